@@ -108,6 +108,8 @@ def _get_dslx_test_cmdline(ctx, src, all_srcs, append_cmd_line_args = True):
         "enable_warnings",
         "max_ticks",
         "format_preference",
+        "quickcheck_threads",
+        "proc_threads",
     )
 
     dslx_test_args = dict(_dslx_test_args)
@@ -69,6 +69,14 @@ _OPT_LOG_FILE_EXTENSION = ".opt.log"
 _CODEGEN_FLAGS = CODEGEN_FIELDS.keys()
 _SCHEDULING_FLAGS = SCHEDULING_FIELDS.keys()
 
+# The IR converter and optimizer can serve many actions from one process (see
+# xls/common/persistent_worker.h), which saves their startup and lets Bazel
+# keep them warm across a build.
+_WORKER_EXECUTION_REQUIREMENTS = {
+    "requires-worker-protocol": "proto",
+    "supports-workers": "1",
+}
+
 def append_xls_dslx_ir_generated_files(args, basename):
     """Returns a dictionary of arguments appended with filenames generated by the 'xls_dslx_ir' rule.
 
@@ -140,6 +148,8 @@ def _convert_to_ir(ctx, src):
         "disable_warnings",
         "convert_tests",
         "default_fifo_config",
+        "conversion_cache_dir",
+        "import_parse_threads",
     )
 
     # With runs outside a monorepo, the execution root for the workspace of
@@ -166,6 +176,11 @@ def _convert_to_ir(ctx, src):
 
     ir_conv_args["top"] = ctx.attr.dslx_top
     my_args = ctx.actions.args()
+
+    # The arguments go through a params file so that the action can run on a
+    # persistent worker, which receives them as a work request.
+    my_args.use_param_file("@%s", use_always = True)
+    my_args.set_param_file_format("multiline")
     for flag, value in ir_conv_args.items():
         # NB Using format because some of the values are 'true/false' which
         # don't mix well with short-flags.
@@ -195,6 +210,7 @@ def _convert_to_ir(ctx, src):
         executable = ir_converter_tool,
         mnemonic = "ConvertDSLX",
         progress_message = "Converting DSLX file to XLS IR: %s" % src.short_path,
+        execution_requirements = _WORKER_EXECUTION_REQUIREMENTS,
         toolchain = None,
     )
     return runfiles, ir_file, interface_proto
@@ -232,6 +248,8 @@ def _optimize_ir(ctx, src, original_input_files):
         opt_ir_args.setdefault("top", ctx.attr.top)
 
     args = ctx.actions.args()
+    args.use_param_file("@%s", use_always = True)
+    args.set_param_file_format("multiline")
     args.add(src.ir_file)
 
     for flag, value in opt_ir_args.items():
@@ -279,6 +297,7 @@ def _optimize_ir(ctx, src, original_input_files):
         arguments = [args],
         mnemonic = "OptimizeIR",
         progress_message = "Optimizing IR %s" % src.ir_file.short_path,
+        execution_requirements = _WORKER_EXECUTION_REQUIREMENTS,
         toolchain = None,
     )
     return runfiles, opt_ir_file
@@ -311,6 +330,7 @@ def get_ir_equivalence_test_cmd(
     IR_EQUIVALENCE_FLAGS = (
         "timeout",
         "activation_count",
+        "use_aig",
     )
 
     ir_equivalence_args = dict(ctx.attr.ir_equivalence_args)
@@ -328,10 +328,15 @@ PROC_WRAPPER_TYPE = "PROC"
 BLOCK_WRAPPER_TYPE = "BLOCK"
 
 _BASE_JIT_WRAPPER_DEPS = {
-    FUNCTION_WRAPPER_TYPE: ["//xls/jit:function_base_jit_wrapper"],
+    FUNCTION_WRAPPER_TYPE: [
+        "//xls/common/status:ret_check",
+        "//xls/jit:function_base_jit_wrapper",
+        "@com_google_absl//absl/types:span",
+    ],
     PROC_WRAPPER_TYPE: [
         "//xls/jit:proc_base_jit_wrapper",
         "@com_google_absl//absl/container:flat_hash_map",
+        "@com_google_absl//absl/types:span",
     ],
     BLOCK_WRAPPER_TYPE: [
         "//xls/jit:block_base_jit_wrapper",
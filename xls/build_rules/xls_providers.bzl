@@ -123,6 +123,15 @@ CODEGEN_FIELDS = {
                                "'IdentityOnly' or 'None'",
     "emit_sv_types": "Whether or not to honor the #[sv_type(NAME)] annotations in the source DSLX.",
     "codegen_version": "Version of codegen to use (0=default).",
+    "module_cache_dir": "Directory in which to cache the Verilog generated " +
+                        "for each block.",
+    "retime_registers": "Whether to retime pipeline registers using the " +
+                        "delay model.",
+    "share_resources": "Whether to share expensive operations between " +
+                       "mutually exclusive uses in a stage.",
+    "instantiated_functions": "Comma-separated list of functions whose " +
+                              "invocations are emitted as instantiations " +
+                              "of a separate module.",
 }
 
 SCHEDULING_FIELDS = {
@@ -136,6 +145,20 @@ SCHEDULING_FIELDS = {
     "period_relaxation_percent": "The percentage of clock period that will " +
                                  "be relaxed when scheduling without an " +
                                  "explicit --clock_period_ps.",
+    "flop_relaxation_percent": "The percentage by which the SDC scheduler " +
+                               "may lengthen the clock period if that " +
+                               "lowers the pipeline flop count.",
+    "clock_search_parallelism": "The number of clock periods to try at " +
+                                "once when searching for the minimum " +
+                                "feasible clock period.",
+    "max_partition_size": "If positive, functions with more nodes than this " +
+                          "are scheduled by recursively cutting them at " +
+                          "stage boundaries and scheduling the parts in " +
+                          "parallel.",
+    "schedule_hint_path": "Path to the schedule of an earlier version of " +
+                          "the IR to keep where it is still valid.",
+    "pin_schedule_hint": "If true, nodes away from the changes since the " +
+                         "schedule hint stay in their hinted stages.",
     "minimize_clock_on_error": "If true, when `--clock_period_ps` is given " +
                                "but is infeasible for scheduling, search for " +
                                "& report the shortest feasible clock period.",
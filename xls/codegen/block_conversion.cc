@@ -1960,6 +1960,72 @@ absl::StatusOr<ConcurrentStageGroups> CalculateConcurrentGroupsFromStateWrites(
   return result;
 }
 
+// Map from the nodes of the function base being converted to the nodes of the
+// block which carry their values. Conversion does not modify the function base,
+// so its nodes are indexed by Node::dense_index() rather than hashed.
+class ConvertedNodeMap {
+ public:
+  explicit ConvertedNodeMap(FunctionBase* function_base)
+      : function_base_(function_base),
+        nodes_(function_base->node_count()),
+        mapped_(function_base->node_count(), false) {}
+
+  bool contains(Node* node) const { return mapped_[Index(node)]; }
+
+  Node* at(Node* node) const {
+    CHECK(contains(node)) << "No block node for " << node->GetName();
+    return nodes_[Index(node)];
+  }
+
+  Node*& operator[](Node* node) {
+    mapped_[Index(node)] = true;
+    return nodes_[Index(node)];
+  }
+
+ private:
+  int64_t Index(Node* node) const {
+    DCHECK_EQ(node->function_base(), function_base_);
+    return node->dense_index();
+  }
+
+  FunctionBase* function_base_;
+  std::vector<Node*> nodes_;
+  std::vector<bool> mapped_;
+};
+
+// Returns, for each stage but the last, the nodes which are live out of it
+// (see PipelineSchedule::IsLiveOutOfCycle) in the order of the nodes of the
+// function base. The live range of each node is found in a single walk over
+// the nodes rather than by querying every node at every stage.
+std::vector<std::vector<Node*>> LiveOutNodesByStage(
+    const PipelineSchedule& schedule) {
+  FunctionBase* function_base = schedule.function_base();
+  int64_t last_stage = schedule.length() - 1;
+  std::vector<std::vector<Node*>> live_out(std::max<int64_t>(last_stage, 0));
+  Node* return_value = function_base->IsFunction()
+                           ? function_base->AsFunctionOrDie()->return_value()
+                           : nullptr;
+  for (Node* node : function_base->nodes()) {
+    int64_t stage = schedule.cycle(node);
+    // The node is live out of every stage from its own up to the last one in
+    // which it is used.
+    int64_t end = node == return_value ? last_stage : stage;
+    for (Node* user : node->users()) {
+      if (user->Is<Next>() && user->As<Next>()->value() != node &&
+          user->As<Next>()->predicate() != node) {
+        // The Next node only uses the StateRead to target the state register
+        // it writes; it doesn't need the value read out of it.
+        continue;
+      }
+      end = std::max(end, schedule.cycle(user));
+    }
+    for (; stage < std::min(end, last_stage); ++stage) {
+      live_out[stage].push_back(node);
+    }
+  }
+  return live_out;
+}
+
 // Clones every node in the given func/proc into the given block. Some nodes are
 // handled specially:
 //
@@ -2047,6 +2113,7 @@ class CloneNodesIntoBlockHandler {
         function_base_(proc_or_function),
         options_(options),
         block_(block),
+        node_map_(proc_or_function),
         fifo_instantiations_({}) {
     absl::StatusOr<absl::flat_hash_set<int64_t>>
         loopback_channel_ids_or_status =
@@ -2057,6 +2124,7 @@ class CloneNodesIntoBlockHandler {
       Proc* proc = function_base_->AsProcOrDie();
       result_.state_registers.resize(proc->GetStateElementCount());
     }
+    result_.node_to_stage_map.reserve(proc_or_function->node_count());
     if (stage_count > 1) {
       result_.pipeline_registers.resize(stage_count - 1);
     }
@@ -2139,22 +2207,20 @@ class CloneNodesIntoBlockHandler {
     return absl::OkStatus();
   }
 
-  // Add pipeline registers. A register is needed for each node which is
-  // scheduled at or before this cycle and has a use after this cycle.
-  absl::Status AddNextPipelineStage(const PipelineSchedule& schedule,
+  // Add pipeline registers for the nodes which are live out of the given
+  // stage (see LiveOutNodesByStage).
+  absl::Status AddNextPipelineStage(absl::Span<Node* const> live_out_nodes,
                                     int64_t stage) {
-    for (Node* function_base_node : function_base_->nodes()) {
-      if (schedule.IsLiveOutOfCycle(function_base_node, stage)) {
-        Node* node = node_map_.at(function_base_node);
+    for (Node* function_base_node : live_out_nodes) {
+      Node* node = node_map_.at(function_base_node);
 
-        XLS_ASSIGN_OR_RETURN(
-            Node * node_after_stage,
-            CreatePipelineRegistersForNode(
-                PipelineSignalName(node->GetName(), stage), node, stage,
-                result_.pipeline_registers.at(stage)));
+      XLS_ASSIGN_OR_RETURN(
+          Node * node_after_stage,
+          CreatePipelineRegistersForNode(
+              PipelineSignalName(node->GetName(), stage), node, stage,
+              result_.pipeline_registers.at(stage)));
 
-        node_map_[function_base_node] = node_after_stage;
-      }
+      node_map_[function_base_node] = node_after_stage;
     }
 
     return absl::OkStatus();
@@ -2198,7 +2264,8 @@ class CloneNodesIntoBlockHandler {
   }
 
   // Return structure describing streaming io ports and pipeline registers.
-  StreamingIOPipeline GetResult() { return result_; }
+  // The handler is done once the result has been taken.
+  StreamingIOPipeline GetResult() { return std::move(result_); }
 
   std::optional<ConcurrentStageGroups> GetConcurrentStages() {
     return concurrent_stages_;
@@ -2794,7 +2861,7 @@ class CloneNodesIntoBlockHandler {
   Block* block_;
   std::optional<ConcurrentStageGroups> concurrent_stages_;
   StreamingIOPipeline result_;
-  absl::flat_hash_map<Node*, Node*> node_map_;
+  ConvertedNodeMap node_map_;
   absl::flat_hash_set<int64_t> loopback_channel_ids_;
   absl::flat_hash_map<int64_t, xls::Instantiation*> fifo_instantiations_;
 };
@@ -2816,9 +2883,12 @@ CloneNodesIntoPipelinedBlock(const PipelineSchedule& schedule,
 
   CloneNodesIntoBlockHandler cloner(function_base, schedule.length(), options,
                                     block);
+  std::vector<std::vector<Node*>> live_out = LiveOutNodesByStage(schedule);
   for (int64_t stage = 0; stage < schedule.length(); ++stage) {
     XLS_RET_CHECK_OK(cloner.CloneNodes(schedule.nodes_in_cycle(stage), stage));
-    XLS_RET_CHECK_OK(cloner.AddNextPipelineStage(schedule, stage));
+    if (stage < live_out.size()) {
+      XLS_RET_CHECK_OK(cloner.AddNextPipelineStage(live_out[stage], stage));
+    }
   }
 
   XLS_RET_CHECK_OK(cloner.AddOutputPortsIfFunction(options.output_port_name()));
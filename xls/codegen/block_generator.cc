@@ -16,9 +16,11 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <initializer_list>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -40,16 +42,20 @@
 #include "xls/codegen/codegen_options.h"
 #include "xls/codegen/flattening.h"
 #include "xls/codegen/module_builder.h"
+#include "xls/codegen/module_cache.h"
 #include "xls/codegen/module_signature.pb.h"
 #include "xls/codegen/node_expressions.h"
 #include "xls/codegen/node_representation.h"
 #include "xls/codegen/op_override.h"
+#include "xls/codegen/vast/emit_stream.h"
 #include "xls/codegen/vast/vast.h"
 #include "xls/codegen/verilog_line_map.pb.h"
 #include "xls/common/casts.h"
+#include "xls/common/math_util.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/block.h"
 #include "xls/ir/format_preference.h"
@@ -67,6 +73,14 @@ namespace xls {
 namespace verilog {
 namespace {
 
+// Largest size in characters of an inline expression which may be repeated at
+// each of its uses in the Verilog (see BlockGenerator::IsTooLargeToRepeat).
+constexpr int64_t kMaxRepeatedExpressionSize = 256;
+
+// Allowance in characters for the operator, parentheses and separators of an
+// inline expression (see BlockGenerator::InlineExpressionSize).
+constexpr int64_t kInlineOperatorSize = 4;
+
 // Returns true if the given type is representable in the Verilog.
 bool IsRepresentable(Type* type) { return type->GetFlatBitCount() > 0; }
 
@@ -463,6 +477,45 @@ class BlockGenerator {
     return false;
   }
 
+  // Returns the approximate size in characters of the text of `n` if it is
+  // emitted as an inline expression: a fixed allowance for the operator plus
+  // the size of each operand occurrence, which is the size of the operand's
+  // own inline expression or, for operands with a name of their own, the size
+  // of the name. This is computed from the recorded sizes of the operands
+  // rather than by printing the expression, so that it takes constant time
+  // per operand however deep the expression is.
+  int64_t InlineExpressionSize(Node* n) const {
+    int64_t size = kInlineOperatorSize;
+    if (n->Is<xls::Literal>()) {
+      size += CeilOfRatio(n->GetType()->GetFlatBitCount(), int64_t{4});
+    }
+    for (Node* operand : n->operands()) {
+      auto it = inline_expression_sizes_.find(operand);
+      size += it == inline_expression_sizes_.end() ? operand->GetName().size()
+                                                   : it->second;
+    }
+    return size;
+  }
+
+  // Returns true if the inline expression of `n`, of size `inline_size` (see
+  // InlineExpressionSize), would be repeated in the Verilog and is too large
+  // for that, so `n` should be emitted as an assignment instead. Cheap
+  // expressions are inlined into each of their uses (see
+  // ShouldInlineExpressionIntoMultipleUses), as are nodes used more than once
+  // by a single user, but as their operands are inlined in turn the repeated
+  // text can grow exponentially with the depth of the IR. Bounding it keeps
+  // the size of the output linear in the size of the IR.
+  bool IsTooLargeToRepeat(Node* n, int64_t inline_size) const {
+    if (inline_size <= kMaxRepeatedExpressionSize) {
+      return false;
+    }
+    int64_t use_count = 0;
+    for (Node* user : n->users()) {
+      use_count += absl::c_count(user->operands(), n);
+    }
+    return use_count > 1;
+  }
+
   // Name of the node if it gets emitted as a separate assignment.
   std::string NodeAssignmentName(Node* const node,
                                  std::optional<int64_t> stage) {
@@ -675,16 +728,19 @@ class BlockGenerator {
         inputs.push_back(std::get<Expression*>(node_exprs_.at(operand)));
       }
 
-      if (ShouldEmitAsAssignment(node, inline_depth)) {
-        XLS_ASSIGN_OR_RETURN(
-            node_exprs_[node],
-            mb_.EmitAsAssignment(NodeAssignmentName(node, stage), node,
-                                 inputs));
-      } else {
-        XLS_ASSIGN_OR_RETURN(node_exprs_[node],
-                             mb_.EmitAsInlineExpression(node, inputs));
-        node_depth[node] = inline_depth;
+      if (!ShouldEmitAsAssignment(node, inline_depth)) {
+        int64_t inline_size = InlineExpressionSize(node);
+        if (!IsTooLargeToRepeat(node, inline_size)) {
+          XLS_ASSIGN_OR_RETURN(node_exprs_[node],
+                               mb_.EmitAsInlineExpression(node, inputs));
+          node_depth[node] = inline_depth;
+          inline_expression_sizes_[node] = inline_size;
+          continue;
+        }
       }
+      XLS_ASSIGN_OR_RETURN(
+          node_exprs_[node],
+          mb_.EmitAsAssignment(NodeAssignmentName(node, stage), node, inputs));
     }
     return absl::OkStatus();
   }
@@ -948,6 +1004,10 @@ class BlockGenerator {
   // Map from Node* to the Verilog expression representing its value.
   absl::flat_hash_map<Node*, NodeRepresentation> node_exprs_;
 
+  // Approximate text sizes of the nodes emitted as inline expressions, see
+  // InlineExpressionSize.
+  absl::flat_hash_map<Node*, int64_t> inline_expression_sizes_;
+
   // Map from xls::Register* to the ModuleBuilder register abstraction
   // representing the underlying Verilog register.
   absl::flat_hash_map<xls::Register*, ModuleBuilder::Register> mb_registers_;
@@ -995,12 +1055,74 @@ absl::StatusOr<std::vector<Block*>> GatherInstantiatedBlocks(Block* top) {
   return blocks;
 }
 
+// Generates the module for `block` on its own. The Verilog line numbers of
+// the returned line map are relative to the first line of the module. The
+// line map is only filled in if `with_line_map` is true.
+absl::StatusOr<CachedModule> GenerateModule(
+    Block* block, const CodegenOptions& options,
+    const absl::flat_hash_map<InputPort*, std::string>& input_port_sv_types,
+    const absl::flat_hash_map<OutputPort*, std::string>& output_port_sv_types,
+    bool with_line_map) {
+  VerilogFile file(options.use_system_verilog() ? FileType::kSystemVerilog
+                                                : FileType::kVerilog);
+  XLS_RETURN_IF_ERROR(BlockGenerator::Generate(
+      block, &file, options, input_port_sv_types, output_port_sv_types));
+
+  CachedModule module;
+  LineInfo line_info;
+  StringEmitSink sink(&module.verilog_text);
+  EmitStream stream(&sink);
+  file.EmitTo(&stream, with_line_map ? &line_info : nullptr);
+  if (!with_line_map) {
+    return module;
+  }
+  for (const VastNode* vast_node : line_info.nodes()) {
+    std::optional<std::vector<LineSpan>> spans =
+        line_info.LookupNode(vast_node);
+    if (!spans.has_value()) {
+      return absl::InternalError("Unbalanced calls to LineInfo::{Start, End}");
+    }
+    for (const LineSpan& span : spans.value()) {
+      SourceInfo info = vast_node->loc();
+      for (const SourceLocation& loc : info.locations) {
+        int64_t line = static_cast<int32_t>(loc.lineno());
+        VerilogLineMapping* mapping = module.line_map.add_mapping();
+        mapping->set_source_file(
+            block->package()->GetFilename(loc.fileno()).value_or(""));
+        mapping->mutable_source_span()->set_line_start(line);
+        mapping->mutable_source_span()->set_line_end(line);
+        mapping->set_verilog_file("");  // to be updated later on
+        mapping->mutable_verilog_span()->set_line_start(span.StartLine());
+        mapping->mutable_verilog_span()->set_line_end(span.EndLine());
+      }
+    }
+  }
+  return module;
+}
+
 }  // namespace
 
 absl::StatusOr<std::string> GenerateVerilog(
     Block* top, const CodegenOptions& options, VerilogLineMap* verilog_line_map,
     const absl::flat_hash_map<InputPort*, std::string>& input_port_sv_types,
     const absl::flat_hash_map<OutputPort*, std::string>& output_port_sv_types) {
+  std::string text;
+  StringEmitSink sink(&text);
+  XLS_RETURN_IF_ERROR(StreamVerilog(top, options, &sink, verilog_line_map,
+                                    input_port_sv_types,
+                                    output_port_sv_types));
+
+  VLOG(2) << "Verilog output:";
+  XLS_VLOG_LINES(2, text);
+
+  return text;
+}
+
+absl::Status StreamVerilog(
+    Block* top, const CodegenOptions& options, EmitSink* out,
+    VerilogLineMap* verilog_line_map,
+    const absl::flat_hash_map<InputPort*, std::string>& input_port_sv_types,
+    const absl::flat_hash_map<OutputPort*, std::string>& output_port_sv_types) {
   VLOG(2) << absl::StreamFormat(
       "Generating Verilog for packge with with top level block `%s`:",
       top->name());
@@ -1008,48 +1130,86 @@ absl::StatusOr<std::string> GenerateVerilog(
 
   XLS_ASSIGN_OR_RETURN(std::vector<Block*> blocks,
                        GatherInstantiatedBlocks(top));
-  VerilogFile file(options.use_system_verilog() ? FileType::kSystemVerilog
-                                                : FileType::kVerilog);
-  for (Block* block : blocks) {
-    XLS_RETURN_IF_ERROR(BlockGenerator::Generate(
-        block, &file, options, input_port_sv_types, output_port_sv_types));
-    if (block != blocks.back()) {
-      file.Add(file.Make<BlankLine>(SourceInfo()));
-      file.Add(file.Make<BlankLine>(SourceInfo()));
-    }
-  }
 
-  LineInfo line_info;
-  std::string text = file.Emit(&line_info);
-  if (verilog_line_map != nullptr) {
-    for (const VastNode* vast_node : line_info.nodes()) {
-      std::optional<std::vector<LineSpan>> spans =
-          line_info.LookupNode(vast_node);
-      if (!spans.has_value()) {
-        return absl::InternalError(
-            "Unbalanced calls to LineInfo::{Start, End}");
+  std::unique_ptr<ModuleCache> cache;
+  if (options.module_cache_dir().has_value()) {
+    XLS_ASSIGN_OR_RETURN(cache,
+                         ModuleCache::Create(*options.module_cache_dir()));
+  }
+  bool with_line_map = verilog_line_map != nullptr || cache != nullptr;
+
+  // Generating a module only reads the IR of its block, so the modules are
+  // generated concurrently, each into a text of its own. The texts are then
+  // emitted in the order of `blocks`, so the output is the same as if all the
+  // modules were generated into a single file.
+  std::vector<absl::StatusOr<CachedModule>> modules(blocks.size());
+  auto generate = [&](int64_t i) -> absl::StatusOr<CachedModule> {
+    std::optional<std::string> key;
+    if (cache != nullptr) {
+      key = ModuleCache::ComputeKey(blocks[i], options, input_port_sv_types,
+                                    output_port_sv_types);
+    }
+    if (key.has_value()) {
+      XLS_ASSIGN_OR_RETURN(std::optional<CachedModule> cached,
+                           cache->Lookup(*key));
+      if (cached.has_value()) {
+        return *std::move(cached);
       }
-      for (const LineSpan& span : spans.value()) {
-        SourceInfo info = vast_node->loc();
-        for (const SourceLocation& loc : info.locations) {
-          int64_t line = static_cast<int32_t>(loc.lineno());
-          VerilogLineMapping* mapping = verilog_line_map->add_mapping();
-          mapping->set_source_file(
-              top->package()->GetFilename(loc.fileno()).value_or(""));
-          mapping->mutable_source_span()->set_line_start(line);
-          mapping->mutable_source_span()->set_line_end(line);
-          mapping->set_verilog_file("");  // to be updated later on
-          mapping->mutable_verilog_span()->set_line_start(span.StartLine());
-          mapping->mutable_verilog_span()->set_line_end(span.EndLine());
+    }
+    XLS_ASSIGN_OR_RETURN(
+        CachedModule module,
+        GenerateModule(blocks[i], options, input_port_sv_types,
+                       output_port_sv_types, with_line_map));
+    if (key.has_value()) {
+      XLS_RETURN_IF_ERROR(cache->Store(*key, module));
+    }
+    return module;
+  };
+  int64_t thread_count =
+      std::min<int64_t>(AvailableCPUs(), static_cast<int64_t>(blocks.size()));
+  if (thread_count <= 1) {
+    for (int64_t i = 0; i < blocks.size(); ++i) {
+      modules[i] = generate(i);
+    }
+  } else {
+    std::atomic<int64_t> next_block = 0;
+    // Threads are joined on destruction.
+    std::vector<std::unique_ptr<Thread>> threads;
+    threads.reserve(thread_count);
+    for (int64_t t = 0; t < thread_count; ++t) {
+      threads.push_back(std::make_unique<Thread>([&]() {
+        for (int64_t i = next_block++; i < blocks.size(); i = next_block++) {
+          modules[i] = generate(i);
         }
-      }
+      }));
     }
   }
 
-  VLOG(2) << "Verilog output:";
-  XLS_VLOG_LINES(2, text);
+  // Line numbers of the mappings of each module are relative to its first
+  // line, which follows all the lines emitted before it.
+  int64_t line_offset = 0;
+  for (int64_t i = 0; i < blocks.size(); ++i) {
+    XLS_RETURN_IF_ERROR(modules[i].status());
+    const CachedModule& module = *modules[i];
+    if (i > 0) {
+      out->Write("\n\n");
+      line_offset += 2;
+    }
+    out->Write(module.verilog_text);
+    if (verilog_line_map != nullptr) {
+      for (const VerilogLineMapping& relative : module.line_map.mapping()) {
+        VerilogLineMapping* mapping = verilog_line_map->add_mapping();
+        *mapping = relative;
+        mapping->mutable_verilog_span()->set_line_start(
+            relative.verilog_span().line_start() + line_offset);
+        mapping->mutable_verilog_span()->set_line_end(
+            relative.verilog_span().line_end() + line_offset);
+      }
+    }
+    line_offset += absl::c_count(module.verilog_text, '\n');
+  }
 
-  return text;
+  return absl::OkStatus();
 }
 
 }  // namespace verilog
@@ -32,10 +32,12 @@
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
 #include "xls/codegen/block_conversion.h"
 #include "xls/codegen/codegen_options.h"
 #include "xls/codegen/codegen_pass.h"
@@ -1439,6 +1441,54 @@ endpackage : pkg
   XLS_ASSERT_OK(tb->Run());
 }
 
+TEST_P(BlockGeneratorTest, ManyInstantiatedBlocks) {
+  // The modules are generated concurrently but must be emitted in dependency
+  // order regardless.
+  Package package(TestBaseName());
+  Type* u32 = package.GetBitsType(32);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Block * sub_block,
+                           MakeSubtractBlock("subtractor", &package));
+  BlockBuilder bb("my_block", &package);
+  BValue j = bb.InputPort("j", u32);
+  BValue k = bb.InputPort("k", u32);
+  std::vector<BValue> differences;
+  for (int64_t i = 0; i < 16; ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Block * delegator,
+        MakeDelegatingBlock(absl::StrCat("delegator", i), sub_block, &package));
+    XLS_ASSERT_OK_AND_ASSIGN(xls::Instantiation * instantiation,
+                             bb.block()->AddBlockInstantiation(
+                                 absl::StrCat("deleg", i), delegator));
+    bb.InstantiationInput(instantiation, "x", j);
+    bb.InstantiationInput(instantiation, "y", k);
+    differences.push_back(bb.InstantiationOutput(instantiation, "z"));
+  }
+  bb.OutputPort("out", bb.Concat(differences));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::string verilog,
+                           GenerateVerilog(block, codegen_options()));
+  std::vector<std::string_view> modules;
+  for (std::string_view line : absl::StrSplit(verilog, '\n')) {
+    if (absl::StartsWith(line, "module ")) {
+      modules.push_back(line);
+    }
+  }
+  ASSERT_EQ(modules.size(), 18);
+  EXPECT_TRUE(absl::StartsWith(modules.front(), "module subtractor("));
+  for (int64_t i = 0; i < 16; ++i) {
+    EXPECT_TRUE(absl::StartsWith(modules[i + 1],
+                                 absl::StrCat("module delegator", i, "(")));
+  }
+  EXPECT_TRUE(absl::StartsWith(modules.back(), "module my_block("));
+
+  for (int64_t i = 0; i < 3; ++i) {
+    EXPECT_THAT(GenerateVerilog(block, codegen_options()),
+                absl_testing::IsOkAndHolds(verilog));
+  }
+}
+
 TEST_P(BlockGeneratorTest, DiamondDependencyInstantiations) {
   Package package(TestBaseName());
   Type* u32 = package.GetBitsType(32);
@@ -2057,6 +2107,46 @@ fn deep_nesting(x: bits[10]) -> bits[10] {
                                  verilog);
 }
 
+TEST_P(BlockGeneratorTest, RepeatedExpressionsStayLinear) {
+  // Every node is used twice by the next one. Inlining each into both uses
+  // would double the size of the expression at every level.
+  auto p = std::make_unique<VerifiedPackage>(TestName());
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  for (int64_t i = 0; i < 40; ++i) {
+    x = fb.Add(x, x);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  CodegenOptions options;
+  options.use_system_verilog(UseSystemVerilog());
+  options.max_inline_depth(100);
+
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenPassUnit unit,
+                           FunctionToCombinationalBlock(f, options));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::string verilog,
+                           GenerateVerilog(unit.top_block, options));
+  EXPECT_THAT(verilog, HasSubstr("x + x"));
+
+  // Once an expression grows too large to repeat it is assigned to a
+  // temporary which the next level refers to twice by name.
+  int64_t reused_temporaries = 0;
+  for (std::string_view line : absl::StrSplit(verilog, '\n')) {
+    EXPECT_LT(line.size(), 600) << line;
+    std::string_view assignment = absl::StripLeadingAsciiWhitespace(line);
+    if (!absl::ConsumePrefix(&assignment, "assign ")) {
+      continue;
+    }
+    std::string_view name = assignment.substr(0, assignment.find(' '));
+    if (absl::StrContains(verilog, absl::StrCat(name, " + ", name))) {
+      ++reused_temporaries;
+    }
+  }
+  EXPECT_GE(reused_temporaries, 5);
+  EXPECT_LT(verilog.size(), 20000);
+}
+
 TEST_P(BlockGeneratorTest, ArrayIndexBounds) {
   auto p = std::make_unique<VerifiedPackage>(TestName());
   FunctionBuilder fb(TestName(), p.get());
@@ -14,6 +14,7 @@
 
 #include "xls/codegen/block_inlining_pass.h"
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -31,182 +32,351 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/block.h"
 #include "xls/ir/block_elaboration.h"
-#include "xls/ir/elaborated_block_dfs_visitor.h"
 #include "xls/ir/instantiation.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
 #include "xls/ir/register.h"
 
 namespace xls::verilog {
 
 namespace {
 
-class InlineVisitor : public ElaboratedBlockDfsVisitorWithDefault {
+// The nodes of a block with dense indices, along with how its block
+// instantiations connect to the ports of the instantiated blocks. Computed once
+// per block and shared by all of its instances.
+struct BlockLayout {
+  std::vector<Node*> nodes;
+  absl::flat_hash_map<Node*, int64_t> index;
+  std::vector<std::vector<int64_t>> operands;
+  // For each InstantiationInput or InstantiationOutput of a block
+  // instantiation, the port of the instantiated block it connects to, and
+  // nullptr for every other node.
+  std::vector<Node*> linked_ports;
+  // The InstantiationInput driving each input port of each instantiated block.
+  absl::flat_hash_map<std::pair<xls::Instantiation*, Node*>, int64_t>
+      port_drivers;
+};
+
+absl::StatusOr<std::unique_ptr<BlockLayout>> ComputeBlockLayout(Block* block) {
+  auto layout = std::make_unique<BlockLayout>();
+  layout->nodes.assign(block->nodes().begin(), block->nodes().end());
+  layout->index.reserve(layout->nodes.size());
+  for (int64_t i = 0; i < layout->nodes.size(); ++i) {
+    layout->index[layout->nodes[i]] = i;
+  }
+  layout->operands.resize(layout->nodes.size());
+  layout->linked_ports.resize(layout->nodes.size(), nullptr);
+  for (int64_t i = 0; i < layout->nodes.size(); ++i) {
+    Node* node = layout->nodes[i];
+    layout->operands[i].reserve(node->operand_count());
+    for (Node* operand : node->operands()) {
+      layout->operands[i].push_back(layout->index.at(operand));
+    }
+    if (node->Is<InstantiationInput>()) {
+      InstantiationInput* ii = node->As<InstantiationInput>();
+      if (ii->instantiation()->kind() != InstantiationKind::kBlock) {
+        continue;
+      }
+      XLS_ASSIGN_OR_RETURN(BlockInstantiation * bi,
+                           ii->instantiation()->AsBlockInstantiation());
+      XLS_ASSIGN_OR_RETURN(
+          InputPort * port,
+          bi->instantiated_block()->GetInputPort(ii->port_name()),
+          _ << "Unable to find referenced port " << ii->port_name());
+      layout->linked_ports[i] = port;
+      layout->port_drivers[{ii->instantiation(), port}] = i;
+    } else if (node->Is<InstantiationOutput>()) {
+      InstantiationOutput* io = node->As<InstantiationOutput>();
+      if (io->instantiation()->kind() != InstantiationKind::kBlock) {
+        continue;
+      }
+      XLS_ASSIGN_OR_RETURN(BlockInstantiation * bi,
+                           io->instantiation()->AsBlockInstantiation());
+      XLS_ASSIGN_OR_RETURN(
+          OutputPort * port,
+          bi->instantiated_block()->GetOutputPort(io->port_name()),
+          _ << "Unable to find referenced port " << io->port_name());
+      layout->linked_ports[i] = port;
+    }
+  }
+  return layout;
+}
+
+// Copies every node of every instance of an elaboration into a single block.
+// Ports between instances are not copied; the users of a port use the node
+// driving it instead.
+class BlockFlattener {
  public:
-  explicit InlineVisitor(Block* out) : new_block_(out) {}
+  explicit BlockFlattener(Block* out) : new_block_(out) {}
 
   const absl::flat_hash_map<std::pair<Register*, BlockInstance*>, Register*>&
   reg_map() const {
     return reg_map_;
   }
-  absl::Status DefaultHandler(const ElaboratedNode& n) override {
-    std::vector<Node*> new_ops;
-    new_ops.reserve(n.node->operand_count());
-    for (Node* op : n.node->operands()) {
-      new_ops.push_back(
-          old_to_new_[ElaboratedNode{.node = op, .instance = n.instance}]);
-    }
-    XLS_ASSIGN_OR_RETURN(Node * new_node,
-                         n.node->CloneInNewFunction(new_ops, new_block_));
-    old_to_new_[n] = new_node;
-    return absl::OkStatus();
-  }
 
-  // NB Call order is InstantiationInput -> Input
-  absl::Status HandleInstantiationInput(InstantiationInput* ii,
-                                        BlockInstance* instance) override {
-    if (ii->instantiation()->kind() != InstantiationKind::kBlock) {
-      // Copy a new instantiation
-      XLS_ASSIGN_OR_RETURN(
-          Instantiation * new_inst,
-          GetCopiedInstantiation(ii->instantiation(), instance));
-      XLS_ASSIGN_OR_RETURN(
-          (old_to_new_[{.node = ii, .instance = instance}]),
-          new_block_->MakeNodeWithName<InstantiationInput>(
-              ii->loc(),
-              old_to_new_[{.node = ii->data(), .instance = instance}], new_inst,
-              ii->port_name(), ii->GetName()));
-      return absl::OkStatus();
+  absl::Status Flatten(const BlockElaboration& elab) {
+    for (BlockInstance* instance : elab.instances()) {
+      if (!instance->block().has_value()) {
+        continue;
+      }
+      Block* block = *instance->block();
+      auto [it, inserted] = layouts_.try_emplace(block);
+      if (inserted) {
+        XLS_ASSIGN_OR_RETURN(it->second, ComputeBlockLayout(block));
+      }
+      auto state = std::make_unique<InstanceState>();
+      state->instance = instance;
+      state->layout = it->second.get();
+      state->values.resize(state->layout->nodes.size(), nullptr);
+      state->visit_state.resize(state->layout->nodes.size(),
+                                VisitState::kUnvisited);
+      state_by_instance_[instance] = state.get();
+      states_.push_back(std::move(state));
+    }
+    for (const std::unique_ptr<InstanceState>& state : states_) {
+      if (state->instance->parent_instance().has_value()) {
+        state->parent =
+            state_by_instance_.at(*state->instance->parent_instance());
+      }
     }
-    XLS_RET_CHECK(
-        old_to_new_.contains({.node = ii->data(), .instance = instance}))
-        << "Unable to find value set for " << ii->data();
-    // Create the 'InputPort' node associated with this and map it to the input.
-    // Done here to avoid having to keep track of the value across the function
-    // boundary.
-    XLS_ASSIGN_OR_RETURN(BlockInstantiation * bi,
-                         ii->instantiation()->AsBlockInstantiation());
-    XLS_ASSIGN_OR_RETURN(
-        InputPort * mapped_port,
-        bi->instantiated_block()->GetInputPort(ii->port_name()),
-        _ << "Unable to find referenced port " << ii->port_name());
-    XLS_RET_CHECK(
-        instance->instantiation_to_instance().contains(ii->instantiation()));
-    BlockInstance* ii_instance =
-        instance->instantiation_to_instance().at(ii->instantiation());
-    old_to_new_[{.node = mapped_port, .instance = ii_instance}] =
-        old_to_new_[{.node = ii->data(), .instance = instance}];
-    return absl::OkStatus();
-  }
 
-  absl::Status HandleInputPort(InputPort* port,
-                               BlockInstance* instance) override {
-    if (!instance->parent_instance()) {
-      // Top block, no linking of ports required.
-      XLS_ASSIGN_OR_RETURN(
-          Node * new_input,
-          new_block_->AddInputPort(port->name(), port->GetType(), port->loc()));
-      old_to_new_[{.node = port, .instance = instance}] = new_input;
-      return absl::OkStatus();
+    // Copy everything the sinks of each instance depend on. Ports between
+    // instances link the instances' graphs together, so the copying may cross
+    // into other instances.
+    for (const std::unique_ptr<InstanceState>& state : states_) {
+      for (int64_t i = 0; i < state->layout->nodes.size(); ++i) {
+        if (state->layout->nodes[i]->users().empty()) {
+          XLS_RETURN_IF_ERROR(CopyWithPredecessors(state.get(), i));
+        }
+      }
+    }
+    for (const std::unique_ptr<InstanceState>& state : states_) {
+      for (int64_t i = 0; i < state->layout->nodes.size(); ++i) {
+        XLS_RET_CHECK(state->visit_state[i] == VisitState::kVisited)
+            << "Node " << state->layout->nodes[i]->GetName() << " in "
+            << state->instance->ToString()
+            << " is only used by a cycle in the elaboration";
+      }
     }
-    // The InstantiationInput node has already filled in the ops map so no need
-    // to do anything.
-    XLS_RET_CHECK(old_to_new_.contains({.node = port, .instance = instance}));
     return absl::OkStatus();
   }
 
-  // NB Call order is Output -> InstantiationOutput
-  absl::Status HandleOutputPort(OutputPort* port,
-                                BlockInstance* instance) override {
-    if (!instance->parent_instance()) {
-      // Top block, no linking of ports required.
-      XLS_ASSIGN_OR_RETURN(
-          Node * new_output,
-          new_block_->AddOutputPort(
-              port->name(),
-              old_to_new_[{.node = port->operand(OutputPort::kOperandOperand),
-                           .instance = instance}],
-              port->loc()));
-      old_to_new_[{.node = port, .instance = instance}] = new_output;
-      return absl::OkStatus();
+ private:
+  // verilog::Instantiation from vast is also visible.
+  using Instantiation = xls::Instantiation;
+
+  enum class VisitState : uint8_t { kUnvisited, kVisiting, kVisited };
+
+  struct InstanceState {
+    BlockInstance* instance;
+    const BlockLayout* layout;
+    InstanceState* parent = nullptr;
+    // The node standing in for each node of the instance in the new block.
+    std::vector<Node*> values;
+    std::vector<VisitState> visit_state;
+  };
+
+  struct ElaboratedIndex {
+    InstanceState* state;
+    int64_t index;
+  };
+
+  // Returns the node of another instance which node `index` of `state` takes
+  // its value from, if any: the InstantiationInput driving an input port, or
+  // the output port driving an InstantiationOutput.
+  absl::StatusOr<std::optional<ElaboratedIndex>> InterInstancePredecessor(
+      InstanceState* state, int64_t index) {
+    Node* node = state->layout->nodes[index];
+    if (node->Is<InputPort>() && state->parent != nullptr) {
+      XLS_RET_CHECK(state->instance->instantiation().has_value());
+      auto it = state->parent->layout->port_drivers.find(
+          {*state->instance->instantiation(), node});
+      XLS_RET_CHECK(it != state->parent->layout->port_drivers.end())
+          << "Unable to find value set for " << node->GetName() << " in "
+          << state->instance->ToString();
+      return ElaboratedIndex{.state = state->parent, .index = it->second};
     }
-    // Just save the output_port -> the mapped value.
-    old_to_new_[{.node = port, .instance = instance}] =
-        old_to_new_[{.node = port->operand(OutputPort::kOperandOperand),
-                     .instance = instance}];
-    return absl::OkStatus();
+    if (node->Is<InstantiationOutput>() &&
+        state->layout->linked_ports[index] != nullptr) {
+      BlockInstance* child = state->instance->instantiation_to_instance().at(
+          node->As<InstantiationOutput>()->instantiation());
+      InstanceState* child_state = state_by_instance_.at(child);
+      return ElaboratedIndex{
+          .state = child_state,
+          .index = child_state->layout->index.at(
+              state->layout->linked_ports[index])};
+    }
+    return std::nullopt;
   }
 
-  absl::Status HandleInstantiationOutput(InstantiationOutput* ii,
-                                         BlockInstance* instance) override {
-    if (ii->instantiation()->kind() != InstantiationKind::kBlock) {
-      // Copy a new instantiation
-      XLS_ASSIGN_OR_RETURN(
-          Instantiation * new_inst,
-          GetCopiedInstantiation(ii->instantiation(), instance));
-      XLS_ASSIGN_OR_RETURN(
-          (old_to_new_[{.node = ii, .instance = instance}]),
-          new_block_->MakeNodeWithName<InstantiationOutput>(
-              ii->loc(), new_inst, ii->port_name(), ii->GetName()));
+  // Copies node `index` of `state` after everything it depends on, using an
+  // explicit stack as the hierarchy may be arbitrarily deep.
+  absl::Status CopyWithPredecessors(InstanceState* state, int64_t index) {
+    if (state->visit_state[index] == VisitState::kVisited) {
       return absl::OkStatus();
     }
-    // Take the value the output-port is mapped to.
-    XLS_ASSIGN_OR_RETURN(BlockInstantiation * bi,
-                         ii->instantiation()->AsBlockInstantiation());
-    XLS_ASSIGN_OR_RETURN(
-        OutputPort * mapped_port,
-        bi->instantiated_block()->GetOutputPort(ii->port_name()),
-        _ << "Unable to find referenced port " << ii->port_name());
-    XLS_RET_CHECK(
-        instance->instantiation_to_instance().contains(ii->instantiation()));
-    BlockInstance* ii_instance =
-        instance->instantiation_to_instance().at(ii->instantiation());
-    XLS_RET_CHECK(
-        old_to_new_.contains({.node = mapped_port, .instance = ii_instance}))
-        << "Unable to find value set for " << mapped_port << " in "
-        << ii_instance;
-    old_to_new_[{.node = ii, .instance = instance}] =
-        old_to_new_[{.node = mapped_port, .instance = ii_instance}];
-    return absl::OkStatus();
-  }
-
-  absl::Status HandleRegisterRead(RegisterRead* rr,
-                                  BlockInstance* instance) override {
-    XLS_ASSIGN_OR_RETURN(Register * new_reg,
-                         GetCopiedRegister(rr->GetRegister(), instance));
-    XLS_ASSIGN_OR_RETURN(Node * new_node,
-                         new_block_->MakeNodeWithName<RegisterRead>(
-                             rr->loc(), new_reg, rr->GetName()));
-    old_to_new_[{.node = rr, .instance = instance}] = new_node;
+    // Each frame holds the number of predecessors already pushed; the last
+    // predecessor is the one in another instance, if any.
+    struct Frame {
+      ElaboratedIndex node;
+      int64_t next_predecessor;
+    };
+    std::vector<Frame> stack = {
+        Frame{.node = {.state = state, .index = index}, .next_predecessor = 0}};
+    state->visit_state[index] = VisitState::kVisiting;
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      InstanceState* s = frame.node.state;
+      int64_t i = frame.node.index;
+      const std::vector<int64_t>& operands = s->layout->operands[i];
+      std::optional<ElaboratedIndex> predecessor;
+      if (frame.next_predecessor < operands.size()) {
+        predecessor = ElaboratedIndex{
+            .state = s, .index = operands[frame.next_predecessor]};
+        ++frame.next_predecessor;
+      } else if (frame.next_predecessor == operands.size()) {
+        ++frame.next_predecessor;
+        XLS_ASSIGN_OR_RETURN(predecessor, InterInstancePredecessor(s, i));
+      } else {
+        XLS_RETURN_IF_ERROR(Copy(s, i));
+        s->visit_state[i] = VisitState::kVisited;
+        stack.pop_back();
+        continue;
+      }
+      if (!predecessor.has_value()) {
+        continue;
+      }
+      VisitState& visit_state =
+          predecessor->state->visit_state[predecessor->index];
+      if (visit_state == VisitState::kVisiting) {
+        return absl::InternalError(absl::StrFormat(
+            "Cycle detected in elaboration at node %s in %s",
+            predecessor->state->layout->nodes[predecessor->index]->GetName(),
+            predecessor->state->instance->ToString()));
+      }
+      if (visit_state == VisitState::kUnvisited) {
+        visit_state = VisitState::kVisiting;
+        stack.push_back(Frame{.node = *predecessor, .next_predecessor = 0});
+      }
+    }
     return absl::OkStatus();
   }
 
-  absl::Status HandleRegisterWrite(RegisterWrite* rw,
-                                   BlockInstance* instance) override {
-    XLS_ASSIGN_OR_RETURN(Register * new_reg,
-                         GetCopiedRegister(rw->GetRegister(), instance));
-    Node* new_data = old_to_new_[{.node = rw->data(), .instance = instance}];
-    std::optional<Node*> new_le =
-        rw->load_enable()
-            ? std::make_optional(old_to_new_[{.node = *rw->load_enable(),
-                                              .instance = instance}])
-            : std::nullopt;
-    std::optional<Node*> new_reset =
-        rw->reset()
-            ? std::make_optional(
-                  old_to_new_[{.node = *rw->reset(), .instance = instance}])
-            : std::nullopt;
-    XLS_ASSIGN_OR_RETURN(
-        Node * new_node,
-        new_block_->MakeNodeWithName<RegisterWrite>(
-            rw->loc(), new_data, new_le, new_reset, new_reg, rw->GetName()));
-    old_to_new_[{.node = rw, .instance = instance}] = new_node;
-    return absl::OkStatus();
+  // Sets the node standing in for node `index` of `state`, whose predecessors
+  // all have one already.
+  absl::Status Copy(InstanceState* state, int64_t index) {
+    Node* node = state->layout->nodes[index];
+    std::vector<Node*>& values = state->values;
+    auto operand = [&](int64_t operand_no) {
+      return values[state->layout->operands[index][operand_no]];
+    };
+    bool is_top = state->parent == nullptr;
+    switch (node->op()) {
+      case Op::kInputPort: {
+        if (is_top) {
+          XLS_ASSIGN_OR_RETURN(
+              values[index],
+              new_block_->AddInputPort(node->GetName(), node->GetType(),
+                                       node->loc()));
+          return absl::OkStatus();
+        }
+        XLS_ASSIGN_OR_RETURN(std::optional<ElaboratedIndex> driver,
+                             InterInstancePredecessor(state, index));
+        values[index] = driver->state->values[driver->index];
+        return absl::OkStatus();
+      }
+      case Op::kOutputPort: {
+        if (is_top) {
+          XLS_ASSIGN_OR_RETURN(
+              values[index],
+              new_block_->AddOutputPort(
+                  node->GetName(), operand(OutputPort::kOperandOperand),
+                  node->loc()));
+          return absl::OkStatus();
+        }
+        values[index] = operand(OutputPort::kOperandOperand);
+        return absl::OkStatus();
+      }
+      case Op::kInstantiationInput: {
+        if (state->layout->linked_ports[index] != nullptr) {
+          // The input port of the instantiated block takes this value.
+          values[index] = operand(0);
+          return absl::OkStatus();
+        }
+        InstantiationInput* ii = node->As<InstantiationInput>();
+        XLS_ASSIGN_OR_RETURN(
+            Instantiation * new_inst,
+            GetCopiedInstantiation(ii->instantiation(), state->instance));
+        XLS_ASSIGN_OR_RETURN(values[index],
+                             new_block_->MakeNodeWithName<InstantiationInput>(
+                                 ii->loc(), operand(0), new_inst,
+                                 ii->port_name(), ii->GetName()));
+        return absl::OkStatus();
+      }
+      case Op::kInstantiationOutput: {
+        if (state->layout->linked_ports[index] != nullptr) {
+          XLS_ASSIGN_OR_RETURN(std::optional<ElaboratedIndex> driver,
+                               InterInstancePredecessor(state, index));
+          values[index] = driver->state->values[driver->index];
+          return absl::OkStatus();
+        }
+        InstantiationOutput* io = node->As<InstantiationOutput>();
+        XLS_ASSIGN_OR_RETURN(
+            Instantiation * new_inst,
+            GetCopiedInstantiation(io->instantiation(), state->instance));
+        XLS_ASSIGN_OR_RETURN(values[index],
+                             new_block_->MakeNodeWithName<InstantiationOutput>(
+                                 io->loc(), new_inst, io->port_name(),
+                                 io->GetName()));
+        return absl::OkStatus();
+      }
+      case Op::kRegisterRead: {
+        RegisterRead* rr = node->As<RegisterRead>();
+        XLS_ASSIGN_OR_RETURN(
+            Register * new_reg,
+            GetCopiedRegister(rr->GetRegister(), state->instance));
+        XLS_ASSIGN_OR_RETURN(values[index],
+                             new_block_->MakeNodeWithName<RegisterRead>(
+                                 rr->loc(), new_reg, rr->GetName()));
+        return absl::OkStatus();
+      }
+      case Op::kRegisterWrite: {
+        RegisterWrite* rw = node->As<RegisterWrite>();
+        XLS_ASSIGN_OR_RETURN(
+            Register * new_reg,
+            GetCopiedRegister(rw->GetRegister(), state->instance));
+        auto new_value = [&](Node* n) {
+          return values[state->layout->index.at(n)];
+        };
+        std::optional<Node*> new_le =
+            rw->load_enable().has_value()
+                ? std::make_optional(new_value(*rw->load_enable()))
+                : std::nullopt;
+        std::optional<Node*> new_reset =
+            rw->reset().has_value()
+                ? std::make_optional(new_value(*rw->reset()))
+                : std::nullopt;
+        XLS_ASSIGN_OR_RETURN(values[index],
+                             new_block_->MakeNodeWithName<RegisterWrite>(
+                                 rw->loc(), new_value(rw->data()), new_le,
+                                 new_reset, new_reg, rw->GetName()));
+        return absl::OkStatus();
+      }
+      default: {
+        std::vector<Node*> new_operands;
+        new_operands.reserve(node->operand_count());
+        for (int64_t operand_no = 0; operand_no < node->operand_count();
+             ++operand_no) {
+          new_operands.push_back(operand(operand_no));
+        }
+        XLS_ASSIGN_OR_RETURN(
+            values[index], node->CloneInNewFunction(new_operands, new_block_));
+        return absl::OkStatus();
+      }
+    }
   }
 
- private:
-  // verilog::Instantiation from vast is also visible.
-  using Instantiation = xls::Instantiation;
   absl::StatusOr<Instantiation*> GetCopiedInstantiation(
       Instantiation* old_inst, BlockInstance* instance) {
     XLS_RET_CHECK_NE(old_inst->kind(), InstantiationKind::kBlock);
@@ -253,7 +423,9 @@ class InlineVisitor : public ElaboratedBlockDfsVisitorWithDefault {
   }
 
   Block* new_block_;
-  absl::flat_hash_map<ElaboratedNode, Node*> old_to_new_;
+  absl::flat_hash_map<Block*, std::unique_ptr<BlockLayout>> layouts_;
+  std::vector<std::unique_ptr<InstanceState>> states_;
+  absl::flat_hash_map<BlockInstance*, InstanceState*> state_by_instance_;
   absl::flat_hash_map<std::pair<Register*, BlockInstance*>, Register*> reg_map_;
   absl::flat_hash_map<std::pair<Instantiation*, BlockInstance*>, Instantiation*>
       inst_map_;
@@ -281,11 +453,11 @@ absl::StatusOr<Block*> InlineElaboration(
     XLS_RETURN_IF_ERROR(elab.package()->SetTop(stitched));
   }
 
-  InlineVisitor vis(stitched);
-  XLS_RETURN_IF_ERROR(elab.Accept(vis));
+  BlockFlattener flattener(stitched);
+  XLS_RETURN_IF_ERROR(flattener.Flatten(elab));
 
   // Record new register names.
-  for (const auto& [orig_reg_and_instance, new_reg] : vis.reg_map()) {
+  for (const auto& [orig_reg_and_instance, new_reg] : flattener.reg_map()) {
     const auto& [orig_reg, instance] = orig_reg_and_instance;
     if (instance->parent_instance()) {
       reg_renames[absl::StrFormat("%s%s", instance->RegisterPrefix(),
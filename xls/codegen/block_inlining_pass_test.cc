@@ -22,6 +22,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "xls/codegen/codegen_pass.h"
 #include "xls/common/status/matchers.h"
@@ -335,5 +336,54 @@ TEST_F(BlockInliningPassTest, InlineBlocksWithExtern) {
                              testing::Contains(m::InstantiationOutput(
                                  "return", right_foobar_inst))));
 }
+
+TEST_F(BlockInliningPassTest, InlineDeepHierarchy) {
+  auto p = CreatePackage();
+
+  // (define level_0 (x) (+ x 1))
+  // (define level_n (x) (level_n-1 (level_n-1 x)))
+  constexpr int64_t kLevels = 10;
+  BlockBuilder bb_leaf("level_0", p.get());
+  bb_leaf.OutputPort("res",
+                     bb_leaf.Add(bb_leaf.InputPort("x", p->GetBitsType(32)),
+                                 bb_leaf.Literal(UBits(1, 32))));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * level, bb_leaf.Build());
+  for (int64_t i = 1; i <= kLevels; ++i) {
+    BlockBuilder bb(i == kLevels ? TestName() : absl::StrCat("level_", i),
+                    p.get());
+    XLS_ASSERT_OK_AND_ASSIGN(Instantiation * first,
+                             bb.block()->AddBlockInstantiation("first", level));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Instantiation * second,
+        bb.block()->AddBlockInstantiation("second", level));
+    bb.InstantiationInput(first, "x", bb.InputPort("x", p->GetBitsType(32)));
+    bb.InstantiationInput(second, "x", bb.InstantiationOutput(first, "res"));
+    bb.OutputPort("res", bb.InstantiationOutput(second, "res"));
+    XLS_ASSERT_OK_AND_ASSIGN(level, bb.Build());
+  }
+  Block* top = level;
+
+  BlockInliningPass bip;
+  CodegenPassUnit pu(p.get(), top);
+  CodegenPassResults results;
+  CodegenPassOptions opt;
+  ASSERT_THAT(bip.Run(&pu, opt, &results), absl_testing::IsOkAndHolds(true));
+
+  Block* inlined = pu.top_block;
+  EXPECT_THAT(inlined->nodes(),
+              testing::Not(testing::Contains(m::InstantiationInput())));
+  EXPECT_THAT(inlined->nodes(),
+              testing::Not(testing::Contains(m::InstantiationOutput())));
+  EXPECT_EQ(inlined->GetInputPorts().size(), 1);
+  EXPECT_EQ(inlined->GetOutputPorts().size(), 1);
+
+  InterpreterBlockEvaluator eval;
+  XLS_ASSERT_OK_AND_ASSIGN(auto test, eval.NewContinuation(inlined));
+  XLS_ASSERT_OK(test->RunOneCycle({{"x", Value(UBits(5, 32))}}));
+  EXPECT_THAT(test->output_ports(),
+              UnorderedElementsAre(
+                  Pair("res", Value(UBits(5 + (int64_t{1} << kLevels), 32)))));
+}
+
 }  // namespace
 }  // namespace xls::verilog
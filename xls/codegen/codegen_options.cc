@@ -69,10 +69,14 @@ CodegenOptions::CodegenOptions(const CodegenOptions& options)
       array_index_bounds_checking_(options.array_index_bounds_checking_),
       gate_recvs_(options.gate_recvs_),
       register_merge_strategy_(options.register_merge_strategy_),
+      retime_registers_(options.retime_registers_),
+      share_resources_(options.share_resources_),
+      instantiated_functions_(options.instantiated_functions_),
       package_interface_(options.package_interface_),
       emit_sv_types_(options.emit_sv_types_),
       simulation_macro_name_(options.simulation_macro_name_),
-      codegen_version_(options.codegen_version_) {
+      codegen_version_(options.codegen_version_),
+      module_cache_dir_(options.module_cache_dir_) {
   for (auto& [op, op_override] : options.op_overrides_) {
     op_overrides_.insert_or_assign(op, op_override->Clone());
   }
@@ -106,10 +110,14 @@ CodegenOptions& CodegenOptions::operator=(const CodegenOptions& options) {
   array_index_bounds_checking_ = options.array_index_bounds_checking_;
   gate_recvs_ = options.gate_recvs_;
   register_merge_strategy_ = options.register_merge_strategy_;
+  retime_registers_ = options.retime_registers_;
+  share_resources_ = options.share_resources_;
+  instantiated_functions_ = options.instantiated_functions_;
   package_interface_ = options.package_interface_;
   emit_sv_types_ = options.emit_sv_types_;
   simulation_macro_name_ = options.simulation_macro_name_;
   codegen_version_ = options.codegen_version_;
+  module_cache_dir_ = options.module_cache_dir_;
 
   for (auto& [op, op_override] : options.op_overrides_) {
     op_overrides_.insert_or_assign(op, op_override->Clone());
@@ -302,4 +310,14 @@ CodegenOptions& CodegenOptions::register_merge_strategy(
   return *this;
 }
 
+CodegenOptions& CodegenOptions::retime_registers(bool value) {
+  retime_registers_ = value;
+  return *this;
+}
+
+CodegenOptions& CodegenOptions::share_resources(bool value) {
+  share_resources_ = value;
+  return *this;
+}
+
 }  // namespace xls::verilog
@@ -264,6 +264,27 @@ class CodegenOptions {
     return register_merge_strategy_;
   }
 
+  // Whether to retime pipeline registers across the combinational nodes at
+  // stage boundaries (see RegisterRetimingPass). Requires a delay estimator.
+  CodegenOptions& retime_registers(bool value);
+  bool retime_registers() const { return retime_registers_; }
+
+  // Whether to share expensive operations between mutually exclusive uses in
+  // the same stage (see ResourceSharingPass). Requires a delay estimator.
+  CodegenOptions& share_resources(bool value);
+  bool share_resources() const { return share_resources_; }
+
+  // Names of the functions whose invocations are emitted as instantiations of
+  // a module generated once per function (see FunctionInstantiationPass)
+  // rather than having to be inlined before codegen.
+  CodegenOptions& instantiated_functions(absl::Span<const std::string> names) {
+    instantiated_functions_.assign(names.begin(), names.end());
+    return *this;
+  }
+  absl::Span<const std::string> instantiated_functions() const {
+    return instantiated_functions_;
+  }
+
   int64_t max_trace_verbosity() const { return max_trace_verbosity_; }
   CodegenOptions& set_max_trace_verbosity(int64_t value) {
     max_trace_verbosity_ = value;
@@ -303,6 +324,17 @@ class CodegenOptions {
   }
   Version codegen_version() const { return codegen_version_; }
 
+  // Directory of a cache of the modules generated for blocks. Modules of blocks
+  // whose IR and options are unchanged since an earlier run are read from the
+  // cache instead of being generated again. No cache is used if not given.
+  CodegenOptions& module_cache_dir(std::string_view value) {
+    module_cache_dir_ = value;
+    return *this;
+  }
+  std::optional<std::string_view> module_cache_dir() const {
+    return module_cache_dir_;
+  }
+
   // Whether to generate combinational logic.
   CodegenOptions& generate_combinational(bool value) {
     generate_combinational_ = value;
@@ -339,11 +371,15 @@ class CodegenOptions {
   int64_t max_trace_verbosity_ = 0;
   RegisterMergeStrategy register_merge_strategy_ =
       RegisterMergeStrategy::kDefault;
+  bool retime_registers_ = false;
+  bool share_resources_ = false;
+  std::vector<std::string> instantiated_functions_;
   std::optional<PackageInterfaceProto> package_interface_;
   std::vector<std::string> includes_;
   bool emit_sv_types_ = true;
   std::string simulation_macro_name_ = "SIMULATION";
   Version codegen_version_ = Version::kDefault;
+  std::optional<std::string> module_cache_dir_;
 };
 
 template <typename Sink>
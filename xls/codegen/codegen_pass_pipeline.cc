@@ -26,6 +26,7 @@
 #include "xls/codegen/codegen_pass.h"
 #include "xls/codegen/codegen_wrapper_pass.h"
 #include "xls/codegen/ffi_instantiation_pass.h"
+#include "xls/codegen/function_instantiation_pass.h"
 #include "xls/codegen/mulp_combining_pass.h"
 #include "xls/codegen/name_legalization_pass.h"
 #include "xls/codegen/port_legalization_pass.h"
@@ -33,6 +34,8 @@
 #include "xls/codegen/ram_rewrite_pass.h"
 #include "xls/codegen/register_combining_pass.h"
 #include "xls/codegen/register_legalization_pass.h"
+#include "xls/codegen/register_retiming_pass.h"
+#include "xls/codegen/resource_sharing_pass.h"
 #include "xls/codegen/side_effect_condition_pass.h"
 #include "xls/codegen/signature_generation_pass.h"
 #include "xls/codegen/trace_verbosity_pass.h"
@@ -54,6 +57,11 @@ std::unique_ptr<CodegenCompoundPass> CreateCodegenPassPipeline() {
   // and stitches the others.
   top->Add<BlockStitchingPass>();
 
+  // Convert invocations of the functions selected in the codegen options into
+  // instantiations of blocks shared by every invocation of the same function.
+  // This runs before the blocks are legalized so that the new blocks are too.
+  top->Add<FunctionInstantiationPass>();
+
   // Generate the signature from the initial proc and options prior to any
   // transformations. If necessary the signature can be mutated later if the
   // proc is transformed in a way which affects its externally visible
@@ -87,12 +95,21 @@ std::unique_ptr<CodegenCompoundPass> CreateCodegenPassPipeline() {
   // Filter out traces filtered by verbosity config.
   top->Add<TraceVerbosityPass>();
 
+  // Share expensive operations between mutually exclusive uses in the same
+  // stage. This runs before priority-select reduction so that the operand muxes
+  // it adds are simplified too.
+  top->Add<ResourceSharingPass>();
+
   // Replace provably-unneeded priority-select operations with simpler selects.
   top->Add<PrioritySelectReductionPass>();
 
   // Update assert conditions to be guarded by pipeline_valid signals.
   top->Add<SideEffectConditionPass>();
 
+  // Move pipeline registers across the nodes at stage boundaries where this
+  // saves flops or balances stage delays.
+  top->Add<RegisterRetimingPass>();
+
   // Deduplicate registers across mutually exclusive stages.
   top->Add<RegisterCombiningPass>();
 
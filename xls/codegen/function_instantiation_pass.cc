@@ -0,0 +1,175 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/function_instantiation_pass.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/codegen/vast/vast.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+#include "xls/ir/topo_sort.h"
+
+namespace xls::verilog {
+namespace {
+
+// Returns a name derived from `name` which is not used by any block in
+// `package`.
+std::string UniqueBlockName(Package* package, std::string_view name) {
+  const std::string base_name = SanitizeIdentifier(name);
+  std::string block_name = base_name;
+  for (int64_t i = 1; package->GetBlock(block_name).ok(); ++i) {
+    block_name = absl::StrCat(base_name, "_", i);
+  }
+  return block_name;
+}
+
+// Converts `function` into a combinational block in the same package. Function
+// parameters become input ports of the same name and the return value becomes
+// the output port `output_port_name`.
+absl::StatusOr<Block*> FunctionToInstantiableBlock(
+    Function* function, std::string_view output_port_name) {
+  Package* package = function->package();
+  Block* block = package->AddBlock(std::make_unique<Block>(
+      UniqueBlockName(package, function->name()), package));
+
+  absl::flat_hash_map<Node*, Node*> node_map;
+  for (Param* param : function->params()) {
+    XLS_ASSIGN_OR_RETURN(
+        node_map[param],
+        block->AddInputPort(param->name(), param->GetType(), param->loc()));
+  }
+  for (Node* node : TopoSort(function)) {
+    if (node->Is<Param>()) {
+      continue;
+    }
+    std::vector<Node*> new_operands;
+    new_operands.reserve(node->operand_count());
+    for (Node* operand : node->operands()) {
+      new_operands.push_back(node_map.at(operand));
+    }
+    XLS_ASSIGN_OR_RETURN(node_map[node],
+                         node->CloneInNewFunction(new_operands, block));
+  }
+  XLS_RETURN_IF_ERROR(
+      block
+          ->AddOutputPort(output_port_name,
+                          node_map.at(function->return_value()))
+          .status());
+  return block;
+}
+
+}  // namespace
+
+absl::StatusOr<bool> FunctionInstantiationPass::RunInternal(
+    CodegenPassUnit* unit, const CodegenPassOptions& options,
+    CodegenPassResults* results) const {
+  const absl::flat_hash_set<std::string_view> instantiated_functions(
+      options.codegen_options.instantiated_functions().begin(),
+      options.codegen_options.instantiated_functions().end());
+  if (instantiated_functions.empty()) {
+    return false;
+  }
+  const std::string_view output_port_name =
+      options.codegen_options.output_port_name();
+
+  // The blocks converted from functions may themselves invoke functions to be
+  // instantiated so they are added to the worklist as they are created.
+  std::vector<Block*> worklist;
+  for (const std::unique_ptr<Block>& block : unit->package->blocks()) {
+    worklist.push_back(block.get());
+  }
+  absl::flat_hash_map<Function*, Block*> function_blocks;
+  bool changed = false;
+  while (!worklist.empty()) {
+    Block* block = worklist.back();
+    worklist.pop_back();
+
+    std::vector<Invoke*> invocations;
+    for (Node* node : block->nodes()) {
+      if (node->Is<Invoke>() &&
+          instantiated_functions.contains(
+              node->As<Invoke>()->to_apply()->name())) {
+        invocations.push_back(node->As<Invoke>());
+      }
+    }
+
+    for (Invoke* invocation : invocations) {
+      Function* const function = invocation->to_apply();
+      auto [it, inserted] = function_blocks.try_emplace(function, nullptr);
+      if (inserted) {
+        XLS_ASSIGN_OR_RETURN(
+            it->second,
+            FunctionToInstantiableBlock(function, output_port_name));
+        worklist.push_back(it->second);
+      }
+
+      const std::string inst_name = SanitizeIdentifier(
+          absl::StrCat(function->name(), "_", invocation->GetName(), "_inst"));
+      XLS_ASSIGN_OR_RETURN(xls::Instantiation * instantiation,
+                           block->AddBlockInstantiation(inst_name, it->second));
+
+      std::vector<Node*> new_nodes;
+      for (int64_t i = 0; i < invocation->operand_count(); ++i) {
+        XLS_ASSIGN_OR_RETURN(new_nodes.emplace_back(),
+                             block->MakeNode<InstantiationInput>(
+                                 invocation->loc(), invocation->operand(i),
+                                 instantiation, function->param(i)->name()));
+      }
+      XLS_ASSIGN_OR_RETURN(new_nodes.emplace_back(),
+                           invocation->ReplaceUsesWithNew<InstantiationOutput>(
+                               instantiation, output_port_name));
+
+      // The instantiation inputs and outputs are placed in the pipeline stage
+      // of the invocation they replace.
+      if (auto metadata_it = unit->metadata.find(block);
+          metadata_it != unit->metadata.end()) {
+        absl::flat_hash_map<Node*, Stage>& stage_map =
+            metadata_it->second.streaming_io_and_pipeline.node_to_stage_map;
+        if (auto stage_it = stage_map.find(invocation);
+            stage_it != stage_map.end()) {
+          const Stage stage = stage_it->second;
+          for (Node* node : new_nodes) {
+            stage_map[node] = stage;
+          }
+        }
+      }
+
+      XLS_RETURN_IF_ERROR(block->RemoveNode(invocation));
+      changed = true;
+    }
+  }
+
+  if (changed) {
+    unit->GcMetadata();
+  }
+  return changed;
+}
+
+}  // namespace xls::verilog
@@ -0,0 +1,43 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_FUNCTION_INSTANTIATION_PASS_H_
+#define XLS_CODEGEN_FUNCTION_INSTANTIATION_PASS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/codegen/codegen_pass.h"
+
+namespace xls::verilog {
+
+// Replaces invoke() of the functions named in
+// CodegenOptions::instantiated_functions() with instantiations of a
+// combinational block converted from the function. The block is converted once
+// per function and shared by all of its invocations, so each function is
+// emitted as a single Verilog module rather than being inlined at every call.
+class FunctionInstantiationPass : public CodegenPass {
+ public:
+  FunctionInstantiationPass()
+      : CodegenPass("function_instantiation",
+                    "Convert invocations of selected functions to block "
+                    "instantiations") {}
+  ~FunctionInstantiationPass() override = default;
+
+  absl::StatusOr<bool> RunInternal(CodegenPassUnit* unit,
+                                   const CodegenPassOptions& options,
+                                   CodegenPassResults* results) const final;
+};
+
+}  // namespace xls::verilog
+
+#endif  // XLS_CODEGEN_FUNCTION_INSTANTIATION_PASS_H_
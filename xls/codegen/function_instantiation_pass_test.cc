@@ -0,0 +1,186 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/function_instantiation_pass.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/algorithm/container.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/codegen/block_generator.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/common/casts.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/verifier.h"
+
+namespace xls::verilog {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::testing::Each;
+using ::testing::SizeIs;
+using ::testing::UnorderedElementsAre;
+
+class FunctionInstantiationPassTest : public IrTestBase {
+ protected:
+  absl::StatusOr<bool> Run(Block* block,
+                           absl::Span<const std::string> functions) {
+    CodegenPassResults results;
+    CodegenPassUnit unit(block->package(), block);
+    CodegenPassOptions options;
+    options.codegen_options.instantiated_functions(functions);
+    return FunctionInstantiationPass().Run(&unit, options, &results);
+  }
+
+  static int64_t InvokeCount(Block* block) {
+    return absl::c_count_if(block->nodes(),
+                            [](Node* n) { return n->Is<Invoke>(); });
+  }
+
+  static int64_t CountOccurrences(std::string_view text,
+                                  std::string_view pattern) {
+    int64_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string_view::npos;
+         pos = text.find(pattern, pos + 1)) {
+      ++count;
+    }
+    return count;
+  }
+
+  static Block* InstantiatedBlock(xls::Instantiation* instantiation) {
+    return down_cast<BlockInstantiation*>(instantiation)->instantiated_block();
+  }
+};
+
+TEST_F(FunctionInstantiationPassTest, InvocationsShareOneBlock) {
+  auto p = CreatePackage();
+  BitsType* const u32 = p->GetBitsType(32);
+
+  FunctionBuilder fb("adder", p.get());
+  fb.Add(fb.Param("a", u32), fb.Param("b", u32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * adder, fb.Build());
+
+  BlockBuilder bb(TestName(), p.get());
+  BValue x = bb.InputPort("x", u32);
+  BValue y = bb.InputPort("y", u32);
+  BValue sum = bb.Invoke({x, y}, adder);
+  bb.OutputPort("out", bb.Invoke({sum, y}, adder));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  EXPECT_THAT(Run(block, {"adder"}), IsOkAndHolds(true));
+  EXPECT_THAT(Run(block, {"adder"}), IsOkAndHolds(false));
+
+  EXPECT_EQ(InvokeCount(block), 0);
+  ASSERT_THAT(block->GetInstantiations(), SizeIs(2));
+  EXPECT_THAT(block->GetInstantiations(),
+              Each(testing::Property(&xls::Instantiation::kind,
+                                     InstantiationKind::kBlock)));
+  Block* adder_block = InstantiatedBlock(block->GetInstantiations()[0]);
+  EXPECT_EQ(InstantiatedBlock(block->GetInstantiations()[1]), adder_block);
+  EXPECT_EQ(adder_block->name(), "adder");
+
+  std::vector<std::string> port_names;
+  for (const Block::Port& port : adder_block->GetPorts()) {
+    port_names.push_back(Block::PortName(port));
+  }
+  EXPECT_THAT(port_names, UnorderedElementsAre("a", "b", "out"));
+  XLS_EXPECT_OK(VerifyPackage(p.get()));
+
+  // The function is emitted as a single module instantiated twice.
+  XLS_ASSERT_OK_AND_ASSIGN(std::string verilog,
+                           GenerateVerilog(block, CodegenOptions()));
+  EXPECT_EQ(CountOccurrences(verilog, "module adder("), 1);
+  EXPECT_EQ(CountOccurrences(verilog, "adder adder_"), 2);
+}
+
+TEST_F(FunctionInstantiationPassTest, UnselectedFunctionsAreNotInstantiated) {
+  auto p = CreatePackage();
+  BitsType* const u32 = p->GetBitsType(32);
+
+  FunctionBuilder fb("negate", p.get());
+  fb.Negate(fb.Param("a", u32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * negate, fb.Build());
+
+  BlockBuilder bb(TestName(), p.get());
+  bb.OutputPort("out", bb.Invoke({bb.InputPort("x", u32)}, negate));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  EXPECT_THAT(Run(block, {}), IsOkAndHolds(false));
+  EXPECT_THAT(Run(block, {"other"}), IsOkAndHolds(false));
+  EXPECT_EQ(InvokeCount(block), 1);
+  EXPECT_THAT(block->GetInstantiations(), testing::IsEmpty());
+}
+
+TEST_F(FunctionInstantiationPassTest, NestedInvocations) {
+  auto p = CreatePackage();
+  BitsType* const u16 = p->GetBitsType(16);
+
+  FunctionBuilder inner_fb("inner", p.get());
+  inner_fb.Not(inner_fb.Param("a", u16));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * inner, inner_fb.Build());
+
+  FunctionBuilder outer_fb("outer", p.get());
+  BValue a = outer_fb.Param("a", u16);
+  outer_fb.Tuple({outer_fb.Invoke({a}, inner), a});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * outer, outer_fb.Build());
+
+  BlockBuilder bb(TestName(), p.get());
+  bb.OutputPort("out", bb.Invoke({bb.InputPort("x", u16)}, outer));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  EXPECT_THAT(Run(block, {"inner", "outer"}), IsOkAndHolds(true));
+
+  EXPECT_EQ(InvokeCount(block), 0);
+  ASSERT_THAT(block->GetInstantiations(), SizeIs(1));
+  Block* outer_block = InstantiatedBlock(block->GetInstantiations()[0]);
+  EXPECT_EQ(outer_block->name(), "outer");
+  EXPECT_EQ(InvokeCount(outer_block), 0);
+  ASSERT_THAT(outer_block->GetInstantiations(), SizeIs(1));
+  EXPECT_EQ(InstantiatedBlock(outer_block->GetInstantiations()[0])->name(),
+            "inner");
+  XLS_EXPECT_OK(VerifyPackage(p.get()));
+}
+
+TEST_F(FunctionInstantiationPassTest, BlockNamesAreUnique) {
+  auto p = CreatePackage();
+  BitsType* const u8 = p->GetBitsType(8);
+
+  FunctionBuilder fb("f", p.get());
+  fb.Identity(fb.Param("a", u8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  BlockBuilder bb("f", p.get());
+  bb.OutputPort("out", bb.Invoke({bb.InputPort("x", u8)}, f));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  EXPECT_THAT(Run(block, {"f"}), IsOkAndHolds(true));
+  ASSERT_THAT(block->GetInstantiations(), SizeIs(1));
+  EXPECT_EQ(InstantiatedBlock(block->GetInstantiations()[0])->name(), "f_1");
+}
+
+}  // namespace
+}  // namespace xls::verilog
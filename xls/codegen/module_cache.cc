@@ -0,0 +1,160 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/module_cache.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "openssl/sha.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/block.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/type.h"
+
+namespace xls::verilog {
+/* static */ absl::StatusOr<std::unique_ptr<ModuleCache>> ModuleCache::Create(
+    const std::filesystem::path& directory) {
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(directory));
+  return std::unique_ptr<ModuleCache>(new ModuleCache(directory));
+}
+
+/* static */ std::optional<std::string> ModuleCache::ComputeKey(
+    Block* block, const CodegenOptions& options,
+    const absl::flat_hash_map<InputPort*, std::string>& input_port_sv_types,
+    const absl::flat_hash_map<OutputPort*, std::string>&
+        output_port_sv_types) {
+  // Only the options read while generating the module from the block IR
+  // matter; the others have already shaped the IR itself.
+  std::string preimage = absl::StrFormat(
+      "version: %d\nsystem_verilog: %d\nemit_sv_types: %d\n"
+      "emit_as_pipeline: %d\nseparate_lines: %d\nmax_inline_depth: %d\n"
+      "array_index_bounds_checking: %d\nsimulation_macro_name: %s\n",
+      kFormatVersion, options.use_system_verilog(), options.emit_sv_types(),
+      options.emit_as_pipeline(), options.separate_lines(),
+      options.max_inline_depth(), options.array_index_bounds_checking(),
+      options.simulation_macro_name());
+
+  absl::btree_set<Fileno> filenos;
+  for (Node* node : block->nodes()) {
+    if (options.GetOpOverride(node->op()).has_value()) {
+      return std::nullopt;
+    }
+    for (const SourceLocation& loc : node->loc().locations) {
+      filenos.insert(loc.fileno());
+    }
+  }
+  for (Fileno fileno : filenos) {
+    absl::StrAppendFormat(
+        &preimage, "file %d: %s\n", static_cast<int32_t>(fileno),
+        block->package()->GetFilename(fileno).value_or(""));
+  }
+
+  // The module refers to the ports of the blocks it instantiates.
+  for (xls::Instantiation* instantiation : block->GetInstantiations()) {
+    auto* block_instantiation = dynamic_cast<BlockInstantiation*>(instantiation);
+    if (block_instantiation == nullptr) {
+      continue;
+    }
+    Block* instantiated = block_instantiation->instantiated_block();
+    absl::StrAppend(&preimage, "instantiated block ", instantiated->name(),
+                    ":\n");
+    for (const Block::Port& port : instantiated->GetPorts()) {
+      if (std::holds_alternative<InputPort*>(port)) {
+        InputPort* p = std::get<InputPort*>(port);
+        absl::StrAppend(&preimage, "  input ", p->name(), ": ",
+                        p->GetType()->ToString(), "\n");
+      } else if (std::holds_alternative<OutputPort*>(port)) {
+        OutputPort* p = std::get<OutputPort*>(port);
+        absl::StrAppend(&preimage, "  output ", p->name(), ": ",
+                        p->operand(0)->GetType()->ToString(), "\n");
+      } else {
+        absl::StrAppend(&preimage, "  clock ",
+                        std::get<Block::ClockPort*>(port)->name, "\n");
+      }
+    }
+  }
+
+  for (InputPort* port : block->GetInputPorts()) {
+    if (auto it = input_port_sv_types.find(port);
+        it != input_port_sv_types.end()) {
+      absl::StrAppend(&preimage, "sv_type ", port->name(), ": ", it->second,
+                      "\n");
+    }
+  }
+  for (OutputPort* port : block->GetOutputPorts()) {
+    if (auto it = output_port_sv_types.find(port);
+        it != output_port_sv_types.end()) {
+      absl::StrAppend(&preimage, "sv_type ", port->name(), ": ", it->second,
+                      "\n");
+    }
+  }
+
+  absl::StrAppend(&preimage, block->DumpIr());
+  std::array<char, SHA256_DIGEST_LENGTH> digest;
+  SHA256(reinterpret_cast<const uint8_t*>(preimage.data()), preimage.size(),
+         reinterpret_cast<uint8_t*>(digest.data()));
+  return absl::BytesToHexString({digest.data(), digest.size()});
+}
+
+std::filesystem::path ModuleCache::VerilogPath(std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".v");
+}
+
+std::filesystem::path ModuleCache::LineMapPath(std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".line_map.pb");
+}
+
+absl::StatusOr<std::optional<CachedModule>> ModuleCache::Lookup(
+    std::string_view key) {
+  // The line map is written last so its presence marks a complete entry.
+  if (!FileExists(LineMapPath(key)).ok()) {
+    return std::nullopt;
+  }
+  CachedModule result;
+  XLS_RETURN_IF_ERROR(ParseProtobinFile(LineMapPath(key), &result.line_map));
+  XLS_ASSIGN_OR_RETURN(result.verilog_text, GetFileContents(VerilogPath(key)));
+  VLOG(1) << "Module cache hit for " << key;
+  return result;
+}
+
+absl::Status ModuleCache::Store(std::string_view key,
+                                const CachedModule& module) {
+  XLS_RETURN_IF_ERROR(
+      AtomicallySetFileContents(VerilogPath(key), module.verilog_text));
+  return AtomicallySetFileContents(LineMapPath(key),
+                                   module.line_map.SerializeAsString());
+}
+
+}  // namespace xls::verilog
@@ -0,0 +1,94 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_MODULE_CACHE_H_
+#define XLS_CODEGEN_MODULE_CACHE_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/codegen/verilog_line_map.pb.h"
+#include "xls/ir/block.h"
+#include "xls/ir/nodes.h"
+
+namespace xls::verilog {
+
+// The Verilog text generated for a single block along with the mapping of its
+// lines back to the IR. The Verilog line numbers of `line_map` are relative to
+// the first line of `verilog_text`.
+struct CachedModule {
+  std::string verilog_text;
+  VerilogLineMap line_map;
+};
+
+// A persistent on-disk cache of the modules generated for blocks, so that
+// rerunning codegen on a package in which only a few blocks changed does not
+// generate the modules of the other blocks again. Entries are keyed by a hash
+// of everything the module text depends on.
+//
+// Entries are written to a temporary file and renamed into place so concurrent
+// processes sharing a cache directory never observe partially written entries.
+// The cache is never pruned; stale entries are simply never looked up again.
+class ModuleCache {
+ public:
+  // Bumped whenever the layout of cached entries or the text generated for a
+  // given block changes in a way the key would not otherwise capture.
+  static constexpr int64_t kFormatVersion = 1;
+
+  // Creates a cache backed by the given directory, creating it if needed.
+  static absl::StatusOr<std::unique_ptr<ModuleCache>> Create(
+      const std::filesystem::path& directory);
+
+  // Returns the cache key for the module generated for `block`. The key covers
+  // the IR of the block, the ports of the blocks it instantiates, the source
+  // files its nodes refer to, the options which affect module generation and
+  // the SystemVerilog types of its ports. Returns std::nullopt if the module
+  // cannot be cached because the options override the codegen of an op used
+  // in the block.
+  static std::optional<std::string> ComputeKey(
+      Block* block, const CodegenOptions& options,
+      const absl::flat_hash_map<InputPort*, std::string>& input_port_sv_types,
+      const absl::flat_hash_map<OutputPort*, std::string>&
+          output_port_sv_types);
+
+  // Returns the entry stored under `key` or std::nullopt if there is none.
+  absl::StatusOr<std::optional<CachedModule>> Lookup(std::string_view key);
+
+  // Stores `module` under `key`.
+  absl::Status Store(std::string_view key, const CachedModule& module);
+
+  const std::filesystem::path& directory() const { return directory_; }
+
+ private:
+  explicit ModuleCache(std::filesystem::path directory)
+      : directory_(std::move(directory)) {}
+
+  std::filesystem::path VerilogPath(std::string_view key) const;
+  std::filesystem::path LineMapPath(std::string_view key) const;
+
+  std::filesystem::path directory_;
+};
+
+}  // namespace xls::verilog
+
+#endif  // XLS_CODEGEN_MODULE_CACHE_H_
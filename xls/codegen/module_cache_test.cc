@@ -0,0 +1,167 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/module_cache.h"
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "xls/codegen/block_generator.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/codegen/verilog_line_map.pb.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+
+namespace xls::verilog {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::testing::Ne;
+using ::testing::Optional;
+
+class ModuleCacheTest : public IrTestBase {
+ protected:
+  absl::StatusOr<Block*> MakeSubtractBlock(Package* package) {
+    Type* u32 = package->GetBitsType(32);
+    BlockBuilder bb("subtractor", package);
+    bb.OutputPort("result",
+                  bb.Subtract(bb.InputPort("a", u32), bb.InputPort("b", u32)));
+    return bb.Build();
+  }
+
+  // Makes a block which instantiates `sub_block` and, if `negate` is true,
+  // negates its result.
+  absl::StatusOr<Block*> MakeTopBlock(Block* sub_block, bool negate,
+                                      Package* package) {
+    Type* u32 = package->GetBitsType(32);
+    BlockBuilder bb("top", package);
+    BValue x = bb.InputPort("x", u32);
+    BValue y = bb.InputPort("y", u32);
+    XLS_ASSIGN_OR_RETURN(
+        xls::Instantiation * instantiation,
+        bb.block()->AddBlockInstantiation("sub", sub_block));
+    bb.InstantiationInput(instantiation, "a", x);
+    bb.InstantiationInput(instantiation, "b", y);
+    BValue result = bb.InstantiationOutput(instantiation, "result");
+    bb.OutputPort("z", negate ? bb.Negate(result) : result);
+    return bb.Build();
+  }
+
+  static int64_t EntryFileCount(const std::filesystem::path& dir) {
+    return std::distance(std::filesystem::directory_iterator(dir),
+                         std::filesystem::directory_iterator());
+  }
+};
+
+TEST_F(ModuleCacheTest, KeyDependsOnIrAndOptions) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Block * sub, MakeSubtractBlock(p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * top, MakeTopBlock(sub, false, p.get()));
+
+  CodegenOptions options;
+  std::optional<std::string> key =
+      ModuleCache::ComputeKey(sub, options, {}, {});
+  ASSERT_TRUE(key.has_value());
+  EXPECT_THAT(ModuleCache::ComputeKey(sub, options, {}, {}), Optional(*key));
+  EXPECT_THAT(ModuleCache::ComputeKey(top, options, {}, {}),
+              Optional(Ne(*key)));
+  EXPECT_THAT(ModuleCache::ComputeKey(
+                  sub, CodegenOptions().use_system_verilog(false), {}, {}),
+              Optional(Ne(*key)));
+  EXPECT_THAT(ModuleCache::ComputeKey(
+                  sub, CodegenOptions().max_inline_depth(1), {}, {}),
+              Optional(Ne(*key)));
+}
+
+TEST_F(ModuleCacheTest, LookupMissingEntry) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModuleCache> cache,
+                           ModuleCache::Create(temp_dir.path() / "cache"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<CachedModule> entry,
+                           cache->Lookup("does_not_exist"));
+  EXPECT_FALSE(entry.has_value());
+}
+
+TEST_F(ModuleCacheTest, StoreAndLookup) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModuleCache> cache,
+                           ModuleCache::Create(temp_dir.path()));
+  CachedModule module;
+  module.verilog_text = "module foo();\nendmodule\n";
+  VerilogLineMapping* mapping = module.line_map.add_mapping();
+  mapping->set_source_file("foo.x");
+  mapping->mutable_verilog_span()->set_line_start(1);
+  mapping->mutable_verilog_span()->set_line_end(1);
+  XLS_ASSERT_OK(cache->Store("abc", module));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<CachedModule> entry,
+                           cache->Lookup("abc"));
+  ASSERT_TRUE(entry.has_value());
+  EXPECT_EQ(entry->verilog_text, module.verilog_text);
+  EXPECT_EQ(entry->line_map.SerializeAsString(),
+            module.line_map.SerializeAsString());
+}
+
+TEST_F(ModuleCacheTest, OnlyChangedBlocksAreRegenerated) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  CodegenOptions uncached;
+  CodegenOptions cached = uncached;
+  cached.module_cache_dir(temp_dir.path().string());
+
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Block * sub, MakeSubtractBlock(p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * top, MakeTopBlock(sub, false, p.get()));
+
+  VerilogLineMap expected_line_map;
+  XLS_ASSERT_OK_AND_ASSIGN(std::string expected,
+                           GenerateVerilog(top, uncached, &expected_line_map));
+
+  // A cold and then a warm run both match the uncached output.
+  for (int64_t i = 0; i < 2; ++i) {
+    VerilogLineMap line_map;
+    EXPECT_THAT(GenerateVerilog(top, cached, &line_map),
+                IsOkAndHolds(expected));
+    EXPECT_EQ(line_map.SerializeAsString(),
+              expected_line_map.SerializeAsString());
+    // A text and a line map for each of the two modules.
+    EXPECT_EQ(EntryFileCount(temp_dir.path()), 4);
+  }
+
+  // Changing the top block adds an entry only for it.
+  auto p2 = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Block * sub2, MakeSubtractBlock(p2.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * top2, MakeTopBlock(sub2, true, p2.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string expected2,
+                           GenerateVerilog(top2, uncached));
+  EXPECT_THAT(GenerateVerilog(top2, cached), IsOkAndHolds(expected2));
+  EXPECT_EQ(EntryFileCount(temp_dir.path()), 6);
+}
+
+}  // namespace
+}  // namespace xls::verilog
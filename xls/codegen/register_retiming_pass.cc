@@ -0,0 +1,408 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/register_retiming_pass.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/codegen/block_conversion.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/estimators/delay_model/delay_estimator.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/ir/block.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/register.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/ir/value.h"
+
+namespace xls::verilog {
+namespace {
+
+int64_t NodeDelay(Node* node, const DelayEstimator& delay_estimator) {
+  absl::StatusOr<int64_t> delay = delay_estimator.GetOperationDelayInPs(node);
+  return delay.ok() ? *delay : 0;
+}
+
+// Delays through the combinational logic of a block. As in the block metrics,
+// paths start at input ports and register reads (whose delay is the clk-to-q
+// delay) and end at output ports and register writes.
+struct Timing {
+  // Largest delay from the start of a path to the output of each node.
+  absl::flat_hash_map<Node*, int64_t> arrival;
+  // Largest delay from the output of each node to the end of a path.
+  absl::flat_hash_map<Node*, int64_t> tail;
+  // Largest delay through the nodes of each stage.
+  std::vector<int64_t> stage_delay;
+  // Largest delay of any path in the block.
+  int64_t critical_path = 0;
+};
+
+Timing AnalyzeTiming(Block* block, const StreamingIOPipeline& pipeline,
+                     const DelayEstimator& delay_estimator) {
+  Timing timing;
+  timing.stage_delay.resize(pipeline.pipeline_registers.size() + 1, 0);
+  std::vector<Node*> topo_order = TopoSort(block);
+  for (Node* node : topo_order) {
+    int64_t arrival = 0;
+    for (Node* operand : node->operands()) {
+      arrival = std::max(arrival, timing.arrival.at(operand));
+    }
+    if (!node->Is<RegisterWrite>() && !node->Is<OutputPort>()) {
+      arrival += NodeDelay(node, delay_estimator);
+    }
+    timing.arrival[node] = arrival;
+    timing.critical_path = std::max(timing.critical_path, arrival);
+    if (auto it = pipeline.node_to_stage_map.find(node);
+        it != pipeline.node_to_stage_map.end() &&
+        it->second < timing.stage_delay.size()) {
+      timing.stage_delay[it->second] =
+          std::max(timing.stage_delay[it->second], arrival);
+    }
+  }
+  for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+    int64_t tail = 0;
+    for (Node* user : (*it)->users()) {
+      if (!user->Is<RegisterWrite>() && !user->Is<OutputPort>()) {
+        tail = std::max(tail,
+                        NodeDelay(user, delay_estimator) + timing.tail[user]);
+      }
+    }
+    timing.tail[*it] = tail;
+  }
+  return timing;
+}
+
+// Returns the nodes the metadata refers to. These carry the valid and flow
+// control semantics of the pipeline and are never moved.
+absl::flat_hash_set<Node*> ReferencedNodes(
+    const StreamingIOPipeline& pipeline) {
+  absl::flat_hash_set<Node*> nodes;
+  auto add = [&](const std::optional<Node*>& node) {
+    if (node.has_value()) {
+      nodes.insert(*node);
+    }
+  };
+  for (const std::vector<StreamingInput>& inputs : pipeline.inputs) {
+    for (const StreamingInput& input : inputs) {
+      add(input.signal_data);
+      add(input.signal_valid);
+      add(input.predicate);
+    }
+  }
+  for (const std::vector<StreamingOutput>& outputs : pipeline.outputs) {
+    for (const StreamingOutput& output : outputs) {
+      add(output.port);
+      add(output.predicate);
+    }
+  }
+  for (const std::optional<StateRegister>& state : pipeline.state_registers) {
+    if (!state.has_value()) {
+      continue;
+    }
+    for (const StateRegister::NextValue& next_value : state->next_values) {
+      add(next_value.value);
+      add(next_value.predicate);
+    }
+  }
+  for (const std::vector<std::optional<Node*>>* signals :
+       {&pipeline.pipeline_valid, &pipeline.stage_valid,
+        &pipeline.stage_done}) {
+    for (const std::optional<Node*>& signal : *signals) {
+      add(signal);
+    }
+  }
+  return nodes;
+}
+
+// Moving `node` from stage `stage + 1` to stage `stage`.
+struct Move {
+  Node* node;
+  Stage stage;
+  // The distinct pipeline registers feeding the node.
+  std::vector<PipelineRegister> registers;
+  // The change in the number of flops.
+  int64_t flop_delta;
+};
+
+bool SameReset(const PipelineRegister& a, const PipelineRegister& b) {
+  const std::optional<xls::Reset>& x = a.reg->reset();
+  const std::optional<xls::Reset>& y = b.reg->reset();
+  if (x.has_value() != y.has_value()) {
+    return false;
+  }
+  return !x.has_value() ||
+         (x->asynchronous == y->asynchronous && x->active_low == y->active_low);
+}
+
+std::optional<Move> EvaluateMove(
+    Node* node, Stage stage, const StreamingIOPipeline& pipeline,
+    const absl::flat_hash_map<Register*, std::pair<Stage, PipelineRegister>>&
+        registers,
+    const absl::flat_hash_set<Node*>& referenced, const Timing& timing,
+    int64_t period, const DelayEstimator& delay_estimator) {
+  if (node->Is<RegisterWrite>() || node->Is<RegisterRead>() ||
+      node->Is<OutputPort>() || node->Is<InputPort>() ||
+      node->Is<InstantiationInput>() || node->Is<InstantiationOutput>() ||
+      node->Is<xls::Literal>() || OpIsSideEffecting(node->op()) ||
+      node->GetType()->GetFlatBitCount() == 0 || referenced.contains(node)) {
+    return std::nullopt;
+  }
+  auto stage_it = pipeline.node_to_stage_map.find(node);
+  if (stage_it == pipeline.node_to_stage_map.end() ||
+      stage_it->second != stage + 1) {
+    return std::nullopt;
+  }
+
+  Move move{.node = node, .stage = stage, .flop_delta = 0};
+  int64_t new_arrival = 0;
+  for (Node* operand : node->operands()) {
+    if (operand->Is<xls::Literal>()) {
+      continue;
+    }
+    if (!operand->Is<RegisterRead>()) {
+      return std::nullopt;
+    }
+    auto it = registers.find(operand->As<RegisterRead>()->GetRegister());
+    if (it == registers.end() || it->second.first != stage) {
+      return std::nullopt;
+    }
+    const PipelineRegister& reg = it->second.second;
+    if (!move.registers.empty()) {
+      const PipelineRegister& first = move.registers.front();
+      if (reg.reg_write->load_enable() != first.reg_write->load_enable() ||
+          reg.reg_write->reset() != first.reg_write->reset() ||
+          !SameReset(reg, first)) {
+        return std::nullopt;
+      }
+    }
+    if (std::any_of(
+            move.registers.begin(), move.registers.end(),
+            [&](const PipelineRegister& r) { return r.reg == reg.reg; })) {
+      continue;
+    }
+    move.registers.push_back(reg);
+    new_arrival =
+        std::max(new_arrival, timing.arrival.at(reg.reg_write->data()));
+    if (reg.reg_read->users().size() == 1) {
+      move.flop_delta -= reg.reg->type()->GetFlatBitCount();
+    }
+  }
+  if (move.registers.empty()) {
+    return std::nullopt;
+  }
+  int64_t delay = NodeDelay(node, delay_estimator);
+  new_arrival += delay;
+  if (new_arrival > period) {
+    return std::nullopt;
+  }
+  move.flop_delta += node->GetType()->GetFlatBitCount();
+  if (move.flop_delta < 0) {
+    return move;
+  }
+  // At the same flop count, only move a node off the critical path of the
+  // later stage into a stage which stays faster.
+  int64_t later_stage_delay = timing.stage_delay[stage + 1];
+  if (move.flop_delta == 0 && delay > 0 &&
+      timing.arrival.at(node) + timing.tail.at(node) == later_stage_delay &&
+      std::max(timing.stage_delay[stage], new_arrival) < later_stage_delay) {
+    return move;
+  }
+  return std::nullopt;
+}
+
+absl::Status ApplyMove(const Move& move, Block* block,
+                       StreamingIOPipeline& pipeline) {
+  Node* node = move.node;
+  const PipelineRegister& first = move.registers.front();
+  const std::optional<xls::Reset>& first_reset = first.reg->reset();
+  std::vector<Node*> new_operands;
+  std::vector<Value> reset_operands;
+  for (Node* operand : node->operands()) {
+    if (operand->Is<xls::Literal>()) {
+      new_operands.push_back(operand);
+      reset_operands.push_back(operand->As<xls::Literal>()->value());
+      continue;
+    }
+    Register* reg = operand->As<RegisterRead>()->GetRegister();
+    auto it = std::find_if(
+        move.registers.begin(), move.registers.end(),
+        [&](const PipelineRegister& r) { return r.reg == reg; });
+    new_operands.push_back(it->reg_write->data());
+    if (first_reset.has_value()) {
+      reset_operands.push_back(reg->reset()->reset_value);
+    }
+  }
+
+  std::optional<xls::Reset> reset;
+  if (first_reset.has_value()) {
+    XLS_ASSIGN_OR_RETURN(Value reset_value,
+                         InterpretNode(node, reset_operands));
+    reset = xls::Reset{.reset_value = reset_value,
+                  .asynchronous = first_reset->asynchronous,
+                  .active_low = first_reset->active_low};
+  }
+  XLS_ASSIGN_OR_RETURN(Node * retimed, node->Clone(new_operands));
+  XLS_ASSIGN_OR_RETURN(
+      Register * reg,
+      block->AddRegister(PipelineSignalName(node->GetName(), move.stage),
+                         node->GetType(), reset));
+  XLS_ASSIGN_OR_RETURN(
+      RegisterWrite * reg_write,
+      block->MakeNode<RegisterWrite>(node->loc(), retimed,
+                                     first.reg_write->load_enable(),
+                                     first.reg_write->reset(), reg));
+  XLS_ASSIGN_OR_RETURN(RegisterRead * reg_read,
+                       block->MakeNodeWithName<RegisterRead>(
+                           node->loc(), reg, /*name=*/reg->name()));
+  VLOG(3) << "Retiming " << node->GetName() << " into stage " << move.stage
+          << " as " << reg->name();
+  pipeline.node_to_stage_map[retimed] = move.stage;
+  pipeline.node_to_stage_map[reg_write] = move.stage;
+  pipeline.node_to_stage_map[reg_read] = move.stage + 1;
+
+  XLS_RETURN_IF_ERROR(node->ReplaceUsesWith(reg_read));
+  pipeline.node_to_stage_map.erase(node);
+  XLS_RETURN_IF_ERROR(block->RemoveNode(node));
+
+  PipelineStageRegisters& stage_registers =
+      pipeline.pipeline_registers[move.stage];
+  for (const PipelineRegister& dead : move.registers) {
+    if (!dead.reg_read->users().empty()) {
+      continue;
+    }
+    std::erase_if(stage_registers, [&](const PipelineRegister& r) {
+      return r.reg == dead.reg;
+    });
+    pipeline.node_to_stage_map.erase(dead.reg_read);
+    pipeline.node_to_stage_map.erase(dead.reg_write);
+    XLS_RETURN_IF_ERROR(block->RemoveNode(dead.reg_read));
+    XLS_RETURN_IF_ERROR(block->RemoveNode(dead.reg_write));
+    XLS_RETURN_IF_ERROR(block->RemoveRegister(dead.reg));
+  }
+  stage_registers.push_back(PipelineRegister{reg, reg_write, reg_read});
+  return absl::OkStatus();
+}
+
+absl::StatusOr<bool> RunOnBlock(Block* block, CodegenMetadata& metadata,
+                                const DelayEstimator& delay_estimator) {
+  StreamingIOPipeline& pipeline = metadata.streaming_io_and_pipeline;
+  if (pipeline.pipeline_registers.empty()) {
+    return false;
+  }
+  // The period is fixed to the critical path of the block as scheduled, so
+  // retiming never slows the pipeline down.
+  int64_t period =
+      AnalyzeTiming(block, pipeline, delay_estimator).critical_path;
+
+  bool changed = false;
+  // Every move takes a node into an earlier stage, so this terminates; the
+  // bound only guards against surprises.
+  for (int64_t round = 0; round < block->node_count(); ++round) {
+    Timing timing = AnalyzeTiming(block, pipeline, delay_estimator);
+    absl::flat_hash_map<Register*, std::pair<Stage, PipelineRegister>>
+        registers;
+    for (Stage stage = 0; stage < pipeline.pipeline_registers.size();
+         ++stage) {
+      for (const PipelineRegister& reg : pipeline.pipeline_registers[stage]) {
+        registers[reg.reg] = {stage, reg};
+      }
+    }
+    absl::flat_hash_set<Node*> referenced = ReferencedNodes(pipeline);
+
+    // Pick the best move at each stage boundary, preferring the largest flop
+    // savings, then the largest delay moved.
+    std::vector<std::optional<Move>> best(pipeline.pipeline_registers.size());
+    for (Stage stage = 0; stage < pipeline.pipeline_registers.size();
+         ++stage) {
+      absl::flat_hash_set<Node*> visited;
+      for (const PipelineRegister& reg : pipeline.pipeline_registers[stage]) {
+        for (Node* user : reg.reg_read->users()) {
+          if (!visited.insert(user).second) {
+            continue;
+          }
+          std::optional<Move> move =
+              EvaluateMove(user, stage, pipeline, registers, referenced,
+                           timing, period, delay_estimator);
+          if (!move.has_value()) {
+            continue;
+          }
+          auto key = [&](const Move& m) {
+            return std::make_tuple(m.flop_delta,
+                                   -NodeDelay(m.node, delay_estimator),
+                                   m.node->id());
+          };
+          if (!best[stage].has_value() || key(*move) < key(*best[stage])) {
+            best[stage] = std::move(move);
+          }
+        }
+      }
+    }
+
+    // Moves touching the same stage would invalidate each other's timing, so
+    // only disjoint ones are made in the same round.
+    std::vector<bool> touched(pipeline.pipeline_registers.size() + 1, false);
+    bool moved = false;
+    for (Stage stage = 0; stage < best.size(); ++stage) {
+      if (!best[stage].has_value() || touched[stage] || touched[stage + 1]) {
+        continue;
+      }
+      XLS_RETURN_IF_ERROR(ApplyMove(*best[stage], block, pipeline));
+      touched[stage] = touched[stage + 1] = true;
+      moved = true;
+    }
+    if (!moved) {
+      break;
+    }
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace
+
+absl::StatusOr<bool> RegisterRetimingPass::RunInternal(
+    CodegenPassUnit* unit, const CodegenPassOptions& options,
+    CodegenPassResults* results) const {
+  if (!options.codegen_options.retime_registers() ||
+      options.delay_estimator == nullptr) {
+    return false;
+  }
+  bool changed = false;
+  for (auto& [block, metadata] : unit->metadata) {
+    XLS_ASSIGN_OR_RETURN(
+        bool block_changed,
+        RunOnBlock(block, metadata, *options.delay_estimator));
+    changed = changed || block_changed;
+  }
+  if (changed) {
+    unit->GcMetadata();
+  }
+  return changed;
+}
+
+}  // namespace xls::verilog
@@ -0,0 +1,51 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_REGISTER_RETIMING_PASS_H_
+#define XLS_CODEGEN_REGISTER_RETIMING_PASS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/codegen/codegen_pass.h"
+
+namespace xls::verilog {
+
+// Retimes pipeline registers forward across the combinational nodes at stage
+// boundaries. A node in stage `s + 1` whose operands are all pipeline
+// registers written in stage `s` (or literals) is instead computed in stage `s`
+// from the values written to those registers, and its result registered. The
+// registers feeding it are removed if it was their only user.
+//
+// Using the delay estimator, a move is made only if it keeps the register to
+// register delay within the critical path of the block when the pass started,
+// and either lowers the flop count or, at the same flop count, moves a node on
+// the critical path of stage `s + 1` into the faster stage `s`. The registers
+// involved must share the same load enable and reset so the new register
+// loads whenever they would; its reset value is the node evaluated on theirs.
+//
+// Does nothing unless CodegenOptions::retime_registers is set and a delay
+// estimator is given.
+class RegisterRetimingPass : public CodegenPass {
+ public:
+  RegisterRetimingPass()
+      : CodegenPass("register_retiming", "Retime pipeline registers") {}
+  ~RegisterRetimingPass() override = default;
+
+  absl::StatusOr<bool> RunInternal(CodegenPassUnit* unit,
+                                   const CodegenPassOptions& options,
+                                   CodegenPassResults* results) const override;
+};
+
+}  // namespace xls::verilog
+
+#endif  // XLS_CODEGEN_REGISTER_RETIMING_PASS_H_
@@ -0,0 +1,209 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/register_retiming_pass.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "xls/codegen/block_conversion.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/register.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/value.h"
+#include "xls/scheduling/pipeline_schedule.h"
+
+namespace m = xls::op_matchers;
+namespace xls::verilog {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+MATCHER_P(Reg, name, "") { return arg->name() == name; }
+
+class RegisterRetimingPassTest : public IrTestBase {
+ protected:
+  static CodegenOptions Options() {
+    return CodegenOptions()
+        .emit_as_pipeline(true)
+        .module_name("foobar")
+        .clock_name("clk")
+        .retime_registers(true);
+  }
+
+  absl::StatusOr<bool> Run(CodegenPassUnit& unit,
+                           const CodegenOptions& options = Options()) {
+    return RegisterRetimingPass().Run(
+        &unit,
+        CodegenPassOptions{.codegen_options = options,
+                           .delay_estimator = &delay_estimator_},
+        &results_);
+  }
+
+ private:
+  TestDelayEstimator delay_estimator_;
+  CodegenPassResults results_;
+};
+
+TEST_F(RegisterRetimingPassTest, NarrowingNodeMovesBeforeRegisters) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue eq = fb.Eq(x, y, SourceInfo(), "eq");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  PipelineSchedule schedule(f, {{x.node(), 0}, {y.node(), 0}, {eq.node(), 1}},
+                            2);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      CodegenPassUnit unit,
+      FunctionBaseToPipelinedBlock(schedule, Options(), f));
+  ASSERT_THAT(unit.top_block->GetRegisters(),
+              UnorderedElementsAre(Reg("p0_x"), Reg("p0_y")));
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(true));
+  EXPECT_THAT(unit.top_block->GetRegisters(), ElementsAre(Reg("p0_eq")));
+  EXPECT_THAT(unit.top_block->GetOutputPorts(),
+              ElementsAre(m::OutputPort(m::RegisterRead("p0_eq"))));
+  XLS_ASSERT_OK_AND_ASSIGN(RegisterWrite * write,
+                           unit.top_block->GetRegisterWrite(
+                               unit.top_block->GetRegisters().front()));
+  EXPECT_THAT(write->data(), m::Eq(m::InputPort("x"), m::InputPort("y")));
+  EXPECT_THAT(
+      unit.metadata.at(unit.top_block)
+          .streaming_io_and_pipeline.pipeline_registers,
+      ElementsAre(ElementsAre(testing::Field(&PipelineRegister::reg,
+                                             Reg("p0_eq")))));
+}
+
+TEST_F(RegisterRetimingPassTest, CriticalPathIsNotLengthened) {
+  // The earlier stage is already as slow as the later one.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue sum = fb.Add(x, y);
+  BValue eq = fb.Eq(sum, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  PipelineSchedule schedule(
+      f, {{x.node(), 0}, {y.node(), 0}, {sum.node(), 0}, {eq.node(), 1}}, 2);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      CodegenPassUnit unit,
+      FunctionBaseToPipelinedBlock(schedule, Options(), f));
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(false));
+}
+
+TEST_F(RegisterRetimingPassTest, BalancesStagesAtEqualFlopCount) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue not_x = fb.Not(x, SourceInfo(), "not_x");
+  BValue neg = fb.Negate(not_x, SourceInfo(), "neg");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  PipelineSchedule schedule(
+      f, {{x.node(), 0}, {not_x.node(), 1}, {neg.node(), 1}}, 2);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      CodegenPassUnit unit,
+      FunctionBaseToPipelinedBlock(schedule, Options(), f));
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(true));
+  // Moving `neg` as well would make the first stage the slower one.
+  EXPECT_THAT(unit.top_block->GetRegisters(), ElementsAre(Reg("p0_not_x")));
+  EXPECT_THAT(unit.top_block->GetOutputPorts(),
+              ElementsAre(m::OutputPort(m::Neg(m::RegisterRead("p0_not_x")))));
+}
+
+TEST_F(RegisterRetimingPassTest, DisabledByDefault) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue eq = fb.Eq(x, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  PipelineSchedule schedule(f, {{x.node(), 0}, {y.node(), 0}, {eq.node(), 1}},
+                            2);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      CodegenPassUnit unit,
+      FunctionBaseToPipelinedBlock(schedule, Options(), f));
+
+  EXPECT_THAT(Run(unit, Options().retime_registers(false)),
+              IsOkAndHolds(false));
+}
+
+TEST_F(RegisterRetimingPassTest, ResetValueIsEvaluated) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in, p->CreateStreamingChannel("in", ChannelOps::kReceiveOnly,
+                                              p->GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(1)));
+  TokenlessProcBuilder pb(TestName(), "tok", p.get());
+  BValue x = pb.Receive(in);
+  BValue ne = pb.Ne(x, pb.Literal(UBits(5, 32)), SourceInfo(), "ne");
+  pb.Send(out, ne);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build());
+
+  // Everything but the receive happens in the second stage.
+  absl::flat_hash_map<Node*, int64_t> cycles;
+  for (Node* node : proc->nodes()) {
+    bool first_stage =
+        node->Is<Receive>() || node->Is<StateRead>() ||
+        (node->Is<TupleIndex>() && node->operand(0)->Is<Receive>());
+    cycles[node] = first_stage ? 0 : 1;
+  }
+  PipelineSchedule schedule(proc, cycles, 2);
+  CodegenOptions options = Options();
+  options.reset("rst", /*asynchronous=*/false, /*active_low=*/false,
+                /*reset_data_path=*/true);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      CodegenPassUnit unit,
+      FunctionBaseToPipelinedBlock(schedule, options, proc));
+
+  EXPECT_THAT(Run(unit, options), IsOkAndHolds(true));
+  std::optional<PipelineRegister> retimed;
+  for (const PipelineRegister& reg :
+       unit.metadata.at(unit.top_block)
+           .streaming_io_and_pipeline.pipeline_registers.at(0)) {
+    EXPECT_NE(reg.reg->type(), p->GetBitsType(32)) << reg.reg->name();
+    if (reg.reg->name() == "p0_ne") {
+      retimed = reg;
+    }
+  }
+  ASSERT_TRUE(retimed.has_value());
+  ASSERT_TRUE(retimed->reg->reset().has_value());
+  // The received value resets to zero, which is not 5.
+  EXPECT_EQ(retimed->reg->reset()->reset_value, Value(UBits(1, 1)));
+  EXPECT_EQ(retimed->reg_write->reset(),
+            std::optional<Node*>(*unit.top_block->GetResetPort()));
+}
+
+}  // namespace
+}  // namespace xls::verilog
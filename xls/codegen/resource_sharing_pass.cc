@@ -0,0 +1,445 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/resource_sharing_pass.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/estimators/delay_model/delay_estimator.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/block.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/ir/value.h"
+#include "xls/passes/bdd_function.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/predicate_dominator_analysis.h"
+#include "xls/passes/predicate_state.h"
+#include "xls/passes/query_engine.h"
+
+namespace xls::verilog {
+namespace {
+
+bool IsShareable(Node* node) {
+  switch (node->op()) {
+    case Op::kUMul:
+    case Op::kSMul:
+    case Op::kUDiv:
+    case Op::kSDiv:
+    case Op::kUMod:
+    case Op::kSMod:
+      return node->GetType()->IsBits();
+    default:
+      return false;
+  }
+}
+
+// Operations can only be shared by nodes with the same op and widths.
+using Signature = std::tuple<Op, int64_t, std::vector<int64_t>>;
+
+Signature GetSignature(Node* node) {
+  std::vector<int64_t> operand_widths;
+  operand_widths.reserve(node->operand_count());
+  for (Node* operand : node->operands()) {
+    operand_widths.push_back(operand->BitCountOrDie());
+  }
+  return {node->op(), node->BitCountOrDie(), std::move(operand_widths)};
+}
+
+int64_t NodeDelay(Node* node, const DelayEstimator& delay_estimator) {
+  absl::StatusOr<int64_t> delay = delay_estimator.GetOperationDelayInPs(node);
+  return delay.ok() ? *delay : 0;
+}
+
+// Delays through the combinational logic of a block. Paths start at input
+// ports and register reads and end at output ports and register writes.
+struct Timing {
+  // Largest delay from the start of a path to the output of each node.
+  absl::flat_hash_map<Node*, int64_t> arrival;
+  // Largest delay from the output of each node to the end of a path.
+  absl::flat_hash_map<Node*, int64_t> tail;
+  // Largest delay of any path in the block.
+  int64_t critical_path = 0;
+};
+
+bool EndsPath(Node* node) {
+  return node->Is<RegisterWrite>() || node->Is<OutputPort>();
+}
+
+Timing AnalyzeTiming(Block* block, const DelayEstimator& delay_estimator) {
+  Timing timing;
+  std::vector<Node*> topo_order = TopoSort(block);
+  for (Node* node : topo_order) {
+    int64_t arrival = 0;
+    for (Node* operand : node->operands()) {
+      arrival = std::max(arrival, timing.arrival.at(operand));
+    }
+    if (!EndsPath(node)) {
+      arrival += NodeDelay(node, delay_estimator);
+    }
+    timing.arrival[node] = arrival;
+    timing.critical_path = std::max(timing.critical_path, arrival);
+  }
+  for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+    int64_t tail = 0;
+    for (Node* user : (*it)->users()) {
+      if (!EndsPath(user)) {
+        tail = std::max(tail,
+                        NodeDelay(user, delay_estimator) + timing.tail[user]);
+      }
+    }
+    timing.tail[*it] = tail;
+  }
+  return timing;
+}
+
+// The arm of a select which must be chosen for a node to be used.
+struct Guard {
+  Select* select;
+  PredicateState::ArmT arm;
+
+  bool IsDefaultArm() const { return arm == PredicateState::kDefaultArm; }
+
+  // The value of the selector which chooses the arm; the default arm is chosen
+  // by this value and all larger ones.
+  int64_t SelectorValue() const {
+    return IsDefaultArm() ? select->cases().size() : std::get<int64_t>(arm);
+  }
+};
+
+bool MutuallyExclusive(const Guard& a, const Guard& b,
+                       const QueryEngine& query_engine) {
+  if (a.select == b.select) {
+    return a.arm != b.arm;
+  }
+  Node* x = a.select->selector();
+  Node* y = b.select->selector();
+  if (x->BitCountOrDie() != 1 || y->BitCountOrDie() != 1) {
+    return false;
+  }
+  TreeBitLocation x_bit(x, 0);
+  TreeBitLocation y_bit(y, 0);
+  bool x_set = a.SelectorValue() == 1;
+  bool y_set = b.SelectorValue() == 1;
+  if (x_set && y_set) {
+    return query_engine.AtMostOneTrue({x_bit, y_bit});
+  }
+  if (!x_set && !y_set) {
+    return query_engine.AtLeastOneTrue({x_bit, y_bit});
+  }
+  return x_set ? query_engine.Implies(x_bit, y_bit)
+               : query_engine.Implies(y_bit, x_bit);
+}
+
+// Adds the transitive fanin of `node`, including itself, to `fanin`.
+void AddFanin(Node* node, absl::flat_hash_set<Node*>& fanin) {
+  std::vector<Node*> worklist = {node};
+  while (!worklist.empty()) {
+    Node* n = worklist.back();
+    worklist.pop_back();
+    if (!fanin.insert(n).second) {
+      continue;
+    }
+    for (Node* operand : n->operands()) {
+      worklist.push_back(operand);
+    }
+  }
+}
+
+struct Candidate {
+  Node* node;
+  Guard guard;
+};
+
+// Mutually exclusive candidates which can share one operation.
+struct Group {
+  std::vector<Candidate> members;
+  // The transitive fanin of the operands and guard selectors of the members.
+  // No member may be in it, otherwise sharing would create a cycle.
+  absl::flat_hash_set<Node*> fanin;
+};
+
+bool TryAddToGroup(const Candidate& candidate,
+                   const absl::flat_hash_set<Node*>& candidate_fanin,
+                   const QueryEngine& query_engine, Group& group) {
+  if (group.fanin.contains(candidate.node)) {
+    return false;
+  }
+  for (const Candidate& member : group.members) {
+    if (candidate_fanin.contains(member.node) ||
+        !MutuallyExclusive(member.guard, candidate.guard, query_engine)) {
+      return false;
+    }
+  }
+  group.members.push_back(candidate);
+  group.fanin.insert(candidate_fanin.begin(), candidate_fanin.end());
+  return true;
+}
+
+// Returns a one-bit node which is true when the guarded arm is chosen.
+absl::StatusOr<Node*> MakeCondition(const Guard& guard, Block* block,
+                                    std::vector<Node*>& created) {
+  Node* selector = guard.select->selector();
+  int64_t width = selector->BitCountOrDie();
+  int64_t value = guard.SelectorValue();
+  if (width == 1 && value == 1) {
+    return selector;
+  }
+  if (width == 1 && !guard.IsDefaultArm()) {
+    XLS_ASSIGN_OR_RETURN(Node * inverted, block->MakeNode<UnOp>(
+                                              selector->loc(), selector,
+                                              Op::kNot));
+    created.push_back(inverted);
+    return inverted;
+  }
+  XLS_ASSIGN_OR_RETURN(Node * literal,
+                       block->MakeNode<xls::Literal>(
+                           selector->loc(), Value(UBits(value, width))));
+  created.push_back(literal);
+  XLS_ASSIGN_OR_RETURN(
+      Node * condition,
+      block->MakeNode<CompareOp>(selector->loc(), selector, literal,
+                                 guard.IsDefaultArm() ? Op::kUGe : Op::kEq));
+  created.push_back(condition);
+  return condition;
+}
+
+// Replaces the members of the group with a single operation whose operands are
+// muxed between theirs. The first member's operands are the fallback when no
+// other member is chosen. Returns false, leaving the block unchanged, if the
+// muxes would lengthen the critical path past `period`.
+absl::StatusOr<bool> ShareGroup(const std::vector<Candidate>& members,
+                                Block* block, StreamingIOPipeline& pipeline,
+                                std::optional<Stage> stage,
+                                const Timing& timing, int64_t period,
+                                const DelayEstimator& delay_estimator) {
+  std::vector<Node*> created;
+  std::vector<Node*> conditions;
+  for (int64_t i = 1; i < members.size(); ++i) {
+    XLS_ASSIGN_OR_RETURN(Node * condition,
+                         MakeCondition(members[i].guard, block, created));
+    conditions.push_back(condition);
+  }
+  Node* first = members.front().node;
+  Node* selector = conditions.front();
+  if (conditions.size() > 1) {
+    // Bit `i` of the selector chooses member `i + 1`.
+    std::vector<Node*> bits(conditions.rbegin(), conditions.rend());
+    XLS_ASSIGN_OR_RETURN(selector, block->MakeNode<Concat>(first->loc(), bits));
+    created.push_back(selector);
+  }
+  std::vector<Node*> operands;
+  for (int64_t operand_no = 0; operand_no < first->operand_count();
+       ++operand_no) {
+    std::vector<Node*> cases;
+    for (const Candidate& member : members) {
+      cases.push_back(member.node->operand(operand_no));
+    }
+    if (std::all_of(cases.begin(), cases.end(),
+                    [&](Node* n) { return n == cases.front(); })) {
+      operands.push_back(cases.front());
+      continue;
+    }
+    Node* mux;
+    if (members.size() == 2) {
+      XLS_ASSIGN_OR_RETURN(mux, block->MakeNode<Select>(
+                                    first->loc(), selector, cases,
+                                    /*default_value=*/std::nullopt));
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          mux, block->MakeNode<PrioritySelect>(
+                   first->loc(), selector,
+                   absl::MakeConstSpan(cases).subspan(1),
+                   /*default_value=*/cases.front()));
+    }
+    created.push_back(mux);
+    operands.push_back(mux);
+  }
+  XLS_ASSIGN_OR_RETURN(Node * shared, first->Clone(operands));
+  created.push_back(shared);
+
+  absl::flat_hash_map<Node*, int64_t> arrival;
+  auto arrival_of = [&](Node* node) {
+    auto it = arrival.find(node);
+    return it == arrival.end() ? timing.arrival.at(node) : it->second;
+  };
+  for (Node* node : created) {
+    int64_t node_arrival = 0;
+    for (Node* operand : node->operands()) {
+      node_arrival = std::max(node_arrival, arrival_of(operand));
+    }
+    arrival[node] = node_arrival + NodeDelay(node, delay_estimator);
+  }
+  bool fits = std::all_of(
+      members.begin(), members.end(), [&](const Candidate& member) {
+        return arrival.at(shared) + timing.tail.at(member.node) <= period;
+      });
+  if (!fits) {
+    for (auto it = created.rbegin(); it != created.rend(); ++it) {
+      XLS_RETURN_IF_ERROR(block->RemoveNode(*it));
+    }
+    return false;
+  }
+
+  VLOG(3) << "Sharing " << first->GetName() << " between " << members.size()
+          << " mutually exclusive uses as " << shared->GetName();
+  for (const Candidate& member : members) {
+    XLS_RETURN_IF_ERROR(member.node->ReplaceUsesWith(shared));
+    pipeline.node_to_stage_map.erase(member.node);
+    XLS_RETURN_IF_ERROR(block->RemoveNode(member.node));
+  }
+  if (stage.has_value()) {
+    for (Node* node : created) {
+      pipeline.node_to_stage_map[node] = *stage;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<bool> RunOnBlock(Block* block, CodegenMetadata& metadata,
+                                const DelayEstimator& delay_estimator) {
+  StreamingIOPipeline& pipeline = metadata.streaming_io_and_pipeline;
+  // Without pipeline registers every node is in the same stage.
+  bool staged = !pipeline.pipeline_registers.empty();
+  // The period is fixed to the critical path of the block as scheduled, so
+  // sharing never slows the pipeline down.
+  int64_t period = AnalyzeTiming(block, delay_estimator).critical_path;
+
+  bool changed = false;
+  // Every round removes nodes, so this terminates; the bound only guards
+  // against surprises.
+  for (int64_t round = 0; round < block->node_count(); ++round) {
+    PredicateDominatorAnalysis predicates =
+        PredicateDominatorAnalysis::Run(block);
+    BddQueryEngine query_engine(BddFunction::kDefaultPathLimit);
+    XLS_RETURN_IF_ERROR(query_engine.Populate(block).status());
+
+    // Group the candidates by stage and signature, in topological order so
+    // that the result is deterministic.
+    absl::btree_map<std::pair<Stage, Signature>, std::vector<Group>> groups;
+    for (Node* node : TopoSort(block)) {
+      if (!IsShareable(node)) {
+        continue;
+      }
+      PredicateState predicate = predicates.GetSingleNearestPredicate(node);
+      if (!predicate.IsSelectPredicate()) {
+        continue;
+      }
+      Stage stage = 0;
+      if (staged) {
+        auto it = pipeline.node_to_stage_map.find(node);
+        if (it == pipeline.node_to_stage_map.end()) {
+          continue;
+        }
+        stage = it->second;
+      }
+      Candidate candidate{
+          .node = node,
+          .guard = Guard{.select = predicate.node()->As<Select>(),
+                         .arm = predicate.arm()}};
+      absl::flat_hash_set<Node*> candidate_fanin;
+      for (Node* operand : node->operands()) {
+        AddFanin(operand, candidate_fanin);
+      }
+      AddFanin(candidate.guard.select->selector(), candidate_fanin);
+
+      std::vector<Group>& bucket = groups[{stage, GetSignature(node)}];
+      bool added = std::any_of(bucket.begin(), bucket.end(), [&](Group& g) {
+        return TryAddToGroup(candidate, candidate_fanin, query_engine, g);
+      });
+      if (!added) {
+        bucket.push_back(Group{.members = {candidate},
+                               .fanin = std::move(candidate_fanin)});
+      }
+    }
+
+    // Sharing a group changes which predicates guard the nodes in its fanin,
+    // so candidates there wait for the next round.
+    absl::flat_hash_set<Node*> stale;
+    bool shared_any = false;
+    for (auto& [key, bucket] : groups) {
+      for (Group& group : bucket) {
+        std::vector<Candidate> members;
+        for (const Candidate& member : group.members) {
+          if (!stale.contains(member.node)) {
+            members.push_back(member);
+          }
+        }
+        // Fewer members only relax the constraints the group was built with.
+        while (members.size() >= 2) {
+          Timing timing = AnalyzeTiming(block, delay_estimator);
+          XLS_ASSIGN_OR_RETURN(
+              bool shared,
+              ShareGroup(members, block, pipeline,
+                         staged ? std::make_optional(key.first) : std::nullopt,
+                         timing, period, delay_estimator));
+          if (shared) {
+            for (Node* node : group.fanin) {
+              stale.insert(node);
+            }
+            shared_any = true;
+            break;
+          }
+          members.pop_back();
+        }
+      }
+    }
+    if (!shared_any) {
+      break;
+    }
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace
+
+absl::StatusOr<bool> ResourceSharingPass::RunInternal(
+    CodegenPassUnit* unit, const CodegenPassOptions& options,
+    CodegenPassResults* results) const {
+  if (!options.codegen_options.share_resources() ||
+      options.delay_estimator == nullptr) {
+    return false;
+  }
+  bool changed = false;
+  for (auto& [block, metadata] : unit->metadata) {
+    XLS_ASSIGN_OR_RETURN(
+        bool block_changed,
+        RunOnBlock(block, metadata, *options.delay_estimator));
+    changed = changed || block_changed;
+  }
+  if (changed) {
+    unit->GcMetadata();
+  }
+  return changed;
+}
+
+}  // namespace xls::verilog
@@ -0,0 +1,51 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_RESOURCE_SHARING_PASS_H_
+#define XLS_CODEGEN_RESOURCE_SHARING_PASS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/codegen/codegen_pass.h"
+
+namespace xls::verilog {
+
+// Shares a single instance of an expensive operation (multiplies, divides and
+// modulos) between mutually exclusive uses in the same pipeline stage.
+//
+// An operation is only used when the nearest select guarding it (see
+// PredicateDominatorAnalysis) chooses its arm. Operations of the same kind and
+// width guarded by different arms of the same select, or by selects with
+// single-bit selectors which the BDD proves are never both taken, are replaced
+// by one operation whose operands are muxed between theirs.
+//
+// Using the delay estimator, a group is only shared if the added operand muxes
+// keep every path within the critical path of the block as scheduled.
+//
+// Does nothing unless CodegenOptions::share_resources is set and a delay
+// estimator is given.
+class ResourceSharingPass : public CodegenPass {
+ public:
+  ResourceSharingPass()
+      : CodegenPass("resource_sharing",
+                    "Share mutually exclusive expensive operations") {}
+  ~ResourceSharingPass() override = default;
+
+  absl::StatusOr<bool> RunInternal(CodegenPassUnit* unit,
+                                   const CodegenPassOptions& options,
+                                   CodegenPassResults* results) const override;
+};
+
+}  // namespace xls::verilog
+
+#endif  // XLS_CODEGEN_RESOURCE_SHARING_PASS_H_
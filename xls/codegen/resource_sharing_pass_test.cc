@@ -0,0 +1,213 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/resource_sharing_pass.h"
+
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "xls/codegen/block_conversion.h"
+#include "xls/codegen/codegen_options.h"
+#include "xls/codegen/codegen_pass.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/block_interpreter.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+
+namespace m = xls::op_matchers;
+namespace xls::verilog {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+class ResourceSharingPassTest : public IrTestBase {
+ protected:
+  static CodegenOptions Options() {
+    return CodegenOptions().module_name("foobar").share_resources(true);
+  }
+
+  absl::StatusOr<bool> Run(CodegenPassUnit& unit,
+                           const CodegenOptions& options = Options()) {
+    return ResourceSharingPass().Run(
+        &unit,
+        CodegenPassOptions{.codegen_options = options,
+                           .delay_estimator = &delay_estimator_},
+        &results_);
+  }
+
+  static int64_t CountOps(Block* block, Op op) {
+    int64_t count = 0;
+    for (Node* node : block->nodes()) {
+      if (node->op() == op) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  // Adds a path of `depth` nodes from `x` so the critical path of the block
+  // leaves room for operand muxes.
+  static BValue SlowPath(FunctionBuilder& fb, BValue x, int64_t depth) {
+    for (int64_t i = 0; i < depth; ++i) {
+      x = fb.Negate(x);
+    }
+    return x;
+  }
+
+ private:
+  TestDelayEstimator delay_estimator_;
+  CodegenPassResults results_;
+};
+
+TEST_F(ResourceSharingPassTest, ArmsOfTheSameSelectShareAMultiplier) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue s = fb.Param("s", p->GetBitsType(1));
+  BValue a = fb.Param("a", p->GetBitsType(16));
+  BValue b = fb.Param("b", p->GetBitsType(16));
+  BValue c = fb.Param("c", p->GetBitsType(16));
+  BValue d = fb.Param("d", p->GetBitsType(16));
+  BValue sel = fb.Select(s, {fb.UMul(a, b), fb.UMul(c, d)});
+  fb.Add(sel, SlowPath(fb, a, 4));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenPassUnit unit,
+                           FunctionToCombinationalBlock(f, Options()));
+  Block* block = unit.top_block;
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(true));
+  EXPECT_EQ(CountOps(block, Op::kUMul), 1);
+  EXPECT_THAT(block->GetOutputPorts().front()->operand(0),
+              m::Add(m::Select(m::InputPort("s"),
+                               {m::UMul(m::Select(m::InputPort("s"),
+                                                  {m::InputPort("a"),
+                                                   m::InputPort("c")}),
+                                        m::Select(m::InputPort("s"),
+                                                  {m::InputPort("b"),
+                                                   m::InputPort("d")})),
+                                m::UMul()}),
+                     m::Neg()));
+  for (uint64_t s_value : {0, 1}) {
+    EXPECT_THAT(
+        InterpretCombinationalBlock(
+            block, {{"s", s_value}, {"a", 3}, {"b", 5}, {"c", 7}, {"d", 11}}),
+        IsOkAndHolds(ElementsAre(
+            Pair("out", ((s_value == 0 ? 15 : 77) + 3) & 0xffff))));
+  }
+}
+
+TEST_F(ResourceSharingPassTest, ComplementarySelectsShareADivider) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue s = fb.Param("s", p->GetBitsType(1));
+  BValue a = fb.Param("a", p->GetBitsType(16));
+  BValue b = fb.Param("b", p->GetBitsType(16));
+  BValue c = fb.Param("c", p->GetBitsType(16));
+  // The first quotient is only used when `s` is set, the second only when it
+  // is not.
+  BValue x = fb.Select(s, {a, fb.UDiv(a, b)});
+  BValue y = fb.Select(s, {fb.UDiv(c, b), c});
+  fb.Add(fb.Add(x, y), SlowPath(fb, a, 4));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenPassUnit unit,
+                           FunctionToCombinationalBlock(f, Options()));
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(true));
+  EXPECT_EQ(CountOps(unit.top_block, Op::kUDiv), 1);
+}
+
+TEST_F(ResourceSharingPassTest, IndependentSelectsAreNotShared) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue s = fb.Param("s", p->GetBitsType(1));
+  BValue t = fb.Param("t", p->GetBitsType(1));
+  BValue a = fb.Param("a", p->GetBitsType(16));
+  BValue b = fb.Param("b", p->GetBitsType(16));
+  BValue x = fb.Select(s, {a, fb.UMul(a, b)});
+  BValue y = fb.Select(t, {b, fb.UMul(b, b)});
+  fb.Add(fb.Add(x, y), SlowPath(fb, a, 4));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenPassUnit unit,
+                           FunctionToCombinationalBlock(f, Options()));
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(false));
+  EXPECT_EQ(CountOps(unit.top_block, Op::kUMul), 2);
+}
+
+TEST_F(ResourceSharingPassTest, ManyArmsShareOneMultiplier) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue s = fb.Param("s", p->GetBitsType(2));
+  BValue a = fb.Param("a", p->GetBitsType(8));
+  BValue b = fb.Param("b", p->GetBitsType(8));
+  BValue sel = fb.Select(
+      s, {fb.UMul(a, b), fb.UMul(a, a), fb.UMul(b, b), fb.UMul(b, a)});
+  fb.Add(sel, SlowPath(fb, a, 6));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenPassUnit unit,
+                           FunctionToCombinationalBlock(f, Options()));
+  Block* block = unit.top_block;
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(true));
+  EXPECT_EQ(CountOps(block, Op::kUMul), 1);
+  for (uint64_t s_value = 0; s_value < 4; ++s_value) {
+    uint64_t products[] = {3 * 5, 3 * 3, 5 * 5, 5 * 3};
+    EXPECT_THAT(InterpretCombinationalBlock(
+                    block, {{"s", s_value}, {"a", 3}, {"b", 5}}),
+                IsOkAndHolds(ElementsAre(
+                    Pair("out", (products[s_value] + 3) & 0xff))));
+  }
+}
+
+TEST_F(ResourceSharingPassTest, CriticalPathIsNotLengthened) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue s = fb.Param("s", p->GetBitsType(1));
+  BValue a = fb.Param("a", p->GetBitsType(16));
+  BValue b = fb.Param("b", p->GetBitsType(16));
+  fb.Select(s, {fb.UMul(a, b), fb.UMul(b, b)});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenPassUnit unit,
+                           FunctionToCombinationalBlock(f, Options()));
+
+  EXPECT_THAT(Run(unit), IsOkAndHolds(false));
+  EXPECT_EQ(CountOps(unit.top_block, Op::kUMul), 2);
+}
+
+TEST_F(ResourceSharingPassTest, DisabledByDefault) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue s = fb.Param("s", p->GetBitsType(1));
+  BValue a = fb.Param("a", p->GetBitsType(16));
+  BValue b = fb.Param("b", p->GetBitsType(16));
+  BValue sel = fb.Select(s, {fb.UMul(a, b), fb.UMul(b, b)});
+  fb.Add(sel, SlowPath(fb, a, 4));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenPassUnit unit,
+                           FunctionToCombinationalBlock(f, Options()));
+
+  EXPECT_THAT(Run(unit, Options().share_resources(false)),
+              IsOkAndHolds(false));
+}
+
+}  // namespace
+}  // namespace xls::verilog
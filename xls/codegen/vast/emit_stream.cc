@@ -0,0 +1,119 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/vast/emit_stream.h"
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/error_code_to_status.h"
+
+namespace xls {
+namespace verilog {
+namespace {
+
+absl::Status ErrNoToStatusWithFilename(int errno_value,
+                                       const std::filesystem::path& path) {
+  xabsl::StatusBuilder builder = ErrnoToStatus(errno_value);
+  builder << path.string();
+  return std::move(builder);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<FileEmitSink>> FileEmitSink::Create(
+    const std::filesystem::path& path) {
+  // Use POSIX C APIs instead of C++ iostreams to avoid exceptions.
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0664);
+  if (fd == -1) {
+    return ErrNoToStatusWithFilename(errno, path);
+  }
+  return absl::WrapUnique(new FileEmitSink(path, fd));
+}
+
+FileEmitSink::~FileEmitSink() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+void FileEmitSink::Write(std::string_view text) {
+  if (buffer_.size() + text.size() > kBufferSize) {
+    Flush();
+  }
+  buffer_.append(text);
+}
+
+void FileEmitSink::Flush() {
+  std::string_view pending = buffer_;
+  while (status_.ok() && !pending.empty()) {
+    ssize_t n = write(fd_, pending.data(), pending.size());
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EINTR) {
+        continue;
+      }
+      status_ = ErrNoToStatusWithFilename(errno, path_);
+      break;
+    }
+    pending.remove_prefix(n);
+  }
+  buffer_.clear();
+}
+
+absl::Status FileEmitSink::Close() {
+  if (fd_ == -1) {
+    return status_;
+  }
+  Flush();
+  if (close(fd_) != 0 && status_.ok()) {
+    status_ = ErrNoToStatusWithFilename(errno, path_);
+  }
+  fd_ = -1;
+  return status_;
+}
+
+void EmitStream::Write(std::string_view text) {
+  while (!text.empty()) {
+    size_t newline = text.find('\n');
+    std::string_view line = text.substr(0, newline);
+    if (!line.empty()) {
+      if (at_line_start_ && indent_ > 0) {
+        sink_->Write(std::string(indent_, ' '));
+      }
+      sink_->Write(line);
+      at_line_start_ = false;
+    }
+    if (newline == std::string_view::npos) {
+      return;
+    }
+    sink_->Write("\n");
+    at_line_start_ = true;
+    text.remove_prefix(newline + 1);
+  }
+}
+
+}  // namespace verilog
+}  // namespace xls
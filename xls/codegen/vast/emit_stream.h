@@ -0,0 +1,115 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_CODEGEN_VAST_EMIT_STREAM_H_
+#define XLS_CODEGEN_VAST_EMIT_STREAM_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+
+namespace xls {
+namespace verilog {
+
+// Destination of emitted Verilog text.
+class EmitSink {
+ public:
+  virtual ~EmitSink() = default;
+
+  virtual void Write(std::string_view text) = 0;
+};
+
+// Appends the emitted text to a string.
+class StringEmitSink final : public EmitSink {
+ public:
+  explicit StringEmitSink(std::string* out) : out_(out) {}
+
+  void Write(std::string_view text) final { out_->append(text); }
+
+ private:
+  std::string* out_;
+};
+
+// Appends the emitted text to a cord.
+class CordEmitSink final : public EmitSink {
+ public:
+  explicit CordEmitSink(absl::Cord* out) : out_(out) {}
+
+  void Write(std::string_view text) final { out_->Append(text); }
+
+ private:
+  absl::Cord* out_;
+};
+
+// Writes the emitted text to a file through a fixed-size buffer. Errors are
+// sticky and reported by Close, which must be called before destruction for
+// the file to be complete.
+class FileEmitSink final : public EmitSink {
+ public:
+  // Creates (or truncates) the file at `path`.
+  static absl::StatusOr<std::unique_ptr<FileEmitSink>> Create(
+      const std::filesystem::path& path);
+
+  ~FileEmitSink() final;
+
+  void Write(std::string_view text) final;
+
+  // Flushes the buffer and closes the file.
+  absl::Status Close();
+
+ private:
+  static constexpr int64_t kBufferSize = 1 << 20;
+
+  FileEmitSink(const std::filesystem::path& path, int fd)
+      : path_(path), fd_(fd) {
+    buffer_.reserve(kBufferSize);
+  }
+
+  void Flush();
+
+  std::filesystem::path path_;
+  int fd_;
+  std::string buffer_;
+  absl::Status status_;
+};
+
+// Writes text into a sink, indenting each line by the current indentation
+// level. As with xls::Indent, empty lines are not indented so no trailing white
+// space is produced.
+class EmitStream {
+ public:
+  explicit EmitStream(EmitSink* sink) : sink_(sink) {}
+
+  void Write(std::string_view text);
+
+  // Increases/decreases the indentation of the lines started after the call.
+  void Indent(int64_t spaces = 2) { indent_ += spaces; }
+  void Dedent(int64_t spaces = 2) { indent_ -= spaces; }
+
+ private:
+  EmitSink* sink_;
+  int64_t indent_ = 0;
+  bool at_line_start_ = true;
+};
+
+}  // namespace verilog
+}  // namespace xls
+
+#endif  // XLS_CODEGEN_VAST_EMIT_STREAM_H_
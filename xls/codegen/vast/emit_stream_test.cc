@@ -0,0 +1,79 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/codegen/vast/emit_stream.h"
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/indent.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace verilog {
+namespace {
+
+TEST(EmitStreamTest, IndentationMatchesIndent) {
+  const std::string kText = "a\n\nb {\n  c\n}\n";
+  std::string text;
+  StringEmitSink sink(&text);
+  EmitStream stream(&sink);
+  stream.Write("begin\n");
+  stream.Indent();
+  // Lines may be written in pieces.
+  stream.Write(kText.substr(0, 4));
+  stream.Write(kText.substr(4));
+  stream.Dedent();
+  stream.Write("end");
+  EXPECT_EQ(text, absl::StrCat("begin\n", Indent(kText), "end"));
+}
+
+TEST(EmitStreamTest, CordSink) {
+  absl::Cord text;
+  CordEmitSink sink(&text);
+  EmitStream stream(&sink);
+  stream.Indent(4);
+  stream.Write("x\ny");
+  EXPECT_EQ(std::string(text), "    x\n    y");
+}
+
+TEST(EmitStreamTest, FileSink) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path path = temp_dir.path() / "out.v";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FileEmitSink> sink,
+                           FileEmitSink::Create(path));
+  // Write more than the size of the buffer.
+  std::string expected;
+  {
+    EmitStream stream(sink.get());
+    for (int64_t i = 0; i < 100000; ++i) {
+      std::string line = absl::StrCat("assign x", i, " = y", i, ";\n");
+      stream.Write(line);
+      absl::StrAppend(&expected, line);
+    }
+  }
+  XLS_ASSERT_OK(sink->Close());
+  EXPECT_EQ(GetFileContents(path).value(), expected);
+}
+
+}  // namespace
+}  // namespace verilog
+}  // namespace xls
@@ -15,7 +15,9 @@
 #include "xls/codegen/vast/vast.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -35,6 +37,7 @@
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "xls/codegen/module_signature.pb.h"
+#include "xls/codegen/vast/emit_stream.h"
 #include "xls/common/indent.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/visitor.h"
@@ -48,6 +51,16 @@ namespace verilog {
 
 namespace {
 
+// Returns the text which `node` writes with EmitTo.
+template <typename T>
+std::string EmitToString(const T& node, LineInfo* line_info) {
+  std::string text;
+  StringEmitSink sink(&text);
+  EmitStream out(&sink);
+  node.EmitTo(&out, line_info);
+  return text;
+}
+
 int64_t NumberOfNewlines(std::string_view string) {
   int64_t number_of_newlines = 0;
   for (char c : string) {
@@ -430,17 +443,43 @@ UnpackedArrayType* VerilogFile::UnpackedArrayType(
   return Make<verilog::UnpackedArrayType>(loc, element_type, dims);
 }
 
+VastNodeArena::~VastNodeArena() {
+  for (auto it = nodes_.rbegin(); it != nodes_.rend(); ++it) {
+    (*it)->~VastNode();
+  }
+}
+
+void* VastNodeArena::Allocate(size_t size, size_t alignment) {
+  size_t padding = -reinterpret_cast<uintptr_t>(next_) & (alignment - 1);
+  if (padding + size > remaining_) {
+    if (size > kBlockSize / 4) {
+      // Give large nodes a block of their own rather than wasting the rest of
+      // the current block.
+      blocks_.push_back(std::unique_ptr<std::byte[]>(new std::byte[size]));
+      return blocks_.back().get();
+    }
+    blocks_.push_back(
+        std::unique_ptr<std::byte[]>(new std::byte[kBlockSize]));
+    next_ = blocks_.back().get();
+    remaining_ = kBlockSize;
+    padding = 0;
+  }
+  void* ptr = next_ + padding;
+  next_ += padding + size;
+  remaining_ -= padding + size;
+  return ptr;
+}
+
 std::string VerilogFile::Emit(LineInfo* line_info) const {
-  auto file_member_str = [=](const FileMember& member) -> std::string {
-    return absl::visit([=](auto* m) { return m->Emit(line_info); }, member);
-  };
+  return EmitToString(*this, line_info);
+}
 
-  std::string out;
+void VerilogFile::EmitTo(EmitStream* out, LineInfo* line_info) const {
   for (const FileMember& member : members_) {
-    absl::StrAppend(&out, file_member_str(member), "\n");
+    absl::visit([&](auto* m) { m->EmitTo(out, line_info); }, member);
+    out->Write("\n");
     LineInfoIncrease(line_info, 1);
   }
-  return out;
 }
 
 LocalParamItemRef* LocalParam::AddItem(std::string_view name, Expression* value,
@@ -956,57 +995,57 @@ IntegerDef::IntegerDef(std::string_view name, DataType* data_type,
                        const SourceInfo& loc)
     : Def(name, DataKind::kInteger, data_type, init, file, loc) {}
 
-namespace {
-
-// "Match" statement for emitting a ModuleMember.
-std::string EmitModuleMember(LineInfo* line_info, const ModuleMember& member) {
-  return absl::visit([=](auto* d) { return d->Emit(line_info); }, member);
-}
-
-// Visitor for emitting a VerilogPackageMember.
-std::string EmitVerilogPackageMember(LineInfo* line_info,
-                                     const VerilogPackageMember& member) {
-  return absl::visit([=](auto* d) { return d->Emit(line_info); }, member);
+std::string ModuleSection::Emit(LineInfo* line_info) const {
+  return EmitToString(*this, line_info);
 }
 
-}  // namespace
-
-std::string ModuleSection::Emit(LineInfo* line_info) const {
+void ModuleSection::EmitTo(EmitStream* out, LineInfo* line_info) const {
   LineInfoStart(line_info, this);
-  std::vector<std::string> elements;
+  bool empty = true;
   for (const ModuleMember& member : members_) {
     if (std::holds_alternative<ModuleSection*>(member)) {
       if (std::get<ModuleSection*>(member)->members_.empty()) {
         continue;
       }
     }
-    elements.push_back(EmitModuleMember(line_info, member));
+    if (!empty) {
+      out->Write("\n");
+    }
+    empty = false;
+    absl::visit([&](auto* d) { d->EmitTo(out, line_info); }, member);
     LineInfoIncrease(line_info, 1);
   }
-  if (!elements.empty()) {
+  if (!empty) {
     LineInfoIncrease(line_info, -1);
   }
   LineInfoEnd(line_info, this);
-  return absl::StrJoin(elements, "\n");
 }
 
 std::string VerilogPackageSection::Emit(LineInfo* line_info) const {
+  return EmitToString(*this, line_info);
+}
+
+void VerilogPackageSection::EmitTo(EmitStream* out,
+                                   LineInfo* line_info) const {
   LineInfoStart(line_info, this);
-  std::vector<std::string> elements;
+  bool empty = true;
   for (const VerilogPackageMember& member : members_) {
     if (std::holds_alternative<VerilogPackageSection*>(member)) {
       if (std::get<VerilogPackageSection*>(member)->members_.empty()) {
         continue;
       }
     }
-    elements.push_back(EmitVerilogPackageMember(line_info, member));
+    if (!empty) {
+      out->Write("\n");
+    }
+    empty = false;
+    absl::visit([&](auto* d) { d->EmitTo(out, line_info); }, member);
     LineInfoIncrease(line_info, 1);
   }
-  if (!elements.empty()) {
+  if (!empty) {
     LineInfoIncrease(line_info, -1);
   }
   LineInfoEnd(line_info, this);
-  return absl::StrJoin(elements, "\n");
 }
 
 std::string ContinuousAssignment::Emit(LineInfo* line_info) const {
@@ -1145,45 +1184,56 @@ std::string SystemFunctionCall::Emit(LineInfo* line_info) const {
 }
 
 std::string Module::Emit(LineInfo* line_info) const {
+  return EmitToString(*this, line_info);
+}
+
+void Module::EmitTo(EmitStream* out, LineInfo* line_info) const {
   LineInfoStart(line_info, this);
-  std::string result = absl::StrCat("module ", name_);
+  out->Write(absl::StrCat("module ", name_));
   if (ports_.empty()) {
-    absl::StrAppend(&result, ";\n");
+    out->Write(";\n");
     LineInfoIncrease(line_info, 1);
   } else {
-    absl::StrAppend(&result, "(\n  ");
+    out->Write("(\n  ");
     LineInfoIncrease(line_info, 1);
-    absl::StrAppend(
-        &result,
-        absl::StrJoin(ports_, ",\n  ", [=](std::string* out, const Port& port) {
-          std::string wire_str = port.wire->EmitNoSemi(line_info);
-          CHECK(CannotStripWhitespace(wire_str));
-          absl::StrAppendFormat(out, "%s %s", ToString(port.direction),
-                                wire_str);
-          LineInfoIncrease(line_info, 1);
-        }));
-    absl::StrAppend(&result, "\n);\n");
+    for (int64_t i = 0; i < ports_.size(); ++i) {
+      const Port& port = ports_[i];
+      std::string wire_str = port.wire->EmitNoSemi(line_info);
+      CHECK(CannotStripWhitespace(wire_str));
+      out->Write(absl::StrFormat("%s%s %s", i == 0 ? "" : ",\n  ",
+                                 ToString(port.direction), wire_str));
+      LineInfoIncrease(line_info, 1);
+    }
+    out->Write("\n);\n");
     LineInfoIncrease(line_info, 1);
   }
-  absl::StrAppend(&result, Indent(top_.Emit(line_info)), "\n");
+  out->Indent();
+  top_.EmitTo(out, line_info);
+  out->Dedent();
+  out->Write("\n");
   LineInfoIncrease(line_info, 1);
-  absl::StrAppend(&result, "endmodule");
+  out->Write("endmodule");
   LineInfoEnd(line_info, this);
-  return result;
 }
 
 std::string VerilogPackage::Emit(LineInfo* line_info) const {
+  return EmitToString(*this, line_info);
+}
+
+void VerilogPackage::EmitTo(EmitStream* out, LineInfo* line_info) const {
   LineInfoStart(line_info, this);
 
-  std::string result = absl::StrCat("package ", name_, ";\n");
+  out->Write(absl::StrCat("package ", name_, ";\n"));
   LineInfoIncrease(line_info, 1);
 
-  absl::StrAppend(&result, Indent(top_.Emit(line_info)), "\n");
+  out->Indent();
+  top_.EmitTo(out, line_info);
+  out->Dedent();
+  out->Write("\n");
   LineInfoIncrease(line_info, 1);
 
-  absl::StrAppend(&result, "endpackage");
+  out->Write("endpackage");
   LineInfoEnd(line_info, this);
-  return result;
 }
 
 std::string Literal::Emit(LineInfo* line_info) const {
@@ -1683,28 +1733,29 @@ ModuleSection* ModuleConditionalDirective::AddAlternate(
 }
 
 std::string ModuleConditionalDirective::Emit(LineInfo* line_info) const {
+  return EmitToString(*this, line_info);
+}
+
+void ModuleConditionalDirective::EmitTo(EmitStream* out,
+                                        LineInfo* line_info) const {
   LineInfoStart(line_info, this);
-  std::vector<std::string> pieces;
-  pieces.push_back(
-      absl::StrCat(ConditionalDirectiveKindToString(kind_), " ", identifier_));
-  pieces.push_back(consequent_->Emit(line_info));
+  out->Write(absl::StrCat(ConditionalDirectiveKindToString(kind_), " ",
+                          identifier_, "\n"));
+  consequent_->EmitTo(out, line_info);
   LineInfoIncrease(line_info, 2);
 
   for (const auto& [identifier, block] : alternates_) {
     if (identifier.empty()) {
-      pieces.push_back("`else");
-      pieces.push_back(block->Emit(line_info));
+      out->Write("\n`else\n");
     } else {
-      pieces.push_back(absl::StrCat("`elsif ", identifier));
-      pieces.push_back(block->Emit(line_info));
+      out->Write(absl::StrCat("\n`elsif ", identifier, "\n"));
     }
+    block->EmitTo(out, line_info);
     LineInfoIncrease(line_info, 2);
   }
-  pieces.push_back("`endif");
+  out->Write("\n`endif");
   LineInfoIncrease(line_info, 1);
   LineInfoEnd(line_info, this);
-
-  return absl::StrJoin(pieces, "\n");
 }
 
 WhileStatement::WhileStatement(Expression* condition, VerilogFile* file,
@@ -18,13 +18,16 @@
 #ifndef XLS_CODEGEN_VAST_H_
 #define XLS_CODEGEN_VAST_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <new>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -38,6 +41,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "xls/codegen/module_signature.pb.h"
+#include "xls/codegen/vast/emit_stream.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/format_preference.h"
@@ -168,6 +172,13 @@ class VastNode {
 
   virtual std::string Emit(LineInfo* line_info) const = 0;
 
+  // Writes the same text as Emit to `out`. Nodes which can hold a large amount
+  // of text, such as modules, override this to stream their members one at a
+  // time rather than concatenating the text of all of them.
+  virtual void EmitTo(EmitStream* out, LineInfo* line_info) const {
+    out->Write(Emit(line_info));
+  }
+
  private:
   VerilogFile* file_;
   SourceInfo loc_;
@@ -2154,6 +2165,7 @@ class ModuleSection final : public VastNode {
   const std::vector<ModuleMember>& members() const { return members_; }
 
   std::string Emit(LineInfo* line_info) const final;
+  void EmitTo(EmitStream* out, LineInfo* line_info) const final;
 
  private:
   std::vector<ModuleMember> members_;
@@ -2175,6 +2187,7 @@ class ModuleConditionalDirective final : public VastNode {
   ModuleSection* AddAlternate(std::string identifier = "");
 
   std::string Emit(LineInfo* line_info) const final;
+  void EmitTo(EmitStream* out, LineInfo* line_info) const final;
 
  private:
   ConditionalDirectiveKind kind_;
@@ -2252,6 +2265,7 @@ class Module final : public VastNode {
   const std::string& name() const { return name_; }
 
   std::string Emit(LineInfo* line_info) const final;
+  void EmitTo(EmitStream* out, LineInfo* line_info) const final;
 
  private:
   // Add the given Def as a port on the module.
@@ -2322,6 +2336,7 @@ class VerilogPackageSection final : public VastNode {
   const std::vector<VerilogPackageMember>& members() const { return members_; }
 
   std::string Emit(LineInfo* line_info) const final;
+  void EmitTo(EmitStream* out, LineInfo* line_info) const final;
 
  private:
   std::vector<VerilogPackageMember> members_;
@@ -2356,6 +2371,7 @@ class VerilogPackage final : public VastNode {
   const std::string& name() const { return name_; }
 
   std::string Emit(LineInfo* line_info) const final;
+  void EmitTo(EmitStream* out, LineInfo* line_info) const final;
 
  private:
   std::string name_;
@@ -2377,6 +2393,47 @@ class Include final : public VastNode {
 using FileMember =
     std::variant<Module*, VerilogPackage*, Include*, BlankLine*, Comment*>;
 
+// Bump allocator owning the nodes of a VerilogFile. Nodes are placed one after
+// the other in large blocks, so creating a node is usually just a pointer
+// increment, nodes created together are close together in memory, and the
+// storage is released a block at a time. Nodes never move, so pointers to them
+// remain valid for the lifetime of the arena.
+class VastNodeArena {
+ public:
+  VastNodeArena() = default;
+  ~VastNodeArena();
+
+  VastNodeArena(const VastNodeArena&) = delete;
+  VastNodeArena& operator=(const VastNodeArena&) = delete;
+
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    static_assert(std::is_base_of_v<VastNode, T>);
+    static_assert(alignof(T) <= alignof(std::max_align_t));
+    T* node = new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    nodes_.push_back(node);
+    return node;
+  }
+
+  // Number of nodes in the arena.
+  int64_t size() const { return nodes_.size(); }
+
+ private:
+  static constexpr size_t kBlockSize = size_t{64} * 1024;
+
+  // Returns uninitialized storage for an object of the given size and
+  // alignment.
+  void* Allocate(size_t size, size_t alignment);
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  // The unused tail of the last block.
+  std::byte* next_ = nullptr;
+  size_t remaining_ = 0;
+  // The nodes in creation order. They are destroyed in reverse order.
+  std::vector<VastNode*> nodes_;
+};
+
 // Represents a file (as a Verilog translation-unit equivalent).
 class VerilogFile {
  public:
@@ -2401,15 +2458,16 @@ class VerilogFile {
 
   template <typename T, typename... Args>
   T* Make(const SourceInfo& loc, Args&&... args) {
-    std::unique_ptr<T> value =
-        std::make_unique<T>(std::forward<Args>(args)..., this, loc);
-    T* ptr = value.get();
-    nodes_.push_back(std::move(value));
-    return ptr;
+    return nodes_.Create<T>(std::forward<Args>(args)..., this, loc);
   }
 
   std::string Emit(LineInfo* line_info = nullptr) const;
 
+  // Writes the text returned by Emit to `out` one file member at a time. Use
+  // this with a FileEmitSink to write large files without holding their whole
+  // text in memory.
+  void EmitTo(EmitStream* out, LineInfo* line_info = nullptr) const;
+
   verilog::Slice* Slice(IndexableExpression* subject, Expression* hi,
                         Expression* lo, const SourceInfo& loc) {
     return Make<verilog::Slice>(loc, subject, hi, lo);
@@ -2673,7 +2731,7 @@ class VerilogFile {
 
   FileType file_type_;
   std::vector<FileMember> members_;
-  std::vector<std::unique_ptr<VastNode>> nodes_;
+  VastNodeArena nodes_;
 };
 
 template <typename T, typename... Args>
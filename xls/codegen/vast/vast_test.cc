@@ -25,9 +25,11 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "xls/codegen/vast/emit_stream.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/format_preference.h"
@@ -2300,6 +2302,64 @@ TEST_P(VastTest, SliceOfMultidimensionalPackedArrayOnLhsAndRhs) {
 endmodule)");
 }
 
+TEST_P(VastTest, ManyNodes) {
+  // Enough nodes to fill many blocks of the arena holding them.
+  VerilogFile f(GetFileType());
+  Module* m = f.AddModule("top", SourceInfo());
+  std::vector<Expression*> literals;
+  for (int64_t i = 0; i < 100000; ++i) {
+    literals.push_back(f.PlainLiteral(i, SourceInfo()));
+  }
+  m->AddReg("r", f.BitVectorType(32, SourceInfo()), SourceInfo(),
+            f.Concat(literals, SourceInfo()));
+
+  for (int64_t i = 0; i < literals.size(); ++i) {
+    ASSERT_EQ(literals[i]->Emit(nullptr), absl::StrCat(i));
+  }
+}
+
+TEST_P(VastTest, StreamedFile) {
+  VerilogFile f(GetFileType());
+  Module* m = f.AddModule("top", SourceInfo());
+  LogicRef* clk =
+      m->AddInput("clk", f.BitVectorType(1, SourceInfo()), SourceInfo());
+  LogicRef* out =
+      m->AddOutput("out", f.BitVectorType(8, SourceInfo()), SourceInfo());
+  LogicRef* r = m->AddReg("r", f.BitVectorType(8, SourceInfo()), SourceInfo());
+  AlwaysFlop* af = m->Add<AlwaysFlop>(SourceInfo(), clk);
+  af->AddRegister(r, out, SourceInfo());
+  ModuleConditionalDirective* ifndef = m->Add<ModuleConditionalDirective>(
+      SourceInfo(), ConditionalDirectiveKind::kIfndef, "SYNTHESIS");
+  ifndef->consequent()->Add<ContinuousAssignment>(SourceInfo(), out, r);
+  f.Add(f.Make<BlankLine>(SourceInfo()));
+  f.AddModule("empty", SourceInfo());
+
+  absl::Cord text;
+  CordEmitSink sink(&text);
+  EmitStream stream(&sink);
+  LineInfo line_info;
+  f.EmitTo(&stream, &line_info);
+  EXPECT_EQ(std::string(text), R"(module top(
+  input wire clk,
+  output wire [7:0] out
+);
+  reg [7:0] r;
+  always @ (posedge clk) begin
+    r <= out;
+  end
+  `ifndef SYNTHESIS
+  assign out = r;
+  `endif
+endmodule
+
+module empty;
+
+endmodule
+)");
+  EXPECT_EQ(std::string(text), f.Emit());
+  EXPECT_EQ(line_info.LookupNode(m).value().front().StartLine(), 0);
+}
+
 INSTANTIATE_TEST_SUITE_P(VastTestInstantiation, VastTest,
                          testing::Values(false, true),
                          [](const testing::TestParamInfo<bool>& info) {
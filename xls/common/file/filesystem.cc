@@ -20,7 +20,9 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <cstdint>
 #include <cstring>
 #include <filesystem>  // NOLINT
 #include <sstream>
@@ -204,6 +206,26 @@ absl::Status SetFileContents(const std::filesystem::path& file_name,
   return SetFileContentsOrAppend(file_name, content, SetOrAppend::kSet);
 }
 
+absl::Status AtomicallySetFileContents(const std::filesystem::path& file_name,
+                                       std::string_view content) {
+  static std::atomic<int64_t> counter = 0;
+  std::filesystem::path tmp_path = absl::StrCat(
+      file_name.string(), ".tmp.", getpid(), ".", counter.fetch_add(1));
+  XLS_RETURN_IF_ERROR(SetFileContents(tmp_path, content));
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, file_name, ec);
+  if (ec) {
+    std::error_code remove_ec;
+    std::filesystem::remove(tmp_path, remove_ec);
+    absl::Status status = ErrorCodeToStatus(ec);
+    return absl::Status(status.code(),
+                        absl::StrCat("Unable to move ", tmp_path.string(),
+                                     " into place at ", file_name.string(),
+                                     ": ", status.message()));
+  }
+  return absl::OkStatus();
+}
+
 absl::Status AppendStringToFile(const std::filesystem::path& file_name,
                                 std::string_view content) {
   return SetFileContentsOrAppend(file_name, content, SetOrAppend::kAppend);
@@ -98,6 +98,19 @@ absl::StatusOr<std::string> GetFileContents(
 absl::Status SetFileContents(const std::filesystem::path& file_name,
                              std::string_view content);
 
+// Writes the contents of data into the file file_name, overwriting any
+// existing content, such that readers (in this or other processes) only ever
+// see either the previous or the new contents in full. The data is written to
+// a uniquely named temporary file in the same directory which is then renamed
+// to file_name. The temporary file is removed if the rename fails.
+//
+// Typical return codes (not guaranteed exhaustive):
+//  * StatusCode::kOk
+//  * StatusCode::kPermissionDenied (directory not writable)
+//  * StatusCode::kUnknown (a Write, Open or Rename error occurred)
+absl::Status AtomicallySetFileContents(const std::filesystem::path& file_name,
+                                       std::string_view content);
+
 // Writes the contents of data into the file file_name, appending to any
 // existing content.
 //
@@ -21,6 +21,7 @@
 #include <ios>
 #include <string>
 #include <system_error>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -37,8 +38,10 @@ namespace {
 
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
+using ::testing::_;
 using ::testing::AnyOf;
 using ::testing::Contains;
+using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::HasSubstr;
 
@@ -223,6 +226,32 @@ TEST(FilesystemTest, SetFileContentsWithSmallerContent) {
   EXPECT_THAT(GetFileContents(temp_file.path()), IsOkAndHolds("123"));
 }
 
+TEST(FilesystemTest, AtomicallySetFileContentsOverwritesFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path path = temp_dir.path() / "file";
+  XLS_ASSERT_OK(SetFileContents(path, "abcdefghi"));
+
+  XLS_ASSERT_OK(AtomicallySetFileContents(path, "123"));
+
+  EXPECT_THAT(GetFileContents(path), IsOkAndHolds("123"));
+  // No temporary files are left behind.
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<std::filesystem::path> entries,
+                           GetDirectoryEntries(temp_dir.path()));
+  EXPECT_THAT(entries, ElementsAre(path));
+}
+
+TEST(FilesystemTest, AtomicallySetFileContentsOverDirectoryFails) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path path = temp_dir.path() / "dir";
+  XLS_ASSERT_OK(RecursivelyCreateDir(path / "child"));
+
+  EXPECT_THAT(AtomicallySetFileContents(path, "123"),
+              StatusIs(_, HasSubstr("into place at")));
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<std::filesystem::path> entries,
+                           GetDirectoryEntries(temp_dir.path()));
+  EXPECT_THAT(entries, ElementsAre(path));
+}
+
 TEST(FilesystemTest, VerifyPermissionsOfTempFile) {
   XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
                            TempFile::CreateWithContent("abcdefghi"));
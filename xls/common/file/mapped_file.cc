@@ -0,0 +1,97 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/common/file/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <filesystem>  // NOLINT
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/error_code_to_status.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls {
+
+/* static */ absl::StatusOr<MappedFile> MappedFile::Open(
+    const std::filesystem::path& path) {
+  MappedFile file;
+  if (path == "/dev/stdin" || path == "-") {
+    XLS_ASSIGN_OR_RETURN(file.read_contents_, GetFileContents(path));
+    return file;
+  }
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return ErrnoToStatus(errno) << "Failed to open " << path;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int fstat_errno = errno;
+    close(fd);
+    return ErrnoToStatus(fstat_errno) << "Failed to stat " << path;
+  }
+  if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+    // Only regular files can be mapped, and empty mappings are not allowed.
+    close(fd);
+    XLS_ASSIGN_OR_RETURN(file.read_contents_, GetFileContents(path));
+    return file;
+  }
+  void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int mmap_errno = errno;
+  // The mapping stays valid after the file is closed.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return ErrnoToStatus(mmap_errno) << "Failed to map " << path;
+  }
+  // The contents are expected to be read front to back.
+  madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+  file.mapping_ = static_cast<const char*>(mapping);
+  file.size_ = st.st_size;
+  return file;
+}
+
+MappedFile::~MappedFile() { Unmap(); }
+
+MappedFile::MappedFile(MappedFile&& other)
+    : mapping_(std::exchange(other.mapping_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      read_contents_(std::move(other.read_contents_)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  if (this != &other) {
+    Unmap();
+    mapping_ = std::exchange(other.mapping_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    read_contents_ = std::move(other.read_contents_);
+  }
+  return *this;
+}
+
+void MappedFile::Unmap() {
+  if (mapping_ != nullptr) {
+    munmap(const_cast<char*>(mapping_), size_);
+    mapping_ = nullptr;
+    size_ = 0;
+  }
+}
+
+}  // namespace xls
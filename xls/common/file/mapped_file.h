@@ -0,0 +1,66 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_COMMON_FILE_MAPPED_FILE_H_
+#define XLS_COMMON_FILE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <filesystem>  // NOLINT
+#include <string>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+
+namespace xls {
+
+// The read-only contents of a file mapped into memory. Unlike the string
+// returned by GetFileContents, the mapped pages are backed by the file itself
+// so they can be evicted under memory pressure and only count against the
+// memory of the process while they are resident, which makes it suitable for
+// scanning very large files once. Files which cannot be mapped (e.g., pipes
+// and "/dev/stdin") are read into memory instead.
+class MappedFile {
+ public:
+  static absl::StatusOr<MappedFile> Open(const std::filesystem::path& path);
+
+  ~MappedFile();
+
+  // MappedFile is movable but not copyable.
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // The contents of the file, valid for the lifetime of this object.
+  std::string_view contents() const {
+    return mapping_ != nullptr ? std::string_view(mapping_, size_)
+                               : std::string_view(read_contents_);
+  }
+
+  // Returns whether the contents are mapped rather than read into memory.
+  bool is_mapped() const { return mapping_ != nullptr; }
+
+ private:
+  MappedFile() = default;
+  void Unmap();
+
+  const char* mapping_ = nullptr;
+  size_t size_ = 0;
+  std::string read_contents_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_FILE_MAPPED_FILE_H_
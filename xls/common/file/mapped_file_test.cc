@@ -0,0 +1,69 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/common/file/mapped_file.h"
+
+#include <filesystem>  // NOLINT
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::IsEmpty;
+
+TEST(MappedFileTest, MapsFileContents) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path path = temp_dir.path() / "foo.txt";
+  std::string contents(1 << 20, 'x');
+  contents.back() = 'y';
+  XLS_ASSERT_OK(SetFileContents(path, contents));
+
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(path));
+  EXPECT_TRUE(file.is_mapped());
+  EXPECT_EQ(file.contents(), contents);
+
+  // The mapping is transferred on move.
+  MappedFile moved = std::move(file);
+  EXPECT_EQ(moved.contents(), contents);
+}
+
+TEST(MappedFileTest, EmptyFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path path = temp_dir.path() / "empty.txt";
+  XLS_ASSERT_OK(SetFileContents(path, ""));
+
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile file, MappedFile::Open(path));
+  EXPECT_FALSE(file.is_mapped());
+  EXPECT_THAT(file.contents(), IsEmpty());
+}
+
+TEST(MappedFileTest, MissingFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  EXPECT_THAT(MappedFile::Open(temp_dir.path() / "missing.txt"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace xls
@@ -59,6 +59,10 @@ class FileLineWriter {
   // is automatically added.
   absl::Status WriteLine(std::string_view line);
 
+  // Flushes the lines written so far to the file. Needed when the reader waits
+  // for lines before the writer is done (or closed).
+  absl::Status Flush();
+
   // FileLineWriter is movable but not copyable.
   FileLineWriter(FileLineWriter&& other) = default;
   FileLineWriter& operator=(FileLineWriter&& other) = default;
@@ -14,6 +14,7 @@
 
 #include "xls/common/init_xls.h"
 
+#include <fstream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -39,8 +40,23 @@ std::vector<std::string_view> InitXls(std::string_view usage, int argc,
     };
     absl::SetFlagsUsageConfig(usage_config);
   };
-  // Copy the argv array to ensure this method doesn't clobber argv.
-  std::vector<char*> arguments(argv, argv + argc);
+  // Copy the argv array to ensure this method doesn't clobber argv. Bazel
+  // params files ("@path" arguments, one argument per line) are expanded in
+  // place; their contents must outlive the returned views so are never freed.
+  std::vector<char*> arguments;
+  for (int i = 0; i < argc; ++i) {
+    std::string_view argument = argv[i];
+    if (i == 0 || !argument.starts_with('@')) {
+      arguments.push_back(argv[i]);
+      continue;
+    }
+    std::ifstream params_file{std::string(argument.substr(1))};
+    QCHECK(params_file) << "Unable to read params file " << argument.substr(1);
+    std::string line;
+    while (std::getline(params_file, line)) {
+      arguments.push_back((new std::string(line))->data());
+    }
+  }
   std::vector<char*> remaining = absl::ParseCommandLine(
       static_cast<int>(arguments.size()), arguments.data());
   CHECK_GE(argc, 1);
@@ -31,7 +31,9 @@ namespace xls {
 // absl::SetProgramUsageMessage().
 //
 // `argc` and `argv` are the command line flags to parse. This function does not
-// modify `argc`.
+// modify `argc`. An argument of the form "@path" is replaced by the lines of
+// the file at `path`, as Bazel writes params files for actions which may run as
+// persistent workers.
 //
 // Returns a vector of the positional arguments that are not part of any
 // command-line flag (or arguments to a flag), not including the program
@@ -0,0 +1,147 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/persistent_worker.h"
+
+#include <cstdint>
+#include <iostream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/reflection.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "xls/common/worker_protocol.pb.h"
+
+ABSL_FLAG(bool, persistent_worker, false,
+          "Run as a Bazel persistent worker, reading work requests from stdin "
+          "and writing responses to stdout.");
+
+namespace xls {
+namespace {
+
+// Reads a varint length prefix followed by that many bytes. Reads exactly the
+// bytes of one message, as Bazel waits for the response before sending more.
+// Returns nullopt at the end of the stream.
+std::optional<std::string> ReadDelimited(std::istream& in) {
+  uint64_t size = 0;
+  for (int shift = 0;; shift += 7) {
+    int c = in.get();
+    if (c == std::char_traits<char>::eof() || shift >= 64) {
+      return std::nullopt;
+    }
+    size |= static_cast<uint64_t>(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) {
+      break;
+    }
+  }
+  std::string bytes(size, '\0');
+  if (!in.read(bytes.data(), static_cast<std::streamsize>(size))) {
+    return std::nullopt;
+  }
+  return bytes;
+}
+
+void WriteDelimited(const WorkResponse& response, std::ostream& out) {
+  std::string bytes = response.SerializeAsString();
+  // A varint32 takes at most five bytes.
+  uint8_t prefix[5];
+  uint8_t* end = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(
+      static_cast<uint32_t>(bytes.size()), prefix);
+  out.write(reinterpret_cast<const char*>(prefix), end - prefix);
+  out << bytes;
+  out.flush();
+}
+
+}  // namespace
+
+bool IsPersistentWorker() { return absl::GetFlag(FLAGS_persistent_worker); }
+
+WorkResponse HandleWorkRequest(const WorkRequest& request,
+                               std::string_view program_name,
+                               WorkerFunction work) {
+  WorkResponse response;
+  response.set_request_id(request.request_id());
+
+  // Flags set by one request must not leak into the next.
+  absl::FlagSaver flag_saver;
+  std::vector<std::string> arguments;
+  arguments.reserve(request.arguments_size() + 1);
+  arguments.emplace_back(program_name);
+  arguments.insert(arguments.end(), request.arguments().begin(),
+                   request.arguments().end());
+  std::vector<char*> argv;
+  argv.reserve(arguments.size());
+  for (std::string& argument : arguments) {
+    argv.push_back(argument.data());
+  }
+  std::vector<char*> positional;
+  std::vector<absl::UnrecognizedFlag> unrecognized;
+  absl::ParseAbseilFlagsOnly(static_cast<int>(argv.size()), argv.data(),
+                             positional, unrecognized);
+  if (!unrecognized.empty()) {
+    response.set_exit_code(1);
+    response.set_output(absl::StrCat("Unknown command line flag '",
+                                     unrecognized.front().flag_name, "'\n"));
+    return response;
+  }
+  // The first positional argument is the program name.
+  std::vector<std::string_view> positional_arguments(positional.begin() + 1,
+                                                     positional.end());
+
+  std::ostringstream output;
+  std::streambuf* cout_buf = std::cout.rdbuf(output.rdbuf());
+  std::streambuf* cerr_buf = std::cerr.rdbuf(output.rdbuf());
+  absl::Status status = work(positional_arguments);
+  std::cout.rdbuf(cout_buf);
+  std::cerr.rdbuf(cerr_buf);
+
+  std::string text = output.str();
+  if (!status.ok()) {
+    absl::StrAppend(&text, status.ToString(), "\n");
+    response.set_exit_code(1);
+  }
+  response.set_output(std::move(text));
+  return response;
+}
+
+int RunPersistentWorker(std::string_view program_name, WorkerFunction work,
+                        std::istream& in, std::ostream& out) {
+  while (std::optional<std::string> bytes = ReadDelimited(in)) {
+    WorkRequest request;
+    if (!request.ParseFromString(*bytes)) {
+      LOG(ERROR) << "Malformed work request";
+      return 1;
+    }
+    WriteDelimited(HandleWorkRequest(request, program_name, work), out);
+  }
+  return 0;
+}
+
+int RunPersistentWorker(std::string_view program_name, WorkerFunction work) {
+  return RunPersistentWorker(program_name, work, std::cin, std::cout);
+}
+
+}  // namespace xls
@@ -0,0 +1,56 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_PERSISTENT_WORKER_H_
+#define XLS_COMMON_PERSISTENT_WORKER_H_
+
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "xls/common/worker_protocol.pb.h"
+
+namespace xls {
+
+// Runs one unit of work of a tool given the positional arguments of its
+// command line. Flags have already been parsed into the absl flags.
+using WorkerFunction =
+    absl::FunctionRef<absl::Status(absl::Span<const std::string_view>)>;
+
+// Whether the binary was started by Bazel as a persistent worker, i.e., with
+// --persistent_worker.
+bool IsPersistentWorker();
+
+// Handles a single work request: parses the flags in its arguments, runs
+// `work` on the remaining positional arguments and restores the flags
+// afterwards. Anything `work` writes to std::cout or std::cerr, along with a
+// failed status, is returned as the output of the response.
+WorkResponse HandleWorkRequest(const WorkRequest& request,
+                               std::string_view program_name,
+                               WorkerFunction work);
+
+// Serves work requests read from `in` until it is closed, writing the
+// responses to `out`. Returns the exit code of the worker.
+int RunPersistentWorker(std::string_view program_name, WorkerFunction work,
+                        std::istream& in, std::ostream& out);
+
+// As above, speaking the protocol over stdin and stdout.
+int RunPersistentWorker(std::string_view program_name, WorkerFunction work);
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_PERSISTENT_WORKER_H_
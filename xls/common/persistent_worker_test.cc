@@ -0,0 +1,128 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/persistent_worker.h"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "xls/common/worker_protocol.pb.h"
+
+ABSL_FLAG(int64_t, worker_test_value, 0, "Flag set by the test requests.");
+
+namespace xls {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+WorkRequest MakeRequest(std::vector<std::string> arguments,
+                        int32_t request_id = 0) {
+  WorkRequest request;
+  for (std::string& argument : arguments) {
+    request.add_arguments(std::move(argument));
+  }
+  request.set_request_id(request_id);
+  return request;
+}
+
+TEST(PersistentWorkerTest, ParsesFlagsAndRestoresThem) {
+  std::vector<std::string> seen;
+  int64_t seen_value = 0;
+  auto work = [&](absl::Span<const std::string_view> positional) {
+    seen.assign(positional.begin(), positional.end());
+    seen_value = absl::GetFlag(FLAGS_worker_test_value);
+    std::cout << "hello";
+    return absl::OkStatus();
+  };
+  WorkResponse response =
+      HandleWorkRequest(MakeRequest({"a.x", "--worker_test_value=42", "b.x"}),
+                        "tool", work);
+  EXPECT_EQ(response.exit_code(), 0);
+  EXPECT_EQ(response.output(), "hello");
+  EXPECT_THAT(seen, ElementsAre("a.x", "b.x"));
+  EXPECT_EQ(seen_value, 42);
+  EXPECT_EQ(absl::GetFlag(FLAGS_worker_test_value), 0);
+}
+
+TEST(PersistentWorkerTest, ReportsErrors) {
+  auto work = [](absl::Span<const std::string_view> positional) {
+    std::cerr << "warning\n";
+    return absl::InvalidArgumentError("bad input");
+  };
+  WorkResponse response =
+      HandleWorkRequest(MakeRequest({"a.x"}, /*request_id=*/3), "tool", work);
+  EXPECT_EQ(response.exit_code(), 1);
+  EXPECT_EQ(response.request_id(), 3);
+  EXPECT_THAT(response.output(), HasSubstr("warning\n"));
+  EXPECT_THAT(response.output(), HasSubstr("bad input"));
+
+  response = HandleWorkRequest(MakeRequest({"--no_such_flag=1"}), "tool", work);
+  EXPECT_EQ(response.exit_code(), 1);
+  EXPECT_THAT(response.output(), HasSubstr("no_such_flag"));
+}
+
+TEST(PersistentWorkerTest, ServesRequestsUntilEndOfInput) {
+  std::string requests;
+  {
+    google::protobuf::io::StringOutputStream stream(&requests);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    for (int64_t value : {1, 2, 3}) {
+      WorkRequest request = MakeRequest(
+          {absl::StrCat("--worker_test_value=", value)}, /*request_id=*/value);
+      coded.WriteVarint32(request.ByteSizeLong());
+      request.SerializeToCodedStream(&coded);
+    }
+  }
+  std::istringstream in(requests);
+  std::ostringstream out;
+  auto work = [](absl::Span<const std::string_view> positional) {
+    std::cout << absl::GetFlag(FLAGS_worker_test_value);
+    return absl::OkStatus();
+  };
+  EXPECT_EQ(RunPersistentWorker("tool", work, in, out), 0);
+
+  std::string responses = out.str();
+  google::protobuf::io::ArrayInputStream stream(responses.data(),
+                                                responses.size());
+  google::protobuf::io::CodedInputStream coded(&stream);
+  for (int64_t value : {1, 2, 3}) {
+    uint32_t size;
+    ASSERT_TRUE(coded.ReadVarint32(&size));
+    auto limit = coded.PushLimit(size);
+    WorkResponse response;
+    ASSERT_TRUE(response.ParseFromCodedStream(&coded));
+    coded.PopLimit(limit);
+    EXPECT_EQ(response.request_id(), value);
+    EXPECT_EQ(response.exit_code(), 0);
+    EXPECT_EQ(response.output(), absl::StrCat(value));
+  }
+  EXPECT_TRUE(coded.ExpectAtEnd());
+}
+
+}  // namespace
+}  // namespace xls
@@ -39,6 +39,32 @@ void BasicIntegrationAlgorithm::EnqueueNodeIfReady(Node* node) {
   }
 }
 
+absl::StatusOr<int64_t> BasicIntegrationAlgorithm::GetInsertNodeCost(
+    Node* node) {
+  auto it = insert_costs_.find(node);
+  if (it != insert_costs_.end()) {
+    return it->second;
+  }
+  XLS_ASSIGN_OR_RETURN(int64_t cost,
+                       integration_function_->GetInsertNodeCost(node));
+  insert_costs_[node] = cost;
+  return cost;
+}
+
+absl::StatusOr<std::optional<int64_t>>
+BasicIntegrationAlgorithm::GetMergeNodesCost(Node* node, Node* internal_node) {
+  std::pair<Node*, Node*> key(node, internal_node);
+  auto it = merge_costs_.find(key);
+  if (it != merge_costs_.end()) {
+    return it->second;
+  }
+  XLS_ASSIGN_OR_RETURN(
+      std::optional<int64_t> cost,
+      integration_function_->GetMergeNodesCost(node, internal_node));
+  merge_costs_[key] = cost;
+  return cost;
+}
+
 absl::Status BasicIntegrationAlgorithm::Initialize() {
   // Make integration function.
   XLS_ASSIGN_OR_RETURN(integration_function_, NewIntegrationFunction());
@@ -61,8 +87,7 @@ BasicIntegrationAlgorithm::Run() {
     for (auto node_itr = ready_nodes_.begin(); node_itr != ready_nodes_.end();
          ++node_itr) {
       // Check insertion cost.
-      XLS_ASSIGN_OR_RETURN(int64_t insert_cost,
-                           integration_function_->GetInsertNodeCost(*node_itr));
+      XLS_ASSIGN_OR_RETURN(int64_t insert_cost, GetInsertNodeCost(*node_itr));
       if (!move.has_value() || insert_cost < move.value().cost) {
         move = MakeInsertMove(node_itr, insert_cost);
       }
@@ -76,9 +101,8 @@ BasicIntegrationAlgorithm::Run() {
         }
 
         // Check if mergeable
-        XLS_ASSIGN_OR_RETURN(
-            std::optional<int64_t> merge_cost,
-            integration_function_->GetMergeNodesCost(*node_itr, internal_node));
+        XLS_ASSIGN_OR_RETURN(std::optional<int64_t> merge_cost,
+                             GetMergeNodesCost(*node_itr, internal_node));
         if (!merge_cost.has_value()) {
           continue;
         }
@@ -95,6 +119,9 @@ BasicIntegrationAlgorithm::Run() {
     XLS_RET_CHECK(move.has_value());
     XLS_RETURN_IF_ERROR(
         ExecuteMove(integration_function_.get(), move.value()).status());
+    if (move.value().move_type == IntegrationMoveType::kMerge) {
+      merge_costs_.clear();
+    }
 
     // Update ready_nodes_.
     ready_nodes_.erase(move.value().node_itr);
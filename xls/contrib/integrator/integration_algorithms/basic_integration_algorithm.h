@@ -19,7 +19,10 @@
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <optional>
+#include <utility>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -94,6 +97,26 @@ class BasicIntegrationAlgorithm
   // and node has not already been queued for processing.
   void EnqueueNodeIfReady(Node* node);
 
+  // Returns the cost of inserting / merging 'node' into the integration
+  // function, consulting the caches below first. Evaluating a cost
+  // temporarily modifies the integration function, which makes it by far the
+  // most expensive part of the search. For the same reason candidates are
+  // evaluated one at a time on a single thread.
+  absl::StatusOr<int64_t> GetInsertNodeCost(Node* node);
+  absl::StatusOr<std::optional<int64_t>> GetMergeNodesCost(
+      Node* node, Node* internal_node);
+
+  // Cost of inserting each source node. This only depends on the node itself.
+  absl::flat_hash_map<Node*, int64_t> insert_costs_;
+
+  // Cost of merging pairs of (source node, integration function node), or
+  // std::nullopt if they cannot be merged. Inserting a node leaves the
+  // existing integration function nodes untouched so these costs remain valid
+  // across insert moves. A merge replaces integration function nodes and muxes
+  // which any cost may depend on so the cache is cleared after merge moves.
+  absl::flat_hash_map<std::pair<Node*, Node*>, std::optional<int64_t>>
+      merge_costs_;
+
   // Track nodes for which all operands are already mapped and
   // are ready to be added to the integration_function_
   std::list<Node*> ready_nodes_;
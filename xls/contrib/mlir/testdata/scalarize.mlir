@@ -289,3 +289,29 @@ func.func @select(%arg0: tensor<2xi32>, %arg1: tensor<2xi32>, %arg2: tensor<2xi1
   %0 = xls.sel %arg2 in [%arg1] else %arg0 : (tensor<2xi1>, [tensor<2xi32>], tensor<2xi32>) -> tensor<2xi32>
   return %0 : tensor<2xi32>
 }
+
+// CHECK-LABEL: @elementwise_chain
+// CHECK-NEXT: array_index_static
+// CHECK-NEXT: array_index_static
+// CHECK-NEXT: add
+// CHECK-NEXT: array_index_static
+// CHECK-NEXT: array_index_static
+// CHECK-NEXT: add
+// CHECK-NEXT: not
+// CHECK-NEXT: not
+// CHECK-NEXT: array
+// CHECK-NEXT: return
+func.func @elementwise_chain(%arg0: tensor<2xi32>, %arg1: tensor<2xi32>) -> tensor<2xi32> attributes {xls = true} {
+  %0 = xls.add %arg0, %arg1 : tensor<2xi32>
+  %1 = xls.not %0 : tensor<2xi32>
+  return %1 : tensor<2xi32>
+}
+
+// CHECK-LABEL: @identity
+// CHECK-NEXT: xls.identity
+// CHECK-SAME: !xls.array<2 x i32>
+// CHECK-NEXT: return
+func.func @identity(%arg0: tensor<2xi32>) -> tensor<2xi32> attributes {xls = true} {
+  %0 = xls.identity %arg0 : tensor<2xi32>
+  return %0 : tensor<2xi32>
+}
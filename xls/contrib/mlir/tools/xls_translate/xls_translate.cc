@@ -69,7 +69,6 @@
 #include "xls/ir/source_location.h"
 #include "xls/public/function_builder.h"
 #include "xls/public/ir.h"
-#include "xls/public/ir_parser.h"
 #include "xls/public/runtime_build_actions.h"
 #include "xls/tools/opt.h"
 
@@ -866,7 +865,6 @@ FailureOr<PackageInfo> importDslxInstantiation(
   std::string module_name = "imported_module";
   std::string_view stdlib_path = ::xls::GetDefaultDslxStdlibPath();
   std::vector<std::filesystem::path> additional_search_paths = {};
-  absl::StatusOr<std::string> package_string_or;
 
   // Note: this is not bullet proof. The experience if these are wrong would
   // be suboptimal.
@@ -886,19 +884,12 @@ FailureOr<PackageInfo> importDslxInstantiation(
 
   // Note: using a different pathname here else XLS considers this a circular
   // import.
-  package_string_or =
-      ::xls::ConvertDslxToIr(dslx, "<instantiated module>", module_name,
-                             stdlib_path, additional_search_paths);
-  if (!package_string_or.ok()) {
-    llvm::errs() << "Failed to convert DSLX to IR: "
-                 << package_string_or.status().message() << "\n";
-    return failure();
-  }
   absl::StatusOr<std::unique_ptr<Package>> package_or =
-      ::xls::ParsePackage(package_string_or.value(), std::nullopt);
+      ::xls::ConvertDslxToPackage(dslx, "<instantiated module>", module_name,
+                                  stdlib_path, additional_search_paths);
   if (!package_or.ok()) {
-    llvm::errs() << "Failed to parse package: " << package_or.status().message()
-                 << "\n";
+    llvm::errs() << "Failed to convert DSLX to IR: "
+                 << package_or.status().message() << "\n";
     return failure();
   }
   absl::StatusOr<Package::PackageMergeResult> merge_result =
@@ -1346,8 +1337,8 @@ LogicalResult setTop(Operation* op, std::string_view name, Package* package) {
 }
 }  // namespace
 
-LogicalResult MlirXlsToXlsTranslate(Operation* op, llvm::raw_ostream& output,
-                                    MlirXlsToXlsTranslateOptions options) {
+FailureOr<std::unique_ptr<Package>> MlirXlsToXlsPackage(
+    Operation* op, MlirXlsToXlsTranslateOptions options) {
   DslxPackageCache maybe_cache;
   if (options.dslx_cache == nullptr) {
     options.dslx_cache = &maybe_cache;
@@ -1362,7 +1353,8 @@ LogicalResult MlirXlsToXlsTranslate(Operation* op, llvm::raw_ostream& output,
     mlir::PassManager pm(op->getContext());
     pm.addPass(mlir::createSymbolDCEPass());
     if (pm.run(op).failed()) {
-      return op->emitError("Failed to run SymbolDCE pass");
+      op->emitError("Failed to run SymbolDCE pass");
+      return failure();
     }
   }
 
@@ -1383,6 +1375,15 @@ LogicalResult MlirXlsToXlsTranslate(Operation* op, llvm::raw_ostream& output,
       return failure();
     }
   }
+  return std::move(*package);
+}
+
+LogicalResult MlirXlsToXlsTranslate(Operation* op, llvm::raw_ostream& output,
+                                    MlirXlsToXlsTranslateOptions options) {
+  auto package = MlirXlsToXlsPackage(op, options);
+  if (failed(package)) {
+    return failure();
+  }
 
   if (!options.generate_verilog) {
     std::string out = (*package)->DumpIr();
@@ -1410,13 +1411,9 @@ absl::StatusOr<std::shared_ptr<const Package>> DslxPackageCache::import(
   if (it != cache.end()) {
     return it->second;
   }
-  absl::StatusOr<std::string> package_string_or = ::xls::ConvertDslxPathToIr(
-      fileName, ::xls::GetDefaultDslxStdlibPath(), {});
-  if (!package_string_or.ok()) {
-    return package_string_or.status();
-  }
   absl::StatusOr<std::unique_ptr<Package>> package_or =
-      ::xls::ParsePackage(package_string_or.value(), std::nullopt);
+      ::xls::ConvertDslxPathToPackage(fileName,
+                                      ::xls::GetDefaultDslxStdlibPath(), {});
   if (!package_or.ok()) {
     return package_or.status();
   }
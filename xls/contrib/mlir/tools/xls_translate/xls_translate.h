@@ -24,6 +24,7 @@
 #include "absl/status/statusor.h"
 #include "llvm/include/llvm/ADT/StringRef.h"
 #include "mlir/include/mlir/Support/LLVM.h"
+#include "mlir/include/mlir/Support/LogicalResult.h"
 #include "xls/tools/codegen_flags.h"
 #include "xls/tools/codegen_flags.pb.h"
 #include "xls/tools/scheduling_options_flags.h"
@@ -89,7 +90,16 @@ struct MlirXlsToXlsTranslateOptions {
       DieUnlessOk(::xls::GetSchedulingOptionsFlagsProto());
 };
 
-// Translates an operation with XLS dialect to DSLX.
+// Translates an operation with XLS dialect to an XLS package, built directly
+// in memory and optimized if `options.optimize_ir` is set. The package can be
+// handed straight to the optimization and codegen APIs (e.g.
+// ::xls::ScheduleAndCodegenPackage) without printing and reparsing its IR.
+// `options.generate_verilog` is ignored.
+FailureOr<std::unique_ptr<::xls::Package>> MlirXlsToXlsPackage(
+    Operation* op, MlirXlsToXlsTranslateOptions options = {});
+
+// Translates an operation with XLS dialect to XLS IR text, or to Verilog if
+// `options.generate_verilog` is set.
 LogicalResult MlirXlsToXlsTranslate(Operation* op, llvm::raw_ostream& output,
                                     MlirXlsToXlsTranslateOptions options = {});
 
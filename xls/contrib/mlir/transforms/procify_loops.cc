@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "llvm/include/llvm/ADT/DenseSet.h"
+#include "llvm/include/llvm/ADT/SmallVector.h"
 #include "mlir/include/mlir/Dialect/Affine/IR/AffineOps.h"  // IWYU pragma: keep
 #include "mlir/include/mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/include/mlir/Dialect/SCF/Utils/Utils.h"
@@ -45,28 +47,48 @@ class ProcifyLoopsPass : public impl::ProcifyLoopsPassBase<ProcifyLoopsPass> {
   void runOnOperation() override {
     ModuleOp module = getOperation();
     SymbolTable symbolTable(module);
-    // We need to transform in pre-order, but MLIR's walkers require that if we
-    // erase forOp we must interrupt the walk. So we run the walk to fixpoint.
-    bool changed = true;
-    while (changed) {
-      changed = false;
-      module->walk<WalkOrder::PreOrder>([&](scf::ForOp forOp) mutable {
-        changed |= runOnOperation(forOp, symbolTable);
-        return changed ? WalkResult::interrupt() : WalkResult::advance();
-      });
+    DenseSet<Operation*> visited;
+    for (SprocOp sproc : module.getOps<SprocOp>()) {
+      visited.insert(sproc);
     }
+    procifyLoopsIn(module, symbolTable);
+    // Converting a loop moves its body into new sprocs, which may in turn
+    // contain loops to convert. Each sproc is visited once rather than walking
+    // the whole module again after every conversion.
+    SmallVector<SprocOp> newSprocs;
+    do {
+      newSprocs.clear();
+      for (SprocOp sproc : module.getOps<SprocOp>()) {
+        if (visited.insert(sproc).second) {
+          newSprocs.push_back(sproc);
+        }
+      }
+      for (SprocOp sproc : newSprocs) {
+        procifyLoopsIn(sproc, symbolTable);
+      }
+    } while (!newSprocs.empty());
   }
 
-  bool runOnOperation(scf::ForOp forOp, SymbolTable& symbolTable) {
-    if (!shouldTransform(forOp)) {
-      return false;
+  // Converts the outermost loops to transform within `root`, excluding `root`
+  // itself. Loops are converted in pre-order; the loops nested in a loop that
+  // cannot be converted are tried in turn.
+  void procifyLoopsIn(Operation* root, SymbolTable& symbolTable) {
+    SmallVector<scf::ForOp> forOps;
+    root->walk<WalkOrder::PreOrder>([&](scf::ForOp forOp) {
+      if (forOp == root || !shouldTransform(forOp)) {
+        return WalkResult::advance();
+      }
+      forOps.push_back(forOp);
+      return WalkResult::skip();
+    });
+    for (scf::ForOp forOp : forOps) {
+      if (!forOp->getParentOfType<SprocOp>()) {
+        forOp.emitError("procify_loops expected op to have a parent sproc");
+      } else if (succeeded(convertForOpToSprocCall(forOp, symbolTable))) {
+        continue;
+      }
+      procifyLoopsIn(forOp, symbolTable);
     }
-    SprocOp sproc = forOp->getParentOfType<SprocOp>();
-    if (!sproc) {
-      forOp.emitError("procify_loops expected op to have a parent sproc");
-      return false;
-    }
-    return succeeded(convertForOpToSprocCall(forOp, symbolTable));
   }
 
   bool shouldTransform(scf::ForOp forOp) {
@@ -24,6 +24,7 @@
 
 #include "absl/algorithm/container.h"
 #include "llvm/include/llvm/ADT/ArrayRef.h"
+#include "llvm/include/llvm/ADT/DenseSet.h"
 #include "llvm/include/llvm/ADT/STLExtras.h"
 #include "llvm/include/llvm/ADT/SmallVector.h"
 #include "llvm/include/llvm/ADT/StringRef.h"
@@ -42,11 +43,14 @@
 #include "mlir/include/mlir/IR/MLIRContext.h"
 #include "mlir/include/mlir/IR/OpDefinition.h"
 #include "mlir/include/mlir/IR/PatternMatch.h"
+#include "mlir/include/mlir/IR/SymbolTable.h"
+#include "mlir/include/mlir/IR/Threading.h"
 #include "mlir/include/mlir/IR/TypeUtilities.h"
 #include "mlir/include/mlir/IR/ValueRange.h"
 #include "mlir/include/mlir/IR/Visitors.h"
 #include "mlir/include/mlir/Interfaces/ControlFlowInterfaces.h"
 #include "mlir/include/mlir/Pass/Pass.h"  // IWYU pragma: keep
+#include "mlir/include/mlir/Rewrite/FrozenRewritePatternSet.h"
 #include "mlir/include/mlir/Support/LLVM.h"
 #include "mlir/include/mlir/Support/LogicalResult.h"
 #include "mlir/include/mlir/Support/TypeID.h"
@@ -645,7 +649,13 @@ class LegalizeScalarizableOpPattern
 
       SmallVector<Value> newOperands;
       for (Value operand : operands) {
-        if (ArrayType vtype = dyn_cast<ArrayType>(operand.getType())) {
+        if (auto arrayOp = operand.getDefiningOp<ArrayOp>()) {
+          // Take the element straight from the array it was built into, e.g.
+          // by scalarizing the op producing the operand, rather than indexing
+          // the array. Chains of elementwise ops then scalarize into chains of
+          // scalar ops without an array in between.
+          newOperands.push_back(arrayOp.getInputs()[i]);
+        } else if (ArrayType vtype = dyn_cast<ArrayType>(operand.getType())) {
           newOperands.push_back(rewriter.create<ArrayIndexStaticOp>(
               op->getLoc(), vtype.getElementType(), operand,
               rewriter.getI64IntegerAttr(i)));
@@ -784,14 +794,14 @@ LogicalResult convertVectorizedCall(mlir::Operation* op,
 class LegalizeVectorizedCallPattern
     : public OpConversionPattern<VectorizedCallOp> {
  public:
-  using OpConversionPattern::OpConversionPattern;
+  LegalizeVectorizedCallPattern(TypeConverter& tc, mlir::MLIRContext* context,
+                                const SymbolTable& symbolTable)
+      : OpConversionPattern(tc, context), symbolTable(symbolTable) {}
 
   LogicalResult matchAndRewrite(
       VectorizedCallOp op, OpAdaptor adaptor,
       ConversionPatternRewriter& rewriter) const override {
-    auto callee =
-        op->getParentOfType<mlir::ModuleOp>().lookupSymbol<mlir::func::FuncOp>(
-            adaptor.getCallee());
+    auto callee = symbolTable.lookup<mlir::func::FuncOp>(adaptor.getCallee());
     if (!callee) {
       return failure();
     }
@@ -799,6 +809,9 @@ class LegalizeVectorizedCallPattern
     return convertVectorizedCall<func::CallOp>(op, adaptor.getOperands(),
                                                *typeConverter, rewriter);
   }
+
+ private:
+  const SymbolTable& symbolTable;
 };
 
 class LegalizeCallDslxPattern : public OpConversionPattern<CallDslxOp> {
@@ -816,35 +829,34 @@ class LegalizeCallDslxPattern : public OpConversionPattern<CallDslxOp> {
 class ScalarizePass : public impl::ScalarizePassBase<ScalarizePass> {
  public:
   void runOnOperation() override {
+    TensorTypeConverter typeConverter;
+    ConversionTarget chanTarget(getContext());
+    chanTarget.addDynamicallyLegalOp<ChanOp>(
+        [&](ChanOp op) { return typeConverter.isLegal(op.getType()); });
+    RewritePatternSet chanPatterns(&getContext());
+    chanPatterns.add<LegalizeChanOpPattern>(typeConverter, &getContext());
+    FrozenRewritePatternSet frozenChanPatterns(std::move(chanPatterns));
+
+    // Channels are replaced within their parent block, so they are converted
+    // one at a time. Regions are converted in place and independently of one
+    // another, so they are converted in parallel below.
+    SmallVector<XlsRegionOpInterface> regions;
     getOperation()->walk([&](Operation* op) {
       if (auto interface = dyn_cast<XlsRegionOpInterface>(op)) {
         if (interface.isSupportedRegion()) {
-          runOnOperation(interface);
+          regions.push_back(interface);
           return WalkResult::skip();
         }
       } else if (auto chanOp = dyn_cast<ChanOp>(op)) {
-        runOnOperation(chanOp);
+        if (failed(mlir::applyFullConversion(chanOp, chanTarget,
+                                             frozenChanPatterns))) {
+          signalPassFailure();
+        }
         return WalkResult::skip();
       }
       return WalkResult::advance();
     });
-  }
 
-  void runOnOperation(ChanOp operation) {
-    TensorTypeConverter typeConverter;
-    ConversionTarget target(getContext());
-    target.addDynamicallyLegalOp<ChanOp>(
-        [&](ChanOp op) { return typeConverter.isLegal(op.getType()); });
-    RewritePatternSet patterns(&getContext());
-    patterns.add<LegalizeChanOpPattern>(typeConverter, &getContext());
-    if (failed(mlir::applyFullConversion(operation, target,
-                                         std::move(patterns)))) {
-      signalPassFailure();
-    }
-  }
-
-  void runOnOperation(XlsRegionOpInterface operation) {
-    TensorTypeConverter typeConverter;
     ConversionTarget target(getContext());
     // TODO(jpienaar,jmolloy): This target definition seems to broad: it allows
     // to create ops (such as `arith.addi`) that the remainder of the
@@ -859,6 +871,9 @@ class ScalarizePass : public impl::ScalarizePassBase<ScalarizePass> {
     // handle them all for us, but with deep nesting of patterns this seems to
     // be required.
     target.addLegalOp<UnrealizedConversionCastOp>();
+    // Callees are looked up in a symbol table built up front rather than by
+    // walking the module, which other threads are modifying.
+    SymbolTable symbolTable(getOperation());
     RewritePatternSet patterns(&getContext());
     patterns.add<
         // clang-format off
@@ -877,18 +892,44 @@ class ScalarizePass : public impl::ScalarizePassBase<ScalarizePass> {
         LegalizeTensorFromElementsPattern,
         LegalizeTensorInsertSingleSlicePattern,
         LegalizeTensorInsertPattern,
-        LegalizeVectorizedCallPattern,
         ReturnLikeOpPattern
         // clang-format on
         >(typeConverter, &getContext());
-    operation.addSignatureConversionPatterns(patterns, typeConverter, target);
+    patterns.add<LegalizeVectorizedCallPattern>(typeConverter, &getContext(),
+                                                symbolTable);
+    DenseSet<OperationName> seen;
+    for (XlsRegionOpInterface region : regions) {
+      if (seen.insert(region->getName()).second) {
+        region.addSignatureConversionPatterns(patterns, typeConverter, target);
+      }
+    }
     mlir::populateReturnOpTypeConversionPattern(patterns, typeConverter);
     mlir::populateCallOpTypeConversionPattern(patterns, typeConverter);
-    if (failed(mlir::applyFullConversion(operation, target,
-                                         std::move(patterns)))) {
+    FrozenRewritePatternSet frozenPatterns(std::move(patterns));
+
+    if (failed(mlir::failableParallelForEach(
+            &getContext(), regions, [&](XlsRegionOpInterface region) {
+              if (failed(mlir::applyFullConversion(region, target,
+                                                   frozenPatterns))) {
+                return failure();
+              }
+              eraseDeadArrays(region);
+              return success();
+            }))) {
       signalPassFailure();
     }
   }
+
+  // Scalarizing a chain of elementwise ops forwards elements straight from one
+  // op to the next (see LegalizeScalarizableOpPattern), leaving the arrays
+  // built in between unused.
+  static void eraseDeadArrays(XlsRegionOpInterface region) {
+    region->walk([](ArrayOp op) {
+      if (op->use_empty()) {
+        op->erase();
+      }
+    });
+  }
 };
 
 }  // namespace
@@ -54,6 +54,8 @@
 #include "clang/include/clang/Basic/TokenKinds.h"
 #include "clang/include/clang/Frontend/CompilerInstance.h"
 #include "clang/include/clang/Frontend/FrontendAction.h"
+#include "clang/include/clang/Frontend/FrontendActions.h"
+#include "clang/include/clang/Frontend/FrontendOptions.h"
 #include "clang/include/clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/include/clang/Lex/PPCallbacks.h"
 #include "clang/include/clang/Lex/Pragma.h"
@@ -1186,50 +1188,10 @@ absl::StatusOr<const clang::VarDecl*> CCParser::GetXlsccOnReset() const {
   return xlscc_on_reset_;
 }
 
-LibToolThread::LibToolThread(std::string_view source_filename,
-                             std::string_view top_class_name,
-                             absl::Span<std::string_view> command_line_args,
-                             CCParser& parser)
-    : source_filename_(source_filename),
-      top_class_name_(top_class_name),
-      command_line_args_(command_line_args),
-      parser_(parser) {}
-
-void LibToolThread::Start() {
-  thread_.emplace([this] { Run(); });
-}
-
-void LibToolThread::Join() { thread_->Join(); }
-
-void LibToolThread::Run() {
-  std::vector<std::string> argv;
-  argv.emplace_back("binary");
-  argv.emplace_back("/xls_top.cc");
-  for (const auto& view : command_line_args_) {
-    argv.emplace_back(view);
-  }
-  // For xls_top.cc to include the source file
-  argv.emplace_back("-I.");
-  argv.emplace_back("-fsyntax-only");
-  argv.emplace_back("-std=c++17");
-  argv.emplace_back("-nostdinc");
-  argv.emplace_back("-Wno-unused-label");
-  argv.emplace_back("-Wno-constant-logical-operand");
-  argv.emplace_back("-Wno-unused-but-set-variable");
-  argv.emplace_back("-Wno-c++11-narrowing");
-  argv.emplace_back("-Wno-conversion");
-  argv.emplace_back("-Wno-missing-template-arg-list-after-template-kw");
-
-  llvm::IntrusiveRefCntPtr<clang::FileManager> libtool_files;
-
-  std::unique_ptr<LibToolFrontendAction> libtool_action(
-      new LibToolFrontendAction(parser_));
+namespace {
 
-  llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> mem_fs(
-      new llvm::vfs::InMemoryFileSystem);
-  mem_fs->addFile("/xls_builtin.h", 0,
-                  llvm::MemoryBuffer::getMemBuffer(
-                      R"(
+// Declarations of the XLS[cc] builtins, included before the source file.
+constexpr std::string_view kXlsBuiltinHeader = R"(
 #ifndef __XLS_BUILTIN_H
 #define __XLS_BUILTIN_H
 template<int N>
@@ -1298,7 +1260,88 @@ __xls_bits<64> __xlscc_fixed_32_32_bits_for_double(double input);
 __xls_bits<64> __xlscc_fixed_32_32_bits_for_float(float input);
 
 #endif//__XLS_BUILTIN_H
-          )"));
+          )";
+
+// Appends the arguments passed to Clang after the user's.
+void AddClangArgs(std::vector<std::string>& argv) {
+  // For xls_top.cc to include the source file
+  argv.emplace_back("-I.");
+  argv.emplace_back("-fsyntax-only");
+  argv.emplace_back("-std=c++17");
+  argv.emplace_back("-nostdinc");
+  argv.emplace_back("-Wno-unused-label");
+  argv.emplace_back("-Wno-constant-logical-operand");
+  argv.emplace_back("-Wno-unused-but-set-variable");
+  argv.emplace_back("-Wno-c++11-narrowing");
+  argv.emplace_back("-Wno-conversion");
+  argv.emplace_back("-Wno-missing-template-arg-list-after-template-kw");
+}
+
+// Returns a file manager over the real file system, overlaid with
+// /xls_builtin.h and `entry_filename` containing `entry_src`.
+llvm::IntrusiveRefCntPtr<clang::FileManager> CreateFileManager(
+    std::string_view entry_filename, std::string_view entry_src) {
+  llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> mem_fs(
+      new llvm::vfs::InMemoryFileSystem);
+  mem_fs->addFile("/xls_builtin.h", 0,
+                  llvm::MemoryBuffer::getMemBuffer(kXlsBuiltinHeader));
+  mem_fs->addFile(entry_filename, 0,
+                  llvm::MemoryBuffer::getMemBufferCopy(entry_src));
+
+  llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> overlay_fs(
+      new llvm::vfs::OverlayFileSystem(llvm::vfs::getRealFileSystem()));
+
+  overlay_fs->pushOverlay(mem_fs);
+
+  return new clang::FileManager(clang::FileSystemOptions(), overlay_fs);
+}
+
+// Writes the precompiled header to a given path rather than one derived from
+// the name of the in-memory input file.
+class PrecompiledHeaderAction : public clang::GeneratePCHAction {
+ public:
+  explicit PrecompiledHeaderAction(std::string_view output_filename)
+      : output_filename_(output_filename) {}
+
+ protected:
+  bool BeginInvocation(clang::CompilerInstance& CI) override {
+    CI.getFrontendOpts().OutputFile = output_filename_;
+    return clang::GeneratePCHAction::BeginInvocation(CI);
+  }
+
+ private:
+  std::string output_filename_;
+};
+
+}  // namespace
+
+LibToolThread::LibToolThread(std::string_view source_filename,
+                             std::string_view top_class_name,
+                             absl::Span<std::string_view> command_line_args,
+                             CCParser& parser)
+    : source_filename_(source_filename),
+      top_class_name_(top_class_name),
+      command_line_args_(command_line_args),
+      parser_(parser) {}
+
+void LibToolThread::Start() {
+  thread_.emplace([this] { Run(); });
+}
+
+void LibToolThread::Join() { thread_->Join(); }
+
+void LibToolThread::Run() {
+  std::vector<std::string> argv;
+  argv.emplace_back("binary");
+  argv.emplace_back("/xls_top.cc");
+  for (const auto& view : command_line_args_) {
+    argv.emplace_back(view);
+  }
+  AddClangArgs(argv);
+
+  std::unique_ptr<LibToolFrontendAction> libtool_action(
+      new LibToolFrontendAction(parser_));
+
 
   // Inject an instantiation to make Clang parse the constructor bodies
   std::string top_class_inst_injection = top_class_name_.empty()
@@ -1327,15 +1370,8 @@ void __xlscc_top_class_instance_ref2() {
           )",
                       source_filename_, top_class_inst_injection);
 
-  mem_fs->addFile("/xls_top.cc", 0, llvm::MemoryBuffer::getMemBuffer(top_src));
-
-  llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> overlay_fs(
-      new llvm::vfs::OverlayFileSystem(llvm::vfs::getRealFileSystem()));
-
-  overlay_fs->pushOverlay(mem_fs);
-
-  libtool_files =
-      new clang::FileManager(clang::FileSystemOptions(), overlay_fs);
+  llvm::IntrusiveRefCntPtr<clang::FileManager> libtool_files =
+      CreateFileManager("/xls_top.cc", top_src);
 
   std::unique_ptr<clang::tooling::ToolInvocation> libtool_inv(
       new clang::tooling::ToolInvocation(argv, std::move(libtool_action),
@@ -1378,4 +1414,38 @@ absl::StatusOr<const clang::FunctionDecl*> CCParser::GetTopFunction() const {
   return top_function_;
 }
 
+absl::Status GeneratePrecompiledHeader(
+    std::string_view header_filename,
+    absl::Span<std::string_view> command_line_args,
+    std::string_view output_filename) {
+  std::vector<std::string> argv;
+  argv.emplace_back("binary");
+  argv.emplace_back("-x");
+  argv.emplace_back("c++-header");
+  argv.emplace_back("/xls_pch.h");
+  for (const auto& view : command_line_args) {
+    argv.emplace_back(view);
+  }
+  AddClangArgs(argv);
+
+  // Same prefix as xls_top.cc, so that the guards in the precompiled header
+  // skip both includes when scanning the source file.
+  const std::string pch_src = absl::StrFormat(R"(
+#include "/xls_builtin.h"
+#include "%s"
+)",
+                                              header_filename);
+  llvm::IntrusiveRefCntPtr<clang::FileManager> files =
+      CreateFileManager("/xls_pch.h", pch_src);
+
+  clang::tooling::ToolInvocation invocation(
+      argv, std::make_unique<PrecompiledHeaderAction>(output_filename),
+      files.get());
+  if (!invocation.run()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Failed to precompile header %s", header_filename));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace xlscc
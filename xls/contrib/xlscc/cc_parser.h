@@ -151,6 +151,18 @@ class CCParser {
   int next_file_number_ = 1;
 };
 
+// Uses Clang to precompile a header, preceded by the XLS[cc] builtins, into
+//  `output_filename`.
+//
+// Passing "-include-pch <output_filename>" to CCParser::ScanFile() then
+//  avoids reparsing the header, as long as the rest of command_line_args
+//  are the same. Clang rejects the precompiled header if any of the files
+//  it was built from have changed since.
+absl::Status GeneratePrecompiledHeader(
+    std::string_view header_filename,
+    absl::Span<std::string_view> command_line_args,
+    std::string_view output_filename);
+
 }  // namespace xlscc
 
 #endif  // XLS_CONTRIB_XLSCC_PARSE_CPP_H_
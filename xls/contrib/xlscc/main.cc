@@ -39,6 +39,7 @@
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/log_flags.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/contrib/xlscc/cc_parser.h"
 #include "xls/contrib/xlscc/flags.h"
 #include "xls/contrib/xlscc/hls_block.pb.h"
 #include "xls/contrib/xlscc/metadata_output.pb.h"
@@ -84,6 +85,16 @@ ABSL_FLAG(std::vector<std::string>, defines, std::vector<std::string>(),
 ABSL_FLAG(std::vector<std::string>, include_dirs, std::vector<std::string>(),
           "Comma separated list of include directories to pass to clang");
 
+ABSL_FLAG(bool, precompile_header, false,
+          "Instead of generating IR, precompile the input file, a header, "
+          "into a Clang precompiled header at --out. It can then be passed "
+          "to invocations with the same clang arguments via "
+          "--precompiled_header.");
+
+ABSL_FLAG(std::string, precompiled_header, "",
+          "Precompiled header generated by --precompile_header, used instead "
+          "of parsing the header again.");
+
 ABSL_FLAG(std::string, meta_out, "",
           "Path at which to output metadata protobuf");
 
@@ -244,12 +255,37 @@ static absl::Status Run(std::string_view cpp_path) {
     clang_argvs.push_back(absl::StrCat("-I", dir));
   }
 
+  const bool precompile_header = absl::GetFlag(FLAGS_precompile_header);
+  const std::string precompiled_header =
+      absl::GetFlag(FLAGS_precompiled_header);
+  if (!precompiled_header.empty()) {
+    clang_argvs.push_back("-include-pch");
+    clang_argvs.push_back(precompiled_header);
+  }
+  if (precompile_header || !precompiled_header.empty()) {
+    // Hash the inputs of the precompiled header so that it stays valid when
+    // they are only touched, as happens when they are copied into a sandbox.
+    clang_argvs.push_back("-fvalidate-ast-input-files-content");
+  }
+
   std::vector<std::string_view> clang_argv;
   clang_argv.reserve(clang_argvs.size());
   for (const auto& i : clang_argvs) {
     clang_argv.push_back(i);
   }
 
+  if (precompile_header) {
+    const std::string out = absl::GetFlag(FLAGS_out);
+    if (out.empty()) {
+      return absl::InvalidArgumentError(
+          "--precompile_header requires --out to be specified");
+    }
+    std::cerr << "Precompiling header '" << cpp_path << "' with clang..."
+              << '\n';
+    return GeneratePrecompiledHeader(cpp_path, absl::MakeSpan(clang_argv),
+                                     out);
+  }
+
   std::cerr << "Parsing file '" << cpp_path << "' with clang..." << '\n';
   XLS_RETURN_IF_ERROR(translator.ScanFile(
       cpp_path, clang_argv.empty()
@@ -180,6 +180,7 @@ absl::Status Translator::GenerateIR_UnrolledLoop(bool always_first_iter,
     Z3_context ctx_;
     Z3_solver solver_;
   };
+  SolverDeref solver_deref(z3_translator_parent->ctx(), solver);
 
   // Generate the declaration within a private context
   PushContextGuard for_init_guard(*this, loc);
@@ -5507,6 +5507,16 @@ absl::StatusOr<bool> Translator::BitMustBe(bool assert_value, xls::BValue& bval,
 
   XLS_RETURN_IF_ERROR(ShortCircuitBVal(bval, loc));
 
+  // Conditions which are constant after ternary evaluation (e.g., a counter
+  // compared against a bound) are answered without Z3.
+  XLS_ASSIGN_OR_RETURN(xls::TernaryQueryEngine * ternary_query_engine,
+                       GetTernaryQueryEngine(bval.builder()->function()));
+  if (std::optional<xls::Bits> known_value =
+          ternary_query_engine->KnownValueAsBits(bval.node());
+      known_value.has_value()) {
+    return known_value->IsOne() == assert_value;
+  }
+
   XLS_ASSIGN_OR_RETURN(xls::solvers::z3::IrTranslator * z3_translator,
                        GetZ3Translator(bval.builder()->function()));
   XLS_RETURN_IF_ERROR(bval.node()->Accept(z3_translator));
@@ -6166,4 +6176,17 @@ absl::StatusOr<xls::solvers::z3::IrTranslator*> Translator::GetZ3Translator(
   return iter->second.get();
 }
 
+absl::StatusOr<xls::TernaryQueryEngine*> Translator::GetTernaryQueryEngine(
+    xls::FunctionBase* func) {
+  XLS_RET_CHECK(!func->IsBlock());
+  auto [iter, inserted] = ternary_query_engines_.insert({func, nullptr});
+  if (inserted) {
+    iter->second = std::make_unique<xls::TernaryQueryEngine>();
+    XLS_RETURN_IF_ERROR(iter->second->Populate(func).status());
+  } else {
+    XLS_RETURN_IF_ERROR(iter->second->Update(func).status());
+  }
+  return iter->second.get();
+}
+
 }  // namespace xlscc
@@ -67,6 +67,7 @@
 #include "xls/ir/state_element.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/passes/ternary_query_engine.h"
 #include "xls/solvers/z3_ir_translator.h"
 #include "z3/src/api/z3_api.h"
 
@@ -2249,9 +2250,19 @@ class Translator {
   absl::StatusOr<xls::solvers::z3::IrTranslator*> GetZ3Translator(
       xls::FunctionBase* func) ABSL_ATTRIBUTE_LIFETIME_BOUND;
 
+  // Returns a ternary query engine up to date with the nodes of `func`. The
+  // engine is kept across calls and only re-evaluates the nodes added or
+  // changed since the last one, so it is cheap to consult before Z3 on every
+  // iteration of an unrolled loop.
+  absl::StatusOr<xls::TernaryQueryEngine*> GetTernaryQueryEngine(
+      xls::FunctionBase* func) ABSL_ATTRIBUTE_LIFETIME_BOUND;
+
   absl::flat_hash_map<xls::FunctionBase*,
                       std::unique_ptr<xls::solvers::z3::IrTranslator>>
       z3_translators_;
+  absl::flat_hash_map<xls::FunctionBase*,
+                      std::unique_ptr<xls::TernaryQueryEngine>>
+      ternary_query_engines_;
 };
 
 }  // namespace xlscc
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -24,6 +25,8 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "clang/include/clang/AST/Attr.h"
 #include "clang/include/clang/AST/AttrIterator.h"
 #include "clang/include/clang/AST/Attrs.inc"
@@ -32,6 +35,7 @@
 #include "clang/include/clang/AST/Stmt.h"
 #include "clang/include/clang/Basic/LLVM.h"
 #include "llvm/include/llvm/Support/Casting.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/status/matchers.h"
 #include "xls/contrib/xlscc/metadata_output.pb.h"
 #include "xls/contrib/xlscc/unit_tests/unit_test.h"
@@ -323,6 +327,44 @@ TEST_F(CCParserTest, SourceMeta) {
             static_cast<int32_t>(output.sources(0).number()));
 }
 
+TEST_F(CCParserTest, PrecompiledHeader) {
+  const std::string header_src = R"(
+    #ifndef PRECOMPILED_H
+    #define PRECOMPILED_H
+    struct Pair {
+      int a;
+      int b;
+    };
+    #endif
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(
+      xls::TempFile header, xls::TempFile::CreateWithContent(header_src, ".h"));
+  XLS_ASSERT_OK_AND_ASSIGN(xls::TempFile pch, xls::TempFile::Create(".pch"));
+  const std::string header_path = header.path().string();
+  const std::string pch_path = pch.path().string();
+
+  std::vector<std::string_view> argv = {"-Werror", "-Wall",
+                                        "-Wno-unknown-pragmas"};
+  XLS_ASSERT_OK(xlscc::GeneratePrecompiledHeader(
+      header_path, absl::MakeSpan(argv), pch_path));
+
+  const std::string cpp_src = absl::StrFormat(R"(
+    #include "%s"
+    #pragma hls_top
+    int foo(Pair p) {
+      return p.a + p.b;
+    }
+  )",
+                                              header_path);
+
+  xlscc::CCParser parser;
+  XLS_ASSERT_OK(ScanTempFileWithContent(cpp_src, {"-include-pch", pch_path},
+                                        &parser));
+  XLS_ASSERT_OK_AND_ASSIGN(const auto* top_ptr, parser.GetTopFunction());
+  ASSERT_NE(top_ptr, nullptr);
+  EXPECT_EQ(top_ptr->getNameAsString(), "foo");
+}
+
 TEST_F(CCParserTest, Pragma) {
   xlscc::CCParser parser;
 
@@ -15,13 +15,16 @@
 #include "xls/data_structures/binary_decision_diagram.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
@@ -30,14 +33,14 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/span.h"
 
 namespace xls {
 
-BinaryDecisionDiagram::BinaryDecisionDiagram() {
-  // Leaf node 0.
-  nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
-                           /*p=*/1));
-  // Leaf node 1.
+BinaryDecisionDiagram::BinaryDecisionDiagram()
+    : computed_table_(kMinComputedTableSize,
+                      ComputedEntry{.result = BddNodeIndex(-1)}) {
+  // The leaf node one. Zero is its complement.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
 }
@@ -45,58 +48,116 @@ BinaryDecisionDiagram::BinaryDecisionDiagram() {
 BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
                                                     BddNodeIndex high,
                                                     BddNodeIndex low) {
+  if (low == high) {
+    return low;
+  }
+  // Keep the high child regular by complementing the node instead.
+  bool complemented = IsComplemented(high);
+  high = Complement(high, complemented);
+  low = Complement(low, complemented);
+
   NodeKey key = std::make_tuple(var, high, low);
   auto it = node_map_.find(key);
   if (it != node_map_.end()) {
-    return it->second;
-  }
-  if (low == high) {
-    return low;
+    return Complement(it->second, complemented);
   }
   // Compute the number of paths that the new node will have to the terminal
   // nodes 0 and 1. Use int64s to avoid overflowing and saturate at INT32_MAX.
   int32_t paths = std::min(
       static_cast<int64_t>(GetNode(low).path_count) + GetNode(high).path_count,
       static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
-  nodes_.emplace_back(var, high, low, paths);
-  BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
+  int32_t position;
+  if (free_nodes_.empty()) {
+    position = nodes_.size();
+    nodes_.emplace_back(var, high, low, paths);
+  } else {
+    position = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[position] = BddNode(var, high, low, paths);
+  }
+  BddNodeIndex node_index = BddNodeIndex(position << 1);
   node_map_[key] = node_index;
-  return node_index;
+  MaybeGrowComputedTable();
+  return Complement(node_index, complemented);
 }
 
 BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
                                              bool value) {
-  if (expr == zero() || expr == one()) {
+  if (IsLeaf(expr)) {
     return expr;
   }
 
   const BddNode& node = GetNode(expr);
   CHECK_LE(var, node.variable);
   if (node.variable == var) {
-    return value ? node.high : node.low;
+    return value ? High(expr) : Low(expr);
   }
   return expr;
 }
 
+BinaryDecisionDiagram::ComputedEntry& BinaryDecisionDiagram::GetComputedEntry(
+    BddNodeIndex cond, BddNodeIndex if_true, BddNodeIndex if_false) {
+  size_t hash = absl::HashOf(cond.value(), if_true.value(), if_false.value());
+  return computed_table_[hash & (computed_table_.size() - 1)];
+}
+
+void BinaryDecisionDiagram::MaybeGrowComputedTable() {
+  if (size() <= computed_table_.size() ||
+      computed_table_.size() >= kMaxComputedTableSize) {
+    return;
+  }
+  std::vector<ComputedEntry> old_table = std::move(computed_table_);
+  computed_table_ = std::vector<ComputedEntry>(
+      2 * old_table.size(), ComputedEntry{.result = BddNodeIndex(-1)});
+  for (const ComputedEntry& entry : old_table) {
+    if (entry.result >= BddNodeIndex(0)) {
+      GetComputedEntry(entry.cond, entry.if_true, entry.if_false) = entry;
+    }
+  }
+}
+
 BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
                                                BddNodeIndex if_true,
                                                BddNodeIndex if_false) {
+  // Normalize the expression so equivalent forms share a computed table
+  // entry: the condition is regular, operands equal to the condition (or its
+  // inverse) are replaced by leaves, and the if-true operand is regular.
+  if (IsComplemented(cond)) {
+    cond = Not(cond);
+    std::swap(if_true, if_false);
+  }
   if (cond == one()) {
     return if_true;
   }
-  if (cond == zero()) {
-    return if_false;
+  if (if_true == cond) {
+    if_true = one();
+  } else if (if_true == Not(cond)) {
+    if_true = zero();
   }
-  if (if_true == one() && if_false == zero()) {
-    return cond;
+  if (if_false == cond) {
+    if_false = zero();
+  } else if (if_false == Not(cond)) {
+    if_false = one();
   }
   if (if_true == if_false) {
     return if_true;
   }
-  auto key = std::make_tuple(cond, if_true, if_false);
-  auto it = ite_map_.find(key);
-  if (it != ite_map_.end()) {
-    return it->second;
+  if (if_true == one() && if_false == zero()) {
+    return cond;
+  }
+  if (if_true == zero() && if_false == one()) {
+    return Not(cond);
+  }
+  bool complemented = IsComplemented(if_true);
+  if_true = Complement(if_true, complemented);
+  if_false = Complement(if_false, complemented);
+
+  {
+    const ComputedEntry& entry = GetComputedEntry(cond, if_true, if_false);
+    if (entry.result >= BddNodeIndex(0) && entry.cond == cond &&
+        entry.if_true == if_true && entry.if_false == if_false) {
+      return Complement(entry.result, complemented);
+    }
   }
 
   // The expression is non-trivial and has not been computed before. Recursively
@@ -107,10 +168,10 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   // through the BDD the variable indices are strictly increasing.
   BddVariable min_var = GetNode(cond).variable;
   // Only non-leaf nodes (not zero or one) have associated variables.
-  if (if_true != zero() && if_true != one()) {
+  if (!IsLeaf(if_true)) {
     min_var = std::min(min_var, GetNode(if_true).variable);
   }
-  if (if_false != zero() && if_false != one()) {
+  if (!IsLeaf(if_false)) {
     min_var = std::min(min_var, GetNode(if_false).variable);
   }
 
@@ -126,23 +187,73 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
                                            Restrict(if_true, min_var, false),
                                            Restrict(if_false, min_var, false));
 
-  if (true_cofactor == false_cofactor) {
-    ite_map_[key] = true_cofactor;
-    return true_cofactor;
-  }
   BddNodeIndex expr = GetOrCreateNode(min_var, true_cofactor, false_cofactor);
-  ite_map_[key] = expr;
-  return expr;
+  // The recursive calls may have grown the table, so look up the entry again.
+  GetComputedEntry(cond, if_true, if_false) =
+      ComputedEntry{.cond = cond,
+                    .if_true = if_true,
+                    .if_false = if_false,
+                    .result = expr};
+  return Complement(expr, complemented);
 }
 
 BddNodeIndex BinaryDecisionDiagram::NewVariable() {
   BddVariable var = next_var_;
   ++next_var_;
-  return GetOrCreateNode(var, one(), zero());
+  BddNodeIndex node = GetOrCreateNode(var, one(), zero());
+  variable_base_nodes_.push_back(node);
+  return node;
 }
 
 BddNodeIndex BinaryDecisionDiagram::Not(BddNodeIndex expr) {
-  return IfThenElse(expr, zero(), one());
+  return Complement(expr, true);
+}
+
+void BinaryDecisionDiagram::GarbageCollect(
+    absl::Span<const BddNodeIndex> roots) {
+  // Mark every node reachable from the roots or from a variable.
+  std::vector<bool> live(nodes_.size(), false);
+  live[0] = true;
+  std::vector<BddNodeIndex> worklist(roots.begin(), roots.end());
+  worklist.insert(worklist.end(), variable_base_nodes_.begin(),
+                  variable_base_nodes_.end());
+  while (!worklist.empty()) {
+    int32_t position = worklist.back().value() >> 1;
+    worklist.pop_back();
+    if (live[position]) {
+      continue;
+    }
+    live[position] = true;
+    worklist.push_back(nodes_[position].high);
+    worklist.push_back(nodes_[position].low);
+  }
+
+  // Sweep the unmarked nodes. Reclaimed nodes are marked with a negative
+  // variable so they are not reclaimed twice.
+  int64_t reclaimed = 0;
+  for (int32_t position = 1; position < nodes_.size(); ++position) {
+    BddNode& node = nodes_[position];
+    if (live[position] || node.variable < BddVariable(0)) {
+      continue;
+    }
+    node_map_.erase(std::make_tuple(node.variable, node.high, node.low));
+    node = BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
+                   /*p=*/0);
+    free_nodes_.push_back(position);
+    ++reclaimed;
+  }
+
+  // Drop the computed expressions which refer to reclaimed nodes.
+  auto is_live = [&](BddNodeIndex expr) { return live[expr.value() >> 1]; };
+  for (ComputedEntry& entry : computed_table_) {
+    if (entry.result >= BddNodeIndex(0) &&
+        !(is_live(entry.cond) && is_live(entry.if_true) &&
+          is_live(entry.if_false) && is_live(entry.result))) {
+      entry.result = BddNodeIndex(-1);
+    }
+  }
+  VLOG(3) << absl::StreamFormat("BDD garbage collection reclaimed %d nodes",
+                                reclaimed);
 }
 
 BddNodeIndex BinaryDecisionDiagram::Or(BddNodeIndex a, BddNodeIndex b) {
@@ -171,15 +282,14 @@ absl::StatusOr<bool> BinaryDecisionDiagram::Evaluate(
               << variable_values.at(node);
     }
   }
-  while (result != zero() && result != one()) {
+  while (!IsLeaf(result)) {
     BddNodeIndex var_node = GetVariableBaseNode(GetNode(result).variable);
     if (!variable_values.contains(var_node)) {
       return absl::InvalidArgumentError(
           absl::StrFormat("Missing value for BDD variable %d (node index %d)",
                           GetNode(result).variable.value(), var_node.value()));
     }
-    result = variable_values.at(var_node) ? GetNode(result).high
-                                          : GetNode(result).low;
+    result = variable_values.at(var_node) ? High(result) : Low(result);
   }
   VLOG(2) << "  result = " << (result == one() ? true : false);
   return result == one();
@@ -212,9 +322,9 @@ void BinaryDecisionDiagram::ToStringDnfHelper(BddNodeIndex expr,
 
   const BddNode& node = GetNode(expr);
   terms->push_back(absl::StrCat("x", node.variable.value()));
-  ToStringDnfHelper(node.high, minterms_to_emit, terms, str);
+  ToStringDnfHelper(High(expr), minterms_to_emit, terms, str);
   terms->back() = absl::StrCat("!x", node.variable.value());
-  ToStringDnfHelper(node.low, minterms_to_emit, terms, str);
+  ToStringDnfHelper(Low(expr), minterms_to_emit, terms, str);
   terms->pop_back();
 }
 
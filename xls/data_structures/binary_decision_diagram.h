@@ -22,6 +22,7 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/strong_int.h"
 
 namespace xls {
@@ -34,6 +35,13 @@ namespace xls {
 //   K.S. Brace, R.L. Rudell, and R.E. Bryant,
 //   "Efficient Implementation of a BDD package"
 //   https://ieeexplore.ieee.org/document/114826
+//
+// Edges are complemented: the low bit of a BddNodeIndex indicates that the
+// expression is the inverse of the node it refers to, so Not is free and an
+// expression and its inverse share all of their nodes. Nodes which are no
+// longer reachable from any expression of interest may be reclaimed with
+// GarbageCollect, and the table memoizing if-then-else computations is of
+// bounded size.
 
 // For efficiency variables and nodes are referred to by indices into vector
 // data members in the BDD.
@@ -42,7 +50,7 @@ XLS_DEFINE_STRONG_INT_TYPE(BddNodeIndex, int32_t);
 
 // A node in the BDD. The node is associated with a single variable and has
 // children corresponding to when the variable is true (high) and when it is
-// false (low).
+// false (low). The high child is never a complemented edge.
 struct BddNode {
   BddNode() : variable(0), high(0), low(0), path_count(0) {}
   BddNode(BddVariable v, BddNodeIndex h, BddNodeIndex l, int32_t p)
@@ -76,8 +84,8 @@ class BinaryDecisionDiagram {
   BddNodeIndex Or(BddNodeIndex a, BddNodeIndex b);
 
   // Returns the leaf node corresponding to zero or one.
-  BddNodeIndex zero() const { return BddNodeIndex(0); }
-  BddNodeIndex one() const { return BddNodeIndex(1); }
+  BddNodeIndex zero() const { return BddNodeIndex(1); }
+  BddNodeIndex one() const { return BddNodeIndex(0); }
 
   // Evaluates the given expression with the given variable values. The keys in
   // the map are the *node* indices of the respective variable (value returned
@@ -87,13 +95,31 @@ class BinaryDecisionDiagram {
       BddNodeIndex expr,
       const absl::flat_hash_map<BddNodeIndex, bool>& variable_values) const;
 
-  // Returns the BDD node with the given index.
+  // Returns the BDD node the given expression refers to. If `node_index` is a
+  // complemented edge the children of the returned node are those of the
+  // inverse of the expression; use High and Low to get the cofactors of the
+  // expression itself.
   const BddNode& GetNode(BddNodeIndex node_index) const {
-    return nodes_.at(node_index.value());
+    return nodes_.at(node_index.value() >> 1);
+  }
+
+  // Returns the expression with the variable of `expr` set to true (high) or
+  // false (low). `expr` must not be a leaf.
+  BddNodeIndex High(BddNodeIndex expr) const {
+    return Complement(GetNode(expr).high, IsComplemented(expr));
+  }
+  BddNodeIndex Low(BddNodeIndex expr) const {
+    return Complement(GetNode(expr).low, IsComplemented(expr));
   }
 
-  // Returns the number of nodes in the graph.
-  int64_t size() const { return nodes_.size(); }
+  // Returns the number of live nodes in the graph.
+  int64_t size() const { return nodes_.size() - free_nodes_.size(); }
+
+  // Reclaims every node which is not reachable from one of `roots` or from the
+  // node of a variable. Indices of the reclaimed nodes may be reused by later
+  // operations, so any expression not reachable from `roots` must not be used
+  // after this call.
+  void GarbageCollect(absl::Span<const BddNodeIndex> roots);
 
   // Returns the number of variables in the graph.
   int64_t variable_count() const { return next_var_.value(); }
@@ -112,7 +138,7 @@ class BinaryDecisionDiagram {
   // variable. The expression of a base node is exactly equal to the value of
   // the variable.
   bool IsVariableBaseNode(BddNodeIndex expr) const {
-    return GetNode(expr).high == one() && GetNode(expr).low == zero();
+    return !IsLeaf(expr) && High(expr) == one() && Low(expr) == zero();
   }
 
   // Returns the node corresponding to the given if-then-else expression.
@@ -125,6 +151,31 @@ class BinaryDecisionDiagram {
                          std::vector<std::string>* terms,
                          std::string* str) const;
 
+  // An entry in the table of computed if-then-else expressions.
+  struct ComputedEntry {
+    BddNodeIndex cond;
+    BddNodeIndex if_true;
+    BddNodeIndex if_false;
+    BddNodeIndex result;
+  };
+
+  // The computed table starts at this many entries and grows with the number
+  // of live nodes up to kMaxComputedTableSize entries. Entries are overwritten
+  // on collision. Both are powers of two.
+  static constexpr int64_t kMinComputedTableSize = 1 << 10;
+  static constexpr int64_t kMaxComputedTableSize = 1 << 20;
+
+  static bool IsComplemented(BddNodeIndex expr) {
+    return (expr.value() & 1) != 0;
+  }
+  static BddNodeIndex Regular(BddNodeIndex expr) {
+    return BddNodeIndex(expr.value() & ~1);
+  }
+  static BddNodeIndex Complement(BddNodeIndex expr, bool complement) {
+    return BddNodeIndex(expr.value() ^ static_cast<int32_t>(complement));
+  }
+  bool IsLeaf(BddNodeIndex expr) const { return Regular(expr) == one(); }
+
   // Get the node corresponding to the given variable with the given low/high
   // children. Creates it if it does not exist.
   BddNodeIndex GetOrCreateNode(BddVariable var, BddNodeIndex high,
@@ -136,27 +187,42 @@ class BinaryDecisionDiagram {
 
   // Returns the node corresponding to the value of the given variable.
   BddNodeIndex GetVariableBaseNode(BddVariable variable) const {
-    return node_map_.at({variable, one(), zero()});
+    return variable_base_nodes_.at(variable.value());
   }
 
+  ComputedEntry& GetComputedEntry(BddNodeIndex cond, BddNodeIndex if_true,
+                                  BddNodeIndex if_false);
+
+  // Doubles the size of the computed table if the number of live nodes has
+  // outgrown it, keeping the entries which still fit.
+  void MaybeGrowComputedTable();
+
   // The numeric id to use for the next created variable. Increments with each
   // call to NewVariable which
   BddVariable next_var_ = BddVariable(0);
 
-  // The vector of all the nodes in the BDD.
+  // The vector of all the nodes in the BDD. Node i is referred to by the
+  // indices 2*i (the node's expression) and 2*i+1 (its inverse). Node 0 is the
+  // leaf one.
   std::vector<BddNode> nodes_;
 
+  // Positions in `nodes_` which were reclaimed by GarbageCollect and may be
+  // reused for new nodes.
+  std::vector<int32_t> free_nodes_;
+
+  // The node corresponding to the value of each variable, indexed by variable.
+  std::vector<BddNodeIndex> variable_base_nodes_;
+
   // A map from BDD node content (variable id, high child, low child) to the
   // index of the respective node. This map is used to ensure that no duplicate
   // nodes are created.
   using NodeKey = std::tuple<BddVariable, BddNodeIndex, BddNodeIndex>;
   absl::flat_hash_map<NodeKey, BddNodeIndex> node_map_;
 
-  // A map from if-then-else expression to the node corresponding to that
-  // expression. The key elements are (condition, if-true, if-false). This map
-  // enables fast lookup for expressions.
-  using IteKey = std::tuple<BddNodeIndex, BddNodeIndex, BddNodeIndex>;
-  absl::flat_hash_map<IteKey, BddNodeIndex> ite_map_;
+  // A lossy direct-mapped cache from if-then-else expression (condition,
+  // if-true, if-false) to the node corresponding to that expression. Unused
+  // entries have a negative result.
+  std::vector<ComputedEntry> computed_table_;
 };
 
 }  // namespace xls
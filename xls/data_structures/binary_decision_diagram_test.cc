@@ -314,5 +314,55 @@ TEST(BinaryDecisionDiagramTest, ThreeVariableExhaustive) {
   }
 }
 
+TEST(BinaryDecisionDiagramTest, NotSharesNodes) {
+  BinaryDecisionDiagram bdd;
+  BddNodeIndex x0 = bdd.NewVariable();
+  BddNodeIndex x1 = bdd.NewVariable();
+  BddNodeIndex x0_and_x1 = bdd.And(x0, x1);
+
+  int64_t before_size = bdd.size();
+  BddNodeIndex nand = bdd.Not(x0_and_x1);
+  EXPECT_EQ(bdd.size(), before_size);
+  EXPECT_EQ(bdd.Not(nand), x0_and_x1);
+  EXPECT_EQ(bdd.Or(bdd.Not(x0), bdd.Not(x1)), nand);
+  EXPECT_EQ(bdd.size(), before_size);
+  EXPECT_EQ(bdd.Not(bdd.zero()), bdd.one());
+  EXPECT_FALSE(bdd.IsVariableBaseNode(bdd.Not(x0)));
+}
+
+TEST(BinaryDecisionDiagramTest, GarbageCollect) {
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> vars;
+  for (int64_t i = 0; i < 8; ++i) {
+    vars.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex kept = bdd.And(vars[0], bdd.Or(vars[1], vars[2]));
+  std::string kept_dnf = bdd.ToStringDnf(kept);
+
+  // Build a large expression and discard it.
+  BddNodeIndex garbage = bdd.zero();
+  for (int64_t i = 0; i < 8; ++i) {
+    garbage = bdd.Or(bdd.And(garbage, bdd.Not(vars[i])),
+                     bdd.And(bdd.Not(garbage), vars[i]));
+  }
+  int64_t size_with_garbage = bdd.size();
+
+  bdd.GarbageCollect({kept});
+  EXPECT_LT(bdd.size(), size_with_garbage);
+  EXPECT_EQ(bdd.ToStringDnf(kept), kept_dnf);
+  EXPECT_EQ(bdd.And(vars[0], bdd.Or(vars[1], vars[2])), kept);
+  EXPECT_THAT(bdd.Evaluate(vars[3], {{vars[3], true}}), IsOkAndHolds(true));
+
+  // Reclaimed nodes are reused and rebuilt expressions are still correct.
+  int64_t size_after_collection = bdd.size();
+  BddNodeIndex x0_xor_x1 = bdd.Or(bdd.And(vars[0], bdd.Not(vars[1])),
+                                  bdd.And(bdd.Not(vars[0]), vars[1]));
+  EXPECT_GT(bdd.size(), size_after_collection);
+  EXPECT_THAT(bdd.Evaluate(x0_xor_x1, {{vars[0], true}, {vars[1], false}}),
+              IsOkAndHolds(true));
+  EXPECT_THAT(bdd.Evaluate(x0_xor_x1, {{vars[0], true}, {vars[1], true}}),
+              IsOkAndHolds(false));
+}
+
 }  // namespace
 }  // namespace xls
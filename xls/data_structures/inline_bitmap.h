@@ -31,7 +31,9 @@
 
 namespace xls {
 
-// A bitmap that has 64-bits of inline storage by default.
+// A bitmap that has 128-bits of inline storage by default. 128-bit values are
+// common enough in hardware designs that spilling them to the heap shows up in
+// every operation producing one.
 class InlineBitmap {
  public:
   // Constructs an InlineBitmap of width `bit_count` using the bits in
@@ -215,6 +217,45 @@ class InlineBitmap {
     data_[wordno] = value & MaskForWord(wordno);
   }
 
+  // Returns the `width` bits (at most 64) starting at bit `index` as the low
+  // bits of a word. The bits must lie within the bitmap.
+  uint64_t GetBits(int64_t index, int64_t width) const {
+    DCHECK_GE(index, 0);
+    DCHECK_LE(width, kWordBits);
+    DCHECK_LE(index + width, bit_count());
+    if (width == 0) {
+      return 0;
+    }
+    int64_t wordno = index / kWordBits;
+    int64_t bitno = index % kWordBits;
+    uint64_t result = data_[wordno] >> bitno;
+    if (bitno != 0 && bitno + width > kWordBits) {
+      result |= data_[wordno + 1] << (kWordBits - bitno);
+    }
+    return result & Mask(width);
+  }
+
+  // Copies `count` bits of `other` starting at bit `read_offset` into this
+  // bitmap starting at bit `write_offset`. Other bits are left unchanged. The
+  // copy proceeds a word at a time rather than bit by bit.
+  void Overwrite(const InlineBitmap& other, int64_t count,
+                 int64_t write_offset = 0, int64_t read_offset = 0) {
+    DCHECK_GE(count, 0);
+    DCHECK_LE(write_offset + count, bit_count());
+    DCHECK_LE(read_offset + count, other.bit_count());
+    int64_t copied = 0;
+    while (copied < count) {
+      int64_t index = write_offset + copied;
+      int64_t wordno = index / kWordBits;
+      int64_t bitno = index % kWordBits;
+      int64_t chunk = std::min(kWordBits - bitno, count - copied);
+      uint64_t mask = Mask(chunk) << bitno;
+      uint64_t bits = other.GetBits(read_offset + copied, chunk) << bitno;
+      data_[wordno] = (data_[wordno] & ~mask) | bits;
+      copied += chunk;
+    }
+  }
+
   // Sets a byte in the data underlying the bitmap.
   //
   // Setting byte i as {b_7, b_6, b_5, ..., b_0} sets the bit at i*8 to b_0, the
@@ -335,8 +376,11 @@ class InlineBitmap {
                                                            : Mask(remainder);
   }
 
+  // Number of words stored without a heap allocation.
+  static constexpr int64_t kInlineWordCount = 2;
+
   int64_t bit_count_;
-  absl::InlinedVector<uint64_t, 1> data_;
+  absl::InlinedVector<uint64_t, kInlineWordCount> data_;
 };
 
 }  // namespace xls
@@ -552,6 +552,40 @@ TEST(InlineBitmapTest, WithSize) {
   }
 }
 
+TEST(InlineBitmapTest, GetBits) {
+  auto b = InlineBitmap::FromBytes(
+      72, {0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xa5});
+  EXPECT_EQ(b.GetBits(0, 0), 0);
+  EXPECT_EQ(b.GetBits(0, 8), 0x01);
+  EXPECT_EQ(b.GetBits(4, 8), 0x30);
+  EXPECT_EQ(b.GetBits(0, 64), 0xefcdab8967452301);
+  EXPECT_EQ(b.GetBits(8, 64), 0xa5efcdab89674523);
+  EXPECT_EQ(b.GetBits(60, 12), 0xa5e);
+}
+
+TEST(InlineBitmapTest, Overwrite) {
+  // Copy every aligned and unaligned window of a wide source.
+  InlineBitmap source(200);
+  for (int64_t i = 0; i < source.bit_count(); i += 3) {
+    source.Set(i);
+  }
+  for (int64_t read_offset : {0, 1, 63, 64, 65}) {
+    for (int64_t write_offset : {0, 5, 64, 70}) {
+      InlineBitmap b(250, /*fill=*/true);
+      int64_t count = 130;
+      b.Overwrite(source, count, write_offset, read_offset);
+      for (int64_t i = 0; i < b.bit_count(); ++i) {
+        bool expected = (i >= write_offset && i < write_offset + count)
+                            ? source.Get(i - write_offset + read_offset)
+                            : true;
+        EXPECT_EQ(b.Get(i), expected)
+            << "bit " << i << " read_offset " << read_offset
+            << " write_offset " << write_offset;
+      }
+    }
+  }
+}
+
 }  // namespace
 
 // Note: tests below this point are friended, so cannot live in the anonymous
@@ -0,0 +1,139 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DATA_STRUCTURES_LEAF_TYPE_TREE_ARENA_H_
+#define XLS_DATA_STRUCTURES_LEAF_TYPE_TREE_ARENA_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "xls/data_structures/leaf_type_tree.h"
+#include "xls/ir/type.h"
+
+namespace xls {
+
+// Storage for the leaves of many LeafTypeTrees packed into a few large
+// contiguous blocks. Trees are allocated in the arena and handed out as
+// MutableLeafTypeTreeViews which remain valid until the arena is cleared or
+// destroyed (moving the arena keeps them valid). This avoids the separate
+// allocations of a LeafTypeTree per value when an analysis keeps a tree for
+// every node of a function.
+//
+// Individual trees cannot be freed; a tree which is replaced by one of the
+// same type should be overwritten in place through its view instead of being
+// allocated again.
+template <typename T>
+class LeafTypeTreeArena {
+ public:
+  // Number of leaves in each block. Trees with more leaves get a block of their
+  // own.
+  static constexpr int64_t kDefaultBlockSize = 4096;
+
+  explicit LeafTypeTreeArena(int64_t block_size = kDefaultBlockSize)
+      : block_size_(block_size) {
+    CHECK_GT(block_size, 0);
+  }
+
+  LeafTypeTreeArena(const LeafTypeTreeArena<T>& other) = delete;
+  LeafTypeTreeArena& operator=(const LeafTypeTreeArena<T>& other) = delete;
+  LeafTypeTreeArena(LeafTypeTreeArena<T>&& other) = default;
+  LeafTypeTreeArena& operator=(LeafTypeTreeArena<T>&& other) = default;
+
+  // Allocates a tree of the given type in which each leaf is default
+  // constructed.
+  MutableLeafTypeTreeView<T> Allocate(Type* type) {
+    absl::InlinedVector<Type*, 1> leaf_types =
+        leaf_type_tree_internal::GetLeafTypes(type);
+    Block& block = GetBlock(leaf_types.size());
+    for (Type* leaf_type : leaf_types) {
+      block.elements.emplace_back();
+      block.leaf_types.push_back(leaf_type);
+    }
+    return MakeView(block, type, leaf_types.size());
+  }
+
+  // Allocates a copy of `tree`.
+  MutableLeafTypeTreeView<T> Allocate(LeafTypeTreeView<T> tree) {
+    Block& block = GetBlock(tree.size());
+    block.elements.insert(block.elements.end(), tree.elements().begin(),
+                          tree.elements().end());
+    block.leaf_types.insert(block.leaf_types.end(), tree.leaf_types().begin(),
+                            tree.leaf_types().end());
+    return MakeView(block, tree.type(), tree.size());
+  }
+
+  // Allocates a tree holding the leaves moved out of `tree`.
+  MutableLeafTypeTreeView<T> Allocate(LeafTypeTree<T>&& tree) {
+    Block& block = GetBlock(tree.size());
+    for (T& element : tree.elements()) {
+      block.elements.push_back(std::move(element));
+    }
+    block.leaf_types.insert(block.leaf_types.end(), tree.leaf_types().begin(),
+                            tree.leaf_types().end());
+    return MakeView(block, tree.type(), tree.size());
+  }
+
+  // Destroys every tree in the arena, invalidating all views.
+  void Clear() {
+    blocks_.clear();
+    leaf_count_ = 0;
+  }
+
+  // Returns the number of leaves allocated in the arena.
+  int64_t leaf_count() const { return leaf_count_; }
+
+ private:
+  struct Block {
+    // Never grown past their reserved capacity so views stay valid.
+    std::vector<T> elements;
+    std::vector<Type*> leaf_types;
+  };
+
+  // Returns a block with room for `size` more leaves.
+  Block& GetBlock(int64_t size) {
+    leaf_count_ += size;
+    if (blocks_.empty() ||
+        static_cast<int64_t>(blocks_.back().elements.capacity() -
+                             blocks_.back().elements.size()) < size) {
+      Block& block = blocks_.emplace_back();
+      int64_t capacity = std::max(size, block_size_);
+      block.elements.reserve(capacity);
+      block.leaf_types.reserve(capacity);
+      return block;
+    }
+    return blocks_.back();
+  }
+
+  // Returns a view of the last `size` leaves of `block`.
+  static MutableLeafTypeTreeView<T> MakeView(Block& block, Type* type,
+                                             int64_t size) {
+    return MutableLeafTypeTreeView<T>(
+        type, absl::MakeSpan(block.elements).last(size),
+        absl::MakeConstSpan(block.leaf_types).last(size));
+  }
+
+  int64_t block_size_;
+  int64_t leaf_count_ = 0;
+  // Moving the vectors of a block when this one grows keeps their buffers.
+  std::vector<Block> blocks_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_DATA_STRUCTURES_LEAF_TYPE_TREE_ARENA_H_
@@ -0,0 +1,83 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/data_structures/leaf_type_tree_arena.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/data_structures/leaf_type_tree.h"
+#include "xls/ir/package.h"
+#include "xls/ir/type.h"
+
+namespace xls {
+namespace {
+
+using ::testing::ElementsAre;
+
+class LeafTypeTreeArenaTest : public ::testing::Test {
+ protected:
+  LeafTypeTreeArenaTest() : package_("LeafTypeTreeArenaTest") {}
+
+  Package package_;
+};
+
+TEST_F(LeafTypeTreeArenaTest, AllocatesTrees) {
+  Type* u32 = package_.GetBitsType(32);
+  Type* tuple = package_.GetTupleType({u32, package_.GetArrayType(2, u32)});
+  LeafTypeTreeArena<std::string> arena;
+
+  MutableLeafTypeTreeView<std::string> a = arena.Allocate(tuple);
+  EXPECT_EQ(a.type(), tuple);
+  EXPECT_THAT(a.elements(), ElementsAre("", "", ""));
+  a.Set({1, 0}, "x");
+
+  LeafTypeTree<std::string> tree(u32, "y");
+  MutableLeafTypeTreeView<std::string> b = arena.Allocate(tree.AsView());
+  MutableLeafTypeTreeView<std::string> c =
+      arena.Allocate(LeafTypeTree<std::string>(tuple, "z"));
+  EXPECT_EQ(b.AsView(), tree.AsView());
+  EXPECT_THAT(c.elements(), ElementsAre("z", "z", "z"));
+  EXPECT_THAT(c.leaf_types(), ElementsAre(u32, u32, u32));
+  EXPECT_THAT(a.elements(), ElementsAre("", "x", ""));
+  EXPECT_EQ(arena.leaf_count(), 7);
+
+  arena.Clear();
+  EXPECT_EQ(arena.leaf_count(), 0);
+}
+
+TEST_F(LeafTypeTreeArenaTest, ViewsSurviveNewBlocks) {
+  Type* u8 = package_.GetBitsType(8);
+  Type* wide = package_.GetArrayType(10, u8);
+  LeafTypeTreeArena<int64_t> arena(/*block_size=*/4);
+  std::vector<MutableLeafTypeTreeView<int64_t>> views;
+  for (int64_t i = 0; i < 20; ++i) {
+    views.push_back(
+        arena.Allocate(LeafTypeTree<int64_t>(i % 3 == 0 ? wide : u8, i)));
+  }
+  LeafTypeTreeArena<int64_t> moved = std::move(arena);
+  for (int64_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(views[i].size(), i % 3 == 0 ? 10 : 1);
+    for (int64_t element : views[i].elements()) {
+      EXPECT_EQ(element, i);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace xls
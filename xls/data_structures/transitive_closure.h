@@ -15,13 +15,20 @@
 #ifndef XLS_DATA_STRUCTURES_TRANSITIVE_CLOSURE_H_
 #define XLS_DATA_STRUCTURES_TRANSITIVE_CLOSURE_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
+#include "absl/numeric/bits.h"
+#include "xls/common/thread.h"
+#include "xls/data_structures/strongly_connected_components.h"
 
 namespace xls {
 
@@ -106,6 +113,139 @@ HashRelation<V> TransitiveClosure(const HashRelation<V>& relation) {
   return result;
 }
 
+// Compute the transitive closure of a relation like TransitiveClosure but in
+// a way which scales to large relations. Strongly connected components are
+// condensed first and the nodes reachable from each component are then
+// computed in reverse topological order as a word-packed bitset, which takes
+// O(n * (n + m) / 64) word operations instead of O(n^3) hash lookups.
+// Components at the same depth in the condensed graph are independent and are
+// divided among up to `thread_count` threads.
+template <typename V>
+HashRelation<V> DenseTransitiveClosure(const HashRelation<V>& relation,
+                                       int64_t thread_count = 1) {
+  // Levels with fewer components per thread than this are computed serially
+  // as starting the threads would cost more than it saves.
+  constexpr int64_t kMinComponentsPerThread = 16;
+
+  if (relation.empty()) {
+    return HashRelation<V>();
+  }
+
+  std::vector<V> nodes;
+  absl::flat_hash_map<V, int64_t> node_to_index;
+  auto index_of = [&](const V& node) {
+    auto [it, inserted] = node_to_index.try_emplace(node, nodes.size());
+    if (inserted) {
+      nodes.push_back(node);
+    }
+    return it->second;
+  };
+  absl::btree_map<int64_t, absl::btree_set<int64_t>> graph;
+  for (const auto& [node, children] : relation) {
+    absl::btree_set<int64_t>& successors = graph[index_of(node)];
+    for (const V& child : children) {
+      successors.insert(index_of(child));
+    }
+  }
+  const int64_t n = nodes.size();
+  const int64_t words = (n + 63) / 64;
+
+  // Tarjan's algorithm produces a component only after all of the components
+  // reachable from it, i.e. in reverse topological order. Nodes without any
+  // edges are not part of a component.
+  std::vector<absl::btree_set<int64_t>> components =
+      StronglyConnectedComponents(graph);
+  std::vector<int64_t> component_of(n, -1);
+  for (int64_t c = 0; c < components.size(); ++c) {
+    for (int64_t node : components[c]) {
+      component_of[node] = c;
+    }
+  }
+
+  // Group the components by their height in the condensed graph so that the
+  // components of each level only depend on those of lower levels.
+  std::vector<int64_t> height(components.size(), 0);
+  std::vector<std::vector<int64_t>> levels;
+  for (int64_t c = 0; c < components.size(); ++c) {
+    for (int64_t node : components[c]) {
+      auto it = graph.find(node);
+      if (it == graph.end()) {
+        continue;
+      }
+      for (int64_t successor : it->second) {
+        int64_t d = component_of[successor];
+        if (d != c) {
+          height[c] = std::max(height[c], height[d] + 1);
+        }
+      }
+    }
+    if (height[c] >= levels.size()) {
+      levels.resize(height[c] + 1);
+    }
+    levels[height[c]].push_back(c);
+  }
+
+  // Row `c` holds the nodes reachable from component `c` in one or more steps.
+  std::vector<uint64_t> reachable(components.size() * words, 0);
+  auto compute_row = [&](int64_t c) {
+    uint64_t* row = &reachable[c * words];
+    absl::flat_hash_set<int64_t> merged;
+    for (int64_t node : components[c]) {
+      auto it = graph.find(node);
+      if (it == graph.end()) {
+        continue;
+      }
+      for (int64_t successor : it->second) {
+        row[successor / 64] |= uint64_t{1} << (successor % 64);
+        int64_t d = component_of[successor];
+        if (d != c && merged.insert(d).second) {
+          const uint64_t* successor_row = &reachable[d * words];
+          for (int64_t w = 0; w < words; ++w) {
+            row[w] |= successor_row[w];
+          }
+        }
+      }
+    }
+  };
+  for (const std::vector<int64_t>& level : levels) {
+    int64_t level_threads =
+        std::min<int64_t>(thread_count, level.size() / kMinComponentsPerThread);
+    if (level_threads <= 1) {
+      for (int64_t c : level) {
+        compute_row(c);
+      }
+      continue;
+    }
+    std::vector<std::unique_ptr<Thread>> threads;
+    threads.reserve(level_threads);
+    for (int64_t t = 0; t < level_threads; ++t) {
+      threads.push_back(std::make_unique<Thread>([&, t]() {
+        for (int64_t i = t; i < level.size(); i += level_threads) {
+          compute_row(level[i]);
+        }
+      }));
+    }
+    // Threads are joined on destruction.
+  }
+
+  HashRelation<V> result;
+  result.reserve(relation.size());
+  for (const auto& [node, _] : relation) {
+    absl::flat_hash_set<V>& children = result[node];
+    int64_t c = component_of[node_to_index.at(node)];
+    if (c < 0) {
+      continue;
+    }
+    const uint64_t* row = &reachable[c * words];
+    for (int64_t w = 0; w < words; ++w) {
+      for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+        children.insert(nodes[w * 64 + absl::countr_zero(bits)]);
+      }
+    }
+  }
+  return result;
+}
+
 }  // namespace xls
 
 #endif  // XLS_DATA_STRUCTURES_TRANSITIVE_CLOSURE_H_
@@ -14,6 +14,8 @@
 
 #include "xls/data_structures/transitive_closure.h"
 
+#include <cstdint>
+#include <random>
 #include <string>
 
 #include "gmock/gmock.h"
@@ -43,5 +45,54 @@ TEST(TransitiveClosureTest, Simple) {
   EXPECT_FALSE(tc.contains("qux"));
 }
 
+TEST(TransitiveClosureTest, DenseMatchesSimple) {
+  HashRelation<V> rel;
+  rel["foo"].insert("bar");
+  rel["bar"].insert("baz");
+  rel["bar"].insert("qux");
+  rel["baz"].insert("qux");
+  rel["foo2"].insert("baz");
+  rel["empty"];
+  EXPECT_EQ(DenseTransitiveClosure<V>(rel), TransitiveClosure<V>(rel));
+}
+
+TEST(TransitiveClosureTest, DenseWithCycles) {
+  HashRelation<V> rel;
+  rel["a"].insert("b");
+  rel["b"].insert("c");
+  rel["c"].insert("a");
+  rel["c"].insert("d");
+  rel["d"].insert("d");
+  rel["e"].insert("a");
+  HashRelation<V> tc = DenseTransitiveClosure<V>(rel);
+  EXPECT_THAT(tc.at("a"), UnorderedElementsAre("a", "b", "c", "d"));
+  EXPECT_THAT(tc.at("c"), UnorderedElementsAre("a", "b", "c", "d"));
+  EXPECT_THAT(tc.at("d"), UnorderedElementsAre("d"));
+  EXPECT_THAT(tc.at("e"), UnorderedElementsAre("a", "b", "c", "d"));
+  EXPECT_EQ(tc, TransitiveClosure<V>(rel));
+}
+
+TEST(TransitiveClosureTest, DenseMatchesRandomRelations) {
+  std::mt19937_64 rng(42);
+  for (int64_t iteration = 0; iteration < 5; ++iteration) {
+    // Mostly forward edges with a few backward ones so that there are both
+    // long paths and cycles.
+    HashRelation<int64_t> rel;
+    constexpr int64_t kNodes = 150;
+    for (int64_t i = 0; i < kNodes; ++i) {
+      for (int64_t e = 0; e < 2; ++e) {
+        int64_t j = std::uniform_int_distribution<int64_t>(0, kNodes - 1)(rng);
+        if (j > i || std::uniform_int_distribution<int64_t>(0, 20)(rng) == 0) {
+          rel[i].insert(j);
+        }
+      }
+    }
+    HashRelation<int64_t> expected = TransitiveClosure<int64_t>(rel);
+    EXPECT_EQ(DenseTransitiveClosure<int64_t>(rel), expected);
+    EXPECT_EQ(DenseTransitiveClosure<int64_t>(rel, /*thread_count=*/4),
+              expected);
+  }
+}
+
 }  // namespace
 }  // namespace xls
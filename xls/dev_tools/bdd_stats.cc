@@ -134,9 +134,17 @@ absl::Status RealMain(std::string_view input_path) {
     std::cout << "Bits in graph: " << number_bits << "\n";
 
     int64_t max_paths = 0;
-    for (int64_t i = 0; i < bdd_function->bdd().size(); ++i) {
-      max_paths =
-          std::max(max_paths, bdd_function->bdd().path_count(BddNodeIndex(i)));
+    for (Node* node : top.value()->nodes()) {
+      if (!node->GetType()->IsBits()) {
+        continue;
+      }
+      for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
+        std::optional<BddNodeIndex> bit = bdd_function->TryGetBddNode(node, i);
+        if (bit.has_value()) {
+          max_paths =
+              std::max(max_paths, bdd_function->bdd().path_count(*bit));
+        }
+      }
     }
     if (max_paths == std::numeric_limits<int32_t>::max()) {
       std::cout << "Maximum paths of any expression: INT32_MAX\n";
@@ -27,8 +27,10 @@
 #include "absl/strings/str_split.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "xls/codegen/block_conversion.h"
 #include "xls/codegen/block_metrics.h"
 #include "xls/codegen/codegen_options.h"
+#include "xls/codegen/codegen_pass.h"
 #include "xls/codegen/combinational_generator.h"
 #include "xls/codegen/module_signature.h"
 #include "xls/codegen/pipeline_generator.h"
@@ -43,6 +45,7 @@
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
 #include "xls/scheduling/pipeline_schedule.h"
+#include "xls/scheduling/pipeline_schedule.pb.h"
 #include "xls/scheduling/run_pipeline_schedule.h"
 #include "xls/scheduling/scheduling_options.h"
 #include "xls/tools/codegen.h"
@@ -113,6 +116,34 @@ absl::Status PrintPipelinedCodegenInfo(
   return absl::OkStatus();
 }
 
+// Times only the conversion of the scheduled function/proc into a block. The
+// conversion is run on a fresh copy of the IR so the package used for the full
+// codegen run is left untouched.
+absl::Status PrintBlockConversionInfo(
+    std::string_view opt_ir_contents, const PipelineSchedule& schedule,
+    const DelayEstimator& delay_estimator,
+    const verilog::CodegenOptions& codegen_options) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       Parser::ParsePackage(opt_ir_contents));
+  std::optional<FunctionBase*> top = package->GetTop();
+  XLS_RET_CHECK(top.has_value());
+  PackagePipelineSchedulesProto schedules_proto;
+  (*schedules_proto.mutable_schedules())[(*top)->name()] =
+      schedule.ToProto(delay_estimator);
+  XLS_ASSIGN_OR_RETURN(PipelineSchedule package_schedule,
+                       PipelineSchedule::FromProto(*top, schedules_proto));
+
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(verilog::CodegenPassUnit unit,
+                       verilog::FunctionBaseToPipelinedBlock(
+                           package_schedule, codegen_options, *top));
+  absl::Duration total_time = absl::Now() - start;
+  std::cout << absl::StreamFormat("Block conversion time: %dms\n",
+                                  total_time / absl::Milliseconds(1));
+
+  return absl::OkStatus();
+}
+
 absl::StatusOr<Block*> GetTopBlock(Package* package) {
   if (!absl::GetFlag(FLAGS_top).empty()) {
     return package->GetBlock(absl::GetFlag(FLAGS_top));
@@ -187,6 +218,8 @@ absl::Status RealMain(std::string_view opt_ir_path,
           PipelineSchedule schedule,
           ScheduleAndPrintStats(opt_package.get(), *delay_estimator,
                                 scheduling_options));
+      XLS_RETURN_IF_ERROR(PrintBlockConversionInfo(
+          opt_ir_contents, schedule, *delay_estimator, codegen_options));
       XLS_RETURN_IF_ERROR(
           PrintPipelinedCodegenInfo(*top, schedule, codegen_options));
     }
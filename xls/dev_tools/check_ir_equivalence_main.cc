@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -26,11 +27,13 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/flags/flag.h"
 #include "absl/log/check.h"
+#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "xls/common/exit_status.h"
 #include "xls/common/file/filesystem.h"
@@ -55,6 +58,7 @@
 #include "xls/passes/unroll_pass.h"
 #include "xls/scheduling/proc_state_legalization_pass.h"
 #include "xls/scheduling/scheduling_pass.h"
+#include "xls/solvers/z3_aig_equivalence.h"
 #include "xls/solvers/z3_ir_equivalence.h"
 #include "xls/solvers/z3_ir_translator.h"
 
@@ -89,6 +93,13 @@ ABSL_FLAG(int, match_exit_code, 0,
           "Value to exit with if equivalence is not proven.");
 ABSL_FLAG(absl::Duration, timeout, absl::InfiniteDuration(),
           "How long to wait for any proof to complete.");
+ABSL_FLAG(bool, use_aig, true,
+          "Whether to first try bit-blasting both functions into one "
+          "structurally hashed AIG and sweeping it for equivalent nodes, which "
+          "is typically much faster for functions that differ by local "
+          "rewrites. Functions the AIG checker does not support, or can't "
+          "decide within half of --timeout, are checked with the bitvector "
+          "encoding.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
 
 namespace xls {
@@ -96,6 +107,19 @@ namespace {
 
 absl::StatusOr<solvers::z3::ProverResult> CheckFunctionEquivalence(
     Function* f1, Function* f2, absl::Duration timeout) {
+  if (absl::GetFlag(FLAGS_use_aig)) {
+    // The AIG checker gets half of the budget so that a problem which is hard
+    // for it still leaves time for the bitvector encoding.
+    absl::Time deadline = absl::Now() + timeout;
+    absl::StatusOr<solvers::z3::ProverResult> result =
+        solvers::z3::TryProveEquivalenceWithAig(f1, f2, timeout / 2);
+    if (!absl::IsUnimplemented(result.status()) &&
+        !absl::IsDeadlineExceeded(result.status())) {
+      return result;
+    }
+    VLOG(1) << "Falling back to the bitvector encoding: " << result.status();
+    timeout = std::max(deadline - absl::Now(), absl::ZeroDuration());
+  }
   return solvers::z3::TryProveEquivalence(f1, f2, timeout);
 }
 absl::StatusOr<solvers::z3::ProverResult> CheckProcEquivalence(
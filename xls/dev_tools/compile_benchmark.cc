@@ -0,0 +1,319 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dev_tools/compile_benchmark.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/strip.h"
+#include "absl/time/time.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/common/stopwatch.h"
+#include "xls/dev_tools/compile_benchmark.pb.h"
+#include "xls/estimators/area_model/area_breakdown.h"
+#include "xls/dslx/ir_convert/conversion_info.h"
+#include "xls/dslx/ir_convert/convert_options.h"
+#include "xls/dslx/ir_convert/ir_converter.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+#include "xls/scheduling/pipeline_schedule.h"
+#include "xls/tools/codegen.h"
+#include "xls/tools/opt.h"
+
+namespace xls {
+namespace {
+
+// Resets the peak resident set size of the process to its current size so
+// that the peak of each phase can be measured on its own. Only has an effect
+// on Linux.
+void ResetPeakRss() {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+}
+
+// Returns the peak resident set size of the process in KiB.
+int64_t GetPeakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    std::string_view value = line;
+    if (absl::ConsumePrefix(&value, "VmHWM:")) {
+      value = absl::StripSuffix(absl::StripAsciiWhitespace(value), " kB");
+      int64_t kb;
+      if (absl::SimpleAtoi(value, &kb)) {
+        return kb;
+      }
+    }
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Runs `phase`, recording its cost in `result`. Phases are recorded in the
+// order of their first run; later runs keep the smallest wall time and the
+// largest peak RSS.
+absl::Status RunPhase(std::string_view name,
+                      const std::function<absl::Status()>& phase,
+                      CompileBenchmarkResultProto& result) {
+  ResetPeakRss();
+  Stopwatch stopwatch;
+  absl::Status status = phase();
+  int64_t wall_time_us = absl::ToInt64Microseconds(stopwatch.GetElapsedTime());
+  int64_t peak_rss_kb = GetPeakRssKb();
+
+  CompileBenchmarkPhaseProto* proto = nullptr;
+  for (CompileBenchmarkPhaseProto& existing : *result.mutable_phases()) {
+    if (existing.name() == name) {
+      proto = &existing;
+    }
+  }
+  if (proto == nullptr) {
+    proto = result.add_phases();
+    proto->set_name(std::string{name});
+    proto->set_wall_time_us(wall_time_us);
+    proto->set_peak_rss_kb(peak_rss_kb);
+  } else {
+    proto->set_wall_time_us(std::min(proto->wall_time_us(), wall_time_us));
+    proto->set_peak_rss_kb(std::max(proto->peak_rss_kb(), peak_rss_kb));
+  }
+  return status;
+}
+
+absl::Status RunFlow(const CompileBenchmarkDesignProto& design,
+                     const CompileBenchmarkOptions& options,
+                     CompileBenchmarkResultProto& result) {
+  std::unique_ptr<Package> package;
+  XLS_RETURN_IF_ERROR(RunPhase(
+      "ir_conversion",
+      [&]() -> absl::Status {
+        std::string_view path = design.dslx_path();
+        XLS_ASSIGN_OR_RETURN(
+            dslx::PackageConversionData data,
+            dslx::ConvertFilesToPackage(
+                {path}, options.dslx_stdlib_path.string(), options.dslx_paths,
+                dslx::ConvertOptions{}, design.top()));
+        package = std::move(data.package);
+        return absl::OkStatus();
+      },
+      result));
+
+  XLS_RETURN_IF_ERROR(RunPhase(
+      "optimization",
+      [&]() { return tools::OptimizeIrForTop(package.get(), {}); }, result));
+
+  PipelineScheduleOrGroup schedules = PackagePipelineSchedules();
+  XLS_RETURN_IF_ERROR(RunPhase(
+      "scheduling",
+      [&]() -> absl::Status {
+        XLS_ASSIGN_OR_RETURN(
+            schedules,
+            Schedule(package.get(), design.scheduling_options(),
+                     design.codegen_options(), /*scheduling_time=*/nullptr));
+        return absl::OkStatus();
+      },
+      result));
+
+  // Estimate the area before codegen adds the blocks generated from the
+  // scheduled functions and procs to the package.
+  std::optional<PackageAreaProto> area;
+  if (options.area_estimator != nullptr) {
+    absl::flat_hash_map<Node*, int64_t> node_stages;
+    if (std::holds_alternative<PipelineSchedule>(schedules)) {
+      node_stages = std::get<PipelineSchedule>(schedules).GetCycleMap();
+    } else {
+      for (const auto& [_, schedule] :
+           std::get<PackagePipelineSchedules>(schedules)) {
+        node_stages.insert(schedule.GetCycleMap().begin(),
+                           schedule.GetCycleMap().end());
+      }
+    }
+    XLS_ASSIGN_OR_RETURN(area,
+                         EstimatePackageArea(package.get(),
+                                             *options.area_estimator,
+                                             node_stages));
+  }
+
+  CodegenResult codegen_result;
+  XLS_RETURN_IF_ERROR(RunPhase(
+      "codegen",
+      [&]() -> absl::Status {
+        XLS_ASSIGN_OR_RETURN(
+            codegen_result,
+            Codegen(package.get(), design.scheduling_options(),
+                    design.codegen_options(), /*with_delay_model=*/true,
+                    &schedules, /*codegen_time=*/nullptr));
+        return absl::OkStatus();
+      },
+      result));
+
+  CompileBenchmarkQorProto& qor = *result.mutable_qor();
+  int64_t node_count = 0;
+  for (FunctionBase* function_base : package->GetFunctionBases()) {
+    node_count += function_base->node_count();
+  }
+  qor.set_node_count(node_count);
+  int64_t pipeline_stages = 0;
+  if (std::holds_alternative<PipelineSchedule>(schedules)) {
+    pipeline_stages = std::get<PipelineSchedule>(schedules).length();
+  } else {
+    for (const auto& [_, schedule] :
+         std::get<PackagePipelineSchedules>(schedules)) {
+      pipeline_stages = std::max(pipeline_stages, schedule.length());
+    }
+  }
+  qor.set_pipeline_stages(pipeline_stages);
+  const verilog::ModuleGeneratorResult& module =
+      codegen_result.module_generator_result;
+  const auto& block_metrics =
+      module.signature.proto().metrics().block_metrics();
+  qor.set_flop_count(block_metrics.flop_count());
+  qor.set_max_reg_to_reg_delay_ps(block_metrics.max_reg_to_reg_delay_ps());
+  qor.set_verilog_line_count(
+      std::count(module.verilog_text.begin(), module.verilog_text.end(), '\n'));
+  if (area.has_value()) {
+    *qor.mutable_area() = *std::move(area);
+  }
+  return absl::OkStatus();
+}
+
+// Returns the relative increase from `baseline` to `current`.
+double RelativeIncrease(int64_t baseline, int64_t current) {
+  if (baseline == 0) {
+    return current > 0 ? 1.0 : 0.0;
+  }
+  return static_cast<double>(current - baseline) /
+         static_cast<double>(baseline);
+}
+
+}  // namespace
+
+CompileBenchmarkResultProto RunCompileBenchmark(
+    const CompileBenchmarkDesignProto& design,
+    const CompileBenchmarkOptions& options) {
+  CompileBenchmarkResultProto result;
+  result.set_design(design.name());
+  for (int64_t run = 0; run < options.runs; ++run) {
+    absl::Status status = RunFlow(design, options, result);
+    if (!status.ok()) {
+      result.set_error(status.ToString());
+      break;
+    }
+  }
+  return result;
+}
+
+std::vector<std::string> FindCompileBenchmarkRegressions(
+    const CompileBenchmarkResultsProto& baseline,
+    const CompileBenchmarkResultsProto& current,
+    const CompileBenchmarkThresholds& thresholds) {
+  absl::flat_hash_map<std::string, const CompileBenchmarkResultProto*>
+      current_results;
+  for (const CompileBenchmarkResultProto& result : current.results()) {
+    current_results[result.design()] = &result;
+  }
+
+  std::vector<std::string> regressions;
+  for (const CompileBenchmarkResultProto& before : baseline.results()) {
+    auto it = current_results.find(before.design());
+    if (it == current_results.end()) {
+      regressions.push_back(
+          absl::StrFormat("%s: missing from the results", before.design()));
+      continue;
+    }
+    const CompileBenchmarkResultProto& after = *it->second;
+    if (!after.error().empty()) {
+      if (before.error().empty()) {
+        regressions.push_back(absl::StrFormat("%s: now fails: %s",
+                                              before.design(), after.error()));
+      }
+      continue;
+    }
+
+    for (const CompileBenchmarkPhaseProto& phase_before : before.phases()) {
+      const CompileBenchmarkPhaseProto* phase_after = nullptr;
+      for (const CompileBenchmarkPhaseProto& phase : after.phases()) {
+        if (phase.name() == phase_before.name()) {
+          phase_after = &phase;
+        }
+      }
+      if (phase_after == nullptr) {
+        continue;
+      }
+      if (std::max(phase_before.wall_time_us(), phase_after->wall_time_us()) >=
+              thresholds.min_wall_time_us &&
+          RelativeIncrease(phase_before.wall_time_us(),
+                           phase_after->wall_time_us()) >
+              thresholds.wall_time) {
+        regressions.push_back(absl::StrFormat(
+            "%s: %s wall time %.3fs -> %.3fs", before.design(),
+            phase_before.name(), phase_before.wall_time_us() / 1e6,
+            phase_after->wall_time_us() / 1e6));
+      }
+      if (RelativeIncrease(phase_before.peak_rss_kb(),
+                           phase_after->peak_rss_kb()) > thresholds.peak_rss) {
+        regressions.push_back(absl::StrFormat(
+            "%s: %s peak RSS %dKiB -> %dKiB", before.design(),
+            phase_before.name(), phase_before.peak_rss_kb(),
+            phase_after->peak_rss_kb()));
+      }
+    }
+
+    if (!before.has_qor() || !after.has_qor()) {
+      continue;
+    }
+    auto check_qor = [&](std::string_view metric, int64_t qor_before,
+                         int64_t qor_after) {
+      if (RelativeIncrease(qor_before, qor_after) > thresholds.qor) {
+        regressions.push_back(absl::StrFormat("%s: %s %d -> %d",
+                                              before.design(), metric,
+                                              qor_before, qor_after));
+      }
+    };
+    check_qor("node count", before.qor().node_count(),
+              after.qor().node_count());
+    check_qor("pipeline stages", before.qor().pipeline_stages(),
+              after.qor().pipeline_stages());
+    check_qor("flop count", before.qor().flop_count(),
+              after.qor().flop_count());
+    check_qor("max reg-to-reg delay (ps)",
+              before.qor().max_reg_to_reg_delay_ps(),
+              after.qor().max_reg_to_reg_delay_ps());
+    check_qor("Verilog lines", before.qor().verilog_line_count(),
+              after.qor().verilog_line_count());
+  }
+  return regressions;
+}
+
+}  // namespace xls
@@ -0,0 +1,75 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DEV_TOOLS_COMPILE_BENCHMARK_H_
+#define XLS_DEV_TOOLS_COMPILE_BENCHMARK_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "xls/dev_tools/compile_benchmark.pb.h"
+#include "xls/estimators/area_model/area_estimator.h"
+
+namespace xls {
+
+struct CompileBenchmarkOptions {
+  std::filesystem::path dslx_stdlib_path;
+  // Paths searched for imported DSLX modules.
+  std::vector<std::filesystem::path> dslx_paths;
+  // Number of times the flow is run. Wall times are the smallest over all
+  // runs, which filters out much of the noise of a loaded machine.
+  int64_t runs = 1;
+  // If set, the estimated area of the scheduled package is recorded in the
+  // QoR. Wrap the area model in a SignatureCachingAreaEstimator to share the
+  // estimates between designs.
+  const AreaEstimator* area_estimator = nullptr;
+};
+
+// Compiles `design` (whose DSLX path is taken as is) from DSLX to Verilog
+// `options.runs` times, recording the cost of each phase of the flow and the
+// quality of its results. Failures of the flow are recorded in the result
+// rather than returned so that one broken design doesn't hide the others.
+//
+// Peak RSS is measured per phase by resetting the process's high-water mark
+// before each phase where the OS supports it (Linux); elsewhere it is the peak
+// of the process so far.
+CompileBenchmarkResultProto RunCompileBenchmark(
+    const CompileBenchmarkDesignProto& design,
+    const CompileBenchmarkOptions& options);
+
+struct CompileBenchmarkThresholds {
+  // Relative increases of wall time and peak RSS tolerated before a phase is
+  // considered to have regressed.
+  double wall_time = 0.1;
+  double peak_rss = 0.1;
+  // Phases whose wall time is below this in both revisions are never
+  // reported; their timings are mostly noise.
+  int64_t min_wall_time_us = 100'000;
+  // Relative increase of any QoR metric tolerated.
+  double qor = 0.0;
+};
+
+// Returns a description of each regression from `baseline` to `current`:
+// designs that started failing or disappeared, phases that got slower or
+// bigger beyond the thresholds, and QoR metrics that got worse.
+std::vector<std::string> FindCompileBenchmarkRegressions(
+    const CompileBenchmarkResultsProto& baseline,
+    const CompileBenchmarkResultsProto& current,
+    const CompileBenchmarkThresholds& thresholds);
+
+}  // namespace xls
+
+#endif  // XLS_DEV_TOOLS_COMPILE_BENCHMARK_H_
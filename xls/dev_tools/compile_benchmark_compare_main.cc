@@ -0,0 +1,109 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/exit_status.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dev_tools/compile_benchmark.h"
+#include "xls/dev_tools/compile_benchmark.pb.h"
+
+static constexpr std::string_view kUsage = R"(
+Compares two sets of results of compile_benchmark_main and reports the
+regressions from the first to the second. Exits with an error if there are
+any. Files ending in .textproto are read as text protos, others as binary
+protos. Example:
+
+   compile_benchmark_compare_main baseline.textproto current.textproto
+)";
+
+ABSL_FLAG(double, max_wall_time_increase, 0.1,
+          "Relative increase of the wall time of a phase tolerated.");
+ABSL_FLAG(int64_t, min_wall_time_us, 100'000,
+          "Phases faster than this in both revisions are not compared.");
+ABSL_FLAG(double, max_peak_rss_increase, 0.1,
+          "Relative increase of the peak RSS of a phase tolerated.");
+ABSL_FLAG(double, max_qor_increase, 0.0,
+          "Relative increase of QoR metrics (node count, stages, flops, "
+          "delay, Verilog lines) tolerated.");
+
+namespace xls {
+namespace {
+
+absl::StatusOr<CompileBenchmarkResultsProto> ReadResults(
+    const std::filesystem::path& path) {
+  CompileBenchmarkResultsProto results;
+  if (absl::EndsWith(path.string(), ".textproto")) {
+    XLS_RETURN_IF_ERROR(ParseTextProtoFile(path, &results));
+  } else {
+    XLS_RETURN_IF_ERROR(ParseProtobinFile(path, &results));
+  }
+  return results;
+}
+
+absl::Status RealMain(const std::filesystem::path& baseline_path,
+                      const std::filesystem::path& current_path) {
+  XLS_ASSIGN_OR_RETURN(CompileBenchmarkResultsProto baseline,
+                       ReadResults(baseline_path));
+  XLS_ASSIGN_OR_RETURN(CompileBenchmarkResultsProto current,
+                       ReadResults(current_path));
+  CompileBenchmarkThresholds thresholds{
+      .wall_time = absl::GetFlag(FLAGS_max_wall_time_increase),
+      .peak_rss = absl::GetFlag(FLAGS_max_peak_rss_increase),
+      .min_wall_time_us = absl::GetFlag(FLAGS_min_wall_time_us),
+      .qor = absl::GetFlag(FLAGS_max_qor_increase),
+  };
+  std::vector<std::string> regressions =
+      FindCompileBenchmarkRegressions(baseline, current, thresholds);
+  if (regressions.empty()) {
+    std::cout << absl::StreamFormat("No regressions from %s to %s.\n",
+                                    baseline.revision(), current.revision());
+    return absl::OkStatus();
+  }
+  std::cout << absl::StreamFormat("Regressions from %s to %s:\n",
+                                  baseline.revision(), current.revision());
+  for (const std::string& regression : regressions) {
+    std::cout << "  " << regression << "\n";
+  }
+  return absl::FailedPreconditionError(
+      absl::StrFormat("Found %d compile benchmark regressions",
+                      regressions.size()));
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  if (positional_arguments.size() != 2) {
+    LOG(QFATAL) << absl::StreamFormat(
+        "Expected invocation: %s BASELINE_RESULTS CURRENT_RESULTS", argv[0]);
+  }
+  return xls::ExitStatus(
+      xls::RealMain(positional_arguments[0], positional_arguments[1]));
+}
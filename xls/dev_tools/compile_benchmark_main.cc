@@ -0,0 +1,181 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "xls/common/exit_status.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/get_runfile_path.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dev_tools/compile_benchmark.h"
+#include "xls/dev_tools/compile_benchmark.pb.h"
+#include "xls/dslx/default_dslx_stdlib_path.h"
+#include "xls/estimators/area_model/area_breakdown.h"
+#include "xls/estimators/area_model/area_estimator.h"
+#include "xls/estimators/area_model/area_estimators.h"
+
+static constexpr std::string_view kUsage = R"(
+Compiles each design of a corpus from DSLX to Verilog and records the wall
+time and peak RSS of each phase of the flow along with the quality of the
+results in a CompileBenchmarkResultsProto. Compare the results of two
+revisions with compile_benchmark_compare_main. Example:
+
+   compile_benchmark_main --runs=3 --revision=$(git rev-parse HEAD) \
+     --output_textproto=/tmp/results.textproto
+)";
+
+ABSL_FLAG(std::string, corpus,
+          "xls/dev_tools/compile_benchmark_corpus.textproto",
+          "CompileBenchmarkCorpusProto textproto listing the designs to "
+          "compile. Relative paths are looked up in the XLS runfiles, as are "
+          "the DSLX paths of the designs.");
+ABSL_FLAG(std::string, designs, "",
+          "Comma-separated names of the designs of the corpus to compile. "
+          "Empty compiles all of them.");
+ABSL_FLAG(int64_t, runs, 1,
+          "Number of times to compile each design. The smallest wall time of "
+          "each phase is recorded.");
+ABSL_FLAG(std::string, revision, "",
+          "Label of the revision benchmarked, recorded in the results.");
+ABSL_FLAG(std::string, dslx_stdlib_path,
+          std::string(xls::kDefaultDslxStdlibPath),
+          "Path to DSLX standard library.");
+ABSL_FLAG(std::string, area_model, "",
+          "Area model used to record the estimated area of each design in its "
+          "QoR, e.g. asap7. Empty records no area.");
+ABSL_FLAG(std::string, output_proto, "",
+          "File to write the CompileBenchmarkResultsProto to as a binary "
+          "proto.");
+ABSL_FLAG(std::string, output_textproto, "",
+          "File to write the CompileBenchmarkResultsProto to as a text proto.");
+
+namespace xls {
+namespace {
+
+// Returns `path` looked up in the XLS runfiles if it is relative. If so and
+// `root` is given, sets it to the root of the runfiles.
+absl::StatusOr<std::filesystem::path> ResolvePath(
+    const std::filesystem::path& path, std::filesystem::path* root = nullptr) {
+  if (path.is_absolute()) {
+    return path;
+  }
+  XLS_ASSIGN_OR_RETURN(std::filesystem::path resolved,
+                       GetXlsRunfilePath(path));
+  if (root != nullptr) {
+    *root = resolved;
+    for (auto it = path.begin(); it != path.end(); ++it) {
+      *root = root->parent_path();
+    }
+  }
+  return resolved;
+}
+
+absl::Status RealMain() {
+  XLS_ASSIGN_OR_RETURN(std::filesystem::path corpus_path,
+                       ResolvePath(absl::GetFlag(FLAGS_corpus)));
+  XLS_ASSIGN_OR_RETURN(
+      CompileBenchmarkCorpusProto corpus,
+      ParseTextProtoFile<CompileBenchmarkCorpusProto>(corpus_path));
+  std::vector<std::string> selected_names =
+      absl::StrSplit(absl::GetFlag(FLAGS_designs), ',', absl::SkipEmpty());
+  absl::flat_hash_set<std::string> selected(selected_names.begin(),
+                                            selected_names.end());
+
+  // Shared by all designs so each distinct operation is estimated once.
+  std::optional<SignatureCachingAreaEstimator> area_estimator;
+  if (!absl::GetFlag(FLAGS_area_model).empty()) {
+    XLS_ASSIGN_OR_RETURN(AreaEstimator * model,
+                         GetAreaEstimator(absl::GetFlag(FLAGS_area_model)));
+    area_estimator.emplace(*model);
+  }
+
+  CompileBenchmarkResultsProto results;
+  results.set_revision(absl::GetFlag(FLAGS_revision));
+  for (CompileBenchmarkDesignProto design : corpus.designs()) {
+    if (!selected.empty() && !selected.erase(design.name())) {
+      continue;
+    }
+    CompileBenchmarkOptions options{
+        .dslx_stdlib_path = absl::GetFlag(FLAGS_dslx_stdlib_path),
+        .runs = absl::GetFlag(FLAGS_runs),
+        .area_estimator =
+            area_estimator.has_value() ? &*area_estimator : nullptr,
+    };
+    std::filesystem::path root;
+    XLS_ASSIGN_OR_RETURN(std::filesystem::path dslx_path,
+                         ResolvePath(design.dslx_path(), &root));
+    design.set_dslx_path(dslx_path.string());
+    // Imports like `xls.modules.rle.rle_common` are relative to the root.
+    if (!root.empty()) {
+      options.dslx_paths.push_back(root);
+    }
+
+    LOG(INFO) << "Compiling " << design.name();
+    CompileBenchmarkResultProto result = RunCompileBenchmark(design, options);
+    std::cout << absl::StreamFormat("%-24s", result.design());
+    for (const CompileBenchmarkPhaseProto& phase : result.phases()) {
+      std::cout << absl::StreamFormat("  %s: %.3fs %dMiB", phase.name(),
+                                      phase.wall_time_us() / 1e6,
+                                      phase.peak_rss_kb() / 1024);
+    }
+    if (!result.error().empty()) {
+      std::cout << "  FAILED: " << result.error();
+    }
+    std::cout << "\n";
+    *results.add_results() = std::move(result);
+  }
+  if (!selected.empty()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Designs not in the corpus: %s", absl::StrJoin(selected, ", ")));
+  }
+
+  if (!absl::GetFlag(FLAGS_output_proto).empty()) {
+    XLS_RETURN_IF_ERROR(
+        SetProtobinFile(absl::GetFlag(FLAGS_output_proto), results));
+  }
+  if (!absl::GetFlag(FLAGS_output_textproto).empty()) {
+    XLS_RETURN_IF_ERROR(
+        SetTextProtoFile(absl::GetFlag(FLAGS_output_textproto), results));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  if (!positional_arguments.empty()) {
+    LOG(QFATAL) << absl::StreamFormat("Expected invocation: %s [flags]",
+                                      argv[0]);
+  }
+  return xls::ExitStatus(xls::RealMain());
+}
@@ -0,0 +1,119 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dev_tools/compile_benchmark.h"
+
+#include <filesystem>  // NOLINT
+#include <string_view>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dev_tools/compile_benchmark.pb.h"
+#include "xls/dslx/default_dslx_stdlib_path.h"
+
+namespace xls {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Not;
+
+template <typename ProtoT>
+ProtoT ParseTextProtoOrDie(std::string_view text) {
+  ProtoT proto;
+  CHECK_OK(ParseTextProto(text, /*file_name=*/"", &proto));
+  return proto;
+}
+
+TEST(CompileBenchmarkTest, CompilesDesign) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path path = temp_dir.path() / "add.x";
+  XLS_ASSERT_OK(SetFileContents(path, R"(
+fn add3(x: u32, y: u32, z: u32) -> u32 { x + y + z }
+)"));
+  CompileBenchmarkDesignProto design =
+      ParseTextProtoOrDie<CompileBenchmarkDesignProto>(R"pb(
+        name: "add3"
+        top: "add3"
+        scheduling_options { delay_model: "unit" pipeline_stages: 2 }
+        codegen_options { generator: GENERATOR_KIND_PIPELINE }
+      )pb");
+  design.set_dslx_path(path.string());
+
+  CompileBenchmarkResultProto result = RunCompileBenchmark(
+      design, {.dslx_stdlib_path = kDefaultDslxStdlibPath, .runs = 2});
+  EXPECT_THAT(result.error(), IsEmpty());
+  EXPECT_EQ(result.design(), "add3");
+  ASSERT_EQ(result.phases_size(), 4);
+  EXPECT_EQ(result.phases(0).name(), "ir_conversion");
+  EXPECT_EQ(result.phases(3).name(), "codegen");
+  EXPECT_GT(result.phases(0).peak_rss_kb(), 0);
+  EXPECT_EQ(result.qor().pipeline_stages(), 2);
+  EXPECT_GT(result.qor().flop_count(), 0);
+  EXPECT_GT(result.qor().verilog_line_count(), 0);
+}
+
+TEST(CompileBenchmarkTest, RecordsFailures) {
+  CompileBenchmarkDesignProto design =
+      ParseTextProtoOrDie<CompileBenchmarkDesignProto>(R"pb(
+        name: "missing" dslx_path: "/does/not/exist.x" top: "f"
+      )pb");
+  CompileBenchmarkResultProto result = RunCompileBenchmark(
+      design, {.dslx_stdlib_path = kDefaultDslxStdlibPath});
+  EXPECT_THAT(result.error(), Not(IsEmpty()));
+  ASSERT_EQ(result.phases_size(), 1);
+  EXPECT_EQ(result.phases(0).name(), "ir_conversion");
+}
+
+TEST(CompileBenchmarkTest, FindsRegressions) {
+  auto baseline = ParseTextProtoOrDie<CompileBenchmarkResultsProto>(R"pb(
+    revision: "a"
+    results {
+      design: "fast"
+      phases { name: "optimization" wall_time_us: 1000000 peak_rss_kb: 1000 }
+      phases { name: "codegen" wall_time_us: 1000 peak_rss_kb: 1000 }
+      qor { node_count: 10 pipeline_stages: 2 flop_count: 64 }
+    }
+    results { design: "broken" error: "INTERNAL: oops" }
+    results { design: "gone" }
+  )pb");
+  auto current = ParseTextProtoOrDie<CompileBenchmarkResultsProto>(R"pb(
+    revision: "b"
+    results {
+      design: "fast"
+      phases { name: "optimization" wall_time_us: 1200000 peak_rss_kb: 1050 }
+      phases { name: "codegen" wall_time_us: 5000 peak_rss_kb: 1000 }
+      qor { node_count: 10 pipeline_stages: 2 flop_count: 65 }
+    }
+    results { design: "broken" error: "INTERNAL: oops" }
+  )pb");
+
+  EXPECT_THAT(FindCompileBenchmarkRegressions(baseline, current, {}),
+              ElementsAre(HasSubstr("fast: optimization wall time"),
+                          HasSubstr("fast: flop count 64 -> 65"),
+                          HasSubstr("gone: missing")));
+  EXPECT_THAT(FindCompileBenchmarkRegressions(
+                  baseline, current, {.wall_time = 0.5, .qor = 0.1}),
+              ElementsAre(HasSubstr("gone: missing")));
+  EXPECT_THAT(FindCompileBenchmarkRegressions(current, current, {}),
+              IsEmpty());
+}
+
+}  // namespace
+}  // namespace xls
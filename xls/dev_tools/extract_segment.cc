@@ -14,8 +14,9 @@
 
 #include "xls/dev_tools/extract_segment.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
-#include <optional>
 #include <string_view>
 #include <vector>
 
@@ -27,6 +28,8 @@
 #include "absl/types/span.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/data_structures/inline_bitmap.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
@@ -36,77 +39,153 @@
 #include "xls/ir/package.h"
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
-#include "xls/passes/node_dependency_analysis.h"
 
 namespace xls {
 
 namespace {
 
+// Connectivity of a function base computed once and shared by every segment
+// extracted from it. Nodes are numbered in topological order, so the nodes of
+// a segment are visited in that order by sorting their indices.
+class SegmentIndex {
+ public:
+  explicit SegmentIndex(FunctionBase* full) : nodes_(TopoSort(full)) {
+    indices_.reserve(nodes_.size());
+    for (int64_t i = 0; i < nodes_.size(); ++i) {
+      indices_[nodes_[i]] = i;
+    }
+    operands_.resize(nodes_.size());
+    users_.resize(nodes_.size());
+    for (int64_t i = 0; i < nodes_.size(); ++i) {
+      for (Node* operand : nodes_[i]->operands()) {
+        operands_[i].push_back(indices_.at(operand));
+      }
+      for (Node* user : nodes_[i]->users()) {
+        users_[i].push_back(indices_.at(user));
+      }
+    }
+  }
+
+  int64_t node_count() const { return nodes_.size(); }
+  Node* node(int64_t index) const { return nodes_[index]; }
+  absl::Span<const int64_t> operands(int64_t index) const {
+    return operands_[index];
+  }
+  absl::Span<const int64_t> users(int64_t index) const {
+    return users_[index];
+  }
+  absl::StatusOr<int64_t> IndexOf(Node* node) const {
+    auto it = indices_.find(node);
+    if (it == indices_.end()) {
+      return absl::InvalidArgumentError("node is from a different function!");
+    }
+    return it->second;
+  }
+
+ private:
+  std::vector<Node*> nodes_;
+  absl::flat_hash_map<Node*, int64_t> indices_;
+  std::vector<std::vector<int64_t>> operands_;
+  std::vector<std::vector<int64_t>> users_;
+};
+
+// Marks in 'visited' the nodes reachable from 'roots' through users (if
+// 'forward') or operands, including the roots themselves, and returns their
+// indices. If 'within' is given the walk does not leave the nodes it marks.
+absl::StatusOr<std::vector<int64_t>> MarkCone(const SegmentIndex& index,
+                                              absl::Span<Node* const> roots,
+                                              bool forward,
+                                              const InlineBitmap* within,
+                                              InlineBitmap& visited) {
+  std::vector<int64_t> cone;
+  auto visit = [&](int64_t i) {
+    if (!visited.Get(i) && (within == nullptr || within->Get(i))) {
+      visited.Set(i);
+      cone.push_back(i);
+    }
+  };
+  for (Node* root : roots) {
+    XLS_ASSIGN_OR_RETURN(int64_t i, index.IndexOf(root));
+    visit(i);
+  }
+  // 'cone' doubles as the worklist.
+  for (int64_t next = 0; next < cone.size(); ++next) {
+    int64_t i = cone[next];
+    for (int64_t neighbor : forward ? index.users(i) : index.operands(i)) {
+      visit(neighbor);
+    }
+  }
+  return cone;
+}
+
 absl::StatusOr<BValue> ExtractSegmentInto(FunctionBuilder& dest,
+                                          const SegmentIndex& index,
                                           FunctionBase* full,
                                           absl::Span<Node* const> source_nodes,
                                           absl::Span<Node* const> sink_nodes,
                                           bool next_nodes_are_tuples) {
-  // Get node dependency information.
-  std::optional<NodeDependencyAnalysis> forward_analysis;
-  std::optional<NodeDependencyAnalysis> backward_analysis;
-  std::vector<DependencyBitmap> forward_bitmaps;
-  std::vector<DependencyBitmap> backward_bitmaps;
-  if (!source_nodes.empty()) {
-    forward_analysis =
-        NodeDependencyAnalysis::ForwardDependents(full, source_nodes);
-    for (auto n : source_nodes) {
-      XLS_ASSIGN_OR_RETURN(auto dep, forward_analysis->GetDependents(n));
-      forward_bitmaps.push_back(dep);
-    }
+  // The segment is the nodes which are fed by some source and feed some sink.
+  // Only the cones of the sources and sinks are walked.
+  const int64_t node_count = index.node_count();
+  InlineBitmap in_segment(node_count);
+  std::vector<int64_t> segment;
+  if (source_nodes.empty() && sink_nodes.empty()) {
+    in_segment.SetRange(0, node_count);
+    segment.resize(node_count);
+    absl::c_iota(segment, 0);
+  } else if (source_nodes.empty()) {
+    XLS_ASSIGN_OR_RETURN(segment,
+                         MarkCone(index, sink_nodes, /*forward=*/false,
+                                  /*within=*/nullptr, in_segment));
+  } else if (sink_nodes.empty()) {
+    XLS_ASSIGN_OR_RETURN(segment,
+                         MarkCone(index, source_nodes, /*forward=*/true,
+                                  /*within=*/nullptr, in_segment));
+  } else {
+    // Every node on a path from a source to a node feeding a sink also feeds
+    // the sink, so the forward walk can stay within the sinks' cone.
+    InlineBitmap feeds_sink(node_count);
+    XLS_RETURN_IF_ERROR(MarkCone(index, sink_nodes, /*forward=*/false,
+                                 /*within=*/nullptr, feeds_sink)
+                            .status());
+    XLS_ASSIGN_OR_RETURN(segment, MarkCone(index, source_nodes,
+                                           /*forward=*/true, &feeds_sink,
+                                           in_segment));
   }
-  if (!sink_nodes.empty()) {
-    backward_analysis =
-        NodeDependencyAnalysis::BackwardDependents(full, sink_nodes);
-    for (auto n : sink_nodes) {
-      XLS_ASSIGN_OR_RETURN(auto dep, backward_analysis->GetDependents(n));
-      backward_bitmaps.push_back(dep);
+
+  // Visit the segment, along with the nodes outside it which feed it, in
+  // topological order.
+  std::vector<int64_t> order = segment;
+  InlineBitmap visited = in_segment;
+  for (int64_t i : segment) {
+    for (int64_t operand : index.operands(i)) {
+      if (!visited.Get(operand)) {
+        visited.Set(operand);
+        order.push_back(operand);
+      }
     }
   }
-  auto is_forward_dep = [&](Node* n) -> bool {
-    return forward_bitmaps.empty() ||
-           absl::c_any_of(forward_bitmaps, [&](DependencyBitmap db) {
-             return *db.IsDependent(n);
-           });
-  };
-  auto is_backward_dep = [&](Node* n) -> bool {
-    return backward_bitmaps.empty() ||
-           absl::c_any_of(backward_bitmaps, [&](DependencyBitmap db) {
-             return *db.IsDependent(n);
-           });
-  };
-  auto is_dep = [&](Node* n) -> bool {
-    return is_forward_dep(n) && is_backward_dep(n);
-  };
-  auto is_used_by_dep = [&](Node* n) -> bool {
-    const auto& users = n->users();
-    return absl::c_any_of(users, [&](Node* u) { return is_dep(u); });
-  };
+  absl::c_sort(order);
+
   Package* dest_pkg = dest.function()->package();
   std::vector<Node*> outputs;
   absl::flat_hash_map<Node*, Node*> old_to_new;
-  for (Node* n : TopoSort(full)) {
-    if (!is_dep(n)) {
-      if (is_used_by_dep(n)) {
-        // Add a param/literal
-        if (n->Is<Literal>()) {
-          old_to_new[n] =
-              dest.Literal(n->As<Literal>()->value(), n->loc(), n->GetName())
-                  .node();
-        } else {
-          old_to_new[n] =
-              dest.Param(
-                      absl::StrFormat("param_for_%s_id%d", n->GetName(),
-                                      n->id()),
-                      dest_pkg->MapTypeFromOtherPackage(n->GetType()).value(),
-                      n->loc())
-                  .node();
-        }
+  for (int64_t i : order) {
+    Node* n = index.node(i);
+    if (!in_segment.Get(i)) {
+      // Add a param/literal
+      if (n->Is<Literal>()) {
+        old_to_new[n] =
+            dest.Literal(n->As<Literal>()->value(), n->loc(), n->GetName())
+                .node();
+      } else {
+        old_to_new[n] =
+            dest.Param(
+                    absl::StrFormat("param_for_%s_id%d", n->GetName(),
+                                    n->id()),
+                    dest_pkg->MapTypeFromOtherPackage(n->GetType()).value(),
+                    n->loc())
+                .node();
       }
       continue;
     }
@@ -197,30 +276,85 @@ absl::StatusOr<BValue> ExtractSegmentInto(FunctionBuilder& dest,
   return dest.Tuple(res);
 }
 
-}  // namespace
-
-absl::StatusOr<std::unique_ptr<Package>> ExtractSegmentInNewPackage(
-    FunctionBase* full, absl::Span<Node* const> source_nodes,
-    absl::Span<Node* const> sink_nodes, std::string_view extracted_package_name,
+absl::StatusOr<std::unique_ptr<Package>> ExtractSegmentWithIndex(
+    const SegmentIndex& index, FunctionBase* full,
+    absl::Span<Node* const> source_nodes, absl::Span<Node* const> sink_nodes,
+    std::string_view extracted_package_name,
     std::string_view extracted_function_name, bool next_nodes_are_tuples) {
   std::unique_ptr<Package> pkg =
       std::make_unique<Package>(extracted_package_name);
   FunctionBuilder fb(extracted_function_name, pkg.get());
   XLS_ASSIGN_OR_RETURN(auto res,
-                       ExtractSegmentInto(fb, full, source_nodes, sink_nodes,
-                                          next_nodes_are_tuples));
+                       ExtractSegmentInto(fb, index, full, source_nodes,
+                                          sink_nodes, next_nodes_are_tuples));
   XLS_RETURN_IF_ERROR(fb.SetAsTop());
   XLS_RETURN_IF_ERROR(fb.BuildWithReturnValue(res).status());
   return pkg;
 }
 
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<Package>> ExtractSegmentInNewPackage(
+    FunctionBase* full, absl::Span<Node* const> source_nodes,
+    absl::Span<Node* const> sink_nodes, std::string_view extracted_package_name,
+    std::string_view extracted_function_name, bool next_nodes_are_tuples) {
+  return ExtractSegmentWithIndex(
+      SegmentIndex(full), full, source_nodes, sink_nodes,
+      extracted_package_name, extracted_function_name, next_nodes_are_tuples);
+}
+
+absl::StatusOr<std::vector<std::unique_ptr<Package>>>
+ExtractSegmentsInNewPackages(FunctionBase* full,
+                             absl::Span<const SegmentSpec> segments,
+                             bool next_nodes_are_tuples,
+                             int64_t thread_count) {
+  const SegmentIndex index(full);
+  // Each segment is built in its own package and only reads 'full', so the
+  // segments can be extracted concurrently. Thread i extracts every
+  // 'thread_count'th segment starting at i.
+  std::vector<absl::StatusOr<std::unique_ptr<Package>>> extracted(
+      segments.size());
+  thread_count = std::max<int64_t>(
+      std::min<int64_t>(thread_count, segments.size()), 1);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t t = 0; t < thread_count; ++t) {
+      auto extract = [&, t] {
+        for (int64_t i = t; i < segments.size(); i += thread_count) {
+          const SegmentSpec& segment = segments[i];
+          extracted[i] = ExtractSegmentWithIndex(
+              index, full, segment.source_nodes, segment.sink_nodes,
+              segment.package_name, segment.function_name,
+              next_nodes_are_tuples);
+        }
+      };
+      if (t + 1 == thread_count) {
+        extract();
+      } else {
+        threads.push_back(std::make_unique<Thread>(extract));
+      }
+    }
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+  }
+  std::vector<std::unique_ptr<Package>> packages;
+  packages.reserve(extracted.size());
+  for (absl::StatusOr<std::unique_ptr<Package>>& package : extracted) {
+    XLS_RETURN_IF_ERROR(package.status());
+    packages.push_back(*std::move(package));
+  }
+  return packages;
+}
+
 absl::StatusOr<Function*> ExtractSegment(
     FunctionBase* full, absl::Span<Node* const> source_nodes,
     absl::Span<Node* const> sink_nodes,
     std::string_view extracted_function_name, bool next_nodes_are_tuples) {
   FunctionBuilder fb(extracted_function_name, full->package());
   XLS_ASSIGN_OR_RETURN(auto res,
-                       ExtractSegmentInto(fb, full, source_nodes, sink_nodes,
+                       ExtractSegmentInto(fb, SegmentIndex(full), full,
+                                          source_nodes, sink_nodes,
                                           next_nodes_are_tuples));
   return fb.BuildWithReturnValue(res);
 }
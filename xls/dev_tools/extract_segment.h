@@ -15,8 +15,11 @@
 #ifndef XLS_DEV_TOOLS_EXTRACT_SEGMENT_H_
 #define XLS_DEV_TOOLS_EXTRACT_SEGMENT_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
@@ -40,6 +43,29 @@ absl::StatusOr<std::unique_ptr<Package>> ExtractSegmentInNewPackage(
     std::string_view extracted_function_name,
     bool next_nodes_are_tuples = true);
 
+// A segment to extract with ExtractSegmentsInNewPackages, as specified by the
+// arguments of ExtractSegmentInNewPackage.
+struct SegmentSpec {
+  std::vector<Node*> source_nodes;
+  std::vector<Node*> sink_nodes;
+  std::string package_name;
+  std::string function_name;
+};
+
+// Extracts each of 'segments' from 'full' into a new package as
+// ExtractSegmentInNewPackage does, returning the packages in the same order.
+//
+// The connectivity of 'full' is indexed once for all the segments, and each
+// segment walks only the cones of its source and sink nodes, so extracting
+// many small segments from a large function is much cheaper than extracting
+// them one at a time. The segments are extracted on up to 'thread_count'
+// threads; 'full' must not be modified until this returns.
+absl::StatusOr<std::vector<std::unique_ptr<Package>>>
+ExtractSegmentsInNewPackages(FunctionBase* full,
+                             absl::Span<const SegmentSpec> segments,
+                             bool next_nodes_are_tuples = true,
+                             int64_t thread_count = 1);
+
 // Create a new function in the current package which contains nodes in 'full'
 // which are dominated by some 'source_nodes' and dominate some 'sink_nodes'. If
 // no source or sink nodes are present all nodes are considered to be in the
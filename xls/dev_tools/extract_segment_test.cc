@@ -14,6 +14,10 @@
 
 #include "xls/dev_tools/extract_segment.h"
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/common/status/matchers.h"
@@ -21,6 +25,7 @@
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
 
 namespace m = xls::op_matchers;
 
@@ -123,5 +128,48 @@ TEST_F(ExtractSegmentTest, NextNodesAsTuples) {
                                                  m::Param("c")));
 }
 
+TEST_F(ExtractSegmentTest, ExtractManySegments) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  auto a = fb.Param("a", p->GetBitsType(32));
+  auto b = fb.Param("b", p->GetBitsType(32));
+  auto c = fb.Param("c", p->GetBitsType(32));
+  auto d = fb.Param("d", p->GetBitsType(32));
+  auto ab = fb.Add(a, fb.Not(b));
+  auto nab = fb.Add(fb.Literal(UBits(32, 32)), ab);
+  auto cd = fb.Add(c, d);
+  auto res = fb.Add(nab, cd);
+  XLS_ASSERT_OK_AND_ASSIGN(auto* f, fb.Build());
+  std::vector<SegmentSpec> segments = {
+      {.source_nodes = {a.node()}, .function_name = "from_a"},
+      {.sink_nodes = {nab.node()}, .function_name = "to_nab"},
+      {.source_nodes = {b.node()},
+       .sink_nodes = {res.node()},
+       .function_name = "b_to_res"},
+      {.sink_nodes = {ab.node(), cd.node()}, .function_name = "to_ab_cd"},
+  };
+  for (SegmentSpec& segment : segments) {
+    segment.package_name = segment.function_name;
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::unique_ptr<Package>> packages,
+      ExtractSegmentsInNewPackages(f, segments, /*next_nodes_are_tuples=*/true,
+                                   /*thread_count=*/3));
+  ASSERT_EQ(packages.size(), segments.size());
+  for (int64_t i = 0; i < segments.size(); ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<Package> expected,
+        ExtractSegmentInNewPackage(f, segments[i].source_nodes,
+                                   segments[i].sink_nodes,
+                                   segments[i].package_name,
+                                   segments[i].function_name));
+    EXPECT_EQ(packages[i]->DumpIr(), expected->DumpIr());
+  }
+  EXPECT_THAT(packages[2]->GetTopAsFunction().value()->return_value(),
+              m::Add(m::Add(m::Literal(UBits(32, 32)),
+                            m::Add(m::Param(), m::Not(m::Param("b")))),
+                     m::Param()));
+}
+
 }  // namespace
 }  // namespace xls
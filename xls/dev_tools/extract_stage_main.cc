@@ -24,6 +24,7 @@
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/scheduling/extract_stage.h"
@@ -69,10 +70,10 @@ static absl::Status RealMain(const std::string& ir_path,
   std::vector<FunctionBase*> funcs = package->GetFunctionBases();
 
   if (stage == -1) {
-    for (int i = 0; i < schedule.length(); ++i) {
-      XLS_ASSIGN_OR_RETURN(Function * stage,
-                           ExtractStage(function, schedule, i));
-      XLS_RETURN_IF_ERROR(package->SetTop(stage));
+    XLS_ASSIGN_OR_RETURN(std::vector<Function*> stages,
+                         ExtractStages(function, schedule));
+    if (!stages.empty()) {
+      XLS_RETURN_IF_ERROR(package->SetTop(stages.back()));
     }
   } else {
     XLS_ASSIGN_OR_RETURN(Function * stage,
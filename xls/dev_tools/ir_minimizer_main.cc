@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
@@ -51,6 +52,7 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/subprocess.h"
+#include "xls/common/thread.h"
 #include "xls/data_structures/binary_search.h"
 #include "xls/data_structures/inline_bitmap.h"
 #include "xls/dev_tools/extract_segment.h"
@@ -69,6 +71,7 @@
 #include "xls/ir/package.h"
 #include "xls/ir/source_location.h"
 #include "xls/ir/state_element.h"
+#include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
@@ -230,6 +233,17 @@ ABSL_FLAG(
 ABSL_FLAG(
     bool, can_inline, true,
     "Whether individual invokes & maps can be inlined as a simplification.");
+ABSL_FLAG(
+    bool, ddmin, false,
+    "Before the randomized simplifications, reduce the top function by delta "
+    "debugging: try replacing chunks of its nodes with zero literals (and "
+    "removing the logic which becomes dead), starting with large chunks and "
+    "halving them whenever none can be replaced. Candidate reductions are "
+    "tested in parallel (see --parallelism), so this quickly removes large "
+    "subgraphs from big inputs. Only applies when top is a function.");
+ABSL_FLAG(int64_t, parallelism, 0,
+          "Number of candidate reductions to test at once with --ddmin. If "
+          "zero, the number of available CPUs is used.");
 
 namespace xls {
 namespace {
@@ -1221,6 +1235,187 @@ absl::Status CleanUp(FunctionBase* f, bool can_remove_params) {
   return absl::OkStatus();
 }
 
+// A delta debugging candidate: the IR which results from replacing some nodes
+// of the top function with zero literals.
+struct DeltaCandidate {
+  std::string ir_text;
+  int64_t node_count;
+};
+
+// Returns the ids of the nodes of `f` which delta debugging may replace with a
+// literal, users before operands so that chunks of consecutive ids cover the
+// cones feeding the function's outputs.
+std::vector<int64_t> ReplaceableNodeIds(Function* f) {
+  std::vector<int64_t> ids;
+  for (Node* node : ReverseTopoSort(f)) {
+    if (node->Is<Param>() || node->Is<Literal>() ||
+        TypeHasToken(node->GetType())) {
+      continue;
+    }
+    ids.push_back(node->id());
+  }
+  return ids;
+}
+
+// Returns the IR of `ir_text` with the nodes of the top function with the
+// given ids (or all other replaceable nodes, if `complement`) replaced with
+// zero literals and cleaned up.
+absl::StatusOr<DeltaCandidate> MakeDeltaCandidate(
+    std::string_view ir_text, absl::Span<const int64_t> node_ids,
+    bool complement, bool can_remove_params) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package, ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(Function * f, package->GetTopAsFunction());
+  std::vector<int64_t> to_replace;
+  if (complement) {
+    absl::flat_hash_set<int64_t> kept(node_ids.begin(), node_ids.end());
+    for (int64_t id : ReplaceableNodeIds(f)) {
+      if (!kept.contains(id)) {
+        to_replace.push_back(id);
+      }
+    }
+  } else {
+    to_replace.assign(node_ids.begin(), node_ids.end());
+  }
+  for (int64_t id : to_replace) {
+    XLS_ASSIGN_OR_RETURN(Node * node, f->GetNodeById(id));
+    XLS_RETURN_IF_ERROR(
+        node->ReplaceUsesWithNew<Literal>(ZeroOfType(node->GetType()))
+            .status());
+  }
+  XLS_RETURN_IF_ERROR(CleanUp(f, can_remove_params));
+  return DeltaCandidate{.ir_text = package->DumpIr(),
+                        .node_count = package->GetNodeCount()};
+}
+
+// Tests the given candidates on up to `parallelism` threads and returns
+// whether each still fails. Only results not found in `test_cache` are
+// computed; they are added to it afterwards.
+absl::StatusOr<std::vector<bool>> StillFailsInParallel(
+    absl::Span<const DeltaCandidate> candidates,
+    const std::optional<std::vector<Value>>& inputs, int64_t parallelism,
+    absl::flat_hash_map<std::string, bool>& test_cache) {
+  std::vector<bool> results(candidates.size());
+  std::vector<int64_t> untested;
+  for (int64_t i = 0; i < candidates.size(); ++i) {
+    auto it = test_cache.find(candidates[i].ir_text);
+    if (it == test_cache.end()) {
+      untested.push_back(i);
+    } else {
+      results[i] = it->second;
+    }
+  }
+
+  std::vector<absl::StatusOr<bool>> untested_results(untested.size());
+  std::atomic<int64_t> next = 0;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t t = 0; t < std::min<int64_t>(parallelism, untested.size());
+       ++t) {
+    threads.push_back(std::make_unique<Thread>([&] {
+      for (int64_t i = next++; i < untested.size(); i = next++) {
+        untested_results[i] =
+            StillFailsHelper(candidates[untested[i]].ir_text, inputs);
+      }
+    }));
+  }
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+
+  for (int64_t i = 0; i < untested.size(); ++i) {
+    XLS_ASSIGN_OR_RETURN(bool still_fails, untested_results[i]);
+    test_cache[candidates[untested[i]].ir_text] = still_fails;
+    results[untested[i]] = still_fails;
+  }
+  return results;
+}
+
+// Reduces the top function of `knownf_ir_text` (which must fail) by
+// hierarchical delta debugging over its nodes, and returns the reduced IR,
+// which still fails.
+//
+// At granularity n the replaceable nodes are split into n chunks, and the
+// candidates replacing each chunk (or, for n > 2, everything but each chunk)
+// are tested `parallelism` at a time. The smallest failing candidate of the
+// first batch with any is kept and the granularity lowered again; if none
+// fails, the granularity doubles, until it reaches single nodes.
+absl::StatusOr<std::string> DeltaDebug(
+    std::string knownf_ir_text, const std::optional<std::vector<Value>>& inputs,
+    bool can_remove_params, int64_t parallelism,
+    absl::flat_hash_map<std::string, bool>& test_cache) {
+  int64_t granularity = 2;
+  while (true) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                         ParsePackage(knownf_ir_text));
+    absl::StatusOr<Function*> top = package->GetTopAsFunction();
+    if (!top.ok()) {
+      LOG(INFO) << "=== Top is not a function; skipping delta debugging";
+      return knownf_ir_text;
+    }
+    std::vector<int64_t> node_ids = ReplaceableNodeIds(*top);
+    if (node_ids.empty()) {
+      break;
+    }
+    granularity = std::min<int64_t>(granularity, node_ids.size());
+    LOG(INFO) << absl::StreamFormat(
+        "=== Delta debugging %d nodes (%d replaceable) at granularity %d",
+        package->GetNodeCount(), node_ids.size(), granularity);
+
+    // Chunk i covers node_ids[bounds[i], bounds[i + 1]).
+    std::vector<int64_t> bounds;
+    for (int64_t i = 0; i <= granularity; ++i) {
+      bounds.push_back(i * static_cast<int64_t>(node_ids.size()) /
+                       granularity);
+    }
+    int64_t candidate_count = granularity > 2 ? 2 * granularity : granularity;
+    std::optional<DeltaCandidate> reduced;
+    for (int64_t batch_start = 0; batch_start < candidate_count;
+         batch_start += parallelism) {
+      std::vector<DeltaCandidate> batch;
+      for (int64_t c = batch_start;
+           c < std::min(candidate_count, batch_start + parallelism); ++c) {
+        int64_t chunk = c % granularity;
+        XLS_ASSIGN_OR_RETURN(
+            DeltaCandidate candidate,
+            MakeDeltaCandidate(
+                knownf_ir_text,
+                absl::MakeConstSpan(node_ids).subspan(
+                    bounds[chunk], bounds[chunk + 1] - bounds[chunk]),
+                /*complement=*/c >= granularity, can_remove_params));
+        if (candidate.ir_text != knownf_ir_text) {
+          batch.push_back(std::move(candidate));
+        }
+      }
+      XLS_ASSIGN_OR_RETURN(
+          std::vector<bool> still_fails,
+          StillFailsInParallel(batch, inputs, parallelism, test_cache));
+      for (int64_t i = 0; i < batch.size(); ++i) {
+        if (still_fails[i] &&
+            (!reduced.has_value() ||
+             batch[i].node_count < reduced->node_count)) {
+          reduced = std::move(batch[i]);
+        }
+      }
+      if (reduced.has_value()) {
+        break;
+      }
+    }
+
+    if (reduced.has_value()) {
+      LOG(INFO) << absl::StreamFormat(
+          "=== Delta debugging reduced %d to %d nodes",
+          package->GetNodeCount(), reduced->node_count);
+      knownf_ir_text = std::move(reduced->ir_text);
+      granularity = std::max<int64_t>(granularity - 1, 2);
+      continue;
+    }
+    if (granularity >= node_ids.size()) {
+      break;
+    }
+    granularity = std::min<int64_t>(2 * granularity, node_ids.size());
+  }
+  return knownf_ir_text;
+}
+
 absl::Status RealMain(std::string_view path, const int64_t failed_attempt_limit,
                       const int64_t total_attempt_limit,
                       const int64_t simplifications_between_tests,
@@ -1272,6 +1467,17 @@ absl::Status RealMain(std::string_view path, const int64_t failed_attempt_limit,
     LOG(INFO) << "=== Done cleaning up initial garbage";
   }
 
+  if (absl::GetFlag(FLAGS_ddmin)) {
+    int64_t parallelism = absl::GetFlag(FLAGS_parallelism);
+    if (parallelism <= 0) {
+      parallelism = std::max(AvailableCPUs(), 1);
+    }
+    XLS_ASSIGN_OR_RETURN(
+        knownf_ir_text,
+        DeltaDebug(std::move(knownf_ir_text), inputs, can_remove_params,
+                   parallelism, test_cache));
+  }
+
   // If so, we start simplifying via this seeded RNG.
   std::mt19937 rng;  // Default constructor uses deterministic seed.
 
@@ -364,6 +364,30 @@ class IrMinimizerMainTest(absltest.TestCase):
     self.assertNotIn('x: bits', minimized_ir)
     self.assertNotIn('y: bits', minimized_ir)
 
+  def test_ddmin_replaces_nodes_with_literals(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    test_sh_file = self.create_tempfile()
+    self._write_sh_script(
+        test_sh_file.full_path, ['/usr/bin/env grep myadd $1']
+    )
+    minimized_ir = subprocess.check_output(
+        [
+            IR_MINIMIZER_MAIN_PATH,
+            '--test_executable=' + test_sh_file.full_path,
+            '--can_remove_params=false',
+            '--ddmin',
+            '--parallelism=4',
+            # Skip the randomized simplifications to only see delta debugging.
+            '--failed_attempt_limit=0',
+            ir_file.full_path,
+        ],
+        encoding='utf-8',
+    )
+    self._maybe_record_property('output', minimized_ir)
+    self.assertIn('myadd', minimized_ir)
+    self.assertNotIn('mynot', minimized_ir)
+    self.assertEqual(node_count(minimized_ir, 'literal'), 1)
+
   def test_no_reduction_possible(self):
     ir_file = self.create_tempfile(content=ADD_IR)
     test_sh_file = self.create_tempfile()
@@ -15,6 +15,7 @@
 // Prints summary information about an IR file to the terminal.
 // Output will be added as needs warrant, so feel free to make additions!
 
+#include <cstdint>
 #include <iostream>
 #include <optional>
 #include <string>
@@ -28,7 +29,11 @@
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
 
 ABSL_FLAG(
     std::string, top, "",
@@ -38,6 +43,40 @@ ABSL_FLAG(
 
 namespace xls {
 
+// Returns an estimate of the memory used by the nodes of `f`: the base Node
+// object of each (fields of derived node classes are not counted), and its
+// operand and user lists where these do not fit inline.
+static int64_t EstimateNodeBytes(FunctionBase* f) {
+  constexpr int64_t kInlineNodeCount = 2;
+  int64_t bytes = 0;
+  for (Node* node : f->nodes()) {
+    bytes += sizeof(Node);
+    if (node->operand_count() > kInlineNodeCount) {
+      bytes += node->operand_count() * sizeof(Node*);
+    }
+    if (node->users().size() > kInlineNodeCount) {
+      bytes += node->users().size() * sizeof(Node*);
+    }
+  }
+  return bytes;
+}
+
+static void PrintMemoryFootprint(Package* package) {
+  int64_t node_bytes = 0;
+  for (FunctionBase* f : package->GetFunctionBases()) {
+    node_bytes += EstimateNodeBytes(f);
+  }
+  std::cout << "Memory footprint (estimated):" << '\n';
+  std::cout << "  Nodes: " << package->GetNodeCount() << " ("
+            << sizeof(Node) << " bytes each)" << '\n';
+  std::cout << "  Node storage: " << node_bytes << " bytes" << '\n';
+  std::cout << "  Interned source infos: "
+            << package->interned_source_info_count() << " ("
+            << sizeof(SourceInfo) << " bytes each plus locations)" << '\n';
+  std::cout << "  Interned node names: " << package->interned_node_name_count()
+            << '\n';
+}
+
 static absl::Status RealMain(std::string_view ir_path,
                              std::optional<std::string> restrict_fn) {
   XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(ir_path));
@@ -53,6 +92,7 @@ static absl::Status RealMain(std::string_view ir_path,
     std::cout << "    Nodes: " << f->node_count() << '\n';
     std::cout << '\n';
   }
+  PrintMemoryFootprint(package.get());
   return absl::OkStatus();
 }
 
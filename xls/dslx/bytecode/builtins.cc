@@ -62,7 +62,7 @@ absl::Status RunBinaryBuiltin(
   XLS_ASSIGN_OR_RETURN(InterpValue b, stack.Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue a, stack.Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue result, fn(a, b));
-  stack.Push(result);
+  stack.Push(std::move(result));
   return absl::OkStatus();
 }
 
@@ -75,7 +75,7 @@ absl::Status RunTernaryBuiltin(
   XLS_ASSIGN_OR_RETURN(InterpValue b, stack.Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue a, stack.Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue result, fn(a, b, c));
-  stack.Push(result);
+  stack.Push(std::move(result));
   return absl::OkStatus();
 }
 
@@ -94,12 +94,16 @@ absl::Status RunBuiltinArraySlice(const Bytecode& bytecode,
 
 absl::Status RunBuiltinUpdate(const Bytecode& bytecode,
                               InterpreterStack& stack) {
-  return RunTernaryBuiltin(
-      [](const InterpValue& array, const InterpValue& index,
-         const InterpValue& new_value) {
-        return array.Update(index, new_value);
-      },
-      stack);
+  // The array is popped rather than passed to a RunTernaryBuiltin() callback
+  // so that, when it is not shared, it is updated in place.
+  XLS_RET_CHECK_GE(stack.size(), 3);
+  XLS_ASSIGN_OR_RETURN(InterpValue new_value, stack.Pop());
+  XLS_ASSIGN_OR_RETURN(InterpValue index, stack.Pop());
+  XLS_ASSIGN_OR_RETURN(InterpValue array, stack.Pop());
+  XLS_ASSIGN_OR_RETURN(InterpValue result,
+                       std::move(array).Update(index, new_value));
+  stack.Push(std::move(result));
+  return absl::OkStatus();
 }
 
 absl::Status RunBuiltinBitSlice(const Bytecode& bytecode,
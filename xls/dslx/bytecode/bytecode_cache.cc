@@ -20,6 +20,7 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/dslx/bytecode/bytecode.h"
@@ -39,6 +40,7 @@ absl::StatusOr<BytecodeFunction*> BytecodeCache::GetOrCreateBytecodeFunction(
     const std::optional<ParametricEnv>& caller_bindings) {
   XLS_RET_CHECK(type_info != nullptr);
   Key key = std::make_tuple(&f, type_info, caller_bindings);
+  absl::MutexLock lock(&mutex_);
   if (!cache_.contains(key)) {
     XLS_ASSIGN_OR_RETURN(
         std::unique_ptr<BytecodeFunction> bf,
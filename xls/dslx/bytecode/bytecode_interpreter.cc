@@ -273,6 +273,10 @@ absl::Status BytecodeInterpreter::EvalNextInstruction() {
   const Bytecode& bytecode = bytecodes.at(frame->pc());
   VLOG(10) << "Running bytecode: " << bytecode.ToString(file_table())
            << " depth before: " << stack_.size();
+  if (TryEvalNarrowBinop(bytecode.op())) {
+    frame->IncrementPc();
+    return absl::OkStatus();
+  }
   switch (bytecode.op()) {
     case Bytecode::Op::kUAdd: {
       XLS_RETURN_IF_ERROR(EvalAdd(bytecode, /*is_signed=*/false));
@@ -503,6 +507,99 @@ absl::Status BytecodeInterpreter::EvalBinop(
   return absl::OkStatus();
 }
 
+bool BytecodeInterpreter::TryEvalNarrowBinop(Bytecode::Op op) {
+  switch (op) {
+    case Bytecode::Op::kUAdd:
+    case Bytecode::Op::kSAdd:
+    case Bytecode::Op::kUSub:
+    case Bytecode::Op::kSSub:
+    case Bytecode::Op::kUMul:
+    case Bytecode::Op::kSMul:
+      // The rollover hook needs the full precision result.
+      if (options_.rollover_hook() != nullptr) {
+        return false;
+      }
+      break;
+    case Bytecode::Op::kAnd:
+    case Bytecode::Op::kOr:
+    case Bytecode::Op::kXor:
+    case Bytecode::Op::kEq:
+    case Bytecode::Op::kNe:
+    case Bytecode::Op::kLt:
+    case Bytecode::Op::kLe:
+    case Bytecode::Op::kGt:
+    case Bytecode::Op::kGe:
+      break;
+    default:
+      return false;
+  }
+  if (stack_.size() < 2) {
+    return false;
+  }
+  const InterpValue& lhs = stack_.PeekOrDie(1);
+  const InterpValue& rhs = stack_.PeekOrDie(0);
+  if (!lhs.IsBits() || lhs.tag() != rhs.tag()) {
+    return false;
+  }
+  const Bits& lhs_bits = lhs.GetBitsOrDie();
+  const Bits& rhs_bits = rhs.GetBitsOrDie();
+  const int64_t width = lhs_bits.bit_count();
+  if (width == 0 || width > 64 || rhs_bits.bit_count() != width) {
+    return false;
+  }
+  const bool is_signed = lhs.IsSBits();
+  const uint64_t a = lhs_bits.bitmap().GetWord(0);
+  const uint64_t b = rhs_bits.bitmap().GetWord(0);
+  const uint64_t mask =
+      width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+  // Comparisons are done on the values sign-extended to 64 bits.
+  auto extend = [&](uint64_t x) -> int64_t {
+    return static_cast<int64_t>(x << (64 - width)) >> (64 - width);
+  };
+  auto less_than = [&](uint64_t x, uint64_t y) {
+    return is_signed ? extend(x) < extend(y) : x < y;
+  };
+  auto bits = [&](uint64_t value) {
+    return InterpValue::MakeBits(is_signed, UBits(value & mask, width));
+  };
+
+  InterpValue result = [&] {
+    switch (op) {
+      case Bytecode::Op::kUAdd:
+      case Bytecode::Op::kSAdd:
+        return bits(a + b);
+      case Bytecode::Op::kUSub:
+      case Bytecode::Op::kSSub:
+        return bits(a - b);
+      case Bytecode::Op::kUMul:
+      case Bytecode::Op::kSMul:
+        return bits(a * b);
+      case Bytecode::Op::kAnd:
+        return bits(a & b);
+      case Bytecode::Op::kOr:
+        return bits(a | b);
+      case Bytecode::Op::kXor:
+        return bits(a ^ b);
+      case Bytecode::Op::kEq:
+        return InterpValue::MakeBool(a == b);
+      case Bytecode::Op::kNe:
+        return InterpValue::MakeBool(a != b);
+      case Bytecode::Op::kLt:
+        return InterpValue::MakeBool(less_than(a, b));
+      case Bytecode::Op::kLe:
+        return InterpValue::MakeBool(!less_than(b, a));
+      case Bytecode::Op::kGt:
+        return InterpValue::MakeBool(less_than(b, a));
+      case Bytecode::Op::kGe:
+        return InterpValue::MakeBool(!less_than(a, b));
+      default:
+        LOG(FATAL) << "Unexpected narrow binop: " << static_cast<int>(op);
+    }
+  }();
+  stack_.ReplaceTopTwo(std::move(result));
+  return true;
+}
+
 absl::Status BytecodeInterpreter::EvalAdd(const Bytecode& bytecode,
                                           bool is_signed) {
   return EvalBinop([&](const InterpValue& lhs,
@@ -1110,12 +1207,16 @@ absl::Status BytecodeInterpreter::EvalRecvNonBlocking(
 
   XLS_ASSIGN_OR_RETURN(const Bytecode::ChannelData* channel_data,
                        bytecode.channel_data());
-  if (condition.IsTrue() && !channel->empty()) {
+  std::optional<InterpValue> value;
+  if (condition.IsTrue()) {
+    value = channel->TryPop();
+  }
+  if (value.has_value()) {
     if (options_.trace_channels() && options_.trace_hook()) {
-      XLS_ASSIGN_OR_RETURN(std::string formatted_data,
-                           ToStringMaybeFormatted(
-                               channel->front(), channel_data->value_fmt_desc(),
-                               kChannelTraceIndentation));
+      XLS_ASSIGN_OR_RETURN(
+          std::string formatted_data,
+          ToStringMaybeFormatted(*value, channel_data->value_fmt_desc(),
+                                 kChannelTraceIndentation));
       options_.trace_hook()(
           bytecode.source_span(),
           absl::StrFormat("Received data on channel `%s`:\n%s",
@@ -1123,8 +1224,7 @@ absl::Status BytecodeInterpreter::EvalRecvNonBlocking(
                           formatted_data));
     }
     stack_.Push(InterpValue::MakeTuple(
-        {token, channel->front(), InterpValue::MakeBool(true)}));
-    channel->pop_front();
+        {token, *std::move(value), InterpValue::MakeBool(true)}));
   } else {
     stack_.Push(InterpValue::MakeTuple(
         {token, default_value, InterpValue::MakeBool(false)}));
@@ -1141,7 +1241,8 @@ absl::Status BytecodeInterpreter::EvalRecv(const Bytecode& bytecode) {
   XLS_ASSIGN_OR_RETURN(const Bytecode::ChannelData* channel_data,
                        bytecode.channel_data());
   if (condition.IsTrue()) {
-    if (channel->empty()) {
+    std::optional<InterpValue> value = channel->TryPop();
+    if (!value.has_value()) {
       // Restore the stack!
       stack_.Push(channel_value);
       stack_.Push(condition);
@@ -1149,6 +1250,7 @@ absl::Status BytecodeInterpreter::EvalRecv(const Bytecode& bytecode) {
       blocked_channel_info_ = BlockedChannelInfo{
           .name = std::string(channel_data->channel_name()),
           .span = bytecode.source_span(),
+          .channel = std::move(channel),
       };
       return absl::UnavailableError("Channel is empty.");
     }
@@ -1156,18 +1258,17 @@ absl::Status BytecodeInterpreter::EvalRecv(const Bytecode& bytecode) {
     XLS_ASSIGN_OR_RETURN(InterpValue token, Pop());
 
     if (options_.trace_channels() && options_.trace_hook()) {
-      XLS_ASSIGN_OR_RETURN(std::string formatted_data,
-                           ToStringMaybeFormatted(
-                               channel->front(), channel_data->value_fmt_desc(),
-                               kChannelTraceIndentation));
+      XLS_ASSIGN_OR_RETURN(
+          std::string formatted_data,
+          ToStringMaybeFormatted(*value, channel_data->value_fmt_desc(),
+                                 kChannelTraceIndentation));
       options_.trace_hook()(
           bytecode.source_span(),
           absl::StrFormat("Received data on channel `%s`:\n%s",
                           FormatChannelNameForTracing(*channel_data),
                           formatted_data));
     }
-    stack_.Push(InterpValue::MakeTuple({token, channel->front()}));
-    channel->pop_front();
+    stack_.Push(InterpValue::MakeTuple({token, *std::move(value)}));
   } else {
     XLS_ASSIGN_OR_RETURN(InterpValue token, Pop());
     stack_.Push(InterpValue::MakeTuple({token, default_value}));
@@ -1279,7 +1380,7 @@ absl::Status BytecodeInterpreter::EvalStore(const Bytecode& bytecode) {
   }
 
   XLS_ASSIGN_OR_RETURN(InterpValue value, Pop());
-  frames_.back().StoreSlot(slot, value);
+  frames_.back().StoreSlot(slot, std::move(value));
   return absl::OkStatus();
 }
 
@@ -1322,8 +1423,8 @@ absl::Status BytecodeInterpreter::EvalSwap(const Bytecode& bytecode) {
   XLS_RET_CHECK_GE(stack_.size(), 2);
   XLS_ASSIGN_OR_RETURN(InterpValue tos0, Pop());
   XLS_ASSIGN_OR_RETURN(InterpValue tos1, Pop());
-  stack_.Push(tos0);
-  stack_.Push(tos1);
+  stack_.Push(std::move(tos0));
+  stack_.Push(std::move(tos1));
   return absl::OkStatus();
 }
 
@@ -58,10 +58,12 @@ inline void InfoLoggingTraceHook(const FileTable& file_table,
                     source_location.start().GetHumanLineno());
 }
 
-// Stores name and use-location of a blocked channel, for error messaging.
+// Stores name and use-location of a blocked channel, for error messaging, and
+// the channel itself so the proc can be resumed once it receives a value.
 struct BlockedChannelInfo {
   std::string name;
   Span span;
+  std::shared_ptr<InterpValue::Channel> channel;
 };
 
 // Bytecode interpreter for DSLX. Accepts sequence of "bytecode" "instructions"
@@ -191,6 +193,12 @@ class BytecodeInterpreter {
       const std::function<absl::StatusOr<InterpValue>(
           const InterpValue& lhs, const InterpValue& rhs)>& op);
 
+  // Evaluates the binary operation `op` directly on the machine words of the
+  // top two stack values if both are bits values of the same signedness and
+  // width of at most 64 bits, replacing them with the result. Returns false,
+  // leaving the stack untouched, if the operands or the op do not qualify.
+  bool TryEvalNarrowBinop(Bytecode::Op op);
+
   absl::StatusOr<BytecodeFunction*> GetBytecodeFn(
       Function& function, const Invocation* invocation,
       const ParametricEnv& caller_bindings);
@@ -81,6 +81,14 @@ class BytecodeInterpreterOptions {
   }
   std::optional<int64_t> max_ticks() const { return max_ticks_; }
 
+  // Number of threads to run the procs of a network on; see RunProcNetwork().
+  // With more than one the hooks above must be thread safe.
+  BytecodeInterpreterOptions& proc_thread_count(int64_t value) {
+    proc_thread_count_ = value;
+    return *this;
+  }
+  int64_t proc_thread_count() const { return proc_thread_count_; }
+
   void set_validate_final_stack_depth(bool enabled) {
     validate_final_stack_depth_ = enabled;
   }
@@ -103,6 +111,7 @@ class BytecodeInterpreterOptions {
   RolloverHook rollover_hook_ = nullptr;
   bool trace_channels_ = false;
   std::optional<int64_t> max_ticks_;
+  int64_t proc_thread_count_ = 1;
   bool validate_final_stack_depth_ = true;
   FormatPreference format_preference_ = FormatPreference::kDefault;
 };
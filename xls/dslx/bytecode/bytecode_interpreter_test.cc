@@ -15,6 +15,7 @@
 
 #include <cstdint>
 #include <ios>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -37,6 +38,7 @@
 #include "xls/dslx/bytecode/bytecode_emitter.h"
 #include "xls/dslx/bytecode/bytecode_interpreter_options.h"
 #include "xls/dslx/bytecode/interpreter_stack.h"
+#include "xls/dslx/bytecode/proc_scheduler.h"
 #include "xls/dslx/command_line_utils.h"
 #include "xls/dslx/create_import_data.h"
 #include "xls/dslx/frontend/ast.h"
@@ -115,6 +117,24 @@ class BytecodeInterpreterTest : public ::testing::Test {
     return absl::OkStatus();
   }
 
+  // As above, but runs the procs with RunProcNetwork().
+  absl::Status RunNetwork(TestProc* test_proc,
+                          const BytecodeInterpreterOptions& options) {
+    XLS_ASSIGN_OR_RETURN(TypeInfo * ti, tm_->type_info->GetTopLevelProcTypeInfo(
+                                            test_proc->proc()));
+    XLS_ASSIGN_OR_RETURN(
+        InterpValue terminator,
+        ti->GetConstExpr(test_proc->proc()->config().params()[0]));
+    std::vector<ProcInstance> proc_instances;
+    ProcIdFactory proc_id_factory;
+    XLS_RETURN_IF_ERROR(ProcConfigBytecodeInterpreter::InitializeProcNetwork(
+        &import_data_.value(), &proc_id_factory, ti, test_proc->proc(),
+        terminator, &proc_instances, options));
+    return RunProcNetwork(absl::MakeSpan(proc_instances),
+                          *terminator.GetChannelOrDie(),
+                          import_data_->file_table(), options);
+  }
+
  protected:
   std::optional<ImportData> import_data_;
   std::optional<TypecheckedModule> tm_;
@@ -3072,6 +3092,65 @@ TEST_F(BytecodeInterpreterTest, CheckHighlightLineByLineDifferences) {
             "< queen\n");
 }
 
+TEST_F(BytecodeInterpreterTest, NarrowSignedBinops) {
+  constexpr std::string_view kProgram = R"(
+fn main(x: s3, y: s3)
+    -> (s3, s3, s3, s3, s3, s3, bool, bool, bool, bool, bool, bool) {
+  (x + y, x - y, x * y, x & y, x | y, x ^ y,
+   x == y, x != y, x < y, x <= y, x > y, x >= y)
+}
+)";
+
+  // Wraps `value` to the range of an s3.
+  auto s3 = [](int64_t value) {
+    return InterpValue::MakeSBits(3, ((value & 7) ^ 4) - 4);
+  };
+  for (int64_t x = -4; x < 4; ++x) {
+    for (int64_t y = -4; y < 4; ++y) {
+      EXPECT_THAT(Interpret(kProgram, "main", {s3(x), s3(y)}),
+                  IsOkAndHolds(InterpValue::MakeTuple({
+                      s3(x + y),
+                      s3(x - y),
+                      s3(x * y),
+                      s3(x & y),
+                      s3(x | y),
+                      s3(x ^ y),
+                      InterpValue::MakeBool(x == y),
+                      InterpValue::MakeBool(x != y),
+                      InterpValue::MakeBool(x < y),
+                      InterpValue::MakeBool(x <= y),
+                      InterpValue::MakeBool(x > y),
+                      InterpValue::MakeBool(x >= y),
+                  })))
+          << "x: " << x << " y: " << y;
+    }
+  }
+}
+
+TEST_F(BytecodeInterpreterTest, BinopsAtAndAboveSixtyFourBits) {
+  constexpr std::string_view kProgram = R"(
+fn main(x: u64, y: u64, a: s64, b: s64, p: u65, q: u65)
+    -> (u64, u64, bool, bool, u65, bool) {
+  (x + y, x * y, a < b, x < y, p + q, p < q)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpValue result,
+      Interpret(kProgram, "main",
+                {InterpValue::MakeU64(std::numeric_limits<uint64_t>::max()),
+                 InterpValue::MakeU64(2), InterpValue::MakeS64(-1),
+                 InterpValue::MakeS64(2),
+                 InterpValue::MakeBits(/*is_signed=*/false, Bits::AllOnes(65)),
+                 InterpValue::MakeUBits(65, 1)}));
+  EXPECT_EQ(result,
+            InterpValue::MakeTuple(
+                {InterpValue::MakeU64(1),
+                 InterpValue::MakeU64(std::numeric_limits<uint64_t>::max() - 1),
+                 InterpValue::MakeBool(true), InterpValue::MakeBool(false),
+                 InterpValue::MakeUBits(65, 0), InterpValue::MakeBool(false)}));
+}
+
 TEST_F(BytecodeInterpreterTest, RolloverHookTestForAdd) {
   constexpr std::string_view kProgram = R"(
 fn main(x: u2, y: u2) -> u2 {
@@ -3276,5 +3355,108 @@ fn g() -> u32[3] {
   EXPECT_EQ(bit_value, 8);
 }
 
+constexpr std::string_view kIncrementerChainProgram = R"(
+proc incrementer {
+  in_ch: chan<u32> in;
+  out_ch: chan<u32> out;
+
+  init { () }
+
+  config(in_ch: chan<u32> in, out_ch: chan<u32> out) { (in_ch, out_ch) }
+
+  next(_: ()) {
+    let (tok, i) = recv(join(), in_ch);
+    send(tok, out_ch, i + u32:1);
+  }
+}
+
+proc chain {
+  init { () }
+
+  config(in_ch: chan<u32> in, out_ch: chan<u32> out) {
+    let (s0, r0) = chan<u32>("c0");
+    let (s1, r1) = chan<u32>("c1");
+    let (s2, r2) = chan<u32>("c2");
+    spawn incrementer(in_ch, s0);
+    spawn incrementer(r0, s1);
+    spawn incrementer(r1, s2);
+    spawn incrementer(r2, out_ch);
+  }
+
+  next(_: ()) { () }
+}
+
+#[test_proc]
+proc tester_proc {
+  data_out: chan<u32> out;
+  data_in: chan<u32> in;
+  terminator: chan<bool> out;
+
+  init { u32:0 }
+
+  config(terminator: chan<bool> out) {
+    let (input_p, input_c) = chan<u32>("input");
+    let (output_p, output_c) = chan<u32>("output");
+    spawn chain(input_c, output_p);
+    (input_p, output_c, terminator)
+  }
+
+  next(i: u32) {
+    let tok = send(join(), data_out, i);
+    let (tok, result) = recv(tok, data_in);
+    assert_eq(result, i + u32:4);
+    send_if(tok, terminator, i == u32:100, true);
+    i + u32:1
+  }
+})";
+
+TEST_F(BytecodeInterpreterTest, RunProcNetworkOnThreads) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TestProc * test_proc,
+      ParseAndGetTestProc(kIncrementerChainProgram, "tester_proc"));
+  for (int64_t thread_count : {1, 4}) {
+    XLS_EXPECT_OK(RunNetwork(test_proc, BytecodeInterpreterOptions()
+                                            .proc_thread_count(thread_count)))
+        << "thread count " << thread_count;
+  }
+}
+
+TEST_F(BytecodeInterpreterTest, RunProcNetworkTickLimit) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TestProc * test_proc,
+      ParseAndGetTestProc(kIncrementerChainProgram, "tester_proc"));
+  EXPECT_THAT(RunNetwork(test_proc, BytecodeInterpreterOptions().max_ticks(10)),
+              StatusIs(absl::StatusCode::kDeadlineExceeded,
+                       HasSubstr("Exceeded limit of 10 proc ticks")));
+}
+
+TEST_F(BytecodeInterpreterTest, RunProcNetworkDeadlock) {
+  constexpr std::string_view kProgram = R"(
+#[test_proc]
+proc tester_proc {
+  data_in: chan<u32> in;
+  terminator: chan<bool> out;
+
+  init { () }
+
+  config(terminator: chan<bool> out) {
+    let (_, input_c) = chan<u32>("input");
+    (input_c, terminator)
+  }
+
+  next(_: ()) {
+    let (tok, _) = recv(join(), data_in);
+    send(tok, terminator, true);
+  }
+})";
+  XLS_ASSERT_OK_AND_ASSIGN(TestProc * test_proc,
+                           ParseAndGetTestProc(kProgram, "tester_proc"));
+  EXPECT_THAT(
+      RunNetwork(test_proc, BytecodeInterpreterOptions().proc_thread_count(2)),
+      StatusIs(absl::StatusCode::kDeadlineExceeded,
+               HasSubstr("proc `tester_proc` is blocked on receive on channel "
+                         "`tester_proc::data_in`")));
+}
+
 }  // namespace
 }  // namespace xls::dslx
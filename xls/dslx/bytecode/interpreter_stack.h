@@ -83,6 +83,16 @@ class InterpreterStack {
     stack_.push_back(std::move(value));
   }
 
+  // Replaces the top two values of the stack, e.g. the operands of a binary
+  // operation, with `value`.
+  void ReplaceTopTwo(InterpValue value) {
+    CHECK_GE(stack_.size(), 2);
+    VLOG(3) << absl::StreamFormat("ReplaceTopTwo(%s)", value.ToString());
+    stack_.pop_back();
+    stack_.back() = FormattedInterpValue{.value = std::move(value),
+                                         .format_descriptor = std::nullopt};
+  }
+
   const InterpValue& PeekOrDie(int64_t from_top = 0) const {
     CHECK_GE(stack_.size(), from_top + 1);
     return stack_.at(stack_.size() - from_top - 1).value;
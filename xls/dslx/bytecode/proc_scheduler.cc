@@ -0,0 +1,258 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/bytecode/proc_scheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/common/thread.h"
+#include "xls/dslx/bytecode/bytecode_interpreter.h"
+#include "xls/dslx/bytecode/bytecode_interpreter_options.h"
+#include "xls/dslx/frontend/ast.h"
+#include "xls/dslx/frontend/pos.h"
+#include "xls/dslx/interp_value.h"
+#include "xls/dslx/type_system/parametric_env.h"
+
+namespace xls::dslx {
+namespace {
+
+// Every proc is, at any time, either ready to run, running on one of the
+// threads, or waiting for a value on the channel it is blocked on.
+class ProcScheduler {
+ public:
+  ProcScheduler(absl::Span<ProcInstance> procs,
+                InterpValue::Channel& terminator, const FileTable& file_table,
+                std::optional<int64_t> max_ticks)
+      : procs_(procs),
+        terminator_(terminator),
+        file_table_(file_table),
+        max_ticks_(max_ticks),
+        blocked_on_(procs.size()),
+        ticks_(procs.size(), 0) {
+    for (int64_t i = 0; i < procs_.size(); ++i) {
+      ready_.push_back(i);
+    }
+  }
+
+  ~ProcScheduler() {
+    // The channels outlive the scheduler.
+    absl::MutexLock lock(&mutex_);
+    for (auto& [_, channel] : observed_) {
+      channel->SetSendObserver(nullptr);
+    }
+  }
+
+  absl::Status Run(int64_t thread_count) {
+    terminator_.SetSendObserver([this] {
+      absl::MutexLock lock(&mutex_);
+      terminated_ = true;
+    });
+    {
+      absl::MutexLock lock(&mutex_);
+      terminated_ = !terminator_.empty();
+    }
+
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t i = 1; i < thread_count; ++i) {
+      threads.push_back(std::make_unique<Thread>([this] { Work(); }));
+    }
+    Work();
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+    terminator_.SetSendObserver(nullptr);
+
+    absl::MutexLock lock(&mutex_);
+    if (!status_.ok() || terminated_) {
+      return status_;
+    }
+    std::vector<std::string> blocked_channels;
+    for (int64_t i = 0; i < procs_.size(); ++i) {
+      if (blocked_on_[i].has_value()) {
+        blocked_channels.push_back(absl::StrFormat(
+            "%s: proc `%s` is blocked on receive on channel `%s`",
+            blocked_on_[i]->span.ToString(file_table_),
+            procs_[i].proc()->identifier(), blocked_on_[i]->name));
+      }
+    }
+    return absl::DeadlineExceededError(absl::StrFormat(
+        "Procs are deadlocked:\n%s", absl::StrJoin(blocked_channels, "\n")));
+  }
+
+ private:
+  bool Finished() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
+    return terminated_ || !status_.ok() || (ready_.empty() && running_ == 0);
+  }
+  bool HasWork() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
+    return Finished() || !ready_.empty();
+  }
+
+  // Runs ready procs until the network terminates, fails or deadlocks.
+  void Work() {
+    while (true) {
+      int64_t index;
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(this, &ProcScheduler::HasWork));
+        if (Finished()) {
+          return;
+        }
+        index = ready_.front();
+        ready_.pop_front();
+        ++running_;
+      }
+      absl::StatusOr<ProcRunResult> result = procs_[index].Run();
+      absl::MutexLock lock(&mutex_);
+      --running_;
+      if (!result.ok()) {
+        if (status_.ok()) {
+          status_ = result.status();
+        }
+        continue;
+      }
+      if (result->execution_state == ProcExecutionState::kCompleted) {
+        if (max_ticks_.has_value() && ++ticks_[index] > *max_ticks_) {
+          if (status_.ok()) {
+            status_ = absl::DeadlineExceededError(absl::StrFormat(
+                "Exceeded limit of %d proc ticks before terminating",
+                *max_ticks_));
+          }
+          continue;
+        }
+        ready_.push_back(index);
+        continue;
+      }
+      if (!result->blocked_channel_info.has_value() ||
+          result->blocked_channel_info->channel == nullptr) {
+        if (status_.ok()) {
+          status_ = absl::InternalError(absl::StrFormat(
+              "Proc `%s` blocked without a channel",
+              procs_[index].proc()->identifier()));
+        }
+        continue;
+      }
+      Block(index, *std::move(result->blocked_channel_info));
+    }
+  }
+
+  // Sets aside proc `index`, blocked as described by `info`, until a value is
+  // sent on the channel.
+  void Block(int64_t index, BlockedChannelInfo info)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    std::shared_ptr<InterpValue::Channel> channel = info.channel;
+    if (auto [it, inserted] = observed_.try_emplace(channel.get(), channel);
+        inserted) {
+      InterpValue::Channel* key = channel.get();
+      channel->SetSendObserver([this, key] { Wake(key); });
+    }
+    // A value may have been sent since the proc found the channel empty, in
+    // which case there is no send to wake it up.
+    if (!channel->empty()) {
+      ready_.push_back(index);
+      return;
+    }
+    blocked_on_[index] = std::move(info);
+    waiters_[channel.get()].push_back(index);
+  }
+
+  void Wake(const InterpValue::Channel* channel) {
+    absl::MutexLock lock(&mutex_);
+    auto it = waiters_.find(channel);
+    if (it == waiters_.end()) {
+      return;
+    }
+    for (int64_t index : it->second) {
+      blocked_on_[index].reset();
+      ready_.push_back(index);
+    }
+    waiters_.erase(it);
+  }
+
+  absl::Span<ProcInstance> procs_;
+  InterpValue::Channel& terminator_;
+  const FileTable& file_table_;
+  const std::optional<int64_t> max_ticks_;
+
+  absl::Mutex mutex_;
+  std::deque<int64_t> ready_ ABSL_GUARDED_BY(mutex_);
+  int64_t running_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool terminated_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  // What each waiting proc is blocked on, and the procs waiting on each
+  // channel.
+  std::vector<std::optional<BlockedChannelInfo>> blocked_on_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<const InterpValue::Channel*, std::vector<int64_t>>
+      waiters_ ABSL_GUARDED_BY(mutex_);
+  // The channels given a send observer.
+  absl::flat_hash_map<const InterpValue::Channel*,
+                      std::shared_ptr<InterpValue::Channel>>
+      observed_ ABSL_GUARDED_BY(mutex_);
+  std::vector<int64_t> ticks_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+absl::Status RunProcNetwork(absl::Span<ProcInstance> procs,
+                            InterpValue::Channel& terminator,
+                            const FileTable& file_table,
+                            const BytecodeInterpreterOptions& options) {
+  ProcScheduler scheduler(procs, terminator, file_table, options.max_ticks());
+  return scheduler.Run(std::max<int64_t>(options.proc_thread_count(), 1));
+}
+
+BytecodeInterpreterOptions SerializeInterpreterHooks(
+    const BytecodeInterpreterOptions& options, absl::Mutex* mutex) {
+  BytecodeInterpreterOptions result = options;
+  if (PostFnEvalHook hook = options.post_fn_eval_hook(); hook != nullptr) {
+    result.post_fn_eval_hook(
+        [hook, mutex](const Function* f, absl::Span<const InterpValue> args,
+                      const ParametricEnv* env, const InterpValue& got) {
+          absl::MutexLock lock(mutex);
+          return hook(f, args, env, got);
+        });
+  }
+  if (TraceHook hook = options.trace_hook(); hook != nullptr) {
+    result.trace_hook(
+        [hook, mutex](const Span& span, std::string_view message) {
+          absl::MutexLock lock(mutex);
+          hook(span, message);
+        });
+  }
+  if (RolloverHook hook = options.rollover_hook(); hook != nullptr) {
+    result.rollover_hook([hook, mutex](const Span& span) {
+      absl::MutexLock lock(mutex);
+      hook(span);
+    });
+  }
+  return result;
+}
+
+}  // namespace xls::dslx
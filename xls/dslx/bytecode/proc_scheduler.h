@@ -0,0 +1,57 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_BYTECODE_PROC_SCHEDULER_H_
+#define XLS_DSLX_BYTECODE_PROC_SCHEDULER_H_
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/dslx/bytecode/bytecode_interpreter.h"
+#include "xls/dslx/bytecode/bytecode_interpreter_options.h"
+#include "xls/dslx/frontend/pos.h"
+#include "xls/dslx/interp_value.h"
+
+namespace xls::dslx {
+
+// Runs a network of procs, as created by
+// ProcConfigBytecodeInterpreter::InitializeProcNetwork(), until a value is
+// sent on `terminator`.
+//
+// Procs run one tick at a time, taking turns. A proc blocked on a receive is
+// set aside until a value is sent on the channel it waits for rather than
+// being retried every turn, so a network in which most procs are waiting for
+// data costs only as much as the procs which are not.
+//
+// With `options.proc_thread_count()` greater than one the procs run on that
+// many threads, each proc on one thread at a time. The hooks in the options
+// the procs were created with must then be thread safe; see
+// SerializeInterpreterHooks().
+//
+// Returns DeadlineExceeded if every proc is blocked on a receive, or once a
+// proc completes more than `options.max_ticks()` ticks.
+absl::Status RunProcNetwork(absl::Span<ProcInstance> procs,
+                            InterpValue::Channel& terminator,
+                            const FileTable& file_table,
+                            const BytecodeInterpreterOptions& options);
+
+// Returns `options` with every hook wrapped to hold `mutex` while it runs, for
+// hooks which are not thread safe themselves. `mutex` must outlive the
+// returned options.
+BytecodeInterpreterOptions SerializeInterpreterHooks(
+    const BytecodeInterpreterOptions& options, absl::Mutex* mutex);
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_BYTECODE_PROC_SCHEDULER_H_
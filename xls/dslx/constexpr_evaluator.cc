@@ -206,11 +206,32 @@ absl::Status ConstexprEvaluator::HandleAllOnesMacro(const AllOnesMacro* expr) {
 absl::Status ConstexprEvaluator::HandleArray(const Array* expr) {
   VLOG(3) << "ConstexprEvaluator::HandleArray : " << expr->ToString();
   std::vector<InterpValue> values;
+  values.reserve(expr->members().size());
   for (const Expr* member : expr->members()) {
-    EVAL_AS_CONSTEXPR_OR_RETURN(member);
+    GET_CONSTEXPR_OR_RETURN(InterpValue value, member);
+    values.push_back(std::move(value));
+  }
+
+  // As with tuples, there's no need to fire up the interpreter (which would
+  // evaluate every member all over again) once we know the members. Large
+  // constant tables make this matter.
+  if (expr->has_ellipsis()) {
+    std::optional<Type*> type = type_info_->GetItem(expr);
+    const auto* array_type =
+        type.has_value() ? dynamic_cast<const ArrayType*>(*type) : nullptr;
+    if (array_type == nullptr || values.empty()) {
+      return InterpretExpr(expr);
+    }
+    absl::StatusOr<int64_t> size = array_type->size().GetAsInt64();
+    if (!size.ok() || *size < values.size()) {
+      return InterpretExpr(expr);
+    }
+    values.resize(*size, values.back());
   }
-
-  return InterpretExpr(expr);
+  XLS_ASSIGN_OR_RETURN(InterpValue array,
+                       InterpValue::MakeArray(std::move(values)));
+  type_info_->NoteConstExpr(expr, std::move(array));
+  return absl::OkStatus();
 }
 
 absl::Status ConstexprEvaluator::HandleBinop(const Binop* expr) {
@@ -620,6 +620,34 @@ fn main() -> MyArray {
   EXPECT_THAT(value.GetLength(), IsOkAndHolds(4));
 }
 
+TEST(ConstexprEvaluatorTest, ArrayFillOperatorRepeatsLastMember) {
+  constexpr std::string_view kProgram = R"(
+const TABLE = u8[5]:[u8:1, u8:2 + u8:3, ...];
+
+fn main() -> u8[5] {
+  TABLE
+}
+)";
+
+  ImportData import_data(CreateImportDataForTest());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(kProgram, "test.x", "test", &import_data));
+
+  XLS_ASSERT_OK_AND_ASSIGN(ConstantDef * table,
+                           tm.module->GetMemberOrError<ConstantDef>("TABLE"));
+  XLS_ASSERT_OK_AND_ASSIGN(InterpValue value,
+                           tm.type_info->GetConstExpr(table->value()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpValue want,
+      InterpValue::MakeArray({InterpValue::MakeUBits(8, 1),
+                              InterpValue::MakeUBits(8, 5),
+                              InterpValue::MakeUBits(8, 5),
+                              InterpValue::MakeUBits(8, 5),
+                              InterpValue::MakeUBits(8, 5)}));
+  EXPECT_EQ(value, want);
+}
+
 TEST(ConstexprEvaluatorTest, ImplWithConstantSimple) {
   constexpr std::string_view kProgram = R"(
 struct MyStruct {}
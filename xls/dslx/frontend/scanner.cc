@@ -14,7 +14,9 @@
 
 #include "xls/dslx/frontend/scanner.h"
 
+#include <algorithm>
 #include <cctype>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -61,6 +63,21 @@ char Scanner::PopChar() {
   return c;
 }
 
+void Scanner::AdvanceTo(int64_t end) {
+  CHECK_LE(index_, end);
+  CHECK_LE(end, text_.size());
+  std::string_view skipped =
+      std::string_view(text_).substr(index_, end - index_);
+  int64_t newlines = std::count(skipped.begin(), skipped.end(), '\n');
+  if (newlines == 0) {
+    colno_ += skipped.size();
+  } else {
+    lineno_ += newlines;
+    colno_ = skipped.size() - skipped.rfind('\n') - 1;
+  }
+  index_ = end;
+}
+
 void Scanner::DropChar(int64_t count) {
   for (int64_t i = 0; i < count; ++i) {
     (void)PopChar();
@@ -79,33 +96,36 @@ Token Scanner::PopComment(const Pos& start_pos, bool allow_multiline) {
   std::string chars;
   Pos end_pos = GetPos();
   while (!AtCharEof()) {
-    char c = PopChar();
-    chars.append(1, c);
+    // Take the rest of the line, newline included, in one go.
+    size_t newline = text_.find('\n', index_);
+    int64_t end = newline == std::string::npos ? text_.size() : newline + 1;
+    chars.append(text_, index_, end - index_);
+    AdvanceTo(end);
     end_pos = GetPos();
-    if (c == '\n') {
-      // If we've collected a comment, conditionally look for a continuation of
-      // it on the next line at the same colno.
-      if (allow_multiline && !AtCharEof() && PeekChar() != '\n' &&
-          chars.size() > 1) {
-        DropLeadingWhitespace();
-        if (!AtCharEof() && PeekChar() == '/' && PeekChar2OrNull() == '/' &&
-            GetPos().colno() == start_pos.colno()) {
-          DropChar(2);
-          continue;
-        }
-      }
+    if (newline == std::string::npos) {
       break;
     }
+    // If we've collected a comment, conditionally look for a continuation of
+    // it on the next line at the same colno.
+    if (allow_multiline && !AtCharEof() && PeekChar() != '\n' &&
+        chars.size() > 1) {
+      DropLeadingWhitespace();
+      if (!AtCharEof() && PeekChar() == '/' && PeekChar2OrNull() == '/' &&
+          GetPos().colno() == start_pos.colno()) {
+        DropChar(2);
+        continue;
+      }
+    }
+    break;
   }
   return Token(TokenKind::kComment, Span(start_pos, end_pos), chars);
 }
 
 absl::StatusOr<Token> Scanner::PopWhitespace(const Pos& start_pos) {
   CHECK(AtWhitespace());
-  std::string chars;
-  while (!AtCharEof() && AtWhitespace()) {
-    chars.append(1, PopChar());
-  }
+  int64_t end = FindWhitespaceEnd();
+  std::string chars = text_.substr(index_, end - index_);
+  AdvanceTo(end);
   return Token(TokenKind::kWhitespace, Span(start_pos, GetPos()), chars);
 }
 
@@ -398,8 +418,8 @@ absl::StatusOr<Token> Scanner::ScanNumber(char startc, const Pos& start_pos) {
   return Token(TokenKind::kNumber, Span(start_pos, GetPos()), s);
 }
 
-bool Scanner::AtWhitespace() const {
-  switch (PeekChar()) {
+static bool IsWhitespace(char c) {
+  switch (c) {
     case ' ':
     case '\r':
     case '\n':
@@ -411,16 +431,18 @@ bool Scanner::AtWhitespace() const {
   }
 }
 
-void Scanner::DropLeadingWhitespace() {
-  while (!AtCharEof()) {
-    if (AtWhitespace()) {
-      DropChar();
-    } else {
-      break;
-    }
+bool Scanner::AtWhitespace() const { return IsWhitespace(PeekChar()); }
+
+int64_t Scanner::FindWhitespaceEnd() const {
+  int64_t end = index_;
+  while (end < text_.size() && IsWhitespace(text_[end])) {
+    ++end;
   }
+  return end;
 }
 
+void Scanner::DropLeadingWhitespace() { AdvanceTo(FindWhitespaceEnd()); }
+
 absl::StatusOr<Token> Scanner::ScanChar(const Pos& start_pos) {
   const char open_quote = PopChar();
   CHECK_EQ(open_quote, '\'');
@@ -16,7 +16,6 @@
 #define XLS_DSLX_FRONTEND_SCANNER_H_
 
 #include <cstdint>
-#include <functional>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -148,18 +147,19 @@ class Scanner {
 
   // Scans from the current position until ftake returns false or EOF is
   // reached.
-  std::string ScanWhile(std::string s, const std::function<bool(char)>& ftake) {
-    while (!AtCharEof()) {
-      char peek = PeekChar();
-      if (!ftake(peek)) {
-        break;
-      }
-      s.append(1, PopChar());
+  template <typename TakeFn>
+  std::string ScanWhile(std::string s, TakeFn ftake) {
+    int64_t end = index_;
+    while (end < text_.size() && ftake(text_[end])) {
+      ++end;
     }
+    s.append(text_, index_, end - index_);
+    AdvanceTo(end);
     return s;
   }
-  std::string ScanWhile(char c, const std::function<bool(char)>& ftake) {
-    return ScanWhile(std::string(1, c), ftake);
+  template <typename TakeFn>
+  std::string ScanWhile(char c, TakeFn ftake) {
+    return ScanWhile(std::string(1, c), std::move(ftake));
   }
 
   // Scans the identifier-looping entity beginning with startc.
@@ -216,6 +216,16 @@ class Scanner {
   // routine will check-fail).
   ABSL_MUST_USE_RESULT char PopChar();
 
+  // Moves the character stream cursor forward to `end`, updating the line and
+  // column to account for the characters skipped in between.
+  //
+  // Precondition: `index_ <= end <= text_.size()`.
+  void AdvanceTo(int64_t end);
+
+  // Returns the index of the first non-whitespace character at or after the
+  // cursor, or `text_.size()` if there is none.
+  int64_t FindWhitespaceEnd() const;
+
   // Drops "count" characters from the head of the character stream.
   //
   // Note: As with PopChar() if the character stream is extinguished when a
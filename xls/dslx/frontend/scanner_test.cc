@@ -500,4 +500,21 @@ bar  // another thing
   }
 }
 
+TEST(ScannerTest, SpansAfterMultilineWhitespaceAndComments) {
+  std::string text = "a \t\n\n  // c\n\t  0x1_f  foo\n";
+  FileTable file_table;
+  Fileno fileno(0);
+  Scanner s(file_table, fileno, text);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<Token> tokens, s.PopAll());
+  ASSERT_EQ(tokens.size(), 4);
+  EXPECT_EQ(tokens[0].span(), Span(Pos(fileno, 0, 0), Pos(fileno, 0, 1)));
+  EXPECT_TRUE(tokens[1].IsNumber("0x1_f"));
+  EXPECT_EQ(tokens[1].span(), Span(Pos(fileno, 3, 3), Pos(fileno, 3, 8)));
+  EXPECT_EQ(tokens[2].span(), Span(Pos(fileno, 3, 10), Pos(fileno, 3, 13)));
+  EXPECT_EQ(tokens[3].span(), Span(Pos(fileno, 4, 0), Pos(fileno, 4, 0)));
+
+  ASSERT_EQ(s.comments().size(), 1);
+  EXPECT_EQ(s.comments()[0].span, Span(Pos(fileno, 2, 2), Pos(fileno, 3, 0)));
+}
+
 }  // namespace xls::dslx
@@ -17,6 +17,7 @@
 #include <cstddef>
 #include <filesystem>  // NOLINT
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -61,6 +62,17 @@ absl::StatusOr<ModuleInfo*> ImportData::Get(const ImportTokens& subject) const {
   return it->second.get();
 }
 
+std::optional<ImportData::ParsedModule> ImportData::TakeParsedModule(
+    const ImportTokens& subject) {
+  auto it = parsed_modules_.find(subject);
+  if (it == parsed_modules_.end()) {
+    return std::nullopt;
+  }
+  ParsedModule parsed = std::move(it->second);
+  parsed_modules_.erase(it);
+  return parsed;
+}
+
 absl::StatusOr<ModuleInfo*> ImportData::Put(
     const ImportTokens& subject, std::unique_ptr<ModuleInfo> module_info) {
   auto* pmodule_info = module_info.get();
@@ -73,6 +85,23 @@ absl::StatusOr<ModuleInfo*> ImportData::Put(
   return pmodule_info;
 }
 
+absl::StatusOr<std::unique_ptr<ModuleInfo>> ImportData::Take(
+    const ImportTokens& subject) {
+  auto it = modules_.find(subject);
+  if (it == modules_.end()) {
+    return absl::NotFoundError(
+        "No module is loaded for import of " + subject.ToString());
+  }
+  std::unique_ptr<ModuleInfo> module_info = std::move(it->second);
+  modules_.erase(it);
+  auto path_it = path_to_module_info_.find(module_info->path().string());
+  if (path_it != path_to_module_info_.end() &&
+      path_it->second == module_info.get()) {
+    path_to_module_info_.erase(path_it);
+  }
+  return module_info;
+}
+
 absl::StatusOr<TypeInfo*> ImportData::GetRootTypeInfoForNode(
     const AstNode* node) {
   XLS_RET_CHECK(node != nullptr);
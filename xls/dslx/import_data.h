@@ -19,6 +19,7 @@
 #include <filesystem>  // NOLINT
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -145,6 +146,12 @@ class ImportData {
   absl::StatusOr<ModuleInfo*> Put(const ImportTokens& subject,
                                   std::unique_ptr<ModuleInfo> module_info);
 
+  // Removes the module for `subject` so that another one may be put in its
+  // place, returning ownership of it. Type information held by this object may
+  // still refer to the module, so the caller must keep it alive for as long as
+  // this object.
+  absl::StatusOr<std::unique_ptr<ModuleInfo>> Take(const ImportTokens& subject);
+
   TypeInfoOwner& type_info_owner() { return type_info_owner_; }
 
   // Helper that gets the "root" type information for the module of the given
@@ -220,6 +227,26 @@ class ImportData {
 
   VirtualizableFilesystem& vfs() const { return *vfs_; }
 
+  // The maximum number of threads PrefetchImports() parses modules on. At most
+  // one (the default) means imports are only parsed as they are imported.
+  int64_t parse_parallelism() const { return parse_parallelism_; }
+  void set_parse_parallelism(int64_t value) { parse_parallelism_ = value; }
+
+  // A module parsed ahead of being imported, see PrefetchImports().
+  struct ParsedModule {
+    std::unique_ptr<Module> module;
+    std::filesystem::path source_path;
+  };
+
+  bool HasParsedModule(const ImportTokens& subject) const {
+    return parsed_modules_.contains(subject);
+  }
+  void AddParsedModule(const ImportTokens& subject, ParsedModule parsed) {
+    parsed_modules_.emplace(subject, std::move(parsed));
+  }
+  // Removes and returns the module parsed for `subject`, if any.
+  std::optional<ParsedModule> TakeParsedModule(const ImportTokens& subject);
+
  private:
   friend ImportData CreateImportData(const std::filesystem::path&,
                                      absl::Span<const std::filesystem::path>,
@@ -268,6 +295,9 @@ class ImportData {
   std::vector<ImportRecord> importer_stack_;
 
   std::unique_ptr<VirtualizableFilesystem> vfs_;
+
+  int64_t parse_parallelism_ = 1;
+  absl::flat_hash_map<ImportTokens, ParsedModule> parsed_modules_;
 };
 
 }  // namespace xls::dslx
@@ -14,11 +14,15 @@
 
 #include "xls/dslx/import_routines.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <filesystem>  // NOLINT
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "absl/cleanup/cleanup.h"
@@ -35,6 +39,8 @@
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/dslx/frontend/ast.h"
 #include "xls/dslx/frontend/module.h"
 #include "xls/dslx/frontend/parser.h"
 #include "xls/dslx/frontend/pos.h"
@@ -202,25 +208,31 @@ absl::StatusOr<ModuleInfo*> DoImport(const TypecheckModuleFn& ftypecheck,
   absl::Cleanup cleanup = absl::MakeCleanup(
       [&] { CHECK_OK(import_data->PopFromImporterStack(import_span)); });
 
-  // Use the "filesystem_path" for reading the contents but the "source_path"
-  // for other uses. This avoids decorated paths like
-  // "/build/work/.../runfiles/...a/b/c/foo.x" appearing in the file table and
-  // artifacts. Instead the original "a/b/c/foo.x" path is used.
-  XLS_ASSIGN_OR_RETURN(std::string contents,
-                       vfs.GetFileContents(dslx_path.filesystem_path));
-
-  absl::Span<std::string const> pieces = subject.pieces();
-  std::string fully_qualified_name = absl::StrJoin(pieces, ".");
+  std::string fully_qualified_name = absl::StrJoin(subject.pieces(), ".");
   VLOG(3) << "Parsing and typechecking " << fully_qualified_name << ": start";
 
   VLOG(4) << "Subject = " << subject.ToString();
   VLOG(4) << "Source path = " << dslx_path.source_path.c_str();
   VLOG(4) << "Filesystem path = " << dslx_path.filesystem_path.c_str();
 
-  Fileno fileno = file_table.GetOrCreate(dslx_path.source_path.c_str());
-  Scanner scanner(file_table, fileno, contents);
-  Parser parser(/*module_name=*/fully_qualified_name, &scanner);
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Module> module, parser.ParseModule());
+  std::unique_ptr<Module> module;
+  std::optional<ImportData::ParsedModule> parsed =
+      import_data->TakeParsedModule(subject);
+  if (parsed.has_value() && parsed->source_path == dslx_path.source_path) {
+    VLOG(3) << "Using module parsed ahead of import: " << fully_qualified_name;
+    module = std::move(parsed->module);
+  } else {
+    // Use the "filesystem_path" for reading the contents but the "source_path"
+    // for other uses. This avoids decorated paths like
+    // "/build/work/.../runfiles/...a/b/c/foo.x" appearing in the file table
+    // and artifacts. Instead the original "a/b/c/foo.x" path is used.
+    XLS_ASSIGN_OR_RETURN(std::string contents,
+                         vfs.GetFileContents(dslx_path.filesystem_path));
+    Fileno fileno = file_table.GetOrCreate(dslx_path.source_path.c_str());
+    Scanner scanner(file_table, fileno, contents);
+    Parser parser(/*module_name=*/fully_qualified_name, &scanner);
+    XLS_ASSIGN_OR_RETURN(module, parser.ParseModule());
+  }
   XLS_ASSIGN_OR_RETURN(TypeInfo * type_info, ftypecheck(module.get()));
 
   VLOG(3) << "Parsing and typechecking " << fully_qualified_name << ": done";
@@ -230,4 +242,102 @@ absl::StatusOr<ModuleInfo*> DoImport(const TypecheckModuleFn& ftypecheck,
                                             std::move(dslx_path.source_path)));
 }
 
+absl::Status PrefetchImports(const Module& module, ImportData* import_data) {
+  XLS_RET_CHECK(import_data != nullptr);
+  if (import_data->parse_parallelism() <= 1) {
+    return absl::OkStatus();
+  }
+  FileTable& file_table = import_data->file_table();
+  VirtualizableFilesystem& vfs = import_data->vfs();
+
+  // A module whose file has been read and which is waiting to be parsed.
+  struct PendingParse {
+    ImportTokens subject;
+    std::filesystem::path source_path;
+    Fileno fileno;
+    std::string contents;
+    absl::StatusOr<std::unique_ptr<Module>> module;
+  };
+
+  absl::flat_hash_set<ImportTokens> seen;
+  // Returns the not-yet-imported, not-yet-parsed modules imported by `importer`
+  // ready to be parsed. Resolving and reading happens here, on the calling
+  // thread, as it mutates the file table and may go through a filesystem which
+  // is not thread safe.
+  auto collect_imports = [&](const Module& importer,
+                             std::vector<PendingParse>& wave) {
+    for (const ModuleMember& member : importer.top()) {
+      if (!std::holds_alternative<Import*>(member)) {
+        continue;
+      }
+      const Import* import = std::get<Import*>(member);
+      ImportTokens subject(import->subject());
+      if (!seen.insert(subject).second || import_data->Contains(subject) ||
+          import_data->HasParsedModule(subject)) {
+        continue;
+      }
+      // Failures are left for DoImport to report with the usual context.
+      absl::StatusOr<DslxPath> dslx_path =
+          FindExistingPath(subject, import_data->stdlib_path(),
+                           import_data->additional_search_paths(),
+                           import->span(), file_table, vfs);
+      if (!dslx_path.ok()) {
+        continue;
+      }
+      absl::StatusOr<std::string> contents =
+          vfs.GetFileContents(dslx_path->filesystem_path);
+      if (!contents.ok()) {
+        continue;
+      }
+      wave.push_back(PendingParse{
+          .subject = subject,
+          .source_path = dslx_path->source_path,
+          .fileno = file_table.GetOrCreate(dslx_path->source_path.c_str()),
+          .contents = *std::move(contents),
+          .module = absl::UnknownError("Not parsed")});
+    }
+  };
+
+  // Parse the import graph a level at a time: the modules of each wave are
+  // parsed concurrently, and their imports make up the next wave.
+  std::vector<PendingParse> wave;
+  collect_imports(module, wave);
+  while (!wave.empty()) {
+    std::atomic<int64_t> next = 0;
+    auto parse_pending = [&] {
+      for (int64_t i = next.fetch_add(1); i < static_cast<int64_t>(wave.size());
+           i = next.fetch_add(1)) {
+        PendingParse& pending = wave[i];
+        Scanner scanner(file_table, pending.fileno, pending.contents);
+        Parser parser(absl::StrJoin(pending.subject.pieces(), "."), &scanner);
+        pending.module = parser.ParseModule();
+      }
+    };
+    int64_t thread_count = std::min(import_data->parse_parallelism(),
+                                    static_cast<int64_t>(wave.size()));
+    VLOG(3) << "Parsing " << wave.size() << " imports on " << thread_count
+            << " threads";
+    {
+      std::vector<std::unique_ptr<Thread>> threads;
+      for (int64_t i = 0; i < thread_count; ++i) {
+        threads.push_back(std::make_unique<Thread>(parse_pending));
+      }
+    }
+
+    std::vector<PendingParse> next_wave;
+    for (PendingParse& pending : wave) {
+      if (!pending.module.ok()) {
+        continue;
+      }
+      collect_imports(**pending.module, next_wave);
+      import_data->AddParsedModule(
+          pending.subject,
+          ImportData::ParsedModule{.module = *std::move(pending.module),
+                                   .source_path = pending.source_path});
+    }
+    wave = std::move(next_wave);
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace xls::dslx
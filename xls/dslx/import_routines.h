@@ -17,6 +17,7 @@
 
 #include <functional>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "xls/dslx/frontend/ast.h"
 #include "xls/dslx/frontend/pos.h"
@@ -54,6 +55,15 @@ absl::StatusOr<ModuleInfo*> DoImport(const TypecheckModuleFn& ftypecheck,
                                      const Span& import_span,
                                      VirtualizableFilesystem& vfs);
 
+// Parses the transitive imports of `module` which are not yet in `import_data`
+// on up to `import_data->parse_parallelism()` threads, so that the DoImport()
+// calls made while typechecking `module` only have to typecheck them.
+//
+// Typechecking itself stays sequential: it shares type information and the
+// importer stack across modules. Imports which cannot be located or parsed are
+// skipped here and reported by DoImport() as usual.
+absl::Status PrefetchImports(const Module& module, ImportData* import_data);
+
 }  // namespace xls::dslx
 
 #endif  // XLS_DSLX_IMPORT_ROUTINES_H_
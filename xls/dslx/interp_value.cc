@@ -16,6 +16,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <optional>
@@ -32,6 +33,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
@@ -627,24 +629,37 @@ absl::StatusOr<InterpValue> InterpValue::Index(const InterpValue& other) const {
   return (*lhs)[index];
 }
 
+std::vector<InterpValue>& InterpValue::MutableValues() {
+  Values& values = std::get<Values>(payload_);
+  if (values.use_count() > 1) {
+    values = std::make_shared<std::vector<InterpValue>>(*values);
+  }
+  return *values;
+}
+
 absl::StatusOr<InterpValue> InterpValue::Update(
-    const InterpValue& index, const InterpValue& value) const {
+    const InterpValue& index, const InterpValue& value) const& {
+  return InterpValue(*this).Update(index, value);
+}
+
+absl::StatusOr<InterpValue> InterpValue::Update(const InterpValue& index,
+                                                const InterpValue& value) && {
   absl::Span<const xls::dslx::InterpValue> indices;
   if (index.IsTuple()) {
-    indices =
-        absl::MakeConstSpan(std::get<std::vector<InterpValue>>(index.payload_));
+    indices = absl::MakeConstSpan(index.GetValuesOrDie());
   } else {
     indices = absl::MakeConstSpan(&index, 1);
   }
-  InterpValue copy = *this;
-  InterpValue* element = &copy;
+  // Check the indices before copying anything.
+  const InterpValue* subject = this;
+  std::vector<uint64_t> index_values;
+  index_values.reserve(indices.size());
   for (const auto& i : indices) {
-    if (!element->IsArray()) {
+    if (!subject->IsArray()) {
       return absl::InvalidArgumentError(absl::StrFormat(
-          "Update of non-array element: %s", element->ToString()));
+          "Update of non-array element: %s", subject->ToString()));
     }
-    std::vector<InterpValue>& values =
-        std::get<std::vector<InterpValue>>(element->payload_);
+    const std::vector<InterpValue>& values = subject->GetValuesOrDie();
     XLS_ASSIGN_OR_RETURN(Bits index_bits, i.GetBits());
     XLS_ASSIGN_OR_RETURN(uint64_t index_value, index_bits.ToUint64());
     if (index_value >= values.size()) {
@@ -652,10 +667,16 @@ absl::StatusOr<InterpValue> InterpValue::Update(
           absl::StrFormat("Update index %d is out of bounds; subject size: %d",
                           index_value, values.size()));
     }
-    element = &values[index_value];
+    index_values.push_back(index_value);
+    subject = &values[index_value];
+  }
+  InterpValue result = std::move(*this);
+  InterpValue* element = &result;
+  for (uint64_t index_value : index_values) {
+    element = &element->MutableValues()[index_value];
   }
   *element = value;
-  return copy;
+  return result;
 }
 
 absl::StatusOr<InterpValue> InterpValue::ArithmeticNegate() const {
@@ -694,6 +715,18 @@ const Bits& InterpValue::GetBitsOrDie() const {
   return std::get<EnumData>(payload_).value;
 }
 
+void InterpValue::Channel::push_back(InterpValue value) {
+  std::function<void()> observer;
+  {
+    absl::MutexLock lock(&mutex_);
+    values_.push_back(std::move(value));
+    observer = send_observer_;
+  }
+  if (observer != nullptr) {
+    observer();
+  }
+}
+
 absl::StatusOr<std::shared_ptr<InterpValue::Channel>> InterpValue::GetChannel()
     const {
   if (std::holds_alternative<std::shared_ptr<Channel>>(payload_)) {
@@ -17,6 +17,7 @@
 
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -26,10 +27,12 @@
 #include <variant>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/dslx/dslx_builtins.h"
 #include "xls/dslx/frontend/ast.h"
@@ -75,7 +78,7 @@ class InterpValue {
     Function* function;
   };
   using FnData = std::variant<Builtin, UserFnData>;
-  using Channel = std::deque<InterpValue>;
+  class Channel;
 
   // Factories
 
@@ -119,9 +122,7 @@ class InterpValue {
         std::move(bits));
   }
   static InterpValue MakeTuple(std::vector<InterpValue> members);
-  static InterpValue MakeChannel() {
-    return InterpValue(InterpValueTag::kChannel, std::make_shared<Channel>());
-  }
+  static InterpValue MakeChannel();
   static absl::StatusOr<InterpValue> MakeArray(
       std::vector<InterpValue> elements);
   static InterpValue MakeBool(bool value) {
@@ -247,8 +248,14 @@ class InterpValue {
   absl::StatusOr<InterpValue> FloorMod(const InterpValue& other) const;
   absl::StatusOr<InterpValue> Index(const InterpValue& other) const;
   absl::StatusOr<InterpValue> Index(int64_t index) const;
+  // Returns this array with the element at `index` (or, for a tuple `index`,
+  // the nested element) replaced with `value`. Only the arrays along the path
+  // to the element are copied, and of those only the ones shared with other
+  // values when updating an rvalue.
+  absl::StatusOr<InterpValue> Update(const InterpValue& index,
+                                     const InterpValue& value) const&;
   absl::StatusOr<InterpValue> Update(const InterpValue& index,
-                                     const InterpValue& value) const;
+                                     const InterpValue& value) &&;
   absl::StatusOr<InterpValue> Slice(const InterpValue& start,
                                     const InterpValue& length) const;
   absl::StatusOr<InterpValue> Flatten() const;
@@ -298,13 +305,13 @@ class InterpValue {
   InterpValueTag tag() const { return tag_; }
 
   absl::StatusOr<const std::vector<InterpValue>*> GetValues() const {
-    if (!std::holds_alternative<std::vector<InterpValue>>(payload_)) {
+    if (!std::holds_alternative<Values>(payload_)) {
       return absl::InvalidArgumentError("Value does not hold element values");
     }
-    return &std::get<std::vector<InterpValue>>(payload_);
+    return std::get<Values>(payload_).get();
   }
   const std::vector<InterpValue>& GetValuesOrDie() const {
-    return std::get<std::vector<InterpValue>>(payload_);
+    return *std::get<Values>(payload_);
   }
   absl::StatusOr<const FnData*> GetFunction() const {
     if (!std::holds_alternative<FnData>(payload_)) {
@@ -346,7 +353,7 @@ class InterpValue {
   }
 
   bool HasValues() const {
-    return std::holds_alternative<std::vector<InterpValue>>(payload_);
+    return std::holds_alternative<Values>(payload_);
   }
 
   bool IsToken() const { return tag_ == InterpValueTag::kToken; }
@@ -395,12 +402,24 @@ class InterpValue {
   //
   // TODO(leary): 2020-02-10 When all Python bindings are eliminated we can more
   // easily make an interpreter scoped lifetime that InterpValues can live in.
-  using Payload =
-      std::variant<Bits, EnumData, std::vector<InterpValue>, FnData,
-                   std::shared_ptr<TokenData>, std::shared_ptr<Channel>>;
+  //
+  // The elements of tuples and arrays are immutable once shared, so that
+  // copying an aggregate (e.g. to pass it to a function) is constant time;
+  // see MutableValues().
+  using Values = std::shared_ptr<std::vector<InterpValue>>;
+  using Payload = std::variant<Bits, EnumData, Values, FnData,
+                               std::shared_ptr<TokenData>,
+                               std::shared_ptr<Channel>>;
 
   InterpValue(InterpValueTag tag, Payload payload)
       : tag_(tag), payload_(std::move(payload)) {}
+  InterpValue(InterpValueTag tag, std::vector<InterpValue> values)
+      : InterpValue(tag, std::make_shared<std::vector<InterpValue>>(
+                             std::move(values))) {}
+
+  // Returns the elements of this tuple or array for modification, first
+  // copying them if they are shared with any other value.
+  std::vector<InterpValue>& MutableValues();
 
   using CompareF = bool (*)(const Bits& lhs, const Bits& rhs);
 
@@ -413,6 +432,69 @@ class InterpValue {
   Payload payload_;
 };
 
+// The values sent on a channel and not yet received, in order.
+//
+// A channel connects one sending and one receiving proc, which may run on
+// different threads, so every operation is atomic. A send observer may be set
+// to learn of values sent without polling the channel; it runs on the sending
+// thread once the value is in the channel.
+class InterpValue::Channel {
+ public:
+  bool empty() const {
+    absl::MutexLock lock(&mutex_);
+    return values_.empty();
+  }
+  int64_t size() const {
+    absl::MutexLock lock(&mutex_);
+    return values_.size();
+  }
+
+  // Returns the value at the front of the channel, which must not be empty.
+  InterpValue front() const {
+    absl::MutexLock lock(&mutex_);
+    CHECK(!values_.empty());
+    return values_.front();
+  }
+  void pop_front() {
+    absl::MutexLock lock(&mutex_);
+    CHECK(!values_.empty());
+    values_.pop_front();
+  }
+
+  // Removes and returns the value at the front of the channel, if any.
+  std::optional<InterpValue> TryPop() {
+    absl::MutexLock lock(&mutex_);
+    if (values_.empty()) {
+      return std::nullopt;
+    }
+    InterpValue value = std::move(values_.front());
+    values_.pop_front();
+    return value;
+  }
+
+  void push_back(InterpValue value);
+
+  // Returns a copy of the values in the channel.
+  std::vector<InterpValue> GetContents() const {
+    absl::MutexLock lock(&mutex_);
+    return std::vector<InterpValue>(values_.begin(), values_.end());
+  }
+
+  void SetSendObserver(std::function<void()> observer) {
+    absl::MutexLock lock(&mutex_);
+    send_observer_ = std::move(observer);
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  std::deque<InterpValue> values_ ABSL_GUARDED_BY(mutex_);
+  std::function<void()> send_observer_ ABSL_GUARDED_BY(mutex_);
+};
+
+inline InterpValue InterpValue::MakeChannel() {
+  return InterpValue(InterpValueTag::kChannel, std::make_shared<Channel>());
+}
+
 template <typename H>
 H AbslHashValue(H state, const InterpValue::UserFnData& v) {
   return H::combine(std::move(state), v.module, v.function);
@@ -17,6 +17,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -254,6 +255,31 @@ TEST(InterpValueTest, Array2DUpdateArrayOutOfBounds) {
                   testing::HasSubstr("Update index 2 is out of bounds")));
 }
 
+TEST(InterpValueTest, Array2DUpdateSharedArray) {
+  XLS_ASSERT_OK_AND_ASSIGN(InterpValue row,
+                           InterpValue::MakeArray({InterpValue::MakeU32(1),
+                                                   InterpValue::MakeU32(2)}));
+  XLS_ASSERT_OK_AND_ASSIGN(InterpValue array,
+                           InterpValue::MakeArray({row, row}));
+  InterpValue copy = array;
+  auto indices =
+      InterpValue::MakeTuple({InterpValue::MakeU8(1), InterpValue::MakeU8(0)});
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpValue updated,
+      std::move(copy).Update(indices, InterpValue::MakeU32(4)));
+  EXPECT_EQ(updated.ToHumanString(), "[[1, 2], [4, 2]]");
+  // The values sharing elements with the updated array are unchanged.
+  EXPECT_EQ(array.ToHumanString(), "[[1, 2], [1, 2]]");
+  EXPECT_EQ(row.ToHumanString(), "[1, 2]");
+
+  // An unshared array is updated in place.
+  const InterpValue* elements = &updated.GetValuesOrDie()[0];
+  XLS_ASSERT_OK_AND_ASSIGN(
+      updated, std::move(updated).Update(InterpValue::MakeU8(0), row));
+  EXPECT_EQ(&updated.GetValuesOrDie()[0], elements);
+  EXPECT_EQ(updated.ToHumanString(), "[[1, 2], [4, 2]]");
+}
+
 TEST(InterpValueTest, TestPredicates) {
   auto false_value = InterpValue::MakeBool(false);
   EXPECT_TRUE(false_value.IsFalse());
@@ -15,7 +15,6 @@
 #include <cstdint>
 #include <cstdlib>
 #include <filesystem>  // NOLINT
-#include <iostream>
 #include <memory>
 #include <optional>
 #include <string>
@@ -24,7 +23,6 @@
 #include <vector>
 
 #include "absl/flags/flag.h"
-#include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -36,7 +34,9 @@
 #include "xls/common/exit_status.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
+#include "xls/common/persistent_worker.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/command_line_utils.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/run_routines/ir_test_runner.h"
@@ -88,7 +88,16 @@ ABSL_FLAG(int64_t, max_ticks, 100000,
 ABSL_FLAG(std::string, evaluator, "dslx-interpreter",
           "What evaluator should be used to actually execute the dslx test. "
           "'dslx-interpreter' is the DSLX bytecode interpreter. 'ir-jit' is "
-          "the XLS-IR JIT. ir-interpreter' is the XLS-IR interpreter.");
+          "the XLS-IR JIT. ir-interpreter' is the XLS-IR interpreter. With "
+          "the IR evaluators, quickchecks also run on them without needing "
+          "--compare.");
+ABSL_FLAG(int64_t, quickcheck_threads, 1,
+          "Number of threads to evaluate quickcheck samples on when running "
+          "them on the IR JIT or interpreter; 0 uses every available core. "
+          "Samples do not depend on the number of threads.");
+ABSL_FLAG(int64_t, proc_threads, 1,
+          "Number of threads to run the procs of test procs on in the DSLX "
+          "interpreter; 0 uses every available core.");
 // LINT.ThenChange(//xls/build_rules/xls_dslx_rules.bzl)
 
 namespace xls::dslx {
@@ -153,6 +162,15 @@ absl::StatusOr<TestResult> RealMain(
 
   warnings |= warnings_to_enable;
 
+  int64_t quickcheck_threads = absl::GetFlag(FLAGS_quickcheck_threads);
+  if (quickcheck_threads <= 0) {
+    quickcheck_threads = AvailableCPUs();
+  }
+  int64_t proc_threads = absl::GetFlag(FLAGS_proc_threads);
+  if (proc_threads <= 0) {
+    proc_threads = AvailableCPUs();
+  }
+
   RealFilesystem vfs;
 
   XLS_ASSIGN_OR_RETURN(std::string program,
@@ -195,7 +213,9 @@ absl::StatusOr<TestResult> RealMain(
                                  .warnings_as_errors = warnings_as_errors,
                                  .warnings = warnings,
                                  .trace_channels = trace_channels,
-                                 .max_ticks = max_ticks};
+                                 .max_ticks = max_ticks,
+                                 .quickcheck_threads = quickcheck_threads,
+                                 .proc_threads = proc_threads};
 
   std::unique_ptr<AbstractTestRunner> test_runner = GetTestRunner(evaluator);
   XLS_ASSIGN_OR_RETURN(TestResultData test_result,
@@ -213,17 +233,9 @@ absl::StatusOr<TestResult> RealMain(
   return test_result.result();
 }
 
-}  // namespace
-}  // namespace xls::dslx
-
-int main(int argc, char* argv[]) {
-  std::vector<std::string_view> args =
-      xls::InitXls(xls::dslx::kUsage, argc, argv);
-  if (args.empty()) {
-    LOG(QFATAL) << "Wrong number of command-line arguments; got " << args.size()
-                << ": `" << absl::StrJoin(args, " ") << "`; want " << argv[0]
-                << " <input-file>";
-  }
+// Reads the remaining options from the flags and the environment and runs the
+// tests of the module at `entry_module_path`.
+absl::StatusOr<TestResult> RunFromFlags(std::string_view entry_module_path) {
   std::string dslx_path = absl::GetFlag(FLAGS_dslx_path);
   std::vector<std::string> dslx_path_strs = absl::StrSplit(dslx_path, ':');
   std::vector<std::filesystem::path> dslx_paths;
@@ -241,16 +253,18 @@ int main(int argc, char* argv[]) {
           ? std::nullopt
           : std::optional<int64_t>(absl::GetFlag(FLAGS_max_ticks));
 
-  xls::dslx::CompareFlag compare_flag;
+  CompareFlag compare_flag;
   if (compare_flag_str == "none") {
-    compare_flag = xls::dslx::CompareFlag::kNone;
+    compare_flag = CompareFlag::kNone;
   } else if (compare_flag_str == "jit") {
-    compare_flag = xls::dslx::CompareFlag::kJit;
+    compare_flag = CompareFlag::kJit;
   } else if (compare_flag_str == "interpreter") {
-    compare_flag = xls::dslx::CompareFlag::kInterpreter;
+    compare_flag = CompareFlag::kInterpreter;
   } else {
-    LOG(QFATAL) << "Invalid -compare flag: " << compare_flag_str
-                << "; must be one of none|jit|interpreter";
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid -compare flag: %s; must be one of "
+                        "none|jit|interpreter",
+                        compare_flag_str));
   }
 
   // Optional seed value.
@@ -275,9 +289,9 @@ int main(int argc, char* argv[]) {
 
   if (!test_filter_env.empty()) {
     if (test_filter.has_value()) {
-      std::cerr << "TESTBRIDGE_TEST_ONLY environment variable set "
-                   "simultaneously with --test_filter; only one is allowed.\n";
-      return EXIT_FAILURE;
+      return absl::InvalidArgumentError(
+          "TESTBRIDGE_TEST_ONLY environment variable set simultaneously with "
+          "--test_filter; only one is allowed.");
     }
     test_filter = test_filter_env;
   }
@@ -290,34 +304,67 @@ int main(int argc, char* argv[]) {
     xml_output_file = xml_output_file_env;
   }
 
-  xls::FormatPreference preference = xls::FormatPreference::kDefault;
+  FormatPreference preference = FormatPreference::kDefault;
   if (!absl::GetFlag(FLAGS_format_preference).empty()) {
-    absl::StatusOr<xls::FormatPreference> flag_preference =
-        xls::FormatPreferenceFromString(absl::GetFlag(FLAGS_format_preference));
+    absl::StatusOr<FormatPreference> flag_preference =
+        FormatPreferenceFromString(absl::GetFlag(FLAGS_format_preference));
     // `default` is not a legal overriding format preference.
-    QCHECK(flag_preference.ok() &&
-           absl::GetFlag(FLAGS_format_preference) != "default")
-        << "-format_preference accepts binary|hex|decimal";
+    if (!flag_preference.ok() ||
+        absl::GetFlag(FLAGS_format_preference) == "default") {
+      return absl::InvalidArgumentError(
+          "-format_preference accepts binary|hex|decimal");
+    }
     preference = flag_preference.value();
   }
 
-  absl::StatusOr<xls::dslx::EvaluatorType> evaluator =
-      xls::dslx::GetEvaluatorType(absl::GetFlag(FLAGS_evaluator));
-  if (!evaluator.ok()) {
-    return xls::ExitStatus(evaluator.status());
+  XLS_ASSIGN_OR_RETURN(EvaluatorType evaluator,
+                       GetEvaluatorType(absl::GetFlag(FLAGS_evaluator)));
+  if (evaluator != EvaluatorType::kDslxInterpreter &&
+      compare_flag != CompareFlag::kNone) {
+    return absl::InvalidArgumentError(
+        "--compare flag is only supported on --evaluator=dslx-interpreter");
   }
 
-  QCHECK(evaluator.value() == xls::dslx::EvaluatorType::kDslxInterpreter ||
-         compare_flag == xls::dslx::CompareFlag::kNone)
-      << "--compare flag is only supported on --evaluator=dslx-interpreter";
-
   std::filesystem::path dslx_stdlib_path =
       absl::GetFlag(FLAGS_dslx_stdlib_path);
 
-  absl::StatusOr<xls::dslx::TestResult> test_result = xls::dslx::RealMain(
-      args[0], dslx_paths, dslx_stdlib_path, test_filter, preference,
-      compare_flag, execute, warnings_as_errors, seed, trace_channels,
-      max_ticks, xml_output_file, evaluator.value());
+  return RealMain(entry_module_path, dslx_paths, dslx_stdlib_path, test_filter,
+                  preference, compare_flag, execute, warnings_as_errors, seed,
+                  trace_channels, max_ticks, xml_output_file, evaluator);
+}
+
+}  // namespace
+}  // namespace xls::dslx
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string_view> args =
+      xls::InitXls(xls::dslx::kUsage, argc, argv);
+  if (xls::IsPersistentWorker()) {
+    return xls::RunPersistentWorker(
+        argv[0],
+        [](absl::Span<const std::string_view> positional_arguments)
+            -> absl::Status {
+          if (positional_arguments.size() != 1) {
+            return absl::InvalidArgumentError(
+                "Expected invocation: interpreter_main <input-file>");
+          }
+          XLS_ASSIGN_OR_RETURN(
+              xls::dslx::TestResult test_result,
+              xls::dslx::RunFromFlags(positional_arguments[0]));
+          if (test_result != xls::dslx::TestResult::kAllPassed) {
+            return absl::InternalError("Tests failed");
+          }
+          return absl::OkStatus();
+        });
+  }
+  if (args.empty()) {
+    LOG(QFATAL) << "Wrong number of command-line arguments; got " << args.size()
+                << ": `" << absl::StrJoin(args, " ") << "`; want " << argv[0]
+                << " <input-file>";
+  }
+
+  absl::StatusOr<xls::dslx::TestResult> test_result =
+      xls::dslx::RunFromFlags(args[0]);
   if (!test_result.ok()) {
     return xls::ExitStatus(test_result.status());
   }
@@ -0,0 +1,192 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/ir_convert/conversion_cache.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/types/span.h"
+#include "google/protobuf/text_format.h"
+#include "openssl/sha.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/ir_convert/ir_converter_options_flags.pb.h"
+#include "xls/dslx/virtualizable_file_system.h"
+#include "xls/ir/xls_ir_interface.pb.h"
+
+namespace xls::dslx {
+namespace {
+
+std::string Sha256Hex(std::string_view data) {
+  std::array<char, SHA256_DIGEST_LENGTH> digest;
+  SHA256(reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+         reinterpret_cast<uint8_t*>(digest.data()));
+  return absl::BytesToHexString({digest.data(), digest.size()});
+}
+
+// The dependencies file has one line per observed path, of the form
+// `read <sha256> <path>`, `exists <path>` or `absent <path>`, and a final
+// `ir <sha256>` line over the IR text of the entry.
+constexpr std::string_view kRead = "read";
+constexpr std::string_view kExists = "exists";
+constexpr std::string_view kAbsent = "absent";
+constexpr std::string_view kIr = "ir";
+
+}  // namespace
+
+/* static */ absl::StatusOr<std::unique_ptr<ConversionCache>>
+ConversionCache::Create(const std::filesystem::path& directory) {
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(directory));
+  return std::unique_ptr<ConversionCache>(new ConversionCache(directory));
+}
+
+/* static */ std::string ConversionCache::ComputeKey(
+    absl::Span<const std::string_view> paths,
+    const IrConverterOptionsFlagsProto& options,
+    const std::filesystem::path& current_directory) {
+  IrConverterOptionsFlagsProto key_options = options;
+  key_options.clear_output_file();
+  key_options.clear_interface_proto_file();
+  key_options.clear_interface_textproto_file();
+  key_options.clear_conversion_cache_dir();
+  key_options.clear_import_parse_threads();
+  std::string options_text;
+  google::protobuf::TextFormat::PrintToString(key_options, &options_text);
+
+  std::string preimage = absl::StrFormat("version: %d\ncwd: %s\n",
+                                         kFormatVersion,
+                                         current_directory.string());
+  for (std::string_view path : paths) {
+    absl::StrAppend(&preimage, "path: ", path, "\n");
+  }
+  absl::StrAppend(&preimage, options_text);
+  return Sha256Hex(preimage);
+}
+
+std::filesystem::path ConversionCache::IrPath(std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".ir");
+}
+
+std::filesystem::path ConversionCache::InterfacePath(
+    std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".interface.pb");
+}
+
+std::filesystem::path ConversionCache::DependenciesPath(
+    std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".deps");
+}
+
+absl::StatusOr<std::optional<CachedConversion>> ConversionCache::Lookup(
+    std::string_view key, VirtualizableFilesystem& vfs) {
+  // The dependencies are written last so their presence marks a complete
+  // entry.
+  if (!FileExists(DependenciesPath(key)).ok()) {
+    return std::nullopt;
+  }
+  XLS_ASSIGN_OR_RETURN(std::string dependencies,
+                       GetFileContents(DependenciesPath(key)));
+  std::optional<std::string> ir_hash;
+  for (std::string_view line :
+       absl::StrSplit(dependencies, '\n', absl::SkipEmpty())) {
+    std::vector<std::string_view> fields =
+        absl::StrSplit(line, absl::MaxSplits(' ', 1));
+    if (fields.size() != 2) {
+      return absl::InternalError(absl::StrFormat(
+          "Malformed conversion cache entry %s: `%s`",
+          DependenciesPath(key).string(), line));
+    }
+    if (fields[0] == kIr) {
+      ir_hash = std::string(fields[1]);
+      continue;
+    }
+    bool up_to_date;
+    if (fields[0] == kRead) {
+      std::vector<std::string_view> hash_and_path =
+          absl::StrSplit(fields[1], absl::MaxSplits(' ', 1));
+      if (hash_and_path.size() != 2) {
+        return absl::InternalError(absl::StrFormat(
+            "Malformed conversion cache entry %s: `%s`",
+            DependenciesPath(key).string(), line));
+      }
+      absl::StatusOr<std::string> contents =
+          vfs.GetFileContents(std::filesystem::path(hash_and_path[1]));
+      up_to_date = contents.ok() && Sha256Hex(*contents) == hash_and_path[0];
+    } else if (fields[0] == kExists || fields[0] == kAbsent) {
+      up_to_date = vfs.FileExists(std::filesystem::path(fields[1])).ok() ==
+                   (fields[0] == kExists);
+    } else {
+      return absl::InternalError(absl::StrFormat(
+          "Malformed conversion cache entry %s: `%s`",
+          DependenciesPath(key).string(), line));
+    }
+    if (!up_to_date) {
+      VLOG(1) << "Conversion cache entry " << key << " is stale: " << line;
+      return std::nullopt;
+    }
+  }
+
+  CachedConversion result;
+  XLS_ASSIGN_OR_RETURN(result.ir_text, GetFileContents(IrPath(key)));
+  if (!ir_hash.has_value() || Sha256Hex(result.ir_text) != *ir_hash) {
+    // Another process replaced the entry while it was being read.
+    return std::nullopt;
+  }
+  XLS_RETURN_IF_ERROR(ParseProtobinFile(InterfacePath(key), &result.interface));
+  VLOG(1) << "Conversion cache hit for " << key;
+  return result;
+}
+
+absl::Status ConversionCache::Store(
+    std::string_view key,
+    const absl::btree_map<std::string, ObservedFile>& observed_files,
+    const CachedConversion& conversion) {
+  std::string dependencies;
+  for (const auto& [path, observed] : observed_files) {
+    if (observed.contents.has_value()) {
+      absl::StrAppend(&dependencies, kRead, " ",
+                      Sha256Hex(*observed.contents), " ", path, "\n");
+    } else {
+      absl::StrAppend(&dependencies, observed.exists ? kExists : kAbsent, " ",
+                      path, "\n");
+    }
+  }
+  absl::StrAppend(&dependencies, kIr, " ", Sha256Hex(conversion.ir_text),
+                  "\n");
+  XLS_RETURN_IF_ERROR(AtomicallySetFileContents(IrPath(key),
+                                                conversion.ir_text));
+  XLS_RETURN_IF_ERROR(AtomicallySetFileContents(
+      InterfacePath(key), conversion.interface.SerializeAsString()));
+  XLS_RETURN_IF_ERROR(
+      AtomicallySetFileContents(DependenciesPath(key), dependencies));
+  VLOG(1) << "Stored conversion cache entry " << key;
+  return absl::OkStatus();
+}
+
+}  // namespace xls::dslx
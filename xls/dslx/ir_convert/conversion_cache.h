@@ -0,0 +1,99 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_IR_CONVERT_CONVERSION_CACHE_H_
+#define XLS_DSLX_IR_CONVERT_CONVERSION_CACHE_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/container/btree_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/dslx/ir_convert/ir_converter_options_flags.pb.h"
+#include "xls/dslx/virtualizable_file_system.h"
+#include "xls/ir/xls_ir_interface.pb.h"
+
+namespace xls::dslx {
+
+// The result of converting DSLX files to IR.
+struct CachedConversion {
+  std::string ir_text;
+  PackageInterfaceProto interface;
+};
+
+// A persistent on-disk cache of the IR converted from DSLX files, so that a
+// rerun whose import closure (standard library included) is unchanged skips
+// parsing, typechecking and conversion entirely.
+//
+// Entries are looked up by a key over the inputs known before any DSLX is
+// read: the paths, the options and the working directory. Each entry records
+// every file the conversion looked for or read, with a hash of the contents of
+// the files read, and is only used if they are all still the same. This also
+// catches an import which would now resolve to a file earlier on the search
+// path.
+//
+// Entries are written to a temporary file and renamed into place so concurrent
+// processes sharing a cache directory never observe partially written entries.
+// The cache is never pruned; stale entries are simply overwritten.
+class ConversionCache {
+ public:
+  // Bumped whenever the layout of cached entries or the IR converted from given
+  // DSLX changes in a way the key would not otherwise capture.
+  static constexpr int64_t kFormatVersion = 1;
+
+  // Creates a cache backed by the given directory, creating it if needed.
+  static absl::StatusOr<std::unique_ptr<ConversionCache>> Create(
+      const std::filesystem::path& directory);
+
+  // Returns the cache key for converting `paths` with `options`. Options which
+  // only say where to write the results or how fast to compute them are
+  // ignored.
+  static std::string ComputeKey(absl::Span<const std::string_view> paths,
+                                const IrConverterOptionsFlagsProto& options,
+                                const std::filesystem::path& current_directory);
+
+  // Returns the entry stored under `key`, or std::nullopt if there is none or
+  // if a file it depends on has changed in `vfs`.
+  absl::StatusOr<std::optional<CachedConversion>> Lookup(
+      std::string_view key, VirtualizableFilesystem& vfs);
+
+  // Stores `conversion` under `key` along with the files it was converted from.
+  absl::Status Store(
+      std::string_view key,
+      const absl::btree_map<std::string, ObservedFile>& observed_files,
+      const CachedConversion& conversion);
+
+  const std::filesystem::path& directory() const { return directory_; }
+
+ private:
+  explicit ConversionCache(std::filesystem::path directory)
+      : directory_(std::move(directory)) {}
+
+  std::filesystem::path IrPath(std::string_view key) const;
+  std::filesystem::path InterfacePath(std::string_view key) const;
+  std::filesystem::path DependenciesPath(std::string_view key) const;
+
+  std::filesystem::path directory_;
+};
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_IR_CONVERT_CONVERSION_CACHE_H_
@@ -0,0 +1,119 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/ir_convert/conversion_cache.h"
+
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/btree_map.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dslx/ir_convert/ir_converter_options_flags.pb.h"
+#include "xls/dslx/virtualizable_file_system.h"
+#include "xls/ir/xls_ir_interface.pb.h"
+
+namespace xls::dslx {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+
+class ConversionCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    XLS_ASSERT_OK_AND_ASSIGN(temp_dir_, TempDirectory::Create());
+    XLS_ASSERT_OK_AND_ASSIGN(cache_,
+                             ConversionCache::Create(temp_dir_->path() / "c"));
+    module_path_ = temp_dir_->path() / "module.x";
+    import_path_ = temp_dir_->path() / "import.x";
+    XLS_ASSERT_OK(SetFileContents(module_path_, "import import;"));
+    XLS_ASSERT_OK(SetFileContents(import_path_, "pub const X = u32:1;"));
+  }
+
+  // Records a conversion which read the module and its import and found no
+  // `shadow.x`, then stores it under `key`.
+  void StoreConversion(std::string_view key) {
+    absl::btree_map<std::string, ObservedFile> observed;
+    RecordingFilesystem vfs(std::make_unique<RealFilesystem>(), &observed);
+    XLS_ASSERT_OK(vfs.GetFileContents(module_path_).status());
+    EXPECT_FALSE(vfs.FileExists(temp_dir_->path() / "shadow.x").ok());
+    XLS_ASSERT_OK(vfs.GetFileContents(import_path_).status());
+    CachedConversion conversion{.ir_text = "package module\n"};
+    conversion.interface.set_name("module");
+    XLS_ASSERT_OK(cache_->Store(key, observed, conversion));
+  }
+
+  std::optional<TempDirectory> temp_dir_;
+  std::unique_ptr<ConversionCache> cache_;
+  std::filesystem::path module_path_;
+  std::filesystem::path import_path_;
+  RealFilesystem vfs_;
+};
+
+TEST_F(ConversionCacheTest, HitWhenInputsAreUnchanged) {
+  EXPECT_THAT(cache_->Lookup("k", vfs_), IsOkAndHolds(std::nullopt));
+  StoreConversion("k");
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<CachedConversion> cached,
+                           cache_->Lookup("k", vfs_));
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_EQ(cached->ir_text, "package module\n");
+  EXPECT_EQ(cached->interface.name(), "module");
+}
+
+TEST_F(ConversionCacheTest, MissWhenImportChanges) {
+  StoreConversion("k");
+  XLS_ASSERT_OK(SetFileContents(import_path_, "pub const X = u32:2;"));
+  EXPECT_THAT(cache_->Lookup("k", vfs_), IsOkAndHolds(std::nullopt));
+}
+
+TEST_F(ConversionCacheTest, MissWhenProbedFileAppears) {
+  StoreConversion("k");
+  XLS_ASSERT_OK(SetFileContents(temp_dir_->path() / "shadow.x", ""));
+  EXPECT_THAT(cache_->Lookup("k", vfs_), IsOkAndHolds(std::nullopt));
+}
+
+TEST_F(ConversionCacheTest, KeyIgnoresOutputLocations) {
+  IrConverterOptionsFlagsProto options;
+  options.set_top("main");
+  std::string key =
+      ConversionCache::ComputeKey({"module.x"}, options, temp_dir_->path());
+
+  IrConverterOptionsFlagsProto with_outputs = options;
+  with_outputs.set_output_file("out.ir");
+  with_outputs.set_interface_proto_file("out.pb");
+  with_outputs.set_conversion_cache_dir("cache");
+  EXPECT_EQ(
+      ConversionCache::ComputeKey({"module.x"}, with_outputs,
+                                  temp_dir_->path()),
+      key);
+
+  IrConverterOptionsFlagsProto other_top = options;
+  other_top.set_top("other");
+  EXPECT_NE(
+      ConversionCache::ComputeKey({"module.x"}, other_top, temp_dir_->path()),
+      key);
+  EXPECT_NE(ConversionCache::ComputeKey({"other.x"}, options,
+                                        temp_dir_->path()),
+            key);
+}
+
+}  // namespace
+}  // namespace xls::dslx
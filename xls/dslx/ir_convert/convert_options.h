@@ -15,6 +15,7 @@
 #ifndef XLS_DSLX_IR_CONVERT_CONVERT_OPTIONS_H_
 #define XLS_DSLX_IR_CONVERT_CONVERT_OPTIONS_H_
 
+#include <cstdint>
 #include <optional>
 
 #include "xls/dslx/warning_kind.h"
@@ -51,6 +52,10 @@ struct ConvertOptions {
   // If present, the default FIFO config to use for any FIFO that does not
   // specify a config.
   std::optional<FifoConfig> default_fifo_config;
+
+  // Number of threads on which the modules imported by each converted file are
+  // parsed ahead of typechecking. See PrefetchImports().
+  int64_t import_parse_threads = 1;
 };
 
 }  // namespace xls::dslx
@@ -91,6 +91,10 @@ constexpr WarningCollector* kNoWarningCollector = nullptr;
 // https://github.com/google/xls/issues/450
 constexpr size_t kUsizeBits = 32;
 
+// Constant arrays with more elements than this are emitted as a single literal
+// rather than as an array of per-element literals.
+constexpr int64_t kMaxElementwiseConstantArraySize = 64;
+
 // Returns a status that indicates an error in the IR conversion process.
 absl::Status IrConversionErrorStatus(const std::optional<Span>& span,
                                      std::string_view message,
@@ -3704,6 +3708,20 @@ absl::Status FunctionConverter::HandleConstantArray(const ConstantArray* node) {
   // constexprs should be evaluated during typechecking, we shouldn't need to
   // forcibly do constant evaluation at IR conversion time; therefore, we just
   // build BValues and let XLS opt constant fold them.
+  //
+  // Large tables are the exception: building (and later folding) a literal and
+  // an array operand per element is slow for arrays of many thousands of
+  // elements, so those are emitted as a single literal when typechecking has
+  // already evaluated them.
+  std::optional<InterpValue> iv = current_type_info_->GetConstExprOption(node);
+  if (iv.has_value() && iv->IsArray()) {
+    XLS_ASSIGN_OR_RETURN(int64_t length, iv->GetLength());
+    if (length > kMaxElementwiseConstantArraySize) {
+      XLS_ASSIGN_OR_RETURN(Value value, InterpValueToValue(*iv));
+      DefConst(node, value);
+      return absl::OkStatus();
+    }
+  }
   return HandleArray(node);
 }
 
@@ -3722,15 +3740,31 @@ absl::StatusOr<Value> InterpValueToValue(const InterpValue& iv) {
       return Value(iv.GetBitsOrDie());
     case InterpValueTag::kTuple:
     case InterpValueTag::kArray: {
+      const std::vector<InterpValue>& elements = iv.GetValuesOrDie();
       std::vector<Value> ir_values;
-      for (const InterpValue& e : iv.GetValuesOrDie()) {
+      ir_values.reserve(elements.size());
+      if (iv.tag() == InterpValueTag::kArray && !elements.empty() &&
+          elements.front().HasBits()) {
+        // Arrays of bits (e.g. lookup tables) are converted in one pass rather
+        // than one recursive call per element.
+        for (const InterpValue& e : elements) {
+          ir_values.push_back(Value(e.GetBitsOrDie()));
+        }
+        return Value::ArrayOwned(std::move(ir_values));
+      }
+      for (const InterpValue& e : elements) {
         XLS_ASSIGN_OR_RETURN(Value ir_value, InterpValueToValue(e));
         ir_values.push_back(std::move(ir_value));
       }
       if (iv.tag() == InterpValueTag::kTuple) {
-        return Value::Tuple(ir_values);
+        return Value::TupleOwned(std::move(ir_values));
+      }
+      if (ir_values.empty()) {
+        return Value::Array(ir_values);
       }
-      return Value::Array(ir_values);
+      // The elements of an interpreter array all have the same type, so they
+      // can be moved into place without copying or checking them again.
+      return Value::ArrayOwned(std::move(ir_values));
     }
     case InterpValueTag::kToken:
       return Value::Token();
@@ -29,9 +29,11 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
@@ -525,7 +527,8 @@ absl::StatusOr<PackageConversionData> ConvertFilesToPackage(
     absl::Span<const std::string_view> paths, std::string_view stdlib_path,
     absl::Span<const std::filesystem::path> dslx_paths,
     const ConvertOptions& convert_options, std::optional<std::string_view> top,
-    std::optional<std::string_view> package_name, bool* printed_error) {
+    std::optional<std::string_view> package_name, bool* printed_error,
+    absl::btree_map<std::string, ObservedFile>* observed_files) {
   std::string resolved_package_name;
   if (package_name.has_value()) {
     resolved_package_name = package_name.value();
@@ -552,9 +555,16 @@ absl::StatusOr<PackageConversionData> ConvertFilesToPackage(
         "path to know where to resolve the entry function");
   }
   for (std::string_view path : paths) {
-    ImportData import_data(CreateImportData(
-        stdlib_path, dslx_paths, convert_options.enabled_warnings,
-        std::make_unique<RealFilesystem>()));
+    std::unique_ptr<VirtualizableFilesystem> vfs =
+        std::make_unique<RealFilesystem>();
+    if (observed_files != nullptr) {
+      vfs = std::make_unique<RecordingFilesystem>(std::move(vfs),
+                                                  observed_files);
+    }
+    ImportData import_data(CreateImportData(stdlib_path, dslx_paths,
+                                            convert_options.enabled_warnings,
+                                            std::move(vfs)));
+    import_data.set_parse_parallelism(convert_options.import_parse_threads);
     XLS_ASSIGN_OR_RETURN(std::string text,
                          import_data.vfs().GetFileContents(path));
     XLS_ASSIGN_OR_RETURN(std::string module_name, PathToName(path));
@@ -20,6 +20,7 @@
 #include <string>
 #include <string_view>
 
+#include "absl/container/btree_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
@@ -28,6 +29,7 @@
 #include "xls/dslx/ir_convert/conversion_info.h"
 #include "xls/dslx/ir_convert/convert_options.h"
 #include "xls/dslx/type_system/parametric_env.h"
+#include "xls/dslx/virtualizable_file_system.h"
 
 namespace xls::dslx {
 
@@ -110,13 +112,16 @@ absl::Status ConvertOneFunctionIntoPackage(Module* module, Function* fn,
 //   package_name: Optionally, the name of the package.
 //   printed_error: If a non-null pointer is passes, sets the contents to a
 //     boolean value indicating if an error was printed during conversion.
+//   observed_files: If a non-null pointer is passed, records every file the
+//     conversion looked for or read, e.g. to validate a cache of its result.
 absl::StatusOr<PackageConversionData> ConvertFilesToPackage(
     absl::Span<const std::string_view> paths, std::string_view stdlib_path,
     absl::Span<const std::filesystem::path> dslx_paths,
     const ConvertOptions& convert_options,
     std::optional<std::string_view> top = std::nullopt,
     std::optional<std::string_view> package_name = std::nullopt,
-    bool* printed_error = nullptr);
+    bool* printed_error = nullptr,
+    absl::btree_map<std::string, ObservedFile>* observed_files = nullptr);
 
 }  // namespace xls::dslx
 
@@ -0,0 +1,121 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/ir_convert/ir_converter_driver.h"
+
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/btree_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_split.h"
+#include "absl/types/span.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/ir_convert/conversion_cache.h"
+#include "xls/dslx/ir_convert/conversion_info.h"
+#include "xls/dslx/ir_convert/convert_options.h"
+#include "xls/dslx/ir_convert/ir_converter.h"
+#include "xls/dslx/ir_convert/ir_converter_options_flags.pb.h"
+#include "xls/dslx/virtualizable_file_system.h"
+#include "xls/dslx/warning_kind.h"
+#include "xls/ir/channel.h"
+
+namespace xls::dslx {
+
+absl::StatusOr<CachedConversion> ConvertFilesWithOptions(
+    absl::Span<const std::string_view> paths,
+    const IrConverterOptionsFlagsProto& options, bool* printed_error) {
+  *printed_error = false;
+  std::string_view dslx_stdlib_path = options.dslx_stdlib_path();
+  std::string_view dslx_path = options.dslx_path();
+  std::vector<std::string_view> dslx_path_strs = absl::StrSplit(dslx_path, ':');
+
+  std::vector<std::filesystem::path> dslx_paths;
+  dslx_paths.reserve(dslx_path_strs.size());
+  for (const auto& path : dslx_path_strs) {
+    dslx_paths.push_back(std::filesystem::path(path));
+  }
+
+  std::optional<std::string_view> top;
+  if (options.has_top()) {
+    top = options.top();
+  }
+
+  std::optional<std::string_view> package_name;
+  if (options.has_package_name()) {
+    package_name = options.package_name();
+  }
+
+  XLS_ASSIGN_OR_RETURN(
+      WarningKindSet enabled_warnings,
+      WarningKindSetFromDisabledString(options.disable_warnings()));
+  std::optional<FifoConfig> default_fifo_config;
+  if (options.has_default_fifo_config()) {
+    XLS_ASSIGN_OR_RETURN(default_fifo_config,
+                         FifoConfig::FromProto(options.default_fifo_config()));
+  }
+  const ConvertOptions convert_options = {
+      .emit_positions = true,
+      .emit_fail_as_assert = options.emit_fail_as_assert(),
+      .verify_ir = options.verify(),
+      .warnings_as_errors = options.warnings_as_errors(),
+      .enabled_warnings = enabled_warnings,
+      .convert_tests = options.convert_tests(),
+      .default_fifo_config = default_fifo_config,
+      .import_parse_threads = options.import_parse_threads(),
+  };
+
+  // Input read from stdin cannot be read again to validate a cache entry.
+  std::unique_ptr<ConversionCache> cache;
+  std::string cache_key;
+  if (options.has_conversion_cache_dir() &&
+      absl::c_none_of(paths, [](std::string_view p) {
+        return p == "/dev/stdin";
+      })) {
+    XLS_ASSIGN_OR_RETURN(
+        cache, ConversionCache::Create(options.conversion_cache_dir()));
+    XLS_ASSIGN_OR_RETURN(std::filesystem::path current_directory,
+                         GetCurrentDirectory());
+    cache_key = ConversionCache::ComputeKey(paths, options, current_directory);
+    RealFilesystem vfs;
+    XLS_ASSIGN_OR_RETURN(std::optional<CachedConversion> cached,
+                         cache->Lookup(cache_key, vfs));
+    if (cached.has_value()) {
+      return *std::move(cached);
+    }
+  }
+
+  absl::btree_map<std::string, ObservedFile> observed_files;
+  XLS_ASSIGN_OR_RETURN(
+      PackageConversionData result,
+      ConvertFilesToPackage(paths, dslx_stdlib_path, dslx_paths,
+                            convert_options,
+                            /*top=*/top,
+                            /*package_name=*/package_name, printed_error,
+                            cache == nullptr ? nullptr : &observed_files));
+  CachedConversion conversion{.ir_text = result.DumpIr(),
+                              .interface = result.interface};
+  if (cache != nullptr && !*printed_error) {
+    XLS_RETURN_IF_ERROR(cache->Store(cache_key, observed_files, conversion));
+  }
+  return conversion;
+}
+
+}  // namespace xls::dslx
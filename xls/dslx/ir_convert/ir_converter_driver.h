@@ -0,0 +1,40 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_IR_CONVERT_IR_CONVERTER_DRIVER_H_
+#define XLS_DSLX_IR_CONVERT_IR_CONVERTER_DRIVER_H_
+
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/dslx/ir_convert/conversion_cache.h"
+#include "xls/dslx/ir_convert/ir_converter_options_flags.pb.h"
+
+namespace xls::dslx {
+
+// Converts the DSLX files at `paths` to IR as ir_converter_main does with the
+// given options, looking the result up in and storing it to the conversion
+// cache if the options name one. The output files named by the options are not
+// written.
+//
+// If an error was printed during conversion `printed_error` is set and the
+// result, which is not cached, is still returned.
+absl::StatusOr<CachedConversion> ConvertFilesWithOptions(
+    absl::Span<const std::string_view> paths,
+    const IrConverterOptionsFlagsProto& options, bool* printed_error);
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_IR_CONVERT_IR_CONVERTER_DRIVER_H_
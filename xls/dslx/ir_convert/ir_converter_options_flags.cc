@@ -14,6 +14,7 @@
 
 #include "xls/dslx/ir_convert/ir_converter_options_flags.h"
 
+#include <cstdint>
 #include <filesystem>  // NOLINT
 #include <optional>
 #include <string>
@@ -68,6 +69,13 @@ ABSL_FLAG(std::optional<std::string>, ir_converter_options_proto, std::nullopt,
 ABSL_FLAG(std::optional<std::string>, default_fifo_config, std::nullopt,
           "Textproto description of a default FifoConfigProto. If unspecified, "
           "no default FIFO config is specified and codegen may fail.");
+ABSL_FLAG(std::optional<std::string>, conversion_cache_dir, std::nullopt,
+          "Directory in which to cache converted IR. A rerun with the same "
+          "inputs, options and unchanged imported files reuses the cached IR "
+          "without parsing or typechecking any DSLX.");
+ABSL_FLAG(int64_t, import_parse_threads, 1,
+          "Number of threads on which to parse imported modules ahead of "
+          "typechecking them. Typechecking itself is sequential.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
 ABSL_FLAG(std::optional<std::string>, ir_converter_options_used_textproto_file,
           std::nullopt,
@@ -104,6 +112,8 @@ absl::StatusOr<bool> SetOptionsFromFlags(IrConverterOptionsFlagsProto& proto) {
   POPULATE_FLAG(warnings_as_errors);
   POPULATE_OPTIONAL_FLAG(interface_proto_file);
   POPULATE_OPTIONAL_FLAG(interface_textproto_file);
+  POPULATE_OPTIONAL_FLAG(conversion_cache_dir);
+  POPULATE_FLAG(import_parse_threads);
 
 #undef POPULATE_FLAG
 
@@ -45,6 +45,7 @@ namespace {
 
 using ::absl_testing::StatusIs;
 using ::testing::HasSubstr;
+using ::testing::Not;
 
 absl::StatusOr<TestResultData> ParseAndTest(
     std::string_view program, std::string_view module_name,
@@ -2829,6 +2830,23 @@ TEST(IrConverterTest, StringWithUnsignedRangeCharacter) {
   ExpectIr(converted, TestName());
 }
 
+TEST(IrConverterTest, LargeConstantArrayIsSingleLiteral) {
+  constexpr std::string_view kProgram = R"(
+    fn main(i: u32) -> u8 {
+      let table = u8[100]:[u8:1, u8:2, ...];
+      table[i]
+    }
+)";
+  ConvertOptions options;
+  options.emit_positions = false;
+  auto import_data = CreateImportDataForTest();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::string converted,
+      ConvertOneFunctionForTest(kProgram, "main", import_data, options));
+  EXPECT_THAT(converted, HasSubstr("literal(value=[1, 2, 2,"));
+  EXPECT_THAT(converted, Not(HasSubstr(" array(")));
+}
+
 // TODO(google/xls#917): Remove this test when empty arrays are supported.
 TEST(IrConverterTest, EmptyArray) {
   constexpr std::string_view kProgram = R"(
@@ -35,6 +35,7 @@
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
 #include "nlohmann/json.hpp"
 #include "verible/common/lsp/json-rpc-dispatcher.h"
@@ -46,6 +47,7 @@
 #include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/lsp/language_server_adapter.h"
 #include "xls/dslx/lsp/lsp_uri.h"
+#include "xls/dslx/lsp/workspace_index.h"
 
 ABSL_FLAG(std::string, stdlib_path, std::string(xls::kDefaultDslxStdlibPath),
           "Path to DSLX standard library files.");
@@ -87,6 +89,8 @@ InitializeResult InitializeServer(const nlohmann::json& params) {
   };
   capabilities["documentHighlightProvider"] = true;
   capabilities["documentFormattingProvider"] = true;
+  capabilities["referencesProvider"] = true;
+  capabilities["workspaceSymbolProvider"] = true;
   return InitializeResult{
       .capabilities = std::move(capabilities),
       .serverInfo =
@@ -97,6 +101,23 @@ InitializeResult InitializeServer(const nlohmann::json& params) {
   };
 }
 
+// Starts indexing the workspace given by the "initialize" parameters, if any,
+// in the background.
+void IndexWorkspaceRoot(const nlohmann::json& params,
+                        LanguageServerAdapter& adapter) {
+  auto root_uri = params.find("rootUri");
+  if (root_uri == params.end() || !root_uri->is_string()) {
+    return;
+  }
+  std::string uri = root_uri->get<std::string>();
+  if (!absl::StartsWith(uri, LspUri::kFileUriPrefix)) {
+    LspLog() << "Not indexing non-file workspace root: " << uri << "\n";
+    return;
+  }
+  LspLog() << "Indexing workspace root: " << uri << "\n";
+  adapter.IndexWorkspace(LspUri(std::move(uri)));
+}
+
 // On text change: attempt to parse the buffer and emit diagnostics if needed.
 void TextChangeHandler(const LspUri& file_uri,
                        const EditTextBuffer& text_buffer,
@@ -192,7 +213,11 @@ absl::Status RealMain() {
   // -- Add request handlers reacting to json-RPC method and notification calls
 
   // Exchange of capabilities.
-  dispatcher.AddRequestHandler("initialize", InitializeServer);
+  dispatcher.AddRequestHandler(
+      "initialize", [&](const nlohmann::json& params) {
+        IndexWorkspaceRoot(params, language_server_adapter);
+        return InitializeServer(params);
+      });
 
   // The client sends a request to shut down. Use that to exit our main loop.
   bool shutdown_requested = false;
@@ -306,6 +331,54 @@ absl::Status RealMain() {
         return std::vector<verible::lsp::DocumentHighlight>{};
       });
 
+  dispatcher.AddRequestHandler(
+      "textDocument/references", [&](const nlohmann::json& params) {
+        // The reference parameters are the definition ones plus a context.
+        const auto definition_params =
+            params.get<verible::lsp::DefinitionParams>();
+        const bool include_declaration = params.value(
+            nlohmann::json::json_pointer("/context/includeDeclaration"), true);
+        return language_server_adapter.FindReferences(
+            LspUri(std::string{definition_params.textDocument.uri}),
+            definition_params.position, include_declaration);
+      });
+
+  dispatcher.AddRequestHandler(
+      "workspace/symbol", [&](const nlohmann::json& params) {
+        nlohmann::json result = nlohmann::json::array();
+        for (const WorkspaceIndex::Symbol& symbol :
+             language_server_adapter.FindWorkspaceSymbols(
+                 params.value("query", ""))) {
+          nlohmann::json location;
+          verible::lsp::to_json(location, symbol.location);
+          result.push_back({
+              {"name", symbol.name},
+              {"kind", static_cast<int>(symbol.kind)},
+              {"location", std::move(location)},
+              {"containerName", symbol.container},
+          });
+        }
+        return result;
+      });
+
+  // Files changed outside of the editor, e.g. by version control, are
+  // reindexed; open files are kept up to date by their text changes instead.
+  dispatcher.AddNotificationHandler(
+      "workspace/didChangeWatchedFiles", [&](const nlohmann::json& params) {
+        auto changes = params.find("changes");
+        if (changes == params.end() || !changes->is_array()) {
+          return;
+        }
+        for (const nlohmann::json& change : *changes) {
+          std::string uri = change.value("uri", "");
+          if (absl::StartsWith(uri, LspUri::kFileUriPrefix) &&
+              absl::EndsWith(uri, ".x")) {
+            language_server_adapter.NoteFileChangedOnDisk(
+                LspUri(std::move(uri)));
+          }
+        }
+      });
+
   // Main loop. Feeding the stream-splitter that then calls the dispatcher.
   absl::Status status = absl::OkStatus();
   while (status.ok() && !shutdown_requested) {
@@ -22,7 +22,9 @@
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/status/statusor.h"
 #include "absl/types/variant.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/common/visitor.h"
 #include "xls/dslx/frontend/ast.h"
 #include "xls/dslx/frontend/module.h"
@@ -55,6 +57,42 @@ const NameDef* GetNameDef(
 
 }  // namespace
 
+absl::StatusOr<const NameDef*> ResolveReference(const AstNode* node,
+                                                const TypeInfo& type_info,
+                                                ImportData& import_data) {
+  if (auto* colon_ref = dynamic_cast<const ColonRef*>(node);
+      colon_ref != nullptr) {
+    VLOG(3) << "Resolving colon ref: `" << colon_ref->ToString() << "`";
+    XLS_ASSIGN_OR_RETURN(auto subject,
+                         ResolveColonRefSubjectAfterTypeChecking(
+                             &import_data, &type_info, colon_ref));
+    return GetNameDef(subject, colon_ref->attr());
+  }
+  if (auto* name_ref = dynamic_cast<const NameRef*>(node);
+      name_ref != nullptr) {
+    VLOG(3) << "Resolving name ref: `" << name_ref->ToString() << "`";
+    std::variant<const NameDef*, BuiltinNameDef*> name_def =
+        name_ref->name_def();
+    if (std::holds_alternative<const NameDef*>(name_def)) {
+      return std::get<const NameDef*>(name_def);
+    }
+    return nullptr;
+  }
+  if (auto* type_ref = dynamic_cast<const TypeRef*>(node)) {
+    VLOG(3) << "Resolving type ref: `" << type_ref->ToString() << "`";
+    AnyNameDef type_definer =
+        TypeDefinitionGetNameDef(type_ref->type_definition());
+    if (std::holds_alternative<const NameDef*>(type_definer)) {
+      return std::get<const NameDef*>(type_definer);
+    }
+    return nullptr;
+  }
+  if (auto* name_def = dynamic_cast<const NameDef*>(node)) {
+    return name_def;
+  }
+  return nullptr;
+}
+
 std::optional<const NameDef*> FindDefinition(const Module& m,
                                              const Pos& selected,
                                              const TypeInfo& type_info,
@@ -75,37 +113,13 @@ std::optional<const NameDef*> FindDefinition(const Module& m,
     VLOG(5) << "Intercepting node kind: " << node->kind() << " @ "
             << node->GetSpan().value().ToString(import_data.file_table())
             << " :: `" << node->ToString() << "`";
-    if (auto* colon_ref = dynamic_cast<const ColonRef*>(node);
-        colon_ref != nullptr) {
-      VLOG(3) << "Intercepting colon ref: `" << colon_ref->ToString() << "`";
-      auto node_or = ResolveColonRefSubjectAfterTypeChecking(
-          &import_data, &type_info, colon_ref);
-      if (!node_or.ok()) {
-        return std::nullopt;
-      }
-      const NameDef* name_def = GetNameDef(node_or.value(), colon_ref->attr());
-      if (name_def != nullptr) {
-        defs.push_back(Reference{colon_ref->span(), name_def});
-      }
-    } else if (auto* name_ref = dynamic_cast<const NameRef*>(node);
-               name_ref != nullptr) {
-      VLOG(3) << "Intercepting name ref: `" << name_ref->ToString() << "`";
-      std::variant<const NameDef*, BuiltinNameDef*> name_def =
-          name_ref->name_def();
-      if (std::holds_alternative<const NameDef*>(name_def)) {
-        defs.push_back(
-            Reference{name_ref->span(), std::get<const NameDef*>(name_def)});
-      }
-    } else if (auto* type_ref = dynamic_cast<const TypeRef*>(node)) {
-      VLOG(3) << "Intercepting type ref: `" << type_ref->ToString() << "`";
-      AnyNameDef type_definer =
-          TypeDefinitionGetNameDef(type_ref->type_definition());
-      if (std::holds_alternative<const NameDef*>(type_definer)) {
-        defs.push_back(Reference{type_ref->span(),
-                                 std::get<const NameDef*>(type_definer)});
-      }
-    } else if (auto* name_def = dynamic_cast<const NameDef*>(node)) {
-      defs.push_back(Reference{name_def->span(), name_def});
+    absl::StatusOr<const NameDef*> to =
+        ResolveReference(node, type_info, import_data);
+    if (!to.ok()) {
+      return std::nullopt;
+    }
+    if (*to != nullptr) {
+      defs.push_back(Reference{node->GetSpan().value(), *to});
     }
   }
 
@@ -17,6 +17,7 @@
 
 #include <optional>
 
+#include "absl/status/statusor.h"
 #include "xls/dslx/frontend/ast.h"
 #include "xls/dslx/frontend/module.h"
 #include "xls/dslx/frontend/pos.h"
@@ -39,6 +40,14 @@ namespace xls::dslx {
 //
 // Note that this currently only supports resolution in a single file, e.g. a
 // colon-reference to a construct in another module will return nullopt.
+// Returns the name definition referred to by `node` if it is a reference (a
+// name, type or colon reference) to one, `node` itself if it is a name
+// definition, and nullptr otherwise. Returns an error if the subject of a
+// colon reference cannot be resolved.
+absl::StatusOr<const NameDef*> ResolveReference(const AstNode* node,
+                                                const TypeInfo& type_info,
+                                                ImportData& import_data);
+
 std::optional<const NameDef*> FindDefinition(const Module& m,
                                              const Pos& selected,
                                              const TypeInfo& type_info,
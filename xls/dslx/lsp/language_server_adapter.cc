@@ -14,14 +14,18 @@
 
 #include "xls/dslx/lsp/language_server_adapter.h"
 
+#include <cstdint>
+#include <deque>
 #include <filesystem>  // NOLINT
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <system_error>  // NOLINT
 #include <utility>
 #include <vector>
 
+#include "absl/cleanup/cleanup.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -29,6 +33,7 @@
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -40,6 +45,7 @@
 #include "xls/common/file/filesystem.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/create_import_data.h"
 #include "xls/dslx/extract_module_name.h"
 #include "xls/dslx/fmt/ast_fmt.h"
@@ -50,13 +56,16 @@
 #include "xls/dslx/frontend/comment_data.h"
 #include "xls/dslx/frontend/pos.h"
 #include "xls/dslx/import_data.h"
+#include "xls/dslx/import_routines.h"
 #include "xls/dslx/lsp/document_symbols.h"
 #include "xls/dslx/lsp/find_definition.h"
 #include "xls/dslx/lsp/lsp_type_utils.h"
 #include "xls/dslx/lsp/lsp_uri.h"
+#include "xls/dslx/lsp/workspace_index.h"
 #include "xls/dslx/parse_and_typecheck.h"
 #include "xls/dslx/type_system/type.h"
 #include "xls/dslx/type_system/type_info.h"
+#include "xls/dslx/type_system/typecheck_module.h"
 #include "xls/dslx/virtualizable_file_system.h"
 #include "xls/dslx/warning_collector.h"
 #include "xls/dslx/warning_kind.h"
@@ -66,6 +75,10 @@ namespace {
 
 static const char kSource[] = "DSLX";
 
+// Every revision of a buffer is kept alive while its imports are reused, so
+// they are reloaded after this many revisions to bound memory use.
+constexpr int64_t kMaxRetiredModules = 32;
+
 // Convert error included in status message to LSP Diagnostic
 void AppendDiagnosticFromStatus(
     const absl::Status& status,
@@ -148,6 +161,16 @@ LanguageServerAdapter::LanguageServerAdapter(
     LspUri stdlib, const std::vector<LspUri>& dslx_paths)
     : stdlib_(stdlib), dslx_paths_(dslx_paths) {}
 
+LanguageServerAdapter::~LanguageServerAdapter() {
+  {
+    absl::MutexLock lock(&indexer_mutex_);
+    indexer_stopping_ = true;
+  }
+  if (indexer_ != nullptr) {
+    indexer_->Join();
+  }
+}
+
 LanguageServerAdapter::ParseData* LanguageServerAdapter::FindParsedForUri(
     LspUri uri) const {
   if (auto found = uri_parse_data_.find(uri); found != uri_parse_data_.end()) {
@@ -193,20 +216,216 @@ absl::Status LanguageServerAdapter::Update(
   auto inserted = uri_parse_data_.emplace(file_uri, nullptr);
   std::unique_ptr<ParseData>& insert_value = inserted.first->second;
 
-  std::vector<std::filesystem::path> dslx_paths_as_filesystem_paths =
-      GetDslxPathsAsFilesystemPaths();
+  std::unique_ptr<BufferImports> imports;
+  if (insert_value != nullptr && insert_value->imports().reusable &&
+      insert_value->imports().retired_modules.size() < kMaxRetiredModules &&
+      ImportsUpToDate(insert_value->imports())) {
+    if (insert_value->contents() == *dslx_code) {
+      return insert_value->status();
+    }
+    imports = insert_value->TakeImports();
+  } else {
+    imports = CreateBufferImports();
+  }
+
+  const std::string& module_name = module_name_or.value();
+
+  std::vector<CommentData> comments;
+  absl::StatusOr<TypecheckedModule> typechecked_module =
+      ParseAndTypecheckBuffer(dslx_code.value(), file_uri.GetFilesystemPath(),
+                              module_name, *imports, &comments);
+
+  if (typechecked_module.ok()) {
+    workspace_index_.IndexModule(file_uri, *typechecked_module->module,
+                                 *typechecked_module->type_info,
+                                 *imports->import_data, /*from_buffer=*/true);
+    insert_value = std::make_unique<ParseData>(
+        std::move(imports), std::string(*dslx_code),
+        TypecheckedModuleWithComments{
+            .tm = std::move(typechecked_module).value(),
+            .comments = Comments::Create(comments),
+        });
+  } else {
+    insert_value =
+        std::make_unique<ParseData>(std::move(imports), std::string(*dslx_code),
+                                    typechecked_module.status());
+  }
+
+  const absl::Duration duration = absl::Now() - start;
+  if (duration > absl::Milliseconds(200)) {
+    LspLog() << "Parsing " << file_uri << " took " << duration << "\n";
+  }
+
+  return insert_value->status();
+}
+
+std::unique_ptr<LanguageServerAdapter::BufferImports>
+LanguageServerAdapter::CreateBufferImports() {
+  auto imports = std::make_unique<BufferImports>();
+  imports->import_data = std::make_unique<ImportData>(CreateImportData(
+      stdlib_.GetFilesystemPath(), GetDslxPathsAsFilesystemPaths(),
+      kAllWarningsSet,
+      std::make_unique<RecordingFilesystem>(
+          std::make_unique<LanguageServerFilesystem>(*this),
+          &imports->observed_files)));
+  return imports;
+}
+
+ImportData LanguageServerAdapter::CreateIndexerImportData() const {
+  return CreateImportData(stdlib_.GetFilesystemPath(),
+                          GetDslxPathsAsFilesystemPaths(), kAllWarningsSet,
+                          std::make_unique<RealFilesystem>());
+}
+
+void LanguageServerAdapter::IndexWorkspace(const LspUri& root) {
+  QueueForIndexing(root.GetFilesystemPath());
+}
+
+void LanguageServerAdapter::NoteFileChangedOnDisk(const LspUri& uri) {
+  QueueForIndexing(uri.GetFilesystemPath());
+}
+
+void LanguageServerAdapter::QueueForIndexing(std::filesystem::path path) {
+  absl::MutexLock lock(&indexer_mutex_);
+  indexer_queue_.push_back(std::move(path));
+  if (indexer_ == nullptr) {
+    indexer_ = std::make_unique<Thread>([this] { RunIndexer(); });
+  }
+}
+
+void LanguageServerAdapter::WaitForIndexing() {
+  absl::MutexLock lock(&indexer_mutex_);
+  indexer_mutex_.Await(absl::Condition(
+      +[](LanguageServerAdapter* self) {
+        self->indexer_mutex_.AssertHeld();
+        return self->indexer_queue_.empty() && !self->indexer_busy_;
+      },
+      this));
+}
+
+void LanguageServerAdapter::RunIndexer() {
+  while (true) {
+    std::deque<std::filesystem::path> batch;
+    {
+      absl::MutexLock lock(&indexer_mutex_);
+      indexer_busy_ = false;
+      indexer_mutex_.Await(absl::Condition(
+          +[](LanguageServerAdapter* self) {
+            self->indexer_mutex_.AssertHeld();
+            return self->indexer_stopping_ || !self->indexer_queue_.empty();
+          },
+          this));
+      if (indexer_stopping_) {
+        return;
+      }
+      batch.swap(indexer_queue_);
+      indexer_busy_ = true;
+    }
+
+    // Expand directories into the DSLX files they contain.
+    std::vector<std::filesystem::path> files;
+    for (const std::filesystem::path& path : batch) {
+      std::error_code ec;
+      if (!std::filesystem::is_directory(path, ec)) {
+        files.push_back(path);
+        continue;
+      }
+      for (auto it = std::filesystem::recursive_directory_iterator(
+               path,
+               std::filesystem::directory_options::skip_permission_denied, ec);
+           !ec && it != std::filesystem::recursive_directory_iterator();
+           it.increment(ec)) {
+        if (it->path().extension() == ".x" && it->is_regular_file(ec)) {
+          files.push_back(it->path());
+        }
+      }
+    }
+
+    // The files of a batch share their imports, which are read afresh for
+    // every batch so that changes on disk are picked up.
+    const absl::Time start = absl::Now();
+    ImportData import_data = CreateIndexerImportData();
+    for (const std::filesystem::path& path : files) {
+      {
+        absl::MutexLock lock(&indexer_mutex_);
+        if (indexer_stopping_) {
+          return;
+        }
+      }
+      if (!xls::FileExists(path).ok()) {
+        workspace_index_.RemoveFile(
+            LspUri(verible::lsp::PathToLSPUri(path.c_str())));
+        continue;
+      }
+      if (absl::Status status = IndexFileFromDisk(path, import_data);
+          !status.ok()) {
+        VLOG(1) << "Could not index " << path << ": " << status;
+      }
+    }
+    VLOG(1) << "Indexed " << files.size() << " files in "
+            << (absl::Now() - start);
+  }
+}
 
-  ImportData import_data = CreateImportData(
-      stdlib_.GetFilesystemPath(), dslx_paths_as_filesystem_paths,
-      kAllWarningsSet, std::make_unique<LanguageServerFilesystem>(*this));
+absl::Status LanguageServerAdapter::IndexFileFromDisk(
+    const std::filesystem::path& path, ImportData& import_data) {
+  const LspUri uri(verible::lsp::PathToLSPUri(path.c_str()));
+  XLS_ASSIGN_OR_RETURN(std::string module_name, ExtractModuleName(path));
+  XLS_ASSIGN_OR_RETURN(ImportTokens subject,
+                       ImportTokens::FromString(module_name));
+  if (import_data.Contains(subject)) {
+    XLS_ASSIGN_OR_RETURN(ModuleInfo * info, import_data.Get(subject));
+    if (info->path() == path) {
+      // Already typechecked as an import of an earlier file of the batch.
+      workspace_index_.IndexModule(uri, info->module(), *info->type_info(),
+                                   import_data, /*from_buffer=*/false);
+      return absl::OkStatus();
+    }
+    // A module of the same name in another directory.
+    ImportData own_import_data = CreateIndexerImportData();
+    return IndexFileFromDisk(path, own_import_data);
+  }
+  XLS_ASSIGN_OR_RETURN(std::string contents, xls::GetFileContents(path));
+  XLS_ASSIGN_OR_RETURN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(contents, path.c_str(), module_name, &import_data));
+  workspace_index_.IndexModule(uri, *tm.module, *tm.type_info, import_data,
+                               /*from_buffer=*/false);
+  return absl::OkStatus();
+}
 
+bool LanguageServerAdapter::ImportsUpToDate(const BufferImports& imports) {
+  LanguageServerFilesystem vfs(*this);
+  for (const auto& [path, observed] : imports.observed_files) {
+    if (observed.contents.has_value()) {
+      absl::StatusOr<std::string> contents = vfs.GetFileContents(path);
+      if (!contents.ok() || *contents != *observed.contents) {
+        return false;
+      }
+    } else if (vfs.FileExists(path).ok() != observed.exists) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<TypecheckedModule>
+LanguageServerAdapter::ParseAndTypecheckBuffer(
+    std::string_view text, const std::filesystem::path& path,
+    std::string_view module_name, BufferImports& imports,
+    std::vector<CommentData>* comments) {
+  ImportData& import_data = *imports.import_data;
+  FileTable& file_table = import_data.file_table();
+  const Fileno fileno = file_table.GetOrCreate(path.c_str());
+
+  bool imported_new_module = false;
   import_data.SetImporterStackObserver(
       [&](const Span& importer_span, const std::filesystem::path& imported) {
         // Here we check that the filename as reported by the span is a valid
         // URI. When we are using the LSP we expect /all/ files in the file
         // table to be in URI form.
         std::string_view importer_filename =
-            importer_span.GetFilename(import_data.file_table());
+            importer_span.GetFilename(file_table);
         CHECK(!absl::StartsWith(importer_filename, "file://"))
             << "importer_filename: " << importer_filename
             << " imported: " << imported;
@@ -214,33 +433,61 @@ absl::Status LanguageServerAdapter::Update(
 
         const LspUri imported_uri(verible::lsp::PathToLSPUri(imported.c_str()));
         import_sensitivity_.NoteImportAttempt(importer_uri, imported_uri);
+        imported_new_module |= imported != path;
       });
-
-  const std::string& module_name = module_name_or.value();
-
-  std::vector<CommentData> comments;
-  absl::StatusOr<TypecheckedModule> typechecked_module = ParseAndTypecheck(
-      dslx_code.value(), /*path=*/file_uri.GetFilesystemPath().c_str(),
-      /*module_name=*/module_name, &import_data, &comments);
-
-  if (typechecked_module.ok()) {
-    insert_value = std::make_unique<ParseData>(
-        std::move(import_data), TypecheckedModuleWithComments{
-                                    .tm = std::move(typechecked_module).value(),
-                                    .comments = Comments::Create(comments),
-                                    .contents = std::string(*dslx_code),
-                                });
-  } else {
-    insert_value = std::make_unique<ParseData>(std::move(import_data),
-                                               typechecked_module.status());
+  absl::Cleanup clear_observer = [&] {
+    import_data.SetImporterStackObserver(nullptr);
+  };
+
+  // The outermost import doesn't have a real import statement associated with
+  // it, but we need the filename to be correct to detect cycles.
+  const Span fake_import_span = Span(Pos(fileno, 0, 0), Pos(fileno, 0, 0));
+  XLS_RETURN_IF_ERROR(
+      import_data.AddToImporterStack(fake_import_span, path.c_str()));
+  absl::Cleanup pop_importer = [&] {
+    CHECK_OK(import_data.PopFromImporterStack(fake_import_span));
+  };
+
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<Module> module,
+      ParseModule(text, path.c_str(), module_name, file_table, comments));
+  XLS_ASSIGN_OR_RETURN(ImportTokens subject,
+                       ImportTokens::FromString(module_name));
+  if (import_data.Contains(subject)) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<ModuleInfo> previous,
+                         import_data.Take(subject));
+    imports.retired_modules.push_back(std::move(previous));
   }
+  XLS_RETURN_IF_ERROR(PrefetchImports(*module, &import_data));
 
-  const absl::Duration duration = absl::Now() - start;
-  if (duration > absl::Milliseconds(200)) {
-    LspLog() << "Parsing " << file_uri << " took " << duration << "\n";
+  WarningCollector warnings(import_data.enabled_warnings());
+  for (const WarningCollector::Entry& warning : imports.import_warnings) {
+    warnings.Add(warning.span, warning.kind, warning.message);
+  }
+  const int64_t import_warning_count = imports.import_warnings.size();
+  absl::StatusOr<TypeInfo*> type_info =
+      TypecheckModule(module.get(), &import_data, &warnings);
+  for (int64_t i = import_warning_count; i < warnings.warnings().size(); ++i) {
+    if (warnings.warnings()[i].span.fileno() != fileno) {
+      imports.import_warnings.push_back(warnings.warnings()[i]);
+    }
   }
 
-  return insert_value->status();
+  if (!type_info.ok()) {
+    // A module which failed to import leaves type information behind for an
+    // AST which no longer exists, so start afresh next time.
+    imports.reusable = !imported_new_module;
+    imports.retired_modules.push_back(
+        std::make_unique<ModuleInfo>(std::move(module), nullptr, path));
+    return type_info.status();
+  }
+  TypecheckedModule result{module.get(), *type_info, std::move(warnings)};
+  XLS_RETURN_IF_ERROR(
+      import_data
+          .Put(subject, std::make_unique<ModuleInfo>(std::move(module),
+                                                     *type_info, path))
+          .status());
+  return result;
 }
 
 std::vector<verible::lsp::Diagnostic>
@@ -287,8 +534,15 @@ LanguageServerAdapter::FindDefinitions(
           ConvertSpanToLspLocation(definition_span, file_table);
       return std::vector<verible::lsp::Location>{location};
     }
+    return std::vector<verible::lsp::Location>{};
   }
-  return std::vector<verible::lsp::Location>{};
+  return workspace_index_.FindDefinitions(uri, position);
+}
+
+std::vector<verible::lsp::Location> LanguageServerAdapter::FindReferences(
+    LspUri uri, const verible::lsp::Position& position,
+    bool include_declaration) const {
+  return workspace_index_.FindReferences(uri, position, include_declaration);
 }
 
 absl::StatusOr<std::vector<verible::lsp::TextEdit>>
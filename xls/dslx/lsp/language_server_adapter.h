@@ -15,6 +15,7 @@
 #ifndef XLS_DSLX_LSP_LANGUAGE_SERVER_ADAPTER_H_
 #define XLS_DSLX_LSP_LANGUAGE_SERVER_ADAPTER_H_
 
+#include <deque>
 #include <filesystem>  // NOLINT
 #include <iostream>
 #include <memory>
@@ -25,19 +26,27 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "verible/common/lsp/lsp-protocol.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/fmt/comments.h"
+#include "xls/dslx/frontend/comment_data.h"
 #include "xls/dslx/frontend/module.h"
 #include "xls/dslx/frontend/pos.h"
 #include "xls/dslx/import_data.h"
 #include "xls/dslx/lsp/import_sensitivity.h"
 #include "xls/dslx/lsp/lsp_uri.h"
+#include "xls/dslx/lsp/workspace_index.h"
 #include "xls/dslx/parse_and_typecheck.h"
 #include "xls/dslx/type_system/type_info.h"
+#include "xls/dslx/virtualizable_file_system.h"
+#include "xls/dslx/warning_collector.h"
 
 namespace xls::dslx {
 
@@ -48,11 +57,13 @@ inline std::ostream& LspLog() { return std::cerr; }
 
 // Note: this is a thread-compatible implementation, but not thread safe (e.g.
 // we assume the language server request handler acts as a concurrency
-// serializing entity).
+// serializing entity). The only exception is the workspace index, which files
+// on disk are added to by a background thread.
 class LanguageServerAdapter {
  public:
   LanguageServerAdapter(LspUri stdlib_uri,
                         const std::vector<LspUri>& dslx_paths);
+  ~LanguageServerAdapter();
 
   // Takes note that `dslx_code` is the current file contents for `file_uri`
   // and performs a parse-and-typecheck using that file/contents as the entry
@@ -61,7 +72,10 @@ class LanguageServerAdapter {
   // `dslx_code` can be nullopt when we're re-evaluating the previous contents
   // again; i.e. because we think a dependency may have been corrected.
   //
-  // Note: this is parsing is triggered for every keystroke. Fine for now.
+  // Note: this is triggered for every keystroke, so the modules imported by the
+  // file are kept from one update to the next and only the file itself is
+  // reparsed and retypechecked; they are reloaded once any file they came from
+  // changes. An update with unchanged contents and imports does nothing.
   // Successful and unsuccessful parses are memoized so that their status
   // and can be queried.
   //
@@ -83,9 +97,38 @@ class LanguageServerAdapter {
 
   // Note: the return type is slightly unintuitive, but the latest LSP protocol
   // supports multiple defining locations for a single reference.
+  //
+  // Files which are not open, or whose current contents do not typecheck, are
+  // answered from the workspace index.
   absl::StatusOr<std::vector<verible::lsp::Location>> FindDefinitions(
       LspUri uri, const verible::lsp::Position& position) const;
 
+  // Returns the references throughout the workspace to the definition referred
+  // to at `position`, see
+  // https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#textDocument_references
+  std::vector<verible::lsp::Location> FindReferences(
+      LspUri uri, const verible::lsp::Position& position,
+      bool include_declaration) const;
+
+  // Returns the module-level definitions in the workspace whose names contain
+  // `query`, see
+  // https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#workspace_symbol
+  std::vector<WorkspaceIndex::Symbol> FindWorkspaceSymbols(
+      std::string_view query) const {
+    return workspace_index_.FindSymbols(query);
+  }
+
+  // Indexes every DSLX file under the directory `root` in the background.
+  // Files open in the editor are indexed as they are updated instead.
+  void IndexWorkspace(const LspUri& root);
+
+  // Reindexes `uri` in the background after it changed on disk (or removes it
+  // from the index if it no longer exists).
+  void NoteFileChangedOnDisk(const LspUri& uri);
+
+  // Blocks until the background indexing queued so far is done.
+  void WaitForIndexing();
+
   // Implements the functionality for full document formatting:
   // https://microsoft.github.io/language-server-protocol/specifications/lsp/3.17/specification/#textDocument_formatting
   //
@@ -129,23 +172,75 @@ class LanguageServerAdapter {
   struct TypecheckedModuleWithComments {
     TypecheckedModule tm;
     Comments comments;
-    std::string contents;
   };
 
+  // The modules imported by an editor buffer, which are kept across updates of
+  // the buffer.
+  struct BufferImports {
+    std::unique_ptr<ImportData> import_data;
+
+    // Every file looked for or read while importing, as it was at the time.
+    absl::btree_map<std::string, ObservedFile> observed_files;
+
+    // Warnings found in the imported modules, which are reported again for
+    // every revision of the buffer.
+    std::vector<WarningCollector::Entry> import_warnings;
+
+    // Earlier revisions of the buffer's module. The type information in
+    // `import_data` may still refer to them so they live as long as it does.
+    std::vector<std::unique_ptr<ModuleInfo>> retired_modules;
+
+    // Whether `import_data` may be used for the next revision; false once an
+    // import failed to typecheck.
+    bool reusable = true;
+  };
+
+  std::unique_ptr<BufferImports> CreateBufferImports();
+
+  // Queues `path`, a DSLX file or a directory to search for them, to be
+  // indexed in the background, starting the indexing thread if needed.
+  void QueueForIndexing(std::filesystem::path path);
+
+  // Body of the indexing thread.
+  void RunIndexer();
+
+  // Indexes the DSLX file `path` from disk, importing its dependencies into
+  // `import_data`.
+  absl::Status IndexFileFromDisk(const std::filesystem::path& path,
+                                 ImportData& import_data);
+
+  // Creates import data which reads files from disk only; the virtual
+  // filesystem may not be used from the indexing thread.
+  ImportData CreateIndexerImportData() const;
+
+  // Returns whether every file observed while importing for `imports` is
+  // unchanged.
+  bool ImportsUpToDate(const BufferImports& imports);
+
+  // As ParseAndTypecheck(), but keeps the imported modules in `imports`.
+  absl::StatusOr<TypecheckedModule> ParseAndTypecheckBuffer(
+      std::string_view text, const std::filesystem::path& path,
+      std::string_view module_name, BufferImports& imports,
+      std::vector<CommentData>* comments);
+
   // Everything relevant for a parsed editor buffer.
   // Note, each buffer independently currently keeps track of its import data.
   // This could maybe be considered to be put in a single place.
   class ParseData {
    public:
-    ParseData(ImportData&& import_data,
+    ParseData(std::unique_ptr<BufferImports> imports, std::string contents,
               absl::StatusOr<TypecheckedModuleWithComments> tmc)
-        : import_data_(std::move(import_data)), tmc_(std::move(tmc)) {}
+        : imports_(std::move(imports)),
+          contents_(std::move(contents)),
+          tmc_(std::move(tmc)) {}
 
     bool ok() const { return tmc_.ok(); }
     absl::Status status() const { return tmc_.status(); }
 
-    ImportData& import_data() { return import_data_; }
-    FileTable& file_table() { return import_data_.file_table(); }
+    ImportData& import_data() { return *imports_->import_data; }
+    FileTable& file_table() { return import_data().file_table(); }
+    const BufferImports& imports() const { return *imports_; }
+    std::unique_ptr<BufferImports> TakeImports() { return std::move(imports_); }
     const Module& module() const {
       CHECK_OK(tmc_.status());
       return *tmc_->tm.module;
@@ -158,17 +253,15 @@ class LanguageServerAdapter {
       CHECK_OK(tmc_.status());
       return tmc_->comments;
     }
-    const std::string& contents() const {
-      CHECK_OK(tmc_.status());
-      return tmc_->contents;
-    }
+    const std::string& contents() const { return contents_; }
     const TypecheckedModule& typechecked_module() const {
       CHECK_OK(tmc_.status());
       return tmc_->tm;
     }
 
    private:
-    ImportData import_data_;
+    std::unique_ptr<BufferImports> imports_;
+    std::string contents_;
     absl::StatusOr<TypecheckedModuleWithComments> tmc_;
   };
 
@@ -183,6 +276,16 @@ class LanguageServerAdapter {
   absl::flat_hash_map<LspUri, std::string> vfs_contents_;
 
   ImportSensitivity import_sensitivity_;
+
+  WorkspaceIndex workspace_index_;
+
+  absl::Mutex indexer_mutex_;
+  // Files and directories waiting to be indexed from disk.
+  std::deque<std::filesystem::path> indexer_queue_
+      ABSL_GUARDED_BY(indexer_mutex_);
+  bool indexer_busy_ ABSL_GUARDED_BY(indexer_mutex_) = false;
+  bool indexer_stopping_ ABSL_GUARDED_BY(indexer_mutex_) = false;
+  std::unique_ptr<Thread> indexer_;
 };
 
 }  // namespace xls::dslx
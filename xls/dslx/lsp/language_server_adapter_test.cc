@@ -36,6 +36,7 @@
 #include "xls/common/status/matchers.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/lsp/lsp_uri.h"
+#include "xls/dslx/lsp/workspace_index.h"
 
 namespace xls::dslx {
 namespace {
@@ -496,6 +497,89 @@ const OUTER_FOO = inner::FOO;  // this is not public, at first
   ASSERT_TRUE(diags.empty());
 }
 
+// Imports are kept across edits of a buffer, so this checks that the buffer
+// still sees a change to an imported module, and that edits which fail to
+// typecheck do not disturb later ones.
+TEST(LanguageServerAdapterTest, RepeatedUpdatesSeeChangedImports) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory tempdir, TempDirectory::Create());
+  LanguageServerAdapter adapter(
+      GetDslxStdlibUri(),
+      /*dslx_paths=*/{LspUri::FromFilesystemPath(tempdir.path())});
+  XLS_ASSERT_OK(
+      SetFileContents(tempdir.path() / "imported.x", "pub const X = u32:1;"));
+
+  const LspUri importer_uri(
+      absl::StrFormat("file://%s/importer.x", tempdir.path()));
+  XLS_ASSERT_OK(adapter.Update(importer_uri, R"(import imported;
+const_assert!(imported::X == u32:1);
+)"));
+  EXPECT_THAT(adapter.Update(importer_uri, R"(import imported;
+const_assert!(imported::X == u32:1);
+const Y = imported::Z;
+)"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  XLS_ASSERT_OK(adapter.Update(importer_uri, R"(import imported;
+const_assert!(imported::X == u32:1);
+const Y = imported::X;
+)"));
+  EXPECT_TRUE(adapter.GenerateParseDiagnostics(importer_uri).empty());
+
+  const LspUri imported_uri(
+      absl::StrFormat("file://%s/imported.x", tempdir.path()));
+  XLS_ASSERT_OK(adapter.Update(imported_uri, "pub const X = u32:2;"));
+  EXPECT_THAT(adapter.Update(importer_uri, std::nullopt),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(adapter.GenerateParseDiagnostics(importer_uri).size(), 1);
+}
+
+// Files which are never opened in the editor are found by indexing the
+// workspace in the background.
+TEST(LanguageServerAdapterTest, FindReferencesAcrossWorkspace) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory tempdir, TempDirectory::Create());
+  const LspUri tempdir_uri = LspUri::FromFilesystemPath(tempdir.path());
+  LanguageServerAdapter adapter(GetDslxStdlibUri(),
+                                /*dslx_paths=*/{tempdir_uri});
+
+  XLS_ASSERT_OK(SetFileContents(tempdir.path() / "imported.x",
+                                "pub const FOO = u32:42;"));
+  XLS_ASSERT_OK(SetFileContents(tempdir.path() / "user.x", R"(import imported;
+
+const BAR = imported::FOO + imported::FOO;
+)"));
+  adapter.IndexWorkspace(tempdir_uri);
+  adapter.WaitForIndexing();
+
+  std::vector<WorkspaceIndex::Symbol> symbols =
+      adapter.FindWorkspaceSymbols("foo");
+  ASSERT_EQ(symbols.size(), 1);
+  EXPECT_EQ(symbols[0].name, "FOO");
+  EXPECT_EQ(symbols[0].container, "imported");
+
+  // Ask for the references from the definition in the unopened file.
+  const LspUri imported_uri(
+      absl::StrFormat("file://%s/imported.x", tempdir.path()));
+  const std::string user_uri =
+      absl::StrFormat("file://%s/user.x", tempdir.path());
+  std::vector<verible::lsp::Location> references = adapter.FindReferences(
+      imported_uri, verible::lsp::Position{0, 11},
+      /*include_declaration=*/false);
+  ASSERT_EQ(references.size(), 2);
+  EXPECT_EQ(references[0].uri, user_uri);
+  EXPECT_EQ(references[0].range.start.character, 12);
+  EXPECT_EQ(references[1].range.start.character, 28);
+
+  // Once opened, the file is indexed from the editor's contents instead.
+  XLS_ASSERT_OK(adapter.Update(LspUri(user_uri), R"(import imported;
+
+const BAR = imported::FOO;
+)"));
+  EXPECT_EQ(adapter
+                .FindReferences(imported_uri, verible::lsp::Position{0, 11},
+                                /*include_declaration=*/true)
+                .size(),
+            2);
+}
+
 // Tests that when DSLX path values are given we can resolve imports against
 // them.
 TEST(LanguageServerAdapterTest, NontrivialDslxPathResolution) {
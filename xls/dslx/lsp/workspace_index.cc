@@ -0,0 +1,296 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/lsp/workspace_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/variant.h"
+#include "verible/common/lsp/lsp-protocol-enums.h"
+#include "verible/common/lsp/lsp-protocol.h"
+#include "xls/common/visitor.h"
+#include "xls/dslx/frontend/ast.h"
+#include "xls/dslx/frontend/module.h"
+#include "xls/dslx/frontend/pos.h"
+#include "xls/dslx/import_data.h"
+#include "xls/dslx/lsp/find_definition.h"
+#include "xls/dslx/lsp/lsp_type_utils.h"
+#include "xls/dslx/lsp/lsp_uri.h"
+#include "xls/dslx/type_system/type_info.h"
+
+namespace xls::dslx {
+namespace {
+
+bool Before(const verible::lsp::Position& lhs,
+            const verible::lsp::Position& rhs) {
+  return std::tie(lhs.line, lhs.character) <
+         std::tie(rhs.line, rhs.character);
+}
+
+bool SameRange(const verible::lsp::Range& lhs,
+               const verible::lsp::Range& rhs) {
+  return !Before(lhs.start, rhs.start) && !Before(rhs.start, lhs.start) &&
+         !Before(lhs.end, rhs.end) && !Before(rhs.end, lhs.end);
+}
+
+bool RangeContains(const verible::lsp::Range& range,
+                   const verible::lsp::Position& position) {
+  return !Before(position, range.start) && Before(position, range.end);
+}
+
+bool RangeContains(const verible::lsp::Range& outer,
+                   const verible::lsp::Range& inner) {
+  return !Before(inner.start, outer.start) && !Before(outer.end, inner.end);
+}
+
+// Returns the kind of symbol defined by `member`, or nullopt if it is not
+// reported as a workspace symbol. This matches the document symbols.
+std::optional<verible::lsp::SymbolKind> GetSymbolKind(
+    const ModuleMember& member) {
+  using verible::lsp::SymbolKind;
+  return absl::visit(
+      Visitor{
+          [](Function*) -> std::optional<SymbolKind> {
+            return SymbolKind::kMethod;
+          },
+          [](Proc*) -> std::optional<SymbolKind> {
+            return SymbolKind::kMethod;
+          },
+          [](StructDef*) -> std::optional<SymbolKind> {
+            return SymbolKind::kStruct;
+          },
+          [](ProcDef*) -> std::optional<SymbolKind> {
+            return SymbolKind::kStruct;
+          },
+          [](EnumDef*) -> std::optional<SymbolKind> {
+            return SymbolKind::kEnum;
+          },
+          [](ConstantDef*) -> std::optional<SymbolKind> {
+            return SymbolKind::kConstant;
+          },
+          [](auto*) -> std::optional<SymbolKind> { return std::nullopt; },
+      },
+      member);
+}
+
+}  // namespace
+
+void WorkspaceIndex::IndexModule(const LspUri& uri, const Module& module,
+                                 const TypeInfo& type_info,
+                                 ImportData& import_data, bool from_buffer) {
+  const FileTable& file_table = import_data.file_table();
+  FileEntry entry{.from_buffer = from_buffer};
+
+  for (const ModuleMember& member : module.top()) {
+    std::optional<verible::lsp::SymbolKind> kind = GetSymbolKind(member);
+    const NameDef* name_def = ModuleMemberGetNameDef(member);
+    if (!kind.has_value() || name_def == nullptr) {
+      continue;
+    }
+    entry.symbols.push_back(Symbol{
+        .name = name_def->identifier(),
+        .kind = *kind,
+        .location = ConvertSpanToLspLocation(name_def->span(), file_table),
+        .container = module.name(),
+    });
+  }
+
+  for (const AstNode* node : module.FindContained(module.span())) {
+    absl::StatusOr<const NameDef*> to =
+        ResolveReference(node, type_info, import_data);
+    if (!to.ok()) {
+      VLOG(3) << "Not indexing unresolved reference `" << node->ToString()
+              << "`: " << to.status();
+      continue;
+    }
+    if (*to == nullptr) {
+      continue;
+    }
+    verible::lsp::Location target =
+        ConvertSpanToLspLocation((*to)->span(), file_table);
+    entry.occurrences.push_back(Occurrence{
+        .range = ConvertSpanToLspRange(node->GetSpan().value()),
+        .target = DefinitionKey{.uri = LspUri(target.uri),
+                                .line = target.range.start.line,
+                                .character = target.range.start.character},
+        .target_range = target.range,
+        .is_definition = node == *to,
+    });
+  }
+  // A colon reference naming a type is found both as itself and as the type
+  // reference wrapping it.
+  std::sort(entry.occurrences.begin(), entry.occurrences.end(),
+            [](const Occurrence& a, const Occurrence& b) {
+              return Before(a.range.start, b.range.start) ||
+                     (!Before(b.range.start, a.range.start) &&
+                      Before(a.range.end, b.range.end));
+            });
+  entry.occurrences.erase(
+      std::unique(entry.occurrences.begin(), entry.occurrences.end(),
+                  [](const Occurrence& a, const Occurrence& b) {
+                    return SameRange(a.range, b.range) && a.target == b.target;
+                  }),
+      entry.occurrences.end());
+
+  absl::MutexLock lock(&mutex_);
+  if (auto it = files_.find(uri);
+      it != files_.end() && it->second.from_buffer && !from_buffer) {
+    return;
+  }
+  RemoveFileLocked(uri);
+  for (const Occurrence& occurrence : entry.occurrences) {
+    referring_files_[occurrence.target].insert(uri);
+  }
+  files_.insert_or_assign(uri, std::move(entry));
+}
+
+void WorkspaceIndex::RemoveFile(const LspUri& uri) {
+  absl::MutexLock lock(&mutex_);
+  RemoveFileLocked(uri);
+}
+
+void WorkspaceIndex::RemoveFileLocked(const LspUri& uri) {
+  auto it = files_.find(uri);
+  if (it == files_.end()) {
+    return;
+  }
+  for (const Occurrence& occurrence : it->second.occurrences) {
+    auto referring = referring_files_.find(occurrence.target);
+    if (referring == referring_files_.end()) {
+      continue;
+    }
+    referring->second.erase(uri);
+    if (referring->second.empty()) {
+      referring_files_.erase(referring);
+    }
+  }
+  files_.erase(it);
+}
+
+bool WorkspaceIndex::Contains(const LspUri& uri) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return files_.contains(uri);
+}
+
+int64_t WorkspaceIndex::file_count() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return files_.size();
+}
+
+const WorkspaceIndex::Occurrence* WorkspaceIndex::FindOccurrence(
+    const LspUri& uri, const verible::lsp::Position& position) const {
+  auto it = files_.find(uri);
+  if (it == files_.end()) {
+    return nullptr;
+  }
+  const std::vector<Occurrence>& occurrences = it->second.occurrences;
+  // Names do not span lines, so only the occurrences starting on the line of
+  // `position` can contain it.
+  auto end = std::upper_bound(
+      occurrences.begin(), occurrences.end(), position,
+      [](const verible::lsp::Position& p, const Occurrence& occurrence) {
+        return Before(p, occurrence.range.start);
+      });
+  const Occurrence* result = nullptr;
+  for (auto o = end; o != occurrences.begin();) {
+    --o;
+    if (o->range.start.line != position.line) {
+      break;
+    }
+    if (RangeContains(o->range, position) &&
+        (result == nullptr || RangeContains(o->range, result->range))) {
+      result = &*o;
+    }
+  }
+  return result;
+}
+
+std::vector<verible::lsp::Location> WorkspaceIndex::FindDefinitions(
+    const LspUri& uri, const verible::lsp::Position& position) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  const Occurrence* occurrence = FindOccurrence(uri, position);
+  if (occurrence == nullptr) {
+    return {};
+  }
+  verible::lsp::Location location{.range = occurrence->target_range};
+  location.uri = std::string(occurrence->target.uri.GetStringView());
+  return {std::move(location)};
+}
+
+std::vector<verible::lsp::Location> WorkspaceIndex::FindReferences(
+    const LspUri& uri, const verible::lsp::Position& position,
+    bool include_declaration) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  const Occurrence* occurrence = FindOccurrence(uri, position);
+  if (occurrence == nullptr) {
+    return {};
+  }
+  const DefinitionKey& target = occurrence->target;
+  std::vector<verible::lsp::Location> result;
+  if (include_declaration && !files_.contains(target.uri)) {
+    verible::lsp::Location location{.range = occurrence->target_range};
+    location.uri = std::string(target.uri.GetStringView());
+    result.push_back(std::move(location));
+  }
+  auto referring = referring_files_.find(target);
+  if (referring == referring_files_.end()) {
+    return result;
+  }
+  std::vector<LspUri> referring_uris(referring->second.begin(),
+                                     referring->second.end());
+  std::sort(referring_uris.begin(), referring_uris.end());
+  for (const LspUri& referring_uri : referring_uris) {
+    for (const Occurrence& o : files_.at(referring_uri).occurrences) {
+      if (o.target == target && (include_declaration || !o.is_definition)) {
+        verible::lsp::Location location{.range = o.range};
+        location.uri = std::string(referring_uri.GetStringView());
+        result.push_back(std::move(location));
+      }
+    }
+  }
+  return result;
+}
+
+std::vector<WorkspaceIndex::Symbol> WorkspaceIndex::FindSymbols(
+    std::string_view query) const {
+  std::vector<Symbol> result;
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    for (const auto& [uri, entry] : files_) {
+      for (const Symbol& symbol : entry.symbols) {
+        if (absl::StrContainsIgnoreCase(symbol.name, query)) {
+          result.push_back(symbol);
+        }
+      }
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const Symbol& a, const Symbol& b) {
+    return std::tie(a.name, a.location.uri) < std::tie(b.name, b.location.uri);
+  });
+  return result;
+}
+
+}  // namespace xls::dslx
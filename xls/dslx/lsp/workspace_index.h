@@ -0,0 +1,140 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DSLX_LSP_WORKSPACE_INDEX_H_
+#define XLS_DSLX_LSP_WORKSPACE_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "verible/common/lsp/lsp-protocol-enums.h"
+#include "verible/common/lsp/lsp-protocol.h"
+#include "xls/dslx/frontend/module.h"
+#include "xls/dslx/import_data.h"
+#include "xls/dslx/lsp/lsp_uri.h"
+#include "xls/dslx/type_system/type_info.h"
+
+namespace xls::dslx {
+
+// An index of the definitions in, and the references made by, every DSLX file
+// of a workspace, so that go-to-definition, find-references and
+// workspace-symbol queries are answered from the index rather than by parsing
+// and typechecking the files involved.
+//
+// Each file is indexed from its typechecked module; indexing a file again
+// replaces everything recorded for it, so the index is kept current by
+// reindexing files as they change. Only the reverse references of the names a
+// file refers to are updated, which keeps reindexing proportional to the size
+// of the file.
+//
+// Files indexed from editor buffers take precedence over the same files
+// indexed from disk, which may be stale.
+//
+// This class is thread safe.
+class WorkspaceIndex {
+ public:
+  // A module-level definition, as reported for workspace-symbol queries.
+  struct Symbol {
+    std::string name;
+    verible::lsp::SymbolKind kind;
+    verible::lsp::Location location;
+    // Name of the module containing the definition.
+    std::string container;
+  };
+
+  // Indexes the definitions and references in `module`, which was parsed from
+  // `uri`; `from_buffer` is whether it came from an editor buffer rather than
+  // from disk.
+  void IndexModule(const LspUri& uri, const Module& module,
+                   const TypeInfo& type_info, ImportData& import_data,
+                   bool from_buffer);
+
+  // Forgets everything recorded for `uri`.
+  void RemoveFile(const LspUri& uri);
+
+  bool Contains(const LspUri& uri) const;
+  int64_t file_count() const;
+
+  // Returns the definition referred to at `position` in `uri`, if any.
+  std::vector<verible::lsp::Location> FindDefinitions(
+      const LspUri& uri, const verible::lsp::Position& position) const;
+
+  // Returns every reference in the workspace to the definition referred to at
+  // `position` in `uri`, ordered by file and position, optionally with the
+  // definition itself.
+  std::vector<verible::lsp::Location> FindReferences(
+      const LspUri& uri, const verible::lsp::Position& position,
+      bool include_declaration) const;
+
+  // Returns the module-level definitions whose name contains `query`, ignoring
+  // case, ordered by name.
+  std::vector<Symbol> FindSymbols(std::string_view query) const;
+
+ private:
+  // Identifies a definition by the start of its name.
+  struct DefinitionKey {
+    LspUri uri;
+    int64_t line;
+    int64_t character;
+
+    bool operator==(const DefinitionKey& other) const = default;
+
+    template <typename H>
+    friend H AbslHashValue(H h, const DefinitionKey& key) {
+      return H::combine(std::move(h), key.uri, key.line, key.character);
+    }
+  };
+
+  // A name in a file referring to a definition, or the name of the definition
+  // itself.
+  struct Occurrence {
+    verible::lsp::Range range;
+    DefinitionKey target;
+    verible::lsp::Range target_range;
+    bool is_definition;
+  };
+
+  struct FileEntry {
+    bool from_buffer = false;
+    std::vector<Symbol> symbols;
+    // Ordered by the start of their range.
+    std::vector<Occurrence> occurrences;
+  };
+
+  // Returns the occurrence at `position` in `uri`; if several overlap (e.g.
+  // the subject and the whole of a colon reference) the outermost one.
+  const Occurrence* FindOccurrence(const LspUri& uri,
+                                   const verible::lsp::Position& position)
+      const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
+  void RemoveFileLocked(const LspUri& uri)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<LspUri, FileEntry> files_ ABSL_GUARDED_BY(mutex_);
+  // The files referring to each definition.
+  absl::flat_hash_map<DefinitionKey, absl::flat_hash_set<LspUri>>
+      referring_files_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls::dslx
+
+#endif  // XLS_DSLX_LSP_WORKSPACE_INDEX_H_
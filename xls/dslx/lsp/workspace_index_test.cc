@@ -0,0 +1,108 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/dslx/lsp/workspace_index.h"
+
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "verible/common/lsp/lsp-protocol-enums.h"
+#include "verible/common/lsp/lsp-protocol.h"
+#include "xls/common/status/matchers.h"
+#include "xls/dslx/create_import_data.h"
+#include "xls/dslx/import_data.h"
+#include "xls/dslx/lsp/lsp_uri.h"
+#include "xls/dslx/parse_and_typecheck.h"
+
+namespace xls::dslx {
+namespace {
+
+constexpr std::string_view kPath = "/fake/path/test.x";
+
+constexpr std::string_view kProgram = R"(const FOO = u32:42;
+fn f() -> u32 { FOO }
+fn g() -> u32 { FOO + f() }
+)";
+
+void Index(WorkspaceIndex& index, std::string_view program, bool from_buffer) {
+  ImportData import_data = CreateImportDataForTest();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(program, kPath, "test", &import_data));
+  index.IndexModule(LspUri::FromFilesystemPath(kPath), *tm.module,
+                    *tm.type_info, import_data, from_buffer);
+}
+
+TEST(WorkspaceIndexTest, DefinitionsReferencesAndSymbols) {
+  WorkspaceIndex index;
+  Index(index, kProgram, /*from_buffer=*/true);
+  const LspUri uri = LspUri::FromFilesystemPath(kPath);
+
+  // `f` in the body of `g`.
+  std::vector<verible::lsp::Location> definitions =
+      index.FindDefinitions(uri, verible::lsp::Position{2, 22});
+  ASSERT_EQ(definitions.size(), 1);
+  EXPECT_EQ(definitions[0].uri, uri.GetStringView());
+  EXPECT_EQ(definitions[0].range.start.line, 1);
+  EXPECT_EQ(definitions[0].range.start.character, 3);
+
+  // `FOO` in the body of `f`.
+  std::vector<verible::lsp::Location> references = index.FindReferences(
+      uri, verible::lsp::Position{1, 17}, /*include_declaration=*/false);
+  ASSERT_EQ(references.size(), 2);
+  EXPECT_EQ(references[0].range.start.line, 1);
+  EXPECT_EQ(references[1].range.start.line, 2);
+  references = index.FindReferences(uri, verible::lsp::Position{1, 17},
+                                    /*include_declaration=*/true);
+  ASSERT_EQ(references.size(), 3);
+  EXPECT_EQ(references[0].range.start.line, 0);
+
+  std::vector<WorkspaceIndex::Symbol> symbols = index.FindSymbols("f");
+  ASSERT_EQ(symbols.size(), 2);
+  EXPECT_EQ(symbols[0].name, "FOO");
+  EXPECT_EQ(symbols[0].kind, verible::lsp::SymbolKind::kConstant);
+  EXPECT_EQ(symbols[1].name, "f");
+  EXPECT_EQ(symbols[1].kind, verible::lsp::SymbolKind::kMethod);
+  EXPECT_EQ(index.FindSymbols("").size(), 3);
+
+  // Nothing is referred to between the names.
+  EXPECT_TRUE(index.FindDefinitions(uri, verible::lsp::Position{1, 6}).empty());
+}
+
+TEST(WorkspaceIndexTest, ReindexingReplacesFile) {
+  WorkspaceIndex index;
+  const LspUri uri = LspUri::FromFilesystemPath(kPath);
+  Index(index, kProgram, /*from_buffer=*/false);
+  Index(index, "const FOO = u32:42;\nconst BAR = FOO;\n", /*from_buffer=*/true);
+  EXPECT_EQ(index.FindReferences(uri, verible::lsp::Position{0, 7},
+                                 /*include_declaration=*/false)
+                .size(),
+            1);
+  EXPECT_EQ(index.FindSymbols("").size(), 2);
+
+  // The editor's contents take precedence over those on disk.
+  Index(index, kProgram, /*from_buffer=*/false);
+  EXPECT_EQ(index.FindSymbols("").size(), 2);
+
+  index.RemoveFile(uri);
+  EXPECT_FALSE(index.Contains(uri));
+  EXPECT_TRUE(index.FindSymbols("").empty());
+  EXPECT_TRUE(index.FindReferences(uri, verible::lsp::Position{0, 7},
+                                   /*include_declaration=*/true)
+                  .empty());
+}
+
+}  // namespace
+}  // namespace xls::dslx
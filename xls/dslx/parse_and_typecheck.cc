@@ -23,6 +23,7 @@
 
 #include "absl/cleanup/cleanup.h"
 #include "absl/log/check.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "xls/common/file/get_runfile_path.h"
 #include "xls/common/status/ret_check.h"
@@ -33,6 +34,7 @@
 #include "xls/dslx/frontend/pos.h"
 #include "xls/dslx/frontend/scanner.h"
 #include "xls/dslx/import_data.h"
+#include "xls/dslx/import_routines.h"
 #include "xls/dslx/type_system/type_info.h"
 #include "xls/dslx/type_system/typecheck_module.h"
 #include "xls/dslx/warning_collector.h"
@@ -58,6 +60,7 @@ absl::StatusOr<TypecheckedModule> ParseAndTypecheck(
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Module> module,
                        ParseModule(text, path, module_name,
                                    import_data->file_table(), comments));
+  XLS_RETURN_IF_ERROR(PrefetchImports(*module, import_data));
   return TypecheckModule(std::move(module), path, import_data);
 }
 
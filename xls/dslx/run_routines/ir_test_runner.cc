@@ -14,6 +14,7 @@
 
 #include "xls/dslx/run_routines/ir_test_runner.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <iterator>
@@ -67,21 +68,64 @@
 
 namespace xls::dslx {
 namespace {
-class IrRunner : public AbstractParsedTestRunner {
+
+// Returns the failure for the given assertion messages. Assertions converted
+// from DSLX end their message with ` @ <span>`, which is used to report the
+// failure against the DSLX source as the DSLX interpreter would.
+absl::Status AssertionFailureStatus(absl::Span<const std::string> assert_msgs,
+                                    FileTable& file_table) {
+  std::string message = absl::StrJoin(assert_msgs, "\n");
+  std::string_view first = assert_msgs.front();
+  if (size_t at = first.rfind(" @ "); at != std::string_view::npos) {
+    if (absl::StatusOr<Span> span =
+            Span::FromString(first.substr(at + 3), file_table);
+        span.ok()) {
+      return FailureErrorStatus(*span, message, file_table);
+    }
+  }
+  return absl::AbortedError(message);
+}
+
+using FunctionRunner = std::function<absl::StatusOr<InterpreterResult<Value>>(
+    xls::Function* f, absl::Span<Value const>)>;
+
+// Returns a FunctionRunner for `f` which may be called on another thread
+// concurrently with any other runner.
+using ConcurrentFunctionRunnerFactory =
+    std::function<absl::StatusOr<FunctionRunner>(xls::Function* f)>;
+
+class FunctionRunnerAdapter : public AbstractIrFunctionRunner {
+ public:
+  explicit FunctionRunnerAdapter(FunctionRunner func_runner)
+      : func_runner_(std::move(func_runner)) {}
+
+  absl::StatusOr<InterpreterResult<Value>> RunIrFunction(
+      std::string_view ir_name, xls::Function* ir_function,
+      absl::Span<const Value> ir_args) override {
+    return func_runner_(ir_function, ir_args);
+  }
+
+ private:
+  FunctionRunner func_runner_;
+};
+
+class IrRunner : public AbstractParsedTestRunner,
+                 public AbstractIrFunctionRunner {
  public:
   IrRunner(
       absl::flat_hash_map<std::string, std::unique_ptr<Package>>&& packages,
       absl::flat_hash_map<std::string, std::string>&& finish_chan_names,
       std::function<absl::StatusOr<std::unique_ptr<ProcRuntime>>(xls::Package*)>
           proc_runner,
-      std::function<absl::StatusOr<InterpreterResult<Value>>(
-          xls::Function* f, absl::Span<Value const>)>
-          func_runner,
+      FunctionRunner func_runner,
+      ConcurrentFunctionRunnerFactory concurrent_func_runner_factory,
       ImportData* import_data)
       : packages_(std::move(packages)),
         finish_chan_names_(std::move(finish_chan_names)),
         proc_runner_(std::move(proc_runner)),
         func_runner_(std::move(func_runner)),
+        concurrent_func_runner_factory_(
+            std::move(concurrent_func_runner_factory)),
         import_data_(import_data) {}
 
   // TODO need to move to having each test proc have its own package from
@@ -124,8 +168,7 @@ class IrRunner : public AbstractParsedTestRunner {
       }
       return RunResult{.result = absl::OkStatus()};
     }
-    return RunResult{.result =
-                         absl::AbortedError(absl::StrJoin(asserts, "\n"))};
+    return RunResult{.result = AssertionFailureStatus(asserts, file_table())};
   }
 
   absl::StatusOr<RunResult> RunTestProc(
@@ -176,8 +219,24 @@ class IrRunner : public AbstractParsedTestRunner {
     if (v.events.assert_msgs.empty()) {
       return RunResult{.result = absl::OkStatus()};
     }
-    return RunResult{.result = absl::AbortedError(
-                         absl::StrJoin(v.events.assert_msgs, "\n"))};
+    return RunResult{.result = AssertionFailureStatus(v.events.assert_msgs,
+                                                      file_table())};
+  }
+
+  AbstractIrFunctionRunner* ir_function_runner() override { return this; }
+
+  absl::StatusOr<InterpreterResult<Value>> RunIrFunction(
+      std::string_view ir_name, xls::Function* ir_function,
+      absl::Span<const Value> ir_args) override {
+    return func_runner_(ir_function, ir_args);
+  }
+
+  absl::StatusOr<std::unique_ptr<AbstractIrFunctionRunner>>
+  CreateConcurrentRunner(std::string_view ir_name,
+                         xls::Function* ir_function) override {
+    XLS_ASSIGN_OR_RETURN(FunctionRunner func_runner,
+                         concurrent_func_runner_factory_(ir_function));
+    return std::make_unique<FunctionRunnerAdapter>(std::move(func_runner));
   }
 
  private:
@@ -187,17 +246,14 @@ class IrRunner : public AbstractParsedTestRunner {
   absl::flat_hash_map<std::string, std::string> finish_chan_names_;
   std::function<absl::StatusOr<std::unique_ptr<ProcRuntime>>(xls::Package*)>
       proc_runner_;
-  std::function<absl::StatusOr<InterpreterResult<Value>>(
-      xls::Function* f, absl::Span<Value const>)>
-      func_runner_;
+  FunctionRunner func_runner_;
+  ConcurrentFunctionRunnerFactory concurrent_func_runner_factory_;
   ImportData* import_data_;
 };
 
 absl::StatusOr<std::unique_ptr<AbstractParsedTestRunner>> MakeRunner(
     ImportData* import_data, TypeInfo* type_info, Module* module,
-    std::function<absl::StatusOr<InterpreterResult<Value>>(
-        xls::Function* f, absl::Span<Value const>)>
-        func,
+    FunctionRunner func, ConcurrentFunctionRunnerFactory concurrent_func,
     std::function<absl::StatusOr<std::unique_ptr<ProcRuntime>>(xls::Package*)>
         proc) {
   ConvertOptions base_option{
@@ -231,20 +287,44 @@ absl::StatusOr<std::unique_ptr<AbstractParsedTestRunner>> MakeRunner(
   }
   return std::make_unique<IrRunner>(
       std::move(packages), std::move(finish_chan_names), std::move(proc),
-      std::move(func), import_data);
+      std::move(func), std::move(concurrent_func), import_data);
 }
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<AbstractParsedTestRunner>>
 IrJitTestRunner::CreateTestRunner(ImportData* import_data, TypeInfo* type_info,
                                   Module* module) const {
+  // Quickchecks run the same function many times so it is only compiled once.
+  auto jit_cache = std::make_shared<
+      absl::flat_hash_map<xls::Function*, std::unique_ptr<FunctionJit>>>();
+  auto get_or_compile =
+      [jit_cache](xls::Function* f) -> absl::StatusOr<FunctionJit*> {
+    auto it = jit_cache->find(f);
+    if (it == jit_cache->end()) {
+      XLS_ASSIGN_OR_RETURN(std::unique_ptr<FunctionJit> jit,
+                           FunctionJit::Create(f));
+      it = jit_cache->emplace(f, std::move(jit)).first;
+    }
+    return it->second.get();
+  };
   return MakeRunner(
       import_data, type_info, module,
-      [](xls::Function* f,
-         auto args) -> absl::StatusOr<InterpreterResult<Value>> {
-        XLS_ASSIGN_OR_RETURN(auto jit, FunctionJit::Create(f));
+      [get_or_compile](xls::Function* f, absl::Span<Value const> args)
+          -> absl::StatusOr<InterpreterResult<Value>> {
+        XLS_ASSIGN_OR_RETURN(FunctionJit * jit, get_or_compile(f));
         return jit->Run(args);
       },
+      // The function is compiled up front so that concurrent runners only
+      // share the (immutable) compiled code and each run on a context of its
+      // own.
+      [get_or_compile](xls::Function* f) -> absl::StatusOr<FunctionRunner> {
+        XLS_ASSIGN_OR_RETURN(FunctionJit * jit, get_or_compile(f));
+        std::shared_ptr<FunctionJit::ExecutionContext> context =
+            jit->CreateExecutionContext();
+        return [context](xls::Function*, absl::Span<Value const> args) {
+          return context->Run(args);
+        };
+      },
       [](xls::Package* p) -> absl::StatusOr<std::unique_ptr<ProcRuntime>> {
         return CreateJitSerialProcRuntime(p, EvaluatorOptions());
       });
@@ -259,6 +339,11 @@ IrInterpreterTestRunner::CreateTestRunner(ImportData* import_data,
       [&](xls::Function* f, absl::Span<Value const> args) {
         return InterpretFunction(f, args);
       },
+      [](xls::Function*) -> absl::StatusOr<FunctionRunner> {
+        return [](xls::Function* f, absl::Span<Value const> args) {
+          return InterpretFunction(f, args);
+        };
+      },
       [](xls::Package* p) -> absl::StatusOr<std::unique_ptr<ProcRuntime>> {
         return CreateInterpreterSerialProcRuntime(p, EvaluatorOptions());
       });
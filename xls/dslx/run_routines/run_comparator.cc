@@ -40,6 +40,25 @@
 #include "xls/jit/function_jit.h"
 
 namespace xls::dslx {
+namespace {
+
+// Runs a JIT'd function on an execution context of its own.
+class JitContextRunner : public AbstractIrFunctionRunner {
+ public:
+  explicit JitContextRunner(const FunctionJit& jit)
+      : context_(jit.CreateExecutionContext()) {}
+
+  absl::StatusOr<InterpreterResult<xls::Value>> RunIrFunction(
+      std::string_view ir_name, xls::Function* ir_function,
+      absl::Span<const xls::Value> ir_args) override {
+    return context_->Run(ir_args);
+  }
+
+ private:
+  std::unique_ptr<FunctionJit::ExecutionContext> context_;
+};
+
+}  // namespace
 
 absl::StatusOr<FunctionJit*> RunComparator::GetOrCompileJitFunction(
     std::string_view ir_name, xls::Function* ir_function) {
@@ -146,4 +165,12 @@ absl::StatusOr<InterpreterResult<xls::Value>> RunComparator::RunIrFunction(
   return jit->Run(ir_args);
 }
 
+absl::StatusOr<std::unique_ptr<AbstractIrFunctionRunner>>
+RunComparator::CreateConcurrentRunner(std::string_view ir_name,
+                                      xls::Function* ir_function) {
+  XLS_ASSIGN_OR_RETURN(FunctionJit * jit,
+                       GetOrCompileJitFunction(ir_name, ir_function));
+  return std::make_unique<JitContextRunner>(*jit);
+}
+
 }  // namespace xls::dslx
@@ -63,6 +63,11 @@ class RunComparator : public AbstractRunComparator {
       std::string_view ir_name, xls::Function* ir_function,
       absl::Span<const xls::Value> ir_args) override;
 
+  // Returns a runner over its own execution context of the JIT'd ir_function.
+  absl::StatusOr<std::unique_ptr<AbstractIrFunctionRunner>>
+  CreateConcurrentRunner(std::string_view ir_name,
+                         xls::Function* ir_function) override;
+
   // Returns the cached or newly-compiled jit function for ir_name.  ir_name has
   // already been mangled (see MangleDslxName) so it should be unique in the
   // program and is used as the cache key.
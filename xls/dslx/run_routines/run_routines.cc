@@ -17,9 +17,11 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <ctime>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <random>
@@ -29,6 +31,7 @@
 #include <variant>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/bind_front.h"
 #include "absl/log/check.h"
@@ -38,16 +41,20 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/bytecode/bytecode.h"
 #include "xls/dslx/bytecode/bytecode_cache.h"
 #include "xls/dslx/bytecode/bytecode_emitter.h"
 #include "xls/dslx/bytecode/bytecode_interpreter.h"
 #include "xls/dslx/bytecode/bytecode_interpreter_options.h"
+#include "xls/dslx/bytecode/proc_scheduler.h"
 #include "xls/dslx/command_line_utils.h"
 #include "xls/dslx/create_import_data.h"
 #include "xls/dslx/error_printer.h"
@@ -148,7 +155,14 @@ absl::Status RunDslxTestFunction(ImportData* import_data, TypeInfo* type_info,
 
 absl::Status RunDslxTestProc(ImportData* import_data, TypeInfo* type_info,
                              Module* module, TestProc* tp,
-                             const BytecodeInterpreterOptions& options) {
+                             const BytecodeInterpreterOptions& base_options) {
+  // The hooks given by the caller need not be thread safe.
+  absl::Mutex hook_mutex;
+  BytecodeInterpreterOptions options =
+      base_options.proc_thread_count() > 1
+          ? SerializeInterpreterHooks(base_options, &hook_mutex)
+          : base_options;
+
   auto cache = std::make_unique<BytecodeCache>(import_data);
   import_data->SetBytecodeCache(std::move(cache));
 
@@ -165,37 +179,9 @@ absl::Status RunDslxTestProc(ImportData* import_data, TypeInfo* type_info,
 
   std::shared_ptr<InterpValue::Channel> term_chan =
       terminator.GetChannelOrDie();
-  int64_t tick_count = 0;
-  while (term_chan->empty()) {
-    bool progress_made = false;
-    if (options.max_ticks().has_value() &&
-        tick_count > options.max_ticks().value()) {
-      return absl::DeadlineExceededError(
-          absl::StrFormat("Exceeded limit of %d proc ticks before terminating",
-                          options.max_ticks().value()));
-    }
-
-    std::vector<std::string> blocked_channels;
-    for (auto& p : proc_instances) {
-      XLS_ASSIGN_OR_RETURN(ProcRunResult run_result, p.Run());
-      if (run_result.execution_state == ProcExecutionState::kBlockedOnReceive) {
-        XLS_RET_CHECK(run_result.blocked_channel_info.has_value());
-        BlockedChannelInfo channel_info =
-            run_result.blocked_channel_info.value();
-        blocked_channels.push_back(absl::StrFormat(
-            "%s: proc `%s` is blocked on receive on channel `%s`",
-            channel_info.span.ToString(import_data->file_table()),
-            p.proc()->identifier(), channel_info.name));
-      }
-      progress_made |= run_result.progress_made;
-    }
-
-    if (!progress_made) {
-      return absl::DeadlineExceededError(absl::StrFormat(
-          "Procs are deadlocked:\n%s", absl::StrJoin(blocked_channels, "\n")));
-    }
-    ++tick_count;
-  }
+  XLS_RETURN_IF_ERROR(RunProcNetwork(absl::MakeSpan(proc_instances),
+                                     *term_chan, import_data->file_table(),
+                                     options));
 
   InterpValue ret_val = term_chan->front();
   XLS_RET_CHECK(ret_val.IsBool());
@@ -295,22 +281,31 @@ static bool TestMatchesFilter(std::string_view test_name,
   return RE2::FullMatch(test_name, *test_filter);
 }
 
-absl::StatusOr<QuickCheckResults> DoQuickCheck(
-    xls::Function* xls_function, std::string_view ir_name,
-    AbstractRunComparator* run_comparator, int64_t seed, int64_t num_tests) {
-  QuickCheckResults results;
-  std::minstd_rand rng_engine(seed);
+// Quickcheck samples are drawn and evaluated in shards of this many.
+constexpr int64_t kQuickCheckShardSize = 1024;
 
-  for (int i = 0; i < num_tests; i++) {
+// Evaluates `count` samples of the shard with the given index, stopping early
+// at the first counterexample.
+static absl::Status RunQuickCheckShard(
+    xls::Function* xls_function, std::string_view ir_name,
+    AbstractIrFunctionRunner* ir_function_runner, int64_t seed, int64_t shard,
+    int64_t count, QuickCheckResults& results) {
+  std::seed_seq seeds{static_cast<uint32_t>(seed),
+                      static_cast<uint32_t>(static_cast<uint64_t>(seed) >> 32),
+                      static_cast<uint32_t>(shard)};
+  std::minstd_rand rng_engine(seeds);
+
+  for (int64_t i = 0; i < count; i++) {
     results.arg_sets.push_back(
         RandomFunctionArguments(xls_function, rng_engine));
     // TODO(https://github.com/google/xls/issues/506): 2021-10-15
     // Assertion failures should work out, but we should consciously decide
     // if/how we want to dump traces when running QuickChecks (always, for
     // failures, flag-controlled, ...).
-    XLS_ASSIGN_OR_RETURN(xls::Value result,
-                         DropInterpreterEvents(run_comparator->RunIrFunction(
-                             ir_name, xls_function, results.arg_sets.back())));
+    XLS_ASSIGN_OR_RETURN(
+        xls::Value result,
+        DropInterpreterEvents(ir_function_runner->RunIrFunction(
+            ir_name, xls_function, results.arg_sets.back())));
 
     // In the case of an implicit token signature we get (token, bool) as the
     // result of the quickcheck'd function, so we unbox the boolean here.
@@ -327,7 +322,71 @@ absl::StatusOr<QuickCheckResults> DoQuickCheck(
       break;
     }
   }
+  return absl::OkStatus();
+}
 
+absl::StatusOr<QuickCheckResults> DoQuickCheck(
+    xls::Function* xls_function, std::string_view ir_name,
+    AbstractIrFunctionRunner* ir_function_runner, int64_t seed,
+    int64_t num_tests, int64_t num_threads) {
+  const int64_t num_shards = CeilOfRatio(num_tests, kQuickCheckShardSize);
+  std::vector<QuickCheckResults> shard_results(num_shards);
+  std::vector<absl::Status> shard_statuses(num_shards);
+  // Shards are claimed in order and the first one to find a counterexample (or
+  // fail) stops the shards after it from being claimed. Every shard before it
+  // still runs to completion so the reported counterexample is deterministic.
+  std::atomic<int64_t> next_shard = 0;
+  std::atomic<int64_t> first_stopped_shard = num_shards;
+  auto run_shards = [&](AbstractIrFunctionRunner* runner) {
+    for (int64_t shard = next_shard.fetch_add(1);
+         shard < first_stopped_shard.load(); shard = next_shard.fetch_add(1)) {
+      QuickCheckResults& results = shard_results[shard];
+      shard_statuses[shard] = RunQuickCheckShard(
+          xls_function, ir_name, runner, seed, shard,
+          std::min(kQuickCheckShardSize,
+                   num_tests - shard * kQuickCheckShardSize),
+          results);
+      if (shard_statuses[shard].ok() && !results.results.back().IsAllZeros()) {
+        continue;
+      }
+      int64_t stopped = first_stopped_shard.load();
+      while (shard < stopped &&
+             !first_stopped_shard.compare_exchange_weak(stopped, shard)) {
+      }
+    }
+  };
+
+  std::vector<std::unique_ptr<AbstractIrFunctionRunner>> runners;
+  for (int64_t i = 0; i < std::min(num_threads, num_shards); ++i) {
+    XLS_ASSIGN_OR_RETURN(
+        std::unique_ptr<AbstractIrFunctionRunner> runner,
+        ir_function_runner->CreateConcurrentRunner(ir_name, xls_function));
+    if (runner == nullptr) {
+      break;
+    }
+    runners.push_back(std::move(runner));
+  }
+  if (runners.size() > 1) {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (std::unique_ptr<AbstractIrFunctionRunner>& runner : runners) {
+      threads.push_back(std::make_unique<Thread>(
+          [&run_shards, runner = runner.get()] { run_shards(runner); }));
+    }
+  } else {
+    run_shards(ir_function_runner);
+  }
+
+  QuickCheckResults results;
+  for (int64_t shard = 0; shard < num_shards; ++shard) {
+    XLS_RETURN_IF_ERROR(shard_statuses[shard]);
+    absl::c_move(shard_results[shard].arg_sets,
+                 std::back_inserter(results.arg_sets));
+    absl::c_move(shard_results[shard].results,
+                 std::back_inserter(results.results));
+    if (shard == first_stopped_shard.load()) {
+      break;
+    }
+  }
   return results;
 }
 
@@ -364,9 +423,10 @@ static absl::StatusOr<QuickcheckIrFn> FindQuickcheckIrFn(Function* fn,
                       absl::StrJoin(ir_package->GetFunctionNames(), ", ")));
 }
 
-static absl::Status RunQuickCheck(AbstractRunComparator* run_comparator,
+static absl::Status RunQuickCheck(AbstractIrFunctionRunner* ir_function_runner,
                                   Package* ir_package, QuickCheck* quickcheck,
-                                  TypeInfo* type_info, int64_t seed) {
+                                  TypeInfo* type_info, int64_t seed,
+                                  int64_t num_threads) {
   // Note: DSLX function.
   Function* fn = quickcheck->fn();
 
@@ -375,8 +435,8 @@ static absl::Status RunQuickCheck(AbstractRunComparator* run_comparator,
 
   XLS_ASSIGN_OR_RETURN(
       QuickCheckResults qc_results,
-      DoQuickCheck(qc_fn.ir_function, qc_fn.ir_name, run_comparator, seed,
-                   quickcheck->GetTestCountOrDefault()));
+      DoQuickCheck(qc_fn.ir_function, qc_fn.ir_name, ir_function_runner, seed,
+                   quickcheck->GetTestCountOrDefault(), num_threads));
   const auto& [arg_sets, results] = qc_results;
   XLS_ASSIGN_OR_RETURN(Bits last_result, results.back().GetBitsWithStatus());
   if (!last_result.IsZero()) {
@@ -410,10 +470,10 @@ static absl::Status RunQuickCheck(AbstractRunComparator* run_comparator,
 
 static absl::Status RunQuickChecksIfJitEnabled(
     const RE2* test_filter, Module* entry_module, TypeInfo* type_info,
-    AbstractRunComparator* run_comparator, Package* ir_package,
-    std::optional<int64_t> seed, TestResultData& result,
+    AbstractIrFunctionRunner* ir_function_runner, Package* ir_package,
+    std::optional<int64_t> seed, int64_t num_threads, TestResultData& result,
     VirtualizableFilesystem& vfs) {
-  if (run_comparator == nullptr) {
+  if (ir_function_runner == nullptr) {
     // TODO(leary): 2024-02-08 Note that this skips /all/ the quickchecks so we
     // don't make an entry for it right now in the test XML.
     std::cerr << "[ SKIPPING QUICKCHECKS  ] (JIT is disabled)" << "\n";
@@ -453,7 +513,8 @@ static absl::Status RunQuickChecksIfJitEnabled(
     std::cerr << "[ RUN QUICKCHECK        ] " << quickcheck_name
               << " count: " << quickcheck->GetTestCountOrDefault() << "\n";
     const absl::Status status =
-        RunQuickCheck(run_comparator, ir_package, quickcheck, type_info, *seed);
+        RunQuickCheck(ir_function_runner, ir_package, quickcheck, type_info,
+                      *seed, num_threads);
     const absl::Duration duration = absl::Now() - test_case_start;
     if (!status.ok()) {
       HandleError(result, status, quickcheck_name, start_pos, test_case_start,
@@ -702,11 +763,21 @@ absl::StatusOr<TestResultData> AbstractTestRunner::ParseAndTest(
 
   Module* entry_module = tm_or.value().module;
 
-  // If JIT comparisons are "on", we register a post-evaluation hook to compare
-  // with the interpreter.
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<AbstractParsedTestRunner> runner,
+      CreateTestRunner(&import_data, tm_or.value().type_info, entry_module));
+
+  // Quickchecks run on the comparator's IR evaluator if there is one, or else
+  // on the one the tests run on, if any.
+  AbstractIrFunctionRunner* quickcheck_runner =
+      options.run_comparator != nullptr ? options.run_comparator
+                                        : runner->ir_function_runner();
+
+  // The IR is needed both to compare against and to run quickchecks on.
   std::unique_ptr<Package> ir_package;
-  PostFnEvalHook post_fn_eval_hook;
-  if (options.run_comparator != nullptr) {
+  if (options.run_comparator != nullptr ||
+      (quickcheck_runner != nullptr &&
+       !entry_module->GetQuickChecks().empty())) {
     absl::StatusOr<dslx::PackageConversionData> ir_package_or =
         ConvertModuleToPackage(entry_module, &import_data,
                                options.convert_options);
@@ -716,11 +787,21 @@ absl::StatusOr<TestResultData> AbstractTestRunner::ParseAndTest(
         result.Finish(TestResult::kSomeFailed, absl::Now() - start);
         return result;
       }
+      if (options.run_comparator == nullptr) {
+        return xabsl::StatusBuilder(ir_package_or.status())
+               << "Failed to convert input to IR to run quickchecks: ";
+      }
       return xabsl::StatusBuilder(ir_package_or.status())
              << "Failed to convert input to IR for comparison. Consider "
                 "turning off comparison with `--compare=none`: ";
     }
     ir_package = std::move(ir_package_or).value().package;
+  }
+
+  // If JIT comparisons are "on", we register a post-evaluation hook to compare
+  // with the interpreter.
+  PostFnEvalHook post_fn_eval_hook;
+  if (options.run_comparator != nullptr) {
     post_fn_eval_hook = [&ir_package, &import_data, &options](
                             const Function* f,
                             absl::Span<const InterpValue> args,
@@ -738,9 +819,6 @@ absl::StatusOr<TestResultData> AbstractTestRunner::ParseAndTest(
     };
   }
 
-  XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<AbstractParsedTestRunner> runner,
-      CreateTestRunner(&import_data, tm_or.value().type_info, entry_module));
   // Run unit tests.
   for (const std::string& test_name : entry_module->GetTestNames()) {
     auto test_case_start = absl::Now();
@@ -767,6 +845,7 @@ absl::StatusOr<TestResultData> AbstractTestRunner::ParseAndTest(
         .trace_hook(absl::bind_front(InfoLoggingTraceHook, file_table))
         .trace_channels(options.trace_channels)
         .max_ticks(options.max_ticks)
+        .proc_thread_count(options.proc_threads)
         .format_preference(options.format_preference);
     if (std::holds_alternative<TestFunction*>(*member)) {
       XLS_ASSIGN_OR_RETURN(
@@ -801,12 +880,12 @@ absl::StatusOr<TestResultData> AbstractTestRunner::ParseAndTest(
                    result.GetSkippedCount())
             << '\n';
 
-  // Run quickchecks, but only if the JIT is enabled.
+  // Run quickchecks, but only if there is an IR evaluator to run them on.
   if (!entry_module->GetQuickChecks().empty()) {
     XLS_RETURN_IF_ERROR(RunQuickChecksIfJitEnabled(
         options.test_filter, entry_module, tm_or.value().type_info,
-        options.run_comparator, ir_package.get(), options.seed, result,
-        import_data.vfs()));
+        quickcheck_runner, ir_package.get(), options.seed,
+        options.quickcheck_threads, result, import_data.vfs()));
   }
 
   result.Finish(
@@ -52,22 +52,11 @@
 
 namespace xls::dslx {
 
-// Abstract API used for comparing DSLX-interpreter results to executed IR
-// results. This is a virtual API to help decouple from implementation details
-// like whether the JIT is available or only interpretation, or whether we
-// should perhaps compare against both.
-class AbstractRunComparator {
+// Abstract API for running IR functions converted from DSLX, e.g. on the JIT
+// or the IR interpreter.
+class AbstractIrFunctionRunner {
  public:
-  virtual ~AbstractRunComparator() = default;
-
-  // Runs a comparison of the DSLX_interpreter-determined value against the
-  // otherwise-determined value (e.g. IR interpreter or IR JIT).
-  virtual absl::Status RunComparison(Package* ir_package,
-                                     bool requires_implicit_token,
-                                     const Function* f,
-                                     absl::Span<InterpValue const> args,
-                                     const ParametricEnv* parametric_env,
-                                     const InterpValue& got) = 0;
+  virtual ~AbstractIrFunctionRunner() = default;
 
   // Helper for abstracting over the running of IR functions. i.e. we implement
   // this in subclasses to either execute JIT'd computations or interpreted
@@ -80,6 +69,31 @@ class AbstractRunComparator {
   virtual absl::StatusOr<InterpreterResult<xls::Value>> RunIrFunction(
       std::string_view ir_name, xls::Function* ir_function,
       absl::Span<const xls::Value> ir_args) = 0;
+
+  // Returns a runner for `ir_function` which may be used on another thread
+  // concurrently with this runner and any others returned from here, or
+  // nullptr if the function cannot be run concurrently.
+  virtual absl::StatusOr<std::unique_ptr<AbstractIrFunctionRunner>>
+  CreateConcurrentRunner(std::string_view ir_name,
+                         xls::Function* ir_function) {
+    return nullptr;
+  }
+};
+
+// Abstract API used for comparing DSLX-interpreter results to executed IR
+// results. This is a virtual API to help decouple from implementation details
+// like whether the JIT is available or only interpretation, or whether we
+// should perhaps compare against both.
+class AbstractRunComparator : public AbstractIrFunctionRunner {
+ public:
+  // Runs a comparison of the DSLX_interpreter-determined value against the
+  // otherwise-determined value (e.g. IR interpreter or IR JIT).
+  virtual absl::Status RunComparison(Package* ir_package,
+                                     bool requires_implicit_token,
+                                     const Function* f,
+                                     absl::Span<InterpValue const> args,
+                                     const ParametricEnv* parametric_env,
+                                     const InterpValue& got) = 0;
 };
 
 // Optional arguments to ParseAndTest (that have sensible defaults).
@@ -87,7 +101,9 @@ class AbstractRunComparator {
 //   test_filter: Test filter specification (e.g. as passed from bazel test
 //     environment).
 //   run_comparator: Optional object that can compare DSLX interpreter
-//    executions with a reference (e.g. IR execution).
+//    executions with a reference (e.g. IR execution). Quickchecks are run on
+//    it if given, otherwise on the test runner's IR evaluator if it has one,
+//    and are skipped if neither is available.
 //   execute: Whether or not to execute the quickchecks and tests.
 //   seed: Seed for QuickCheck random input stimulus.
 //   convert_options: Options used in IR conversion, see `ConvertOptions` for
@@ -95,6 +111,8 @@ class AbstractRunComparator {
 //   warnings_as_errors: Whether warnings should be reported as errors (i.e.
 //    cause the run routine to report failure when a warning is encountered).
 //   warnings: Set of warnings to enable for reporting.
+//   quickcheck_threads: Number of threads to evaluate quickcheck samples on.
+//   proc_threads: Number of threads to run the procs of a test proc on.
 struct ParseAndTestOptions {
   std::filesystem::path dslx_stdlib_path;
   absl::Span<const std::filesystem::path> dslx_paths;
@@ -108,6 +126,8 @@ struct ParseAndTestOptions {
   WarningKindSet warnings = kDefaultWarningsSet;
   bool trace_channels = false;
   std::optional<int64_t> max_ticks;
+  int64_t quickcheck_threads = 1;
+  int64_t proc_threads = 1;
 };
 
 // As above, but a subset of the options required for the ParseAndProve()
@@ -234,6 +254,11 @@ class AbstractParsedTestRunner {
       std::string_view name, const BytecodeInterpreterOptions& options) = 0;
   virtual absl::StatusOr<RunResult> RunTestFunction(
       std::string_view name, const BytecodeInterpreterOptions& options) = 0;
+
+  // Returns the object this runner executes IR functions with, or nullptr if
+  // it does not execute IR. Quickchecks are run on it when no run comparator
+  // is given, so they need not be executed by the DSLX interpreter as well.
+  virtual AbstractIrFunctionRunner* ir_function_runner() { return nullptr; }
 };
 
 class DslxInterpreterTestRunner final : public AbstractTestRunner {
@@ -281,16 +306,22 @@ struct QuickCheckResults {
   std::vector<Value> results;
 };
 
-// JIT-compiles the given xls_function and invokes it with num_tests randomly
-// generated arguments -- returns `([argset, ...], [results, ...])` (i.e. in
-// structure-of-array style).
+// Invokes the given xls_function on `ir_function_runner` (e.g. the JIT) with
+// num_tests randomly generated arguments -- returns
+// `([argset, ...], [results, ...])` (i.e. in structure-of-array style).
 //
 // xls_function is a predicate we're trying to find evidence to falsify, so if
 // this finds an example that falsifies the predicate, we early-return (i.e. the
 // length of the returned vectors may be < 1000).
+//
+// The samples are drawn in fixed-size shards, each from its own random stream
+// seeded by `seed` and the shard index, and the shards are evaluated on up to
+// `num_threads` threads if the runner supports concurrent runners. The results
+// (including which counterexample is reported) only depend on the seed.
 absl::StatusOr<QuickCheckResults> DoQuickCheck(
     xls::Function* xls_function, std::string_view ir_name,
-    AbstractRunComparator* run_comparator, int64_t seed, int64_t num_tests);
+    AbstractIrFunctionRunner* ir_function_runner, int64_t seed,
+    int64_t num_tests, int64_t num_threads = 1);
 
 }  // namespace xls::dslx
 
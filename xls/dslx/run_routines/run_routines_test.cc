@@ -70,6 +70,7 @@ MATCHER_P4(IsTestResult, result, ran_count, skipped_count, failed_count, "") {
 
 using ::absl_testing::StatusIs;
 using ::testing::HasSubstr;
+using ::testing::Not;
 
 enum class RunnerType : int8_t {
   kDslxInterpreter,
@@ -225,6 +226,46 @@ fn trivial(x: u5) -> bool { false }
   EXPECT_THAT(result, IsTestResult(TestResult::kSomeFailed, 1, 0, 1));
 }
 
+TEST_P(RunRoutinesTest, QuickCheckRunsOnIrEvaluatorWithoutComparator) {
+  constexpr const char* kProgram = R"(
+#[quickcheck(test_count=2)]
+fn trivial(x: u5) -> bool { false }
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto temp_file,
+                           TempFile::CreateWithContent(kProgram, "_test.x"));
+  constexpr const char* kModuleName = "test";
+  ParseAndTestOptions options;
+  options.seed = int64_t{42};
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TestResultData result,
+      ParseAndTest(kProgram, kModuleName, std::string(temp_file.path()),
+                   options));
+  if (GetParam() == RunnerType::kDslxInterpreter) {
+    // Without a comparator there is nothing to run the quickcheck on.
+    EXPECT_THAT(result, IsTestResult(TestResult::kAllPassed, 0, 0, 0));
+  } else {
+    EXPECT_THAT(result, IsTestResult(TestResult::kSomeFailed, 1, 0, 1));
+  }
+}
+
+TEST_P(RunRoutinesTest, FailedAssertionIsReportedAtDslxSpan) {
+  constexpr std::string_view kProgram = R"(
+#[test]
+fn doomed() { assert_eq(u32:1, u32:2) }
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto temp_file,
+                           TempFile::CreateWithContent(kProgram, "_test.x"));
+  ParseAndTestOptions options;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TestResultData result,
+      ParseAndTest(kProgram, "test", std::string(temp_file.path()), options));
+  EXPECT_THAT(result, IsTestResult(TestResult::kSomeFailed, 1, 0, 1));
+  std::vector<std::string> failures = result.failures();
+  ASSERT_EQ(failures.size(), 1);
+  EXPECT_THAT(failures[0], HasSubstr("FailureError"));
+  EXPECT_THAT(failures[0], Not(HasSubstr("internal error")));
+}
+
 TEST_P(RunRoutinesTest, TwoNonParametricProcs) {
   constexpr std::string_view kProgram = R"(
 proc FirstProc {
@@ -415,6 +456,34 @@ TEST(QuickcheckTest, Seeding) {
   EXPECT_EQ(results1, results2);
 }
 
+// The samples drawn (and so the counterexample reported) only depend on the
+// seed, not on how many threads they are evaluated on.
+TEST(QuickcheckTest, ThreadCountDoesNotChangeResults) {
+  Package package("rarely_false");
+  std::string ir_text = R"(
+  fn ne_seven(x: bits[10]) -> bits[1] {
+    literal.2: bits[10] = literal(value=7)
+    ret ne.3: bits[1] = ne(x, literal.2)
+  }
+  )";
+  int64_t seed = 12345;
+  int64_t num_tests = 10000;
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      QuickCheckResults serial,
+      DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests,
+                   /*num_threads=*/1));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      QuickCheckResults parallel,
+      DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests,
+                   /*num_threads=*/4));
+
+  EXPECT_EQ(serial.arg_sets, parallel.arg_sets);
+  EXPECT_EQ(serial.results, parallel.results);
+}
+
 TEST_P(ParseAndTestTest, DeadlockedProc) {
   // Test proc never sends to the subproc, so network is deadlocked.
   constexpr std::string_view kProgram = R"(
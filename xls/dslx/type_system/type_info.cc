@@ -435,6 +435,24 @@ absl::Status TypeInfo::AddInvocationTypeInfo(const Invocation& invocation,
       caller_env, InvocationCalleeData{callee_env, derived_type_info});
 }
 
+void TypeInfo::NoteInstantiationTypeInfo(const Function& f,
+                                         const ParametricEnv& env,
+                                         TypeInfo* derived_type_info) {
+  CHECK_EQ(f.owner(), module_);
+  GetRoot()->instantiations_[{&f, env}] = derived_type_info;
+}
+
+std::optional<TypeInfo*> TypeInfo::GetInstantiationTypeInfo(
+    const Function& f, const ParametricEnv& env) const {
+  CHECK_EQ(f.owner(), module_);
+  const TypeInfo* root = GetRoot();
+  auto it = root->instantiations_.find(std::make_pair(&f, env));
+  if (it == root->instantiations_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
 std::optional<bool> TypeInfo::GetRequiresImplicitToken(
     const Function& f) const {
   CHECK_EQ(f.owner(), module_) << "function owner: " << f.owner()->name()
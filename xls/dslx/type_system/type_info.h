@@ -21,6 +21,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -198,6 +199,18 @@ class TypeInfo {
   absl::StatusOr<TypeInfo*> GetInvocationTypeInfoOrError(
       const Invocation* invocation, const ParametricEnv& caller) const;
 
+  // Notes that `derived_type_info` holds the deduced body of `f` (a function in
+  // this module) instantiated with `env`, so that other invocations anywhere in
+  // the program with the same environment can share it instead of deducing the
+  // body again.
+  void NoteInstantiationTypeInfo(const Function& f, const ParametricEnv& env,
+                                 TypeInfo* derived_type_info);
+
+  // Retrieves the type information noted above for `f` instantiated with
+  // `env`, if any.
+  std::optional<TypeInfo*> GetInstantiationTypeInfo(
+      const Function& f, const ParametricEnv& env) const;
+
   // Sets the type info for the given proc when typechecked at top-level (i.e.,
   // not via an instantiation). Can only be called on the module root TypeInfo.
   absl::Status SetTopLevelProcTypeInfo(const Proc* p, TypeInfo* ti);
@@ -392,6 +405,8 @@ class TypeInfo {
   absl::flat_hash_map<const Invocation*, InvocationData> invocations_;
   absl::flat_hash_map<Slice*, SliceData> slices_;
   absl::flat_hash_map<const Function*, bool> requires_implicit_token_;
+  absl::flat_hash_map<std::pair<const Function*, ParametricEnv>, TypeInfo*>
+      instantiations_;
 
   // Maps a Proc to the TypeInfo used for its top-level typechecking.
   absl::flat_hash_map<const Proc*, TypeInfo*> top_level_proc_type_info_;
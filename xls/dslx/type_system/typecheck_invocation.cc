@@ -422,6 +422,25 @@ absl::StatusOr<TypeAndParametricEnv> TypecheckInvocation(
   parent_ctx->type_info()->SetItem(invocation->callee(), instantiated_ft);
   ctx->type_info()->SetItem(callee_fn.name_def(), instantiated_ft);
 
+  // The body of a function (other than a proc's, which needs its own constexpr
+  // data per instantiation) deduces the same way for the same parametric env
+  // wherever it is invoked from, so an earlier instantiation is shared.
+  const bool shares_instantiations =
+      !callee_fn.proc().has_value() && constexpr_env.empty();
+  if (shares_instantiations) {
+    if (std::optional<TypeInfo*> instantiated =
+            ctx->type_info()->GetInstantiationTypeInfo(
+                callee_fn, callee_tab.parametric_env);
+        instantiated.has_value()) {
+      VLOG(5) << "Sharing instantiation of " << callee_fn.identifier()
+              << " with env " << callee_tab.parametric_env.ToString();
+      XLS_RETURN_IF_ERROR(parent_ctx->type_info()->AddInvocationTypeInfo(
+          *invocation, caller, caller_parametric_env,
+          callee_tab.parametric_env, *instantiated));
+      return callee_tab;
+    }
+  }
+
   // We need to deduce fn body, so we're going to call Deduce, which means we'll
   // need a new stack entry w/the new symbolic bindings.
   TypeInfo* const original_ti = parent_ctx->type_info();
@@ -518,6 +537,10 @@ absl::StatusOr<TypeAndParametricEnv> TypecheckInvocation(
 
   XLS_RETURN_IF_ERROR(ctx->PopDerivedTypeInfo(derived_type_info));
   ctx->PopFnStackEntry();
+  if (shares_instantiations) {
+    ctx->type_info()->NoteInstantiationTypeInfo(
+        callee_fn, callee_tab.parametric_env, derived_type_info);
+  }
 
   // Implementation note: though we could have all functions have
   // NoteRequiresImplicitToken() be false unless otherwise noted, this helps
@@ -12,13 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
@@ -33,6 +37,7 @@
 #include "xls/dslx/frontend/pos.h"
 #include "xls/dslx/import_data.h"
 #include "xls/dslx/parse_and_typecheck.h"
+#include "xls/dslx/type_system/parametric_env.h"
 #include "xls/dslx/type_system/type_info.h"
 #include "xls/dslx/type_system/typecheck_test_utils.h"
 #include "xls/dslx/virtualizable_file_system.h"
@@ -525,6 +530,24 @@ proc Bar {
       ParseAndTypecheck(kProgram, "fake_main_path.x", "main", &import_data));
 }
 
+TEST(TypecheckTest, ImportsParsedAheadOnThreads) {
+  constexpr std::string_view kProgram = R"(
+import float32;
+import std;
+
+fn f(x: float32::F32) -> u32 { std::popcount(float32::flatten(x)) }
+)";
+  auto import_data = CreateImportDataForTest();
+  import_data.set_parse_parallelism(4);
+
+  XLS_EXPECT_OK(
+      ParseAndTypecheck(kProgram, "fake_main_path.x", "main", &import_data));
+  // Everything parsed ahead of time was then imported.
+  EXPECT_FALSE(import_data.HasParsedModule(ImportTokens({"float32"})));
+  EXPECT_FALSE(import_data.HasParsedModule(ImportTokens({"apfloat"})));
+  EXPECT_TRUE(import_data.Contains(ImportTokens({"apfloat"})));
+}
+
 TEST(TypecheckTest, FailsOnProcWithImplAsImportedStructMember) {
   constexpr std::string_view kImported = R"(
 pub proc Foo {
@@ -2416,6 +2439,38 @@ fn main() {
   EXPECT_EQ(visitor.nonconstexpr_numbers_seen(), 0);
 }
 
+// Invocations of a parametric function with the same parametric env share the
+// type information of a single instantiation.
+TEST(TypecheckTest, IdenticalParametricInstantiationsAreShared) {
+  constexpr std::string_view kProgram = R"(
+fn p<N: u32>(x: uN[N]) -> uN[N] { x + uN[N]:1 }
+
+fn f(a: u8, b: u8, c: u16) -> (u8, u8, u16) { (p(a), p(b), p(c)) }
+
+fn g(a: u8) -> u8 { p(a) }
+)";
+  ImportData import_data(CreateImportDataForTest());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypecheckedModule tm,
+      ParseAndTypecheck(kProgram, "fake.x", "fake", &import_data));
+
+  absl::flat_hash_map<int64_t, absl::flat_hash_set<TypeInfo*>> by_width;
+  for (const auto& [invocation, data] : tm.type_info->GetRootInvocations()) {
+    std::optional<TypeInfo*> derived =
+        tm.type_info->GetInvocationTypeInfo(invocation, ParametricEnv());
+    ASSERT_TRUE(derived.has_value());
+    std::optional<const ParametricEnv*> callee_env =
+        tm.type_info->GetInvocationCalleeBindings(invocation, ParametricEnv());
+    ASSERT_TRUE(callee_env.has_value());
+    XLS_ASSERT_OK_AND_ASSIGN(
+        int64_t width, (*callee_env)->ToMap().at("N").GetBitValueViaSign());
+    by_width[width].insert(*derived);
+  }
+  ASSERT_EQ(by_width.size(), 2);
+  EXPECT_EQ(by_width.at(8).size(), 1);
+  EXPECT_EQ(by_width.at(16).size(), 1);
+}
+
 TEST(TypecheckTest, BasicTupleIndex) {
   XLS_EXPECT_OK(Typecheck(R"(
 fn main() -> u18 {
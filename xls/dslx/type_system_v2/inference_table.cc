@@ -14,7 +14,7 @@
 
 #include "xls/dslx/type_system_v2/inference_table.h"
 
-#include <cstddef>
+#include <algorithm>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -86,16 +86,25 @@ absl::StatusOr<InferenceVariableKind> TypeAnnotationToInferenceVariableKind(
                        annotation->ToString()));
 }
 
+// Dense ids which an `InferenceTable` assigns to the nodes and variables it
+// stores data for, in the order they are added, and uses to index that data.
+using NodeId = int64_t;
+using VariableId = int64_t;
+
 // Represents the immutable metadata for a variable in an `InferenceTable`.
 class InferenceVariable {
  public:
-  InferenceVariable(const AstNode* definer, const NameRef* name_ref,
-                    InferenceVariableKind kind, bool parametric)
-      : definer_(definer),
+  InferenceVariable(VariableId id, const AstNode* definer,
+                    const NameRef* name_ref, InferenceVariableKind kind,
+                    bool parametric)
+      : id_(id),
+        definer_(definer),
         name_ref_(name_ref),
         kind_(kind),
         parametric_(parametric) {}
 
+  VariableId id() const { return id_; }
+
   const AstNode* definer() const { return definer_; }
 
   std::string_view name() const { return name_ref_->identifier(); }
@@ -122,6 +131,7 @@ class InferenceVariable {
   }
 
  private:
+  const VariableId id_;
   const AstNode* const definer_;
   const NameRef* const name_ref_;
   const InferenceVariableKind kind_;
@@ -130,9 +140,23 @@ class InferenceVariable {
 
 // The mutable data for a node in an `InferenceTable`.
 struct NodeData {
-  size_t order_added;
+  const AstNode* node;
   std::optional<const TypeAnnotation*> type_annotation;
   std::optional<const InferenceVariable*> type_variable;
+  // Nodes are considered static by default, and they lose their static-ness
+  // when they are determined to depend on a parametric, i.e. their types may
+  // then have more than one concretization.
+  bool is_static = true;
+};
+
+// The data for a variable in an `InferenceTable`.
+struct VariableData {
+  std::unique_ptr<InferenceVariable> variable;
+  // The type annotations that have been associated with a variable of
+  // type-kind.
+  std::vector<const TypeAnnotation*> type_annotations;
+  // The nodes which depend on the variable. May contain duplicates.
+  std::vector<NodeId> dependents;
 };
 
 // The mutable data for a type variable in an `InferenceTable`.
@@ -195,8 +219,7 @@ class InferenceTableImpl : public InferenceTable {
         module_.Make<NameDef>(span, std::string(name), definer);
     const NameRef* name_ref =
         module_.Make<NameRef>(span, std::string(name), name_def);
-    AddVariable(name_def, std::make_unique<InferenceVariable>(
-                              definer, name_ref, kind, /*parametric=*/false));
+    AddVariable(name_def, definer, name_ref, kind, /*parametric=*/false);
     return name_ref;
   }
 
@@ -208,8 +231,7 @@ class InferenceTableImpl : public InferenceTable {
     const NameDef* name_def = binding.name_def();
     const NameRef* name_ref = module_.Make<NameRef>(
         name_def->span(), name_def->identifier(), name_def);
-    AddVariable(name_def, std::make_unique<InferenceVariable>(
-                              name_def, name_ref, kind, /*parametric=*/true));
+    AddVariable(name_def, name_def, name_ref, kind, /*parametric=*/true);
     XLS_RETURN_IF_ERROR(SetTypeAnnotation(name_def, binding.type_annotation()));
     return name_ref;
   }
@@ -235,11 +257,11 @@ class InferenceTableImpl : public InferenceTable {
               callee.parametric_bindings().size(), explicit_parametrics.size()),
           file_table_);
     }
-    absl::flat_hash_map<const InferenceVariable*, InvocationScopedExpr> values;
+    // The values of the callee's parametrics, in the order of its bindings.
+    std::vector<InvocationScopedExpr> values;
+    values.reserve(bindings.size());
     for (int i = 0; i < bindings.size(); i++) {
       const ParametricBinding* binding = bindings[i];
-      const InferenceVariable* variable =
-          variables_.at(binding->name_def()).get();
       if (i < explicit_parametrics.size()) {
         const ExprOrType value = explicit_parametrics[i];
         if (!std::holds_alternative<Expr*>(value)) {
@@ -248,25 +270,22 @@ class InferenceTableImpl : public InferenceTable {
               "support types as parametric values: $0",
               node.ToString()));
         }
-        values.emplace(
-            variable,
-            InvocationScopedExpr(caller_invocation, binding->type_annotation(),
-                                 std::get<Expr*>(value)));
+        values.push_back(InvocationScopedExpr(caller_invocation,
+                                              binding->type_annotation(),
+                                              std::get<Expr*>(value)));
       } else if (binding->expr() == nullptr) {
         return absl::UnimplementedError(absl::StrCat(
             "Type inference version 2 is a work in progress and doesn't yet "
             "support inferring parametrics from function arguments: ",
             invocation->ToString()));
       } else {
-        values.emplace(
-            variable,
-            InvocationScopedExpr(invocation.get(), binding->type_annotation(),
-                                 binding->expr()));
+        values.push_back(InvocationScopedExpr(
+            invocation.get(), binding->type_annotation(), binding->expr()));
       }
     }
     const ParametricInvocation* result = invocation.get();
     parametric_invocations_.push_back(std::move(invocation));
-    parametric_values_by_invocation_.emplace(result, std::move(values));
+    parametric_values_by_invocation_.push_back(std::move(values));
     return result;
   }
 
@@ -283,8 +302,14 @@ class InferenceTableImpl : public InferenceTable {
   InvocationScopedExpr GetParametricValue(
       const NameDef& binding_name_def,
       const ParametricInvocation& invocation) const override {
-    const InferenceVariable* variable = variables_.at(&binding_name_def).get();
-    return parametric_values_by_invocation_.at(&invocation).at(variable);
+    const std::vector<ParametricBinding*>& bindings =
+        invocation.callee().parametric_bindings();
+    const auto it = absl::c_find_if(bindings, [&](const ParametricBinding* b) {
+      return b->name_def() == &binding_name_def;
+    });
+    CHECK(it != bindings.end());
+    return parametric_values_by_invocation_.at(invocation.id())
+        .at(it - bindings.begin());
   }
 
   absl::Status SetTypeAnnotation(const AstNode* node,
@@ -306,7 +331,13 @@ class InferenceTableImpl : public InferenceTable {
   }
 
   std::vector<const AstNode*> GetStaticNodes() const override {
-    return ConvertNodeSetToOrderedVector(static_nodes_);
+    std::vector<const AstNode*> result;
+    for (const NodeData& data : node_data_) {
+      if (data.is_static) {
+        result.push_back(data.node);
+      }
+    }
+    return result;
   }
 
   // Returns all the nodes that have information in the table and whose types
@@ -314,36 +345,41 @@ class InferenceTableImpl : public InferenceTable {
   // nodes are returned in the order added to the table.
   std::vector<const AstNode*> GetNodesWithInvocationSpecificTypes(
       const ParametricInvocation* invocation) const override {
-    absl::flat_hash_set<const AstNode*> dependents;
+    std::vector<NodeId> dependents;
     for (const ParametricBinding* binding :
          invocation->callee().parametric_bindings()) {
-      const InferenceVariable* variable =
-          variables_.at(binding->name_def()).get();
-      const auto it = variable_dependents_.find(variable);
-      if (it != variable_dependents_.end()) {
-        absl::c_copy(it->second, std::inserter(dependents, dependents.end()));
-      }
+      const VariableData& data =
+          variables_[variable_ids_.at(binding->name_def())];
+      absl::c_copy(data.dependents, std::back_inserter(dependents));
     }
-    return ConvertNodeSetToOrderedVector(dependents);
+    absl::c_sort(dependents);
+    dependents.erase(std::unique(dependents.begin(), dependents.end()),
+                     dependents.end());
+    std::vector<const AstNode*> result;
+    result.reserve(dependents.size());
+    for (NodeId id : dependents) {
+      result.push_back(node_data_[id].node);
+    }
+    return result;
   }
 
   std::optional<const TypeAnnotation*> GetTypeAnnotation(
       const AstNode* node) const override {
-    const auto it = node_data_.find(node);
-    if (it == node_data_.end()) {
+    const auto it = node_ids_.find(node);
+    if (it == node_ids_.end()) {
       return std::nullopt;
     }
-    return it->second.type_annotation;
+    return node_data_[it->second].type_annotation;
   }
 
   std::optional<const NameRef*> GetTypeVariable(
       const AstNode* node) const override {
-    const auto it = node_data_.find(node);
-    if (it == node_data_.end()) {
+    const auto it = node_ids_.find(node);
+    if (it == node_ids_.end()) {
       return std::nullopt;
     }
     const std::optional<const InferenceVariable*>& variable =
-        it->second.type_variable;
+        node_data_[it->second].type_variable;
     return variable.has_value() ? std::make_optional((*variable)->name_ref())
                                 : std::nullopt;
   }
@@ -351,24 +387,27 @@ class InferenceTableImpl : public InferenceTable {
   absl::StatusOr<std::vector<const TypeAnnotation*>>
   GetTypeAnnotationsForTypeVariable(const NameRef* ref) const override {
     XLS_ASSIGN_OR_RETURN(const InferenceVariable* variable, GetVariable(ref));
-    const auto it = type_annotations_per_type_variable_.find(variable);
-    return it == type_annotations_per_type_variable_.end()
-               ? std::vector<const TypeAnnotation*>()
-               : it->second;
+    return variables_[variable->id()].type_annotations;
   }
 
  private:
-  void AddVariable(const NameDef* name_def,
-                   std::unique_ptr<InferenceVariable> variable) {
-    variables_.emplace(name_def, std::move(variable));
+  void AddVariable(const NameDef* name_def, const AstNode* definer,
+                   const NameRef* name_ref, InferenceVariableKind kind,
+                   bool parametric) {
+    VariableId id = variables_.size();
+    if (variable_ids_.emplace(name_def, id).second) {
+      variables_.push_back(VariableData{
+          .variable = std::make_unique<InferenceVariable>(id, definer, name_ref,
+                                                          kind, parametric)});
+    }
   }
 
   absl::StatusOr<InferenceVariable*> GetVariable(const NameRef* ref) const {
     if (std::holds_alternative<const NameDef*>(ref->name_def())) {
       const auto it =
-          variables_.find(std::get<const NameDef*>(ref->name_def()));
-      if (it != variables_.end()) {
-        return it->second.get();
+          variable_ids_.find(std::get<const NameDef*>(ref->name_def()));
+      if (it != variable_ids_.end()) {
+        return variables_[it->second].variable.get();
       }
     }
     return absl::NotFoundError(absl::Substitute(
@@ -381,54 +420,45 @@ class InferenceTableImpl : public InferenceTable {
   // conflicting information.
   absl::Status MutateAndCheckNodeData(
       const AstNode* node, absl::AnyInvocable<void(NodeData&)> mutator) {
-    const auto [it, inserted] = node_data_.emplace(node, NodeData{});
-    NodeData& node_data = it->second;
+    const auto [it, inserted] = node_ids_.emplace(node, node_data_.size());
     if (inserted) {
-      node_data.order_added = node_data_.size();
-      static_nodes_.insert(node);
+      node_data_.push_back(NodeData{.node = node});
     }
+    const NodeId id = it->second;
+    NodeData& node_data = node_data_[id];
     bool had_type_annotation_before = node_data.type_annotation.has_value();
     mutator(node_data);
     // Refine and check the associated type variable.
     if (node_data.type_variable.has_value() &&
         node_data.type_annotation.has_value()) {
-      type_annotations_per_type_variable_[*node_data.type_variable].push_back(
+      variables_[(*node_data.type_variable)->id()].type_annotations.push_back(
           *node_data.type_annotation);
     }
     // Update the dependencies of the node.
     if (node_data.type_variable.has_value()) {
-      AddDependency(node, *node_data.type_variable);
+      AddDependency(id, *node_data.type_variable);
     }
     if (!had_type_annotation_before && node_data.type_annotation.has_value()) {
       XLS_ASSIGN_OR_RETURN(
           absl::flat_hash_set<const InferenceVariable*> referenced_variables,
           GetReferencedVariables(*node_data.type_annotation));
       for (const InferenceVariable* variable : referenced_variables) {
-        AddDependency(node, variable);
+        AddDependency(id, variable);
       }
     }
     return absl::OkStatus();
   }
 
-  void AddDependency(const AstNode* node, const InferenceVariable* variable) {
-    variable_dependents_[variable].insert(node);
+  void AddDependency(NodeId node, const InferenceVariable* variable) {
+    std::vector<NodeId>& dependents = variables_[variable->id()].dependents;
+    if (dependents.empty() || dependents.back() != node) {
+      dependents.push_back(node);
+    }
     if (variable->parametric()) {
-      // Nodes are considered static by default, and they lose their static-ness
-      // when they are determined to depend on a parametric.
-      static_nodes_.erase(node);
+      node_data_[node].is_static = false;
     }
   }
 
-  std::vector<const AstNode*> ConvertNodeSetToOrderedVector(
-      const absl::flat_hash_set<const AstNode*>& nodes) const {
-    std::vector<const AstNode*> result;
-    absl::c_copy(nodes, std::back_inserter(result));
-    absl::c_sort(result, [this](const AstNode* x, const AstNode* y) {
-      return node_data_.at(x).order_added < node_data_.at(y).order_added;
-    });
-    return result;
-  }
-
   absl::StatusOr<absl::flat_hash_set<const InferenceVariable*>>
   GetReferencedVariables(const AstNode* node) {
     InferenceVariableDiscoveryVisitor visitor(
@@ -440,29 +470,19 @@ class InferenceTableImpl : public InferenceTable {
   Module& module_;
   const FileTable& file_table_;
   // The variables of all kinds that have been defined by the user or
-  // internally.
-  absl::flat_hash_map<const NameDef*, std::unique_ptr<InferenceVariable>>
-      variables_;
-  // The type annotations that have been associated with each inference
-  // variable of type-kind.
-  absl::flat_hash_map<const InferenceVariable*,
-                      std::vector<const TypeAnnotation*>>
-      type_annotations_per_type_variable_;
-  // The `AstNode` objects that have associated data.
-  absl::flat_hash_map<const AstNode*, NodeData> node_data_;
-  // Which `AstNode` objects depend on which variables.
-  absl::flat_hash_map<const InferenceVariable*,
-                      absl::flat_hash_set<const AstNode*>>
-      variable_dependents_;
-  // These nodes don't depend on any parametric variables, so their associated
-  // types have a single concretization.
-  absl::flat_hash_set<const AstNode*> static_nodes_;
-  // Parametric invocations and the corresponding information about parametric
-  // variables.
+  // internally, indexed by id, and the id of the variable for each `NameDef`.
+  std::vector<VariableData> variables_;
+  absl::flat_hash_map<const NameDef*, VariableId> variable_ids_;
+  // The `AstNode` objects that have associated data, indexed by id, and the id
+  // of each. Ids are dealt out in the order nodes are added, so iterating
+  // `node_data_` visits the nodes in that order.
+  std::vector<NodeData> node_data_;
+  absl::flat_hash_map<const AstNode*, NodeId> node_ids_;
+  // Parametric invocations and the values of the callee's parametrics for
+  // each, in the order of the callee's bindings. Both are indexed by the id of
+  // the invocation.
   std::vector<std::unique_ptr<ParametricInvocation>> parametric_invocations_;
-  absl::flat_hash_map<
-      const ParametricInvocation*,
-      absl::flat_hash_map<const InferenceVariable*, InvocationScopedExpr>>
+  std::vector<std::vector<InvocationScopedExpr>>
       parametric_values_by_invocation_;
 };
 
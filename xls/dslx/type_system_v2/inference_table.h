@@ -49,6 +49,9 @@ class ParametricInvocation {
         caller_(caller),
         caller_invocation_(caller_invocation) {}
 
+  // The index of the invocation among those in its table, in the order they
+  // were added.
+  uint64_t id() const { return id_; }
   const Invocation& node() const { return node_; }
   const Function& callee() const { return callee_; }
   const Function& caller() const { return caller_; }
@@ -74,7 +77,7 @@ class ParametricInvocation {
   }
 
  private:
-  const uint64_t id_;  // Just for logging.
+  const uint64_t id_;
   const Invocation& node_;
   const Function& callee_;
   const Function& caller_;
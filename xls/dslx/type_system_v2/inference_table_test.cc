@@ -259,6 +259,57 @@ TEST_F(InferenceTableTest, ParametricVariable) {
               HasSubstr("node: `a: uN[N]`, type: uN[5]"));
 }
 
+TEST_F(InferenceTableTest, IdenticalInstantiationsShareTypeInfo) {
+  ParseAndInitModuleAndTable(R"(
+    fn foo<N: u32>(a: uN[N]) -> uN[N] { a }
+    fn bar() {
+      foo<u32:4>(u4:1);
+      foo<u32:5>(u5:3);
+      foo<u32:4>(u4:2);
+    }
+)");
+
+  XLS_ASSERT_OK_AND_ASSIGN(const Function* foo,
+                           module_->GetMemberOrError<Function>("foo"));
+  XLS_ASSERT_OK(
+      table_->DefineParametricVariable(*foo->parametric_bindings()[0]));
+  for (const Param* param : foo->params()) {
+    XLS_ASSERT_OK(table_->SetTypeAnnotation(param, param->type_annotation()));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(const Function* bar,
+                           module_->GetMemberOrError<Function>("bar"));
+  ASSERT_EQ(bar->body()->statements().size(), 3);
+  std::vector<const Invocation*> invocations;
+  for (const Statement* statement : bar->body()->statements()) {
+    invocations.push_back(
+        down_cast<const Invocation*>(ToAstNode(statement->wrapped())));
+    XLS_ASSERT_OK(
+        table_->AddParametricInvocation(*invocations.back(), *foo, *bar,
+                                        /*caller_invocation=*/std::nullopt));
+  }
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TypeInfo * ti,
+      InferenceTableToTypeInfo(*table_, *module_, *import_data_,
+                               *warning_collector_, file_table_,
+                               /*max_threads=*/4));
+  std::vector<TypeInfo*> invocation_tis;
+  for (const Invocation* invocation : invocations) {
+    std::optional<TypeInfo*> invocation_ti =
+        ti->GetInvocationTypeInfo(invocation, ParametricEnv());
+    ASSERT_TRUE(invocation_ti.has_value());
+    invocation_tis.push_back(*invocation_ti);
+  }
+  EXPECT_EQ(invocation_tis[0], invocation_tis[2]);
+  EXPECT_NE(invocation_tis[0], invocation_tis[1]);
+  XLS_ASSERT_OK_AND_ASSIGN(std::string ti4_string,
+                           TypeInfoToString(*invocation_tis[0]));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string ti5_string,
+                           TypeInfoToString(*invocation_tis[1]));
+  EXPECT_THAT(ti4_string, HasSubstr("node: `a: uN[N]`, type: uN[4]"));
+  EXPECT_THAT(ti5_string, HasSubstr("node: `a: uN[N]`, type: uN[5]"));
+}
+
 TEST_F(InferenceTableTest, ParametricVariableForSignedness) {
   ParseAndInitModuleAndTable(R"(
     fn foo<S: bool, N: u32>(a: xN[S][N]) -> xN[S][N] { a }
@@ -15,10 +15,12 @@
 #include "xls/dslx/type_system_v2/inference_table_to_type_info.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -28,7 +30,10 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/constexpr_evaluator.h"
 #include "xls/dslx/errors.h"
 #include "xls/dslx/frontend/ast.h"
@@ -61,9 +66,12 @@ class InferenceTableConverter {
         base_type_info_(base_type_info),
         file_table_(file_table) {}
 
-  // Generates the resulting type info for the given invocation, as a child of
-  // the base type info.
-  absl::Status AddInvocationAndGenerateTypeInfo(
+  // Adds the type info for the given invocation to the base type info. Returns
+  // whether the invocation is the first instantiation of its callee with its
+  // parametric values, in which case its type info is a new child of the base
+  // type info which GenerateTypeInfo must then fill in. Otherwise it shares the
+  // type info of the earlier identical instantiation.
+  absl::StatusOr<bool> AddInvocation(
       const ParametricInvocation* parametric_invocation) {
     ParametricEnv caller_env;
     if (parametric_invocation->caller_invocation().has_value()) {
@@ -77,13 +85,53 @@ class InferenceTableConverter {
     invocation_type_info_.emplace(parametric_invocation, invocation_type_info);
     XLS_ASSIGN_OR_RETURN(ParametricEnv callee_env,
                          ParametricInvocationToEnv(parametric_invocation));
-    XLS_RETURN_IF_ERROR(GenerateTypeInfo(parametric_invocation));
+    const auto [it, inserted] = instantiations_.emplace(
+        std::make_pair(&parametric_invocation->callee(), callee_env),
+        invocation_type_info);
+    if (!inserted) {
+      // The type info noted so far for this invocation only holds the values
+      // of the callee's parametrics, which are the same in the shared one.
+      invocation_type_info_[parametric_invocation] = it->second;
+    }
     VLOG(5) << "Adding invocation type info for "
             << parametric_invocation->callee().ToString()
-            << " with caller env: " << caller_env.ToString();
-    return base_type_info_->AddInvocationTypeInfo(
+            << " with caller env: " << caller_env.ToString()
+            << (inserted ? "" : " (shared)");
+    XLS_RETURN_IF_ERROR(base_type_info_->AddInvocationTypeInfo(
         parametric_invocation->node(), &parametric_invocation->caller(),
-        caller_env, callee_env, invocation_type_info);
+        caller_env, callee_env, it->second));
+    return inserted;
+  }
+
+  // Runs GenerateTypeInfo for each of the given invocations, which must be
+  // distinct instantiations, on up to `max_threads` threads. Returns the first
+  // error in the order of `invocations`.
+  absl::Status GenerateTypeInfos(
+      absl::Span<const ParametricInvocation* const> invocations,
+      int64_t max_threads) {
+    std::vector<absl::Status> statuses(invocations.size());
+    std::atomic<int64_t> next_index = 0;
+    auto worker = [&]() {
+      for (int64_t i = next_index++; i < invocations.size();
+           i = next_index++) {
+        statuses[i] = GenerateTypeInfo(invocations[i]);
+      }
+    };
+    {
+      std::vector<std::unique_ptr<Thread>> threads;
+      int64_t thread_count =
+          std::min<int64_t>(max_threads, invocations.size());
+      for (int64_t i = 0; i < thread_count; ++i) {
+        threads.push_back(std::make_unique<Thread>(worker));
+      }
+      for (std::unique_ptr<Thread>& thread : threads) {
+        thread->Join();
+      }
+    }
+    for (const absl::Status& status : statuses) {
+      XLS_RETURN_IF_ERROR(status);
+    }
+    return absl::OkStatus();
   }
 
   // Generates type info for either a particular parametric invocation (storing
@@ -197,6 +245,7 @@ class InferenceTableConverter {
     // Note: the `ParametricEnv` is irrelevant here, because we have guaranteed
     // that any parametric that may be referenced by the expr has been noted as
     // a normal constexpr in `type_info`.
+    absl::MutexLock lock(&shared_state_mutex_);
     return ConstexprEvaluator::EvaluateToValue(
         &import_data_, type_info, &warning_collector_, ParametricEnv(),
         scoped_expr.expr(), /*type=*/nullptr);
@@ -235,11 +284,14 @@ class InferenceTableConverter {
       return std::get<bool>(value_or_expr);
     }
     const Expr* expr = std::get<const Expr*>(value_or_expr);
-    XLS_ASSIGN_OR_RETURN(
-        InterpValue value,
-        Evaluate(InvocationScopedExpr(
-            parametric_invocation, CreateBoolAnnotation(module_, expr->span()),
-            expr)));
+    TypeAnnotation* annotation;
+    {
+      absl::MutexLock lock(&shared_state_mutex_);
+      annotation = CreateBoolAnnotation(module_, expr->span());
+    }
+    XLS_ASSIGN_OR_RETURN(InterpValue value,
+                         Evaluate(InvocationScopedExpr(parametric_invocation,
+                                                       annotation, expr)));
     return value.GetBitValueUnsigned();
   }
 
@@ -253,6 +305,7 @@ class InferenceTableConverter {
     std::optional<const TypeAnnotation*> type_annotation =
         table_.GetTypeAnnotation(expr);
     if (!type_annotation.has_value()) {
+      absl::MutexLock lock(&shared_state_mutex_);
       type_annotation = CreateS64Annotation(module_, expr->span());
     }
     XLS_ASSIGN_OR_RETURN(InterpValue value,
@@ -299,18 +352,27 @@ class InferenceTableConverter {
           unified_bit_count.has_value() ? *unified_bit_count : 0, bit_count);
       unified_signedness = signedness;
     }
+    absl::MutexLock lock(&shared_state_mutex_);
     return CreateUnOrSnAnnotation(module_, span, *unified_signedness,
                                   *unified_bit_count);
   }
 
   const InferenceTable& table_;
+  // Instantiations generated concurrently by GenerateTypeInfos each write only
+  // their own type info, but share the following, which are then only used
+  // under `shared_state_mutex_`.
   Module& module_;
   ImportData& import_data_;
   WarningCollector& warning_collector_;
+  absl::Mutex shared_state_mutex_;
   TypeInfo* const base_type_info_;
   const FileTable& file_table_;
   absl::flat_hash_map<const ParametricInvocation*, TypeInfo*>
       invocation_type_info_;
+  // The type info of each distinct instantiation, i.e. callee and values of its
+  // parametrics, shared by all invocations resulting in it.
+  absl::flat_hash_map<std::pair<const Function*, ParametricEnv>, TypeInfo*>
+      instantiations_;
   absl::flat_hash_map<const ParametricInvocation*, ParametricEnv>
       converted_parametric_envs_;
 };
@@ -319,7 +381,8 @@ class InferenceTableConverter {
 
 absl::StatusOr<TypeInfo*> InferenceTableToTypeInfo(
     const InferenceTable& table, Module& module, ImportData& import_data,
-    WarningCollector& warning_collector, const FileTable& file_table) {
+    WarningCollector& warning_collector, const FileTable& file_table,
+    int64_t max_threads) {
   XLS_ASSIGN_OR_RETURN(TypeInfo * base_type_info,
                        import_data.type_info_owner().New(&module));
   InferenceTableConverter converter(table, module, import_data,
@@ -327,10 +390,21 @@ absl::StatusOr<TypeInfo*> InferenceTableToTypeInfo(
                                     file_table);
   XLS_RETURN_IF_ERROR(converter.GenerateTypeInfo(
       /*parametric_invocation=*/std::nullopt));
+  std::vector<const ParametricInvocation*> instantiations;
   for (const ParametricInvocation* invocation :
        table.GetParametricInvocations()) {
-    XLS_RETURN_IF_ERROR(converter.AddInvocationAndGenerateTypeInfo(invocation));
+    XLS_ASSIGN_OR_RETURN(bool new_instantiation,
+                         converter.AddInvocation(invocation));
+    if (!new_instantiation) {
+      continue;
+    }
+    if (max_threads > 1) {
+      instantiations.push_back(invocation);
+    } else {
+      XLS_RETURN_IF_ERROR(converter.GenerateTypeInfo(invocation));
+    }
   }
+  XLS_RETURN_IF_ERROR(converter.GenerateTypeInfos(instantiations, max_threads));
   return converter.GetBaseTypeInfo();
 }
 
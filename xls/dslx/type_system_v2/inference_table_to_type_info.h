@@ -15,6 +15,8 @@
 #ifndef XLS_DSLX_TYPE_SYSTEM_V2_INFERENCE_TABLE_TO_TYPE_INFO_H_
 #define XLS_DSLX_TYPE_SYSTEM_V2_INFERENCE_TABLE_TO_TYPE_INFO_H_
 
+#include <cstdint>
+
 #include "absl/status/statusor.h"
 #include "xls/dslx/frontend/ast.h"
 #include "xls/dslx/frontend/module.h"
@@ -29,9 +31,15 @@ namespace xls::dslx {
 // Converts the given `InferenceTable` into a `TypeInfo`, by concretizing the
 // types associated with all nodes in the table. This is the final step of type
 // inference.
+//
+// Invocations of a parametric function with the same parametric values share
+// one derived type info. If `max_threads` is greater than one, the derived type
+// infos of the distinct instantiations are generated concurrently, once the
+// parametric values of all invocations are known.
 absl::StatusOr<TypeInfo*> InferenceTableToTypeInfo(
     const InferenceTable& table, Module& module, ImportData& import_data,
-    WarningCollector& warning_collector, const FileTable& file_table);
+    WarningCollector& warning_collector, const FileTable& file_table,
+    int64_t max_threads = 1);
 
 }  // namespace xls::dslx
 
@@ -36,4 +36,22 @@ absl::StatusOr<std::filesystem::path> RealFilesystem::GetCurrentDirectory() {
   return xls::GetCurrentDirectory();
 }
 
+absl::Status RecordingFilesystem::FileExists(
+    const std::filesystem::path& path) {
+  absl::Status status = filesystem_->FileExists(path);
+  (*observed_)[path.string()].exists = status.ok();
+  return status;
+}
+
+absl::StatusOr<std::string> RecordingFilesystem::GetFileContents(
+    const std::filesystem::path& path) {
+  absl::StatusOr<std::string> contents = filesystem_->GetFileContents(path);
+  ObservedFile& observed = (*observed_)[path.string()];
+  observed.exists = contents.ok();
+  if (contents.ok()) {
+    observed.contents = *contents;
+  }
+  return contents;
+}
+
 }  // namespace xls::dslx
@@ -16,10 +16,13 @@
 #define XLS_DSLX_VIRTUALIZABLE_FILE_SYSTEM_H_
 
 #include <filesystem>  // NOLINT
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 
+#include "absl/container/btree_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
@@ -56,6 +59,35 @@ class RealFilesystem : public VirtualizableFilesystem {
   absl::StatusOr<std::filesystem::path> GetCurrentDirectory() override;
 };
 
+// What a RecordingFilesystem observed about a path.
+struct ObservedFile {
+  bool exists = false;
+  // The contents of the file, if they were read.
+  std::optional<std::string> contents;
+};
+
+// Forwards to another filesystem and records every path it is asked about, so
+// callers can later check whether a result computed from those files is still
+// up to date.
+class RecordingFilesystem : public VirtualizableFilesystem {
+ public:
+  RecordingFilesystem(std::unique_ptr<VirtualizableFilesystem> filesystem,
+                      absl::btree_map<std::string, ObservedFile>* observed)
+      : filesystem_(std::move(filesystem)), observed_(observed) {}
+
+  ~RecordingFilesystem() override = default;
+  absl::Status FileExists(const std::filesystem::path& path) override;
+  absl::StatusOr<std::string> GetFileContents(
+      const std::filesystem::path& path) override;
+  absl::StatusOr<std::filesystem::path> GetCurrentDirectory() override {
+    return filesystem_->GetCurrentDirectory();
+  }
+
+ private:
+  std::unique_ptr<VirtualizableFilesystem> filesystem_;
+  absl::btree_map<std::string, ObservedFile>* observed_;
+};
+
 // A fake filesystem that gives back the same file content for all requested
 // paths, useful in testing.
 //
@@ -0,0 +1,220 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/estimators/area_model/area_breakdown.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/estimators/area_model/area_breakdown.pb.h"
+#include "xls/estimators/area_model/area_estimator.h"
+#include "xls/estimators/delay_model/delay_estimator.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/register.h"
+
+namespace xls {
+
+SignatureCachingAreaEstimator::SignatureCachingAreaEstimator(
+    const AreaEstimator& cached)
+    : AreaEstimator(cached.name()), cached_(cached) {}
+
+absl::StatusOr<double>
+SignatureCachingAreaEstimator::GetOperationAreaInSquareMicrons(
+    Node* node) const {
+  std::optional<std::string> signature =
+      SignatureCachingDelayEstimator::GetSignature(node);
+  if (!signature.has_value()) {
+    return cached_.GetOperationAreaInSquareMicrons(node);
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = cache_.find(*signature);
+    if (it != cache_.end()) {
+      return it->second;
+    }
+  }
+  absl::StatusOr<double> area = cached_.GetOperationAreaInSquareMicrons(node);
+  absl::MutexLock lock(&mutex_);
+  cache_.emplace(*std::move(signature), area);
+  return area;
+}
+
+int64_t SignatureCachingAreaEstimator::size() const {
+  absl::MutexLock lock(&mutex_);
+  return cache_.size();
+}
+
+absl::StatusOr<double>
+SignatureCachingAreaEstimator::GetOneBitRegisterAreaInSquareMicrons() const {
+  return cached_.GetRegisterAreaInSquareMicrons(1);
+}
+
+namespace {
+
+struct OpTally {
+  int64_t count = 0;
+  double area = 0.0;
+  int64_t unestimated_count = 0;
+};
+
+// Tallies keyed by op name so they are emitted in a deterministic order.
+using OpTallies = absl::btree_map<std::string, OpTally>;
+
+struct StageTally {
+  OpTallies ops;
+  int64_t register_bits = 0;
+};
+
+void Tally(Node* node, const absl::StatusOr<double>& area, OpTallies& ops) {
+  OpTally& tally = ops[OpToString(node->op())];
+  ++tally.count;
+  if (area.ok()) {
+    tally.area += *area;
+  } else {
+    ++tally.unestimated_count;
+  }
+}
+
+double AppendOps(const OpTallies& ops,
+                 absl::FunctionRef<OpAreaProto*()> add_op) {
+  double total = 0.0;
+  for (const auto& [op, tally] : ops) {
+    OpAreaProto* proto = add_op();
+    proto->set_op(op);
+    proto->set_count(tally.count);
+    proto->set_area_um2(tally.area);
+    proto->set_unestimated_count(tally.unestimated_count);
+    total += tally.area;
+  }
+  return total;
+}
+
+double RegisterArea(const AreaEstimator& estimator, int64_t bits) {
+  if (bits == 0) {
+    return 0.0;
+  }
+  return estimator.GetRegisterAreaInSquareMicrons(bits).value_or(0.0);
+}
+
+absl::StatusOr<FunctionBaseAreaProto> EstimateFunctionBaseArea(
+    FunctionBase* function_base, const AreaEstimator& estimator,
+    const absl::flat_hash_map<Node*, int64_t>& node_stages,
+    OpTallies& package_ops) {
+  bool scheduled = absl::c_any_of(function_base->nodes(), [&](Node* node) {
+    return node_stages.contains(node);
+  });
+  OpTallies ops;
+  absl::btree_map<int64_t, StageTally> stages;
+  for (Node* node : function_base->nodes()) {
+    absl::StatusOr<double> area =
+        estimator.GetOperationAreaInSquareMicrons(node);
+    Tally(node, area, ops);
+    Tally(node, area, package_ops);
+    if (!scheduled) {
+      continue;
+    }
+    auto it = node_stages.find(node);
+    XLS_RET_CHECK(it != node_stages.end())
+        << "Node " << node->GetName() << " of scheduled function base "
+        << function_base->name() << " has no stage";
+    int64_t stage = it->second;
+    StageTally& stage_tally = stages[stage];
+    Tally(node, area, stage_tally.ops);
+    // The value is held in a pipeline register at every stage boundary
+    // between its definition and its last use.
+    int64_t last_use = stage;
+    for (Node* user : node->users()) {
+      auto user_it = node_stages.find(user);
+      XLS_RET_CHECK(user_it != node_stages.end())
+          << "Node " << user->GetName() << " of scheduled function base "
+          << function_base->name() << " has no stage";
+      last_use = std::max(last_use, user_it->second);
+    }
+    stage_tally.register_bits +=
+        node->GetType()->GetFlatBitCount() * (last_use - stage);
+  }
+
+  FunctionBaseAreaProto proto;
+  proto.set_name(function_base->name());
+  proto.set_logic_area_um2(AppendOps(ops, [&] { return proto.add_ops(); }));
+  double register_area = 0.0;
+  for (const auto& [stage, tally] : stages) {
+    StageAreaProto* stage_proto = proto.add_stages();
+    stage_proto->set_stage(stage);
+    stage_proto->set_logic_area_um2(
+        AppendOps(tally.ops, [&] { return stage_proto->add_ops(); }));
+    stage_proto->set_register_bits(tally.register_bits);
+    stage_proto->set_register_area_um2(
+        RegisterArea(estimator, tally.register_bits));
+    register_area += stage_proto->register_area_um2();
+  }
+  if (function_base->IsBlock()) {
+    int64_t register_bits = 0;
+    for (Register* reg : function_base->AsBlockOrDie()->GetRegisters()) {
+      register_bits += reg->type()->GetFlatBitCount();
+    }
+    register_area += RegisterArea(estimator, register_bits);
+  }
+  proto.set_register_area_um2(register_area);
+  return proto;
+}
+
+}  // namespace
+
+absl::StatusOr<PackageAreaProto> EstimatePackageArea(
+    Package* package, const AreaEstimator& estimator,
+    const absl::flat_hash_map<Node*, int64_t>& node_stages) {
+  // Estimate each distinct signature once unless the caller already shares a
+  // cache between calls.
+  std::optional<SignatureCachingAreaEstimator> local_cache;
+  const AreaEstimator* caching_estimator = &estimator;
+  if (dynamic_cast<const SignatureCachingAreaEstimator*>(&estimator) ==
+      nullptr) {
+    caching_estimator = &local_cache.emplace(estimator);
+  }
+
+  PackageAreaProto proto;
+  proto.set_area_model(estimator.name());
+  OpTallies package_ops;
+  double total_area = 0.0;
+  for (FunctionBase* function_base : package->GetFunctionBases()) {
+    XLS_ASSIGN_OR_RETURN(
+        FunctionBaseAreaProto function_base_area,
+        EstimateFunctionBaseArea(function_base, *caching_estimator,
+                                 node_stages, package_ops));
+    total_area += function_base_area.logic_area_um2() +
+                  function_base_area.register_area_um2();
+    *proto.add_function_bases() = std::move(function_base_area);
+  }
+  AppendOps(package_ops, [&] { return proto.add_ops(); });
+  proto.set_total_area_um2(total_area);
+  return proto;
+}
+
+}  // namespace xls
@@ -0,0 +1,75 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_ESTIMATORS_AREA_MODEL_AREA_BREAKDOWN_H_
+#define XLS_ESTIMATORS_AREA_MODEL_AREA_BREAKDOWN_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/estimators/area_model/area_breakdown.pb.h"
+#include "xls/estimators/area_model/area_estimator.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// Cache the area of an underlying area estimator by the signature of each
+// operation (see SignatureCachingDelayEstimator::GetSignature). The area models
+// estimate the area of a node from the same properties as the delay models so
+// nodes with equal signatures have equal area. Estimates are shared by all
+// packages the estimator is used on, e.g., when estimating many designs with
+// the same model. Failed estimates are cached too.
+//
+// This class is safe for concurrent access.
+class SignatureCachingAreaEstimator : public AreaEstimator {
+ public:
+  explicit SignatureCachingAreaEstimator(const AreaEstimator& cached);
+
+  absl::StatusOr<double> GetOperationAreaInSquareMicrons(
+      Node* node) const override;
+
+  // Returns the number of cached signatures.
+  int64_t size() const;
+
+ private:
+  absl::StatusOr<double> GetOneBitRegisterAreaInSquareMicrons() const override;
+
+  const AreaEstimator& cached_;
+  mutable absl::Mutex mutex_;
+  mutable absl::flat_hash_map<std::string, absl::StatusOr<double>> cache_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns the estimated area of every function, proc and block in `package`
+// broken down by op. Function bases whose nodes are all in `node_stages`
+// (e.g., the cycle maps of their pipeline schedules) are also broken down by
+// stage, including the area of the pipeline registers between stages. The
+// registers of blocks are included as well.
+//
+// Each distinct operation signature is estimated once. Pass a
+// SignatureCachingAreaEstimator to also share the estimates between calls.
+// Nodes the area model has no estimate for are counted but contribute no area,
+// as are registers if the model does not estimate register area.
+absl::StatusOr<PackageAreaProto> EstimatePackageArea(
+    Package* package, const AreaEstimator& estimator,
+    const absl::flat_hash_map<Node*, int64_t>& node_stages = {});
+
+}  // namespace xls
+
+#endif  // XLS_ESTIMATORS_AREA_MODEL_AREA_BREAKDOWN_H_
@@ -0,0 +1,144 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/estimators/area_model/area_breakdown.h"
+
+#include <cstdint>
+#include <string_view>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/estimators/area_model/area_breakdown.pb.h"
+#include "xls/estimators/area_model/area_estimator.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+
+// Estimates the area of a node as its bit count and counts the estimates.
+// Params have no estimate.
+class CountingAreaEstimator : public AreaEstimator {
+ public:
+  explicit CountingAreaEstimator(std::string_view name)
+      : AreaEstimator(name) {}
+  absl::StatusOr<double> GetOperationAreaInSquareMicrons(
+      Node* node) const override {
+    ++estimate_count_;
+    if (node->op() == Op::kParam) {
+      return absl::UnimplementedError("no param model");
+    }
+    return node->GetType()->GetFlatBitCount();
+  }
+  absl::StatusOr<double> GetOneBitRegisterAreaInSquareMicrons() const override {
+    return 0.5;
+  }
+
+  int64_t estimate_count() const { return estimate_count_; }
+
+ private:
+  mutable int64_t estimate_count_ = 0;
+};
+
+class AreaBreakdownTest : public IrTestBase {};
+
+TEST_F(AreaBreakdownTest, SignatureCaching) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue a = fb.Add(x, y);
+  BValue b = fb.Add(y, x);
+  BValue c = fb.Add(x, x);
+  XLS_ASSERT_OK(fb.Build().status());
+
+  CountingAreaEstimator counting("counting");
+  SignatureCachingAreaEstimator caching(counting);
+  EXPECT_EQ(caching.name(), "counting");
+  EXPECT_THAT(caching.GetOperationAreaInSquareMicrons(a.node()),
+              IsOkAndHolds(8.0));
+  EXPECT_THAT(caching.GetOperationAreaInSquareMicrons(b.node()),
+              IsOkAndHolds(8.0));
+  EXPECT_EQ(counting.estimate_count(), 1);
+  // Repeated operands are a different signature.
+  EXPECT_THAT(caching.GetOperationAreaInSquareMicrons(c.node()),
+              IsOkAndHolds(8.0));
+  EXPECT_EQ(counting.estimate_count(), 2);
+  EXPECT_EQ(caching.size(), 2);
+  EXPECT_THAT(caching.GetRegisterAreaInSquareMicrons(4), IsOkAndHolds(2.0));
+}
+
+TEST_F(AreaBreakdownTest, PackageArea) {
+  auto p = CreatePackage();
+  FunctionBuilder fb("f", p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue sum = fb.Add(x, y);
+  BValue other_sum = fb.Add(y, x);
+  BValue concat = fb.Concat({sum, other_sum});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  CountingAreaEstimator estimator("counting");
+  // Stage 0 computes the sums which are held in registers for stage 1.
+  absl::flat_hash_map<Node*, int64_t> node_stages = {{x.node(), 0},
+                                                     {y.node(), 0},
+                                                     {sum.node(), 0},
+                                                     {other_sum.node(), 0},
+                                                     {concat.node(), 1}};
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PackageAreaProto area,
+      EstimatePackageArea(p.get(), estimator, node_stages));
+  // The two adds share a signature.
+  EXPECT_EQ(estimator.estimate_count(), 3);
+
+  EXPECT_EQ(area.area_model(), "counting");
+  EXPECT_DOUBLE_EQ(area.total_area_um2(), 32.0 + 8.0);
+  ASSERT_EQ(area.function_bases_size(), 1);
+  const FunctionBaseAreaProto& f_area = area.function_bases(0);
+  EXPECT_EQ(f_area.name(), f->name());
+  EXPECT_DOUBLE_EQ(f_area.logic_area_um2(), 32.0);
+  EXPECT_DOUBLE_EQ(f_area.register_area_um2(), 8.0);
+  ASSERT_EQ(f_area.ops_size(), 3);
+  EXPECT_EQ(f_area.ops(0).op(), "add");
+  EXPECT_EQ(f_area.ops(0).count(), 2);
+  EXPECT_DOUBLE_EQ(f_area.ops(0).area_um2(), 16.0);
+  EXPECT_EQ(f_area.ops(2).op(), "param");
+  EXPECT_EQ(f_area.ops(2).unestimated_count(), 2);
+  EXPECT_DOUBLE_EQ(f_area.ops(2).area_um2(), 0.0);
+
+  ASSERT_EQ(f_area.stages_size(), 2);
+  EXPECT_EQ(f_area.stages(0).stage(), 0);
+  EXPECT_DOUBLE_EQ(f_area.stages(0).logic_area_um2(), 16.0);
+  EXPECT_EQ(f_area.stages(0).register_bits(), 16);
+  EXPECT_DOUBLE_EQ(f_area.stages(0).register_area_um2(), 8.0);
+  EXPECT_EQ(f_area.stages(1).stage(), 1);
+  EXPECT_DOUBLE_EQ(f_area.stages(1).logic_area_um2(), 16.0);
+  EXPECT_EQ(f_area.stages(1).register_bits(), 0);
+
+  ASSERT_EQ(area.ops_size(), 3);
+  EXPECT_EQ(area.ops(1).op(), "concat");
+  EXPECT_EQ(area.ops(1).count(), 1);
+}
+
+}  // namespace
+}  // namespace xls
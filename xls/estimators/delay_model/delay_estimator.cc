@@ -15,21 +15,32 @@
 #include "xls/estimators/delay_model/delay_estimator.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>  // NOLINT
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include "absl/base/no_destructor.h"
+#include "absl/hash/hash.h"
 #include "absl/log/die_if_null.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/common/file/filesystem.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
@@ -264,6 +275,231 @@ absl::StatusOr<int64_t> CachingDelayEstimator::GetOperationDelayInPs(
   return delay;
 }
 
+SignatureCachingDelayEstimator::SignatureCachingDelayEstimator(
+    std::string_view name, const DelayEstimator& cached)
+    : DelayEstimator(name), cached_(cached) {
+  absl::MutexLock lock(&mutex_);
+  tables_.push_back(std::make_unique<Table>(64));
+  table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+SignatureCachingDelayEstimator::~SignatureCachingDelayEstimator() = default;
+
+/* static */ std::optional<std::string>
+SignatureCachingDelayEstimator::GetSignature(Node* node) {
+  switch (node->op()) {
+    case Op::kCountedFor:
+    case Op::kDynamicCountedFor:
+    case Op::kInvoke:
+    case Op::kMap:
+    case Op::kReceive:
+    case Op::kSend:
+      return std::nullopt;
+    default:
+      break;
+  }
+  std::string signature =
+      absl::StrCat(OpToString(node->op()), " ", node->GetType()->ToString());
+  switch (node->op()) {
+    case Op::kBitSlice:
+      absl::StrAppend(&signature, " start=", node->As<BitSlice>()->start());
+      break;
+    case Op::kTupleIndex:
+      absl::StrAppend(&signature, " index=", node->As<TupleIndex>()->index());
+      break;
+    case Op::kOneHot:
+      absl::StrAppend(&signature, " lsb_prio=",
+                      node->As<OneHot>()->priority() == LsbOrMsb::kLsb);
+      break;
+    case Op::kSel:
+      absl::StrAppend(&signature, " default=",
+                      node->As<Select>()->default_value().has_value());
+      break;
+    case Op::kMinDelay:
+      absl::StrAppend(&signature, " delay=", node->As<MinDelay>()->delay());
+      break;
+    default:
+      break;
+  }
+  for (int64_t i = 0; i < node->operand_count(); ++i) {
+    Node* operand = node->operand(i);
+    absl::StrAppend(&signature, " ", operand->GetType()->ToString());
+    if (operand->Is<Literal>()) {
+      absl::StrAppend(&signature, "=",
+                      operand->As<Literal>()->value().ToString());
+    }
+    // Estimators may specialize on repeated operands, e.g. `and(x, x)`.
+    for (int64_t j = 0; j < i; ++j) {
+      if (node->operand(j) == operand) {
+        absl::StrAppend(&signature, "@", j);
+        break;
+      }
+    }
+  }
+  return signature;
+}
+
+std::optional<int64_t> SignatureCachingDelayEstimator::Find(
+    std::string_view signature) const {
+  const Table* table = table_.load(std::memory_order_acquire);
+  size_t mask = table->slots.size() - 1;
+  for (size_t i = absl::HashOf(signature) & mask;; i = (i + 1) & mask) {
+    const Entry* entry = table->slots[i].load(std::memory_order_acquire);
+    if (entry == nullptr) {
+      return std::nullopt;
+    }
+    if (entry->signature == signature) {
+      return entry->delay;
+    }
+  }
+}
+
+void SignatureCachingDelayEstimator::InsertLocked(const Entry* entry) const {
+  Table* table = table_.load(std::memory_order_relaxed);
+  if (2 * (entries_.size() + 1) > table->slots.size()) {
+    // Readers may still be probing the old table, so it is kept rather than
+    // resized in place.
+    tables_.push_back(std::make_unique<Table>(2 * table->slots.size()));
+    table = tables_.back().get();
+    size_t mask = table->slots.size() - 1;
+    for (const std::unique_ptr<Entry>& old : entries_) {
+      size_t i = absl::HashOf(std::string_view(old->signature)) & mask;
+      while (table->slots[i].load(std::memory_order_relaxed) != nullptr) {
+        i = (i + 1) & mask;
+      }
+      table->slots[i].store(old.get(), std::memory_order_relaxed);
+    }
+    table_.store(table, std::memory_order_release);
+  }
+  size_t mask = table->slots.size() - 1;
+  size_t i = absl::HashOf(std::string_view(entry->signature)) & mask;
+  while (table->slots[i].load(std::memory_order_relaxed) != nullptr) {
+    i = (i + 1) & mask;
+  }
+  table->slots[i].store(entry, std::memory_order_release);
+}
+
+void SignatureCachingDelayEstimator::Insert(std::string signature,
+                                            int64_t delay) const {
+  absl::MutexLock lock(&mutex_);
+  if (Find(signature).has_value()) {
+    return;
+  }
+  auto entry = std::make_unique<Entry>(Entry{std::move(signature), delay});
+  InsertLocked(entry.get());
+  entries_.push_back(std::move(entry));
+}
+
+absl::StatusOr<int64_t> SignatureCachingDelayEstimator::GetOperationDelayInPs(
+    Node* node) const {
+  std::optional<std::string> signature = GetSignature(node);
+  if (!signature.has_value()) {
+    return cached_.GetOperationDelayInPs(node);
+  }
+  if (std::optional<int64_t> delay = Find(*signature); delay.has_value()) {
+    return *delay;
+  }
+  XLS_ASSIGN_OR_RETURN(int64_t delay, cached_.GetOperationDelayInPs(node));
+  Insert(*std::move(signature), delay);
+  return delay;
+}
+
+absl::StatusOr<std::vector<int64_t>>
+SignatureCachingDelayEstimator::GetOperationDelaysInPs(
+    absl::Span<Node* const> nodes) const {
+  std::vector<int64_t> delays(nodes.size());
+  // Nodes which miss the cache are estimated together and then inserted under
+  // a single acquisition of the lock.
+  std::vector<Node*> misses;
+  std::vector<int64_t> miss_indices;
+  std::vector<std::optional<std::string>> miss_signatures;
+  for (int64_t i = 0; i < nodes.size(); ++i) {
+    std::optional<std::string> signature = GetSignature(nodes[i]);
+    if (signature.has_value()) {
+      if (std::optional<int64_t> delay = Find(*signature); delay.has_value()) {
+        delays[i] = *delay;
+        continue;
+      }
+    }
+    misses.push_back(nodes[i]);
+    miss_indices.push_back(i);
+    miss_signatures.push_back(std::move(signature));
+  }
+  if (misses.empty()) {
+    return delays;
+  }
+  XLS_ASSIGN_OR_RETURN(std::vector<int64_t> miss_delays,
+                       cached_.GetOperationDelaysInPs(misses));
+  absl::MutexLock lock(&mutex_);
+  for (int64_t i = 0; i < misses.size(); ++i) {
+    delays[miss_indices[i]] = miss_delays[i];
+    if (!miss_signatures[i].has_value() ||
+        Find(*miss_signatures[i]).has_value()) {
+      continue;
+    }
+    auto entry = std::make_unique<Entry>(
+        Entry{*std::move(miss_signatures[i]), miss_delays[i]});
+    InsertLocked(entry.get());
+    entries_.push_back(std::move(entry));
+  }
+  return delays;
+}
+
+int64_t SignatureCachingDelayEstimator::size() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+// The file starts with a line naming the underlying estimator followed by one
+// line per signature holding the delay and the signature separated by a space.
+// Signatures never contain newlines.
+absl::Status SignatureCachingDelayEstimator::SaveToFile(
+    const std::filesystem::path& path) const {
+  std::string contents = absl::StrCat("estimator ", cached_.name(), "\n");
+  {
+    absl::MutexLock lock(&mutex_);
+    for (const std::unique_ptr<Entry>& entry : entries_) {
+      absl::StrAppend(&contents, entry->delay, " ", entry->signature, "\n");
+    }
+  }
+  return SetFileContents(path, contents);
+}
+
+absl::Status SignatureCachingDelayEstimator::LoadFromFile(
+    const std::filesystem::path& path) {
+  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+  std::vector<std::string_view> lines =
+      absl::StrSplit(contents, '\n', absl::SkipEmpty());
+  std::string header = absl::StrCat("estimator ", cached_.name());
+  if (lines.empty() || lines.front() != header) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Delay cache file %s was not written for delay estimator `%s`.",
+        path.string(), cached_.name()));
+  }
+  for (std::string_view line : absl::MakeSpan(lines).subspan(1)) {
+    std::pair<std::string_view, std::string_view> fields =
+        absl::StrSplit(line, absl::MaxSplits(' ', 1));
+    int64_t delay;
+    if (fields.second.empty() || !absl::SimpleAtoi(fields.first, &delay)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Malformed line in delay cache file %s: `%s`", path.string(), line));
+    }
+    Insert(std::string(fields.second), delay);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<int64_t>> DelayEstimator::GetOperationDelaysInPs(
+    absl::Span<Node* const> nodes) const {
+  std::vector<int64_t> delays;
+  delays.reserve(nodes.size());
+  for (Node* node : nodes) {
+    XLS_ASSIGN_OR_RETURN(int64_t delay, GetOperationDelayInPs(node));
+    delays.push_back(delay);
+  }
+  return delays;
+}
+
 /* static */ absl::StatusOr<int64_t> DelayEstimator::GetLogicalEffortDelayInPs(
     Node* node, int64_t tau_in_ps) {
   XLS_ASSIGN_OR_RETURN(int64_t delay_in_tau, GetLogicalEffortDelayInTau(node));
@@ -15,9 +15,12 @@
 #ifndef XLS_ESTIMATORS_DELAY_MODEL_DELAY_ESTIMATOR_H_
 #define XLS_ESTIMATORS_DELAY_MODEL_DELAY_ESTIMATOR_H_
 
+#include <atomic>
 #include <cstdint>
+#include <filesystem>  // NOLINT
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -45,6 +48,12 @@ class DelayEstimator {
   // Returns the estimated delay of the given node in picoseconds.
   virtual absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const = 0;
 
+  // Returns the estimated delays of the given nodes in picoseconds, in the
+  // same order. Estimators which can amortize work across nodes should
+  // override this; by default each node is estimated in turn.
+  virtual absl::StatusOr<std::vector<int64_t>> GetOperationDelaysInPs(
+      absl::Span<Node* const> nodes) const;
+
   // Compute the delay of the given node using logical effort estimation. Only
   // relatively simple operations (kAnd, kOr, etc) are supported using this
   // method.
@@ -122,6 +131,70 @@ class CachingDelayEstimator : public DelayEstimator {
       ABSL_GUARDED_BY(cache_mutex_);
 };
 
+// Cache the delay of an underlying delay estimator by the signature of each
+// operation: its op, result and operand types, the values of literal operands,
+// which operands are repeated, and the op-specific attributes. Unlike
+// CachingDelayEstimator the cached delays are therefore shared by all
+// functions (and clones of them) and can be saved to and loaded from a file,
+// but this is only correct for underlying estimators whose estimates depend
+// on nothing else, as is the case for the estimators built from delay models.
+// Ops which refer to other functions or to channels are never cached.
+//
+// This class is safe for concurrent access. Lookups do not take a lock; only
+// the insertion of new signatures does.
+class SignatureCachingDelayEstimator : public DelayEstimator {
+ public:
+  SignatureCachingDelayEstimator(std::string_view name,
+                                 const DelayEstimator& cached);
+
+  ~SignatureCachingDelayEstimator() override;
+
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override;
+  absl::StatusOr<std::vector<int64_t>> GetOperationDelaysInPs(
+      absl::Span<Node* const> nodes) const override;
+
+  // Returns the signature under which the delay of `node` is cached, or
+  // std::nullopt if the delay of `node` is not cacheable.
+  static std::optional<std::string> GetSignature(Node* node);
+
+  // Returns the number of cached signatures.
+  int64_t size() const;
+
+  // Writes the cached delays to the file at `path`.
+  absl::Status SaveToFile(const std::filesystem::path& path) const;
+
+  // Adds the delays in the file at `path` to the cache. Returns an error if
+  // the file was written for a different underlying estimator.
+  absl::Status LoadFromFile(const std::filesystem::path& path);
+
+ private:
+  struct Entry {
+    std::string signature;
+    int64_t delay;
+  };
+
+  // An open addressing hash table of entries with a power of two capacity.
+  // Slots are only ever filled, never cleared, so readers can probe without
+  // synchronizing with writers.
+  struct Table {
+    explicit Table(int64_t capacity) : slots(capacity) {}
+    std::vector<std::atomic<const Entry*>> slots;
+  };
+
+  std::optional<int64_t> Find(std::string_view signature) const;
+  void Insert(std::string signature, int64_t delay) const;
+  void InsertLocked(const Entry* entry) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const DelayEstimator& cached_;
+  mutable std::atomic<Table*> table_;
+  mutable absl::Mutex mutex_;
+  // Every entry and table is kept alive until destruction because readers may
+  // still be probing a table which has been replaced by a larger one.
+  mutable std::vector<std::unique_ptr<Entry>> entries_ ABSL_GUARDED_BY(mutex_);
+  mutable std::vector<std::unique_ptr<Table>> tables_ ABSL_GUARDED_BY(mutex_);
+};
+
 enum class DelayEstimatorPrecedence {
   kLow = 1,
   kMedium = 2,
@@ -14,6 +14,7 @@
 
 #include "xls/estimators/delay_model/delay_estimator.h"
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string_view>
@@ -24,8 +25,10 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/function.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/op.h"
@@ -304,6 +307,108 @@ TEST_F(DelayEstimatorTest, CachingDelayEstimator) {
   EXPECT_THAT(caching.GetNodeDelay(f->return_value()), 1);
 }
 
+// A test delay estimator which returns the result bit count of every node and
+// counts how often it is queried.
+class CountingDelayEstimator : public DelayEstimator {
+ public:
+  CountingDelayEstimator() : DelayEstimator("counting") {}
+
+  absl::StatusOr<int64_t> GetOperationDelayInPs(Node* node) const override {
+    ++queries_;
+    return node->GetType()->GetFlatBitCount();
+  }
+
+  int64_t queries() const { return queries_; }
+
+ private:
+  mutable std::atomic<int64_t> queries_ = 0;
+};
+
+TEST_F(DelayEstimatorTest, GetOperationDelaysInPs) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(16));
+  BValue z = fb.Concat({x, y});
+  XLS_ASSERT_OK(fb.BuildWithReturnValue(z));
+  CountingDelayEstimator counting;
+  EXPECT_THAT(counting.GetOperationDelaysInPs({x.node(), z.node(), y.node()}),
+              IsOkAndHolds(ElementsAre(8, 24, 16)));
+}
+
+TEST_F(DelayEstimatorTest, SignatureCachingDelayEstimatorSharesSignatures) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue a = fb.Add(x, y);
+  BValue b = fb.Add(y, x);
+  BValue c = fb.Add(x, x);
+  BValue d = fb.Add(x, fb.Literal(UBits(1, 8)));
+  BValue e = fb.Add(y, fb.Literal(UBits(2, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           fb.BuildWithReturnValue(fb.Tuple({a, b, c, d, e})));
+
+  EXPECT_EQ(SignatureCachingDelayEstimator::GetSignature(a.node()),
+            SignatureCachingDelayEstimator::GetSignature(b.node()));
+  // Repeated operands and literal values are part of the signature.
+  EXPECT_NE(SignatureCachingDelayEstimator::GetSignature(a.node()),
+            SignatureCachingDelayEstimator::GetSignature(c.node()));
+  EXPECT_NE(SignatureCachingDelayEstimator::GetSignature(d.node()),
+            SignatureCachingDelayEstimator::GetSignature(e.node()));
+
+  CountingDelayEstimator counting;
+  SignatureCachingDelayEstimator caching("caching", counting);
+  std::vector<Node*> nodes = {a.node(), b.node(), c.node(), d.node(),
+                              e.node()};
+  EXPECT_THAT(caching.GetOperationDelaysInPs(nodes),
+              IsOkAndHolds(ElementsAre(8, 8, 8, 8, 8)));
+  EXPECT_EQ(counting.queries(), 5);
+  EXPECT_EQ(caching.size(), 4);
+
+  // A clone of the function hits the cache for every node.
+  XLS_ASSERT_OK_AND_ASSIGN(Function * clone, f->Clone("clone"));
+  for (Node* node : clone->nodes()) {
+    if (node->op() == Op::kAdd) {
+      EXPECT_THAT(caching.GetOperationDelayInPs(node), IsOkAndHolds(8));
+    }
+  }
+  EXPECT_EQ(counting.queries(), 5);
+}
+
+TEST_F(DelayEstimatorTest, SignatureCachingDelayEstimatorSaveAndLoad) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue sum = fb.Add(x, x);
+  BValue product = fb.UMul(y, y);
+  XLS_ASSERT_OK(fb.BuildWithReturnValue(fb.Tuple({sum, product})));
+
+  CountingDelayEstimator counting;
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file, TempFile::Create());
+  {
+    SignatureCachingDelayEstimator caching("caching", counting);
+    XLS_ASSERT_OK(caching.GetOperationDelaysInPs({sum.node(), product.node()})
+                      .status());
+    XLS_ASSERT_OK(caching.SaveToFile(file.path()));
+  }
+  EXPECT_EQ(counting.queries(), 2);
+
+  SignatureCachingDelayEstimator loaded("loaded", counting);
+  XLS_ASSERT_OK(loaded.LoadFromFile(file.path()));
+  EXPECT_EQ(loaded.size(), 2);
+  EXPECT_THAT(loaded.GetOperationDelayInPs(sum.node()), IsOkAndHolds(8));
+  EXPECT_THAT(loaded.GetOperationDelayInPs(product.node()), IsOkAndHolds(32));
+  EXPECT_EQ(counting.queries(), 2);
+
+  // A cache written for another estimator is rejected.
+  FakeDelayEstimator other(1, "other");
+  SignatureCachingDelayEstimator mismatched("mismatched", other);
+  EXPECT_THAT(mismatched.LoadFromFile(file.path()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 // A Delay Estimator that can only handle one kind of operation.
 class TestNodeMatchEstimator : public DelayEstimator {
  public:
@@ -36,6 +36,12 @@ flags.DEFINE_enum(
     help='Precedence of model.',
     enum_values=('kLow', 'kMedium', 'kHigh'),
 )
+flags.DEFINE_bool(
+    'lookup_tables',
+    True,
+    'Emit estimators which depend on a single factor (e.g., bit width) as '
+    'precomputed constexpr tables indexed by the factor.',
+)
 flags.mark_flag_as_required('model_name')
 flags.mark_flag_as_required('precedence')
 FLAGS = flags.FLAGS
@@ -63,6 +69,7 @@ def main(argv):
   template = env.from_string(tmpl_text)
   rendered = template.render(
       delay_model=em,
+      use_lookup_tables=FLAGS.lookup_tables,
       name=FLAGS.model_name,
       precedence=FLAGS.precedence,
       camel_case_name=''.join(
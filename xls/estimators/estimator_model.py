@@ -23,6 +23,7 @@ compute the metric as well as provide metric estimates in Python.
 import abc
 import dataclasses
 import enum
+import math
 import random
 from typing import Callable, List, Optional, Sequence, Tuple, Union
 
@@ -31,11 +32,45 @@ from scipy import optimize as opt
 
 from xls.estimators import estimator_model_pb2
 
+# Largest factor value (e.g., bit width) covered by a generated lookup table.
+MAX_LOOKUP_TABLE_FACTOR = 1024
+
 
 class Error(Exception):
   pass
 
 
+def _cpp_round(value: float) -> int:
+  """Rounds half away from zero, matching std::round."""
+  return int(math.copysign(math.floor(abs(value) + 0.5), value))
+
+
+def _lookup_table_size(max_factor: int) -> int:
+  """Returns the number of entries of a table covering [0, max_factor].
+
+  The table is extended to the next power of two so that widths just above the
+  largest characterized one are also covered.
+  """
+  bound = 1
+  while bound < max_factor:
+    bound *= 2
+  return min(bound, MAX_LOOKUP_TABLE_FACTOR) + 1
+
+
+def _cpp_lookup_table(
+    factor_cpp_expression: str, entries: Sequence[int]
+) -> str:
+  """Returns C++ statements returning entries[factor] if it is in range."""
+  return '\n'.join([
+      '{',
+      '  static constexpr std::array<int64_t, %d> kTable = {%s};'
+      % (len(entries), ', '.join(str(e) for e in entries)),
+      '  const int64_t x = %s;' % factor_cpp_expression,
+      '  if (x >= 0 && x < %d) { return kTable[x]; }' % len(entries),
+      '}',
+  ])
+
+
 class Metric(enum.Enum):
   """String Enum representing metric.
 
@@ -98,6 +133,20 @@ class Estimator(metaclass=abc.ABCMeta):
     """
     raise NotImplementedError
 
+  def cpp_lookup_table_code(self, node_identifier: str) -> Optional[str]:
+    """Returns C++ statements returning the metric from a precomputed table.
+
+    The statements fall through if the node is outside of the table, so they
+    must be followed by the code from cpp_estimation_code. Returns None if the
+    estimator has no table form.
+
+    Args:
+      node_identifier: The string identifier of the Node* value whose metric is
+        being estimated.
+    """
+    del node_identifier
+    return None
+
   @abc.abstractmethod
   def operation_estimation(
       self, operation: estimator_model_pb2.Operation
@@ -616,6 +665,29 @@ class RegressionEstimator(Estimator):
     """Returns the estimation with estimator expressions passed in as floats."""
     return self.estimator_function(xargs)
 
+  def cpp_lookup_table_code(self, node_identifier: str) -> Optional[str]:
+    # Only single-factor delay curves are tabulated; the table holds exactly
+    # the values the curve evaluates to in cpp_estimation_code.
+    if (
+        self.metric != Metric.DELAY_METRIC
+        or len(self.estimator_expressions) != 1
+        or not self.estimator_expressions[0].HasField('factor')
+    ):
+      return None
+    max_factor = max(int(dp.factors[0]) for dp in self.raw_data_points)
+    entries = []
+    for x in range(_lookup_table_size(max_factor)):
+      value = float(self.params[0])
+      value += float(self.params[1]) * float(x)
+      value += float(self.params[2]) * math.log2(1.0 if x < 1 else float(x))
+      entries.append(_cpp_round(value))
+    return _cpp_lookup_table(
+        _estimator_factor_cpp_expression(
+            self.estimator_expressions[0].factor, node_identifier
+        ),
+        entries,
+    )
+
   def cpp_estimation_code(self, node_identifier: str) -> str:
     terms = [repr(float(self.params[0]))]
     for i, expression in enumerate(self.estimator_expressions):
@@ -823,6 +895,21 @@ class BoundingBoxEstimator(Estimator):
     )
     return '\n'.join(lines)
 
+  def cpp_lookup_table_code(self, node_identifier: str) -> Optional[str]:
+    if self.metric != Metric.DELAY_METRIC or len(self.estimator_factors) != 1:
+      return None
+    max_factor = max(int(dp.factors[0]) for dp in self.raw_data_points)
+    entries = [
+        int(self.raw_estimation((x,)))
+        for x in range(min(max_factor, MAX_LOOKUP_TABLE_FACTOR) + 1)
+    ]
+    return _cpp_lookup_table(
+        _estimator_factor_cpp_expression(
+            self.estimator_factors[0], node_identifier
+        ),
+        entries,
+    )
+
   def operation_estimation(
       self, operation: estimator_model_pb2.Operation
   ) -> Union[int, float]:
@@ -1035,8 +1122,24 @@ class OpModel:
         self.op, self.metric, proto.estimator, data_points
     )
 
-  def cpp_estimation_function(self) -> str:
-    """Return a C++ function which estimates a metric for an operation."""
+  def cpp_estimation_function(self, use_lookup_tables: bool = False) -> str:
+    """Return a C++ function which estimates a metric for an operation.
+
+    Args:
+      use_lookup_tables: Whether estimators with a table form are emitted as
+        constexpr tables indexed by the estimator factor, avoiding evaluating
+        the estimator on every call. Nodes outside of the tables are still
+        estimated by the estimator code.
+    """
+
+    def estimation_code(estimator: Estimator) -> str:
+      code = estimator.cpp_estimation_code('node')
+      if use_lookup_tables:
+        table = estimator.cpp_lookup_table_code('node')
+        if table is not None:
+          code = table + '\n' + code
+      return code
+
     metric_return_type = {
         Metric.DELAY_METRIC: 'int64_t',
         Metric.AREA_METRIC: 'double',
@@ -1096,9 +1199,9 @@ class OpModel:
       else:
         raise NotImplementedError
       lines.append('if (%s) {' % cond)
-      lines.append(estimator.cpp_estimation_code('node'))
+      lines.append(estimation_code(estimator))
       lines.append('}')
-    lines.append(self.estimator.cpp_estimation_code('node'))
+    lines.append(estimation_code(self.estimator))
     lines.append('}')
     return '\n'.join(lines)
 
@@ -231,6 +231,63 @@ class EstimatorModelTest(absltest.TestCase):
         """,
     )
 
+  def test_one_factor_regression_estimator_lookup_table(self):
+    data_points_str = [
+        'operation { op: "kFoo" bit_count: %d } delay: %d delay_offset: 10'
+        % (bc, 100 * bc + 10)
+        for bc in (2, 4, 6, 8, 10)
+    ]
+    result_bit_count = estimator_model_pb2.EstimatorExpression()
+    result_bit_count.factor.source = (
+        estimator_model_pb2.EstimatorFactor.Source.RESULT_BIT_COUNT
+    )
+    foo = estimator_model.RegressionEstimator(
+        'kFoo',
+        estimator_model.Metric.DELAY_METRIC,
+        (result_bit_count,),
+        tuple(_parse_data_point(s) for s in data_points_str),
+    )
+    code = foo.cpp_lookup_table_code('node')
+    # The table covers widths up to the next power of two above the largest
+    # characterized width.
+    match = re.search(
+        r'std::array<int64_t, (\d+)> kTable = {([^}]*)};', code
+    )
+    self.assertIsNotNone(match)
+    self.assertEqual(int(match.group(1)), 17)
+    self.assertEqual(
+        [int(e) for e in match.group(2).split(',')],
+        [100 * bc for bc in range(17)],
+    )
+    self.assertIn(
+        'const int64_t x = node->GetType()->GetFlatBitCount();', code
+    )
+    self.assertIn('if (x >= 0 && x < 17) { return kTable[x]; }', code)
+
+  def test_two_factor_regression_estimator_has_no_lookup_table(self):
+    data_points_str = [
+        'operation { op: "kFoo" bit_count: %d operands { bit_count: %d } } '
+        'delay: %d delay_offset: 0' % (bc, oc, 10 * bc + oc)
+        for bc in (2, 4, 8, 16)
+        for oc in (1, 3, 5)
+    ]
+    result_bit_count = estimator_model_pb2.EstimatorExpression()
+    result_bit_count.factor.source = (
+        estimator_model_pb2.EstimatorFactor.Source.RESULT_BIT_COUNT
+    )
+    operand_bit_count = estimator_model_pb2.EstimatorExpression()
+    operand_bit_count.factor.source = (
+        estimator_model_pb2.EstimatorFactor.Source.OPERAND_BIT_COUNT
+    )
+    operand_bit_count.factor.operand_number = 0
+    foo = estimator_model.RegressionEstimator(
+        'kFoo',
+        estimator_model.Metric.DELAY_METRIC,
+        (result_bit_count, operand_bit_count),
+        tuple(_parse_data_point(s) for s in data_points_str),
+    )
+    self.assertIsNone(foo.cpp_lookup_table_code('node'))
+
   def test_one_regression_estimator_operand_count(self):
 
     def gen_operation(operand_count):
@@ -1185,6 +1242,64 @@ class EstimatorModelTest(absltest.TestCase):
         """,
     )
 
+  def test_op_model_with_lookup_tables(self):
+
+    def gen_data_point(bit_count, delay, specialization=''):
+      return _parse_data_point(
+          'operation { op: "kFoo" bit_count: %d %s} delay: %d delay_offset: 0'
+          % (bit_count, specialization, delay)
+      )
+
+    op_model = estimator_model.OpModel(
+        estimator_model.Metric.DELAY_METRIC,
+        text_format.Parse(
+            'op: "kFoo" estimator { regression { expressions { factor { source:'
+            ' RESULT_BIT_COUNT } } } }specializations { kind:'
+            ' OPERANDS_IDENTICAL estimator { bounding_box { factors { source:'
+            ' RESULT_BIT_COUNT } } } }',
+            estimator_model_pb2.OpModel(),
+        ),
+        [gen_data_point(bc, 10 * bc) for bc in range(1, 10)]
+        + [
+            gen_data_point(bc, 2 * bc, 'specialization: OPERANDS_IDENTICAL')
+            for bc in range(1, 3)
+        ],
+    )
+    self.assertEqualIgnoringWhitespaceAndFloats(
+        op_model.cpp_estimation_function(use_lookup_tables=True),
+        """
+          absl::StatusOr<int64_t> FooDelay(Node* node) {
+            if (std::all_of(node->operands().begin(), node->operands().end(),
+                [&](Node* n) { return n == node->operand(0); })) {
+              {
+                static constexpr std::array<int64_t, 3> kTable = {2, 2, 4};
+                const int64_t x = node->GetType()->GetFlatBitCount();
+                if (x >= 0 && x < 3) { return kTable[x]; }
+              }
+              if (node->GetType()->GetFlatBitCount() <= 1) { return 2; }
+              if (node->GetType()->GetFlatBitCount() <= 2) { return 4; }
+              return absl::UnimplementedError(
+                "Unhandled node for delay estimation: " +
+                node->ToStringWithOperandTypes());
+            }
+            {
+              static constexpr std::array<int64_t, 17> kTable = {
+                0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120, 130,
+                140, 150, 160};
+              const int64_t x = node->GetType()->GetFlatBitCount();
+              if (x >= 0 && x < 17) { return kTable[x]; }
+            }
+            return std::round(
+                0.0 + 0.0 * static_cast<float>(node->GetType()->GetFlatBitCount()) +
+                0.0 * std::log2(
+                  static_cast<float>(node->GetType()->GetFlatBitCount()) < 1.0 ?
+                   1.0 :
+                  static_cast<float>(node->GetType()->GetFlatBitCount())
+                ));
+          }
+        """,
+    )
+
   def test_regression_estimator_generate_validation_sets(self):
 
     def gen_raw_dp(*a):
@@ -56,6 +56,18 @@ _RPC_PORT = flags.DEFINE_integer(
     'Endpoint port for a separately running synthesis server. If not provided,'
     ' yosys_server_main will be started internally.',
 )
+_NUM_SERVERS = flags.DEFINE_integer(
+    'num_servers',
+    1,
+    'Number of synthesis servers to start internally. The client dispatches'
+    ' points to all of them concurrently. Ignored if --rpc_port is given.',
+)
+_ADAPTIVE_ROUNDS = flags.DEFINE_integer(
+    'adaptive_rounds',
+    0,
+    'Number of rounds of adaptive refinement of the sample points, which adds'
+    ' points where interpolating between the collected points is inaccurate.',
+)
 _MAX_THREADS = flags.DEFINE_integer(
     'max_threads',
     max(os.cpu_count() // 2, 1),
@@ -138,7 +150,7 @@ class WorkerConfig:
 
   server_bin: str
   server_extra_args = []
-  rpc_port: int
+  rpc_ports: List[int] = []
 
   client_bin: str
   client_args = []
@@ -236,10 +248,10 @@ def _do_config_task(config: WorkerConfig):
   if not os.path.isfile(config.client_bin):
     raise app.UsageError(f'Client tool not found with {config.client_bin}')
 
-  config.rpc_port = (
-      _RPC_PORT.value
+  config.rpc_ports = (
+      [_RPC_PORT.value]
       if _RPC_PORT.value is not None
-      else portpicker.pick_unused_port()
+      else [portpicker.pick_unused_port() for _ in range(_NUM_SERVERS.value)]
   )
 
   if config.debug:
@@ -261,6 +273,10 @@ def _do_config_task(config: WorkerConfig):
     config.client_extra_args.append(
         '--op_include_list=' + ','.join(_OP_INCLUDE_LIST.value)
     )
+  if _ADAPTIVE_ROUNDS.value:
+    config.client_extra_args.append(
+        f'--adaptive_rounds={_ADAPTIVE_ROUNDS.value}'
+    )
 
 
 def _do_config_asap7(config: WorkerConfig):
@@ -315,7 +331,9 @@ def _do_config_sky130(config: WorkerConfig):
   config.client_args.append('--max_ps=10000')
 
 
-def _start_server(config: WorkerConfig) -> subprocess.Popen[bytes]:
+def _start_server(
+    config: WorkerConfig, rpc_port: int
+) -> subprocess.Popen[bytes]:
   """Starts a Yosys synthesis server locally using the given config."""
   server = [repr(config.server_bin)]
   server.append(f'--yosys_path={config.yosys_bin!r}')
@@ -331,15 +349,13 @@ def _start_server(config: WorkerConfig) -> subprocess.Popen[bytes]:
   if _DEFAULT_LOAD.value:
     server.append(f'--default_load={_DEFAULT_LOAD.value!r}')
 
-  server.append(f'--port={config.rpc_port}')
+  server.append(f'--port={rpc_port}')
   server.extend(repr(arg) for arg in config.server_extra_args)
 
   server_cmd = ' '.join(server)
 
   # start non-blocking process
-  server_proc = subprocess.Popen(server_cmd, stdout=subprocess.PIPE, shell=True)
-  time.sleep(_SERVER_STARTUP_WAIT_SECS)
-  return server_proc
+  return subprocess.Popen(server_cmd, stdout=subprocess.PIPE, shell=True)
 
 
 def _do_worker_task(config: WorkerConfig):
@@ -349,15 +365,19 @@ def _do_worker_task(config: WorkerConfig):
   if config.debug:
     logging.info('  Client       : %s', config.client_bin)
     if _RPC_PORT.value is not None:
-      logging.info('  External RPC port : %s', config.rpc_port)
+      logging.info('  External RPC port : %s', _RPC_PORT.value)
     else:
       logging.info('  OpenROAD dir : %s', config.openroad_path)
       logging.info('  Server       : %s', config.server_bin)
+      logging.info('  Server ports : %s', config.rpc_ports)
       logging.info('  Using Yosys  : %s', config.yosys_bin)
       logging.info('  Using STA    : %s', config.sta_bin)
 
   start = datetime.datetime.now()
-  server_proc = None if _RPC_PORT.value is not None else _start_server(config)
+  server_procs = []
+  if _RPC_PORT.value is None:
+    server_procs = [_start_server(config, port) for port in config.rpc_ports]
+    time.sleep(_SERVER_STARTUP_WAIT_SECS)
 
   client = [repr(config.client_bin)]
   if config.client_checkpoint_file:
@@ -365,7 +385,9 @@ def _do_worker_task(config: WorkerConfig):
   client.append(f'--out_path {config.client_out_file!r}')
   client.extend(repr(arg) for arg in config.client_args)
   client.extend(repr(arg) for arg in config.client_extra_args)
-  client.append(f'--port={config.rpc_port}')
+  client.append(
+      '--servers=' + ','.join(f'localhost:{port}' for port in config.rpc_ports)
+  )
 
   client_cmd = ' '.join(client)
   # create a checkpoint file if not already there
@@ -387,8 +409,8 @@ def _do_worker_task(config: WorkerConfig):
       ' Total elapsed time for worker (%s) : %s', config.target, elapsed
   )
 
-  if server_proc is not None:
-    # clean up
+  # clean up
+  for server_proc in server_procs:
     server_proc.kill()
     server_proc.communicate()
 
@@ -17,9 +17,11 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <optional>
 #include <tuple>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/functional/function_ref.h"
@@ -40,37 +42,88 @@
 namespace xls {
 
 DelayManager::DelayManager(FunctionBase *function,
-                           const DelayEstimator &delay_estimator)
+                           const DelayEstimator &delay_estimator,
+                           std::optional<int64_t> max_tracked_delay)
     : function_(function),
-      index_to_node_(function_->node_count()),
-      indices_to_delay_(function_->node_count(),
-                        std::vector<int64_t>(function_->node_count(), -1)),
-      indices_to_critical_operand_(
-          function_->node_count(),
-          std::vector<Node *>(function_->node_count(), nullptr)),
+      max_tracked_delay_(max_tracked_delay),
+      index_to_node_(TopoSort(function_)),
+      paths_to_(index_to_node_.size()),
       name_(delay_estimator.name()) {
   // Get the mapping between function node and their index. Also, estimate the
   // delay of each node.
-  node_to_index_.reserve(function_->node_count());
-  int32_t index = 0;
-  for (Node *node : function_->nodes()) {
+  node_to_index_.reserve(index_to_node_.size());
+  for (int64_t index = 0; index < index_to_node_.size(); ++index) {
+    Node *node = index_to_node_[index];
     node_to_index_[node] = index;
-    index_to_node_[index] = node;
     absl::StatusOr<int64_t> maybe_delay =
         delay_estimator.GetOperationDelayInPs(node);
     CHECK_OK(maybe_delay.status());
-    indices_to_delay_[index][index] = maybe_delay.value();
-    index++;
+    paths_to_[index].push_back(Entry{.source = static_cast<int32_t>(index),
+                                     .critical_operand = -1,
+                                     .delay = maybe_delay.value()});
   }
   PropagateDelays();
 }
 
+const DelayManager::Entry *DelayManager::FindEntry(int64_t from_index,
+                                                   int64_t to_index) const {
+  const std::vector<Entry> &paths = paths_to_[to_index];
+  auto it = absl::c_lower_bound(paths, from_index,
+                                [](const Entry &entry, int64_t source) {
+                                  return entry.source < source;
+                                });
+  if (it == paths.end() || it->source != from_index) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+int64_t DelayManager::ComputeCriticalPathDelay(
+    int64_t from_index, int64_t to_index,
+    std::vector<int64_t> *critical_operands) const {
+  if (from_index > to_index) {
+    return -1;
+  }
+  // Only the nodes between the two in topological order can be on a path
+  // between them.
+  std::vector<int64_t> delays(to_index - from_index + 1, -1);
+  if (critical_operands != nullptr) {
+    critical_operands->assign(delays.size(), -1);
+  }
+  for (int64_t i = from_index; i <= to_index; ++i) {
+    int64_t &delay = delays[i - from_index];
+    int64_t critical_operand = -1;
+    if (const Entry *entry = FindEntry(from_index, i);
+        entry != nullptr && entry->exact) {
+      delay = entry->delay;
+      critical_operand = entry->critical_operand;
+    } else {
+      for (Node *operand : index_to_node_[i]->operands()) {
+        int64_t operand_index = node_to_index_.at(operand);
+        if (operand_index < from_index ||
+            delays[operand_index - from_index] == -1) {
+          continue;
+        }
+        int64_t operand_delay =
+            delays[operand_index - from_index] + NodeDelay(i);
+        if (operand_delay > delay) {
+          delay = operand_delay;
+          critical_operand = operand_index;
+        }
+      }
+    }
+    if (critical_operands != nullptr) {
+      (*critical_operands)[i - from_index] = critical_operand;
+    }
+  }
+  return delays.back();
+}
+
 absl::StatusOr<int64_t> DelayManager::GetNodeDelay(Node *node) const {
   if (node->function_base() != function_) {
     return absl::InvalidArgumentError("invalid node");
   }
-  int64_t node_index = node_to_index_.at(node);
-  return indices_to_delay_[node_index][node_index];
+  return NodeDelay(node_to_index_.at(node));
 }
 
 absl::StatusOr<int64_t> DelayManager::GetCriticalPathDelay(Node *from,
@@ -80,7 +133,14 @@ absl::StatusOr<int64_t> DelayManager::GetCriticalPathDelay(Node *from,
   }
   int64_t from_index = node_to_index_.at(from);
   int64_t to_index = node_to_index_.at(to);
-  return indices_to_delay_[from_index][to_index];
+  const Entry *entry = FindEntry(from_index, to_index);
+  if (entry != nullptr && entry->exact) {
+    return entry->delay;
+  }
+  if (!max_tracked_delay_.has_value()) {
+    return -1;
+  }
+  return ComputeCriticalPathDelay(from_index, to_index);
 }
 
 absl::Status DelayManager::SetCriticalPathDelay(Node *from, Node *to,
@@ -91,10 +151,36 @@ absl::Status DelayManager::SetCriticalPathDelay(Node *from, Node *to,
   }
   int64_t from_index = node_to_index_.at(from);
   int64_t to_index = node_to_index_.at(to);
-  int64_t &current_delay = indices_to_delay_[from_index][to_index];
+  std::vector<Entry> &paths = paths_to_[to_index];
+  auto it = absl::c_lower_bound(paths, from_index,
+                                [](const Entry &entry, int64_t source) {
+                                  return entry.source < source;
+                                });
+  if (it != paths.end() && it->source == from_index) {
+    if (!if_shorter || it->delay > delay) {
+      if (!if_exist || it->delay != -1) {
+        it->delay = delay;
+        it->exact = true;
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // The pair is either not connected or beyond the tracking horizon.
+  int64_t current_delay = -1;
+  std::vector<int64_t> critical_operands;
+  if (max_tracked_delay_.has_value()) {
+    current_delay =
+        ComputeCriticalPathDelay(from_index, to_index, &critical_operands);
+  }
   if (!if_shorter || current_delay > delay) {
     if (!if_exist || current_delay != -1) {
-      current_delay = delay;
+      paths.insert(
+          it, Entry{.source = static_cast<int32_t>(from_index),
+                    .critical_operand = static_cast<int32_t>(
+                        critical_operands.empty() ? -1
+                                                  : critical_operands.back()),
+                    .delay = delay});
     }
   }
   return absl::OkStatus();
@@ -104,89 +190,183 @@ absl::StatusOr<std::vector<Node *>> DelayManager::GetFullCriticalPath(
     Node *from, Node *to) const {
   int64_t from_index = node_to_index_.at(from);
   int64_t to_index = node_to_index_.at(to);
-  std::vector<Node *> critical_path;
 
-  Node *critical_operand = indices_to_critical_operand_[from_index][to_index];
+  // Critical operands of the nodes between `from` and `to`, computed if the
+  // path leaves the stored ones.
+  std::optional<std::vector<int64_t>> computed_critical_operands;
+  auto get_critical_operand = [&](int64_t index) -> int64_t {
+    if (const Entry *entry = FindEntry(from_index, index);
+        entry != nullptr && entry->exact) {
+      return entry->critical_operand;
+    }
+    if (!max_tracked_delay_.has_value()) {
+      return -1;
+    }
+    if (!computed_critical_operands.has_value()) {
+      computed_critical_operands.emplace();
+      ComputeCriticalPathDelay(from_index, to_index,
+                               &*computed_critical_operands);
+    }
+    if (index < from_index ||
+        index - from_index >= computed_critical_operands->size()) {
+      return -1;
+    }
+    return (*computed_critical_operands)[index - from_index];
+  };
+
+  std::vector<Node *> critical_path;
+  int64_t critical_operand = get_critical_operand(to_index);
   critical_path.push_back(to);
-  while (critical_operand != nullptr && critical_operand != from) {
-    critical_path.push_back(critical_operand);
-    int64_t critical_operand_index = node_to_index_.at(critical_operand);
-    critical_operand =
-        indices_to_critical_operand_[from_index][critical_operand_index];
+  while (critical_operand != -1 && critical_operand != from_index) {
+    critical_path.push_back(index_to_node_[critical_operand]);
+    critical_operand = get_critical_operand(critical_operand);
   }
-  XLS_RET_CHECK(critical_operand == from);
+  XLS_RET_CHECK(critical_operand == from_index);
   critical_path.push_back(from);
   std::reverse(critical_path.begin(), critical_path.end());
   return critical_path;
 }
 
 void DelayManager::PropagateDelays() {
-  // Traverse the function in a reversed topological order.
-  for (Node *node : ReverseTopoSort(function_)) {
-    int64_t node_index = node_to_index_[node];
-    int64_t node_delay = indices_to_delay_[node_index][node_index];
-    std::vector<int64_t> new_delays(function_->node_count(), -1);
-
-    // Compute the critical-path distance from `a` to `node` for all nodes `a`
-    // from the delays of `a` to each operand of `node`.
-    for (Node *user : node->users()) {
-      int64_t user_index = node_to_index_[user];
-      for (int64_t i = 0; i < function_->node_count(); ++i) {
-        int64_t from_user_delay = indices_to_delay_[user_index][i];
-        if (from_user_delay != -1) {
+  // Traverse the sources of each target in a reversed topological order,
+  // computing the critical-path distance from each source to the target from
+  // the distances of its users.
+  for (int64_t target = 0; target < paths_to_.size(); ++target) {
+    std::vector<Entry> &paths = paths_to_[target];
+    for (int64_t i = static_cast<int64_t>(paths.size()) - 1; i >= 0; --i) {
+      Entry &entry = paths[i];
+      // Only nodes preceding the target have users on a path to it.
+      if (entry.source >= target) {
+        continue;
+      }
+      int64_t node_delay = NodeDelay(entry.source);
+      int64_t new_delay = -1;
+      for (Node *user : index_to_node_[entry.source]->users()) {
+        int64_t user_index = node_to_index_.at(user);
+        auto it = std::lower_bound(paths.begin() + i + 1, paths.end(),
+                                   user_index,
+                                   [](const Entry &other, int64_t source) {
+                                     return other.source < source;
+                                   });
+        if (it != paths.end() && it->source == user_index) {
           // Always pick the critical path.
-          if (new_delays[i] < from_user_delay + node_delay) {
-            new_delays[i] = from_user_delay + node_delay;
-          }
+          new_delay = std::max(new_delay, it->delay + node_delay);
         }
       }
+      // Update the original delay if the newly calculated delay is smaller.
+      if (new_delay != -1 && entry.delay >= new_delay) {
+        entry.delay = new_delay;
+      }
     }
+  }
 
-    // Update the original delay if the newly calculated delay is smaller.
-    for (int64_t i = 0; i < function_->node_count(); ++i) {
-      if (new_delays[i] != -1) {
-        int64_t &current_delay = indices_to_delay_[node_index][i];
-        if (current_delay >= new_delays[i] || current_delay == -1) {
-          current_delay = new_delays[i];
-        }
+  // The latest arrival time of each node from the start of the function,
+  // which bounds the delay of any path ending at it.
+  std::vector<int64_t> arrivals(index_to_node_.size(), 0);
+  if (max_tracked_delay_.has_value()) {
+    for (int64_t index = 0; index < index_to_node_.size(); ++index) {
+      for (Node *operand : index_to_node_[index]->operands()) {
+        arrivals[index] =
+            std::max(arrivals[index], arrivals[node_to_index_.at(operand)]);
       }
+      arrivals[index] += NodeDelay(index);
     }
   }
 
-  // Traverse the function in a topological order.
-  for (Node *node : TopoSort(function_)) {
-    int64_t node_index = node_to_index_[node];
-    int64_t node_delay = indices_to_delay_[node_index][node_index];
-    std::vector<int64_t> new_delays(function_->node_count(), -1);
-    std::vector<Node *> new_critical_operands(function_->node_count(), nullptr);
-
-    // Compute the critical-path distance from `a` to `node` for all nodes `a`
-    // from the delays of `a` to each operand of `node`.
+  // Traverse the function in a topological order, computing the
+  // critical-path distance from `a` to `node` for all nodes `a` from the
+  // delays of `a` to each operand of `node`.
+  std::vector<int64_t> new_delays(index_to_node_.size(), -1);
+  std::vector<int32_t> new_critical_operands(index_to_node_.size(), -1);
+  std::vector<bool> new_exact(index_to_node_.size(), true);
+  std::vector<int32_t> sources;
+  for (int64_t index = 0; index < index_to_node_.size(); ++index) {
+    Node *node = index_to_node_[index];
+    int64_t node_delay = NodeDelay(index);
     for (Node *operand : node->operands()) {
-      int64_t operand_index = node_to_index_[operand];
-      for (int64_t i = 0; i < function_->node_count(); ++i) {
-        int64_t to_operand_delay = indices_to_delay_[i][operand_index];
-        if (to_operand_delay != -1) {
-          // Always pick the critical path.
-          if (new_delays[i] < to_operand_delay + node_delay) {
-            new_delays[i] = to_operand_delay + node_delay;
-            new_critical_operands[i] = operand;
+      int64_t operand_index = node_to_index_.at(operand);
+      for (const Entry &entry : paths_to_[operand_index]) {
+        if (entry.delay == -1 || !IsTracked(entry.delay)) {
+          continue;
+        }
+        int64_t &new_delay = new_delays[entry.source];
+        if (new_delay == -1) {
+          sources.push_back(entry.source);
+        }
+        // Always pick the critical path.
+        if (new_delay < entry.delay + node_delay) {
+          new_delay = entry.delay + node_delay;
+          new_critical_operands[entry.source] = operand_index;
+        }
+      }
+    }
+    if (sources.empty()) {
+      continue;
+    }
+
+    // With a horizon, a source may also reach the node through an operand
+    // whose path from the source is not stored, which is then longer than the
+    // horizon. The delay is exact if none can, either because the arrival
+    // times bound the path within the horizon or because every operand the
+    // source can reach has an exact path from it.
+    if (max_tracked_delay_.has_value()) {
+      for (int32_t source : sources) {
+        if (arrivals[index] - arrivals[source] + NodeDelay(source) -
+                node_delay <=
+            *max_tracked_delay_) {
+          continue;
+        }
+        for (Node *operand : node->operands()) {
+          int64_t operand_index = node_to_index_.at(operand);
+          if (operand_index < source) {
+            continue;
+          }
+          const Entry *entry = FindEntry(source, operand_index);
+          if (entry == nullptr) {
+            new_exact[source] = false;
+          } else if (!IsTracked(entry->delay)) {
+            // The source reaches the node through a path past the horizon.
+            new_delays[source] = -1;
+            break;
+          } else if (!entry->exact) {
+            new_exact[source] = false;
           }
         }
       }
     }
 
     // Update the original delay if the newly calculated delay is smaller.
-    for (int64_t i = 0; i < function_->node_count(); ++i) {
-      if (new_delays[i] != -1) {
-        int64_t &current_delay = indices_to_delay_[i][node_index];
-        if (current_delay >= new_delays[i] || current_delay == -1) {
-          current_delay = new_delays[i];
-          indices_to_critical_operand_[i][node_index] =
-              new_critical_operands[i];
-        }
+    std::vector<Entry> &paths = paths_to_[index];
+    bool added = false;
+    for (Entry &entry : paths) {
+      int64_t &new_delay = new_delays[entry.source];
+      if (new_delay == -1) {
+        continue;
+      }
+      if (entry.delay >= new_delay || entry.delay == -1) {
+        entry.delay = new_delay;
+        entry.critical_operand = new_critical_operands[entry.source];
+        entry.exact = new_exact[entry.source];
       }
+      new_delay = -1;
+    }
+    for (int32_t source : sources) {
+      if (new_delays[source] != -1) {
+        paths.push_back(Entry{.source = source,
+                              .critical_operand = new_critical_operands[source],
+                              .delay = new_delays[source],
+                              .exact = new_exact[source]});
+        new_delays[source] = -1;
+        added = true;
+      }
+      new_exact[source] = true;
+    }
+    if (added) {
+      absl::c_sort(paths, [](const Entry &a, const Entry &b) {
+        return a.source < b.source;
+      });
     }
+    sources.clear();
   }
 }
 
@@ -196,12 +376,11 @@ DelayManager::GetPathsOverDelayThreshold(int64_t delay_threshold) const {
   if (delay_threshold < 0) {
     return paths;
   }
-  for (int64_t i = 0; i < function_->node_count(); ++i) {
-    Node *from = index_to_node_[i];
-    for (int64_t j = 0; j < function_->node_count(); ++j) {
-      Node *to = index_to_node_[j];
-      if (indices_to_delay_[i][j] > delay_threshold) {
-        paths[from].push_back(to);
+  for (int64_t j = 0; j < index_to_node_.size(); ++j) {
+    Node *to = index_to_node_[j];
+    for (const Entry &entry : paths_to_[j]) {
+      if (entry.delay > delay_threshold) {
+        paths[index_to_node_[entry.source]].push_back(to);
       }
     }
   }
@@ -220,13 +399,12 @@ absl::StatusOr<std::vector<PathInfo>> DelayManager::GetTopNPaths(
   // Traverse all nodes in the function and construct a worklist with score of
   // each path.
   std::vector<std::tuple<float, int64_t, Node *, Node *>> worklist;
-  for (int64_t i = 0; i < function_->node_count(); ++i) {
-    Node *from = index_to_node_[i];
-    for (int64_t j = 0; j < function_->node_count(); ++j) {
-      Node *to = index_to_node_[j];
-      int64_t delay = indices_to_delay_[i][j];
+  for (int64_t j = 0; j < index_to_node_.size(); ++j) {
+    Node *to = index_to_node_[j];
+    for (const Entry &entry : paths_to_[j]) {
+      Node *from = index_to_node_[entry.source];
 
-      if (delay < 0) {
+      if (entry.delay < 0) {
         continue;
       }
       if (options.exclude_single_node_path && from == to) {
@@ -274,6 +452,9 @@ absl::StatusOr<std::vector<PathInfo>> DelayManager::GetTopNPaths(
         }
       }
 
+      int64_t delay = entry.exact
+                          ? entry.delay
+                          : ComputeCriticalPathDelay(entry.source, j);
       worklist.emplace_back(score(from, to), delay, from, to);
     }
   }
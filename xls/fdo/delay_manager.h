@@ -16,6 +16,7 @@
 #define XLS_FDO_DELAY_MANAGER_H_
 
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -72,10 +73,19 @@ struct PathExtractOptions {
 // or proc. It allows users to update the delay between a certain pair of nodes,
 // re-calculate the critical delay of all pairs of nodes, extract paths longer
 // than a threshold, extract top-N longest paths, etc.
+//
+// Delays are stored sparsely, only for pairs of nodes connected by a path. If
+// `max_tracked_delay` is given then, to bound memory on large functions, the
+// delay from a source to a target is only stored while the path up to (but
+// excluding) the target is no longer than `max_tracked_delay`, so every stored
+// path ends at most one node past the horizon. The delays of other pairs are
+// computed on demand from the stored ones and the node delays, and such pairs
+// are not considered when extracting paths.
 class DelayManager {
  public:
-  explicit DelayManager(FunctionBase *function,
-                        const DelayEstimator &delay_estimator);
+  explicit DelayManager(
+      FunctionBase *function, const DelayEstimator &delay_estimator,
+      std::optional<int64_t> max_tracked_delay = std::nullopt);
 
   absl::StatusOr<int64_t> GetNodeDelay(Node *node) const;
 
@@ -104,6 +114,11 @@ class DelayManager {
   void PropagateDelays();
 
   // Get all the paths whose delay is longer than the given delay threshold.
+  //
+  // If delays are tracked up to a horizon at least `delay_threshold`, the paths
+  // which only go over the threshold at their last node are all returned. Any
+  // other path over the threshold contains one of them, which suffices for
+  // deriving timing constraints.
   absl::flat_hash_map<Node *, std::vector<Node *>> GetPathsOverDelayThreshold(
       int64_t delay_threshold) const;
 
@@ -133,22 +148,59 @@ class DelayManager {
   static float GetZeroScore(Node *from, Node *to) { return 0.0; }
   static bool GetFalse(Node *from, Node *to) { return false; }
 
+  // The delay of the critical path from `source` to a target node. The
+  // critical operand is the operand of the target on the critical path, or -1
+  // if the source is the target. Node indices are topological. Beyond the
+  // tracking horizon a path may reach the target through nodes whose paths are
+  // not stored, in which case the delay is only a lower bound and is not
+  // `exact`.
+  struct Entry {
+    int32_t source;
+    int32_t critical_operand;
+    int64_t delay;
+    bool exact = true;
+  };
+
+  // Returns the entry of the path from `from_index` to `to_index` if it is
+  // stored.
+  const Entry *FindEntry(int64_t from_index, int64_t to_index) const;
+
+  // Computes the critical path delay between the given nodes from the exact
+  // stored delays and the node delays, for pairs with no exact entry. If
+  // `critical_operands` is given it receives the critical operand of each node
+  // between the two, indexed by the node index minus `from_index`.
+  int64_t ComputeCriticalPathDelay(
+      int64_t from_index, int64_t to_index,
+      std::vector<int64_t> *critical_operands = nullptr) const;
+
+  // The delay of the node with the given index, stored as the delay of the
+  // path from the node to itself.
+  int64_t NodeDelay(int64_t index) const {
+    return FindEntry(index, index)->delay;
+  }
+
+  // Whether a path is stored given its delay excluding the target.
+  bool IsTracked(int64_t delay_before_target) const {
+    return !max_tracked_delay_.has_value() ||
+           delay_before_target <= *max_tracked_delay_;
+  }
+
   FunctionBase *function_;
+  std::optional<int64_t> max_tracked_delay_;
 
   // A mapping from a node to its index in the function.
   absl::flat_hash_map<Node *, int64_t> node_to_index_;
 
-  // A mapping from a node index to the corresponding node.
+  // A mapping from a node index to the corresponding node, in topological
+  // order.
   std::vector<Node *> index_to_node_;
 
-  // An all-to-all delay mapping. The self-to-self delay of a node is defined as
-  // the delay of itself. If there is no valid path exists, the delay is defined
-  // as -1. Both the source and target node delays are counted.
-  std::vector<std::vector<int64_t>> indices_to_delay_;
-
-  // A all-to-all mapping from the source and target node indices to the
-  // critical operand of the target node.
-  std::vector<std::vector<Node *>> indices_to_critical_operand_;
+  // For each target node, the critical paths to it from the nodes which reach
+  // it, sorted by source index. The self-to-self delay of a node is defined as
+  // the delay of itself and both the source and target node delays are
+  // counted. Pairs without an entry have no path (-1) unless they are beyond
+  // the tracking horizon.
+  std::vector<std::vector<Entry>> paths_to_;
 
   // Name of the delay estimator.
   const std::string name_;
@@ -176,5 +176,53 @@ fn main(i0: bits[3], i1: bits[3]) -> bits[3] {
   EXPECT_EQ(new_udiv3_i0_delay, -1);
 }
 
+TEST_F(DelayManagerTest, MaxTrackedDelay) {
+  std::string ir_text = R"(
+package p
+
+fn main(x: bits[8]) -> bits[8] {
+  add.1: bits[8] = add(x, x)
+  add.2: bits[8] = add(add.1, x)
+  add.3: bits[8] = add(add.2, x)
+  add.4: bits[8] = add(add.3, x)
+  add.5: bits[8] = add(add.4, x)
+  ret add.6: bits[8] = add(add.5, x)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, package->GetFunction("main"));
+  Node *x = FindNode("x", function);
+  Node *add3 = FindNode("add.3", function);
+  Node *add6 = FindNode("add.6", function);
+
+  DelayManager exact(function, TestDelayEstimator());
+  DelayManager bounded(function, TestDelayEstimator(),
+                       /*max_tracked_delay=*/2);
+
+  // Delays beyond the horizon are computed on demand.
+  for (Node *from : function->nodes()) {
+    for (Node *to : function->nodes()) {
+      XLS_ASSERT_OK_AND_ASSIGN(int64_t exact_delay,
+                               exact.GetCriticalPathDelay(from, to));
+      XLS_ASSERT_OK_AND_ASSIGN(int64_t bounded_delay,
+                               bounded.GetCriticalPathDelay(from, to));
+      EXPECT_EQ(exact_delay, bounded_delay)
+          << from->GetName() << " -> " << to->GetName();
+    }
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<Node *> path,
+                           bounded.GetFullCriticalPath(x, add6));
+  EXPECT_EQ(path.size(), 7);
+  EXPECT_EQ(path.front(), x);
+  EXPECT_EQ(path.back(), add6);
+
+  // Only the paths which cross the threshold at their last node are returned
+  // when the threshold is the horizon.
+  EXPECT_EQ(exact.GetPathsOverDelayThreshold(2).at(x).size(), 4);
+  EXPECT_EQ(bounded.GetPathsOverDelayThreshold(2).at(x),
+            std::vector<Node *>({add3}));
+}
+
 }  // namespace
 }  // namespace xls
@@ -28,6 +28,7 @@
 #include "xls/estimators/delay_model/analyze_critical_path.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/fdo/synthesizer.h"
+#include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
 #include "xls/scheduling/extract_stage.h"
@@ -77,6 +78,25 @@ std::string SynthesizedDelayDiffToStringHeader(
                          diff.synthesized_delay_ps - diff.xls_delay_ps);
 }
 
+// Creates a delay diff for a stage already extracted into `stage_function`.
+absl::StatusOr<SynthesizedDelayDiff> CreateDelayDiffForStageFunction(
+    Function* stage_function, const DelayEstimator& delay_estimator,
+    synthesis::Synthesizer* synthesizer) {
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<CriticalPathEntry> critical_path,
+      AnalyzeCriticalPath(stage_function, /*clock_period_ps=*/std::nullopt,
+                          delay_estimator));
+  if (synthesizer) {
+    return SynthesizeAndGetDelayDiff(stage_function, std::move(critical_path),
+                                     synthesizer);
+  }
+  SynthesizedDelayDiff diff;
+  diff.xls_delay_ps =
+      critical_path.empty() ? 0 : critical_path[0].path_delay_ps;
+  diff.critical_path = std::move(critical_path);
+  return diff;
+}
+
 }  // namespace
 
 absl::StatusOr<SynthesizedDelayDiff> SynthesizeAndGetDelayDiff(
@@ -99,19 +119,8 @@ absl::StatusOr<SynthesizedDelayDiff> CreateDelayDiffForStage(
     int stage) {
   XLS_ASSIGN_OR_RETURN(Function * stage_function,
                        ExtractStage(f, schedule, stage));
-  XLS_ASSIGN_OR_RETURN(
-      std::vector<CriticalPathEntry> critical_path,
-      AnalyzeCriticalPath(stage_function, /*clock_period_ps=*/std::nullopt,
-                          delay_estimator));
-  if (synthesizer) {
-    return SynthesizeAndGetDelayDiff(stage_function, std::move(critical_path),
-                                     synthesizer);
-  }
-  SynthesizedDelayDiff diff;
-  diff.xls_delay_ps =
-      critical_path.empty() ? 0 : critical_path[0].path_delay_ps;
-  diff.critical_path = std::move(critical_path);
-  return diff;
+  return CreateDelayDiffForStageFunction(stage_function, delay_estimator,
+                                         synthesizer);
 }
 
 absl::StatusOr<SynthesizedDelayDiffByStage> CreateDelayDiffByStage(
@@ -121,10 +130,12 @@ absl::StatusOr<SynthesizedDelayDiffByStage> CreateDelayDiffByStage(
   SynthesizedDelayDiffByStage result;
   result.stage_diffs.reserve(schedule.length());
   result.stage_percent_diffs.resize(schedule.length());
-  for (int i = 0; i < schedule.length(); ++i) {
-    XLS_ASSIGN_OR_RETURN(
-        SynthesizedDelayDiff stage_diff,
-        CreateDelayDiffForStage(f, schedule, delay_estimator, synthesizer, i));
+  XLS_ASSIGN_OR_RETURN(std::vector<Function*> stage_functions,
+                       ExtractStages(f, schedule));
+  for (Function* stage_function : stage_functions) {
+    XLS_ASSIGN_OR_RETURN(SynthesizedDelayDiff stage_diff,
+                         CreateDelayDiffForStageFunction(
+                             stage_function, delay_estimator, synthesizer));
     result.total_diff.synthesized_delay_ps += stage_diff.synthesized_delay_ps;
     result.total_diff.xls_delay_ps += stage_diff.xls_delay_ps;
     result.stage_diffs.emplace_back(std::move(stage_diff));
@@ -14,6 +14,8 @@
 
 #include "xls/fdo/synthesizer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -24,10 +26,13 @@
 
 #include "absl/base/no_destructor.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/codegen/block_conversion.h"
 #include "xls/codegen/block_generator.h"
@@ -41,27 +46,65 @@
 #include "xls/ir/block.h"
 #include "xls/ir/function.h"
 #include "xls/ir/node.h"
+#include "xls/ir/topo_sort.h"
 #include "xls/scheduling/pipeline_schedule.h"
 #include "xls/scheduling/scheduling_options.h"
 
 namespace xls {
 namespace synthesis {
 
+absl::StatusOr<int64_t> SynthesizedDelayCache::GetOrSynthesize(
+    std::string_view verilog_text,
+    absl::FunctionRef<absl::StatusOr<int64_t>()> synthesize) {
+  std::shared_ptr<Entry> entry;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto [it, inserted] = entries_.try_emplace(verilog_text);
+    if (!inserted) {
+      ++hits_;
+      entry = it->second;
+      // Wait for the thread synthesizing the same text, if any.
+      mutex_.Await(absl::Condition(
+          +[](Entry *e) { return e->delay.has_value(); }, entry.get()));
+      return *entry->delay;
+    }
+    it->second = entry = std::make_shared<Entry>();
+  }
+  absl::StatusOr<int64_t> delay = synthesize();
+  absl::MutexLock lock(&mutex_);
+  entry->delay = delay;
+  if (!delay.ok()) {
+    // Later requests retry; the threads waiting on this one get the error.
+    entries_.erase(verilog_text);
+  }
+  return delay;
+}
+
+int64_t SynthesizedDelayCache::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
 absl::StatusOr<std::vector<int64_t>>
 Synthesizer::SynthesizeNodesConcurrentlyAndGetDelays(
     absl::Span<const absl::flat_hash_set<Node *>> nodes_list) const {
-  // Launches multi-threading delay estimation.
-  std::vector<absl::StatusOr<int64_t>> results;
+  // Launches a pool of workers which take the node sets in order. Repeated
+  // node sets are synthesized once through the delay cache.
+  int64_t count = nodes_list.size();
+  std::vector<absl::StatusOr<int64_t>> results(count, 0);
+  int64_t worker_count = count;
+  if (max_concurrency_ > 0) {
+    worker_count = std::min(worker_count, max_concurrency_);
+  }
+  std::atomic<int64_t> next = 0;
   std::vector<std::unique_ptr<Thread>> threads;
-  results.reserve(nodes_list.size());
-  absl::StatusOr<int64_t> init_val = 0;
-  for (const absl::flat_hash_set<Node *> &nodes : nodes_list) {
-    results.push_back(init_val);
-    absl::StatusOr<int64_t> &dest = results.back();
-    // TODO(hanchenye): 2023-08-14 Use a thread pool structure that we can
-    // schedule on.
-    threads.push_back(std::make_unique<Thread>(
-        [&]() { dest = SynthesizeNodesAndGetDelay(nodes); }));
+  threads.reserve(worker_count);
+  for (int64_t i = 0; i < worker_count; ++i) {
+    threads.push_back(std::make_unique<Thread>([&]() {
+      for (int64_t index = next++; index < count; index = next++) {
+        results[index] = SynthesizeNodesAndGetDelay(nodes_list[index]);
+      }
+    }));
   }
 
   // Records the estimated delays.
@@ -83,12 +126,20 @@ absl::StatusOr<int64_t> Synthesizer::SynthesizeNodesAndGetDelay(
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> tmp_package,
                        ExtractNodes(nodes, top_name));
   XLS_ASSIGN_OR_RETURN(Function * f, tmp_package->GetFunction(top_name));
+  // Name the nodes by their position so that the Verilog, which is the key of
+  // the delay cache, does not depend on where the nodes were extracted from.
+  int64_t position = 0;
+  for (Node *node : TopoSort(f)) {
+    node->SetName(absl::StrCat("n", position++));
+  }
   XLS_ASSIGN_OR_RETURN(std::string verilog_text,
                        FunctionBaseToVerilog(f, /*flop_inputs_outputs=*/true));
   if (verilog_text.empty()) {
     return 0;
   }
-  return SynthesizeVerilogAndGetDelay(verilog_text, top_name);
+  return delay_cache_->GetOrSynthesize(verilog_text, [&]() {
+    return SynthesizeVerilogAndGetDelay(verilog_text, top_name);
+  });
 }
 
 absl::StatusOr<int64_t> Synthesizer::SynthesizeFunctionBaseAndGetDelay(
@@ -98,7 +149,9 @@ absl::StatusOr<int64_t> Synthesizer::SynthesizeFunctionBaseAndGetDelay(
   if (verilog_text.empty()) {
     return 0;
   }
-  return SynthesizeVerilogAndGetDelay(verilog_text, f->name());
+  return delay_cache_->GetOrSynthesize(verilog_text, [&]() {
+    return SynthesizeVerilogAndGetDelay(verilog_text, f->name());
+  });
 }
 
 absl::StatusOr<std::string> Synthesizer::FunctionBaseToVerilog(
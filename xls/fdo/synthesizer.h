@@ -17,16 +17,20 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
@@ -35,10 +39,36 @@
 namespace xls {
 namespace synthesis {
 
+// A thread-safe cache of synthesized delays keyed by the synthesized Verilog
+// text. Concurrent requests for the same text wait for a single synthesis.
+// Failed syntheses are not cached.
+class SynthesizedDelayCache {
+ public:
+  // Returns the cached delay of `verilog_text`, calling `synthesize` to
+  // compute it if it is neither cached nor being computed by another thread.
+  absl::StatusOr<int64_t> GetOrSynthesize(
+      std::string_view verilog_text,
+      absl::FunctionRef<absl::StatusOr<int64_t>()> synthesize);
+
+  // Returns the number of requests answered without calling `synthesize`.
+  int64_t hits() const;
+
+ private:
+  struct Entry {
+    std::optional<absl::StatusOr<int64_t>> delay;
+  };
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::shared_ptr<Entry>> entries_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
 // An abstract class of a synthesis service.
 class Synthesizer {
  public:
-  explicit Synthesizer(std::string_view name) : name_(name) {}
+  explicit Synthesizer(std::string_view name)
+      : name_(name), delay_cache_(std::make_shared<SynthesizedDelayCache>()) {}
   virtual ~Synthesizer() = default;
 
   const std::string &name() const { return name_; }
@@ -71,14 +101,33 @@ class Synthesizer {
       FunctionBase *f, bool flop_inputs_outputs) const;
 
   // Launches `SynthesizeNodesAndGetDelay` concurrently for each set of nodes
-  // listed in `nodes_list` and get their delays.
+  // listed in `nodes_list` and get their delays. At most `max_concurrency()`
+  // sets are synthesized at once.
   absl::StatusOr<std::vector<int64_t>> SynthesizeNodesConcurrentlyAndGetDelays(
       absl::Span<const absl::flat_hash_set<Node *>> nodes_list) const;
 
+  // Sets/gets the maximum number of concurrent syntheses launched by
+  // `SynthesizeNodesConcurrentlyAndGetDelays`. Zero means no limit.
+  void set_max_concurrency(int64_t value) { max_concurrency_ = value; }
+  int64_t max_concurrency() const { return max_concurrency_; }
+
+  // Sets/gets the cache through which all syntheses of this synthesizer go.
+  // Extracted node sets are given names which only depend on their structure,
+  // so identical node sets hit the cache across scheduler iterations and, if
+  // the cache is shared between synthesizers, across designs. Each
+  // synthesizer starts out with a cache of its own.
+  void set_delay_cache(std::shared_ptr<SynthesizedDelayCache> cache) {
+    delay_cache_ = std::move(cache);
+  }
+  SynthesizedDelayCache &delay_cache() const { return *delay_cache_; }
+
  private:
   // Records the name of the concreate synthesizer, e.g., yosys, for management
   // and debugging purpose.
   std::string name_;
+
+  int64_t max_concurrency_ = 0;
+  std::shared_ptr<SynthesizedDelayCache> delay_cache_;
 };
 
 // An abstract class of a synthesis service.
@@ -14,12 +14,16 @@
 
 #include "xls/fdo/synthesizer.h"
 
+#include <atomic>
 #include <cstdint>
 #include <filesystem>  // NOLINT
+#include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/golden_files.h"
@@ -118,5 +122,64 @@ fn test(i0: bits[3], i1: bits[3]) -> (bits[3], bits[3]) {
   ExpectEqualToGoldenFile(GoldenFilePath("vtxt"), actual_verilog_text);
 }
 
+// A synthesizer which counts its syntheses.
+class CountingSynthesizer : public synthesis::Synthesizer {
+ public:
+  CountingSynthesizer() : synthesis::Synthesizer("CountingSynthesizer") {}
+
+  absl::StatusOr<int64_t> SynthesizeVerilogAndGetDelay(
+      std::string_view verilog_text,
+      std::string_view top_module_name) const override {
+    ++syntheses_;
+    return verilog_text.size();
+  }
+
+  int64_t syntheses() const { return syntheses_; }
+
+ private:
+  mutable std::atomic<int64_t> syntheses_ = 0;
+};
+
+TEST_F(SynthesizerTest, IdenticalNodeSetsAreSynthesizedOnce) {
+  const std::string ir_text = R"(
+package p
+
+fn test(i0: bits[3], i1: bits[3], i2: bits[3], i3: bits[3]) -> bits[3] {
+  add.5: bits[3] = add(i0, i1, id=5)
+  add.6: bits[3] = add(i2, i3, id=6)
+  sub.7: bits[3] = sub(add.5, add.6, id=7)
+  ret umul.8: bits[3] = umul(sub.7, i0, id=8)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, package->GetFunction("test"));
+  XLS_ASSERT_OK_AND_ASSIGN(Node * add5, function->GetNode("add.5"));
+  XLS_ASSERT_OK_AND_ASSIGN(Node * add6, function->GetNode("add.6"));
+  XLS_ASSERT_OK_AND_ASSIGN(Node * umul8, function->GetNode("umul.8"));
+
+  auto cache = std::make_shared<synthesis::SynthesizedDelayCache>();
+  CountingSynthesizer synthesizer;
+  synthesizer.set_delay_cache(cache);
+  synthesizer.set_max_concurrency(2);
+  std::vector<absl::flat_hash_set<Node*>> nodes_list = {
+      {add5}, {add6}, {umul8}, {add5}, {add6}};
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> delays,
+      synthesizer.SynthesizeNodesConcurrentlyAndGetDelays(nodes_list));
+  ASSERT_EQ(delays.size(), 5);
+  EXPECT_EQ(delays[0], delays[1]);
+  EXPECT_EQ(delays[0], delays[3]);
+  EXPECT_EQ(delays[0], delays[4]);
+  EXPECT_EQ(synthesizer.syntheses(), 2);
+  EXPECT_EQ(cache->hits(), 3);
+
+  // A shared cache carries the delays over to another synthesizer.
+  CountingSynthesizer other;
+  other.set_delay_cache(cache);
+  XLS_ASSERT_OK(other.SynthesizeNodesAndGetDelay({add6}).status());
+  EXPECT_EQ(other.syntheses(), 0);
+}
+
 }  // namespace
 }  // namespace xls
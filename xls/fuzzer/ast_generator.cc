@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
@@ -2431,24 +2432,106 @@ int OpProbability(OpChoice op) {
   LOG(FATAL) << "Invalid op choice: " << static_cast<int64_t>(op);
 }
 
-absl::discrete_distribution<int>& GetOpDistribution(bool generate_proc) {
-  auto dist = [&](bool generate_proc) {
-    static const std::set<int> proc_ops = {int{kChannelOp}, int{kJoinOp}};
-    std::vector<int> tmp;
-    tmp.reserve(int{kEndSentinel});
-    for (int i = 0; i < int{kEndSentinel}; ++i) {
-      // When not generating a proc, do not generate proc operations by setting
-      // its probability to zero.
-      if (!generate_proc && proc_ops.find(i) != proc_ops.end()) {
-        tmp.push_back(0);
-        continue;
-      }
-      tmp.push_back(OpProbability(static_cast<OpChoice>(i)));
+// Returns the name of the given op choice, as used for
+// `AstGeneratorOptions::expr_kind_weights`.
+std::string_view OpChoiceName(OpChoice op) {
+  switch (op) {
+    case kArray:
+      return "array";
+    case kArrayIndex:
+      return "array_index";
+    case kArrayUpdate:
+      return "array_update";
+    case kArraySlice:
+      return "array_slice";
+    case kBinop:
+      return "binop";
+    case kBitSlice:
+      return "bit_slice";
+    case kBitSliceUpdate:
+      return "bit_slice_update";
+    case kBitwiseReduction:
+      return "bitwise_reduction";
+    case kCastToBitsArray:
+      return "cast_to_bits_array";
+    case kChannelOp:
+      return "channel_op";
+    case kCompareOp:
+      return "compare";
+    case kCompareArrayOp:
+      return "compare_array";
+    case kCompareTupleOp:
+      return "compare_tuple";
+    case kMatchOp:
+      return "match";
+    case kConcat:
+      return "concat";
+    case kCountedFor:
+      return "counted_for";
+    case kGate:
+      return "gate";
+    case kInvoke:
+      return "invoke";
+    case kJoinOp:
+      return "join";
+    case kLogical:
+      return "logical";
+    case kMap:
+      return "map";
+    case kNumber:
+      return "number";
+    case kOneHotSelectBuiltin:
+      return "one_hot_select";
+    case kPartialProduct:
+      return "partial_product";
+    case kPrioritySelectBuiltin:
+      return "priority_select";
+    case kSignExtendBuiltin:
+      return "sign_extend";
+    case kShiftOp:
+      return "shift";
+    case kTupleOrIndex:
+      return "tuple_or_index";
+    case kUnop:
+      return "unop";
+    case kUnopBuiltin:
+      return "unop_builtin";
+    case kEndSentinel:
+      break;
+  }
+  LOG(FATAL) << "Invalid op choice: " << static_cast<int64_t>(op);
+}
+
+absl::discrete_distribution<int> MakeOpDistribution(
+    bool generate_proc,
+    const absl::flat_hash_map<std::string, double>& weights) {
+  static const std::set<int> proc_ops = {int{kChannelOp}, int{kJoinOp}};
+  std::vector<double> tmp;
+  tmp.reserve(int{kEndSentinel});
+  for (int i = 0; i < int{kEndSentinel}; ++i) {
+    // When not generating a proc, do not generate proc operations by setting
+    // its probability to zero.
+    if (!generate_proc && proc_ops.find(i) != proc_ops.end()) {
+      tmp.push_back(0);
+      continue;
     }
-    return new absl::discrete_distribution<int>(tmp.begin(), tmp.end());
-  };
-  static absl::discrete_distribution<int>& func_dist = *dist(false);
-  static absl::discrete_distribution<int>& proc_dist = *dist(true);
+    double probability = OpProbability(static_cast<OpChoice>(i));
+    if (auto it = weights.find(OpChoiceName(static_cast<OpChoice>(i)));
+        it != weights.end()) {
+      probability *= it->second;
+    }
+    tmp.push_back(probability);
+  }
+  return absl::discrete_distribution<int>(tmp.begin(), tmp.end());
+}
+
+absl::discrete_distribution<int>& GetOpDistribution(bool generate_proc) {
+  static absl::discrete_distribution<int>& func_dist =
+      *new absl::discrete_distribution<int>(
+          MakeOpDistribution(/*generate_proc=*/false, {}));
+  static absl::discrete_distribution<int>& proc_dist =
+      *new absl::discrete_distribution<int>(
+          MakeOpDistribution(/*generate_proc=*/true, {}));
   if (generate_proc) {
     return proc_dist;
   }
@@ -2465,7 +2548,12 @@ absl::StatusOr<TypedExpr> AstGenerator::GenerateExpr(int64_t call_depth,
                                                      Context* ctx) {
   absl::StatusOr<TypedExpr> generated = RecoverableError("Not yet generated.");
   while (IsRecoverableError(generated.status())) {
-    switch (ChooseOp(bit_gen_, ctx->is_generating_proc)) {
+    std::optional<absl::discrete_distribution<int>>& weighted_kinds =
+        ctx->is_generating_proc ? proc_expr_kinds_ : function_expr_kinds_;
+    OpChoice op = weighted_kinds.has_value()
+                      ? static_cast<OpChoice>((*weighted_kinds)(bit_gen_))
+                      : ChooseOp(bit_gen_, ctx->is_generating_proc);
+    switch (op) {
       case kArray:
         generated = GenerateArray(ctx);
         break;
@@ -3087,6 +3175,22 @@ AstGenerator::AstGenerator(AstGeneratorOptions options, absl::BitGenRef bit_gen,
       options_(options),
       file_table_(file_table),
       fake_pos_(Fileno(0), 0, 0),
-      fake_span_(fake_pos_, fake_pos_) {}
+      fake_span_(fake_pos_, fake_pos_) {
+  if (!options_.expr_kind_weights.empty()) {
+    function_expr_kinds_ = MakeOpDistribution(/*generate_proc=*/false,
+                                              options_.expr_kind_weights);
+    proc_expr_kinds_ = MakeOpDistribution(/*generate_proc=*/true,
+                                          options_.expr_kind_weights);
+  }
+}
+
+std::vector<std::string> GetExprKindNames() {
+  std::vector<std::string> names;
+  names.reserve(int{kEndSentinel});
+  for (int i = 0; i < int{kEndSentinel}; ++i) {
+    names.push_back(std::string(OpChoiceName(static_cast<OpChoice>(i))));
+  }
+  return names;
+}
 
 }  // namespace xls::dslx
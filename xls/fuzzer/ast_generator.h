@@ -30,6 +30,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/random/bit_gen_ref.h"
+#include "absl/random/discrete_distribution.h"
 #include "absl/random/distributions.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -120,6 +121,13 @@ struct AstGeneratorOptions {
   // true.
   bool emit_zero_width_bits_types = false;
 
+  // Multipliers for the relative probability of generating each kind of
+  // expression, keyed by the names returned by GetExprKindNames(); kinds which
+  // are not present are generated with their usual probability. These are set
+  // at run time to steer generation (e.g. by a CoverageTracker) and are not
+  // part of AstGeneratorOptionsProto.
+  absl::flat_hash_map<std::string, double> expr_kind_weights;
+
   static absl::StatusOr<AstGeneratorOptions> FromProto(
       const AstGeneratorOptionsProto& proto);
   AstGeneratorOptionsProto ToProto() const;
@@ -133,6 +141,10 @@ bool AbslParseFlag(std::string_view text,
                    std::string* error);
 std::string AbslUnparseFlag(const AstGeneratorOptions& ast_generator_options);
 
+// Returns the names of the kinds of expression the AST generator chooses
+// between, as used to key `AstGeneratorOptions::expr_kind_weights`.
+std::vector<std::string> GetExprKindNames();
+
 // Type that generates a random module for use in fuzz testing; i.e.
 //
 //    std::mt19937_64 rng;
@@ -720,6 +732,11 @@ class AstGenerator {
 
   const AstGeneratorOptions options_;
 
+  // Distributions over the kinds of expression to generate in functions and
+  // procs respectively, when `options_.expr_kind_weights` is non-empty.
+  std::optional<absl::discrete_distribution<int>> function_expr_kinds_;
+  std::optional<absl::discrete_distribution<int>> proc_expr_kinds_;
+
   FileTable& file_table_;
 
   const Pos fake_pos_;
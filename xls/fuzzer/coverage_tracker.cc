@@ -0,0 +1,174 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/fuzzer/coverage_tracker.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/math_util.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/type.h"
+
+namespace xls {
+namespace {
+
+// The IR ops each kind of expression generated by the AST generator is
+// expected to produce. Kinds without a distinctive op are left out and so
+// never reweighted.
+const absl::flat_hash_map<std::string_view, std::vector<Op>>&
+GetExprKindOps() {
+  static const auto* kExprKindOps =
+      new absl::flat_hash_map<std::string_view, std::vector<Op>>({
+          {"array", {Op::kArray}},
+          {"array_index", {Op::kArrayIndex}},
+          {"array_update", {Op::kArrayUpdate}},
+          {"array_slice", {Op::kArraySlice}},
+          {"binop",
+           {Op::kAdd, Op::kSub, Op::kUMul, Op::kSMul, Op::kUDiv, Op::kSDiv,
+            Op::kUMod, Op::kSMod}},
+          {"bit_slice", {Op::kBitSlice, Op::kDynamicBitSlice}},
+          {"bit_slice_update", {Op::kBitSliceUpdate}},
+          {"bitwise_reduction",
+           {Op::kAndReduce, Op::kOrReduce, Op::kXorReduce}},
+          {"channel_op", {Op::kSend, Op::kReceive}},
+          {"compare",
+           {Op::kEq, Op::kNe, Op::kULt, Op::kULe, Op::kUGt, Op::kUGe,
+            Op::kSLt, Op::kSLe, Op::kSGt, Op::kSGe}},
+          {"compare_array", {Op::kEq, Op::kNe}},
+          {"compare_tuple", {Op::kEq, Op::kNe}},
+          {"match", {Op::kSel}},
+          {"concat", {Op::kConcat}},
+          {"counted_for", {Op::kCountedFor}},
+          {"gate", {Op::kGate}},
+          {"invoke", {Op::kInvoke}},
+          {"join", {Op::kAfterAll}},
+          {"logical", {Op::kAnd, Op::kOr, Op::kXor}},
+          {"map", {Op::kMap}},
+          {"number", {Op::kLiteral}},
+          {"one_hot_select", {Op::kOneHotSel}},
+          {"partial_product", {Op::kUMulp, Op::kSMulp}},
+          {"priority_select", {Op::kPrioritySel}},
+          {"sign_extend", {Op::kSignExt}},
+          {"shift", {Op::kShll, Op::kShrl, Op::kShra}},
+          {"tuple_or_index", {Op::kTuple, Op::kTupleIndex}},
+          {"unop", {Op::kNot, Op::kNeg}},
+          {"unop_builtin",
+           {Op::kReverse, Op::kDecode, Op::kEncode, Op::kOneHot}},
+      });
+  return *kExprKindOps;
+}
+
+// Returns a short description of the kind and width of `type`, with widths
+// bucketed by their log2 so that shapes don't differ in every bit count.
+std::string TypeShape(const Type* type) {
+  int64_t width = type->GetFlatBitCount();
+  return absl::StrCat(TypeKindToString(type->kind()), ":",
+                      width == 0 ? 0 : FloorOfLog2(width) + 1);
+}
+
+std::string NodeShape(const Node* node) {
+  std::string shape =
+      absl::StrCat(OpToString(node->op()), "/", TypeShape(node->GetType()));
+  for (const Node* operand : node->operands()) {
+    absl::StrAppend(&shape, " ", TypeShape(operand->GetType()));
+  }
+  return shape;
+}
+
+// Laplace-smoothed rate at which samples containing an op have contained new
+// shapes of it; ops never seen at all get the uninformed rate of one half.
+double NoveltyRate(int64_t samples, int64_t samples_with_new_shapes) {
+  return static_cast<double>(samples_with_new_shapes + 1) /
+         static_cast<double>(samples + 2);
+}
+
+}  // namespace
+
+void CoverageTracker::RecordPackage(const Package& package) {
+  // Shapes are computed before taking the lock as that is most of the work.
+  absl::flat_hash_set<Op> ops;
+  std::vector<std::pair<Op, std::string>> shapes;
+  for (FunctionBase* function_base : package.GetFunctionBases()) {
+    for (const Node* node : function_base->nodes()) {
+      ops.insert(node->op());
+      shapes.push_back({node->op(), NodeShape(node)});
+    }
+  }
+
+  absl::MutexLock lock(&mutex_);
+  absl::flat_hash_set<Op> ops_with_new_shapes;
+  for (auto& [op, shape] : shapes) {
+    if (shapes_.insert(std::move(shape)).second) {
+      ops_with_new_shapes.insert(op);
+    }
+  }
+  for (Op op : ops) {
+    OpStats& stats = op_stats_[op];
+    ++stats.samples;
+    if (ops_with_new_shapes.contains(op)) {
+      ++stats.samples_with_new_shapes;
+    }
+  }
+}
+
+absl::flat_hash_map<std::string, double> CoverageTracker::GetExprKindWeights()
+    const {
+  absl::MutexLock lock(&mutex_);
+  auto rate = [&](Op op) {
+    auto it = op_stats_.find(op);
+    return it == op_stats_.end()
+               ? NoveltyRate(0, 0)
+               : NoveltyRate(it->second.samples,
+                             it->second.samples_with_new_shapes);
+  };
+
+  // Each kind of expression is rated by the most novel of its ops, relative to
+  // the average over all kinds.
+  absl::flat_hash_map<std::string, double> kind_rates;
+  double rate_sum = 0.0;
+  for (const auto& [kind, ops] : GetExprKindOps()) {
+    double kind_rate = 0.0;
+    for (Op op : ops) {
+      kind_rate = std::max(kind_rate, rate(op));
+    }
+    kind_rates[kind] = kind_rate;
+    rate_sum += kind_rate;
+  }
+  double mean_rate = rate_sum / static_cast<double>(kind_rates.size());
+
+  absl::flat_hash_map<std::string, double> weights;
+  for (const auto& [kind, kind_rate] : kind_rates) {
+    weights[kind] = std::clamp(kind_rate / mean_rate, kMinWeight, kMaxWeight);
+  }
+  return weights;
+}
+
+int64_t CoverageTracker::shape_count() const {
+  absl::MutexLock lock(&mutex_);
+  return shapes_.size();
+}
+
+}  // namespace xls
@@ -0,0 +1,68 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_FUZZER_COVERAGE_TRACKER_H_
+#define XLS_FUZZER_COVERAGE_TRACKER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// Tracks the IR covered by the fuzzer's samples and turns it into weights
+// which steer the AST generator toward less covered behavior. Thread-safe, so
+// a single tracker can be shared by all the workers of a fuzzing run.
+//
+// Coverage is measured in node "shapes": the op of a node along with the kind
+// and (log2-bucketed) width of its type and of its operands'. For each op the
+// tracker counts the samples containing it and how many of those contained a
+// shape of it not seen before. Kinds of expression whose IR ops still turn up
+// new shapes are weighted up, and those whose ops are saturated are weighted
+// down.
+class CoverageTracker {
+ public:
+  // The bounds of the weights returned by GetExprKindWeights().
+  static constexpr double kMinWeight = 0.25;
+  static constexpr double kMaxWeight = 4.0;
+
+  // Records the nodes of one sample's IR.
+  void RecordPackage(const Package& package);
+
+  // Returns weights for `dslx::AstGeneratorOptions::expr_kind_weights`.
+  absl::flat_hash_map<std::string, double> GetExprKindWeights() const;
+
+  // Returns the number of distinct node shapes seen so far.
+  int64_t shape_count() const;
+
+ private:
+  struct OpStats {
+    int64_t samples = 0;
+    int64_t samples_with_new_shapes = 0;
+  };
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_set<std::string> shapes_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<Op, OpStats> op_stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_FUZZER_COVERAGE_TRACKER_H_
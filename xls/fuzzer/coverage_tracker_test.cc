@@ -0,0 +1,77 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/fuzzer/coverage_tracker.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "xls/common/status/matchers.h"
+#include "xls/fuzzer/ast_generator.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+using ::testing::Contains;
+using ::testing::Ge;
+using ::testing::Gt;
+using ::testing::Le;
+using ::testing::Lt;
+
+constexpr char kAddPackage[] = R"(
+package add
+
+top fn main(x: bits[32], y: bits[32]) -> bits[32] {
+  ret add.1: bits[32] = add(x, y, id=1)
+}
+)";
+
+TEST(CoverageTrackerTest, WeightsAreForGeneratedKindsAndBounded) {
+  CoverageTracker tracker;
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kAddPackage));
+  tracker.RecordPackage(*package);
+
+  std::vector<std::string> kinds = dslx::GetExprKindNames();
+  for (const auto& [kind, weight] : tracker.GetExprKindWeights()) {
+    EXPECT_THAT(kinds, Contains(kind));
+    EXPECT_THAT(weight, Ge(CoverageTracker::kMinWeight));
+    EXPECT_THAT(weight, Le(CoverageTracker::kMaxWeight));
+  }
+}
+
+TEST(CoverageTrackerTest, SaturatedKindsAreWeightedDown) {
+  CoverageTracker tracker;
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kAddPackage));
+  for (int i = 0; i < 16; ++i) {
+    tracker.RecordPackage(*package);
+  }
+  // Only the first sample contributed new shapes: the param and the add.
+  EXPECT_EQ(tracker.shape_count(), 2);
+
+  absl::flat_hash_map<std::string, double> weights =
+      tracker.GetExprKindWeights();
+  EXPECT_THAT(weights.at("binop"), Lt(1.0));
+  EXPECT_THAT(weights.at("shift"), Gt(1.0));
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,235 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/fuzzer/fuzz_coordinator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "openssl/sha.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/fuzzer/fuzz_coordinator.pb.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "re2/re2.h"
+
+namespace xls {
+namespace {
+
+// Returns the ops of the nodes of `ir`, sorted, or nullopt if `ir` does not
+// parse.
+std::optional<std::vector<std::string>> SortedOps(std::string_view ir) {
+  absl::StatusOr<std::unique_ptr<Package>> package = Parser::ParsePackage(ir);
+  if (!package.ok()) {
+    return std::nullopt;
+  }
+  std::vector<std::string> ops;
+  for (FunctionBase* function_base : (*package)->GetFunctionBases()) {
+    for (const Node* node : function_base->nodes()) {
+      ops.push_back(OpToString(node->op()));
+    }
+  }
+  std::sort(ops.begin(), ops.end());
+  return ops;
+}
+
+// Writes a crasher in the layout used by run_fuzz, i.e. as a directory holding
+// the crasher file, the error it failed with and (if available) its minimized
+// IR; the seed it was generated from is recorded alongside.
+absl::Status SaveCrasher(const fuzzer::CrasherProto& crasher,
+                         std::string_view signature,
+                         const std::filesystem::path& crasher_dir) {
+  std::filesystem::path signature_dir = crasher_dir / signature;
+  LOG(INFO) << "Saving crasher to " << signature_dir;
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(signature_dir));
+  XLS_RETURN_IF_ERROR(SetFileContents(
+      signature_dir / "exception.txt",
+      absl::Status(static_cast<absl::StatusCode>(crasher.status_code()),
+                   crasher.error_message())
+          .ToString()));
+  XLS_RETURN_IF_ERROR(SetFileContents(signature_dir / "seed.txt",
+                                      absl::StrCat(crasher.seed(), "\n")));
+  XLS_RETURN_IF_ERROR(SetFileContents(
+      signature_dir /
+          absl::StrFormat(
+              "crasher_%s_%s.x",
+              absl::FormatTime("%Y-%m-%d", absl::Now(), absl::LocalTimeZone()),
+              signature.substr(0, 4)),
+      crasher.crasher()));
+  if (crasher.has_minimized_ir()) {
+    XLS_RETURN_IF_ERROR(SetFileContents(signature_dir / "minimized.ir",
+                                        crasher.minimized_ir()));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+std::string CrasherSignature(const fuzzer::CrasherProto& crasher) {
+  std::string key = absl::StatusCodeToString(
+      static_cast<absl::StatusCode>(crasher.status_code()));
+  std::optional<std::vector<std::string>> ops;
+  if (crasher.has_minimized_ir()) {
+    ops = SortedOps(crasher.minimized_ir());
+  }
+  if (ops.has_value()) {
+    absl::StrAppend(&key, "\nops: ", absl::StrJoin(*ops, ","));
+  } else {
+    std::string message = crasher.error_message();
+    RE2::GlobalReplace(&message, "[0-9]+", "#");
+    absl::StrAppend(&key, "\nmessage: ", message);
+  }
+
+  std::array<char, SHA256_DIGEST_LENGTH> digest;
+  SHA256(reinterpret_cast<const uint8_t*>(key.data()), key.size(),
+         reinterpret_cast<uint8_t*>(digest.data()));
+  static_assert(digest.size() >= 8);
+  return absl::BytesToHexString({digest.data(), 8});
+}
+
+fuzzer::LeaseSeedsResponse FuzzCoordinator::LeaseSeeds(
+    const fuzzer::LeaseSeedsRequest& request, absl::Time now) {
+  absl::MutexLock lock(&mutex_);
+  fuzzer::LeaseSeedsResponse response;
+
+  // Hand out expired leases again before any new seeds, so that the seeds of
+  // workers which went away are not lost.
+  for (auto& [first_seed, lease] : leases_) {
+    if (lease.expiry > now) {
+      continue;
+    }
+    LOG(INFO) << absl::StreamFormat(
+        "Lease of seeds [%d, %d) by %s expired; leasing to %s", first_seed,
+        first_seed + lease.seed_count, lease.worker, request.worker());
+    lease.worker = request.worker();
+    lease.expiry = now + options_.lease_timeout;
+    response.set_first_seed(first_seed);
+    response.set_seed_count(lease.seed_count);
+    return response;
+  }
+
+  uint64_t remaining =
+      options_.seed_count.has_value()
+          ? options_.first_seed + *options_.seed_count - next_seed_
+          : std::numeric_limits<uint64_t>::max() - next_seed_;
+  if (remaining == 0) {
+    response.set_seed_count(0);
+    response.set_done(leases_.empty());
+    return response;
+  }
+  int64_t seed_count = static_cast<int64_t>(
+      std::min<uint64_t>(options_.seeds_per_lease, remaining));
+  leases_[next_seed_] = Lease{.seed_count = seed_count,
+                              .worker = request.worker(),
+                              .expiry = now + options_.lease_timeout};
+  response.set_first_seed(next_seed_);
+  response.set_seed_count(seed_count);
+  next_seed_ += seed_count;
+  return response;
+}
+
+absl::StatusOr<fuzzer::ReportResultsResponse> FuzzCoordinator::ReportResults(
+    const fuzzer::ReportResultsRequest& request) {
+  // Minimized IR is parsed to compute signatures, so do that before locking.
+  std::vector<std::string> signatures;
+  signatures.reserve(request.crashers_size());
+  for (const fuzzer::CrasherProto& crasher : request.crashers()) {
+    signatures.push_back(CrasherSignature(crasher));
+  }
+
+  absl::MutexLock lock(&mutex_);
+  auto it = leases_.find(request.first_seed());
+  if (it == leases_.end() || it->second.seed_count != request.seed_count()) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "Seeds [%d, %d) reported by %s are not leased", request.first_seed(),
+        request.first_seed() + request.seed_count(), request.worker()));
+  }
+  leases_.erase(it);
+  reported_seed_count_ += request.seed_count();
+  sample_count_ += request.summaries().samples_size();
+
+  if (options_.summary_dir.has_value() &&
+      request.summaries().samples_size() > 0) {
+    XLS_RETURN_IF_ERROR(AppendStringToFile(
+        *options_.summary_dir / "summary_coordinator.binarypb",
+        request.summaries().SerializeAsString()));
+  }
+
+  fuzzer::ReportResultsResponse response;
+  int64_t new_crasher_count = 0;
+  for (int64_t i = 0; i < request.crashers_size(); ++i) {
+    ++crasher_count_;
+    if (signatures_[signatures[i]]++ > 0) {
+      continue;
+    }
+    ++new_crasher_count;
+    if (options_.crasher_dir.has_value()) {
+      XLS_RETURN_IF_ERROR(SaveCrasher(request.crashers(i), signatures[i],
+                                      *options_.crasher_dir));
+    }
+  }
+  response.set_new_crasher_count(new_crasher_count);
+
+  LOG(INFO) << absl::StreamFormat(
+      "%s reported seeds [%d, %d): %d crashers (%d new); %d seeds reported, %d "
+      "distinct crashers in total",
+      request.worker(), request.first_seed(),
+      request.first_seed() + request.seed_count(), request.crashers_size(),
+      new_crasher_count, reported_seed_count_, signatures_.size());
+  return response;
+}
+
+int64_t FuzzCoordinator::reported_seed_count() const {
+  absl::MutexLock lock(&mutex_);
+  return reported_seed_count_;
+}
+
+int64_t FuzzCoordinator::sample_count() const {
+  absl::MutexLock lock(&mutex_);
+  return sample_count_;
+}
+
+int64_t FuzzCoordinator::crasher_count() const {
+  absl::MutexLock lock(&mutex_);
+  return crasher_count_;
+}
+
+int64_t FuzzCoordinator::distinct_crasher_count() const {
+  absl::MutexLock lock(&mutex_);
+  return signatures_.size();
+}
+
+}  // namespace xls
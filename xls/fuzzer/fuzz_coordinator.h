@@ -0,0 +1,106 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_FUZZER_FUZZ_COORDINATOR_H_
+#define XLS_FUZZER_FUZZ_COORDINATOR_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/fuzzer/fuzz_coordinator.pb.h"
+
+namespace xls {
+
+// Returns a signature identifying the bug behind a crasher, so that crashers
+// found from different seeds can be deduplicated: the status code of the
+// failure along with the ops of its minimized IR, or (if the crasher could not
+// be minimized) its error message with any numbers elided.
+std::string CrasherSignature(const fuzzer::CrasherProto& crasher);
+
+struct FuzzCoordinatorOptions {
+  // The seeds to hand out are [first_seed, first_seed + seed_count), or
+  // unbounded if `seed_count` is not given.
+  uint64_t first_seed = 0;
+  std::optional<int64_t> seed_count;
+
+  // The number of seeds in each lease.
+  int64_t seeds_per_lease = 64;
+
+  // Leases not reported within this time are handed out again, e.g. to
+  // recover the seeds of a worker which went away.
+  absl::Duration lease_timeout = absl::Hours(1);
+
+  // Where to write one crasher per distinct signature.
+  std::optional<std::filesystem::path> crasher_dir;
+
+  // Where to write the aggregated sample summaries.
+  std::optional<std::filesystem::path> summary_dir;
+};
+
+// The state of a distributed fuzzing run: hands out seed ranges to workers and
+// aggregates what they report. Thread-safe; the gRPC service in
+// fuzz_coordinator_main is a thin wrapper around this.
+class FuzzCoordinator {
+ public:
+  explicit FuzzCoordinator(FuzzCoordinatorOptions options)
+      : options_(std::move(options)), next_seed_(options_.first_seed) {}
+
+  fuzzer::LeaseSeedsResponse LeaseSeeds(
+      const fuzzer::LeaseSeedsRequest& request, absl::Time now = absl::Now());
+
+  // Records the results of a leased range. Returns a failed precondition error
+  // (and records nothing) if the range is not currently leased, e.g. because
+  // it was already reported by a worker it was handed out to again.
+  absl::StatusOr<fuzzer::ReportResultsResponse> ReportResults(
+      const fuzzer::ReportResultsRequest& request);
+
+  int64_t reported_seed_count() const;
+  int64_t sample_count() const;
+  int64_t crasher_count() const;
+  int64_t distinct_crasher_count() const;
+
+ private:
+  struct Lease {
+    int64_t seed_count;
+    std::string worker;
+    absl::Time expiry;
+  };
+
+  const FuzzCoordinatorOptions options_;
+
+  mutable absl::Mutex mutex_;
+  uint64_t next_seed_ ABSL_GUARDED_BY(mutex_);
+  // Outstanding leases, keyed by their first seed.
+  absl::btree_map<uint64_t, Lease> leases_ ABSL_GUARDED_BY(mutex_);
+  // The number of crashers seen with each signature.
+  absl::flat_hash_map<std::string, int64_t> signatures_ ABSL_GUARDED_BY(mutex_);
+  int64_t reported_seed_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t sample_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t crasher_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_FUZZER_FUZZ_COORDINATOR_H_
@@ -0,0 +1,160 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/time/time.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "xls/common/exit_status.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/fuzzer/fuzz_coordinator.grpc.pb.h"
+#include "xls/fuzzer/fuzz_coordinator.h"
+#include "xls/fuzzer/fuzz_coordinator.pb.h"
+
+static constexpr std::string_view kUsage = R"(
+Coordinates fuzzing across many machines: hands out ranges of seeds to
+run_fuzz_multiprocess workers started with --coordinator, and collects their
+results. One crasher is kept per distinct signature, and the summaries of all
+samples are aggregated for read_summary_main. Sample usage:
+
+  fuzz_coordinator_main --port=10000 --seed_count=1000000 \
+    --crash_path=/tmp/crashers --summary_path=/tmp/summaries
+
+and on each fuzzing machine:
+
+  run_fuzz_multiprocess --coordinator=COORDINATOR_HOST:10000
+)";
+
+ABSL_FLAG(int32_t, port, 10000, "Port to listen on.");
+ABSL_FLAG(std::optional<std::string>, crash_path, std::nullopt,
+          "Path at which to place crash data.");
+ABSL_FLAG(absl::Duration, lease_timeout, absl::Hours(1),
+          "Time after which seeds leased to a worker which has not reported "
+          "them are leased to another worker.");
+ABSL_FLAG(uint64_t, seed, 0, "First seed to hand out.");
+ABSL_FLAG(std::optional<int64_t>, seed_count, std::nullopt,
+          "Number of seeds to hand out; unbounded if not given.");
+ABSL_FLAG(int64_t, seeds_per_lease, 64,
+          "Number of seeds handed out to a worker at a time.");
+ABSL_FLAG(std::optional<std::string>, summary_path, std::nullopt,
+          "Directory in which to write the aggregated summary information.");
+
+namespace xls {
+namespace {
+
+::grpc::Status AbslToGrpcStatus(const absl::Status& status) {
+  // This assumes that the status code enums match up.
+  return ::grpc::Status(static_cast<::grpc::StatusCode>(status.code()),
+                        std::string(status.message()));
+}
+
+class FuzzCoordinatorServiceImpl : public fuzzer::FuzzCoordinator::Service {
+ public:
+  explicit FuzzCoordinatorServiceImpl(FuzzCoordinator& coordinator)
+      : coordinator_(coordinator) {}
+
+  ::grpc::Status LeaseSeeds(::grpc::ServerContext* server_context,
+                            const fuzzer::LeaseSeedsRequest* request,
+                            fuzzer::LeaseSeedsResponse* response) override {
+    *response = coordinator_.LeaseSeeds(*request);
+    return ::grpc::Status::OK;
+  }
+
+  ::grpc::Status ReportResults(
+      ::grpc::ServerContext* server_context,
+      const fuzzer::ReportResultsRequest* request,
+      fuzzer::ReportResultsResponse* response) override {
+    absl::StatusOr<fuzzer::ReportResultsResponse> result =
+        coordinator_.ReportResults(*request);
+    if (!result.ok()) {
+      LOG(WARNING) << "Failed to record results: " << result.status();
+      return AbslToGrpcStatus(result.status());
+    }
+    *response = *std::move(result);
+    return ::grpc::Status::OK;
+  }
+
+ private:
+  FuzzCoordinator& coordinator_;
+};
+
+absl::Status RealMain() {
+  FuzzCoordinatorOptions options{
+      .first_seed = absl::GetFlag(FLAGS_seed),
+      .seed_count = absl::GetFlag(FLAGS_seed_count),
+      .seeds_per_lease = absl::GetFlag(FLAGS_seeds_per_lease),
+      .lease_timeout = absl::GetFlag(FLAGS_lease_timeout),
+  };
+  if (std::optional<std::string> crash_path = absl::GetFlag(FLAGS_crash_path);
+      crash_path.has_value()) {
+    options.crasher_dir = *crash_path;
+    XLS_RETURN_IF_ERROR(RecursivelyCreateDir(*options.crasher_dir));
+  }
+  if (std::optional<std::string> summary_path =
+          absl::GetFlag(FLAGS_summary_path);
+      summary_path.has_value()) {
+    options.summary_dir = *summary_path;
+    XLS_RETURN_IF_ERROR(RecursivelyCreateDir(*options.summary_dir));
+  }
+  FuzzCoordinator coordinator(std::move(options));
+  FuzzCoordinatorServiceImpl service(coordinator);
+
+  // Fuzzing machines only exchange generated samples and their results with
+  // the coordinator, so the connection is not authenticated.
+  int port = absl::GetFlag(FLAGS_port);
+  ::grpc::ServerBuilder builder;
+  builder.AddListeningPort(absl::StrCat("0.0.0.0:", port),
+                           ::grpc::InsecureServerCredentials());
+  builder.RegisterService(&service);
+  std::unique_ptr<::grpc::Server> server(builder.BuildAndStart());
+  if (server == nullptr) {
+    return absl::UnavailableError(
+        absl::StrCat("Failed to start fuzz coordinator on port ", port));
+  }
+  LOG(INFO) << "Serving on port: " << port;
+  server->Wait();
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  if (!positional_arguments.empty()) {
+    LOG(QFATAL) << "Unexpected positional arguments: "
+                << absl::StrJoin(positional_arguments, ", ");
+  }
+  return xls::ExitStatus(xls::RealMain());
+}
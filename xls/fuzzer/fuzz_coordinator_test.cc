@@ -0,0 +1,169 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/fuzzer/fuzz_coordinator.h"
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <string>
+#include <string_view>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/fuzzer/fuzz_coordinator.pb.h"
+#include "xls/fuzzer/sample_summary.pb.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+
+constexpr char kMinimizedIr[] = R"(
+package crasher
+
+top fn main(x: bits[8]) -> bits[8] {
+  ret neg.1: bits[8] = neg(x, id=1)
+}
+)";
+
+fuzzer::LeaseSeedsRequest Request(std::string_view worker) {
+  fuzzer::LeaseSeedsRequest request;
+  request.set_worker(worker);
+  return request;
+}
+
+fuzzer::ReportResultsRequest Report(const fuzzer::LeaseSeedsResponse& lease) {
+  fuzzer::ReportResultsRequest report;
+  report.set_worker("worker");
+  report.set_first_seed(lease.first_seed());
+  report.set_seed_count(lease.seed_count());
+  return report;
+}
+
+fuzzer::CrasherProto Crasher(uint64_t seed, std::string_view error_message) {
+  fuzzer::CrasherProto crasher;
+  crasher.set_seed(seed);
+  crasher.set_status_code(static_cast<int>(absl::StatusCode::kInternal));
+  crasher.set_error_message(error_message);
+  crasher.set_crasher("fn main() {}");
+  return crasher;
+}
+
+TEST(FuzzCoordinatorTest, LeasesSeedRangesUntilDone) {
+  FuzzCoordinator coordinator(FuzzCoordinatorOptions{
+      .first_seed = 100, .seed_count = 10, .seeds_per_lease = 4});
+
+  fuzzer::LeaseSeedsResponse a = coordinator.LeaseSeeds(Request("a"));
+  fuzzer::LeaseSeedsResponse b = coordinator.LeaseSeeds(Request("b"));
+  fuzzer::LeaseSeedsResponse c = coordinator.LeaseSeeds(Request("c"));
+  EXPECT_EQ(a.first_seed(), 100);
+  EXPECT_EQ(a.seed_count(), 4);
+  EXPECT_EQ(b.first_seed(), 104);
+  EXPECT_EQ(b.seed_count(), 4);
+  EXPECT_EQ(c.first_seed(), 108);
+  EXPECT_EQ(c.seed_count(), 2);
+
+  // Seeds are exhausted, but not all reported yet.
+  fuzzer::LeaseSeedsResponse none = coordinator.LeaseSeeds(Request("d"));
+  EXPECT_EQ(none.seed_count(), 0);
+  EXPECT_FALSE(none.done());
+
+  for (const fuzzer::LeaseSeedsResponse& lease : {a, b, c}) {
+    XLS_EXPECT_OK(coordinator.ReportResults(Report(lease)));
+  }
+  EXPECT_EQ(coordinator.reported_seed_count(), 10);
+  EXPECT_TRUE(coordinator.LeaseSeeds(Request("d")).done());
+}
+
+TEST(FuzzCoordinatorTest, ExpiredLeasesAreHandedOutAgain) {
+  FuzzCoordinator coordinator(
+      FuzzCoordinatorOptions{.seed_count = 8,
+                             .seeds_per_lease = 8,
+                             .lease_timeout = absl::Minutes(5)});
+  absl::Time start = absl::UnixEpoch();
+
+  fuzzer::LeaseSeedsResponse lost = coordinator.LeaseSeeds(Request("a"), start);
+  EXPECT_EQ(coordinator.LeaseSeeds(Request("b"), start).seed_count(), 0);
+
+  fuzzer::LeaseSeedsResponse retry =
+      coordinator.LeaseSeeds(Request("b"), start + absl::Minutes(6));
+  EXPECT_EQ(retry.first_seed(), lost.first_seed());
+  EXPECT_EQ(retry.seed_count(), lost.seed_count());
+
+  // Only the first report of a range counts.
+  XLS_EXPECT_OK(coordinator.ReportResults(Report(retry)));
+  EXPECT_THAT(coordinator.ReportResults(Report(lost)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_EQ(coordinator.reported_seed_count(), 8);
+}
+
+TEST(FuzzCoordinatorTest, SignaturesIgnoreNumbersAndPreferMinimizedIr) {
+  EXPECT_EQ(CrasherSignature(Crasher(1, "Result miscompare for sample 12")),
+            CrasherSignature(Crasher(2, "Result miscompare for sample 34")));
+  EXPECT_NE(CrasherSignature(Crasher(1, "Result miscompare")),
+            CrasherSignature(Crasher(1, "Codegen failed")));
+
+  fuzzer::CrasherProto a = Crasher(1, "Result miscompare");
+  fuzzer::CrasherProto b = Crasher(2, "Codegen failed");
+  a.set_minimized_ir(kMinimizedIr);
+  b.set_minimized_ir(kMinimizedIr);
+  EXPECT_EQ(CrasherSignature(a), CrasherSignature(b));
+}
+
+TEST(FuzzCoordinatorTest, AggregatesSummariesAndDedupesCrashers) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path crasher_dir = temp_dir.path() / "crashers";
+  std::filesystem::path summary_dir = temp_dir.path() / "summaries";
+  XLS_ASSERT_OK(RecursivelyCreateDir(crasher_dir));
+  XLS_ASSERT_OK(RecursivelyCreateDir(summary_dir));
+  FuzzCoordinator coordinator(
+      FuzzCoordinatorOptions{.seed_count = 4,
+                             .seeds_per_lease = 2,
+                             .crasher_dir = crasher_dir,
+                             .summary_dir = summary_dir});
+
+  for (int64_t i = 0; i < 2; ++i) {
+    fuzzer::ReportResultsRequest report =
+        Report(coordinator.LeaseSeeds(Request("worker")));
+    report.mutable_summaries()->add_samples();
+    report.mutable_summaries()->add_samples();
+    *report.add_crashers() = Crasher(report.first_seed(), "Result miscompare");
+    XLS_ASSERT_OK_AND_ASSIGN(fuzzer::ReportResultsResponse response,
+                             coordinator.ReportResults(report));
+    EXPECT_EQ(response.new_crasher_count(), i == 0 ? 1 : 0);
+  }
+  EXPECT_EQ(coordinator.sample_count(), 4);
+  EXPECT_EQ(coordinator.crasher_count(), 2);
+  EXPECT_EQ(coordinator.distinct_crasher_count(), 1);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::string summary_data,
+      GetFileContents(summary_dir / "summary_coordinator.binarypb"));
+  fuzzer::SampleSummariesProto summaries;
+  ASSERT_TRUE(summaries.ParseFromString(summary_data));
+  EXPECT_EQ(summaries.samples_size(), 4);
+
+  std::string signature = CrasherSignature(Crasher(0, "Result miscompare"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::string seed, GetFileContents(crasher_dir / signature / "seed.txt"));
+  EXPECT_EQ(seed, "0\n");
+}
+
+}  // namespace
+}  // namespace xls
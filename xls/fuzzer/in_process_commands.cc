@@ -0,0 +1,185 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/fuzzer/in_process_commands.h"
+
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/fuzzer/sample.h"
+#include "xls/fuzzer/sample_runner.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/ir/events.h"
+#include "xls/ir/format_preference.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+#include "xls/tests/testvector.pb.h"
+#include "xls/tools/opt.h"
+#include "re2/re2.h"
+
+namespace xls {
+namespace {
+
+// Tool names used to select the sample's known failures which apply to each
+// in-process stage; these match the basenames of the binaries they replace.
+constexpr std::string_view kEvalIrTool = "eval_ir_main";
+constexpr std::string_view kOptTool = "opt_main";
+
+// Resolves `path` the way the tool it stands in for would, i.e. relative to
+// the run directory it is started in.
+std::filesystem::path ResolvePath(const std::filesystem::path& path,
+                                  const std::filesystem::path& run_dir) {
+  return path.is_relative() ? run_dir / path : path;
+}
+
+// Mirrors the subprocess runner's handling of known failures: an error from
+// `tool` whose message matches one of the sample's known failures is
+// reported as a failed precondition, which the sample runner ignores.
+absl::Status MaybeSuppressKnownFailure(std::string_view tool,
+                                       const SampleOptions& options,
+                                       const absl::Status& status) {
+  if (status.ok()) {
+    return status;
+  }
+  for (const KnownFailure& filter : options.known_failures()) {
+    if ((filter.tool == nullptr || RE2::FullMatch(tool, *filter.tool)) &&
+        RE2::PartialMatch(status.message(), *filter.stderr_regex)) {
+      return absl::FailedPreconditionError(absl::StrFormat(
+          "%s failed but failure was suppressed due to stderr regexp: %s",
+          tool, status.message()));
+    }
+  }
+  return status;
+}
+
+// Evaluates the top function of an IR file on each argument set of a function
+// testvector, accepting the arguments the sample runner passes to
+// `eval_ir_main`, and returns one result per line as that tool does.
+absl::StatusOr<std::string> EvalIr(const std::vector<std::string>& args,
+                                   const std::filesystem::path& run_dir) {
+  std::optional<std::filesystem::path> ir_path;
+  std::optional<std::filesystem::path> testvector_path;
+  bool use_jit = true;
+  for (std::string_view arg : args) {
+    if (absl::ConsumePrefix(&arg, "--testvector_textproto=")) {
+      testvector_path = ResolvePath(arg, run_dir);
+    } else if (arg == "--use_llvm_jit") {
+      use_jit = true;
+    } else if (arg == "--nouse_llvm_jit") {
+      use_jit = false;
+    } else if (!absl::StartsWith(arg, "-") && !ir_path.has_value()) {
+      ir_path = ResolvePath(arg, run_dir);
+    } else {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported argument for in-process IR evaluation: ",
+                       arg));
+    }
+  }
+  if (!ir_path.has_value() || !testvector_path.has_value()) {
+    return absl::InvalidArgumentError(
+        "In-process IR evaluation requires an IR file and a testvector.");
+  }
+
+  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(*ir_path));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       Parser::ParsePackage(ir_text, ir_path->string()));
+  XLS_ASSIGN_OR_RETURN(Function * f, package->GetTopAsFunction());
+  testvector::SampleInputsProto testvector;
+  XLS_RETURN_IF_ERROR(ParseTextProtoFile(*testvector_path, &testvector));
+  if (!testvector.has_function_args()) {
+    return absl::InvalidArgumentError("Expected function_args in testvector");
+  }
+
+  std::unique_ptr<FunctionJit> jit;
+  if (use_jit) {
+    XLS_ASSIGN_OR_RETURN(jit, FunctionJit::Create(f));
+  }
+  std::string results;
+  for (std::string_view arg_line : testvector.function_args().args()) {
+    std::vector<Value> arg_values;
+    for (std::string_view value_string : absl::StrSplit(arg_line, ';')) {
+      XLS_ASSIGN_OR_RETURN(Value value, Parser::ParseTypedValue(value_string));
+      arg_values.push_back(std::move(value));
+    }
+    Value result;
+    if (use_jit) {
+      XLS_ASSIGN_OR_RETURN(result, DropInterpreterEvents(jit->Run(arg_values)));
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          result, DropInterpreterEvents(InterpretFunction(f, arg_values)));
+    }
+    absl::StrAppend(&results, result.ToString(FormatPreference::kHex), "\n");
+  }
+  return results;
+}
+
+// Optimizes an IR file with the default options of `opt_main`, which is all
+// the sample runner ever asks of it, and returns the optimized IR.
+absl::StatusOr<std::string> OptimizeIr(const std::vector<std::string>& args,
+                                       const std::filesystem::path& run_dir) {
+  if (args.size() != 1 || absl::StartsWith(args.front(), "-")) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Unsupported arguments for in-process IR optimization: ",
+        absl::StrJoin(args, " ")));
+  }
+  std::filesystem::path ir_path = ResolvePath(args.front(), run_dir);
+  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
+  return tools::OptimizeIrForTop(
+      ir_text, tools::OptOptions{.ir_path = ir_path.string()});
+}
+
+}  // namespace
+
+SampleRunner::Commands InProcessCommands() {
+  SampleRunner::Commands commands;
+  commands.eval_ir_main =
+      [](const std::vector<std::string>& args,
+         const std::filesystem::path& run_dir,
+         const SampleOptions& options) -> absl::StatusOr<std::string> {
+    absl::StatusOr<std::string> result = EvalIr(args, run_dir);
+    XLS_RETURN_IF_ERROR(
+        MaybeSuppressKnownFailure(kEvalIrTool, options, result.status()));
+    return result;
+  };
+  commands.ir_opt_main =
+      [](const std::vector<std::string>& args,
+         const std::filesystem::path& run_dir,
+         const SampleOptions& options) -> absl::StatusOr<std::string> {
+    absl::StatusOr<std::string> result = OptimizeIr(args, run_dir);
+    XLS_RETURN_IF_ERROR(
+        MaybeSuppressKnownFailure(kOptTool, options, result.status()));
+    return result;
+  };
+  return commands;
+}
+
+}  // namespace xls
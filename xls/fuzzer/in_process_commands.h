@@ -0,0 +1,34 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_FUZZER_IN_PROCESS_COMMANDS_H_
+#define XLS_FUZZER_IN_PROCESS_COMMANDS_H_
+
+#include "xls/fuzzer/sample_runner.h"
+
+namespace xls {
+
+// Returns sample runner commands which evaluate IR functions and optimize IR
+// in the calling process, rather than starting an `eval_ir_main` or `opt_main`
+// subprocess for every evaluation. These are the stages run most often per
+// sample; the remaining stages still run their tools as subprocesses.
+//
+// In-process stages do not honor the sample's timeout and a crash in them
+// takes down the calling process, so these are meant for use inside a process
+// which is itself isolated, e.g. `sample_runner_main`.
+SampleRunner::Commands InProcessCommands();
+
+}  // namespace xls
+
+#endif  // XLS_FUZZER_IN_PROCESS_COMMANDS_H_
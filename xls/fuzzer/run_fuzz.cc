@@ -225,7 +225,10 @@ cd "$RUNDIR"
 
   VLOG(1) << "Starting to run sample";
   VLOG(2) << smp.input_text();
-  SampleRunner runner(run_dir);
+  // Samples often share their optimized IR and Verilog, e.g. when generated
+  // from the same program with different inputs or codegen options.
+  SampleRunner runner(run_dir, SampleRunner::Commands(),
+                      &SampleArtifactCache::ProcessWide());
   XLS_RETURN_IF_ERROR(runner.RunFromFiles(sample_file_name, options_file_name,
                                           testvector_path));
 
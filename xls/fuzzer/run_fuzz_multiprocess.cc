@@ -14,6 +14,8 @@
 
 #include "xls/fuzzer/run_fuzz_multiprocess.h"
 
+#include <unistd.h>
+
 #include <cstdint>
 #include <filesystem>  // NOLINT
 #include <memory>
@@ -21,6 +23,7 @@
 #include <random>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/log/log.h"
@@ -28,10 +31,17 @@
 #include "absl/random/random.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "grpcpp/channel.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/create_channel.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/support/status.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/temp_directory.h"
 #include "xls/common/status/status_macros.h"
@@ -39,8 +49,14 @@
 #include "xls/common/thread.h"
 #include "xls/dslx/frontend/pos.h"
 #include "xls/fuzzer/ast_generator.h"
+#include "xls/fuzzer/coverage_tracker.h"
+#include "xls/fuzzer/fuzz_coordinator.grpc.pb.h"
+#include "xls/fuzzer/fuzz_coordinator.pb.h"
 #include "xls/fuzzer/run_fuzz.h"
 #include "xls/fuzzer/sample.h"
+#include "xls/fuzzer/sample_summary.pb.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
 
 namespace xls {
 namespace {
@@ -49,6 +65,23 @@ static constexpr std::string_view kBlueText = "\033[34m";
 static constexpr std::string_view kRedText = "\033[31m";
 static constexpr std::string_view kDefaultColor = "\033[0m";
 
+// Records the unoptimized and optimized IR of the sample run in `run_dir`, as
+// far as the run got, in `coverage_tracker`.
+absl::Status RecordSampleCoverage(const std::filesystem::path& run_dir,
+                                  CoverageTracker& coverage_tracker) {
+  for (std::string_view filename : {"sample.ir", "sample.opt.ir"}) {
+    std::filesystem::path ir_path = run_dir / filename;
+    if (!std::filesystem::exists(ir_path)) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                         Parser::ParsePackage(ir_text, ir_path.string()));
+    coverage_tracker.RecordPackage(*package);
+  }
+  return absl::OkStatus();
+}
+
 absl::Status GenerateAndRunSamples(
     int64_t worker_number,
     const dslx::AstGeneratorOptions& ast_generator_options,
@@ -57,7 +90,8 @@ absl::Status GenerateAndRunSamples(
     const std::optional<std::filesystem::path>& crasher_dir,
     const std::optional<std::filesystem::path>& summary_dir,
     std::optional<int64_t> sample_count,
-    const std::optional<absl::Duration>& duration, bool force_failure) {
+    const std::optional<absl::Duration>& duration, bool force_failure,
+    CoverageTracker* coverage_tracker) {
   int64_t crashers = 0;
   LOG(INFO) << "--- Started worker " << worker_number;
   Stopwatch stopwatch;
@@ -83,6 +117,9 @@ absl::Status GenerateAndRunSamples(
   std::mt19937_64 rng{rng_seed};
   dslx::FileTable file_table;
 
+  // Each worker reweights its own copy of the generator options.
+  dslx::AstGeneratorOptions generator_options = ast_generator_options;
+
   int64_t sample = 0;
   while (true) {
     std::filesystem::path run_dir;
@@ -97,7 +134,7 @@ absl::Status GenerateAndRunSamples(
     }
 
     absl::Status sample_status =
-        GenerateSampleAndRun(file_table, rng, ast_generator_options,
+        GenerateSampleAndRun(file_table, rng, generator_options,
                              sample_options, run_dir, crasher_dir, summary_file,
                              force_failure)
             .status();
@@ -109,11 +146,21 @@ absl::Status GenerateAndRunSamples(
                 << kDefaultColor;
       crashers++;
     }
+    if (coverage_tracker != nullptr) {
+      // Coverage only steers generation, so failing to record it is not fatal.
+      absl::Status coverage_status =
+          RecordSampleCoverage(run_dir, *coverage_tracker);
+      if (!coverage_status.ok()) {
+        LOG(WARNING) << "--- Worker #" << worker_number
+                     << " could not record coverage for sample number "
+                     << sample << ": " << coverage_status;
+      }
+    }
 
     absl::Duration elapsed = stopwatch.GetElapsedTime();
     if (sample > 0 && sample % 16 == 0) {
       std::vector<std::string> metrics;
-      metrics.reserve(3);
+      metrics.reserve(4);
       if (sample_count.has_value()) {
         metrics.push_back(
             absl::StrFormat("%d/%d samples", sample, *sample_count));
@@ -131,6 +178,12 @@ absl::Status GenerateAndRunSamples(
         metrics.push_back(
             absl::StrFormat("running for %s", absl::FormatDuration(elapsed)));
       }
+      if (coverage_tracker != nullptr) {
+        metrics.push_back(absl::StrFormat(
+            "%d IR node shapes", coverage_tracker->shape_count()));
+        generator_options.expr_kind_weights =
+            coverage_tracker->GetExprKindWeights();
+      }
       LOG(INFO) << absl::StreamFormat("--- Worker #%d: %s", worker_number,
                                       absl::StrJoin(metrics, ", "));
     }
@@ -159,6 +212,145 @@ absl::Status GenerateAndRunSamples(
   return absl::OkStatus();
 }
 
+// How long to wait before asking the coordinator for seeds again when all of
+// the remaining ones are leased to other workers.
+static constexpr absl::Duration kLeaseRetryDelay = absl::Seconds(30);
+
+absl::Status GrpcToAbslStatus(const ::grpc::Status& grpc_status) {
+  return absl::Status(
+      // this assumes that the status code enums match up
+      static_cast<absl::StatusCode>(static_cast<int>(grpc_status.error_code())),
+      grpc_status.error_message());
+}
+
+// Returns a name identifying this worker thread to the coordinator.
+std::string CoordinatedWorkerName(int64_t worker_number) {
+  char hostname[256] = {};
+  gethostname(hostname, sizeof(hostname) - 1);
+  return absl::StrFormat("%s:%d#%d", hostname, getpid(), worker_number);
+}
+
+// Reads back the crasher which GenerateSampleAndRun saved (in a directory of
+// its own) in `crasher_dir` for the sample generated from `seed`.
+absl::StatusOr<fuzzer::CrasherProto> ReadCrasher(
+    const std::filesystem::path& crasher_dir, uint64_t seed,
+    const absl::Status& error) {
+  fuzzer::CrasherProto crasher;
+  crasher.set_seed(seed);
+  crasher.set_status_code(static_cast<int>(error.code()));
+  crasher.set_error_message(error.message());
+  XLS_ASSIGN_OR_RETURN(std::vector<std::filesystem::path> sample_crasher_dirs,
+                       GetDirectoryEntries(crasher_dir));
+  for (const std::filesystem::path& sample_crasher_dir : sample_crasher_dirs) {
+    XLS_ASSIGN_OR_RETURN(std::vector<std::filesystem::path> files,
+                         GetDirectoryEntries(sample_crasher_dir));
+    for (const std::filesystem::path& file : files) {
+      std::string filename = file.filename().string();
+      if (filename == "minimized.ir") {
+        XLS_ASSIGN_OR_RETURN(*crasher.mutable_minimized_ir(),
+                             GetFileContents(file));
+      } else if (absl::StartsWith(filename, "crasher_") &&
+                 absl::EndsWith(filename, ".x")) {
+        XLS_ASSIGN_OR_RETURN(*crasher.mutable_crasher(), GetFileContents(file));
+      }
+    }
+  }
+  return crasher;
+}
+
+absl::Status RunCoordinatedSamples(
+    int64_t worker_number, fuzzer::FuzzCoordinator::Stub& coordinator,
+    const dslx::AstGeneratorOptions& ast_generator_options,
+    const SampleOptions& sample_options) {
+  LOG(INFO) << "--- Started worker " << worker_number;
+  Stopwatch stopwatch;
+  std::string worker_name = CoordinatedWorkerName(worker_number);
+  dslx::FileTable file_table;
+  int64_t samples = 0;
+  int64_t crashers = 0;
+  while (true) {
+    fuzzer::LeaseSeedsRequest lease_request;
+    lease_request.set_worker(worker_name);
+    fuzzer::LeaseSeedsResponse lease;
+    {
+      ::grpc::ClientContext context;
+      XLS_RETURN_IF_ERROR(GrpcToAbslStatus(
+          coordinator.LeaseSeeds(&context, lease_request, &lease)));
+    }
+    if (lease.done()) {
+      break;
+    }
+    if (lease.seed_count() == 0) {
+      absl::SleepFor(kLeaseRetryDelay);
+      continue;
+    }
+
+    XLS_ASSIGN_OR_RETURN(TempDirectory lease_dir, TempDirectory::Create());
+    std::filesystem::path summary_file = lease_dir.path() / "summary.binarypb";
+    fuzzer::ReportResultsRequest report;
+    report.set_worker(worker_name);
+    report.set_first_seed(lease.first_seed());
+    report.set_seed_count(lease.seed_count());
+    for (uint64_t seed = lease.first_seed();
+         seed < lease.first_seed() + lease.seed_count(); ++seed) {
+      XLS_ASSIGN_OR_RETURN(TempDirectory run_dir, TempDirectory::Create());
+      std::filesystem::path crasher_dir =
+          lease_dir.path() / absl::StrCat("crasher_", seed);
+      XLS_RETURN_IF_ERROR(RecursivelyCreateDir(crasher_dir));
+      std::mt19937_64 rng{seed};
+      absl::Status sample_status =
+          GenerateSampleAndRun(file_table, rng, ast_generator_options,
+                               sample_options, run_dir.path(), crasher_dir,
+                               summary_file)
+              .status();
+      ++samples;
+      if (!sample_status.ok()) {
+        LOG(INFO) << kRedText
+                  << absl::StreamFormat(
+                         "--- Worker #%d noted crasher #%d for seed %d",
+                         worker_number, crashers, seed)
+                  << kDefaultColor;
+        ++crashers;
+        XLS_ASSIGN_OR_RETURN(fuzzer::CrasherProto crasher,
+                             ReadCrasher(crasher_dir, seed, sample_status));
+        *report.add_crashers() = std::move(crasher);
+      }
+    }
+    if (FileExists(summary_file).ok()) {
+      XLS_ASSIGN_OR_RETURN(std::string summary_data,
+                           GetFileContents(summary_file));
+      if (!report.mutable_summaries()->ParseFromString(summary_data)) {
+        return absl::InternalError(
+            absl::StrCat("Failed to parse summary file ", summary_file));
+      }
+    }
+
+    fuzzer::ReportResultsResponse response;
+    ::grpc::ClientContext context;
+    absl::Status report_status = GrpcToAbslStatus(
+        coordinator.ReportResults(&context, report, &response));
+    if (absl::IsFailedPrecondition(report_status)) {
+      // The lease expired and its seeds were reported by another worker.
+      LOG(WARNING) << "--- Worker #" << worker_number
+                   << ": results not recorded: " << report_status;
+      continue;
+    }
+    XLS_RETURN_IF_ERROR(report_status);
+    LOG(INFO) << absl::StreamFormat(
+        "--- Worker #%d: %d samples, %d crashers (%d new this lease); %.2f "
+        "samples/s",
+        worker_number, samples, crashers, response.new_crasher_count(),
+        static_cast<double>(samples) /
+            absl::ToDoubleSeconds(stopwatch.GetElapsedTime()));
+  }
+
+  LOG(INFO) << absl::StreamFormat(
+      "--- Worker #%d finished! %d samples; %d crashers; ran for %s",
+      worker_number, samples, crashers,
+      absl::FormatDuration(stopwatch.GetElapsedTime()));
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::Status ParallelGenerateAndRunSamples(
@@ -169,7 +361,11 @@ absl::Status ParallelGenerateAndRunSamples(
     const std::optional<std::filesystem::path>& crasher_dir,
     const std::optional<std::filesystem::path>& summary_dir,
     std::optional<int64_t> sample_count, std::optional<absl::Duration> duration,
-    bool force_failure) {
+    bool force_failure, bool coverage_guided) {
+  std::optional<CoverageTracker> coverage_tracker;
+  if (coverage_guided) {
+    coverage_tracker.emplace();
+  }
   std::vector<std::unique_ptr<Thread>> workers;
   workers.resize(worker_count);
   std::vector<absl::Status> worker_status;
@@ -182,10 +378,45 @@ absl::Status ParallelGenerateAndRunSamples(
             : std::nullopt;
     workers[i] = std::make_unique<Thread>([&, i, worker_sample_count,
                                            status = &worker_status[i]] {
-      *status =
-          GenerateAndRunSamples(i, ast_generator_options, sample_options, seed,
-                                top_run_dir, crasher_dir, summary_dir,
-                                worker_sample_count, duration, force_failure);
+      *status = GenerateAndRunSamples(
+          i, ast_generator_options, sample_options, seed, top_run_dir,
+          crasher_dir, summary_dir, worker_sample_count, duration,
+          force_failure,
+          coverage_tracker.has_value() ? &*coverage_tracker : nullptr);
+    });
+  }
+  for (int64_t i = 0; i < workers.size(); ++i) {
+    LOG(INFO) << "-- Waiting on worker " << i;
+    workers[i]->Join();
+    if (!worker_status[i].ok()) {
+      LOG(ERROR) << kRedText << "-- Worker #" << i
+                 << " failed: " << worker_status[i] << kDefaultColor;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CoordinatedGenerateAndRunSamples(
+    std::string_view coordinator_address, int64_t worker_count,
+    const dslx::AstGeneratorOptions& ast_generator_options,
+    const SampleOptions& sample_options) {
+  // The coordinator only hands out seeds and collects results, so the
+  // connection is not authenticated; see fuzz_coordinator_main.
+  std::shared_ptr<::grpc::Channel> channel =
+      ::grpc::CreateChannel(std::string(coordinator_address),
+                            ::grpc::InsecureChannelCredentials());
+  std::unique_ptr<fuzzer::FuzzCoordinator::Stub> coordinator =
+      fuzzer::FuzzCoordinator::NewStub(channel);
+
+  std::vector<std::unique_ptr<Thread>> workers;
+  workers.resize(worker_count);
+  std::vector<absl::Status> worker_status;
+  worker_status.resize(workers.size(),
+                       absl::InternalError("worker did not terminate."));
+  for (int64_t i = 0; i < workers.size(); ++i) {
+    workers[i] = std::make_unique<Thread>([&, i, status = &worker_status[i]] {
+      *status = RunCoordinatedSamples(i, *coordinator, ast_generator_options,
+                                      sample_options);
     });
   }
   for (int64_t i = 0; i < workers.size(); ++i) {
@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <filesystem>  // NOLINT
 #include <optional>
+#include <string_view>
 
 #include "absl/status/status.h"
 #include "absl/time/time.h"
@@ -37,6 +38,10 @@ namespace xls {
 //
 // If `force_failure` is true, every sample run will be considered a failure.
 // This is useful for testing failure paths.
+//
+// If `coverage_guided` is true, the IR of every sample is recorded in a
+// CoverageTracker shared by all workers, and each worker periodically reweights
+// the kinds of expression it generates toward the least covered ones.
 absl::Status ParallelGenerateAndRunSamples(
     int64_t worker_count,
     const dslx::AstGeneratorOptions& ast_generator_options,
@@ -47,7 +52,17 @@ absl::Status ParallelGenerateAndRunSamples(
     const std::optional<std::filesystem::path>& summary_dir = std::nullopt,
     std::optional<int64_t> sample_count = std::nullopt,
     std::optional<absl::Duration> duration = std::nullopt,
-    bool force_failure = false);
+    bool force_failure = false, bool coverage_guided = false);
+
+// Generate and run fuzzer samples on `worker_count` threads for the seeds
+// handed out by the fuzz coordinator at `coordinator_address` (see
+// fuzz_coordinator_main), until it has none left. Each seed generates exactly
+// one sample. Sample summaries and crashers are reported to the coordinator
+// rather than written locally.
+absl::Status CoordinatedGenerateAndRunSamples(
+    std::string_view coordinator_address, int64_t worker_count,
+    const dslx::AstGeneratorOptions& ast_generator_options,
+    const SampleOptions& sample_options);
 
 }  // namespace xls
 
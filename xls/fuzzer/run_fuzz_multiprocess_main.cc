@@ -42,6 +42,14 @@ ABSL_FLAG(int64_t, calls_per_sample, 128, "Arguments to generate per sample.");
 ABSL_FLAG(std::optional<std::string>, crash_path, std::nullopt,
           "Path at which to place crash data.");
 ABSL_FLAG(bool, codegen, false, "Run code generation.");
+ABSL_FLAG(std::optional<std::string>, coordinator, std::nullopt,
+          "Address (host:port) of a fuzz_coordinator_main to get seeds from "
+          "and report results to; runs until the coordinator has no seeds "
+          "left. When given, --seed, --sample_count, --duration, --crash_path, "
+          "--summary_path and --coverage_guided are ignored.");
+ABSL_FLAG(bool, coverage_guided, false,
+          "Steer sample generation toward the kinds of expression whose IR "
+          "is least covered by the samples run so far.");
 ABSL_FLAG(bool, emit_loops, true, "Emit loops in generator.");
 ABSL_FLAG(
     bool, force_failure, false,
@@ -94,6 +102,8 @@ struct Options {
   int64_t calls_per_sample;
   std::optional<std::filesystem::path> crash_path;
   bool codegen;
+  std::optional<std::string> coordinator;
+  bool coverage_guided;
   bool emit_loops;
   bool force_failure;
   bool generate_proc;
@@ -173,11 +183,17 @@ absl::Status RealMain(const Options& options) {
   sample_options.set_use_system_verilog(options.use_system_verilog);
   sample_options.set_with_valid_holdoff(options.with_valid_holdoff);
 
+  if (options.coordinator.has_value()) {
+    return CoordinatedGenerateAndRunSamples(*options.coordinator, worker_count,
+                                            ast_generator_options,
+                                            sample_options);
+  }
   return ParallelGenerateAndRunSamples(
       worker_count, ast_generator_options, sample_options, options.seed,
       /*top_run_dir=*/options.save_temps_path,
       /*crasher_dir=*/options.crash_path, /*summary_dir=*/options.summary_path,
-      options.sample_count, options.duration, options.force_failure);
+      options.sample_count, options.duration, options.force_failure,
+      options.coverage_guided);
 }
 
 }  // namespace
@@ -203,6 +219,8 @@ int main(int argc, char** argv) {
       .calls_per_sample = absl::GetFlag(FLAGS_calls_per_sample),
       .crash_path = absl::GetFlag(FLAGS_crash_path),
       .codegen = absl::GetFlag(FLAGS_codegen),
+      .coordinator = absl::GetFlag(FLAGS_coordinator),
+      .coverage_guided = absl::GetFlag(FLAGS_coverage_guided),
       .emit_loops = absl::GetFlag(FLAGS_emit_loops),
       .force_failure = absl::GetFlag(FLAGS_force_failure),
       .generate_proc = absl::GetFlag(FLAGS_generate_proc),
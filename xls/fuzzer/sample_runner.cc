@@ -29,6 +29,7 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/no_destructor.h"
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/flags/declare.h"
@@ -39,10 +40,12 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xls/common/file/filesystem.h"
@@ -79,6 +82,7 @@
 #include "xls/simulation/check_simulator.h"
 #include "xls/tests/testvector.pb.h"
 #include "xls/tools/eval_utils.h"
+#include "openssl/sha.h"
 #include "re2/re2.h"
 
 // These are used to forward, but also see comment below.
@@ -102,6 +106,21 @@ static constexpr struct BinaryPaths {
 } kBinary;
 // clang-format on
 
+// Returns the SHA-256 digest of `key`. Each part is preceded by its size so
+// that distinct keys cannot collide by concatenation.
+std::string KeyDigest(absl::Span<const std::string_view> key) {
+  SHA256_CTX context;
+  SHA256_Init(&context);
+  for (std::string_view part : key) {
+    uint64_t size = part.size();
+    SHA256_Update(&context, &size, sizeof(size));
+    SHA256_Update(&context, part.data(), part.size());
+  }
+  std::string digest(SHA256_DIGEST_LENGTH, '\0');
+  SHA256_Final(reinterpret_cast<uint8_t*>(digest.data()), &context);
+  return digest;
+}
+
 absl::StatusOr<ArgsBatch> ConvertFunctionKwargs(
     const dslx::Function* f, const dslx::ImportData& import_data,
     const dslx::TypecheckedModule& tm, const ArgsBatch& args_batch) {
@@ -348,11 +367,76 @@ absl::StatusOr<std::vector<dslx::InterpValue>> EvaluateIrFunction(
   return ParseValues(results_text);
 }
 
+// Returns the files, relative to the run directory, which a tool writes as
+// well as its stdout given `args`, i.e. those of its `--output_*_path` flags.
+std::vector<std::filesystem::path> GetSideOutputPaths(
+    absl::Span<const std::string> args) {
+  std::vector<std::filesystem::path> paths;
+  for (std::string_view arg : args) {
+    if (!absl::ConsumePrefix(&arg, "--output_")) {
+      continue;
+    }
+    std::vector<std::string_view> flag_and_value =
+        absl::StrSplit(arg, absl::MaxSplits('=', 1));
+    if (flag_and_value.size() == 2 &&
+        absl::EndsWith(flag_and_value[0], "_path")) {
+      paths.push_back(flag_and_value[1]);
+    }
+  }
+  return paths;
+}
+
+// Runs the tool `command` on the IR file `ir_path`, as RunCommand does, unless
+// `cache` holds its outputs for the same arguments and IR. The arguments other
+// than the IR file are `args`. Any files the tool writes besides its stdout are
+// restored from the cache along with it.
+absl::StatusOr<std::string> RunCachedIrCommand(
+    std::string_view desc, const SampleRunner::Commands::Callable& command,
+    std::vector<std::string> args, const std::filesystem::path& ir_path,
+    const std::filesystem::path& run_dir, const SampleOptions& options,
+    SampleArtifactCache* cache) {
+  std::vector<std::filesystem::path> side_outputs = GetSideOutputPaths(args);
+  std::string ir_text;
+  std::vector<std::string_view> key;
+  std::optional<std::vector<std::string>> cached;
+  if (cache != nullptr) {
+    XLS_ASSIGN_OR_RETURN(ir_text, GetFileContents(ir_path));
+    key.push_back(desc);
+    key.insert(key.end(), args.begin(), args.end());
+    key.push_back(ir_text);
+    cached = cache->Lookup(key);
+  }
+  if (cached.has_value()) {
+    VLOG(1) << desc << ": reusing cached outputs";
+    XLS_RET_CHECK_EQ(cached->size(), side_outputs.size() + 1);
+    for (int64_t i = 0; i < side_outputs.size(); ++i) {
+      XLS_RETURN_IF_ERROR(
+          SetFileContents(run_dir / side_outputs[i], (*cached)[i + 1]));
+    }
+    return std::move(cached->front());
+  }
+
+  std::vector<std::string> args_with_ir = args;
+  args_with_ir.push_back(ir_path.string());
+  XLS_ASSIGN_OR_RETURN(
+      std::string stdout_text,
+      RunCommand(desc, command, args_with_ir, run_dir, options));
+  if (cache != nullptr) {
+    std::vector<std::string> outputs = {stdout_text};
+    for (const std::filesystem::path& side_output : side_outputs) {
+      XLS_ASSIGN_OR_RETURN(outputs.emplace_back(),
+                           GetFileContents(run_dir / side_output));
+    }
+    cache->Insert(key, std::move(outputs));
+  }
+  return stdout_text;
+}
+
 absl::StatusOr<std::filesystem::path> Codegen(
     const std::filesystem::path& ir_path,
     absl::Span<const std::string> codegen_args, const SampleOptions& options,
     const std::filesystem::path& run_dir,
-    const SampleRunner::Commands& commands) {
+    const SampleRunner::Commands& commands, SampleArtifactCache* cache) {
   std::optional<SampleRunner::Commands::Callable> command =
       commands.codegen_main;
   if (!command.has_value()) {
@@ -364,10 +448,10 @@ absl::StatusOr<std::filesystem::path> Codegen(
       "--delay_model=unit",
   };
   args.insert(args.end(), codegen_args.begin(), codegen_args.end());
-  args.push_back(ir_path.string());
-  XLS_ASSIGN_OR_RETURN(
-      std::string verilog_text,
-      RunCommand("Generating Verilog", *command, args, run_dir, options));
+  XLS_ASSIGN_OR_RETURN(std::string verilog_text,
+                       RunCachedIrCommand("Generating Verilog", *command,
+                                          std::move(args), ir_path, run_dir,
+                                          options, cache));
   VLOG(3) << "Verilog:\n" << verilog_text;
   std::filesystem::path verilog_path =
       run_dir / (options.use_system_verilog() ? "sample.sv" : "sample.v");
@@ -379,16 +463,17 @@ absl::StatusOr<std::filesystem::path> Codegen(
 absl::StatusOr<std::filesystem::path> OptimizeIr(
     const std::filesystem::path& ir_path, const SampleOptions& options,
     const std::filesystem::path& run_dir,
-    const SampleRunner::Commands& commands) {
+    const SampleRunner::Commands& commands, SampleArtifactCache* cache) {
   std::optional<SampleRunner::Commands::Callable> command =
       commands.ir_opt_main;
   if (!command.has_value()) {
     command = CallableFromExecutable(kBinary.ir_opt_main);
   }
 
-  XLS_ASSIGN_OR_RETURN(
-      std::string opt_ir_text,
-      RunCommand("Optimizing IR", *command, {ir_path}, run_dir, options));
+  XLS_ASSIGN_OR_RETURN(std::string opt_ir_text,
+                       RunCachedIrCommand("Optimizing IR", *command,
+                                          /*args=*/{}, ir_path, run_dir,
+                                          options, cache));
   VLOG(3) << "Optimized IR:\n" << opt_ir_text;
   std::filesystem::path opt_ir_path = run_dir / "sample.opt.ir";
   XLS_RETURN_IF_ERROR(SetFileContents(opt_ir_path, opt_ir_text));
@@ -637,8 +722,7 @@ RunProc(dslx::Proc* proc, dslx::ImportData& import_data,
   for (int64_t index = 0; index < out_chan_indexes.size(); ++index) {
     std::shared_ptr<dslx::InterpValue::Channel> channel =
         config_args[out_chan_indexes[index]].GetChannelOrDie();
-    all_channel_values[out_ir_channel_names[index]] =
-        std::vector<dslx::InterpValue>(channel->begin(), channel->end());
+    all_channel_values[out_ir_channel_names[index]] = channel->GetContents();
   }
   return all_channel_values;
 }
@@ -823,6 +907,51 @@ SimulateProc(const std::filesystem::path& verilog_path,
 
 }  // namespace
 
+/* static */ SampleArtifactCache& SampleArtifactCache::ProcessWide() {
+  static absl::NoDestructor<SampleArtifactCache> cache;
+  return *cache;
+}
+
+std::optional<std::vector<std::string>> SampleArtifactCache::Lookup(
+    absl::Span<const std::string_view> key) {
+  std::string digest = KeyDigest(key);
+  absl::MutexLock lock(&mutex_);
+  auto it = entries_.find(digest);
+  if (it == entries_.end()) {
+    ++misses_;
+    return std::nullopt;
+  }
+  ++hits_;
+  return it->second;
+}
+
+void SampleArtifactCache::Insert(absl::Span<const std::string_view> key,
+                                 std::vector<std::string> outputs) {
+  std::string digest = KeyDigest(key);
+  int64_t size = 0;
+  for (const std::string& output : outputs) {
+    size += output.size();
+  }
+  absl::MutexLock lock(&mutex_);
+  if (bytes_ + size > max_bytes_) {
+    entries_.clear();
+    bytes_ = 0;
+  }
+  if (entries_.try_emplace(digest, std::move(outputs)).second) {
+    bytes_ += size;
+  }
+}
+
+int64_t SampleArtifactCache::hits() const {
+  absl::MutexLock lock(&mutex_);
+  return hits_;
+}
+
+int64_t SampleArtifactCache::misses() const {
+  absl::MutexLock lock(&mutex_);
+  return misses_;
+}
+
 absl::Status SampleRunner::Run(const Sample& sample) {
   std::filesystem::path input_path = run_dir_;
   if (sample.options().input_is_dslx()) {
@@ -950,8 +1079,9 @@ absl::Status SampleRunner::RunFunction(
 
   if (options.optimize_ir()) {
     Stopwatch t;
-    XLS_ASSIGN_OR_RETURN(std::filesystem::path opt_ir_path,
-                         OptimizeIr(ir_path, options, run_dir_, commands_));
+    XLS_ASSIGN_OR_RETURN(
+        std::filesystem::path opt_ir_path,
+        OptimizeIr(ir_path, options, run_dir_, commands_, cache_));
     timing_.set_optimize_ns(absl::ToInt64Nanoseconds(t.GetElapsedTime()));
 
     if (args_batch.has_value()) {
@@ -977,7 +1107,7 @@ absl::Status SampleRunner::RunFunction(
       t.Reset();
       XLS_ASSIGN_OR_RETURN(std::filesystem::path verilog_path,
                            Codegen(opt_ir_path, options.codegen_args(), options,
-                                   run_dir_, commands_));
+                                   run_dir_, commands_, cache_));
       timing_.set_codegen_ns(absl::ToInt64Nanoseconds(t.GetElapsedTime()));
 
       if (options.simulate()) {
@@ -1087,8 +1217,8 @@ absl::Status SampleRunner::RunProc(
   std::optional<std::filesystem::path> opt_ir_path = std::nullopt;
   if (options.optimize_ir()) {
     Stopwatch t;
-    XLS_ASSIGN_OR_RETURN(opt_ir_path,
-                         OptimizeIr(ir_path, options, run_dir_, commands_));
+    XLS_ASSIGN_OR_RETURN(
+        opt_ir_path, OptimizeIr(ir_path, options, run_dir_, commands_, cache_));
     timing_.set_optimize_ns(absl::ToInt64Nanoseconds(t.GetElapsedTime()));
 
     if (args_batch.has_value()) {
@@ -1114,7 +1244,7 @@ absl::Status SampleRunner::RunProc(
         t.Reset();
         XLS_ASSIGN_OR_RETURN(std::filesystem::path verilog_path,
                              Codegen(*opt_ir_path, options.codegen_args(),
-                                     options, run_dir_, commands_));
+                                     options, run_dir_, commands_, cache_));
         timing_.set_codegen_ns(absl::ToInt64Nanoseconds(t.GetElapsedTime()));
 
         if (options.simulate()) {
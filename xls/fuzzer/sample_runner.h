@@ -15,20 +15,63 @@
 #ifndef XLS_FUZZER_SAMPLE_RUNNER_H_
 #define XLS_FUZZER_SAMPLE_RUNNER_H_
 
+#include <cstdint>
 #include <filesystem>  // NOLINT
 #include <functional>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xls/fuzzer/sample.h"
 #include "xls/fuzzer/sample_summary.pb.h"
 
 namespace xls {
 
+// A cache of the outputs of the deterministic stages of running a sample (IR
+// optimization and code generation), keyed by a digest of everything the
+// output depends on. Sharing one between sample runners lets samples whose IR
+// is identical, as generated or once optimized, skip the repeated stages.
+//
+// Only the outputs of successful stages are cached. The cache is cleared once
+// it holds more than `max_bytes` of outputs. Thread safe.
+class SampleArtifactCache {
+ public:
+  explicit SampleArtifactCache(int64_t max_bytes = int64_t{256} << 20)
+      : max_bytes_(max_bytes) {}
+
+  // Returns the cache shared by every sample run in this process.
+  static SampleArtifactCache& ProcessWide();
+
+  // Returns the outputs stored under the digest of `key`, if any.
+  std::optional<std::vector<std::string>> Lookup(
+      absl::Span<const std::string_view> key);
+
+  // Stores `outputs` under the digest of `key`.
+  void Insert(absl::Span<const std::string_view> key,
+              std::vector<std::string> outputs);
+
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  const int64_t max_bytes_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::vector<std::string>> entries_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t hits_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
 // A class for performing various operations on a code sample.
 
 // Code sample can be in DSLX or IR. The possible operations include:
@@ -64,6 +107,13 @@ class SampleRunner {
       : run_dir_(std::move(run_dir)) {}
   SampleRunner(std::filesystem::path run_dir, Commands commands)
       : run_dir_(std::move(run_dir)), commands_(std::move(commands)) {}
+  // As above, reusing the outputs of stages already run in `cache` (which
+  // must outlive the runner).
+  SampleRunner(std::filesystem::path run_dir, Commands commands,
+               SampleArtifactCache* cache)
+      : run_dir_(std::move(run_dir)),
+        commands_(std::move(commands)),
+        cache_(cache) {}
 
   // Runs the provided sample, writing out files under the SampleRunner's
   // `run_dir` as appropriate.
@@ -89,6 +139,7 @@ class SampleRunner {
 
   const std::filesystem::path run_dir_;
   const Commands commands_;
+  SampleArtifactCache* const cache_ = nullptr;
   fuzzer::SampleTimingProto timing_;
 };
 
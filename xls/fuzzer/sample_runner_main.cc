@@ -29,6 +29,7 @@
 #include "xls/common/exit_status.h"
 #include "xls/common/file/temp_directory.h"
 #include "xls/common/init_xls.h"
+#include "xls/fuzzer/in_process_commands.h"
 #include "xls/fuzzer/sample_runner.h"
 
 constexpr std::string_view kUsage = R"(Sample runner program.
@@ -49,6 +50,9 @@ ABSL_FLAG(std::string, input_file, "", "Code input file.");
 ABSL_FLAG(std::string, testvector_textproto, "",
           "A textproto file containing the function argument or proc "
           "channel test vectors.");
+ABSL_FLAG(bool, in_process_stages, false,
+          "Evaluate and optimize IR within this process rather than running "
+          "a tool subprocess for each of those stages.");
 
 namespace xls {
 
@@ -76,7 +80,9 @@ static absl::Status RealMain(const std::filesystem::path& run_dir,
                              const std::string& options_file,
                              const std::string& input_file,
                              const std::string& testvector_file) {
-  SampleRunner runner(run_dir);
+  SampleRunner runner(run_dir, absl::GetFlag(FLAGS_in_process_stages)
+                                   ? InProcessCommands()
+                                   : SampleRunner::Commands());
   std::filesystem::path input_filename = MaybeCopyFile(input_file, run_dir);
   std::filesystem::path options_filename = MaybeCopyFile(options_file, run_dir);
   std::filesystem::path testvector_filename =
@@ -40,6 +40,7 @@
 #include "xls/dslx/interp_value.h"
 #include "xls/dslx/interp_value_utils.h"
 #include "xls/fuzzer/cpp_sample_runner.h"
+#include "xls/fuzzer/in_process_commands.h"
 #include "xls/fuzzer/sample.h"
 #include "xls/fuzzer/sample.pb.h"
 #include "xls/ir/bits.h"
@@ -303,6 +304,29 @@ TEST_F(SampleRunnerTest, EvaluateIR) {
               ElementsAre("bits[8]:0x8e", "bits[8]:0xce"));
 }
 
+TEST_F(SampleRunnerTest, EvaluateAndOptimizeIRInProcess) {
+  SampleRunner runner(GetTempPath(), InProcessCommands());
+  constexpr std::string_view dslx_text =
+      "fn main(x: u8, y: u8) -> u8 { x + y }";
+  SampleOptions options;
+  options.set_input_is_dslx(true);
+  options.set_ir_converter_args({"--top=main"});
+  options.set_use_jit(true);
+  XLS_ASSERT_OK_AND_ASSIGN(ArgsBatch args_batch,
+                           ToArgsBatch({{"bits[8]:42", "bits[8]:100"},
+                                        {"bits[8]:222", "bits[8]:240"}}));
+  XLS_ASSERT_OK(
+      runner.Run(Sample(std::string(dslx_text), options, args_batch)));
+  EXPECT_THAT(GetFileContents(GetTempPath() / "sample.opt.ir"),
+              IsOkAndHolds(HasSubstr("package sample")));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::string opt_ir_results,
+      GetFileContents(GetTempPath() / "sample.opt.ir.results"));
+  EXPECT_THAT(absl::StrSplit(absl::StripAsciiWhitespace(opt_ir_results), "\n",
+                             absl::SkipEmpty()),
+              ElementsAre("bits[8]:0x8e", "bits[8]:0xce"));
+}
+
 TEST_F(SampleRunnerTest, EvaluateIRWide) {
   SampleRunner runner(GetTempPath());
   constexpr std::string_view dslx_text =
@@ -636,6 +660,49 @@ TEST_F(SampleRunnerTest, CodegenCombinationalWrongResults) {
                        AllOf(HasSubstr("Result miscompare for sample 0"))));
 }
 
+TEST_F(SampleRunnerTest, CodegenReusesCachedArtifacts) {
+  constexpr std::string_view dslx_text =
+      "fn main(x: u8, y: u8) -> u8 { x + y }";
+  SampleOptions options;
+  options.set_input_is_dslx(true);
+  options.set_ir_converter_args({"--top=main"});
+  options.set_codegen(true);
+  options.set_codegen_args({"--generator=combinational"});
+  options.set_use_system_verilog(false);
+  options.set_simulate(true);
+  XLS_ASSERT_OK_AND_ASSIGN(ArgsBatch args_batch,
+                           ToArgsBatch({{"bits[8]:42", "bits[8]:100"}}));
+
+  SampleArtifactCache cache;
+  std::filesystem::path first_dir = GetTempPath() / "first";
+  std::filesystem::path second_dir = GetTempPath() / "second";
+  ASSERT_TRUE(std::filesystem::create_directory(first_dir));
+  ASSERT_TRUE(std::filesystem::create_directory(second_dir));
+  SampleRunner first(first_dir, SampleRunner::Commands(), &cache);
+  XLS_ASSERT_OK(first.Run(Sample(std::string(dslx_text), options, args_batch)));
+  EXPECT_EQ(cache.hits(), 0);
+
+  // The second run optimizes and generates Verilog for the same IR, so both
+  // stages are served from the cache, side outputs included.
+  SampleRunner second(second_dir, SampleRunner::Commands(), &cache);
+  XLS_ASSERT_OK(
+      second.Run(Sample(std::string(dslx_text), options, args_batch)));
+  EXPECT_EQ(cache.hits(), 2);
+  for (std::string_view file :
+       {"sample.opt.ir", "sample.v", "module_sig.textproto"}) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::string first_text,
+                             GetFileContents(first_dir / file));
+    XLS_ASSERT_OK_AND_ASSIGN(std::string second_text,
+                             GetFileContents(second_dir / file));
+    EXPECT_EQ(first_text, second_text) << file;
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::string verilog_results,
+                           GetFileContents(second_dir / "sample.v.results"));
+  EXPECT_THAT(absl::StrSplit(absl::StripAsciiWhitespace(verilog_results), "\n",
+                             absl::SkipEmpty()),
+              ElementsAre("bits[8]:0x8e"));
+}
+
 TEST_F(SampleRunnerTest, CodegenPipeline) {
   if (!DefaultSimulatorSupportsSystemVerilog()) {
     GTEST_SKIP() << "uses SystemVerilog, default simulator does not support";
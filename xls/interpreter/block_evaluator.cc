@@ -14,6 +14,8 @@
 
 #include "xls/interpreter/block_evaluator.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -36,8 +38,10 @@
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "xls/codegen/module_signature.pb.h"
+#include "xls/common/thread.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/interpreter/checkpoint.pb.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/block.h"
 #include "xls/ir/block_elaboration.h"
@@ -161,6 +165,46 @@ ConvertInputsToUint64(const absl::flat_hash_map<std::string, Value>& inputs,
   return input_uint64s;
 }
 
+// Runs `continuation` on the given columns of input port values and returns
+// the columns of output port values.
+absl::StatusOr<BlockPortColumns> RunOnColumns(BlockContinuation& continuation,
+                                              Block* block,
+                                              const BlockPortColumns& inputs) {
+  absl::Span<InputPort* const> input_ports = block->GetInputPorts();
+  if (inputs.columns.size() != input_ports.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected %d input port columns but got %d",
+                        input_ports.size(), inputs.columns.size()));
+  }
+  for (int64_t i = 0; i < input_ports.size(); ++i) {
+    if (inputs.columns[i].size() != inputs.cycle_count) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Expected %d values for input port '%s' but got %d",
+          inputs.cycle_count, input_ports[i]->GetName(),
+          inputs.columns[i].size()));
+    }
+  }
+
+  BlockPortColumns outputs{.cycle_count = inputs.cycle_count};
+  outputs.columns.resize(block->GetOutputPorts().size());
+  for (std::vector<Value>& column : outputs.columns) {
+    column.reserve(inputs.cycle_count);
+  }
+  std::vector<Value> cycle_inputs(input_ports.size());
+  for (int64_t cycle = 0; cycle < inputs.cycle_count; ++cycle) {
+    for (int64_t i = 0; i < input_ports.size(); ++i) {
+      cycle_inputs[i] = inputs.columns[i][cycle];
+    }
+    XLS_RETURN_IF_ERROR(continuation.RunOneCycleWithPortValues(cycle_inputs));
+    std::vector<Value> cycle_outputs = continuation.output_port_values();
+    XLS_RET_CHECK_EQ(cycle_outputs.size(), outputs.columns.size());
+    for (int64_t i = 0; i < cycle_outputs.size(); ++i) {
+      outputs.columns[i].push_back(std::move(cycle_outputs[i]));
+    }
+  }
+  return outputs;
+}
+
 }  // namespace
 
 absl::StatusOr<absl::flat_hash_map<std::string, Value>>
@@ -223,6 +267,75 @@ BlockEvaluator::EvaluateSequentialBlock(
   return outputs;
 }
 
+absl::StatusOr<BlockPortColumns> BlockEvaluator::EvaluateSequentialBlockColumns(
+    Block* block, const BlockPortColumns& inputs) const {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BlockContinuation> continuation,
+                       NewContinuation(block));
+  return RunOnColumns(*continuation, block, inputs);
+}
+
+absl::StatusOr<std::vector<BlockPortColumns>>
+BlockEvaluator::EvaluateSequentialBlockBatch(
+    Block* block, absl::Span<const BlockPortColumns> simulations,
+    int64_t max_threads) const {
+  if (max_threads < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("max_threads must not be negative, got %d",
+                        max_threads));
+  }
+  if (max_threads == 0) {
+    max_threads = AvailableCPUs();
+  }
+  int64_t thread_count = std::min<int64_t>(max_threads, simulations.size());
+  if (thread_count == 0) {
+    return std::vector<BlockPortColumns>();
+  }
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<std::unique_ptr<BlockContinuation>> continuations,
+      NewContinuations(block, thread_count));
+  XLS_RET_CHECK_EQ(continuations.size(), thread_count);
+
+  // Each thread takes the next simulation not yet started and runs it on its
+  // own continuation, starting from the zero registers of a fresh one.
+  absl::flat_hash_map<std::string, Value> initial_registers =
+      continuations.front()->registers();
+  std::vector<absl::StatusOr<BlockPortColumns>> results(simulations.size());
+  std::atomic<int64_t> next_simulation = 0;
+  auto run_simulations = [&](BlockContinuation& continuation) {
+    for (int64_t i = next_simulation++; i < simulations.size();
+         i = next_simulation++) {
+      absl::Status status = continuation.SetRegisters(initial_registers);
+      if (!status.ok()) {
+        results[i] = status;
+        continue;
+      }
+      results[i] = RunOnColumns(continuation, block, simulations[i]);
+    }
+  };
+  if (thread_count == 1) {
+    run_simulations(*continuations.front());
+  } else {
+    std::vector<std::unique_ptr<Thread>> threads;
+    threads.reserve(thread_count);
+    for (std::unique_ptr<BlockContinuation>& continuation : continuations) {
+      threads.push_back(std::make_unique<Thread>(
+          [&run_simulations, continuation = continuation.get()]() {
+            run_simulations(*continuation);
+          }));
+    }
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+  }
+
+  std::vector<BlockPortColumns> outputs;
+  outputs.reserve(results.size());
+  for (absl::StatusOr<BlockPortColumns>& result : results) {
+    XLS_ASSIGN_OR_RETURN(outputs.emplace_back(), std::move(result));
+  }
+  return outputs;
+}
+
 absl::Status ChannelSource::SetDataSequence(std::vector<Value> data) {
   // TODO(tedhong): 2022-03-15 - Add additional checks to ensure type of Value
   // elements in data are consistent and compatible with this channel's
@@ -446,9 +559,8 @@ BlockEvaluator::EvaluateChannelizedSequentialBlock(
     absl::c_copy(
         continuation->events().assert_msgs,
         std::back_inserter(block_io_results.interpreter_events.assert_msgs));
-    absl::c_copy(
-        continuation->events().trace_msgs,
-        std::back_inserter(block_io_results.interpreter_events.trace_msgs));
+    block_io_results.interpreter_events.trace_msgs.Append(
+        continuation->events().trace_msgs);
   }
 
   return block_io_results;
@@ -528,4 +640,34 @@ BlockEvaluator::NewContinuation(Block* block) const {
   return MakeNewContinuation(std::move(elaboration), regs);
 }
 
+absl::StatusOr<std::vector<std::unique_ptr<BlockContinuation>>>
+BlockEvaluator::NewContinuations(Block* block, int64_t count) const {
+  std::vector<std::unique_ptr<BlockContinuation>> continuations;
+  continuations.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<BlockContinuation> continuation,
+                         NewContinuation(block));
+    continuations.push_back(std::move(continuation));
+  }
+  return continuations;
+}
+
+absl::StatusOr<BlockCheckpointProto> BlockContinuation::Checkpoint() {
+  BlockCheckpointProto checkpoint;
+  for (const auto& [name, value] : registers()) {
+    XLS_ASSIGN_OR_RETURN((*checkpoint.mutable_registers())[name],
+                         value.AsProto());
+  }
+  return checkpoint;
+}
+
+absl::Status BlockContinuation::Restore(
+    const BlockCheckpointProto& checkpoint) {
+  absl::flat_hash_map<std::string, Value> regs;
+  for (const auto& [name, value] : checkpoint.registers()) {
+    XLS_ASSIGN_OR_RETURN(regs[name], Value::FromProto(value));
+  }
+  return SetRegisters(regs);
+}
+
 }  // namespace xls
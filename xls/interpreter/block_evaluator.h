@@ -28,6 +28,7 @@
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "xls/codegen/module_signature.pb.h"
+#include "xls/interpreter/checkpoint.pb.h"
 #include "xls/interpreter/observer.h"
 #include "xls/ir/block.h"
 #include "xls/ir/block_elaboration.h"
@@ -204,6 +205,15 @@ struct BlockIOResults {
   InterpreterEvents interpreter_events;
 };
 
+// The values of the input or output ports of a block over a number of cycles,
+// stored by port: `columns[i][c]` is the value of port `i` in cycle `c`. Input
+// and output ports are numbered in the order of Block::GetInputPorts() and
+// Block::GetOutputPorts() respectively.
+struct BlockPortColumns {
+  int64_t cycle_count = 0;
+  std::vector<std::vector<Value>> columns;
+};
+
 struct BlockIOResultsAsUint64 {
   std::vector<absl::flat_hash_map<std::string, uint64_t>> inputs;
   std::vector<absl::flat_hash_map<std::string, uint64_t>> outputs;
@@ -263,6 +273,22 @@ class BlockEvaluator {
       absl::Span<const absl::flat_hash_map<std::string, uint64_t>> inputs)
       const;
 
+  // Variant of EvaluateSequentialBlock which takes and returns the port values
+  // by port index rather than by name (see BlockPortColumns), so no maps of
+  // port names are built or looked up each cycle. `inputs` must have a column
+  // of `inputs.cycle_count` values for each input port.
+  absl::StatusOr<BlockPortColumns> EvaluateSequentialBlockColumns(
+      Block* block, const BlockPortColumns& inputs) const;
+
+  // Runs independent simulations of a block, e.g., one per test vector, as
+  // with EvaluateSequentialBlockColumns. Every simulation starts with all
+  // registers zero. The simulations are spread over up to `max_threads`
+  // threads, or all available CPUs if `max_threads` is zero. Returns the
+  // outputs of each simulation in order.
+  absl::StatusOr<std::vector<BlockPortColumns>> EvaluateSequentialBlockBatch(
+      Block* block, absl::Span<const BlockPortColumns> simulations,
+      int64_t max_threads = 0) const;
+
   // Runs the evaluator on a block.  Each input port in the block
   // should be given a sequence of data values to drive the block.
   //
@@ -366,6 +392,12 @@ class BlockEvaluator {
                       const absl::flat_hash_map<std::string, Value>&
                           initial_registers) const = 0;
 
+  // Returns `count` continuations of `block` with all registers zero, for
+  // independent simulations run concurrently. Evaluators which compile the
+  // block may share the compiled code between the continuations.
+  virtual absl::StatusOr<std::vector<std::unique_ptr<BlockContinuation>>>
+  NewContinuations(Block* block, int64_t count) const;
+
   std::string_view name_;
 };
 
@@ -387,10 +419,21 @@ class BlockContinuation {
   // register state.
   virtual absl::Status RunOneCycle(
       const absl::flat_hash_map<std::string, Value>& inputs) = 0;
+  // Variants of RunOneCycle and output_ports with the ports given in the order
+  // of Block::GetInputPorts() and Block::GetOutputPorts(), which avoid
+  // building and hashing maps of port names each cycle.
+  virtual absl::Status RunOneCycleWithPortValues(
+      absl::Span<const Value> inputs) = 0;
+  virtual std::vector<Value> output_port_values() = 0;
   // Update the registers to the give values.
   virtual absl::Status SetRegisters(
       const absl::flat_hash_map<std::string, Value>& regs) = 0;
 
+  // Returns a snapshot of the registers which may be restored with Restore,
+  // possibly into a continuation of a different evaluator of the same block.
+  absl::StatusOr<BlockCheckpointProto> Checkpoint();
+  absl::Status Restore(const BlockCheckpointProto& checkpoint);
+
   // Set an evaluation observer to get reports of the value of each node.
   virtual absl::Status SetObserver(EvaluationObserver* obs) = 0;
   // Clear any evaluation observer
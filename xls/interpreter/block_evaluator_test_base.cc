@@ -35,6 +35,7 @@
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/block_evaluator.h"
+#include "xls/interpreter/checkpoint.pb.h"
 #include "xls/interpreter/observer.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/block.h"
@@ -944,6 +945,70 @@ TEST_P(BlockEvaluatorTest, AccumulatorRegister) {
   EXPECT_THAT(outputs.at(4), UnorderedElementsAre(Pair("out", 15)));
 }
 
+TEST_P(BlockEvaluatorTest, AccumulatorRegisterColumns) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Register * reg,
+      b.block()->AddRegister("accum", package->GetBitsType(32)));
+
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue y = b.InputPort("y", package->GetBitsType(32));
+  BValue accum = b.RegisterRead(reg);
+  BValue next_accum = b.Add(b.Add(x, y), accum);
+  b.RegisterWrite(reg, next_accum);
+  b.OutputPort("out", next_accum);
+  b.OutputPort("x_out", x);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  auto column = [](absl::Span<const uint64_t> values) {
+    std::vector<Value> result;
+    for (uint64_t value : values) {
+      result.push_back(Value(UBits(value, 32)));
+    }
+    return result;
+  };
+  BlockPortColumns inputs{.cycle_count = 3,
+                          .columns = {column({1, 2, 3}), column({10, 0, 5})}};
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BlockPortColumns outputs,
+      evaluator().EvaluateSequentialBlockColumns(block, inputs));
+  EXPECT_EQ(outputs.cycle_count, 3);
+  EXPECT_THAT(outputs.columns,
+              ElementsAre(column({11, 13, 21}), column({1, 2, 3})));
+
+  // Each simulation of a batch starts from zero registers, regardless of the
+  // thread it runs on.
+  std::vector<BlockPortColumns> simulations;
+  for (uint64_t i = 0; i < 16; ++i) {
+    simulations.push_back(BlockPortColumns{
+        .cycle_count = 2, .columns = {column({i, i}), column({0, 1})}});
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<BlockPortColumns> batch_outputs,
+      evaluator().EvaluateSequentialBlockBatch(block, simulations,
+                                               /*max_threads=*/4));
+  ASSERT_EQ(batch_outputs.size(), simulations.size());
+  for (uint64_t i = 0; i < 16; ++i) {
+    EXPECT_THAT(batch_outputs[i].columns,
+                ElementsAre(column({i, 2 * i + 1}), column({i, i})));
+  }
+
+  EXPECT_THAT(evaluator().EvaluateSequentialBlockColumns(
+                  block, BlockPortColumns{.cycle_count = 3,
+                                          .columns = {column({1, 2, 3})}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected 2 input port columns")));
+  EXPECT_THAT(evaluator().EvaluateSequentialBlockBatch(
+                  block, {BlockPortColumns{.cycle_count = 3,
+                                           .columns = {column({1, 2, 3}),
+                                                       column({1, 2})}}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected 3 values for input port 'y'")));
+}
+
 TEST_P(BlockEvaluatorTest, ChannelizedAccumulatorRegister) {
   auto package = CreatePackage();
   BlockBuilder b(TestName(), package.get());
@@ -1576,6 +1641,40 @@ TEST_P(BlockEvaluatorTest, SetRegistersContinuation) {
   }
 }
 
+TEST_P(BlockEvaluatorTest, CheckpointAndRestoreContinuation) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Register * reg,
+      b.block()->AddRegister("accum", package->GetBitsType(32)));
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue next_accum = b.Add(x, b.RegisterRead(reg));
+  b.RegisterWrite(reg, next_accum);
+  b.OutputPort("out", next_accum);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto cont, evaluator().NewContinuation(block));
+  XLS_ASSERT_OK(cont->SetRegisters({{"accum", Value(UBits(0, 32))}}));
+  XLS_ASSERT_OK(cont->RunOneCycle({{"x", Value(UBits(1, 32))}}));
+  XLS_ASSERT_OK(cont->RunOneCycle({{"x", Value(UBits(2, 32))}}));
+  XLS_ASSERT_OK_AND_ASSIGN(BlockCheckpointProto checkpoint,
+                           cont->Checkpoint());
+  XLS_ASSERT_OK(cont->RunOneCycle({{"x", Value(UBits(3, 32))}}));
+  EXPECT_THAT(cont->output_ports(),
+              UnorderedElementsAre(Pair("out", Value(UBits(6, 32)))));
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto restored, evaluator().NewContinuation(block));
+  for (BlockContinuation* c : {cont.get(), restored.get()}) {
+    XLS_ASSERT_OK(c->Restore(checkpoint));
+    EXPECT_THAT(c->registers(),
+                UnorderedElementsAre(Pair("accum", Value(UBits(3, 32)))));
+    XLS_ASSERT_OK(c->RunOneCycle({{"x", Value(UBits(10, 32))}}));
+    EXPECT_THAT(c->output_ports(),
+                UnorderedElementsAre(Pair("out", Value(UBits(13, 32)))));
+  }
+}
+
 TEST_P(BlockEvaluatorTest, DelaysContinuation) {
   auto package = CreatePackage();
   BlockBuilder b(TestName(), package.get());
@@ -37,6 +37,7 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/block_evaluator.h"
 #include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/node_value_map.h"
 #include "xls/interpreter/observer.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/block.h"
@@ -67,7 +68,7 @@ class BlockInterpreter final : public IrInterpreter {
         register_prefix_(register_prefix),
         reg_state_(reg_state),
         next_reg_state_(next_reg_state) {
-    NodeValuesMap().reserve(block->node_count());
+    NodeValuesMap() = NodeValueMap(block);
   }
 
   // Ports and InstantiationInputs/Outputs are handled by the
@@ -909,6 +910,29 @@ class StatelessBlockContinuation final : public BlockContinuation {
     return absl::OkStatus();
   }
 
+  // The interpreter works on maps of port values anyway, so these only save
+  // the caller from building them.
+  absl::Status RunOneCycleWithPortValues(absl::Span<const Value> inputs) final {
+    Block* top_block = *elaboration_.top()->block();
+    XLS_RET_CHECK_EQ(inputs.size(), top_block->GetInputPorts().size());
+    absl::flat_hash_map<std::string, Value> input_map;
+    input_map.reserve(inputs.size());
+    for (int64_t i = 0; i < inputs.size(); ++i) {
+      input_map.emplace(top_block->GetInputPorts()[i]->name(), inputs[i]);
+    }
+    return RunOneCycle(input_map);
+  }
+
+  std::vector<Value> output_port_values() final {
+    Block* top_block = *elaboration_.top()->block();
+    std::vector<Value> values;
+    values.reserve(top_block->GetOutputPorts().size());
+    for (OutputPort* port : top_block->GetOutputPorts()) {
+      values.push_back(last_result_.outputs.at(port->name()));
+    }
+    return values;
+  }
+
   absl::Status SetRegisters(
       const absl::flat_hash_map<std::string, Value>& regs) final {
     XLS_RET_CHECK_EQ(regs.size(), last_result_.reg_state.size());
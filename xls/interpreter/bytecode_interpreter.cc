@@ -0,0 +1,569 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/bytecode_interpreter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/numeric/bits.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/span.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/node_value_map.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/keyword_args.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+// Returns true if values of type `type` are held in word slots.
+bool IsWordType(Type* type) {
+  return type->IsBits() && type->AsBitsOrDie()->bit_count() <= 64;
+}
+
+uint64_t WidthMask(int64_t width) {
+  return width >= 64 ? std::numeric_limits<uint64_t>::max()
+                     : (uint64_t{1} << width) - 1;
+}
+
+int64_t SignExtend(uint64_t value, int64_t width) {
+  if (width == 0) {
+    return 0;
+  }
+  if (width >= 64) {
+    return static_cast<int64_t>(value);
+  }
+  int64_t shift = 64 - width;
+  return static_cast<int64_t>(value << shift) >> shift;
+}
+
+}  // namespace
+
+/* static */ absl::StatusOr<std::unique_ptr<BytecodeFunction>>
+BytecodeFunction::Create(Function* function) {
+  auto bytecode = absl::WrapUnique(new BytecodeFunction(function));
+  XLS_RETURN_IF_ERROR(bytecode->Lower());
+  return bytecode;
+}
+
+absl::Status BytecodeFunction::Lower() {
+  std::vector<Node*> order = TopoSort(function_);
+
+  // Position in `order` of the last instruction reading each node.
+  absl::flat_hash_map<Node*, int64_t> last_use;
+  for (int64_t i = 0; i < order.size(); ++i) {
+    for (Node* operand : order[i]->operands()) {
+      last_use[operand] = i;
+    }
+  }
+  last_use[function_->return_value()] = order.size();
+
+  absl::flat_hash_map<Node*, Slot> slots;
+  std::vector<int32_t> free_word_slots;
+  std::vector<int32_t> free_value_slots;
+  auto allocate = [&](Node* node) {
+    bool is_word = IsWordType(node->GetType());
+    std::vector<int32_t>& free_slots =
+        is_word ? free_word_slots : free_value_slots;
+    int64_t& slot_count = is_word ? word_slot_count_ : value_slot_count_;
+    Slot slot{.is_word = is_word};
+    if (free_slots.empty()) {
+      slot.index = slot_count++;
+    } else {
+      slot.index = free_slots.back();
+      free_slots.pop_back();
+    }
+    slots[node] = slot;
+    return slot;
+  };
+  auto release = [&](Slot slot) {
+    (slot.is_word ? free_word_slots : free_value_slots).push_back(slot.index);
+  };
+
+  for (int64_t i = 0; i < order.size(); ++i) {
+    Node* node = order[i];
+    Instruction instruction{
+        .opcode = Opcode::kGeneric,
+        .width = 0,
+        .operand_begin = static_cast<int32_t>(operand_slots_.size()),
+        .operand_count = static_cast<int32_t>(node->operand_count()),
+        .immediate = 0,
+        .node = node,
+    };
+    bool all_words = IsWordType(node->GetType());
+    for (Node* operand : node->operands()) {
+      operand_slots_.push_back(slots.at(operand));
+      operand_widths_.push_back(
+          operand->GetType()->IsBits() ? operand->BitCountOrDie() : 0);
+      all_words = all_words && IsWordType(operand->GetType());
+    }
+    if (IsWordType(node->GetType())) {
+      instruction.width = node->BitCountOrDie();
+    }
+
+    if (node->Is<Param>()) {
+      instruction.opcode = Opcode::kParam;
+      XLS_ASSIGN_OR_RETURN(instruction.immediate,
+                           function_->GetParamIndex(node->As<Param>()));
+    } else if (all_words) {
+      switch (node->op()) {
+        case Op::kLiteral: {
+          instruction.opcode = Opcode::kLiteral;
+          XLS_ASSIGN_OR_RETURN(instruction.immediate,
+                               node->As<Literal>()->value().bits().ToUint64());
+          break;
+        }
+        case Op::kIdentity:
+          instruction.opcode = Opcode::kIdentity;
+          break;
+        case Op::kAdd:
+          instruction.opcode = Opcode::kAdd;
+          break;
+        case Op::kSub:
+          instruction.opcode = Opcode::kSub;
+          break;
+        case Op::kUMul:
+          instruction.opcode = Opcode::kUMul;
+          break;
+        case Op::kSMul:
+          instruction.opcode = Opcode::kSMul;
+          break;
+        case Op::kUDiv:
+          instruction.opcode = Opcode::kUDiv;
+          break;
+        case Op::kUMod:
+          instruction.opcode = Opcode::kUMod;
+          break;
+        case Op::kNeg:
+          instruction.opcode = Opcode::kNeg;
+          break;
+        case Op::kNot:
+          instruction.opcode = Opcode::kNot;
+          break;
+        case Op::kAnd:
+          instruction.opcode = Opcode::kAnd;
+          break;
+        case Op::kOr:
+          instruction.opcode = Opcode::kOr;
+          break;
+        case Op::kXor:
+          instruction.opcode = Opcode::kXor;
+          break;
+        case Op::kNand:
+          instruction.opcode = Opcode::kNand;
+          break;
+        case Op::kNor:
+          instruction.opcode = Opcode::kNor;
+          break;
+        case Op::kAndReduce:
+          instruction.opcode = Opcode::kAndReduce;
+          break;
+        case Op::kOrReduce:
+          instruction.opcode = Opcode::kOrReduce;
+          break;
+        case Op::kXorReduce:
+          instruction.opcode = Opcode::kXorReduce;
+          break;
+        case Op::kShll:
+          instruction.opcode = Opcode::kShll;
+          break;
+        case Op::kShrl:
+          instruction.opcode = Opcode::kShrl;
+          break;
+        case Op::kShra:
+          instruction.opcode = Opcode::kShra;
+          break;
+        case Op::kEq:
+          instruction.opcode = Opcode::kEq;
+          break;
+        case Op::kNe:
+          instruction.opcode = Opcode::kNe;
+          break;
+        case Op::kULt:
+          instruction.opcode = Opcode::kULt;
+          break;
+        case Op::kULe:
+          instruction.opcode = Opcode::kULe;
+          break;
+        case Op::kUGt:
+          instruction.opcode = Opcode::kUGt;
+          break;
+        case Op::kUGe:
+          instruction.opcode = Opcode::kUGe;
+          break;
+        case Op::kSLt:
+          instruction.opcode = Opcode::kSLt;
+          break;
+        case Op::kSLe:
+          instruction.opcode = Opcode::kSLe;
+          break;
+        case Op::kSGt:
+          instruction.opcode = Opcode::kSGt;
+          break;
+        case Op::kSGe:
+          instruction.opcode = Opcode::kSGe;
+          break;
+        case Op::kBitSlice:
+          instruction.opcode = Opcode::kBitSlice;
+          instruction.immediate = node->As<BitSlice>()->start();
+          break;
+        case Op::kDynamicBitSlice:
+          instruction.opcode = Opcode::kDynamicBitSlice;
+          break;
+        case Op::kConcat:
+          instruction.opcode = Opcode::kConcat;
+          break;
+        case Op::kZeroExt:
+          instruction.opcode = Opcode::kZeroExt;
+          break;
+        case Op::kSignExt:
+          instruction.opcode = Opcode::kSignExt;
+          break;
+        case Op::kSel:
+          instruction.opcode = Opcode::kSel;
+          instruction.immediate =
+              node->As<Select>()->default_value().has_value() ? 1 : 0;
+          break;
+        case Op::kOneHotSel:
+          instruction.opcode = Opcode::kOneHotSel;
+          break;
+        case Op::kPrioritySel:
+          instruction.opcode = Opcode::kPrioritySel;
+          break;
+        case Op::kGate:
+          instruction.opcode = Opcode::kGate;
+          break;
+        default:
+          break;
+      }
+    }
+
+    // Instructions read all of their operands before writing their result so
+    // the result may reuse the slot of an operand it kills.
+    for (int64_t j = 0; j < node->operand_count(); ++j) {
+      Node* operand = node->operand(j);
+      bool first_occurrence = true;
+      for (int64_t k = 0; k < j; ++k) {
+        first_occurrence = first_occurrence && node->operand(k) != operand;
+      }
+      if (first_occurrence && last_use.at(operand) == i) {
+        release(slots.at(operand));
+      }
+    }
+    instruction.result = allocate(node);
+    if (!last_use.contains(node)) {
+      // The result is never read.
+      release(instruction.result);
+    }
+    instructions_.push_back(instruction);
+  }
+  return_slot_ = slots.at(function_->return_value());
+  VLOG(3) << "Bytecode for function " << function_->name() << ":\n"
+          << ToString();
+  return absl::OkStatus();
+}
+
+Value BytecodeFunction::ResolveAsValue(Slot slot, Node* node,
+                                       absl::Span<const uint64_t> words,
+                                       absl::Span<const Value> values) const {
+  if (slot.is_word) {
+    return Value(UBits(words[slot.index], node->BitCountOrDie()));
+  }
+  return values[slot.index];
+}
+
+absl::Status BytecodeFunction::RunGeneric(const Instruction& instruction,
+                                          absl::Span<uint64_t> words,
+                                          absl::Span<Value> values,
+                                          InterpreterEvents& events) const {
+  Node* node = instruction.node;
+  NodeValueMap node_values;
+  for (int64_t i = 0; i < instruction.operand_count; ++i) {
+    node_values.Set(node->operand(i),
+                    ResolveAsValue(operand_slots_[instruction.operand_begin + i],
+                                   node->operand(i), words, values));
+  }
+  IrInterpreter interpreter(&node_values, &events);
+  XLS_RETURN_IF_ERROR(node->VisitSingleNode(&interpreter));
+  const Value& result = node_values.at(node);
+  if (instruction.result.is_word) {
+    XLS_ASSIGN_OR_RETURN(words[instruction.result.index],
+                         result.bits().ToUint64());
+  } else {
+    values[instruction.result.index] = result;
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<InterpreterResult<Value>> BytecodeFunction::Run(
+    absl::Span<const Value> args) const {
+  if (args.size() != function_->params().size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Function `%s` (type: `%s`) wants %d arguments, got %d.",
+        function_->name(), function_->GetType()->ToString(),
+        function_->params().size(), args.size()));
+  }
+  for (int64_t argno = 0; argno < args.size(); ++argno) {
+    Type* param_type = function_->param(argno)->GetType();
+    if (function_->package()->GetTypeForValue(args[argno]) != param_type) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Got argument %s for parameter %d which is not of type %s",
+          args[argno].ToString(), argno, param_type->ToString()));
+    }
+  }
+
+  std::vector<uint64_t> words(word_slot_count_);
+  std::vector<Value> values(value_slot_count_);
+  InterpreterEvents events;
+  for (const Instruction& instruction : instructions_) {
+    const Slot* operands = operand_slots_.data() + instruction.operand_begin;
+    const int32_t* widths = operand_widths_.data() + instruction.operand_begin;
+    auto word = [&](int64_t i) { return words[operands[i].index]; };
+    uint64_t result;
+    switch (instruction.opcode) {
+      case Opcode::kParam: {
+        const Value& arg = args[instruction.immediate];
+        if (!instruction.result.is_word) {
+          values[instruction.result.index] = arg;
+          continue;
+        }
+        XLS_ASSIGN_OR_RETURN(result, arg.bits().ToUint64());
+        break;
+      }
+      case Opcode::kLiteral:
+        result = instruction.immediate;
+        break;
+      case Opcode::kIdentity:
+      case Opcode::kZeroExt:
+        result = word(0);
+        break;
+      case Opcode::kAdd:
+        result = word(0) + word(1);
+        break;
+      case Opcode::kSub:
+        result = word(0) - word(1);
+        break;
+      case Opcode::kUMul:
+        result = word(0) * word(1);
+        break;
+      case Opcode::kSMul:
+        result = static_cast<uint64_t>(SignExtend(word(0), widths[0])) *
+                 static_cast<uint64_t>(SignExtend(word(1), widths[1]));
+        break;
+      case Opcode::kUDiv:
+        result = word(1) == 0 ? WidthMask(instruction.width) : word(0) / word(1);
+        break;
+      case Opcode::kUMod:
+        result = word(1) == 0 ? 0 : word(0) % word(1);
+        break;
+      case Opcode::kNeg:
+        result = -word(0);
+        break;
+      case Opcode::kNot:
+        result = ~word(0);
+        break;
+      case Opcode::kAnd:
+      case Opcode::kNand:
+        result = std::numeric_limits<uint64_t>::max();
+        for (int64_t i = 0; i < instruction.operand_count; ++i) {
+          result &= word(i);
+        }
+        if (instruction.opcode == Opcode::kNand) {
+          result = ~result;
+        }
+        break;
+      case Opcode::kOr:
+      case Opcode::kNor:
+        result = 0;
+        for (int64_t i = 0; i < instruction.operand_count; ++i) {
+          result |= word(i);
+        }
+        if (instruction.opcode == Opcode::kNor) {
+          result = ~result;
+        }
+        break;
+      case Opcode::kXor:
+        result = 0;
+        for (int64_t i = 0; i < instruction.operand_count; ++i) {
+          result ^= word(i);
+        }
+        break;
+      case Opcode::kAndReduce:
+        result = word(0) == WidthMask(widths[0]) ? 1 : 0;
+        break;
+      case Opcode::kOrReduce:
+        result = word(0) != 0 ? 1 : 0;
+        break;
+      case Opcode::kXorReduce:
+        result = absl::popcount(word(0)) & 1;
+        break;
+      case Opcode::kShll:
+        result = word(1) >= instruction.width ? 0 : word(0) << word(1);
+        break;
+      case Opcode::kShrl:
+        result = word(1) >= instruction.width ? 0 : word(0) >> word(1);
+        break;
+      case Opcode::kShra: {
+        int64_t value = SignExtend(word(0), instruction.width);
+        result = static_cast<uint64_t>(value >> std::min<uint64_t>(word(1), 63));
+        break;
+      }
+      case Opcode::kEq:
+        result = word(0) == word(1) ? 1 : 0;
+        break;
+      case Opcode::kNe:
+        result = word(0) != word(1) ? 1 : 0;
+        break;
+      case Opcode::kULt:
+        result = word(0) < word(1) ? 1 : 0;
+        break;
+      case Opcode::kULe:
+        result = word(0) <= word(1) ? 1 : 0;
+        break;
+      case Opcode::kUGt:
+        result = word(0) > word(1) ? 1 : 0;
+        break;
+      case Opcode::kUGe:
+        result = word(0) >= word(1) ? 1 : 0;
+        break;
+      case Opcode::kSLt:
+        result = SignExtend(word(0), widths[0]) < SignExtend(word(1), widths[1])
+                     ? 1
+                     : 0;
+        break;
+      case Opcode::kSLe:
+        result =
+            SignExtend(word(0), widths[0]) <= SignExtend(word(1), widths[1])
+                ? 1
+                : 0;
+        break;
+      case Opcode::kSGt:
+        result = SignExtend(word(0), widths[0]) > SignExtend(word(1), widths[1])
+                     ? 1
+                     : 0;
+        break;
+      case Opcode::kSGe:
+        result =
+            SignExtend(word(0), widths[0]) >= SignExtend(word(1), widths[1])
+                ? 1
+                : 0;
+        break;
+      case Opcode::kBitSlice:
+        result = instruction.immediate >= 64 ? 0
+                                             : word(0) >> instruction.immediate;
+        break;
+      case Opcode::kDynamicBitSlice:
+        result = word(1) >= widths[0] ? 0 : word(0) >> word(1);
+        break;
+      case Opcode::kConcat:
+        // Operand zero is the most significant.
+        result = 0;
+        for (int64_t i = 0; i < instruction.operand_count; ++i) {
+          result = (widths[i] >= 64 ? 0 : result << widths[i]) | word(i);
+        }
+        break;
+      case Opcode::kSignExt:
+        result = static_cast<uint64_t>(SignExtend(word(0), widths[0]));
+        break;
+      case Opcode::kSel: {
+        uint64_t selector = word(0);
+        uint64_t case_count =
+            instruction.operand_count - 1 - instruction.immediate;
+        result = selector < case_count
+                     ? word(1 + selector)
+                     : word(instruction.operand_count - 1);
+        break;
+      }
+      case Opcode::kOneHotSel: {
+        uint64_t selector = word(0);
+        result = 0;
+        for (int64_t i = 1; i < instruction.operand_count; ++i) {
+          if ((selector >> (i - 1)) & 1) {
+            result |= word(i);
+          }
+        }
+        break;
+      }
+      case Opcode::kPrioritySel: {
+        uint64_t selector = word(0);
+        result = selector == 0 ? word(instruction.operand_count - 1)
+                               : word(1 + absl::countr_zero(selector));
+        break;
+      }
+      case Opcode::kGate:
+        result = word(0) != 0 ? word(1) : 0;
+        break;
+      case Opcode::kGeneric:
+        XLS_RETURN_IF_ERROR(
+            RunGeneric(instruction, absl::MakeSpan(words),
+                       absl::MakeSpan(values), events));
+        continue;
+    }
+    words[instruction.result.index] = result & WidthMask(instruction.width);
+  }
+  return InterpreterResult<Value>{
+      ResolveAsValue(return_slot_, function_->return_value(), words, values),
+      std::move(events)};
+}
+
+absl::StatusOr<InterpreterResult<Value>> BytecodeFunction::Run(
+    const absl::flat_hash_map<std::string, Value>& kwargs) const {
+  XLS_ASSIGN_OR_RETURN(std::vector<Value> positional_args,
+                       KeywordArgsToPositional(*function_, kwargs));
+  return Run(positional_args);
+}
+
+std::string BytecodeFunction::ToString() const {
+  auto slot_to_string = [](Slot slot) {
+    return absl::StrFormat("%c%d", slot.is_word ? 'w' : 'v', slot.index);
+  };
+  std::vector<std::string> lines;
+  lines.reserve(instructions_.size());
+  for (const Instruction& instruction : instructions_) {
+    std::vector<std::string> operands;
+    for (int64_t i = 0; i < instruction.operand_count; ++i) {
+      operands.push_back(
+          slot_to_string(operand_slots_[instruction.operand_begin + i]));
+    }
+    lines.push_back(absl::StrFormat(
+        "%s = %s%s(%s)  // %s", slot_to_string(instruction.result),
+        instruction.opcode == Opcode::kGeneric ? "interpret " : "",
+        OpToString(instruction.node->op()), absl::StrJoin(operands, ", "),
+        instruction.node->GetName()));
+  }
+  return absl::StrJoin(lines, "\n");
+}
+
+}  // namespace xls
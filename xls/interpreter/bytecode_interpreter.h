@@ -0,0 +1,162 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_INTERPRETER_BYTECODE_INTERPRETER_H_
+#define XLS_INTERPRETER_BYTECODE_INTERPRETER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// An evaluator tier between the IrInterpreter and the JIT. The function is
+// lowered once into a linear sequence of instructions over register slots and
+// then run with a dispatch loop, so repeated evaluation pays neither for
+// visiting the graph nor for an LLVM compile.
+//
+// Bits values of at most 64 bits are held in 64-bit word slots and the common
+// operations on them are executed directly. All other values are held in
+// Value slots and the nodes producing or consuming them are evaluated by the
+// IrInterpreter, so every function the interpreter supports is supported here.
+// Slots are reused once the value they hold is dead.
+class BytecodeFunction {
+ public:
+  // Lowers `function` into bytecode. `function` must outlive the returned
+  // object and must not be modified while it is alive.
+  static absl::StatusOr<std::unique_ptr<BytecodeFunction>> Create(
+      Function* function);
+
+  // Runs the function with the given arguments. May be called concurrently.
+  absl::StatusOr<InterpreterResult<Value>> Run(
+      absl::Span<const Value> args) const;
+
+  // As above, but with the arguments given by parameter name.
+  absl::StatusOr<InterpreterResult<Value>> Run(
+      const absl::flat_hash_map<std::string, Value>& kwargs) const;
+
+  Function* function() const { return function_; }
+
+  // Number of instructions and register slots of each kind in the lowered
+  // function.
+  int64_t instruction_count() const { return instructions_.size(); }
+  int64_t word_slot_count() const { return word_slot_count_; }
+  int64_t value_slot_count() const { return value_slot_count_; }
+
+  // Returns a human readable listing of the bytecode.
+  std::string ToString() const;
+
+ private:
+  enum class Opcode : uint8_t {
+    kParam,
+    kLiteral,
+    kIdentity,
+    kAdd,
+    kSub,
+    kUMul,
+    kSMul,
+    kUDiv,
+    kUMod,
+    kNeg,
+    kNot,
+    kAnd,
+    kOr,
+    kXor,
+    kNand,
+    kNor,
+    kAndReduce,
+    kOrReduce,
+    kXorReduce,
+    kShll,
+    kShrl,
+    kShra,
+    kEq,
+    kNe,
+    kULt,
+    kULe,
+    kUGt,
+    kUGe,
+    kSLt,
+    kSLe,
+    kSGt,
+    kSGe,
+    kBitSlice,
+    kDynamicBitSlice,
+    kConcat,
+    kZeroExt,
+    kSignExt,
+    kSel,
+    kOneHotSel,
+    kPrioritySel,
+    kGate,
+    // Evaluates the node with the IrInterpreter.
+    kGeneric,
+  };
+
+  // Where the value of a node is held during evaluation.
+  struct Slot {
+    bool is_word;
+    int32_t index;
+  };
+
+  struct Instruction {
+    Opcode opcode;
+    // Bit count of the result if it is held in a word slot.
+    int32_t width;
+    Slot result;
+    // Operands of the instruction are operand_slots_[operand_begin, ...,
+    // operand_begin + operand_count - 1] with bit counts (if bits typed) in
+    // the same positions of operand_widths_.
+    int32_t operand_begin;
+    int32_t operand_count;
+    // Opcode-specific immediate: the parameter index, literal value, slice
+    // start, or whether a select has a default.
+    uint64_t immediate;
+    Node* node;
+  };
+
+  explicit BytecodeFunction(Function* function) : function_(function) {}
+
+  absl::Status Lower();
+
+  // Evaluates `instruction` with the IrInterpreter.
+  absl::Status RunGeneric(const Instruction& instruction,
+                          absl::Span<uint64_t> words,
+                          absl::Span<Value> values,
+                          InterpreterEvents& events) const;
+
+  Value ResolveAsValue(Slot slot, Node* node, absl::Span<const uint64_t> words,
+                       absl::Span<const Value> values) const;
+
+  Function* function_;
+  std::vector<Instruction> instructions_;
+  std::vector<Slot> operand_slots_;
+  std::vector<int32_t> operand_widths_;
+  int64_t word_slot_count_ = 0;
+  int64_t value_slot_count_ = 0;
+  Slot return_slot_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_BYTECODE_INTERPRETER_H_
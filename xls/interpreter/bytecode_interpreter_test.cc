@@ -0,0 +1,151 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/bytecode_interpreter.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/ir_evaluator_test_base.h"
+#include "xls/interpreter/observer.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::FieldsAre;
+using ::testing::HasSubstr;
+
+absl::StatusOr<InterpreterResult<Value>> RunBytecode(
+    Function* function, absl::Span<const Value> args,
+    std::optional<EvaluationObserver*> observer) {
+  if (observer.has_value()) {
+    return absl::UnimplementedError("Observers are not supported.");
+  }
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BytecodeFunction> bytecode,
+                       BytecodeFunction::Create(function));
+  return bytecode->Run(args);
+}
+
+absl::StatusOr<InterpreterResult<Value>> RunBytecodeKwargs(
+    Function* function, const absl::flat_hash_map<std::string, Value>& kwargs,
+    std::optional<EvaluationObserver*> observer) {
+  if (observer.has_value()) {
+    return absl::UnimplementedError("Observers are not supported.");
+  }
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BytecodeFunction> bytecode,
+                       BytecodeFunction::Create(function));
+  return bytecode->Run(kwargs);
+}
+
+INSTANTIATE_TEST_SUITE_P(BytecodeInterpreterTest, IrEvaluatorTestBase,
+                         testing::Values(IrEvaluatorTestParam(
+                             RunBytecode, RunBytecodeKwargs, false)));
+
+class BytecodeInterpreterOnlyTest : public IrTestBase {};
+
+TEST_F(BytecodeInterpreterOnlyTest, SlotsAreReused) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue acc = x;
+  for (int64_t i = 0; i < 100; ++i) {
+    acc = fb.Add(acc, fb.Literal(UBits(i, 32)));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bytecode,
+                           BytecodeFunction::Create(f));
+
+  EXPECT_EQ(bytecode->instruction_count(), f->node_count());
+  EXPECT_LE(bytecode->word_slot_count(), 2);
+  EXPECT_EQ(bytecode->value_slot_count(), 0);
+  std::vector<Value> args = {Value(UBits(1, 32))};
+  EXPECT_THAT(bytecode->Run(args),
+              IsOkAndHolds(FieldsAre(Value(UBits(1 + 99 * 100 / 2, 32)), _)));
+  // The bytecode may be run more than once.
+  args = {Value(UBits(2, 32))};
+  EXPECT_THAT(bytecode->Run(args),
+              IsOkAndHolds(FieldsAre(Value(UBits(2 + 99 * 100 / 2, 32)), _)));
+}
+
+TEST_F(BytecodeInterpreterOnlyTest, MixedWordAndValueSlots) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(128));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue low = fb.BitSlice(x, 0, 8);
+  BValue sum = fb.Add(low, y);
+  BValue wide = fb.ZeroExtend(sum, 128);
+  fb.Tuple({fb.Xor(x, wide), sum});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bytecode,
+                           BytecodeFunction::Create(f));
+  EXPECT_THAT(bytecode->ToString(), HasSubstr("= add(w"));
+  EXPECT_THAT(bytecode->ToString(), HasSubstr("= interpret tuple(v"));
+
+  Bits x_bits = bits_ops::Concat({UBits(0xabcd, 64), UBits(0x1234, 64)});
+  std::vector<Value> args = {Value(x_bits), Value(UBits(3, 8))};
+  XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<Value> result,
+                           bytecode->Run(args));
+  Value expected_sum(UBits(0x37, 8));
+  EXPECT_EQ(result.value,
+            Value::Tuple({Value(bits_ops::Xor(
+                              x_bits, bits_ops::ZeroExtend(UBits(0x37, 8), 128))),
+                          expected_sum}));
+}
+
+TEST_F(BytecodeInterpreterOnlyTest, Events) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue tkn = fb.AfterAll({});
+  BValue sum = fb.Add(x, x);
+  BValue traced = fb.Trace(tkn, fb.Literal(UBits(1, 1)), {sum}, "sum is {}");
+  fb.Assert(traced, fb.ULt(sum, fb.Literal(UBits(10, 8))), "sum too big");
+  fb.Identity(sum);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BytecodeFunction> bytecode,
+                           BytecodeFunction::Create(f));
+
+  std::vector<Value> args = {Value(UBits(6, 8))};
+  XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<Value> result,
+                           bytecode->Run(args));
+  EXPECT_EQ(result.value, Value(UBits(12, 8)));
+  EXPECT_THAT(result.events.trace_msgs, ElementsAre(FieldsAre("sum is 12", 0)));
+  EXPECT_THAT(result.events.assert_msgs, ElementsAre("sum too big"));
+}
+
+}  // namespace
+}  // namespace xls
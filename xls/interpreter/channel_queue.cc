@@ -30,6 +30,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/package.h"
@@ -40,7 +41,7 @@
 namespace xls {
 
 absl::Status ChannelQueue::AttachGenerator(GeneratorFn generator) {
-  absl::MutexLock lock(&mutex_);
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
   if (generator_.has_value()) {
     return absl::InternalError("ChannelQueue already has a generator attached");
   }
@@ -54,11 +55,10 @@ absl::Status ChannelQueue::AttachGenerator(GeneratorFn generator) {
   return absl::OkStatus();
 }
 
-absl::Status ChannelQueue::Write(const Value& value) {
+absl::Status ChannelQueue::CheckedWriteInternal(Value value) {
   VLOG(4) << absl::StreamFormat(
       "Writing value to channel instance `%s`: { %s }",
       channel_instance()->ToString(), value.ToString());
-  absl::MutexLock lock(&mutex_);
   if (generator_.has_value()) {
     return absl::InternalError(
         "Cannot write to ChannelQueue because it has a generator function.");
@@ -69,34 +69,67 @@ absl::Status ChannelQueue::Write(const Value& value) {
         channel()->name(), channel()->type()->ToString(), value.ToString()));
   }
 
-  WriteInternal(value);
-  VLOG(4) << absl::StreamFormat("Channel now has %d elements", queue_.size());
+  WriteInternal(std::move(value));
+  VLOG(4) << absl::StreamFormat("Channel now has %d elements",
+                                GetSizeInternal());
+  return absl::OkStatus();
+}
+
+absl::Status ChannelQueue::Write(const Value& value) {
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
+  return CheckedWriteInternal(value);
+}
+
+absl::Status ChannelQueue::Write(Value&& value) {
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
+  return CheckedWriteInternal(std::move(value));
+}
+
+absl::Status ChannelQueue::WriteBatch(std::vector<Value> values) {
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
+  if (generator_.has_value()) {
+    return absl::InternalError(
+        "Cannot write to ChannelQueue because it has a generator function.");
+  }
+  for (const Value& value : values) {
+    if (!ValueConformsToType(value, channel()->type())) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Channel `%s` expects values to have type %s, got: %s",
+          channel()->name(), channel()->type()->ToString(), value.ToString()));
+    }
+  }
+  for (Value& value : values) {
+    WriteInternal(std::move(value));
+  }
+  VLOG(4) << absl::StreamFormat(
+      "Wrote %d values to channel instance `%s`, channel now has %d elements",
+      values.size(), channel_instance()->ToString(), GetSizeInternal());
   return absl::OkStatus();
 }
 
-void ChannelQueue::WriteInternal(const Value& value) {
+void ChannelQueue::WriteInternal(Value value) {
   CallWriteCallbacks(value);
   if (channel()->kind() == ChannelKind::kSingleValue) {
     if (queue_.empty()) {
-      queue_.push_back(value);
+      queue_.push_back(std::move(value));
     } else {
-      queue_.front() = value;
+      queue_.front() = std::move(value);
     }
     return;
   }
 
   CHECK_EQ(channel()->kind(), ChannelKind::kStreaming);
-  queue_.push_back(value);
+  queue_.push_back(std::move(value));
 }
 
 std::optional<Value> ChannelQueue::Read() {
-  absl::MutexLock lock(&mutex_);
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
   if (generator_.has_value()) {
     // Write/ReadInternal are virtual and may have other side-effects so rather
     // than directly returning the generated value, write then read it.
     std::optional<Value> generated_value = (*generator_)();
     if (generated_value.has_value()) {
-      WriteInternal(generated_value.value());
+      WriteInternal(*std::move(generated_value));
     }
   }
   std::optional<Value> value = ReadInternal();
@@ -104,21 +137,112 @@ std::optional<Value> ChannelQueue::Read() {
       "Reading data from channel instance %s: %s",
       channel_instance()->ToString(),
       value.has_value() ? value->ToString() : "(none)");
-  VLOG(4) << absl::StreamFormat("Channel now has %d elements", queue_.size());
+  VLOG(4) << absl::StreamFormat("Channel now has %d elements",
+                                GetSizeInternal());
   return value;
 }
 
+std::vector<Value> ChannelQueue::ReadBatch(int64_t max_count) {
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
+  if (channel()->kind() == ChannelKind::kSingleValue) {
+    max_count = std::min<int64_t>(max_count, 1);
+  }
+  std::vector<Value> values;
+  while (values.size() < max_count) {
+    if (generator_.has_value()) {
+      std::optional<Value> generated_value = (*generator_)();
+      if (generated_value.has_value()) {
+        WriteInternal(*std::move(generated_value));
+      }
+    }
+    std::optional<Value> value = ReadInternal();
+    if (!value.has_value()) {
+      break;
+    }
+    values.push_back(*std::move(value));
+  }
+  VLOG(4) << absl::StreamFormat(
+      "Read %d values from channel instance %s, channel now has %d elements",
+      values.size(), channel_instance()->ToString(), GetSizeInternal());
+  return values;
+}
+
+std::vector<Value> ChannelQueue::GetContents() {
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
+  // Drain the queue through the (virtual) internal methods, which is the only
+  // way to see the values held by the JIT queues, and then refill it.
+  std::vector<std::unique_ptr<ChannelQueueCallback>> callbacks =
+      std::move(callbacks_);
+  callbacks_.clear();
+  std::vector<Value> values;
+  if (channel()->kind() == ChannelKind::kSingleValue) {
+    // Reads of single-value channels are not destructive.
+    std::optional<Value> value = ReadInternal();
+    if (value.has_value()) {
+      values.push_back(*std::move(value));
+    }
+  } else {
+    int64_t size = GetSizeInternal();
+    values.reserve(size);
+    for (int64_t i = 0; i < size; ++i) {
+      values.push_back(ReadInternal().value());
+    }
+    for (const Value& value : values) {
+      WriteInternal(value);
+    }
+  }
+  callbacks_ = std::move(callbacks);
+  return values;
+}
+
+absl::Status ChannelQueue::SetContents(absl::Span<const Value> values) {
+  absl::MutexLockMaybe lock(MutexIfThreadSafe());
+  if (generator_.has_value()) {
+    return absl::InternalError(
+        "Cannot set the contents of ChannelQueue because it has a generator "
+        "function.");
+  }
+  if (channel()->kind() == ChannelKind::kSingleValue && values.size() > 1) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Single-value channel `%s` can hold at most one value, got %d",
+        channel()->name(), values.size()));
+  }
+  for (const Value& value : values) {
+    if (!ValueConformsToType(value, channel()->type())) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Channel `%s` expects values to have type %s, got: %s",
+          channel()->name(), channel()->type()->ToString(), value.ToString()));
+    }
+  }
+  std::vector<std::unique_ptr<ChannelQueueCallback>> callbacks =
+      std::move(callbacks_);
+  callbacks_.clear();
+  if (channel()->kind() != ChannelKind::kSingleValue) {
+    while (GetSizeInternal() > 0) {
+      ReadInternal();
+    }
+  }
+  for (const Value& value : values) {
+    WriteInternal(value);
+  }
+  callbacks_ = std::move(callbacks);
+  return absl::OkStatus();
+}
+
 int64_t ChannelQueue::GetSizeInternal() const { return queue_.size(); }
 
 std::optional<Value> ChannelQueue::ReadInternal() {
   if (queue_.empty()) {
     return std::nullopt;
   }
-  Value value = queue_.front();
-  CallReadCallbacks(value);
-  if (channel()->kind() != ChannelKind::kSingleValue) {
-    queue_.pop_front();
+  if (channel()->kind() == ChannelKind::kSingleValue) {
+    // Reads of single-value channels are not destructive.
+    CallReadCallbacks(queue_.front());
+    return queue_.front();
   }
+  Value value = std::move(queue_.front());
+  queue_.pop_front();
+  CallReadCallbacks(value);
   return std::move(value);
 }
 
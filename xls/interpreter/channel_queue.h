@@ -55,7 +55,7 @@ class ChannelQueueCallback {
 // Abstract base class for queues which represent channels during IR
 // interpretation. During interpretation of a network of procs each channel
 // instance is backed by exactly one ChannelQueue. ChannelQueues are
-// thread-safe.
+// thread-safe unless put in single-threaded mode (see SetSingleThreaded).
 class ChannelQueue {
  public:
   explicit ChannelQueue(ChannelInstance* channel_instance)
@@ -77,26 +77,54 @@ class ChannelQueue {
 
   // Returns the number of elements currently in the channel queue.
   int64_t GetSize() const {
-    absl::MutexLock lock(&mutex_);
+    absl::MutexLockMaybe lock(MutexIfThreadSafe());
     return GetSizeInternal();
   }
 
   // Returns whether the channel queue is empty.
   bool IsEmpty() const { return GetSize() == 0; }
 
-  // Writes the given value on to the channel.
+  // Writes the given value on to the channel. The rvalue overload moves the
+  // value into the queue rather than copying it.
   absl::Status Write(const Value& value);
+  absl::Status Write(Value&& value);
+
+  // Writes the given values on to the channel in order, taking the lock once.
+  // If any value has the wrong type nothing is written.
+  absl::Status WriteBatch(std::vector<Value> values);
 
   // Reads and returns a value from the channel. Returns an std::nullopt if
-  // the channel is empty.
+  // the channel is empty. The value is moved out of the queue.
   std::optional<Value> Read();
 
+  // Reads and returns up to `max_count` values from the channel, taking the
+  // lock once. Returns fewer values if the channel (and generator, if any) runs
+  // out. Reads of a single-value channel do not consume its value, so at most
+  // one value is returned for one.
+  std::vector<Value> ReadBatch(int64_t max_count);
+
+  // Enables or disables single-threaded mode, in which the queue takes no
+  // locks. Only for runtimes which access all of their queues from a single
+  // thread; no other thread may use the queue while the mode is enabled.
+  void SetSingleThreaded(bool value) { single_threaded_ = value; }
+
   // Attaches a function which generates values for the channel. The generator
   // is called when a value is needed for reading. If a generator is attached
   // then calling `Write` returns an error.
   using GeneratorFn = std::function<std::optional<Value>()>;
   absl::Status AttachGenerator(GeneratorFn generator);
 
+  // Returns the values currently in the queue in the order they would be read
+  // without removing them. Values which a generator would produce are not
+  // included. Callbacks are not called.
+  std::vector<Value> GetContents();
+
+  // Replaces the contents of the queue with `values`, which are read in order.
+  // Callbacks are not called. Returns an error if a generator is attached.
+  // Single-value channels hold at most one value and keep their current value
+  // if `values` is empty.
+  absl::Status SetContents(absl::Span<const Value> values);
+
   void AddCallback(std::unique_ptr<ChannelQueueCallback> callback) {
     callbacks_.push_back(std::move(callback));
   }
@@ -113,11 +141,21 @@ class ChannelQueue {
     }
   }
 
+  // Returns the mutex to hold while accessing the queue, or nullptr in
+  // single-threaded mode. For use with absl::MutexLockMaybe.
+  absl::Mutex* MutexIfThreadSafe() const ABSL_LOCK_RETURNED(mutex_) {
+    return single_threaded_ ? nullptr : &mutex_;
+  }
+
+  // Type-checks `value` and writes it with WriteInternal.
+  absl::Status CheckedWriteInternal(Value value)
+      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+
   mutable absl::Mutex mutex_;
+  bool single_threaded_ = false;
 
   virtual int64_t GetSizeInternal() const ABSL_SHARED_LOCKS_REQUIRED(mutex_);
-  virtual void WriteInternal(const Value& value)
-      ABSL_SHARED_LOCKS_REQUIRED(mutex_);
+  virtual void WriteInternal(Value value) ABSL_SHARED_LOCKS_REQUIRED(mutex_);
   virtual std::optional<Value> ReadInternal()
       ABSL_SHARED_LOCKS_REQUIRED(mutex_);
   ChannelInstance* channel_instance_;
@@ -27,17 +27,21 @@
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue_test_base.h"
+#include "xls/ir/bits.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel_ops.h"
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc_elaboration.h"
+#include "xls/ir/value.h"
 
 namespace xls {
 namespace {
 
 using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::Optional;
 
 // Instantiate and run all the tests in channel_queue_test_base.cc.
 INSTANTIATE_TEST_SUITE_P(ChannelQueueTest, ChannelQueueTestBase,
@@ -47,6 +51,29 @@ INSTANTIATE_TEST_SUITE_P(ChannelQueueTest, ChannelQueueTestBase,
                                    channel_instance);
                              })));
 
+TEST(ChannelQueueTest, SingleThreadedMode) {
+  Package package("single_threaded");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+  ChannelQueue queue(elaboration.GetUniqueInstance(channel).value());
+  queue.SetSingleThreaded(true);
+
+  XLS_ASSERT_OK(queue.WriteBatch({Value(UBits(1, 32)), Value(UBits(2, 32))}));
+  XLS_ASSERT_OK(queue.Write(Value(UBits(3, 32))));
+  EXPECT_THAT(queue.Read(), Optional(Value(UBits(1, 32))));
+  EXPECT_THAT(queue.ReadBatch(5),
+              ElementsAre(Value(UBits(2, 32)), Value(UBits(3, 32))));
+
+  // Locking can be turned back on once the queue is shared again.
+  queue.SetSingleThreaded(false);
+  XLS_ASSERT_OK(queue.Write(Value(UBits(4, 32))));
+  EXPECT_EQ(queue.GetSize(), 1);
+}
+
 // Separate tests for queue managers.
 class ChannelQueueManagerTest : public IrTestBase {
  protected:
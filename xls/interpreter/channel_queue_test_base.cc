@@ -16,6 +16,7 @@
 
 #include <cstdint>
 #include <optional>
+#include <utility>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -35,7 +36,9 @@ namespace xls {
 namespace {
 
 using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 using ::testing::Optional;
 
 TEST_P(ChannelQueueTestBase, FifoChannelQueueTest) {
@@ -173,6 +176,57 @@ TEST_P(ChannelQueueTestBase, FixedValueGenerator) {
   EXPECT_EQ(queue->Read(), std::nullopt);
 }
 
+TEST_P(ChannelQueueTestBase, BatchWriteAndRead) {
+  Package package(TestName());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+  auto queue =
+      GetParam().CreateQueue(elaboration.GetUniqueInstance(channel).value());
+
+  XLS_ASSERT_OK(queue->WriteBatch(
+      {Value(UBits(1, 32)), Value(UBits(2, 32)), Value(UBits(3, 32))}));
+  Value value(UBits(4, 32));
+  XLS_ASSERT_OK(queue->Write(std::move(value)));
+  EXPECT_EQ(queue->GetSize(), 4);
+
+  // A batch with a value of the wrong type is not written at all.
+  EXPECT_THAT(queue->WriteBatch({Value(UBits(5, 32)), Value(UBits(6, 16))}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("expects values to have type bits[32]")));
+  EXPECT_EQ(queue->GetSize(), 4);
+
+  EXPECT_THAT(queue->ReadBatch(3),
+              ElementsAre(Value(UBits(1, 32)), Value(UBits(2, 32)),
+                          Value(UBits(3, 32))));
+  EXPECT_THAT(queue->ReadBatch(3), ElementsAre(Value(UBits(4, 32))));
+  EXPECT_THAT(queue->ReadBatch(3), IsEmpty());
+}
+
+TEST_P(ChannelQueueTestBase, BatchReadFromGenerator) {
+  Package package(TestName());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kReceiveOnly,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+  auto queue =
+      GetParam().CreateQueue(elaboration.GetUniqueInstance(channel).value());
+
+  XLS_ASSERT_OK(queue->AttachGenerator(FixedValueGenerator(
+      {Value(UBits(22, 32)), Value(UBits(44, 32)), Value(UBits(55, 32))})));
+  EXPECT_THAT(queue->ReadBatch(2),
+              ElementsAre(Value(UBits(22, 32)), Value(UBits(44, 32))));
+  EXPECT_THAT(queue->ReadBatch(2), ElementsAre(Value(UBits(55, 32))));
+  EXPECT_THAT(queue->WriteBatch({Value(UBits(1, 32))}),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("has a generator function")));
+}
+
 TEST_P(ChannelQueueTestBase, EmptyGenerator) {
   Package package(TestName());
   XLS_ASSERT_OK_AND_ASSIGN(
@@ -15,6 +15,9 @@
 #ifndef XLS_INTERPRETER_EVALUATOR_OPTIONS_H_
 #define XLS_INTERPRETER_EVALUATOR_OPTIONS_H_
 
+#include <cstdint>
+#include <optional>
+
 #include "xls/ir/format_preference.h"
 
 namespace xls {
@@ -42,10 +45,63 @@ class EvaluatorOptions {
   }
   bool support_observers() const { return support_observers_; }
 
+  // Maximum number of threads used to compile the procs of a JIT runtime
+  // concurrently. Zero means one per available CPU; one compiles serially.
+  EvaluatorOptions& set_jit_compile_threads(int64_t value) {
+    jit_compile_threads_ = value;
+    return *this;
+  }
+  int64_t jit_compile_threads() const { return jit_compile_threads_; }
+
+  // When set, the JIT keeps the state of each proc instance bit-packed rather
+  // than padding every leaf to at least a byte. Reduces the memory footprint
+  // of procs with many narrow state elements at the cost of packing and
+  // unpacking the state on every tick.
+  EvaluatorOptions& set_jit_packed_state(bool value) {
+    jit_packed_state_ = value;
+    return *this;
+  }
+  bool jit_packed_state() const { return jit_packed_state_; }
+
+  // When set, JIT code accumulates the bits set in the value of every node in
+  // a per-instance buffer while an observer is set, and hands them to the
+  // observer's RuntimeObserver::RecordNodeCoverage in one batch rather than
+  // calling out for every node evaluation. Allows node coverage to be collected
+  // without `support_observers`.
+  EvaluatorOptions& set_jit_node_coverage(bool value) {
+    jit_node_coverage_ = value;
+    return *this;
+  }
+  bool jit_node_coverage() const { return jit_node_coverage_; }
+
+  // When set, the channel queues of interpreter runtimes take no locks (see
+  // ChannelQueue::SetSingleThreaded). The runtime and every user of its queues,
+  // e.g., code writing inputs and reading outputs, must run on one thread.
+  EvaluatorOptions& set_single_threaded_queues(bool value) {
+    single_threaded_queues_ = value;
+    return *this;
+  }
+  bool single_threaded_queues() const { return single_threaded_queues_; }
+
+  // If set, traces with a higher verbosity are dropped when they fire rather
+  // than recorded (see InterpreterEvents::max_trace_verbosity).
+  EvaluatorOptions& set_max_trace_verbosity(std::optional<int64_t> value) {
+    max_trace_verbosity_ = value;
+    return *this;
+  }
+  std::optional<int64_t> max_trace_verbosity() const {
+    return max_trace_verbosity_;
+  }
+
  private:
   bool trace_channels_ = false;
   FormatPreference format_preference_ = FormatPreference::kDefault;
   bool support_observers_ = false;
+  int64_t jit_compile_threads_ = 0;
+  bool jit_packed_state_ = false;
+  bool jit_node_coverage_ = false;
+  bool single_threaded_queues_ = false;
+  std::optional<int64_t> max_trace_verbosity_;
 };
 
 }  // namespace xls
@@ -28,6 +28,7 @@
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/node_value_map.h"
 #include "xls/interpreter/observer.h"
 #include "xls/ir/events.h"
 #include "xls/ir/keyword_args.h"
@@ -41,9 +42,11 @@ namespace {
 // An interpreter for XLS functions.
 class FunctionInterpreter final : public IrInterpreter {
  public:
-  FunctionInterpreter(absl::Span<const Value> args,
+  FunctionInterpreter(Function* function, absl::Span<const Value> args,
                       std::optional<EvaluationObserver*> observer)
-      : IrInterpreter(observer), args_(args.begin(), args.end()) {}
+      : IrInterpreter(observer), args_(args.begin(), args.end()) {
+    NodeValuesMap() = NodeValueMap(function);
+  }
 
   absl::Status HandleParam(Param* param) override {
     XLS_ASSIGN_OR_RETURN(int64_t index,
@@ -84,7 +87,7 @@ absl::StatusOr<InterpreterResult<Value>> InterpretFunction(
           value.ToString(), argno, param_type->ToString()));
     }
   }
-  FunctionInterpreter visitor(args, observer);
+  FunctionInterpreter visitor(function, args, observer);
   XLS_RETURN_IF_ERROR(function->Accept(&visitor));
   Value result = visitor.ResolveAsValue(function->return_value());
   VLOG(2) << "Result = " << result;
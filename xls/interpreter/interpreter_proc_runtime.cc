@@ -38,6 +38,12 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
   // receive only queue for every receive only channel.
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<ChannelQueueManager> queue_manager,
                        ChannelQueueManager::Create(std::move(elaboration)));
+  if (options.single_threaded_queues()) {
+    // The serial runtime ticks every proc on the calling thread.
+    for (ChannelQueue* queue : queue_manager->queues()) {
+      queue->SetSingleThreaded(true);
+    }
+  }
 
   // Create a ProcInterpreter for each Proc.
   std::vector<std::unique_ptr<ProcEvaluator>> proc_interpreters;
@@ -21,8 +21,10 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <random>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -4287,5 +4289,77 @@ TEST_P(IrEvaluatorTestBase, DecodeWithWideInput) {
       RunWithUint64sNoEvents(f, {absl::bit_cast<uint32_t>(int32_t{-64})}), 0);
 }
 
+// Returns a pseudo-random Bits value of the given width.
+Bits RandomBits(int64_t bit_count, std::mt19937_64& rng) {
+  std::vector<Bits> words;
+  for (int64_t i = 0; i < CeilOfRatio(bit_count, int64_t{64}); ++i) {
+    words.push_back(UBits(rng(), 64));
+  }
+  return bits_ops::Concat(words).Slice(0, bit_count);
+}
+
+TEST_P(IrEvaluatorTestBase, WideBitsOps) {
+  // Widths spanning many 64-bit words, including widths which are not a
+  // multiple of 64.
+  std::mt19937_64 rng(42);
+  for (int64_t width : {130, 256, 300, 1000, 2048}) {
+    auto p = CreatePackage();
+    FunctionBuilder b(absl::StrCat(TestName(), "_", width), p.get());
+    BValue x = b.Param("x", p->GetBitsType(width));
+    BValue y = b.Param("y", p->GetBitsType(width));
+    BValue amount = b.Param("amount", p->GetBitsType(16));
+    BValue wide_amount = b.Param("wide_amount", p->GetBitsType(100));
+    b.Tuple({b.And(x, y), b.Or(x, y), b.Xor(x, y), b.Not(x), b.Nand(x, y),
+             b.Nor(x, y), b.Add(x, y), b.Subtract(x, y), b.Shll(x, amount),
+             b.Shrl(x, amount), b.Shra(x, amount), b.Shrl(x, wide_amount),
+             b.Concat({x, y}), b.BitSlice(x, width / 3, width / 2),
+             b.BitSlice(x, 64, width - 64), b.BitSlice(x, 70, 8)});
+    XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+
+    std::vector<std::pair<Bits, Bits>> operands = {
+        {RandomBits(width, rng), RandomBits(width, rng)},
+        {Bits::AllOnes(width), UBits(1, width)},
+        {Bits::AllOnes(width), Bits::AllOnes(width)},
+        {UBits(0, width), UBits(1, width)},
+        {Bits::PowerOfTwo(width - 1, width), Bits::PowerOfTwo(64, width)},
+    };
+    std::vector<int64_t> amounts = {0,         1,     63,        64,
+                                    65,        127,   width - 1, width,
+                                    width + 1, 65535};
+    for (const auto& [x_bits, y_bits] : operands) {
+      for (int64_t shift : amounts) {
+        Bits wide_shift = bits_ops::Concat({UBits(shift & 1, 36),
+                                            UBits(shift, 64)});
+        std::vector<Value> args = {Value(x_bits), Value(y_bits),
+                                   Value(UBits(shift, 16)), Value(wide_shift)};
+        Value expected = Value::Tuple({
+            Value(bits_ops::And(x_bits, y_bits)),
+            Value(bits_ops::Or(x_bits, y_bits)),
+            Value(bits_ops::Xor(x_bits, y_bits)),
+            Value(bits_ops::Not(x_bits)),
+            Value(bits_ops::Not(bits_ops::And(x_bits, y_bits))),
+            Value(bits_ops::Not(bits_ops::Or(x_bits, y_bits))),
+            Value(bits_ops::Add(x_bits, y_bits)),
+            Value(bits_ops::Sub(x_bits, y_bits)),
+            Value(bits_ops::ShiftLeftLogical(x_bits, std::min(shift, width))),
+            Value(bits_ops::ShiftRightLogical(x_bits, std::min(shift, width))),
+            Value(bits_ops::ShiftRightArith(x_bits, std::min(shift, width))),
+            Value((shift & 1) != 0
+                      ? UBits(0, width)
+                      : bits_ops::ShiftRightLogical(x_bits,
+                                                    std::min(shift, width))),
+            Value(bits_ops::Concat({x_bits, y_bits})),
+            Value(x_bits.Slice(width / 3, width / 2)),
+            Value(x_bits.Slice(64, width - 64)),
+            Value(x_bits.Slice(70, 8)),
+        });
+        EXPECT_THAT(RunWithNoEvents(f, args), IsOkAndHolds(expected))
+            << "width=" << width << " x=" << x_bits << " y=" << y_bits
+            << " shift=" << shift;
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xls
@@ -21,7 +21,6 @@
 #include <variant>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
@@ -91,9 +90,7 @@ absl::StatusOr<Value> InterpretNode(Node* node,
 
 absl::Status IrInterpreter::AddInterpreterEvents(
     const InterpreterEvents& events) {
-  for (const TraceMessage& trace_msg : events.trace_msgs) {
-    GetInterpreterEvents().trace_msgs.push_back(trace_msg);
-  }
+  GetInterpreterEvents().trace_msgs.Append(events.trace_msgs);
 
   for (const std::string& assert_msg : events.assert_msgs) {
     GetInterpreterEvents().assert_msgs.push_back(assert_msg);
@@ -407,38 +404,6 @@ absl::Status IrInterpreter::HandleIdentity(UnOp* identity) {
   return SetValueResult(identity, ResolveAsValue(identity->operand(0)));
 }
 
-// Recursive function for setting an element of a multidimensional array to a
-// particular value. 'indices' is a multidimensional array index of type tuple
-// of bits. 'value' is what to assign at the array element at the particular
-// index. 'elements' is a vector of the outer-most elements of the array being
-// indexed into.
-static absl::Status SetArrayElement(absl::Span<const Bits> indices,
-                                    const Value& value,
-                                    std::vector<Value>* elements) {
-  XLS_RET_CHECK(!indices.empty());
-  uint64_t index = BitsToBoundedUint64(indices.front(), elements->size());
-  if (index >= elements->size()) {
-    // Out-of-bounds access it a no-op.
-    return absl::OkStatus();
-  }
-  if (indices.size() == 1) {
-    (*elements)[index] = value;
-    return absl::OkStatus();
-  }
-
-  // Index has multiple element. Peel off the first index and recurse into that
-  // element.
-  const Value& selected_element = (*elements)[index];
-  std::vector<Value> subelements(selected_element.elements().begin(),
-                                 selected_element.elements().end());
-  XLS_RETURN_IF_ERROR(SetArrayElement(indices.subspan(1), value, &subelements));
-  // Reconstruct the affected element as an array and assign it to the indexed
-  // slot.
-  XLS_ASSIGN_OR_RETURN(Value array_element, Value::Array(subelements));
-  (*elements)[index] = array_element;
-  return absl::OkStatus();
-}
-
 absl::Status IrInterpreter::HandleArrayIndex(ArrayIndex* index) {
   const Value* array = &ResolveAsValue(index->array());
   for (Node* index_operand : index->indices()) {
@@ -469,21 +434,23 @@ absl::Status IrInterpreter::HandleArrayUpdate(ArrayUpdate* update) {
   const Value& input_array = ResolveAsValue(update->array_to_update());
   const Value& update_value = ResolveAsValue(update->update_value());
 
-  if (update->indices().empty()) {
-    // Index is empty. The *entire* array is replaced with the update value.
-    return SetValueResult(update, update_value);
-  }
-
-  XLS_ASSIGN_OR_RETURN(std::vector<Value> array_elements,
-                       input_array.GetElements());
-  std::vector<Bits> index_vector;
+  std::vector<int64_t> index;
+  index.reserve(update->indices().size());
+  const Value* element = &input_array;
   for (Node* index_operand : update->indices()) {
-    index_vector.push_back(ResolveAsBits(index_operand));
+    uint64_t i =
+        BitsToBoundedUint64(ResolveAsBits(index_operand), element->size());
+    if (i >= element->size()) {
+      // Out-of-bounds access it a no-op.
+      return SetValueResult(update, input_array);
+    }
+    index.push_back(i);
+    element = &element->element(i);
   }
-  XLS_RETURN_IF_ERROR(
-      SetArrayElement(index_vector, update_value, &array_elements));
-  XLS_ASSIGN_OR_RETURN(Value result, Value::Array(array_elements));
-  return SetValueResult(update, result);
+  // An empty index replaces the *entire* array with the update value.
+  XLS_ASSIGN_OR_RETURN(Value result,
+                       input_array.UpdateElement(index, update_value));
+  return SetValueResult(update, std::move(result));
 }
 
 absl::Status IrInterpreter::HandleArrayConcat(ArrayConcat* concat) {
@@ -511,7 +478,8 @@ absl::Status IrInterpreter::HandleAssert(Assert* assert_op) {
 }
 
 absl::Status IrInterpreter::HandleTrace(Trace* trace_op) {
-  if (ResolveAsBool(trace_op->condition())) {
+  if (ResolveAsBool(trace_op->condition()) &&
+      GetInterpreterEvents().ShouldRecordTrace(trace_op->verbosity())) {
     absl::Span<Node* const> arg_nodes = trace_op->args();
     auto arg_node = arg_nodes.begin();
 
@@ -524,20 +492,21 @@ absl::Status IrInterpreter::HandleTrace(Trace* trace_op) {
           StepsToXlsFormatString(trace_op->format()), trace_op->ToString()));
     };
 
-    std::string trace_output;
+    // The message is only formatted once the events are read.
+    UnformattedTraceMessage trace_output{.verbosity = trace_op->verbosity()};
 
     for (auto step : trace_op->format()) {
       if (std::holds_alternative<std::string>(step)) {
-        absl::StrAppend(&trace_output, std::get<std::string>(step));
+        trace_output.pieces.push_back(std::get<std::string>(step));
       }
 
       if (std::holds_alternative<FormatPreference>(step)) {
         if (arg_node == arg_nodes.end()) {
           return make_error("Not enough operands");
         }
-        auto arg_format = std::get<FormatPreference>(step);
-        absl::StrAppend(&trace_output,
-                        ResolveAsValue(*arg_node).ToHumanString(arg_format));
+        trace_output.pieces.push_back(UnformattedTraceMessage::Operand{
+            .value = ResolveAsValue(*arg_node),
+            .format = std::get<FormatPreference>(step)});
         arg_node++;
       }
     }
@@ -546,12 +515,11 @@ absl::Status IrInterpreter::HandleTrace(Trace* trace_op) {
       return make_error("Too many operands");
     }
 
-    VLOG(3) << "Trace output: " << trace_output;
+    if (VLOG_IS_ON(3)) {
+      VLOG(3) << "Trace output: " << trace_output.Format().message;
+    }
 
-    GetInterpreterEvents().trace_msgs.push_back(TraceMessage{
-        .message = trace_output,
-        .verbosity = trace_op->verbosity(),
-    });
+    GetInterpreterEvents().trace_msgs.AddUnformatted(std::move(trace_output));
   }
   return SetValueResult(trace_op, Value::Token());
 }
@@ -898,7 +866,7 @@ absl::Status IrInterpreter::SetValueResult(Node* node, Value result) {
   if (observer_) {
     (*observer_)->NodeEvaluated(node, result);
   }
-  NodeValuesMap()[node] = std::move(result);
+  NodeValuesMap().Set(node, std::move(result));
   return absl::OkStatus();
 }
 
@@ -19,10 +19,10 @@
 #include <optional>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "xls/interpreter/node_value_map.h"
 #include "xls/interpreter/observer.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/dfs_visitor.h"
@@ -49,7 +49,7 @@ class IrInterpreter : public DfsVisitor {
   // Constructor which takes an existing map of node values and events. Used for
   // continuations to enable stopping and restarting execution of a
   // FunctionBase.
-  IrInterpreter(absl::flat_hash_map<Node*, Value>* node_values,
+  IrInterpreter(NodeValueMap* node_values,
                 InterpreterEvents* events,
                 std::optional<EvaluationObserver*> observer = std::nullopt)
       : node_values_ptr_(node_values),
@@ -58,8 +58,8 @@ class IrInterpreter : public DfsVisitor {
 
   // Sets the evaluated value for 'node' to the given Value. 'value' must be
   // passed in by value (ha!) because a use case is passing in a previously
-  // evaluated value and inserting a into flat_hash_map (done below) invalidates
-  // all references to Values in the map.
+  // evaluated value and inserting into the sparse part of a NodeValueMap
+  // invalidates references to the Values held there.
   absl::Status SetValueResult(Node* node, Value result);
 
   // Returns the previously evaluated value of 'node' as a Value.
@@ -196,19 +196,21 @@ class IrInterpreter : public DfsVisitor {
                                absl::Span<const Value* const> inputs);
 
   // Returns the map which maps Node* to the Value computed for that node.
-  absl::flat_hash_map<Node*, Value>& NodeValuesMap() {
+  NodeValueMap& NodeValuesMap() {
     return node_values_ptr_ != nullptr ? *node_values_ptr_ : node_values_;
   }
-  const absl::flat_hash_map<Node*, Value>& NodeValuesMap() const {
+  const NodeValueMap& NodeValuesMap() const {
     return node_values_ptr_ != nullptr ? *node_values_ptr_ : node_values_;
   }
 
   // The evaluated values for the nodes in the Function. To support
   // continuations, an existing map can either be passed in at construction time
   // (`node_values_ptr_` is not null), or a freshly constructed map is used
-  // (`node_values_ptr` is null).
-  absl::flat_hash_map<Node*, Value>* node_values_ptr_;
-  absl::flat_hash_map<Node*, Value> node_values_;
+  // (`node_values_ptr` is null). Interpreters of a whole FunctionBase should
+  // construct the map with the FunctionBase so node values are stored densely
+  // from the start.
+  NodeValueMap* node_values_ptr_;
+  NodeValueMap node_values_;
 
   // Events observed while interpreting (currently only trace messages). To
   // support continuations, an existing events object can either be passed in at
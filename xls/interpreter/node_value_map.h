@@ -0,0 +1,122 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_INTERPRETER_NODE_VALUE_MAP_H_
+#define XLS_INTERPRETER_NODE_VALUE_MAP_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// Map from node to the value computed for it by the IR interpreter.
+//
+// The values of the nodes of one function base are held in a vector indexed by
+// Node::dense_index() so that setting and resolving a value does not hash.
+// Values of other nodes are held in a hash map. A map created without a
+// function base starts out sparse (interpreting a handful of nodes in isolation
+// should not pay for a vector the size of the function) and switches to dense
+// storage once it holds a sizable fraction of a function's nodes.
+class NodeValueMap {
+ public:
+  NodeValueMap() = default;
+
+  // Creates a map with dense storage preallocated for the nodes of
+  // `function_base`.
+  explicit NodeValueMap(const FunctionBase* function_base)
+      : function_base_(function_base),
+        dense_values_(function_base->node_count()) {}
+
+  bool contains(const Node* node) const {
+    if (IsDense(node)) {
+      return node->dense_index() < static_cast<int64_t>(dense_values_.size()) &&
+             dense_values_[node->dense_index()].kind() != ValueKind::kInvalid;
+    }
+    return sparse_values_.contains(node);
+  }
+
+  // Returns the value of `node`. CHECK fails if there is none.
+  const Value& at(const Node* node) const {
+    if (IsDense(node)) {
+      CHECK(contains(node)) << "No value for node " << node->GetName();
+      return dense_values_[node->dense_index()];
+    }
+    return sparse_values_.at(node);
+  }
+
+  // Sets the value of `node`, replacing any existing value.
+  void Set(const Node* node, Value value) {
+    if (IsDense(node)) {
+      if (node->dense_index() >= static_cast<int64_t>(dense_values_.size())) {
+        // Nodes were added to the function base after storage was allocated.
+        dense_values_.resize(function_base_->node_count());
+      }
+      dense_values_[node->dense_index()] = std::move(value);
+      return;
+    }
+    sparse_values_.insert_or_assign(node, std::move(value));
+    if (function_base_ == nullptr && node->function_base() != nullptr &&
+        sparse_values_.size() >= kMinDenseValueCount &&
+        sparse_values_.size() * kMaxDenseSparsity >=
+            node->function_base()->node_count()) {
+      ConvertToDense(node->function_base());
+    }
+  }
+
+  // Removes all values. Dense storage is kept for reuse.
+  void clear() {
+    for (Value& value : dense_values_) {
+      value = Value();
+    }
+    sparse_values_.clear();
+  }
+
+ private:
+  // A sparse map switches to dense storage once it holds at least this many
+  // values and at least 1/kMaxDenseSparsity of the function's nodes.
+  static constexpr int64_t kMinDenseValueCount = 16;
+  static constexpr int64_t kMaxDenseSparsity = 8;
+
+  bool IsDense(const Node* node) const {
+    return function_base_ != nullptr && node->function_base() == function_base_;
+  }
+
+  void ConvertToDense(const FunctionBase* function_base) {
+    function_base_ = function_base;
+    dense_values_.resize(function_base->node_count());
+    for (auto it = sparse_values_.begin(); it != sparse_values_.end();) {
+      if (IsDense(it->first)) {
+        dense_values_[it->first->dense_index()] = std::move(it->second);
+        sparse_values_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  const FunctionBase* function_base_ = nullptr;
+  std::vector<Value> dense_values_;
+  absl::flat_hash_map<const Node*, Value> sparse_values_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_NODE_VALUE_MAP_H_
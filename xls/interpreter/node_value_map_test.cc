@@ -0,0 +1,111 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/node_value_map.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+class NodeValueMapTest : public IrTestBase {};
+
+TEST_F(NodeValueMapTest, DenseIndicesStayContiguousAfterRemoval) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue a = fb.Literal(UBits(1, 32));
+  BValue b = fb.Literal(UBits(2, 32));
+  fb.Add(x, x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK(f->RemoveNode(a.node()));
+  XLS_ASSERT_OK(f->RemoveNode(b.node()));
+
+  std::vector<bool> seen(f->node_count(), false);
+  for (Node* node : f->nodes()) {
+    ASSERT_GE(node->dense_index(), 0);
+    ASSERT_LT(node->dense_index(), f->node_count());
+    EXPECT_FALSE(seen[node->dense_index()]);
+    seen[node->dense_index()] = true;
+  }
+}
+
+TEST_F(NodeValueMapTest, SetAndLookUp) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue sum = fb.Add(x, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  FunctionBuilder other_fb("other", p.get());
+  BValue z = other_fb.Param("z", p->GetBitsType(8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * other, other_fb.Build());
+  (void)other;
+
+  NodeValueMap values(f);
+  EXPECT_FALSE(values.contains(x.node()));
+  values.Set(x.node(), Value(UBits(1, 32)));
+  values.Set(sum.node(), Value(UBits(3, 32)));
+  values.Set(z.node(), Value(UBits(7, 8)));
+  EXPECT_TRUE(values.contains(x.node()));
+  EXPECT_FALSE(values.contains(y.node()));
+  EXPECT_EQ(values.at(x.node()), Value(UBits(1, 32)));
+  EXPECT_EQ(values.at(sum.node()), Value(UBits(3, 32)));
+  EXPECT_EQ(values.at(z.node()), Value(UBits(7, 8)));
+
+  values.Set(x.node(), Value(UBits(5, 32)));
+  EXPECT_EQ(values.at(x.node()), Value(UBits(5, 32)));
+
+  values.clear();
+  EXPECT_FALSE(values.contains(x.node()));
+  EXPECT_FALSE(values.contains(z.node()));
+}
+
+TEST_F(NodeValueMapTest, SparseMapBecomesDense) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  std::vector<BValue> params;
+  for (int64_t i = 0; i < 20; ++i) {
+    params.push_back(fb.Param(absl::StrCat("p", i), p->GetBitsType(16)));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  (void)f;
+
+  NodeValueMap values;
+  for (int64_t i = 0; i < params.size(); ++i) {
+    values.Set(params[i].node(), Value(UBits(i, 16)));
+  }
+  for (int64_t i = 0; i < params.size(); ++i) {
+    ASSERT_TRUE(values.contains(params[i].node()));
+    EXPECT_EQ(values.at(params[i].node()), Value(UBits(i, 16)));
+  }
+}
+
+}  // namespace
+}  // namespace xls
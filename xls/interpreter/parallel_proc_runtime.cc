@@ -0,0 +1,287 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/parallel_proc_runtime.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/thread.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/proc_evaluator.h"
+#include "xls/ir/events.h"
+#include "xls/ir/proc_elaboration.h"
+
+namespace xls {
+
+/* static */ absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+ParallelProcRuntime::Create(
+    std::vector<std::unique_ptr<ProcEvaluator>>&& evaluators,
+    std::unique_ptr<ChannelQueueManager>&& queue_manager,
+    const EvaluatorOptions& options, int64_t thread_count) {
+  XLS_RET_CHECK_GE(thread_count, 0);
+  XLS_RET_CHECK(!options.support_observers())
+      << "ParallelProcRuntime does not support observers";
+  // Verify there exists exactly one evaluator per proc in the package.
+  absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>> evaluator_map;
+  for (std::unique_ptr<ProcEvaluator>& evaluator : evaluators) {
+    Proc* proc = evaluator->proc();
+    auto [it, inserted] = evaluator_map.insert({proc, std::move(evaluator)});
+    XLS_RET_CHECK(inserted) << absl::StreamFormat(
+        "More than one evaluator given for proc `%s`", proc->name());
+  }
+  for (Proc* proc : queue_manager->elaboration().procs()) {
+    XLS_RET_CHECK(evaluator_map.contains(proc))
+        << absl::StreamFormat("No evaluator given for proc `%s`", proc->name());
+  }
+  XLS_RET_CHECK_EQ(evaluator_map.size(),
+                   queue_manager->elaboration().procs().size())
+      << "More evaluators than procs given.";
+
+  if (thread_count == 0) {
+    thread_count = AvailableCPUs();
+  }
+  // There is no point in having more workers than proc instances.
+  thread_count = std::max<int64_t>(
+      1, std::min<int64_t>(
+             thread_count,
+             queue_manager->elaboration().proc_instances().size()));
+  return absl::WrapUnique(new ParallelProcRuntime(
+      std::move(evaluator_map), std::move(queue_manager), options,
+      thread_count));
+}
+
+ParallelProcRuntime::ParallelProcRuntime(
+    absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>>&& evaluators,
+    std::unique_ptr<ChannelQueueManager>&& queue_manager,
+    const EvaluatorOptions& options, int64_t thread_count)
+    : ProcRuntime(std::move(evaluators), std::move(queue_manager), options) {
+  worker_queues_.reserve(thread_count);
+  for (int64_t i = 0; i < thread_count; ++i) {
+    worker_queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+  workers_.reserve(thread_count);
+  for (int64_t i = 0; i < thread_count; ++i) {
+    workers_.push_back(std::make_unique<Thread>([this, i]() { WorkerLoop(i); }));
+  }
+}
+
+ParallelProcRuntime::~ParallelProcRuntime() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutdown_ = true;
+  }
+  // Joins the worker threads.
+  workers_.clear();
+}
+
+bool ParallelProcRuntime::WorkAvailableOrShutdown() const {
+  return shutdown_ || (running_ && status_.ok() && ready_count_ > 0);
+}
+
+bool ParallelProcRuntime::TickDone() const {
+  return in_flight_count_ == 0 && (outstanding_count_ == 0 || !status_.ok());
+}
+
+std::optional<ParallelProcRuntime::WorkItem> ParallelProcRuntime::TryPop(
+    int64_t worker) {
+  // Take the most recently scheduled item from our own queue as it is likely
+  // to have been unblocked by (and to share data with) what we just ran.
+  {
+    WorkerQueue& own = *worker_queues_[worker];
+    absl::MutexLock lock(&own.mutex);
+    if (!own.items.empty()) {
+      WorkItem item = own.items.back();
+      own.items.pop_back();
+      return item;
+    }
+  }
+  // Steal the oldest item from another worker.
+  for (int64_t i = 1; i < worker_queues_.size(); ++i) {
+    WorkerQueue& victim =
+        *worker_queues_[(worker + i) % worker_queues_.size()];
+    absl::MutexLock lock(&victim.mutex);
+    if (!victim.items.empty()) {
+      WorkItem item = victim.items.front();
+      victim.items.pop_front();
+      return item;
+    }
+  }
+  return std::nullopt;
+}
+
+void ParallelProcRuntime::Schedule(int64_t worker, ProcInstance* instance) {
+  VLOG(3) << absl::StreamFormat("Proc instance `%s` added to ready list",
+                                instance->GetName());
+  WorkerQueue& queue = *worker_queues_[worker];
+  {
+    absl::MutexLock lock(&queue.mutex);
+    queue.items.push_back(
+        WorkItem{.instance = instance,
+                 .evaluator = evaluators_.at(instance->proc()).get(),
+                 .continuation = continuations_.at(instance).get(),
+                 .generation = generation_});
+  }
+  ++ready_count_;
+  ++outstanding_count_;
+}
+
+void ParallelProcRuntime::WorkerLoop(int64_t worker) {
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          this, &ParallelProcRuntime::WorkAvailableOrShutdown));
+      if (shutdown_) {
+        return;
+      }
+    }
+    std::optional<WorkItem> item = TryPop(worker);
+    if (!item.has_value()) {
+      // Another worker got to the item first.
+      continue;
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      --ready_count_;
+      if (!running_ || item->generation != generation_ || !status_.ok()) {
+        // The tick this item belongs to has been abandoned.
+        continue;
+      }
+      ++in_flight_count_;
+    }
+
+    VLOG(3) << absl::StreamFormat("Ticking proc instance `%s`",
+                                  item->instance->GetName());
+    absl::StatusOr<TickResult> tick_result =
+        item->evaluator->Tick(*item->continuation);
+    if (tick_result.ok()) {
+      absl::Status events_status =
+          InterpreterEventsToStatus(GetInterpreterEvents(item->instance));
+      if (!events_status.ok()) {
+        tick_result = events_status;
+      }
+    }
+
+    absl::MutexLock lock(&mutex_);
+    HandleTickResult(worker, *item, tick_result);
+    --in_flight_count_;
+    --outstanding_count_;
+  }
+}
+
+void ParallelProcRuntime::HandleTickResult(
+    int64_t worker, const WorkItem& item,
+    const absl::StatusOr<TickResult>& tick_result) {
+  if (!tick_result.ok()) {
+    if (status_.ok()) {
+      status_ = tick_result.status();
+    }
+    return;
+  }
+  VLOG(3) << "Tick result: " << *tick_result;
+  progress_made_ |= tick_result->progress_made;
+  progress_made_on_io_procs_ |=
+      (tick_result->progress_made && item.evaluator->ProcHasIoOperations());
+  if (tick_result->execution_state == TickExecutionState::kSentOnChannel) {
+    ChannelInstance* channel_instance = tick_result->channel_instance.value();
+    auto it = blocked_instances_.find(channel_instance);
+    if (it != blocked_instances_.end()) {
+      VLOG(3) << absl::StreamFormat(
+          "Unblocking proc instance `%s` and adding to ready list",
+          it->second->GetName());
+      Schedule(worker, it->second);
+      blocked_instances_.erase(it);
+    }
+    // This proc instance can go back on the ready queue.
+    Schedule(worker, item.instance);
+  } else if (tick_result->execution_state ==
+             TickExecutionState::kBlockedOnReceive) {
+    ChannelInstance* channel_instance = tick_result->channel_instance.value();
+    // The sender may have run concurrently with this tick, after the receive
+    // observed an empty queue. Every send is followed by a check of
+    // `blocked_instances_` under the lock so checking the queue here under the
+    // lock is enough to avoid losing the wakeup.
+    if (!queue_manager().GetQueue(channel_instance).IsEmpty()) {
+      Schedule(worker, item.instance);
+    } else {
+      VLOG(3) << absl::StreamFormat(
+          "Proc instance `%s` is now blocked on channel instance `%s`",
+          item.instance->GetName(), channel_instance->ToString());
+      blocked_instances_[channel_instance] = item.instance;
+    }
+  }
+}
+
+absl::StatusOr<ParallelProcRuntime::NetworkTickResult>
+ParallelProcRuntime::TickInternal() {
+  VLOG(3) << absl::StreamFormat("TickInternal on package %s",
+                                package()->name());
+  absl::MutexLock lock(&mutex_);
+  ++generation_;
+  running_ = true;
+  status_ = absl::OkStatus();
+  progress_made_ = false;
+  progress_made_on_io_procs_ = false;
+  blocked_instances_.clear();
+
+  // Put all proc instances on the ready lists, spread across the workers.
+  int64_t next_worker = 0;
+  for (ProcInstance* instance : elaboration().proc_instances()) {
+    Schedule(next_worker, instance);
+    next_worker = (next_worker + 1) % worker_queues_.size();
+  }
+  mutex_.Await(absl::Condition(this, &ParallelProcRuntime::TickDone));
+  running_ = false;
+
+  // Discard anything left over from an abandoned tick.
+  for (std::unique_ptr<WorkerQueue>& queue : worker_queues_) {
+    absl::MutexLock queue_lock(&queue->mutex);
+    ready_count_ -= queue->items.size();
+    queue->items.clear();
+  }
+  outstanding_count_ = 0;
+  XLS_RETURN_IF_ERROR(status_);
+  return NetworkTickResult{
+      .progress_made = progress_made_,
+      .progress_made_on_io_procs = progress_made_on_io_procs_,
+  };
+}
+
+std::vector<ChannelInstance*>
+ParallelProcRuntime::GetBlockedChannelInstances() {
+  absl::MutexLock lock(&mutex_);
+  std::vector<ChannelInstance*> blocked_channel_instances;
+  for (ChannelInstance* instance : elaboration().channel_instances()) {
+    if (blocked_instances_.contains(instance)) {
+      blocked_channel_instances.push_back(instance);
+    }
+  }
+  return blocked_channel_instances;
+}
+
+}  // namespace xls
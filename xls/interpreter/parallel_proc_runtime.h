@@ -0,0 +1,136 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_INTERPRETER_PARALLEL_PROC_RUNTIME_H_
+#define XLS_INTERPRETER_PARALLEL_PROC_RUNTIME_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/proc_evaluator.h"
+#include "xls/interpreter/proc_runtime.h"
+#include "xls/ir/proc_elaboration.h"
+
+namespace xls {
+
+// Class for interpreting a network of procs using a pool of worker threads.
+// Semantically equivalent to SerialProcRuntime: each call to Tick() runs every
+// proc instance until it either completes an activation or blocks on a
+// receive. Proc instances which are ready to run are distributed across
+// per-worker queues and idle workers steal from the other workers' queues. A
+// proc instance blocked on a receive is parked until a value is sent on the
+// channel it is waiting for.
+//
+// All channel queues must be thread-safe (e.g., those created by
+// JitChannelQueueManager::CreateThreadSafe or CreateLockFree; each proc
+// instance is ticked by at most one worker at a time so single-producer
+// single-consumer queues are sufficient) and evaluators must support
+// concurrent ticks of distinct continuations. Networks whose results depend on
+// the relative timing of procs (e.g., through non-blocking receives on
+// internal channels) may produce different results than SerialProcRuntime.
+// Observers are not supported. ParallelProcRuntimes are thread-compatible, but
+// not thread-safe.
+class ParallelProcRuntime : public ProcRuntime {
+ public:
+  // Creates and returns a proc network interpreter for the given evaluators
+  // which uses `thread_count` worker threads. If `thread_count` is zero one
+  // worker per available CPU is used.
+  static absl::StatusOr<std::unique_ptr<ParallelProcRuntime>> Create(
+      std::vector<std::unique_ptr<ProcEvaluator>>&& evaluators,
+      std::unique_ptr<ChannelQueueManager>&& queue_manager,
+      const EvaluatorOptions& options = EvaluatorOptions(),
+      int64_t thread_count = 0);
+
+  ~ParallelProcRuntime() override;
+
+  int64_t thread_count() const { return worker_queues_.size(); }
+
+ private:
+  struct WorkItem {
+    ProcInstance* instance;
+    ProcEvaluator* evaluator;
+    ProcContinuation* continuation;
+    // The tick during which this item was scheduled. Items left over from a
+    // tick that ended with an error are discarded.
+    int64_t generation;
+  };
+
+  struct WorkerQueue {
+    absl::Mutex mutex;
+    std::deque<WorkItem> items ABSL_GUARDED_BY(mutex);
+  };
+
+  ParallelProcRuntime(
+      absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>>&& evaluators,
+      std::unique_ptr<ChannelQueueManager>&& queue_manager,
+      const EvaluatorOptions& options, int64_t thread_count);
+
+  absl::StatusOr<NetworkTickResult> TickInternal() override;
+  std::vector<ChannelInstance*> GetBlockedChannelInstances() override;
+
+  // Main loop of the worker thread with the given index.
+  void WorkerLoop(int64_t worker);
+
+  // Pops an item from the worker's own queue or steals one from another
+  // worker's queue.
+  std::optional<WorkItem> TryPop(int64_t worker);
+
+  // Schedules the given proc instance on the given worker's queue.
+  void Schedule(int64_t worker, ProcInstance* instance)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Conditions waited upon by the workers and by TickInternal respectively.
+  bool WorkAvailableOrShutdown() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool TickDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Updates the scheduler state with the result of ticking `item`.
+  void HandleTickResult(int64_t worker, const WorkItem& item,
+                        const absl::StatusOr<TickResult>& tick_result)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  std::vector<std::unique_ptr<WorkerQueue>> worker_queues_;
+  std::vector<std::unique_ptr<Thread>> workers_;
+
+  absl::Mutex mutex_;
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+  bool running_ ABSL_GUARDED_BY(mutex_) = false;
+  int64_t generation_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Number of items in the worker queues.
+  int64_t ready_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Number of items scheduled during this tick which have not yet finished
+  // being ticked, including those currently being ticked.
+  int64_t outstanding_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Number of items currently being ticked.
+  int64_t in_flight_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  bool progress_made_ ABSL_GUARDED_BY(mutex_) = false;
+  bool progress_made_on_io_procs_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::flat_hash_map<ChannelInstance*, ProcInstance*> blocked_instances_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_PARALLEL_PROC_RUNTIME_H_
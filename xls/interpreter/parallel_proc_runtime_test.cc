@@ -0,0 +1,118 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/parallel_proc_runtime.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/proc_runtime.h"
+#include "xls/interpreter/proc_runtime_test_base.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/channel_ops.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/jit_proc_runtime.h"
+
+namespace xls {
+namespace {
+
+using ::testing::Optional;
+
+class ParallelProcRuntimeTest : public IrTestBase {};
+
+// A chain of `kStages` procs each of which adds one to the value it receives
+// and forwards it to the next proc.
+TEST_F(ParallelProcRuntimeTest, LongPipeline) {
+  constexpr int64_t kStages = 32;
+  constexpr int64_t kValues = 200;
+  auto package = CreatePackage();
+  std::vector<Channel*> channels;
+  for (int64_t i = 0; i <= kStages; ++i) {
+    ChannelOps ops = i == 0         ? ChannelOps::kReceiveOnly
+                     : i == kStages ? ChannelOps::kSendOnly
+                                    : ChannelOps::kSendReceive;
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Channel * channel,
+        package->CreateStreamingChannel(absl::StrCat("ch", i), ops,
+                                        package->GetBitsType(32)));
+    channels.push_back(channel);
+  }
+  for (int64_t i = 0; i < kStages; ++i) {
+    TokenlessProcBuilder pb(absl::StrCat("stage", i), "tkn", package.get());
+    pb.Send(channels[i + 1],
+            pb.Add(pb.Receive(channels[i]), pb.Literal(UBits(1, 32))));
+    XLS_ASSERT_OK(pb.Build({}).status());
+  }
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ParallelProcRuntime> runtime,
+      CreateJitParallelProcRuntime(package.get(), EvaluatorOptions(),
+                                   /*thread_count=*/4));
+  EXPECT_EQ(runtime->thread_count(), 4);
+  ChannelQueue& input = runtime->queue_manager().GetQueue(channels.front());
+  ChannelQueue& output = runtime->queue_manager().GetQueue(channels.back());
+  for (int64_t i = 0; i < kValues; ++i) {
+    XLS_ASSERT_OK(input.Write(Value(UBits(i, 32))));
+  }
+  XLS_ASSERT_OK(runtime->TickUntilOutput({{channels.back(), kValues}},
+                                         /*max_ticks=*/10 * kValues)
+                    .status());
+  for (int64_t i = 0; i < kValues; ++i) {
+    EXPECT_THAT(output.Read(), Optional(Value(UBits(i + kStages, 32))));
+  }
+}
+
+TEST_F(ParallelProcRuntimeTest, ObserversAreRejected) {
+  auto package = CreatePackage();
+  TokenlessProcBuilder pb(TestName(), "tkn", package.get());
+  XLS_ASSERT_OK(pb.Build({}).status());
+  EXPECT_FALSE(CreateJitParallelProcRuntime(
+                   package.get(), EvaluatorOptions().set_support_observers(true))
+                   .ok());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ProcRuntimeTest, ProcRuntimeTestBase,
+    testing::Values(ProcRuntimeTestParam(
+        "jit_parallel",
+        [](Package* package, const EvaluatorOptions& options)
+            -> std::unique_ptr<ProcRuntime> {
+          return CreateJitParallelProcRuntime(package, options,
+                                              /*thread_count=*/4)
+              .value();
+        },
+        [](Proc* top, const EvaluatorOptions& options)
+            -> std::unique_ptr<ProcRuntime> {
+          return CreateJitParallelProcRuntime(top, options,
+                                              /*thread_count=*/4)
+              .value();
+        },
+        /*supports_observers=*/false)),
+    [](const testing::TestParamInfo<ProcRuntimeTestBase::ParamType>& info) {
+      return info.param.name();
+    });
+
+}  // namespace
+}  // namespace xls
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -25,6 +26,7 @@
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/observer.h"
 #include "xls/interpreter/proc_evaluator.h"
@@ -37,6 +39,7 @@
 #include "xls/ir/proc.h"
 #include "xls/ir/proc_elaboration.h"
 #include "xls/ir/value.h"
+#include "xls/ir/value_utils.h"
 
 namespace xls {
 namespace {
@@ -1065,6 +1068,72 @@ TEST_P(ProcEvaluatorTestBase, MultiStateElementProc) {
               ElementsAre(Value(UBits(31, 32)), Value(UBits(69, 32))));
 }
 
+TEST_P(ProcEvaluatorTestBase, SparselyUpdatedStateProc) {
+  auto package = CreatePackage();
+
+  // Proc has two state elements:
+  //  table: array updated at index `i`, only on even iterations
+  //  i: iteration count
+  ProcBuilder pb("sparse", package.get());
+  XLS_ASSERT_OK_AND_ASSIGN(Value zeros,
+                           Value::UBitsArray(std::vector<uint64_t>(16, 0), 32));
+  BValue table = pb.StateElement("table", zeros);
+  BValue i = pb.StateElement("i", Value(UBits(0, 32)));
+  BValue even_iteration = pb.Eq(pb.BitSlice(i, /*start=*/0, /*width=*/1),
+                                pb.Literal(UBits(0, 1)));
+  BValue updated_table =
+      pb.ArrayUpdate(table, pb.Add(i, pb.Literal(UBits(100, 32))), {i});
+  pb.Next(/*state_read=*/table, /*value=*/updated_table,
+          /*pred=*/even_iteration);
+  pb.Next(/*state_read=*/i, /*value=*/pb.Add(i, pb.Literal(UBits(1, 32))));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build());
+
+  std::unique_ptr<ChannelQueueManager> queue_manager =
+      GetParam().CreateQueueManager(package.get());
+  std::unique_ptr<ProcEvaluator> evaluator =
+      GetParam().CreateEvaluator(proc, queue_manager.get());
+  std::unique_ptr<ProcContinuation> continuation = evaluator->NewContinuation(
+      queue_manager->elaboration().GetUniqueInstance(proc).value());
+
+  auto expected_table =
+      [](std::vector<std::pair<int64_t, uint64_t>> updates) {
+        std::vector<uint64_t> elements(16, 0);
+        for (auto [index, value] : updates) {
+          elements[index] = value;
+        }
+        return Value::UBitsArray(elements, 32).value();
+      };
+  for (int64_t tick = 0; tick < 4; ++tick) {
+    EXPECT_THAT(evaluator->Tick(*continuation),
+                IsOkAndHolds(TickResult{
+                    .execution_state = TickExecutionState::kCompleted,
+                    .channel_instance = std::nullopt,
+                    .progress_made = true}));
+  }
+  EXPECT_THAT(continuation->GetState(),
+              ElementsAre(expected_table({{0, 100}, {2, 102}}),
+                          Value(UBits(4, 32))));
+
+  // Elements without an active next value keep the value they were set to.
+  XLS_ASSERT_OK(continuation->SetState(
+      {expected_table({{5, 42}}), Value(UBits(7, 32))}));
+  EXPECT_THAT(
+      evaluator->Tick(*continuation),
+      IsOkAndHolds(TickResult{.execution_state = TickExecutionState::kCompleted,
+                              .channel_instance = std::nullopt,
+                              .progress_made = true}));
+  EXPECT_THAT(continuation->GetState(),
+              ElementsAre(expected_table({{5, 42}}), Value(UBits(8, 32))));
+  EXPECT_THAT(
+      evaluator->Tick(*continuation),
+      IsOkAndHolds(TickResult{.execution_state = TickExecutionState::kCompleted,
+                              .channel_instance = std::nullopt,
+                              .progress_made = true}));
+  EXPECT_THAT(continuation->GetState(),
+              ElementsAre(expected_table({{5, 42}, {8, 108}}),
+                          Value(UBits(9, 32))));
+}
+
 TEST_P(ProcEvaluatorTestBase, NonBlockingReceives) {
   auto package = CreatePackage();
   XLS_ASSERT_OK_AND_ASSIGN(Channel * in0, package->CreateStreamingChannel(
@@ -1259,6 +1328,77 @@ TEST_P(ProcEvaluatorTestBase, NonBlockingReceivesZeroRecv) {
   EXPECT_THAT(out0_queue.Read(), Optional(Value(UBits(0, 32))));
 }
 
+TEST_P(ProcEvaluatorTestBase, WidePayloads) {
+  // Wide payloads may take a different path through the JIT's channel queues
+  // than narrow ones. Exercise conditional and non-blocking receives of wide
+  // values including the cases where nothing is received.
+  auto package = CreatePackage();
+  Type* wide_type = package->GetTupleType(
+      {package->GetBitsType(1000), package->GetBitsType(48)});
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in0, package->CreateStreamingChannel(
+                         "in0", ChannelOps::kReceiveOnly, wide_type));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in1, package->CreateStreamingChannel(
+                         "in1", ChannelOps::kReceiveOnly, wide_type));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out0, package->CreateStreamingChannel(
+                          "out0", ChannelOps::kSendOnly, wide_type));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out1, package->CreateStreamingChannel(
+                          "out1", ChannelOps::kSendOnly, wide_type));
+
+  TokenlessProcBuilder pb("wide", /*token_name=*/"tok", package.get());
+  BValue st = pb.StateElement("st", Value(UBits(1, 1)));
+  BValue in0_data = pb.ReceiveIf(in0, /*pred=*/st);
+  auto [in1_data, in1_valid] = pb.ReceiveNonBlocking(in1);
+  pb.Send(out0, in0_data);
+  pb.Send(out1, in1_data);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({pb.Not(st)}));
+
+  std::unique_ptr<ChannelQueueManager> queue_manager =
+      GetParam().CreateQueueManager(package.get());
+  std::unique_ptr<ProcEvaluator> evaluator =
+      GetParam().CreateEvaluator(proc, queue_manager.get());
+  std::unique_ptr<ProcContinuation> continuation = evaluator->NewContinuation(
+      queue_manager->elaboration().GetUniqueInstance(proc).value());
+
+  auto tick_until_completed = [&]() -> absl::Status {
+    while (true) {
+      XLS_ASSIGN_OR_RETURN(TickResult result, evaluator->Tick(*continuation));
+      if (result.execution_state == TickExecutionState::kCompleted) {
+        return absl::OkStatus();
+      }
+      if (result.execution_state != TickExecutionState::kSentOnChannel) {
+        return absl::InternalError("Unexpected tick result");
+      }
+    }
+  };
+
+  Value a = Value::Tuple({Value(Bits::AllOnes(1000)), Value(UBits(42, 48))});
+  Value b = Value::Tuple({Value(UBits(123, 1000)), Value(Bits::AllOnes(48))});
+  Value zero = ZeroOfType(wide_type);
+
+  // First activation: the receive_if predicate is true and in1 has a value.
+  XLS_ASSERT_OK(queue_manager->GetQueue(in0).Write(a));
+  XLS_ASSERT_OK(queue_manager->GetQueue(in1).Write(b));
+  XLS_ASSERT_OK(tick_until_completed());
+  EXPECT_THAT(queue_manager->GetQueue(out0).Read(), Optional(a));
+  EXPECT_THAT(queue_manager->GetQueue(out1).Read(), Optional(b));
+
+  // Second activation: the predicate is false and in1 is empty so both
+  // received values are zero and the value in in0 stays put.
+  XLS_ASSERT_OK(queue_manager->GetQueue(in0).Write(b));
+  XLS_ASSERT_OK(tick_until_completed());
+  EXPECT_THAT(queue_manager->GetQueue(out0).Read(), Optional(zero));
+  EXPECT_THAT(queue_manager->GetQueue(out1).Read(), Optional(zero));
+
+  // Third activation: the value left in in0 is received.
+  XLS_ASSERT_OK(tick_until_completed());
+  EXPECT_THAT(queue_manager->GetQueue(out0).Read(), Optional(b));
+  EXPECT_THAT(queue_manager->GetQueue(out1).Read(), Optional(zero));
+}
+
 TEST_P(ProcEvaluatorTestBase, ProcSetState) {
   auto package = CreatePackage();
   XLS_ASSERT_OK_AND_ASSIGN(
@@ -33,6 +33,7 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/node_value_map.h"
 #include "xls/interpreter/observer.h"
 #include "xls/interpreter/proc_evaluator.h"
 #include "xls/ir/bits.h"
@@ -55,7 +56,9 @@ class ProcInterpreterContinuation : public ProcContinuation {
   // Construct a new continuation. Execution the proc begins with the state set
   // to its initial values with no proc nodes yet executed.
   explicit ProcInterpreterContinuation(ProcInstance* proc_instance)
-      : ProcContinuation(proc_instance), node_index_(0) {
+      : ProcContinuation(proc_instance),
+        node_index_(0),
+        node_values_(proc_instance->proc()) {
     state_.reserve(proc()->GetStateElementCount());
     for (StateElement* state_element : proc()->StateElements()) {
       state_.push_back(state_element->initial_value());
@@ -101,8 +104,8 @@ class ProcInterpreterContinuation : public ProcContinuation {
   void SetNodeExecutionIndex(int64_t index) { node_index_ = index; }
 
   // Returns the map of node values computed in the tick so far.
-  absl::flat_hash_map<Node*, Value>& GetNodeValues() { return node_values_; }
-  const absl::flat_hash_map<Node*, Value>& GetNodeValues() const {
+  NodeValueMap& GetNodeValues() { return node_values_; }
+  const NodeValueMap& GetNodeValues() const {
     return node_values_;
   }
 
@@ -111,7 +114,7 @@ class ProcInterpreterContinuation : public ProcContinuation {
   std::vector<Value> state_;
 
   InterpreterEvents events_;
-  absl::flat_hash_map<Node*, Value> node_values_;
+  NodeValueMap node_values_;
   absl::flat_hash_map<StateElement*, std::vector<Next*>> active_next_values_;
 };
 
@@ -128,7 +131,7 @@ class ProcIrInterpreter : public IrInterpreter {
   //   events: events object to record events in (e.g, traces).
   //   queue_manager: manager for channel queues.
   ProcIrInterpreter(ProcInstance* proc_instance, absl::Span<const Value> state,
-                    absl::flat_hash_map<Node*, Value>* node_values,
+                    NodeValueMap* node_values,
                     InterpreterEvents* events,
                     ChannelQueueManager* queue_manager,
                     absl::flat_hash_map<StateElement*, std::vector<Next*>>*
@@ -33,6 +33,7 @@
 #include "absl/synchronization/mutex.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/checkpoint.pb.h"
 #include "xls/interpreter/evaluator_options.h"
 #include "xls/interpreter/observer.h"
 #include "xls/interpreter/proc_evaluator.h"
@@ -43,6 +44,7 @@
 #include "xls/ir/package.h"
 #include "xls/ir/proc_elaboration.h"
 #include "xls/ir/value.h"
+#include "xls/ir/xls_value.pb.h"
 #include "xls/jit/jit_channel_queue.h"
 
 namespace xls {
@@ -110,10 +112,13 @@ ProcRuntime::ProcRuntime(
     std::unique_ptr<ChannelQueueManager>&& queue_manager,
     const EvaluatorOptions& options)
     : queue_manager_(std::move(queue_manager)),
-      evaluators_(std::move(evaluators)) {
+      evaluators_(std::move(evaluators)),
+      options_(options) {
   for (ProcInstance* instance : elaboration().proc_instances()) {
     std::unique_ptr<ProcContinuation> continuation =
         evaluators_.at(instance->proc())->NewContinuation(instance);
+    continuation->GetEvents().max_trace_verbosity =
+        options_.max_trace_verbosity();
     continuations_[instance] = std::move(continuation);
   }
   if (options.trace_channels()) {
@@ -125,14 +130,13 @@ ProcRuntime::ProcRuntime(
 }
 
 absl::Status ProcRuntime::Tick() {
-  std::vector<Channel*> blocked_channels;
   XLS_ASSIGN_OR_RETURN(NetworkTickResult result, TickInternal());
   if (!result.progress_made) {
     // Not a single instruction executed on any proc. This is necessarily a
     // deadlock.
     return absl::InternalError(absl::StrFormat(
         "Proc network is deadlocked. Blocked channel instances: %s",
-        absl::StrJoin(result.blocked_channel_instances, ", ",
+        absl::StrJoin(GetBlockedChannelInstances(), ", ",
                       [](std::string* s, ChannelInstance* c) {
                         absl::StrAppend(s, c->ToString());
                       })));
@@ -231,6 +235,8 @@ void ProcRuntime::ResetState() {
   for (ProcInstance* instance : elaboration().proc_instances()) {
     continuations_[instance] =
         evaluators_.at(instance->proc())->NewContinuation(instance);
+    continuations_[instance]->GetEvents().max_trace_verbosity =
+        options_.max_trace_verbosity();
     if (observer_) {
       // We must have called this successfully at least once.
       CHECK_OK(continuations_[instance]->SetObserver(*observer_));
@@ -238,6 +244,88 @@ void ProcRuntime::ResetState() {
   }
 }
 
+absl::StatusOr<ProcRuntimeCheckpointProto> ProcRuntime::Checkpoint() {
+  ProcRuntimeCheckpointProto checkpoint;
+  for (ProcInstance* instance : elaboration().proc_instances()) {
+    const ProcContinuation& continuation = *continuations_.at(instance);
+    if (!continuation.AtStartOfTick()) {
+      return absl::FailedPreconditionError(absl::StrFormat(
+          "Cannot checkpoint proc instance `%s` which is blocked part way "
+          "through an activation",
+          instance->GetName()));
+    }
+    ProcRuntimeCheckpointProto::ProcInstanceState* proc_state =
+        checkpoint.add_procs();
+    proc_state->set_instance(instance->GetName());
+    for (const Value& value : continuation.GetState()) {
+      XLS_ASSIGN_OR_RETURN(*proc_state->add_state(), value.AsProto());
+    }
+  }
+  for (ChannelInstance* instance : elaboration().channel_instances()) {
+    ProcRuntimeCheckpointProto::ChannelQueueContents* contents =
+        checkpoint.add_channels();
+    contents->set_channel_instance(instance->ToString());
+    for (const Value& value :
+         queue_manager_->GetQueue(instance).GetContents()) {
+      XLS_ASSIGN_OR_RETURN(*contents->add_values(), value.AsProto());
+    }
+  }
+  return checkpoint;
+}
+
+absl::Status ProcRuntime::Restore(
+    const ProcRuntimeCheckpointProto& checkpoint) {
+  absl::flat_hash_map<std::string, ProcInstance*> proc_instances;
+  for (ProcInstance* instance : elaboration().proc_instances()) {
+    proc_instances[instance->GetName()] = instance;
+  }
+  absl::flat_hash_map<std::string, ChannelInstance*> channel_instances;
+  for (ChannelInstance* instance : elaboration().channel_instances()) {
+    channel_instances[instance->ToString()] = instance;
+  }
+
+  // Resolve names and convert values before modifying the runtime so
+  // checkpoints of a different package are rejected up front.
+  absl::flat_hash_map<ProcInstance*, std::vector<Value>> states;
+  for (const ProcRuntimeCheckpointProto::ProcInstanceState& proc_state :
+       checkpoint.procs()) {
+    auto it = proc_instances.find(proc_state.instance());
+    if (it == proc_instances.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Checkpoint contains unknown proc instance `%s`",
+                          proc_state.instance()));
+    }
+    std::vector<Value>& state = states[it->second];
+    for (const ValueProto& value : proc_state.state()) {
+      XLS_ASSIGN_OR_RETURN(state.emplace_back(), Value::FromProto(value));
+    }
+  }
+  absl::flat_hash_map<ChannelInstance*, std::vector<Value>> contents;
+  for (const ProcRuntimeCheckpointProto::ChannelQueueContents& channel :
+       checkpoint.channels()) {
+    auto it = channel_instances.find(channel.channel_instance());
+    if (it == channel_instances.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Checkpoint contains unknown channel instance `%s`",
+                          channel.channel_instance()));
+    }
+    std::vector<Value>& values = contents[it->second];
+    for (const ValueProto& value : channel.values()) {
+      XLS_ASSIGN_OR_RETURN(values.emplace_back(), Value::FromProto(value));
+    }
+  }
+
+  ResetState();
+  for (auto& [instance, state] : states) {
+    XLS_RETURN_IF_ERROR(
+        continuations_.at(instance)->SetState(std::move(state)));
+  }
+  for (const auto& [instance, values] : contents) {
+    XLS_RETURN_IF_ERROR(queue_manager_->GetQueue(instance).SetContents(values));
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<JitChannelQueueManager*>
 ProcRuntime::GetJitChannelQueueManager() {
   auto* jit_qm = dynamic_cast<JitChannelQueueManager*>(queue_manager_.get());
@@ -27,6 +27,7 @@
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/checkpoint.pb.h"
 #include "xls/interpreter/evaluator_options.h"
 #include "xls/interpreter/observer.h"
 #include "xls/interpreter/proc_evaluator.h"
@@ -109,6 +110,18 @@ class ProcRuntime {
   // Reset the state of all of the procs to their initial state.
   void ResetState();
 
+  // Returns a snapshot of the state of every proc instance and the contents of
+  // every channel queue. The snapshot is only taken between complete ticks;
+  // returns an error if any proc is blocked part way through an activation.
+  // Values which generators attached to channel queues have yet to produce are
+  // not part of the snapshot.
+  absl::StatusOr<ProcRuntimeCheckpointProto> Checkpoint();
+
+  // Restores the proc state and channel queue contents from a snapshot taken
+  // with Checkpoint, possibly by a runtime of a different kind created from
+  // the same package. Pending activations are discarded.
+  absl::Status Restore(const ProcRuntimeCheckpointProto& checkpoint);
+
   // Returns the events for each proc in the network.
   const InterpreterEvents& GetInterpreterEvents(ProcInstance* instance) const {
     return continuations_.at(instance)->GetEvents();
@@ -152,11 +165,15 @@ class ProcRuntime {
 
     // Whether any instruction on a proc with IO executed
     bool progress_made_on_io_procs;
-
-    std::vector<ChannelInstance*> blocked_channel_instances;
   };
   virtual absl::StatusOr<NetworkTickResult> TickInternal() = 0;
 
+  // Returns the channel instances which proc instances were blocked on at the
+  // end of the last tick, in the order of ProcElaboration::channel_instances().
+  // Only used to report deadlocks, so it is computed on demand rather than
+  // after every tick.
+  virtual std::vector<ChannelInstance*> GetBlockedChannelInstances() = 0;
+
   std::unique_ptr<ChannelQueueManager> queue_manager_;
   absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>> evaluators_;
   absl::flat_hash_map<ProcInstance*, std::unique_ptr<ProcContinuation>>
@@ -29,6 +29,7 @@
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/checkpoint.pb.h"
 #include "xls/interpreter/evaluator_options.h"
 #include "xls/interpreter/observer.h"
 #include "xls/interpreter/proc_runtime.h"
@@ -1082,6 +1083,71 @@ TEST_P(ProcRuntimeTestBase, ProcSetState) {
   EXPECT_TRUE(ch0_queue.IsEmpty());
 }
 
+TEST_P(ProcRuntimeTestBase, CheckpointAndRestore) {
+  auto package = CreatePackage();
+  // An iota proc which keeps its state in a channel with multiple initial
+  // values so that the checkpoint includes channel contents as well as proc
+  // state.
+  ProcBuilder pb(TestName(), package.get());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * state_channel,
+      package->CreateStreamingChannel(
+          "state", ChannelOps::kSendReceive, package->GetBitsType(32),
+          {Value(UBits(42, 32)), Value(UBits(55, 32)), Value(UBits(100, 32))}));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * output_channel,
+      package->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                      package->GetBitsType(32)));
+  BValue count = pb.StateElement("count", Value(UBits(0, 32)));
+  BValue state_receive = pb.Receive(state_channel, pb.Literal(Value::Token()));
+  BValue state = pb.TupleIndex(state_receive, /*idx=*/1);
+  pb.Send(output_channel, pb.Literal(Value::Token()), pb.Add(state, count));
+  pb.Send(state_channel, pb.TupleIndex(state_receive, /*idx=*/0),
+          pb.Add(state, pb.Literal(UBits(1, 32))));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb.Build({pb.Add(count, pb.Literal(UBits(1000, 32)))}));
+
+  std::unique_ptr<ProcRuntime> runtime =
+      GetParam().CreateRuntime(package.get());
+  XLS_ASSERT_OK(runtime->Tick());
+  XLS_ASSERT_OK(runtime->Tick());
+  XLS_ASSERT_OK_AND_ASSIGN(ProcRuntimeCheckpointProto checkpoint,
+                           runtime->Checkpoint());
+  EXPECT_EQ(checkpoint.procs_size(), 1);
+
+  XLS_ASSERT_OK(runtime->Tick());
+  XLS_ASSERT_OK(runtime->Tick());
+  ChannelQueue& output_queue =
+      runtime->queue_manager().GetQueue(output_channel);
+  EXPECT_THAT(output_queue.GetContents(),
+              ElementsAre(Value(UBits(42, 32)), Value(UBits(1055, 32)),
+                          Value(UBits(2100, 32)), Value(UBits(3043, 32))));
+
+  // Restoring into a fresh runtime and into the original one both resume from
+  // the checkpoint.
+  std::unique_ptr<ProcRuntime> restored_runtime =
+      GetParam().CreateRuntime(package.get());
+  for (ProcRuntime* r : {runtime.get(), restored_runtime.get()}) {
+    XLS_ASSERT_OK(r->Restore(checkpoint));
+    EXPECT_THAT(r->ResolveState(proc), ElementsAre(Value(UBits(2000, 32))));
+    ChannelQueue& queue = r->queue_manager().GetQueue(output_channel);
+    EXPECT_THAT(queue.GetContents(),
+                ElementsAre(Value(UBits(42, 32)), Value(UBits(1055, 32))));
+    XLS_ASSERT_OK(r->Tick());
+    XLS_ASSERT_OK(r->Tick());
+    EXPECT_THAT(queue.Read(), Optional(Value(UBits(42, 32))));
+    EXPECT_THAT(queue.Read(), Optional(Value(UBits(1055, 32))));
+    EXPECT_THAT(queue.Read(), Optional(Value(UBits(2100, 32))));
+    EXPECT_THAT(queue.Read(), Optional(Value(UBits(3043, 32))));
+    EXPECT_TRUE(queue.IsEmpty());
+  }
+
+  checkpoint.mutable_procs(0)->set_instance("not_a_proc");
+  EXPECT_THAT(runtime->Restore(checkpoint),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unknown proc instance `not_a_proc`")));
+}
+
 TEST_P(ProcRuntimeTestBase, TraceChannels) {
   auto package = CreatePackage();
   XLS_ASSERT_OK_AND_ASSIGN(
@@ -1165,5 +1231,30 @@ TEST_P(ProcRuntimeTestBase, TraceChannels) {
   }
 }
 
+TEST_P(ProcRuntimeTestBase, TraceVerbosityFilter) {
+  auto package = CreatePackage();
+  ProcBuilder pb("tracer", package.get());
+  BValue counter = pb.StateElement("cnt", Value(UBits(0, 32)));
+  BValue tkn = pb.Literal(Value::Token());
+  BValue cond = pb.Literal(UBits(1, 1));
+  pb.Trace(tkn, cond, {counter}, "low: {}", /*verbosity=*/0);
+  pb.Trace(tkn, cond, {counter}, "high: {}", /*verbosity=*/2);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb.Build({pb.Add(counter, pb.Literal(UBits(1, 32)))}));
+
+  // Traces above the maximum verbosity are never recorded.
+  std::unique_ptr<ProcRuntime> runtime = GetParam().CreateRuntime(
+      package.get(), EvaluatorOptions().set_max_trace_verbosity(1));
+  XLS_ASSERT_OK(runtime->Tick());
+  XLS_ASSERT_OK(runtime->Tick());
+
+  const InterpreterEvents& events = runtime->GetInterpreterEvents(proc);
+  std::vector<std::string> event_messages;
+  for (const TraceMessage& message : events.trace_msgs) {
+    event_messages.push_back(message.message);
+  }
+  EXPECT_THAT(event_messages, ElementsAre("low: 0", "low: 1"));
+}
+
 }  // namespace
 }  // namespace xls
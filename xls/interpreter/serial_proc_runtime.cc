@@ -14,16 +14,19 @@
 
 #include "xls/interpreter/serial_proc_runtime.h"
 
-#include <deque>
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
@@ -55,92 +58,117 @@ SerialProcRuntime::Create(
   XLS_RET_CHECK_EQ(evaluator_map.size(),
                    queue_manager->elaboration().procs().size())
       << "More evaluators than procs given.";
-  auto network_interpreter = absl::WrapUnique(new SerialProcRuntime(
-      std::move(evaluator_map), std::move(queue_manager), options));
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<ProcInstance*> tick_order,
+      queue_manager->elaboration().GetProcInstancesInDataflowOrder());
+  auto network_interpreter = absl::WrapUnique(
+      new SerialProcRuntime(std::move(evaluator_map), std::move(queue_manager),
+                            std::move(tick_order), options));
   return std::move(network_interpreter);
 }
 
+SerialProcRuntime::SerialProcRuntime(
+    absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>>&& evaluators,
+    std::unique_ptr<ChannelQueueManager>&& queue_manager,
+    std::vector<ProcInstance*> tick_order, const EvaluatorOptions& options)
+    : ProcRuntime(std::move(evaluators), std::move(queue_manager), options),
+      tick_order_(std::move(tick_order)) {
+  evaluators_by_index_.reserve(tick_order_.size());
+  for (ProcInstance* instance : tick_order_) {
+    evaluators_by_index_.push_back(evaluators_.at(instance->proc()).get());
+  }
+  absl::Span<ChannelInstance* const> channel_instances =
+      elaboration().channel_instances();
+  channel_index_.reserve(channel_instances.size());
+  for (int64_t i = 0; i < channel_instances.size(); ++i) {
+    channel_index_[channel_instances[i]] = i;
+  }
+  blocked_instance_.resize(channel_instances.size(), -1);
+}
+
 absl::StatusOr<SerialProcRuntime::NetworkTickResult>
 SerialProcRuntime::TickInternal() {
   VLOG(3) << absl::StreamFormat("TickInternal on package %s",
                                 package()->name());
-  // Map containing any blocked proc instances and the channels they are blocked
-  // on.
-  absl::flat_hash_map<ChannelInstance*, ProcInstance*> blocked_instances;
-
-  struct QueueElement {
-    ProcInstance* instance;
-    ProcEvaluator* evaluator;
-    ProcContinuation* continuation;
-  };
-  std::deque<QueueElement> ready_instances;
+  // Forget the proc instances blocked during the previous tick (or left over
+  // from a tick which ended with an error).
+  for (int64_t channel : blocked_channels_) {
+    blocked_instance_[channel] = -1;
+  }
+  blocked_channels_.clear();
+  ready_instances_.clear();
 
-  // Put all proc instances on the ready list.
-  for (ProcInstance* instance : elaboration().proc_instances()) {
+  // Put all proc instances on the ready list. Producers go first so their
+  // consumers don't block on values sent later in the same tick.
+  for (int64_t i = 0; i < tick_order_.size(); ++i) {
     VLOG(3) << absl::StreamFormat("Proc instance `%s` added to ready list",
-                                  instance->GetName());
-    ready_instances.push_back(
-        QueueElement{.instance = instance,
-                     .evaluator = evaluators_.at(instance->proc()).get(),
-                     .continuation = continuations_.at(instance).get()});
+                                  tick_order_[i]->GetName());
+    ready_instances_.push_back(i);
   }
 
   bool progress_made = false;
   bool progress_made_on_io_procs = false;
-  while (!ready_instances.empty()) {
-    const QueueElement element = ready_instances.front();
-    ready_instances.pop_front();
+  while (!ready_instances_.empty()) {
+    const int64_t index = ready_instances_.front();
+    ready_instances_.pop_front();
+    ProcInstance* instance = tick_order_[index];
+    ProcEvaluator* evaluator = evaluators_by_index_[index];
 
     VLOG(3) << absl::StreamFormat("Ticking proc instance `%s`",
-                                  element.instance->GetName());
+                                  instance->GetName());
     XLS_ASSIGN_OR_RETURN(TickResult tick_result,
-                         element.evaluator->Tick(*element.continuation));
-    const InterpreterEvents& events =
-        this->GetInterpreterEvents(element.instance);
+                         evaluator->Tick(*continuations_.at(instance)));
+    const InterpreterEvents& events = this->GetInterpreterEvents(instance);
     XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(events));
     VLOG(3) << "Tick result: " << tick_result;
 
     progress_made |= tick_result.progress_made;
     progress_made_on_io_procs |=
-        (tick_result.progress_made && element.evaluator->ProcHasIoOperations());
+        (tick_result.progress_made && evaluator->ProcHasIoOperations());
     if (tick_result.execution_state == TickExecutionState::kSentOnChannel) {
-      ChannelInstance* channel_instance = tick_result.channel_instance.value();
-      if (blocked_instances.contains(channel_instance)) {
+      int64_t channel = channel_index_.at(tick_result.channel_instance.value());
+      if (int64_t blocked = blocked_instance_[channel]; blocked >= 0) {
         VLOG(3) << absl::StreamFormat(
             "Unblocking proc instance `%s` and adding to ready list",
-            blocked_instances.at(channel_instance)->GetName());
-        ProcInstance* instance = blocked_instances.at(channel_instance);
-        ready_instances.push_back(
-            QueueElement{.instance = instance,
-                         .evaluator = evaluators_.at(instance->proc()).get(),
-                         .continuation = continuations_.at(instance).get()});
-        blocked_instances.erase(channel_instance);
+            tick_order_[blocked]->GetName());
+        ready_instances_.push_back(blocked);
+        blocked_instance_[channel] = -1;
       }
       // This proc instance can go back on the ready queue.
-      ready_instances.push_back(element);
+      ready_instances_.push_back(index);
     } else if (tick_result.execution_state ==
                TickExecutionState::kBlockedOnReceive) {
       ChannelInstance* channel_instance = tick_result.channel_instance.value();
       VLOG(3) << absl::StreamFormat(
           "Proc instance `%s` is now blocked on channel instance `%s`",
-          element.instance->GetName(), channel_instance->ToString());
-      blocked_instances[channel_instance] = element.instance;
+          instance->GetName(), channel_instance->ToString());
+      int64_t channel = channel_index_.at(channel_instance);
+      blocked_instance_[channel] = index;
+      blocked_channels_.push_back(channel);
     }
   }
-  auto get_blocked_channel_instances = [&]() {
-    std::vector<ChannelInstance*> instances;
-    for (ChannelInstance* instance : elaboration().channel_instances()) {
-      if (blocked_instances.contains(instance)) {
-        instances.push_back(instance);
-      }
-    }
-    return instances;
-  };
   return NetworkTickResult{
       .progress_made = progress_made,
       .progress_made_on_io_procs = progress_made_on_io_procs,
-      .blocked_channel_instances = get_blocked_channel_instances(),
   };
 }
 
+std::vector<ChannelInstance*> SerialProcRuntime::GetBlockedChannelInstances() {
+  std::vector<int64_t> channels;
+  for (int64_t channel : blocked_channels_) {
+    if (blocked_instance_[channel] >= 0) {
+      channels.push_back(channel);
+    }
+  }
+  absl::c_sort(channels);
+  channels.erase(std::unique(channels.begin(), channels.end()),
+                 channels.end());
+  std::vector<ChannelInstance*> instances;
+  instances.reserve(channels.size());
+  for (int64_t channel : channels) {
+    instances.push_back(elaboration().channel_instances()[channel]);
+  }
+  return instances;
+}
+
 }  // namespace xls
@@ -15,6 +15,8 @@
 #ifndef XLS_INTERPRETER_SERIAL_PROC_RUNTIME_H_
 #define XLS_INTERPRETER_SERIAL_PROC_RUNTIME_H_
 
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -26,6 +28,7 @@
 #include "xls/interpreter/proc_evaluator.h"
 #include "xls/interpreter/proc_runtime.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc_elaboration.h"
 
 namespace xls {
 
@@ -45,10 +48,29 @@ class SerialProcRuntime : public ProcRuntime {
   SerialProcRuntime(
       absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>>&& evaluators,
       std::unique_ptr<ChannelQueueManager>&& queue_manager,
-      const EvaluatorOptions& options = EvaluatorOptions())
-      : ProcRuntime(std::move(evaluators), std::move(queue_manager), options) {}
+      std::vector<ProcInstance*> tick_order,
+      const EvaluatorOptions& options = EvaluatorOptions());
 
   absl::StatusOr<SerialProcRuntime::NetworkTickResult> TickInternal() override;
+  std::vector<ChannelInstance*> GetBlockedChannelInstances() override;
+
+  // Order in which the proc instances are ticked (see
+  // ProcElaboration::GetProcInstancesInDataflowOrder). Proc instances are
+  // referred to by their position in this order and channel instances by their
+  // position in ProcElaboration::channel_instances().
+  std::vector<ProcInstance*> tick_order_;
+  std::vector<ProcEvaluator*> evaluators_by_index_;
+  absl::flat_hash_map<ChannelInstance*, int64_t> channel_index_;
+
+  // Scheduler state, kept across ticks so that its storage is reused and only
+  // the entries touched by the previous tick need to be reset.
+  std::deque<int64_t> ready_instances_;
+  // The proc instance blocked on each channel instance, or -1.
+  std::vector<int64_t> blocked_instance_;
+  // The channel instances on which a proc instance blocked during the last
+  // tick. May contain duplicates and channel instances which were unblocked
+  // later in the tick.
+  std::vector<int64_t> blocked_channels_;
 };
 
 }  // namespace xls
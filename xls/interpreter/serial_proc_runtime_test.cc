@@ -177,6 +177,22 @@ INSTANTIATE_TEST_SUITE_P(
               return CreateJitSerialProcRuntime(top, options).value();
             },
             /*supports_observers=*/true),
+        ProcRuntimeTestParam(
+            "jit_serial_compile",
+            [](Package* package, const EvaluatorOptions& options)
+                -> std::unique_ptr<ProcRuntime> {
+              EvaluatorOptions serial_options = options;
+              serial_options.set_jit_compile_threads(1);
+              return CreateJitSerialProcRuntime(package, serial_options)
+                  .value();
+            },
+            [](Proc* top, const EvaluatorOptions& options)
+                -> std::unique_ptr<ProcRuntime> {
+              EvaluatorOptions serial_options = options;
+              serial_options.set_jit_compile_threads(1);
+              return CreateJitSerialProcRuntime(top, serial_options).value();
+            },
+            /*supports_observers=*/true),
         ProcRuntimeTestParam(
             "mixed",
             [](Package* package, const EvaluatorOptions& options)
@@ -48,6 +48,14 @@ namespace xls {
 //     ...
 //
 // And define non-virtual methods One, Zero, Not, And, and Or.
+//
+// The derived class may also define any of the vector operations below (for
+// example Add, UMul, ULessThan or BitwiseAnd) with the same signature, e.g. to
+// operate on a packed representation a machine word at a time. The compound
+// operations here (Neg, division, shifts, selects, ...) call the vector
+// operations through the derived class, so such versions are picked at compile
+// time wherever they are used. A derived version may fall back to the generic
+// one by calling it qualified, e.g. AbstractEvaluator::UMul(a, b).
 template <typename ElementT, typename EvaluatorT>
 class AbstractEvaluator {
   using ThisType = AbstractEvaluator<ElementT, EvaluatorT>;
@@ -152,7 +160,7 @@ class AbstractEvaluator {
   Vector BitwiseXor(Span a, Span b) { return BitwiseXor({a, b}); }
 
   Vector Gate(const Element& a, const Span& b) {
-    return BitwiseAnd(SignExtend({a}, b.size()), b);
+    return derived().BitwiseAnd(SignExtend({a}, b.size()), b);
   }
 
   Vector BitSlice(Span input, int64_t start, int64_t width) {
@@ -195,7 +203,8 @@ class AbstractEvaluator {
     //  (Not(A is non-neg and B is neg) && ULessThan(a, b))
     Element a_neg_b_non_neg = And(a.back(), Not(b.back()));
     Element a_non_neg_b_neg = And(Not(a.back()), b.back());
-    return Or(a_neg_b_non_neg, And(Not(a_non_neg_b_neg), ULessThan(a, b)));
+    return Or(a_neg_b_non_neg,
+              And(Not(a_non_neg_b_neg), derived().ULessThan(a, b)));
   }
 
   Element ULessThan(Span a, Span b) {
@@ -208,9 +217,13 @@ class AbstractEvaluator {
     }
     return result;
   }
-  Element ULessThanOrEqual(Span a, Span b) { return Not(ULessThan(b, a)); }
-  Element UGreaterThan(Span a, Span b) { return ULessThan(b, a); }
-  Element UGreaterThanOrEqual(Span a, Span b) { return Not(ULessThan(a, b)); }
+  Element ULessThanOrEqual(Span a, Span b) {
+    return Not(derived().ULessThan(b, a));
+  }
+  Element UGreaterThan(Span a, Span b) { return derived().ULessThan(b, a); }
+  Element UGreaterThanOrEqual(Span a, Span b) {
+    return Not(derived().ULessThan(a, b));
+  }
 
   Vector OneHotSelect(Span selector, SpanOfSpan cases,
                       bool selector_can_be_zero) {
@@ -302,22 +315,24 @@ class AbstractEvaluator {
     int64_t num_ones = std::min(input.size(), value.size());
     Bits start_ones =
         bits_ops::ZeroExtend(Bits::AllOnes(num_ones), input.size());
-    Vector mask = BitwiseNot(ShiftLeftLogical(BitsToVector(start_ones), start));
+    Vector mask = derived().BitwiseNot(
+        derived().ShiftLeftLogical(BitsToVector(start_ones), start));
 
     // Adjust 'value' to the same width as 'input' either by truncation or
     // zero-extension.
     Vector adjusted_value = value.size() >= input.size()
                                 ? BitSlice(value, 0, input.size())
                                 : ZeroExtend(value, input.size());
-    return BitwiseOr(BitwiseAnd(mask, input),
-                     ShiftLeftLogical(adjusted_value, start));
+    Vector shifted_value = derived().ShiftLeftLogical(adjusted_value, start);
+    return derived().BitwiseOr(derived().BitwiseAnd(mask, input),
+                               shifted_value);
   }
 
   // Binary encode and decode operations.
   Vector Decode(Span input, int64_t result_width) {
     Vector result(result_width);
     for (int64_t i = 0; i < result_width; ++i) {
-      result[i] = Equals(input, BitsToVector(UBits(i, input.size())));
+      result[i] = derived().Equals(input, BitsToVector(UBits(i, input.size())));
     }
     return result;
   }
@@ -385,7 +400,8 @@ class AbstractEvaluator {
     if (x.empty()) {
       return SpanToVec(x);
     }
-    return Add(BitwiseNot(x), BitsToVector(UBits(1, x.size())));
+    return derived().Add(derived().BitwiseNot(x),
+                         BitsToVector(UBits(1, x.size())));
   }
 
   Vector Abs(Span x) { return IfBits(x.back(), Neg(x), x); }
@@ -401,7 +417,7 @@ class AbstractEvaluator {
     int max = std::max(a.size(), b.size());
     Vector temp_a = SignExtend(a, max * 2);
     Vector temp_b = SignExtend(b, max * 2);
-    Vector result = UMul(temp_a, temp_b);
+    Vector result = derived().UMul(temp_a, temp_b);
     return BitSlice(result, 0, a.size() + b.size());
   }
 
@@ -550,8 +566,8 @@ class AbstractEvaluator {
 
       // If r >= divisor, then subtract divisor from r and set q[i] := 1.
       // Otherwise, set q[i] := 0.
-      q[i] = Not(ULessThan(r, divisor));
-      r = IfBits(q[i], Add(r, neg_divisor), r);
+      q[i] = Not(derived().ULessThan(r, divisor));
+      r = IfBits(q[i], derived().Add(r, neg_divisor), r);
 
       // Remove the MSB of r; guaranteed to be 0 because r < d.
       // Ensures r.size() == d.size().
@@ -595,6 +611,10 @@ class AbstractEvaluator {
   Vector SMod(Span n, Span d) { return SDivMod(n, d).remainder; }
 
  private:
+  // The vector operations used by the compound operations above are called
+  // through the derived evaluator so that its versions, if any, are used.
+  EvaluatorT& derived() { return static_cast<EvaluatorT&>(*this); }
+
   // An implementation of OneHotSelect which takes a span of spans of Elements
   // rather than a span of Vectors. This enables the cases to be overlapping
   // spans of the same underlying vector as is used in the shift implementation.
@@ -622,7 +642,7 @@ class AbstractEvaluator {
           }
         }
       }
-      result = BitwiseOr(and_reduction, result);
+      result = derived().BitwiseOr(and_reduction, result);
     }
     return result;
   }
@@ -635,15 +655,16 @@ class AbstractEvaluator {
     Vector one_hot_selector;
     for (int64_t i = 0; i < cases.size(); ++i) {
       one_hot_selector.push_back(
-          Equals(selector, BitsToVector(UBits(i, selector.size()))));
+          derived().Equals(selector, BitsToVector(UBits(i, selector.size()))));
     }
     // Copy the cases span as we may need to append to it.
     // TODO(allight): In some cases we can avoid copy.
     std::vector<Span> cases_vec(cases.begin(), cases.end());
     if (default_value.has_value()) {
       one_hot_selector.push_back(
-          ULessThan(BitsToVector(UBits(cases_vec.size() - 1, selector.size())),
-                    selector));
+          derived().ULessThan(
+              BitsToVector(UBits(cases_vec.size() - 1, selector.size())),
+              selector));
       cases_vec.push_back(*default_value);
     }
     return OneHotSelectInternal(one_hot_selector, cases_vec,
@@ -716,13 +737,14 @@ class AbstractEvaluator {
         // 'amount' doesn't have enough bits to express this shift amount.
         break;
       }
-      selector.push_back(Equals(amount, bits_vector(i)));
+      selector.push_back(derived().Equals(amount, bits_vector(i)));
     }
     // If 'amount' is wide enough to express over-shifting (shifting greater
     // than or equal to the input size), we need an additional case to catch
     // these instances.
     if (amount.size() >= Bits::MinBitCountUnsigned(input.size())) {
-      selector.push_back(Not(ULessThan(amount, bits_vector(input.size()))));
+      selector.push_back(
+          Not(derived().ULessThan(amount, bits_vector(input.size()))));
     }
 
     // Create a span for each case in the one-hot-select. Each span corresponds
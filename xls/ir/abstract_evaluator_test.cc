@@ -361,6 +361,71 @@ TEST(AbstractEvaluatorTest, SLessThan) {
   EXPECT_EQ(eval.SLessThan(ToBoxedVector(a), ToBoxedVector(b)).value, 0);
 }
 
+// Evaluator which supplies its own Add, UMul and ULessThan and counts how
+// often they are used.
+class CountingAbstractEvaluator
+    : public AbstractEvaluator<BoxedBool, CountingAbstractEvaluator> {
+ public:
+  BoxedBool One() const { return {true}; }
+  BoxedBool Zero() const { return {false}; }
+  BoxedBool Not(const BoxedBool& input) const { return {!input.value}; }
+  BoxedBool And(const BoxedBool& a, const BoxedBool& b) const {
+    return {a.value && b.value};
+  }
+  BoxedBool Or(const BoxedBool& a, const BoxedBool& b) const {
+    return {a.value || b.value};
+  }
+  BoxedBool If(const BoxedBool& a, const BoxedBool& b,
+               const BoxedBool& c) const {
+    return a.value ? b : c;
+  }
+
+  Vector Add(Span a, Span b) {
+    ++add_count;
+    return AbstractEvaluator::Add(a, b);
+  }
+  Vector UMul(Span a, Span b) {
+    ++umul_count;
+    return AbstractEvaluator::UMul(a, b);
+  }
+  BoxedBool ULessThan(Span a, Span b) {
+    ++ult_count;
+    return AbstractEvaluator::ULessThan(a, b);
+  }
+
+  int64_t add_count = 0;
+  int64_t umul_count = 0;
+  int64_t ult_count = 0;
+};
+
+TEST(AbstractEvaluatorTest, CompoundOpsUseDerivedOps) {
+  CountingAbstractEvaluator eval;
+  EXPECT_EQ(FromBoxedVector(eval.Neg(ToBoxedVector(SBits(3, 8)))),
+            SBits(-3, 8));
+  EXPECT_EQ(eval.add_count, 1);
+
+  EXPECT_EQ(FromBoxedVector(eval.SMul(ToBoxedVector(SBits(-3, 8)),
+                                      ToBoxedVector(SBits(5, 8)))),
+            SBits(-15, 16));
+  EXPECT_EQ(eval.umul_count, 1);
+
+  EXPECT_TRUE(
+      eval.SLessThan(ToBoxedVector(SBits(-3, 8)), ToBoxedVector(SBits(5, 8)))
+          .value);
+  EXPECT_FALSE(eval.UGreaterThan(ToBoxedVector(UBits(3, 8)),
+                                 ToBoxedVector(UBits(5, 8)))
+                   .value);
+  EXPECT_EQ(eval.ult_count, 2);
+
+  eval.add_count = 0;
+  eval.ult_count = 0;
+  EXPECT_EQ(FromBoxedVector(eval.UDiv(ToBoxedVector(UBits(100, 8)),
+                                      ToBoxedVector(UBits(7, 8)))),
+            UBits(14, 8));
+  EXPECT_GT(eval.add_count, 0);
+  EXPECT_GT(eval.ult_count, 0);
+}
+
 TEST(AbstractEvaluatorTest, PrioritySelect) {
   TestAbstractEvaluator eval;
   auto test_eq = [&](int64_t expected, const Bits& selector,
@@ -14,7 +14,6 @@
 
 #include "xls/ir/big_int.h"
 
-#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -30,10 +29,21 @@
 #include "openssl/base.h"
 #include "openssl/bn.h"
 #include "openssl/mem.h"
-#include "xls/common/bits_util.h"
+#include "xls/common/math_util.h"
 #include "xls/ir/bits.h"
 
 namespace xls {
+namespace {
+
+// Returns the BN_CTX (scratch space for BIGNUM operations) of the calling
+// thread. Creating a context allocates so it is reused across operations.
+BN_CTX* ThreadBnCtx() {
+  thread_local bssl::UniquePtr<BN_CTX> ctx(BN_CTX_new());
+  CHECK(ctx != nullptr) << "BigNum allocation failure";
+  return ctx.get();
+}
+
+}  // namespace
 
 BigInt::BigInt() { BN_init(&bn_); }
 
@@ -55,7 +65,11 @@ BigInt& BigInt::operator=(const BigInt& other) {
 }
 
 BigInt& BigInt::operator=(BigInt&& other) {
-  CHECK(BN_copy(&bn_, &other.bn_));
+  // Swap the limbs rather than copying them; `other` frees ours.
+  BIGNUM tmp;
+  memcpy(&tmp, &bn_, sizeof(bn_));
+  memcpy(&bn_, &other.bn_, sizeof(bn_));
+  memcpy(&other.bn_, &tmp, sizeof(bn_));
   return *this;
 }
 
@@ -65,37 +79,19 @@ bool BigInt::operator==(const BigInt& other) const {
 
 /* static */ BigInt BigInt::MakeUnsigned(const Bits& bits) {
   BigInt value;
+  // ToBytes returns little-endian bytes which BN reads directly.
   std::vector<uint8_t> byte_vector = bits.ToBytes();
-  // ToBytes returns in little-endian. BN expects big-endian.
-  std::reverse(byte_vector.begin(), byte_vector.end());
-  CHECK(BN_bin2bn(byte_vector.data(), byte_vector.size(), &value.bn_));
+  CHECK(BN_le2bn(byte_vector.data(), byte_vector.size(), &value.bn_));
   return value;
 }
 
 /* static */ BigInt BigInt::MakeSigned(const Bits& bits) {
-  if (bits.bit_count() == 0 || !bits.msb()) {
-    return MakeUnsigned(bits);
-  }
-  BigInt value;
-  // 'bits' is a twos-complement negative number, invert the bits and add one to
-  // get the magnitude. Then negate it to produce the correct value in the
-  // BigInt.
-  std::vector<uint8_t> byte_vector = bits.ToBytes();
-  // ToBytes returns in little-endian. BN expects big-endian.
-  std::reverse(byte_vector.begin(), byte_vector.end());
-  for (auto& byte : byte_vector) {
-    byte = ~byte;
+  BigInt value = MakeUnsigned(bits);
+  if (bits.bit_count() > 0 && bits.msb()) {
+    // 'bits' is a twos-complement negative number whose value is its unsigned
+    // value minus 2^bit_count.
+    CHECK(BN_sub(&value.bn_, &value.bn_, &Exp2(bits.bit_count()).bn_));
   }
-  // ToBytes pads the most significant bits with zeroes to fit the return value
-  // in whole bytes. Set them back to zero after the bit inversion above.
-  int bits_in_msb = bits.bit_count() % 8;
-  if (bits_in_msb) {  // There are pad bits.
-    byte_vector[0] &= Mask(bits_in_msb);
-  }
-
-  CHECK(BN_bin2bn(byte_vector.data(), byte_vector.size(), &value.bn_));
-  CHECK(BN_add_word(&value.bn_, 1));
-  BN_set_negative(&value.bn_, 1);
   return value;
 }
 
@@ -112,48 +108,28 @@ bool BigInt::operator==(const BigInt& other) const {
 }
 
 Bits BigInt::ToSignedBits() const {
-  if (BN_is_zero(&bn_)) {
-    return Bits();
-  }
-  bool is_negative = BN_is_negative(&bn_) != 0;
-
-  // In twos-complement, negative values are stored as their positive
-  // counterpart - 1, bit inverted. First compute the positive counterpart - 1.
-  BigInt decremented_if_negative = *this;
-  BN_set_negative(&decremented_if_negative.bn_, 0);
-  if (is_negative) {
-    CHECK(BN_sub_word(&decremented_if_negative.bn_, 1));
-  }
-
-  std::vector<uint8_t> byte_vector;
-  byte_vector.resize(BN_num_bytes(&decremented_if_negative.bn_));
-  CHECK(BN_bn2bin_padded(byte_vector.data(), byte_vector.size(),
-                         &decremented_if_negative.bn_));
-
-  if (is_negative) {
-    for (uint8_t& byte : byte_vector) {
-      byte = ~byte;
-    }
-  }
-
-  int64_t result_bit_count = SignedBitCount();
-  BitsRope rope(result_bit_count);
-  // FromBytes expects bytes in little endian order.
-  std::reverse(byte_vector.begin(), byte_vector.end());
-  rope.push_back(Bits::FromBytes(byte_vector, result_bit_count - 1));
-  rope.push_back(is_negative ? Bits::AllOnes(1) : Bits(1));
-  return rope.Build();
+  return ToBitsTruncated(SignedBitCount());
 }
 
 Bits BigInt::ToUnsignedBits() const {
   CHECK(!BN_is_negative(&bn_));
-  int64_t bit_count = BN_num_bits(&bn_);
-  std::vector<uint8_t> byte_vector;
-  byte_vector.resize(BN_num_bytes(&bn_));
-
-  CHECK(BN_bn2bin_padded(byte_vector.data(), byte_vector.size(), &bn_));
-  // FromBytes expects bytes in little endian order.
-  std::reverse(byte_vector.begin(), byte_vector.end());
+  return ToBitsTruncated(BN_num_bits(&bn_));
+}
+
+Bits BigInt::ToBitsTruncated(int64_t bit_count) const {
+  CHECK_GE(bit_count, 0);
+  CHECK_LE(bit_count, int64_t{std::numeric_limits<int>::max()});
+  // Reduce the value modulo 2^bit_count to a non-negative number with at most
+  // `bit_count` bits which BN writes out in little-endian order as expected
+  // by FromBytes.
+  const BIGNUM* residue = &bn_;
+  BigInt reduced;
+  if (BN_is_negative(&bn_) || BN_num_bits(&bn_) > bit_count) {
+    CHECK(BN_nnmod(&reduced.bn_, &bn_, &Exp2(bit_count).bn_, ThreadBnCtx()));
+    residue = &reduced.bn_;
+  }
+  std::vector<uint8_t> byte_vector(CeilOfRatio(bit_count, int64_t{8}));
+  CHECK(BN_bn2le_padded(byte_vector.data(), byte_vector.size(), residue));
   return Bits::FromBytes(byte_vector, bit_count);
 }
 
@@ -181,16 +157,7 @@ absl::StatusOr<Bits> BigInt::ToSignedBitsWithBitCount(int64_t bit_count) const {
         bit_count, min_bit_count));
   }
 
-  // Can't use bits_ops due to circular dependency.
-  BitsRope rope(bit_count);
-  Bits bits = ToSignedBits();
-  rope.push_back(bits);
-  if (BN_is_negative(&bn_)) {
-    rope.push_back(Bits::AllOnes(bit_count - min_bit_count));
-  } else {
-    rope.push_back(Bits(bit_count - min_bit_count));
-  }
-  return rope.Build();
+  return ToBitsTruncated(bit_count);
 }
 
 absl::StatusOr<Bits> BigInt::ToUnsignedBitsWithBitCount(
@@ -202,12 +169,7 @@ absl::StatusOr<Bits> BigInt::ToUnsignedBitsWithBitCount(
         bit_count, min_bit_count));
   }
 
-  // Can't use bits_ops due to circular dependency.
-  BitsRope rope(bit_count);
-  Bits bits = ToUnsignedBits();
-  rope.push_back(bits);
-  rope.push_back(Bits(bit_count - min_bit_count));
-  return rope.Build();
+  return ToBitsTruncated(bit_count);
 }
 
 int64_t BigInt::SignedBitCount() const {
@@ -252,47 +214,30 @@ int64_t BigInt::UnsignedBitCount() const {
   BigInt value;
   // Note: The documentation about BN_CTX in bn.h indicates that it's possible
   // to pass null to public methods that take a BN_CTX*, but that's not true.
-  BN_CTX* ctx = BN_CTX_new();
-  CHECK(ctx);
-  CHECK(BN_mul(&value.bn_, &lhs.bn_, &rhs.bn_, ctx));
-  BN_CTX_free(ctx);
+  CHECK(BN_mul(&value.bn_, &lhs.bn_, &rhs.bn_, ThreadBnCtx()));
   return value;
 }
 
 /* static */ BigInt BigInt::Div(const BigInt& lhs, const BigInt& rhs) {
   BigInt value;
-  // Note: The documentation about BN_CTX in bn.h indicates that it's possible
-  // to pass null to public methods that take a BN_CTX*, but that's not true.
-  BN_CTX* ctx = BN_CTX_new();
-  CHECK(ctx);
-  CHECK(BN_div(&value.bn_, /*rem=*/nullptr, &lhs.bn_, &rhs.bn_, ctx));
-  BN_CTX_free(ctx);
+  CHECK(BN_div(&value.bn_, /*rem=*/nullptr, &lhs.bn_, &rhs.bn_,
+               ThreadBnCtx()));
   return value;
 }
 
 /* static */ BigInt BigInt::Mod(const BigInt& lhs, const BigInt& rhs) {
   BigInt value;
-  // Note: The documentation about BN_CTX in bn.h indicates that it's possible
-  // to pass null to public methods that take a BN_CTX*, but that's not true.
-  BN_CTX* ctx = BN_CTX_new();
-  CHECK(ctx);
   CHECK(BN_div(/*quotient=*/nullptr, /*rem=*/&value.bn_, &lhs.bn_, &rhs.bn_,
-               ctx));
-  BN_CTX_free(ctx);
+               ThreadBnCtx()));
   return value;
 }
 
 /* static */ BigInt BigInt::Exp2(int64_t e) {
   CHECK_GE(e, 0);
-  BigInt one = BigInt::One();
-  if (e == 0) {
-    return one;
-  }
-
   CHECK_LE(e, int64_t{std::numeric_limits<int>::max()});
 
   BigInt value;
-  BN_lshift(&value.bn_, &one.bn_, static_cast<int>(e));
+  CHECK(BN_set_bit(&value.bn_, static_cast<int>(e)));
   return value;
 }
 
@@ -334,8 +279,8 @@ bool BigInt::operator>=(const BigInt& rhs) const {
     return false;
   }
 
-  const int64_t num_significant_bits = BN_num_bits(&input.bn_);
-  return BigInt::Exp2(num_significant_bits - 1) == input;
+  return int64_t{BN_count_low_zero_bits(&input.bn_)} ==
+         int64_t{BN_num_bits(&input.bn_)} - 1;
 }
 
 /* static */ int64_t BigInt::CeilingLog2(const BigInt& input) {
@@ -350,7 +295,7 @@ bool BigInt::operator>=(const BigInt& rhs) const {
   }
 
   const int64_t num_significant_bits = BN_num_bits(&input.bn_);
-  if (BigInt::Exp2(num_significant_bits - 1) == input) {
+  if (BN_count_low_zero_bits(&input.bn_) == num_significant_bits - 1) {
     return num_significant_bits - 1;
   }
 
@@ -359,14 +304,12 @@ bool BigInt::operator>=(const BigInt& rhs) const {
 
 /* static */ std::tuple<BigInt, int64_t> BigInt::FactorizePowerOfTwo(
     const BigInt& input) {
-  const BigInt zero = BigInt::Zero();
-  const BigInt two = BigInt::Exp2(1);
-  int64_t power = 0;
-  BigInt x = input;
-  while (IsEven(x) && x != zero) {
-    x = x / two;
-    power = power + 1;
+  if (BN_is_zero(&input.bn_)) {
+    return std::make_tuple(input, int64_t{0});
   }
+  int64_t power = BN_count_low_zero_bits(&input.bn_);
+  BigInt x;
+  CHECK(BN_rshift(&x.bn_, &input.bn_, static_cast<int>(power)));
   return std::make_tuple(x, power);
 }
 
@@ -67,6 +67,11 @@ class BigInt {
   absl::StatusOr<Bits> ToSignedBitsWithBitCount(int64_t bit_count) const;
   absl::StatusOr<Bits> ToUnsignedBitsWithBitCount(int64_t bit_count) const;
 
+  // Returns the low `bit_count` bits of the twos-complement representation of
+  // the value, i.e. the value modulo 2^bit_count. Never fails, unlike the
+  // *WithBitCount methods, which makes it suitable for wrapping arithmetic.
+  Bits ToBitsTruncated(int64_t bit_count) const;
+
   // Returns the minimum number of bits required to hold this BigInt value. For
   // SignedBitCount this is the number of bits required to hold the value in
   // twos-complement representation.
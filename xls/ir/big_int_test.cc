@@ -236,6 +236,28 @@ TEST_F(BigIntTest, ToUnsignedBitsWithBitCount) {
       StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST_F(BigIntTest, ToBitsTruncated) {
+  EXPECT_EQ(MakeBigInt(42).ToBitsTruncated(32), UBits(42, 32));
+  EXPECT_EQ(MakeBigInt(42).ToBitsTruncated(4), UBits(0xa, 4));
+  EXPECT_EQ(MakeBigInt(-42).ToBitsTruncated(32), SBits(-42, 32));
+  EXPECT_EQ(MakeBigInt(-42).ToBitsTruncated(4), UBits(0x6, 4));
+  EXPECT_EQ(MakeBigInt(-1).ToBitsTruncated(100), Bits::AllOnes(100));
+  EXPECT_EQ(MakeBigInt(-1).ToBitsTruncated(0), Bits());
+  EXPECT_EQ(BigInt::Exp2(128).ToBitsTruncated(128), Bits(128));
+  EXPECT_EQ(BigInt::Negate(BigInt::Exp2(128)).ToBitsTruncated(130),
+            Concat({UBits(0b11, 2), Bits(128)}));
+}
+
+TEST_F(BigIntTest, WideRoundTrip) {
+  // Values wider than a BN limb survive the conversions in both directions.
+  Bits wide = Concat({UBits(0x5, 3), UBits(0x0123456789abcdef, 64),
+                      UBits(0xfedcba9876543210, 64)});
+  EXPECT_EQ(BigInt::MakeUnsigned(wide).ToUnsignedBits(), wide);
+  EXPECT_EQ(BigInt::MakeSigned(wide).ToSignedBits(), wide);
+  EXPECT_EQ(BigInt::MakeSigned(wide),
+            BigInt::MakeUnsigned(wide) - BigInt::Exp2(131));
+}
+
 TEST_F(BigIntTest, SignedBitCount) {
   EXPECT_EQ(MakeBigInt(0).SignedBitCount(), 0);
   EXPECT_EQ(MakeBigInt(-1).SignedBitCount(), 1);
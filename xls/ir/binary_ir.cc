@@ -0,0 +1,1360 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/binary_ir.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/foreign_function_data.pb.h"
+#include "xls/ir/format_preference.h"
+#include "xls/ir/format_strings.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/lsb_or_msb.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/state_element.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/ir/verifier.h"
+
+namespace xls {
+namespace {
+
+enum class FunctionBaseKind : uint8_t { kFunction = 0, kProc = 1 };
+enum class TypeTag : uint8_t { kBits = 0, kTuple = 1, kArray = 2, kToken = 3 };
+enum class ValueTag : uint8_t { kBits = 0, kTuple = 1, kArray = 2, kToken = 3 };
+
+// Appends varint-encoded integers and raw bytes to a string.
+class ByteWriter {
+ public:
+  void WriteUnsigned(uint64_t value) {
+    while (value >= 0x80) {
+      out_.push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    out_.push_back(static_cast<char>(value));
+  }
+  void WriteSigned(int64_t value) {
+    WriteUnsigned((static_cast<uint64_t>(value) << 1) ^
+                  static_cast<uint64_t>(value >> 63));
+  }
+  void WriteBool(bool value) { out_.push_back(value ? 1 : 0); }
+  void WriteRaw(std::string_view bytes) { out_.append(bytes); }
+  void WriteBlob(std::string_view bytes) {
+    WriteUnsigned(bytes.size());
+    WriteRaw(bytes);
+  }
+
+  const std::string& out() const { return out_; }
+  std::string& out() { return out_; }
+
+ private:
+  std::string out_;
+};
+
+// Reads values written by ByteWriter.
+class ByteReader {
+ public:
+  explicit ByteReader(std::string_view data) : data_(data) {}
+
+  absl::StatusOr<uint64_t> ReadUnsigned() {
+    uint64_t result = 0;
+    for (int64_t shift = 0; shift < 64; shift += 7) {
+      if (pos_ >= data_.size()) {
+        return Truncated();
+      }
+      uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return result;
+      }
+    }
+    return absl::InvalidArgumentError("Malformed varint in binary IR.");
+  }
+  absl::StatusOr<int64_t> ReadSigned() {
+    XLS_ASSIGN_OR_RETURN(uint64_t value, ReadUnsigned());
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+  absl::StatusOr<bool> ReadBool() {
+    XLS_ASSIGN_OR_RETURN(std::string_view byte, ReadRaw(1));
+    return byte[0] != 0;
+  }
+  absl::StatusOr<std::string_view> ReadRaw(uint64_t size) {
+    if (size > data_.size() - pos_) {
+      return Truncated();
+    }
+    std::string_view result = data_.substr(pos_, size);
+    pos_ += size;
+    return result;
+  }
+  absl::StatusOr<std::string_view> ReadBlob() {
+    XLS_ASSIGN_OR_RETURN(uint64_t size, ReadUnsigned());
+    return ReadRaw(size);
+  }
+
+  bool AtEnd() const { return pos_ == data_.size(); }
+
+ private:
+  absl::Status Truncated() const {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Binary IR is truncated at offset %d.", pos_));
+  }
+
+  std::string_view data_;
+  uint64_t pos_ = 0;
+};
+
+void WriteValue(const Value& value, ByteWriter& out) {
+  switch (value.kind()) {
+    case ValueKind::kBits: {
+      out.WriteUnsigned(static_cast<uint8_t>(ValueTag::kBits));
+      out.WriteUnsigned(value.bits().bit_count());
+      std::vector<uint8_t> bytes = value.bits().ToBytes();
+      out.WriteRaw(std::string_view(reinterpret_cast<const char*>(bytes.data()),
+                                    bytes.size()));
+      return;
+    }
+    case ValueKind::kTuple:
+    case ValueKind::kArray:
+      out.WriteUnsigned(static_cast<uint8_t>(
+          value.kind() == ValueKind::kTuple ? ValueTag::kTuple
+                                            : ValueTag::kArray));
+      out.WriteUnsigned(value.size());
+      for (const Value& element : value.elements()) {
+        WriteValue(element, out);
+      }
+      return;
+    case ValueKind::kToken:
+      out.WriteUnsigned(static_cast<uint8_t>(ValueTag::kToken));
+      return;
+    case ValueKind::kInvalid:
+      break;
+  }
+  LOG(FATAL) << "Cannot serialize invalid value.";
+}
+
+absl::StatusOr<Value> ReadValue(ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t tag, in.ReadUnsigned());
+  switch (static_cast<ValueTag>(tag)) {
+    case ValueTag::kBits: {
+      XLS_ASSIGN_OR_RETURN(uint64_t bit_count, in.ReadUnsigned());
+      XLS_ASSIGN_OR_RETURN(std::string_view bytes,
+                           in.ReadRaw((bit_count + 7) / 8));
+      return Value(Bits::FromBytes(
+          absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(bytes.data()),
+                              bytes.size()),
+          bit_count));
+    }
+    case ValueTag::kTuple:
+    case ValueTag::kArray: {
+      XLS_ASSIGN_OR_RETURN(uint64_t size, in.ReadUnsigned());
+      std::vector<Value> elements;
+      for (uint64_t i = 0; i < size; ++i) {
+        XLS_ASSIGN_OR_RETURN(Value element, ReadValue(in));
+        elements.push_back(std::move(element));
+      }
+      if (static_cast<ValueTag>(tag) == ValueTag::kTuple) {
+        return Value::TupleOwned(std::move(elements));
+      }
+      return Value::Array(elements);
+    }
+    case ValueTag::kToken:
+      return Value::Token();
+  }
+  return absl::InvalidArgumentError(
+      absl::StrFormat("Invalid value tag in binary IR: %d", tag));
+}
+
+void WriteSourceInfo(const SourceInfo& loc, ByteWriter& out) {
+  out.WriteUnsigned(loc.locations.size());
+  for (const SourceLocation& location : loc.locations) {
+    out.WriteSigned(location.fileno().value());
+    out.WriteSigned(location.lineno().value());
+    out.WriteSigned(location.colno().value());
+  }
+}
+
+absl::StatusOr<SourceInfo> ReadSourceInfo(ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t count, in.ReadUnsigned());
+  SourceInfo loc;
+  for (uint64_t i = 0; i < count; ++i) {
+    XLS_ASSIGN_OR_RETURN(int64_t fileno, in.ReadSigned());
+    XLS_ASSIGN_OR_RETURN(int64_t lineno, in.ReadSigned());
+    XLS_ASSIGN_OR_RETURN(int64_t colno, in.ReadSigned());
+    loc.locations.push_back(
+        SourceLocation(Fileno(fileno), Lineno(lineno), Colno(colno)));
+  }
+  return loc;
+}
+
+std::optional<std::string> ToOptionalString(
+    std::optional<std::string_view> s) {
+  return s.has_value() ? std::optional<std::string>(*s) : std::nullopt;
+}
+
+// The function base, location and name of the node being loaded.
+struct NodeContext {
+  FunctionBase* function_base;
+  const SourceInfo& loc;
+  std::string_view name;
+};
+
+// Adds a node without verifying it. The package is verified as a whole once it
+// is loaded.
+template <typename NodeT, typename... Args>
+Node* MakeNode(const NodeContext& context, Args&&... args) {
+  return context.function_base->AddNode(std::make_unique<NodeT>(
+      context.loc, std::forward<Args>(args)..., context.name,
+      context.function_base));
+}
+
+class BinaryIrWriter {
+ public:
+  explicit BinaryIrWriter(const Package* package) : package_(package) {}
+
+  absl::StatusOr<std::string> Write();
+
+ private:
+  int64_t InternString(std::string_view s);
+  int64_t InternType(Type* type);
+  int64_t InternValue(const Value& value);
+
+  // Writes an optional string as zero if absent or one plus its index.
+  void WriteOptionalString(const std::optional<std::string>& s,
+                           ByteWriter& out) {
+    out.WriteUnsigned(s.has_value() ? InternString(*s) + 1 : 0);
+  }
+
+  absl::Status WriteBody(FunctionBase* function_base, ByteWriter& out,
+                         std::vector<int64_t>& callees);
+  absl::Status WriteNode(Node* node,
+                         const absl::flat_hash_map<Node*, int64_t>& indices,
+                         ByteWriter& out, std::vector<int64_t>& callees);
+
+  const Package* package_;
+
+  std::vector<std::string> strings_;
+  absl::flat_hash_map<std::string, int64_t> string_indices_;
+
+  ByteWriter types_;
+  absl::flat_hash_map<Type*, int64_t> type_indices_;
+
+  ByteWriter values_;
+  absl::flat_hash_map<Value, int64_t> value_indices_;
+
+  absl::flat_hash_map<FunctionBase*, int64_t> function_base_indices_;
+};
+
+int64_t BinaryIrWriter::InternString(std::string_view s) {
+  auto [it, inserted] =
+      string_indices_.try_emplace(std::string(s), strings_.size());
+  if (inserted) {
+    strings_.push_back(std::string(s));
+  }
+  return it->second;
+}
+
+int64_t BinaryIrWriter::InternType(Type* type) {
+  if (auto it = type_indices_.find(type); it != type_indices_.end()) {
+    return it->second;
+  }
+  // Element types are written before the types which refer to them.
+  switch (type->kind()) {
+    case TypeKind::kBits:
+      types_.WriteUnsigned(static_cast<uint8_t>(TypeTag::kBits));
+      types_.WriteUnsigned(type->AsBitsOrDie()->bit_count());
+      break;
+    case TypeKind::kTuple: {
+      std::vector<int64_t> elements;
+      for (Type* element : type->AsTupleOrDie()->element_types()) {
+        elements.push_back(InternType(element));
+      }
+      types_.WriteUnsigned(static_cast<uint8_t>(TypeTag::kTuple));
+      types_.WriteUnsigned(elements.size());
+      for (int64_t element : elements) {
+        types_.WriteUnsigned(element);
+      }
+      break;
+    }
+    case TypeKind::kArray: {
+      int64_t element = InternType(type->AsArrayOrDie()->element_type());
+      types_.WriteUnsigned(static_cast<uint8_t>(TypeTag::kArray));
+      types_.WriteUnsigned(type->AsArrayOrDie()->size());
+      types_.WriteUnsigned(element);
+      break;
+    }
+    case TypeKind::kToken:
+      types_.WriteUnsigned(static_cast<uint8_t>(TypeTag::kToken));
+      break;
+  }
+  int64_t index = type_indices_.size();
+  type_indices_[type] = index;
+  return index;
+}
+
+int64_t BinaryIrWriter::InternValue(const Value& value) {
+  auto [it, inserted] =
+      value_indices_.try_emplace(value, value_indices_.size());
+  if (inserted) {
+    WriteValue(value, values_);
+  }
+  return it->second;
+}
+
+absl::Status BinaryIrWriter::WriteNode(
+    Node* node, const absl::flat_hash_map<Node*, int64_t>& indices,
+    ByteWriter& out, std::vector<int64_t>& callees) {
+  int64_t index = indices.size();
+  out.WriteUnsigned(ToOpProto(node->op()));
+  out.WriteUnsigned(node->id());
+  out.WriteUnsigned(node->HasAssignedName() ? InternString(node->GetName()) + 1
+                                            : 0);
+  WriteSourceInfo(node->loc(), out);
+  out.WriteUnsigned(node->operand_count());
+  for (Node* operand : node->operands()) {
+    // Operands always precede their users so they are written as the
+    // (positive) distance back to the operand.
+    out.WriteUnsigned(index - indices.at(operand));
+  }
+  auto write_callee = [&](Function* f) {
+    int64_t callee = function_base_indices_.at(f);
+    if (std::find(callees.begin(), callees.end(), callee) == callees.end()) {
+      callees.push_back(callee);
+    }
+    out.WriteUnsigned(callee);
+  };
+  switch (node->op()) {
+    case Op::kParam:
+      out.WriteUnsigned(InternType(node->GetType()));
+      break;
+    case Op::kLiteral:
+      out.WriteUnsigned(InternValue(node->As<Literal>()->value()));
+      break;
+    case Op::kArray:
+      out.WriteUnsigned(InternType(node->As<Array>()->element_type()));
+      break;
+    case Op::kArrayIndex:
+      out.WriteBool(node->As<ArrayIndex>()->assumed_in_bounds());
+      break;
+    case Op::kArrayUpdate:
+      out.WriteBool(node->As<ArrayUpdate>()->assumed_in_bounds());
+      break;
+    case Op::kArraySlice:
+      out.WriteUnsigned(node->As<ArraySlice>()->width());
+      break;
+    case Op::kAssert: {
+      Assert* assert = node->As<Assert>();
+      out.WriteUnsigned(InternString(assert->message()));
+      WriteOptionalString(assert->label(), out);
+      WriteOptionalString(assert->original_label(), out);
+      break;
+    }
+    case Op::kBitSlice:
+      out.WriteUnsigned(node->As<BitSlice>()->start());
+      out.WriteUnsigned(node->As<BitSlice>()->width());
+      break;
+    case Op::kCountedFor:
+      out.WriteSigned(node->As<CountedFor>()->trip_count());
+      out.WriteSigned(node->As<CountedFor>()->stride());
+      write_callee(node->As<CountedFor>()->body());
+      break;
+    case Op::kCover:
+      out.WriteUnsigned(InternString(node->As<Cover>()->label()));
+      WriteOptionalString(node->As<Cover>()->original_label(), out);
+      break;
+    case Op::kDecode:
+      out.WriteUnsigned(node->As<Decode>()->width());
+      break;
+    case Op::kDynamicBitSlice:
+      out.WriteUnsigned(node->As<DynamicBitSlice>()->width());
+      break;
+    case Op::kDynamicCountedFor:
+      write_callee(node->As<DynamicCountedFor>()->body());
+      break;
+    case Op::kInvoke:
+      write_callee(node->As<Invoke>()->to_apply());
+      break;
+    case Op::kMap:
+      write_callee(node->As<Map>()->to_apply());
+      break;
+    case Op::kMinDelay:
+      out.WriteUnsigned(node->As<MinDelay>()->delay());
+      break;
+    case Op::kOneHot:
+      out.WriteBool(node->As<OneHot>()->priority() == LsbOrMsb::kMsb);
+      break;
+    case Op::kReceive:
+      out.WriteUnsigned(InternString(node->As<Receive>()->channel_name()));
+      out.WriteBool(node->As<Receive>()->is_blocking());
+      break;
+    case Op::kSend:
+      out.WriteUnsigned(InternString(node->As<Send>()->channel_name()));
+      break;
+    case Op::kSel:
+      out.WriteBool(node->As<Select>()->default_value().has_value());
+      break;
+    case Op::kSignExt:
+    case Op::kZeroExt:
+      out.WriteUnsigned(node->As<ExtendOp>()->new_bit_count());
+      break;
+    case Op::kSMul:
+    case Op::kUMul:
+      out.WriteUnsigned(node->As<ArithOp>()->width());
+      break;
+    case Op::kSMulp:
+    case Op::kUMulp:
+      out.WriteUnsigned(node->As<PartialProductOp>()->width());
+      break;
+    case Op::kStateRead: {
+      XLS_ASSIGN_OR_RETURN(int64_t state_index,
+                           node->function_base()->AsProcOrDie()
+                               ->GetStateElementIndex(
+                                   node->As<StateRead>()->state_element()));
+      out.WriteUnsigned(state_index);
+      break;
+    }
+    case Op::kTrace: {
+      Trace* trace = node->As<Trace>();
+      out.WriteSigned(trace->verbosity());
+      out.WriteUnsigned(trace->format().size());
+      for (const FormatStep& step : trace->format()) {
+        if (std::holds_alternative<std::string>(step)) {
+          out.WriteBool(true);
+          out.WriteUnsigned(InternString(std::get<std::string>(step)));
+        } else {
+          out.WriteBool(false);
+          out.WriteUnsigned(InternString(
+              FormatPreferenceToString(std::get<FormatPreference>(step))));
+        }
+      }
+      break;
+    }
+    case Op::kTupleIndex:
+      out.WriteUnsigned(node->As<TupleIndex>()->index());
+      break;
+    case Op::kInputPort:
+    case Op::kOutputPort:
+    case Op::kInstantiationInput:
+    case Op::kInstantiationOutput:
+    case Op::kRegisterRead:
+    case Op::kRegisterWrite:
+      return absl::UnimplementedError(absl::StrFormat(
+          "Op %s is not supported by the binary IR format: %s",
+          OpToString(node->op()), node->GetName()));
+    default:
+      // All other ops are fully described by their operands.
+      break;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status BinaryIrWriter::WriteBody(FunctionBase* function_base,
+                                       ByteWriter& out,
+                                       std::vector<int64_t>& callees) {
+  // Params and state reads are written first and in order so that they are
+  // recreated in the same positions.
+  std::vector<Node*> order(function_base->params().begin(),
+                           function_base->params().end());
+  if (function_base->IsProc()) {
+    Proc* proc = function_base->AsProcOrDie();
+    out.WriteUnsigned(proc->GetStateElementCount());
+    for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+      StateElement* state_element = proc->GetStateElement(i);
+      out.WriteUnsigned(InternString(state_element->name()));
+      out.WriteUnsigned(InternValue(state_element->initial_value()));
+      order.push_back(proc->GetStateRead(i));
+    }
+  }
+  // The remaining nodes are written in the order they were added if operands
+  // precede their users in it, which is the case for parsed IR, so the loaded
+  // function base is identical including the order of its nodes. Otherwise
+  // they are written in topological order.
+  absl::flat_hash_set<Node*> written(order.begin(), order.end());
+  int64_t leading_count = order.size();
+  bool is_topological = true;
+  for (Node* node : function_base->nodes()) {
+    if (node->Is<Param>() || node->Is<StateRead>()) {
+      continue;
+    }
+    is_topological = absl::c_all_of(
+        node->operands(),
+        [&](Node* operand) { return written.contains(operand); });
+    if (!is_topological) {
+      break;
+    }
+    written.insert(node);
+    order.push_back(node);
+  }
+  if (!is_topological) {
+    order.resize(leading_count);
+    for (Node* node : TopoSort(function_base)) {
+      if (!node->Is<Param>() && !node->Is<StateRead>()) {
+        order.push_back(node);
+      }
+    }
+  }
+
+  out.WriteUnsigned(order.size());
+  absl::flat_hash_map<Node*, int64_t> indices;
+  indices.reserve(order.size());
+  for (Node* node : order) {
+    XLS_RETURN_IF_ERROR(WriteNode(node, indices, out, callees));
+    indices.emplace(node, indices.size());
+  }
+
+  if (function_base->IsFunction()) {
+    Node* return_value = function_base->AsFunctionOrDie()->return_value();
+    out.WriteUnsigned(return_value == nullptr ? 0
+                                              : indices.at(return_value) + 1);
+  } else {
+    // TODO: google/xls#1520 - remove this once fully transitioned over to
+    // `next_value` nodes.
+    Proc* proc = function_base->AsProcOrDie();
+    bool has_next_state =
+        proc->next_values().empty() && proc->GetStateElementCount() > 0;
+    out.WriteBool(has_next_state);
+    if (has_next_state) {
+      for (Node* next_state : proc->NextState()) {
+        out.WriteUnsigned(indices.at(next_state));
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> BinaryIrWriter::Write() {
+  if (!package_->blocks().empty()) {
+    return absl::UnimplementedError(
+        "Blocks are not supported by the binary IR format.");
+  }
+  if (package_->ChannelsAreProcScoped()) {
+    return absl::UnimplementedError(
+        "Proc-scoped channels are not supported by the binary IR format.");
+  }
+  std::vector<FunctionBase*> function_bases = package_->GetFunctionBases();
+  for (int64_t i = 0; i < function_bases.size(); ++i) {
+    function_base_indices_[function_bases[i]] = i;
+  }
+
+  // The directory is built first as it interns the strings, types and values
+  // which precede it.
+  ByteWriter directory;
+  directory.WriteUnsigned(function_bases.size());
+  for (FunctionBase* function_base : function_bases) {
+    directory.WriteUnsigned(static_cast<uint8_t>(
+        function_base->IsFunction() ? FunctionBaseKind::kFunction
+                                    : FunctionBaseKind::kProc));
+    directory.WriteUnsigned(InternString(function_base->name()));
+    std::optional<int64_t> ii = function_base->GetInitiationInterval();
+    directory.WriteUnsigned(ii.has_value() ? *ii + 1 : 0);
+    const std::optional<ForeignFunctionData>& ffi =
+        function_base->ForeignFunctionData();
+    directory.WriteUnsigned(
+        ffi.has_value() ? InternString(ffi->SerializeAsString()) + 1 : 0);
+
+    ByteWriter body;
+    std::vector<int64_t> callees;
+    XLS_RETURN_IF_ERROR(WriteBody(function_base, body, callees));
+    directory.WriteUnsigned(callees.size());
+    for (int64_t callee : callees) {
+      directory.WriteUnsigned(callee);
+    }
+    directory.WriteBlob(body.out());
+  }
+
+  // File numbers are written in sorted order to be deterministic.
+  std::vector<std::pair<Fileno, std::string>> filenos(
+      package_->fileno_to_name().begin(), package_->fileno_to_name().end());
+  std::sort(filenos.begin(), filenos.end());
+  std::vector<int64_t> channels;
+  for (Channel* channel : package_->channels()) {
+    channels.push_back(InternString(channel->ToString()));
+  }
+  for (auto& [fileno, filename] : filenos) {
+    InternString(filename);
+  }
+
+  ByteWriter out;
+  out.WriteRaw(kBinaryIrMagic);
+  for (int64_t i = 0; i < 4; ++i) {
+    out.out().push_back(
+        static_cast<char>((kBinaryIrVersion >> (8 * i)) & 0xff));
+  }
+  out.WriteBlob(package_->name());
+  out.WriteUnsigned(package_->next_node_id());
+
+  out.WriteUnsigned(strings_.size());
+  for (const std::string& s : strings_) {
+    out.WriteBlob(s);
+  }
+  out.WriteUnsigned(type_indices_.size());
+  out.WriteRaw(types_.out());
+  out.WriteUnsigned(value_indices_.size());
+  out.WriteRaw(values_.out());
+
+  out.WriteUnsigned(filenos.size());
+  for (auto& [fileno, filename] : filenos) {
+    out.WriteSigned(fileno.value());
+    out.WriteUnsigned(InternString(filename));
+  }
+  out.WriteUnsigned(channels.size());
+  for (int64_t channel : channels) {
+    out.WriteUnsigned(channel);
+  }
+
+  std::optional<FunctionBase*> top = package_->GetTop();
+  out.WriteUnsigned(top.has_value() ? function_base_indices_.at(*top) + 1 : 0);
+  out.WriteRaw(directory.out());
+  return std::move(out.out());
+}
+
+class BinaryIrReader {
+ public:
+  explicit BinaryIrReader(std::string_view contents) : in_(contents) {}
+
+  absl::StatusOr<std::unique_ptr<Package>> Read(
+      const BinaryIrParseOptions& options);
+
+ private:
+  struct FunctionBaseEntry {
+    FunctionBaseKind kind;
+    std::string_view name;
+    std::optional<int64_t> initiation_interval;
+    std::optional<std::string_view> ffi;
+    std::vector<int64_t> callees;
+    std::string_view body;
+  };
+
+  absl::StatusOr<std::string_view> ReadString(ByteReader& in);
+  absl::StatusOr<std::optional<std::string_view>> ReadOptionalString(
+      ByteReader& in);
+  absl::StatusOr<Type*> ReadType(ByteReader& in);
+  absl::StatusOr<const Value*> ReadPooledValue(ByteReader& in);
+  absl::StatusOr<Function*> ReadCallee(ByteReader& in);
+
+  absl::Status ReadHeader();
+  absl::Status Materialize(int64_t index);
+  absl::StatusOr<Node*> ReadNode(FunctionBase* function_base,
+                                 absl::Span<Node* const> nodes,
+                                 absl::Span<StateRead* const> state_reads,
+                                 ByteReader& in);
+
+  ByteReader in_;
+  std::unique_ptr<Package> package_;
+  std::vector<std::string_view> strings_;
+  std::vector<Type*> types_;
+  std::vector<Value> values_;
+  std::vector<FunctionBaseEntry> entries_;
+  // The function base of each entry or nullptr if it is not materialized.
+  std::vector<FunctionBase*> function_bases_;
+};
+
+absl::StatusOr<std::string_view> BinaryIrReader::ReadString(ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t index, in.ReadUnsigned());
+  XLS_RET_CHECK_LT(index, strings_.size()) << "Invalid string index";
+  return strings_[index];
+}
+
+absl::StatusOr<std::optional<std::string_view>>
+BinaryIrReader::ReadOptionalString(ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t index, in.ReadUnsigned());
+  if (index == 0) {
+    return std::nullopt;
+  }
+  XLS_RET_CHECK_LE(index, strings_.size()) << "Invalid string index";
+  return strings_[index - 1];
+}
+
+absl::StatusOr<Type*> BinaryIrReader::ReadType(ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t index, in.ReadUnsigned());
+  XLS_RET_CHECK_LT(index, types_.size()) << "Invalid type index";
+  return types_[index];
+}
+
+absl::StatusOr<const Value*> BinaryIrReader::ReadPooledValue(ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t index, in.ReadUnsigned());
+  XLS_RET_CHECK_LT(index, values_.size()) << "Invalid literal index";
+  return &values_[index];
+}
+
+absl::StatusOr<Function*> BinaryIrReader::ReadCallee(ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t index, in.ReadUnsigned());
+  XLS_RET_CHECK_LT(index, function_bases_.size()) << "Invalid callee index";
+  XLS_RET_CHECK(function_bases_[index] != nullptr &&
+                function_bases_[index]->IsFunction())
+      << "Callee is not a materialized function";
+  return function_bases_[index]->AsFunctionOrDie();
+}
+
+absl::Status BinaryIrReader::ReadHeader() {
+  XLS_ASSIGN_OR_RETURN(std::string_view magic,
+                       in_.ReadRaw(kBinaryIrMagic.size()));
+  if (magic != kBinaryIrMagic) {
+    return absl::InvalidArgumentError("Input is not binary IR.");
+  }
+  XLS_ASSIGN_OR_RETURN(std::string_view version_bytes, in_.ReadRaw(4));
+  uint32_t version = 0;
+  for (int64_t i = 0; i < 4; ++i) {
+    version |= static_cast<uint32_t>(static_cast<uint8_t>(version_bytes[i]))
+               << (8 * i);
+  }
+  if (version != kBinaryIrVersion) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported binary IR version %d, expected %d.",
+                        version, kBinaryIrVersion));
+  }
+  XLS_ASSIGN_OR_RETURN(std::string_view package_name, in_.ReadBlob());
+  package_ = std::make_unique<Package>(package_name);
+  XLS_ASSIGN_OR_RETURN(uint64_t next_node_id, in_.ReadUnsigned());
+  package_->set_next_node_id(next_node_id);
+
+  XLS_ASSIGN_OR_RETURN(uint64_t string_count, in_.ReadUnsigned());
+  for (uint64_t i = 0; i < string_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::string_view s, in_.ReadBlob());
+    strings_.push_back(s);
+  }
+
+  XLS_ASSIGN_OR_RETURN(uint64_t type_count, in_.ReadUnsigned());
+  for (uint64_t i = 0; i < type_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(uint64_t tag, in_.ReadUnsigned());
+    switch (static_cast<TypeTag>(tag)) {
+      case TypeTag::kBits: {
+        XLS_ASSIGN_OR_RETURN(uint64_t bit_count, in_.ReadUnsigned());
+        types_.push_back(package_->GetBitsType(bit_count));
+        break;
+      }
+      case TypeTag::kTuple: {
+        XLS_ASSIGN_OR_RETURN(uint64_t size, in_.ReadUnsigned());
+        std::vector<Type*> elements;
+        for (uint64_t j = 0; j < size; ++j) {
+          XLS_ASSIGN_OR_RETURN(Type * element, ReadType(in_));
+          elements.push_back(element);
+        }
+        types_.push_back(package_->GetTupleType(elements));
+        break;
+      }
+      case TypeTag::kArray: {
+        XLS_ASSIGN_OR_RETURN(uint64_t size, in_.ReadUnsigned());
+        XLS_ASSIGN_OR_RETURN(Type * element, ReadType(in_));
+        types_.push_back(package_->GetArrayType(size, element));
+        break;
+      }
+      case TypeTag::kToken:
+        types_.push_back(package_->GetTokenType());
+        break;
+      default:
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Invalid type tag in binary IR: %d", tag));
+    }
+  }
+
+  XLS_ASSIGN_OR_RETURN(uint64_t value_count, in_.ReadUnsigned());
+  values_.reserve(value_count);
+  for (uint64_t i = 0; i < value_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(Value value, ReadValue(in_));
+    values_.push_back(std::move(value));
+  }
+
+  XLS_ASSIGN_OR_RETURN(uint64_t fileno_count, in_.ReadUnsigned());
+  for (uint64_t i = 0; i < fileno_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(int64_t fileno, in_.ReadSigned());
+    XLS_ASSIGN_OR_RETURN(std::string_view filename, ReadString(in_));
+    package_->SetFileno(Fileno(fileno), filename);
+  }
+
+  // Channels are few but have many optional attributes, so they are stored by
+  // their textual declaration.
+  XLS_ASSIGN_OR_RETURN(uint64_t channel_count, in_.ReadUnsigned());
+  for (uint64_t i = 0; i < channel_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::string_view declaration, ReadString(in_));
+    XLS_RETURN_IF_ERROR(
+        Parser::ParseChannel(declaration, package_.get()).status());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Node*> BinaryIrReader::ReadNode(
+    FunctionBase* function_base, absl::Span<Node* const> nodes,
+    absl::Span<StateRead* const> state_reads, ByteReader& in) {
+  XLS_ASSIGN_OR_RETURN(uint64_t op_proto, in.ReadUnsigned());
+  if (op_proto == OP_INVALID || !OpProto_IsValid(op_proto)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid op in binary IR: %d", op_proto));
+  }
+  Op op = FromOpProto(static_cast<OpProto>(op_proto));
+  XLS_ASSIGN_OR_RETURN(uint64_t id, in.ReadUnsigned());
+  XLS_ASSIGN_OR_RETURN(std::optional<std::string_view> optional_name,
+                       ReadOptionalString(in));
+  std::string_view name = optional_name.value_or("");
+  XLS_ASSIGN_OR_RETURN(SourceInfo loc, ReadSourceInfo(in));
+  XLS_ASSIGN_OR_RETURN(uint64_t operand_count, in.ReadUnsigned());
+  std::vector<Node*> operands;
+  operands.reserve(operand_count);
+  for (uint64_t i = 0; i < operand_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(uint64_t distance, in.ReadUnsigned());
+    XLS_RET_CHECK(distance >= 1 && distance <= nodes.size())
+        << "Invalid operand of node " << id;
+    operands.push_back(nodes[nodes.size() - distance]);
+  }
+  auto require_operands = [&](int64_t count) -> absl::Status {
+    if (operands.size() < count) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Node %d (%s) in binary IR has %d operands, expected at least %d", id,
+          OpToString(op), operands.size(), count));
+    }
+    return absl::OkStatus();
+  };
+  auto optional_operand = [&](int64_t index) -> std::optional<Node*> {
+    return index < operands.size() ? std::optional<Node*>(operands[index])
+                                   : std::nullopt;
+  };
+  absl::Span<Node* const> all_operands = operands;
+  NodeContext context{function_base, loc, name};
+  Node* node = nullptr;
+  switch (op) {
+    case Op::kAdd:
+    case Op::kSDiv:
+    case Op::kSMod:
+    case Op::kShll:
+    case Op::kShrl:
+    case Op::kShra:
+    case Op::kSub:
+    case Op::kUDiv:
+    case Op::kUMod:
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      node = MakeNode<BinOp>(context, operands[0], operands[1], op);
+      break;
+    case Op::kEq:
+    case Op::kNe:
+    case Op::kSLe:
+    case Op::kSGe:
+    case Op::kSLt:
+    case Op::kSGt:
+    case Op::kULe:
+    case Op::kUGe:
+    case Op::kULt:
+    case Op::kUGt:
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      node = MakeNode<CompareOp>(context, operands[0], operands[1], op);
+      break;
+    case Op::kAnd:
+    case Op::kNand:
+    case Op::kNor:
+    case Op::kOr:
+    case Op::kXor:
+      node = MakeNode<NaryOp>(context, all_operands, op);
+      break;
+    case Op::kAndReduce:
+    case Op::kOrReduce:
+    case Op::kXorReduce:
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      node = MakeNode<BitwiseReductionOp>(context, operands[0], op);
+      break;
+    case Op::kIdentity:
+    case Op::kNeg:
+    case Op::kNot:
+    case Op::kReverse:
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      node = MakeNode<UnOp>(context, operands[0], op);
+      break;
+    case Op::kAfterAll:
+      node = MakeNode<AfterAll>(context, all_operands);
+      break;
+    case Op::kArray: {
+      XLS_ASSIGN_OR_RETURN(Type * element_type, ReadType(in));
+      node = MakeNode<Array>(context, all_operands, element_type);
+      break;
+    }
+    case Op::kArrayConcat:
+      node = MakeNode<ArrayConcat>(context, all_operands);
+      break;
+    case Op::kArrayIndex: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(bool assumed_in_bounds, in.ReadBool());
+      node = MakeNode<ArrayIndex>(context, operands[0], all_operands.subspan(1),
+                                  assumed_in_bounds);
+      break;
+    }
+    case Op::kArraySlice: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(uint64_t width, in.ReadUnsigned());
+      node = MakeNode<ArraySlice>(context, operands[0], operands[1], width);
+      break;
+    }
+    case Op::kArrayUpdate: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(bool assumed_in_bounds, in.ReadBool());
+      node = MakeNode<ArrayUpdate>(context, operands[0], operands[1],
+                                   all_operands.subspan(2), assumed_in_bounds);
+      break;
+    }
+    case Op::kAssert: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(std::string_view message, ReadString(in));
+      XLS_ASSIGN_OR_RETURN(std::optional<std::string_view> label,
+                           ReadOptionalString(in));
+      XLS_ASSIGN_OR_RETURN(std::optional<std::string_view> original_label,
+                           ReadOptionalString(in));
+      node = MakeNode<Assert>(context, operands[0], operands[1], message,
+                              ToOptionalString(label),
+                              ToOptionalString(original_label));
+      break;
+    }
+    case Op::kBitSlice: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(uint64_t start, in.ReadUnsigned());
+      XLS_ASSIGN_OR_RETURN(uint64_t width, in.ReadUnsigned());
+      node = MakeNode<BitSlice>(context, operands[0], start, width);
+      break;
+    }
+    case Op::kBitSliceUpdate:
+      XLS_RETURN_IF_ERROR(require_operands(3));
+      node = MakeNode<BitSliceUpdate>(context, operands[0], operands[1],
+                                      operands[2]);
+      break;
+    case Op::kConcat:
+      node = MakeNode<Concat>(context, all_operands);
+      break;
+    case Op::kCountedFor: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(int64_t trip_count, in.ReadSigned());
+      XLS_ASSIGN_OR_RETURN(int64_t stride, in.ReadSigned());
+      XLS_ASSIGN_OR_RETURN(Function * body, ReadCallee(in));
+      node = MakeNode<CountedFor>(context, operands[0], all_operands.subspan(1),
+                                  trip_count, stride, body);
+      break;
+    }
+    case Op::kCover: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(std::string_view label, ReadString(in));
+      XLS_ASSIGN_OR_RETURN(std::optional<std::string_view> original_label,
+                           ReadOptionalString(in));
+      node = MakeNode<Cover>(context, operands[0], label,
+                             ToOptionalString(original_label));
+      break;
+    }
+    case Op::kDecode: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(uint64_t width, in.ReadUnsigned());
+      node = MakeNode<Decode>(context, operands[0], width);
+      break;
+    }
+    case Op::kDynamicBitSlice: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(uint64_t width, in.ReadUnsigned());
+      node = MakeNode<DynamicBitSlice>(context, operands[0], operands[1],
+                                       width);
+      break;
+    }
+    case Op::kDynamicCountedFor: {
+      XLS_RETURN_IF_ERROR(require_operands(3));
+      XLS_ASSIGN_OR_RETURN(Function * body, ReadCallee(in));
+      node = MakeNode<DynamicCountedFor>(context, operands[0], operands[1],
+                                         operands[2], all_operands.subspan(3),
+                                         body);
+      break;
+    }
+    case Op::kEncode:
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      node = MakeNode<Encode>(context, operands[0]);
+      break;
+    case Op::kGate:
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      node = MakeNode<Gate>(context, operands[0], operands[1]);
+      break;
+    case Op::kInvoke: {
+      XLS_ASSIGN_OR_RETURN(Function * to_apply, ReadCallee(in));
+      node = MakeNode<Invoke>(context, all_operands, to_apply);
+      break;
+    }
+    case Op::kLiteral: {
+      XLS_ASSIGN_OR_RETURN(const Value* value, ReadPooledValue(in));
+      node = MakeNode<Literal>(context, *value);
+      break;
+    }
+    case Op::kMap: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(Function * to_apply, ReadCallee(in));
+      node = MakeNode<Map>(context, operands[0], to_apply);
+      break;
+    }
+    case Op::kMinDelay: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(uint64_t delay, in.ReadUnsigned());
+      node = MakeNode<MinDelay>(context, operands[0], delay);
+      break;
+    }
+    case Op::kNext:
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_RET_CHECK(operands[0]->Is<StateRead>())
+          << "Next node " << id << " does not refer to a state read";
+      node = MakeNode<Next>(context, operands[0], operands[1],
+                            optional_operand(2));
+      break;
+    case Op::kOneHot: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(bool msb, in.ReadBool());
+      node = MakeNode<OneHot>(context, operands[0],
+                              msb ? LsbOrMsb::kMsb : LsbOrMsb::kLsb);
+      break;
+    }
+    case Op::kOneHotSel:
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      node = MakeNode<OneHotSelect>(context, operands[0],
+                                    all_operands.subspan(1));
+      break;
+    case Op::kParam: {
+      XLS_ASSIGN_OR_RETURN(Type * type, ReadType(in));
+      node = MakeNode<Param>(context, type);
+      break;
+    }
+    case Op::kPrioritySel:
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      node = MakeNode<PrioritySelect>(
+          context, operands[0], all_operands.subspan(1, operands.size() - 2),
+          operands.back());
+      break;
+    case Op::kReceive: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(std::string_view channel_name, ReadString(in));
+      XLS_ASSIGN_OR_RETURN(bool is_blocking, in.ReadBool());
+      node = MakeNode<Receive>(context, operands[0], optional_operand(1),
+                               channel_name, is_blocking);
+      break;
+    }
+    case Op::kSend: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(std::string_view channel_name, ReadString(in));
+      node = MakeNode<Send>(context, operands[0], operands[1],
+                            optional_operand(2), channel_name);
+      break;
+    }
+    case Op::kSel: {
+      XLS_ASSIGN_OR_RETURN(bool has_default, in.ReadBool());
+      XLS_RETURN_IF_ERROR(require_operands(has_default ? 2 : 1));
+      int64_t case_count = operands.size() - 1 - (has_default ? 1 : 0);
+      node = MakeNode<Select>(
+          context, operands[0], all_operands.subspan(1, case_count),
+          has_default ? std::optional<Node*>(operands.back()) : std::nullopt);
+      break;
+    }
+    case Op::kSignExt:
+    case Op::kZeroExt: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(uint64_t new_bit_count, in.ReadUnsigned());
+      node = MakeNode<ExtendOp>(context, operands[0], new_bit_count, op);
+      break;
+    }
+    case Op::kSMul:
+    case Op::kUMul: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(uint64_t width, in.ReadUnsigned());
+      node = MakeNode<ArithOp>(context, operands[0], operands[1], width, op);
+      break;
+    }
+    case Op::kSMulp:
+    case Op::kUMulp: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(uint64_t width, in.ReadUnsigned());
+      node = MakeNode<PartialProductOp>(context, operands[0], operands[1],
+                                        width, op);
+      break;
+    }
+    case Op::kStateRead: {
+      // State reads are created along with their state elements, so only
+      // their attributes are restored here.
+      XLS_ASSIGN_OR_RETURN(uint64_t state_index, in.ReadUnsigned());
+      XLS_RET_CHECK_LT(state_index, state_reads.size())
+          << "Invalid state element index";
+      node = state_reads[state_index];
+      node->SetLoc(loc);
+      if (name.empty()) {
+        node->ClearName();
+      } else if (node->GetName() != name) {
+        node->SetName(name);
+      }
+      break;
+    }
+    case Op::kTrace: {
+      XLS_RETURN_IF_ERROR(require_operands(2));
+      XLS_ASSIGN_OR_RETURN(int64_t verbosity, in.ReadSigned());
+      XLS_ASSIGN_OR_RETURN(uint64_t step_count, in.ReadUnsigned());
+      std::vector<FormatStep> format;
+      for (uint64_t i = 0; i < step_count; ++i) {
+        XLS_ASSIGN_OR_RETURN(bool is_string, in.ReadBool());
+        XLS_ASSIGN_OR_RETURN(std::string_view s, ReadString(in));
+        if (is_string) {
+          format.push_back(std::string(s));
+        } else {
+          XLS_ASSIGN_OR_RETURN(FormatPreference preference,
+                               FormatPreferenceFromString(s));
+          format.push_back(preference);
+        }
+      }
+      node = MakeNode<Trace>(context, operands[0], operands[1],
+                             all_operands.subspan(2),
+                             absl::MakeConstSpan(format), verbosity);
+      break;
+    }
+    case Op::kTuple:
+      node = MakeNode<Tuple>(context, all_operands);
+      break;
+    case Op::kTupleIndex: {
+      XLS_RETURN_IF_ERROR(require_operands(1));
+      XLS_ASSIGN_OR_RETURN(uint64_t index, in.ReadUnsigned());
+      node = MakeNode<TupleIndex>(context, operands[0], index);
+      break;
+    }
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Op %s is not supported by the binary IR format",
+                          OpToString(op)));
+  }
+  node->SetId(id);
+  return node;
+}
+
+absl::Status BinaryIrReader::Materialize(int64_t index) {
+  const FunctionBaseEntry& entry = entries_[index];
+  FunctionBase* function_base = function_bases_[index];
+  ByteReader in(entry.body);
+
+  std::vector<StateRead*> state_reads;
+  if (entry.kind == FunctionBaseKind::kProc) {
+    Proc* proc = function_base->AsProcOrDie();
+    XLS_ASSIGN_OR_RETURN(uint64_t state_count, in.ReadUnsigned());
+    for (uint64_t i = 0; i < state_count; ++i) {
+      XLS_ASSIGN_OR_RETURN(std::string_view state_name, ReadString(in));
+      XLS_ASSIGN_OR_RETURN(const Value* initial_value, ReadPooledValue(in));
+      XLS_ASSIGN_OR_RETURN(
+          StateRead * state_read,
+          proc->AppendStateElement(state_name, *initial_value));
+      state_reads.push_back(state_read);
+    }
+  }
+
+  XLS_ASSIGN_OR_RETURN(uint64_t node_count, in.ReadUnsigned());
+  std::vector<Node*> nodes;
+  nodes.reserve(node_count);
+  for (uint64_t i = 0; i < node_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(Node * node,
+                         ReadNode(function_base, nodes, state_reads, in));
+    nodes.push_back(node);
+  }
+  auto read_node_index = [&]() -> absl::StatusOr<Node*> {
+    XLS_ASSIGN_OR_RETURN(uint64_t node_index, in.ReadUnsigned());
+    XLS_RET_CHECK_LT(node_index, nodes.size()) << "Invalid node index";
+    return nodes[node_index];
+  };
+
+  if (entry.kind == FunctionBaseKind::kFunction) {
+    XLS_ASSIGN_OR_RETURN(uint64_t return_index, in.ReadUnsigned());
+    if (return_index != 0) {
+      XLS_RET_CHECK_LE(return_index, nodes.size()) << "Invalid node index";
+      XLS_RETURN_IF_ERROR(
+          function_base->AsFunctionOrDie()->set_return_value(
+              nodes[return_index - 1]));
+    }
+  } else {
+    XLS_ASSIGN_OR_RETURN(bool has_next_state, in.ReadBool());
+    if (has_next_state) {
+      for (int64_t i = 0; i < state_reads.size(); ++i) {
+        XLS_ASSIGN_OR_RETURN(Node * next_state, read_node_index());
+        XLS_RETURN_IF_ERROR(
+            function_base->AsProcOrDie()->SetNextStateElement(i, next_state));
+      }
+    }
+  }
+  if (!in.AtEnd()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Trailing bytes in binary IR body of %s", entry.name));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::unique_ptr<Package>> BinaryIrReader::Read(
+    const BinaryIrParseOptions& options) {
+  XLS_RETURN_IF_ERROR(ReadHeader());
+
+  XLS_ASSIGN_OR_RETURN(uint64_t top, in_.ReadUnsigned());
+  XLS_ASSIGN_OR_RETURN(uint64_t function_base_count, in_.ReadUnsigned());
+  for (uint64_t i = 0; i < function_base_count; ++i) {
+    FunctionBaseEntry entry;
+    XLS_ASSIGN_OR_RETURN(uint64_t kind, in_.ReadUnsigned());
+    if (kind != static_cast<uint8_t>(FunctionBaseKind::kFunction) &&
+        kind != static_cast<uint8_t>(FunctionBaseKind::kProc)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid function base kind in binary IR: %d", kind));
+    }
+    entry.kind = static_cast<FunctionBaseKind>(kind);
+    XLS_ASSIGN_OR_RETURN(entry.name, ReadString(in_));
+    XLS_ASSIGN_OR_RETURN(uint64_t ii, in_.ReadUnsigned());
+    if (ii != 0) {
+      entry.initiation_interval = ii - 1;
+    }
+    XLS_ASSIGN_OR_RETURN(entry.ffi, ReadOptionalString(in_));
+    XLS_ASSIGN_OR_RETURN(uint64_t callee_count, in_.ReadUnsigned());
+    for (uint64_t j = 0; j < callee_count; ++j) {
+      XLS_ASSIGN_OR_RETURN(uint64_t callee, in_.ReadUnsigned());
+      XLS_RET_CHECK_LT(callee, function_base_count) << "Invalid callee index";
+      entry.callees.push_back(callee);
+    }
+    XLS_ASSIGN_OR_RETURN(entry.body, in_.ReadBlob());
+    entries_.push_back(std::move(entry));
+  }
+  if (!in_.AtEnd()) {
+    return absl::InvalidArgumentError("Trailing bytes in binary IR.");
+  }
+  XLS_RET_CHECK_LE(top, entries_.size()) << "Invalid top index";
+
+  // Select the function bases to materialize and order them so that callees
+  // are materialized before their callers.
+  std::vector<int64_t> roots;
+  if (options.materialize_only.has_value()) {
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const FunctionBaseEntry& entry) {
+                             return entry.name == *options.materialize_only;
+                           });
+    if (it == entries_.end()) {
+      return absl::NotFoundError(
+          absl::StrFormat("No function base named %s in binary IR",
+                          *options.materialize_only));
+    }
+    roots.push_back(it - entries_.begin());
+  } else {
+    for (int64_t i = 0; i < entries_.size(); ++i) {
+      roots.push_back(i);
+    }
+  }
+  enum class Mark : uint8_t { kNone, kVisiting, kDone };
+  std::vector<Mark> marks(entries_.size(), Mark::kNone);
+  std::vector<int64_t> post_order;
+  std::function<absl::Status(int64_t)> visit =
+      [&](int64_t index) -> absl::Status {
+    if (marks[index] == Mark::kDone) {
+      return absl::OkStatus();
+    }
+    if (marks[index] == Mark::kVisiting) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Recursive call of %s in binary IR", entries_[index].name));
+    }
+    marks[index] = Mark::kVisiting;
+    for (int64_t callee : entries_[index].callees) {
+      XLS_RETURN_IF_ERROR(visit(callee));
+    }
+    marks[index] = Mark::kDone;
+    post_order.push_back(index);
+    return absl::OkStatus();
+  };
+  for (int64_t root : roots) {
+    XLS_RETURN_IF_ERROR(visit(root));
+  }
+
+  // Function bases are created in their original order, which determines the
+  // order they are dumped in, before any body is materialized.
+  function_bases_.resize(entries_.size(), nullptr);
+  for (int64_t i = 0; i < entries_.size(); ++i) {
+    if (marks[i] != Mark::kDone) {
+      continue;
+    }
+    const FunctionBaseEntry& entry = entries_[i];
+    FunctionBase* function_base;
+    if (entry.kind == FunctionBaseKind::kFunction) {
+      function_base = package_->AddFunction(
+          std::make_unique<Function>(entry.name, package_.get()));
+    } else {
+      function_base = package_->AddProc(
+          std::make_unique<Proc>(entry.name, package_.get()));
+    }
+    if (entry.initiation_interval.has_value()) {
+      function_base->SetInitiationInterval(*entry.initiation_interval);
+    }
+    if (entry.ffi.has_value()) {
+      ForeignFunctionData ffi;
+      if (!ffi.ParseFromArray(entry.ffi->data(), entry.ffi->size())) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Non-parseable FFI metadata for %s", entry.name));
+      }
+      function_base->SetForeignFunctionData(ffi);
+    }
+    function_bases_[i] = function_base;
+  }
+  for (int64_t index : post_order) {
+    XLS_RETURN_IF_ERROR(Materialize(index))
+        << "while loading " << entries_[index].name;
+  }
+
+  if (top != 0 && function_bases_[top - 1] != nullptr) {
+    XLS_RETURN_IF_ERROR(package_->SetTop(function_bases_[top - 1]));
+  }
+  if (options.verify) {
+    XLS_RETURN_IF_ERROR(VerifyPackage(package_.get()));
+  }
+  return std::move(package_);
+}
+
+}  // namespace
+
+bool IsBinaryIr(std::string_view contents) {
+  return contents.starts_with(kBinaryIrMagic);
+}
+
+absl::StatusOr<std::string> SerializePackageToBinary(const Package* package) {
+  return BinaryIrWriter(package).Write();
+}
+
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageFromBinary(
+    std::string_view contents, const BinaryIrParseOptions& options) {
+  return BinaryIrReader(contents).Read(options);
+}
+
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageTextOrBinary(
+    std::string_view contents, std::optional<std::string_view> filename,
+    int64_t parallelism) {
+  if (IsBinaryIr(contents)) {
+    return ParsePackageFromBinary(contents);
+  }
+  return Parser::ParsePackageInParallel(contents, parallelism, filename);
+}
+
+}  // namespace xls
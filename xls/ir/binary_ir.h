@@ -0,0 +1,83 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_IR_BINARY_IR_H_
+#define XLS_IR_BINARY_IR_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// A compact binary serialization of a package which, unlike the text IR, can
+// be loaded without tokenizing or resolving names. The format is:
+//
+//   magic "XLSIRBIN", version (4 bytes, little endian)
+//   package name, next node id
+//   string table: every name, label, message and channel declaration
+//   type table: types of params and array elements, in dependency order
+//   literal pool: values of literals and state initial values
+//   file numbers, channel declarations and the index of the top
+//   directory: kind, name, attributes, callees and length-prefixed body of
+//     each function base, in package order
+//
+// Bodies are lists of node records holding the op, id, name, source
+// locations, operands (as distances back to earlier records) and op-specific
+// attributes. All integers are LEB128 varints, zigzag-encoded when signed, and
+// strings, types and values are referenced by their index in the tables above.
+// Loading is a single linear pass which creates each node directly.
+//
+// Blocks and procs with proc-scoped channels are not supported.
+inline constexpr std::string_view kBinaryIrMagic = "XLSIRBIN";
+inline constexpr uint32_t kBinaryIrVersion = 1;
+
+// Returns true if `contents` starts with the binary IR magic.
+bool IsBinaryIr(std::string_view contents);
+
+// Serializes the package into the binary IR format.
+absl::StatusOr<std::string> SerializePackageToBinary(const Package* package);
+
+struct BinaryIrParseOptions {
+  // If set, only the named function base and the functions it transitively
+  // calls are materialized. The bodies of all other function bases are
+  // skipped without being decoded.
+  std::optional<std::string> materialize_only;
+
+  // Whether to verify the package after it is loaded.
+  bool verify = true;
+};
+
+// Loads a package serialized by SerializePackageToBinary. `contents` need
+// only be valid during the call, so it may be a memory-mapped file.
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageFromBinary(
+    std::string_view contents, const BinaryIrParseOptions& options = {});
+
+// Parses `contents` as binary IR if it starts with the binary IR magic and as
+// text IR otherwise. Text IR is parsed on up to `parallelism` threads (see
+// Parser::ParsePackageInParallel).
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageTextOrBinary(
+    std::string_view contents,
+    std::optional<std::string_view> filename = std::nullopt,
+    int64_t parallelism = 1);
+
+}  // namespace xls
+
+#endif  // XLS_IR_BINARY_IR_H_
@@ -0,0 +1,227 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/ir/binary_ir.h"
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/get_runfile_path.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+
+void ExpectBinaryRoundTrip(std::string_view ir_text) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary,
+                           SerializePackageToBinary(package.get()));
+  EXPECT_TRUE(IsBinaryIr(binary));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> loaded,
+                           ParsePackageFromBinary(binary));
+  EXPECT_EQ(loaded->DumpIr(), package->DumpIr());
+  EXPECT_EQ(loaded->next_node_id(), package->next_node_id());
+}
+
+class BinaryIrRoundTripTest : public testing::TestWithParam<std::string> {};
+
+TEST_P(BinaryIrRoundTripTest, RoundTrip) {
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::filesystem::path path,
+      GetXlsRunfilePath(absl::StrFormat(
+          "xls/ir/testdata/ir_parser_round_trip_test_%s.ir", GetParam())));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string ir_text, GetFileContents(path));
+  ExpectBinaryRoundTrip(ir_text);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BinaryIrRoundTripTestInstantiation, BinaryIrRoundTripTest,
+    testing::Values("CountedFor", "CountedForInvariantArgs", "Gate",
+                    "ParseAssert", "ParseAssertWithLabel", "ParseBinarySel",
+                    "ParseBitSliceUpdate", "ParseCover", "ParseFunctionWithFFI",
+                    "ParseIIFunction", "ParseIIProc", "ParseInvoke", "ParseMap",
+                    "ParseMultiFunctionPackage", "ParseOneHotLsbPriority",
+                    "ParseOneHotMsbPriority", "ParseOneHotSelect",
+                    "ParseParamReturn", "ParsePrioritySelect",
+                    "ParseProcWithExplicitNext", "ParseSimpleProc",
+                    "ParseSingleEmptyPackage", "ParseSingleFunctionPackage",
+                    "ParseStatelessProc", "ParseTernarySelectWithDefault",
+                    "ParseTrace", "ParseTraceWithVerbosity"),
+    testing::PrintToStringParamName());
+
+TEST(BinaryIrTest, RoundTripNodeAttributes) {
+  ExpectBinaryRoundTrip(R"(package test
+
+file_number 0 "foo.x"
+file_number 3 "bar.x"
+
+fn f(x: bits[32] id=1, a: bits[8][4] id=2, t: (bits[8], token) id=3) -> (bits[32], bits[8][2], bits[16]) {
+  literal.4: bits[32] = literal(value=0xffff_0123, id=4, pos=[(0,1,2), (3,4,5)])
+  big: bits[100] = literal(value=0xf_ffff_ffff_ffff_ffff_ffff_ffff, id=5)
+  add.6: bits[32] = add(x, literal.4, id=6)
+  bit_slice.7: bits[8] = bit_slice(x, start=3, width=8, id=7)
+  array_index.8: bits[8] = array_index(a, indices=[bit_slice.7], assumed_in_bounds=true, id=8)
+  array_slice.9: bits[8][2] = array_slice(a, x, width=2, id=9)
+  sign_ext.10: bits[16] = sign_ext(array_index.8, new_bit_count=16, id=10)
+  umul.11: bits[16] = umul(sign_ext.10, bit_slice.7, id=11)
+  umulp.12: (bits[20], bits[20]) = umulp(x, x, id=12)
+  decode.13: bits[5] = decode(bit_slice.7, width=5, id=13)
+  dynamic_bit_slice.14: bits[3] = dynamic_bit_slice(x, bit_slice.7, width=3, id=14)
+  concat.15: bits[16] = concat(decode.13, dynamic_bit_slice.14, bit_slice.7, id=15)
+  xor.16: bits[16] = xor(concat.15, umul.11, sign_ext.10, id=16)
+  ret tuple.17: (bits[32], bits[8][2], bits[16]) = tuple(add.6, array_slice.9, xor.16, id=17)
+}
+)");
+}
+
+TEST(BinaryIrTest, RoundTripUnorderedNodes) {
+  // Nodes added after their users are written in topological order.
+  Package package("test");
+  FunctionBuilder fb("f", &package);
+  BValue x = fb.Param("x", package.GetBitsType(8));
+  BValue y = fb.Param("y", package.GetBitsType(8));
+  BValue sum = fb.Add(x, y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(sum));
+  XLS_ASSERT_OK_AND_ASSIGN(Node * negated,
+                           f->MakeNode<UnOp>(SourceInfo(), y.node(), Op::kNeg));
+  XLS_ASSERT_OK(sum.node()->ReplaceOperandNumber(1, negated));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary,
+                           SerializePackageToBinary(&package));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> loaded,
+                           ParsePackageFromBinary(binary));
+  EXPECT_EQ(loaded->DumpIr(), package.DumpIr());
+}
+
+TEST(BinaryIrTest, MaterializeOnly) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package test
+
+fn callee(x: bits[8] id=1) -> bits[8] {
+  ret neg.2: bits[8] = neg(x, id=2)
+}
+
+fn unrelated(x: bits[8] id=3) -> bits[8] {
+  ret not.4: bits[8] = not(x, id=4)
+}
+
+top fn caller(x: bits[8] id=5) -> bits[8] {
+  ret invoke.6: bits[8] = invoke(x, to_apply=callee, id=6)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary,
+                           SerializePackageToBinary(package.get()));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> loaded,
+      ParsePackageFromBinary(
+          binary, BinaryIrParseOptions{.materialize_only = "caller"}));
+  EXPECT_TRUE(loaded->GetFunction("caller").ok());
+  EXPECT_TRUE(loaded->GetFunction("callee").ok());
+  EXPECT_FALSE(loaded->GetFunction("unrelated").ok());
+  XLS_ASSERT_OK_AND_ASSIGN(Function * top, loaded->GetTopAsFunction());
+  EXPECT_EQ(top->name(), "caller");
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      loaded, ParsePackageFromBinary(binary, BinaryIrParseOptions{
+                                                 .materialize_only = "callee"}));
+  EXPECT_EQ(loaded->functions().size(), 1);
+  EXPECT_FALSE(loaded->HasTop());
+
+  EXPECT_THAT(ParsePackageFromBinary(
+                  binary, BinaryIrParseOptions{.materialize_only = "missing"}),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(BinaryIrTest, TextOrBinary) {
+  constexpr std::string_view kIrText = R"(package test
+
+fn f(x: bits[8] id=1) -> bits[8] {
+  ret neg.2: bits[8] = neg(x, id=2)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           ParsePackageTextOrBinary(kIrText));
+  EXPECT_FALSE(IsBinaryIr(kIrText));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary,
+                           SerializePackageToBinary(package.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> loaded,
+                           ParsePackageTextOrBinary(binary));
+  EXPECT_EQ(loaded->DumpIr(), package->DumpIr());
+}
+
+TEST(BinaryIrTest, MalformedInput) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package test
+
+fn f(x: bits[8] id=1) -> bits[8] {
+  ret neg.2: bits[8] = neg(x, id=2)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary,
+                           SerializePackageToBinary(package.get()));
+
+  EXPECT_THAT(ParsePackageFromBinary("package test"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not binary IR")));
+  for (int64_t size = kBinaryIrMagic.size(); size < binary.size(); ++size) {
+    EXPECT_FALSE(ParsePackageFromBinary(binary.substr(0, size)).ok())
+        << "size " << size;
+  }
+  std::string other_version = binary;
+  other_version[kBinaryIrMagic.size()] = 2;
+  EXPECT_THAT(ParsePackageFromBinary(other_version),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unsupported binary IR version")));
+}
+
+TEST(BinaryIrTest, BlocksAreUnsupported) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package test
+
+block my_block(a: bits[32], b: bits[32], out: bits[32]) {
+  a: bits[32] = input_port(name=a, id=1)
+  b: bits[32] = input_port(name=b, id=2)
+  add.3: bits[32] = add(a, b, id=3)
+  out: () = output_port(add.3, name=out, id=4)
+}
+)"));
+  EXPECT_THAT(SerializePackageToBinary(package.get()),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+}  // namespace
+}  // namespace xls
@@ -257,11 +257,8 @@ Bits Bits::Slice(int64_t start, int64_t width) && {
     return Bits::FromBitmap(std::move(bitmap_).WithSize(width));
   }
   Bits result(width);
-  for (int64_t i = 0; i < width; ++i) {
-    if (Get(start + i)) {
-      result.bitmap_.Set(i, true);
-    }
-  }
+  result.bitmap_.Overwrite(bitmap_, width, /*write_offset=*/0,
+                           /*read_offset=*/start);
   return result;
 }
 
@@ -276,11 +273,8 @@ Bits Bits::Slice(int64_t start, int64_t width) const& {
     return Bits::FromBitmap(bitmap_.WithSize(width));
   }
   Bits result(width);
-  for (int64_t i = 0; i < width; ++i) {
-    if (Get(start + i)) {
-      result.bitmap_.Set(i, true);
-    }
-  }
+  result.bitmap_.Overwrite(bitmap_, width, /*write_offset=*/0,
+                           /*read_offset=*/start);
   return result;
 }
 
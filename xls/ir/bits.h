@@ -267,9 +267,7 @@ class BitsRope {
   //
   // So b.Get(0) is now at result.Get(2).
   void push_back(const Bits& bits) {
-    for (int64_t i = 0; i < bits.bit_count(); ++i) {
-      bitmap_.Set(index_ + i, bits.Get(i));
-    }
+    bitmap_.Overwrite(bits.bitmap(), bits.bit_count(), /*write_offset=*/index_);
     index_ += bits.bit_count();
   }
 
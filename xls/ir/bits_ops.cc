@@ -204,9 +204,8 @@ Bits Add(const Bits& lhs, const Bits& rhs) {
     return UBits(result, lhs.bit_count());
   }
 
-  Bits sum = BigInt::Add(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                 .ToSignedBits();
-  return TruncateOrSignExtend(std::move(sum), lhs.bit_count());
+  return BigInt::Add(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+      .ToBitsTruncated(lhs.bit_count());
 }
 
 Bits Sub(const Bits& lhs, const Bits& rhs) {
@@ -217,9 +216,8 @@ Bits Sub(const Bits& lhs, const Bits& rhs) {
     uint64_t result = (lhs_int - rhs_int) & Mask(lhs.bit_count());
     return UBits(result, lhs.bit_count());
   }
-  Bits diff = BigInt::Sub(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                  .ToSignedBits();
-  return TruncateOrSignExtend(std::move(diff), lhs.bit_count());
+  return BigInt::Sub(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+      .ToBitsTruncated(lhs.bit_count());
 }
 
 Bits Increment(const Bits& x) {
@@ -257,9 +255,8 @@ Bits SMul(const Bits& lhs, const Bits& rhs) {
     return SBits(result, result_width);
   }
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return product.ToSignedBitsWithBitCount(result_width).value();
+  return BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+      .ToBitsTruncated(result_width);
 }
 
 Bits UMul(const Bits& lhs, const Bits& rhs) {
@@ -271,27 +268,24 @@ Bits UMul(const Bits& lhs, const Bits& rhs) {
     return UBits(result, result_width);
   }
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return product.ToUnsignedBitsWithBitCount(result_width).value();
+  return BigInt::Mul(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+      .ToBitsTruncated(result_width);
 }
 
 Bits UDiv(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits::AllOnes(lhs.bit_count());
   }
-  BigInt quotient =
-      BigInt::Div(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return ZeroExtend(quotient.ToUnsignedBits(), lhs.bit_count());
+  return BigInt::Div(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+      .ToBitsTruncated(lhs.bit_count());
 }
 
 Bits UMod(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits(rhs.bit_count());
   }
-  BigInt modulo =
-      BigInt::Mod(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return ZeroExtend(modulo.ToUnsignedBits(), rhs.bit_count());
+  return BigInt::Mod(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+      .ToBitsTruncated(rhs.bit_count());
 }
 
 Bits SDiv(const Bits& lhs, const Bits& rhs) {
@@ -308,17 +302,17 @@ Bits SDiv(const Bits& lhs, const Bits& rhs) {
     // 0b0111...111.
     return ZeroExtend(Bits::AllOnes(lhs.bit_count() - 1), lhs.bit_count());
   }
-  BigInt quotient =
-      BigInt::Div(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return TruncateOrSignExtend(quotient.ToSignedBits(), lhs.bit_count());
+  // The quotient of the most negative value and -1 wraps around.
+  return BigInt::Div(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+      .ToBitsTruncated(lhs.bit_count());
 }
 
 Bits SMod(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits(rhs.bit_count());
   }
-  BigInt modulo = BigInt::Mod(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return TruncateOrSignExtend(modulo.ToSignedBits(), rhs.bit_count());
+  return BigInt::Mod(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+      .ToBitsTruncated(rhs.bit_count());
 }
 
 bool UEqual(const Bits& lhs, const Bits& rhs) { return UCmp(lhs, rhs) == 0; }
@@ -499,23 +493,30 @@ Bits Abs(const Bits& bits) {
 Bits ShiftLeftLogical(const Bits& bits, int64_t shift_amount) {
   CHECK_GE(shift_amount, 0);
   shift_amount = std::min(shift_amount, bits.bit_count());
-  return Concat(
-      {bits.Slice(0, bits.bit_count() - shift_amount), UBits(0, shift_amount)});
+  InlineBitmap result(bits.bit_count());
+  result.Overwrite(bits.bitmap(), bits.bit_count() - shift_amount,
+                   /*write_offset=*/shift_amount, /*read_offset=*/0);
+  return Bits::FromBitmap(std::move(result));
 }
 
 Bits ShiftRightLogical(const Bits& bits, int64_t shift_amount) {
   CHECK_GE(shift_amount, 0);
   shift_amount = std::min(shift_amount, bits.bit_count());
-  return Concat({UBits(0, shift_amount),
-                 bits.Slice(shift_amount, bits.bit_count() - shift_amount)});
+  InlineBitmap result(bits.bit_count());
+  result.Overwrite(bits.bitmap(), bits.bit_count() - shift_amount,
+                   /*write_offset=*/0, /*read_offset=*/shift_amount);
+  return Bits::FromBitmap(std::move(result));
 }
 
 Bits ShiftRightArith(const Bits& bits, int64_t shift_amount) {
   CHECK_GE(shift_amount, 0);
   shift_amount = std::min(shift_amount, bits.bit_count());
-  return Concat(
-      {bits.msb() ? Bits::AllOnes(shift_amount) : UBits(0, shift_amount),
-       bits.Slice(shift_amount, bits.bit_count() - shift_amount)});
+  // Start from all copies of the sign bit and shift the value in below them.
+  InlineBitmap result(bits.bit_count(),
+                      /*fill=*/bits.bit_count() > 0 && bits.msb());
+  result.Overwrite(bits.bitmap(), bits.bit_count() - shift_amount,
+                   /*write_offset=*/0, /*read_offset=*/shift_amount);
+  return Bits::FromBitmap(std::move(result));
 }
 
 Bits OneHotLsbToMsb(const Bits& bits) {
@@ -536,10 +537,34 @@ Bits OneHotMsbToLsb(const Bits& bits) {
   return Bits::PowerOfTwo(bits.bit_count(), bits.bit_count() + 1);
 }
 
+namespace {
+
+// Returns `word` with the order of its 64 bits reversed by swapping ever
+// larger groups of bits.
+uint64_t ReverseWord(uint64_t word) {
+  constexpr uint64_t kMasks[] = {0x5555555555555555, 0x3333333333333333,
+                                 0x0f0f0f0f0f0f0f0f, 0x00ff00ff00ff00ff,
+                                 0x0000ffff0000ffff};
+  for (int64_t i = 0; i < 5; ++i) {
+    int64_t shift = int64_t{1} << i;
+    word = ((word >> shift) & kMasks[i]) | ((word & kMasks[i]) << shift);
+  }
+  return (word >> 32) | (word << 32);
+}
+
+}  // namespace
+
 Bits Reverse(const Bits& bits) {
-  InlineBitmap reversed_bitmap(bits.bit_count());
-  for (int64_t i = 0; i < bits.bit_count(); ++i) {
-    reversed_bitmap.Set(bits.bit_count() - i - 1, bits.Get(i));
+  int64_t bit_count = bits.bit_count();
+  InlineBitmap reversed_bitmap(bit_count);
+  // Word `i` of the result holds the reversed `width` bits ending `64 * i`
+  // bits below the MSB of the input.
+  for (int64_t i = 0; i < reversed_bitmap.word_count(); ++i) {
+    int64_t end = bit_count - 64 * i;
+    int64_t start = std::max(end - 64, int64_t{0});
+    int64_t width = end - start;
+    reversed_bitmap.SetWord(
+        i, ReverseWord(bits.bitmap().GetBits(start, width)) >> (64 - width));
   }
   return Bits::FromBitmap(std::move(reversed_bitmap));
 }
@@ -572,22 +597,14 @@ Bits BitSliceUpdate(const Bits& to_update, int64_t start,
     return to_update;
   }
 
-  // Construct the result as the sliced concatenation of three slices:
-  //   (1) slice of some least-significant bits of to_update.
-  //   (2) slice of update_value
-  //   (3) slice of some most-significant bits of to_update.
-  // One or more of these slices may be zero-width.
-  Bits lsb_slice = to_update.Slice(/*start=*/0, /*width=*/start);
-  Bits update_slice = update_value.Slice(
-      /*start=*/0,
-      /*width=*/std::min(update_value.bit_count(),
-                         to_update.bit_count() - start));
-  int64_t msb_start =
-      std::min(to_update.bit_count(), start + update_value.bit_count());
-  Bits msb_slice = to_update.Slice(
-      /*start=*/msb_start,
-      /*width=*/std::max(int64_t{0}, to_update.bit_count() - msb_start));
-  return Concat({msb_slice, update_slice, lsb_slice});
+  // Overwrite the updated range in a copy of to_update. The update value may
+  // extend past the end of to_update.
+  InlineBitmap result = to_update.bitmap();
+  result.Overwrite(update_value.bitmap(),
+                   std::min(update_value.bit_count(),
+                            to_update.bit_count() - start),
+                   /*write_offset=*/start);
+  return Bits::FromBitmap(std::move(result));
 }
 
 Bits LongestCommonPrefixLSB(absl::Span<const Bits> bits_span) {
@@ -784,6 +784,16 @@ TEST(BitsOpsTest, Reverse) {
   EXPECT_EQ(bits_ops::Reverse(UBits(1, 100)), Bits::PowerOfTwo(99, 100));
   EXPECT_EQ(bits_ops::Reverse(UBits(0b111001, 6)), UBits(0b100111, 6));
   EXPECT_EQ(bits_ops::Reverse(UBits(0b111001, 10)), UBits(0b1001110000, 10));
+
+  // Widths which do not fill the last word.
+  for (int64_t bit_count : {63, 65, 127, 130, 200}) {
+    Bits bits = bits_ops::Concat(
+        {UBits(0b1011, 4), Bits(bit_count - 8), UBits(0b0001, 4)});
+    Bits reversed = bits_ops::Concat(
+        {UBits(0b1000, 4), Bits(bit_count - 8), UBits(0b1101, 4)});
+    EXPECT_EQ(bits_ops::Reverse(bits), reversed);
+    EXPECT_EQ(bits_ops::Reverse(reversed), bits);
+  }
 }
 
 TEST(BitsOpsTest, ReductionOps) {
@@ -1228,5 +1238,66 @@ void BM_ZeroExtendMove(benchmark::State& state) {
 }
 BENCHMARK(BM_ZeroExtendMove)->Range(33, 1 << 20);
 
+// Benchmarks of common operations at the widths which are inline (1, 64, 128)
+// and heap-allocated (1024).
+void BM_Add(benchmark::State& state) {
+  Bits a = Bits::AllOnes(state.range(0));
+  Bits b = Bits::AllOnes(state.range(0));
+  for (auto _ : state) {
+    auto v = bits_ops::Add(a, b);
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Add)->Arg(1)->Arg(64)->Arg(128)->Arg(1024);
+
+void BM_Concat(benchmark::State& state) {
+  Bits a = Bits::AllOnes(state.range(0) / 2);
+  Bits b(state.range(0) - state.range(0) / 2);
+  for (auto _ : state) {
+    auto v = bits_ops::Concat({a, b});
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Concat)->Arg(1)->Arg(64)->Arg(128)->Arg(1024);
+
+void BM_Slice(benchmark::State& state) {
+  Bits a = Bits::AllOnes(2 * state.range(0));
+  for (auto _ : state) {
+    auto v = a.Slice(state.range(0) / 2, state.range(0));
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Slice)->Arg(1)->Arg(64)->Arg(128)->Arg(1024);
+
+void BM_ShiftLeftLogical(benchmark::State& state) {
+  Bits a = Bits::AllOnes(state.range(0));
+  int64_t shift_amount = state.range(0) / 3;
+  for (auto _ : state) {
+    auto v = bits_ops::ShiftLeftLogical(a, shift_amount);
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_ShiftLeftLogical)->Arg(1)->Arg(64)->Arg(128)->Arg(1024);
+
+void BM_ShiftRightArith(benchmark::State& state) {
+  Bits a = Bits::AllOnes(state.range(0));
+  int64_t shift_amount = state.range(0) / 3;
+  for (auto _ : state) {
+    auto v = bits_ops::ShiftRightArith(a, shift_amount);
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_ShiftRightArith)->Arg(1)->Arg(64)->Arg(128)->Arg(1024);
+
+void BM_Reverse(benchmark::State& state) {
+  Bits a = bits_ops::Concat({Bits::AllOnes(state.range(0) / 2),
+                             Bits(state.range(0) - state.range(0) / 2)});
+  for (auto _ : state) {
+    auto v = bits_ops::Reverse(a);
+    benchmark::DoNotOptimize(v);
+  }
+}
+BENCHMARK(BM_Reverse)->Arg(1)->Arg(64)->Arg(128)->Arg(1024);
+
 }  // namespace
 }  // namespace xls
@@ -715,7 +715,8 @@ absl::StatusOr<Block*> Block::Clone(
     const absl::flat_hash_map<std::string, std::string>& reg_name_map,
     const absl::flat_hash_map<const Block*, Block*>& block_instantiation_map)
     const {
-  absl::flat_hash_map<Node*, Node*> original_to_clone;
+  // Indexed by the dense index of the original node.
+  std::vector<Node*> original_to_clone(node_count());
   absl::flat_hash_map<Register*, Register*> register_map;
   absl::flat_hash_map<Instantiation*, Instantiation*> instantiation_map;
 
@@ -725,6 +726,7 @@ absl::StatusOr<Block*> Block::Clone(
 
   Block* cloned_block = target_package->AddBlock(
       std::make_unique<Block>(new_name, target_package));
+  cloned_block->ReserveNodes(node_count());
 
   std::optional<std::string> clk_port_name;
   for (const Port& port : GetPorts()) {
@@ -791,10 +793,11 @@ absl::StatusOr<Block*> Block::Clone(
     }
   }
 
+  std::vector<Node*> cloned_operands;
   for (Node* node : TopoSort(const_cast<Block*>(this))) {
-    std::vector<Node*> cloned_operands;
+    cloned_operands.clear();
     for (Node* operand : node->operands()) {
-      cloned_operands.push_back(original_to_clone.at(operand));
+      cloned_operands.push_back(original_to_clone[operand->dense_index()]);
     }
 
     if (node->Is<InputPort>()) {
@@ -803,36 +806,37 @@ absl::StatusOr<Block*> Block::Clone(
           Type * mapped_type,
           target_package->MapTypeFromOtherPackage(src->GetType()));
       XLS_ASSIGN_OR_RETURN(
-          original_to_clone[node],
+          original_to_clone[node->dense_index()],
           cloned_block->AddInputPort(src->name(), mapped_type, src->loc()));
     } else if (node->Is<OutputPort>()) {
       OutputPort* src = node->As<OutputPort>();
-      XLS_ASSIGN_OR_RETURN(original_to_clone[node],
+      XLS_ASSIGN_OR_RETURN(original_to_clone[node->dense_index()],
                            cloned_block->AddOutputPort(
                                src->name(), cloned_operands[0], src->loc()));
     } else if (node->Is<RegisterRead>()) {
       RegisterRead* src = node->As<RegisterRead>();
       XLS_ASSIGN_OR_RETURN(
-          original_to_clone[node],
+          original_to_clone[node->dense_index()],
           cloned_block->MakeNodeWithName<RegisterRead>(
               src->loc(), register_map.at(src->GetRegister()), src->GetName()));
     } else if (node->Is<RegisterWrite>()) {
       RegisterWrite* src = node->As<RegisterWrite>();
       XLS_ASSIGN_OR_RETURN(
-          original_to_clone[node],
+          original_to_clone[node->dense_index()],
           cloned_block->MakeNodeWithName<RegisterWrite>(
               src->loc(), cloned_operands[0],
               src->load_enable().has_value()
                   ? std::optional<Node*>(
-                        original_to_clone.at(*src->load_enable()))
+                        original_to_clone[(*src->load_enable())->dense_index()])
                   : std::nullopt,
               src->reset().has_value()
-                  ? std::optional<Node*>(original_to_clone.at(*src->reset()))
+                  ? std::optional<Node*>(
+                        original_to_clone[(*src->reset())->dense_index()])
                   : std::nullopt,
               register_map.at(src->GetRegister()), src->GetName()));
     } else if (node->Is<InstantiationInput>()) {
       InstantiationInput* src = node->As<InstantiationInput>();
-      XLS_ASSIGN_OR_RETURN(original_to_clone[node],
+      XLS_ASSIGN_OR_RETURN(original_to_clone[node->dense_index()],
                            cloned_block->MakeNodeWithName<InstantiationInput>(
                                src->loc(), cloned_operands[0],
                                instantiation_map.at(src->instantiation()),
@@ -840,13 +844,13 @@ absl::StatusOr<Block*> Block::Clone(
     } else if (node->Is<InstantiationOutput>()) {
       InstantiationOutput* src = node->As<InstantiationOutput>();
       XLS_ASSIGN_OR_RETURN(
-          original_to_clone[node],
+          original_to_clone[node->dense_index()],
           cloned_block->MakeNodeWithName<InstantiationOutput>(
               src->loc(), instantiation_map.at(src->instantiation()),
               src->port_name(), src->GetName()));
     } else {
       XLS_ASSIGN_OR_RETURN(
-          original_to_clone[node],
+          original_to_clone[node->dense_index()],
           node->CloneInNewFunction(cloned_operands, cloned_block));
     }
   }
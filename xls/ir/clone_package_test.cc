@@ -14,10 +14,14 @@
 
 #include "xls/ir/clone_package.h"
 
+#include <memory>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status_matchers.h"
+#include "benchmark/benchmark.h"
 #include "xls/common/status/matchers.h"
+#include "xls/ir/benchmark_support.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/block.h"
 #include "xls/ir/channel.h"
@@ -27,6 +31,7 @@
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
 #include "xls/ir/proc.h"
 #include "xls/ir/proc_testutils.h"
 #include "xls/ir/value.h"
@@ -117,5 +122,22 @@ TEST_F(ClonePackageTest, BasicBlock) {
       absl_testing::IsOkAndHolds(m::OutputPort(m::InstantiationOutput("foo"))));
 }
 
+void BM_ClonePackageBinaryTree(benchmark::State& state) {
+  std::unique_ptr<VerifiedPackage> p =
+      std::make_unique<VerifiedPackage>("balanced_tree_pkg");
+  XLS_ASSERT_OK(benchmark_support::GenerateBalancedTree(
+                    p.get(), /*depth=*/state.range(0),
+                    /*fan_out=*/2, benchmark_support::strategy::BinaryAdd(),
+                    benchmark_support::strategy::DistinctLiteral())
+                    .status());
+  for (auto _ : state) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> clone,
+                             ClonePackage(p.get()));
+    benchmark::DoNotOptimize(clone);
+  }
+}
+
+BENCHMARK(BM_ClonePackageBinaryTree)->DenseRange(2, 16, 2);
+
 }  // namespace
 }  // namespace xls
@@ -14,10 +14,64 @@
 
 #include "xls/ir/events.h"
 
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 
 namespace xls {
 
+TraceMessage UnformattedTraceMessage::Format() const {
+  TraceMessage message{.verbosity = verbosity};
+  for (const std::variant<std::string, Operand>& piece : pieces) {
+    if (std::holds_alternative<std::string>(piece)) {
+      absl::StrAppend(&message.message, std::get<std::string>(piece));
+    } else {
+      const Operand& operand = std::get<Operand>(piece);
+      absl::StrAppend(&message.message,
+                      operand.value.ToHumanString(operand.format));
+    }
+  }
+  return message;
+}
+
+void TraceLog::Append(const TraceLog& other) {
+  for (const TraceMessage& message : other.formatted_) {
+    push_back(message);
+  }
+  unformatted_.insert(unformatted_.end(), other.unformatted_.begin(),
+                      other.unformatted_.end());
+}
+
+std::vector<TraceMessage> TraceLog::GetMessages(int64_t max_verbosity) const {
+  std::vector<TraceMessage> messages;
+  for (const TraceMessage& message : formatted_) {
+    if (message.verbosity <= max_verbosity) {
+      messages.push_back(message);
+    }
+  }
+  for (const UnformattedTraceMessage& message : unformatted_) {
+    if (message.verbosity <= max_verbosity) {
+      messages.push_back(message.Format());
+    }
+  }
+  return messages;
+}
+
+void TraceLog::FormatPending() const {
+  if (unformatted_.empty()) {
+    return;
+  }
+  formatted_.reserve(formatted_.size() + unformatted_.size());
+  for (const UnformattedTraceMessage& message : unformatted_) {
+    formatted_.push_back(message.Format());
+  }
+  unformatted_.clear();
+}
+
 absl::Status InterpreterEventsToStatus(const InterpreterEvents& events) {
   if (events.assert_msgs.empty()) {
     return absl::OkStatus();
@@ -16,13 +16,19 @@
 #define XLS_IR_EVENTS_H_
 
 #include <compare>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "xls/ir/format_preference.h"
+#include "xls/ir/value.h"
 
 namespace xls {
 
@@ -49,12 +55,104 @@ struct TraceMessage {
   }
 };
 
+// A trace message which has not been formatted yet: the literal text and the
+// operand values of the format string, in order.
+struct UnformattedTraceMessage {
+  struct Operand {
+    Value value;
+    FormatPreference format;
+  };
+  std::vector<std::variant<std::string, Operand>> pieces;
+  int64_t verbosity = 0;
+
+  TraceMessage Format() const;
+};
+
+// The trace messages recorded by an interpreter, in the order they were
+// recorded. Reads as a vector of TraceMessages, but messages recorded with
+// AddUnformatted are only formatted once the log is read, so the traces of a
+// long simulation which are never looked at, or are filtered out by verbosity
+// (see GetMessages), cost no string formatting.
+//
+// Reading formats the pending messages in place, so even const accesses must
+// not race with other accesses.
+class TraceLog {
+ public:
+  using value_type = TraceMessage;
+  using const_iterator = std::vector<TraceMessage>::const_iterator;
+  using iterator = const_iterator;
+  using size_type = size_t;
+
+  void push_back(TraceMessage message) {
+    FormatPending();
+    formatted_.push_back(std::move(message));
+  }
+  void AddUnformatted(UnformattedTraceMessage message) {
+    unformatted_.push_back(std::move(message));
+  }
+
+  // Appends the messages of `other` without formatting them.
+  void Append(const TraceLog& other);
+
+  // Returns the messages with at most the given verbosity. Only these messages
+  // are formatted.
+  std::vector<TraceMessage> GetMessages(int64_t max_verbosity) const;
+
+  const_iterator begin() const {
+    FormatPending();
+    return formatted_.begin();
+  }
+  const_iterator end() const {
+    FormatPending();
+    return formatted_.end();
+  }
+  const TraceMessage& at(size_t index) const {
+    FormatPending();
+    return formatted_.at(index);
+  }
+  const TraceMessage& operator[](size_t index) const {
+    FormatPending();
+    return formatted_[index];
+  }
+  size_t size() const { return formatted_.size() + unformatted_.size(); }
+  bool empty() const { return size() == 0; }
+  void clear() {
+    formatted_.clear();
+    unformatted_.clear();
+  }
+
+  bool operator==(const TraceLog& other) const {
+    FormatPending();
+    other.FormatPending();
+    return formatted_ == other.formatted_;
+  }
+  bool operator!=(const TraceLog& other) const { return !(*this == other); }
+
+ private:
+  void FormatPending() const;
+
+  // Messages in order of recording; all formatted messages were recorded
+  // before all unformatted ones.
+  mutable std::vector<TraceMessage> formatted_;
+  mutable std::vector<UnformattedTraceMessage> unformatted_;
+};
+
 // Common structure capturing events that can be produced by any XLS interpreter
 // (DSLX, IR, JIT, etc.)
 struct InterpreterEvents {
-  std::vector<TraceMessage> trace_msgs;
+  TraceLog trace_msgs;
   std::vector<std::string> assert_msgs;
 
+  // If set, traces with a higher verbosity are not recorded at all. Unlike
+  // the events, this is kept by Clear.
+  std::optional<int64_t> max_trace_verbosity;
+
+  // Returns whether a trace of the given verbosity should be recorded.
+  bool ShouldRecordTrace(int64_t verbosity) const {
+    return !max_trace_verbosity.has_value() ||
+           verbosity <= *max_trace_verbosity;
+  }
+
   void Clear() {
     trace_msgs.clear();
     assert_msgs.clear();
@@ -96,26 +96,29 @@ absl::StatusOr<Function*> Function::Clone(
     std::string_view new_name, Package* target_package,
     const absl::flat_hash_map<const Function*, Function*>& call_remapping)
     const {
-  absl::flat_hash_map<Node*, Node*> original_to_clone;
+  // Indexed by the dense index of the original node.
+  std::vector<Node*> original_to_clone(node_count());
   if (target_package == nullptr) {
     target_package = package();
   }
   Function* cloned_function = target_package->AddFunction(
       std::make_unique<Function>(new_name, target_package));
   cloned_function->SetForeignFunctionData(foreign_function_);
+  cloned_function->ReserveNodes(node_count());
 
   // Clone parameters over first to maintain order.
   for (Param* param : (const_cast<Function*>(this))->params()) {
-    XLS_ASSIGN_OR_RETURN(original_to_clone[param],
+    XLS_ASSIGN_OR_RETURN(original_to_clone[param->dense_index()],
                          param->CloneInNewFunction({}, cloned_function));
   }
+  std::vector<Node*> cloned_operands;
   for (Node* node : TopoSort(const_cast<Function*>(this))) {
     if (node->Is<Param>()) {  // Params were already copied.
       continue;
     }
-    std::vector<Node*> cloned_operands;
+    cloned_operands.clear();
     for (Node* operand : node->operands()) {
-      cloned_operands.push_back(original_to_clone.at(operand));
+      cloned_operands.push_back(original_to_clone[operand->dense_index()]);
     }
 
     switch (node->op()) {
@@ -126,7 +129,7 @@ absl::StatusOr<Function*> Function::Clone(
                              ? call_remapping.at(src->body())
                              : src->body();
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             cloned_function->MakeNodeWithName<CountedFor>(
                 src->loc(), cloned_operands[0],
                 absl::Span<Node*>(cloned_operands).subspan(1),
@@ -140,7 +143,7 @@ absl::StatusOr<Function*> Function::Clone(
                                  ? call_remapping.at(src->to_apply())
                                  : src->to_apply();
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             cloned_function->MakeNodeWithName<Map>(
                 src->loc(), cloned_operands[0], to_apply, src->GetName()));
         break;
@@ -152,7 +155,7 @@ absl::StatusOr<Function*> Function::Clone(
                                  ? call_remapping.at(src->to_apply())
                                  : src->to_apply();
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             cloned_function->MakeNodeWithName<Invoke>(
                 src->loc(), cloned_operands, to_apply, src->GetName()));
         break;
@@ -160,14 +163,14 @@ absl::StatusOr<Function*> Function::Clone(
       // Default clone.
       default: {
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             node->CloneInNewFunction(cloned_operands, cloned_function));
         break;
       }
     }
   }
-  XLS_RETURN_IF_ERROR(
-      cloned_function->set_return_value(original_to_clone.at(return_value())));
+  XLS_RETURN_IF_ERROR(cloned_function->set_return_value(
+      original_to_clone[return_value()->dense_index()]));
   return cloned_function;
 }
 
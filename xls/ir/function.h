@@ -16,7 +16,6 @@
 #define XLS_IR_FUNCTION_H_
 
 #include <functional>
-#include <list>
 #include <memory>
 #include <optional>
 #include <string>
@@ -36,9 +35,6 @@
 namespace xls {
 
 class Function : public FunctionBase {
- private:
-  using NodeList = std::list<std::unique_ptr<Node>>;
-
  public:
   Function(std::string_view name, Package* package)
       : FunctionBase(name, package) {}
@@ -52,7 +48,12 @@ class Function : public FunctionBase {
     XLS_RET_CHECK_EQ(n->function_base(), this) << absl::StreamFormat(
         "Return value node %s is not in this function %s (is in function %s)",
         n->GetName(), name(), n->function_base()->name());
+    if (return_value_ != nullptr) {
+      RecordChange(return_value_);
+    }
     return_value_ = n;
+    InvalidateTopoSort();
+    RecordChange(n);
     return absl::OkStatus();
   }
 
@@ -15,6 +15,7 @@
 #include "xls/ir/function_base.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -44,6 +45,7 @@
 #include "xls/ir/op.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc.h"
+#include "xls/ir/topo_sort.h"
 
 namespace xls {
 
@@ -96,6 +98,7 @@ absl::Status FunctionBase::MoveParamToIndex(Param* param, int64_t index) {
   }
   params_.erase(it);
   params_.insert(params_.begin() + index, param);
+  ++version_;
   return absl::OkStatus();
 }
 
@@ -129,7 +132,8 @@ absl::Status FunctionBase::RemoveNode(Node* node) {
   XLS_RET_CHECK(!HasImplicitUse(node)) << node->GetName();
   VLOG(4) << absl::StrFormat("Removing node from FunctionBase %s: %s", name(),
                              node->ToString());
-  ++package()->transform_metrics().nodes_removed;
+  package()->IncrementTransformMetric(&TransformMetrics::nodes_removed);
+  ++transform_metrics_.nodes_removed;
   std::vector<Node*> unique_operands;
   for (Node* operand : node->operands()) {
     if (!absl::c_linear_search(unique_operands, operand)) {
@@ -152,10 +156,127 @@ absl::Status FunctionBase::RemoveNode(Node* node) {
     next_values_by_state_read_.at(state_read).erase(next);
     std::erase(next_values_, next);
   }
-  auto node_it = node_iterators_.find(node);
-  XLS_RET_CHECK(node_it != node_iterators_.end());
-  nodes_.erase(node_it->second);
-  node_iterators_.erase(node_it);
+  int64_t index = node->dense_index_;
+  XLS_RET_CHECK(index >= 0 && index < nodes_.size() &&
+                nodes_[index].get() == node);
+
+  // Unlink the node from the iteration order.
+  Node* prev = node->prev_in_function_base_;
+  Node* next = node->next_in_function_base_;
+  (prev == nullptr ? first_node_ : prev->next_in_function_base_) = next;
+  (next == nullptr ? last_node_ : next->prev_in_function_base_) = prev;
+
+  // Keep the dense indices contiguous by moving the last node into the index
+  // of the removed node.
+  std::unique_ptr<Node> removed = std::move(nodes_[index]);
+  if (index != nodes_.size() - 1) {
+    nodes_[index] = std::move(nodes_.back());
+    nodes_[index]->dense_index_ = index;
+  }
+  nodes_.pop_back();
+  InvalidateTopoSort();
+  last_removal_epoch_ = change_epoch_;
+  ++version_;
+  return absl::OkStatus();
+}
+
+absl::Status FunctionBase::RemoveNodes(absl::Span<Node* const> nodes) {
+  // Indexed by dense index.
+  std::vector<bool> dead(nodes_.size(), false);
+  for (Node* node : nodes) {
+    XLS_RET_CHECK_EQ(node->function_base(), this) << node->GetName();
+    XLS_RET_CHECK(!HasImplicitUse(node)) << node->GetName();
+    dead[node->dense_index_] = true;
+  }
+  for (Node* node : nodes) {
+    for (Node* user : node->users()) {
+      XLS_RET_CHECK(dead[user->dense_index_]) << absl::StreamFormat(
+          "Cannot remove %s, its user %s is not removed", node->GetName(),
+          user->GetName());
+    }
+  }
+
+  if (IsBlock()) {
+    // Blocks keep additional bookkeeping for some nodes which is updated by
+    // Block::RemoveNode, so remove the nodes one at a time, users first.
+    // RemoveNode changes dense indices so gather the nodes up front.
+    std::vector<Node*> users_first;
+    for (Node* node : ReverseTopoSort(this)) {
+      if (dead[node->dense_index_]) {
+        users_first.push_back(node);
+      }
+    }
+    for (Node* node : users_first) {
+      XLS_RETURN_IF_ERROR(RemoveNode(node));
+    }
+    return absl::OkStatus();
+  }
+
+  // Unlink the removed nodes and drop them from the user lists of the remaining
+  // nodes, once per remaining node.
+  std::vector<Node*> live_operands;
+  std::vector<bool> live_operand_seen(nodes_.size(), false);
+  int64_t removed_count = 0;
+  for (const std::unique_ptr<Node>& node : nodes_) {
+    if (!dead[node->dense_index_]) {
+      continue;
+    }
+    ++removed_count;
+    VLOG(4) << absl::StrFormat("Removing node from FunctionBase %s: %s", name(),
+                               node->ToString());
+    // Unlink the node from the iteration order.
+    Node* prev = node->prev_in_function_base_;
+    Node* next = node->next_in_function_base_;
+    (prev == nullptr ? first_node_ : prev->next_in_function_base_) = next;
+    (next == nullptr ? last_node_ : next->prev_in_function_base_) = prev;
+    for (Node* operand : node->operands()) {
+      if (!dead[operand->dense_index_] &&
+          !live_operand_seen[operand->dense_index_]) {
+        live_operand_seen[operand->dense_index_] = true;
+        live_operands.push_back(operand);
+      }
+    }
+  }
+  auto is_dead = [&](Node* node) { return dead[node->dense_index_]; };
+  for (Node* operand : live_operands) {
+    operand->RemoveUsersIf(is_dead);
+    RecordChange(operand);
+  }
+
+  std::erase_if(params_, is_dead);
+  std::erase_if(next_values_, is_dead);
+  for (auto it = next_values_by_state_read_.begin();
+       it != next_values_by_state_read_.end();) {
+    if (is_dead(it->first)) {
+      next_values_by_state_read_.erase(it++);
+      continue;
+    }
+    absl::erase_if(it->second, is_dead);
+    ++it;
+  }
+
+  // Compact the storage keeping the dense indices contiguous.
+  int64_t live_count = 0;
+  for (int64_t i = 0; i < nodes_.size(); ++i) {
+    if (dead[i]) {
+      continue;
+    }
+    if (live_count != i) {
+      nodes_[live_count] = std::move(nodes_[i]);
+      nodes_[live_count]->dense_index_ = live_count;
+    }
+    ++live_count;
+  }
+  nodes_.resize(live_count);
+
+  package()->IncrementTransformMetric(&TransformMetrics::nodes_removed,
+                                      removed_count);
+  transform_metrics_.nodes_removed += removed_count;
+  InvalidateTopoSort();
+  if (removed_count > 0) {
+    last_removal_epoch_ = change_epoch_;
+    ++version_;
+  }
   return absl::OkStatus();
 }
 
@@ -231,7 +352,8 @@ Block* FunctionBase::AsBlockOrDie() {
 Node* FunctionBase::AddNodeInternal(std::unique_ptr<Node> node) {
   VLOG(4) << absl::StrFormat("Adding node to FunctionBase %s: %s", name(),
                              node->ToString());
-  ++package()->transform_metrics().nodes_added;
+  package()->IncrementTransformMetric(&TransformMetrics::nodes_added);
+  ++transform_metrics_.nodes_added;
   if (node->Is<Param>()) {
     params_.push_back(node->As<Param>());
   }
@@ -245,10 +367,33 @@ Node* FunctionBase::AddNodeInternal(std::unique_ptr<Node> node) {
     next_values_by_state_read_.at(state_read).insert(next);
   }
   Node* ptr = node.get();
-  node_iterators_[ptr] = nodes_.insert(nodes_.end(), std::move(node));
+  ptr->dense_index_ = nodes_.size();
+  ptr->prev_in_function_base_ = last_node_;
+  ptr->next_in_function_base_ = nullptr;
+  (last_node_ == nullptr ? first_node_ : last_node_->next_in_function_base_) =
+      ptr;
+  last_node_ = ptr;
+  nodes_.push_back(std::move(node));
+  InvalidateTopoSort();
+  RecordChange(ptr);
   return ptr;
 }
 
+/* static */ int64_t FunctionBase::NextUid() {
+  static std::atomic<int64_t> next_uid = 0;
+  return next_uid.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<Node*> FunctionBase::NodesChangedSince(int64_t epoch) const {
+  std::vector<Node*> changed;
+  for (Node* node : nodes()) {
+    if (node->change_epoch_ >= epoch) {
+      changed.push_back(node);
+    }
+  }
+  return changed;
+}
+
 /* static */ std::vector<std::string> FunctionBase::GetIrReservedWords() {
   std::vector<std::string> words(Token::GetKeywords().begin(),
                                  Token::GetKeywords().end());
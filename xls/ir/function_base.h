@@ -15,8 +15,10 @@
 #ifndef XLS_IR_FUNCTION_BASE_H_
 #define XLS_IR_FUNCTION_BASE_H_
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <ostream>
@@ -29,6 +31,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/iterator_range.h"
 #include "xls/common/status/status_macros.h"
@@ -38,22 +41,51 @@
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
-#include "xls/ir/unwrapping_iterator.h"
 #include "xls/ir/verify_node.h"
 
 namespace xls {
 
 class Function;
+class FunctionBase;
 class Proc;
 
+std::vector<Node*> ReverseTopoSort(FunctionBase* f);
+
 // Base class for Functions and Procs. A holder of a set of nodes.
 class FunctionBase {
- protected:
-  using NodeList = std::list<std::unique_ptr<Node>>;
-
  public:
+  // Iterator over the nodes of a function base in the order they were added.
+  // Like an iterator into a linked list, it remains valid when nodes are added
+  // or when nodes other than the one it refers to are removed.
+  class NodeIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Node*;
+    using difference_type = ptrdiff_t;
+    using pointer = Node* const*;
+    using reference = Node*;
+
+    NodeIterator() = default;
+    explicit NodeIterator(Node* node) : node_(node) {}
+
+    Node* operator*() const { return node_; }
+    NodeIterator& operator++() {
+      node_ = node_->next_in_function_base_;
+      return *this;
+    }
+    NodeIterator operator++(int) {
+      NodeIterator result = *this;
+      ++*this;
+      return result;
+    }
+    bool operator==(const NodeIterator& other) const = default;
+
+   private:
+    Node* node_ = nullptr;
+  };
+
   FunctionBase(std::string_view name, Package* package)
-      : name_(name), package_(package) {}
+      : name_(name), package_(package), uid_(NextUid()) {}
   FunctionBase(const FunctionBase& other) = delete;
   void operator=(const FunctionBase& other) = delete;
 
@@ -103,16 +135,54 @@ class FunctionBase {
 
   int64_t node_count() const { return nodes_.size(); }
 
+  // Transformation metrics for the nodes of this function base. The package
+  // metrics count the same events for all function bases together; these are
+  // only updated by whoever is changing this function base, so they stay
+  // accurate when function bases are optimized concurrently.
+  const TransformMetrics& transform_metrics() const {
+    return transform_metrics_;
+  }
+  TransformMetrics& transform_metrics() { return transform_metrics_; }
+
+  // Returns an identifier which is unique among all function bases created by
+  // the process. Unlike the address of the function base it is never reused,
+  // so it can be used to recognize cached data about a function base which has
+  // since been destroyed.
+  int64_t uid() const { return uid_; }
+
+  // Change tracking. Every node records the epoch in which it was last added
+  // or modified (operands, users, or being made the return value), so a pass
+  // which iterates to a fixed point can restrict later iterations to the
+  // nodes touched by the previous one:
+  //
+  //   int64_t epoch = f->NewChangeEpoch();
+  //   ... transform ...
+  //   for (Node* node : f->NodesChangedSince(epoch)) { ... }
+  //
+  // Starts a new epoch and returns it. Changes made from now on are recorded
+  // as belonging to the returned epoch (or a later one).
+  int64_t NewChangeEpoch() { return ++change_epoch_; }
+
+  // Returns the nodes added or modified in `epoch` or later, in the order of
+  // nodes().
+  std::vector<Node*> NodesChangedSince(int64_t epoch) const;
+
+  // Returns true if any node was removed in `epoch` or later.
+  bool NodesRemovedSince(int64_t epoch) const {
+    return last_removal_epoch_ >= epoch;
+  }
+
+  // Returns a number which increases whenever a node of the function base is
+  // added, removed or modified, so an unchanged version means an unchanged
+  // function base. Changes which are not recorded per node (e.g., setting the
+  // label of a cover) should be recorded with IncrementVersion.
+  int64_t version() const { return version_; }
+  void IncrementVersion() { ++version_; }
+
   // Expose Nodes, so that transformation passes can operate
   // on this function.
-  xabsl::iterator_range<UnwrappingIterator<NodeList::iterator>> nodes() {
-    return xabsl::make_range(MakeUnwrappingIterator(nodes_.begin()),
-                             MakeUnwrappingIterator(nodes_.end()));
-  }
-  xabsl::iterator_range<UnwrappingIterator<NodeList::const_iterator>> nodes()
-      const {
-    return xabsl::make_range(MakeUnwrappingIterator(nodes_.begin()),
-                             MakeUnwrappingIterator(nodes_.end()));
+  xabsl::iterator_range<NodeIterator> nodes() const {
+    return xabsl::make_range(NodeIterator(first_node_), NodeIterator());
   }
 
   // Adds a node to the set owned by this function.
@@ -158,6 +228,14 @@ class FunctionBase {
   // function type signature.
   virtual absl::Status RemoveNode(Node* n);
 
+  // Removes the given nodes from the function. Every user of each node must
+  // itself be among the nodes removed, so the nodes can be removed in any
+  // order. Equivalent to calling RemoveNode on each node users first, but
+  // removes the nodes from their operands' user lists and compacts the node
+  // storage in a single sweep rather than once per node, which matters when
+  // removing a large part of the function.
+  absl::Status RemoveNodes(absl::Span<Node* const> nodes);
+
   // Visit all nodes (including nodes not reachable from the root) in the
   // function using the given visitor.
   absl::Status Accept(DfsVisitor* visitor);
@@ -215,22 +293,61 @@ class FunctionBase {
   };
 
  protected:
+  // Node updates the topological sort cache when edges change.
+  friend class Node;
+  friend std::vector<Node*> ReverseTopoSort(FunctionBase* f);
+
   // Internal virtual helper for adding a node. Returns a pointer to the newly
   // added node.
   virtual Node* AddNodeInternal(std::unique_ptr<Node> node);
 
+  // Reserves storage for `count` nodes, e.g. before cloning another function
+  // base into this one.
+  void ReserveNodes(int64_t count) { nodes_.reserve(count); }
+
+  // Must be called on any change which may change the result of
+  // ReverseTopoSort: adding or removing a node, changing operands, users or
+  // node ids, or changing the return value.
+  void InvalidateTopoSort() {
+    topo_sort_valid_.store(false, std::memory_order_relaxed);
+  }
+
+  // Records that `node` was added or modified in the current epoch.
+  void RecordChange(Node* node) {
+    node->change_epoch_ = change_epoch_;
+    ++version_;
+  }
+
   // Returns a vector containing the reserved words in the IR.
   static std::vector<std::string> GetIrReservedWords();
 
+  static int64_t NextUid();
+
   std::string name_;
   Package* package_;
+  int64_t uid_;
   std::optional<int64_t> initiation_interval_;
-
-  // Store Nodes in std::list as they can be added and removed arbitrarily and
-  // we want a stable iteration order. Keep a map from instruction pointer to
-  // location in the list for fast lookup.
-  NodeList nodes_;
-  absl::flat_hash_map<const Node*, NodeList::iterator> node_iterators_;
+  TransformMetrics transform_metrics_;
+
+  // The owned nodes indexed by Node::dense_index(). Nodes can be added and
+  // removed arbitrarily and we want a stable iteration order, so the
+  // iteration order is kept separately in a list threaded through the nodes
+  // from first_node_ to last_node_.
+  std::vector<std::unique_ptr<Node>> nodes_;
+  Node* first_node_ = nullptr;
+  Node* last_node_ = nullptr;
+
+  // The result of the last ReverseTopoSort, valid while topo_sort_valid_ is
+  // set. Passes sort the same unchanged graph over and over in fixed-point
+  // loops so recomputing it each time is wasted work.
+  absl::Mutex topo_sort_mutex_;
+  std::atomic<bool> topo_sort_valid_ = false;
+  std::vector<Node*> reverse_topo_sort_ ABSL_GUARDED_BY(topo_sort_mutex_);
+
+  // The current change epoch and the last epoch in which a node was removed.
+  int64_t change_epoch_ = 0;
+  int64_t last_removal_epoch_ = -1;
+  int64_t version_ = 0;
 
   std::vector<Param*> params_;
   std::vector<Next*> next_values_;
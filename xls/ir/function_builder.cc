@@ -1053,6 +1053,17 @@ absl::StatusOr<Function*> FunctionBuilder::Build() {
 
 absl::StatusOr<Function*> FunctionBuilder::BuildWithReturnValue(
     BValue return_value) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Function> function,
+                       BuildUnownedWithReturnValue(return_value));
+  Function* f = package()->AddFunction(std::move(function));
+  if (should_verify_) {
+    XLS_RETURN_IF_ERROR(VerifyFunction(f));
+  }
+  return f;
+}
+
+absl::StatusOr<std::unique_ptr<Function>>
+FunctionBuilder::BuildUnownedWithReturnValue(BValue return_value) {
   if (ErrorPending()) {
     return GetError();
   }
@@ -1060,12 +1071,9 @@ absl::StatusOr<Function*> FunctionBuilder::BuildWithReturnValue(
   // down_cast the FunctionBase* to Function*. We know this is safe because
   // FunctionBuilder constructs and passes a Function to BuilderBase
   // constructor so function_ is always a Function.
-  Function* f = package()->AddFunction(
-      absl::WrapUnique(down_cast<Function*>(function_.release())));
+  std::unique_ptr<Function> f =
+      absl::WrapUnique(down_cast<Function*>(function_.release()));
   XLS_RETURN_IF_ERROR(f->set_return_value(return_value.node()));
-  if (should_verify_) {
-    XLS_RETURN_IF_ERROR(VerifyFunction(f));
-  }
   return f;
 }
 
@@ -1166,6 +1174,16 @@ absl::Status ProcBuilder::InstantiateProc(
 }
 
 absl::StatusOr<Proc*> ProcBuilder::Build(absl::Span<const BValue> next_state) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Proc> unowned, BuildUnowned(next_state));
+  Proc* proc = package()->AddProc(std::move(unowned));
+  if (should_verify_) {
+    XLS_RETURN_IF_ERROR(VerifyProc(proc));
+  }
+  return proc;
+}
+
+absl::StatusOr<std::unique_ptr<Proc>> ProcBuilder::BuildUnowned(
+    absl::Span<const BValue> next_state) {
   if (ErrorPending()) {
     return GetError();
   }
@@ -1191,14 +1209,11 @@ absl::StatusOr<Proc*> ProcBuilder::Build(absl::Span<const BValue> next_state) {
   // down_cast the FunctionBase* to Proc*. We know this is safe because
   // ProcBuilder constructs and passes a Proc to BuilderBase constructor so
   // function_ is always a Proc.
-  Proc* proc = package()->AddProc(
-      absl::WrapUnique(down_cast<Proc*>(function_.release())));
+  std::unique_ptr<Proc> proc =
+      absl::WrapUnique(down_cast<Proc*>(function_.release()));
   for (int64_t i = 0; i < next_state.size(); ++i) {
     XLS_RETURN_IF_ERROR(proc->SetNextStateElement(i, next_state[i].node()));
   }
-  if (should_verify_) {
-    XLS_RETURN_IF_ERROR(VerifyProc(proc));
-  }
   return proc;
 }
 
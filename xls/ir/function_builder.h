@@ -717,6 +717,12 @@ class FunctionBuilder : public BuilderBase {
 
   // Build function using given return value.
   absl::StatusOr<Function*> BuildWithReturnValue(BValue return_value);
+
+  // As BuildWithReturnValue, but the function is neither verified nor added to
+  // the package. It may be added to the package later with
+  // Package::AddFunction.
+  absl::StatusOr<std::unique_ptr<Function>> BuildUnownedWithReturnValue(
+      BValue return_value);
 };
 
 // Type used as special argument to ProcBuilder constructor to indicate that the
@@ -806,6 +812,11 @@ class ProcBuilder : public BuilderBase {
   // `next_state` must match the number of state parameters.
   absl::StatusOr<Proc*> Build(absl::Span<const BValue> next_state = {});
 
+  // As Build, but the proc is neither verified nor added to the package. It may
+  // be added to the package later with Package::AddProc.
+  absl::StatusOr<std::unique_ptr<Proc>> BuildUnowned(
+      absl::Span<const BValue> next_state = {});
+
   // Adds a state element to the proc with the given initial value. Returns the
   // newly added state parameter.
   BValue StateElement(std::string_view name, const Value& initial_value,
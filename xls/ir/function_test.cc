@@ -43,6 +43,8 @@ namespace {
 using ::absl_testing::StatusIs;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
 
 class FunctionTest : public IrTestBase {};
 
@@ -441,5 +443,113 @@ fn graph(p: bits[42], q: bits[42]) -> bits[42] {
   }
 }
 
+TEST_F(FunctionTest, NodeOrderIsStableAcrossAddAndRemove) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn foo(x: bits[32], y: bits[32]) -> bits[32] {
+  a: bits[32] = literal(value=1)
+  b: bits[32] = literal(value=2)
+  c: bits[32] = literal(value=3)
+  ret sum: bits[32] = add(x, y)
+}
+)",
+                                                          p.get()));
+  auto node_names = [&]() {
+    std::vector<std::string> names;
+    for (Node* node : func->nodes()) {
+      names.push_back(node->GetName());
+    }
+    return names;
+  };
+  EXPECT_THAT(node_names(), ElementsAre("x", "y", "a", "b", "c", "sum"));
+
+  XLS_ASSERT_OK(func->RemoveNode(FindNode("a", func)));
+  XLS_ASSERT_OK(func->RemoveNode(FindNode("b", func)));
+  EXPECT_THAT(node_names(), ElementsAre("x", "y", "c", "sum"));
+  EXPECT_EQ(func->node_count(), 4);
+
+  XLS_ASSERT_OK(func->MakeNodeWithName<Literal>(SourceInfo(),
+                                                Value(UBits(4, 32)), "d")
+                    .status());
+  EXPECT_THAT(node_names(), ElementsAre("x", "y", "c", "sum", "d"));
+  EXPECT_EQ(func->node_count(), 5);
+}
+
+TEST_F(FunctionTest, RemoveNodes) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn foo(x: bits[32], y: bits[32], z: bits[32]) -> bits[32] {
+  a: bits[32] = add(x, x)
+  b: bits[32] = neg(a)
+  c: bits[32] = add(a, b)
+  ret sum: bits[32] = add(x, y)
+}
+)",
+                                                          p.get()));
+  Node* x = FindNode("x", func);
+  // Removing `a` without its users is an error.
+  EXPECT_THAT(func->RemoveNodes({FindNode("a", func), FindNode("c", func)}),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("its user b is not removed")));
+
+  int64_t epoch = func->NewChangeEpoch();
+  XLS_ASSERT_OK(func->RemoveNodes({FindNode("a", func), FindNode("c", func),
+                                   FindNode("b", func), FindNode("z", func),
+                                   FindNode("b", func)}));
+  std::vector<std::string> names;
+  for (Node* node : func->nodes()) {
+    names.push_back(node->GetName());
+  }
+  EXPECT_THAT(names, ElementsAre("x", "y", "sum"));
+  EXPECT_EQ(func->node_count(), 3);
+  EXPECT_THAT(func->params(), ElementsAre(x, FindNode("y", func)));
+  EXPECT_THAT(x->users(), ElementsAre(FindNode("sum", func)));
+  EXPECT_TRUE(func->NodesRemovedSince(epoch));
+  std::vector<int64_t> dense_indices;
+  for (Node* node : func->nodes()) {
+    dense_indices.push_back(node->dense_index());
+  }
+  EXPECT_THAT(dense_indices, UnorderedElementsAre(0, 1, 2));
+}
+
+TEST_F(FunctionTest, NodesChangedSince) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
+fn foo(x: bits[32], y: bits[32]) -> bits[32] {
+  a: bits[32] = literal(value=1)
+  neg: bits[32] = neg(y)
+  ret sum: bits[32] = add(x, y)
+}
+)",
+                                                          p.get()));
+  auto names_changed_since = [&](int64_t epoch) {
+    std::vector<std::string> names;
+    for (Node* node : func->NodesChangedSince(epoch)) {
+      names.push_back(node->GetName());
+    }
+    return names;
+  };
+  int64_t first = func->NewChangeEpoch();
+  EXPECT_THAT(names_changed_since(first), IsEmpty());
+  EXPECT_FALSE(func->NodesRemovedSince(first));
+
+  // Replacing an operand changes the user and both the old and new operands.
+  XLS_ASSERT_OK(FindNode("sum", func)->ReplaceOperandNumber(
+      1, FindNode("neg", func)));
+  EXPECT_THAT(names_changed_since(first), ElementsAre("y", "neg", "sum"));
+
+  int64_t second = func->NewChangeEpoch();
+  EXPECT_THAT(names_changed_since(second), IsEmpty());
+  XLS_ASSERT_OK(func->MakeNodeWithName<Literal>(SourceInfo(),
+                                                Value(UBits(4, 32)), "b")
+                    .status());
+  XLS_ASSERT_OK(func->RemoveNode(FindNode("a", func)));
+  EXPECT_THAT(names_changed_since(second), ElementsAre("b"));
+  EXPECT_THAT(names_changed_since(first), ElementsAre("y", "neg", "sum", "b"));
+  EXPECT_TRUE(func->NodesRemovedSince(first));
+  EXPECT_TRUE(func->NodesRemovedSince(second));
+  EXPECT_FALSE(func->NodesRemovedSince(func->NewChangeEpoch()));
+}
+
 }  // namespace
 }  // namespace xls
@@ -20,6 +20,7 @@
 #include <list>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/log/check.h"
@@ -32,6 +33,30 @@
 #include "xls/ir/interval.h"
 
 namespace xls {
+namespace {
+
+// Interval sets whose bit count is in (0, kMaxWordBitCount] are normalized and
+// intersected with their bounds held in machine words rather than in Bits.
+constexpr int64_t kMaxWordBitCount = 64;
+
+bool UseWordBounds(int64_t bit_count) {
+  return bit_count > 0 && bit_count <= kMaxWordBitCount;
+}
+
+using WordInterval = std::pair<uint64_t, uint64_t>;
+
+std::vector<Interval> FromWordIntervals(absl::Span<const WordInterval> words,
+                                        int64_t bit_count) {
+  std::vector<Interval> intervals;
+  intervals.reserve(words.size());
+  for (const auto& [lower, upper] : words) {
+    intervals.push_back(
+        Interval(UBits(lower, bit_count), UBits(upper, bit_count)));
+  }
+  return intervals;
+}
+
+}  // namespace
 
 IntervalSet IntervalSet::Maximal(int64_t bit_count) {
   IntervalSet result(bit_count);
@@ -81,6 +106,11 @@ void IntervalSet::Normalize() {
     return;
   }
 
+  if (UseWordBounds(BitCount())) {
+    NormalizeWordBounds();
+    return;
+  }
+
   Bits zero(BitCount());
   Bits max = Bits::AllOnes(BitCount());
   std::vector<Interval> expand_improper;
@@ -110,6 +140,37 @@ void IntervalSet::Normalize() {
   is_normalized_ = true;
 }
 
+void IntervalSet::NormalizeWordBounds() {
+  uint64_t max = Bits::AllOnes(BitCount()).ToUint64().value();
+  std::vector<WordInterval> words;
+  words.reserve(intervals_.size() + 1);
+  for (const Interval& interval : intervals_) {
+    uint64_t lower = interval.LowerBound().ToUint64().value();
+    uint64_t upper = interval.UpperBound().ToUint64().value();
+    if (lower > upper) {
+      words.push_back({0, upper});
+      words.push_back({lower, max});
+    } else {
+      words.push_back({lower, upper});
+    }
+  }
+  std::sort(words.begin(), words.end());
+
+  // Merge overlapping and abutting intervals in place.
+  int64_t merged = 0;
+  for (int64_t i = 1; i < words.size(); ++i) {
+    WordInterval& last = words[merged];
+    if (last.second == max || words[i].first <= last.second + 1) {
+      last.second = std::max(last.second, words[i].second);
+    } else {
+      words[++merged] = words[i];
+    }
+  }
+  words.resize(words.empty() ? 0 : merged + 1);
+  intervals_ = FromWordIntervals(words, BitCount());
+  is_normalized_ = true;
+}
+
 std::optional<Interval> IntervalSet::ConvexHull() const {
   CHECK_GE(bit_count_, 0);
   std::optional<Bits> lower = LowerBound();
@@ -238,6 +299,33 @@ IntervalSet IntervalSet::Intersect(const IntervalSet& lhs,
   CHECK(lhs.is_normalized_);
   CHECK(rhs.is_normalized_);
   IntervalSet result(lhs.BitCount());
+  if (UseWordBounds(lhs.BitCount())) {
+    // Both sets are sorted and disjoint, so a merge of the two lists yields
+    // sorted, disjoint and non-abutting intersections.
+    std::vector<WordInterval> words;
+    int64_t i = 0;
+    int64_t j = 0;
+    while (i < lhs.intervals_.size() && j < rhs.intervals_.size()) {
+      const Interval& left = lhs.intervals_[i];
+      const Interval& right = rhs.intervals_[j];
+      uint64_t left_upper = left.UpperBound().ToUint64().value();
+      uint64_t right_upper = right.UpperBound().ToUint64().value();
+      uint64_t lower = std::max(left.LowerBound().ToUint64().value(),
+                                right.LowerBound().ToUint64().value());
+      uint64_t upper = std::min(left_upper, right_upper);
+      if (lower <= upper) {
+        words.push_back({lower, upper});
+      }
+      if (left_upper <= right_upper) {
+        ++i;
+      }
+      if (right_upper <= left_upper) {
+        ++j;
+      }
+    }
+    result.intervals_ = FromWordIntervals(words, result.BitCount());
+    return result;
+  }
   std::list<Interval> lhs_intervals(lhs.Intervals().begin(),
                                     lhs.Intervals().end());
   std::list<Interval> rhs_intervals(rhs.Intervals().begin(),
@@ -373,6 +461,18 @@ bool IntervalSet::IsTrueWhenMaskWith(const Bits& value) const {
 
 bool IntervalSet::Covers(const Bits& bits) const {
   CHECK_EQ(bits.bit_count(), BitCount());
+  if (UseWordBounds(BitCount())) {
+    uint64_t value = bits.ToUint64().value();
+    for (const Interval& interval : intervals_) {
+      uint64_t lower = interval.LowerBound().ToUint64().value();
+      uint64_t upper = interval.UpperBound().ToUint64().value();
+      if (lower <= upper ? (lower <= value && value <= upper)
+                         : (lower <= value || value <= upper)) {
+        return true;
+      }
+    }
+    return false;
+  }
   for (const Interval& interval : intervals_) {
     if (interval.Covers(bits)) {
       return true;
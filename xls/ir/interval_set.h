@@ -293,6 +293,9 @@ class IntervalSet {
   }
 
  private:
+  // Normalize() for bit counts which fit in a machine word.
+  void NormalizeWordBounds();
+
   bool is_normalized_;
   int64_t bit_count_;
   std::vector<Interval> intervals_;
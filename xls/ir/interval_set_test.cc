@@ -597,5 +597,21 @@ FUZZ_TEST(IntervalFuzzTest, DisjointEquivalentToEmptyIntersection)
     .WithDomains(ArbitraryNormalizedIntervalSet(32),
                  ArbitraryNormalizedIntervalSet(32));
 
+void WordBoundsMatchWideBounds(const IntervalSet& lhs,
+                               const IntervalSet& rhs) {
+  // Sets of 32 bits take the word-sized fast paths while sets of 65 bits do
+  // not.
+  IntervalSet wide_lhs = lhs.ZeroExtend(65);
+  IntervalSet wide_rhs = rhs.ZeroExtend(65);
+  EXPECT_EQ(IntervalSet::Intersect(lhs, rhs).ZeroExtend(65),
+            IntervalSet::Intersect(wide_lhs, wide_rhs));
+  EXPECT_EQ(IntervalSet::Combine(lhs, rhs).ZeroExtend(65),
+            IntervalSet::Combine(wide_lhs, wide_rhs));
+}
+
+FUZZ_TEST(IntervalFuzzTest, WordBoundsMatchWideBounds)
+    .WithDomains(ArbitraryNormalizedIntervalSet(32),
+                 ArbitraryNormalizedIntervalSet(32));
+
 }  // namespace
 }  // namespace xls
@@ -14,6 +14,8 @@
 
 #include "xls/ir/ir_parser.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <initializer_list>
@@ -37,11 +39,13 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/synchronization/notification.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "google/protobuf/text_format.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/common/visitor.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
@@ -769,7 +773,7 @@ absl::StatusOr<BValue> Parser::ParseNode(
           arg_parser.AddKeywordArg<IdentifierString>("to_apply");
       XLS_ASSIGN_OR_RETURN(operands, arg_parser.Run(/*arity=*/1));
       XLS_ASSIGN_OR_RETURN(Function * to_apply,
-                           package->GetFunction(to_apply_name->value));
+                           GetFunction(package, to_apply_name->value));
       bvalue = fb->Map(operands[0], to_apply, *loc, node_name);
       break;
     }
@@ -827,7 +831,7 @@ absl::StatusOr<BValue> Parser::ParseNode(
               "invariant_args", /*default_value=*/{});
       XLS_ASSIGN_OR_RETURN(operands, arg_parser.Run(/*arity=*/1));
       XLS_ASSIGN_OR_RETURN(Function * body,
-                           package->GetFunction(body_name->value));
+                           GetFunction(package, body_name->value));
       bvalue = fb->CountedFor(operands[0], *trip_count, *stride, body,
                               *invariant_args, *loc, node_name);
       break;
@@ -840,7 +844,7 @@ absl::StatusOr<BValue> Parser::ParseNode(
               "invariant_args", /*default_value=*/{});
       XLS_ASSIGN_OR_RETURN(operands, arg_parser.Run(/*arity=*/3));
       XLS_ASSIGN_OR_RETURN(Function * body,
-                           package->GetFunction(body_name->value));
+                           GetFunction(package, body_name->value));
       bvalue = fb->DynamicCountedFor(operands[0], operands[1], operands[2],
                                      body, *invariant_args, *loc, node_name);
       break;
@@ -985,7 +989,7 @@ absl::StatusOr<BValue> Parser::ParseNode(
           arg_parser.AddKeywordArg<IdentifierString>("to_apply");
       XLS_ASSIGN_OR_RETURN(operands, arg_parser.Run(ArgParser::kVariadic));
       XLS_ASSIGN_OR_RETURN(Function * to_apply,
-                           package->GetFunction(to_apply_name->value));
+                           GetFunction(package, to_apply_name->value));
       bvalue = fb->Invoke(operands, to_apply, *loc, node_name);
       break;
     }
@@ -2180,6 +2184,13 @@ absl::Status Parser::ParseFileNumber(Package* package,
 
 absl::StatusOr<Function*> Parser::ParseFunction(
     Package* package, const DeclAttributes& attributes) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Function> function,
+                       ParseUnownedFunction(package, attributes));
+  return package->AddFunction(std::move(function));
+}
+
+absl::StatusOr<std::unique_ptr<Function>> Parser::ParseUnownedFunction(
+    Package* package, const DeclAttributes& attributes) {
   if (AtEof()) {
     return absl::InvalidArgumentError("Could not parse function; at EOF.");
   }
@@ -2209,8 +2220,8 @@ absl::StatusOr<Function*> Parser::ParseFunction(
   // TODO(leary): 2019-02-19 Could be an empty function body, need to decide
   // what to do for those. Accept that the return value can be null and handle
   // everywhere?
-  XLS_ASSIGN_OR_RETURN(Function * result,
-                       fb->BuildWithReturnValue(return_value));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Function> result,
+                       fb->BuildUnownedWithReturnValue(return_value));
 
   for (const auto& [attribute, literal] : attributes) {
     if (attribute == "initiation_interval") {
@@ -2235,6 +2246,13 @@ absl::StatusOr<Function*> Parser::ParseFunction(
 
 absl::StatusOr<Proc*> Parser::ParseProc(Package* package,
                                         const DeclAttributes& attributes) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Proc> proc,
+                       ParseUnownedProc(package, attributes));
+  return package->AddProc(std::move(proc));
+}
+
+absl::StatusOr<std::unique_ptr<Proc>> Parser::ParseUnownedProc(
+    Package* package, const DeclAttributes& attributes) {
   if (AtEof()) {
     return absl::InvalidArgumentError("Could not parse proc; at EOF.");
   }
@@ -2250,7 +2268,8 @@ absl::StatusOr<Proc*> Parser::ParseProc(Package* package,
   XLS_RET_CHECK(std::holds_alternative<ProcNext>(body_result));
   ProcNext proc_next = std::get<ProcNext>(body_result);
 
-  XLS_ASSIGN_OR_RETURN(Proc * result, pb->Build(proc_next.next_state));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Proc> result,
+                       pb->BuildUnowned(proc_next.next_state));
 
   for (const auto& [attribute, literal] : attributes) {
     if (attribute == "initiation_interval") {
@@ -2644,8 +2663,10 @@ absl::StatusOr<DeclAttributes> Parser::MaybeParseAttributes() {
 
 // Verifies the given package. Replaces InternalError status codes with
 // InvalidArgument status code which is more appropriate for the parser.
-static absl::Status VerifyAndSwapError(Package* package) {
-  absl::Status status = VerifyPackage(package);
+static absl::Status VerifyAndSwapError(Package* package,
+                                       int64_t parallelism = 1) {
+  absl::Status status =
+      VerifyPackage(package, /*codegen=*/false, parallelism);
   if (!status.ok() && status.code() == absl::StatusCode::kInternal) {
     return absl::InvalidArgumentError(status.message());
   }
@@ -2725,6 +2746,224 @@ Parser::ParsePackageWithEntry(std::string_view input_string,
   return package;
 }
 
+struct Parser::ParallelDefinitions {
+  struct Definition {
+    bool is_proc;
+    std::string name;
+    bool is_top;
+    DeclAttributes attributes;
+    Scanner::SkippedText text;
+
+    // Notified once the definition has been parsed, successfully or not.
+    absl::Notification parsed;
+    absl::Status status;
+    std::unique_ptr<Function> function;
+    std::unique_ptr<Proc> proc;
+  };
+  std::vector<std::unique_ptr<Definition>> definitions;
+};
+
+absl::StatusOr<Function*> Parser::GetFunction(Package* package,
+                                              std::string_view name) {
+  if (parallel_definitions_ == nullptr) {
+    return package->GetFunction(name);
+  }
+  // As when parsing serially, only functions defined earlier in the text may
+  // be called. These are either parsed or being parsed by other threads.
+  std::vector<std::string_view> defined_names;
+  for (int64_t i = 0; i < definition_index_; ++i) {
+    ParallelDefinitions::Definition& definition =
+        *parallel_definitions_->definitions[i];
+    if (definition.is_proc) {
+      continue;
+    }
+    if (definition.name != name) {
+      defined_names.push_back(definition.name);
+      continue;
+    }
+    definition.parsed.WaitForNotification();
+    if (!definition.status.ok()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Function \"%s\" could not be parsed", name));
+    }
+    return definition.function.get();
+  }
+  return absl::NotFoundError(absl::StrFormat(
+      "Package does not have a function with name: \"%s\"; available: [%s]",
+      name, absl::StrJoin(defined_names, ", ")));
+}
+
+absl::StatusOr<bool> Parser::ScanPackageDefinitions(
+    Package* package, ParallelDefinitions& definitions) {
+  std::optional<Token> previous_top_token;
+  while (!AtEof()) {
+    XLS_ASSIGN_OR_RETURN(DeclAttributes attributes, MaybeParseAttributes());
+    XLS_ASSIGN_OR_RETURN(Token peek, scanner_.PeekToken());
+    bool is_top = false;
+    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "top") {
+      is_top = true;
+      XLS_RETURN_IF_ERROR(scanner_.DropKeywordOrError("top"));
+      XLS_ASSIGN_OR_RETURN(peek, scanner_.PeekToken());
+      if (previous_top_token.has_value()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Top declared more than once, previous declaration @ %s",
+            previous_top_token.value().pos().ToHumanString()));
+      }
+      previous_top_token = peek;
+    }
+    if (peek.type() == LexicalTokenType::kKeyword &&
+        (peek.value() == "fn" || peek.value() == "proc")) {
+      XLS_ASSIGN_OR_RETURN(Scanner::SkippedText text,
+                           scanner_.SkipBracedDefinition());
+      // Only the name, and for procs whether the proc has proc-scoped
+      // channels, is needed now.
+      XLS_ASSIGN_OR_RETURN(Scanner header,
+                           Scanner::Create(text.text, text.start));
+      header.DropTokenOrDie();
+      XLS_ASSIGN_OR_RETURN(Token name,
+                           header.PopTokenOrError(LexicalTokenType::kIdent));
+      bool is_proc = peek.value() == "proc";
+      if (is_proc && header.PeekTokenIs(LexicalTokenType::kLt)) {
+        return false;
+      }
+      auto definition = std::make_unique<ParallelDefinitions::Definition>();
+      definition->is_proc = is_proc;
+      definition->name = name.value();
+      definition->is_top = is_top;
+      definition->attributes = std::move(attributes);
+      definition->text = text;
+      definitions.definitions.push_back(std::move(definition));
+      continue;
+    }
+    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "block") {
+      return false;
+    }
+    if (is_top) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Expected fn, proc or block definition, got %s @ %s",
+                          peek.value(), peek.pos().ToHumanString()));
+    }
+    if (peek.type() == LexicalTokenType::kKeyword && peek.value() == "chan") {
+      // Procs may only use channels declared before them.
+      if (!definitions.definitions.empty()) {
+        return false;
+      }
+      XLS_RETURN_IF_ERROR(ParseChannel(package, attributes).status());
+      continue;
+    }
+    if (peek.type() == LexicalTokenType::kKeyword &&
+        peek.value() == "file_number") {
+      XLS_RETURN_IF_ERROR(ParseFileNumber(package, attributes));
+      continue;
+    }
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected attribute or declaration "
+                        "(`fn`, `proc`, `block`, `chan`, `file_number`), "
+                        "got %s @ %s",
+                        peek.value(), peek.pos().ToHumanString()));
+  }
+  return true;
+}
+
+/* static */ absl::Status Parser::ParseParallelDefinition(
+    Package* package, ParallelDefinitions& definitions, int64_t index) {
+  ParallelDefinitions::Definition& definition =
+      *definitions.definitions[index];
+  XLS_ASSIGN_OR_RETURN(
+      Scanner scanner,
+      Scanner::Create(definition.text.text, definition.text.start));
+  Parser parser(std::move(scanner));
+  parser.parallel_definitions_ = &definitions;
+  parser.definition_index_ = index;
+  if (definition.is_proc) {
+    XLS_ASSIGN_OR_RETURN(
+        definition.proc,
+        parser.ParseUnownedProc(package, definition.attributes));
+  } else {
+    XLS_ASSIGN_OR_RETURN(
+        definition.function,
+        parser.ParseUnownedFunction(package, definition.attributes));
+  }
+  XLS_RET_CHECK(parser.AtEof()) << "Definition of " << definition.name
+                                << " does not end at its closing brace";
+  return absl::OkStatus();
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<Package>>
+Parser::ParsePackageInParallel(std::string_view input_string,
+                               int64_t parallelism,
+                               std::optional<std::string_view> filename) {
+  if (parallelism <= 1) {
+    return ParsePackage(input_string, filename);
+  }
+  XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
+  Parser parser(std::move(scanner));
+  XLS_ASSIGN_OR_RETURN(std::string package_name, parser.ParsePackageName());
+  auto package = std::make_unique<Package>(package_name);
+  ParallelDefinitions definitions;
+  absl::StatusOr<bool> scanned =
+      parser.ScanPackageDefinitions(package.get(), definitions);
+  if (!scanned.ok() || !*scanned) {
+    // Errors are reported by the serial parser so they are the same whichever
+    // parser is used.
+    return ParsePackage(input_string, filename);
+  }
+
+  // Parse the definitions in order so those which are waited upon by later
+  // definitions calling them are already being parsed by another thread.
+  std::atomic<int64_t> next_index = 0;
+  auto worker = [&]() {
+    for (int64_t i = next_index++; i < definitions.definitions.size();
+         i = next_index++) {
+      ParallelDefinitions::Definition& definition =
+          *definitions.definitions[i];
+      definition.status =
+          ParseParallelDefinition(package.get(), definitions, i);
+      definition.parsed.Notify();
+    }
+  };
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    int64_t thread_count = std::min<int64_t>(
+        parallelism, static_cast<int64_t>(definitions.definitions.size()));
+    for (int64_t i = 0; i < thread_count; ++i) {
+      threads.push_back(std::make_unique<Thread>(worker));
+    }
+    // Threads are joined on destruction.
+  }
+
+  // Add the definitions to the package in the order of the text and return the
+  // first error, as the serial parser would.
+  std::string filename_str =
+      (filename.has_value() ? std::string(filename.value()) : "<unknown file>");
+  for (std::unique_ptr<ParallelDefinitions::Definition>& definition :
+       definitions.definitions) {
+    XLS_RETURN_IF_ERROR(definition->status) << "@ " << filename_str;
+    FunctionBase* function_base =
+        definition->is_proc
+            ? static_cast<FunctionBase*>(
+                  package->AddProc(std::move(definition->proc)))
+            : package->AddFunction(std::move(definition->function));
+    if (definition->is_top) {
+      XLS_RETURN_IF_ERROR(package->SetTop(function_base));
+    }
+  }
+
+  // The next node id depends on how the threads interleaved, so reset it
+  // before numbering the nodes without an id.
+  int64_t max_node_id = 0;
+  for (FunctionBase* function_base : package->GetFunctionBases()) {
+    for (Node* node : function_base->nodes()) {
+      max_node_id = std::max(max_node_id, node->id());
+    }
+  }
+  package->set_next_node_id(max_node_id + 1);
+  SetUnassignedNodeIds(package.get());
+
+  XLS_RETURN_IF_ERROR(VerifyAndSwapError(package.get(), parallelism));
+  return package;
+}
+
 /* static */ absl::StatusOr<std::unique_ptr<Package>>
 Parser::ParsePackageNoVerify(std::string_view input_string,
                              std::optional<std::string_view> filename,
@@ -68,6 +68,17 @@ class Parser {
       std::string_view input_string,
       std::optional<std::string_view> filename = std::nullopt);
 
+  // As above, but the functions and procs of the package are parsed, and the
+  // package is verified, on up to `parallelism` threads. A quick scan of the
+  // text first finds where each definition starts and ends. The result is the
+  // same as that of ParsePackage except that nodes without an id in the text
+  // may be numbered differently. Packages containing blocks or procs with
+  // proc-scoped channels, or declaring a channel after a function or proc, are
+  // parsed serially.
+  static absl::StatusOr<std::unique_ptr<Package>> ParsePackageInParallel(
+      std::string_view input_string, int64_t parallelism,
+      std::optional<std::string_view> filename = std::nullopt);
+
   // As above, but sets the entry function to be the given name in the returned
   // package.
   static absl::StatusOr<std::unique_ptr<Package>> ParsePackageWithEntry(
@@ -136,16 +147,44 @@ class Parser {
  private:
   friend class ArgParser;
 
-  explicit Parser(Scanner scanner) : scanner_(scanner) {}
+  // The functions and procs of a package parsed by ParsePackageInParallel.
+  struct ParallelDefinitions;
+
+  explicit Parser(Scanner scanner) : scanner_(std::move(scanner)) {}
 
   // Parse a function starting at the current scanner position.
   absl::StatusOr<Function*> ParseFunction(
       Package* package, const DeclAttributes& attributes = {});
 
+  // As above, but the function is returned rather than added to the package.
+  absl::StatusOr<std::unique_ptr<Function>> ParseUnownedFunction(
+      Package* package, const DeclAttributes& attributes = {});
+
   // Parse a proc starting at the current scanner position.
   absl::StatusOr<Proc*> ParseProc(Package* package,
                                   const DeclAttributes& attributes = {});
 
+  // As above, but the proc is returned rather than added to the package.
+  absl::StatusOr<std::unique_ptr<Proc>> ParseUnownedProc(
+      Package* package, const DeclAttributes& attributes = {});
+
+  // Scans the top level of a package for ParsePackageInParallel starting after
+  // the package name. Channel and file number declarations are parsed into
+  // `package` while functions and procs are skipped and recorded in
+  // `definitions`. Returns false if the package cannot be parsed in parallel.
+  absl::StatusOr<bool> ScanPackageDefinitions(Package* package,
+                                              ParallelDefinitions& definitions);
+
+  // Parses the function or proc at `index` of `definitions`.
+  static absl::Status ParseParallelDefinition(Package* package,
+                                              ParallelDefinitions& definitions,
+                                              int64_t index);
+
+  // Returns the function named `name` which may be called by the function or
+  // proc being parsed.
+  absl::StatusOr<Function*> GetFunction(Package* package,
+                                        std::string_view name);
+
   // Parse a block starting at the current scanner position.
   absl::StatusOr<Block*> ParseBlock(Package* package,
                                     const DeclAttributes& attributes = {});
@@ -337,6 +376,12 @@ class Parser {
   bool AtEof() const { return scanner_.AtEof(); }
 
   Scanner scanner_;
+
+  // If this parser is parsing one of the definitions of a package parsed by
+  // ParsePackageInParallel, the definitions and the index of this one. Only
+  // functions defined earlier may be called.
+  ParallelDefinitions* parallel_definitions_ = nullptr;
+  int64_t definition_index_ = 0;
 };
 
 /* static */ template <typename PackageT>
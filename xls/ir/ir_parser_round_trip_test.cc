@@ -78,6 +78,12 @@ static void ParsePackageAndCheckDump(
   std::string ir_text = GetFileContents(abs_path).value();
   XLS_ASSERT_OK_AND_ASSIGN(auto package, Parser::ParsePackage(ir_text));
   ExpectEqualToGoldenFile(TestFilePath(test_name), package->DumpIr(), loc);
+
+  // Parsing the definitions in parallel must give the same package.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto parallel_package,
+      Parser::ParsePackageInParallel(ir_text, /*parallelism=*/4));
+  EXPECT_EQ(parallel_package->DumpIr(), package->DumpIr());
 }
 
 TEST(IrParserRoundTripTest, ParseBitsLiteral) {
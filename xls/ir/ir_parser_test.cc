@@ -33,9 +33,11 @@
 #include "xls/ir/channel.h"
 #include "xls/ir/channel.pb.h"
 #include "xls/ir/channel_ops.h"
+#include "xls/ir/function.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 
@@ -1001,6 +1003,83 @@ TEST(IrParserTest, ParseWithUnspecifiedIds) {
   XLS_ASSERT_OK(Parser::ParsePackage(input).status());
 }
 
+TEST(IrParserTest, ParsePackageInParallel) {
+  const std::string input = R"(package test
+
+file_number 0 "foo.x"
+
+chan input_ch(bits[32], id=0, kind=streaming, ops=receive_only, flow_control=ready_valid, strictness=proven_mutually_exclusive)
+
+fn square(x: bits[32] id=1) -> bits[32] {
+  ret umul.2: bits[32] = umul(x, x, id=2, pos=[(0,1,2)])
+}
+
+fn body(i: bits[32] id=3, acc: bits[32] id=4) -> bits[32] {
+  invoke.5: bits[32] = invoke(acc, to_apply=square, id=5)
+  ret add.6: bits[32] = add(invoke.5, i, id=6)
+}
+
+top fn main(a: bits[32][4] id=7) -> bits[32] {
+  map.8: bits[32][4] = map(a, to_apply=square, id=8)
+  literal.9: bits[32] = literal(value=0, id=9)
+  array_index.10: bits[32] = array_index(map.8, indices=[literal.9], id=10)
+  ret counted_for.11: bits[32] = counted_for(array_index.10, trip_count=4, stride=1, body=body, id=11)
+}
+
+#[initiation_interval(2)]
+proc counter(st: bits[32] id=12, init={0}) {
+  tkn: token = literal(value=token, id=13)
+  receive.14: (token, bits[32]) = receive(tkn, channel=input_ch, id=14)
+  tuple_index.15: bits[32] = tuple_index(receive.14, index=1, id=15)
+  add.16: bits[32] = add(st, tuple_index.15, id=16)
+  next (add.16)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> serial,
+                           Parser::ParsePackage(input));
+  for (int64_t parallelism : {1, 2, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<Package> parallel,
+        Parser::ParsePackageInParallel(input, parallelism));
+    EXPECT_EQ(parallel->DumpIr(), serial->DumpIr());
+    EXPECT_EQ(parallel->next_node_id(), serial->next_node_id());
+    XLS_ASSERT_OK_AND_ASSIGN(Function * main, parallel->GetTopAsFunction());
+    EXPECT_EQ(main->name(), "main");
+    XLS_ASSERT_OK_AND_ASSIGN(Proc * counter, parallel->GetProc("counter"));
+    EXPECT_EQ(counter->GetInitiationInterval(), 2);
+  }
+}
+
+TEST(IrParserTest, ParsePackageInParallelReportsFirstError) {
+  const std::string input = R"(package test
+
+fn f(x: bits[32]) -> bits[32] {
+  ret neg.1: bits[32] = neg(y)
+}
+
+fn g(x: bits[32]) -> bits[32] {
+  ret invoke.2: bits[32] = invoke(x, to_apply=h)
+}
+
+fn h(x: bits[32]) -> bits[32] {
+  ret identity.3: bits[32] = identity(x)
+}
+)";
+  absl::Status serial = Parser::ParsePackage(input).status();
+  EXPECT_THAT(serial, StatusIs(absl::StatusCode::kInvalidArgument,
+                               HasSubstr("Referred to a name")));
+  EXPECT_EQ(Parser::ParsePackageInParallel(input, 4).status(), serial);
+
+  // Without the first error, calling a function defined later is an error as
+  // it is when parsing serially.
+  std::string later_call = input;
+  later_call.replace(later_call.find("neg(y)"), 6, "neg(x)");
+  serial = Parser::ParsePackage(later_call).status();
+  EXPECT_THAT(serial, StatusIs(absl::StatusCode::kNotFound,
+                               HasSubstr("function with name: \"h\"")));
+  EXPECT_EQ(Parser::ParsePackageInParallel(later_call, 4).status(), serial);
+}
+
 TEST(IrParserTest, TrivialNewStyleProc) {
   const std::string input = R"(package test
 
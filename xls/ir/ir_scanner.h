@@ -16,9 +16,13 @@
 #define XLS_IR_IR_SCANNER_H_
 
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/base/no_destructor.h"
@@ -130,42 +134,143 @@ inline std::ostream& operator<<(std::ostream& os, const Token& token) {
   return os;
 }
 
-// Tokenizes the given string and returns the tokens. It maintains precise
-// source location information.  Right now this is a eager implementation - it
-// tokenizes the whole input. This can be easily changed later to a more demand
-// driven tokenization.
+// Splits IR text into tokens one at a time, maintaining precise source location
+// information.
+class Tokenizer {
+ public:
+  explicit Tokenizer(std::string_view str) : str_(str) {}
+
+  // Tokenizes `str` with positions as if it started at `start`.
+  Tokenizer(std::string_view str, TokenPos start)
+      : str_(str), lineno_(start.lineno), colno_(start.colno) {}
+
+  // Returns the next token, or std::nullopt at the end of the text.
+  absl::StatusOr<std::optional<Token>> Next();
+
+  // Returns the index in the text at which the token most recently returned by
+  // Next() starts.
+  int64_t token_start() const { return token_start_; }
+
+  // Moves back to the given index in the text, which is at position `pos`.
+  void Rewind(int64_t index, TokenPos pos) {
+    index_ = index;
+    lineno_ = pos.lineno;
+    colno_ = pos.colno;
+  }
+
+  // Advances through the text up to and including the '}' which closes the
+  // first '{', without producing tokens. Braces in comments and quoted strings
+  // are ignored. Returns the text from the current index up to this point.
+  absl::StatusOr<std::string_view> SkipThroughClosingBrace();
+
+ private:
+  // Drops all whitespace starting at current index. Returns true if any
+  // whitespace was dropped.
+  bool DropWhiteSpace();
+
+  // Tries to drop an end of line comment starting with "//" at the current
+  // index up to the newline. Returns true an end of line comment was found.
+  bool DropEndOfLineComment();
+
+  // Returns true if the given string matches the substring starting at the
+  // current index in the tokenized string.
+  bool MatchSubstring(std::string_view substr) const;
+
+  // Tries to match a quoted string with the given quote character sequence
+  // (e.g., """). Returns the contents of the quoted string or nullopt if no
+  // quoted string was matched. allow_multine indicates whether a newline
+  // character is allowed in the quoted string.
+  absl::StatusOr<std::optional<std::string_view>> MatchQuotedString(
+      std::string_view quote, bool allow_multiline);
+
+  // Advances the current index into the tokenized string by the given
+  // amount. Updates column and line numbers.
+  int64_t Advance(int64_t amount = 1);
+
+  // Returns whether the current index is at the end of the string.
+  bool EndOfString() const { return index_ >= str_.size(); }
+
+  // Returns the sequence of all characters which satisfy the given test
+  // starting at the current index. Current index is updated to one past the
+  // last matching character. min_chars is the minimum number of characters
+  // which are unconditionally captured.
+  std::string_view CaptureWhile(std::function<bool(char)> test_f,
+                                int64_t min_chars = 0);
+
+  // Returns the character at the current index.
+  char current() const { return str_.at(index_); }
+
+  // Returns the character at the current index + 1, or nullopt if current index
+  // + 1 is beyond the end of the string.
+  std::optional<char> next() const;
+
+  // Returns the current index in the string.
+  int64_t index() const { return index_; }
+
+  // Returns the current line/column number.
+  int64_t lineno() const { return lineno_; }
+  int64_t colno() const { return colno_; }
+
+  // The string being tokenized.
+  std::string_view str_;
+
+  // Current index.
+  int64_t index_ = 0;
+
+  // Index at which the most recently returned token starts.
+  int64_t token_start_ = 0;
+
+  // Line/column number based on the current index.
+  int64_t lineno_ = 0;
+  int64_t colno_ = 0;
+};
+
+// Tokenizes the given string and returns the tokens.
 absl::StatusOr<std::vector<Token>> TokenizeString(std::string_view str);
 
+// A stream of the tokens of IR text. The text is tokenized on demand, so only
+// the tokens peeked at but not yet popped are held in memory, however large
+// the text is. The text must outlive the scanner. If the text cannot be
+// tokenized, the error is returned by the first method which reaches the
+// offending position and needs a token there.
 class Scanner {
  public:
   static absl::StatusOr<Scanner> Create(std::string_view text);
 
+  // Creates a scanner over `text` whose tokens are positioned as if `text`
+  // started at `start`, for example text previously skipped with
+  // SkipBracedDefinition().
+  static absl::StatusOr<Scanner> Create(std::string_view text, TokenPos start);
+
   // Peeks at the next token in the token stream, or returns an error if we're
   // at EOF and no more tokens are available.
   absl::StatusOr<Token> PeekToken() const;
 
   // Return the current token.
   const Token& PeekTokenOrDie() const {
-    CHECK(!AtEof());
-    return tokens_[token_idx_];
+    CHECK(Lookahead(0));
+    return lookahead_.front();
   }
 
   // Returns true if the next token is the given type.
   bool PeekTokenIs(LexicalTokenType target) const {
-    return !AtEof() && PeekTokenOrDie().type() == target;
+    return Lookahead(0) && lookahead_.front().type() == target;
   }
 
   // Returns true if the nth next token is the given type. If `n` is zero this
   // peeks at the immediate next token.
   bool PeekNthTokenIs(int64_t n, LexicalTokenType target) const {
-    return (token_idx_ + n < tokens_.size()) &&
-           tokens_[token_idx_ + n].type() == target;
+    return Lookahead(n) && lookahead_[n].type() == target;
   }
 
   // Pop the current token, advance token pointer to next token.
   Token PopToken() {
-    VLOG(6) << "Popping token: " << tokens_[token_idx_];
-    return tokens_.at(token_idx_++);
+    CHECK(Lookahead(0));
+    VLOG(6) << "Popping token: " << lookahead_.front();
+    Token token = std::move(lookahead_.front());
+    lookahead_.pop_front();
+    lookahead_offsets_.pop_front();
+    return token;
   }
 
   // Same as PopToken() but returns a status error if we are at EOF (in which
@@ -216,14 +321,40 @@ class Scanner {
   // Returns an absl::Status error if we cannot.
   absl::Status DropKeywordOrError(std::string_view keyword);
 
-  // Check if more tokens are available.
-  bool AtEof() const { return token_idx_ >= tokens_.size(); }
+  // Check if more tokens are available. False if the text could not be
+  // tokenized, in which case methods returning a status return the error.
+  bool AtEof() const { return !Lookahead(0) && status_.ok(); }
+
+  // Text skipped by SkipBracedDefinition() and the position at which it
+  // starts.
+  struct SkippedText {
+    std::string_view text;
+    TokenPos start;
+  };
+
+  // Skips the next token and everything after it up to and including the '}'
+  // closing the first '{' (for example, a whole function definition) without
+  // tokenizing it, which is much cheaper than popping the tokens. Braces in
+  // comments and quoted strings are ignored.
+  absl::StatusOr<SkippedText> SkipBracedDefinition();
 
  private:
-  explicit Scanner(std::vector<Token> tokens) : tokens_(tokens) {}
+  explicit Scanner(Tokenizer tokenizer) : tokenizer_(tokenizer) {}
+
+  // Tokenizes until more than `n` tokens are looked ahead at. Returns false if
+  // the text ends or cannot be tokenized first.
+  bool Lookahead(int64_t n) const;
+
+  // Returns the tokenization error, if any, or else `eof_error`.
+  absl::Status EofError(absl::Status eof_error) const {
+    return status_.ok() ? eof_error : status_;
+  }
 
-  int64_t token_idx_ = 0;
-  std::vector<Token> tokens_;
+  mutable Tokenizer tokenizer_;
+  mutable std::deque<Token> lookahead_;
+  // Index in the text of each token in `lookahead_`.
+  mutable std::deque<int64_t> lookahead_offsets_;
+  mutable absl::Status status_;
 };
 
 }  // namespace xls
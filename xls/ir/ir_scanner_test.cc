@@ -15,12 +15,14 @@
 #include "xls/ir/ir_scanner.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/strings/match.h"
 #include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 
@@ -179,5 +181,64 @@ TEST(IrScannerTest, UnterminatedTripleQuotedStrings) {
                HasSubstr("Unterminated quoted string starting at 1:1")));
 }
 
+TEST(IrScannerTest, ScannerTokenizesOnDemand) {
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner scanner, Scanner::Create("a b c $"));
+  EXPECT_TRUE(scanner.PeekNthTokenIs(2, LexicalTokenType::kIdent));
+  EXPECT_EQ(scanner.PopToken().value(), "a");
+  EXPECT_EQ(scanner.PopToken().value(), "b");
+  EXPECT_FALSE(scanner.AtEof());
+  XLS_ASSERT_OK_AND_ASSIGN(Token c, scanner.PopTokenOrError());
+  EXPECT_EQ(c.value(), "c");
+  // The invalid character is only reported once it is reached.
+  EXPECT_FALSE(scanner.PeekTokenIs(LexicalTokenType::kIdent));
+  EXPECT_THAT(scanner.PopTokenOrError(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text")));
+}
+
+TEST(IrScannerTest, SkipBracedDefinition) {
+  std::string_view text = R"(chan c
+fn f(x: bits[1]) -> bits[1] {
+  // A brace in a comment: }
+  t: () = trace(tkn, x, format="{}", data_operands=[])
+  ret y: bits[1] = identity(x)
+}
+fn g)";
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner scanner, Scanner::Create(text));
+  EXPECT_EQ(scanner.PopToken().value(), "chan");
+  EXPECT_EQ(scanner.PopToken().value(), "c");
+  // Look ahead past the start of the definition, as parsers commonly do.
+  EXPECT_TRUE(scanner.PeekNthTokenIs(1, LexicalTokenType::kIdent));
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner::SkippedText skipped,
+                           scanner.SkipBracedDefinition());
+  EXPECT_TRUE(absl::StartsWith(skipped.text, "fn f("));
+  EXPECT_TRUE(absl::EndsWith(skipped.text, "identity(x)\n}"));
+  EXPECT_EQ(skipped.start.lineno, 1);
+  EXPECT_EQ(skipped.start.colno, 0);
+
+  // Scanning continues after the skipped text.
+  EXPECT_EQ(scanner.PopToken().value(), "fn");
+  XLS_ASSERT_OK_AND_ASSIGN(Token g, scanner.PopTokenOrError());
+  EXPECT_EQ(g.value(), "g");
+  EXPECT_EQ(g.pos().lineno, 6);
+  EXPECT_TRUE(scanner.AtEof());
+
+  // The skipped text can be scanned on its own with the original positions.
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner body,
+                           Scanner::Create(skipped.text, skipped.start));
+  EXPECT_EQ(body.PopToken().value(), "fn");
+  XLS_ASSERT_OK_AND_ASSIGN(Token f, body.PopTokenOrError());
+  EXPECT_EQ(f.pos().lineno, 1);
+  EXPECT_EQ(f.pos().colno, 3);
+}
+
+TEST(IrScannerTest, SkipUnterminatedBracedDefinition) {
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner scanner,
+                           Scanner::Create("fn f() { ret x: bits[1] = y"));
+  EXPECT_THAT(scanner.SkipBracedDefinition(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Expected '}' closing definition")));
+}
+
 }  // namespace
 }  // namespace xls
@@ -65,7 +65,14 @@ std::string SanitizeName(
 }  // namespace
 
 std::string NameUniquer::GetSanitizedUniqueName(std::string_view prefix) {
-  std::string root = SanitizeName(prefix, reserved_names_);
+  // Most prefixes are already valid identifiers so only make a sanitized copy
+  // when one is needed.
+  std::string sanitized;
+  std::string_view root = prefix;
+  if (!IsValidIdentifier(prefix) || reserved_names_.contains(prefix)) {
+    sanitized = SanitizeName(prefix, reserved_names_);
+    root = sanitized;
+  }
 
   // Strip away a numeric suffix. For example, grab "foo" from "foo__42". This
   // avoids the possibility of a given prefix (e.g., prefix is "foo__42")
@@ -73,10 +80,10 @@ std::string NameUniquer::GetSanitizedUniqueName(std::string_view prefix) {
   // returns "foo__42")
   std::optional<int64_t> numeric_suffix;
   size_t separator_index = root.rfind(separator_);
-  if (separator_index != std::string::npos) {
-    std::string suffix = root.substr(separator_index + separator_.size());
+  if (separator_index != std::string_view::npos) {
     int64_t i;
-    if (absl::SimpleAtoi(suffix, &i)) {
+    if (absl::SimpleAtoi(root.substr(separator_index + separator_.size()),
+                         &i)) {
       numeric_suffix = i;
       // Remove numeric suffix from root.
       root = root.substr(0, separator_index);
@@ -86,8 +93,9 @@ std::string NameUniquer::GetSanitizedUniqueName(std::string_view prefix) {
   // If the root is empty after stripping off the suffix, use a generic name.
   root = root.empty() ? "name" : root;
 
-  // This will create  a map entry if it does not already exist.
-  PrefixTracker& prefix_tracker = generated_names_[root];
+  // This will create a map entry if it does not already exist.
+  PrefixTracker& prefix_tracker =
+      generated_names_.try_emplace(root).first->second;
 
   SequentialIdGenerator& generator = prefix_tracker.generator;
   if (numeric_suffix.has_value()) {
@@ -102,7 +110,7 @@ std::string NameUniquer::GetSanitizedUniqueName(std::string_view prefix) {
 
   // Root has not been seen before and there is no suffix. Just return it.
   prefix_tracker.bare_prefix_taken = true;
-  return root;
+  return std::string(root);
 }
 
 /* static */ bool NameUniquer::IsValidIdentifier(std::string_view str) {
@@ -64,7 +64,7 @@ class NameUniquer {
     // the next available ID.
     int64_t RegisterId(int64_t id) {
       int64_t result;
-      if (used_.insert(id).second) {
+      if ((id < 1 || id >= next_) && used_.insert(id).second) {
         // ID has not been used before.
         result = id;
       } else {
@@ -73,8 +73,10 @@ class NameUniquer {
         result = next_;
       }
 
-      // Advance next_ to the first unregistered value.
-      while (used_.contains(next_)) {
+      // Advance next_ to the first unregistered value. Every ID in [1, next_)
+      // is known to be used so those need not stay in the set, which keeps it
+      // empty when IDs are handed out in order.
+      while (used_.erase(next_) > 0) {
         ++next_;
       }
 
@@ -88,7 +90,7 @@ class NameUniquer {
     // The next identifier to be tried.
     int64_t next_ = 1;
 
-    // Set of all the identifiers which has been used.
+    // Set of the identifiers outside of [1, next_) which have been used.
     absl::flat_hash_set<int64_t> used_;
   };
 
@@ -101,7 +103,8 @@ class NameUniquer {
   absl::flat_hash_set<std::string> reserved_names_;
 
   // Map from name prefix to the generator data structure which tracks used
-  // identifiers and generates new ones.
+  // identifiers and generates new ones. Looked up by string_view so only new
+  // prefixes allocate.
   struct PrefixTracker {
     // Whether the bare prefix (no numeric suffix) is taken as a name.
     bool bare_prefix_taken = false;
@@ -107,6 +107,18 @@ TEST(NameUniquerTest, CornerCases) {
   EXPECT_EQ("name__5", uniquer.GetSanitizedUniqueName("__2"));
 }
 
+TEST(NameUniquerTest, NonPositiveSuffixes) {
+  NameUniquer uniquer("__");
+  EXPECT_EQ("foo__0", uniquer.GetSanitizedUniqueName("foo__0"));
+  EXPECT_EQ("foo__1", uniquer.GetSanitizedUniqueName("foo__0"));
+  EXPECT_EQ("foo__2", uniquer.GetSanitizedUniqueName("foo__1"));
+  EXPECT_EQ("foo__3", uniquer.GetSanitizedUniqueName("foo__2"));
+  EXPECT_EQ("foo__5", uniquer.GetSanitizedUniqueName("foo__5"));
+  EXPECT_EQ("foo", uniquer.GetSanitizedUniqueName("foo"));
+  EXPECT_EQ("foo__4", uniquer.GetSanitizedUniqueName("foo"));
+  EXPECT_EQ("foo__6", uniquer.GetSanitizedUniqueName("foo"));
+}
+
 TEST(NameUniquerTest, IsValidIdentifier) {
   EXPECT_TRUE(NameUniquer::IsValidIdentifier("foo"));
   EXPECT_TRUE(NameUniquer::IsValidIdentifier("foo_bar"));
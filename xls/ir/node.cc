@@ -15,6 +15,7 @@
 #include "xls/ir/node.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -25,7 +26,10 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
+#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -34,6 +38,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/casts.h"
 #include "xls/common/status/ret_check.h"
@@ -60,11 +65,27 @@ Node::Node(Op op, Type* type, const SourceInfo& loc, std::string_view name,
       id_(function_base_->package()->GetNextNodeIdAndIncrement()),
       op_(op),
       type_(type),
-      loc_(loc),
+      loc_(function_base_->package()->InternSourceInfo(loc)),
       name_(name.empty() ? nullptr
-                         : std::make_unique<std::string>(
+                         : function_base_->package()->InternNodeName(
                                function_base_->UniquifyNodeName(name))) {}
 
+// The users of a node with many users, e.g. a literal or parameter of an
+// unrolled loop, for which keeping `users_` sorted on every change would make
+// replacing or removing all of them quadratic. Users are added to and removed
+// from the hash set in constant time. `users_` is kept up to date as long as
+// users are added in id order and removed from the end, which covers building
+// the graph, and is otherwise marked stale and rebuilt from the set the next
+// time users() is called. users() may be called from several threads at once
+// (e.g. by the verifier), so the rebuild happens under a lock.
+struct Node::LargeUserSet {
+  absl::flat_hash_set<Node*> set;
+  std::atomic<bool> stale = false;
+  absl::Mutex mutex;
+};
+
+Node::~Node() = default;
+
 void Node::AddOperand(Node* operand) {
   VLOG(3) << " Adding operand " << operand->GetName() << " as #"
           << operands_.size() << " operand of " << GetName();
@@ -95,7 +116,29 @@ absl::Status Node::AddNodeToFunctionAndReplace(
   return ReplaceUsesWith(replacement_ptr);
 }
 
+void Node::SwapOperands(int64_t a, int64_t b) {
+  // Operand/user chains already set up properly.
+  std::swap(operands_[a], operands_[b]);
+  function_base_->InvalidateTopoSort();
+  function_base_->RecordChange(this);
+}
+
 void Node::AddUser(Node* user) {
+  function_base_->InvalidateTopoSort();
+  function_base_->RecordChange(this);
+  function_base_->RecordChange(user);
+  if (large_users_ != nullptr) {
+    if (!large_users_->set.insert(user).second) {
+      return;
+    }
+    if (!large_users_->stale && !users_.empty() &&
+        NodeIdLessThan()(users_.back(), user)) {
+      users_.push_back(user);
+    } else {
+      large_users_->stale = true;
+    }
+    return;
+  }
   absl::InlinedVector<Node*, 2>::iterator it;
   if (users_.size() < kSmallUserCount) {
     // Perform a linear search for the insertion point.
@@ -110,9 +153,28 @@ void Node::AddUser(Node* user) {
   if (it == users_.end() || (*it)->id() != user->id()) {
     users_.insert(it, user);
   }
+  if (users_.size() >= kLargeUserCount) {
+    large_users_ = std::make_unique<LargeUserSet>();
+    large_users_->set.insert(users_.begin(), users_.end());
+  }
 }
 
 void Node::RemoveUser(Node* user) {
+  function_base_->InvalidateTopoSort();
+  function_base_->RecordChange(this);
+  function_base_->RecordChange(user);
+  if (large_users_ != nullptr) {
+    if (large_users_->set.erase(user) == 0) {
+      return;
+    }
+    if (!large_users_->stale && users_.back() == user) {
+      users_.pop_back();
+    } else {
+      large_users_->stale = true;
+    }
+    MaybeReleaseLargeUsers();
+    return;
+  }
   absl::InlinedVector<Node*, 2>::iterator it;
   if (users_.size() < kSmallUserCount) {
     it = absl::c_find_if(users_,
@@ -125,6 +187,44 @@ void Node::RemoveUser(Node* user) {
   }
 }
 
+void Node::RemoveUsersIf(absl::FunctionRef<bool(Node*)> predicate) {
+  if (large_users_ == nullptr || !large_users_->stale) {
+    users_.erase(std::remove_if(users_.begin(), users_.end(), predicate),
+                 users_.end());
+  }
+  if (large_users_ != nullptr) {
+    absl::erase_if(large_users_->set, predicate);
+    MaybeReleaseLargeUsers();
+  }
+}
+
+absl::Span<Node* const> Node::LargeUsers() const {
+  if (large_users_->stale.load(std::memory_order_acquire)) {
+    absl::MutexLock lock(&large_users_->mutex);
+    if (large_users_->stale.load(std::memory_order_relaxed)) {
+      RebuildUsers();
+      large_users_->stale.store(false, std::memory_order_release);
+    }
+  }
+  return users_;
+}
+
+void Node::RebuildUsers() const {
+  users_.assign(large_users_->set.begin(), large_users_->set.end());
+  absl::c_sort(users_, NodeIdLessThan());
+}
+
+void Node::MaybeReleaseLargeUsers() {
+  if (large_users_->set.size() >= kLargeUserCount / 2) {
+    return;
+  }
+  if (large_users_->stale) {
+    RebuildUsers();
+  }
+  users_.shrink_to_fit();
+  large_users_.reset();
+}
+
 absl::Status Node::VisitSingleNode(DfsVisitor* visitor) {
   switch (op()) {
     case Op::kAdd:
@@ -469,6 +569,31 @@ bool Node::IsDefinitelyEqualTo(const Node* other) const {
   return same_type(this, other);
 }
 
+uint64_t Node::SignatureHash() const {
+  if (signature_hash_.has_value()) {
+    return *signature_hash_;
+  }
+  // Equal types have the same kind and flat bit count. Hashing these rather
+  // than the type itself avoids walking aggregate types.
+  uint64_t hash =
+      absl::HashOf(op(), GetType()->kind(), GetType()->GetFlatBitCount());
+  switch (op()) {
+    case Op::kLiteral:
+      hash = absl::HashOf(hash, As<Literal>()->value());
+      break;
+    case Op::kBitSlice:
+      hash = absl::HashOf(hash, As<BitSlice>()->start());
+      break;
+    case Op::kTupleIndex:
+      hash = absl::HashOf(hash, As<TupleIndex>()->index());
+      break;
+    default:
+      break;
+  }
+  signature_hash_ = hash;
+  return hash;
+}
+
 std::string Node::GetName() const {
   if (name_ == nullptr) {
     // Return a generated name based on the id.
@@ -486,27 +611,28 @@ std::string_view Node::GetNameView() const {
 
 void Node::SetName(std::string_view name) {
   if (name.empty()) {
-    name_.reset();
+    name_ = nullptr;
   } else {
-    name_ =
-        std::make_unique<std::string>(function_base()->UniquifyNodeName(name));
+    name_ = package()->InternNodeName(function_base()->UniquifyNodeName(name));
   }
 }
 
 void Node::SetNameDirectly(std::string_view name) {
   if (name.empty()) {
-    name_.reset();
+    name_ = nullptr;
   } else {
-    name_ = std::make_unique<std::string>(name);
+    name_ = package()->InternNodeName(name);
   }
 }
 
 void Node::ClearName() {
   CHECK(!Is<Param>());
-  name_.reset();
+  name_ = nullptr;
 }
 
-void Node::SetLoc(const SourceInfo& loc) { loc_ = loc; }
+void Node::SetLoc(const SourceInfo& loc) {
+  loc_ = package()->InternSourceInfo(loc);
+}
 
 std::string Node::ToStringInternal(bool include_operand_types) const {
   std::string ret = absl::StrCat(GetName(), ": ", GetType()->ToString(), " = ",
@@ -751,10 +877,13 @@ std::string Node::GetOperandsString() const {
 }
 
 std::string Node::GetUsersString() const {
-  return absl::StrFormat("[%s]", absl::StrJoin(users_, ", "));
+  return absl::StrFormat("[%s]", absl::StrJoin(users(), ", "));
 }
 
 bool Node::HasUser(const Node* target) const {
+  if (large_users_ != nullptr) {
+    return large_users_->set.contains(target);
+  }
   if (users_.size() < kSmallUserCount) {
     for (const Node* user : users_) {
       if (user->id() == target->id()) {
@@ -802,7 +931,7 @@ void Node::SetId(int64_t id) {
   for (Node* operand : operands()) {
     operand->AddUser(this);
   }
-  package()->set_next_node_id(std::max(id + 1, package()->next_node_id()));
+  package()->RaiseNextNodeId(id + 1);
 }
 
 bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
@@ -818,7 +947,8 @@ bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
   if (this == new_operand) {
     return true;
   }
-  ++package()->transform_metrics().operands_replaced;
+  package()->IncrementTransformMetric(&TransformMetrics::operands_replaced);
+  ++function_base()->transform_metrics().operands_replaced;
   bool did_replace = false;
   for (int64_t i = 0; i < operand_count(); ++i) {
     if (operands_[i] == old_operand) {
@@ -842,7 +972,8 @@ absl::Status Node::ReplaceOperandNumber(int64_t operand_no, Node* new_operand,
         << "old operand type: " << old_operand->GetType()->ToString()
         << " new operand type: " << new_operand->GetType()->ToString();
   }
-  ++package()->transform_metrics().operands_replaced;
+  package()->IncrementTransformMetric(&TransformMetrics::operands_replaced);
+  ++function_base()->transform_metrics().operands_replaced;
 
   // AddUser is idempotent so even if the new operand is already used by this
   // node in another operand slot, it is safe to call.
@@ -866,7 +997,8 @@ absl::Status Node::ReplaceUsesWith(Node* replacement,
   XLS_RET_CHECK(GetType() == replacement->GetType())
       << "type was: " << GetType()->ToString()
       << " replacement: " << replacement->GetType()->ToString();
-  ++package()->transform_metrics().nodes_replaced;
+  package()->IncrementTransformMetric(&TransformMetrics::nodes_replaced);
+  ++function_base()->transform_metrics().nodes_replaced;
   bool all_replaced = true;
   std::vector<Node*> orig_users(users().begin(), users().end());
   for (Node* user : orig_users) {
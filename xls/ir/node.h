@@ -25,6 +25,7 @@
 #include <utility>
 
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -50,7 +51,7 @@ class DfsVisitor;
 // Node is subtyped and can be checked-converted via the As* methods below.
 class Node {
  public:
-  virtual ~Node() = default;
+  virtual ~Node();
 
   // Accepts the visitor, instructing it to visit this node.
   //
@@ -76,7 +77,7 @@ class Node {
   Op op() const { return op_; }
   FunctionBase* function_base() const { return function_base_; }
   Package* package() const;
-  const SourceInfo& loc() const { return loc_; }
+  const SourceInfo& loc() const { return *loc_; }
 
   // Returns the sequence of operands used by this node.
   //
@@ -141,16 +142,22 @@ class Node {
   absl::StatusOr<bool> ReplaceImplicitUsesWith(Node* replacement);
 
   // Swaps the operands at indices 'a' and 'b' in the operands sequence.
-  void SwapOperands(int64_t a, int64_t b) {
-    // Operand/user chains already set up properly.
-    std::swap(operands_[a], operands_[b]);
-  }
+  void SwapOperands(int64_t a, int64_t b);
 
   // Returns true if analysis indicates that this node always produces the
   // same value as 'other' when run with the same operands. The analysis is
   // conservative and false may be returned for some "equivalent" nodes.
   virtual bool IsDefinitelyEqualTo(const Node* other) const;
 
+  // Returns a hash of the properties of this node which IsDefinitelyEqualTo
+  // compares other than its operands: the op, the type, and attributes such as
+  // literal values and slice bounds. Nodes which are definitely equal have
+  // equal signature hashes, so passes looking for equivalent nodes can bucket
+  // by this hash combined with whatever identifies their operands. None of
+  // these properties change after construction so the hash is computed once
+  // and cached.
+  uint64_t SignatureHash() const;
+
   // Returns whether this Op is of the template argument subclass. For example:
   // Is<Param>().
   template <typename OpT>
@@ -229,7 +236,12 @@ class Node {
   };
 
   // Returns the unique set of users of this node sorted by id.
-  absl::Span<Node* const> users() const { return users_; }
+  absl::Span<Node* const> users() const {
+    if (large_users_ == nullptr) {
+      return users_;
+    }
+    return LargeUsers();
+  }
 
   // Helper for querying whether "target" is a user of this node.
   bool HasUser(const Node* target) const;
@@ -256,6 +268,14 @@ class Node {
 
   int64_t id() const { return id_; }
 
+  // Returns the index of this node among the nodes of its function base. The
+  // indices of the nodes of a function base with N nodes are exactly [0, N),
+  // which makes them suitable for indexing per-node storage with a vector.
+  // Removing a node from the function base may change the index of one other
+  // node, so indices should only be relied upon while the function base is not
+  // being modified.
+  int64_t dense_index() const { return dense_index_; }
+
   // Sets the id of the node. Mutates the user sets of the operands of the node
   // because user sets are sorted by id.  Note: this should only be used by the
   // parser and ideally not even there.
@@ -316,18 +336,51 @@ class Node {
   // algorithms on.
   static constexpr int64_t kSmallUserCount = 8;
 
+  // The number of users at which a node starts keeping them in a hash set, see
+  // LargeUserSet. It stops again once it has fewer than half as many.
+  static constexpr int64_t kLargeUserCount = 64;
+
+  struct LargeUserSet;
+
+  // Returns `users_` of a node with a LargeUserSet, rebuilding it if stale.
+  absl::Span<Node* const> LargeUsers() const;
+
+  // Rebuilds `users_` from the LargeUserSet.
+  void RebuildUsers() const;
+
+  // Drops the LargeUserSet if the node no longer has many users.
+  void MaybeReleaseLargeUsers();
+
+  // Removes all users for which `predicate` is true.
+  void RemoveUsersIf(absl::FunctionRef<bool(Node*)> predicate);
+
   FunctionBase* function_base_;
   int64_t id_;
+  // Assigned by FunctionBase when the node is added to it.
+  int64_t dense_index_ = -1;
+  // The change epoch of the function base in which the node was last added or
+  // modified. See FunctionBase::NewChangeEpoch.
+  int64_t change_epoch_ = 0;
+  // Cached result of SignatureHash.
+  mutable std::optional<uint64_t> signature_hash_;
+  // The neighbors of this node in the iteration order of its function base.
+  Node* prev_in_function_base_ = nullptr;
+  Node* next_in_function_base_ = nullptr;
   Op op_;
   Type* type_;
-  SourceInfo loc_;
-  std::unique_ptr<std::string> name_;  // Non-null if name has been assigned.
+  // Interned in the package, see Package::InternSourceInfo.
+  const SourceInfo* loc_;
+  // Interned in the package. Non-null if name has been assigned.
+  const std::string* name_;
 
   // Most nodes have <= 2 operands, so we keep those locally if we can.
   absl::InlinedVector<Node*, 2> operands_;
 
-  // Set of users sorted by node_id for stability.
-  absl::InlinedVector<Node*, 2> users_;
+  // Set of users sorted by node_id for stability. For a node with many users
+  // this is rebuilt on demand from `large_users_`.
+  mutable absl::InlinedVector<Node*, 2> users_;
+  // Non-null while the node has many users.
+  std::unique_ptr<LargeUserSet> large_users_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Node& node) {
@@ -0,0 +1,73 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/topo_sort.h"
+
+namespace xls {
+
+NodeGraph::NodeGraph(FunctionBase* f)
+    : function_base_(f), nodes_(TopoSort(f)) {
+  CHECK_LE(nodes_.size(), std::numeric_limits<NodeIndex>::max());
+  if (nodes_.empty()) {
+    operand_offsets_.push_back(0);
+    user_offsets_.push_back(0);
+    return;
+  }
+
+  int64_t max_node_id = 0;
+  min_node_id_ = std::numeric_limits<int64_t>::max();
+  int64_t operand_count = 0;
+  int64_t user_count = 0;
+  for (Node* node : nodes_) {
+    min_node_id_ = std::min(min_node_id_, node->id());
+    max_node_id = std::max(max_node_id, node->id());
+    operand_count += node->operand_count();
+    user_count += node->users().size();
+  }
+  index_by_id_.resize(max_node_id - min_node_id_ + 1, -1);
+  for (NodeIndex i = 0; i < nodes_.size(); ++i) {
+    index_by_id_[nodes_[i]->id() - min_node_id_] = i;
+  }
+
+  operand_offsets_.reserve(nodes_.size() + 1);
+  operands_.reserve(operand_count);
+  user_offsets_.reserve(nodes_.size() + 1);
+  users_.reserve(user_count);
+  has_implicit_use_.reserve(nodes_.size());
+  for (Node* node : nodes_) {
+    operand_offsets_.push_back(operands_.size());
+    for (Node* operand : node->operands()) {
+      operands_.push_back(index(operand));
+    }
+    user_offsets_.push_back(users_.size());
+    for (Node* user : node->users()) {
+      users_.push_back(index(user));
+    }
+    has_implicit_use_.push_back(f->HasImplicitUse(node));
+  }
+  operand_offsets_.push_back(operands_.size());
+  user_offsets_.push_back(users_.size());
+}
+
+}  // namespace xls
@@ -0,0 +1,101 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_NODE_GRAPH_H_
+#define XLS_IR_NODE_GRAPH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+
+namespace xls {
+
+// A read-only snapshot of the dataflow graph of a function base in compressed
+// sparse row form. Nodes are numbered densely in a topological order so an
+// operand always has a smaller index than its users, and the operands and
+// users of every node are stored as contiguous spans of indices in two flat
+// edge arrays. Analyses can index plain vectors by node index instead of
+// hashing Node pointers and walk the graph without chasing pointers.
+//
+// The snapshot does not track changes to the function base; build a new one
+// after the graph is modified.
+class NodeGraph {
+ public:
+  using NodeIndex = int32_t;
+
+  explicit NodeGraph(FunctionBase* f);
+
+  FunctionBase* function_base() const { return function_base_; }
+  int64_t node_count() const { return nodes_.size(); }
+
+  // The nodes in topological order, i.e., by index.
+  absl::Span<Node* const> nodes() const { return nodes_; }
+  Node* node(NodeIndex index) const { return nodes_[index]; }
+
+  // Returns the index of `node`, which must be a node of the function base
+  // the snapshot was built from.
+  NodeIndex index(const Node* node) const {
+    int64_t slot = node->id() - min_node_id_;
+    DCHECK(slot >= 0 && slot < static_cast<int64_t>(index_by_id_.size()) &&
+           index_by_id_[slot] >= 0)
+        << node->GetName() << " is not in the graph";
+    return index_by_id_[slot];
+  }
+
+  // The indices of the operands of the node at `index`, in operand order. An
+  // operand used more than once appears more than once.
+  absl::Span<const NodeIndex> operands(NodeIndex index) const {
+    return absl::MakeConstSpan(operands_.data() + operand_offsets_[index],
+                               operands_.data() + operand_offsets_[index + 1]);
+  }
+
+  // The indices of the distinct users of the node at `index`, in the order of
+  // Node::users().
+  absl::Span<const NodeIndex> users(NodeIndex index) const {
+    return absl::MakeConstSpan(users_.data() + user_offsets_[index],
+                               users_.data() + user_offsets_[index + 1]);
+  }
+
+  // Whether the node at `index` has an implicit use (see
+  // FunctionBase::HasImplicitUse).
+  bool HasImplicitUse(NodeIndex index) const {
+    return has_implicit_use_[index];
+  }
+
+ private:
+  FunctionBase* function_base_;
+  std::vector<Node*> nodes_;
+
+  // Index of each node by node id offset by `min_node_id_`, or -1 for ids of
+  // nodes not in the function base.
+  int64_t min_node_id_ = 0;
+  std::vector<NodeIndex> index_by_id_;
+
+  // The operands (users) of the node at index i are at positions
+  // [offsets[i], offsets[i + 1]) of the edge array.
+  std::vector<int64_t> operand_offsets_;
+  std::vector<NodeIndex> operands_;
+  std::vector<int64_t> user_offsets_;
+  std::vector<NodeIndex> users_;
+
+  std::vector<bool> has_implicit_use_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_NODE_GRAPH_H_
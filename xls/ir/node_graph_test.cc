@@ -0,0 +1,107 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_graph.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+class NodeGraphTest : public IrTestBase {};
+
+TEST_F(NodeGraphTest, MatchesFunction) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue sum = fb.Add(x, y);
+  BValue square = fb.UMul(sum, sum);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           fb.BuildWithReturnValue(fb.Tuple({square, x})));
+
+  NodeGraph graph(f);
+  ASSERT_EQ(graph.node_count(), f->node_count());
+  for (NodeGraph::NodeIndex i = 0; i < graph.node_count(); ++i) {
+    Node* node = graph.node(i);
+    EXPECT_EQ(graph.index(node), i);
+    ASSERT_EQ(graph.operands(i).size(), node->operand_count());
+    for (int64_t j = 0; j < node->operand_count(); ++j) {
+      EXPECT_EQ(graph.node(graph.operands(i)[j]), node->operand(j));
+      EXPECT_LT(graph.operands(i)[j], i);
+    }
+    std::vector<Node*> users;
+    for (NodeGraph::NodeIndex user : graph.users(i)) {
+      users.push_back(graph.node(user));
+      EXPECT_GT(user, i);
+    }
+    EXPECT_EQ(users, std::vector<Node*>(node->users().begin(),
+                                        node->users().end()));
+    EXPECT_EQ(graph.HasImplicitUse(i), f->HasImplicitUse(node));
+  }
+
+  NodeGraph::NodeIndex s = graph.index(square.node());
+  EXPECT_THAT(graph.operands(s), ElementsAre(graph.index(sum.node()),
+                                             graph.index(sum.node())));
+  EXPECT_THAT(graph.users(graph.index(sum.node())), ElementsAre(s));
+  EXPECT_THAT(graph.users(graph.index(x.node())),
+              UnorderedElementsAre(graph.index(sum.node()),
+                                   graph.index(f->return_value())));
+  EXPECT_THAT(graph.users(graph.index(f->return_value())), IsEmpty());
+  EXPECT_TRUE(graph.HasImplicitUse(graph.index(f->return_value())));
+}
+
+TEST_F(NodeGraphTest, ProcNextValue) {
+  auto p = CreatePackage();
+  ProcBuilder pb(TestName(), p.get());
+  BValue state = pb.StateElement("st", Value(UBits(0, 8)));
+  BValue next = pb.Add(state, pb.Literal(UBits(1, 8)));
+  BValue next_value = pb.Next(state, next);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build());
+
+  NodeGraph graph(proc);
+  EXPECT_EQ(graph.node_count(), proc->node_count());
+  EXPECT_FALSE(graph.HasImplicitUse(graph.index(next.node())));
+  EXPECT_THAT(graph.users(graph.index(next.node())),
+              ElementsAre(graph.index(next_value.node())));
+}
+
+TEST_F(NodeGraphTest, EmptyGraph) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, bb.Build());
+  NodeGraph graph(b);
+  EXPECT_EQ(graph.node_count(), 0);
+  EXPECT_THAT(graph.nodes(), IsEmpty());
+}
+
+}  // namespace
+}  // namespace xls
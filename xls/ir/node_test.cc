@@ -14,6 +14,7 @@
 
 #include "xls/ir/node.h"
 
+#include <cstdint>
 #include <string_view>
 #include <type_traits>
 #include <vector>
@@ -43,6 +44,7 @@ namespace {
 
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
+using ::testing::ElementsAreArray;
 using ::testing::HasSubstr;
 using ::testing::UnorderedElementsAre;
 
@@ -463,6 +465,43 @@ fn ReplaceUses(x: bits[8], y: bits[8]) -> bits[8] {
   EXPECT_TRUE(FindNode("and.1", f)->users().empty());
 }
 
+TEST_F(NodeTest, ManyUsersStaySorted) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  std::vector<BValue> nots;
+  std::vector<Node*> all_users;
+  for (int64_t i = 0; i < 200; ++i) {
+    nots.push_back(fb.Not(x));
+    all_users.push_back(nots.back().node());
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f,
+                           fb.BuildWithReturnValue(fb.Concat(nots)));
+  EXPECT_THAT(x.node()->users(), ElementsAreArray(all_users));
+
+  // Moving every other user to `y` removes users out of order.
+  std::vector<Node*> even_users;
+  std::vector<Node*> odd_users;
+  for (int64_t i = 0; i < all_users.size(); ++i) {
+    if (i % 2 == 0) {
+      even_users.push_back(all_users[i]);
+    } else {
+      odd_users.push_back(all_users[i]);
+      XLS_ASSERT_OK(all_users[i]->ReplaceOperandNumber(0, y.node()));
+    }
+  }
+  EXPECT_THAT(x.node()->users(), ElementsAreArray(even_users));
+  EXPECT_THAT(y.node()->users(), ElementsAreArray(odd_users));
+  EXPECT_TRUE(x.node()->HasUser(all_users[0]));
+  EXPECT_FALSE(x.node()->HasUser(all_users[1]));
+
+  XLS_ASSERT_OK(x.node()->ReplaceUsesWith(y.node()));
+  EXPECT_TRUE(x.node()->users().empty());
+  EXPECT_THAT(y.node()->users(), ElementsAreArray(all_users));
+  XLS_EXPECT_OK(VerifyFunction(f));
+}
+
 TEST_F(NodeTest, ReplaceUsesReturnValue) {
   auto p = CreatePackage();
   XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
@@ -28,12 +28,14 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/node_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -483,6 +485,33 @@ std::string Package::SourceLocationToString(const SourceLocation& loc) {
   return absl::StrFormat("%s:%d", filename, loc.lineno().value());
 }
 
+const SourceInfo* Package::InternSourceInfo(const SourceInfo& loc) {
+  if (loc.Empty()) {
+    return &empty_source_info_;
+  }
+  absl::MutexLock lock(&interned_mutex_);
+  return &*interned_source_infos_.insert(loc).first;
+}
+
+const std::string* Package::InternNodeName(std::string_view name) {
+  absl::MutexLock lock(&interned_mutex_);
+  auto it = interned_node_names_.find(name);
+  if (it == interned_node_names_.end()) {
+    it = interned_node_names_.emplace(name).first;
+  }
+  return &*it;
+}
+
+int64_t Package::interned_source_info_count() const {
+  absl::MutexLock lock(&interned_mutex_);
+  return interned_source_infos_.size();
+}
+
+int64_t Package::interned_node_name_count() const {
+  absl::MutexLock lock(&interned_mutex_);
+  return interned_node_names_.size();
+}
+
 Fileno Package::GetOrCreateFileno(std::string_view filename) {
   // Attempt to add a new fileno/filename pair to the map.
   if (auto it = filename_to_fileno_.find(std::string(filename));
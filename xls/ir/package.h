@@ -15,6 +15,7 @@
 #ifndef XLS_IR_PACKAGE_H_
 #define XLS_IR_PACKAGE_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -24,10 +25,13 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/node_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel.pb.h"
@@ -216,6 +220,18 @@ class Package {
   // increments the next node counter. For use in node construction.
   int64_t GetNextNodeIdAndIncrement() { return next_node_id_++; }
 
+  // Returns a copy of `loc` owned by the package. Nodes refer to their source
+  // locations and names through these interned copies, so nodes sharing a
+  // location or name share its storage and carry only a pointer. Interned
+  // values live as long as the package; renaming a node does not free its old
+  // name.
+  const SourceInfo* InternSourceInfo(const SourceInfo& loc);
+  const std::string* InternNodeName(std::string_view name);
+
+  // The number of distinct source infos and node names interned.
+  int64_t interned_source_info_count() const;
+  int64_t interned_node_name_count() const;
+
   // Adds a file to the file-number table and returns its corresponding number.
   // If it already exists, returns the existing file-number entry.
   Fileno GetOrCreateFileno(std::string_view filename);
@@ -284,6 +300,16 @@ class Package {
   // Intended for use by the parser when node ids are suggested by the IR text.
   void set_next_node_id(int64_t value) { next_node_id_ = value; }
 
+  // Raises the next node id to `value` if it is lower. Unlike a comparison
+  // followed by set_next_node_id, this is safe to call concurrently with node
+  // construction in other function bases.
+  void RaiseNextNodeId(int64_t value) {
+    int64_t current = next_node_id_.load();
+    while (current < value &&
+           !next_node_id_.compare_exchange_weak(current, value)) {
+    }
+  }
+
   // Create a channel. Channels are used with send/receive nodes in communicate
   // between procs or between procs and external (to XLS) components. If no
   // channel ID is specified, a unique channel ID will be automatically
@@ -425,6 +451,14 @@ class Package {
   }
   TransformMetrics& transform_metrics() { return transform_metrics_; }
 
+  // Increments one of the transform metrics. Nodes of different FunctionBases
+  // may be changed concurrently so the increment is atomic.
+  void IncrementTransformMetric(int64_t TransformMetrics::*metric,
+                                int64_t amount = 1) {
+    std::atomic_ref<int64_t>(transform_metrics_.*metric)
+        .fetch_add(amount, std::memory_order_relaxed);
+  }
+
  private:
   std::vector<std::string> GetChannelNames() const;
 
@@ -442,8 +476,19 @@ class Package {
   // Name of this package.
   std::string name_;
 
-  // Ordinal to assign to the next node created in this package.
-  int64_t next_node_id_ = 1;
+  // Ordinal to assign to the next node created in this package. Atomic so that
+  // nodes may be created in different function bases concurrently.
+  std::atomic<int64_t> next_node_id_ = 1;
+
+  // Storage for InternSourceInfo and InternNodeName, guarded by a mutex for the
+  // same reason. Declared before the function bases so that it outlives their
+  // nodes.
+  const SourceInfo empty_source_info_;
+  mutable absl::Mutex interned_mutex_;
+  absl::node_hash_set<SourceInfo> interned_source_infos_
+      ABSL_GUARDED_BY(interned_mutex_);
+  absl::node_hash_set<std::string> interned_node_names_
+      ABSL_GUARDED_BY(interned_mutex_);
 
   std::vector<std::unique_ptr<Function>> functions_;
   std::vector<std::unique_ptr<Proc>> procs_;
@@ -15,6 +15,7 @@
 #include "xls/ir/package.h"
 
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string_view>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "absl/strings/str_cat.h"
 #include "xls/common/casts.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/thread.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel.pb.h"
@@ -33,7 +35,9 @@
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/fileno.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/source_location.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/xls_type.pb.h"
@@ -52,6 +56,32 @@ using ::testing::Property;
 
 class PackageTest : public IrTestBase {};
 
+TEST_F(PackageTest, GetTypesConcurrently) {
+  Package p(TestName());
+  constexpr int64_t kThreadCount = 4;
+  constexpr int64_t kMaxWidth = 300;
+  std::vector<std::vector<Type*>> types(kThreadCount);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t i = 0; i < kThreadCount; ++i) {
+      threads.push_back(std::make_unique<Thread>([&p, &types, i]() {
+        for (int64_t width = 0; width < kMaxWidth; ++width) {
+          BitsType* bits = p.GetBitsType(width);
+          types[i].push_back(bits);
+          types[i].push_back(p.GetArrayType(2, bits));
+          types[i].push_back(p.GetTupleType({bits, bits}));
+        }
+      }));
+    }
+  }
+  for (int64_t i = 1; i < kThreadCount; ++i) {
+    EXPECT_EQ(types[i], types[0]);
+  }
+  EXPECT_EQ(types[0][3 * 7]->AsBitsOrDie()->bit_count(), 7);
+  EXPECT_EQ(types[0][3 * 200], p.GetBitsType(200));
+  EXPECT_TRUE(p.IsOwnedType(types[0][3 * 200 + 2]));
+}
+
 TEST_F(PackageTest, GetBitsTypes) {
   Package p(TestName());
   EXPECT_FALSE(p.IsOwnedType(nullptr));
@@ -1211,6 +1241,43 @@ TEST_F(PackageTest, TransformMetrics) {
   EXPECT_EQ(p->transform_metrics().nodes_removed, 1);
   EXPECT_EQ(p->transform_metrics().nodes_replaced, 1);
   EXPECT_EQ(p->transform_metrics().operands_replaced, 2);
+
+  // Changes to another function are counted by the package but not by `f`.
+  FunctionBuilder other_fb("other", p.get());
+  other_fb.Literal(UBits(1, 32));
+  XLS_ASSERT_OK(other_fb.Build().status());
+
+  EXPECT_EQ(p->transform_metrics().nodes_added, 6);
+  EXPECT_EQ(f->transform_metrics().nodes_added, 5);
+  EXPECT_EQ(f->transform_metrics().nodes_removed, 1);
+  EXPECT_EQ(f->transform_metrics().nodes_replaced, 1);
+  EXPECT_EQ(f->transform_metrics().operands_replaced, 2);
+}
+
+TEST_F(PackageTest, NodeLocationsAndNamesAreInterned) {
+  auto p = CreatePackage();
+  SourceInfo loc(SourceLocation(Fileno(1), Lineno(2), Colno(3)));
+  FunctionBuilder fb(TestName(), p.get());
+  BValue a = fb.Literal(UBits(1, 32), loc, "a");
+  BValue b = fb.Literal(UBits(2, 32), loc);
+  BValue c = fb.Literal(UBits(3, 32));
+  XLS_ASSERT_OK(fb.Build().status());
+  FunctionBuilder other_fb("other", p.get());
+  BValue other_a = other_fb.Literal(UBits(1, 32), loc, "a");
+  XLS_ASSERT_OK(other_fb.Build().status());
+
+  EXPECT_EQ(&a.node()->loc(), &b.node()->loc());
+  EXPECT_EQ(&a.node()->loc(), &other_a.node()->loc());
+  EXPECT_TRUE(c.node()->loc().Empty());
+  EXPECT_EQ(b.node()->loc(), loc);
+  EXPECT_EQ(a.node()->GetNameView().data(),
+            other_a.node()->GetNameView().data());
+  EXPECT_EQ(p->interned_source_info_count(), 1);
+  EXPECT_EQ(p->interned_node_name_count(), 1);
+
+  b.node()->SetLoc(SourceInfo());
+  EXPECT_TRUE(b.node()->loc().Empty());
+  EXPECT_EQ(a.node()->loc(), loc);
 }
 
 }  // namespace
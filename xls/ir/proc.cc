@@ -279,44 +279,87 @@ absl::StatusOr<StateRead*> Proc::ReplaceStateElement(
 }
 
 absl::Status Proc::RemoveStateElement(int64_t index) {
-  XLS_RET_CHECK_LT(index, GetStateElementCount());
-  for (auto& [_, state_element] : state_elements_) {
-    CHECK(absl::c_contains(state_vec_, state_element.get()));
-  }
+  return RemoveStateElements({index});
+}
+
+absl::Status Proc::RemoveStateElements(absl::Span<const int64_t> indices) {
+  const int64_t old_count = GetStateElementCount();
+  XLS_RET_CHECK_EQ(state_elements_.size(), state_vec_.size());
   for (StateElement* state_element : state_vec_) {
-    CHECK(absl::c_any_of(state_elements_, [&](const auto& entry) {
-      return entry.second.get() == state_element;
-    }));
+    auto it = state_elements_.find(state_element->name());
+    XLS_RET_CHECK(it != state_elements_.end() &&
+                  it->second.get() == state_element);
+  }
+
+  std::vector<bool> removed(old_count, false);
+  for (int64_t index : indices) {
+    XLS_RET_CHECK_GE(index, 0);
+    XLS_RET_CHECK_LT(index, old_count);
+    removed[index] = true;
+  }
+
+  // Check every state read before mutating anything so a failure leaves the
+  // proc unchanged.
+  for (int64_t index = 0; index < old_count; ++index) {
+    if (!removed[index]) {
+      continue;
+    }
+    StateRead* state_read = state_reads_.at(state_vec_[index]);
+    if (!state_read->users().empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Cannot remove state element %d of proc %s, existing "
+                          "state read %s has uses",
+                          index, name(), state_read->GetNameView()));
+    }
+  }
+
+  // Map each surviving index to its position after the removal.
+  std::vector<int64_t> new_index(old_count, -1);
+  int64_t new_count = 0;
+  for (int64_t index = 0; index < old_count; ++index) {
+    if (!removed[index]) {
+      new_index[index] = new_count++;
+    }
+  }
+  if (new_count == old_count) {
+    return absl::OkStatus();
   }
 
   // TODO: google/xls#1520 - remove this once fully transitioned over to
   // `next_value` nodes.
-  if (index < GetStateElementCount() - 1) {
-    for (auto& [_, indices] : next_state_indices_) {
-      // Relabel all indices > `index`.
-      auto it = indices.upper_bound(index);
-      absl::btree_set<int64_t> relabeled_indices(indices.begin(), it);
-      for (; it != indices.end(); ++it) {
-        relabeled_indices.insert((*it) - 1);
+  for (auto& [_, next_indices] : next_state_indices_) {
+    absl::btree_set<int64_t> relabeled_indices;
+    for (int64_t index : next_indices) {
+      if (!removed[index]) {
+        relabeled_indices.insert(new_index[index]);
       }
-      indices = std::move(relabeled_indices);
+    }
+    next_indices = std::move(relabeled_indices);
+  }
+
+  std::vector<Node*> new_next_state;
+  std::vector<StateElement*> new_state_vec;
+  std::vector<StateElement*> removed_state_elements;
+  new_next_state.reserve(new_count);
+  new_state_vec.reserve(new_count);
+  removed_state_elements.reserve(old_count - new_count);
+  for (int64_t index = 0; index < old_count; ++index) {
+    if (removed[index]) {
+      removed_state_elements.push_back(state_vec_[index]);
+    } else {
+      new_next_state.push_back(next_state_[index]);
+      new_state_vec.push_back(state_vec_[index]);
     }
   }
-  next_state_indices_[next_state_[index]].erase(index);
-  next_state_.erase(next_state_.begin() + index);
+  next_state_ = std::move(new_next_state);
+  state_vec_ = std::move(new_state_vec);
 
-  StateElement* old_state_element = GetStateElement(index);
-  StateRead* old_state_read = state_reads_.at(old_state_element);
-  if (!old_state_read->users().empty()) {
-    return absl::InvalidArgumentError(
-        absl::StrFormat("Cannot remove state element %d of proc %s, existing "
-                        "state read %s has uses",
-                        index, name(), old_state_read->GetNameView()));
+  for (StateElement* state_element : removed_state_elements) {
+    auto it = state_reads_.find(state_element);
+    XLS_RETURN_IF_ERROR(RemoveNode(it->second));
+    state_reads_.erase(it);
+    state_elements_.erase(state_element->name());
   }
-  XLS_RETURN_IF_ERROR(RemoveNode(old_state_read));
-
-  state_elements_.erase(old_state_element->name());
-  state_vec_.erase(state_vec_.begin() + index);
   return absl::OkStatus();
 }
 
@@ -396,7 +439,8 @@ absl::StatusOr<Proc*> Proc::Clone(
     return n;
   };
 
-  absl::flat_hash_map<Node*, Node*> original_to_clone;
+  // Indexed by the dense index of the original node.
+  std::vector<Node*> original_to_clone(node_count());
   if (target_package == nullptr) {
     target_package = package();
   }
@@ -409,6 +453,7 @@ absl::StatusOr<Proc*> Proc::Clone(
     cloned_proc = target_package->AddProc(
         std::make_unique<Proc>(new_name, target_package));
   }
+  cloned_proc->ReserveNodes(node_count());
   auto remap_state_name = [&](std::string_view orig) -> std::string_view {
     if (!state_name_remapping.contains(orig)) {
       return orig;
@@ -420,7 +465,8 @@ absl::StatusOr<Proc*> Proc::Clone(
                          cloned_proc->AppendStateElement(
                              remap_state_name(GetStateElement(i)->name()),
                              GetStateElement(i)->initial_value()));
-    original_to_clone[state_reads_.at(GetStateElement(i))] = cloned_state_read;
+    original_to_clone[state_reads_.at(GetStateElement(i))->dense_index()] =
+        cloned_state_read;
   }
   if (is_new_style_proc()) {
     for (ChannelReference* channel_ref : interface()) {
@@ -466,10 +512,11 @@ absl::StatusOr<Proc*> Proc::Clone(
     }
   }
 
+  std::vector<Node*> cloned_operands;
   for (Node* node : TopoSort(const_cast<Proc*>(this))) {
-    std::vector<Node*> cloned_operands;
+    cloned_operands.clear();
     for (Node* operand : node->operands()) {
-      cloned_operands.push_back(original_to_clone.at(operand));
+      cloned_operands.push_back(original_to_clone[operand->dense_index()]);
     }
 
     switch (node->op()) {
@@ -480,7 +527,7 @@ absl::StatusOr<Proc*> Proc::Clone(
         Receive* src = node->As<Receive>();
         if (is_new_style_proc()) {
           XLS_ASSIGN_OR_RETURN(
-              original_to_clone[node],
+              original_to_clone[node->dense_index()],
               cloned_proc->MakeNodeWithName<Receive>(
                   src->loc(), cloned_operands[0],
                   cloned_operands.size() == 2
@@ -491,7 +538,7 @@ absl::StatusOr<Proc*> Proc::Clone(
         } else {
           std::string_view channel = new_chan_name(src->channel_name());
           XLS_ASSIGN_OR_RETURN(
-              original_to_clone[node],
+              original_to_clone[node->dense_index()],
               cloned_proc->MakeNodeWithName<Receive>(
                   src->loc(), cloned_operands[0],
                   cloned_operands.size() == 2
@@ -505,7 +552,7 @@ absl::StatusOr<Proc*> Proc::Clone(
         Send* src = node->As<Send>();
         if (is_new_style_proc()) {
           XLS_ASSIGN_OR_RETURN(
-              original_to_clone[node],
+              original_to_clone[node->dense_index()],
               cloned_proc->MakeNodeWithName<Send>(
                   src->loc(), cloned_operands[0], cloned_operands[1],
                   cloned_operands.size() == 3
@@ -515,7 +562,7 @@ absl::StatusOr<Proc*> Proc::Clone(
         } else {
           std::string_view channel = new_chan_name(src->channel_name());
           XLS_ASSIGN_OR_RETURN(
-              original_to_clone[node],
+              original_to_clone[node->dense_index()],
               cloned_proc->MakeNodeWithName<Send>(
                   src->loc(), cloned_operands[0], cloned_operands[1],
                   cloned_operands.size() == 3
@@ -540,7 +587,7 @@ absl::StatusOr<Proc*> Proc::Clone(
               "CountedFor target was not mapped to a function."));
         }
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             cloned_proc->MakeNodeWithName<CountedFor>(
                 src->loc(), cloned_operands[0],
                 absl::Span<Node*>(cloned_operands).subspan(1),
@@ -561,7 +608,7 @@ absl::StatusOr<Proc*> Proc::Clone(
               absl::StrFormat("Map target was not mapped to a function."));
         }
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             cloned_proc->MakeNodeWithName<Map>(src->loc(), cloned_operands[0],
                                                to_apply, src->GetName()));
         break;
@@ -580,7 +627,7 @@ absl::StatusOr<Proc*> Proc::Clone(
               absl::StrFormat("Invoke target was not mapped to a function."));
         }
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             cloned_proc->MakeNodeWithName<Invoke>(src->loc(), cloned_operands,
                                                   to_apply, src->GetName()));
         break;
@@ -588,7 +635,7 @@ absl::StatusOr<Proc*> Proc::Clone(
       // Default clone.
       default: {
         XLS_ASSIGN_OR_RETURN(
-            original_to_clone[node],
+            original_to_clone[node->dense_index()],
             node->CloneInNewFunction(cloned_operands, cloned_proc));
         break;
       }
@@ -599,7 +646,7 @@ absl::StatusOr<Proc*> Proc::Clone(
   // `next_value` nodes.
   for (int64_t i = 0; i < GetStateElementCount(); ++i) {
     XLS_RETURN_IF_ERROR(cloned_proc->SetNextStateElement(
-        i, original_to_clone.at(GetNextStateElement(i))));
+        i, original_to_clone[GetNextStateElement(i)->dense_index()]));
   }
 
   return cloned_proc;
@@ -215,6 +215,13 @@ class Proc : public FunctionBase {
   // index must have no uses.
   absl::Status RemoveStateElement(int64_t index);
 
+  // Removes the state elements at the given indices in a single pass; the
+  // remaining state elements keep their relative order. Duplicate indices are
+  // allowed. The state parameters at the indices must have no uses. This is
+  // linear in the number of state elements, whereas removing the elements one
+  // at a time is quadratic.
+  absl::Status RemoveStateElements(absl::Span<const int64_t> indices);
+
   // Appends a state element with the given name (if possible), next state
   // value, and initial value. If `next_state` is not given then the next state
   // node for this state element is set to the newly created state parameter
@@ -39,6 +39,7 @@
 #include "xls/ir/channel_ops.h"
 #include "xls/ir/elaboration.h"
 #include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc.h"
 #include "xls/ir/proc_instantiation.h"
@@ -149,8 +150,9 @@ ProcInstance::ProcInstance(
 
 absl::StatusOr<ChannelInstance*> ProcInstance::GetChannelInstance(
     std::string_view channel_reference_name) const {
-  if (channel_name_map_.contains(channel_reference_name)) {
-    return channel_name_map_.at(channel_reference_name);
+  auto it = channel_name_map_.find(channel_reference_name);
+  if (it != channel_name_map_.end()) {
+    return it->second;
   }
   return absl::NotFoundError(
       absl::StrFormat("No channel reference named `%s` in proc `%s`",
@@ -217,14 +219,8 @@ absl::Status ProcElaboration::BuildInstanceMaps(ProcInstance* proc_instance) {
 
   for (const std::unique_ptr<ChannelReference>& channel_reference :
        proc_instance->proc()->channel_references()) {
-    XLS_ASSIGN_OR_RETURN(
-        ChannelInstance * channel_instance,
-        proc_instance->GetChannelInstance(channel_reference->name()));
-    channel_instances_by_path_[{std::string{channel_reference->name()},
-                                proc_instance->path().value()}] =
-        channel_instance;
     instances_of_channel_reference_[channel_reference.get()].push_back(
-        channel_instance);
+        proc_instance->GetChannelBinding(channel_reference.get()).instance);
   }
 
   for (const std::unique_ptr<ProcInstance>& subinstance :
@@ -340,14 +336,18 @@ absl::StatusOr<ProcInstance*> ProcElaboration::GetProcInstance(
 
 absl::StatusOr<ChannelInstance*> ProcElaboration::GetChannelInstance(
     std::string_view channel_name, const ProcInstantiationPath& path) const {
-  auto it = channel_instances_by_path_.find({std::string{channel_name}, path});
-  if (it == channel_instances_by_path_.end()) {
+  auto it = proc_instances_by_path_.find(path);
+  absl::StatusOr<ChannelInstance*> channel_instance =
+      it == proc_instances_by_path_.end()
+          ? absl::NotFoundError("")
+          : it->second->GetChannelInstance(channel_name);
+  if (!channel_instance.ok()) {
     return absl::NotFoundError(
         absl::StrFormat("No channel `%s` at instantiation path `%s` in "
                         "elaboration from proc `%s`",
                         channel_name, path.ToString(), top()->proc()->name()));
   }
-  return it->second;
+  return channel_instance;
 }
 
 absl::StatusOr<ChannelInstance*> ProcElaboration::GetChannelInstance(
@@ -459,6 +459,69 @@ absl::StatusOr<ChannelInstance*> ProcElaboration::GetUniqueInstance(
   return instances.front();
 }
 
+absl::StatusOr<std::vector<ProcInstance*>>
+ProcElaboration::GetProcInstancesInDataflowOrder() const {
+  absl::Span<ProcInstance* const> instances = proc_instances();
+  absl::flat_hash_map<ChannelInstance*, std::vector<int64_t>> senders;
+  absl::flat_hash_map<ChannelInstance*, std::vector<int64_t>> receivers;
+  for (int64_t i = 0; i < instances.size(); ++i) {
+    for (Node* node : instances[i]->proc()->nodes()) {
+      if (!node->Is<Send>() && !node->Is<Receive>()) {
+        continue;
+      }
+      XLS_ASSIGN_OR_RETURN(ChannelInstance * channel_instance,
+                           instances[i]->GetChannelInstance(
+                               node->As<ChannelNode>()->channel_name()));
+      // Receives on single-value channels never block.
+      if (channel_instance->channel->kind() != ChannelKind::kStreaming) {
+        continue;
+      }
+      (node->Is<Send>() ? senders : receivers)[channel_instance].push_back(i);
+    }
+  }
+
+  // Kahn's algorithm, always picking the earliest ready instance. When only
+  // cycles remain the earliest remaining instance is picked.
+  std::vector<absl::flat_hash_set<int64_t>> successors(instances.size());
+  std::vector<int64_t> in_degree(instances.size(), 0);
+  for (const auto& [channel_instance, sending] : senders) {
+    auto it = receivers.find(channel_instance);
+    if (it == receivers.end()) {
+      continue;
+    }
+    for (int64_t sender : sending) {
+      for (int64_t receiver : it->second) {
+        if (sender != receiver && successors[sender].insert(receiver).second) {
+          ++in_degree[receiver];
+        }
+      }
+    }
+  }
+  std::vector<ProcInstance*> order;
+  std::vector<bool> placed(instances.size(), false);
+  while (order.size() < instances.size()) {
+    std::optional<int64_t> next;
+    for (int64_t i = 0; i < instances.size(); ++i) {
+      if (placed[i]) {
+        continue;
+      }
+      if (in_degree[i] == 0) {
+        next = i;
+        break;
+      }
+      if (!next.has_value()) {
+        next = i;
+      }
+    }
+    placed[*next] = true;
+    order.push_back(instances[*next]);
+    for (int64_t successor : successors[*next]) {
+      --in_degree[successor];
+    }
+  }
+  return order;
+}
+
 absl::StatusOr<ProcInstantiationPath> ProcElaboration::CreatePath(
     std::string_view path_str) const {
   std::vector<std::string_view> pieces = absl::StrSplit(path_str, "::");
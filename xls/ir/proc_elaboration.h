@@ -198,8 +198,8 @@ class ProcInstance {
   absl::flat_hash_map<ChannelRef, ChannelBinding> channel_bindings_;
 
   // Map from channel reference name to channel instance for all channel
-  // references in the proc.
-  absl::flat_hash_map<std::string, ChannelInstance*> channel_name_map_;
+  // references in the proc. The names are owned by the IR.
+  absl::flat_hash_map<std::string_view, ChannelInstance*> channel_name_map_;
 };
 
 // Data structure representing the elaboration tree.
@@ -258,6 +258,18 @@ class ProcElaboration {
   absl::StatusOr<ProcInstance*> GetUniqueInstance(Proc* proc) const;
   absl::StatusOr<ChannelInstance*> GetUniqueInstance(Channel* channel) const;
 
+  // Returns the proc instances ordered so that the senders on each streaming
+  // channel instance come before its receivers. A serial scheduler ticking the
+  // instances in this order runs a feed-forward network in a single pass
+  // without any receive blocking. Instances in cycles keep their relative order
+  // from proc_instances().
+  //
+  // This only chooses the tick order. Each proc is still compiled and run on
+  // its own, and its sends and receives still go through the runtime's
+  // channel queues.
+  absl::StatusOr<std::vector<ProcInstance*>> GetProcInstancesInDataflowOrder()
+      const;
+
   Package* package() const { return package_; }
 
   // Create path from the given path string serialization. Example input:
@@ -309,12 +321,6 @@ class ProcElaboration {
   absl::flat_hash_map<ProcInstantiationPath, ProcInstance*>
       proc_instances_by_path_;
 
-  // All channel instances in the elaboration indexed by channel reference name
-  // (new style) or channel name (old style) and instantiation path.
-  absl::flat_hash_map<std::pair<std::string, ProcInstantiationPath>,
-                      ChannelInstance*>
-      channel_instances_by_path_;
-
   // List of instances of each Proc/Channel.
   absl::flat_hash_map<Proc*, std::vector<ProcInstance*>> instances_of_proc_;
   absl::flat_hash_map<Channel*, std::vector<ChannelInstance*>>
@@ -27,6 +27,7 @@
 #include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel_ops.h"
 #include "xls/ir/function_builder.h"
@@ -40,6 +41,7 @@ namespace {
 
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::UnorderedElementsAre;
 
@@ -414,5 +416,45 @@ proc2
 proc3)");
 }
 
+TEST_F(ElaborationTest, DataflowOrder) {
+  Package p("package");
+
+  Type* u32 = p.GetBitsType(32);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StreamingChannel * ch1,
+      p.CreateStreamingChannel("ch1", ChannelOps::kSendReceive, u32));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StreamingChannel * ch2,
+      p.CreateStreamingChannel("ch2", ChannelOps::kSendReceive, u32));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StreamingChannel * loop,
+      p.CreateStreamingChannel("loop", ChannelOps::kSendReceive, u32));
+
+  // producer -> middle -> consumer -> echo, created in reverse order. `echo`
+  // also feeds itself through `loop`.
+  TokenlessProcBuilder echo_builder("echo", "tkn", &p);
+  echo_builder.Send(loop, echo_builder.Receive(loop));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * echo, echo_builder.Build({}));
+  TokenlessProcBuilder consumer_builder("consumer", "tkn", &p);
+  consumer_builder.Send(loop, consumer_builder.Receive(ch2));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * consumer, consumer_builder.Build({}));
+  TokenlessProcBuilder middle_builder("middle", "tkn", &p);
+  middle_builder.Send(ch2, middle_builder.Receive(ch1));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * middle, middle_builder.Build({}));
+  TokenlessProcBuilder producer_builder("producer", "tkn", &p);
+  producer_builder.Send(ch1, producer_builder.Literal(UBits(42, 32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * producer, producer_builder.Build({}));
+
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elab,
+                           ProcElaboration::ElaborateOldStylePackage(&p));
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<ProcInstance*> order,
+                           elab.GetProcInstancesInDataflowOrder());
+  std::vector<Proc*> procs;
+  for (ProcInstance* instance : order) {
+    procs.push_back(instance->proc());
+  }
+  EXPECT_THAT(procs, ElementsAre(producer, middle, consumer, echo));
+}
+
 }  // namespace
 }  // namespace xls
@@ -285,6 +285,42 @@ TEST_F(ProcTest, RemoveStateThatStillHasUse) {
                        HasSubstr("state read st has uses")));
 }
 
+TEST_F(ProcTest, RemoveMultipleStateElements) {
+  auto p = CreatePackage();
+  ProcBuilder pb("p", p.get());
+  BValue a = pb.StateElement("a", Value(UBits(1, 32)));
+  pb.StateElement("b", Value(UBits(2, 32)));
+  BValue c = pb.StateElement("c", Value(UBits(3, 32)));
+  pb.StateElement("d", Value(UBits(4, 32)));
+  BValue zero = pb.Literal(UBits(0, 32));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({a, zero, c, zero}));
+
+  XLS_ASSERT_OK(proc->RemoveStateElements({2, 0, 2}));
+  EXPECT_EQ(proc->GetStateElementCount(), 2);
+  EXPECT_EQ(proc->GetStateElement(0)->name(), "b");
+  EXPECT_EQ(proc->GetStateElement(1)->name(), "d");
+  EXPECT_EQ(proc->GetStateRead(1)->GetName(), "d");
+  EXPECT_THAT(proc->GetNextStateIndices(zero.node()), ElementsAre(0, 1));
+  EXPECT_FALSE(proc->GetStateElement("a").ok());
+}
+
+TEST_F(ProcTest, RemoveMultipleStateElementsWithUse) {
+  // Don't call CreatePackage which creates a VerifiedPackage because we
+  // intentionally create a malformed proc.
+  Package p(TestName());
+  ProcBuilder pb("p", &p);
+  BValue x = pb.StateElement("x", Value(UBits(1, 32)));
+  BValue y = pb.StateElement("y", Value(UBits(2, 32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc,
+                           pb.Build({x, pb.Add(pb.Literal(UBits(1, 32)), y)}));
+
+  EXPECT_THAT(proc->RemoveStateElements({0, 1}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("state read y has uses")));
+  EXPECT_EQ(proc->GetStateElementCount(), 2);
+  EXPECT_EQ(proc->GetStateElement(0)->name(), "x");
+}
+
 TEST_F(ProcTest, ReplaceStateWithWrongInitValueType) {
   // Don't call CreatePackage which creates a VerifiedPackage because we
   // intentionally create a malformed proc.
@@ -37,6 +37,7 @@
 #include "xls/data_structures/inline_bitmap.h"
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
@@ -149,6 +150,155 @@ Bits ToKnownBitsValues(TernarySpan ternary_vector) {
   return Bits::FromBitmap(std::move(bitmap));
 }
 
+PackedTernaryVector Pack(TernarySpan ternary_vector) {
+  return PackedTernaryVector{
+      .known_bits = ToKnownBits(ternary_vector),
+      .known_bit_values = ToKnownBitsValues(ternary_vector)};
+}
+
+TernaryVector Unpack(const PackedTernaryVector& packed) {
+  return FromKnownBits(packed.known_bits, packed.known_bit_values);
+}
+
+namespace {
+
+// Returns the bits of `a` which are known to be zero.
+Bits KnownZeros(const PackedTernaryVector& a) {
+  return bits_ops::And(a.known_bits, bits_ops::Not(a.known_bit_values));
+}
+
+// Returns a packed vector with the given known bits and values, clearing the
+// values of the bits which are not known.
+PackedTernaryVector MakePacked(Bits known_bits, const Bits& values) {
+  Bits known_bit_values = bits_ops::And(values, known_bits);
+  return PackedTernaryVector{.known_bits = std::move(known_bits),
+                             .known_bit_values = std::move(known_bit_values)};
+}
+
+}  // namespace
+
+PackedTernaryVector Not(const PackedTernaryVector& a) {
+  return MakePacked(a.known_bits, bits_ops::Not(a.known_bit_values));
+}
+
+PackedTernaryVector And(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  CHECK_EQ(a.bit_count(), b.bit_count());
+  // Known if both bits are known or either is a known zero.
+  return PackedTernaryVector{
+      .known_bits = bits_ops::Or(bits_ops::And(a.known_bits, b.known_bits),
+                                 bits_ops::Or(KnownZeros(a), KnownZeros(b))),
+      .known_bit_values = bits_ops::And(a.known_bit_values, b.known_bit_values),
+  };
+}
+
+PackedTernaryVector Or(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b) {
+  CHECK_EQ(a.bit_count(), b.bit_count());
+  // Known if both bits are known or either is a known one.
+  Bits ones = bits_ops::Or(a.known_bit_values, b.known_bit_values);
+  return PackedTernaryVector{
+      .known_bits =
+          bits_ops::Or(bits_ops::And(a.known_bits, b.known_bits), ones),
+      .known_bit_values = ones,
+  };
+}
+
+PackedTernaryVector Xor(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  CHECK_EQ(a.bit_count(), b.bit_count());
+  return MakePacked(bits_ops::And(a.known_bits, b.known_bits),
+                    bits_ops::Xor(a.known_bit_values, b.known_bit_values));
+}
+
+PackedTernaryVector Add(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  CHECK_EQ(a.bit_count(), b.bit_count());
+  // The largest and smallest possible sums. A bit of the sum is known if the
+  // bits of both operands are known and so is the carry into it, which is the
+  // case when the carries into the bit of both extreme sums agree.
+  Bits a_zeros = KnownZeros(a);
+  Bits b_zeros = KnownZeros(b);
+  Bits max_sum = bits_ops::Add(bits_ops::Not(a_zeros), bits_ops::Not(b_zeros));
+  Bits min_sum = bits_ops::Add(a.known_bit_values, b.known_bit_values);
+  Bits max_carries =
+      bits_ops::Xor(max_sum, bits_ops::Xor(bits_ops::Not(a_zeros),
+                                           bits_ops::Not(b_zeros)));
+  Bits min_carries = bits_ops::Xor(
+      min_sum, bits_ops::Xor(a.known_bit_values, b.known_bit_values));
+  Bits known_carries = bits_ops::Not(bits_ops::Xor(max_carries, min_carries));
+  return MakePacked(
+      bits_ops::And(bits_ops::And(a.known_bits, b.known_bits), known_carries),
+      min_sum);
+}
+
+TernaryValue Equals(const PackedTernaryVector& a,
+                    const PackedTernaryVector& b) {
+  CHECK_EQ(a.bit_count(), b.bit_count());
+  Bits both_known = bits_ops::And(a.known_bits, b.known_bits);
+  if (!bits_ops::And(both_known, bits_ops::Xor(a.known_bit_values,
+                                               b.known_bit_values))
+           .IsZero()) {
+    return TernaryValue::kKnownZero;
+  }
+  return both_known.IsAllOnes() ? TernaryValue::kKnownOne
+                                : TernaryValue::kUnknown;
+}
+
+TernaryValue ULessThan(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b) {
+  CHECK_EQ(a.bit_count(), b.bit_count());
+  // Compare the extreme values of the operands.
+  Bits a_max = bits_ops::Or(a.known_bit_values, bits_ops::Not(a.known_bits));
+  Bits b_max = bits_ops::Or(b.known_bit_values, bits_ops::Not(b.known_bits));
+  if (bits_ops::ULessThan(a_max, b.known_bit_values)) {
+    return TernaryValue::kKnownOne;
+  }
+  if (bits_ops::UGreaterThanOrEqual(a.known_bit_values, b_max)) {
+    return TernaryValue::kKnownZero;
+  }
+  return TernaryValue::kUnknown;
+}
+
+PackedTernaryVector ShiftLeftLogical(const PackedTernaryVector& a,
+                                     int64_t amount) {
+  amount = std::min(amount, a.bit_count());
+  // The shifted-in zeros are known.
+  return PackedTernaryVector{
+      .known_bits = bits_ops::Or(
+          bits_ops::ShiftLeftLogical(a.known_bits, amount),
+          bits_ops::ZeroExtend(Bits::AllOnes(amount), a.bit_count())),
+      .known_bit_values =
+          bits_ops::ShiftLeftLogical(a.known_bit_values, amount),
+  };
+}
+
+PackedTernaryVector ShiftRightLogical(const PackedTernaryVector& a,
+                                      int64_t amount) {
+  amount = std::min(amount, a.bit_count());
+  return PackedTernaryVector{
+      .known_bits = bits_ops::Or(
+          bits_ops::ShiftRightLogical(a.known_bits, amount),
+          bits_ops::ShiftLeftLogical(Bits::AllOnes(a.bit_count()),
+                                     a.bit_count() - amount)),
+      .known_bit_values =
+          bits_ops::ShiftRightLogical(a.known_bit_values, amount),
+  };
+}
+
+PackedTernaryVector ShiftRightArith(const PackedTernaryVector& a,
+                                    int64_t amount) {
+  if (a.bit_count() == 0) {
+    return a;
+  }
+  // Copies of the sign bit are known iff the sign bit is.
+  amount = std::min(amount, a.bit_count());
+  return PackedTernaryVector{
+      .known_bits = bits_ops::ShiftRightArith(a.known_bits, amount),
+      .known_bit_values = bits_ops::ShiftRightArith(a.known_bit_values, amount),
+  };
+}
+
 std::optional<TernaryVector> Difference(TernarySpan lhs, TernarySpan rhs) {
   CHECK_EQ(lhs.size(), rhs.size());
   const int64_t size = lhs.size();
@@ -70,8 +70,49 @@ inline std::ostream& operator<<(std::ostream& os, TernarySpan vector) {
   return os;
 }
 
+// A ternary vector packed into two bit vectors: bit `i` is known iff bit `i` of
+// `known_bits` is set, in which case its value is bit `i` of
+// `known_bit_values`. Bits of `known_bit_values` which are not known are zero.
+// Operations on packed vectors work a machine word at a time rather than a
+// ternary value at a time.
+struct PackedTernaryVector {
+  Bits known_bits;
+  Bits known_bit_values;
+
+  int64_t bit_count() const { return known_bits.bit_count(); }
+};
+
 namespace ternary_ops {
 
+// Conversions between the packed and unpacked representations.
+PackedTernaryVector Pack(TernarySpan ternary_vector);
+TernaryVector Unpack(const PackedTernaryVector& packed);
+
+// Word-parallel ternary operations on packed vectors. Each result is as
+// precise as possible given that the bits of the operands are independent.
+// CHECK fails if the operands have different widths.
+PackedTernaryVector Not(const PackedTernaryVector& a);
+PackedTernaryVector And(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+PackedTernaryVector Or(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b);
+PackedTernaryVector Xor(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+PackedTernaryVector Add(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+TernaryValue Equals(const PackedTernaryVector& a, const PackedTernaryVector& b);
+TernaryValue ULessThan(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b);
+
+// Shifts by a constant amount; amounts of at least the width of `a` shift out
+// every bit.
+PackedTernaryVector ShiftLeftLogical(const PackedTernaryVector& a,
+                                     int64_t amount);
+PackedTernaryVector ShiftRightLogical(const PackedTernaryVector& a,
+                                      int64_t amount);
+PackedTernaryVector ShiftRightArith(const PackedTernaryVector& a,
+                                    int64_t amount);
+
 // Returns a vector with known bits as represented in `known_bits`, with values
 // as given in `known_bits_values`.
 TernaryVector FromKnownBits(const Bits& known_bits,
@@ -75,6 +75,42 @@ TEST(Ternary, NumberOfKnownBits) {
   EXPECT_EQ(ternary_ops::NumberOfKnownBits(TernaryVector()), 0);
 }
 
+TEST(Ternary, PackedOps) {
+  auto packed = [](std::string_view s) {
+    return ternary_ops::Pack(*StringToTernaryVector(s));
+  };
+  EXPECT_EQ(ternary_ops::Unpack(packed("0b10X1_X0X1")),
+            *StringToTernaryVector("0b10X1_X0X1"));
+  EXPECT_EQ(ternary_ops::Unpack(
+                ternary_ops::And(packed("0b01X1X"), packed("0bX0X11"))),
+            *StringToTernaryVector("0b00X1X"));
+  EXPECT_EQ(ternary_ops::Unpack(
+                ternary_ops::Or(packed("0b01X0X"), packed("0bX0X01"))),
+            *StringToTernaryVector("0bX1X01"));
+  EXPECT_EQ(ternary_ops::Unpack(
+                ternary_ops::Xor(packed("0b01X1X"), packed("0b110X1"))),
+            *StringToTernaryVector("0b10XXX"));
+  EXPECT_EQ(ternary_ops::Unpack(ternary_ops::Not(packed("0b01X"))),
+            *StringToTernaryVector("0b10X"));
+  // The carry out of the unknown low bit is zero since the other operand's
+  // low bit is zero.
+  EXPECT_EQ(ternary_ops::Unpack(
+                ternary_ops::Add(packed("0b011X"), packed("0b0010"))),
+            *StringToTernaryVector("0b100X"));
+  EXPECT_EQ(ternary_ops::Equals(packed("0b1X"), packed("0b0X")),
+            TernaryValue::kKnownZero);
+  EXPECT_EQ(ternary_ops::Equals(packed("0b1X"), packed("0b11")),
+            TernaryValue::kUnknown);
+  EXPECT_EQ(ternary_ops::ULessThan(packed("0b0XX"), packed("0b1XX")),
+            TernaryValue::kKnownOne);
+  EXPECT_EQ(ternary_ops::Unpack(
+                ternary_ops::ShiftRightArith(packed("0bX01X"), 2)),
+            *StringToTernaryVector("0bXXX0"));
+  EXPECT_EQ(ternary_ops::Unpack(
+                ternary_ops::ShiftLeftLogical(packed("0bX01X"), 5)),
+            *StringToTernaryVector("0b0000"));
+}
+
 MATCHER_P(ToVector, m,
           testing::DescribeMatcher<std::vector<Bits>>(m, negation)) {
   return testing::ExplainMatchResult(
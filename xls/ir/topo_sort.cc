@@ -32,7 +32,9 @@
 
 namespace xls {
 
-std::vector<Node*> ReverseTopoSort(FunctionBase* f) {
+namespace {
+
+std::vector<Node*> ComputeReverseTopoSort(FunctionBase* f) {
   // For topological traversal we only add nodes to the order when all of its
   // users have been scheduled.
   //
@@ -155,10 +157,20 @@ std::vector<Node*> ReverseTopoSort(FunctionBase* f) {
   return ordered;
 }
 
+}  // namespace
+
+std::vector<Node*> ReverseTopoSort(FunctionBase* f) {
+  absl::MutexLock lock(&f->topo_sort_mutex_);
+  if (!f->topo_sort_valid_.load(std::memory_order_relaxed)) {
+    f->reverse_topo_sort_ = ComputeReverseTopoSort(f);
+    f->topo_sort_valid_.store(true, std::memory_order_relaxed);
+  }
+  return f->reverse_topo_sort_;
+}
+
 std::vector<Node*> TopoSort(FunctionBase* f) {
-  std::vector<Node*> ordered = ReverseTopoSort(f);
-  std::reverse(ordered.begin(), ordered.end());
-  return ordered;
+  std::vector<Node*> reversed = ReverseTopoSort(f);
+  return std::vector<Node*>(reversed.rbegin(), reversed.rend());
 }
 
 }  // namespace xls
@@ -288,6 +288,36 @@ TEST(NodeIteratorTest, RpoVsTopo) {
 
 // LINT.ThenChange(//xls/ir/block_elaboration_test.cc)
 
+TEST(NodeIteratorTest, CachedOrderTracksGraphChanges) {
+  Package p("p");
+  Function f("f", &p);
+  SourceInfo loc;
+  XLS_ASSERT_OK_AND_ASSIGN(Node * a,
+                           f.MakeNode<Literal>(loc, Value(UBits(1, 8))));
+  XLS_ASSERT_OK_AND_ASSIGN(Node * b,
+                           f.MakeNode<Literal>(loc, Value(UBits(2, 8))));
+  XLS_ASSERT_OK_AND_ASSIGN(Node * sub,
+                           f.MakeNode<BinOp>(loc, a, b, Op::kSub));
+  XLS_ASSERT_OK(f.set_return_value(sub));
+  EXPECT_EQ(TopoSort(&f), std::vector<Node*>({a, b, sub}));
+  // Sorting an unchanged graph gives the same order.
+  EXPECT_EQ(TopoSort(&f), std::vector<Node*>({a, b, sub}));
+
+  // Operands are visited in order so swapping them changes the order.
+  sub->SwapOperands(0, 1);
+  EXPECT_EQ(TopoSort(&f), std::vector<Node*>({b, a, sub}));
+
+  XLS_ASSERT_OK_AND_ASSIGN(Node * neg, f.MakeNode<UnOp>(loc, sub, Op::kNeg));
+  XLS_ASSERT_OK(f.set_return_value(neg));
+  EXPECT_EQ(TopoSort(&f), std::vector<Node*>({b, a, sub, neg}));
+
+  XLS_ASSERT_OK(neg->ReplaceOperandNumber(0, a));
+  XLS_ASSERT_OK(f.RemoveNode(sub));
+  XLS_ASSERT_OK(f.RemoveNode(b));
+  EXPECT_EQ(TopoSort(&f), std::vector<Node*>({a, neg}));
+  EXPECT_EQ(ReverseTopoSort(&f), std::vector<Node*>({neg, a}));
+}
+
 void BM_TopoSortBinaryTree(benchmark::State& state) {
   std::unique_ptr<VerifiedPackage> p =
       std::make_unique<VerifiedPackage>("balanced_tree_pkg");
@@ -15,6 +15,8 @@
 #ifndef XLS_IR_TYPE_MANAGER_H_
 #define XLS_IR_TYPE_MANAGER_H_
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -24,6 +26,7 @@
 #include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
@@ -31,8 +34,19 @@
 
 namespace xls {
 
+// Owns the types of a package. Types are interned: structurally equal types
+// are the same object, so they can be compared by pointer.
+//
+// All methods are thread-safe so that passes may run on different function
+// bases of the package concurrently. Lookups of existing types only take a
+// shared lock, and bits types narrower than kSmallBitsTypeCount, which make
+// up most lookups, are found without locking at all.
 class TypeManager {
  public:
+  // Bits types of fewer bits than this are cached in a directly indexed
+  // table.
+  static constexpr int64_t kSmallBitsTypeCount = 129;
+
   explicit TypeManager();
 
   // Type manager is move-only.
@@ -42,9 +56,11 @@ class TypeManager {
   TypeManager& operator=(const TypeManager&) = delete;
   // Returns whether the given type is one of the types owned by this package.
   bool IsOwnedType(const Type* type) const {
+    absl::ReaderMutexLock lock(mutex_.get());
     return owned_types_.find(type) != owned_types_.end();
   }
   bool IsOwnedFunctionType(const FunctionType* function_type) const {
+    absl::ReaderMutexLock lock(mutex_.get());
     return owned_function_types_.find(function_type) !=
            owned_function_types_.end();
   }
@@ -67,6 +83,22 @@ class TypeManager {
   Type* GetTypeForValue(const Value& value);
 
  private:
+  bool IsOwnedTypeLocked(const Type* type) const
+      ABSL_SHARED_LOCKS_REQUIRED(*mutex_) {
+    return owned_types_.find(type) != owned_types_.end();
+  }
+
+  // Guards the maps below. Held by pointer to keep the manager movable.
+  std::unique_ptr<absl::Mutex> mutex_ = std::make_unique<absl::Mutex>();
+
+  // The bits types of each width below kSmallBitsTypeCount, or null if not
+  // created yet. Entries are written once under `mutex_` and read without it.
+  // Held by pointer to keep the manager movable.
+  using SmallBitsTypes =
+      std::array<std::atomic<BitsType*>, kSmallBitsTypeCount>;
+  std::unique_ptr<SmallBitsTypes> small_bits_types_ =
+      std::make_unique<SmallBitsTypes>();
+
   // Set of owned types in this package.
   absl::flat_hash_set<const Type*> owned_types_;
 
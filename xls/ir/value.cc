@@ -16,12 +16,14 @@
 
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/no_destructor.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -252,13 +254,41 @@ void Value::FlattenTo(BitPushBuffer* buffer) const {
   LOG(FATAL) << "Invalid value kind: " << ValueKindToString(kind_);
 }
 
+/* static */ Value::Elements Value::EmptyElements() {
+  static const absl::NoDestructor<Elements> kEmpty(
+      std::make_shared<const std::vector<Value>>());
+  return *kEmpty;
+}
+
 absl::StatusOr<std::vector<Value>> Value::GetElements() const {
-  if (!std::holds_alternative<std::vector<Value>>(payload_)) {
+  if (!std::holds_alternative<Elements>(payload_)) {
     return absl::InvalidArgumentError("Value does not hold elements.");
   }
   return std::vector<Value>(elements().begin(), elements().end());
 }
 
+absl::StatusOr<Value> Value::UpdateElement(absl::Span<const int64_t> index,
+                                           Value new_element) const {
+  if (index.empty()) {
+    XLS_RET_CHECK(SameTypeAs(new_element))
+        << "Cannot replace " << ToString() << " with " << new_element.ToString();
+    return new_element;
+  }
+  if (kind() != ValueKind::kTuple && kind() != ValueKind::kArray) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Cannot update an element of %s", ToString()));
+  }
+  XLS_RET_CHECK_GE(index.front(), 0);
+  XLS_RET_CHECK_LT(index.front(), size());
+  XLS_ASSIGN_OR_RETURN(
+      Value updated_element,
+      element(index.front())
+          .UpdateElement(index.subspan(1), std::move(new_element)));
+  std::vector<Value> new_elements(elements().begin(), elements().end());
+  new_elements[index.front()] = std::move(updated_element);
+  return Value(kind(), std::move(new_elements));
+}
+
 absl::StatusOr<Bits> Value::GetBitsWithStatus() const {
   if (!IsBits()) {
     return absl::InvalidArgumentError(
@@ -468,6 +498,9 @@ bool Value::operator==(const Value& other) const {
   }
 
   // All non-Bits types are container types -- should have a size attribute.
+  if (std::get<Elements>(payload_) == std::get<Elements>(other.payload_)) {
+    return true;
+  }
   if (size() != other.size()) {
     return false;
   }
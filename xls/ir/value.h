@@ -17,6 +17,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -68,7 +69,7 @@ class Value {
     return Value(ValueKind::kTuple, elements);
   }
   static Value TupleOwned(std::vector<Value>&& elements) {
-    return Value(ValueKind::kTuple, elements);
+    return Value(ValueKind::kTuple, std::move(elements));
   }
 
   // All members of "elements" must be of the same type, or an error status will
@@ -106,9 +107,7 @@ class Value {
     return Value(ValueKind::kArray, std::move(elements));
   }
 
-  static Value Token() {
-    return Value(ValueKind::kToken, std::vector<Value>({}));
-  }
+  static Value Token() { return Value(ValueKind::kToken, EmptyElements()); }
   static Value Bool(bool enabled) {
     return Value(
         UBits(/*value=*/static_cast<uint64_t>(enabled), /*bit_count=*/1));
@@ -119,6 +118,24 @@ class Value {
   explicit Value(Bits bits)
       : kind_(ValueKind::kBits), payload_(std::move(bits)) {}
 
+  Value(const Value& other) = default;
+  Value& operator=(const Value& other) = default;
+
+  // A moved-from tuple, array or token is left without elements rather than
+  // without element storage, so that it can still be inspected and compared.
+  Value(Value&& other) noexcept
+      : kind_(other.kind_), payload_(std::move(other.payload_)) {
+    other.ResetMovedFromElements();
+  }
+  Value& operator=(Value&& other) noexcept {
+    if (this != &other) {
+      kind_ = other.kind_;
+      payload_ = std::move(other.payload_);
+      other.ResetMovedFromElements();
+    }
+    return *this;
+  }
+
   // Convert a ValueProto back to a value.
   //
   // If any bits element has a bit-count of more than max_bit_size the
@@ -146,12 +163,20 @@ class Value {
   absl::StatusOr<std::vector<Value>> GetElements() const;
 
   absl::Span<const Value> elements() const {
-    return std::get<std::vector<Value>>(payload_);
+    return *std::get<Elements>(payload_);
   }
   const Value& element(int64_t i) const { return elements().at(i); }
   int64_t size() const { return elements().size(); }
   bool empty() const { return elements().empty(); }
 
+  // Returns a copy of this tuple or array with the element at `index`
+  // replaced by `new_element`. `index` is a path of element indices, outermost
+  // first; an empty path replaces the entire value. `new_element` must have
+  // the type of the element it replaces. Only the aggregates along the path
+  // are copied, the storage of all other elements is shared with this value.
+  absl::StatusOr<Value> UpdateElement(absl::Span<const int64_t> index,
+                                      Value new_element) const;
+
   // Returns the total number of bits in this value.
   int64_t GetFlatBitCount() const;
 
@@ -193,19 +218,47 @@ class Value {
 
   template <typename H>
   friend H AbslHashValue(H h, const Value& v) {
-    return H::combine(std::move(h), v.kind_, v.payload_);
+    if (v.IsBits()) {
+      return H::combine(std::move(h), v.kind_, v.bits());
+    }
+    if (std::holds_alternative<Elements>(v.payload_)) {
+      return H::combine(std::move(h), v.kind_, v.elements());
+    }
+    return H::combine(std::move(h), v.kind_);
   }
 
  private:
+  // The elements of a tuple, array or token. The storage is immutable and
+  // shared between copies of the value so copying an aggregate does not copy
+  // its elements.
+  using Elements = std::shared_ptr<const std::vector<Value>>;
+
   Value(ValueKind kind, absl::Span<const Value> elements)
       : kind_(kind),
-        payload_(std::vector<Value>(elements.begin(), elements.end())) {}
+        payload_(std::make_shared<const std::vector<Value>>(elements.begin(),
+                                                            elements.end())) {}
 
   Value(ValueKind kind, std::vector<Value>&& elements)
+      : kind_(kind),
+        payload_(std::make_shared<const std::vector<Value>>(std::move(elements))) {
+  }
+
+  Value(ValueKind kind, Elements elements)
       : kind_(kind), payload_(std::move(elements)) {}
 
+  // Returns the shared storage for an empty element list.
+  static Elements EmptyElements();
+
+  // Points the storage of a moved-from aggregate at EmptyElements().
+  void ResetMovedFromElements() {
+    if (Elements* elements = std::get_if<Elements>(&payload_);
+        elements != nullptr && *elements == nullptr) {
+      *elements = EmptyElements();
+    }
+  }
+
   ValueKind kind_;
-  std::variant<std::nullptr_t, std::vector<Value>, Bits> payload_;
+  std::variant<std::nullptr_t, Elements, Bits> payload_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Value& value) {
@@ -16,10 +16,12 @@
 
 #include <cstdint>
 #include <string_view>
+#include <utility>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/common/fuzzing/fuzztest.h"
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/types/span.h"
@@ -82,6 +84,55 @@ TEST(ValueTest, ToString) {
   EXPECT_EQ(token_value.ToHumanString(), "token");
 }
 
+TEST(ValueTest, UpdateElement) {
+  XLS_ASSERT_OK_AND_ASSIGN(Value row, Value::UBitsArray({1, 2, 3}, 8));
+  XLS_ASSERT_OK_AND_ASSIGN(Value matrix, Value::Array({row, row}));
+  Value tuple = Value::Tuple({matrix, Value(UBits(7, 4))});
+
+  XLS_ASSERT_OK_AND_ASSIGN(Value new_row, Value::UBitsArray({1, 5, 3}, 8));
+  XLS_ASSERT_OK_AND_ASSIGN(Value new_matrix, Value::Array({row, new_row}));
+  EXPECT_THAT(tuple.UpdateElement({0, 1, 1}, Value(UBits(5, 8))),
+              IsOkAndHolds(Value::Tuple({new_matrix, Value(UBits(7, 4))})));
+  EXPECT_THAT(tuple.UpdateElement({1}, Value(UBits(2, 4))),
+              IsOkAndHolds(Value::Tuple({matrix, Value(UBits(2, 4))})));
+  EXPECT_THAT(matrix.UpdateElement({}, new_matrix), IsOkAndHolds(new_matrix));
+
+  // The original value is unchanged.
+  EXPECT_EQ(tuple, Value::Tuple({matrix, Value(UBits(7, 4))}));
+
+  EXPECT_FALSE(tuple.UpdateElement({1}, Value(UBits(2, 5))).ok());
+  EXPECT_FALSE(tuple.UpdateElement({2}, Value(UBits(2, 4))).ok());
+  EXPECT_FALSE(Value(UBits(2, 4)).UpdateElement({0}, Value(UBits(1, 1))).ok());
+}
+
+TEST(ValueTest, CopiesCompareAndHashEqual) {
+  XLS_ASSERT_OK_AND_ASSIGN(Value array, Value::UBitsArray({1, 2, 3}, 8));
+  Value copy = array;
+  XLS_ASSERT_OK_AND_ASSIGN(Value rebuilt, Value::UBitsArray({1, 2, 3}, 8));
+  EXPECT_EQ(array, copy);
+  EXPECT_EQ(array, rebuilt);
+  EXPECT_EQ(absl::HashOf(array), absl::HashOf(rebuilt));
+  EXPECT_EQ(absl::HashOf(Value::Token()), absl::HashOf(Value::Token()));
+}
+
+TEST(ValueTest, MovedFromAggregateHasNoElements) {
+  Value tuple = Value::Tuple({Value(UBits(1, 8)), Value(UBits(2, 8))});
+  Value moved = std::move(tuple);
+  EXPECT_EQ(moved.size(), 2);
+  // NOLINTBEGIN(bugprone-use-after-move)
+  EXPECT_TRUE(tuple.IsTuple());
+  EXPECT_TRUE(tuple.elements().empty());
+  EXPECT_EQ(tuple.size(), 0);
+  EXPECT_EQ(tuple, Value::Tuple({}));
+  EXPECT_EQ(tuple.ToString(), "()");
+
+  Value assigned;
+  assigned = std::move(moved);
+  EXPECT_EQ(assigned.size(), 2);
+  EXPECT_TRUE(moved.empty());
+  // NOLINTEND(bugprone-use-after-move)
+}
+
 TEST(ValueTest, SameTypeAs) {
   Value b1(UBits(42, 33));
   Value b2(UBits(42, 10));
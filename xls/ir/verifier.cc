@@ -15,6 +15,7 @@
 #include "xls/ir/verifier.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -37,6 +38,7 @@
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/ir/block.h"
 #include "xls/ir/block_elaboration.h"
 #include "xls/ir/caret.h"
@@ -436,22 +438,101 @@ absl::Status VerifyElaboration(Package* package) {
   return absl::OkStatus();
 }
 
-}  // namespace
+// Returns the state of `function` on which its verification depends: the
+// function itself and the signatures of the functions it calls.
+VerifiedFunctions::Entry GetVerifiedFunctionEntry(Function* function) {
+  VerifiedFunctions::Entry entry{.version = function->version(),
+                                 .name = function->name()};
+  for (Node* node : function->nodes()) {
+    Function* callee = nullptr;
+    if (node->Is<Invoke>()) {
+      callee = node->As<Invoke>()->to_apply();
+    } else if (node->Is<Map>()) {
+      callee = node->As<Map>()->to_apply();
+    } else if (node->Is<CountedFor>()) {
+      callee = node->As<CountedFor>()->body();
+    } else if (node->Is<DynamicCountedFor>()) {
+      callee = node->As<DynamicCountedFor>()->body();
+    }
+    if (callee != nullptr) {
+      entry.callee_versions.push_back({callee->uid(), callee->version()});
+    }
+  }
+  return entry;
+}
 
-absl::Status VerifyPackage(Package* package, bool codegen) {
+// Verifies `package`, skipping the functions which are unchanged since they
+// were recorded in `verified` if it is non-null.
+absl::Status VerifyPackageInternal(Package* package, bool codegen,
+                                   int64_t parallelism,
+                                   VerifiedFunctions* verified) {
   VLOG(4) << absl::StreamFormat("Verifying package %s:\n", package->name());
   XLS_VLOG_LINES(4, package->DumpIr());
 
+  // Functions, procs and blocks are verified in this order, and the first error
+  // in this order is returned however many are verified at once.
+  std::vector<FunctionBase*> to_verify;
+  VerifiedFunctions now_verified;
+  int64_t skipped_count = 0;
   for (auto& function : package->functions()) {
-    XLS_RETURN_IF_ERROR(VerifyFunction(function.get(), codegen));
+    if (verified != nullptr) {
+      VerifiedFunctions::Entry entry = GetVerifiedFunctionEntry(function.get());
+      auto it = verified->entries.find(function->uid());
+      bool unchanged = it != verified->entries.end() && it->second == entry;
+      now_verified.entries.emplace(function->uid(), std::move(entry));
+      if (unchanged) {
+        ++skipped_count;
+        continue;
+      }
+    }
+    to_verify.push_back(function.get());
   }
-
   for (auto& proc : package->procs()) {
-    XLS_RETURN_IF_ERROR(VerifyProc(proc.get(), codegen));
+    to_verify.push_back(proc.get());
   }
-
   for (auto& block : package->blocks()) {
-    XLS_RETURN_IF_ERROR(VerifyBlock(block.get(), codegen));
+    to_verify.push_back(block.get());
+  }
+  auto verify = [codegen](FunctionBase* function_base) -> absl::Status {
+    if (function_base->IsFunction()) {
+      return VerifyFunction(function_base->AsFunctionOrDie(), codegen);
+    }
+    if (function_base->IsProc()) {
+      return VerifyProc(function_base->AsProcOrDie(), codegen);
+    }
+    return VerifyBlock(function_base->AsBlockOrDie(), codegen);
+  };
+  if (parallelism <= 1 || to_verify.size() <= 1) {
+    for (FunctionBase* function_base : to_verify) {
+      XLS_RETURN_IF_ERROR(verify(function_base));
+    }
+  } else {
+    std::vector<absl::Status> statuses(to_verify.size());
+    std::atomic<int64_t> next_index = 0;
+    auto worker = [&]() {
+      for (int64_t i = next_index++; i < to_verify.size();
+           i = next_index++) {
+        statuses[i] = verify(to_verify[i]);
+      }
+    };
+    {
+      std::vector<std::unique_ptr<Thread>> threads;
+      int64_t thread_count = std::min<int64_t>(parallelism,
+                                               to_verify.size());
+      for (int64_t i = 0; i < thread_count; ++i) {
+        threads.push_back(std::make_unique<Thread>(worker));
+      }
+      // Threads are joined on destruction.
+    }
+    for (const absl::Status& status : statuses) {
+      XLS_RETURN_IF_ERROR(status);
+    }
+  }
+  if (verified != nullptr) {
+    VLOG(3) << absl::StreamFormat(
+        "Skipped verifying %d unchanged functions of package %s",
+        skipped_count, package->name());
+    *verified = std::move(now_verified);
   }
 
   // Verify node IDs are unique within the package and uplinks point to this
@@ -507,6 +588,20 @@ absl::Status VerifyPackage(Package* package, bool codegen) {
   return absl::OkStatus();
 }
 
+}  // namespace
+
+absl::Status VerifyPackage(Package* package, bool codegen,
+                           int64_t parallelism) {
+  return VerifyPackageInternal(package, codegen, parallelism,
+                               /*verified=*/nullptr);
+}
+
+absl::Status VerifyPackageIncrementally(Package* package,
+                                        VerifiedFunctions& verified,
+                                        bool codegen, int64_t parallelism) {
+  return VerifyPackageInternal(package, codegen, parallelism, &verified);
+}
+
 absl::Status VerifyFunction(Function* function, bool codegen) {
   VLOG(4) << "Verifying function:\n";
   XLS_VLOG_LINES(4, function->DumpIr());
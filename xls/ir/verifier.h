@@ -15,6 +15,12 @@
 #ifndef XLS_IR_VERIFIER_H_
 #define XLS_IR_VERIFIER_H_
 
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 
 namespace xls {
@@ -27,11 +33,41 @@ class Package;
 
 // Verifies numerous invariants of the IR for the given IR construct. Returns a
 // error status if a violation is found.
-absl::Status VerifyPackage(Package* package, bool codegen = false);
+//
+// VerifyPackage verifies up to `parallelism` of the functions, procs and blocks
+// of the package at once. The error returned does not depend on
+// `parallelism`.
+absl::Status VerifyPackage(Package* package, bool codegen = false,
+                           int64_t parallelism = 1);
 absl::Status VerifyFunction(Function* function, bool codegen = false);
 absl::Status VerifyProc(Proc* Proc, bool codegen = false);
 absl::Status VerifyBlock(Block* Block, bool codegen = false);
 
+// The functions which VerifyPackageIncrementally found to be valid, keyed by
+// FunctionBase::uid(), with the state they were in at the time.
+struct VerifiedFunctions {
+  struct Entry {
+    int64_t version;
+    std::string name;
+    // (uid, version) of each function called by the function.
+    std::vector<std::pair<int64_t, int64_t>> callee_versions;
+
+    bool operator==(const Entry& other) const = default;
+  };
+  absl::flat_hash_map<int64_t, Entry> entries;
+};
+
+// Like VerifyPackage but skips the functions recorded in `verified` which have
+// not changed since (see FunctionBase::version()), nor have the functions they
+// call. Procs and blocks, whose validity depends on channels and
+// instantiations which are not tracked this way, and the package-level
+// invariants are always verified. `verified` is updated to the functions of
+// the package if they are all valid.
+absl::Status VerifyPackageIncrementally(Package* package,
+                                        VerifiedFunctions& verified,
+                                        bool codegen = false,
+                                        int64_t parallelism = 1);
+
 }  // namespace xls
 
 #endif  // XLS_IR_VERIFIER_H_
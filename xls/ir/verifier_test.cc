@@ -27,9 +27,12 @@
 #include "xls/common/status/matchers.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/channel.h"
+#include "xls/ir/function.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
 #include "xls/ir/package.h"
 #include "xls/ir/source_location.h"
 #include "xls/ir/value.h"
@@ -690,5 +693,36 @@ proc my_new_proc<>() {}
                                  "proc-scoped channels")));
 }
 
+TEST_F(VerifierTest, IncrementalVerificationRechecksCallers) {
+  std::string input = R"(
+package IncrementalVerification
+
+fn callee(x: bits[8]) -> bits[8] {
+  ret neg.1: bits[8] = neg(x)
+}
+
+fn caller(a: bits[8]) -> bits[8] {
+  ret invoke.2: bits[8] = invoke(a, to_apply=callee)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackageNoVerify(input));
+  VerifiedFunctions verified;
+  XLS_ASSERT_OK(VerifyPackageIncrementally(p.get(), verified));
+  EXPECT_EQ(verified.entries.size(), 2);
+  XLS_ASSERT_OK(VerifyPackageIncrementally(p.get(), verified));
+
+  // Changing the return type of the callee, which is valid by itself,
+  // invalidates the unchanged caller.
+  Function* callee = FindFunction("callee", p.get());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * wide,
+      callee->MakeNode<ExtendOp>(SourceInfo(), callee->return_value(),
+                                 /*new_bit_count=*/16, Op::kZeroExt));
+  XLS_ASSERT_OK(callee->set_return_value(wide));
+  EXPECT_THAT(VerifyPackageIncrementally(p.get(), verified),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("invoked function return value")));
+}
+
 }  // namespace
 }  // namespace xls
@@ -16,7 +16,9 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -44,7 +46,6 @@
 #include "llvm/include/llvm/Target/TargetMachine.h"
 #include "llvm/include/llvm/TargetParser/SubtargetFeature.h"
 #include "llvm/include/llvm/TargetParser/Triple.h"
-#include "llvm/include/llvm/TargetParser/X86TargetParser.h"
 #include "llvm/include/llvm/Transforms/Utils/Cloning.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/jit/jit_emulated_tls.h"
@@ -53,11 +54,20 @@
 
 namespace xls {
 
+namespace {
+
+// CPU whose features all x86-64 machines running AOT-compiled code are assumed
+// to have.
+constexpr std::string_view kBaselineX86Cpu = "haswell";
+
+}  // namespace
+
 /* static */ absl::StatusOr<std::unique_ptr<AotCompiler>> AotCompiler::Create(
-    bool include_msan, int64_t opt_level, JitObserver* observer) {
+    bool include_msan, int64_t opt_level, JitObserver* observer,
+    std::optional<std::string> target_cpu) {
   LlvmCompiler::InitializeLlvm();
-  auto compiler = std::unique_ptr<AotCompiler>(
-      new AotCompiler(opt_level, include_msan, observer));
+  auto compiler = std::unique_ptr<AotCompiler>(new AotCompiler(
+      opt_level, include_msan, observer, std::move(target_cpu)));
   XLS_RETURN_IF_ERROR(compiler->Init());
   return std::move(compiler);
 }
@@ -73,39 +83,30 @@ AotCompiler::CreateTargetMachine() {
   }
 
   error_or_target_builder->setRelocationModel(llvm::Reloc::Model::PIC_);
-  // In ahead-of-time compilation we're compiling on machines we are not
-  // immediately about to run on, where runtime machines may have
-  // heterogeneous specifications vs the compilation machine. We assume a
-  // baseline level of compatibility for all machines XLS compilations might
-  // run on.
-  //
-  // TODO(allight): Ideally we should allow the user to select what target we
-  // want instead of just hard-coding a haswell.
-  switch (error_or_target_builder->getTargetTriple().getArch()) {
-    case llvm::Triple::x86_64: {
-      const std::string kBaselineCpu = "haswell";
-      error_or_target_builder->setCPU(kBaselineCpu);
-      // Clear out the existing features.
-      error_or_target_builder->getFeatures() = llvm::SubtargetFeatures();
-      // Add in features available on our "baseline" CPU.
-      llvm::SmallVector<llvm::StringRef, 32> target_cpu_features;
-      llvm::X86::getFeaturesForCPU(kBaselineCpu, target_cpu_features,
-                                   /*NeedPlus=*/true);
-      std::vector<std::string> features(target_cpu_features.begin(),
-                                        target_cpu_features.end());
-      error_or_target_builder->addFeatures(features);
-      break;
-    }
-    case llvm::Triple::aarch64: {
-      error_or_target_builder->getFeatures() = llvm::SubtargetFeatures();
-      break;
+  if (target_cpu_.has_value()) {
+    XLS_RETURN_IF_ERROR(SetTargetCpu(*error_or_target_builder, *target_cpu_));
+  } else {
+    // In ahead-of-time compilation we're compiling on machines we are not
+    // immediately about to run on, where runtime machines may have
+    // heterogeneous specifications vs the compilation machine. Unless a target
+    // CPU was requested we assume a baseline level of compatibility for all
+    // machines XLS compilations might run on.
+    switch (error_or_target_builder->getTargetTriple().getArch()) {
+      case llvm::Triple::x86_64:
+        XLS_RETURN_IF_ERROR(
+            SetTargetCpu(*error_or_target_builder, kBaselineX86Cpu));
+        break;
+      case llvm::Triple::aarch64: {
+        error_or_target_builder->getFeatures() = llvm::SubtargetFeatures();
+        break;
+      }
+      default:
+        return absl::InvalidArgumentError(
+            "Compiling on unrecognized host architecture for AOT "
+            "compilation: " +
+            std::string{
+                error_or_target_builder->getTargetTriple().getArchName()});
     }
-    default:
-      return absl::InvalidArgumentError(
-          "Compiling on unrecognized host architecture for AOT "
-          "compilation: " +
-          std::string{
-              error_or_target_builder->getTargetTriple().getArchName()});
   }
   // NB We don't need to do anything special to force emutls because we get the
   // same base target as the orc jit which doesn't support it.
@@ -182,13 +183,18 @@ absl::Status AotCompiler::CompileModule(
   if (notification.unoptimized_module) {
     jit_observer_->UnoptimizedModule(module.get());
   }
-  auto err = PerformStandardOptimization(module.get());
+  JitOptimizationStats stats;
+  auto err = PerformStandardOptimization(
+      module.get(), notification.optimization_stats ? &stats : nullptr);
   if (err) {
     std::string mem;
     llvm::raw_string_ostream oss(mem);
     oss << err;
     return absl::InternalError(oss.str());
   }
+  if (notification.optimization_stats) {
+    jit_observer_->OptimizationStats(module.get(), stats);
+  }
   // To avoid the msan pass inserting stores to msan functions we only add it
   // after all the msan stuff is done.
   if (include_msan()) {
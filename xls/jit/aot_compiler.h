@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -33,9 +34,14 @@ namespace xls {
 
 class AotCompiler final : public LlvmCompiler {
  public:
+  // Creates a compiler generating code for `target_cpu` (an LLVM CPU name such
+  // as "x86-64-v3" or LlvmCompiler::kHostCpu). By default code is generated
+  // for a conservative baseline CPU so the object code is portable across the
+  // machines it may run on.
   static absl::StatusOr<std::unique_ptr<AotCompiler>> Create(
       bool include_msan, int64_t opt_level = LlvmCompiler::kDefaultOptLevel,
-      JitObserver* observer = nullptr);
+      JitObserver* observer = nullptr,
+      std::optional<std::string> target_cpu = std::nullopt);
 
   absl::StatusOr<AotCompiler*> AsAotCompiler() override { return this; }
 
@@ -68,10 +74,12 @@ class AotCompiler final : public LlvmCompiler {
  private:
   // TODO(https://github.com/google/xls/issues/1639): It would be nice to
   // support runtime observer callbacks in aot'd code.
-  AotCompiler(int64_t opt_level, bool include_msan, JitObserver* observer)
+  AotCompiler(int64_t opt_level, bool include_msan, JitObserver* observer,
+              std::optional<std::string> target_cpu)
       : LlvmCompiler(opt_level, include_msan,
                      /*include_observer_callbacks=*/false),
-        jit_observer_(observer) {}
+        jit_observer_(observer),
+        target_cpu_(std::move(target_cpu)) {}
 
   std::unique_ptr<llvm::LLVMContext> context_ =
       std::make_unique<llvm::LLVMContext>();
@@ -79,6 +87,9 @@ class AotCompiler final : public LlvmCompiler {
   std::optional<std::vector<uint8_t>> object_code_;
 
   JitObserver* jit_observer_;
+
+  // CPU to generate code for, or std::nullopt for the baseline CPU.
+  std::optional<std::string> target_cpu_;
 };
 
 }  // namespace xls
@@ -25,7 +25,6 @@
 #include <string>
 #include <string_view>
 
-#include "absl/algorithm/container.h"
 #include "absl/flags/flag.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
@@ -39,22 +38,23 @@
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
-#include "xls/dev_tools/extract_interface.h"
 #include "xls/ir/block_elaboration.h"
 #include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/ir_parser.h"
-#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/proc_elaboration.h"
 #include "xls/ir/type.h"
 #include "xls/jit/aot_entrypoint.pb.h"
+#include "xls/jit/aot_entrypoint_utils.h"
+#include "xls/jit/aot_standalone.h"
 #include "xls/jit/block_jit.h"
 #include "xls/jit/function_base_jit.h"
 #include "xls/jit/function_jit.h"
 #include "xls/jit/jit_proc_runtime.h"
 #include "xls/jit/llvm_type_converter.h"
 #include "xls/jit/observer.h"
-#include "xls/jit/type_layout.pb.h"
 
 ABSL_FLAG(std::string, input, "", "Path to the IR to compile.");
 ABSL_FLAG(std::optional<std::string>, top, std::nullopt,
@@ -75,6 +75,22 @@ ABSL_FLAG(std::optional<std::string>, output_llvm_opt_ir, std::nullopt,
           "Path at which to write the output optimized llvm file.");
 ABSL_FLAG(std::optional<std::string>, output_asm, std::nullopt,
           "Path at which to write the output optimized llvm file.");
+ABSL_FLAG(std::optional<std::string>, output_standalone_header, std::nullopt,
+          "Path at which to write the C header of a standalone library "
+          "running the compiled proc network without the XLS runtime. Must be "
+          "given along with --output_standalone_source.");
+ABSL_FLAG(std::optional<std::string>, output_standalone_source, std::nullopt,
+          "Path at which to write the source of the standalone library. It "
+          "must be linked with --output_object.");
+ABSL_FLAG(std::string, standalone_name, "xls_network",
+          "Name of the standalone network, used as the prefix of the symbols "
+          "of its interface.");
+ABSL_FLAG(std::optional<std::string>, standalone_header_include_path,
+          std::nullopt,
+          "Path by which the standalone source includes its header. Defaults "
+          "to --output_standalone_header.");
+ABSL_FLAG(int64_t, standalone_channel_capacity, 64,
+          "Number of values each channel of the standalone network can hold.");
 #ifdef ABSL_HAVE_MEMORY_SANITIZER
 static constexpr bool kHasMsan = true;
 #else
@@ -84,6 +100,13 @@ ABSL_FLAG(bool, include_msan, kHasMsan,
           "Whether to include msan calls in the jitted code. This *must* match "
           "the configuration of the binary the jitted code is included in.");
 
+ABSL_FLAG(std::optional<std::string>, target_cpu, std::nullopt,
+          "LLVM name of the CPU to generate code for, e.g., x86-64-v2, "
+          "x86-64-v3 or x86-64-v4. The code may use every feature of this CPU "
+          "so it only runs on machines supporting them. 'native' selects the "
+          "CPU of the compiling machine. By default a conservative baseline "
+          "CPU is used.");
+
 namespace xls {
 namespace {
 
@@ -120,118 +143,19 @@ class IntermediatesObserver final : public JitObserver {
   std::string asm_;
 };
 
-absl::StatusOr<AotEntrypointProto> GenerateEntrypointProto(
-    Package* package, const FunctionEntrypoint& entrypoint, bool include_msan,
-    LlvmTypeConverter& type_converter) {
-  FunctionBase* func = entrypoint.function;
-  const JittedFunctionBase& object_code = entrypoint.jit_info;
-  AotEntrypointProto proto;
-  proto.set_has_msan(include_msan);
-  if (func->IsFunction()) {
-    proto.set_type(AotEntrypointProto::FUNCTION);
-    proto.add_outputs_names("result");
-    for (const Param* p : func->params()) {
-      proto.add_inputs_names(p->name());
-      *proto.mutable_inputs_layout()->add_layouts() =
-          type_converter.CreateTypeLayout(p->GetType()).ToProto();
-    }
-    *proto.mutable_outputs_layout()->add_layouts() =
-        type_converter
-            .CreateTypeLayout(func->AsFunctionOrDie()->GetType()->return_type())
-            .ToProto();
-    AotEntrypointProto::FunctionMetadataProto* function_metadata_proto =
-        proto.mutable_function_metadata();
-    *function_metadata_proto->mutable_function_interface() =
-        ExtractFunctionInterface(func->AsFunctionOrDie());
-  } else if (func->IsProc()) {
-    proto.set_type(AotEntrypointProto::PROC);
-    for (const Param* p : func->params()) {
-      proto.add_inputs_names(p->name());
-      proto.add_outputs_names(p->name());
-      auto layout_proto =
-          type_converter.CreateTypeLayout(p->GetType()).ToProto();
-      *proto.mutable_inputs_layout()->add_layouts() = layout_proto;
-      *proto.mutable_outputs_layout()->add_layouts() = layout_proto;
-    }
-    AotEntrypointProto::ProcMetadataProto* proc_metadata_proto =
-        proto.mutable_proc_metadata();
-    proc_metadata_proto->mutable_continuation_point_node_ids()->insert(
-        object_code.continuation_points().begin(),
-        object_code.continuation_points().end());
-    proc_metadata_proto->mutable_channel_queue_indices()->insert(
-        object_code.queue_indices().begin(), object_code.queue_indices().end());
-    *proc_metadata_proto->mutable_proc_interface() =
-        ExtractProcInterface(func->AsProcOrDie());
-  } else {
-    XLS_RET_CHECK(func->IsBlock());
-    proto.set_type(AotEntrypointProto::BLOCK);
-    for (InputPort* p : func->AsBlockOrDie()->GetInputPorts()) {
-      proto.add_inputs_names(p->name());
-      auto layout_proto =
-          type_converter.CreateTypeLayout(p->GetType()).ToProto();
-      *proto.mutable_inputs_layout()->add_layouts() = layout_proto;
-    }
-    for (OutputPort* p : func->AsBlockOrDie()->GetOutputPorts()) {
-      proto.add_outputs_names(p->name());
-      auto layout_proto =
-          type_converter.CreateTypeLayout(p->GetType()).ToProto();
-      *proto.mutable_outputs_layout()->add_layouts() = layout_proto;
-    }
-    AotEntrypointProto::BlockMetadataProto* block_metadata_proto =
-        proto.mutable_block_metadata();
-
-    for (const auto& [orig, translated] : entrypoint.register_aliases) {
-      block_metadata_proto->mutable_register_aliases()->insert(
-          {orig, translated});
-    }
-    for (const auto& [reg, ty] : entrypoint.added_registers) {
-      block_metadata_proto->mutable_added_registers()->insert(
-          {reg, ty->ToProto()});
-    }
-    *block_metadata_proto->mutable_block_interface() =
-        ExtractBlockInterface(func->AsBlockOrDie());
-  }
-  proto.set_xls_package_name(package->name());
-  proto.set_xls_function_identifier(func->name());
-  proto.set_function_symbol(object_code.function_name());
-  absl::c_for_each(object_code.input_buffer_sizes(),
-                   [&](int64_t i) { proto.add_input_buffer_sizes(i); });
-  absl::c_for_each(object_code.input_buffer_preferred_alignments(),
-                   [&](int64_t i) { proto.add_input_buffer_alignments(i); });
-  absl::c_for_each(object_code.input_buffer_abi_alignments(), [&](int64_t i) {
-    proto.add_input_buffer_abi_alignments(i);
-  });
-  absl::c_for_each(object_code.output_buffer_sizes(),
-                   [&](int64_t i) { proto.add_output_buffer_sizes(i); });
-  absl::c_for_each(object_code.output_buffer_preferred_alignments(),
-                   [&](int64_t i) { proto.add_output_buffer_alignments(i); });
-  absl::c_for_each(object_code.output_buffer_abi_alignments(), [&](int64_t i) {
-    proto.add_output_buffer_abi_alignments(i);
-  });
-  if (object_code.HasPackedFunction()) {
-    proto.set_packed_function_symbol(*object_code.packed_function_name());
-    absl::c_for_each(object_code.packed_input_buffer_sizes(), [&](int64_t i) {
-      proto.add_packed_input_buffer_sizes(i);
-    });
-    absl::c_for_each(object_code.packed_output_buffer_sizes(), [&](int64_t i) {
-      proto.add_packed_output_buffer_sizes(i);
-    });
-  }
-
-  proto.set_temp_buffer_size(object_code.temp_buffer_size());
-  proto.set_temp_buffer_alignment(object_code.temp_buffer_alignment());
-  return proto;
-}
-
 absl::Status RealMain(const std::string& input_ir_path,
                       const std::optional<std::string>& top,
                       const std::optional<std::string>& output_object_path,
                       const std::optional<std::string>& output_proto_path,
                       bool include_msan,
+                      const std::optional<std::string>& target_cpu,
                       const std::optional<std::string>& output_textproto_path,
                       const std::optional<std::string>& output_llvm_ir_path,
                       const std::optional<std::string>& output_llvm_opt_ir_path,
-                      const std::optional<std::string>& output_asm_path) {
+                      const std::optional<std::string>& output_asm_path,
+                      const std::optional<std::string>& standalone_header_path,
+                      const std::optional<std::string>& standalone_source_path,
+                      const StandaloneProcNetworkOptions& standalone_options) {
   XLS_ASSIGN_OR_RETURN(std::string input_ir, GetFileContents(input_ir_path));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
                        Parser::ParsePackage(input_ir, input_ir_path));
@@ -256,29 +180,68 @@ absl::Status RealMain(const std::string& input_ir_path,
     }
   }
 
+  // Standalone networks have no implementation of the wide arithmetic
+  // callback, so LLVM lowers wide multiplications and divisions itself.
+  const bool standalone = standalone_header_path.has_value() ||
+                          standalone_source_path.has_value();
   std::optional<JitObjectCode> object_code;
   if (f->IsFunction()) {
     XLS_ASSIGN_OR_RETURN(
         object_code,
         FunctionJit::CreateObjectCode(f->AsFunctionOrDie(),
-                                      /*opt_level = */ 3, include_msan, &obs));
+                                      /*opt_level = */ 3, include_msan, &obs,
+                                      target_cpu));
   } else if (f->IsProc()) {
     if (f->AsProcOrDie()->is_new_style_proc()) {
       XLS_ASSIGN_OR_RETURN(
           object_code,
-          CreateProcAotObjectCode(f->AsProcOrDie(), include_msan, &obs));
+          CreateProcAotObjectCode(f->AsProcOrDie(), include_msan, &obs,
+                                  target_cpu,
+                                  /*include_wide_arithmetic_calls=*/
+                                  !standalone));
     } else {
       // all procs
-      XLS_ASSIGN_OR_RETURN(object_code, CreateProcAotObjectCode(
-                                            package.get(), include_msan, &obs));
+      XLS_ASSIGN_OR_RETURN(
+          object_code,
+          CreateProcAotObjectCode(package.get(), include_msan, &obs,
+                                  target_cpu,
+                                  /*include_wide_arithmetic_calls=*/
+                                  !standalone));
     }
   } else {
     XLS_ASSIGN_OR_RETURN(BlockElaboration elab,
                          BlockElaboration::Elaborate(f->AsBlockOrDie()));
     XLS_ASSIGN_OR_RETURN(
         object_code,
-        BlockJit::CreateObjectCode(elab, /*opt_level=*/3, include_msan, &obs));
+        BlockJit::CreateObjectCode(elab, /*opt_level=*/3, include_msan, &obs,
+                                   target_cpu));
+  }
+  if (standalone) {
+    XLS_RET_CHECK(standalone_header_path.has_value() &&
+                  standalone_source_path.has_value())
+        << "Standalone header and source must be generated together.";
+    if (!f->IsProc()) {
+      return absl::InvalidArgumentError(
+          "Standalone libraries can only be generated for procs.");
+    }
+    if (include_msan) {
+      return absl::InvalidArgumentError(
+          "Standalone libraries can't include msan calls.");
+    }
+    XLS_ASSIGN_OR_RETURN(
+        ProcElaboration elaboration,
+        f->AsProcOrDie()->is_new_style_proc()
+            ? ProcElaboration::Elaborate(f->AsProcOrDie())
+            : ProcElaboration::ElaborateOldStylePackage(package.get()));
+    XLS_ASSIGN_OR_RETURN(StandaloneProcNetworkSources sources,
+                         GenerateStandaloneProcNetwork(
+                             elaboration, *object_code, standalone_options));
+    XLS_RETURN_IF_ERROR(
+        SetFileContents(*standalone_header_path, sources.header));
+    XLS_RETURN_IF_ERROR(
+        SetFileContents(*standalone_source_path, sources.source));
   }
+
   AotPackageEntrypointsProto all_entrypoints;
   if (output_object_path) {
     XLS_RETURN_IF_ERROR(SetFileContents(
@@ -288,13 +251,16 @@ absl::Status RealMain(const std::string& input_ir_path,
 
   *all_entrypoints.mutable_data_layout() =
       object_code->data_layout.getStringRepresentation();
+  if (target_cpu.has_value()) {
+    all_entrypoints.set_target_cpu(*target_cpu);
+  }
 
   auto context = std::make_unique<llvm::LLVMContext>();
   LlvmTypeConverter type_converter(context.get(), object_code->data_layout);
   for (const FunctionEntrypoint& oc : object_code->entrypoints) {
     XLS_ASSIGN_OR_RETURN(
         *all_entrypoints.add_entrypoint(),
-        GenerateEntrypointProto(
+        GenerateAotEntrypointProto(
             object_code->package ? object_code->package.get() : package.get(),
             oc, include_msan, type_converter));
   }
@@ -338,11 +304,22 @@ int main(int argc, char** argv) {
       absl::GetFlag(FLAGS_output_proto);
 
   bool include_msan = absl::GetFlag(FLAGS_include_msan);
+  std::optional<std::string> standalone_header_path =
+      absl::GetFlag(FLAGS_output_standalone_header);
+  xls::StandaloneProcNetworkOptions standalone_options{
+      .name = absl::GetFlag(FLAGS_standalone_name),
+      .header_include_path =
+          absl::GetFlag(FLAGS_standalone_header_include_path)
+              .value_or(standalone_header_path.value_or("")),
+      .channel_capacity = absl::GetFlag(FLAGS_standalone_channel_capacity),
+  };
   absl::Status status = xls::RealMain(
       input_ir_path, top, output_object_path, output_proto_path, include_msan,
-      absl::GetFlag(FLAGS_output_textproto),
+      absl::GetFlag(FLAGS_target_cpu), absl::GetFlag(FLAGS_output_textproto),
       absl::GetFlag(FLAGS_output_llvm_ir),
-      absl::GetFlag(FLAGS_output_llvm_opt_ir), absl::GetFlag(FLAGS_output_asm));
+      absl::GetFlag(FLAGS_output_llvm_opt_ir), absl::GetFlag(FLAGS_output_asm),
+      standalone_header_path, absl::GetFlag(FLAGS_output_standalone_source),
+      standalone_options);
   if (!status.ok()) {
     std::cout << status.message();
     return 1;
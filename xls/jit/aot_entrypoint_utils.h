@@ -0,0 +1,34 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_AOT_ENTRYPOINT_UTILS_H_
+#define XLS_JIT_AOT_ENTRYPOINT_UTILS_H_
+
+#include "absl/status/statusor.h"
+#include "xls/ir/package.h"
+#include "xls/jit/aot_entrypoint.pb.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/llvm_type_converter.h"
+
+namespace xls {
+
+// Returns the AotEntrypointProto describing the ABI of the given compiled
+// entrypoint. 'package' is the package the entrypoint's function lives in.
+absl::StatusOr<AotEntrypointProto> GenerateAotEntrypointProto(
+    Package* package, const FunctionEntrypoint& entrypoint, bool include_msan,
+    LlvmTypeConverter& type_converter);
+
+}  // namespace xls
+
+#endif  // XLS_JIT_AOT_ENTRYPOINT_UTILS_H_
@@ -0,0 +1,819 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/aot_standalone.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_replace.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/proc_elaboration.h"
+#include "xls/ir/state_element.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/jit_callbacks.h"
+#include "xls/jit/jit_runtime.h"
+
+namespace xls {
+namespace {
+
+// Alignment of the arena and minimum alignment of channel elements, matching
+// that of JitChannelQueue.
+constexpr int64_t kArenaAlignment = 64;
+constexpr int64_t kMinElementAlignment = 16;
+
+int64_t RoundUp(int64_t value, int64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+bool IsCIdentifier(std::string_view s) {
+  if (s.empty() || absl::ascii_isdigit(s.front())) {
+    return false;
+  }
+  return std::all_of(s.begin(), s.end(), [](char c) {
+    return absl::ascii_isalnum(c) || c == '_';
+  });
+}
+
+std::string ToCIdentifier(std::string_view s) {
+  std::string result;
+  for (char c : s) {
+    result.push_back(absl::ascii_isalnum(c) ? c : '_');
+  }
+  return result;
+}
+
+// Returns a C string literal holding `s`.
+std::string CStringLiteral(std::string_view s) {
+  return absl::StrCat(
+      "\"", absl::StrReplaceAll(s, {{"\\", "\\\\"}, {"\"", "\\\""}}), "\"");
+}
+
+// Returns an initializer list of the bytes of `bytes`.
+std::string ByteList(absl::Span<const uint8_t> bytes) {
+  return absl::StrCat(
+      "{", absl::StrJoin(bytes, ", ",
+                         [](std::string* out, uint8_t byte) {
+                           absl::StrAppendFormat(out, "0x%02x", byte);
+                         }),
+      "}");
+}
+
+// Same as the resolution done by the ProcJit: channel names in the compiled
+// code refer to channel references for new-style procs and to global channels
+// for old-style procs.
+absl::StatusOr<ChannelInstance*> GetChannelInstance(
+    const ProcElaboration& elaboration, ProcInstance* proc_instance,
+    std::string_view channel_name) {
+  if (proc_instance->path().has_value()) {
+    return proc_instance->GetChannelInstance(channel_name);
+  }
+  XLS_ASSIGN_OR_RETURN(
+      Channel * channel,
+      proc_instance->proc()->package()->GetChannel(channel_name));
+  return elaboration.GetUniqueInstance(channel);
+}
+
+// Returns the names of the functions of the generated source implementing the
+// InstanceContextVTable entries, in the order of the table.
+absl::StatusOr<std::vector<std::string>> VTableFunctionNames() {
+  std::vector<std::pair<int64_t, std::string>> entries = {
+      {InstanceContext::kPerformStringStepOffset, "PerformStringStep"},
+      {InstanceContext::kPerformFormatStepOffset, "PerformFormatStep"},
+      {InstanceContext::kRecordTraceOffset, "RecordTrace"},
+      {InstanceContext::kCreateTraceBufferOffset, "CreateTraceBuffer"},
+      {InstanceContext::kRecordAssertionOffset, "RecordAssertion"},
+      {InstanceContext::kQueueReceiveWrapperOffset, "QueueReceive"},
+      {InstanceContext::kQueueSendWrapperOffset, "QueueSend"},
+      {InstanceContext::kQueueAcquireWriteSlotOffset, "QueueAcquireWriteSlot"},
+      {InstanceContext::kQueueCommitWriteSlotOffset, "QueueCommitWriteSlot"},
+      {InstanceContext::kQueuePeekReadSlotOffset, "QueuePeekReadSlot"},
+      {InstanceContext::kQueueReleaseReadSlotOffset, "QueueReleaseReadSlot"},
+      {InstanceContext::kRecordActiveNextValueOffset,
+       "RecordActiveNextValue"},
+      {InstanceContext::kRecordNodeResultOffset, "RecordNodeResult"},
+      {InstanceContext::kGetNodeProfileCountersOffset,
+       "GetNodeProfileCounters"},
+      {InstanceContext::kGetNodeCoverageBitsOffset, "GetNodeCoverageBits"},
+      {InstanceContext::kWideArithmeticOffset, "WideArithmetic"},
+  };
+  XLS_RET_CHECK_EQ(entries.size(), InstanceContext::kVTableLength)
+      << "New InstanceContextVTable entries must be implemented by the "
+         "standalone runtime.";
+  std::sort(entries.begin(), entries.end());
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < entries.size(); ++i) {
+    XLS_RET_CHECK_EQ(entries[i].first, i * sizeof(void (*)()));
+    names.push_back(entries[i].second);
+  }
+  return names;
+}
+
+struct ChannelLayout {
+  std::string name;
+  std::string enum_name;
+  int64_t element_size;
+  int64_t stride;
+  int64_t capacity;
+  int64_t offset;
+  std::vector<uint8_t> initial_values;
+  int64_t initial_value_count;
+};
+
+struct StateLayout {
+  int64_t size;
+  int64_t offsets[2];
+};
+
+struct InstanceLayout {
+  std::string name;
+  std::string_view symbol;
+  int64_t proc_index;
+  std::vector<StateLayout> state;
+  int64_t temp_offset;
+  std::vector<int64_t> queue_channels;
+  bool has_next_values;
+};
+
+constexpr std::string_view kHeaderTemplate =
+    R"(// Generated by aot_compiler_main. Do not edit.
+//
+// Runs the proc network {top} compiled ahead of time. Values are exchanged
+// with the network through channel ring buffers holding them in the native
+// data layout of the XLS JIT. The network only depends on the C++ standard
+// library and the object code of its procs.
+
+#ifndef {guard}
+#define {guard}
+
+#include <stdbool.h>  // NOLINT(modernize-deprecated-headers)
+#include <stddef.h>   // NOLINT(modernize-deprecated-headers)
+#include <stdint.h>   // NOLINT(modernize-deprecated-headers)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Channel instances of the network.
+enum {
+{channel_enum}  {upper}_CHANNEL_COUNT = {channel_count},
+};
+
+typedef struct {name} {name};
+
+// Creates a network in its initial state. Returns NULL if out of memory.
+{name}* {name}_create(void);
+void {name}_destroy({name}* network);
+
+// Returns the network to its initial state, emptying the channels of all but
+// their initial values and clearing any error.
+void {name}_reset({name}* network);
+
+// Ticks every proc of the network once, resuming procs blocked on a receive
+// as long as some proc makes progress. Returns the number of procs which
+// completed their tick or -1 on error (see {name}_error).
+int64_t {name}_tick({name}* network);
+
+// Ticks until the procs are all blocked on receives. Returns the number of
+// ticks executed or -1 on error, which includes not blocking within
+// `max_ticks` ticks if it is positive.
+int64_t {name}_run_until_blocked({name}* network, int64_t max_ticks);
+
+// Returns a description of the error which stopped the network (a failed
+// assertion or a channel overflow) or NULL.
+const char* {name}_error(const {name}* network);
+
+const char* {name}_channel_name(int channel);
+// Size in bytes of the values of the channel.
+size_t {name}_channel_element_size(int channel);
+// Number of values the channel holds.
+size_t {name}_channel_size(const {name}* network, int channel);
+// Writes a value to the channel. Returns false if it is full.
+bool {name}_channel_send({name}* network, int channel, const uint8_t* data);
+// Reads a value from the channel. Returns false if it is empty.
+bool {name}_channel_receive({name}* network, int channel, uint8_t* data);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // {guard}
+)";
+
+constexpr std::string_view kSourceTemplate =
+    R"(// Generated by aot_compiler_main. Do not edit.
+
+#include "{header}"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+extern "C" {
+{entry_declarations}}  // extern "C"
+
+namespace {
+
+using EntryFn = int64_t (*)(const uint8_t* const* inputs,
+                            uint8_t* const* outputs, void* temp_buffer,
+                            void* events, void* instance_context,
+                            void* jit_runtime, int64_t continuation_point);
+
+constexpr size_t kArenaSize = {arena_size};
+constexpr int kChannelCount = {channel_count};
+constexpr int kInstanceCount = {instance_count};
+constexpr int kMaxStateElements = {max_state_elements};
+constexpr int kMaxQueues = {max_queues};
+constexpr int kVTableLength = {vtable_length};
+constexpr size_t kMaxStride = {max_stride};
+constexpr size_t kErrorSize = 256;
+
+struct ChannelInfo {
+  const char* name;
+  size_t element_size;
+  size_t stride;
+  size_t capacity;
+  size_t offset;
+  const uint8_t* initial_values;
+  size_t initial_value_count;
+};
+
+struct InstanceInfo {
+  const char* name;
+  EntryFn entry;
+  int state_count;
+  size_t state_sizes[kMaxStateElements];
+  size_t state_offsets[2][kMaxStateElements];
+  const uint8_t* initial_state[kMaxStateElements];
+  size_t temp_offset;
+  int queue_channels[kMaxQueues];
+  bool has_next_values;
+};
+
+{constants}
+constexpr ChannelInfo kChannels[] = {
+{channel_infos}};
+
+constexpr InstanceInfo kInstances[] = {
+{instance_infos}};
+
+struct Ring {
+  size_t head;
+  size_t count;
+};
+
+// Stands in for the InstanceContext of the XLS runtime: the compiled code
+// only calls the functions of its leading table.
+struct ProcContext {
+  void (*vtable[kVTableLength])();
+  {name}* network;
+  int instance;
+  int64_t continuation_point;
+  int current;
+  uint8_t* state[2][kMaxStateElements];
+};
+
+}  // namespace
+
+struct {name} {
+  alignas({arena_alignment}) uint8_t arena[kArenaSize];
+  alignas({arena_alignment}) uint8_t overflow_slot[kMaxStride];
+  Ring rings[kChannelCount > 0 ? kChannelCount : 1];
+  ProcContext contexts[kInstanceCount];
+  char error[kErrorSize];
+};
+
+namespace {
+
+void SetError({name}* network, const char* prefix, const char* detail) {
+  if (network->error[0] != '\0') {
+    return;
+  }
+  size_t length = 0;
+  for (const char* s : {prefix, detail}) {
+    for (; *s != '\0' && length + 1 < kErrorSize; ++s) {
+      network->error[length++] = *s;
+    }
+  }
+  network->error[length] = '\0';
+}
+
+uint8_t* Slot({name}* network, int channel, size_t index) {
+  const ChannelInfo& info = kChannels[channel];
+  size_t position = (network->rings[channel].head + index) % info.capacity;
+  return network->arena + info.offset + position * info.stride;
+}
+
+bool RingPush({name}* network, int channel, const uint8_t* data) {
+  Ring& ring = network->rings[channel];
+  if (ring.count == kChannels[channel].capacity) {
+    return false;
+  }
+  std::memcpy(Slot(network, channel, ring.count), data,
+              kChannels[channel].element_size);
+  ++ring.count;
+  return true;
+}
+
+bool RingPop({name}* network, int channel, uint8_t* data) {
+  Ring& ring = network->rings[channel];
+  if (ring.count == 0) {
+    return false;
+  }
+  if (data != nullptr) {
+    std::memcpy(data, Slot(network, channel, 0),
+                kChannels[channel].element_size);
+  }
+  ring.head = (ring.head + 1) % kChannels[channel].capacity;
+  --ring.count;
+  return true;
+}
+
+int QueueChannel(ProcContext* context, int64_t queue_index) {
+  return kInstances[context->instance].queue_channels[queue_index];
+}
+
+// Traces need the type information of the XLS runtime and are dropped.
+void PerformStringStep(ProcContext*, char*, void*) {}
+void PerformFormatStep(ProcContext*, void*, const uint8_t*, int64_t,
+                       const uint8_t*, uint64_t, void*) {}
+void RecordTrace(ProcContext*, void*, int64_t, void*) {}
+void* CreateTraceBuffer(ProcContext*, int64_t, void*) { return nullptr; }
+
+void RecordAssertion(ProcContext* context, const char* message, void*) {
+  SetError(context->network, "Assertion failure: ", message);
+}
+
+bool QueueReceive(ProcContext* context, int64_t queue_index,
+                  uint8_t* buffer) {
+  return RingPop(context->network, QueueChannel(context, queue_index), buffer);
+}
+
+void QueueSend(ProcContext* context, int64_t queue_index,
+               const uint8_t* data) {
+  int channel = QueueChannel(context, queue_index);
+  if (!RingPush(context->network, channel, data)) {
+    SetError(context->network, "Channel overflow: ", kChannels[channel].name);
+  }
+}
+
+uint8_t* QueueAcquireWriteSlot(ProcContext* context, int64_t queue_index) {
+  {name}* network = context->network;
+  int channel = QueueChannel(context, queue_index);
+  Ring& ring = network->rings[channel];
+  if (ring.count == kChannels[channel].capacity) {
+    SetError(network, "Channel overflow: ", kChannels[channel].name);
+    return network->overflow_slot;
+  }
+  return Slot(network, channel, ring.count);
+}
+
+void QueueCommitWriteSlot(ProcContext* context, int64_t queue_index) {
+  int channel = QueueChannel(context, queue_index);
+  Ring& ring = context->network->rings[channel];
+  if (ring.count < kChannels[channel].capacity) {
+    ++ring.count;
+  }
+}
+
+const uint8_t* QueuePeekReadSlot(ProcContext* context, int64_t queue_index) {
+  int channel = QueueChannel(context, queue_index);
+  if (context->network->rings[channel].count == 0) {
+    return nullptr;
+  }
+  return Slot(context->network, channel, 0);
+}
+
+void QueueReleaseReadSlot(ProcContext* context, int64_t queue_index) {
+  RingPop(context->network, QueueChannel(context, queue_index), nullptr);
+}
+
+void RecordActiveNextValue(ProcContext*, int64_t, int64_t) {}
+void RecordNodeResult(ProcContext*, int64_t, const uint8_t*) {}
+uint64_t* GetNodeProfileCounters(ProcContext*) { return nullptr; }
+uint8_t* GetNodeCoverageBits(ProcContext*) { return nullptr; }
+
+void WideArithmetic(ProcContext* context, int64_t, uint64_t* result,
+                    const uint64_t*, const uint64_t*, int64_t word_count) {
+  std::memset(result, 0, word_count * sizeof(uint64_t));
+  SetError(context->network,
+           "The procs were compiled with calls to the wide arithmetic "
+           "kernels, which standalone networks do not include",
+           "");
+}
+
+void (*const kVTable[kVTableLength])() = {
+{vtable}};
+
+void CompleteTick({name}* network, int instance) {
+  ProcContext& context = network->contexts[instance];
+  const InstanceInfo& info = kInstances[instance];
+  context.continuation_point = 0;
+  context.current ^= 1;
+  if (info.has_next_values) {
+    // State elements without an active next value keep their value.
+    for (int i = 0; i < info.state_count; ++i) {
+      std::memcpy(context.state[1 - context.current][i],
+                  context.state[context.current][i], info.state_sizes[i]);
+    }
+  }
+}
+
+// Ticks every proc once. Sets `progress` if any proc made progress.
+int64_t TickInternal({name}* network, bool* progress) {
+  if (network->error[0] != '\0') {
+    return -1;
+  }
+  bool done[kInstanceCount] = {};
+  int64_t completed = 0;
+  *progress = false;
+  bool round_progress = true;
+  while (round_progress && completed < kInstanceCount) {
+    round_progress = false;
+    for (int i = 0; i < kInstanceCount; ++i) {
+      if (done[i]) {
+        continue;
+      }
+      ProcContext& context = network->contexts[i];
+      int64_t start = context.continuation_point;
+      int64_t next = kInstances[i].entry(
+          context.state[context.current], context.state[1 - context.current],
+          network->arena + kInstances[i].temp_offset, /*events=*/nullptr,
+          &context, /*jit_runtime=*/nullptr, start);
+      if (network->error[0] != '\0') {
+        return -1;
+      }
+      if (next == 0) {
+        CompleteTick(network, i);
+        done[i] = true;
+        ++completed;
+        round_progress = true;
+      } else {
+        context.continuation_point = next;
+        round_progress = round_progress || next != start;
+      }
+    }
+    *progress = *progress || round_progress;
+  }
+  return completed;
+}
+
+bool IsChannel(int channel) { return channel >= 0 && channel < kChannelCount; }
+
+}  // namespace
+
+extern "C" {
+
+{name}* {name}_create(void) {
+  {name}* network = new (std::nothrow) {name};
+  if (network != nullptr) {
+    {name}_reset(network);
+  }
+  return network;
+}
+
+void {name}_destroy({name}* network) { delete network; }
+
+void {name}_reset({name}* network) {
+  network->error[0] = '\0';
+  for (int i = 0; i < kInstanceCount; ++i) {
+    const InstanceInfo& info = kInstances[i];
+    ProcContext& context = network->contexts[i];
+    for (int j = 0; j < kVTableLength; ++j) {
+      context.vtable[j] = kVTable[j];
+    }
+    context.network = network;
+    context.instance = i;
+    context.continuation_point = 0;
+    context.current = 0;
+    for (int side = 0; side < 2; ++side) {
+      for (int j = 0; j < info.state_count; ++j) {
+        context.state[side][j] = network->arena + info.state_offsets[side][j];
+        if (info.state_sizes[j] != 0) {
+          std::memcpy(context.state[side][j], info.initial_state[j],
+                      info.state_sizes[j]);
+        }
+      }
+    }
+  }
+  for (int channel = 0; channel < kChannelCount; ++channel) {
+    const ChannelInfo& info = kChannels[channel];
+    network->rings[channel] = Ring{0, 0};
+    for (size_t i = 0; i < info.initial_value_count; ++i) {
+      RingPush(network, channel, info.initial_values + i * info.element_size);
+    }
+  }
+}
+
+int64_t {name}_tick({name}* network) {
+  bool progress;
+  return TickInternal(network, &progress);
+}
+
+int64_t {name}_run_until_blocked({name}* network, int64_t max_ticks) {
+  int64_t ticks = 0;
+  while (true) {
+    if (max_ticks > 0 && ticks >= max_ticks) {
+      SetError(network, "Network did not block within the maximum ticks", "");
+      return -1;
+    }
+    bool progress;
+    if (TickInternal(network, &progress) < 0) {
+      return -1;
+    }
+    if (!progress) {
+      return ticks;
+    }
+    ++ticks;
+  }
+}
+
+const char* {name}_error(const {name}* network) {
+  return network->error[0] == '\0' ? nullptr : network->error;
+}
+
+const char* {name}_channel_name(int channel) {
+  return IsChannel(channel) ? kChannels[channel].name : nullptr;
+}
+
+size_t {name}_channel_element_size(int channel) {
+  return IsChannel(channel) ? kChannels[channel].element_size : 0;
+}
+
+size_t {name}_channel_size(const {name}* network, int channel) {
+  return IsChannel(channel) ? network->rings[channel].count : 0;
+}
+
+bool {name}_channel_send({name}* network, int channel, const uint8_t* data) {
+  return IsChannel(channel) && RingPush(network, channel, data);
+}
+
+bool {name}_channel_receive({name}* network, int channel, uint8_t* data) {
+  return IsChannel(channel) && RingPop(network, channel, data);
+}
+
+}  // extern "C"
+)";
+
+}  // namespace
+
+absl::StatusOr<StandaloneProcNetworkSources> GenerateStandaloneProcNetwork(
+    const ProcElaboration& elaboration, const JitObjectCode& object_code,
+    const StandaloneProcNetworkOptions& options) {
+  if (!IsCIdentifier(options.name)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Standalone network name `%s` is not a C identifier", options.name));
+  }
+  XLS_RET_CHECK_GT(options.channel_capacity, 0);
+  XLS_RET_CHECK(!elaboration.proc_instances().empty());
+  XLS_ASSIGN_OR_RETURN(std::vector<std::string> vtable, VTableFunctionNames());
+
+  absl::flat_hash_map<Proc*, const FunctionEntrypoint*> entrypoints;
+  for (const FunctionEntrypoint& entrypoint : object_code.entrypoints) {
+    XLS_RET_CHECK(entrypoint.function->IsProc());
+    entrypoints[entrypoint.function->AsProcOrDie()] = &entrypoint;
+  }
+
+  JitRuntime runtime(object_code.data_layout);
+  int64_t arena_size = 0;
+  auto allocate = [&](int64_t size, int64_t alignment) {
+    int64_t offset = RoundUp(arena_size, std::max<int64_t>(alignment, 1));
+    arena_size = offset + size;
+    return offset;
+  };
+
+  std::string constants;
+  std::vector<ChannelLayout> channels;
+  absl::flat_hash_map<ChannelInstance*, int64_t> channel_indices;
+  absl::flat_hash_map<std::string, int64_t> channel_name_counts;
+  for (ChannelInstance* channel_instance : elaboration.channel_instances()) {
+    ++channel_name_counts[channel_instance->channel->name()];
+  }
+  int64_t max_stride = kMinElementAlignment;
+  for (ChannelInstance* channel_instance : elaboration.channel_instances()) {
+    Channel* channel = channel_instance->channel;
+    Type* type = channel->type();
+    ChannelLayout& layout = channels.emplace_back();
+    layout.name = channel_name_counts[channel->name()] == 1
+                      ? channel->name()
+                      : channel_instance->ToString();
+    layout.enum_name = absl::AsciiStrToUpper(absl::StrCat(
+        options.name, "_CHANNEL_", ToCIdentifier(layout.name)));
+    layout.element_size = runtime.GetTypeByteSize(type);
+    int64_t alignment =
+        std::max(kMinElementAlignment, runtime.GetTypeAlignment(type));
+    layout.stride =
+        RoundUp(std::max<int64_t>(layout.element_size, 1), alignment);
+    max_stride = std::max(max_stride, layout.stride);
+    layout.initial_value_count = channel->initial_values().size();
+    layout.capacity =
+        std::max(options.channel_capacity, layout.initial_value_count);
+    layout.offset = allocate(layout.capacity * layout.stride, alignment);
+    for (const Value& value : channel->initial_values()) {
+      std::vector<uint8_t> bytes(layout.element_size);
+      runtime.BlitValueToBuffer(value, type, absl::MakeSpan(bytes));
+      layout.initial_values.insert(layout.initial_values.end(), bytes.begin(),
+                                   bytes.end());
+    }
+    if (!layout.initial_values.empty()) {
+      absl::StrAppendFormat(&constants,
+                            "alignas(%d) constexpr uint8_t "
+                            "kChannelInitialValues%d[] = %s;\n",
+                            kMinElementAlignment, channels.size() - 1,
+                            ByteList(layout.initial_values));
+    }
+    channel_indices[channel_instance] = channels.size() - 1;
+  }
+
+  std::vector<InstanceLayout> instances;
+  std::vector<Proc*> procs_with_constants;
+  int64_t max_state_elements = 1;
+  int64_t max_queues = 1;
+  // Ticking producers before consumers runs feed-forward networks in a single
+  // pass over the instances.
+  XLS_ASSIGN_OR_RETURN(std::vector<ProcInstance*> tick_order,
+                       elaboration.GetProcInstancesInDataflowOrder());
+  for (ProcInstance* proc_instance : tick_order) {
+    Proc* proc = proc_instance->proc();
+    auto it = entrypoints.find(proc);
+    XLS_RET_CHECK(it != entrypoints.end())
+        << "No compiled code for proc " << proc->name();
+    const JittedFunctionBase& jit_info = it->second->jit_info;
+    XLS_RET_CHECK_EQ(jit_info.input_buffer_sizes().size(),
+                     proc->GetStateElementCount());
+
+    InstanceLayout& layout = instances.emplace_back();
+    layout.name = proc_instance->GetName();
+    layout.symbol = jit_info.function_name();
+    layout.has_next_values = !proc->next_values().empty();
+    auto proc_it = std::find(procs_with_constants.begin(),
+                             procs_with_constants.end(), proc);
+    layout.proc_index = proc_it - procs_with_constants.begin();
+    if (proc_it == procs_with_constants.end()) {
+      procs_with_constants.push_back(proc);
+      for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+        StateElement* state_element = proc->GetStateElement(i);
+        std::vector<uint8_t> bytes(jit_info.input_buffer_sizes()[i]);
+        if (bytes.empty()) {
+          continue;
+        }
+        runtime.BlitValueToBuffer(state_element->initial_value(),
+                                  state_element->type(),
+                                  absl::MakeSpan(bytes));
+        absl::StrAppendFormat(
+            &constants,
+            "alignas(%d) constexpr uint8_t kInitialState%d_%d[] = %s;\n",
+            jit_info.input_buffer_preferred_alignments()[i], layout.proc_index,
+            i, ByteList(bytes));
+      }
+    }
+
+    layout.state.resize(proc->GetStateElementCount());
+    for (int64_t side = 0; side < 2; ++side) {
+      for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+        layout.state[i].size = jit_info.input_buffer_sizes()[i];
+        layout.state[i].offsets[side] =
+            allocate(jit_info.input_buffer_sizes()[i],
+                     jit_info.input_buffer_preferred_alignments()[i]);
+      }
+    }
+    layout.temp_offset = allocate(jit_info.temp_buffer_size(),
+                                  jit_info.temp_buffer_alignment());
+
+    layout.queue_channels.resize(jit_info.queue_indices().size());
+    for (const auto& [channel_name, queue_index] : jit_info.queue_indices()) {
+      XLS_ASSIGN_OR_RETURN(
+          ChannelInstance * channel_instance,
+          GetChannelInstance(elaboration, proc_instance, channel_name));
+      XLS_RET_CHECK_LT(queue_index, layout.queue_channels.size());
+      layout.queue_channels[queue_index] = channel_indices.at(channel_instance);
+    }
+    max_state_elements =
+        std::max(max_state_elements, proc->GetStateElementCount());
+    max_queues = std::max<int64_t>(max_queues, layout.queue_channels.size());
+  }
+
+  std::string channel_enum;
+  std::string channel_infos;
+  for (int64_t i = 0; i < channels.size(); ++i) {
+    const ChannelLayout& layout = channels[i];
+    absl::StrAppendFormat(&channel_enum, "  %s = %d,\n", layout.enum_name, i);
+    absl::StrAppendFormat(
+        &channel_infos, "    {%s, %d, %d, %d, %d, %s, %d},\n",
+        CStringLiteral(layout.name), layout.element_size, layout.stride,
+        layout.capacity, layout.offset,
+        layout.initial_values.empty()
+            ? "nullptr"
+            : absl::StrCat("kChannelInitialValues", i),
+        layout.initial_value_count);
+  }
+  if (channels.empty()) {
+    // Arrays can't be empty; this entry is never used.
+    channel_infos = "    {\"\", 0, 1, 1, 0, nullptr, 0},\n";
+  }
+
+  std::string entry_declarations;
+  std::vector<std::string_view> declared;
+  std::string instance_infos;
+  for (const InstanceLayout& layout : instances) {
+    if (std::find(declared.begin(), declared.end(), layout.symbol) ==
+        declared.end()) {
+      declared.push_back(layout.symbol);
+      absl::StrAppendFormat(
+          &entry_declarations,
+          "int64_t %s(const uint8_t* const* inputs, uint8_t* const* outputs,\n"
+          "    void* temp_buffer, void* events, void* instance_context,\n"
+          "    void* jit_runtime, int64_t continuation_point);\n",
+          layout.symbol);
+    }
+    std::vector<std::string> sizes;
+    std::vector<std::string> offsets[2];
+    std::vector<std::string> initial_state;
+    for (int64_t i = 0; i < layout.state.size(); ++i) {
+      sizes.push_back(absl::StrCat(layout.state[i].size));
+      offsets[0].push_back(absl::StrCat(layout.state[i].offsets[0]));
+      offsets[1].push_back(absl::StrCat(layout.state[i].offsets[1]));
+      initial_state.push_back(
+          layout.state[i].size == 0
+              ? "nullptr"
+              : absl::StrFormat("kInitialState%d_%d", layout.proc_index, i));
+    }
+    absl::StrAppendFormat(
+        &instance_infos,
+        "    {%s, &%s, %d, {%s}, {{%s}, {%s}}, {%s}, %d, {%s}, %s},\n",
+        CStringLiteral(layout.name), layout.symbol, layout.state.size(),
+        absl::StrJoin(sizes, ", "), absl::StrJoin(offsets[0], ", "),
+        absl::StrJoin(offsets[1], ", "), absl::StrJoin(initial_state, ", "),
+        layout.temp_offset, absl::StrJoin(layout.queue_channels, ", "),
+        layout.has_next_values ? "true" : "false");
+  }
+
+  std::string vtable_entries;
+  for (const std::string& function : vtable) {
+    absl::StrAppendFormat(&vtable_entries,
+                          "    reinterpret_cast<void (*)()>(&%s),\n", function);
+  }
+
+  std::string upper = absl::AsciiStrToUpper(options.name);
+  std::string top_name =
+      elaboration.top() != nullptr
+          ? elaboration.top()->proc()->name()
+          : elaboration.proc_instances().front()->proc()->package()->name();
+  StandaloneProcNetworkSources sources;
+  sources.header = absl::StrReplaceAll(
+      kHeaderTemplate, {{"{guard}", absl::StrCat(upper, "_H_")},
+                        {"{top}", top_name},
+                        {"{channel_enum}", channel_enum},
+                        {"{upper}", upper},
+                        {"{channel_count}", absl::StrCat(channels.size())},
+                        {"{name}", options.name}});
+  sources.source = absl::StrReplaceAll(
+      kSourceTemplate,
+      {{"{header}", options.header_include_path},
+       {"{entry_declarations}", entry_declarations},
+       {"{arena_size}", absl::StrCat(std::max<int64_t>(arena_size, 1))},
+       {"{arena_alignment}", absl::StrCat(kArenaAlignment)},
+       {"{channel_count}", absl::StrCat(channels.size())},
+       {"{instance_count}", absl::StrCat(instances.size())},
+       {"{max_state_elements}", absl::StrCat(max_state_elements)},
+       {"{max_queues}", absl::StrCat(max_queues)},
+       {"{vtable_length}", absl::StrCat(InstanceContext::kVTableLength)},
+       {"{max_stride}", absl::StrCat(max_stride)},
+       {"{constants}", constants},
+       {"{channel_infos}", channel_infos},
+       {"{instance_infos}", instance_infos},
+       {"{vtable}", vtable_entries},
+       {"{name}", options.name}});
+  return sources;
+}
+
+}  // namespace xls
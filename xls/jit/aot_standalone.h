@@ -0,0 +1,65 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_AOT_STANDALONE_H_
+#define XLS_JIT_AOT_STANDALONE_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/proc_elaboration.h"
+#include "xls/jit/function_base_jit.h"
+
+namespace xls {
+
+// Sources of a self-contained library running an AOT-compiled proc network.
+struct StandaloneProcNetworkSources {
+  // C header declaring the interface of the network.
+  std::string header;
+  // C++ source implementing it. It only depends on the C++ standard library
+  // and the object code of the procs, not on the XLS runtime.
+  std::string source;
+};
+
+struct StandaloneProcNetworkOptions {
+  // Name of the network, used as the prefix of every symbol in the interface.
+  // Must be a valid C identifier.
+  std::string name;
+  // Path by which the source includes the header.
+  std::string header_include_path;
+  // Number of values each channel can hold. Channels with more initial values
+  // are made large enough to hold them.
+  int64_t channel_capacity = 64;
+};
+
+// Generates the sources of a library running the procs of `elaboration`
+// compiled into `object_code` (see CreateProcAotObjectCode) without the XLS
+// runtime. The library owns a fixed-layout arena holding the state of every
+// proc instance and a ring buffer per channel instance, and ticks the procs
+// with a serial scheduler loop. Channel values are in the native data layout
+// of the JIT (see TypeLayout).
+//
+// Traces are dropped and the object code must have been compiled without
+// msan or observer callbacks, and without calls to the wide arithmetic kernels
+// (`include_wide_arithmetic_calls` of CreateProcAotObjectCode), which the
+// library does not include; such calls put the network in an error state.
+absl::StatusOr<StandaloneProcNetworkSources> GenerateStandaloneProcNetwork(
+    const ProcElaboration& elaboration, const JitObjectCode& object_code,
+    const StandaloneProcNetworkOptions& options);
+
+}  // namespace xls
+
+#endif  // XLS_JIT_AOT_STANDALONE_H_
@@ -0,0 +1,119 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/aot_standalone.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc_elaboration.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/jit_proc_runtime.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::AllOf;
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+constexpr char kNetwork[] = R"(
+package network
+
+chan in(bits[32], id=0, kind=streaming, ops=receive_only, flow_control=ready_valid)
+chan mid(bits[32], id=1, kind=streaming, ops=send_receive, flow_control=ready_valid)
+chan out(bits[32], id=2, kind=streaming, ops=send_only, flow_control=ready_valid)
+
+proc doubler(count: bits[32], init={5}) {
+  tkn: token = literal(value=token)
+  count: bits[32] = state_read(state_element=count)
+  rcv: (token, bits[32]) = receive(tkn, channel=in)
+  rcv_tkn: token = tuple_index(rcv, index=0)
+  x: bits[32] = tuple_index(rcv, index=1)
+  doubled: bits[32] = add(x, x)
+  snd: token = send(rcv_tkn, doubled, channel=mid)
+  one: bits[32] = literal(value=1)
+  next_count: bits[32] = add(count, one)
+  next_count_value: () = next_value(param=count, value=next_count)
+}
+
+proc incrementer() {
+  tkn: token = literal(value=token)
+  rcv: (token, bits[32]) = receive(tkn, channel=mid)
+  rcv_tkn: token = tuple_index(rcv, index=0)
+  x: bits[32] = tuple_index(rcv, index=1)
+  one: bits[32] = literal(value=1)
+  y: bits[32] = add(x, one)
+  snd: token = send(rcv_tkn, y, channel=out)
+}
+)";
+
+TEST(AotStandaloneTest, GeneratesNetwork) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kNetwork));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      JitObjectCode object_code,
+      CreateProcAotObjectCode(package.get(), /*with_msan=*/false));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ProcElaboration elaboration,
+      ProcElaboration::ElaborateOldStylePackage(package.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      StandaloneProcNetworkSources sources,
+      GenerateStandaloneProcNetwork(elaboration, object_code,
+                                    {.name = "pipeline",
+                                     .header_include_path = "pipeline.h",
+                                     .channel_capacity = 8}));
+
+  EXPECT_THAT(sources.header,
+              AllOf(HasSubstr("#ifndef PIPELINE_H_"),
+                    HasSubstr("PIPELINE_CHANNEL_IN = 0,"),
+                    HasSubstr("PIPELINE_CHANNEL_OUT = 2,"),
+                    HasSubstr("PIPELINE_CHANNEL_COUNT = 3,"),
+                    HasSubstr("pipeline* pipeline_create(void);"),
+                    HasSubstr("int64_t pipeline_tick(pipeline* network);")));
+  EXPECT_THAT(sources.source,
+              AllOf(HasSubstr("#include \"pipeline.h\""),
+                    HasSubstr("constexpr int kInstanceCount = 2;"),
+                    HasSubstr(object_code.entrypoints[0]
+                                  .jit_info.function_name()),
+                    HasSubstr(object_code.entrypoints[1]
+                                  .jit_info.function_name()),
+                    HasSubstr("kInitialState"),
+                    Not(HasSubstr("absl")), Not(HasSubstr("xls/"))));
+}
+
+TEST(AotStandaloneTest, RejectsInvalidName) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(kNetwork));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      JitObjectCode object_code,
+      CreateProcAotObjectCode(package.get(), /*with_msan=*/false));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ProcElaboration elaboration,
+      ProcElaboration::ElaborateOldStylePackage(package.get()));
+  EXPECT_THAT(
+      GenerateStandaloneProcNetwork(elaboration, object_code,
+                                    {.name = "my-network"}),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("C identifier")));
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,86 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Runs a standalone network, generated by aot_compiler_main from
+// wide_arithmetic_network.ir, computing 256-bit products and quotients. The
+// network has no wide arithmetic kernels so LLVM must lower these itself.
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/jit/wide_arithmetic_network.h"
+
+namespace xls {
+namespace {
+
+constexpr int64_t kBitCount = 256;
+
+Bits Words(uint64_t w3, uint64_t w2, uint64_t w1, uint64_t w0) {
+  return bits_ops::Concat({UBits(w3, 64), UBits(w2, 64), UBits(w1, 64),
+                           UBits(w0, 64)});
+}
+
+TEST(AotStandaloneWideArithmeticTest, MultipliesAndDivides) {
+  wide_arithmetic_network* network = wide_arithmetic_network_create();
+  ASSERT_NE(network, nullptr);
+  ASSERT_EQ(wide_arithmetic_network_channel_element_size(
+                WIDE_ARITHMETIC_NETWORK_CHANNEL_LHS),
+            kBitCount / 8);
+
+  struct Operands {
+    Bits lhs;
+    Bits rhs;
+  };
+  std::vector<Operands> operands = {
+      {Words(0x0123456789abcdef, 0xfedcba9876543210, 0x0f1e2d3c4b5a6978,
+             0x8796a5b4c3d2e1f0),
+       Words(0, 0, 0x3, 0xc0ffee0123456789)},
+      {Words(0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff,
+             0xffffffffffffffff),
+       Words(0, 0x1, 0x8000000000000000, 0x1)},
+      {Words(0, 0, 0, 1000), Words(0x1, 0, 0, 0)},
+  };
+  for (const Operands& op : operands) {
+    std::vector<uint8_t> lhs = op.lhs.ToBytes();
+    std::vector<uint8_t> rhs = op.rhs.ToBytes();
+    ASSERT_TRUE(wide_arithmetic_network_channel_send(
+        network, WIDE_ARITHMETIC_NETWORK_CHANNEL_LHS, lhs.data()));
+    ASSERT_TRUE(wide_arithmetic_network_channel_send(
+        network, WIDE_ARITHMETIC_NETWORK_CHANNEL_RHS, rhs.data()));
+  }
+  ASSERT_GE(wide_arithmetic_network_run_until_blocked(network, /*max_ticks=*/0),
+            0)
+      << wide_arithmetic_network_error(network);
+
+  for (const Operands& op : operands) {
+    std::vector<uint8_t> product(kBitCount / 8);
+    std::vector<uint8_t> quotient(kBitCount / 8);
+    ASSERT_TRUE(wide_arithmetic_network_channel_receive(
+        network, WIDE_ARITHMETIC_NETWORK_CHANNEL_PRODUCT, product.data()));
+    ASSERT_TRUE(wide_arithmetic_network_channel_receive(
+        network, WIDE_ARITHMETIC_NETWORK_CHANNEL_QUOTIENT, quotient.data()));
+    EXPECT_EQ(product,
+              bits_ops::UMul(op.lhs, op.rhs).Slice(0, kBitCount).ToBytes());
+    EXPECT_EQ(quotient, bits_ops::UDiv(op.lhs, op.rhs).ToBytes());
+  }
+  EXPECT_EQ(wide_arithmetic_network_error(network), nullptr);
+  wide_arithmetic_network_destroy(network);
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,289 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_channel_driver.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/ir/value_utils.h"
+#include "xls/jit/block_jit.h"
+
+namespace xls {
+namespace {
+
+absl::StatusOr<int64_t> GetPortIndex(
+    const absl::flat_hash_map<std::string, int64_t>& indices,
+    std::string_view port, std::string_view channel) {
+  auto it = indices.find(port);
+  if (it == indices.end()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Block has no port `%s` of channel `%s`", port, channel));
+  }
+  return it->second;
+}
+
+}  // namespace
+
+/* static */ absl::StatusOr<std::unique_ptr<BlockChannelDriver>>
+BlockChannelDriver::Create(BlockJitContinuation* continuation,
+                           absl::Span<const ChannelPorts> inputs,
+                           absl::Span<const ChannelPorts> outputs) {
+  const BlockJit::InterfaceMetadata& metadata = continuation->jit()->metadata();
+  absl::flat_hash_map<std::string, int64_t> input_ports =
+      continuation->GetInputPortIndices();
+  absl::flat_hash_map<std::string, int64_t> output_ports =
+      continuation->GetOutputPortIndices();
+
+  // Channels into the block read their ready from an output port and drive
+  // their data and valid on input ports; channels out of the block are the
+  // other way around.
+  auto make_channels = [&](absl::Span<const ChannelPorts> channel_ports,
+                           bool into_block)
+      -> absl::StatusOr<std::vector<Channel>> {
+    const absl::flat_hash_map<std::string, int64_t>& driven =
+        into_block ? input_ports : output_ports;
+    const absl::flat_hash_map<std::string, int64_t>& sampled =
+        into_block ? output_ports : input_ports;
+    absl::Span<Type* const> driven_types =
+        into_block ? metadata.input_port_types : metadata.output_port_types;
+    absl::Span<Type* const> sampled_types =
+        into_block ? metadata.output_port_types : metadata.input_port_types;
+    absl::Span<const int64_t> driven_sizes =
+        into_block ? continuation->jit()->input_port_sizes()
+                   : continuation->jit()->output_port_sizes();
+    std::vector<Channel> channels;
+    channels.reserve(channel_ports.size());
+    for (const ChannelPorts& ports : channel_ports) {
+      Channel channel{.name = ports.name, .type = nullptr, .data_port = -1,
+                      .size = 0};
+      XLS_ASSIGN_OR_RETURN(channel.valid_port,
+                           GetPortIndex(driven, ports.valid, ports.name));
+      XLS_ASSIGN_OR_RETURN(channel.ready_port,
+                           GetPortIndex(sampled, ports.ready, ports.name));
+      if (!driven_types[channel.valid_port]->IsBits() ||
+          driven_types[channel.valid_port]->GetFlatBitCount() != 1 ||
+          !sampled_types[channel.ready_port]->IsBits() ||
+          sampled_types[channel.ready_port]->GetFlatBitCount() != 1) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Ready and valid ports of channel `%s` must be bits[1]",
+            ports.name));
+      }
+      if (!ports.data.empty()) {
+        XLS_ASSIGN_OR_RETURN(channel.data_port,
+                             GetPortIndex(driven, ports.data, ports.name));
+        channel.type = driven_types[channel.data_port];
+        channel.size = driven_sizes[channel.data_port];
+      }
+      channels.push_back(std::move(channel));
+    }
+    return channels;
+  };
+  XLS_ASSIGN_OR_RETURN(std::vector<Channel> input_channels,
+                       make_channels(inputs, /*into_block=*/true));
+  XLS_ASSIGN_OR_RETURN(std::vector<Channel> output_channels,
+                       make_channels(outputs, /*into_block=*/false));
+  return absl::WrapUnique(new BlockChannelDriver(
+      continuation, std::move(input_channels), std::move(output_channels),
+      std::move(input_ports)));
+}
+
+/* static */ absl::StatusOr<int64_t> BlockChannelDriver::FindChannel(
+    absl::Span<const Channel> channels, std::string_view name) {
+  auto it = absl::c_find_if(
+      channels, [&](const Channel& channel) { return channel.name == name; });
+  if (it == channels.end()) {
+    return absl::NotFoundError(
+        absl::StrFormat("No channel named `%s` is driven", name));
+  }
+  return it - channels.begin();
+}
+
+absl::Status BlockChannelDriver::SetInputPort(std::string_view port,
+                                              const Value& value) {
+  auto it = input_ports_.find(port);
+  if (it == input_ports_.end()) {
+    return absl::NotFoundError(
+        absl::StrFormat("Block has no input port `%s`", port));
+  }
+  int64_t index = it->second;
+  BlockJit* jit = continuation_->jit();
+  Type* type = jit->metadata().input_port_types[index];
+  if (!ValueConformsToType(value, type)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Value %s does not match type %s of input port `%s`",
+                        value.ToString(), type->ToString(), port));
+  }
+  jit->runtime()->BlitValueToBuffer(
+      value, type,
+      absl::MakeSpan(continuation_->input_port_pointers()[index],
+                     jit->input_port_sizes()[index]));
+  return absl::OkStatus();
+}
+
+absl::Status BlockChannelDriver::Send(std::string_view channel_name,
+                                      const Value& value) {
+  XLS_ASSIGN_OR_RETURN(int64_t index, FindChannel(inputs_, channel_name));
+  Channel* channel = &inputs_[index];
+  if (channel->data_port >= 0) {
+    if (!ValueConformsToType(value, channel->type)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Value %s does not match type %s of channel `%s`",
+                          value.ToString(), channel->type->ToString(),
+                          channel_name));
+    }
+    channel->values.resize(channel->values.size() + channel->size);
+    continuation_->jit()->runtime()->BlitValueToBuffer(
+        value, channel->type,
+        absl::MakeSpan(channel->values).last(channel->size));
+  }
+  ++channel->value_count;
+  return absl::OkStatus();
+}
+
+std::vector<Value> BlockChannelDriver::UnpackValues(const Channel& channel,
+                                                    int64_t begin) const {
+  std::vector<Value> values;
+  values.reserve(channel.value_count - begin);
+  for (int64_t i = begin; i < channel.value_count; ++i) {
+    values.push_back(channel.data_port < 0
+                         ? Value::Tuple({})
+                         : continuation_->jit()->runtime()->UnpackBuffer(
+                               channel.values.data() + i * channel.size,
+                               channel.type));
+  }
+  return values;
+}
+
+absl::StatusOr<std::vector<Value>> BlockChannelDriver::GetPendingInputs(
+    std::string_view channel_name) const {
+  XLS_ASSIGN_OR_RETURN(int64_t index, FindChannel(inputs_, channel_name));
+  return UnpackValues(inputs_[index], inputs_[index].accepted);
+}
+
+absl::StatusOr<std::vector<Value>> BlockChannelDriver::GetReceived(
+    std::string_view channel_name) const {
+  XLS_ASSIGN_OR_RETURN(int64_t index, FindChannel(outputs_, channel_name));
+  return UnpackValues(outputs_[index], 0);
+}
+
+absl::StatusOr<int64_t> BlockChannelDriver::GetReceivedCount(
+    std::string_view channel_name) const {
+  XLS_ASSIGN_OR_RETURN(int64_t index, FindChannel(outputs_, channel_name));
+  return outputs_[index].value_count;
+}
+
+absl::Status BlockChannelDriver::SetReceiveTarget(std::string_view channel_name,
+                                                  int64_t count) {
+  XLS_RET_CHECK_GE(count, 0);
+  XLS_ASSIGN_OR_RETURN(int64_t index, FindChannel(outputs_, channel_name));
+  outputs_[index].target = count;
+  return absl::OkStatus();
+}
+
+void BlockChannelDriver::DriveHandshakes(bool idle) {
+  absl::Span<uint8_t* const> ports = continuation_->input_port_pointers();
+  for (const Channel& channel : inputs_) {
+    bool valid = !idle && channel.accepted < channel.value_count;
+    *ports[channel.valid_port] = valid ? 1 : 0;
+    if (valid && channel.data_port >= 0) {
+      std::memcpy(ports[channel.data_port],
+                  channel.values.data() + channel.accepted * channel.size,
+                  channel.size);
+    }
+  }
+  for (const Channel& channel : outputs_) {
+    *ports[channel.ready_port] = idle ? 0 : 1;
+  }
+}
+
+bool BlockChannelDriver::CompleteTransfers() {
+  absl::Span<uint8_t* const> inputs = continuation_->input_port_pointers();
+  absl::Span<const uint8_t* const> outputs =
+      continuation_->output_port_pointers();
+  for (Channel& channel : inputs_) {
+    if (*inputs[channel.valid_port] != 0 && *outputs[channel.ready_port] != 0) {
+      ++channel.accepted;
+    }
+  }
+  bool received = false;
+  for (Channel& channel : outputs_) {
+    if (*outputs[channel.valid_port] == 0) {
+      continue;
+    }
+    if (channel.data_port >= 0) {
+      const uint8_t* data = outputs[channel.data_port];
+      channel.values.insert(channel.values.end(), data, data + channel.size);
+    }
+    ++channel.value_count;
+    received = true;
+  }
+  return received;
+}
+
+bool BlockChannelDriver::TargetsReached() const {
+  return absl::c_all_of(outputs_, [](const Channel& channel) {
+    return channel.value_count >= channel.target;
+  });
+}
+
+absl::StatusOr<BlockChannelDriver::RunResult> BlockChannelDriver::Run(
+    const RunOptions& options) {
+  BlockJit* jit = continuation_->jit();
+  RunResult result;
+  int64_t idle_cycles = 0;
+  while (!TargetsReached() && result.cycle_count < options.max_cycles &&
+         idle_cycles < options.max_idle_cycles) {
+    size_t assert_count = continuation_->GetEvents().assert_msgs.size();
+    DriveHandshakes(/*idle=*/false);
+    XLS_RETURN_IF_ERROR(jit->RunOneCycle(*continuation_));
+    if (CompleteTransfers()) {
+      result.last_receive_cycle = result.cycle_count;
+      idle_cycles = 0;
+    } else {
+      ++idle_cycles;
+    }
+    ++result.cycle_count;
+    if (options.stop_on_assert &&
+        continuation_->GetEvents().assert_msgs.size() > assert_count) {
+      break;
+    }
+  }
+  result.targets_reached = TargetsReached();
+  return result;
+}
+
+absl::Status BlockChannelDriver::RunIdleCycle() {
+  DriveHandshakes(/*idle=*/true);
+  return continuation_->jit()->RunOneCycle(*continuation_);
+}
+
+}  // namespace xls
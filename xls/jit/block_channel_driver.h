@@ -0,0 +1,159 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_BLOCK_CHANNEL_DRIVER_H_
+#define XLS_JIT_BLOCK_CHANNEL_DRIVER_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/jit/block_jit.h"
+
+namespace xls {
+
+// Streams values through the ready/valid channels of a jitted block. Values
+// sent to the block are converted once to the native data layout of the JIT
+// and queued in a flat buffer per channel; values received are appended to a
+// flat buffer per channel and only converted back when asked for. Each cycle
+// the driver copies the head of every input queue into the data port, sets
+// the valid ports, runs the block and checks the handshake signals straight
+// from the JIT port buffers, so no Value or port map is built per cycle.
+//
+// Input channels are driven valid whenever they have a value left and output
+// channels are always ready. FIFOs inside the block (see MaterializeFifosPass)
+// are compiled into the block and need no driving.
+class BlockChannelDriver {
+ public:
+  // Ports of a ready/valid channel of the block. `data` is empty for channels
+  // without a data port.
+  struct ChannelPorts {
+    std::string name;
+    std::string data;
+    std::string valid;
+    std::string ready;
+  };
+
+  // Creates a driver of the channels `inputs` (into the block) and `outputs`
+  // (out of the block) of the block run by `continuation`.
+  static absl::StatusOr<std::unique_ptr<BlockChannelDriver>> Create(
+      BlockJitContinuation* continuation, absl::Span<const ChannelPorts> inputs,
+      absl::Span<const ChannelPorts> outputs);
+
+  // Sets an input port which is not part of a channel, e.g. a reset. The port
+  // keeps the value until set again.
+  absl::Status SetInputPort(std::string_view port, const Value& value);
+
+  // Queues `value` to be sent on input channel `channel`.
+  absl::Status Send(std::string_view channel, const Value& value);
+  // Returns the values queued on input channel `channel` which the block has
+  // not accepted yet.
+  absl::StatusOr<std::vector<Value>> GetPendingInputs(
+      std::string_view channel) const;
+
+  // Returns the values received from output channel `channel` so far.
+  absl::StatusOr<std::vector<Value>> GetReceived(
+      std::string_view channel) const;
+  absl::StatusOr<int64_t> GetReceivedCount(std::string_view channel) const;
+
+  // Makes Run stop once output channel `channel` has received `count` values
+  // and every other output channel with a target has reached its own.
+  absl::Status SetReceiveTarget(std::string_view channel, int64_t count);
+
+  struct RunOptions {
+    int64_t max_cycles = std::numeric_limits<int64_t>::max();
+    // Stop after this many consecutive cycles in which no output channel
+    // received a value.
+    int64_t max_idle_cycles = std::numeric_limits<int64_t>::max();
+    // Stop after a cycle in which an assertion fired.
+    bool stop_on_assert = false;
+  };
+  struct RunResult {
+    int64_t cycle_count = 0;
+    // Index among the cycles run of the last one in which an output channel
+    // received a value, or -1 if there was none.
+    int64_t last_receive_cycle = -1;
+    // Whether every output channel with a target has reached it.
+    bool targets_reached = false;
+  };
+  // Runs cycles of the block until every receive target is reached or one of
+  // the limits of `options` is hit. Events of the cycles accumulate in the
+  // continuation.
+  absl::StatusOr<RunResult> Run(const RunOptions& options);
+
+  // Runs one cycle with every input channel invalid and every output channel
+  // not ready, e.g. while the block is in reset.
+  absl::Status RunIdleCycle();
+
+ private:
+  struct Channel {
+    std::string name;
+    Type* type;
+    // Index of the data port, or -1 if there is none.
+    int64_t data_port;
+    int64_t valid_port;
+    int64_t ready_port;
+    // Size of a value in the native layout.
+    int64_t size;
+    // Native values back to back: those sent (input channels) or received
+    // (output channels).
+    std::vector<uint8_t> values;
+    int64_t value_count = 0;
+    // Number of values accepted by the block. Input channels only.
+    int64_t accepted = 0;
+    // Receive target. Output channels only.
+    int64_t target = 0;
+  };
+
+  BlockChannelDriver(BlockJitContinuation* continuation,
+                     std::vector<Channel> inputs, std::vector<Channel> outputs,
+                     absl::flat_hash_map<std::string, int64_t> input_ports)
+      : continuation_(continuation),
+        inputs_(std::move(inputs)),
+        outputs_(std::move(outputs)),
+        input_ports_(std::move(input_ports)) {}
+
+  // Returns the index of the channel named `name` in `channels`.
+  static absl::StatusOr<int64_t> FindChannel(absl::Span<const Channel> channels,
+                                             std::string_view name);
+  std::vector<Value> UnpackValues(const Channel& channel, int64_t begin) const;
+
+  // Sets the valid and data ports of the input channels and the ready ports of
+  // the output channels. If `idle` every valid and ready is deasserted.
+  void DriveHandshakes(bool idle);
+  // Completes the transfers of the cycle just run. Returns whether an output
+  // channel received a value.
+  bool CompleteTransfers();
+  bool TargetsReached() const;
+
+  BlockJitContinuation* continuation_;
+  std::vector<Channel> inputs_;
+  std::vector<Channel> outputs_;
+  // Indices of the input ports by name.
+  absl::flat_hash_map<std::string, int64_t> input_ports_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_BLOCK_CHANNEL_DRIVER_H_
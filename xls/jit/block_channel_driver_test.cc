@@ -0,0 +1,154 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_channel_driver.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/block.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/value.h"
+#include "xls/jit/block_jit.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+class BlockChannelDriverTest : public IrTestBase {
+ protected:
+  // Builds a block passing channel `in` through a FIFO of depth 4 to channel
+  // `out`.
+  absl::StatusOr<Block*> BuildFifoBlock(Package* p) {
+    BlockBuilder bb(TestName(), p);
+    XLS_RETURN_IF_ERROR(bb.AddClockPort("clk"));
+    XLS_ASSIGN_OR_RETURN(FifoInstantiation * fifo,
+                         bb.block()->AddFifoInstantiation(
+                             "fifo",
+                             FifoConfig(/*depth=*/4, /*bypass=*/false,
+                                        /*register_push_outputs=*/false,
+                                        /*register_pop_outputs=*/false),
+                             p->GetBitsType(32)));
+    bb.InstantiationInput(fifo, "rst", bb.InputPort("rst", p->GetBitsType(1)));
+    bb.InstantiationInput(fifo, "push_data",
+                          bb.InputPort("in_data", p->GetBitsType(32)));
+    bb.InstantiationInput(fifo, "push_valid",
+                          bb.InputPort("in_valid", p->GetBitsType(1)));
+    bb.OutputPort("in_ready", bb.InstantiationOutput(fifo, "push_ready"));
+    bb.OutputPort("out_data", bb.InstantiationOutput(fifo, "pop_data"));
+    bb.OutputPort("out_valid", bb.InstantiationOutput(fifo, "pop_valid"));
+    bb.InstantiationInput(fifo, "pop_ready",
+                          bb.InputPort("out_ready", p->GetBitsType(1)));
+    return bb.Build();
+  }
+
+  absl::StatusOr<std::unique_ptr<BlockChannelDriver>> CreateDriver(
+      BlockJitContinuation* continuation) {
+    return BlockChannelDriver::Create(continuation,
+                                      {{.name = "in",
+                                        .data = "in_data",
+                                        .valid = "in_valid",
+                                        .ready = "in_ready"}},
+                                      {{.name = "out",
+                                        .data = "out_data",
+                                        .valid = "out_valid",
+                                        .ready = "out_ready"}});
+  }
+};
+
+TEST_F(BlockChannelDriverTest, StreamsThroughFifo) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, BuildFifoBlock(p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  auto cont = jit->NewContinuation();
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockChannelDriver> driver,
+                           CreateDriver(cont.get()));
+
+  XLS_ASSERT_OK(driver->SetInputPort("rst", Value(UBits(1, 1))));
+  XLS_ASSERT_OK(driver->RunIdleCycle());
+  XLS_ASSERT_OK(driver->SetInputPort("rst", Value(UBits(0, 1))));
+
+  std::vector<Value> sent;
+  for (int64_t i = 0; i < 100; ++i) {
+    sent.push_back(Value(UBits(i * 7919, 32)));
+    XLS_ASSERT_OK(driver->Send("in", sent.back()));
+  }
+  XLS_ASSERT_OK(driver->SetReceiveTarget("out", 100));
+  XLS_ASSERT_OK_AND_ASSIGN(BlockChannelDriver::RunResult result,
+                           driver->Run({.max_cycles = 1000}));
+  EXPECT_TRUE(result.targets_reached);
+  EXPECT_EQ(result.last_receive_cycle, result.cycle_count - 1);
+  EXPECT_THAT(driver->GetReceived("out"), IsOkAndHolds(ElementsAreArray(sent)));
+  EXPECT_THAT(driver->GetPendingInputs("in"), IsOkAndHolds(IsEmpty()));
+}
+
+TEST_F(BlockChannelDriverTest, StopsWhenIdle) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, BuildFifoBlock(p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  auto cont = jit->NewContinuation();
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockChannelDriver> driver,
+                           CreateDriver(cont.get()));
+  XLS_ASSERT_OK(driver->SetInputPort("rst", Value(UBits(1, 1))));
+  XLS_ASSERT_OK(driver->RunIdleCycle());
+  XLS_ASSERT_OK(driver->SetInputPort("rst", Value(UBits(0, 1))));
+
+  XLS_ASSERT_OK(driver->Send("in", Value(UBits(42, 32))));
+  XLS_ASSERT_OK(driver->SetReceiveTarget("out", 2));
+  XLS_ASSERT_OK_AND_ASSIGN(BlockChannelDriver::RunResult result,
+                           driver->Run({.max_idle_cycles = 10}));
+  EXPECT_FALSE(result.targets_reached);
+  EXPECT_EQ(result.cycle_count, result.last_receive_cycle + 11);
+  EXPECT_THAT(driver->GetReceivedCount("out"), IsOkAndHolds(1));
+}
+
+TEST_F(BlockChannelDriverTest, RejectsUnknownPorts) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, BuildFifoBlock(p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  auto cont = jit->NewContinuation();
+  EXPECT_THAT(
+      BlockChannelDriver::Create(cont.get(),
+                                 {{.name = "in",
+                                   .data = "in_data",
+                                   .valid = "in_vld",
+                                   .ready = "in_ready"}},
+                                 {}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockChannelDriver> driver,
+                           CreateDriver(cont.get()));
+  EXPECT_THAT(driver->Send("out", Value(UBits(1, 32))),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(driver->Send("in", Value(UBits(1, 8))),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,6 +14,8 @@
 
 #include "xls/jit/block_jit.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -25,6 +27,7 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -36,6 +39,7 @@
 #include "xls/codegen/codegen_options.h"
 #include "xls/codegen/codegen_pass.h"
 #include "xls/codegen/materialize_fifos_pass.h"
+#include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/block_evaluator.h"
@@ -49,6 +53,7 @@
 #include "xls/ir/instantiation.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
 #include "xls/ir/package.h"
 #include "xls/ir/register.h"
 #include "xls/ir/type.h"
@@ -234,6 +239,12 @@ absl::StatusOr<ElaborationJitData> CloneElaborationPackage(
   };
 }
 
+bool HasEventOps(Block* block) {
+  return absl::c_any_of(block->nodes(), [](Node* node) {
+    return node->OpIn({Op::kAssert, Op::kCover, Op::kTrace});
+  });
+}
+
 }  // namespace
 
 /* static */ absl::StatusOr<BlockJit::InterfaceMetadata>
@@ -349,9 +360,11 @@ absl::StatusOr<std::unique_ptr<BlockJit>> BlockJit::Create(
                          InterfaceMetadata::CreateFromBlock(block));
     XLS_ASSIGN_OR_RETURN(auto function,
                          JittedFunctionBase::Build(block, *orc_jit));
-    return std::unique_ptr<BlockJit>(new BlockJit(
+    auto jit = std::unique_ptr<BlockJit>(new BlockJit(
         std::move(metadata), std::move(jit_runtime), std::move(orc_jit),
         std::move(function), support_observer_callbacks));
+    jit->has_event_ops_ = HasEventOps(block);
+    return jit;
   }
   XLS_ASSIGN_OR_RETURN(ElaborationJitData jit_data,
                        CloneElaborationPackage(elab));
@@ -370,11 +383,13 @@ absl::StatusOr<std::unique_ptr<BlockJit>> BlockJit::Create(
                          metadata.type_manager.MapTypeFromOtherArena(reg_type));
     reg_type = mapped_type;
   }
-  return std::unique_ptr<BlockJit>(new ElaboratedBlockJit(
+  auto jit = std::unique_ptr<BlockJit>(new ElaboratedBlockJit(
       std::move(metadata), std::move(jit_data.renamed_registers),
       std::move(jit_data.added_registers), std::move(jit_runtime),
       std::move(orc_jit), std::move(jit_entrypoint),
       support_observer_callbacks));
+  jit->has_event_ops_ = HasEventOps(jit_data.inlined_block);
+  return jit;
 }
 
 /* static */ absl::StatusOr<std::unique_ptr<BlockJit>> BlockJit::CreateFromAot(
@@ -411,9 +426,10 @@ absl::StatusOr<std::unique_ptr<BlockJit>> BlockJit::Create(
 
 /* static */ absl::StatusOr<JitObjectCode> BlockJit::CreateObjectCode(
     const BlockElaboration& elab, int64_t opt_level, bool include_msan,
-    JitObserver* obs) {
+    JitObserver* obs, std::optional<std::string> target_cpu) {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<AotCompiler> comp,
-                       AotCompiler::Create(include_msan, opt_level, obs));
+                       AotCompiler::Create(include_msan, opt_level, obs,
+                                           std::move(target_cpu)));
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout, comp->CreateDataLayout());
   // NB We could avoid doing a package clone if there are no instantations but
   // since this is aot anyway its easier to just not bother. The cloned package
@@ -445,6 +461,14 @@ std::unique_ptr<BlockJitContinuation> BlockJit::NewContinuation() {
 }
 
 absl::Status BlockJit::RunOneCycle(BlockJitContinuation& continuation) {
+  if (continuation.skip_unchanged_cycles_) {
+    if (continuation.observer() != nullptr) {
+      continuation.has_last_evaluated_state_ = false;
+    } else if (continuation.MatchesLastEvaluatedCycle()) {
+      ++continuation.skipped_cycle_count_;
+      return absl::OkStatus();
+    }
+  }
   function_.RunJittedFunction(
       continuation.input_buffers_.current(),
       continuation.output_buffers_.current(), continuation.temp_buffer_,
@@ -455,6 +479,146 @@ absl::Status BlockJit::RunOneCycle(BlockJitContinuation& continuation) {
   return absl::OkStatus();
 }
 
+/* static */ BlockJit::CycleFrameLayout BlockJit::MakeCycleFrameLayout(
+    absl::Span<const int64_t> sizes, absl::Span<const int64_t> alignments) {
+  CycleFrameLayout layout;
+  layout.offsets.reserve(sizes.size());
+  int64_t offset = 0;
+  for (int64_t i = 0; i < sizes.size(); ++i) {
+    offset = RoundUpToNearest(offset, alignments[i]);
+    layout.offsets.push_back(offset);
+    offset += sizes[i];
+    layout.alignment = std::max(layout.alignment, alignments[i]);
+  }
+  layout.stride = RoundUpToNearest(offset, layout.alignment);
+  return layout;
+}
+
+absl::Status BlockJit::RunCycles(BlockJitContinuation& continuation,
+                                 int64_t cycle_count,
+                                 absl::Span<const uint8_t> input_stream,
+                                 absl::Span<uint8_t> output_sink) {
+  XLS_RET_CHECK_GE(cycle_count, 0);
+  auto check_stream = [&](const uint8_t* data, int64_t size,
+                          const CycleFrameLayout& layout,
+                          std::string_view name) -> absl::Status {
+    if (size < cycle_count * layout.stride) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "%s holds %d bytes but %d cycles require %d bytes", name, size,
+          cycle_count, cycle_count * layout.stride));
+    }
+    if (absl::bit_cast<uintptr_t>(data) % layout.alignment != 0) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "%s must be aligned to %d bytes", name, layout.alignment));
+    }
+    return absl::OkStatus();
+  };
+  XLS_RETURN_IF_ERROR(check_stream(input_stream.data(), input_stream.size(),
+                                   input_frame_layout_, "Input stream"));
+  XLS_RETURN_IF_ERROR(check_stream(output_sink.data(), output_sink.size(),
+                                   output_frame_layout_, "Output sink"));
+  if (cycle_count == 0) {
+    return absl::OkStatus();
+  }
+  // The outputs of the last cycle evaluated by RunOneCycle are about to be
+  // overwritten.
+  continuation.has_last_evaluated_state_ = false;
+
+  // The register halves of the argument vectors alternate between the two
+  // register spaces every cycle. Snapshot both parities up front so that only
+  // the port pointers need to be rebased each cycle.
+  std::array<std::vector<const uint8_t*>, 2> inputs;
+  std::array<std::vector<uint8_t*>, 2> outputs;
+  for (int64_t parity = 0; parity < 2; ++parity) {
+    absl::Span<uint8_t* const> in = continuation.function_inputs();
+    absl::Span<uint8_t* const> out = continuation.function_outputs();
+    inputs[parity].assign(in.begin(), in.end());
+    outputs[parity].assign(out.begin(), out.end());
+    continuation.SwapRegisters();
+  }
+
+  const int64_t input_count = metadata_.InputPortCount();
+  const int64_t output_count = metadata_.OutputPortCount();
+  const uint8_t* input_frame = input_stream.data();
+  uint8_t* output_frame = output_sink.data();
+  for (int64_t cycle = 0; cycle < cycle_count; ++cycle) {
+    std::vector<const uint8_t*>& cycle_inputs = inputs[cycle & 1];
+    std::vector<uint8_t*>& cycle_outputs = outputs[cycle & 1];
+    for (int64_t i = 0; i < input_count; ++i) {
+      cycle_inputs[i] = input_frame + input_frame_layout_.offsets[i];
+    }
+    for (int64_t i = 0; i < output_count; ++i) {
+      cycle_outputs[i] = output_frame + output_frame_layout_.offsets[i];
+    }
+    function_.RunUnalignedJittedFunction</*kForceZeroCopy=*/true>(
+        cycle_inputs.data(), cycle_outputs.data(),
+        continuation.temp_buffer_.get(), &continuation.GetEvents(),
+        /*instance_context=*/&continuation.callbacks_, runtime_.get(),
+        /*continuation_point=*/0);
+    input_frame += input_frame_layout_.stride;
+    output_frame += output_frame_layout_.stride;
+  }
+  if (cycle_count % 2 == 1) {
+    continuation.SwapRegisters();
+  }
+
+  // Leave the continuation's ports as if the last cycle had been run with
+  // RunOneCycle.
+  const uint8_t* last_inputs = input_frame - input_frame_layout_.stride;
+  const uint8_t* last_outputs = output_frame - output_frame_layout_.stride;
+  for (int64_t i = 0; i < input_count; ++i) {
+    memcpy(continuation.input_port_pointers()[i],
+           last_inputs + input_frame_layout_.offsets[i],
+           input_port_sizes()[i]);
+  }
+  for (int64_t i = 0; i < output_count; ++i) {
+    memcpy(continuation.function_outputs()[i],
+           last_outputs + output_frame_layout_.offsets[i],
+           output_port_sizes()[i]);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status BlockJitContinuation::SetSkipUnchangedCycles(bool skip) {
+  if (skip && block_jit_->has_event_ops()) {
+    return absl::FailedPreconditionError(
+        "Cycles of blocks with assert, cover or trace operations cannot be "
+        "skipped");
+  }
+  skip_unchanged_cycles_ = skip;
+  has_last_evaluated_state_ = false;
+  return absl::OkStatus();
+}
+
+bool BlockJitContinuation::MatchesLastEvaluatedCycle() {
+  absl::Span<uint8_t* const> inputs = function_inputs();
+  absl::Span<const int64_t> port_sizes = block_jit_->input_port_sizes();
+  absl::Span<const int64_t> register_sizes = block_jit_->register_sizes();
+  auto size_of = [&](int64_t i) {
+    return i < port_sizes.size() ? port_sizes[i]
+                                 : register_sizes[i - port_sizes.size()];
+  };
+  if (has_last_evaluated_state_) {
+    int64_t offset = 0;
+    bool matches = true;
+    for (int64_t i = 0; i < inputs.size() && matches; ++i) {
+      matches = std::memcmp(last_evaluated_state_.data() + offset, inputs[i],
+                            size_of(i)) == 0;
+      offset += size_of(i);
+    }
+    if (matches) {
+      return true;
+    }
+  }
+  last_evaluated_state_.clear();
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    last_evaluated_state_.insert(last_evaluated_state_.end(), inputs[i],
+                                 inputs[i] + size_of(i));
+  }
+  has_last_evaluated_state_ = true;
+  return false;
+}
+
 absl::StatusOr<JitArgumentSet> BlockJitContinuation::CombineBuffers(
     const JittedFunctionBase& jit_func, const JitArgumentSet& left,
     int64_t left_count, const JitArgumentSet& rest, int64_t rest_start,
@@ -725,9 +889,20 @@ namespace {
 class BlockContinuationJitWrapper final : public BlockContinuation {
  public:
   BlockContinuationJitWrapper(std::unique_ptr<BlockJitContinuation>&& cont,
-                              std::unique_ptr<BlockJit>&& jit)
+                              std::shared_ptr<BlockJit> jit)
       : continuation_(std::move(cont)), jit_(std::move(jit)) {}
+
+  // Returns a new continuation of the same compiled block with the registers
+  // of this one.
+  absl::StatusOr<std::unique_ptr<BlockContinuationJitWrapper>> Clone() const {
+    std::unique_ptr<BlockJitContinuation> cont = jit_->NewContinuation();
+    XLS_RETURN_IF_ERROR(cont->SetRegisters(continuation_->GetRegistersMap()));
+    return std::make_unique<BlockContinuationJitWrapper>(std::move(cont), jit_);
+  }
   JitRuntime* runtime() const { return jit_->runtime(); }
+  BlockJitContinuation* jit_continuation() const {
+    return continuation_.get();
+  }
   const absl::flat_hash_map<std::string, Value>& output_ports() final {
     if (!temporary_outputs_) {
       temporary_outputs_.emplace(continuation_->GetOutputPortsMap());
@@ -749,6 +924,16 @@ class BlockContinuationJitWrapper final : public BlockContinuation {
     XLS_RETURN_IF_ERROR(continuation_->SetInputPorts(inputs));
     return jit_->RunOneCycle(*continuation_);
   }
+  absl::Status RunOneCycleWithPortValues(absl::Span<const Value> inputs) final {
+    temporary_outputs_.reset();
+    temporary_regs_.reset();
+    continuation_->ClearEvents();
+    XLS_RETURN_IF_ERROR(continuation_->SetInputPorts(inputs));
+    return jit_->RunOneCycle(*continuation_);
+  }
+  std::vector<Value> output_port_values() final {
+    return continuation_->GetOutputPorts();
+  }
   absl::Status SetRegisters(
       const absl::flat_hash_map<std::string, Value>& regs) final {
     temporary_regs_.reset();
@@ -776,7 +961,8 @@ class BlockContinuationJitWrapper final : public BlockContinuation {
 
  private:
   std::unique_ptr<BlockJitContinuation> continuation_;
-  std::unique_ptr<BlockJit> jit_;
+  // Shared by continuations created with Clone.
+  std::shared_ptr<BlockJit> jit_;
   // Holder for the data we return out of output_ports so that we can reduce
   // copying.
   std::optional<absl::flat_hash_map<std::string, Value>> temporary_outputs_;
@@ -803,6 +989,22 @@ JitBlockEvaluator::MakeNewContinuation(
                                                        std::move(jit));
 }
 
+absl::StatusOr<std::vector<std::unique_ptr<BlockContinuation>>>
+JitBlockEvaluator::NewContinuations(Block* block, int64_t count) const {
+  // Compile the block once for all the continuations.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BlockContinuation> first,
+                       NewContinuation(block));
+  auto* first_wrapper = dynamic_cast<BlockContinuationJitWrapper*>(first.get());
+  XLS_RET_CHECK(first_wrapper != nullptr);
+  std::vector<std::unique_ptr<BlockContinuation>> continuations;
+  continuations.reserve(count);
+  for (int64_t i = 1; i < count; ++i) {
+    XLS_ASSIGN_OR_RETURN(continuations.emplace_back(), first_wrapper->Clone());
+  }
+  continuations.push_back(std::move(first));
+  return continuations;
+}
+
 absl::StatusOr<JitRuntime*> JitBlockEvaluator::GetRuntime(
     BlockContinuation* cont) const {
   BlockContinuationJitWrapper* cont_wrap =
@@ -813,4 +1015,14 @@ absl::StatusOr<JitRuntime*> JitBlockEvaluator::GetRuntime(
   return cont_wrap->runtime();
 }
 
+absl::StatusOr<BlockJitContinuation*> JitBlockEvaluator::GetJitContinuation(
+    BlockContinuation* cont) const {
+  BlockContinuationJitWrapper* cont_wrap =
+      dynamic_cast<BlockContinuationJitWrapper*>(cont);
+  if (cont_wrap == nullptr) {
+    return absl::InvalidArgumentError("Not a jit continuation");
+  }
+  return cont_wrap->jit_continuation();
+}
+
 }  // namespace xls
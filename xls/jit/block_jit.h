@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <initializer_list>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -82,9 +83,10 @@ class BlockJit {
       JitFunctionType func_ptr);
 
   // Returns the bytes of an object file containing the compiled XLS function.
+  // See AotCompiler::Create for the meaning of `target_cpu`.
   static absl::StatusOr<JitObjectCode> CreateObjectCode(
       const BlockElaboration& elab, int64_t opt_level, bool include_msan,
-      JitObserver* obs);
+      JitObserver* obs, std::optional<std::string> target_cpu = std::nullopt);
 
   virtual ~BlockJit() = default;
 
@@ -95,8 +97,39 @@ class BlockJit {
   // Runs a single cycle of a block with the given continuation.
   virtual absl::Status RunOneCycle(BlockJitContinuation& continuation);
 
+  // Layout of one cycle's worth of port values ("a frame") in the packed
+  // streams used by RunCycles. The value of port `i` is stored in the native
+  // LLVM data layout `offsets[i]` bytes from the start of the frame. Frames
+  // are laid out back to back `stride` bytes apart and the stream must be
+  // aligned to `alignment` bytes.
+  struct CycleFrameLayout {
+    std::vector<int64_t> offsets;
+    int64_t stride = 0;
+    int64_t alignment = 1;
+  };
+  const CycleFrameLayout& input_frame_layout() const {
+    return input_frame_layout_;
+  }
+  const CycleFrameLayout& output_frame_layout() const {
+    return output_frame_layout_;
+  }
+
+  // Runs `cycle_count` cycles of the block with the given continuation. The
+  // input ports for cycle `c` are read from frame `c` of `input_stream` and the
+  // output ports of cycle `c` are written to frame `c` of `output_sink` (see
+  // input_frame_layout() and output_frame_layout()). The streams are passed to
+  // the jitted code in place so no values are marshaled between cycles and
+  // registers stay in the continuation's buffers throughout. Afterwards the
+  // continuation's ports hold the values of the last cycle.
+  absl::Status RunCycles(BlockJitContinuation& continuation,
+                         int64_t cycle_count,
+                         absl::Span<const uint8_t> input_stream,
+                         absl::Span<uint8_t> output_sink);
+
   OrcJit& orc_jit() const { return *jit_; }
 
+  const InterfaceMetadata& metadata() const { return metadata_; }
+
   JitRuntime* runtime() const { return runtime_.get(); }
 
   // Get how large each pointer buffer for the input ports are.
@@ -111,8 +144,18 @@ class BlockJit {
         .subspan(metadata_.InputPortCount());
   }
 
+  // Get how large each pointer buffer for the output ports are.
+  absl::Span<const int64_t> output_port_sizes() const {
+    return absl::MakeConstSpan(function_.output_buffer_sizes())
+        .subspan(0, metadata_.OutputPortCount());
+  }
+
   bool supports_observer() const { return supports_observer_; }
 
+  // Whether the block has operations producing events (assert, cover and
+  // trace). Always true for AOT-compiled blocks, whose nodes are unknown.
+  bool has_event_ops() const { return has_event_ops_; }
+
  protected:
   BlockJit(InterfaceMetadata&& metadata, std::unique_ptr<JitRuntime>&& runtime,
            std::unique_ptr<OrcJit>&& jit, JittedFunctionBase&& function,
@@ -121,13 +164,27 @@ class BlockJit {
         runtime_(std::move(runtime)),
         jit_(std::move(jit)),
         function_(std::move(function)),
-        supports_observer_(supports_observer) {}
+        supports_observer_(supports_observer),
+        input_frame_layout_(MakeCycleFrameLayout(
+            input_port_sizes(),
+            function_.input_buffer_preferred_alignments().subspan(
+                0, metadata_.InputPortCount()))),
+        output_frame_layout_(MakeCycleFrameLayout(
+            output_port_sizes(),
+            function_.output_buffer_preferred_alignments().subspan(
+                0, metadata_.OutputPortCount()))) {}
+
+  static CycleFrameLayout MakeCycleFrameLayout(
+      absl::Span<const int64_t> sizes, absl::Span<const int64_t> alignments);
 
   InterfaceMetadata metadata_;
   std::unique_ptr<JitRuntime> runtime_;
   std::unique_ptr<OrcJit> jit_;
   JittedFunctionBase function_;
   bool supports_observer_;
+  bool has_event_ops_ = true;
+  CycleFrameLayout input_frame_layout_;
+  CycleFrameLayout output_frame_layout_;
 };
 
 class BlockJitContinuation {
@@ -236,6 +293,8 @@ class BlockJitContinuation {
 
   const JitTempBuffer& temp_buffer() const { return temp_buffer_; }
 
+  BlockJit* jit() const { return block_jit_; }
+
   absl::Status SetObserver(RuntimeObserver* obs) {
     if (!block_jit_->supports_observer()) {
       return absl::UnimplementedError("runtime observer not supported");
@@ -246,6 +305,17 @@ class BlockJitContinuation {
   void ClearObserver() { callbacks_.observer = nullptr; }
   RuntimeObserver* observer() const { return callbacks_.observer; }
 
+  // Makes RunOneCycle skip cycles whose input ports and registers hold the
+  // same bytes as in the last evaluated cycle. Such a cycle cannot change any
+  // output port or register so the continuation is left as is, which makes
+  // the idle cycles of mostly idle blocks nearly free at the cost of comparing
+  // the ports and registers every cycle. Cycles run with an observer set or by
+  // RunCycles are always evaluated. Returns an error if the block has
+  // operations producing events, which would be lost.
+  absl::Status SetSkipUnchangedCycles(bool skip);
+  // Number of cycles RunOneCycle has skipped.
+  int64_t skipped_cycle_count() const { return skipped_cycle_count_; }
+
  protected:
   BlockJitContinuation(const BlockJit::InterfaceMetadata& metadata,
                        BlockJit* jit, const JittedFunctionBase& jit_func);
@@ -281,6 +351,11 @@ class BlockJitContinuation {
     return output_buffers_.current().pointers();
   }
 
+  // Returns whether the input ports and registers hold the same bytes as when
+  // the last cycle was evaluated. Otherwise records them as those of the cycle
+  // about to be evaluated.
+  bool MatchesLastEvaluatedCycle();
+
   const BlockJit::InterfaceMetadata& metadata_;
   BlockJit* block_jit_;
 
@@ -310,6 +385,13 @@ class BlockJitContinuation {
 
   InterpreterEvents events_;
 
+  bool skip_unchanged_cycles_ = false;
+  // Bytes of the input ports followed by those of the registers in the last
+  // cycle evaluated by RunOneCycle. Only valid if `has_last_evaluated_state_`.
+  std::vector<uint8_t> last_evaluated_state_;
+  bool has_last_evaluated_state_ = false;
+  int64_t skipped_cycle_count_ = 0;
+
   friend class BlockJit;
 };
 
@@ -321,12 +403,17 @@ class JitBlockEvaluator : public BlockEvaluator {
       : BlockEvaluator(supports_observer ? "ObservableJit" : "Jit"),
         supports_observer_(supports_observer) {}
   absl::StatusOr<JitRuntime*> GetRuntime(BlockContinuation* cont) const;
+  // Returns the block JIT continuation wrapped by `cont`.
+  absl::StatusOr<BlockJitContinuation*> GetJitContinuation(
+      BlockContinuation* cont) const;
 
  protected:
   absl::StatusOr<std::unique_ptr<BlockContinuation>> MakeNewContinuation(
       BlockElaboration&& elaboration,
       const absl::flat_hash_map<std::string, Value>& initial_registers)
       const override;
+  absl::StatusOr<std::vector<std::unique_ptr<BlockContinuation>>>
+  NewContinuations(Block* block, int64_t count) const override;
 
  private:
   bool supports_observer_;
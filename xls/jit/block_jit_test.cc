@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -26,6 +27,7 @@
 #include "absl/status/status_matchers.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "xls/common/math_util.h"
 #include "xls/common/status/matchers.h"
 #include "xls/interpreter/block_evaluator_test_base.h"
 #include "xls/interpreter/block_interpreter.h"
@@ -47,6 +49,7 @@ namespace {
 using ::absl_testing::StatusIs;
 using ::testing::ContainsRegex;
 using ::testing::ElementsAre;
+using ::testing::HasSubstr;
 
 class BlockJitTest : public IrTestBase {};
 TEST_F(BlockJitTest, ConstantToPort) {
@@ -147,6 +150,162 @@ TEST_F(BlockJitTest, SetInputsWithViews) {
               testing::ElementsAre(Value(UBits(42, 16))));
 }
 
+TEST_F(BlockJitTest, RunCyclesMatchesRunOneCycle) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(auto r,
+                           bb.block()->AddRegister("acc", p->GetBitsType(64)));
+  auto in_wide = bb.InputPort("in_wide", p->GetBitsType(32));
+  auto in_narrow = bb.InputPort("in_narrow", p->GetBitsType(8));
+  auto acc = bb.RegisterRead(r);
+  bb.RegisterWrite(r, bb.Add(acc, bb.Add(bb.ZeroExtend(in_wide, 64),
+                                         bb.ZeroExtend(in_narrow, 64))));
+  bb.OutputPort("low", bb.BitSlice(acc, /*start=*/0, /*width=*/8));
+  bb.OutputPort("acc", acc);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, bb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  const BlockJit::CycleFrameLayout& in_layout = jit->input_frame_layout();
+  const BlockJit::CycleFrameLayout& out_layout = jit->output_frame_layout();
+  ASSERT_LE(in_layout.alignment, alignof(uint64_t));
+  ASSERT_LE(out_layout.alignment, alignof(uint64_t));
+
+  // Use an odd number of cycles so the register spaces end up swapped.
+  constexpr int64_t kCycles = 101;
+  std::vector<uint64_t> input_storage(
+      CeilOfRatio<int64_t>(kCycles * in_layout.stride, sizeof(uint64_t)));
+  std::vector<uint64_t> output_storage(
+      CeilOfRatio<int64_t>(kCycles * out_layout.stride, sizeof(uint64_t)));
+  absl::Span<uint8_t> input_stream(
+      reinterpret_cast<uint8_t*>(input_storage.data()),
+      kCycles * in_layout.stride);
+  absl::Span<uint8_t> output_sink(
+      reinterpret_cast<uint8_t*>(output_storage.data()),
+      kCycles * out_layout.stride);
+
+  std::vector<std::vector<Value>> inputs;
+  for (int64_t cycle = 0; cycle < kCycles; ++cycle) {
+    inputs.push_back({Value(UBits(cycle * 1000003, 32)),
+                      Value(UBits(cycle % 256, 8))});
+    uint8_t* frame = input_stream.data() + cycle * in_layout.stride;
+    jit->runtime()->BlitValueToBuffer(
+        inputs.back()[0], p->GetBitsType(32),
+        absl::MakeSpan(frame + in_layout.offsets[0], 4));
+    jit->runtime()->BlitValueToBuffer(
+        inputs.back()[1], p->GetBitsType(8),
+        absl::MakeSpan(frame + in_layout.offsets[1], 1));
+  }
+
+  auto batch = jit->NewContinuation();
+  XLS_ASSERT_OK(batch->SetRegisters({Value(UBits(7, 64))}));
+  XLS_ASSERT_OK(jit->RunCycles(*batch, kCycles, input_stream, output_sink));
+
+  auto reference = jit->NewContinuation();
+  XLS_ASSERT_OK(reference->SetRegisters({Value(UBits(7, 64))}));
+  for (int64_t cycle = 0; cycle < kCycles; ++cycle) {
+    XLS_ASSERT_OK(reference->SetInputPorts(inputs[cycle]));
+    XLS_ASSERT_OK(jit->RunOneCycle(*reference));
+    const uint8_t* frame = output_sink.data() + cycle * out_layout.stride;
+    EXPECT_EQ(jit->runtime()->UnpackBuffer(frame + out_layout.offsets[0],
+                                           p->GetBitsType(8)),
+              reference->GetOutputPorts()[0])
+        << cycle;
+    EXPECT_EQ(jit->runtime()->UnpackBuffer(frame + out_layout.offsets[1],
+                                           p->GetBitsType(64)),
+              reference->GetOutputPorts()[1])
+        << cycle;
+  }
+  EXPECT_EQ(batch->GetRegisters(), reference->GetRegisters());
+  EXPECT_EQ(batch->GetOutputPorts(), reference->GetOutputPorts());
+
+  // Running more cycles afterwards with RunOneCycle continues from the state
+  // left by RunCycles.
+  XLS_ASSERT_OK(batch->SetInputPorts(inputs[1]));
+  XLS_ASSERT_OK(reference->SetInputPorts(inputs[1]));
+  XLS_ASSERT_OK(jit->RunOneCycle(*batch));
+  XLS_ASSERT_OK(jit->RunOneCycle(*reference));
+  EXPECT_EQ(batch->GetRegisters(), reference->GetRegisters());
+}
+
+TEST_F(BlockJitTest, RunCyclesRejectsShortStreams) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  bb.OutputPort("out", bb.InputPort("in", p->GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, bb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  auto cont = jit->NewContinuation();
+
+  std::vector<uint64_t> storage(4);
+  absl::Span<uint8_t> buffer(reinterpret_cast<uint8_t*>(storage.data()),
+                             storage.size() * sizeof(uint64_t));
+  EXPECT_THAT(jit->RunCycles(*cont, 100, buffer, buffer),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("100 cycles require")));
+}
+
+TEST_F(BlockJitTest, SkipUnchangedCycles) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(auto r,
+                           bb.block()->AddRegister("count", p->GetBitsType(8)));
+  auto enable = bb.InputPort("enable", p->GetBitsType(1));
+  auto count = bb.RegisterRead(r);
+  bb.RegisterWrite(r, bb.Select(enable, bb.Add(count, bb.Literal(UBits(1, 8))),
+                                count));
+  bb.OutputPort("count_out", count);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, bb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  auto cont = jit->NewContinuation();
+  XLS_ASSERT_OK(cont->SetSkipUnchangedCycles(true));
+  XLS_ASSERT_OK(cont->SetRegisters({Value(UBits(0, 8))}));
+
+  auto run = [&](int64_t cycles, bool enabled) {
+    XLS_ASSERT_OK(cont->SetInputPorts({Value(UBits(enabled, 1))}));
+    for (int64_t i = 0; i < cycles; ++i) {
+      XLS_ASSERT_OK(jit->RunOneCycle(*cont));
+    }
+  };
+  run(3, true);
+  EXPECT_EQ(cont->skipped_cycle_count(), 0);
+  EXPECT_THAT(cont->GetRegisters(), ElementsAre(Value(UBits(3, 8))));
+
+  // The first idle cycle is evaluated as the input changed. The rest are
+  // skipped.
+  run(10, false);
+  EXPECT_EQ(cont->skipped_cycle_count(), 9);
+  EXPECT_THAT(cont->GetRegisters(), ElementsAre(Value(UBits(3, 8))));
+  EXPECT_THAT(cont->GetOutputPorts(), ElementsAre(Value(UBits(3, 8))));
+
+  // Changing a register makes the next cycle be evaluated.
+  XLS_ASSERT_OK(cont->SetRegisters({Value(UBits(42, 8))}));
+  run(2, false);
+  EXPECT_EQ(cont->skipped_cycle_count(), 10);
+  EXPECT_THAT(cont->GetOutputPorts(), ElementsAre(Value(UBits(42, 8))));
+
+  run(2, true);
+  EXPECT_EQ(cont->skipped_cycle_count(), 10);
+  EXPECT_THAT(cont->GetRegisters(), ElementsAre(Value(UBits(44, 8))));
+  EXPECT_THAT(cont->GetOutputPorts(), ElementsAre(Value(UBits(43, 8))));
+}
+
+TEST_F(BlockJitTest, SkipUnchangedCyclesRejectsEvents) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  auto in = bb.InputPort("in", p->GetBitsType(1));
+  bb.Assert(bb.AfterAll({}), in, "in is zero");
+  bb.OutputPort("out", in);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, bb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  auto cont = jit->NewContinuation();
+  EXPECT_THAT(cont->SetSkipUnchangedCycles(true),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("cannot be skipped")));
+  XLS_EXPECT_OK(cont->SetSkipUnchangedCycles(false));
+}
+
 TEST_F(BlockJitTest, SetRegistersImmediatelyVisible) {
   auto p = CreatePackage();
   BlockBuilder bb(TestName(), p.get());
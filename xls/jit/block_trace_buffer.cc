@@ -0,0 +1,161 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_trace_buffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/codegen/flattening.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/jit/block_jit.h"
+
+namespace xls {
+namespace {
+
+// Returns the short identifier VCD uses to refer to the `index`-th variable.
+// Identifiers are made of the printable ASCII characters.
+std::string VcdIdentifier(int64_t index) {
+  std::string id;
+  do {
+    id.push_back(static_cast<char>('!' + index % 94));
+    index /= 94;
+  } while (index > 0);
+  return id;
+}
+
+std::string VcdValue(const Bits& bits, std::string_view id) {
+  if (bits.bit_count() == 1) {
+    return absl::StrCat(bits.Get(0) ? "1" : "0", id, "\n");
+  }
+  std::string digits;
+  digits.reserve(bits.bit_count());
+  for (int64_t i = bits.bit_count() - 1; i >= 0; --i) {
+    digits.push_back(bits.Get(i) ? '1' : '0');
+  }
+  return absl::StrCat("b", digits, " ", id, "\n");
+}
+
+}  // namespace
+
+/* static */ absl::StatusOr<std::unique_ptr<BlockTraceBuffer>>
+BlockTraceBuffer::Create(BlockJit* jit, int64_t capacity) {
+  if (capacity <= 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Trace buffer capacity must be positive, got %d", capacity));
+  }
+  const BlockJit::InterfaceMetadata& metadata = jit->metadata();
+  std::vector<Signal> signals;
+  int64_t frame_size = 0;
+  auto add_signals = [&](absl::Span<const std::string> names,
+                         absl::Span<Type* const> types,
+                         absl::Span<const int64_t> sizes) {
+    for (int64_t i = 0; i < names.size(); ++i) {
+      signals.push_back(Signal{.name = names[i],
+                               .type = types[i],
+                               .offset = frame_size,
+                               .size = sizes[i]});
+      frame_size += sizes[i];
+    }
+  };
+  add_signals(metadata.input_port_names, metadata.input_port_types,
+              jit->input_port_sizes());
+  add_signals(metadata.register_names, metadata.register_types,
+              jit->register_sizes());
+  add_signals(metadata.output_port_names, metadata.output_port_types,
+              jit->output_port_sizes());
+  return absl::WrapUnique(
+      new BlockTraceBuffer(jit, capacity, std::move(signals), frame_size));
+}
+
+void BlockTraceBuffer::BeginCycle(const BlockJitContinuation& continuation) {
+  uint8_t* frame = CurrentFrame();
+  absl::Span<uint8_t* const> registers = continuation.register_pointers();
+  int64_t first = jit_->metadata().InputPortCount();
+  for (int64_t i = 0; i < registers.size(); ++i) {
+    const Signal& signal = signals_[first + i];
+    std::memcpy(frame + signal.offset, registers[i], signal.size);
+  }
+}
+
+void BlockTraceBuffer::EndCycle(const BlockJitContinuation& continuation) {
+  uint8_t* frame = CurrentFrame();
+  absl::Span<uint8_t* const> inputs = continuation.input_port_pointers();
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    std::memcpy(frame + signals_[i].offset, inputs[i], signals_[i].size);
+  }
+  absl::Span<const uint8_t* const> outputs =
+      continuation.output_port_pointers();
+  int64_t first = signals_.size() - outputs.size();
+  for (int64_t i = 0; i < outputs.size(); ++i) {
+    const Signal& signal = signals_[first + i];
+    std::memcpy(frame + signal.offset, outputs[i], signal.size);
+  }
+  ++recorded_cycle_count_;
+}
+
+std::string BlockTraceBuffer::ToVcd() const {
+  const BlockJit::InterfaceMetadata& metadata = jit_->metadata();
+  int64_t register_begin = metadata.InputPortCount();
+  int64_t register_end = register_begin + metadata.RegisterCount();
+  std::string vcd = absl::StrFormat(
+      "$timescale 1ns $end\n$scope module %s $end\n", metadata.block_name);
+  for (int64_t i = 0; i < signals_.size(); ++i) {
+    int64_t width = signals_[i].type->GetFlatBitCount();
+    if (width == 0) {
+      continue;
+    }
+    bool is_register = i >= register_begin && i < register_end;
+    absl::StrAppendFormat(&vcd, "$var %s %d %s %s $end\n",
+                          is_register ? "reg" : "wire", width,
+                          VcdIdentifier(i), signals_[i].name);
+  }
+  absl::StrAppend(&vcd, "$upscope $end\n$enddefinitions $end\n");
+
+  std::vector<std::string> last_values(signals_.size());
+  for (int64_t cycle = recorded_cycle_count_ - size();
+       cycle < recorded_cycle_count_; ++cycle) {
+    const uint8_t* frame = frames_.data() + (cycle % capacity_) * frame_size_;
+    absl::StrAppend(&vcd, "#", cycle, "\n");
+    for (int64_t i = 0; i < signals_.size(); ++i) {
+      if (signals_[i].type->GetFlatBitCount() == 0) {
+        continue;
+      }
+      Value value = jit_->runtime()->UnpackBuffer(frame + signals_[i].offset,
+                                                  signals_[i].type);
+      std::string line = VcdValue(FlattenValueToBits(value), VcdIdentifier(i));
+      if (line != last_values[i]) {
+        absl::StrAppend(&vcd, line);
+        last_values[i] = std::move(line);
+      }
+    }
+  }
+  absl::StrAppend(&vcd, "#", recorded_cycle_count_, "\n");
+  return vcd;
+}
+
+}  // namespace xls
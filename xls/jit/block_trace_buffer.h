@@ -0,0 +1,98 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_BLOCK_TRACE_BUFFER_H_
+#define XLS_JIT_BLOCK_TRACE_BUFFER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/type.h"
+#include "xls/jit/block_jit.h"
+
+namespace xls {
+
+// Bounded record of the ports and registers of a jitted block over its last
+// cycles. Recording a cycle copies the raw JIT buffers of the continuation
+// into a ring of frames, so long simulations can keep a trace at the cost of
+// a few memcpys per cycle. Values are only decoded when the trace is dumped,
+// e.g. after an assertion fires.
+//
+// Recording a cycle is split around its evaluation:
+//
+//   trace->BeginCycle(*continuation);
+//   XLS_RETURN_IF_ERROR(jit->RunOneCycle(*continuation));
+//   trace->EndCycle(*continuation);
+//
+// BeginCycle records the registers as the cycle reads them and EndCycle
+// records the input and output ports.
+class BlockTraceBuffer {
+ public:
+  // Creates a buffer holding the last `capacity` cycles of continuations of
+  // `jit`.
+  static absl::StatusOr<std::unique_ptr<BlockTraceBuffer>> Create(
+      BlockJit* jit, int64_t capacity);
+
+  void BeginCycle(const BlockJitContinuation& continuation);
+  void EndCycle(const BlockJitContinuation& continuation);
+
+  int64_t capacity() const { return capacity_; }
+  // Number of cycles recorded, including those since overwritten.
+  int64_t recorded_cycle_count() const { return recorded_cycle_count_; }
+  // Number of cycles currently held.
+  int64_t size() const { return std::min(capacity_, recorded_cycle_count_); }
+
+  // Returns the held cycles as a value change dump (IEEE 1364 VCD). Cycle `c`
+  // of the recording is at time `c` and every port and register is a
+  // variable holding its value flattened to bits.
+  std::string ToVcd() const;
+
+ private:
+  struct Signal {
+    std::string name;
+    Type* type;
+    // Position of the value in a frame.
+    int64_t offset;
+    int64_t size;
+  };
+
+  BlockTraceBuffer(BlockJit* jit, int64_t capacity,
+                   std::vector<Signal> signals, int64_t frame_size)
+      : jit_(jit),
+        capacity_(capacity),
+        signals_(std::move(signals)),
+        frame_size_(frame_size),
+        frames_(capacity * frame_size) {}
+
+  uint8_t* CurrentFrame() {
+    return frames_.data() + (recorded_cycle_count_ % capacity_) * frame_size_;
+  }
+
+  BlockJit* jit_;
+  int64_t capacity_;
+  // The input ports followed by the registers and the output ports.
+  std::vector<Signal> signals_;
+  int64_t frame_size_;
+  std::vector<uint8_t> frames_;
+  int64_t recorded_cycle_count_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_BLOCK_TRACE_BUFFER_H_
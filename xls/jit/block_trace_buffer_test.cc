@@ -0,0 +1,98 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_trace_buffer.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/value.h"
+#include "xls/jit/block_jit.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+
+class BlockTraceBufferTest : public IrTestBase {};
+
+TEST_F(BlockTraceBufferTest, DumpsLastCyclesAsVcd) {
+  auto p = CreatePackage();
+  BlockBuilder bb("counter", p.get());
+  XLS_ASSERT_OK(bb.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(auto r,
+                           bb.block()->AddRegister("count", p->GetBitsType(4)));
+  auto enable = bb.InputPort("enable", p->GetBitsType(1));
+  auto count = bb.RegisterRead(r);
+  bb.RegisterWrite(r, bb.Select(enable, bb.Add(count, bb.Literal(UBits(1, 4))),
+                                count));
+  bb.OutputPort("count_out", count);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, bb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  auto cont = jit->NewContinuation();
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockTraceBuffer> trace,
+                           BlockTraceBuffer::Create(jit.get(), 3));
+  XLS_ASSERT_OK(cont->SetRegisters({Value(UBits(0, 4))}));
+  for (int64_t cycle = 0; cycle < 10; ++cycle) {
+    XLS_ASSERT_OK(cont->SetInputPorts({Value(UBits(cycle != 8, 1))}));
+    trace->BeginCycle(*cont);
+    XLS_ASSERT_OK(jit->RunOneCycle(*cont));
+    trace->EndCycle(*cont);
+  }
+  EXPECT_EQ(trace->recorded_cycle_count(), 10);
+  EXPECT_EQ(trace->size(), 3);
+
+  EXPECT_EQ(trace->ToVcd(), R"($timescale 1ns $end
+$scope module counter $end
+$var wire 1 ! enable $end
+$var reg 4 " count $end
+$var wire 4 # count_out $end
+$upscope $end
+$enddefinitions $end
+#7
+1!
+b0111 "
+b0111 #
+#8
+0!
+b1000 "
+b1000 #
+#9
+1!
+#10
+)");
+}
+
+TEST_F(BlockTraceBufferTest, RejectsEmptyCapacity) {
+  auto p = CreatePackage();
+  BlockBuilder bb("passthrough", p.get());
+  bb.OutputPort("out", bb.InputPort("in", p->GetBitsType(8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * b, bb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, BlockJit::Create(b));
+  EXPECT_THAT(BlockTraceBuffer::Create(jit.get(), 0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,281 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/channel_trace.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>  // NOLINT
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/file/mapped_file.h"
+#include "xls/common/math_util.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/package.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/ir/value_utils.h"
+#include "xls/jit/channel_trace.pb.h"
+#include "xls/jit/jit_channel_queue.h"
+#include "xls/jit/jit_runtime.h"
+#include "xls/jit/type_layout.h"
+
+namespace xls {
+namespace {
+
+constexpr int64_t kIndexSizeBytes = 8;
+constexpr int64_t kHeaderSize = kChannelTraceMagic.size() + kIndexSizeBytes;
+
+std::string EncodeIndexSize(uint64_t size) {
+  std::string bytes(kIndexSizeBytes, '\0');
+  for (int64_t i = 0; i < kIndexSizeBytes; ++i) {
+    bytes[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+  }
+  return bytes;
+}
+
+uint64_t DecodeIndexSize(std::string_view bytes) {
+  uint64_t size = 0;
+  for (int64_t i = 0; i < kIndexSizeBytes; ++i) {
+    size |= uint64_t{static_cast<uint8_t>(bytes[i])} << (8 * i);
+  }
+  return size;
+}
+
+// Returns the offset of the records of the first channel in a trace whose index
+// is `index_size` bytes long.
+int64_t DataStart(int64_t index_size) {
+  return RoundUpToNearest(kHeaderSize + index_size, kChannelTraceAlignment);
+}
+
+}  // namespace
+
+bool IsChannelTrace(std::string_view contents) {
+  return absl::StartsWith(contents, kChannelTraceMagic);
+}
+
+absl::Status ChannelTraceWriter::AddChannel(std::string_view name,
+                                            const TypeLayout& layout) {
+  if (columns_by_name_.contains(name)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Channel trace already has a channel named `%s`", name));
+  }
+  columns_.push_back(std::make_unique<Column>(
+      Column{.name = std::string{name}, .layout = layout}));
+  columns_by_name_[name] = columns_.back().get();
+  return absl::OkStatus();
+}
+
+absl::StatusOr<ChannelTraceWriter::Column*> ChannelTraceWriter::GetColumn(
+    std::string_view name) {
+  auto it = columns_by_name_.find(name);
+  if (it == columns_by_name_.end()) {
+    return absl::NotFoundError(
+        absl::StrFormat("Channel trace has no channel named `%s`", name));
+  }
+  return it->second;
+}
+
+absl::Status ChannelTraceWriter::Write(std::string_view name,
+                                       const Value& value) {
+  XLS_ASSIGN_OR_RETURN(Column * column, GetColumn(name));
+  if (!ValueConformsToType(value, column->layout.type())) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Cannot write %s to channel `%s` of type %s", value.ToString(), name,
+        column->layout.type()->ToString()));
+  }
+  int64_t offset = column->records.size();
+  column->records.resize(offset + column->layout.size());
+  column->layout.ValueToNativeLayout(value, column->records.data() + offset);
+  ++column->count;
+  return absl::OkStatus();
+}
+
+absl::Status ChannelTraceWriter::WriteRaw(std::string_view name,
+                                          absl::Span<const uint8_t> record) {
+  XLS_ASSIGN_OR_RETURN(Column * column, GetColumn(name));
+  if (static_cast<int64_t>(record.size()) != column->layout.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Record for channel `%s` is %d bytes, expected %d", name,
+        record.size(), column->layout.size()));
+  }
+  column->records.insert(column->records.end(), record.begin(), record.end());
+  ++column->count;
+  return absl::OkStatus();
+}
+
+absl::Status ChannelTraceWriter::Finish(
+    const std::filesystem::path& path) const {
+  ChannelTraceIndexProto index;
+  int64_t offset = 0;
+  for (const std::unique_ptr<Column>& column : columns_) {
+    offset = RoundUpToNearest(offset, kChannelTraceAlignment);
+    ChannelTraceIndexProto::Channel* channel = index.add_channels();
+    channel->set_name(column->name);
+    *channel->mutable_layout() = column->layout.ToProto();
+    channel->set_offset(offset);
+    channel->set_count(column->count);
+    offset += column->records.size();
+  }
+  std::string serialized_index = index.SerializeAsString();
+  int64_t data_start = DataStart(serialized_index.size());
+
+  std::ofstream stream(path,
+                       std::ios::out | std::ios::trunc | std::ios::binary);
+  int64_t position = 0;
+  auto write = [&](std::string_view bytes) {
+    stream.write(bytes.data(), bytes.size());
+    position += bytes.size();
+  };
+  auto pad_to = [&](int64_t target) {
+    write(std::string(target - position, '\0'));
+  };
+  write(kChannelTraceMagic);
+  write(EncodeIndexSize(serialized_index.size()));
+  write(serialized_index);
+  for (int64_t i = 0; i < columns_.size(); ++i) {
+    pad_to(data_start + index.channels(i).offset());
+    write(std::string_view(
+        reinterpret_cast<const char*>(columns_[i]->records.data()),
+        columns_[i]->records.size()));
+  }
+  stream.close();
+  if (!stream.good()) {
+    return absl::InternalError(
+        absl::StrFormat("Unable to write channel trace `%s`", path.string()));
+  }
+  return absl::OkStatus();
+}
+
+/* static */ absl::StatusOr<ChannelTrace> ChannelTrace::Open(
+    const std::filesystem::path& path, Package* package) {
+  XLS_ASSIGN_OR_RETURN(MappedFile mapped, MappedFile::Open(path));
+  auto file = std::make_unique<MappedFile>(std::move(mapped));
+  std::string_view contents = file->contents();
+  if (!IsChannelTrace(contents) || contents.size() < kHeaderSize) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("`%s` is not a channel trace", path.string()));
+  }
+  uint64_t index_size = DecodeIndexSize(
+      contents.substr(kChannelTraceMagic.size(), kIndexSizeBytes));
+  ChannelTraceIndexProto index;
+  if (index_size > contents.size() - kHeaderSize ||
+      !index.ParseFromArray(contents.data() + kHeaderSize, index_size)) {
+    return absl::DataLossError(absl::StrFormat(
+        "Channel trace `%s` has a truncated or corrupt index", path.string()));
+  }
+  int64_t data_start = DataStart(index_size);
+
+  std::vector<Channel> channels;
+  channels.reserve(index.channels_size());
+  for (const ChannelTraceIndexProto::Channel& channel : index.channels()) {
+    XLS_ASSIGN_OR_RETURN(TypeLayout layout,
+                         TypeLayout::FromProto(channel.layout(), package));
+    int64_t begin = data_start + channel.offset();
+    if (channel.offset() < 0 || channel.count() < 0 ||
+        begin + channel.count() * layout.size() >
+            static_cast<int64_t>(contents.size())) {
+      return absl::DataLossError(absl::StrFormat(
+          "Records of channel `%s` lie outside of channel trace `%s`",
+          channel.name(), path.string()));
+    }
+    channels.push_back(Channel(
+        channel.name(), std::move(layout),
+        reinterpret_cast<const uint8_t*>(contents.data() + begin),
+        channel.count()));
+  }
+  return ChannelTrace(std::move(file), std::move(channels));
+}
+
+absl::StatusOr<const ChannelTrace::Channel*> ChannelTrace::GetChannel(
+    std::string_view name) const {
+  for (const Channel& channel : channels_) {
+    if (channel.name() == name) {
+      return &channel;
+    }
+  }
+  return absl::NotFoundError(
+      absl::StrFormat("Channel trace has no channel named `%s`", name));
+}
+
+absl::Status EnqueueChannelTrace(const ChannelTrace::Channel& channel,
+                                 JitChannelQueue* queue) {
+  Type* queue_type = queue->channel()->type();
+  TypeLayout queue_layout = queue->jit_runtime()->CreateTypeLayout(queue_type);
+  if (queue_layout.ToString() != channel.layout().ToString()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Layout of channel `%s` in the trace does not match that of channel "
+        "`%s` in the JIT:\n%s\nvs\n%s",
+        channel.name(), queue->channel()->name(), channel.layout().ToString(),
+        queue_layout.ToString()));
+  }
+  for (int64_t i = 0; i < channel.count(); ++i) {
+    uint8_t* slot = queue->AcquireWriteSlot();
+    std::memcpy(slot, channel.record(i), queue_layout.size());
+    queue->CommitWriteSlot();
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<absl::btree_map<std::string, std::vector<Value>>>
+ChannelTraceToChannelValues(const ChannelTrace& trace) {
+  absl::btree_map<std::string, std::vector<Value>> channel_values;
+  for (const ChannelTrace::Channel& channel : trace.channels()) {
+    auto [it, inserted] =
+        channel_values.emplace(channel.name(), std::vector<Value>());
+    if (!inserted) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Channel `%s` appears more than once in the trace", channel.name()));
+    }
+    it->second.reserve(channel.count());
+    for (int64_t i = 0; i < channel.count(); ++i) {
+      it->second.push_back(channel.GetValue(i));
+    }
+  }
+  return channel_values;
+}
+
+absl::Status WriteChannelValuesToTrace(
+    const absl::btree_map<std::string, std::vector<Value>>& channel_values,
+    Package* package, JitRuntime* jit_runtime,
+    const std::filesystem::path& path) {
+  ChannelTraceWriter writer;
+  for (const auto& [name, values] : channel_values) {
+    if (values.empty()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Channel `%s` has no values to derive its type from", name));
+    }
+    Type* type = package->GetTypeForValue(values.front());
+    XLS_RETURN_IF_ERROR(
+        writer.AddChannel(name, jit_runtime->CreateTypeLayout(type)));
+    for (const Value& value : values) {
+      XLS_RETURN_IF_ERROR(writer.Write(name, value));
+    }
+  }
+  return writer.Finish(path);
+}
+
+}  // namespace xls
@@ -0,0 +1,165 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_CHANNEL_TRACE_H_
+#define XLS_JIT_CHANNEL_TRACE_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/common/file/mapped_file.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/jit_channel_queue.h"
+#include "xls/jit/jit_runtime.h"
+#include "xls/jit/type_layout.h"
+
+namespace xls {
+
+// A channel trace is a binary file holding the sequence of values of each of a
+// set of channels. It is meant for simulations with so many values that
+// parsing and printing them as text would dominate. The values of each channel
+// are stored back to back as fixed-size records in the native layout of the
+// JIT (see TypeLayout), so they can be copied into JIT channel queues as they
+// are. The file consists of:
+//
+//   kChannelTraceMagic
+//   the size in bytes of the index, as a little-endian 64-bit integer
+//   the index, a serialized ChannelTraceIndexProto
+//   for each channel, padding to the next multiple of kChannelTraceAlignment
+//   bytes followed by the records of the channel
+//
+// The offsets in the index are relative to the start of the records of the
+// first channel so that they don't depend on the size of the index.
+//
+// Native layouts depend on the host, so the layouts stored in the index are
+// compared against those of the JIT before records are used without
+// conversion.
+inline constexpr std::string_view kChannelTraceMagic = "XLSCHTR1";
+inline constexpr int64_t kChannelTraceAlignment = 64;
+
+// Returns whether `contents` starts like a channel trace.
+bool IsChannelTrace(std::string_view contents);
+
+// Collects the values of channels in memory and writes them out as a channel
+// trace.
+class ChannelTraceWriter {
+ public:
+  // Adds a channel whose values have the given native layout.
+  absl::Status AddChannel(std::string_view name, const TypeLayout& layout);
+
+  // Appends a value to the channel with the given name.
+  absl::Status Write(std::string_view name, const Value& value);
+
+  // Appends a value already in the native layout of the channel.
+  absl::Status WriteRaw(std::string_view name,
+                        absl::Span<const uint8_t> record);
+
+  // Writes all channels to `path`, in the order they were added.
+  absl::Status Finish(const std::filesystem::path& path) const;
+
+ private:
+  struct Column {
+    std::string name;
+    TypeLayout layout;
+    std::vector<uint8_t> records;
+    int64_t count = 0;
+  };
+
+  absl::StatusOr<Column*> GetColumn(std::string_view name);
+
+  std::vector<std::unique_ptr<Column>> columns_;
+  absl::flat_hash_map<std::string, Column*> columns_by_name_;
+};
+
+// A channel trace mapped into memory. Records are read in place from the
+// mapping.
+class ChannelTrace {
+ public:
+  class Channel {
+   public:
+    Channel(std::string name, TypeLayout layout, const uint8_t* records,
+            int64_t count)
+        : name_(std::move(name)),
+          layout_(std::move(layout)),
+          records_(records),
+          count_(count) {}
+
+    std::string_view name() const { return name_; }
+    const TypeLayout& layout() const { return layout_; }
+    int64_t count() const { return count_; }
+
+    // Returns the `i`-th record of the channel, `layout().size()` bytes in the
+    // native layout of the channel's type.
+    const uint8_t* record(int64_t i) const {
+      return records_ + i * layout_.size();
+    }
+
+    Value GetValue(int64_t i) const {
+      return layout_.NativeLayoutToValue(record(i));
+    }
+
+   private:
+    std::string name_;
+    TypeLayout layout_;
+    const uint8_t* records_;
+    int64_t count_;
+  };
+
+  // Opens the channel trace at `path`. The types of the channels are created
+  // in `package`.
+  static absl::StatusOr<ChannelTrace> Open(const std::filesystem::path& path,
+                                           Package* package);
+
+  absl::Span<const Channel> channels() const { return channels_; }
+  absl::StatusOr<const Channel*> GetChannel(std::string_view name) const;
+
+ private:
+  ChannelTrace(std::unique_ptr<MappedFile> file, std::vector<Channel> channels)
+      : file_(std::move(file)), channels_(std::move(channels)) {}
+
+  std::unique_ptr<MappedFile> file_;
+  std::vector<Channel> channels_;
+};
+
+// Writes the records of `channel` to `queue` without converting them to
+// Values. The queue must be of a channel of the same type, and its JIT must
+// use the same native layout as the trace.
+absl::Status EnqueueChannelTrace(const ChannelTrace::Channel& channel,
+                                 JitChannelQueue* queue);
+
+// Converts between channel traces and the channel-to-values maps used by
+// ParseChannelValues and ChannelValuesToProto. The type of each channel is
+// that of its first value, so channels must have at least one value to be
+// written to a trace.
+absl::StatusOr<absl::btree_map<std::string, std::vector<Value>>>
+ChannelTraceToChannelValues(const ChannelTrace& trace);
+absl::Status WriteChannelValuesToTrace(
+    const absl::btree_map<std::string, std::vector<Value>>& channel_values,
+    Package* package, JitRuntime* jit_runtime,
+    const std::filesystem::path& path);
+
+}  // namespace xls
+
+#endif  // XLS_JIT_CHANNEL_TRACE_H_
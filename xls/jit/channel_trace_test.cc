@@ -0,0 +1,171 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/channel_trace.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/btree_map.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/channel_ops.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc_elaboration.h"
+#include "xls/ir/value.h"
+#include "xls/jit/jit_channel_queue.h"
+#include "xls/jit/jit_runtime.h"
+#include "xls/jit/orc_jit.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::Optional;
+
+JitRuntime* GetJitRuntime() {
+  static auto orc_jit = OrcJit::Create().value();
+  static auto jit_runtime =
+      std::make_unique<JitRuntime>(orc_jit->CreateDataLayout().value());
+  return jit_runtime.get();
+}
+
+TEST(ChannelTraceTest, RoundTripChannelValues) {
+  Package package("test");
+  absl::btree_map<std::string, std::vector<Value>> channel_values;
+  channel_values["a"] = {Value(UBits(1, 32)), Value(UBits(0xdeadbeef, 32)),
+                         Value(UBits(3, 32))};
+  channel_values["b"] = {
+      Value::Tuple({Value(UBits(5, 3)),
+                    Value::ArrayOrDie({Value(UBits(1, 17)),
+                                       Value(UBits(0x1ffff, 17))})}),
+      Value::Tuple({Value(UBits(0, 3)),
+                    Value::ArrayOrDie({Value(UBits(7, 17)),
+                                       Value(UBits(8, 17))})})};
+  channel_values["c"] = {Value(UBits(1, 200))};
+  channel_values["d"] = {Value::Tuple({}), Value::Tuple({})};
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file, TempFile::Create());
+  XLS_ASSERT_OK(WriteChannelValuesToTrace(channel_values, &package,
+                                          GetJitRuntime(), file.path()));
+
+  Package read_package("read");
+  XLS_ASSERT_OK_AND_ASSIGN(ChannelTrace trace,
+                           ChannelTrace::Open(file.path(), &read_package));
+  EXPECT_EQ(trace.channels().size(), 4);
+  XLS_ASSERT_OK_AND_ASSIGN(const ChannelTrace::Channel* a,
+                           trace.GetChannel("a"));
+  EXPECT_EQ(a->count(), 3);
+  EXPECT_EQ(a->GetValue(1), Value(UBits(0xdeadbeef, 32)));
+  XLS_ASSERT_OK_AND_ASSIGN(const ChannelTrace::Channel* d,
+                           trace.GetChannel("d"));
+  EXPECT_EQ(d->count(), 2);
+  EXPECT_THAT(trace.GetChannel("e"), StatusIs(absl::StatusCode::kNotFound));
+
+  EXPECT_THAT(ChannelTraceToChannelValues(trace), IsOkAndHolds(channel_values));
+}
+
+TEST(ChannelTraceTest, WriterChecksValues) {
+  Package package("test");
+  ChannelTraceWriter writer;
+  XLS_ASSERT_OK(writer.AddChannel(
+      "a", GetJitRuntime()->CreateTypeLayout(package.GetBitsType(8))));
+  EXPECT_THAT(writer.AddChannel("a", GetJitRuntime()->CreateTypeLayout(
+                                         package.GetBitsType(8))),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("already has a channel named `a`")));
+  EXPECT_THAT(writer.Write("a", Value(UBits(1, 9))),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(writer.Write("b", Value(UBits(1, 8))),
+              StatusIs(absl::StatusCode::kNotFound));
+  std::vector<uint8_t> record = {1, 2};
+  EXPECT_THAT(writer.WriteRaw("a", record),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("is 2 bytes, expected 1")));
+}
+
+TEST(ChannelTraceTest, OpenRejectsOtherFiles) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file,
+                           TempFile::CreateWithContent("a : {\n}\n"));
+  EXPECT_THAT(ChannelTrace::Open(file.path(), &package),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("is not a channel trace")));
+}
+
+TEST(ChannelTraceTest, OpenRejectsTruncatedTraces) {
+  Package package("test");
+  absl::btree_map<std::string, std::vector<Value>> channel_values;
+  channel_values["a"] = {Value(UBits(1, 64)), Value(UBits(2, 64))};
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file, TempFile::Create());
+  XLS_ASSERT_OK(WriteChannelValuesToTrace(channel_values, &package,
+                                          GetJitRuntime(), file.path()));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string contents,
+                           GetFileContents(file.path()));
+  contents.resize(contents.size() - 1);
+  XLS_ASSERT_OK(SetFileContents(file.path(), contents));
+
+  EXPECT_THAT(ChannelTrace::Open(file.path(), &package),
+              StatusIs(absl::StatusCode::kDataLoss,
+                       HasSubstr("lie outside of channel trace")));
+}
+
+TEST(ChannelTraceTest, EnqueueIntoJitChannelQueue) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("in", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+  XLS_ASSERT_OK_AND_ASSIGN(ChannelInstance * instance,
+                           elaboration.GetUniqueInstance(channel));
+  ThreadSafeJitChannelQueue queue(instance, GetJitRuntime());
+
+  absl::btree_map<std::string, std::vector<Value>> channel_values;
+  channel_values["in"] = {Value(UBits(42, 32)), Value(UBits(123, 32))};
+  channel_values["narrow"] = {Value(UBits(1, 16))};
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file, TempFile::Create());
+  XLS_ASSERT_OK(WriteChannelValuesToTrace(channel_values, &package,
+                                          GetJitRuntime(), file.path()));
+  XLS_ASSERT_OK_AND_ASSIGN(ChannelTrace trace,
+                           ChannelTrace::Open(file.path(), &package));
+
+  XLS_ASSERT_OK_AND_ASSIGN(const ChannelTrace::Channel* in,
+                           trace.GetChannel("in"));
+  XLS_ASSERT_OK(EnqueueChannelTrace(*in, &queue));
+  EXPECT_THAT(queue.Read(), Optional(Value(UBits(42, 32))));
+  EXPECT_THAT(queue.Read(), Optional(Value(UBits(123, 32))));
+  EXPECT_TRUE(queue.IsEmpty());
+
+  XLS_ASSERT_OK_AND_ASSIGN(const ChannelTrace::Channel* narrow,
+                           trace.GetChannel("narrow"));
+  EXPECT_THAT(EnqueueChannelTrace(*narrow, &queue),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("does not match")));
+}
+
+}  // namespace
+}  // namespace xls
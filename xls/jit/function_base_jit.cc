@@ -14,6 +14,7 @@
 #include "xls/jit/function_base_jit.h"
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <iterator>
@@ -38,11 +39,13 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "llvm/include/llvm/IR/Attributes.h"
 #include "llvm/include/llvm/IR/Constants.h"
 #include "llvm/include/llvm/IR/DerivedTypes.h"
 #include "llvm/include/llvm/IR/Function.h"
 #include "llvm/include/llvm/IR/IRBuilder.h"
 #include "llvm/include/llvm/IR/Instructions.h"
+#include "llvm/include/llvm/IR/Intrinsics.h"
 #include "llvm/include/llvm/IR/LLVMContext.h"
 #include "llvm/include/llvm/IR/Type.h"
 #include "llvm/include/llvm/IR/Value.h"
@@ -69,7 +72,9 @@
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/llvm_compiler.h"
 #include "xls/jit/llvm_type_converter.h"
+#include "xls/jit/node_profile.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 namespace {
@@ -326,6 +331,17 @@ class BufferAllocator {
     return temp_block_offsets_.at(node);
   }
 
+  // Allocates a buffer in the temp block for a value of type `type` which is
+  // not the value of any node (e.g., the unpacked state of a proc whose state
+  // is kept packed). Returns the offset of the buffer within the temp block.
+  int64_t AllocateUnnamedTempBuffer(Type* type) {
+    int64_t offset = type_converter_->AlignFor(type, current_offset_);
+    alignment_ = std::max(alignment_,
+                          type_converter_->GetTypePreferredAlignment(type));
+    current_offset_ = offset + type_converter_->GetTypeByteSize(type);
+    return offset;
+  }
+
   // Returns the total size of the allocated memory.
   int64_t size() const { return current_offset_; }
   int64_t alignment() const { return alignment_; }
@@ -335,17 +351,12 @@ class BufferAllocator {
     CHECK(!node->Is<RegisterWrite>());
     CHECK(!node->Is<OutputPort>());
     CHECK(!temp_block_offsets_.contains(node));
-    int64_t offset =
-        type_converter_->AlignFor(node->GetType(), current_offset_);
-    int64_t node_size = type_converter_->GetTypeByteSize(node->GetType());
+    int64_t offset = AllocateUnnamedTempBuffer(node->GetType());
     temp_block_offsets_[node] = offset;
-    alignment_ =
-        std::max(alignment_,
-                 type_converter_->GetTypePreferredAlignment(node->GetType()));
-    current_offset_ = offset + node_size;
     VLOG(3) << absl::StreamFormat(
         "Allocated %s at offset %d (size = %d): total size %d", node->GetName(),
-        offset, node_size, current_offset_);
+        offset, type_converter_->GetTypeByteSize(node->GetType()),
+        current_offset_);
   }
 
   const LlvmTypeConverter* type_converter_;
@@ -511,6 +522,18 @@ Type* OutputType(const Node* node) {
   return node->GetType();
 }
 
+// Returns true if `node` is a state read with an unconditional next value,
+// which always overwrites the next state so it need not first be initialized
+// to the current state.
+bool IsAlwaysOverwritten(Node* node) {
+  if (!node->Is<StateRead>() || node->function_base()->next_values().empty()) {
+    return false;
+  }
+  return absl::c_any_of(
+      node->function_base()->next_values(node->As<StateRead>()),
+      [](Next* next) { return !next->predicate().has_value(); });
+}
+
 // Builds an LLVM function of the given `name` which executes the given set of
 // nodes. The signature of the partition function is the same as the jitted
 // function implementing a FunctionBase (i.e., `JitFunctionType`). A partition
@@ -564,6 +587,38 @@ absl::StatusOr<llvm::Function*> BuildPartitionFunction(
   // partitions which are early exit points (e.g., have a blocking receive).
   llvm::Value* interrupt_execution = nullptr;
 
+  // When node profiling is enabled the cycle counter is read before the first
+  // node and after each node, and the difference is accumulated in the node's
+  // counters. If the instance context has no counter buffer the counters are
+  // written to a scratch buffer instead to keep the generated code branch-free.
+  llvm::Function* read_cycle_counter = nullptr;
+  llvm::Value* profile_counters = nullptr;
+  llvm::Value* has_profile_counters = nullptr;
+  llvm::Value* profile_scratch = nullptr;
+  llvm::Value* last_tick = nullptr;
+  if (jit_context.llvm_compiler().include_node_profiling()) {
+    read_cycle_counter = llvm::Intrinsic::getOrInsertDeclaration(
+        jit_context.module(), llvm::Intrinsic::readcyclecounter);
+    profile_scratch = b.CreateAlloca(
+        llvm::ArrayType::get(b.getInt64Ty(), kNodeProfileCountersPerSite),
+        /*ArraySize=*/nullptr, "profile_scratch");
+    profile_counters =
+        LlvmGetNodeProfileCounters(wrapper.GetInstanceContextArg(), b);
+    has_profile_counters = b.CreateIsNotNull(profile_counters);
+    last_tick = b.CreateCall(read_cycle_counter);
+  }
+
+  // When node coverage is enabled the value of each node is ORed into the
+  // node's bits in the coverage buffer. As with profiling, a scratch buffer is
+  // used if the instance context has no coverage buffer, and also if the node
+  // blocked, in which case it produced no value.
+  llvm::Value* coverage_bits = nullptr;
+  llvm::Value* has_coverage_bits = nullptr;
+  if (jit_context.llvm_compiler().include_node_coverage()) {
+    coverage_bits = LlvmGetNodeCoverageBits(wrapper.GetInstanceContextArg(), b);
+    has_coverage_bits = b.CreateIsNotNull(coverage_bits);
+  }
+
   // The pointers to the buffers of nodes in the partition.
   absl::flat_hash_map<Node*, llvm::Value*> value_buffers;
   for (Node* node : partition.nodes) {
@@ -571,9 +626,12 @@ absl::StatusOr<llvm::Function*> BuildPartitionFunction(
       // Node is an input node. We need to generate a node function for  this
       // node to call callbacks on the node.
       XLS_RET_CHECK(allocator.GetAllocationKind(node) == AllocationKind::kNone);
-      if (wrapper.IsOutputNode(node)) {
+      if (wrapper.IsOutputNode(node) && !IsAlwaysOverwritten(node)) {
         // `node` is also an output node. This can occur, for example, if a
-        // state param is the next state value for a proc.
+        // state param is the next state value for a proc, and for every state
+        // read of a proc using next values, whose value is unchanged unless a
+        // next value is active. This is the only place the next state is
+        // initialized; callers need not do so.
         llvm::Value* input_buffer = wrapper.GetInputBuffer(node, b);
         for (llvm::Value* output_buffer : wrapper.GetOutputBuffers(node, b)) {
           LlvmMemcpy(
@@ -677,6 +735,58 @@ absl::StatusOr<llvm::Function*> BuildPartitionFunction(
     XLS_RET_CHECK_EQ(node_function.function->arg_size(), args.size());
     llvm::CallInst* node_blocked = b.CreateCall(node_function.function, args);
 
+    if (read_cycle_counter != nullptr) {
+      int64_t site = jit_context.AddNodeProfileSite(node);
+      llvm::Value* tick = b.CreateCall(read_cycle_counter);
+      llvm::Value* site_counters = b.CreateSelect(
+          has_profile_counters,
+          b.CreateConstGEP1_64(b.getInt64Ty(), profile_counters,
+                               kNodeProfileCountersPerSite * site),
+          profile_scratch);
+      llvm::Value* cycles = b.CreateLoad(b.getInt64Ty(), site_counters);
+      b.CreateStore(b.CreateAdd(cycles, b.CreateSub(tick, last_tick)),
+                    site_counters);
+      llvm::Value* evaluations_ptr =
+          b.CreateConstGEP1_64(b.getInt64Ty(), site_counters, 1);
+      llvm::Value* evaluations =
+          b.CreateLoad(b.getInt64Ty(), evaluations_ptr);
+      b.CreateStore(b.CreateAdd(evaluations, b.getInt64(1)), evaluations_ptr);
+      last_tick = tick;
+    }
+
+    if (coverage_bits != nullptr && node->GetType()->GetFlatBitCount() > 0) {
+      llvm::Value* value_buffer = output_buffers.empty()
+                                      ? wrapper.GetInputBuffer(node, b)
+                                      : output_buffers.front();
+      int64_t size =
+          jit_context.type_converter().GetTypeByteSize(node->GetType());
+      int64_t offset = jit_context.AddNodeCoverageSite(node, size);
+      llvm::Value* enabled = has_coverage_bits;
+      if (partition.early_exit_point.has_value()) {
+        enabled = b.CreateAnd(enabled, b.CreateNot(node_blocked));
+      }
+      llvm::Value* site_bits = b.CreateSelect(
+          enabled,
+          b.CreateConstGEP1_64(b.getInt8Ty(), coverage_bits, offset),
+          b.CreateAlloca(llvm::ArrayType::get(b.getInt8Ty(), size),
+                         /*ArraySize=*/nullptr, "coverage_scratch"));
+      // OR in at most a word at a time to avoid very wide integer operations.
+      for (int64_t word_offset = 0; word_offset < size; word_offset += 8) {
+        llvm::Type* word_type =
+            b.getIntNTy(8 * std::min<int64_t>(8, size - word_offset));
+        llvm::Value* bits_ptr =
+            b.CreateConstGEP1_64(b.getInt8Ty(), site_bits, word_offset);
+        llvm::Value* value = b.CreateAlignedLoad(
+            word_type,
+            b.CreateConstGEP1_64(b.getInt8Ty(), value_buffer, word_offset),
+            llvm::MaybeAlign(1));
+        llvm::Value* bits =
+            b.CreateAlignedLoad(word_type, bits_ptr, llvm::MaybeAlign(1));
+        b.CreateAlignedStore(b.CreateOr(bits, value), bits_ptr,
+                             llvm::MaybeAlign(1));
+      }
+    }
+
     if (partition.early_exit_point.has_value()) {
       XLS_RET_CHECK_EQ(partition.nodes.size(), 1);
       interrupt_execution = node_blocked;
@@ -962,6 +1072,13 @@ absl::Status UnpackValue(llvm::Value* packed_buffer,
                          int64_t bit_offset,
                          const LlvmTypeConverter& type_converter,
                          llvm::IRBuilder<>* builder) {
+  if (xls_type->GetFlatBitCount() == 0) {
+    // Nothing to load (e.g., tokens and empty tuples).
+    builder->CreateStore(LlvmTypeConverter::ZeroOfType(
+                             type_converter.ConvertToLlvmType(xls_type)),
+                         unpacked_buffer);
+    return absl::OkStatus();
+  }
   switch (xls_type->kind()) {
     case TypeKind::kBits: {
       // Compute the byte offset into `packed_buffer` where first bit of data
@@ -1258,6 +1375,281 @@ absl::StatusOr<llvm::Function*> BuildPackedWrapper(
   return wrapper.function();
 }
 
+// Builds a wrapper around the jitted function `callee` implementing `proc`
+// which keeps the proc state bit-packed in a single buffer laid out as
+// described by `PackedTypeLayout` rather than in one native buffer per state
+// element. The signature is the same as `JitFunctionType` except that
+// `inputs[0]` and `outputs[0]` point to the packed current and next state.
+// The native buffers passed on to `callee` are allocated in the temp buffer so
+// they persist while a tick is interrupted. The wrapper looks like:
+//
+//   int64_t
+//   __p_packed_state(const uint8_t* const* inputs,
+//                    uint8_t* const* outputs,
+//                    void* temp_buffer,
+//                    InterpreterEvents* events,
+//                    InstanceContext* instance_context,
+//                    JitRuntime* jit_runtime,
+//                    int64_t continuation_point) {
+//     if (continuation_point == 0) {
+//       unpack inputs[0] into the native current state buffers
+//     }
+//     result = __p(native_inputs, native_outputs, temp_buffer, ...,
+//                  continuation_point);
+//     if (result == 0) {
+//       pack the native next state buffers into outputs[0]
+//     }
+//     return result;
+//   }
+//
+// The next state need not be unpacked: `callee` itself initializes the next
+// value of every state element which may not have an active next value.
+absl::StatusOr<llvm::Function*> BuildPackedStateWrapper(
+    Proc* proc, llvm::Function* callee, BufferAllocator& allocator,
+    JitBuilderContext& jit_context) {
+  llvm::LLVMContext* context = &jit_context.context();
+  llvm::Type* i64 = llvm::Type::getInt64Ty(*context);
+  const LlvmTypeConverter& type_converter = jit_context.type_converter();
+  std::vector<Node*> inputs = GetJittedFunctionInputs(proc);
+  std::vector<Node*> outputs = GetJittedFunctionOutputs(proc);
+  XLS_RET_CHECK_EQ(inputs.size(), outputs.size());
+  LlvmFunctionWrapper wrapper = LlvmFunctionWrapper::Create(
+      absl::StrFormat("%s_packed_state", proc->name()),
+      /*input_args=*/{}, /*output_args=*/{}, i64, jit_context,
+      LlvmFunctionWrapper::FunctionArg{.name = "continuation_point",
+                                       .type = i64});
+  llvm::IRBuilder<>& entry = wrapper.entry_builder();
+
+  std::vector<Type*> state_types;
+  state_types.reserve(inputs.size());
+  for (Node* input : inputs) {
+    state_types.push_back(InputType(input));
+  }
+  PackedTypeLayout packed_layout(state_types);
+
+  // Arrays of pointers to the native state buffers passed on to the wrapped
+  // function.
+  llvm::Type* pointer_array_type =
+      llvm::ArrayType::get(llvm::PointerType::getUnqual(*context), 0);
+  llvm::Value* input_arg_array = entry.CreateAlloca(
+      llvm::ArrayType::get(llvm::PointerType::get(*context, 0), inputs.size()));
+  llvm::Value* output_arg_array = entry.CreateAlloca(llvm::ArrayType::get(
+      llvm::PointerType::get(*context, 0), outputs.size()));
+  auto allocate_native_buffer = [&](llvm::Value* array, int64_t index,
+                                    Type* type) {
+    llvm::Value* buffer = wrapper.GetOffsetIntoTempBuffer(
+        allocator.AllocateUnnamedTempBuffer(type), entry);
+    llvm::Value* gep = entry.CreateGEP(
+        pointer_array_type, array,
+        {
+            llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), 0),
+            llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), index),
+        });
+    entry.CreateStore(buffer, gep);
+    return buffer;
+  };
+  std::vector<llvm::Value*> input_buffers;
+  std::vector<llvm::Value*> output_buffers;
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    input_buffers.push_back(
+        allocate_native_buffer(input_arg_array, i, InputType(inputs[i])));
+    output_buffers.push_back(
+        allocate_native_buffer(output_arg_array, i, OutputType(outputs[i])));
+  }
+  llvm::Value* packed_input =
+      LoadPointerFromPointerArray(0, wrapper.GetInputsArg(), &entry);
+  llvm::Value* packed_output =
+      LoadPointerFromPointerArray(0, wrapper.GetOutputsArg(), &entry);
+
+  llvm::BasicBlock* unpack_block = llvm::BasicBlock::Create(
+      *context, "unpack_state", wrapper.function(), /*InsertBefore=*/nullptr);
+  llvm::BasicBlock* call_block = llvm::BasicBlock::Create(
+      *context, "call", wrapper.function(), /*InsertBefore=*/nullptr);
+  llvm::BasicBlock* pack_block = llvm::BasicBlock::Create(
+      *context, "pack_state", wrapper.function(), /*InsertBefore=*/nullptr);
+  llvm::BasicBlock* exit_block = llvm::BasicBlock::Create(
+      *context, "exit", wrapper.function(), /*InsertBefore=*/nullptr);
+  entry.CreateCondBr(
+      entry.CreateICmpEQ(wrapper.GetExtraArg().value(),
+                         llvm::ConstantInt::get(i64, 0)),
+      unpack_block, call_block);
+
+  llvm::IRBuilder<> unpack_builder(unpack_block);
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    XLS_RETURN_IF_ERROR(UnpackValue(packed_input, input_buffers[i],
+                                    InputType(inputs[i]),
+                                    packed_layout.bit_offset(i),
+                                    type_converter, &unpack_builder));
+  }
+  unpack_builder.CreateBr(call_block);
+
+  llvm::IRBuilder<> call_builder(call_block);
+  std::vector<llvm::Value*> args = {input_arg_array,
+                                    output_arg_array,
+                                    wrapper.GetTempBufferArg(),
+                                    wrapper.GetInterpreterEventsArg(),
+                                    wrapper.GetInstanceContextArg(),
+                                    wrapper.GetJitRuntimeArg(),
+                                    wrapper.GetExtraArg().value()};
+  llvm::Value* continuation_result = call_builder.CreateCall(callee, args);
+  call_builder.CreateCondBr(
+      call_builder.CreateICmpEQ(continuation_result,
+                                llvm::ConstantInt::get(i64, 0)),
+      pack_block, exit_block);
+
+  // PackValue clears the bits above the value it writes within the last byte
+  // it touches so the values must be packed in ascending bit order.
+  llvm::IRBuilder<> pack_builder(pack_block);
+  for (int64_t i = 0; i < outputs.size(); ++i) {
+    XLS_RETURN_IF_ERROR(PackValue(output_buffers[i], packed_output,
+                                  OutputType(outputs[i]),
+                                  packed_layout.bit_offset(i), type_converter,
+                                  &pack_builder));
+  }
+  pack_builder.CreateBr(exit_block);
+
+  llvm::IRBuilder<> exit_builder(exit_block);
+  exit_builder.CreateRet(continuation_result);
+
+  return wrapper.function();
+}
+
+// Returns the distance in bytes between consecutive elements of a batched
+// buffer holding values of the given type in the native LLVM data layout.
+int64_t BatchStride(Type* type, const LlvmTypeConverter& type_converter) {
+  return RoundUpToNearest(type_converter.GetTypeByteSize(type),
+                          type_converter.GetTypePreferredAlignment(type));
+}
+
+// Builds a wrapper around the jitted function `callee` which evaluates a batch
+// of argument sets in a single call. The signature is the same as
+// `JitFunctionType` except the final argument is the number of elements in the
+// batch rather than a continuation point. Each pointer in the `inputs` and
+// `outputs` arrays refers to a buffer holding `batch_size` consecutive values
+// in the native LLVM data layout spaced `BatchStride` bytes apart. The wrapper
+// looks like:
+//
+//   int64_t
+//   __f_batched(const uint8_t* const* inputs,
+//               uint8_t* const* outputs,
+//               void* temp_buffer,
+//               InterpreterEvents* events,
+//               InstanceContext* instance_context,
+//               JitRuntime* jit_runtime,
+//               int64_t batch_size) {
+//     for (int64_t i = 0; i < batch_size; ++i) {
+//       lane_inputs[k] = inputs[k] + i * input_stride[k]   (for each k)
+//       lane_outputs[k] = outputs[k] + i * output_stride[k] (for each k)
+//       __f(lane_inputs, lane_outputs, temp_buffer, events,
+//           instance_context, jit_runtime, /*continuation_point=*/0);
+//     }
+//     return 0;
+//   }
+//
+// Keeping the loop inside the generated code avoids the per-call wrapper
+// overhead. The call is marked always-inline so that, once inlined, the lane
+// pointer arrays are promoted to registers and the loop body addresses the
+// batched buffers directly. The loop vectorizer can then vectorize across
+// lanes when the body allows it (in particular when it does not go through
+// `temp_buffer`, which all lanes share); otherwise the lanes run one after
+// the other without call overhead.
+absl::StatusOr<llvm::Function*> BuildBatchedWrapper(
+    FunctionBase* xls_function, llvm::Function* callee,
+    JitBuilderContext& jit_context) {
+  llvm::LLVMContext* context = &jit_context.context();
+  llvm::Type* i64 = llvm::Type::getInt64Ty(*context);
+  llvm::Type* i8 = llvm::Type::getInt8Ty(*context);
+  std::vector<Node*> inputs = GetJittedFunctionInputs(xls_function);
+  std::vector<Node*> outputs = GetJittedFunctionOutputs(xls_function);
+  LlvmFunctionWrapper wrapper = LlvmFunctionWrapper::Create(
+      absl::StrFormat("%s_batched", xls_function->name()), inputs, outputs, i64,
+      jit_context,
+      LlvmFunctionWrapper::FunctionArg{.name = "batch_size", .type = i64});
+  llvm::IRBuilder<>& entry = wrapper.entry_builder();
+
+  // Arrays of pointers to the values of the current batch lane. These are
+  // passed on to the wrapped function.
+  llvm::Type* pointer_array_type =
+      llvm::ArrayType::get(llvm::PointerType::getUnqual(*context), 0);
+  llvm::Value* input_arg_array = entry.CreateAlloca(
+      llvm::ArrayType::get(llvm::PointerType::get(*context, 0), inputs.size()));
+  llvm::Value* output_arg_array = entry.CreateAlloca(llvm::ArrayType::get(
+      llvm::PointerType::get(*context, 0), outputs.size()));
+
+  // The base pointers of the batched buffers are loop invariant.
+  std::vector<llvm::Value*> input_bases;
+  input_bases.reserve(inputs.size());
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    input_bases.push_back(
+        LoadPointerFromPointerArray(i, wrapper.GetInputsArg(), &entry));
+  }
+  std::vector<llvm::Value*> output_bases;
+  output_bases.reserve(outputs.size());
+  for (int64_t i = 0; i < outputs.size(); ++i) {
+    output_bases.push_back(
+        LoadPointerFromPointerArray(i, wrapper.GetOutputsArg(), &entry));
+  }
+
+  llvm::BasicBlock* entry_block = entry.GetInsertBlock();
+  llvm::BasicBlock* header_block = llvm::BasicBlock::Create(
+      *context, "batch_header", wrapper.function(), /*InsertBefore=*/nullptr);
+  llvm::BasicBlock* body_block = llvm::BasicBlock::Create(
+      *context, "batch_body", wrapper.function(), /*InsertBefore=*/nullptr);
+  llvm::BasicBlock* exit_block = llvm::BasicBlock::Create(
+      *context, "batch_exit", wrapper.function(), /*InsertBefore=*/nullptr);
+  entry.CreateBr(header_block);
+
+  llvm::IRBuilder<> header_builder(header_block);
+  llvm::PHINode* lane = header_builder.CreatePHI(i64, 2, "lane");
+  lane->addIncoming(llvm::ConstantInt::get(i64, 0), entry_block);
+  header_builder.CreateCondBr(
+      header_builder.CreateICmpSLT(lane, wrapper.GetExtraArg().value()),
+      body_block, exit_block);
+
+  llvm::IRBuilder<> body_builder(body_block);
+  auto store_lane_pointer = [&](llvm::Value* array, int64_t index,
+                                llvm::Value* base, Type* type) {
+    llvm::Value* offset = body_builder.CreateMul(
+        lane, llvm::ConstantInt::get(
+                  i64, BatchStride(type, jit_context.type_converter())));
+    llvm::Value* lane_ptr = body_builder.CreateGEP(i8, base, offset);
+    llvm::Value* gep = body_builder.CreateGEP(
+        pointer_array_type, array,
+        {
+            llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), 0),
+            llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), index),
+        });
+    body_builder.CreateStore(lane_ptr, gep);
+  };
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    store_lane_pointer(input_arg_array, i, input_bases[i],
+                       InputType(inputs[i]));
+  }
+  for (int64_t i = 0; i < outputs.size(); ++i) {
+    store_lane_pointer(output_arg_array, i, output_bases[i],
+                       OutputType(outputs[i]));
+  }
+
+  std::vector<llvm::Value*> args = {input_arg_array,
+                                    output_arg_array,
+                                    wrapper.GetTempBufferArg(),
+                                    wrapper.GetInterpreterEventsArg(),
+                                    wrapper.GetInstanceContextArg(),
+                                    wrapper.GetJitRuntimeArg(),
+                                    llvm::ConstantInt::get(i64, 0)};
+  llvm::CallInst* call = body_builder.CreateCall(callee, args);
+  call->addFnAttr(llvm::Attribute::AlwaysInline);
+  llvm::Value* next_lane =
+      body_builder.CreateAdd(lane, llvm::ConstantInt::get(i64, 1));
+  lane->addIncoming(next_lane, body_block);
+  body_builder.CreateBr(header_block);
+
+  llvm::IRBuilder<> exit_builder(exit_block);
+  exit_builder.CreateRet(llvm::ConstantInt::get(i64, 0));
+
+  return wrapper.function();
+}
+
 }  // namespace
 
 JitArgumentSet JittedFunctionBase::CreateInputBuffer() const {
@@ -1278,6 +1670,37 @@ absl::StatusOr<JitArgumentSet> JittedFunctionBase::CreateInputOutputBuffer()
       {input_buffer_sizes(), output_buffer_sizes()});
 }
 
+JitArgumentSet JittedFunctionBase::CreateBatchedInputBuffer(
+    int64_t batch_size) const {
+  std::vector<int64_t> sizes;
+  sizes.reserve(input_buffer_sizes_.size());
+  for (int64_t i = 0; i < input_buffer_sizes_.size(); ++i) {
+    sizes.push_back(input_batch_stride(i) * batch_size);
+  }
+  return JitArgumentSet::CreateInput(this, input_buffer_preferred_alignments(),
+                                     sizes);
+}
+
+JitArgumentSet JittedFunctionBase::CreateBatchedOutputBuffer(
+    int64_t batch_size) const {
+  std::vector<int64_t> sizes;
+  sizes.reserve(output_buffer_sizes_.size());
+  for (int64_t i = 0; i < output_buffer_sizes_.size(); ++i) {
+    sizes.push_back(output_batch_stride(i) * batch_size);
+  }
+  return JitArgumentSet::CreateOutput(
+      this, output_buffer_preferred_alignments(), sizes);
+}
+
+JitArgumentSet JittedFunctionBase::CreatePackedStateBuffer() const {
+  // The packed code makes no alignment assumptions.
+  std::array<int64_t, 1> alignment = {1};
+  std::array<int64_t, 1> size = {packed_state_size_};
+  return JitArgumentSet::CreateInputOutput(this, {alignment, alignment},
+                                           {size, size})
+      .value();
+}
+
 JitTempBuffer JittedFunctionBase::CreateTempBuffer() const {
   return JitTempBuffer(this, temp_buffer_alignment(), temp_buffer_size());
 }
@@ -1286,7 +1709,8 @@ JitTempBuffer JittedFunctionBase::CreateTempBuffer() const {
 // dependent xls::Functions which may be called by `xls_function`.
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
     FunctionBase* xls_function, JitBuilderContext& jit_context,
-    bool build_packed_wrapper) {
+    bool build_packed_wrapper, bool build_batched_wrapper,
+    bool build_packed_state_wrapper) {
   std::vector<FunctionBase*> functions = GetDependentFunctions(xls_function);
   BufferAllocator allocator(&jit_context.type_converter());
   llvm::Function* top_function = nullptr;
@@ -1324,6 +1748,23 @@ absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
         BuildPackedWrapper(xls_function, top_function, jit_context));
     packed_wrapper_name = packed_wrapper_function->getName().str();
   }
+  std::string batched_wrapper_name;
+  if (build_batched_wrapper) {
+    XLS_ASSIGN_OR_RETURN(
+        llvm::Function * batched_wrapper_function,
+        BuildBatchedWrapper(xls_function, top_function, jit_context));
+    batched_wrapper_name = batched_wrapper_function->getName().str();
+  }
+  std::string packed_state_wrapper_name;
+  if (build_packed_state_wrapper) {
+    XLS_RET_CHECK(xls_function->IsProc());
+    XLS_ASSIGN_OR_RETURN(
+        llvm::Function * packed_state_wrapper_function,
+        BuildPackedStateWrapper(xls_function->AsProcOrDie(), top_function,
+                                allocator, jit_context));
+    packed_state_wrapper_name =
+        packed_state_wrapper_function->getName().str();
+  }
 
   XLS_RETURN_IF_ERROR(
       jit_context.llvm_compiler().CompileModule(jit_context.ConsumeModule()));
@@ -1357,6 +1798,43 @@ absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
     }
   }
 
+  if (build_batched_wrapper) {
+    jitted_function.batched_function_name_ = batched_wrapper_name;
+    if (jit_context.llvm_compiler().IsOrcJit()) {
+      XLS_ASSIGN_OR_RETURN(auto* orc_jit,
+                           jit_context.llvm_compiler().AsOrcJit());
+      XLS_ASSIGN_OR_RETURN(auto batched_fn_address,
+                           orc_jit->LoadSymbol(batched_wrapper_name));
+      jitted_function.batched_function_ =
+          absl::bit_cast<JitFunctionType>(batched_fn_address);
+    } else {
+      // Give it a function that will give a sort of useful error message if you
+      // actually try to invoke it.
+      jitted_function.batched_function_ = InvalidJitFunctionUse;
+    }
+  }
+
+  if (build_packed_state_wrapper) {
+    jitted_function.packed_state_function_name_ = packed_state_wrapper_name;
+    if (jit_context.llvm_compiler().IsOrcJit()) {
+      XLS_ASSIGN_OR_RETURN(auto* orc_jit,
+                           jit_context.llvm_compiler().AsOrcJit());
+      XLS_ASSIGN_OR_RETURN(auto packed_state_fn_address,
+                           orc_jit->LoadSymbol(packed_state_wrapper_name));
+      jitted_function.packed_state_function_ =
+          absl::bit_cast<JitFunctionType>(packed_state_fn_address);
+    } else {
+      // Give it a function that will give a sort of useful error message if you
+      // actually try to invoke it.
+      jitted_function.packed_state_function_ = InvalidJitFunctionUse;
+    }
+    std::vector<Type*> state_types;
+    for (const Node* input : GetJittedFunctionInputs(xls_function)) {
+      state_types.push_back(InputType(input));
+    }
+    jitted_function.packed_state_size_ = PackedTypeLayout(state_types).size();
+  }
+
   for (const Node* input : GetJittedFunctionInputs(xls_function)) {
     Type* input_type = InputType(input);
     jitted_function.input_buffer_sizes_.push_back(
@@ -1392,6 +1870,9 @@ absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
   }
 
   jitted_function.queue_indices_ = jit_context.queue_indices();
+  jitted_function.profile_sites_ = jit_context.profile_sites();
+  jitted_function.coverage_sites_ = jit_context.coverage_sites();
+  jitted_function.node_coverage_size_ = jit_context.node_coverage_size();
 
   return std::move(jitted_function);
 }
@@ -1399,22 +1880,31 @@ absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildInternal(
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::Build(
     Function* xls_function, LlvmCompiler& compiler) {
   JitBuilderContext jit_context(compiler, xls_function);
-  return JittedFunctionBase::BuildInternal(xls_function, jit_context,
-                                           /*build_packed_wrapper=*/true);
+  return JittedFunctionBase::BuildInternal(
+      xls_function, jit_context,
+      /*build_packed_wrapper=*/true,
+      /*build_batched_wrapper=*/true,
+      /*build_packed_state_wrapper=*/false);
 }
 
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::Build(
-    Proc* proc, LlvmCompiler& compiler) {
+    Proc* proc, LlvmCompiler& compiler, bool packed_state) {
   JitBuilderContext jit_context(compiler, proc);
-  return JittedFunctionBase::BuildInternal(proc, jit_context,
-                                           /*build_packed_wrapper=*/false);
+  return JittedFunctionBase::BuildInternal(
+      proc, jit_context,
+      /*build_packed_wrapper=*/false,
+      /*build_batched_wrapper=*/false,
+      /*build_packed_state_wrapper=*/packed_state);
 }
 
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::Build(
     Block* block, LlvmCompiler& compiler) {
   JitBuilderContext jit_context(compiler, block);
-  return JittedFunctionBase::BuildInternal(block, jit_context,
-                                           /*build_packed_wrapper=*/false);
+  return JittedFunctionBase::BuildInternal(
+      block, jit_context,
+      /*build_packed_wrapper=*/false,
+      /*build_batched_wrapper=*/false,
+      /*build_packed_state_wrapper=*/false);
 }
 
 absl::StatusOr<JittedFunctionBase> JittedFunctionBase::BuildFromAot(
@@ -1548,6 +2038,54 @@ JittedFunctionBase::RunUnalignedJittedFunction</*kForceZeroCopy=*/false>(
     InterpreterEvents* events, InstanceContext* instance_context,
     JitRuntime* jit_runtime, int64_t continuation) const;
 
+absl::Status JittedFunctionBase::RunBatchedJittedFunction(
+    const uint8_t* const* inputs, uint8_t* const* outputs, void* temp_buffer,
+    InterpreterEvents* events, InstanceContext* instance_context,
+    JitRuntime* jit_runtime, int64_t batch_size) const {
+  XLS_RET_CHECK_GE(batch_size, 0);
+  XLS_RETURN_IF_ERROR(
+      VerifyOffsetAlignments(inputs, input_buffer_preferred_alignments()));
+  XLS_RETURN_IF_ERROR(
+      VerifyOffsetAlignments(outputs, output_buffer_preferred_alignments()));
+  XLS_RET_CHECK(IsAligned(temp_buffer, temp_buffer_alignment_));
+  if (batched_function_) {
+    (*batched_function_)(inputs, outputs, temp_buffer, events,
+                         instance_context, jit_runtime, batch_size);
+    return absl::OkStatus();
+  }
+  // No batched entry point (e.g., AOT compiled code). Step through the batch
+  // one lane at a time.
+  std::vector<const uint8_t*> lane_inputs(input_buffer_sizes_.size());
+  std::vector<uint8_t*> lane_outputs(output_buffer_sizes_.size());
+  for (int64_t lane = 0; lane < batch_size; ++lane) {
+    for (int64_t i = 0; i < lane_inputs.size(); ++i) {
+      lane_inputs[i] = inputs[i] + lane * input_batch_stride(i);
+    }
+    for (int64_t i = 0; i < lane_outputs.size(); ++i) {
+      lane_outputs[i] = outputs[i] + lane * output_batch_stride(i);
+    }
+    function_(lane_inputs.data(), lane_outputs.data(), temp_buffer, events,
+              instance_context, jit_runtime, /*continuation_point=*/0);
+  }
+  return absl::OkStatus();
+}
+
+int64_t JittedFunctionBase::RunPackedStateJittedFunction(
+    const JitArgumentSet& state, JitArgumentSet& next_state,
+    JitTempBuffer& temp_buffer, InterpreterEvents* events,
+    InstanceContext* instance_context, JitRuntime* jit_runtime,
+    int64_t continuation_point) const {
+  CHECK(packed_state_function_.has_value());
+  CHECK(state.is_inputs());
+  CHECK_EQ(state.source(), this);
+  CHECK(next_state.is_outputs());
+  CHECK_EQ(next_state.source(), this);
+  CHECK_EQ(temp_buffer.source(), this);
+  return (*packed_state_function_)(state.get(), next_state.get(),
+                                   temp_buffer.get(), events, instance_context,
+                                   jit_runtime, continuation_point);
+}
+
 std::optional<int64_t> JittedFunctionBase::RunPackedJittedFunction(
     const uint8_t* const* inputs, uint8_t* const* outputs, void* temp_buffer,
     InterpreterEvents* events, InstanceContext* instance_context,
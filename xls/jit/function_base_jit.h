@@ -28,6 +28,7 @@
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
+#include "xls/common/math_util.h"
 #include "xls/ir/events.h"
 #include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
@@ -41,6 +42,8 @@
 #include "xls/jit/jit_callbacks.h"
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/llvm_compiler.h"
+#include "xls/jit/node_coverage.h"
+#include "xls/jit/node_profile.h"
 
 namespace xls {
 
@@ -88,9 +91,11 @@ class JittedFunctionBase {
                                                   LlvmCompiler& compiler);
 
   // Builds and returns an LLVM IR function implementing the given XLS
-  // proc.
+  // proc. If `packed_state` is true, also builds a variant of the function
+  // which keeps the proc state bit-packed (see RunPackedStateJittedFunction).
   static absl::StatusOr<JittedFunctionBase> Build(Proc* proc,
-                                                  LlvmCompiler& compiler);
+                                                  LlvmCompiler& compiler,
+                                                  bool packed_state = false);
 
   // Builds and returns an LLVM IR function implementing the given XLS
   // block.
@@ -151,6 +156,68 @@ class JittedFunctionBase {
       InterpreterEvents* events, InstanceContext* instance_context,
       JitRuntime* jit_runtime, int64_t continuation_point) const;
 
+  // Create a buffer holding the bit-packed state of a proc, usable as both
+  // the input and output of `RunPackedStateJittedFunction`.
+  JitArgumentSet CreatePackedStateBuffer() const;
+
+  // Executes the proc function with the state bit-packed into a single buffer
+  // laid out as described by `PackedTypeLayout` over the state element types.
+  // `state` holds the current state and `next_state` receives the next state
+  // when the tick completes. At the start of a tick `next_state` must hold the
+  // default next state (the current state for procs using `next_value`
+  // nodes). Only valid if `HasPackedStateFunction()`.
+  int64_t RunPackedStateJittedFunction(const JitArgumentSet& state,
+                                       JitArgumentSet& next_state,
+                                       JitTempBuffer& temp_buffer,
+                                       InterpreterEvents* events,
+                                       InstanceContext* instance_context,
+                                       JitRuntime* jit_runtime,
+                                       int64_t continuation_point) const;
+
+  // Executes the function over a batch of `batch_size` argument sets in a
+  // single call. Each pointer in `inputs` (`outputs`) refers to a buffer
+  // holding `batch_size` consecutive values in the native LLVM data layout
+  // spaced `input_batch_stride(i)` (`output_batch_stride(i)`) bytes apart. The
+  // buffers must satisfy the preferred alignment of their element type. The
+  // temporary buffer is reused by every element of the batch. Only valid for
+  // functions (which have no continuation points).
+  absl::Status RunBatchedJittedFunction(const uint8_t* const* inputs,
+                                        uint8_t* const* outputs,
+                                        void* temp_buffer,
+                                        InterpreterEvents* events,
+                                        InstanceContext* instance_context,
+                                        JitRuntime* jit_runtime,
+                                        int64_t batch_size) const;
+
+  // Create a buffer with space for `batch_size` copies of each input, laid out
+  // as expected by `RunBatchedJittedFunction`.
+  JitArgumentSet CreateBatchedInputBuffer(int64_t batch_size) const;
+
+  // Create a buffer with space for `batch_size` copies of each output, laid
+  // out as expected by `RunBatchedJittedFunction`.
+  JitArgumentSet CreateBatchedOutputBuffer(int64_t batch_size) const;
+
+  // Distance in bytes between consecutive batch elements of the given input
+  // (output) in the buffers passed to `RunBatchedJittedFunction`.
+  int64_t input_batch_stride(int64_t index) const {
+    return RoundUpToNearest(input_buffer_sizes_[index],
+                            input_buffer_preferred_alignments_[index]);
+  }
+  int64_t output_batch_stride(int64_t index) const {
+    return RoundUpToNearest(output_buffer_sizes_[index],
+                            output_buffer_preferred_alignments_[index]);
+  }
+
+  // Checks if we have a batched version of the function. If not,
+  // `RunBatchedJittedFunction` falls back to calling the function once per
+  // batch element.
+  bool HasBatchedFunction() const { return batched_function_.has_value(); }
+  std::optional<std::string_view> batched_function_name() const {
+    return HasBatchedFunction()
+               ? std::make_optional<std::string_view>(*batched_function_name_)
+               : std::nullopt;
+  }
+
   // Checks if we have a packed version of the function.
   bool HasPackedFunction() const { return packed_function_.has_value(); }
   std::optional<std::string_view> packed_function_name() const {
@@ -159,6 +226,21 @@ class JittedFunctionBase {
                : std::nullopt;
   }
 
+  // Checks if we have a packed-state version of the proc function.
+  bool HasPackedStateFunction() const {
+    return packed_state_function_.has_value();
+  }
+  std::optional<std::string_view> packed_state_function_name() const {
+    return HasPackedStateFunction()
+               ? std::make_optional<std::string_view>(
+                     *packed_state_function_name_)
+               : std::nullopt;
+  }
+
+  // Size in bytes of the packed state buffers passed to
+  // `RunPackedStateJittedFunction`.
+  int64_t packed_state_size() const { return packed_state_size_; }
+
   std::string_view function_name() const { return function_name_; }
 
   absl::Span<int64_t const> input_buffer_sizes() const {
@@ -207,12 +289,32 @@ class JittedFunctionBase {
     return queue_indices_;
   }
 
+  // The nodes timed by node profiling code, in the order of their counters in
+  // InstanceContext::node_profile_counters. Empty if the function was not
+  // compiled with node profiling.
+  const std::vector<NodeProfileSite>& profile_sites() const {
+    return profile_sites_;
+  }
+
+  // The nodes whose values are accumulated by node coverage code and their
+  // locations in InstanceContext::node_coverage_bits, which must be
+  // node_coverage_size() bytes. Empty if the function was not compiled with
+  // node coverage.
+  const std::vector<NodeCoverageSite>& coverage_sites() const {
+    return coverage_sites_;
+  }
+  int64_t node_coverage_size() const { return node_coverage_size_; }
+
   JittedFunctionBase WithCodePointers(
       JitFunctionType entrypoint,
       std::optional<JitFunctionType> packed_entrypoint = std::nullopt) const {
     JittedFunctionBase res = *this;
     res.function_ = entrypoint;
     res.packed_function_ = packed_entrypoint;
+    res.batched_function_name_ = std::nullopt;
+    res.batched_function_ = std::nullopt;
+    res.packed_state_function_name_ = std::nullopt;
+    res.packed_state_function_ = std::nullopt;
     return res;
   }
 
@@ -252,7 +354,8 @@ class JittedFunctionBase {
 
   static absl::StatusOr<JittedFunctionBase> BuildInternal(
       FunctionBase* function, JitBuilderContext& jit_context,
-      bool build_packed_wrapper);
+      bool build_packed_wrapper, bool build_batched_wrapper,
+      bool build_packed_state_wrapper);
 
   // Name and function pointer for the jitted function which accepts/produces
   // arguments/results in LLVM native format.
@@ -265,6 +368,18 @@ class JittedFunctionBase {
   std::optional<std::string> packed_function_name_;
   std::optional<JitFunctionType> packed_function_;
 
+  // Name and function pointer for the jitted function which evaluates a batch
+  // of argument sets in native LLVM format. Only exists for JITted
+  // xls::Functions.
+  std::optional<std::string> batched_function_name_;
+  std::optional<JitFunctionType> batched_function_;
+
+  // Name and function pointer for the jitted function which keeps the state
+  // bit-packed. Only exists for JITted xls::Procs built with `packed_state`.
+  std::optional<std::string> packed_state_function_name_;
+  std::optional<JitFunctionType> packed_state_function_;
+  int64_t packed_state_size_ = 0;
+
   // Sizes of the inputs/outputs in native LLVM format for `function_base`.
   std::vector<int64_t> input_buffer_sizes_;
   std::vector<int64_t> output_buffer_sizes_;
@@ -293,6 +408,13 @@ class JittedFunctionBase {
   // The map from channel reference name to the index of the respective queue in
   // the instance context.
   absl::btree_map<std::string, int64_t> queue_indices_;
+
+  // The nodes timed by node profiling code.
+  std::vector<NodeProfileSite> profile_sites_;
+
+  // The nodes accumulated by node coverage code and the size of their bits.
+  std::vector<NodeCoverageSite> coverage_sites_;
+  int64_t node_coverage_size_ = 0;
 };
 
 struct FunctionEntrypoint {
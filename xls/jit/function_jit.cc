@@ -22,12 +22,15 @@
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "llvm/include/llvm/ExecutionEngine/Orc/Shared/ExecutorAddress.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
 #include "llvm/include/llvm/Support/Error.h"
 #include "xls/common/status/ret_check.h"
@@ -44,7 +47,10 @@
 #include "xls/jit/aot_compiler.h"
 #include "xls/jit/aot_entrypoint.pb.h"
 #include "xls/jit/function_base_jit.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/jit/node_profile.h"
+#include "xls/jit/node_profile.pb.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
 
@@ -98,7 +104,35 @@ absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::Create(
     Function* xls_function, int64_t opt_level, bool include_observer_callbacks,
     JitObserver* jit_observer) {
   return CreateInternal(xls_function, opt_level, include_observer_callbacks,
-                        jit_observer);
+                        /*include_node_profiling=*/false, jit_observer);
+}
+
+absl::StatusOr<std::unique_ptr<FunctionJit>>
+FunctionJit::CreateWithNodeProfiling(Function* xls_function, int64_t opt_level,
+                                     JitObserver* jit_observer) {
+  return CreateInternal(xls_function, opt_level,
+                        /*include_observer_callbacks=*/false,
+                        /*include_node_profiling=*/true, jit_observer);
+}
+
+absl::StatusOr<std::unique_ptr<FunctionJit>>
+FunctionJit::CreateWithParallelCompilation(Function* xls_function,
+                                           int64_t compile_threads,
+                                           int64_t opt_level) {
+  return CreateInternal(xls_function, opt_level,
+                        /*include_observer_callbacks=*/false,
+                        /*include_node_profiling=*/false,
+                        /*jit_observer=*/nullptr,
+                        LlvmOptions{.compile_threads = compile_threads});
+}
+
+absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateWithLlvmOptions(
+    Function* xls_function, const LlvmOptions& llvm_options, int64_t opt_level,
+    JitObserver* jit_observer) {
+  return CreateInternal(xls_function, opt_level,
+                        /*include_observer_callbacks=*/false,
+                        /*include_node_profiling=*/false, jit_observer,
+                        llvm_options);
 }
 
 // Returns an object containing an AOT-compiled version of the specified XLS
@@ -131,9 +165,10 @@ FunctionJit::CreateFromAot(const AotEntrypointProto& entrypoint,
 
 absl::StatusOr<JitObjectCode> FunctionJit::CreateObjectCode(
     Function* xls_function, int64_t opt_level, bool include_msan,
-    JitObserver* observer) {
+    JitObserver* observer, std::optional<std::string> target_cpu) {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<AotCompiler> comp,
-                       AotCompiler::Create(include_msan, opt_level, observer));
+                       AotCompiler::Create(include_msan, opt_level, observer,
+                                           std::move(target_cpu)));
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout, comp->CreateDataLayout());
   XLS_ASSIGN_OR_RETURN(JittedFunctionBase jfb,
                        JittedFunctionBase::Build(xls_function, *comp));
@@ -149,12 +184,72 @@ absl::StatusOr<JitObjectCode> FunctionJit::CreateObjectCode(
                        .data_layout = data_layout};
 }
 
+/* static */ absl::StatusOr<std::unique_ptr<FunctionJit>>
+FunctionJit::CreateWithObjectCache(Function* xls_function,
+                                   JitObjectCache& cache, int64_t opt_level,
+                                   JitObserver* jit_observer) {
+  // The OrcJit only serves as the arena holding the loaded object code; no
+  // modules are compiled by it.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<OrcJit> orc_jit,
+                       OrcJit::Create(opt_level));
+  std::string key =
+      JitObjectCache::ComputeKey(xls_function, opt_level,
+                                 orc_jit->include_msan(),
+                                 orc_jit->target_triple());
+  XLS_ASSIGN_OR_RETURN(std::optional<CachedJitObject> cached,
+                       cache.Lookup(key));
+  if (!cached.has_value()) {
+    XLS_ASSIGN_OR_RETURN(JitObjectCode object_code,
+                         CreateObjectCode(xls_function, opt_level,
+                                          orc_jit->include_msan(),
+                                          jit_observer));
+    XLS_ASSIGN_OR_RETURN(
+        cached, cache.Store(key, object_code, xls_function->package(),
+                            orc_jit->include_msan()));
+  }
+  XLS_RET_CHECK_EQ(cached->entrypoints.entrypoint_size(), 1);
+  const AotEntrypointProto& entrypoint = cached->entrypoints.entrypoint(0);
+  XLS_RET_CHECK_EQ(entrypoint.xls_function_identifier(), xls_function->name());
+
+  XLS_RETURN_IF_ERROR(orc_jit->LoadObjectCode(cached->object_code));
+  XLS_ASSIGN_OR_RETURN(llvm::orc::ExecutorAddr function_addr,
+                       orc_jit->LoadSymbol(entrypoint.function_symbol()));
+  std::optional<JitFunctionType> packed_function;
+  if (entrypoint.has_packed_function_symbol()) {
+    XLS_ASSIGN_OR_RETURN(
+        llvm::orc::ExecutorAddr packed_addr,
+        orc_jit->LoadSymbol(entrypoint.packed_function_symbol()));
+    packed_function = absl::bit_cast<JitFunctionType>(packed_addr);
+  }
+  XLS_ASSIGN_OR_RETURN(
+      JittedFunctionBase function_base,
+      JittedFunctionBase::BuildFromAot(
+          entrypoint, absl::bit_cast<JitFunctionType>(function_addr),
+          packed_function));
+
+  llvm::Expected<llvm::DataLayout> layout =
+      llvm::DataLayout::parse(cached->entrypoints.data_layout());
+  XLS_RET_CHECK(layout) << "Unable to parse '"
+                        << cached->entrypoints.data_layout()
+                        << "' to an llvm data-layout.";
+  XLS_ASSIGN_OR_RETURN(InterfaceMetadata metadata,
+                       InterfaceMetadata::CreateFromFunction(xls_function));
+  return std::unique_ptr<FunctionJit>(new FunctionJit(
+      std::move(metadata), std::move(orc_jit), std::move(function_base),
+      /*has_observer_callbacks=*/false, std::make_unique<JitRuntime>(*layout)));
+}
+
 absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateInternal(
     Function* xls_function, int64_t opt_level, bool include_observer_callbacks,
-    JitObserver* jit_observer) {
+    bool include_node_profiling, JitObserver* jit_observer,
+    const LlvmOptions& llvm_options) {
   XLS_ASSIGN_OR_RETURN(
       auto orc_jit,
       OrcJit::Create(opt_level, include_observer_callbacks, jit_observer));
+  orc_jit->SetIncludeNodeProfiling(include_node_profiling);
+  orc_jit->SetCompileThreads(llvm_options.compile_threads);
+  orc_jit->SetLlvmPipeline(llvm_options.pipeline);
+  orc_jit->SetOptimizationBudget(llvm_options.optimization_budget);
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
                        orc_jit->CreateDataLayout());
   XLS_ASSIGN_OR_RETURN(auto function_base,
@@ -167,8 +262,16 @@ absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateInternal(
       include_observer_callbacks, std::make_unique<JitRuntime>(data_layout)));
 }
 
-absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
-    absl::Span<const Value> args) {
+NodeProfileProto FunctionJit::GetNodeProfile() const {
+  return BuildNodeProfile(jitted_function_base_.profile_sites(),
+                          node_profile_counters_);
+}
+
+void FunctionJit::ResetNodeProfile() {
+  absl::c_fill(node_profile_counters_, 0);
+}
+
+absl::Status FunctionJit::CheckArgs(absl::Span<const Value> args) const {
   if (args.size() != metadata_.ParamCount()) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Arg list to '%s' has the wrong size: %d vs expected %d.",
@@ -182,22 +285,36 @@ absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
           args[i].ToString(), i, metadata_.param_types[i]->ToString()));
     }
   }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<InterpreterResult<Value>> FunctionJit::RunWithBuffers(
+    absl::Span<const Value> args, JitArgumentSet& arg_buffers,
+    JitArgumentSet& result_buffers, JitTempBuffer& temp_buffer,
+    InstanceContext* instance_context) const {
+  XLS_RETURN_IF_ERROR(CheckArgs(args));
 
   // Allocate argument buffers and copy in arg Values.
   XLS_RETURN_IF_ERROR(jit_runtime_->PackArgs(args, metadata_.param_types,
-                                             arg_buffers_.pointers()));
+                                             arg_buffers.pointers()));
 
   InterpreterEvents events;
   jitted_function_base_.RunJittedFunction(
-      arg_buffers_, result_buffers_, temp_buffer_, &events,
-      /*instance_context=*/&callbacks_, /*jit_runtime=*/runtime(),
+      arg_buffers, result_buffers, temp_buffer, &events, instance_context,
+      /*jit_runtime=*/runtime(),
       /*continuation_point=*/0);
-  Value result = jit_runtime_->UnpackBuffer(result_buffers_.pointers()[0],
+  Value result = jit_runtime_->UnpackBuffer(result_buffers.pointers()[0],
                                             metadata_.return_type);
 
   return InterpreterResult<Value>{std::move(result), std::move(events)};
 }
 
+absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
+    absl::Span<const Value> args) {
+  return RunWithBuffers(args, arg_buffers_, result_buffers_, temp_buffer_,
+                        &callbacks_);
+}
+
 absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
     const absl::flat_hash_map<std::string, Value>& kwargs) {
   XLS_ASSIGN_OR_RETURN(std::vector<Value> positional_args,
@@ -205,10 +322,81 @@ absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
   return Run(positional_args);
 }
 
-template <bool kForceZeroCopy>
-absl::Status FunctionJit::RunWithViews(absl::Span<uint8_t* const> args,
-                                       absl::Span<uint8_t> result_buffer,
-                                       InterpreterEvents* events) {
+absl::StatusOr<InterpreterResult<std::vector<Value>>> FunctionJit::RunBatched(
+    absl::Span<const std::vector<Value>> argsets) {
+  int64_t batch_size = argsets.size();
+  for (int64_t lane = 0; lane < batch_size; ++lane) {
+    absl::Span<const Value> args = argsets[lane];
+    if (args.size() != metadata_.ParamCount()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Arg list %d to '%s' has the wrong size: %d vs expected %d.", lane,
+          metadata_.name, args.size(), metadata_.ParamCount()));
+    }
+    for (int i = 0; i < metadata_.ParamCount(); i++) {
+      if (!ValueConformsToType(args[i], metadata_.param_types[i])) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Got argument %s for parameter %d of arg list %d which is not of "
+            "type %s",
+            args[i].ToString(), i, lane, metadata_.param_types[i]->ToString()));
+      }
+    }
+  }
+
+  JitArgumentSet inputs =
+      jitted_function_base_.CreateBatchedInputBuffer(batch_size);
+  JitArgumentSet outputs =
+      jitted_function_base_.CreateBatchedOutputBuffer(batch_size);
+  for (int64_t i = 0; i < metadata_.ParamCount(); ++i) {
+    int64_t stride = GetArgBatchStride(i);
+    for (int64_t lane = 0; lane < batch_size; ++lane) {
+      jit_runtime_->BlitValueToBuffer(
+          argsets[lane][i], metadata_.param_types[i],
+          absl::MakeSpan(inputs.pointers()[i] + lane * stride, stride));
+    }
+  }
+
+  InterpreterEvents events;
+  XLS_RETURN_IF_ERROR(jitted_function_base_.RunBatchedJittedFunction(
+      inputs.get(), outputs.get(), temp_buffer_.get(), &events,
+      /*instance_context=*/&callbacks_, runtime(), batch_size));
+
+  std::vector<Value> results;
+  results.reserve(batch_size);
+  int64_t result_stride = GetReturnBatchStride();
+  for (int64_t lane = 0; lane < batch_size; ++lane) {
+    results.push_back(jit_runtime_->UnpackBuffer(
+        outputs.pointers()[0] + lane * result_stride, metadata_.return_type));
+  }
+  return InterpreterResult<std::vector<Value>>{std::move(results),
+                                               std::move(events)};
+}
+
+absl::Status FunctionJit::RunBatchedWithViews(absl::Span<uint8_t* const> args,
+                                              absl::Span<uint8_t> result_buffer,
+                                              int64_t batch_size,
+                                              InterpreterEvents* events) {
+  if (args.size() != metadata_.ParamCount()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Arg list has the wrong size: %d vs expected %d.",
+                        args.size(), metadata_.ParamCount()));
+  }
+  if (batch_size < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Batch size must be non-negative, got %d", batch_size));
+  }
+  if (result_buffer.size() < GetReturnBatchStride() * batch_size) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Result buffer too small - must be at least %d bytes!",
+        GetReturnBatchStride() * batch_size));
+  }
+  uint8_t* output_buffers[1] = {result_buffer.data()};
+  return jitted_function_base_.RunBatchedJittedFunction(
+      args.data(), output_buffers, temp_buffer_.get(), events,
+      /*instance_context=*/&callbacks_, runtime(), batch_size);
+}
+
+absl::Status FunctionJit::CheckViews(absl::Span<uint8_t* const> args,
+                                     absl::Span<uint8_t> result_buffer) const {
   if (args.size() != metadata_.ParamCount()) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Arg list has the wrong size: %d vs expected %d.",
@@ -220,7 +408,14 @@ absl::Status FunctionJit::RunWithViews(absl::Span<uint8_t* const> args,
         absl::StrCat("Result buffer too small - must be at least %d bytes!",
                      GetReturnTypeSize()));
   }
+  return absl::OkStatus();
+}
 
+template <bool kForceZeroCopy>
+absl::Status FunctionJit::RunWithViews(absl::Span<uint8_t* const> args,
+                                       absl::Span<uint8_t> result_buffer,
+                                       InterpreterEvents* events) {
+  XLS_RETURN_IF_ERROR(CheckViews(args, result_buffer));
   InvokeUnalignedJitFunction<kForceZeroCopy>(args, result_buffer.data(),
                                              events);
   return absl::OkStatus();
@@ -236,18 +431,78 @@ template absl::Status FunctionJit::RunWithViews</*kForceZeroCopy=*/false>(
 template <bool kForceZeroCopy>
 void FunctionJit::InvokeUnalignedJitFunction(
     absl::Span<const uint8_t* const> arg_buffers, uint8_t* output_buffer,
-    InterpreterEvents* events) {
+    void* temp_buffer, InstanceContext* instance_context,
+    InterpreterEvents* events) const {
   uint8_t* output_buffers[1] = {output_buffer};
   jitted_function_base_.RunUnalignedJittedFunction<kForceZeroCopy>(
-      arg_buffers.data(), output_buffers, temp_buffer_.get(), events,
-      /*instance_context=*/&callbacks_, runtime(), /*continuation=*/0);
+      arg_buffers.data(), output_buffers, temp_buffer, events, instance_context,
+      runtime(), /*continuation=*/0);
 }
 
 template void FunctionJit::InvokeUnalignedJitFunction</*kForceZeroCopy=*/false>(
     absl::Span<const uint8_t* const> arg_buffers, uint8_t* output_buffer,
-    InterpreterEvents* events);
+    void* temp_buffer, InstanceContext* instance_context,
+    InterpreterEvents* events) const;
 template void FunctionJit::InvokeUnalignedJitFunction</*kForceZeroCopy=*/true>(
     absl::Span<const uint8_t* const> arg_buffers, uint8_t* output_buffer,
+    void* temp_buffer, InstanceContext* instance_context,
+    InterpreterEvents* events) const;
+
+std::unique_ptr<FunctionJit::ExecutionContext>
+FunctionJit::CreateExecutionContext() const {
+  return std::unique_ptr<ExecutionContext>(new ExecutionContext(this));
+}
+
+FunctionJit::ExecutionContext::ExecutionContext(const FunctionJit* jit)
+    : jit_(jit),
+      arg_buffers_(jit->jitted_function_base_.CreateInputBuffer()),
+      result_buffers_(jit->jitted_function_base_.CreateOutputBuffer()),
+      temp_buffer_(jit->jitted_function_base_.CreateTempBuffer()),
+      node_profile_counters_(jit->NodeProfileCounterCount(), 0) {
+  callbacks_.node_profile_counters =
+      node_profile_counters_.empty() ? nullptr : node_profile_counters_.data();
+}
+
+NodeProfileProto FunctionJit::ExecutionContext::GetNodeProfile() const {
+  return BuildNodeProfile(jit_->jitted_function_base_.profile_sites(),
+                          node_profile_counters_);
+}
+
+void FunctionJit::ExecutionContext::ResetNodeProfile() {
+  absl::c_fill(node_profile_counters_, 0);
+}
+
+absl::StatusOr<InterpreterResult<Value>> FunctionJit::ExecutionContext::Run(
+    absl::Span<const Value> args) {
+  return jit_->RunWithBuffers(args, arg_buffers_, result_buffers_,
+                              temp_buffer_, &callbacks_);
+}
+
+absl::StatusOr<InterpreterResult<Value>> FunctionJit::ExecutionContext::Run(
+    const absl::flat_hash_map<std::string, Value>& kwargs) {
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<Value> positional_args,
+      KeywordArgsToPositional(jit_->metadata_.param_names, kwargs));
+  return Run(positional_args);
+}
+
+template <bool kForceZeroCopy>
+absl::Status FunctionJit::ExecutionContext::RunWithViews(
+    absl::Span<uint8_t* const> args, absl::Span<uint8_t> result_buffer,
+    InterpreterEvents* events) {
+  XLS_RETURN_IF_ERROR(jit_->CheckViews(args, result_buffer));
+  jit_->InvokeUnalignedJitFunction<kForceZeroCopy>(
+      args, result_buffer.data(), temp_buffer_.get(), &callbacks_, events);
+  return absl::OkStatus();
+}
+
+template absl::Status
+FunctionJit::ExecutionContext::RunWithViews</*kForceZeroCopy=*/true>(
+    absl::Span<uint8_t* const> args, absl::Span<uint8_t> result_buffer,
+    InterpreterEvents* events);
+template absl::Status
+FunctionJit::ExecutionContext::RunWithViews</*kForceZeroCopy=*/false>(
+    absl::Span<uint8_t* const> args, absl::Span<uint8_t> result_buffer,
     InterpreterEvents* events);
 
 }  // namespace xls
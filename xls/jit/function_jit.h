@@ -38,7 +38,11 @@
 #include "xls/jit/function_base_jit.h"
 #include "xls/jit/jit_buffer.h"
 #include "xls/jit/jit_callbacks.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/jit/llvm_compiler.h"
+#include "xls/jit/node_profile.h"
+#include "xls/jit/node_profile.pb.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
 
@@ -47,9 +51,56 @@ namespace xls {
 // This class provides a facility to execute XLS functions (on the host) by
 // converting it to LLVM IR, compiling it, and finally executing it. Not
 // thread-safe due to sharing of result and temporary buffers between
-// invocations of Run.
+// invocations of Run. To execute the compiled code from multiple threads create
+// one ExecutionContext per thread with CreateExecutionContext().
 class FunctionJit {
  public:
+  // Owns the argument, result and temporary buffers needed to run the compiled
+  // function. Any number of contexts created from the same FunctionJit may be
+  // used concurrently, each on its own thread, and all share the single
+  // compiled body; an individual context is not thread-safe. A context must not
+  // outlive the FunctionJit which created it.
+  class ExecutionContext {
+   public:
+    ExecutionContext(const ExecutionContext&) = delete;
+    ExecutionContext& operator=(const ExecutionContext&) = delete;
+
+    // Executes the compiled function with the specified arguments.
+    absl::StatusOr<InterpreterResult<Value>> Run(absl::Span<const Value> args);
+
+    // As above, buth with arguments as key-value pairs.
+    absl::StatusOr<InterpreterResult<Value>> Run(
+        const absl::flat_hash_map<std::string, Value>& kwargs);
+
+    // Executes the compiled function with the arguments and results specified
+    // as "views". See FunctionJit::RunWithViews.
+    template <bool kForceZeroCopy = false>
+    absl::Status RunWithViews(absl::Span<uint8_t* const> args,
+                              absl::Span<uint8_t> result_buffer,
+                              InterpreterEvents* events);
+
+    const FunctionJit& jit() const { return *jit_; }
+
+    // Returns the node profile accumulated by runs using this context. Empty
+    // unless the FunctionJit was created with CreateWithNodeProfiling.
+    NodeProfileProto GetNodeProfile() const;
+
+    // Clears the node profile accumulated by runs using this context.
+    void ResetNodeProfile();
+
+   private:
+    explicit ExecutionContext(const FunctionJit* jit);
+
+    const FunctionJit* jit_;
+    JitArgumentSet arg_buffers_;
+    JitArgumentSet result_buffers_;
+    JitTempBuffer temp_buffer_;
+    InstanceContext callbacks_ = InstanceContext::CreateForFunc();
+    std::vector<uint64_t> node_profile_counters_;
+
+    friend class FunctionJit;
+  };
+
   // Returns an object containing a host-compiled version of the specified XLS
   // function.
   static absl::StatusOr<std::unique_ptr<FunctionJit>> Create(
@@ -57,6 +108,43 @@ class FunctionJit {
       bool include_observer_callbacks = false,
       JitObserver* jit_observer = nullptr);
 
+  // Returns an object containing a host-compiled version of the specified XLS
+  // function instrumented to measure the time spent evaluating each node. The
+  // measurements are accumulated across runs and may be retrieved with
+  // GetNodeProfile(). The instrumentation reads the processor's cycle counter
+  // around every node so it perturbs the generated code; it is intended for
+  // finding the nodes which dominate the run time, not for benchmarking.
+  static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateWithNodeProfiling(
+      Function* xls_function, int64_t opt_level = 3,
+      JitObserver* jit_observer = nullptr);
+
+  // Returns an object containing a host-compiled version of the specified XLS
+  // function, splitting a large function's LLVM module into parts which are
+  // optimized and compiled on up to `compile_threads` threads. See
+  // OrcJit::SetCompileThreads. Intended for huge (e.g., fully unrolled)
+  // functions whose compile time would otherwise be dominated by LLVM.
+  static absl::StatusOr<std::unique_ptr<FunctionJit>>
+  CreateWithParallelCompilation(Function* xls_function, int64_t compile_threads,
+                                int64_t opt_level = 3);
+
+  // How LLVM compiles a function, for trading compile time against the speed
+  // of the generated code.
+  struct LlvmOptions {
+    // See OrcJit::SetCompileThreads.
+    int64_t compile_threads = 1;
+    // See LlvmCompiler::SetLlvmPipeline.
+    LlvmPipeline pipeline = LlvmPipeline::kStandard;
+    // See LlvmCompiler::SetOptimizationBudget.
+    int64_t optimization_budget = LlvmCompiler::kUnlimitedOptimizationBudget;
+  };
+
+  // Returns an object containing a host-compiled version of the specified XLS
+  // function compiled with the given LLVM options. An observer requesting
+  // optimization_stats is told what the optimization cost and achieved.
+  static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateWithLlvmOptions(
+      Function* xls_function, const LlvmOptions& llvm_options,
+      int64_t opt_level = 3, JitObserver* jit_observer = nullptr);
+
   // Returns an object containing an AOT-compiled version of the specified XLS
   // function.
   static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateFromAot(
@@ -65,9 +153,24 @@ class FunctionJit {
       std::optional<JitFunctionType> function_packed = std::nullopt);
 
   // Returns the bytes of an object file containing the compiled XLS function.
+  // See AotCompiler::Create for the meaning of `target_cpu`.
   static absl::StatusOr<JitObjectCode> CreateObjectCode(
       Function* xls_function, int64_t opt_level, bool include_msan,
-      JitObserver* observer = nullptr);
+      JitObserver* observer = nullptr,
+      std::optional<std::string> target_cpu = std::nullopt);
+
+  // Returns an object containing a host-compiled version of the specified XLS
+  // function, reusing the object code stored in 'cache' if this function was
+  // previously compiled with the same options. On a miss the function is
+  // compiled to object code and stored in the cache before being loaded. In
+  // either case the resulting code is loaded as if it were AOT-compiled.
+  static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateWithObjectCache(
+      Function* xls_function, JitObjectCache& cache, int64_t opt_level = 3,
+      JitObserver* jit_observer = nullptr);
+
+  // Returns a new execution context sharing this object's compiled code. See
+  // ExecutionContext. Runtime observers are not supported by execution contexts.
+  std::unique_ptr<ExecutionContext> CreateExecutionContext() const;
 
   // Executes the compiled function with the specified arguments.
   absl::StatusOr<InterpreterResult<Value>> Run(absl::Span<const Value> args);
@@ -93,6 +196,25 @@ class FunctionJit {
                             absl::Span<uint8_t> result_buffer,
                             InterpreterEvents* events);
 
+  // Executes the compiled function once for each of the given argument sets
+  // with a single call into the jitted code. Events from all invocations are
+  // accumulated into the returned result.
+  absl::StatusOr<InterpreterResult<std::vector<Value>>> RunBatched(
+      absl::Span<const std::vector<Value>> argsets);
+
+  // Executes the compiled function over a batch of `batch_size` argument sets
+  // stored in structure-of-arrays form: `args[i]` points to `batch_size`
+  // consecutive values of the i-th parameter in the native LLVM data layout,
+  // each `GetArgBatchStride(i)` bytes apart. Results are written to
+  // `result_buffer` in the same fashion using `GetReturnBatchStride()`. All
+  // buffers must be aligned to the preferred alignment of their type (see
+  // `jitted_function_base().CreateBatchedInputBuffer()`). The loop over the
+  // batch runs inside the jitted code so no per-element call overhead is paid.
+  absl::Status RunBatchedWithViews(absl::Span<uint8_t* const> args,
+                                   absl::Span<uint8_t> result_buffer,
+                                   int64_t batch_size,
+                                   InterpreterEvents* events);
+
   // Similar to RunWithViews(), except the arguments here are _packed_views_ -
   // views whose data elements are tightly packed, with no padding bits or bytes
   // between them. The function return value is specified as the last arg - its
@@ -165,6 +287,15 @@ class FunctionJit {
     return jitted_function_base_.output_buffer_abi_alignments()[0];
   }
 
+  // Gets the distance in bytes between consecutive elements of the batched
+  // argument (or return value) buffers used by RunBatchedWithViews.
+  int64_t GetArgBatchStride(int arg_index) const {
+    return jitted_function_base_.input_batch_stride(arg_index);
+  }
+  int64_t GetReturnBatchStride() const {
+    return jitted_function_base_.output_batch_stride(0);
+  }
+
   // Gets the size of the compiled function's arguments (or return value) in the
   // packed layout.
   int64_t GetPackedArgTypeSize(int arg_index) const {
@@ -207,6 +338,14 @@ class FunctionJit {
   }
   bool SupportsObservers() const { return has_observer_callbacks_; }
 
+  // Returns the node profile accumulated by runs of this object (not including
+  // runs through execution contexts). Empty unless this object was created
+  // with CreateWithNodeProfiling.
+  NodeProfileProto GetNodeProfile() const;
+
+  // Clears the node profile accumulated by runs of this object.
+  void ResetNodeProfile();
+
  private:
   struct InterfaceMetadata {
     std::string name;
@@ -236,11 +375,37 @@ class FunctionJit {
         result_buffers_(jitted_function_base_.CreateOutputBuffer()),
         temp_buffer_(jitted_function_base_.CreateTempBuffer()),
         jit_runtime_(std::move(runtime)),
-        has_observer_callbacks_(has_observer_callbacks) {}
+        has_observer_callbacks_(has_observer_callbacks),
+        node_profile_counters_(NodeProfileCounterCount(), 0) {
+    callbacks_.node_profile_counters =
+        node_profile_counters_.empty() ? nullptr
+                                       : node_profile_counters_.data();
+  }
 
   static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateInternal(
       Function* xls_function, int64_t opt_level,
-      bool include_observer_callbacks, JitObserver* jit_observer);
+      bool include_observer_callbacks, bool include_node_profiling,
+      JitObserver* jit_observer, const LlvmOptions& llvm_options = {});
+
+  // Returns the number of node profile counters used by the compiled code.
+  int64_t NodeProfileCounterCount() const {
+    return kNodeProfileCountersPerSite *
+           jitted_function_base_.profile_sites().size();
+  }
+
+  // Returns an error if `args` do not match the function's signature.
+  absl::Status CheckArgs(absl::Span<const Value> args) const;
+
+  // Executes the compiled function over `args` using the given buffers and
+  // instance context. Shared by FunctionJit::Run and ExecutionContext::Run.
+  absl::StatusOr<InterpreterResult<Value>> RunWithBuffers(
+      absl::Span<const Value> args, JitArgumentSet& arg_buffers,
+      JitArgumentSet& result_buffers, JitTempBuffer& temp_buffer,
+      InstanceContext* instance_context) const;
+
+  // Checks the sizes of the view buffers passed to RunWithViews.
+  absl::Status CheckViews(absl::Span<uint8_t* const> args,
+                          absl::Span<uint8_t> result_buffer) const;
 
   template <bool kForceZeroCopy, typename... ArgsT>
   absl::Status RunWithUnpackedViewsCommon(ArgsT... args) {
@@ -297,7 +462,15 @@ class FunctionJit {
   template <bool kForceZeroCopy = false>
   void InvokeUnalignedJitFunction(absl::Span<const uint8_t* const> arg_buffers,
                                   uint8_t* output_buffer,
-                                  InterpreterEvents* events);
+                                  InterpreterEvents* events) {
+    InvokeUnalignedJitFunction<kForceZeroCopy>(
+        arg_buffers, output_buffer, temp_buffer_.get(), &callbacks_, events);
+  }
+  template <bool kForceZeroCopy = false>
+  void InvokeUnalignedJitFunction(absl::Span<const uint8_t* const> arg_buffers,
+                                  uint8_t* output_buffer, void* temp_buffer,
+                                  InstanceContext* instance_context,
+                                  InterpreterEvents* events) const;
 
   InterfaceMetadata metadata_;
 
@@ -320,6 +493,9 @@ class FunctionJit {
 
   // Are callbacks for node-values compiled in.
   bool has_observer_callbacks_;
+
+  // Counters accumulated by node profiling code (if compiled in).
+  std::vector<uint64_t> node_profile_counters_;
 };
 
 }  // namespace xls
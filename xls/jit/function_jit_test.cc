@@ -50,6 +50,7 @@
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/interpreter/ir_evaluator_test_base.h"
 #include "xls/interpreter/observer.h"
 #include "xls/interpreter/random_value.h"
@@ -67,6 +68,7 @@
 #include "xls/jit/function_base_jit.h"
 #include "xls/jit/jit_buffer.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/jit/node_profile.pb.h"
 #include "xls/jit/llvm_compiler.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
@@ -77,9 +79,16 @@ namespace {
 using ::absl_testing::IsOk;
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
+using ::testing::AllOf;
+using ::testing::Contains;
+using ::testing::Each;
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::IsSupersetOf;
+using ::testing::Not;
+using ::testing::Property;
 using ::testing::TestParamInfo;
 using ::testing::Values;
 
@@ -312,6 +321,336 @@ TEST(FunctionJitTest, ReuseTest) {
               IsOkAndHolds(Value(UBits(7, 8))));
 }
 
+TEST(FunctionJitTest, RunBatched) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn add_and_swap(x: bits[8], y: bits[17]) -> (bits[17], bits[8]) {
+    zero_ext.1: bits[17] = zero_ext(x, new_bit_count=17)
+    add.2: bits[17] = add(zero_ext.1, y)
+    ret tuple.3: (bits[17], bits[8]) = tuple(add.2, x)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::Create(function));
+  EXPECT_TRUE(jit->jitted_function_base().HasBatchedFunction());
+
+  std::vector<std::vector<Value>> argsets;
+  std::vector<Value> expected;
+  for (int64_t i = 0; i < 100; ++i) {
+    argsets.push_back({Value(UBits(i, 8)), Value(UBits(1000 * i, 17))});
+    expected.push_back(Value::Tuple(
+        {Value(UBits((1001 * i) & 0x1ffff, 17)), Value(UBits(i, 8))}));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<std::vector<Value>> result,
+                           jit->RunBatched(argsets));
+  EXPECT_THAT(result.value, ElementsAreArray(expected));
+
+  // An empty batch is a no-op.
+  XLS_ASSERT_OK_AND_ASSIGN(result, jit->RunBatched({}));
+  EXPECT_TRUE(result.value.empty());
+
+  EXPECT_THAT(jit->RunBatched({{Value(UBits(1, 8))}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("wrong size")));
+  EXPECT_THAT(jit->RunBatched({{Value(UBits(1, 8)), Value(UBits(1, 8))}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not of type")));
+}
+
+TEST(FunctionJitTest, RunBatchedWithViews) {
+  Package package("my_package");
+  FunctionBuilder fb("test", &package);
+  fb.Add(fb.Param("x", package.GetBitsType(32)),
+         fb.Param("y", package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::Create(function));
+  ASSERT_EQ(jit->GetArgBatchStride(0), sizeof(uint32_t));
+  ASSERT_EQ(jit->GetArgBatchStride(1), sizeof(uint32_t));
+  ASSERT_EQ(jit->GetReturnBatchStride(), sizeof(uint32_t));
+
+  constexpr int64_t kBatchSize = 1000;
+  std::vector<uint32_t> x(kBatchSize);
+  std::vector<uint32_t> y(kBatchSize);
+  std::vector<uint32_t> result(kBatchSize);
+  for (int64_t i = 0; i < kBatchSize; ++i) {
+    x[i] = i * 7;
+    y[i] = 0xffff0000 + i;
+  }
+  std::array<uint8_t*, 2> args = {reinterpret_cast<uint8_t*>(x.data()),
+                                  reinterpret_cast<uint8_t*>(y.data())};
+  InterpreterEvents events;
+  XLS_ASSERT_OK(jit->RunBatchedWithViews(
+      args,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(result.data()),
+                     result.size() * sizeof(uint32_t)),
+      kBatchSize, &events));
+  for (int64_t i = 0; i < kBatchSize; ++i) {
+    EXPECT_EQ(result[i], x[i] + y[i]) << "lane " << i;
+  }
+
+  EXPECT_THAT(
+      jit->RunBatchedWithViews(
+          args,
+          absl::MakeSpan(reinterpret_cast<uint8_t*>(result.data()),
+                         sizeof(uint32_t)),
+          kBatchSize, &events),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("too small")));
+}
+
+TEST(FunctionJitTest, ExecutionContextsShareCompiledCode) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn muladd(x: bits[32], y: bits[32]) -> bits[32] {
+    umul.1: bits[32] = umul(x, y)
+    ret add.2: bits[32] = add(umul.1, y)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::Create(function));
+
+  constexpr int64_t kThreadCount = 8;
+  constexpr int64_t kIterations = 1000;
+  std::vector<std::unique_ptr<FunctionJit::ExecutionContext>> contexts;
+  for (int64_t t = 0; t < kThreadCount; ++t) {
+    contexts.push_back(jit->CreateExecutionContext());
+  }
+  std::vector<int64_t> mismatches(kThreadCount, 0);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t t = 0; t < kThreadCount; ++t) {
+      threads.push_back(std::make_unique<Thread>([&, t]() {
+        for (int64_t i = 0; i < kIterations; ++i) {
+          uint32_t x = t * kIterations + i;
+          uint32_t y = 3 * i + 1;
+          std::vector<Value> args = {Value(UBits(x, 32)), Value(UBits(y, 32))};
+          absl::StatusOr<InterpreterResult<Value>> result =
+              contexts[t]->Run(args);
+          if (!result.ok() ||
+              result->value != Value(UBits(static_cast<uint32_t>(x * y + y),
+                                           32))) {
+            ++mismatches[t];
+          }
+        }
+      }));
+    }
+  }
+  EXPECT_THAT(mismatches, ::testing::Each(0));
+
+  // Views go through the context's own temporary buffer as well.
+  uint32_t x = 6;
+  uint32_t y = 7;
+  uint32_t result = 0;
+  std::array<uint8_t*, 2> args = {reinterpret_cast<uint8_t*>(&x),
+                                  reinterpret_cast<uint8_t*>(&y)};
+  InterpreterEvents events;
+  XLS_ASSERT_OK(contexts.front()->RunWithViews(
+      args,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(&result), sizeof(result)),
+      &events));
+  EXPECT_EQ(result, 49);
+}
+
+TEST(FunctionJitTest, WideMulDivMod) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn muldivmod(x: bits[200], y: bits[200]) -> (bits[200], bits[200], bits[200], bits[200], bits[200], bits[200]) {
+    umul.1: bits[200] = umul(x, y)
+    smul.2: bits[200] = smul(x, y)
+    udiv.3: bits[200] = udiv(x, y)
+    sdiv.4: bits[200] = sdiv(x, y)
+    umod.5: bits[200] = umod(x, y)
+    smod.6: bits[200] = smod(x, y)
+    ret tuple.7: (bits[200], bits[200], bits[200], bits[200], bits[200], bits[200]) = tuple(umul.1, smul.2, udiv.3, sdiv.4, umod.5, smod.6)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::Create(function));
+
+  auto expect_matches = [&](const Bits& x, const Bits& y) {
+    XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<Value> result,
+                             jit->Run({Value(x), Value(y)}));
+    EXPECT_EQ(result.value,
+              Value::Tuple({Value(bits_ops::UMul(x, y).Slice(0, 200)),
+                            Value(bits_ops::SMul(x, y).Slice(0, 200)),
+                            Value(bits_ops::UDiv(x, y)),
+                            Value(bits_ops::SDiv(x, y)),
+                            Value(bits_ops::UMod(x, y)),
+                            Value(bits_ops::SMod(x, y))}))
+        << "x: " << x.ToDebugString() << " y: " << y.ToDebugString();
+  };
+  absl::BitGen bitgen;
+  Type* type = package.GetBitsType(200);
+  for (int64_t i = 0; i < 100; ++i) {
+    Bits x = RandomValue(type, bitgen).bits();
+    Bits y = RandomValue(type, bitgen).bits();
+    expect_matches(x, y);
+    expect_matches(x, bits_ops::ShiftRightLogical(y, i));
+  }
+  expect_matches(Bits::MinSigned(200), Bits::AllOnes(200));
+  expect_matches(Bits::MinSigned(200), Bits(200));
+  expect_matches(Bits::MaxSigned(200), Bits(200));
+}
+
+TEST(FunctionJitTest, NodeProfile) {
+  std::string ir_text = R"(
+  package my_package
+
+  fn square(a: bits[32]) -> bits[32] {
+    ret umul.10: bits[32] = umul(a, a)
+  }
+
+  top fn muladd(x: bits[32], y: bits[32]) -> bits[32] {
+    umul.1: bits[32] = umul(x, y)
+    invoke.2: bits[32] = invoke(umul.1, to_apply=square)
+    ret add.3: bits[32] = add(invoke.2, y)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, p->GetTopAsFunction());
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit,
+                           FunctionJit::CreateWithNodeProfiling(function));
+  std::unique_ptr<FunctionJit::ExecutionContext> context =
+      jit->CreateExecutionContext();
+
+  constexpr int64_t kRuns = 10;
+  for (int64_t i = 0; i < kRuns; ++i) {
+    std::vector<Value> args = {Value(UBits(i, 32)), Value(UBits(3, 32))};
+    XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<Value> result, jit->Run(args));
+    EXPECT_EQ(result.value, Value(UBits((3 * i) * (3 * i) + 3, 32)));
+  }
+  std::vector<Value> context_args = {Value(UBits(1, 32)), Value(UBits(2, 32))};
+  XLS_ASSERT_OK(context->Run(context_args));
+
+  auto entry = [](std::string_view function_name, std::string_view node_name,
+                  std::string_view op, uint64_t evaluations) {
+    return AllOf(
+        Property(&NodeProfileProto::Entry::function_name, function_name),
+        Property(&NodeProfileProto::Entry::node_name, node_name),
+        Property(&NodeProfileProto::Entry::op, op),
+        Property(&NodeProfileProto::Entry::evaluations, evaluations));
+  };
+  NodeProfileProto profile = jit->GetNodeProfile();
+  EXPECT_THAT(profile.entries(),
+              IsSupersetOf({entry("muladd", "umul.1", "umul", kRuns),
+                            entry("muladd", "invoke.2", "invoke", kRuns),
+                            entry("muladd", "add.3", "add", kRuns),
+                            entry("square", "umul.10", "umul", kRuns)}));
+  for (int64_t i = 1; i < profile.entries_size(); ++i) {
+    EXPECT_GE(profile.entries(i - 1).cycles(), profile.entries(i).cycles());
+  }
+
+  // Each execution context keeps its own counters.
+  EXPECT_THAT(context->GetNodeProfile().entries(),
+              Contains(entry("muladd", "add.3", "add", 1)));
+  context->ResetNodeProfile();
+  EXPECT_THAT(context->GetNodeProfile().entries(),
+              Each(Property(&NodeProfileProto::Entry::evaluations, 0)));
+
+  jit->ResetNodeProfile();
+  EXPECT_THAT(jit->GetNodeProfile().entries(),
+              Each(Property(&NodeProfileProto::Entry::cycles, 0)));
+}
+
+TEST(FunctionJitTest, ParallelCompilationOfLargeFunction) {
+  Package package("my_package");
+  FunctionBuilder fb("chain", &package);
+  BValue x = fb.Param("x", package.GetBitsType(32));
+  BValue acc = x;
+  constexpr int64_t kSteps = 2000;
+  for (int64_t i = 0; i < kSteps; ++i) {
+    acc = i % 2 == 0 ? fb.Add(acc, x)
+                     : fb.Xor(acc, fb.Literal(UBits(i * 7919, 32)));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, fb.BuildWithReturnValue(acc));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, FunctionJit::CreateWithParallelCompilation(
+                    function, /*compile_threads=*/4, /*opt_level=*/1));
+
+  for (uint32_t input : {0u, 1u, 0xdeadbeefu}) {
+    uint32_t expected = input;
+    for (int64_t i = 0; i < kSteps; ++i) {
+      expected = i % 2 == 0 ? expected + input
+                            : expected ^ static_cast<uint32_t>(i * 7919);
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<Value> result,
+                             jit->Run({Value(UBits(input, 32))}));
+    EXPECT_EQ(result.value, Value(UBits(expected, 32)));
+  }
+}
+
+class OptimizationStatsObserver final : public JitObserver {
+ public:
+  JitObserverRequests GetNotificationOptions() const override {
+    return JitObserverRequests{.optimization_stats = true};
+  }
+  void OptimizationStats(const llvm::Module* module,
+                         const JitOptimizationStats& stats) override {
+    stats_.push_back(stats);
+  }
+  const std::vector<JitOptimizationStats>& stats() const { return stats_; }
+
+ private:
+  std::vector<JitOptimizationStats> stats_;
+};
+
+TEST(FunctionJitTest, LlvmPipelines) {
+  Package package("my_package");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(R"(
+    fn muladd(x: bits[32], y: bits[32]) -> bits[32] {
+      umul.1: bits[32] = umul(x, y)
+      add.2: bits[32] = add(umul.1, x)
+      ret xor.3: bits[32] = xor(add.2, y)
+    }
+  )",
+                                                 &package));
+  struct Case {
+    FunctionJit::LlvmOptions options;
+    std::string_view pipeline;
+  };
+  for (const Case& c : std::vector<Case>{
+           {.options = {.pipeline = LlvmPipeline::kStandard},
+            .pipeline = "standard O3"},
+           {.options = {.pipeline = LlvmPipeline::kXls}, .pipeline = "xls O3"},
+           {.options = {.pipeline = LlvmPipeline::kXls,
+                        .optimization_budget = 1},
+            .pipeline = "xls-reduced O3"},
+       }) {
+    OptimizationStatsObserver observer;
+    XLS_ASSERT_OK_AND_ASSIGN(
+        auto jit, FunctionJit::CreateWithLlvmOptions(function, c.options,
+                                                     /*opt_level=*/3,
+                                                     &observer));
+    XLS_ASSERT_OK_AND_ASSIGN(
+        InterpreterResult<Value> result,
+        jit->Run({Value(UBits(6, 32)), Value(UBits(7, 32))}));
+    EXPECT_EQ(result.value, Value(UBits((6 * 7 + 6) ^ 7, 32)));
+    ASSERT_THAT(observer.stats(), Not(IsEmpty()));
+    EXPECT_EQ(observer.stats().front().pipeline, c.pipeline);
+    EXPECT_GT(observer.stats().front().instructions_before, 0);
+    EXPECT_GT(observer.stats().front().instructions_after, 0);
+  }
+}
+
+TEST(FunctionJitTest, NoNodeProfileByDefault) {
+  Package package("my_package");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(R"(
+  fn f(x: bits[8]) -> bits[8] {
+    ret neg.1: bits[8] = neg(x)
+  }
+  )",
+                                                 &package));
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::Create(function));
+  std::vector<Value> args = {Value(UBits(1, 8))};
+  XLS_ASSERT_OK(jit->Run(args));
+  EXPECT_THAT(jit->GetNodeProfile().entries(), IsEmpty());
+}
+
 TEST(FunctionJitTest, OneHotZeroBit) {
   Package package("my_package");
   std::string ir_text = R"(
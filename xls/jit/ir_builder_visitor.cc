@@ -48,6 +48,7 @@
 #include "llvm/include/llvm/IR/Value.h"
 #include "llvm/include/llvm/Support/Alignment.h"
 #include "llvm/include/llvm/Support/Casting.h"
+#include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/bits.h"
@@ -80,6 +81,12 @@ bool ShouldMaterializeAtUse(Node* node) {
 
 namespace {
 
+// Channel payloads at least this many bytes wide are sent and received through
+// the queue's slot API so that the payload is copied directly between the node
+// buffer and the queue's storage with a fixed-size copy. Narrower payloads use
+// the single-call WriteRaw/ReadRaw wrappers which have lower call overhead.
+constexpr int64_t kInPlaceQueueAccessMinBytes = 64;
+
 // Abstraction representing a value carried across iterations of the loop.
 struct LoopCarriedValue {
   std::string name;
@@ -326,12 +333,248 @@ std::vector<std::string> ConcatVectors(absl::Span<const std::string> a,
   return result;
 }
 
+// Bits values whose LLVM type is at least this wide are lowered as vectors of
+// 64-bit lanes rather than as single wide LLVM integers. LLVM legalizes wide
+// integer operations into long serial chains of word-sized operations (carry
+// chains for add/sub, per-word select trees for variable shifts) which neither
+// vectorize nor schedule well. LLVM bit widths of bits types are powers of two
+// so types this wide are always a whole number of lanes.
+constexpr int64_t kWideLoweringMinBits = 256;
+constexpr int64_t kWideLaneBits = 64;
+
+bool UseWideLowering(llvm::Type* type) {
+  return type->isIntegerTy() &&
+         type->getIntegerBitWidth() >= kWideLoweringMinBits &&
+         type->getIntegerBitWidth() % kWideLaneBits == 0;
+}
+
+llvm::FixedVectorType* WideLaneType(llvm::Type* type) {
+  return llvm::FixedVectorType::get(
+      llvm::Type::getInt64Ty(type->getContext()),
+      type->getIntegerBitWidth() / kWideLaneBits);
+}
+
+// Reinterprets the wide integer `value` as a vector of 64-bit lanes. Lane 0
+// holds the least significant bits.
+llvm::Value* ToLanes(llvm::Value* value, llvm::IRBuilder<>& builder) {
+  return builder.CreateBitCast(value, WideLaneType(value->getType()));
+}
+
+llvm::Value* FromLanes(llvm::Value* lanes, llvm::Type* type,
+                       llvm::IRBuilder<>& builder) {
+  return builder.CreateBitCast(lanes, type);
+}
+
+// Applies the bitwise `opcode` (and, or, xor) across `operands`.
+llvm::Value* EmitNaryBitwiseOp(llvm::Instruction::BinaryOps opcode,
+                               absl::Span<llvm::Value* const> operands,
+                               llvm::IRBuilder<>& builder) {
+  llvm::Type* type = operands.front()->getType();
+  const bool wide = UseWideLowering(type);
+  llvm::Value* result =
+      wide ? ToLanes(operands.front(), builder) : operands.front();
+  for (int64_t i = 1; i < operands.size(); ++i) {
+    result = builder.CreateBinOp(
+        opcode, result, wide ? ToLanes(operands[i], builder) : operands[i]);
+  }
+  return wide ? FromLanes(result, type, builder) : result;
+}
+
+llvm::Value* EmitNot(llvm::Value* operand, llvm::IRBuilder<>& builder) {
+  if (!UseWideLowering(operand->getType())) {
+    return builder.CreateNot(operand);
+  }
+  return FromLanes(builder.CreateNot(ToLanes(operand, builder)),
+                   operand->getType(), builder);
+}
+
+// Emits `lhs + rhs` (or `lhs - rhs` if `subtract` is true) on wide integers
+// using carry-lookahead across 64-bit lanes: the lanes are added independently,
+// then the carry into each lane is computed from the per-lane generate and
+// propagate bits with a single narrow integer add, and finally added in.
+llvm::Value* EmitWideAddOrSub(llvm::Value* lhs, llvm::Value* rhs,
+                              bool subtract, llvm::IRBuilder<>& builder) {
+  llvm::Type* type = lhs->getType();
+  llvm::FixedVectorType* lane_type = WideLaneType(type);
+  int64_t lane_count = lane_type->getNumElements();
+  llvm::Type* mask_type = builder.getIntNTy(lane_count);
+  llvm::Type* mask_vector_type =
+      llvm::FixedVectorType::get(builder.getInt1Ty(), lane_count);
+
+  // a - b is computed as a + ~b + 1.
+  llvm::Value* lhs_lanes = ToLanes(lhs, builder);
+  llvm::Value* rhs_lanes = ToLanes(rhs, builder);
+  if (subtract) {
+    rhs_lanes = builder.CreateNot(rhs_lanes);
+  }
+  llvm::Value* partial_sum = builder.CreateAdd(lhs_lanes, rhs_lanes);
+
+  // Lanes which carry out by themselves and lanes which carry out only if
+  // there is a carry in. These sets are disjoint.
+  llvm::Value* generate = builder.CreateBitCast(
+      builder.CreateICmpULT(partial_sum, lhs_lanes), mask_type);
+  llvm::Value* propagate = builder.CreateBitCast(
+      builder.CreateICmpEQ(partial_sum,
+                           llvm::Constant::getAllOnesValue(lane_type)),
+      mask_type);
+
+  // Viewing each lane as a single bit, the carry into lane k is the carry into
+  // bit k of the sum x + y where x & y == generate and x ^ y == propagate,
+  // i.e., x = generate | propagate and y = generate. The carries into each bit
+  // of a sum are (x + y + carry_in) ^ x ^ y.
+  llvm::Value* carries = builder.CreateAdd(
+      builder.CreateOr(generate, propagate), generate);
+  if (subtract) {
+    carries = builder.CreateAdd(carries, llvm::ConstantInt::get(mask_type, 1));
+  }
+  carries = builder.CreateXor(carries, propagate);
+  llvm::Value* carry_lanes = builder.CreateZExt(
+      builder.CreateBitCast(carries, mask_vector_type), lane_type);
+  return FromLanes(builder.CreateAdd(partial_sum, carry_lanes), type, builder);
+}
+
+// Returns the lanes of `lanes` shifted by the constant `amount` bits toward the
+// more significant end (if `left`) or less significant end, shifting in zeros.
+// Only the lowest `result_lane_count` lanes of the result are produced.
+llvm::Value* ShiftLanesByConstant(llvm::Value* lanes, int64_t amount, bool left,
+                                  int64_t result_lane_count,
+                                  llvm::IRBuilder<>& builder) {
+  int64_t lane_count =
+      llvm::cast<llvm::FixedVectorType>(lanes->getType())->getNumElements();
+  int64_t lane_shift = amount / kWideLaneBits;
+  int64_t bit_shift = amount % kWideLaneBits;
+  llvm::Value* zero = llvm::Constant::getNullValue(lanes->getType());
+  // Selects, for each result lane, the source lane `offset` lanes away. Index
+  // `lane_count` selects a lane of `zero`.
+  auto select_lanes = [&](int64_t offset) {
+    std::vector<int> mask(result_lane_count);
+    for (int64_t i = 0; i < result_lane_count; ++i) {
+      int64_t source = left ? i - offset : i + offset;
+      mask[i] = source >= 0 && source < lane_count ? source : lane_count;
+    }
+    return builder.CreateShuffleVector(lanes, zero, mask);
+  };
+  llvm::Value* near = select_lanes(lane_shift);
+  if (bit_shift == 0) {
+    return near;
+  }
+  llvm::Value* far = select_lanes(lane_shift + 1);
+  llvm::Type* result_type = near->getType();
+  llvm::Value* near_amount = llvm::ConstantInt::get(result_type, bit_shift);
+  llvm::Value* far_amount =
+      llvm::ConstantInt::get(result_type, kWideLaneBits - bit_shift);
+  if (left) {
+    return builder.CreateOr(builder.CreateShl(near, near_amount),
+                            builder.CreateLShr(far, far_amount));
+  }
+  return builder.CreateOr(builder.CreateLShr(near, near_amount),
+                          builder.CreateShl(far, far_amount));
+}
+
+// Emits a shift of the wide integer `lhs` by the variable amount `rhs`. `lhs`
+// must already be sign-extended to its full LLVM width for arithmetic shifts.
+// The lanes are spilled to a stack buffer next to lanes of fill bits and the
+// whole-lane part of the shift is performed with unaligned vector loads at a
+// variable offset; the remaining sub-lane part is a pair of vector shifts.
+llvm::Value* EmitWideShiftOp(Op op, llvm::Value* lhs, llvm::Value* rhs,
+                             llvm::IRBuilder<>& builder) {
+  llvm::Type* type = lhs->getType();
+  llvm::FixedVectorType* lane_type = WideLaneType(type);
+  int64_t lane_count = lane_type->getNumElements();
+  int64_t bit_count = type->getIntegerBitWidth();
+  llvm::Type* i64 = builder.getInt64Ty();
+
+  // Clamp the shift amount to the bit count; shifting by the bit count shifts
+  // every lane out.
+  llvm::Value* amount = rhs;
+  if (amount->getType()->getIntegerBitWidth() < 64) {
+    amount = builder.CreateZExt(amount, i64);
+  }
+  llvm::Value* is_overshift = builder.CreateICmpUGE(
+      amount, llvm::ConstantInt::get(amount->getType(), bit_count));
+  if (amount->getType()->getIntegerBitWidth() > 64) {
+    amount = builder.CreateTrunc(amount, i64);
+  }
+  amount = builder.CreateSelect(is_overshift, builder.getInt64(bit_count),
+                                amount);
+  llvm::Value* lane_shift =
+      builder.CreateUDiv(amount, builder.getInt64(kWideLaneBits));
+  llvm::Value* bit_shift =
+      builder.CreateURem(amount, builder.getInt64(kWideLaneBits));
+  // Shifting by `64 - bit_shift` would be poison when `bit_shift` is zero so
+  // shift by one and then by `63 - bit_shift`.
+  llvm::Value* one = llvm::ConstantInt::get(lane_type, 1);
+  llvm::Value* near_amount = builder.CreateVectorSplat(lane_count, bit_shift);
+  llvm::Value* far_amount = builder.CreateVectorSplat(
+      lane_count,
+      builder.CreateSub(builder.getInt64(kWideLaneBits - 1), bit_shift));
+
+  llvm::Value* lanes = ToLanes(lhs, builder);
+  llvm::Type* fill_type = llvm::FixedVectorType::get(i64, lane_count + 1);
+  llvm::Value* fill = llvm::Constant::getNullValue(fill_type);
+  if (op == Op::kShra) {
+    llvm::Value* sign = builder.CreateAShr(
+        builder.CreateExtractElement(lanes, lane_count - 1),
+        builder.getInt64(kWideLaneBits - 1));
+    fill = builder.CreateVectorSplat(lane_count + 1, sign);
+  }
+  llvm::Value* buffer = builder.CreateAlloca(
+      llvm::ArrayType::get(i64, 2 * lane_count + 1), /*ArraySize=*/nullptr,
+      "wide_shift_buffer");
+  const llvm::Align lane_align(kWideLaneBits / 8);
+  auto lanes_at = [&](llvm::Value* index) {
+    return builder.CreateGEP(i64, buffer, index);
+  };
+  auto load_at = [&](llvm::Value* index) {
+    return builder.CreateAlignedLoad(lane_type, lanes_at(index), lane_align);
+  };
+
+  llvm::Value* result;
+  if (op == Op::kShll) {
+    // Buffer layout: [lane_count + 1 fill lanes][value lanes].
+    builder.CreateAlignedStore(fill, lanes_at(builder.getInt64(0)),
+                               lane_align);
+    builder.CreateAlignedStore(
+        lanes, lanes_at(builder.getInt64(lane_count + 1)), lane_align);
+    llvm::Value* near_index =
+        builder.CreateSub(builder.getInt64(lane_count + 1), lane_shift);
+    llvm::Value* near = load_at(near_index);
+    llvm::Value* far =
+        load_at(builder.CreateSub(near_index, builder.getInt64(1)));
+    result = builder.CreateOr(
+        builder.CreateShl(near, near_amount),
+        builder.CreateLShr(builder.CreateLShr(far, one), far_amount));
+  } else {
+    CHECK(op == Op::kShrl || op == Op::kShra);
+    // Buffer layout: [value lanes][lane_count + 1 fill lanes].
+    builder.CreateAlignedStore(lanes, lanes_at(builder.getInt64(0)),
+                               lane_align);
+    builder.CreateAlignedStore(fill, lanes_at(builder.getInt64(lane_count)),
+                               lane_align);
+    llvm::Value* near = load_at(lane_shift);
+    llvm::Value* far =
+        load_at(builder.CreateAdd(lane_shift, builder.getInt64(1)));
+    result = builder.CreateOr(
+        builder.CreateLShr(near, near_amount),
+        builder.CreateShl(builder.CreateShl(far, one), far_amount));
+  }
+  return FromLanes(result, type, builder);
+}
+
 // Emit an LLVM shift operation corresponding to the semantics of the given XLS
 // op.
 llvm::Value* EmitShiftOp(Node* shift, llvm::Value* lhs, llvm::Value* rhs,
                          llvm::IRBuilder<>* builder,
                          LlvmTypeConverter* type_converter) {
   Op op = shift->op();
+  if (UseWideLowering(lhs->getType())) {
+    llvm::Value* value =
+        op == Op::kShra
+            ? type_converter->AsSignedValue(lhs, shift->operand(0)->GetType(),
+                                            *builder)
+            : lhs;
+    return EmitWideShiftOp(op, value, rhs, *builder);
+  }
   // Shift operands are allowed to be different sizes in the [XLS] IR, so
   // we need to cast them to be the same size here (for LLVM).
   int common_width = std::max(lhs->getType()->getIntegerBitWidth(),
@@ -385,8 +628,91 @@ llvm::Value* EmitShiftOp(Node* shift, llvm::Value* lhs, llvm::Value* rhs,
              : builder->CreateTrunc(result, lhs->getType());
 }
 
+template <int64_t kFunctionOffset>
+llvm::Value* InvokeCallback(llvm::IRBuilder<>* builder, llvm::Type* return_type,
+                            llvm::Value* instance_ptr,
+                            absl::Span<llvm::Value* const> args);
+
+// Multiplications and divisions of integers wider than this are computed by
+// the runtime's kernels (see wide_arithmetic.h). LLVM expands them into
+// libcalls or very long inline sequences which are slower still.
+constexpr int64_t kWideArithmeticMaxInlineBits = 128;
+
+// Returns whether to compute an operation on integers of the given type with
+// the wide arithmetic kernels. `wide_arithmetic_context` is the instance
+// context to call the kernels through, or nullptr if they are not available
+// and LLVM must lower every operation itself.
+bool UseWideArithmetic(llvm::Type* type,
+                       llvm::Value* wide_arithmetic_context) {
+  return wide_arithmetic_context != nullptr &&
+         type->getIntegerBitWidth() > kWideArithmeticMaxInlineBits;
+}
+
+// Computes `lhs op rhs` on unsigned integers of the same type by calling the
+// wide arithmetic kernel of the runtime. The operands are passed through stack
+// buffers holding a whole number of 64-bit words.
+llvm::Value* EmitWideArithmetic(WideArithmeticOp op, llvm::Value* lhs,
+                                llvm::Value* rhs, llvm::Value* instance_context,
+                                llvm::IRBuilder<>* builder) {
+  llvm::Type* type = lhs->getType();
+  int64_t word_count =
+      CeilOfRatio(int64_t{type->getIntegerBitWidth()}, int64_t{64});
+  llvm::Type* words_type = builder->getIntNTy(word_count * 64);
+  auto to_words = [&](llvm::Value* value, const char* name) {
+    llvm::Value* buffer = builder->CreateAlloca(words_type, nullptr, name);
+    builder->CreateStore(builder->CreateZExt(value, words_type), buffer);
+    return buffer;
+  };
+  llvm::Value* lhs_buffer = to_words(lhs, "wide_lhs");
+  llvm::Value* rhs_buffer = to_words(rhs, "wide_rhs");
+  llvm::Value* result_buffer =
+      builder->CreateAlloca(words_type, nullptr, "wide_result");
+  InvokeCallback<InstanceContext::kWideArithmeticOffset>(
+      builder, builder->getVoidTy(), instance_context,
+      {builder->getInt64(static_cast<int64_t>(op)), result_buffer, lhs_buffer,
+       rhs_buffer, builder->getInt64(word_count)});
+  return builder->CreateTrunc(builder->CreateLoad(words_type, result_buffer),
+                              type);
+}
+
+// Emits the division (or remainder if `remainder` is true) of `num` by
+// `denom`. `denom` must be nonzero and a signed division must not overflow.
+// See UseWideArithmetic for `wide_arithmetic_context`.
+llvm::Value* EmitRawDivOrMod(llvm::Value* num, llvm::Value* denom,
+                             bool is_signed, bool remainder,
+                             llvm::Value* wide_arithmetic_context,
+                             llvm::IRBuilder<>* builder) {
+  if (!UseWideArithmetic(num->getType(), wide_arithmetic_context)) {
+    if (remainder) {
+      return is_signed ? builder->CreateSRem(num, denom)
+                       : builder->CreateURem(num, denom);
+    }
+    return is_signed ? builder->CreateSDiv(num, denom)
+                     : builder->CreateUDiv(num, denom);
+  }
+  WideArithmeticOp op =
+      remainder ? WideArithmeticOp::kMod : WideArithmeticOp::kDiv;
+  if (!is_signed) {
+    return EmitWideArithmetic(op, num, denom, wide_arithmetic_context, builder);
+  }
+  // The kernels are unsigned so divide the magnitudes. The quotient is
+  // negative if the signs of the operands differ and the remainder has the
+  // sign of the dividend.
+  llvm::Value* zero = llvm::ConstantInt::get(num->getType(), 0);
+  llvm::Value* num_is_neg = builder->CreateICmpSLT(num, zero);
+  llvm::Value* denom_is_neg = builder->CreateICmpSLT(denom, zero);
+  llvm::Value* result = EmitWideArithmetic(
+      op, builder->CreateSelect(num_is_neg, builder->CreateNeg(num), num),
+      builder->CreateSelect(denom_is_neg, builder->CreateNeg(denom), denom),
+      wide_arithmetic_context, builder);
+  llvm::Value* negate =
+      remainder ? num_is_neg : builder->CreateXor(num_is_neg, denom_is_neg);
+  return builder->CreateSelect(negate, builder->CreateNeg(result), result);
+}
+
 llvm::Value* EmitDiv(llvm::Value* num, llvm::Value* denom, int64_t bit_count,
                      bool is_signed, LlvmTypeConverter* type_converter,
+                     llvm::Value* wide_arithmetic_context,
                      llvm::IRBuilder<>* builder) {
   // XLS div semantics differ from LLVM's (and most software's) here: in XLS,
   // division by zero returns the greatest value of that type, so 255 for an
@@ -407,7 +733,8 @@ llvm::Value* EmitDiv(llvm::Value* num, llvm::Value* denom, int64_t bit_count,
         type_converter
             ->ToLlvmConstant(denom->getType(), Value(Bits::AllOnes(bit_count)))
             .value(),
-        builder->CreateUDiv(num, safe_denom));
+        EmitRawDivOrMod(num, safe_denom, /*is_signed=*/false,
+                        /*remainder=*/false, wide_arithmetic_context, builder));
   }
 
   // Division by 0 gives the value furthest from zero with matching sign.
@@ -437,7 +764,9 @@ llvm::Value* EmitDiv(llvm::Value* num, llvm::Value* denom, int64_t bit_count,
   safe_denom = builder->CreateSelect(
       denom_eq_neg_one, llvm::ConstantInt::get(denom->getType(), 1),
       safe_denom);
-  llvm::Value* normal_result = builder->CreateSDiv(num, safe_denom);
+  llvm::Value* normal_result =
+      EmitRawDivOrMod(num, safe_denom, /*is_signed=*/true,
+                      /*remainder=*/false, wide_arithmetic_context, builder);
 
   return builder->CreateSelect(
       denom_eq_zero, rhs_is_zero_result,
@@ -446,6 +775,7 @@ llvm::Value* EmitDiv(llvm::Value* num, llvm::Value* denom, int64_t bit_count,
 }
 
 llvm::Value* EmitMod(llvm::Value* lhs, llvm::Value* rhs, bool is_signed,
+                     llvm::Value* wide_arithmetic_context,
                      llvm::IRBuilder<>* builder) {
   // XLS mod semantics differ from LLVMs with regard to mod by zero. In XLS,
   // modulo by zero returns zero rather than undefined behavior.
@@ -455,9 +785,10 @@ llvm::Value* EmitMod(llvm::Value* lhs, llvm::Value* rhs, bool is_signed,
   // used.
   rhs = builder->CreateSelect(rhs_eq_zero,
                               llvm::ConstantInt::get(rhs->getType(), 1), rhs);
-  return builder->CreateSelect(rhs_eq_zero, zero,
-                               is_signed ? builder->CreateSRem(lhs, rhs)
-                                         : builder->CreateURem(lhs, rhs));
+  return builder->CreateSelect(
+      rhs_eq_zero, zero,
+      EmitRawDivOrMod(lhs, rhs, is_signed, /*remainder=*/true,
+                      wide_arithmetic_context, builder));
 }
 
 // Local struct to hold the individual elements of a (possibly) compound
@@ -640,12 +971,15 @@ absl::Status InvokeRecordTraceCallback(llvm::IRBuilder<>* builder,
   return absl::OkStatus();
 }
 
-// Build the LLVM IR to invoke the callback that creates a trace buffer.
+// Build the LLVM IR to invoke the callback that creates a trace buffer. The
+// buffer is null if traces of the given verbosity are not recorded.
 absl::StatusOr<llvm::Value*> InvokeCreateBufferCallback(
-    llvm::IRBuilder<>* builder, llvm::Value* instance_ctx) {
+    llvm::IRBuilder<>* builder, int64_t verbosity,
+    llvm::Value* interpreter_events_ptr, llvm::Value* instance_ctx) {
   llvm::Type* ptr_type = llvm::PointerType::get(builder->getContext(), 0);
   return InvokeCallback<InstanceContext::kCreateTraceBufferOffset>(
-      builder, ptr_type, instance_ctx, {});
+      builder, ptr_type, instance_ctx,
+      {builder->getInt64(verbosity), interpreter_events_ptr});
 }
 
 // Build the LLVM IR to invoke the callback that records assertions.
@@ -1253,14 +1587,11 @@ class IrBuilderVisitor : public DfsVisitorWithDefault {
       Node* node, std::function<llvm::Value*(absl::Span<llvm::Value* const>,
                                              llvm::IRBuilder<>&)>);
 
-  // HandleBinaryOp variant which converts the operands to result type prior to
-  // calling `build_result`.
-  absl::Status HandleBinaryOpWithOperandConversion(
-      Node* node,
-      std::function<llvm::Value*(llvm::Value*, llvm::Value*,
-                                 llvm::IRBuilder<>&)>
-          build_result,
-      bool is_signed);
+  // Shared implementations of the multiplication, division and modulus ops.
+  // Operations wider than LLVM handles well call the runtime's wide
+  // arithmetic kernels.
+  absl::Status HandleMul(ArithOp* mul, bool is_signed);
+  absl::Status HandleDivOrMod(BinOp* binop, bool is_signed, bool remainder);
 
   // Gets the built function representing the given XLS function.
   absl::StatusOr<llvm::Function*> GetFunction(Function* function) {
@@ -1275,6 +1606,14 @@ class IrBuilderVisitor : public DfsVisitorWithDefault {
   absl::StatusOr<NodeIrContext> NewInputNodeIrContext(
       Node* node, bool include_wrapper_args = false);
 
+  // Returns the instance context through which the code of the node calls the
+  // wide arithmetic kernels, or nullptr if it must not call them.
+  llvm::Value* WideArithmeticContext(NodeIrContext& node_context) {
+    return jit_context_.llvm_compiler().include_wide_arithmetic_calls()
+               ? node_context.GetInstanceContextArg()
+               : nullptr;
+  }
+
   // Finalizes the given NodeIrContext (adds a return statement with the given
   // result) and adds a call in the top-level LLVM function to the node
   // function.
@@ -1318,6 +1657,12 @@ class IrBuilderVisitor : public DfsVisitorWithDefault {
                            Send* send, llvm::Value* send_data_ptr,
                            llvm::Value* instance_context);
 
+  // Returns whether payloads of the given type are copied directly to and from
+  // the queue's storage using the slot-based queue API. In this case
+  // ReceiveFromQueue may add basic blocks and leaves `builder` positioned at
+  // the end of the last one.
+  bool UseInPlaceQueueAccess(Type* payload_type);
+
   int64_t output_arg_count_;
   const JitCompilationMetadata& metadata_;
   JitBuilderContext& jit_context_;
@@ -1487,6 +1832,9 @@ absl::Status IrBuilderVisitor::HandleOutputPort(OutputPort* write) {
 absl::Status IrBuilderVisitor::HandleAdd(BinOp* binop) {
   return HandleBinaryOp(
       binop, [](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
+        if (UseWideLowering(lhs->getType())) {
+          return EmitWideAddOrSub(lhs, rhs, /*subtract=*/false, b);
+        }
         return b.CreateAdd(lhs, rhs);
       });
 }
@@ -1610,15 +1958,24 @@ absl::Status IrBuilderVisitor::HandleTrace(Trace* trace_op) {
 
   skip_builder.CreateBr(after_block);
 
-  llvm::BasicBlock* print_block = llvm::BasicBlock::Create(
-      ctx(), absl::StrCat(trace_name, "_print"), node_context.llvm_function());
-  llvm::IRBuilder<> print_builder(print_block);
-
+  // Traces filtered out by verbosity get a null buffer and skip formatting.
+  llvm::BasicBlock* create_buffer_block = llvm::BasicBlock::Create(
+      ctx(), absl::StrCat(trace_name, "_create_buffer"),
+      node_context.llvm_function());
+  llvm::IRBuilder<> create_buffer_builder(create_buffer_block);
   XLS_ASSIGN_OR_RETURN(
       llvm::Value * buffer_ptr,
-      InvokeCreateBufferCallback(&print_builder,
+      InvokeCreateBufferCallback(&create_buffer_builder,
+                                 trace_op->verbosity(), events_ptr,
                                  node_context.GetInstanceContextArg()));
 
+  llvm::BasicBlock* print_block = llvm::BasicBlock::Create(
+      ctx(), absl::StrCat(trace_name, "_print"), node_context.llvm_function());
+  llvm::IRBuilder<> print_builder(print_block);
+  create_buffer_builder.CreateCondBr(
+      create_buffer_builder.CreateIsNotNull(buffer_ptr), print_block,
+      skip_block);
+
   // Operands are: (tok, pred, ..data_operands..)
   XLS_RET_CHECK_EQ(trace_op->operand(0)->GetType(),
                    trace_op->package()->GetTokenType());
@@ -1652,7 +2009,7 @@ absl::Status IrBuilderVisitor::HandleTrace(Trace* trace_op) {
 
   print_builder.CreateBr(after_block);
 
-  b.CreateCondBr(condition, print_block, skip_block);
+  b.CreateCondBr(condition, create_buffer_block, skip_block);
 
   auto after_builder = std::make_unique<llvm::IRBuilder<>>(after_block);
   llvm::Value* token = type_converter()->GetToken();
@@ -1859,10 +2216,24 @@ absl::Status IrBuilderVisitor::HandleBitSlice(BitSlice* bit_slice) {
       llvm::Constant * start,
       type_converter()->ToLlvmConstant(value->getType(), shift_amount));
 
+  llvm::Type* result_type =
+      type_converter()->ConvertToLlvmType(bit_slice->GetType());
+  if (UseWideLowering(value->getType())) {
+    // Only compute the lanes which make up the result.
+    int64_t result_bit_count = result_type->getIntegerBitWidth();
+    int64_t lane_count = CeilOfRatio(result_bit_count, kWideLaneBits);
+    llvm::Value* lanes =
+        ShiftLanesByConstant(ToLanes(value, b), bit_slice->start(),
+                             /*left=*/false, lane_count, b);
+    llvm::Value* result =
+        b.CreateBitCast(lanes, b.getIntNTy(lane_count * kWideLaneBits));
+    return FinalizeNodeIrContextWithValue(std::move(node_context),
+                                          b.CreateTrunc(result, result_type));
+  }
+
   // Then shift and "mask" (by casting) the input value.
   llvm::Value* shifted_value = b.CreateLShr(value, start);
-  llvm::Value* truncated_value = b.CreateTrunc(
-      shifted_value, type_converter()->ConvertToLlvmType(bit_slice->GetType()));
+  llvm::Value* truncated_value = b.CreateTrunc(shifted_value, result_type);
 
   return FinalizeNodeIrContextWithValue(std::move(node_context),
                                         truncated_value);
@@ -1989,6 +2360,10 @@ absl::Status IrBuilderVisitor::HandleConcat(Concat* concat) {
   llvm::Type* dest_type =
       type_converter()->ConvertToLlvmType(concat->GetType());
   llvm::Value* base = llvm::ConstantInt::get(dest_type, 0);
+  // Wide results are accumulated as lanes (see UseWideLowering).
+  const bool wide = UseWideLowering(dest_type);
+  llvm::Value* lanes =
+      wide ? llvm::Constant::getNullValue(WideLaneType(dest_type)) : nullptr;
 
   int current_shift = concat->BitCountOrDie();
   for (int64_t i = 0; i < concat->operand_count(); ++i) {
@@ -2002,12 +2377,23 @@ absl::Status IrBuilderVisitor::HandleConcat(Concat* concat) {
       continue;
     }
     operand = b.CreateZExt(operand, dest_type);
-    llvm::Value* shifted_operand =
-        b.CreateShl(operand, current_shift - operand_width);
-    base = b.CreateOr(base, shifted_operand);
+    if (wide) {
+      lanes = b.CreateOr(
+          lanes, ShiftLanesByConstant(
+                     ToLanes(operand, b), current_shift - operand_width,
+                     /*left=*/true, WideLaneType(dest_type)->getNumElements(),
+                     b));
+    } else {
+      llvm::Value* shifted_operand =
+          b.CreateShl(operand, current_shift - operand_width);
+      base = b.CreateOr(base, shifted_operand);
+    }
 
     current_shift -= operand_width;
   }
+  if (wide) {
+    base = FromLanes(lanes, dest_type, b);
+  }
 
   return FinalizeNodeIrContextWithValue(std::move(node_context), base);
 }
@@ -2449,21 +2835,11 @@ absl::Status IrBuilderVisitor::HandleMap(Map* map) {
 }
 
 absl::Status IrBuilderVisitor::HandleSMul(ArithOp* mul) {
-  return HandleBinaryOpWithOperandConversion(
-      mul,
-      [](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
-        return b.CreateMul(lhs, rhs);
-      },
-      /*is_signed=*/true);
+  return HandleMul(mul, /*is_signed=*/true);
 }
 
 absl::Status IrBuilderVisitor::HandleUMul(ArithOp* mul) {
-  return HandleBinaryOpWithOperandConversion(
-      mul,
-      [](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
-        return b.CreateMul(lhs, rhs);
-      },
-      /*is_signed=*/false);
+  return HandleMul(mul, /*is_signed=*/false);
 }
 
 namespace {
@@ -2472,6 +2848,7 @@ absl::StatusOr<llvm::Value*> HandleMulp(PartialProductOp* mul,
                                         NodeIrContext* node_context,
                                         LlvmTypeConverter* type_converter,
                                         llvm::LLVMContext& ctx,
+                                        llvm::Value* wide_arithmetic_context,
                                         bool is_signed) {
   llvm::IRBuilder<>& b = node_context->entry_builder();
 
@@ -2503,12 +2880,13 @@ absl::StatusOr<llvm::Value*> HandleMulp(PartialProductOp* mul,
                                         /*shift_size=*/3))));
   // The outer int cast is unconditionally unsigned because smulp (like umulp)
   // returns a tuple of unsigned ints.
+  lhs = b.CreateIntCast(lhs, llvm_result_element_type, /*isSigned=*/is_signed);
+  rhs = b.CreateIntCast(rhs, llvm_result_element_type, /*isSigned=*/is_signed);
   llvm::Value* product =
-      b.CreateIntCast(b.CreateMul(b.CreateIntCast(lhs, llvm_result_element_type,
-                                                  /*isSigned=*/is_signed),
-                                  b.CreateIntCast(rhs, llvm_result_element_type,
-                                                  /*isSigned=*/is_signed)),
-                      llvm_result_element_type, /*isSigned=*/false);
+      UseWideArithmetic(llvm_result_element_type, wide_arithmetic_context)
+          ? EmitWideArithmetic(WideArithmeticOp::kMul, lhs, rhs,
+                               wide_arithmetic_context, &b)
+          : b.CreateMul(lhs, rhs);
   llvm::Value* product_minus_offset = b.CreateSub(product, offset);
 
   llvm::Value* output_buffer = node_context->GetOutputPtr(0);
@@ -2534,6 +2912,7 @@ absl::Status IrBuilderVisitor::HandleSMulp(PartialProductOp* mul) {
 
   XLS_ASSIGN_OR_RETURN(llvm::Value * output_buffer,
                        HandleMulp(mul, &node_context, type_converter(), ctx(),
+                                  WideArithmeticContext(node_context),
                                   /*is_signed=*/true));
   return FinalizeNodeIrContextWithPointerToValue(std::move(node_context),
                                                  output_buffer);
@@ -2545,6 +2924,7 @@ absl::Status IrBuilderVisitor::HandleUMulp(PartialProductOp* mul) {
       NewNodeIrContext(mul, NumberedStrings("operand", mul->operand_count())));
   XLS_ASSIGN_OR_RETURN(llvm::Value * output_buffer,
                        HandleMulp(mul, &node_context, type_converter(), ctx(),
+                                  WideArithmeticContext(node_context),
                                   /*is_signed=*/false));
   return FinalizeNodeIrContextWithPointerToValue(std::move(node_context),
                                                  output_buffer);
@@ -2553,55 +2933,35 @@ absl::Status IrBuilderVisitor::HandleUMulp(PartialProductOp* mul) {
 absl::Status IrBuilderVisitor::HandleNaryAnd(NaryOp* and_op) {
   return HandleNaryOp(and_op, [](absl::Span<llvm::Value* const> operands,
                                  llvm::IRBuilder<>& b) {
-    llvm::Value* result = operands.front();
-    for (int i = 1; i < operands.size(); ++i) {
-      result = b.CreateAnd(result, operands[i]);
-    }
-    return result;
+    return EmitNaryBitwiseOp(llvm::Instruction::And, operands, b);
   });
 }
 
 absl::Status IrBuilderVisitor::HandleNaryNand(NaryOp* nand_op) {
   return HandleNaryOp(nand_op, [](absl::Span<llvm::Value* const> operands,
                                   llvm::IRBuilder<>& b) {
-    llvm::Value* result = operands.front();
-    for (int i = 1; i < operands.size(); ++i) {
-      result = b.CreateAnd(result, operands[i]);
-    }
-    return b.CreateNot(result);
+    return EmitNot(EmitNaryBitwiseOp(llvm::Instruction::And, operands, b), b);
   });
 }
 
 absl::Status IrBuilderVisitor::HandleNaryNor(NaryOp* nor_op) {
   return HandleNaryOp(nor_op, [](absl::Span<llvm::Value* const> operands,
                                  llvm::IRBuilder<>& b) {
-    llvm::Value* result = operands.front();
-    for (int i = 1; i < operands.size(); ++i) {
-      result = b.CreateOr(result, operands[i]);
-    }
-    return b.CreateNot(result);
+    return EmitNot(EmitNaryBitwiseOp(llvm::Instruction::Or, operands, b), b);
   });
 }
 
 absl::Status IrBuilderVisitor::HandleNaryOr(NaryOp* or_op) {
   return HandleNaryOp(
       or_op, [](absl::Span<llvm::Value* const> operands, llvm::IRBuilder<>& b) {
-        llvm::Value* result = operands.front();
-        for (int i = 1; i < operands.size(); ++i) {
-          result = b.CreateOr(result, operands[i]);
-        }
-        return result;
+        return EmitNaryBitwiseOp(llvm::Instruction::Or, operands, b);
       });
 }
 
 absl::Status IrBuilderVisitor::HandleNaryXor(NaryOp* xor_op) {
   return HandleNaryOp(xor_op, [](absl::Span<llvm::Value* const> operands,
                                  llvm::IRBuilder<>& b) {
-    llvm::Value* result = operands.front();
-    for (int i = 1; i < operands.size(); ++i) {
-      result = b.CreateXor(result, operands[i]);
-    }
-    return result;
+    return EmitNaryBitwiseOp(llvm::Instruction::Xor, operands, b);
   });
 }
 
@@ -2679,7 +3039,7 @@ absl::Status IrBuilderVisitor::HandleNext(Next* next) {
 
 absl::Status IrBuilderVisitor::HandleNot(UnOp* not_op) {
   return HandleUnaryOp(not_op, [](llvm::Value* operand, llvm::IRBuilder<>& b) {
-    return b.CreateNot(operand);
+    return EmitNot(operand, b);
   });
 }
 
@@ -2915,22 +3275,11 @@ absl::Status IrBuilderVisitor::HandleReverse(UnOp* reverse) {
 }
 
 absl::Status IrBuilderVisitor::HandleSDiv(BinOp* binop) {
-  return HandleBinaryOp(
-      binop,
-      [&](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
-        return EmitDiv(lhs, rhs, binop->BitCountOrDie(), /*is_signed=*/true,
-                       type_converter(), &b);
-      },
-      /*is_signed=*/true);
+  return HandleDivOrMod(binop, /*is_signed=*/true, /*remainder=*/false);
 }
 
 absl::Status IrBuilderVisitor::HandleSMod(BinOp* binop) {
-  return HandleBinaryOp(
-      binop,
-      [&](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
-        return EmitMod(lhs, rhs, /*is_signed=*/true, &b);
-      },
-      /*is_signed=*/true);
+  return HandleDivOrMod(binop, /*is_signed=*/true, /*remainder=*/true);
 }
 
 absl::Status IrBuilderVisitor::HandleSel(Select* sel) {
@@ -3048,6 +3397,9 @@ absl::Status IrBuilderVisitor::HandleStateRead(StateRead* state_read) {
 absl::Status IrBuilderVisitor::HandleSub(BinOp* binop) {
   return HandleBinaryOp(
       binop, [](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
+        if (UseWideLowering(lhs->getType())) {
+          return EmitWideAddOrSub(lhs, rhs, /*subtract=*/true, b);
+        }
         return b.CreateSub(lhs, rhs);
       });
 }
@@ -3094,18 +3446,11 @@ absl::Status IrBuilderVisitor::HandleTupleIndex(TupleIndex* index) {
 }
 
 absl::Status IrBuilderVisitor::HandleUDiv(BinOp* binop) {
-  return HandleBinaryOp(
-      binop, [&](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
-        return EmitDiv(lhs, rhs, binop->BitCountOrDie(), /*is_signed=*/false,
-                       type_converter(), &b);
-      });
+  return HandleDivOrMod(binop, /*is_signed=*/false, /*remainder=*/false);
 }
 
 absl::Status IrBuilderVisitor::HandleUMod(BinOp* binop) {
-  return HandleBinaryOp(
-      binop, [&](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
-        return EmitMod(lhs, rhs, /*is_signed=*/false, &b);
-      });
+  return HandleDivOrMod(binop, /*is_signed=*/false, /*remainder=*/true);
 }
 
 absl::Status IrBuilderVisitor::HandleUGe(CompareOp* ge) {
@@ -3210,24 +3555,45 @@ absl::Status IrBuilderVisitor::HandleNaryOp(
       build_result(args, node_context.entry_builder()));
 }
 
-absl::Status IrBuilderVisitor::HandleBinaryOpWithOperandConversion(
-    Node* node,
-    std::function<llvm::Value*(llvm::Value*, llvm::Value*, llvm::IRBuilder<>&)>
-        build_result,
-    bool is_signed) {
-  XLS_RET_CHECK_EQ(node->operand_count(), 2);
-  llvm::Type* result_type =
-      type_converter()->ConvertToLlvmType(node->GetType());
-  return HandleBinaryOp(
-      node, [&](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
-        llvm::Value* converted_lhs =
-            MaybeAsSigned(lhs, node->operand(0)->GetType(), b, is_signed);
-        llvm::Value* converted_rhs =
-            MaybeAsSigned(rhs, node->operand(1)->GetType(), b, is_signed);
-        return build_result(
-            b.CreateIntCast(converted_lhs, result_type, is_signed),
-            b.CreateIntCast(converted_rhs, result_type, is_signed), b);
-      });
+absl::Status IrBuilderVisitor::HandleMul(ArithOp* mul, bool is_signed) {
+  XLS_ASSIGN_OR_RETURN(NodeIrContext node_context,
+                       NewNodeIrContext(mul, {"lhs", "rhs"}));
+  llvm::IRBuilder<>& b = node_context.entry_builder();
+  llvm::Type* result_type = type_converter()->ConvertToLlvmType(mul->GetType());
+  llvm::Value* lhs = b.CreateIntCast(
+      MaybeAsSigned(node_context.LoadOperand(0), mul->operand(0)->GetType(), b,
+                    is_signed),
+      result_type, is_signed);
+  llvm::Value* rhs = b.CreateIntCast(
+      MaybeAsSigned(node_context.LoadOperand(1), mul->operand(1)->GetType(), b,
+                    is_signed),
+      result_type, is_signed);
+  llvm::Value* wide_arithmetic_context = WideArithmeticContext(node_context);
+  llvm::Value* product =
+      UseWideArithmetic(result_type, wide_arithmetic_context)
+          ? EmitWideArithmetic(WideArithmeticOp::kMul, lhs, rhs,
+                               wide_arithmetic_context, &b)
+          : b.CreateMul(lhs, rhs);
+  return FinalizeNodeIrContextWithValue(std::move(node_context), product);
+}
+
+absl::Status IrBuilderVisitor::HandleDivOrMod(BinOp* binop, bool is_signed,
+                                              bool remainder) {
+  XLS_ASSIGN_OR_RETURN(NodeIrContext node_context,
+                       NewNodeIrContext(binop, {"lhs", "rhs"}));
+  llvm::IRBuilder<>& b = node_context.entry_builder();
+  llvm::Value* lhs =
+      MaybeAsSigned(node_context.LoadOperand(0), binop->operand(0)->GetType(),
+                    b, is_signed);
+  llvm::Value* rhs =
+      MaybeAsSigned(node_context.LoadOperand(1), binop->operand(1)->GetType(),
+                    b, is_signed);
+  llvm::Value* wide_arithmetic_context = WideArithmeticContext(node_context);
+  llvm::Value* result =
+      remainder ? EmitMod(lhs, rhs, is_signed, wide_arithmetic_context, &b)
+                : EmitDiv(lhs, rhs, binop->BitCountOrDie(), is_signed,
+                          type_converter(), wide_arithmetic_context, &b);
+  return FinalizeNodeIrContextWithValue(std::move(node_context), result);
 }
 
 absl::StatusOr<NodeIrContext> IrBuilderVisitor::NewNodeIrContext(
@@ -3311,16 +3677,56 @@ absl::StatusOr<llvm::Value*> IrBuilderVisitor::CallFunction(
   return builder.CreateCall(f, args);
 }
 
+bool IrBuilderVisitor::UseInPlaceQueueAccess(Type* payload_type) {
+  return type_converter()->GetTypeByteSize(payload_type) >=
+         kInPlaceQueueAccessMinBytes;
+}
+
 absl::StatusOr<llvm::Value*> IrBuilderVisitor::ReceiveFromQueue(
     llvm::IRBuilder<>* builder, int64_t queue_index, Receive* receive,
     llvm::Value* output_ptr, llvm::Value* instance_context) {
-  // llvm::Type* i64_type = llvm::Type::getInt64Ty(ctx());
   llvm::Type* bool_type = llvm::Type::getInt1Ty(ctx());
-  // Call the wrapper to JitChannelQueue::Recv.
   llvm::Value* queue_index_value =
       llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx()), queue_index);
-  return InvokeCallback<InstanceContext::kQueueReceiveWrapperOffset>(
-      builder, bool_type, instance_context, {queue_index_value, output_ptr});
+  if (!UseInPlaceQueueAccess(receive->GetPayloadType())) {
+    // Call the wrapper to JitChannelQueue::ReadRaw.
+    return InvokeCallback<InstanceContext::kQueueReceiveWrapperOffset>(
+        builder, bool_type, instance_context, {queue_index_value, output_ptr});
+  }
+
+  // Copy the payload straight out of the oldest slot in the queue then
+  // release it. If the queue is empty the output is zero.
+  llvm::Value* slot = InvokeCallback<InstanceContext::kQueuePeekReadSlotOffset>(
+      builder, llvm::PointerType::get(ctx(), 0), instance_context,
+      {queue_index_value});
+  llvm::Value* receive_fired = builder->CreateIsNotNull(slot);
+  llvm::Function* function = builder->GetInsertBlock()->getParent();
+  llvm::BasicBlock* done_block = llvm::BasicBlock::Create(
+      ctx(), absl::StrCat(receive->GetName(), "_received"), function);
+  llvm::BasicBlock* copy_block = llvm::BasicBlock::Create(
+      ctx(), absl::StrCat(receive->GetName(), "_copy"), function, done_block);
+  llvm::BasicBlock* empty_block = llvm::BasicBlock::Create(
+      ctx(), absl::StrCat(receive->GetName(), "_empty"), function, done_block);
+  builder->CreateCondBr(receive_fired, copy_block, empty_block);
+
+  llvm::IRBuilder<> copy_builder(copy_block);
+  LlvmMemcpy(output_ptr, slot,
+             type_converter()->GetTypeByteSize(receive->GetPayloadType()),
+             copy_builder);
+  InvokeCallback<InstanceContext::kQueueReleaseReadSlotOffset>(
+      &copy_builder, llvm::Type::getVoidTy(ctx()), instance_context,
+      {queue_index_value});
+  copy_builder.CreateBr(done_block);
+
+  llvm::IRBuilder<> empty_builder(empty_block);
+  empty_builder.CreateStore(
+      LlvmTypeConverter::ZeroOfType(
+          type_converter()->ConvertToLlvmType(receive->GetPayloadType())),
+      output_ptr);
+  empty_builder.CreateBr(done_block);
+
+  builder->SetInsertPoint(done_block);
+  return receive_fired;
 }
 
 absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
@@ -3346,11 +3752,16 @@ absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
        llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx()), 1)});
   data_buffer->setName("data_buffer");
 
-  // Always initialize the data buffer to zero.
+  // Always initialize the data buffer to zero. When the payload is received in
+  // place the buffer is only zeroed on the paths where nothing is received to
+  // avoid writing wide payloads twice.
   llvm::Type* data_type =
       type_converter()->ConvertToLlvmType(recv->GetPayloadType());
-  node_context.entry_builder().CreateStore(
-      LlvmTypeConverter::ZeroOfType(data_type), data_buffer);
+  bool in_place = UseInPlaceQueueAccess(recv->GetPayloadType());
+  if (!in_place) {
+    node_context.entry_builder().CreateStore(
+        LlvmTypeConverter::ZeroOfType(data_type), data_buffer);
+  }
 
   if (recv->predicate().has_value()) {
     llvm::Value* predicate = node_context.LoadOperand(1);
@@ -3376,6 +3787,10 @@ absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
         llvm::BasicBlock::Create(ctx(), absl::StrCat(recv->GetName(), "_false"),
                                  node_context.llvm_function(), join_block);
     llvm::IRBuilder<> false_builder(false_block);
+    if (in_place) {
+      false_builder.CreateStore(LlvmTypeConverter::ZeroOfType(data_type),
+                                data_buffer);
+    }
     false_builder.CreateBr(join_block);
 
     // Next, create a branch op w/the original builder,
@@ -3387,7 +3802,10 @@ absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
 
     llvm::PHINode* receive_fired = join_builder.CreatePHI(
         llvm::Type::getInt1Ty(ctx()), /*NumReservedValues=*/2);
-    receive_fired->addIncoming(true_receive_fired, true_block);
+    // The receive may have added blocks so the incoming edge is from wherever
+    // `true_builder` ended up.
+    receive_fired->addIncoming(true_receive_fired,
+                               true_builder.GetInsertBlock());
     receive_fired->addIncoming(llvm::ConstantInt::getFalse(ctx()), false_block);
     receive_fired->setName("receive_fired");
     if (!recv->is_blocking()) {
@@ -3438,8 +3856,23 @@ absl::Status IrBuilderVisitor::SendToQueue(llvm::IRBuilder<>* builder,
   llvm::Type* void_type = llvm::Type::getVoidTy(ctx());
   llvm::Value* queue_index_value =
       llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx()), queue_index);
-  InvokeCallback<InstanceContext::kQueueSendWrapperOffset>(
-      builder, void_type, instance_context, {queue_index_value, send_data_ptr});
+  if (!UseInPlaceQueueAccess(send->data()->GetType())) {
+    InvokeCallback<InstanceContext::kQueueSendWrapperOffset>(
+        builder, void_type, instance_context,
+        {queue_index_value, send_data_ptr});
+    return absl::OkStatus();
+  }
+
+  // Copy the payload straight into the queue's next slot then commit it.
+  llvm::Value* slot =
+      InvokeCallback<InstanceContext::kQueueAcquireWriteSlotOffset>(
+          builder, llvm::PointerType::get(ctx(), 0), instance_context,
+          {queue_index_value});
+  LlvmMemcpy(slot, send_data_ptr,
+             type_converter()->GetTypeByteSize(send->data()->GetType()),
+             *builder);
+  InvokeCallback<InstanceContext::kQueueCommitWriteSlotOffset>(
+      builder, void_type, instance_context, {queue_index_value});
   return absl::OkStatus();
 }
 
@@ -3513,6 +3946,20 @@ llvm::Value* LlvmMemcpy(llvm::Value* tgt, llvm::Value* src, int64_t size,
                               llvm::MaybeAlign(1), size);
 }
 
+llvm::Value* LlvmGetNodeProfileCounters(llvm::Value* instance_context,
+                                        llvm::IRBuilder<>& builder) {
+  return InvokeCallback<InstanceContext::kGetNodeProfileCountersOffset>(
+      &builder, llvm::PointerType::get(builder.getContext(), 0),
+      instance_context, {});
+}
+
+llvm::Value* LlvmGetNodeCoverageBits(llvm::Value* instance_context,
+                                     llvm::IRBuilder<>& builder) {
+  return InvokeCallback<InstanceContext::kGetNodeCoverageBitsOffset>(
+      &builder, llvm::PointerType::get(builder.getContext(), 0),
+      instance_context, {});
+}
+
 absl::StatusOr<NodeFunction> CreateNodeFunction(
     Node* node, int64_t output_arg_count,
     const JitCompilationMetadata& metadata, JitBuilderContext& jit_context) {
@@ -34,6 +34,8 @@
 #include "xls/ir/node.h"
 #include "xls/jit/llvm_compiler.h"
 #include "xls/jit/llvm_type_converter.h"
+#include "xls/jit/node_coverage.h"
+#include "xls/jit/node_profile.h"
 
 namespace xls {
 
@@ -94,6 +96,41 @@ class JitBuilderContext {
     return queue_indices_;
   }
 
+  // Records that the evaluation of `node` is timed by node profiling code and
+  // returns the index of its counters in the profile counter buffer.
+  int64_t AddNodeProfileSite(Node* node) {
+    int64_t index = profile_sites_.size();
+    profile_sites_.push_back(NodeProfileSite{
+        .function_name = node->function_base()->name(),
+        .node_id = node->id(),
+        .node_name = node->GetName(),
+        .op = node->op()});
+    return index;
+  }
+
+  // Returns the nodes timed by node profiling code in order of counter index.
+  const std::vector<NodeProfileSite>& profile_sites() const {
+    return profile_sites_;
+  }
+
+  // Records that the values of `node` are accumulated by node coverage code
+  // and returns the offset of its `size` bytes in the coverage buffer.
+  int64_t AddNodeCoverageSite(Node* node, int64_t size) {
+    int64_t offset = node_coverage_size_;
+    coverage_sites_.push_back(
+        NodeCoverageSite{.node = node, .offset = offset, .size = size});
+    node_coverage_size_ += size;
+    return offset;
+  }
+
+  // Returns the nodes whose values are accumulated by node coverage code in
+  // order of offset.
+  const std::vector<NodeCoverageSite>& coverage_sites() const {
+    return coverage_sites_;
+  }
+  // Returns the size in bytes of the coverage buffer.
+  int64_t node_coverage_size() const { return node_coverage_size_; }
+
   std::string MangleFunctionName(FunctionBase* f) {
     if (f == top() || !llvm_compiler().IsSharedCompilation()) {
       return f->name();
@@ -112,6 +149,13 @@ class JitBuilderContext {
 
   // A map from channel name to queue index.
   absl::btree_map<std::string, int64_t> queue_indices_;
+
+  // The nodes with node profiling counters.
+  std::vector<NodeProfileSite> profile_sites_;
+
+  // The nodes with node coverage bits and the total size of their bits.
+  std::vector<NodeCoverageSite> coverage_sites_;
+  int64_t node_coverage_size_ = 0;
 };
 
 // Abstraction representing an llvm::Function implementing an xls::Node. The
@@ -177,6 +221,16 @@ absl::StatusOr<NodeFunction> CreateNodeFunction(
 llvm::Value* LlvmMemcpy(llvm::Value* tgt, llvm::Value* src, int64_t size,
                         llvm::IRBuilder<>& builder);
 
+// Constructs a call to the GetNodeProfileCounters callback returning the
+// (possibly null) node profile counter buffer of `instance_context`.
+llvm::Value* LlvmGetNodeProfileCounters(llvm::Value* instance_context,
+                                        llvm::IRBuilder<>& builder);
+
+// Constructs a call to the GetNodeCoverageBits callback returning the
+// (possibly null) node coverage buffer of `instance_context`.
+llvm::Value* LlvmGetNodeCoverageBits(llvm::Value* instance_context,
+                                     llvm::IRBuilder<>& builder);
+
 }  // namespace xls
 
 #endif  // XLS_JIT_IR_BUILDER_VISITOR_H_
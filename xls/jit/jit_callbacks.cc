@@ -16,9 +16,10 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
-#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "xls/ir/events.h"
 #include "xls/ir/format_preference.h"
@@ -26,37 +27,43 @@
 #include "xls/ir/value.h"
 #include "xls/ir/xls_type.pb.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/jit/wide_arithmetic.h"
 
 namespace xls {
 
 namespace {
 void PerformStringStep(InstanceContext* thiz, char* step_string,
-                       std::string* buffer) {
-  buffer->append(step_string);
+                       UnformattedTraceMessage* buffer) {
+  buffer->pieces.push_back(std::string(step_string));
 }
 
 void PerformFormatStep(InstanceContext* thiz, JitRuntime* runtime,
                        const uint8_t* proto_data, int64_t proto_data_size,
                        const uint8_t* value, uint64_t format_u64,
-                       std::string* buffer) {
+                       UnformattedTraceMessage* buffer) {
   Type* type = thiz->ParseTypeFromProto(
       absl::Span<uint8_t const>(proto_data, proto_data_size));
 #ifdef ABSL_HAVE_MEMORY_SANITIZER
   __msan_unpoison(value, runtime->GetTypeByteSize(type));
 #endif
-  FormatPreference format = static_cast<FormatPreference>(format_u64);
-  Value ir_value = runtime->UnpackBuffer(value, type);
-  absl::StrAppend(buffer, ir_value.ToHumanString(format));
+  buffer->pieces.push_back(UnformattedTraceMessage::Operand{
+      .value = runtime->UnpackBuffer(value, type),
+      .format = static_cast<FormatPreference>(format_u64)});
 }
 
-void RecordTrace(InstanceContext* thiz, std::string* buffer, int64_t verbosity,
-                 InterpreterEvents* events) {
-  events->trace_msgs.push_back(
-      TraceMessage{.message = *buffer, .verbosity = verbosity});
+void RecordTrace(InstanceContext* thiz, UnformattedTraceMessage* buffer,
+                 int64_t verbosity, InterpreterEvents* events) {
+  buffer->verbosity = verbosity;
+  events->trace_msgs.AddUnformatted(std::move(*buffer));
   delete buffer;
 }
-std::string* CreateTraceBuffer(InstanceContext* thiz) {
-  return new std::string();
+UnformattedTraceMessage* CreateTraceBuffer(InstanceContext* thiz,
+                                           int64_t verbosity,
+                                           InterpreterEvents* events) {
+  if (!events->ShouldRecordTrace(verbosity)) {
+    return nullptr;
+  }
+  return new UnformattedTraceMessage();
 }
 void RecordAssertion(InstanceContext* thiz, const char* msg,
                      InterpreterEvents* events) {
@@ -73,6 +80,22 @@ void QueueSendWrapper(InstanceContext* thiz, int64_t queue_index,
   thiz->channel_queues[queue_index]->WriteRaw(data);
 }
 
+uint8_t* QueueAcquireWriteSlot(InstanceContext* thiz, int64_t queue_index) {
+  return thiz->channel_queues[queue_index]->AcquireWriteSlot();
+}
+
+void QueueCommitWriteSlot(InstanceContext* thiz, int64_t queue_index) {
+  thiz->channel_queues[queue_index]->CommitWriteSlot();
+}
+
+const uint8_t* QueuePeekReadSlot(InstanceContext* thiz, int64_t queue_index) {
+  return thiz->channel_queues[queue_index]->PeekReadSlot();
+}
+
+void QueueReleaseReadSlot(InstanceContext* thiz, int64_t queue_index) {
+  thiz->channel_queues[queue_index]->ReleaseReadSlot();
+}
+
 void RecordActiveNextValue(InstanceContext* thiz, int64_t state_element_idx,
                            int64_t next_id) {
   thiz->active_next_values[state_element_idx].insert(next_id);
@@ -84,6 +107,32 @@ void RecordNodeResult(InstanceContext* thiz, int64_t node_ptr,
     thiz->observer->RecordNodeValue(node_ptr, data);
   }
 }
+
+uint64_t* GetNodeProfileCounters(InstanceContext* thiz) {
+  return thiz->node_profile_counters;
+}
+
+uint8_t* GetNodeCoverageBits(InstanceContext* thiz) {
+  return thiz->node_coverage_bits;
+}
+
+void WideArithmetic(InstanceContext* thiz, int64_t op, uint64_t* result,
+                    const uint64_t* lhs, const uint64_t* rhs,
+                    int64_t word_count) {
+  absl::Span<const uint64_t> lhs_words(lhs, word_count);
+  absl::Span<const uint64_t> rhs_words(rhs, word_count);
+  absl::Span<uint64_t> result_words(result, word_count);
+  if (static_cast<WideArithmeticOp>(op) == WideArithmeticOp::kMul) {
+    WideMultiply(lhs_words, rhs_words, result_words);
+    return;
+  }
+  absl::InlinedVector<uint64_t, 16> other(word_count);
+  if (static_cast<WideArithmeticOp>(op) == WideArithmeticOp::kDiv) {
+    WideDivide(lhs_words, rhs_words, result_words, absl::MakeSpan(other));
+  } else {
+    WideDivide(lhs_words, rhs_words, absl::MakeSpan(other), result_words);
+  }
+}
 }  // namespace
 
 InstanceContextVTable::InstanceContextVTable()
@@ -94,14 +143,25 @@ InstanceContextVTable::InstanceContextVTable()
       record_assertion(&RecordAssertion),
       queue_receive_wrapper(&QueueReceiveWrapper),
       queue_send_wrapper(&QueueSendWrapper),
+      queue_acquire_write_slot(&QueueAcquireWriteSlot),
+      queue_commit_write_slot(&QueueCommitWriteSlot),
+      queue_peek_read_slot(&QueuePeekReadSlot),
+      queue_release_read_slot(&QueueReleaseReadSlot),
       record_active_next_value(&RecordActiveNextValue),
-      record_node_result(&RecordNodeResult) {}
+      record_node_result(&RecordNodeResult),
+      get_node_profile_counters(&GetNodeProfileCounters),
+      get_node_coverage_bits(&GetNodeCoverageBits),
+      wide_arithmetic(&WideArithmetic) {}
 
 Type* InstanceContext::ParseTypeFromProto(absl::Span<uint8_t const> data) {
-  TypeProto proto;
-  CHECK(proto.ParseFromArray(data.data(), data.size()));
-  auto type_or = type_manager->GetTypeFromProto(proto);
-  CHECK_OK(type_or);
-  return *type_or;
+  auto [it, inserted] = parsed_types.try_emplace(data.data(), nullptr);
+  if (inserted) {
+    TypeProto proto;
+    CHECK(proto.ParseFromArray(data.data(), data.size()));
+    auto type_or = type_manager->GetTypeFromProto(proto);
+    CHECK_OK(type_or);
+    it->second = *type_or;
+  }
+  return it->second;
 }
 }  // namespace xls
@@ -37,6 +37,14 @@
 namespace xls {
 
 struct InstanceContext;
+
+// Operations performed by InstanceContextVTable::wide_arithmetic.
+enum class WideArithmeticOp : int64_t {
+  kMul = 0,
+  kDiv = 1,
+  kMod = 2,
+};
+
 // Manual vtable of an InstanceContext. Called directly from LLVM jit code.
 //
 // TODO(allight): Instead of using this Vtable passed as an argument we could
@@ -49,25 +57,32 @@ struct InstanceContextVTable {
   explicit InstanceContextVTable();
 
   using PerformStringStepFn = void (*)(InstanceContext* thiz, char* step_string,
-                                       std::string* buffer);
+                                       UnformattedTraceMessage* buffer);
   // This is a shim to let JIT code add a new trace fragment to an existing
   // trace buffer.
   const PerformStringStepFn perform_string_step;
-  using PerformFormatStepFn =
-      void (*)(InstanceContext* thiz, JitRuntime* runtime,
-               const uint8_t* type_proto_data, int64_t type_proto_data_size,
-               const uint8_t* value, uint64_t format_u64, std::string* buffer);
+  // This is a shim to let JIT code add an operand value to an existing trace
+  // buffer. The value is only formatted when the trace is read.
+  using PerformFormatStepFn = void (*)(
+      InstanceContext* thiz, JitRuntime* runtime,
+      const uint8_t* type_proto_data, int64_t type_proto_data_size,
+      const uint8_t* value, uint64_t format_u64,
+      UnformattedTraceMessage* buffer);
   const PerformFormatStepFn perform_format_step;
 
-  using RecordTraceFn = void (*)(InstanceContext* thiz, std::string* buffer,
+  using RecordTraceFn = void (*)(InstanceContext* thiz,
+                                 UnformattedTraceMessage* buffer,
                                  int64_t verbosity, InterpreterEvents* events);
   // This a shim to let JIT code record a completed trace as an interpreter
   // event.
   const RecordTraceFn record_trace;
 
-  using CreateTraceBufferFn = std::string* (*)(InstanceContext* thiz);
+  using CreateTraceBufferFn = UnformattedTraceMessage* (*)(
+      InstanceContext* thiz, int64_t verbosity, InterpreterEvents* events);
   // This is a shim to let JIT code create a buffer for accumulating trace
-  // fragments.
+  // fragments. Returns nullptr if traces of the given verbosity are not
+  // recorded (see InterpreterEvents::max_trace_verbosity), in which case the
+  // JIT code skips the trace.
   const CreateTraceBufferFn create_trace_buffer;
 
   using RecordAssertionFn = void (*)(InstanceContext* thiz, const char* msg,
@@ -84,6 +99,22 @@ struct InstanceContextVTable {
                                       int64_t queue_index, const uint8_t* data);
   const QueueSendWrapperFn queue_send_wrapper;
 
+  // Shims to let JIT code write and read wide channel payloads in place in the
+  // queue's storage rather than through an intermediate buffer. See
+  // JitChannelQueue::AcquireWriteSlot and JitChannelQueue::PeekReadSlot.
+  using QueueAcquireWriteSlotFn = uint8_t* (*)(InstanceContext* thiz,
+                                               int64_t queue_index);
+  const QueueAcquireWriteSlotFn queue_acquire_write_slot;
+  using QueueCommitWriteSlotFn = void (*)(InstanceContext* thiz,
+                                          int64_t queue_index);
+  const QueueCommitWriteSlotFn queue_commit_write_slot;
+  using QueuePeekReadSlotFn = const uint8_t* (*)(InstanceContext* thiz,
+                                                 int64_t queue_index);
+  const QueuePeekReadSlotFn queue_peek_read_slot;
+  using QueueReleaseReadSlotFn = void (*)(InstanceContext* thiz,
+                                          int64_t queue_index);
+  const QueueReleaseReadSlotFn queue_release_read_slot;
+
   using RecordActiveNextValueFn = void (*)(InstanceContext* thiz,
                                            int64_t param_id, int64_t next_id);
   // This is a shim to let JIT code record the activation of a `next_value`
@@ -100,6 +131,26 @@ struct InstanceContextVTable {
   // Data is in JIT data format and can be read using the appropriate type
   // information for the node.
   const RecordNodeResultFn record_node_result;
+
+  using GetNodeProfileCountersFn = uint64_t* (*)(InstanceContext* thiz);
+  // This is a shim to let JIT code compiled with node profiling find the
+  // buffer in which to accumulate per-node counters. Returns nullptr if no
+  // profile is being collected.
+  const GetNodeProfileCountersFn get_node_profile_counters;
+
+  using GetNodeCoverageBitsFn = uint8_t* (*)(InstanceContext* thiz);
+  // This is a shim to let JIT code compiled with node coverage find the buffer
+  // into which to OR the values of nodes. Returns nullptr if no coverage is
+  // being collected.
+  const GetNodeCoverageBitsFn get_node_coverage_bits;
+
+  using WideArithmeticFn = void (*)(InstanceContext* thiz, int64_t op,
+                                    uint64_t* result, const uint64_t* lhs,
+                                    const uint64_t* rhs, int64_t word_count);
+  // This is a shim to let JIT code multiply and divide unsigned integers too
+  // wide for LLVM to handle efficiently (see wide_arithmetic.h). `op` is a
+  // WideArithmeticOp and all operands are `word_count` 64-bit words long.
+  const WideArithmeticFn wide_arithmetic;
 };
 
 // Data structure passed to the JITted function which contains instance-specific
@@ -131,19 +182,38 @@ struct InstanceContext {
       offsetof(InstanceContextVTable, queue_receive_wrapper);
   static constexpr int64_t kQueueSendWrapperOffset =
       offsetof(InstanceContextVTable, queue_send_wrapper);
+  static constexpr int64_t kQueueAcquireWriteSlotOffset =
+      offsetof(InstanceContextVTable, queue_acquire_write_slot);
+  static constexpr int64_t kQueueCommitWriteSlotOffset =
+      offsetof(InstanceContextVTable, queue_commit_write_slot);
+  static constexpr int64_t kQueuePeekReadSlotOffset =
+      offsetof(InstanceContextVTable, queue_peek_read_slot);
+  static constexpr int64_t kQueueReleaseReadSlotOffset =
+      offsetof(InstanceContextVTable, queue_release_read_slot);
   static constexpr int64_t kRecordActiveNextValueOffset =
       offsetof(InstanceContextVTable, record_active_next_value);
   static constexpr int64_t kRecordNodeResultOffset =
       offsetof(InstanceContextVTable, record_node_result);
-  static constexpr int64_t kVTableLength = 9;
+  static constexpr int64_t kGetNodeProfileCountersOffset =
+      offsetof(InstanceContextVTable, get_node_profile_counters);
+  static constexpr int64_t kGetNodeCoverageBitsOffset =
+      offsetof(InstanceContextVTable, get_node_coverage_bits);
+  static constexpr int64_t kWideArithmeticOffset =
+      offsetof(InstanceContextVTable, wide_arithmetic);
+  static constexpr int64_t kVTableLength = 16;
   using VTableArrayType = std::array<void (*)(), kVTableLength>;
 
   static constexpr bool IsVtableOffset(int64_t v) {
     return v == kPerformFormatStepOffset || v == kPerformStringStepOffset ||
            v == kRecordTraceOffset || v == kCreateTraceBufferOffset ||
            v == kRecordAssertionOffset || v == kQueueReceiveWrapperOffset ||
-           v == kQueueSendWrapperOffset || v == kRecordActiveNextValueOffset ||
-           v == kRecordNodeResultOffset;
+           v == kQueueSendWrapperOffset ||
+           v == kQueueAcquireWriteSlotOffset ||
+           v == kQueueCommitWriteSlotOffset || v == kQueuePeekReadSlotOffset ||
+           v == kQueueReleaseReadSlotOffset ||
+           v == kRecordActiveNextValueOffset || v == kRecordNodeResultOffset ||
+           v == kGetNodeProfileCountersOffset ||
+           v == kGetNodeCoverageBitsOffset || v == kWideArithmeticOffset;
   }
 
   Type* ParseTypeFromProto(absl::Span<uint8_t const> data);
@@ -165,7 +235,19 @@ struct InstanceContext {
   // Arena used to materialize types that are passed to callbacks.
   std::unique_ptr<TypeManager> type_manager = std::make_unique<TypeManager>();
 
+  // Types parsed by ParseTypeFromProto, keyed by the address of the serialized
+  // proto, which is a constant of the JIT code.
+  absl::flat_hash_map<const uint8_t*, Type*> parsed_types;
+
   RuntimeObserver* observer = nullptr;
+
+  // Counters accumulated by JIT code compiled with node profiling (if any).
+  // Laid out as described by kNodeProfileCountersPerSite in node_profile.h.
+  uint64_t* node_profile_counters = nullptr;
+
+  // Bits accumulated by JIT code compiled with node coverage (if any). Laid
+  // out as described by the NodeCoverageSites of the JIT code.
+  uint8_t* node_coverage_bits = nullptr;
 };
 
 static_assert(offsetof(InstanceContext, vtable) == 0);
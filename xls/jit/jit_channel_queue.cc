@@ -19,9 +19,12 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
 #include "absl/memory/memory.h"
@@ -30,6 +33,9 @@
 #include "xls/common/math_util.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc_elaboration.h"
 #include "xls/ir/type.h"
@@ -56,6 +62,68 @@ std::optional<Value> ReadValueFromQueue(Type* type, JitRuntime& runtime,
   return runtime.UnpackBuffer(buffer.data(), type);
 }
 
+int64_t GetInitialCapacity(Channel* channel) {
+  if (auto* streaming = dynamic_cast<StreamingChannel*>(channel)) {
+    std::optional<int64_t> depth = streaming->GetFifoDepth();
+    if (depth.has_value() && *depth > 0) {
+      return *depth;
+    }
+  }
+  return LockFreeJitChannelQueue::kDefaultCapacity;
+}
+
+// Returns the number of distinct proc instances which send on (`senders`) or
+// receive from (`receivers`) each channel instance in the elaboration.
+struct ChannelEndpointCounts {
+  absl::flat_hash_map<ChannelInstance*, int64_t> senders;
+  absl::flat_hash_map<ChannelInstance*, int64_t> receivers;
+};
+
+absl::StatusOr<ChannelInstance*> ResolveChannelInstance(
+    const ProcElaboration& elaboration, ProcInstance* proc_instance,
+    std::string_view channel_name) {
+  if (proc_instance->path().has_value()) {
+    // New-style proc-scoped channels.
+    return proc_instance->GetChannelInstance(channel_name);
+  }
+  // Old-style global channels.
+  XLS_ASSIGN_OR_RETURN(
+      Channel * channel,
+      proc_instance->proc()->package()->GetChannel(channel_name));
+  return elaboration.GetUniqueInstance(channel);
+}
+
+absl::StatusOr<ChannelEndpointCounts> CountChannelEndpoints(
+    const ProcElaboration& elaboration) {
+  ChannelEndpointCounts counts;
+  for (ProcInstance* proc_instance : elaboration.proc_instances()) {
+    absl::flat_hash_set<ChannelInstance*> sends;
+    absl::flat_hash_set<ChannelInstance*> receives;
+    for (Node* node : proc_instance->proc()->nodes()) {
+      if (node->Is<Send>()) {
+        XLS_ASSIGN_OR_RETURN(
+            ChannelInstance * instance,
+            ResolveChannelInstance(elaboration, proc_instance,
+                                   node->As<Send>()->channel_name()));
+        sends.insert(instance);
+      } else if (node->Is<Receive>()) {
+        XLS_ASSIGN_OR_RETURN(
+            ChannelInstance * instance,
+            ResolveChannelInstance(elaboration, proc_instance,
+                                   node->As<Receive>()->channel_name()));
+        receives.insert(instance);
+      }
+    }
+    for (ChannelInstance* instance : sends) {
+      ++counts.senders[instance];
+    }
+    for (ChannelInstance* instance : receives) {
+      ++counts.receivers[instance];
+    }
+  }
+  return counts;
+}
+
 }  // namespace
 
 ByteQueue::ByteQueue(int64_t channel_element_size, bool is_single_value)
@@ -70,21 +138,17 @@ ByteQueue::ByteQueue(int64_t channel_element_size, bool is_single_value)
   if (allocated_element_size_ == 0) {
     allocated_element_size_ = 1;
   }
-  // Align the vector allocation to a power of 2 for efficient utilization
-  // of the memory.
-  int64_t element_size_2 = 1 << CeilOfLog2(allocated_element_size_);
-  if (element_size_2 > kInitBufferSize) {
-    circular_buffer_.resize(element_size_2);
-  } else {
-    circular_buffer_.resize(kInitBufferSize);
-  }
-  max_byte_count_ = FloorOfRatio(static_cast<int64_t>(circular_buffer_.size()),
-                                 allocated_element_size_) *
-                    allocated_element_size_;
 }
 
 void ByteQueue::Resize() {
-  circular_buffer_.resize(circular_buffer_.size() * 2);
+  if (circular_buffer_.empty()) {
+    // Align the vector allocation to a power of 2 for efficient utilization
+    // of the memory.
+    int64_t element_size_2 = int64_t{1} << CeilOfLog2(allocated_element_size_);
+    circular_buffer_.resize(std::max(element_size_2, kInitBufferSize));
+  } else {
+    circular_buffer_.resize(circular_buffer_.size() * 2);
+  }
   max_byte_count_ = FloorOfRatio(static_cast<int64_t>(circular_buffer_.size()),
                                  allocated_element_size_) *
                     allocated_element_size_;
@@ -102,11 +166,91 @@ void ByteQueue::Resize() {
   }
 }
 
+SpscByteQueue::SpscByteQueue(int64_t channel_element_size,
+                             int64_t initial_capacity)
+    : channel_element_size_(channel_element_size),
+      allocated_element_size_(std::max<int64_t>(
+          RoundUpToNearest(channel_element_size,
+                           static_cast<int64_t>(alignof(std::max_align_t))),
+          1)) {
+  int64_t capacity =
+      int64_t{1} << CeilOfLog2(std::max<int64_t>(initial_capacity, 1));
+  write_segment_ = new Segment(capacity, allocated_element_size_);
+  read_segment_ = write_segment_;
+}
+
+SpscByteQueue::~SpscByteQueue() {
+  Segment* segment = read_segment_;
+  while (segment != nullptr) {
+    Segment* next = segment->next.load(std::memory_order_acquire);
+    delete segment;
+    segment = next;
+  }
+}
+
+SpscByteQueue::Segment* SpscByteQueue::Grow() {
+  auto* segment =
+      new Segment(write_segment_->capacity * 2, allocated_element_size_);
+  write_segment_->next.store(segment, std::memory_order_release);
+  write_segment_ = segment;
+  return segment;
+}
+
+SpscByteQueue::Segment* SpscByteQueue::AdvanceReadSegment() {
+  while (true) {
+    Segment* segment = read_segment_;
+    Segment* next = segment->next.load(std::memory_order_acquire);
+    // The producer never writes to a segment after linking its successor so
+    // once `next` is visible so are all writes to `segment`.
+    if (segment->head.load(std::memory_order_relaxed) !=
+        segment->tail.load(std::memory_order_acquire)) {
+      return segment;
+    }
+    if (next == nullptr) {
+      return nullptr;
+    }
+    read_segment_ = next;
+    delete segment;
+  }
+}
+
+LockFreeJitChannelQueue::LockFreeJitChannelQueue(
+    ChannelInstance* channel_instance, JitRuntime* jit_runtime)
+    : JitChannelQueue(channel_instance, jit_runtime),
+      byte_queue_(
+          jit_runtime->GetTypeByteSize(channel_instance->channel->type()),
+          GetInitialCapacity(channel_instance->channel)) {
+  CHECK_EQ(channel_instance->channel->kind(), ChannelKind::kStreaming)
+      << "LockFreeJitChannelQueue only supports streaming channels";
+}
+
+int64_t LockFreeJitChannelQueue::GetSizeInternal() const {
+  return byte_queue_.size();
+}
+
+void LockFreeJitChannelQueue::WriteInternal(Value value) {
+  CallWriteCallbacks(value);
+  std::vector<uint8_t> buffer(byte_queue_.element_size());
+  jit_runtime_->BlitValueToBuffer(value, channel()->type(),
+                                  absl::MakeSpan(buffer));
+  byte_queue_.Write(buffer.data());
+}
+
+std::optional<Value> LockFreeJitChannelQueue::ReadInternal() {
+  std::vector<uint8_t> buffer(byte_queue_.element_size());
+  if (!byte_queue_.Read(buffer.data())) {
+    return std::nullopt;
+  }
+  Value value = jit_runtime_->UnpackBuffer(buffer.data(), channel()->type());
+  CallReadCallbacks(value);
+  return value;
+}
+
 int64_t ThreadSafeJitChannelQueue::GetSizeInternal() const {
   return byte_queue_.size();
 }
 
-void ThreadSafeJitChannelQueue::WriteInternal(const Value& value) {
+void ThreadSafeJitChannelQueue::WriteInternal(Value value) {
   CallWriteCallbacks(value);
   WriteValueOnQueue(value, channel()->type(), *jit_runtime_, byte_queue_);
 }
@@ -124,7 +268,7 @@ int64_t ThreadUnsafeJitChannelQueue::GetSizeInternal() const {
   return byte_queue_.size();
 }
 
-void ThreadUnsafeJitChannelQueue::WriteInternal(const Value& value) {
+void ThreadUnsafeJitChannelQueue::WriteInternal(Value value) {
   CallWriteCallbacks(value);
   WriteValueOnQueue(value, channel()->type(), *jit_runtime_, byte_queue_);
 }
@@ -178,6 +322,38 @@ JitChannelQueueManager::CreateThreadUnsafe(
       std::move(elaboration), std::move(queues), std::move(runtime)));
 }
 
+/* static */ absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
+JitChannelQueueManager::CreateLockFree(Package* package,
+                                       std::unique_ptr<JitRuntime> runtime) {
+  XLS_ASSIGN_OR_RETURN(ProcElaboration elaboration,
+                       ProcElaboration::ElaborateOldStylePackage(package));
+  return CreateLockFree(std::move(elaboration), std::move(runtime));
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
+JitChannelQueueManager::CreateLockFree(ProcElaboration&& elaboration,
+                                       std::unique_ptr<JitRuntime> runtime) {
+  XLS_ASSIGN_OR_RETURN(ChannelEndpointCounts counts,
+                       CountChannelEndpoints(elaboration));
+  std::vector<std::unique_ptr<ChannelQueue>> queues;
+  for (ChannelInstance* channel_instance : elaboration.channel_instances()) {
+    // Input channels are written by the host and output channels are read by
+    // the host; either way there is a single producer and consumer as long as
+    // at most one proc instance is on each end.
+    if (channel_instance->channel->kind() == ChannelKind::kStreaming &&
+        counts.senders[channel_instance] <= 1 &&
+        counts.receivers[channel_instance] <= 1) {
+      queues.push_back(std::make_unique<LockFreeJitChannelQueue>(
+          channel_instance, runtime.get()));
+    } else {
+      queues.push_back(std::make_unique<ThreadSafeJitChannelQueue>(
+          channel_instance, runtime.get()));
+    }
+  }
+  return absl::WrapUnique(new JitChannelQueueManager(
+      std::move(elaboration), std::move(queues), std::move(runtime)));
+}
+
 JitChannelQueue& JitChannelQueueManager::GetJitQueue(Channel* channel) {
   JitChannelQueue* queue = dynamic_cast<JitChannelQueue*>(&GetQueue(channel));
   CHECK_NE(queue, nullptr);
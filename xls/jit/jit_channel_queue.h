@@ -14,6 +14,7 @@
 #ifndef XLS_JIT_JIT_CHANNEL_QUEUE_H_
 #define XLS_JIT_JIT_CHANNEL_QUEUE_H_
 
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -21,6 +22,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/optimization.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
@@ -47,17 +49,42 @@ class ByteQueue {
 
   int64_t element_size() const { return channel_element_size_; }
 
-  // Doubles the size of the queue.
+  // Doubles the size of the queue, or allocates it if it is empty.
   void Resize();
 
   void Write(const uint8_t* data) {
 #ifdef ABSL_HAVE_MEMORY_SANITIZER
     __msan_unpoison(data, channel_element_size_);
 #endif
-    if (bytes_used_ == max_byte_count_ && !is_single_value_) {
+    memcpy(AcquireWriteSlot(), data, channel_element_size_);
+    CommitWrite();
+  }
+
+  bool Read(uint8_t* buffer) {
+    const uint8_t* slot = PeekRead();
+    if (slot == nullptr) {
+      return false;
+    }
+    memcpy(buffer, slot, channel_element_size_);
+    Pop();
+    return true;
+  }
+
+  // Returns the slot which the next write fills, growing the queue if
+  // necessary. The caller writes the element in place and then calls
+  // CommitWrite to make it visible. The slot is invalidated by any other
+  // write.
+  uint8_t* AcquireWriteSlot() {
+    if (bytes_used_ == max_byte_count_ &&
+        (!is_single_value_ || max_byte_count_ == 0)) {
       Resize();
     }
-    memcpy(circular_buffer_.data() + write_index_, data, channel_element_size_);
+    return circular_buffer_.data() + write_index_;
+  }
+  // Returns the slot filled by the last call to AcquireWriteSlot after
+  // committing it.
+  const uint8_t* CommitWrite() {
+    const uint8_t* slot = circular_buffer_.data() + write_index_;
     if (is_single_value_) {
       bytes_used_ = allocated_element_size_;
     } else {
@@ -67,14 +94,20 @@ class ByteQueue {
         write_index_ = 0;
       }
     }
+    return slot;
   }
 
-  bool Read(uint8_t* buffer) {
+  // Returns the slot holding the oldest element or nullptr if the queue is
+  // empty. The slot remains valid until the next Pop or write.
+  const uint8_t* PeekRead() const {
     if (bytes_used_ == 0) {
-      return false;
+      return nullptr;
     }
-    memcpy(buffer, circular_buffer_.data() + read_index_,
-           channel_element_size_);
+    return circular_buffer_.data() + read_index_;
+  }
+  // Removes the oldest element. Has no effect on single-value queues. The
+  // queue must not be empty.
+  void Pop() {
     if (!is_single_value_) {
       // Reads are destructive for non single-value channels.
       bytes_used_ -= allocated_element_size_;
@@ -83,7 +116,6 @@ class ByteQueue {
         read_index_ = 0;
       }
     }
-    return true;
   }
 
   int64_t size() const { return bytes_used_ / allocated_element_size_; }
@@ -106,12 +138,155 @@ class ByteQueue {
   int64_t read_index_ = 0;
   // Index in the circular buffer to read values from.
   int64_t write_index_ = 0;
-  // A circular buffer to store the elements. It is preallocated with storage.
+  // A circular buffer to store the elements. It is allocated on the first
+  // write, so the queues of channels which are never written (e.g., in large
+  // proc networks) only take up the inline storage.
   absl::InlinedVector<uint8_t, kInitBufferSize> circular_buffer_;
   // Whether this queue follows single-value channel semantics.
   bool is_single_value_;
 };
 
+// A lock-free queue from which raw bytes may be written by one producer thread
+// and read by one consumer thread concurrently. The queue has FIFO semantics.
+//
+// Elements are stored in a chain of ring-buffer segments. Writes go to the
+// newest segment; when it is full the producer links in a new segment of twice
+// the capacity rather than blocking, so writes always succeed just as with
+// ByteQueue. The consumer frees segments once it has drained them and the
+// producer has moved on. The head and tail indices live on separate cache
+// lines so the producer and consumer do not contend.
+class SpscByteQueue {
+ public:
+  // `channel_element_size` is the granularity of the queue access.
+  // `initial_capacity` is the number of elements the first segment holds and is
+  // rounded up to a power of two.
+  SpscByteQueue(int64_t channel_element_size, int64_t initial_capacity);
+  ~SpscByteQueue();
+
+  SpscByteQueue(const SpscByteQueue&) = delete;
+  SpscByteQueue& operator=(const SpscByteQueue&) = delete;
+
+  int64_t element_size() const { return channel_element_size_; }
+
+  // Must only be called from the producer thread.
+  void Write(const uint8_t* data) {
+#ifdef ABSL_HAVE_MEMORY_SANITIZER
+    __msan_unpoison(data, channel_element_size_);
+#endif
+    memcpy(AcquireWriteSlot(), data, channel_element_size_);
+    CommitWrite();
+  }
+
+  // Must only be called from the consumer thread. Returns false if the queue
+  // is empty.
+  bool Read(uint8_t* buffer) {
+    const uint8_t* slot = PeekRead();
+    if (slot == nullptr) {
+      return false;
+    }
+    memcpy(buffer, slot, channel_element_size_);
+    Pop();
+    return true;
+  }
+
+  // Returns the slot which the next write fills, linking in a new segment if
+  // necessary. The producer writes the element in place and then calls
+  // CommitWrite to publish it. Must only be called from the producer thread.
+  uint8_t* AcquireWriteSlot() {
+    Segment* segment = write_segment_;
+    int64_t tail = segment->tail.load(std::memory_order_relaxed);
+    if (ABSL_PREDICT_FALSE(tail - segment->head.load(std::memory_order_acquire) ==
+                           segment->capacity)) {
+      segment = Grow();
+      tail = 0;
+    }
+    return segment->Slot(tail, allocated_element_size_);
+  }
+  // Publishes the slot returned by the last call to AcquireWriteSlot and
+  // returns it. The slot must not be accessed by the producer afterwards.
+  const uint8_t* CommitWrite() {
+    Segment* segment = write_segment_;
+    int64_t tail = segment->tail.load(std::memory_order_relaxed);
+    // Count the element before publishing it so size() never goes negative.
+    write_count_.store(write_count_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+    segment->tail.store(tail + 1, std::memory_order_release);
+    return segment->Slot(tail, allocated_element_size_);
+  }
+
+  // Returns the slot holding the oldest element or nullptr if the queue is
+  // empty. The slot remains valid until the next Pop. Must only be called from
+  // the consumer thread.
+  const uint8_t* PeekRead() {
+    Segment* segment = read_segment_;
+    int64_t head = segment->head.load(std::memory_order_relaxed);
+    if (ABSL_PREDICT_FALSE(head ==
+                           segment->tail.load(std::memory_order_acquire))) {
+      segment = AdvanceReadSegment();
+      if (segment == nullptr) {
+        return nullptr;
+      }
+      head = segment->head.load(std::memory_order_relaxed);
+    }
+    return segment->Slot(head, allocated_element_size_);
+  }
+  // Removes the oldest element. Must only be called from the consumer thread
+  // after a successful PeekRead.
+  void Pop() {
+    Segment* segment = read_segment_;
+    int64_t head = segment->head.load(std::memory_order_relaxed);
+    segment->head.store(head + 1, std::memory_order_release);
+    read_count_.store(read_count_.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+  }
+
+  // Returns the number of elements in the queue. May be called from any
+  // thread.
+  int64_t size() const {
+    int64_t read_count = read_count_.load(std::memory_order_acquire);
+    return write_count_.load(std::memory_order_acquire) - read_count;
+  }
+
+ private:
+  struct Segment {
+    Segment(int64_t capacity, int64_t allocated_element_size)
+        : capacity(capacity),
+          data(new uint8_t[capacity * allocated_element_size]) {}
+
+    uint8_t* Slot(int64_t index, int64_t allocated_element_size) {
+      return data.get() + (index & (capacity - 1)) * allocated_element_size;
+    }
+
+    // Number of elements read from this segment. Written by the consumer.
+    alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> head = 0;
+    // Number of elements written to this segment. Written by the producer.
+    alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> tail = 0;
+    alignas(ABSL_CACHELINE_SIZE) const int64_t capacity;
+    std::unique_ptr<uint8_t[]> data;
+    // The segment the producer moved on to once this one filled up.
+    std::atomic<Segment*> next = nullptr;
+  };
+
+  // Links a new, larger segment after the current write segment and returns
+  // it.
+  Segment* Grow();
+
+  // Frees drained segments the producer has moved past. Returns the read
+  // segment if it is non-empty afterwards, or nullptr if the queue is empty.
+  Segment* AdvanceReadSegment();
+
+  int64_t channel_element_size_;
+  int64_t allocated_element_size_;
+
+  // Producer state.
+  alignas(ABSL_CACHELINE_SIZE) Segment* write_segment_;
+  std::atomic<int64_t> write_count_ = 0;
+
+  // Consumer state.
+  alignas(ABSL_CACHELINE_SIZE) Segment* read_segment_;
+  std::atomic<int64_t> read_count_ = 0;
+};
+
 // Abstract base class for channel queues which may be used by the JIT. These
 // queues support reading and writing raw bytes to the queue rather the just
 // xls::Values.
@@ -124,6 +299,24 @@ class JitChannelQueue : public ChannelQueue {
   virtual void WriteRaw(const uint8_t* data) = 0;
   virtual bool ReadRaw(uint8_t* buffer) = 0;
 
+  // Slot-based versions of WriteRaw and ReadRaw which let the caller access
+  // the queue's storage in place. AcquireWriteSlot returns a buffer of the
+  // channel's element size into which the caller writes the next value in
+  // LLVM's native format, and CommitWriteSlot makes the value visible. Each
+  // acquire must be followed by exactly one commit with no other access to the
+  // queue from the same thread in between.
+  virtual uint8_t* AcquireWriteSlot() = 0;
+  virtual void CommitWriteSlot() = 0;
+
+  // Returns a pointer to the oldest value in the queue or nullptr if the queue
+  // is empty. If non-null, the caller reads the value in place and then must
+  // call ReleaseReadSlot to remove it from the queue, with no other access to
+  // the queue from the same thread in between.
+  virtual const uint8_t* PeekReadSlot() = 0;
+  virtual void ReleaseReadSlot() = 0;
+
+  JitRuntime* jit_runtime() const { return jit_runtime_; }
+
  protected:
   JitRuntime* jit_runtime_;
 };
@@ -156,7 +349,7 @@ class ThreadSafeJitChannelQueue : public JitChannelQueue {
     if (generator_.has_value()) {
       std::optional<Value> generated_value = (*generator_)();
       if (generated_value.has_value()) {
-        WriteInternal(generated_value.value());
+        WriteInternal(*std::move(generated_value));
       }
     }
     bool value_read = byte_queue_.Read(buffer);
@@ -166,10 +359,45 @@ class ThreadSafeJitChannelQueue : public JitChannelQueue {
     return value_read;
   }
 
+  // The mutex is held from acquiring (peeking) a slot until it is committed
+  // (released).
+  uint8_t* AcquireWriteSlot() override ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.Lock();
+    return byte_queue_.AcquireWriteSlot();
+  }
+  void CommitWriteSlot() override ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    const uint8_t* slot = byte_queue_.CommitWrite();
+    if (!callbacks_.empty()) {
+      CallWriteCallbacks(jit_runtime_->UnpackBuffer(slot, channel()->type()));
+    }
+    mutex_.Unlock();
+  }
+  const uint8_t* PeekReadSlot() override ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    mutex_.Lock();
+    if (generator_.has_value()) {
+      std::optional<Value> generated_value = (*generator_)();
+      if (generated_value.has_value()) {
+        WriteInternal(*std::move(generated_value));
+      }
+    }
+    const uint8_t* slot = byte_queue_.PeekRead();
+    if (slot == nullptr) {
+      mutex_.Unlock();
+    }
+    return slot;
+  }
+  void ReleaseReadSlot() override ABSL_NO_THREAD_SAFETY_ANALYSIS {
+    if (!callbacks_.empty()) {
+      CallReadCallbacks(
+          jit_runtime_->UnpackBuffer(byte_queue_.PeekRead(), channel()->type()));
+    }
+    byte_queue_.Pop();
+    mutex_.Unlock();
+  }
+
  protected:
   int64_t GetSizeInternal() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
-  void WriteInternal(const Value& value)
-      ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
+  void WriteInternal(Value value) ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
   std::optional<Value> ReadInternal()
       ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
 
@@ -197,7 +425,7 @@ class ThreadUnsafeJitChannelQueue : public JitChannelQueue {
     if (generator_.has_value()) {
       std::optional<Value> generated_value = (*generator_)();
       if (generated_value.has_value()) {
-        WriteInternal(generated_value.value());
+        WriteInternal(*std::move(generated_value));
       }
     }
     bool value_read = byte_queue_.Read(buffer);
@@ -207,14 +435,112 @@ class ThreadUnsafeJitChannelQueue : public JitChannelQueue {
     return value_read;
   }
 
+  uint8_t* AcquireWriteSlot() override {
+    return byte_queue_.AcquireWriteSlot();
+  }
+  void CommitWriteSlot() override {
+    const uint8_t* slot = byte_queue_.CommitWrite();
+    if (!callbacks_.empty()) {
+      CallWriteCallbacks(jit_runtime_->UnpackBuffer(slot, channel()->type()));
+    }
+  }
+  const uint8_t* PeekReadSlot() override {
+    if (generator_.has_value()) {
+      std::optional<Value> generated_value = (*generator_)();
+      if (generated_value.has_value()) {
+        WriteInternal(*std::move(generated_value));
+      }
+    }
+    return byte_queue_.PeekRead();
+  }
+  void ReleaseReadSlot() override {
+    if (!callbacks_.empty()) {
+      CallReadCallbacks(
+          jit_runtime_->UnpackBuffer(byte_queue_.PeekRead(), channel()->type()));
+    }
+    byte_queue_.Pop();
+  }
+
  protected:
   int64_t GetSizeInternal() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
-  void WriteInternal(const Value& value) override;
+  void WriteInternal(Value value) override;
   std::optional<Value> ReadInternal() override;
 
   ByteQueue byte_queue_;
 };
 
+// A lock-free version of the JIT channel queue for streaming channels with a
+// single sending and a single receiving proc instance. The raw API used by
+// the JIT never takes a lock; the proc instance ticking the sender (or the
+// host, for input channels) is the producer and the proc instance ticking the
+// receiver (or the host, for output channels) is the consumer. The first
+// segment is sized from the channel's declared FIFO depth.
+class LockFreeJitChannelQueue : public JitChannelQueue {
+ public:
+  // Default capacity when the channel does not declare a FIFO depth.
+  static constexpr int64_t kDefaultCapacity = 64;
+
+  LockFreeJitChannelQueue(ChannelInstance* channel_instance,
+                          JitRuntime* jit_runtime);
+  ~LockFreeJitChannelQueue() override = default;
+
+  void WriteRaw(const uint8_t* data) override {
+    byte_queue_.Write(data);
+    if (!callbacks_.empty()) {
+      CallWriteCallbacks(jit_runtime_->UnpackBuffer(data, channel()->type()));
+    }
+  }
+  bool ReadRaw(uint8_t* buffer) override {
+    // With a generator attached the consumer is also the only producer.
+    if (generator_.has_value()) {
+      std::optional<Value> generated_value = (*generator_)();
+      if (generated_value.has_value()) {
+        WriteInternal(*std::move(generated_value));
+      }
+    }
+    bool value_read = byte_queue_.Read(buffer);
+    if (value_read && !callbacks_.empty()) {
+      CallReadCallbacks(jit_runtime_->UnpackBuffer(buffer, channel()->type()));
+    }
+    return value_read;
+  }
+
+  uint8_t* AcquireWriteSlot() override {
+    return byte_queue_.AcquireWriteSlot();
+  }
+  void CommitWriteSlot() override {
+    const uint8_t* slot = byte_queue_.CommitWrite();
+    if (!callbacks_.empty()) {
+      // Slots are never modified by the consumer and the segment holding the
+      // committed slot is the newest one so it cannot have been freed.
+      CallWriteCallbacks(jit_runtime_->UnpackBuffer(slot, channel()->type()));
+    }
+  }
+  const uint8_t* PeekReadSlot() override {
+    if (generator_.has_value()) {
+      std::optional<Value> generated_value = (*generator_)();
+      if (generated_value.has_value()) {
+        WriteInternal(*std::move(generated_value));
+      }
+    }
+    return byte_queue_.PeekRead();
+  }
+  void ReleaseReadSlot() override {
+    if (!callbacks_.empty()) {
+      CallReadCallbacks(
+          jit_runtime_->UnpackBuffer(byte_queue_.PeekRead(), channel()->type()));
+    }
+    byte_queue_.Pop();
+  }
+
+ protected:
+  int64_t GetSizeInternal() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
+  void WriteInternal(Value value) override;
+  std::optional<Value> ReadInternal() override;
+
+  SpscByteQueue byte_queue_;
+};
+
 // A Channel manager which holds exclusively JitChannelQueues.
 class JitChannelQueueManager : public ChannelQueueManager {
  public:
@@ -233,6 +559,16 @@ class JitChannelQueueManager : public ChannelQueueManager {
   CreateThreadUnsafe(ProcElaboration&& elaboration,
                      std::unique_ptr<JitRuntime> runtime);
 
+  // Factories which create a queue manager whose queues are thread-safe,
+  // using LockFreeJitChannelQueues for streaming channel instances with at
+  // most one sending and one receiving proc instance and
+  // ThreadSafeJitChannelQueues for all others.
+  static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
+  CreateLockFree(Package* package, std::unique_ptr<JitRuntime> runtime);
+  static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
+  CreateLockFree(ProcElaboration&& elaboration,
+                 std::unique_ptr<JitRuntime> runtime);
+
   JitChannelQueue& GetJitQueue(Channel* channel);
   JitChannelQueue& GetJitQueue(ChannelInstance* channel_instance);
 
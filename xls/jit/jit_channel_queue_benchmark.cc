@@ -20,6 +20,7 @@
 
 #include "absl/log/check.h"
 #include "include/benchmark/benchmark.h"
+#include "xls/common/thread.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel_ops.h"
 #include "xls/ir/package.h"
@@ -93,6 +94,69 @@ BENCHMARK(BM_QueueWriteThenRead<ThreadUnsafeJitChannelQueue>)
     ->ArgPair(2048, 1)
     ->ArgPair(2048, 128);
 
+BENCHMARK(BM_QueueWriteThenRead<LockFreeJitChannelQueue>)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 128)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 128)
+    ->ArgPair(32, 1)
+    ->ArgPair(32, 128)
+    ->ArgPair(2048, 1)
+    ->ArgPair(2048, 128);
+
+// Benchmark evaluating a producer thread writing to the channel while the
+// benchmark thread concurrently reads from it. Each iteration transfers
+// `state.range(1)` elements.
+template <typename QueueT,
+          typename std::enable_if<std::is_base_of_v<JitChannelQueue, QueueT>,
+                                  QueueT>::type* = nullptr>
+static void BM_QueueProducerConsumer(benchmark::State& state) {
+  int64_t element_size_bytes = state.range(0);
+
+  Package package("benchmark");
+  auto orc_jit = OrcJit::Create().value();
+  auto jit_runtime =
+      std::make_unique<JitRuntime>(orc_jit->CreateDataLayout().value());
+  Channel* channel =
+      package
+          .CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                  package.GetBitsType(8 * element_size_bytes))
+          .value();
+  ProcElaboration elaboration =
+      ProcElaboration::ElaborateOldStylePackage(&package).value();
+
+  QueueT queue(elaboration.GetUniqueInstance(channel).value(),
+               jit_runtime.get());
+
+  int64_t send_count = state.range(1);
+  std::vector<uint8_t> recv_buffer(element_size_bytes);
+  for (auto _ : state) {
+    Thread producer([&]() {
+      std::vector<uint8_t> send_buffer(element_size_bytes, 42);
+      for (int64_t i = 0; i < send_count; ++i) {
+        queue.WriteRaw(send_buffer.data());
+      }
+    });
+    for (int64_t i = 0; i < send_count;) {
+      if (queue.ReadRaw(recv_buffer.data())) {
+        ++i;
+      }
+    }
+    producer.Join();
+  }
+  state.SetItemsProcessed(state.iterations() * send_count);
+}
+
+BENCHMARK(BM_QueueProducerConsumer<ThreadSafeJitChannelQueue>)
+    ->ArgPair(8, 1024)
+    ->ArgPair(8, 65536)
+    ->ArgPair(2048, 1024);
+
+BENCHMARK(BM_QueueProducerConsumer<LockFreeJitChannelQueue>)
+    ->ArgPair(8, 1024)
+    ->ArgPair(8, 65536)
+    ->ArgPair(2048, 1024);
+
 }  // namespace
 }  // namespace xls
 
@@ -25,6 +25,7 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/thread.h"
 #include "xls/interpreter/channel_queue_test_base.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/channel.h"
@@ -64,11 +65,25 @@ INSTANTIATE_TEST_SUITE_P(
                                                                GetJitRuntime());
         })));
 
+INSTANTIATE_TEST_SUITE_P(
+    LockFreeJitChannelQueueTest, ChannelQueueTestBase,
+    testing::Values(ChannelQueueTestParam(
+        [](ChannelInstance* channel_instance) -> std::unique_ptr<ChannelQueue> {
+          // Lock-free queues only support streaming channels.
+          if (channel_instance->channel->kind() != ChannelKind::kStreaming) {
+            return std::make_unique<ThreadSafeJitChannelQueue>(
+                channel_instance, GetJitRuntime());
+          }
+          return std::make_unique<LockFreeJitChannelQueue>(channel_instance,
+                                                           GetJitRuntime());
+        })));
+
 template <typename QueueT>
 class JitChannelQueueTest : public ::testing::Test {};
 
 using QueueTypes =
-    ::testing::Types<ThreadSafeJitChannelQueue, ThreadUnsafeJitChannelQueue>;
+    ::testing::Types<ThreadSafeJitChannelQueue, ThreadUnsafeJitChannelQueue,
+                     LockFreeJitChannelQueue>;
 TYPED_TEST_SUITE(JitChannelQueueTest, QueueTypes);
 
 // An empty tuple represents a zero width.
@@ -146,6 +161,46 @@ TYPED_TEST(JitChannelQueueTest, BasicAccess) {
   EXPECT_TRUE(queue.IsEmpty());
 }
 
+TYPED_TEST(JitChannelQueueTest, SlotAccess) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+
+  TypeParam queue(elaboration.GetUniqueInstance(channel).value(),
+                  GetJitRuntime());
+
+  EXPECT_EQ(queue.PeekReadSlot(), nullptr);
+  // Write enough values to force the queue to grow.
+  for (uint32_t i = 0; i < 1000; ++i) {
+    memcpy(queue.AcquireWriteSlot(), &i, sizeof(i));
+    queue.CommitWriteSlot();
+  }
+  EXPECT_EQ(queue.GetSize(), 1000);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    const uint8_t* slot = queue.PeekReadSlot();
+    ASSERT_NE(slot, nullptr);
+    uint32_t value;
+    memcpy(&value, slot, sizeof(value));
+    EXPECT_EQ(value, i);
+    queue.ReleaseReadSlot();
+  }
+  EXPECT_EQ(queue.PeekReadSlot(), nullptr);
+  EXPECT_TRUE(queue.IsEmpty());
+
+  // The slot API interoperates with the raw API.
+  uint32_t value = 42;
+  queue.WriteRaw(reinterpret_cast<const uint8_t*>(&value));
+  const uint8_t* slot = queue.PeekReadSlot();
+  ASSERT_NE(slot, nullptr);
+  EXPECT_EQ(memcmp(slot, &value, sizeof(value)), 0);
+  queue.ReleaseReadSlot();
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
 TYPED_TEST(JitChannelQueueTest, IotaGeneratorWithRawApi) {
   Package package("test");
   XLS_ASSERT_OK_AND_ASSIGN(
@@ -181,5 +236,129 @@ TYPED_TEST(JitChannelQueueTest, IotaGeneratorWithRawApi) {
                                  "a generator function")));
 }
 
+TEST(ByteQueueTest, WideElementsAllocatedOnFirstWrite) {
+  // Elements wider than the inline storage of the queue.
+  constexpr int64_t kElementSize = 1000;
+  std::vector<uint8_t> send_buffer(kElementSize);
+  std::vector<uint8_t> recv_buffer(kElementSize);
+
+  ByteQueue single_value(kElementSize, /*is_single_value=*/true);
+  EXPECT_FALSE(single_value.Read(recv_buffer.data()));
+  send_buffer[kElementSize - 1] = 42;
+  single_value.Write(send_buffer.data());
+  EXPECT_TRUE(single_value.Read(recv_buffer.data()));
+  EXPECT_TRUE(single_value.Read(recv_buffer.data()));
+  EXPECT_EQ(recv_buffer[kElementSize - 1], 42);
+
+  ByteQueue fifo(kElementSize, /*is_single_value=*/false);
+  EXPECT_FALSE(fifo.Read(recv_buffer.data()));
+  for (int64_t i = 0; i < 5; ++i) {
+    send_buffer[kElementSize - 1] = i;
+    fifo.Write(send_buffer.data());
+  }
+  for (int64_t i = 0; i < 5; ++i) {
+    EXPECT_TRUE(fifo.Read(recv_buffer.data()));
+    EXPECT_EQ(recv_buffer[kElementSize - 1], i);
+  }
+  EXPECT_FALSE(fifo.Read(recv_buffer.data()));
+}
+
+TEST(LockFreeJitChannelQueueTest, GrowsPastFifoDepth) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel(
+          "my_channel", ChannelOps::kSendReceive, package.GetBitsType(32),
+          /*initial_values=*/{}, /*fifo_config=*/
+          FifoConfig(/*depth=*/3, /*bypass=*/true,
+                     /*register_push_outputs=*/false,
+                     /*register_pop_outputs=*/false)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+
+  LockFreeJitChannelQueue queue(elaboration.GetUniqueInstance(channel).value(),
+                                GetJitRuntime());
+
+  // Interleave reads and writes so the consumer drains segments while the
+  // producer is still filling later ones.
+  uint32_t next_write = 0;
+  uint32_t next_read = 0;
+  for (int64_t round = 0; round < 8; ++round) {
+    for (int64_t i = 0; i < 10 * (round + 1); ++i) {
+      queue.WriteRaw(reinterpret_cast<const uint8_t*>(&next_write));
+      ++next_write;
+    }
+    EXPECT_EQ(queue.GetSize(), next_write - next_read);
+    for (int64_t i = 0; i < 7 * (round + 1); ++i) {
+      uint32_t value;
+      ASSERT_TRUE(queue.ReadRaw(reinterpret_cast<uint8_t*>(&value)));
+      EXPECT_EQ(value, next_read);
+      ++next_read;
+    }
+  }
+  uint32_t value;
+  while (queue.ReadRaw(reinterpret_cast<uint8_t*>(&value))) {
+    EXPECT_EQ(value, next_read);
+    ++next_read;
+  }
+  EXPECT_EQ(next_read, next_write);
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(LockFreeJitChannelQueueTest, ConcurrentProducerAndConsumer) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(ProcElaboration elaboration,
+                           ProcElaboration::ElaborateOldStylePackage(&package));
+
+  LockFreeJitChannelQueue queue(elaboration.GetUniqueInstance(channel).value(),
+                                GetJitRuntime());
+
+  constexpr uint32_t kCount = 100000;
+  Thread producer([&]() {
+    for (uint32_t i = 0; i < kCount; ++i) {
+      queue.WriteRaw(reinterpret_cast<const uint8_t*>(&i));
+    }
+  });
+  uint32_t expected = 0;
+  while (expected < kCount) {
+    uint32_t value;
+    if (queue.ReadRaw(reinterpret_cast<uint8_t*>(&value))) {
+      ASSERT_EQ(value, expected);
+      ++expected;
+    }
+  }
+  producer.Join();
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(JitChannelQueueManagerTest, CreateLockFree) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * streaming,
+      package.CreateStreamingChannel("streaming", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * single_value,
+      package.CreateSingleValueChannel("single_value", ChannelOps::kSendReceive,
+                                       package.GetBitsType(32)));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<JitChannelQueueManager> manager,
+      JitChannelQueueManager::CreateLockFree(
+          &package, std::make_unique<JitRuntime>(
+                        GetJitRuntime()->data_layout())));
+
+  EXPECT_NE(dynamic_cast<LockFreeJitChannelQueue*>(
+                &manager->GetJitQueue(streaming)),
+            nullptr);
+  EXPECT_NE(dynamic_cast<ThreadSafeJitChannelQueue*>(
+                &manager->GetJitQueue(single_value)),
+            nullptr);
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,119 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "llvm/include/llvm/Config/llvm-config.h"
+#include "llvm/include/llvm/IR/LLVMContext.h"
+#include "openssl/sha.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/package.h"
+#include "xls/jit/aot_entrypoint.pb.h"
+#include "xls/jit/aot_entrypoint_utils.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/llvm_type_converter.h"
+
+namespace xls {
+/* static */ absl::StatusOr<std::unique_ptr<JitObjectCache>>
+JitObjectCache::Create(const std::filesystem::path& directory) {
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(directory));
+  return std::unique_ptr<JitObjectCache>(new JitObjectCache(directory));
+}
+
+/* static */ std::string JitObjectCache::ComputeKey(
+    FunctionBase* top, int64_t opt_level, bool include_msan,
+    std::string_view target_triple) {
+  // The whole package is hashed rather than just the transitive callees of
+  // 'top' since procs and blocks also depend on channels and instantiations.
+  std::string preimage = absl::StrFormat(
+      "version: %d\nllvm: %s\ntriple: %s\nopt_level: %d\nmsan: %d\ntop: %s\n%s",
+      kFormatVersion, LLVM_VERSION_STRING, target_triple, opt_level,
+      include_msan, top->name(), top->package()->DumpIr());
+  std::array<char, SHA256_DIGEST_LENGTH> digest;
+  SHA256(reinterpret_cast<const uint8_t*>(preimage.data()), preimage.size(),
+         reinterpret_cast<uint8_t*>(digest.data()));
+  return absl::BytesToHexString({digest.data(), digest.size()});
+}
+
+std::filesystem::path JitObjectCache::ObjectPath(std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".o");
+}
+
+std::filesystem::path JitObjectCache::EntrypointsPath(
+    std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".entrypoints.pb");
+}
+
+absl::StatusOr<std::optional<CachedJitObject>> JitObjectCache::Lookup(
+    std::string_view key) {
+  // The entrypoints are written last so their presence marks a complete entry.
+  if (!FileExists(EntrypointsPath(key)).ok()) {
+    return std::nullopt;
+  }
+  CachedJitObject result;
+  XLS_RETURN_IF_ERROR(
+      ParseProtobinFile(EntrypointsPath(key), &result.entrypoints));
+  XLS_ASSIGN_OR_RETURN(std::string object_code,
+                       GetFileContents(ObjectPath(key)));
+  result.object_code =
+      std::vector<uint8_t>(object_code.begin(), object_code.end());
+  VLOG(1) << "JIT object cache hit for " << key;
+  return result;
+}
+
+absl::StatusOr<CachedJitObject> JitObjectCache::Store(
+    std::string_view key, const JitObjectCode& object_code, Package* package,
+    bool include_msan) {
+  CachedJitObject result;
+  result.object_code = object_code.object_code;
+  *result.entrypoints.mutable_data_layout() =
+      object_code.data_layout.getStringRepresentation();
+  llvm::LLVMContext context;
+  LlvmTypeConverter type_converter(&context, object_code.data_layout);
+  for (const FunctionEntrypoint& entrypoint : object_code.entrypoints) {
+    XLS_ASSIGN_OR_RETURN(
+        *result.entrypoints.add_entrypoint(),
+        GenerateAotEntrypointProto(
+            object_code.package ? object_code.package.get() : package,
+            entrypoint, include_msan, type_converter));
+  }
+
+  XLS_RETURN_IF_ERROR(AtomicallySetFileContents(
+      ObjectPath(key),
+      std::string_view(reinterpret_cast<const char*>(result.object_code.data()),
+                       result.object_code.size())));
+  XLS_RETURN_IF_ERROR(AtomicallySetFileContents(
+      EntrypointsPath(key), result.entrypoints.SerializeAsString()));
+  VLOG(1) << "Stored JIT object cache entry " << key;
+  return result;
+}
+
+}  // namespace xls
@@ -0,0 +1,90 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_JIT_OBJECT_CACHE_H_
+#define XLS_JIT_JIT_OBJECT_CACHE_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/ir/function_base.h"
+#include "xls/jit/aot_entrypoint.pb.h"
+#include "xls/jit/function_base_jit.h"
+
+namespace xls {
+
+// An object file previously produced by one of the `CreateObjectCode`
+// functions along with the description of the entrypoints it contains.
+struct CachedJitObject {
+  std::vector<uint8_t> object_code;
+  AotPackageEntrypointsProto entrypoints;
+};
+
+// A persistent on-disk cache of JIT object code. Entries are keyed by a hash of
+// the IR, the optimization level and the target; the cached object code can be
+// loaded into an OrcJit and wrapped with JittedFunctionBase::BuildFromAot
+// without invoking LLVM again.
+//
+// Entries are written to a temporary file and renamed into place so concurrent
+// processes sharing a cache directory never observe partially written entries.
+// The cache is never pruned; stale entries are simply never looked up again.
+class JitObjectCache {
+ public:
+  // Bumped whenever the layout of cached entries or the code generated for a
+  // given IR changes in a way the key would not otherwise capture.
+  static constexpr int64_t kFormatVersion = 1;
+
+  // Creates a cache backed by the given directory, creating it if needed.
+  static absl::StatusOr<std::unique_ptr<JitObjectCache>> Create(
+      const std::filesystem::path& directory);
+
+  // Returns the cache key for compiling 'top' (and everything in its package)
+  // with the given options for the given target.
+  static std::string ComputeKey(FunctionBase* top, int64_t opt_level,
+                                bool include_msan,
+                                std::string_view target_triple);
+
+  // Returns the entry stored under 'key' or std::nullopt if there is none.
+  absl::StatusOr<std::optional<CachedJitObject>> Lookup(std::string_view key);
+
+  // Stores the given object code under 'key' and returns the stored entry.
+  // 'package' is the package the entrypoints were compiled from; it is ignored
+  // if 'object_code' carries its own package.
+  absl::StatusOr<CachedJitObject> Store(std::string_view key,
+                                        const JitObjectCode& object_code,
+                                        Package* package, bool include_msan);
+
+  const std::filesystem::path& directory() const { return directory_; }
+
+ private:
+  explicit JitObjectCache(std::filesystem::path directory)
+      : directory_(std::move(directory)) {}
+
+  std::filesystem::path ObjectPath(std::string_view key) const;
+  std::filesystem::path EntrypointsPath(std::string_view key) const;
+
+  std::filesystem::path directory_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_JIT_OBJECT_CACHE_H_
@@ -0,0 +1,115 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::testing::Ne;
+using ::testing::SizeIs;
+
+class JitObjectCacheTest : public IrTestBase {};
+
+TEST_F(JitObjectCacheTest, KeyDependsOnIrAndOptions) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  fb.Add(fb.Param("x", p->GetBitsType(32)), fb.Param("y", p->GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add, fb.Build());
+  FunctionBuilder fb2("other", p.get());
+  fb2.Param("x", p->GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * other, fb2.Build());
+
+  std::string key = JitObjectCache::ComputeKey(add, /*opt_level=*/3,
+                                               /*include_msan=*/false, "x");
+  EXPECT_EQ(key, JitObjectCache::ComputeKey(add, 3, false, "x"));
+  EXPECT_THAT(key, Ne(JitObjectCache::ComputeKey(add, 1, false, "x")));
+  EXPECT_THAT(key, Ne(JitObjectCache::ComputeKey(add, 3, true, "x")));
+  EXPECT_THAT(key, Ne(JitObjectCache::ComputeKey(add, 3, false, "y")));
+  EXPECT_THAT(key, Ne(JitObjectCache::ComputeKey(other, 3, false, "x")));
+}
+
+TEST_F(JitObjectCacheTest, LookupMissingEntry) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<JitObjectCache> cache,
+                           JitObjectCache::Create(temp_dir.path() / "cache"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::optional<CachedJitObject> entry,
+                           cache->Lookup("does_not_exist"));
+  EXPECT_FALSE(entry.has_value());
+}
+
+TEST_F(JitObjectCacheTest, WarmStartReusesObjectCode) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<JitObjectCache> cache,
+                           JitObjectCache::Create(temp_dir.path()));
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+    fn muladd(x: bits[16], y: bits[16], z: bits[16]) -> bits[16] {
+      umul.1: bits[16] = umul(x, y)
+      ret add.2: bits[16] = add(umul.1, z)
+    }
+  )",
+                                                       p.get()));
+  std::vector<Value> args = {Value(UBits(3, 16)), Value(UBits(5, 16)),
+                             Value(UBits(7, 16))};
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> cold,
+                           FunctionJit::CreateWithObjectCache(f, *cache));
+  EXPECT_THAT(DropInterpreterEvents(cold->Run(args)),
+              IsOkAndHolds(Value(UBits(22, 16))));
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<std::filesystem::path> entries,
+                           GetDirectoryEntries(temp_dir.path()));
+  EXPECT_THAT(entries, SizeIs(2));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> warm,
+                           FunctionJit::CreateWithObjectCache(f, *cache));
+  EXPECT_THAT(DropInterpreterEvents(warm->Run(args)),
+              IsOkAndHolds(Value(UBits(22, 16))));
+  XLS_ASSERT_OK_AND_ASSIGN(entries, GetDirectoryEntries(temp_dir.path()));
+  EXPECT_THAT(entries, SizeIs(2));
+
+  // A different opt level produces a separate entry.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<FunctionJit> unoptimized,
+      FunctionJit::CreateWithObjectCache(f, *cache, /*opt_level=*/0));
+  EXPECT_THAT(DropInterpreterEvents(unoptimized->Run(args)),
+              IsOkAndHolds(Value(UBits(22, 16))));
+  XLS_ASSERT_OK_AND_ASSIGN(entries, GetDirectoryEntries(temp_dir.path()));
+  EXPECT_THAT(entries, SizeIs(4));
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,6 +14,8 @@
 
 #include "xls/jit/jit_proc_runtime.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -36,8 +38,10 @@
 #include "llvm/include/llvm/Target/TargetMachine.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/parallel_proc_runtime.h"
 #include "xls/interpreter/proc_evaluator.h"
 #include "xls/interpreter/serial_proc_runtime.h"
 #include "xls/ir/package.h"
@@ -81,7 +85,9 @@ class SharedCompiler final : public LlvmCompiler {
                      /*include_observer_callbacks=*/false),
         underlying_(underlying),
         the_module_(underlying_->NewModule(
-            absl::StrFormat("__shared_module_for_%s", name))) {}
+            absl::StrFormat("__shared_module_for_%s", name))) {
+    SetIncludeWideArithmeticCalls(underlying->include_wide_arithmetic_calls());
+  }
 
   bool IsSharedCompilation() const override { return true; }
 
@@ -123,13 +129,16 @@ class SharedCompiler final : public LlvmCompiler {
   std::optional<std::unique_ptr<llvm::Module>> the_module_;
 };
 
-absl::StatusOr<JitObjectCode> GetAotObjectCode(ProcElaboration elaboration,
-                                               bool with_msan,
-                                               JitObserver* observer) {
+absl::StatusOr<JitObjectCode> GetAotObjectCode(
+    ProcElaboration elaboration, bool with_msan, JitObserver* observer,
+    std::optional<std::string> target_cpu,
+    bool include_wide_arithmetic_calls) {
   XLS_ASSIGN_OR_RETURN(
       std::unique_ptr<AotCompiler> compiler,
-      AotCompiler::Create(
-          with_msan, /*opt_level=*/LlvmCompiler::kDefaultOptLevel, observer));
+      AotCompiler::Create(with_msan,
+                          /*opt_level=*/LlvmCompiler::kDefaultOptLevel,
+                          observer, std::move(target_cpu)));
+  compiler->SetIncludeWideArithmeticCalls(include_wide_arithmetic_calls);
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<llvm::TargetMachine> target,
                        compiler->CreateTargetMachine());
   llvm::DataLayout layout = target->createDataLayout();
@@ -233,8 +242,79 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateAotRuntime(
   return std::move(proc_runtime);
 }
 
-absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
-    ProcElaboration elaboration, const EvaluatorOptions& options) {
+// Creates a ProcJit for every proc in the queue manager's elaboration, running
+// up to `options.jit_compile_threads()` compilations at once. The returned
+// evaluators are in the same order as the elaboration's procs.
+absl::StatusOr<std::vector<std::unique_ptr<ProcEvaluator>>>
+CreateProcJitsConcurrently(JitChannelQueueManager* queue_manager,
+                           const EvaluatorOptions& options) {
+  absl::Span<Proc* const> procs = queue_manager->elaboration().procs();
+  int64_t thread_count = options.jit_compile_threads() > 0
+                             ? options.jit_compile_threads()
+                             : int64_t{AvailableCPUs()};
+  thread_count = std::clamp<int64_t>(thread_count, 1, procs.size());
+
+  // Compiling a trace lowers to bits[1] and token types; intern them up front
+  // so the workers only ever read the package's type tables.
+  if (!procs.empty()) {
+    procs.front()->package()->GetBitsType(1);
+    procs.front()->package()->GetTokenType();
+  }
+
+  std::vector<absl::StatusOr<std::unique_ptr<ProcJit>>> results;
+  results.reserve(procs.size());
+  for (int64_t i = 0; i < procs.size(); ++i) {
+    results.push_back(absl::UnknownError("ProcJit not created"));
+  }
+  auto create_one = [&](int64_t i) {
+    results[i] = ProcJit::Create(
+        procs[i], &queue_manager->runtime(), queue_manager,
+        /*include_observer_callbacks=*/options.support_observers(),
+        /*observer=*/nullptr,
+        /*packed_state=*/options.jit_packed_state(),
+        /*include_node_coverage=*/options.jit_node_coverage());
+  };
+  if (thread_count <= 1) {
+    for (int64_t i = 0; i < procs.size(); ++i) {
+      create_one(i);
+    }
+  } else {
+    std::atomic<int64_t> next_proc = 0;
+    std::vector<std::unique_ptr<Thread>> threads;
+    threads.reserve(thread_count);
+    for (int64_t t = 0; t < thread_count; ++t) {
+      threads.push_back(std::make_unique<Thread>([&]() {
+        for (int64_t i = next_proc.fetch_add(1); i < procs.size();
+             i = next_proc.fetch_add(1)) {
+          create_one(i);
+        }
+      }));
+    }
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+  }
+
+  std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
+  proc_jits.reserve(procs.size());
+  for (absl::StatusOr<std::unique_ptr<ProcJit>>& result : results) {
+    XLS_RETURN_IF_ERROR(result.status());
+    proc_jits.push_back(*std::move(result));
+  }
+  return proc_jits;
+}
+
+struct ProcJitsAndQueues {
+  std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
+  std::unique_ptr<JitChannelQueueManager> queue_manager;
+};
+
+// If `lock_free_queues` is true, single-producer single-consumer streaming
+// channels use LockFreeJitChannelQueues. This requires that each proc instance
+// is ticked by at most one thread at a time.
+absl::StatusOr<ProcJitsAndQueues> CreateProcJitsAndQueues(
+    ProcElaboration elaboration, const EvaluatorOptions& options,
+    bool lock_free_queues) {
   // We use the compiler to know the data layout.
   XLS_ASSIGN_OR_RETURN(
       std::unique_ptr<OrcJit> comp,
@@ -244,26 +324,38 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout layout, comp->CreateDataLayout());
   // Create a queue manager for the queues. This factory verifies that there an
   // receive only queue for every receive only channel.
+  ProcJitsAndQueues result;
+  auto runtime = std::make_unique<JitRuntime>(layout);
+  if (lock_free_queues) {
+    XLS_ASSIGN_OR_RETURN(result.queue_manager,
+                         JitChannelQueueManager::CreateLockFree(
+                             std::move(elaboration), std::move(runtime)));
+  } else {
+    XLS_ASSIGN_OR_RETURN(result.queue_manager,
+                         JitChannelQueueManager::CreateThreadSafe(
+                             std::move(elaboration), std::move(runtime)));
+  }
+
+  // Create a ProcJit for each Proc. Each ProcJit owns an independent OrcJit so
+  // the LLVM compiles can proceed concurrently.
   XLS_ASSIGN_OR_RETURN(
-      std::unique_ptr<JitChannelQueueManager> queue_manager,
-      JitChannelQueueManager::CreateThreadSafe(
-          std::move(elaboration), std::make_unique<JitRuntime>(layout)));
+      result.proc_jits,
+      CreateProcJitsConcurrently(result.queue_manager.get(), options));
+  return result;
+}
 
-  // Create a ProcJit for each Proc.
-  std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
-  for (Proc* proc : queue_manager->elaboration().procs()) {
-    XLS_ASSIGN_OR_RETURN(
-        std::unique_ptr<ProcJit> proc_jit,
-        ProcJit::Create(
-            proc, &queue_manager->runtime(), queue_manager.get(),
-            /*include_observer_callbacks=*/options.support_observers()));
-    proc_jits.push_back(std::move(proc_jit));
-  }
+absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
+    ProcElaboration elaboration, const EvaluatorOptions& options) {
+  XLS_ASSIGN_OR_RETURN(
+      ProcJitsAndQueues jits_and_queues,
+      CreateProcJitsAndQueues(std::move(elaboration), options,
+                              /*lock_free_queues=*/false));
 
   // Create a runtime.
   XLS_ASSIGN_OR_RETURN(
       std::unique_ptr<SerialProcRuntime> proc_runtime,
-      SerialProcRuntime::Create(std::move(proc_jits), std::move(queue_manager),
+      SerialProcRuntime::Create(std::move(jits_and_queues.proc_jits),
+                                std::move(jits_and_queues.queue_manager),
                                 options));
 
   XLS_RETURN_IF_ERROR(InsertInitialChannelValues(
@@ -271,6 +363,26 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateRuntime(
   return std::move(proc_runtime);
 }
 
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>> CreateParallelRuntime(
+    ProcElaboration elaboration, const EvaluatorOptions& options,
+    int64_t thread_count) {
+  XLS_ASSIGN_OR_RETURN(
+      ProcJitsAndQueues jits_and_queues,
+      CreateProcJitsAndQueues(std::move(elaboration), options,
+                              /*lock_free_queues=*/true));
+
+  // Create a runtime.
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<ParallelProcRuntime> proc_runtime,
+      ParallelProcRuntime::Create(std::move(jits_and_queues.proc_jits),
+                                  std::move(jits_and_queues.queue_manager),
+                                  options, thread_count));
+
+  XLS_RETURN_IF_ERROR(InsertInitialChannelValues(
+      proc_runtime->elaboration(), proc_runtime->queue_manager()));
+  return std::move(proc_runtime);
+}
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
@@ -287,18 +399,39 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
   return CreateRuntime(std::move(elaboration), options);
 }
 
-absl::StatusOr<JitObjectCode> CreateProcAotObjectCode(Package* package,
-                                                      bool with_msan,
-                                                      JitObserver* observer) {
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+CreateJitParallelProcRuntime(Package* package, const EvaluatorOptions& options,
+                             int64_t thread_count) {
+  XLS_ASSIGN_OR_RETURN(ProcElaboration elaboration,
+                       ProcElaboration::ElaborateOldStylePackage(package));
+  return CreateParallelRuntime(std::move(elaboration), options, thread_count);
+}
+
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+CreateJitParallelProcRuntime(Proc* top, const EvaluatorOptions& options,
+                             int64_t thread_count) {
+  XLS_ASSIGN_OR_RETURN(ProcElaboration elaboration,
+                       ProcElaboration::Elaborate(top));
+  return CreateParallelRuntime(std::move(elaboration), options, thread_count);
+}
+
+absl::StatusOr<JitObjectCode> CreateProcAotObjectCode(
+    Package* package, bool with_msan, JitObserver* observer,
+    std::optional<std::string> target_cpu,
+    bool include_wide_arithmetic_calls) {
   XLS_ASSIGN_OR_RETURN(ProcElaboration elaboration,
                        ProcElaboration::ElaborateOldStylePackage(package));
-  return GetAotObjectCode(std::move(elaboration), with_msan, observer);
+  return GetAotObjectCode(std::move(elaboration), with_msan, observer,
+                          std::move(target_cpu), include_wide_arithmetic_calls);
 }
-absl::StatusOr<JitObjectCode> CreateProcAotObjectCode(Proc* top, bool with_msan,
-                                                      JitObserver* observer) {
+absl::StatusOr<JitObjectCode> CreateProcAotObjectCode(
+    Proc* top, bool with_msan, JitObserver* observer,
+    std::optional<std::string> target_cpu,
+    bool include_wide_arithmetic_calls) {
   XLS_ASSIGN_OR_RETURN(ProcElaboration elaboration,
                        ProcElaboration::Elaborate(top));
-  return GetAotObjectCode(std::move(elaboration), with_msan, observer);
+  return GetAotObjectCode(std::move(elaboration), with_msan, observer,
+                          std::move(target_cpu), include_wide_arithmetic_calls);
 }
 
 // Create a SerialProcRuntime composed of ProcJits. Constructed from the
@@ -15,12 +15,15 @@
 #ifndef XLS_JIT_JIT_PROC_RUNTIME_H_
 #define XLS_JIT_JIT_PROC_RUNTIME_H_
 
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "xls/interpreter/evaluator_options.h"
+#include "xls/interpreter/parallel_proc_runtime.h"
 #include "xls/interpreter/serial_proc_runtime.h"
 #include "xls/ir/package.h"
 #include "xls/ir/xls_ir_interface.pb.h"
@@ -40,6 +43,21 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
     Proc* top, const EvaluatorOptions& options = EvaluatorOptions());
 
+// Create a ParallelProcRuntime composed of ProcJits which ticks procs on
+// `thread_count` worker threads (one per CPU if zero). Supports old-style
+// procs.
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+CreateJitParallelProcRuntime(
+    Package* package, const EvaluatorOptions& options = EvaluatorOptions(),
+    int64_t thread_count = 0);
+
+// Create a ParallelProcRuntime composed of ProcJits. Constructed from the
+// elaboration of the given proc. Supports new-style procs.
+absl::StatusOr<std::unique_ptr<ParallelProcRuntime>>
+CreateJitParallelProcRuntime(
+    Proc* top, const EvaluatorOptions& options = EvaluatorOptions(),
+    int64_t thread_count = 0);
+
 struct ProcAotEntrypoints {
   // What proc these entrypoints are associated with.
   PackageInterfaceProto::Proc proc_interface_proto;
@@ -69,12 +87,19 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateAotSerialProcRuntime(
     absl::Span<ProcAotEntrypoints const> impls,
     const EvaluatorOptions& options = EvaluatorOptions());
 
-// Generate AOT code for the given proc elaboration.
+// Generate AOT code for the given proc elaboration. See AotCompiler::Create for
+// the meaning of `target_cpu` and LlvmCompiler::SetIncludeWideArithmeticCalls
+// for that of `include_wide_arithmetic_calls`, which must be false for code
+// run by a standalone network (see aot_standalone.h).
 absl::StatusOr<JitObjectCode> CreateProcAotObjectCode(
-    Package* package, bool with_msan, JitObserver* observer = nullptr);
+    Package* package, bool with_msan, JitObserver* observer = nullptr,
+    std::optional<std::string> target_cpu = std::nullopt,
+    bool include_wide_arithmetic_calls = true);
 // Generate AOT code for the given proc elaboration.
 absl::StatusOr<JitObjectCode> CreateProcAotObjectCode(
-    Proc* top, bool with_msan, JitObserver* observer = nullptr);
+    Proc* top, bool with_msan, JitObserver* observer = nullptr,
+    std::optional<std::string> target_cpu = std::nullopt,
+    bool include_wide_arithmetic_calls = true);
 
 }  // namespace xls
 
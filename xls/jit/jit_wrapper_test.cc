@@ -17,12 +17,14 @@
 #include <cstdint>
 #include <optional>
 #include <string_view>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/algorithm/container.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 #include "xls/dslx/stdlib/float32_mul_jit_wrapper.h"
 #include "xls/dslx/stdlib/tests/float32_upcast_jit_wrapper.h"
@@ -108,6 +110,19 @@ TEST(JitWrapperTest, PackedFunctionCall2) {
   EXPECT_EQ(rv, 1.2345f);
 }
 
+TEST(JitWrapperTest, BatchFunctionCall) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, fp::Float32Mul::Create());
+  std::vector<fp::Float32Mul::Input> inputs = {
+      {3.14f, 1.2345f}, {-2.0f, 0.5f}, {0.0f, 7.0f}};
+  std::vector<float> results(inputs.size());
+  XLS_ASSERT_OK(jit->RunBatch(inputs, absl::MakeSpan(results)));
+  EXPECT_THAT(results, ElementsAre(3.14f * 1.2345f, -1.0f, 0.0f));
+
+  std::vector<float> too_few_results(1);
+  EXPECT_THAT(jit->RunBatch(inputs, absl::MakeSpan(too_few_results)),
+              absl_testing::StatusIs(absl::StatusCode::kInternal));
+}
+
 std::array<uint8_t, 8> StrArray(std::string_view sv) {
   EXPECT_EQ(sv.size(), 8);
   std::array<uint8_t, 8> ret;
@@ -205,6 +220,23 @@ TEST(JitWrapperTest, ProcTickUnitlBlocked) {
   EXPECT_THAT(jit->ReceiveFromStringOutput(), IsOkAndHolds(std::nullopt));
 }
 
+TEST(JitWrapperTest, ProcBatchSendAndReceive) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto jit, examples::SomeCaps::Create());
+  std::vector<std::array<uint8_t, 8>> inputs = {
+      StrArray("abcdefgh"), StrArray("ijklmnop"), StrArray("qrstuvwx")};
+  XLS_ASSERT_OK(jit->SendManyToStringInput(inputs));
+  XLS_ASSERT_OK(jit->TickUntilBlocked());
+
+  std::vector<std::array<uint8_t, 8>> outputs(4);
+  EXPECT_THAT(jit->ReceiveManyFromStringOutput(absl::MakeSpan(outputs)),
+              IsOkAndHolds(3));
+  EXPECT_THAT(absl::MakeSpan(outputs).first(3),
+              ElementsAre(StrArray("ABCDEFGH"), StrArray("ijklmnop"),
+                          StrArray("QrStUvWx")));
+  EXPECT_THAT(jit->ReceiveManyFromStringOutputAsValues(/*max_count=*/4),
+              IsOkAndHolds(IsEmpty()));
+}
+
 TEST(JitWrapperTest, ProcOptIrWrapper) {
   XLS_ASSERT_OK_AND_ASSIGN(auto jit, examples::SomeCapsOpt::Create());
   XLS_ASSERT_OK(
@@ -20,16 +20,26 @@
 #include <string>
 #include <string_view>
 #include <system_error>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "absl/base/call_once.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "llvm/include/llvm-c/Target.h"
+#include "llvm/include/llvm/ADT/SmallVector.h"
+#include "llvm/include/llvm/ADT/StringRef.h"
 #include "llvm/include/llvm/Analysis/CGSCCPassManager.h"
 #include "llvm/include/llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/include/llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/include/llvm/IR/Argument.h"
 #include "llvm/include/llvm/IR/BasicBlock.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
@@ -43,10 +53,23 @@
 #include "llvm/include/llvm/Support/Error.h"
 #include "llvm/include/llvm/Support/raw_ostream.h"
 #include "llvm/include/llvm/Target/TargetMachine.h"
+#include "llvm/include/llvm/TargetParser/SubtargetFeature.h"
+#include "llvm/include/llvm/TargetParser/Triple.h"
+#include "llvm/include/llvm/TargetParser/X86TargetParser.h"
+#include "llvm/include/llvm/Transforms/IPO/GlobalDCE.h"
+#include "llvm/include/llvm/Transforms/IPO/Inliner.h"
+#include "llvm/include/llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/include/llvm/Transforms/Instrumentation/MemorySanitizer.h"
+#include "llvm/include/llvm/Transforms/Scalar/DeadStoreElimination.h"
+#include "llvm/include/llvm/Transforms/Scalar/EarlyCSE.h"
+#include "llvm/include/llvm/Transforms/Scalar/GVN.h"
+#include "llvm/include/llvm/Transforms/Scalar/MemCpyOptimizer.h"
+#include "llvm/include/llvm/Transforms/Scalar/SROA.h"
+#include "llvm/include/llvm/Transforms/Scalar/SimplifyCFG.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/jit/observer.h"
 
 namespace xls {
 
@@ -66,6 +89,80 @@ std::string LlvmCompiler::target_triple() const {
 
 void LlvmCompiler::InitializeLlvm() { absl::call_once(once, OnceInit); }
 
+/* static */ absl::StatusOr<bool> LlvmCompiler::HostSupportsTargetCpu(
+    std::string_view cpu) {
+  if (cpu == kHostCpu) {
+    return true;
+  }
+  if (llvm::X86::parseArchX86(cpu, /*Only64Bit=*/true) ==
+      llvm::X86::CK_None) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown x86-64 target CPU: ", cpu));
+  }
+  auto error_or_host = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!error_or_host) {
+    return absl::InternalError(
+        absl::StrCat("Unable to detect host: ",
+                     llvm::toString(error_or_host.takeError())));
+  }
+  if (error_or_host->getTargetTriple().getArch() != llvm::Triple::x86_64) {
+    return false;
+  }
+  // The detected features list every feature known for the host as either
+  // "+feature" or "-feature". Only features the host explicitly lacks make
+  // the target unsupported.
+  absl::flat_hash_set<std::string> missing_features;
+  for (const std::string& feature :
+       error_or_host->getFeatures().getFeatures()) {
+    if (!feature.empty() && feature[0] == '-') {
+      missing_features.insert(feature.substr(1));
+    }
+  }
+  llvm::SmallVector<llvm::StringRef, 32> cpu_features;
+  llvm::X86::getFeaturesForCPU(cpu, cpu_features, /*NeedPlus=*/false);
+  for (llvm::StringRef feature : cpu_features) {
+    if (missing_features.contains(std::string_view(feature))) {
+      VLOG(1) << "Host does not support feature " << feature.str()
+              << " of target CPU " << cpu;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* static */ absl::Status LlvmCompiler::SetTargetCpu(
+    llvm::orc::JITTargetMachineBuilder& builder, std::string_view cpu) {
+  if (cpu == kHostCpu) {
+    return absl::OkStatus();
+  }
+  switch (builder.getTargetTriple().getArch()) {
+    case llvm::Triple::x86_64: {
+      if (llvm::X86::parseArchX86(cpu, /*Only64Bit=*/true) ==
+          llvm::X86::CK_None) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Unknown x86-64 target CPU: ", cpu));
+      }
+      builder.setCPU(std::string(cpu));
+      // Replace the host features with those available on the target CPU.
+      builder.getFeatures() = llvm::SubtargetFeatures();
+      llvm::SmallVector<llvm::StringRef, 32> cpu_features;
+      llvm::X86::getFeaturesForCPU(cpu, cpu_features, /*NeedPlus=*/true);
+      builder.addFeatures(
+          std::vector<std::string>(cpu_features.begin(), cpu_features.end()));
+      return absl::OkStatus();
+    }
+    case llvm::Triple::aarch64:
+      // The AArch64 backend derives the features from the CPU name.
+      builder.setCPU(std::string(cpu));
+      builder.getFeatures() = llvm::SubtargetFeatures();
+      return absl::OkStatus();
+    default:
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Target CPUs can't be selected on host architecture ",
+          std::string_view(builder.getTargetTriple().getArchName())));
+  }
+}
+
 absl::StatusOr<llvm::DataLayout> LlvmCompiler::CreateDataLayout() {
   LlvmCompiler::InitializeLlvm();
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<llvm::TargetMachine> target_machine,
@@ -134,8 +231,60 @@ char BadOptLevelError::ID;
 
 }  // namespace
 
+std::string_view LlvmPipelineToString(LlvmPipeline pipeline) {
+  switch (pipeline) {
+    case LlvmPipeline::kStandard:
+      return "standard";
+    case LlvmPipeline::kXls:
+      return "xls";
+    case LlvmPipeline::kXlsReduced:
+      return "xls-reduced";
+  }
+  LOG(FATAL) << "Invalid LLVM pipeline: " << static_cast<int>(pipeline);
+}
+
+namespace {
+
+// Builds the kXls or kXlsReduced pipeline. Node functions are private and
+// called once so inlining them all is cheap, and everything after works on
+// straight-line code in the partition functions.
+llvm::ModulePassManager BuildXlsPipeline(bool reduced, bool include_msan) {
+  llvm::ModulePassManager mpm;
+  if (include_msan) {
+    mpm.addPass(llvm::MemorySanitizerPass(llvm::MemorySanitizerOptions()));
+  }
+  mpm.addPass(llvm::ModuleInlinerWrapperPass());
+
+  llvm::FunctionPassManager fpm;
+  fpm.addPass(llvm::SROAPass(llvm::SROAOptions::ModifyCFG));
+  fpm.addPass(llvm::EarlyCSEPass(/*UseMemorySSA=*/true));
+  if (!reduced) {
+    fpm.addPass(llvm::InstCombinePass());
+    fpm.addPass(llvm::MemCpyOptPass());
+    fpm.addPass(llvm::GVNPass());
+    fpm.addPass(llvm::DSEPass());
+    fpm.addPass(llvm::InstCombinePass());
+  }
+  fpm.addPass(llvm::SimplifyCFGPass());
+  mpm.addPass(llvm::createModuleToFunctionPassAdaptor(std::move(fpm)));
+  mpm.addPass(llvm::GlobalDCEPass());
+  return mpm;
+}
+
+}  // namespace
+
 llvm::Error LlvmCompiler::PerformStandardOptimization(
-    llvm::Module* bare_module) {
+    llvm::Module* bare_module, JitOptimizationStats* stats) {
+  absl::Time start = absl::Now();
+  int64_t instructions_before = bare_module->getInstructionCount();
+  LlvmPipeline pipeline = llvm_pipeline_;
+  if (instructions_before > optimization_budget_) {
+    VLOG(1) << "Module of " << instructions_before
+            << " instructions is over the optimization budget of "
+            << optimization_budget_;
+    pipeline = LlvmPipeline::kXlsReduced;
+  }
+
   // Follow the directions at llvm.org/docs/NewPassManager.html to run the
   // initial architecture independent opt passes
   llvm::CGSCCAnalysisManager cgam;
@@ -180,10 +329,24 @@ llvm::Error LlvmCompiler::PerformStandardOptimization(
   llvm::ModulePassManager mpm;
   if (llvm_opt_level == llvm::OptimizationLevel::O0) {
     mpm = pass_builder.buildO0DefaultPipeline(llvm_opt_level);
-  } else {
+  } else if (pipeline == LlvmPipeline::kStandard) {
     mpm = pass_builder.buildPerModuleDefaultPipeline(llvm_opt_level);
+  } else {
+    // The pipeline start callback only applies to the default pipelines.
+    mpm = BuildXlsPipeline(pipeline == LlvmPipeline::kXlsReduced,
+                           include_msan_);
   }
   mpm.run(*bare_module, mam);
+
+  if (stats != nullptr) {
+    *stats = JitOptimizationStats{
+        .pipeline = absl::StrFormat("%s O%d", LlvmPipelineToString(pipeline),
+                                    opt_level_),
+        .instructions_before = instructions_before,
+        .instructions_after = bare_module->getInstructionCount(),
+        .optimization_time = absl::Now() - start,
+    };
+  }
   return llvm::Error::success();
 }
 
@@ -16,6 +16,7 @@
 #define XLS_JIT_LLVM_COMPILER_H_
 
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -27,23 +28,55 @@
 #include "llvm/include/llvm/Support/Error.h"
 #include "llvm/include/llvm/Support/raw_ostream.h"
 #include "llvm/include/llvm/Target/TargetMachine.h"
+#include "xls/jit/observer.h"
 
 // LLVM is so huge that it noticeably slows down code completion. Don't have
 // includes in the header to avoid this issue as much as possible.
 namespace llvm {
 class LLVMContext;
 class Module;
+namespace orc {
+class JITTargetMachineBuilder;
+}  // namespace orc
 }  // namespace llvm
 namespace xls {
 
 class AotCompiler;
 class OrcJit;
 
+// The LLVM optimization pipeline run on the modules the JIT generates.
+enum class LlvmPipeline : uint8_t {
+  // LLVM's default per-module pipeline for the opt level.
+  kStandard,
+  // A pipeline for the code the JIT emits: straight-line partition functions
+  // calling one small node function per XLS node. It inlines the node functions
+  // and cleans up with scalar passes (SROA, CSE, instcombine, GVN, dead store
+  // elimination), skipping the loop, vectorizer and interprocedural passes of
+  // the standard pipeline which find little to do in such code.
+  kXls,
+  // The inliner, SROA, early CSE and CFG simplification only. Compiles much
+  // faster than kXls at some cost in the quality of the generated code.
+  kXlsReduced,
+};
+
+std::string_view LlvmPipelineToString(LlvmPipeline pipeline);
+
 class LlvmCompiler {
  public:
   static constexpr int64_t kDefaultOptLevel = 3;
+  static constexpr int64_t kUnlimitedOptimizationBudget =
+      std::numeric_limits<int64_t>::max();
+  // Target CPU name which selects the CPU of the running process along with
+  // every feature it supports.
+  static constexpr std::string_view kHostCpu = "native";
   static void InitializeLlvm();
 
+  // Returns whether code compiled for the given target CPU (e.g., "haswell"
+  // or "x86-64-v4") can run on the CPU of this process, i.e., whether the
+  // host supports every feature the target CPU implies. Only x86-64 CPU names
+  // can be checked; other names are an error.
+  static absl::StatusOr<bool> HostSupportsTargetCpu(std::string_view cpu);
+
   virtual ~LlvmCompiler() = default;
 
   virtual absl::StatusOr<OrcJit*> AsOrcJit() {
@@ -92,6 +125,42 @@ class LlvmCompiler {
     return include_observer_callbacks_;
   }
 
+  // If set, code compiled after this call times the evaluation of each node
+  // and accumulates the results in the buffer returned by the
+  // GetNodeProfileCounters callback. See node_profile.h.
+  void SetIncludeNodeProfiling(bool value) { include_node_profiling_ = value; }
+  bool include_node_profiling() const { return include_node_profiling_; }
+
+  // If set, code compiled after this call ORs the value of each node into the
+  // buffer returned by the GetNodeCoverageBits callback so that it records
+  // every bit which was ever set. See node_coverage.h.
+  void SetIncludeNodeCoverage(bool value) { include_node_coverage_ = value; }
+  bool include_node_coverage() const { return include_node_coverage_; }
+
+  // If cleared, code compiled after this call leaves multiplications and
+  // divisions wider than 128 bits to LLVM rather than calling the
+  // WideArithmetic callback. Code run without the XLS runtime (see
+  // aot_standalone.h) has no implementation of the callback.
+  void SetIncludeWideArithmeticCalls(bool value) {
+    include_wide_arithmetic_calls_ = value;
+  }
+  bool include_wide_arithmetic_calls() const {
+    return include_wide_arithmetic_calls_;
+  }
+
+  // Selects the pipeline which optimizes modules compiled after this call.
+  // Opt level 0 runs LLVM's O0 pipeline whatever pipeline is selected.
+  void SetLlvmPipeline(LlvmPipeline pipeline) { llvm_pipeline_ = pipeline; }
+  LlvmPipeline llvm_pipeline() const { return llvm_pipeline_; }
+
+  // Modules of more than `instruction_count` LLVM instructions are optimized
+  // with LlvmPipeline::kXlsReduced instead of the selected pipeline, bounding
+  // the compile time of huge (e.g., fully unrolled) functions.
+  void SetOptimizationBudget(int64_t instruction_count) {
+    optimization_budget_ = instruction_count;
+  }
+  int64_t optimization_budget() const { return optimization_budget_; }
+
  protected:
   absl::Status Init();
 
@@ -99,7 +168,15 @@ class LlvmCompiler {
 
   absl::Status VerifyModule(const llvm::Module& module);
 
-  llvm::Error PerformStandardOptimization(llvm::Module* module);
+  // Configures `builder`, created by detecting the host, to generate code for
+  // the given CPU using exactly the features that CPU implies. kHostCpu leaves
+  // the detected CPU and features in place.
+  static absl::Status SetTargetCpu(llvm::orc::JITTargetMachineBuilder& builder,
+                                   std::string_view cpu);
+
+  // Runs the selected pipeline on `module`, filling in `stats` if given.
+  llvm::Error PerformStandardOptimization(
+      llvm::Module* module, JitOptimizationStats* stats = nullptr);
 
   LlvmCompiler(int64_t opt_level, bool include_msan,
                bool include_observer_callbacks)
@@ -132,6 +209,14 @@ class LlvmCompiler {
   // callback.
   const bool include_observer_callbacks_;
 
+  // If the jitted code should accumulate per-node cycle counts.
+  bool include_node_profiling_ = false;
+  bool include_node_coverage_ = false;
+  bool include_wide_arithmetic_calls_ = true;
+
+  LlvmPipeline llvm_pipeline_ = LlvmPipeline::kStandard;
+  int64_t optimization_budget_ = kUnlimitedOptimizationBudget;
+
   bool module_created_ = false;
 };
 
@@ -0,0 +1,42 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_NODE_COVERAGE_H_
+#define XLS_JIT_NODE_COVERAGE_H_
+
+#include <cstdint>
+
+#include "xls/ir/node.h"
+
+namespace xls {
+
+// An IR node whose values are accumulated by JIT code compiled with node
+// coverage enabled (see LlvmCompiler::SetIncludeNodeCoverage).
+//
+// Coverage is a byte buffer passed to the JIT code through
+// InstanceContext::node_coverage_bits. After every evaluation of the node the
+// JIT code ORs the node's value, in the native JIT layout of its type, into the
+// `size` bytes at `offset`. The bytes therefore hold every bit which was ever
+// set in the node's value and can be unpacked like any other value of the
+// node's type. Updating coverage is a handful of branch-free loads and stores
+// per node rather than a call out of the JIT code.
+struct NodeCoverageSite {
+  Node* node;
+  int64_t offset;
+  int64_t size;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_NODE_COVERAGE_H_
@@ -0,0 +1,49 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/node_profile.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+#include "xls/ir/op.h"
+#include "xls/jit/node_profile.pb.h"
+
+namespace xls {
+
+NodeProfileProto BuildNodeProfile(absl::Span<const NodeProfileSite> sites,
+                                  absl::Span<const uint64_t> counters) {
+  CHECK_EQ(counters.size(), sites.size() * kNodeProfileCountersPerSite);
+  NodeProfileProto profile;
+  for (int64_t i = 0; i < sites.size(); ++i) {
+    NodeProfileProto::Entry* entry = profile.add_entries();
+    entry->set_function_name(sites[i].function_name);
+    entry->set_node_id(sites[i].node_id);
+    entry->set_node_name(sites[i].node_name);
+    entry->set_op(OpToString(sites[i].op));
+    entry->set_cycles(counters[kNodeProfileCountersPerSite * i]);
+    entry->set_evaluations(counters[kNodeProfileCountersPerSite * i + 1]);
+  }
+  std::stable_sort(profile.mutable_entries()->begin(),
+                   profile.mutable_entries()->end(),
+                   [](const NodeProfileProto::Entry& a,
+                      const NodeProfileProto::Entry& b) {
+                     return a.cycles() > b.cycles();
+                   });
+  return profile;
+}
+
+}  // namespace xls
@@ -0,0 +1,49 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_NODE_PROFILE_H_
+#define XLS_JIT_NODE_PROFILE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/types/span.h"
+#include "xls/ir/op.h"
+#include "xls/jit/node_profile.pb.h"
+
+namespace xls {
+
+// An IR node whose evaluation is timed by JIT code compiled with node profiling
+// enabled (see LlvmCompiler::SetIncludeNodeProfiling). Sites are numbered in
+// the order they are added to the JitBuilderContext.
+struct NodeProfileSite {
+  std::string function_name;
+  int64_t node_id;
+  std::string node_name;
+  Op op;
+};
+
+// Number of uint64_t counters per site in the counter buffer passed to
+// profiled JIT code through InstanceContext::node_profile_counters. The
+// counters of site `i` are at index `kNodeProfileCountersPerSite * i`: the
+// accumulated cycle count followed by the evaluation count.
+inline constexpr int64_t kNodeProfileCountersPerSite = 2;
+
+// Builds a profile from the counters recorded for the given sites.
+NodeProfileProto BuildNodeProfile(absl::Span<const NodeProfileSite> sites,
+                                  absl::Span<const uint64_t> counters);
+
+}  // namespace xls
+
+#endif  // XLS_JIT_NODE_PROFILE_H_
@@ -43,6 +43,11 @@ JitObserverRequests CompoundJitObserver::GetNotificationOptions() const {
                          [](auto* o) {
                            return o->GetNotificationOptions().assembly_code_str;
                          }),
+      .optimization_stats = absl::c_any_of(
+          observers_,
+          [](auto* o) {
+            return o->GetNotificationOptions().optimization_stats;
+          }),
   };
 }
 void CompoundJitObserver::UnoptimizedModule(const llvm::Module* module) {
@@ -68,6 +73,15 @@ void CompoundJitObserver::AssemblyCodeString(const llvm::Module* module,
   }
 }
 
+void CompoundJitObserver::OptimizationStats(
+    const llvm::Module* module, const JitOptimizationStats& stats) {
+  for (auto* o : observers_) {
+    if (o->GetNotificationOptions().optimization_stats) {
+      o->OptimizationStats(module, stats);
+    }
+  }
+}
+
 void CompoundJitObserver::AddObserver(JitObserver* o) {
   observers_.push_back(o);
 }
@@ -18,10 +18,12 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xls/interpreter/observer.h"
 #include "xls/ir/node.h"
@@ -45,6 +47,21 @@ struct JitObserverRequests {
   bool optimized_module = false;
   // Do we want to get called with optimized asm code.
   bool assembly_code_str = false;
+  // Do we want to get called with the statistics of each LLVM optimization.
+  bool optimization_stats = false;
+};
+
+// What one run of the LLVM optimization pipeline over a module cost and
+// achieved. The instruction counts are a proxy for the run time of the
+// generated code, to weigh against the compile time spent.
+struct JitOptimizationStats {
+  // The pipeline which ran, e.g., "standard O3" or "xls-reduced O2". A module
+  // over the optimization budget runs the reduced pipeline whatever pipeline
+  // was requested.
+  std::string pipeline;
+  int64_t instructions_before = 0;
+  int64_t instructions_after = 0;
+  absl::Duration optimization_time;
 };
 
 // Basic observer for JIT compilation events
@@ -60,6 +77,9 @@ class JitObserver {
   // Called when a LLVM module has been compiled with the module code.
   virtual void AssemblyCodeString(const llvm::Module* module,
                                   std::string_view asm_code) {}
+  // Called when a LLVM module has been optimized.
+  virtual void OptimizationStats(const llvm::Module* module,
+                                 const JitOptimizationStats& stats) {}
 };
 
 // A compound observer that lets one trigger multiple observers at once.
@@ -72,6 +92,8 @@ class CompoundJitObserver final : public JitObserver {
   void OptimizedModule(const llvm::Module* module) final;
   void AssemblyCodeString(const llvm::Module* module,
                           std::string_view asm_code) final;
+  void OptimizationStats(const llvm::Module* module,
+                         const JitOptimizationStats& stats) final;
 
   void AddObserver(JitObserver* o);
 
@@ -85,6 +107,13 @@ class RuntimeObserver {
  public:
   virtual ~RuntimeObserver() = default;
   virtual void RecordNodeValue(int64_t node_ptr, const uint8_t* data) = 0;
+
+  // Called with the bits accumulated by JIT code compiled with node coverage
+  // (see LlvmCompiler::SetIncludeNodeCoverage) in place of a RecordNodeValue
+  // call for every evaluation. `data` is in the same format as in
+  // RecordNodeValue and has every bit set which was set in any value the node
+  // took since coverage was last reported.
+  virtual void RecordNodeCoverage(int64_t node_ptr, const uint8_t* data) {}
 };
 
 // A translator that lets one easily convert from a jit runtime observer to the
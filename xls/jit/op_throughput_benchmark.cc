@@ -0,0 +1,441 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures the time per evaluation of functions made of a single IR operation
+// (or a small kernel of a few operations) with the IR interpreter and with the
+// different entry points of the function JIT. Marshaling of the arguments and
+// result between Values and the native layout is measured on its own by
+// BM_JitMarshal, so it can be told apart from the execution proper, which is
+// what BM_JitRunWithViews measures.
+//
+// Benchmarks are named by the case index and width, e.g.
+// BM_JitRunWithViews/3/64; the label gives the name of the operation.
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "include/benchmark/benchmark.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/lsb_or_msb.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_buffer.h"
+
+namespace xls {
+namespace {
+
+// Every benchmarked function takes three bits[width] parameters `x`, `y` and
+// `s` (the latter used as a shift amount, index or selector) whether it uses
+// them or not, so all of them can be called the same way.
+using BuildFn =
+    std::function<absl::StatusOr<Function*>(Package* p, int64_t width)>;
+
+struct BenchmarkCase {
+  std::string name;
+  BuildFn build;
+};
+
+// Ops which only exist in procs or blocks and so can't be benchmarked in a
+// function.
+bool IsFunctionOp(Op op) {
+  switch (op) {
+    case Op::kInputPort:
+    case Op::kOutputPort:
+    case Op::kInstantiationInput:
+    case Op::kInstantiationOutput:
+    case Op::kRegisterRead:
+    case Op::kRegisterWrite:
+    case Op::kReceive:
+    case Op::kSend:
+    case Op::kNext:
+    case Op::kStateRead:
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Returns a function `body(i: bits[width], acc: bits[width]) -> bits[width]`
+// to use as the body of loops and the target of invokes.
+Function* AccumulateBody(Package* p, int64_t width) {
+  FunctionBuilder fb("body", p);
+  BValue i = fb.Param("i", p->GetBitsType(width));
+  BValue acc = fb.Param("acc", p->GetBitsType(width));
+  return fb.BuildWithReturnValue(fb.Xor(fb.Add(acc, i), i)).value();
+}
+
+// Builds a function computing `op`. Token-producing ops return their token
+// in a tuple with `x`. The condition of the trace is always false as its
+// events would otherwise accumulate across iterations.
+absl::StatusOr<Function*> BuildOpFunction(Op op, Package* p, int64_t width) {
+  FunctionBuilder fb("f", p);
+  Type* type = p->GetBitsType(width);
+  BValue x = fb.Param("x", type);
+  BValue y = fb.Param("y", type);
+  BValue s = fb.Param("s", type);
+  BValue select_bit = fb.BitSlice(s, 0, 1);
+  BValue array = fb.Array({x, y, s}, type);
+  switch (op) {
+    case Op::kAdd:
+      return fb.BuildWithReturnValue(fb.Add(x, y));
+    case Op::kAfterAll:
+      return fb.BuildWithReturnValue(fb.Tuple({fb.AfterAll({}), x}));
+    case Op::kAnd:
+    case Op::kNand:
+    case Op::kNor:
+    case Op::kOr:
+    case Op::kXor:
+      return fb.BuildWithReturnValue(fb.AddNaryOp(op, {x, y}));
+    case Op::kAndReduce:
+    case Op::kOrReduce:
+    case Op::kXorReduce:
+      return fb.BuildWithReturnValue(fb.AddBitwiseReductionOp(op, x));
+    case Op::kArray:
+      return fb.BuildWithReturnValue(array);
+    case Op::kArrayConcat:
+      return fb.BuildWithReturnValue(fb.ArrayConcat({array, array}));
+    case Op::kArrayIndex:
+      return fb.BuildWithReturnValue(fb.ArrayIndex(array, {s}));
+    case Op::kArraySlice:
+      return fb.BuildWithReturnValue(fb.ArraySlice(array, s, /*width=*/2));
+    case Op::kArrayUpdate:
+      return fb.BuildWithReturnValue(fb.ArrayUpdate(array, x, {s}));
+    case Op::kAssert:
+      return fb.BuildWithReturnValue(fb.Tuple(
+          {fb.Assert(fb.AfterAll({}), fb.Eq(x, x), "assertion failed"), x}));
+    case Op::kBitSlice:
+      return fb.BuildWithReturnValue(fb.BitSlice(x, width / 4, width / 2));
+    case Op::kBitSliceUpdate:
+      return fb.BuildWithReturnValue(
+          fb.BitSliceUpdate(x, s, fb.BitSlice(y, 0, width / 2)));
+    case Op::kConcat:
+      return fb.BuildWithReturnValue(fb.Concat({x, y}));
+    case Op::kCountedFor:
+      return fb.BuildWithReturnValue(fb.CountedFor(
+          x, /*trip_count=*/4, /*stride=*/1, AccumulateBody(p, width)));
+    case Op::kCover:
+      return fb.BuildWithReturnValue(
+          fb.Tuple({fb.Cover(fb.Eq(x, y), "x_eq_y"), x}));
+    case Op::kDecode:
+      return fb.BuildWithReturnValue(fb.Decode(x, /*width=*/width));
+    case Op::kDynamicBitSlice:
+      return fb.BuildWithReturnValue(fb.DynamicBitSlice(x, s, width / 2));
+    case Op::kDynamicCountedFor:
+      return fb.BuildWithReturnValue(fb.DynamicCountedFor(
+          x, /*trip_count=*/fb.BitSlice(s, 0, 2),
+          /*stride=*/fb.Literal(UBits(1, 2)), AccumulateBody(p, width)));
+    case Op::kEncode:
+      return fb.BuildWithReturnValue(fb.Encode(x));
+    case Op::kEq:
+    case Op::kNe:
+    case Op::kSGe:
+    case Op::kSGt:
+    case Op::kSLe:
+    case Op::kSLt:
+    case Op::kUGe:
+    case Op::kUGt:
+    case Op::kULe:
+    case Op::kULt:
+      return fb.BuildWithReturnValue(fb.AddCompareOp(op, x, y));
+    case Op::kGate:
+      return fb.BuildWithReturnValue(fb.Gate(select_bit, x));
+    case Op::kIdentity:
+      return fb.BuildWithReturnValue(fb.Identity(x));
+    case Op::kInvoke:
+      return fb.BuildWithReturnValue(
+          fb.Invoke({x, y}, AccumulateBody(p, width)));
+    case Op::kLiteral:
+      return fb.BuildWithReturnValue(fb.Literal(Bits::AllOnes(width)));
+    case Op::kMap: {
+      FunctionBuilder mapped("mapped", p);
+      mapped.Negate(mapped.Param("e", type));
+      XLS_ASSIGN_OR_RETURN(Function * to_apply, mapped.Build());
+      return fb.BuildWithReturnValue(fb.Map(array, to_apply));
+    }
+    case Op::kMinDelay:
+      return fb.BuildWithReturnValue(
+          fb.Tuple({fb.MinDelay(fb.AfterAll({}), /*delay=*/1), x}));
+    case Op::kNeg:
+      return fb.BuildWithReturnValue(fb.Negate(x));
+    case Op::kNot:
+      return fb.BuildWithReturnValue(fb.Not(x));
+    case Op::kOneHot:
+      return fb.BuildWithReturnValue(fb.OneHot(x, LsbOrMsb::kLsb));
+    case Op::kOneHotSel:
+      return fb.BuildWithReturnValue(
+          fb.OneHotSelect(fb.BitSlice(s, 0, 2), {x, y}));
+    case Op::kParam:
+      return fb.BuildWithReturnValue(x);
+    case Op::kPrioritySel:
+      return fb.BuildWithReturnValue(
+          fb.PrioritySelect(fb.BitSlice(s, 0, 2), {x, y}, s));
+    case Op::kReverse:
+      return fb.BuildWithReturnValue(fb.Reverse(x));
+    case Op::kSDiv:
+      return fb.BuildWithReturnValue(fb.SDiv(x, y));
+    case Op::kSMod:
+      return fb.BuildWithReturnValue(fb.SMod(x, y));
+    case Op::kSMul:
+      return fb.BuildWithReturnValue(fb.SMul(x, y));
+    case Op::kSMulp:
+      return fb.BuildWithReturnValue(fb.SMulp(x, y));
+    case Op::kSel:
+      return fb.BuildWithReturnValue(fb.Select(select_bit, {x, y}));
+    case Op::kShll:
+      return fb.BuildWithReturnValue(fb.Shll(x, s));
+    case Op::kShra:
+      return fb.BuildWithReturnValue(fb.Shra(x, s));
+    case Op::kShrl:
+      return fb.BuildWithReturnValue(fb.Shrl(x, s));
+    case Op::kSignExt:
+      return fb.BuildWithReturnValue(fb.SignExtend(x, 2 * width));
+    case Op::kSub:
+      return fb.BuildWithReturnValue(fb.Subtract(x, y));
+    case Op::kTrace:
+      return fb.BuildWithReturnValue(
+          fb.Tuple({fb.Trace(fb.AfterAll({}), fb.ULt(x, x), {x}, "x: {}"), x}));
+    case Op::kTuple:
+      return fb.BuildWithReturnValue(fb.Tuple({x, y, s}));
+    case Op::kTupleIndex:
+      return fb.BuildWithReturnValue(fb.TupleIndex(fb.Tuple({x, y}), 1));
+    case Op::kUDiv:
+      return fb.BuildWithReturnValue(fb.UDiv(x, y));
+    case Op::kUMod:
+      return fb.BuildWithReturnValue(fb.UMod(x, y));
+    case Op::kUMul:
+      return fb.BuildWithReturnValue(fb.UMul(x, y));
+    case Op::kUMulp:
+      return fb.BuildWithReturnValue(fb.UMulp(x, y));
+    case Op::kZeroExt:
+      return fb.BuildWithReturnValue(fb.ZeroExtend(x, 2 * width));
+    default:
+      return absl::UnimplementedError(
+          absl::StrCat("No function benchmark for op ", OpToString(op)));
+  }
+}
+
+// Small kernels of a few operations typical of datapaths. `$0` is the width
+// and `$1` one less.
+struct Kernel {
+  const char* name;
+  const char* ir;
+};
+constexpr Kernel kKernels[] = {
+    {"kernel_mac",
+     R"(fn f(x: bits[$0], y: bits[$0], s: bits[$0]) -> bits[$0] {
+      p: bits[$0] = umul(x, y)
+      ret r: bits[$0] = add(p, s)
+    })"},
+    {"kernel_abs_diff",
+     R"(fn f(x: bits[$0], y: bits[$0], s: bits[$0]) -> bits[$0] {
+      lt: bits[1] = ult(x, y)
+      a: bits[$0] = sub(y, x)
+      b: bits[$0] = sub(x, y)
+      ret r: bits[$0] = sel(lt, cases=[b, a])
+    })"},
+    {"kernel_crc_step",
+     R"(fn f(x: bits[$0], y: bits[$0], s: bits[$0]) -> bits[$0] {
+      one: bits[$0] = literal(value=1)
+      shifted: bits[$0] = shll(x, one)
+      msb: bits[1] = bit_slice(x, start=$1, width=1)
+      mask: bits[$0] = sign_ext(msb, new_bit_count=$0)
+      poly: bits[$0] = and(y, mask)
+      ret r: bits[$0] = xor(shifted, poly)
+    })"},
+    {"kernel_clamp",
+     R"(fn f(x: bits[$0], y: bits[$0], s: bits[$0]) -> bits[$0] {
+      lo: bits[1] = slt(x, y)
+      hi: bits[1] = sgt(x, s)
+      sel_hi: bits[$0] = sel(hi, cases=[x, s])
+      ret r: bits[$0] = sel(lo, cases=[sel_hi, y])
+    })"},
+};
+
+const std::vector<BenchmarkCase>& GetBenchmarkCases() {
+  static const std::vector<BenchmarkCase>* cases = [] {
+    auto* cases = new std::vector<BenchmarkCase>();
+    for (Op op : kAllOps) {
+      if (!IsFunctionOp(op)) {
+        continue;
+      }
+      cases->push_back({OpToString(op), [op](Package* p, int64_t width) {
+                          return BuildOpFunction(op, p, width);
+                        }});
+    }
+    for (const Kernel& kernel : kKernels) {
+      cases->push_back({kernel.name, [ir = kernel.ir](Package* p,
+                                                      int64_t width) {
+                          return Parser::ParseFunction(
+                              absl::Substitute(ir, width, width - 1), p);
+                        }});
+    }
+    return cases;
+  }();
+  return *cases;
+}
+
+void CasesAndWidths(benchmark::internal::Benchmark* b) {
+  for (int64_t i = 0; i < GetBenchmarkCases().size(); ++i) {
+    for (int64_t width : {8, 32, 64, 256, 1024}) {
+      b->Args({i, width});
+    }
+  }
+}
+
+// The function of a benchmark case along with random arguments for it.
+struct Setup {
+  Package package{"op_throughput"};
+  Function* function;
+  std::vector<Value> args;
+  std::unique_ptr<FunctionJit> jit;
+};
+
+std::unique_ptr<Setup> CreateSetup(benchmark::State& state, bool with_jit) {
+  const BenchmarkCase& benchmark_case = GetBenchmarkCases()[state.range(0)];
+  int64_t width = state.range(1);
+  state.SetLabel(benchmark_case.name);
+  auto setup = std::make_unique<Setup>();
+  setup->function = benchmark_case.build(&setup->package, width).value();
+  std::minstd_rand bitgen;
+  for (int64_t i = 0; i < setup->function->params().size(); ++i) {
+    std::vector<uint8_t> bytes((width + 7) / 8);
+    for (uint8_t& byte : bytes) {
+      byte = static_cast<uint8_t>(bitgen());
+    }
+    setup->args.push_back(Value(Bits::FromBytes(bytes, width)));
+  }
+  if (with_jit) {
+    setup->jit = FunctionJit::Create(setup->function).value();
+  }
+  return setup;
+}
+
+void BM_Interpreter(benchmark::State& state) {
+  std::unique_ptr<Setup> setup = CreateSetup(state, /*with_jit=*/false);
+  for (auto _ : state) {
+    auto result = InterpretFunction(setup->function, setup->args);
+    CHECK_OK(result.status());
+    benchmark::DoNotOptimize(result->value);
+  }
+}
+
+// Includes marshaling the arguments and result.
+void BM_JitRun(benchmark::State& state) {
+  std::unique_ptr<Setup> setup = CreateSetup(state, /*with_jit=*/true);
+  for (auto _ : state) {
+    auto result = setup->jit->Run(setup->args);
+    CHECK_OK(result.status());
+    benchmark::DoNotOptimize(result->value);
+  }
+}
+
+// Only marshals the arguments into the native layout and the result out of it.
+void BM_JitMarshal(benchmark::State& state) {
+  std::unique_ptr<Setup> setup = CreateSetup(state, /*with_jit=*/true);
+  FunctionJit& jit = *setup->jit;
+  FunctionType* type = setup->function->GetType();
+  JitArgumentSet args = jit.jitted_function_base().CreateInputBuffer();
+  JitArgumentSet result = jit.jitted_function_base().CreateOutputBuffer();
+  for (auto _ : state) {
+    CHECK_OK(jit.runtime()->PackArgs(setup->args, type->parameters(),
+                                     args.pointers()));
+    Value value =
+        jit.runtime()->UnpackBuffer(result.pointers()[0], type->return_type());
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+// Only the execution: the arguments are already in the native layout.
+void BM_JitRunWithViews(benchmark::State& state) {
+  std::unique_ptr<Setup> setup = CreateSetup(state, /*with_jit=*/true);
+  FunctionJit& jit = *setup->jit;
+  JitArgumentSet args = jit.jitted_function_base().CreateInputBuffer();
+  JitArgumentSet result = jit.jitted_function_base().CreateOutputBuffer();
+  CHECK_OK(jit.runtime()->PackArgs(
+      setup->args, setup->function->GetType()->parameters(), args.pointers()));
+  InterpreterEvents events;
+  for (auto _ : state) {
+    CHECK_OK((jit.RunWithViews</*kForceZeroCopy=*/true>(
+        args.pointers(),
+        absl::MakeSpan(result.pointers()[0], jit.GetReturnTypeSize()),
+        &events)));
+    benchmark::DoNotOptimize(result.pointers()[0][0]);
+  }
+}
+
+// A packed view over a buffer of any type, as RunWithPackedViews only needs
+// the buffers of its views.
+class PackedBuffer {
+ public:
+  explicit PackedBuffer(uint8_t* buffer) : buffer_(buffer) {}
+  const uint8_t* buffer() { return buffer_; }
+  uint8_t* mutable_buffer() { return buffer_; }
+
+ private:
+  uint8_t* buffer_;
+};
+
+void BM_JitRunWithPackedViews(benchmark::State& state) {
+  std::unique_ptr<Setup> setup = CreateSetup(state, /*with_jit=*/true);
+  FunctionJit& jit = *setup->jit;
+  const JittedFunctionBase& base = jit.jitted_function_base();
+  std::minstd_rand bitgen;
+  std::vector<std::vector<uint8_t>> args;
+  for (int64_t size : base.packed_input_buffer_sizes()) {
+    std::vector<uint8_t>& arg = args.emplace_back(size);
+    for (uint8_t& byte : arg) {
+      byte = static_cast<uint8_t>(bitgen());
+    }
+  }
+  std::vector<uint8_t> result(base.packed_output_buffer_sizes()[0]);
+  PackedBuffer x(args[0].data());
+  PackedBuffer y(args[1].data());
+  PackedBuffer s(args[2].data());
+  PackedBuffer r(result.data());
+  for (auto _ : state) {
+    CHECK_OK(jit.RunWithPackedViews(x, y, s, r));
+    benchmark::DoNotOptimize(result.data());
+  }
+}
+
+BENCHMARK(BM_Interpreter)->Apply(CasesAndWidths);
+BENCHMARK(BM_JitRun)->Apply(CasesAndWidths);
+BENCHMARK(BM_JitMarshal)->Apply(CasesAndWidths);
+BENCHMARK(BM_JitRunWithViews)->Apply(CasesAndWidths);
+BENCHMARK(BM_JitRunWithPackedViews)->Apply(CasesAndWidths);
+
+}  // namespace
+}  // namespace xls
+
+BENCHMARK_MAIN();
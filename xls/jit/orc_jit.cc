@@ -14,12 +14,14 @@
 
 #include "xls/jit/orc_jit.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
@@ -28,8 +30,12 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "llvm/include/llvm/ADT/StringRef.h"
 #include "llvm/include/llvm/ADT/SmallVector.h"
 #include "llvm/include/llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/include/llvm/Bitcode/BitcodeReader.h"
+#include "llvm/include/llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/AbsoluteSymbols.h"  // IWYU pragma: keep
 #include "llvm/include/llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/Core.h"
@@ -45,17 +51,24 @@
 #include "llvm/include/llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/include/llvm/IR/BasicBlock.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
+#include "llvm/include/llvm/IR/Function.h"
 #include "llvm/include/llvm/IR/Instruction.h"
+#include "llvm/include/llvm/IR/LLVMContext.h"
 #include "llvm/include/llvm/IR/LegacyPassManager.h"
 #include "llvm/include/llvm/IR/Module.h"
 #include "llvm/include/llvm/IRPrinter/IRPrintingPasses.h"
 #include "llvm/include/llvm/Passes/PassBuilder.h"
 #include "llvm/include/llvm/Support/CodeGen.h"
 #include "llvm/include/llvm/Support/Error.h"
+#include "llvm/include/llvm/Support/MemoryBuffer.h"
 #include "llvm/include/llvm/Support/raw_ostream.h"
+#include "llvm/include/llvm/Target/TargetMachine.h"
+#include "llvm/include/llvm/TargetParser/Triple.h"
 #include "llvm/include/llvm/Transforms/Instrumentation/MemorySanitizer.h"
+#include "llvm/include/llvm/Transforms/Utils/SplitModule.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/jit/jit_emulated_tls.h"  // NOLINT: Used with MSAN
 #include "xls/jit/llvm_compiler.h"
 #include "xls/jit/observer.h"
@@ -63,7 +76,7 @@
 namespace xls {
 
 OrcJit::OrcJit(int64_t opt_level, bool include_msan,
-               bool include_observer_callbacks)
+               bool include_observer_callbacks, std::string_view target_cpu)
     : LlvmCompiler(opt_level, include_msan, include_observer_callbacks),
       context_(std::make_unique<llvm::LLVMContext>()),
       execution_session_(
@@ -71,7 +84,8 @@ OrcJit::OrcJit(int64_t opt_level, bool include_msan,
       object_layer_(
           execution_session_,
           []() { return std::make_unique<llvm::SectionMemoryManager>(); }),
-      dylib_(execution_session_.createBareJITDylib("main")) {}
+      dylib_(execution_session_.createBareJITDylib("main")),
+      target_cpu_(target_cpu) {}
 
 OrcJit::~OrcJit() {
   if (auto err = execution_session_.endSession()) {
@@ -91,10 +105,18 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
     jit_observer_->UnoptimizedModule(bare_module);
   }
 
-  auto error = PerformStandardOptimization(bare_module);
+  bool observe_stats =
+      jit_observer_ != nullptr &&
+      jit_observer_->GetNotificationOptions().optimization_stats;
+  JitOptimizationStats stats;
+  auto error = PerformStandardOptimization(
+      bare_module, observe_stats ? &stats : nullptr);
   if (error) {
     return llvm::Expected<llvm::orc::ThreadSafeModule>(std::move(error));
   }
+  if (observe_stats) {
+    jit_observer_->OptimizationStats(bare_module, stats);
+  }
 
   VLOG(2) << "Optimized module IR:";
   XLS_VLOG_LINES(2, DumpLlvmModuleToString(bare_module));
@@ -132,7 +154,8 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
 }
 
 absl::StatusOr<std::unique_ptr<OrcJit>> OrcJit::Create(
-    int64_t opt_level, bool include_observer_callbacks, JitObserver* observer) {
+    int64_t opt_level, bool include_observer_callbacks, JitObserver* observer,
+    std::string_view target_cpu) {
   LlvmCompiler::InitializeLlvm();
 #ifdef ABSL_HAVE_MEMORY_SANITIZER
   constexpr bool kHasMsan = true;
@@ -140,7 +163,7 @@ absl::StatusOr<std::unique_ptr<OrcJit>> OrcJit::Create(
   constexpr bool kHasMsan = false;
 #endif
   std::unique_ptr<OrcJit> jit = absl::WrapUnique(
-      new OrcJit(opt_level, kHasMsan, include_observer_callbacks));
+      new OrcJit(opt_level, kHasMsan, include_observer_callbacks, target_cpu));
   jit->SetJitObserver(observer);
   XLS_RETURN_IF_ERROR(jit->Init());
   return std::move(jit);
@@ -157,6 +180,18 @@ OrcJit::CreateTargetMachine() {
   }
 
   error_or_target_builder->setRelocationModel(llvm::Reloc::Model::PIC_);
+  if (target_cpu_ != kHostCpu) {
+    // The generated code runs right here so make sure it can.
+    if (error_or_target_builder->getTargetTriple().getArch() ==
+        llvm::Triple::x86_64) {
+      XLS_ASSIGN_OR_RETURN(bool supported, HostSupportsTargetCpu(target_cpu_));
+      if (!supported) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Host CPU does not support JIT target CPU ", target_cpu_));
+      }
+    }
+    XLS_RETURN_IF_ERROR(SetTargetCpu(*error_or_target_builder, target_cpu_));
+  }
   auto error_or_target_machine = error_or_target_builder->createTargetMachine();
   if (!error_or_target_machine) {
     return absl::InternalError(
@@ -232,8 +267,37 @@ absl::Status OrcJit::InitInternal() {
   return absl::OkStatus();
 }
 
+namespace {
+
+// The fewest function definitions worth giving a part of a module compiled in
+// parts. The JIT emits a function per node plus one per partition of up to a
+// hundred nodes so this is about two partitions.
+constexpr int64_t kMinFunctionsPerPart = 200;
+
+}  // namespace
+
 absl::Status OrcJit::CompileModule(std::unique_ptr<llvm::Module>&& module) {
   XLS_RETURN_IF_ERROR(VerifyModule(*module));
+  bool observe_modules =
+      VLOG_IS_ON(2) ||
+      (jit_observer_ != nullptr &&
+       (jit_observer_->GetNotificationOptions().unoptimized_module ||
+        jit_observer_->GetNotificationOptions().optimized_module ||
+        jit_observer_->GetNotificationOptions().assembly_code_str ||
+        jit_observer_->GetNotificationOptions().optimization_stats));
+  if (compile_threads_ > 1 && !observe_modules) {
+    int64_t function_count = 0;
+    for (const llvm::Function& function : module->functions()) {
+      if (!function.isDeclaration()) {
+        ++function_count;
+      }
+    }
+    int64_t part_count = std::min(compile_threads_,
+                                  function_count / kMinFunctionsPerPart);
+    if (part_count > 1) {
+      return CompileModuleInParts(std::move(module), part_count);
+    }
+  }
   llvm::Error error = transform_layer_->add(
       dylib_, llvm::orc::ThreadSafeModule(std::move(module), context_));
   if (error) {
@@ -243,6 +307,92 @@ absl::Status OrcJit::CompileModule(std::unique_ptr<llvm::Module>&& module) {
   return absl::OkStatus();
 }
 
+absl::Status OrcJit::CompileModuleInParts(std::unique_ptr<llvm::Module> module,
+                                          int64_t part_count) {
+  // Splitting keeps private symbols with everything referencing them, so each
+  // partition function stays with the node functions it inlines. An LLVM
+  // context may only be used by one thread at a time so the parts are handed
+  // to the workers as bitcode.
+  std::vector<llvm::SmallVector<char, 0>> bitcode;
+  llvm::SplitModule(
+      *module, part_count,
+      [&](std::unique_ptr<llvm::Module> part) {
+        llvm::raw_svector_ostream ostream(bitcode.emplace_back());
+        llvm::WriteBitcodeToFile(*part, ostream);
+      },
+      /*PreserveLocals=*/true);
+  module.reset();
+  VLOG(1) << "Compiling module in " << bitcode.size() << " parts";
+
+  std::vector<std::unique_ptr<llvm::TargetMachine>> target_machines;
+  target_machines.reserve(bitcode.size());
+  for (int64_t i = 0; i < bitcode.size(); ++i) {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<llvm::TargetMachine> target_machine,
+                         CreateTargetMachine());
+    target_machines.push_back(std::move(target_machine));
+  }
+  std::vector<absl::StatusOr<std::vector<uint8_t>>> object_code(
+      bitcode.size(), absl::UnknownError("Part not compiled"));
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    threads.reserve(bitcode.size());
+    for (int64_t i = 0; i < bitcode.size(); ++i) {
+      threads.push_back(std::make_unique<Thread>([&, i]() {
+        object_code[i] = CompileBitcode(bitcode[i], *target_machines[i]);
+      }));
+    }
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+  }
+  for (absl::StatusOr<std::vector<uint8_t>>& part : object_code) {
+    XLS_RETURN_IF_ERROR(part.status());
+    XLS_RETURN_IF_ERROR(LoadObjectCode(*part));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<uint8_t>> OrcJit::CompileBitcode(
+    absl::Span<const char> bitcode, llvm::TargetMachine& target_machine) {
+  llvm::LLVMContext context;
+  llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()),
+                            "xls_jit_part"),
+      context);
+  if (!module) {
+    return absl::InternalError(
+        absl::StrCat("Unable to read module part: ",
+                     llvm::toString(module.takeError())));
+  }
+  if (llvm::Error error = PerformStandardOptimization(module->get())) {
+    return absl::InternalError(absl::StrCat(
+        "Unable to optimize module part: ", llvm::toString(std::move(error))));
+  }
+  llvm::SmallVector<char, 0> stream_buffer;
+  llvm::raw_svector_ostream ostream(stream_buffer);
+  llvm::legacy::PassManager mpm;
+  if (target_machine.addPassesToEmitFile(mpm, ostream, nullptr,
+                                         llvm::CodeGenFileType::ObjectFile)) {
+    return absl::InternalError("Unable to add passes for object code dumping");
+  }
+  mpm.run(**module);
+  return std::vector<uint8_t>(stream_buffer.begin(), stream_buffer.end());
+}
+
+absl::Status OrcJit::LoadObjectCode(absl::Span<const uint8_t> object_code) {
+  std::unique_ptr<llvm::MemoryBuffer> buffer =
+      llvm::MemoryBuffer::getMemBufferCopy(
+          llvm::StringRef(reinterpret_cast<const char*>(object_code.data()),
+                          object_code.size()),
+          "xls_jit_object");
+  llvm::Error error = object_layer_.add(dylib_, std::move(buffer));
+  if (error) {
+    return absl::UnknownError(absl::StrFormat(
+        "Error loading object code: %s", llvm::toString(std::move(error))));
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<llvm::orc::ExecutorAddr> OrcJit::LoadSymbol(
     std::string_view function_name) {
 #ifdef __APPLE__
@@ -17,10 +17,13 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/IRTransformLayer.h"
@@ -50,10 +53,16 @@ class OrcJit : public LlvmCompiler {
   // compiler should use the 3-argument version above. Passing nullopt to
   // emit_msan directs the jit to use MSAN if the running binary is MSAN and
   // vice-versa.
+  //
+  // Code is generated for the CPU of this process using every feature it
+  // supports unless another `target_cpu` (an LLVM CPU name such as
+  // "x86-64-v3") is given, e.g., to reproduce the code of an AOT compile. The
+  // host must support the features of the target CPU.
   static absl::StatusOr<std::unique_ptr<OrcJit>> Create(
       int64_t opt_level = kDefaultOptLevel,
       bool include_observer_callbacks = false,
-      JitObserver* jit_observer = nullptr);
+      JitObserver* jit_observer = nullptr,
+      std::string_view target_cpu = kHostCpu);
 
   void SetJitObserver(JitObserver* o) { jit_observer_ = o; }
 
@@ -62,6 +71,23 @@ class OrcJit : public LlvmCompiler {
   // Compiles the given LLVM module into the JIT's execution session.
   absl::Status CompileModule(std::unique_ptr<llvm::Module>&& module) override;
 
+  // If greater than one, modules compiled after this call which are large
+  // enough are split into up to `thread_count` parts which are optimized and
+  // compiled to object code concurrently, each in its own LLVM context. The
+  // JIT emits a function base as a sequence of partition functions (each with
+  // the node functions it calls) so a huge function splits along partitions,
+  // at the cost of calls between parts not being inlined. Modules are compiled
+  // whole when an observer or VLOG wants to see them.
+  void SetCompileThreads(int64_t thread_count) {
+    compile_threads_ = thread_count;
+  }
+  int64_t compile_threads() const { return compile_threads_; }
+
+  // Adds a previously compiled object file (e.g., the object code produced by
+  // an AotCompiler for the same target) to the JIT's execution session. The
+  // symbols it defines may then be resolved with LoadSymbol.
+  absl::Status LoadObjectCode(absl::Span<const uint8_t> object_code);
+
   // Returns the address of the given JIT'ed function.
   absl::StatusOr<llvm::orc::ExecutorAddr> LoadSymbol(
       std::string_view function_name);
@@ -76,7 +102,8 @@ class OrcJit : public LlvmCompiler {
   absl::Status InitInternal() override;
 
  private:
-  OrcJit(int64_t opt_level, bool include_msan, bool include_observer_callbacks);
+  OrcJit(int64_t opt_level, bool include_msan, bool include_observer_callbacks,
+         std::string_view target_cpu);
 
   // Method which optimizes the given module. Used within the JIT to form an IR
   // transform layer.
@@ -84,6 +111,16 @@ class OrcJit : public LlvmCompiler {
       llvm::orc::ThreadSafeModule module,
       const llvm::orc::MaterializationResponsibility& responsibility);
 
+  // Splits `module` into `part_count` parts and compiles them concurrently,
+  // loading the resulting object code into the execution session.
+  absl::Status CompileModuleInParts(std::unique_ptr<llvm::Module> module,
+                                    int64_t part_count);
+
+  // Optimizes the module serialized in `bitcode` in a fresh LLVM context and
+  // returns its object code generated with `target_machine`.
+  absl::StatusOr<std::vector<uint8_t>> CompileBitcode(
+      absl::Span<const char> bitcode, llvm::TargetMachine& target_machine);
+
   llvm::orc::ThreadSafeContext context_;
   llvm::orc::ExecutionSession execution_session_;
   llvm::orc::RTDyldObjectLinkingLayer object_layer_;
@@ -93,6 +130,9 @@ class OrcJit : public LlvmCompiler {
   std::unique_ptr<llvm::orc::IRTransformLayer> transform_layer_;
 
   JitObserver* jit_observer_ = nullptr;
+
+  std::string target_cpu_;
+  int64_t compile_threads_ = 1;
 };
 
 }  // namespace xls
@@ -15,6 +15,7 @@
 #ifndef XLS_JIT_PROC_BASE_JIT_WRAPPER_H_
 #define XLS_JIT_PROC_BASE_JIT_WRAPPER_H_
 
+#include <bit>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -37,6 +38,7 @@
 #include "xls/ir/package.h"
 #include "xls/ir/proc.h"
 #include "xls/ir/state_element.h"
+#include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/xls_ir_interface.pb.h"
 #include "xls/jit/aot_entrypoint.pb.h"
@@ -157,6 +159,35 @@ class BaseProcJitWrapper {
     return queue->Read();
   }
 
+  // Add each of 'vs', in order, onto the queue of things to be sent to the
+  // proc on the given channel.
+  absl::Status SendManyToChannel(std::string_view chan_name,
+                                 absl::Span<const xls::Value> vs) {
+    XLS_ASSIGN_OR_RETURN(auto* man, runtime_->GetJitChannelQueueManager());
+    XLS_ASSIGN_OR_RETURN(auto* queue, man->GetQueueByName(chan_name));
+    for (const xls::Value& v : vs) {
+      XLS_RETURN_IF_ERROR(queue->Write(v));
+    }
+    return absl::OkStatus();
+  }
+
+  // Remove and return up to 'max_count' of the oldest elements in the
+  // channels queue, oldest first.
+  absl::StatusOr<std::vector<xls::Value>> ReceiveManyFromChannel(
+      std::string_view chan_name, int64_t max_count) {
+    XLS_ASSIGN_OR_RETURN(auto* man, runtime_->GetJitChannelQueueManager());
+    XLS_ASSIGN_OR_RETURN(auto* queue, man->GetQueueByName(chan_name));
+    std::vector<xls::Value> result;
+    for (int64_t i = 0; i < max_count; ++i) {
+      std::optional<xls::Value> v = queue->Read();
+      if (!v) {
+        break;
+      }
+      result.push_back(*std::move(v));
+    }
+    return result;
+  }
+
  protected:
   BaseProcJitWrapper(std::unique_ptr<Package> package, Proc* proc,
                      std::unique_ptr<ProcRuntime> runtime,
@@ -192,6 +223,42 @@ class BaseProcJitWrapper {
     return true;
   }
 
+  // Send each of 'vs', which are laid out as 'PackedView's, in order.
+  template <typename PackedView, typename T>
+  absl::Status SendManyToChannelPacked(std::string_view chan_name,
+                                       absl::Span<const T> vs) {
+    XLS_ASSIGN_OR_RETURN(auto* man, runtime_->GetJitChannelQueueManager());
+    XLS_ASSIGN_OR_RETURN(auto* queue, man->GetQueueByName(chan_name));
+    for (const T& v : vs) {
+      PackedView view(std::bit_cast<uint8_t*>(&v), 0);
+      XLS_RETURN_IF_ERROR(queue->Write(
+          jit_runtime_.UnpackBuffer(view.buffer(), queue->channel()->type())));
+    }
+    return absl::OkStatus();
+  }
+
+  // Receive into successive elements of 'memory', which are laid out as
+  // 'PackedView's, until it is full or the channel is empty. Returns the
+  // number of elements received.
+  template <typename PackedView, typename T>
+  absl::StatusOr<int64_t> ReceiveManyFromChannelPacked(
+      std::string_view chan_name, absl::Span<T> memory) {
+    XLS_ASSIGN_OR_RETURN(auto* man, runtime_->GetJitChannelQueueManager());
+    XLS_ASSIGN_OR_RETURN(auto* queue, man->GetQueueByName(chan_name));
+    Type* type = queue->channel()->type();
+    int64_t count = 0;
+    for (; count < memory.size(); ++count) {
+      std::optional<Value> v = queue->Read();
+      if (!v) {
+        break;
+      }
+      PackedView view(std::bit_cast<uint8_t*>(&memory[count]), 0);
+      XLS_RETURN_IF_ERROR(
+          jit_runtime_.PackArgs({*v}, {type}, {view.mutable_buffer()}));
+    }
+    return count;
+  }
+
   std::unique_ptr<Package> package_;
   Proc* proc_;
   std::unique_ptr<ProcRuntime> runtime_;
@@ -14,8 +14,8 @@
 
 #include "xls/jit/proc_jit.h"
 
+#include <algorithm>
 #include <cstdint>
-#include <cstring>
 #include <memory>
 #include <optional>
 #include <string>
@@ -44,6 +44,7 @@
 #include "xls/ir/proc.h"
 #include "xls/ir/proc_elaboration.h"
 #include "xls/ir/state_element.h"
+#include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/jit/aot_entrypoint.pb.h"
 #include "xls/jit/function_base_jit.h"
@@ -52,13 +53,25 @@
 #include "xls/jit/jit_channel_queue.h"
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/llvm_compiler.h"
+#include "xls/jit/node_coverage.h"
 #include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
 namespace {
 
+// Returns the layout of the state of `proc` when it is kept bit-packed.
+PackedTypeLayout PackedStateLayout(Proc* proc) {
+  std::vector<Type*> state_types;
+  state_types.reserve(proc->GetStateElementCount());
+  for (StateElement* state_element : proc->StateElements()) {
+    state_types.push_back(state_element->type());
+  }
+  return PackedTypeLayout(state_types);
+}
+
 // A continuation used by the ProcJit. Stores control and data state of proc
 // execution for the JIT.
 class ProcJitContinuation : public ProcContinuation {
@@ -72,9 +85,10 @@ class ProcJitContinuation : public ProcContinuation {
                                JitRuntime* jit_runtime,
                                std::vector<JitChannelQueue*> queues,
                                const JittedFunctionBase& jit_func,
-                               bool has_observer_callbacks);
+                               bool has_observer_callbacks,
+                               bool has_node_coverage);
 
-  ~ProcJitContinuation() override = default;
+  ~ProcJitContinuation() override { ReportNodeCoverage(); }
 
   std::vector<Value> GetState() const override;
   absl::Status SetState(std::vector<Value> v) override;
@@ -130,11 +144,21 @@ class ProcJitContinuation : public ProcContinuation {
    private:
     ProcJitContinuation* owner_;
   };
+
+  // Reports the node coverage accumulated since the last report to the
+  // observer (if any) and clears it.
+  void ReportNodeCoverage();
+
   int64_t continuation_point_;
   JitRuntime* jit_runtime_;
 
   InterpreterEvents events_;
 
+  // Layout of the state if the proc was compiled to keep it bit-packed. In
+  // that case `input_` and `output_` each hold a single packed buffer rather
+  // than one native buffer per state element.
+  std::optional<PackedTypeLayout> packed_layout_;
+
   // Buffers to hold inputs, outputs, and temporary storage. This is allocated
   // once and then re-used with each invocation of Run. Not thread-safe.
   JitArgumentSet input_;
@@ -149,26 +173,49 @@ class ProcJitContinuation : public ProcContinuation {
 
   // if the code has observer callbacks compiled in.
   bool has_observer_callbacks_;
+
+  // If the code has node coverage compiled in, the nodes it covers and the
+  // buffer into which their bits are accumulated while an observer is set.
+  bool has_node_coverage_;
+  absl::Span<const NodeCoverageSite> coverage_sites_;
+  std::vector<uint8_t> node_coverage_bits_;
 };
 
 ProcJitContinuation::ProcJitContinuation(ProcInstance* proc_instance,
                                          JitRuntime* jit_runtime,
                                          std::vector<JitChannelQueue*> queues,
                                          const JittedFunctionBase& jit_func,
-                                         bool has_observer_callbacks)
+                                         bool has_observer_callbacks,
+                                         bool has_node_coverage)
     : ProcContinuation(proc_instance),
       continuation_point_(0),
       jit_runtime_(jit_runtime),
-      input_(jit_func.CreateInputOutputBuffer().value()),
-      output_(jit_func.CreateInputOutputBuffer().value()),
+      packed_layout_(jit_func.HasPackedStateFunction()
+                         ? std::make_optional(
+                               PackedStateLayout(proc_instance->proc()))
+                         : std::nullopt),
+      input_(packed_layout_.has_value()
+                 ? jit_func.CreatePackedStateBuffer()
+                 : jit_func.CreateInputOutputBuffer().value()),
+      output_(packed_layout_.has_value()
+                  ? jit_func.CreatePackedStateBuffer()
+                  : jit_func.CreateInputOutputBuffer().value()),
       temp_buffer_(jit_func.CreateTempBuffer()),
       instance_context_(
           InstanceContext::CreateForProc(proc_instance, std::move(queues))),
       observer_shim_(this),
-      has_observer_callbacks_(has_observer_callbacks) {
+      has_observer_callbacks_(has_observer_callbacks),
+      has_node_coverage_(has_node_coverage),
+      coverage_sites_(jit_func.coverage_sites()),
+      node_coverage_bits_(jit_func.node_coverage_size(), 0) {
   // Write initial state value to the input_buffer.
   for (StateElement* state_element : proc()->StateElements()) {
     int64_t state_index = *proc()->GetStateElementIndex(state_element);
+    if (packed_layout_.has_value()) {
+      packed_layout_->ValueToPackedLayout(
+          state_index, state_element->initial_value(), input_.pointers()[0]);
+      continue;
+    }
     jit_runtime->BlitValueToBuffer(
         state_element->initial_value(), state_element->type(),
         absl::Span<uint8_t>(
@@ -177,23 +224,46 @@ ProcJitContinuation::ProcJitContinuation(ProcInstance* proc_instance,
   }
 }
 
+void ProcJitContinuation::ReportNodeCoverage() {
+  if (instance_context_.observer == nullptr) {
+    return;
+  }
+  for (const NodeCoverageSite& site : coverage_sites_) {
+    instance_context_.observer->RecordNodeCoverage(
+        static_cast<int64_t>(reinterpret_cast<intptr_t>(site.node)),
+        node_coverage_bits_.data() + site.offset);
+  }
+  std::fill(node_coverage_bits_.begin(), node_coverage_bits_.end(), 0);
+}
+
 void ProcJitContinuation::ClearObserver() {
+  ReportNodeCoverage();
   instance_context_.observer = nullptr;
+  instance_context_.node_coverage_bits = nullptr;
   ProcContinuation::ClearObserver();
 }
 
 absl::Status ProcJitContinuation::SetObserver(EvaluationObserver* obs) {
-  if (!has_observer_callbacks_) {
+  if (!has_observer_callbacks_ && !has_node_coverage_) {
     return absl::UnimplementedError(
         "Observers are not supported on this compilation.");
   }
-  XLS_RETURN_IF_ERROR(ProcContinuation::SetObserver(obs));
   auto runtime_obs = obs->AsRawObserver();
+  if (!has_observer_callbacks_ && !runtime_obs) {
+    return absl::UnimplementedError(
+        "Code compiled with only node coverage requires an observer which "
+        "accepts raw JIT values.");
+  }
+  XLS_RETURN_IF_ERROR(ProcContinuation::SetObserver(obs));
+  ReportNodeCoverage();
   if (runtime_obs) {
     instance_context_.observer = *runtime_obs;
   } else {
     instance_context_.observer = &observer_shim_;
   }
+  if (has_node_coverage_) {
+    instance_context_.node_coverage_bits = node_coverage_bits_.data();
+  }
   return absl::OkStatus();
 }
 
@@ -201,6 +271,11 @@ std::vector<Value> ProcJitContinuation::GetState() const {
   std::vector<Value> state;
   for (StateElement* state_element : proc()->StateElements()) {
     int64_t state_index = *proc()->GetStateElementIndex(state_element);
+    if (packed_layout_.has_value()) {
+      state.push_back(packed_layout_->PackedLayoutToValue(
+          state_index, input_.pointers()[0]));
+      continue;
+    }
     state.push_back(jit_runtime_->UnpackBuffer(input_.pointers()[state_index],
                                                state_element->type()));
   }
@@ -212,6 +287,11 @@ absl::Status ProcJitContinuation::SetState(std::vector<Value> v) {
 
   for (StateElement* state_element : proc()->StateElements()) {
     int64_t state_index = *proc()->GetStateElementIndex(state_element);
+    if (packed_layout_.has_value()) {
+      packed_layout_->ValueToPackedLayout(state_index, v[state_index],
+                                          input_.pointers()[0]);
+      continue;
+    }
     jit_runtime_->BlitValueToBuffer(
         v[state_index], state_element->type(),
         absl::Span<uint8_t>(
@@ -263,16 +343,9 @@ absl::Status ProcJitContinuation::NextTick() {
                              absl::StrAppend(out, value.ToString());
                            });
 
-  if (!proc()->next_values().empty()) {
-    // New-style state param evaluation; initialize the output state params to
-    // be unchanged by default.
-    for (int64_t state_index = 0; state_index < proc()->GetStateElementCount();
-         ++state_index) {
-      memcpy(output_.pointers()[state_index], input_.pointers()[state_index],
-             jit_runtime_->GetTypeByteSize(
-                 proc()->GetStateElementType(state_index)));
-    }
-  }
+  // The output state need not be initialized for the next tick: the jitted
+  // function copies the current value of each state element without an
+  // unconditional next value itself.
   return absl::OkStatus();
 }
 
@@ -281,8 +354,7 @@ absl::StatusOr<ChannelInstance*> GetChannelInstance(
     JitChannelQueueManager* queue_mgr) {
   if (proc_instance->path().has_value()) {
     // New-style proc-scoped channels.
-    return queue_mgr->elaboration().GetChannelInstance(channel_name,
-                                                       *proc_instance->path());
+    return proc_instance->GetChannelInstance(channel_name);
   }
   // Old-style global channels.
   XLS_ASSIGN_OR_RETURN(
@@ -321,7 +393,8 @@ absl::Status InitializeChannelQueues(
   // TODO(allight): Supporting observer callbacks in aot would be nice.
   auto jit = std::unique_ptr<ProcJit>(
       new ProcJit(proc, jit_runtime, queue_mgr, /*orc_jit=*/nullptr,
-                  /*has_observer_callbacks=*/false));
+                  /*has_observer_callbacks=*/false,
+                  /*has_node_coverage=*/false));
   XLS_ASSIGN_OR_RETURN(
       jit->jitted_function_base_,
       JittedFunctionBase::BuildFromAot(entrypoint, unpacked, packed));
@@ -333,16 +406,20 @@ absl::Status InitializeChannelQueues(
 
 absl::StatusOr<std::unique_ptr<ProcJit>> ProcJit::Create(
     Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr,
-    bool include_observer_callbacks, JitObserver* jit_observer) {
+    bool include_observer_callbacks, JitObserver* jit_observer,
+    bool packed_state, bool include_node_coverage) {
   XLS_ASSIGN_OR_RETURN(
       std::unique_ptr<OrcJit> orc_jit,
       OrcJit::Create(LlvmCompiler::kDefaultOptLevel, include_observer_callbacks,
                      jit_observer));
+  orc_jit->SetIncludeNodeCoverage(include_node_coverage);
   auto jit = absl::WrapUnique(
       new ProcJit(proc, jit_runtime, queue_mgr, std::move(orc_jit),
-                  /*has_observer_callbacks=*/include_observer_callbacks));
-  XLS_ASSIGN_OR_RETURN(jit->jitted_function_base_,
-                       JittedFunctionBase::Build(proc, jit->GetOrcJit()));
+                  /*has_observer_callbacks=*/include_observer_callbacks,
+                  /*has_node_coverage=*/include_node_coverage));
+  XLS_ASSIGN_OR_RETURN(
+      jit->jitted_function_base_,
+      JittedFunctionBase::Build(proc, jit->GetOrcJit(), packed_state));
   XLS_RET_CHECK(jit->jitted_function_base_.InputsAndOutputsAreEquivalent());
 
   XLS_RETURN_IF_ERROR(InitializeChannelQueues(
@@ -356,7 +433,7 @@ std::unique_ptr<ProcContinuation> ProcJit::NewContinuation(
   CHECK_EQ(proc_instance->proc(), proc());
   return std::make_unique<ProcJitContinuation>(
       proc_instance, jit_runtime_, channel_queues_.at(proc_instance),
-      jitted_function_base_, has_observer_callbacks_);
+      jitted_function_base_, has_observer_callbacks_, has_node_coverage_);
 }
 
 absl::StatusOr<TickResult> ProcJit::Tick(ProcContinuation& continuation) const {
@@ -367,9 +444,16 @@ absl::StatusOr<TickResult> ProcJit::Tick(ProcContinuation& continuation) const {
 
   // The jitted function returns the early exit point at which execution
   // halted. A return value of zero indicates that the tick completed.
-  int64_t next_continuation_point = jitted_function_base_.RunJittedFunction(
-      cont->input(), cont->output(), cont->temp_buffer(), &cont->GetEvents(),
-      cont->instance_context(), runtime(), cont->GetContinuationPoint());
+  int64_t next_continuation_point =
+      jitted_function_base_.HasPackedStateFunction()
+          ? jitted_function_base_.RunPackedStateJittedFunction(
+                cont->input(), cont->output(), cont->temp_buffer(),
+                &cont->GetEvents(), cont->instance_context(), runtime(),
+                cont->GetContinuationPoint())
+          : jitted_function_base_.RunJittedFunction(
+                cont->input(), cont->output(), cont->temp_buffer(),
+                &cont->GetEvents(), cont->instance_context(), runtime(),
+                cont->GetContinuationPoint());
 
   if (next_continuation_point == 0) {
     // The proc successfully completed its tick.
@@ -40,10 +40,21 @@ namespace xls {
 class ProcJit : public ProcEvaluator {
  public:
   // Returns an object containing a host-compiled version of the specified XLS
-  // proc.
+  // proc. If `packed_state` is true, the state of each proc instance is kept
+  // bit-packed (see PackedTypeLayout) which shrinks procs with many narrow
+  // state elements at the cost of unpacking the state at the start of each
+  // tick and packing it at the end.
+  //
+  // If `include_node_coverage` is true, the JIT code accumulates the bits set
+  // in the value of each node while an observer is set (see
+  // LlvmCompiler::SetIncludeNodeCoverage) and reports them to the observer's
+  // RuntimeObserver::RecordNodeCoverage when the observer is cleared or
+  // replaced or the continuation is destroyed. This supports observers which
+  // accept raw JIT values even without `include_observer_callbacks`.
   static absl::StatusOr<std::unique_ptr<ProcJit>> Create(
       Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr,
-      bool include_observer_callbacks = false, JitObserver* observer = nullptr);
+      bool include_observer_callbacks = false, JitObserver* observer = nullptr,
+      bool packed_state = false, bool include_node_coverage = false);
 
   static absl::StatusOr<std::unique_ptr<ProcJit>> CreateFromAot(
       Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr,
@@ -64,12 +75,14 @@ class ProcJit : public ProcEvaluator {
  private:
   explicit ProcJit(Proc* proc, JitRuntime* jit_runtime,
                    JitChannelQueueManager* queue_mgr,
-                   std::unique_ptr<OrcJit> orc_jit, bool has_observer_callbacks)
+                   std::unique_ptr<OrcJit> orc_jit, bool has_observer_callbacks,
+                   bool has_node_coverage)
       : ProcEvaluator(proc),
         jit_runtime_(jit_runtime),
         queue_mgr_(queue_mgr),
         orc_jit_(std::move(orc_jit)),
-        has_observer_callbacks_(has_observer_callbacks) {}
+        has_observer_callbacks_(has_observer_callbacks),
+        has_node_coverage_(has_node_coverage) {}
 
   JitRuntime* jit_runtime_;
   JitChannelQueueManager* queue_mgr_;
@@ -78,6 +91,8 @@ class ProcJit : public ProcEvaluator {
   // We need to have compiled in the callbacks in order to support the
   // Evaluation/RuntimeObserver apis.
   bool has_observer_callbacks_;
+  // Whether the code was compiled with node coverage.
+  bool has_node_coverage_;
 
   // The set of channel queues used in each proc instance. The vector is in a
   // predetermined order assigned at JIT compile time. The JITted code looks for
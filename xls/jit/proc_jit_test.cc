@@ -14,22 +14,37 @@
 
 #include "xls/jit/proc_jit.h"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/observer.h"
 #include "xls/interpreter/proc_evaluator.h"
 #include "xls/interpreter/proc_evaluator_test_base.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc.h"
+#include "xls/ir/value.h"
 #include "xls/jit/jit_channel_queue.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/jit/observer.h"
 #include "xls/jit/orc_jit.h"
 
 namespace xls {
 namespace {
 
+using ::absl_testing::StatusIs;
+
 JitRuntime* GetJitRuntime() {
   static auto orc_jit = OrcJit::Create().value();
   static auto jit_runtime =
@@ -37,14 +52,15 @@ JitRuntime* GetJitRuntime() {
   return jit_runtime.get();
 }
 
-template <bool kWithObserver>
+template <bool kWithObserver, bool kPackedState = false>
 std::unique_ptr<ProcEvaluator> EvaluatorFromProc(
     Proc* proc, ChannelQueueManager* queue_manager) {
   JitChannelQueueManager* jit_queue_manager =
       dynamic_cast<JitChannelQueueManager*>(queue_manager);
   CHECK(jit_queue_manager != nullptr);
   return ProcJit::Create(proc, GetJitRuntime(), jit_queue_manager,
-                         /*include_observer_callbacks=*/kWithObserver)
+                         /*include_observer_callbacks=*/kWithObserver,
+                         /*observer=*/nullptr, /*packed_state=*/kPackedState)
       .value();
 }
 
@@ -62,7 +78,77 @@ INSTANTIATE_TEST_SUITE_P(
                                            /*supports_observers=*/false),
                     ProcEvaluatorTestParam(EvaluatorFromProc<true>,
                                            QueueManagerForPackage,
-                                           /*supports_observers=*/true)));
+                                           /*supports_observers=*/true),
+                    ProcEvaluatorTestParam(
+                        EvaluatorFromProc</*kWithObserver=*/false,
+                                          /*kPackedState=*/true>,
+                        QueueManagerForPackage,
+                        /*supports_observers=*/false)));
+
+// Records the coverage reported by the JIT and fails on any other callback.
+class CoverageObserver final : public EvaluationObserver,
+                               public RuntimeObserver {
+ public:
+  void NodeEvaluated(Node* n, const Value& v) override {
+    ADD_FAILURE() << "Unexpected evaluation of " << n;
+  }
+  std::optional<RuntimeObserver*> AsRawObserver() override { return this; }
+  void RecordNodeValue(int64_t node_ptr, const uint8_t* data) override {
+    ADD_FAILURE() << "Unexpected node value callback";
+  }
+  void RecordNodeCoverage(int64_t node_ptr, const uint8_t* data) override {
+    Node* node = reinterpret_cast<Node*>(static_cast<intptr_t>(node_ptr));
+    EXPECT_FALSE(coverage_.contains(node)) << node << " reported twice";
+    coverage_[node] = GetJitRuntime()->UnpackBuffer(data, node->GetType());
+  }
+
+  const absl::flat_hash_map<Node*, Value>& coverage() const {
+    return coverage_;
+  }
+
+ private:
+  absl::flat_hash_map<Node*, Value> coverage_;
+};
+
+class ProcJitNodeCoverageTest : public IrTestBase {};
+
+TEST_F(ProcJitNodeCoverageTest, AccumulatesSetBits) {
+  auto p = CreatePackage();
+  ProcBuilder pb(TestName(), p.get());
+  BValue st = pb.StateElement("st", Value(UBits(1, 8)));
+  BValue shifted = pb.Shll(st, pb.Literal(UBits(1, 8)));
+  pb.Next(st, shifted);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build());
+
+  std::unique_ptr<ChannelQueueManager> queue_manager =
+      QueueManagerForPackage(p.get());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ProcJit> jit,
+      ProcJit::Create(
+          proc, GetJitRuntime(),
+          dynamic_cast<JitChannelQueueManager*>(queue_manager.get()),
+          /*include_observer_callbacks=*/false, /*observer=*/nullptr,
+          /*packed_state=*/false, /*include_node_coverage=*/true));
+  std::unique_ptr<ProcContinuation> continuation = jit->NewContinuation(
+      queue_manager->elaboration().GetUniqueInstance(proc).value());
+
+  // Without per-node callbacks only observers of raw JIT values are possible.
+  CollectingEvaluationObserver collecting;
+  EXPECT_THAT(continuation->SetObserver(&collecting),
+              StatusIs(absl::StatusCode::kUnimplemented));
+
+  CoverageObserver observer;
+  XLS_ASSERT_OK(continuation->SetObserver(&observer));
+  for (int64_t i = 0; i < 4; ++i) {
+    XLS_ASSERT_OK(jit->Tick(*continuation));
+  }
+  EXPECT_TRUE(observer.coverage().empty());
+  continuation->ClearObserver();
+
+  // `st` took the values 1, 2, 4 and 8.
+  EXPECT_EQ(observer.coverage().at(st.node()), Value(UBits(0x0f, 8)));
+  EXPECT_EQ(observer.coverage().at(shifted.node()), Value(UBits(0x1e, 8)));
+}
 
 }  // namespace
 }  // namespace xls
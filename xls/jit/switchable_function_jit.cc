@@ -27,6 +27,7 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/ir_interpreter.h"
+#include "xls/interpreter/node_value_map.h"
 #include "xls/ir/events.h"
 #include "xls/ir/function.h"
 #include "xls/ir/node.h"
@@ -85,25 +86,25 @@ SwitchableFunctionJit::Create(Function* xls_function, ExecutionType execution,
 }
 
 namespace {
-absl::StatusOr<absl::flat_hash_map<Node*, Value>> ToValueMap(
-    absl::Span<const Value> args, Function* f) {
-  absl::flat_hash_map<Node*, Value> res;
+absl::StatusOr<NodeValueMap> ToValueMap(absl::Span<const Value> args,
+                                        Function* f) {
+  NodeValueMap res(f);
   XLS_RET_CHECK_EQ(args.size(), f->params().size())
       << "Wrong number of parameters";
   int64_t i = 0;
   for (Param* p : f->params()) {
-    res.emplace(p, args.at(i++));
+    res.Set(p, args.at(i++));
   }
   return res;
 }
 
-absl::StatusOr<absl::flat_hash_map<Node*, Value>> ToValueMap(
+absl::StatusOr<NodeValueMap> ToValueMap(
     const absl::flat_hash_map<std::string, Value>& args, Function* f) {
-  absl::flat_hash_map<Node*, Value> res;
+  NodeValueMap res(f);
   for (Param* p : f->params()) {
     XLS_RET_CHECK(args.contains(p->name()))
         << "No value for param called '" << p->name() << "' given!";
-    res.emplace(p, args.at(p->name()));
+    res.Set(p, args.at(p->name()));
   }
   return res;
 }
@@ -118,7 +119,7 @@ class MemoizedIrInterpreter : public IrInterpreter {
 };
 
 absl::StatusOr<InterpreterResult<Value>> Interpret(
-    absl::flat_hash_map<Node*, Value> values, Function* function) {
+    NodeValueMap values, Function* function) {
   InterpreterEvents e;
   Node* return_val = function->return_value();
   InterpreterResult<Value> res;
@@ -0,0 +1,116 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/tiered_function_jit.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+
+namespace xls {
+
+/* static */ absl::StatusOr<std::unique_ptr<TieredFunctionJit>>
+TieredFunctionJit::Create(Function* xls_function,
+                          const TieredJitOptions& options) {
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<FunctionJit> initial_jit,
+      FunctionJit::Create(xls_function, options.initial_opt_level));
+  auto jit = absl::WrapUnique(
+      new TieredFunctionJit(xls_function, options, std::move(initial_jit)));
+  if (options.hot_run_count <= 0) {
+    jit->StartRecompilation();
+  }
+  return jit;
+}
+
+TieredFunctionJit::~TieredFunctionJit() {
+  // Joins the compile thread, which uses `function_` and `mutex_`.
+  compile_thread_.reset();
+}
+
+absl::StatusOr<InterpreterResult<Value>> TieredFunctionJit::Run(
+    absl::Span<const Value> args) {
+  CountRun();
+  return jit_->Run(args);
+}
+
+void TieredFunctionJit::CountRun() {
+  if (recompilation_done_) {
+    return;
+  }
+  if (compile_thread_ == nullptr) {
+    if (++run_count_ >= options_.hot_run_count) {
+      StartRecompilation();
+    }
+    return;
+  }
+  if (recompilation_finished_.load(std::memory_order_acquire)) {
+    SwitchToOptimizedCode();
+  }
+}
+
+void TieredFunctionJit::StartRecompilation() {
+  compile_thread_ = std::make_unique<Thread>([this]() {
+    absl::StatusOr<std::unique_ptr<FunctionJit>> jit =
+        FunctionJit::Create(function_, options_.optimized_opt_level);
+    {
+      absl::MutexLock lock(&mutex_);
+      if (jit.ok()) {
+        optimized_jit_ = *std::move(jit);
+      } else {
+        recompilation_status_ = jit.status();
+      }
+    }
+    recompilation_finished_.store(true, std::memory_order_release);
+  });
+}
+
+void TieredFunctionJit::SwitchToOptimizedCode() {
+  compile_thread_->Join();
+  recompilation_done_ = true;
+  absl::MutexLock lock(&mutex_);
+  if (!recompilation_status_.ok()) {
+    LOG(WARNING) << "Recompilation of " << function_->name()
+                 << " failed, keeping the initial code: "
+                 << recompilation_status_;
+    return;
+  }
+  jit_ = std::move(optimized_jit_);
+  optimized_ = true;
+}
+
+absl::Status TieredFunctionJit::WaitForOptimizedCode() {
+  if (!recompilation_done_) {
+    if (compile_thread_ == nullptr) {
+      StartRecompilation();
+    }
+    SwitchToOptimizedCode();
+  }
+  absl::MutexLock lock(&mutex_);
+  return recompilation_status_;
+}
+
+}  // namespace xls
@@ -0,0 +1,116 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_TIERED_FUNCTION_JIT_H_
+#define XLS_JIT_TIERED_FUNCTION_JIT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/common/thread.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+
+namespace xls {
+
+struct TieredJitOptions {
+  // Optimization level of the code run until the function is hot.
+  int64_t initial_opt_level = 0;
+  // Optimization level at which hot functions are recompiled.
+  int64_t optimized_opt_level = 3;
+  // Number of runs after which the function is considered hot.
+  int64_t hot_run_count = 1000;
+};
+
+// Runs an XLS function with code compiled quickly at a low optimization level
+// and, once the function has run `hot_run_count` times, recompiles it at a
+// higher optimization level on a background thread. Runs switch to the
+// optimized code as soon as it is ready, so short runs only pay for the quick
+// compile and long runs get the optimized code. If the recompilation fails the
+// initial code keeps being used.
+//
+// The function must not be modified while a recompilation may be in progress.
+// This class is not thread-safe.
+class TieredFunctionJit {
+ public:
+  static absl::StatusOr<std::unique_ptr<TieredFunctionJit>> Create(
+      Function* xls_function, const TieredJitOptions& options = {});
+
+  // Waits for any recompilation in progress.
+  ~TieredFunctionJit();
+
+  // Executes the function with the specified arguments.
+  absl::StatusOr<InterpreterResult<Value>> Run(absl::Span<const Value> args);
+
+  // Executes the function with arguments and result in the native data layout.
+  // See FunctionJit::RunWithViews. Argument and result sizes don't depend on
+  // the optimization level.
+  template <bool kForceZeroCopy = false>
+  absl::Status RunWithViews(absl::Span<uint8_t* const> args,
+                            absl::Span<uint8_t> result_buffer,
+                            InterpreterEvents* events) {
+    CountRun();
+    return jit_->RunWithViews<kForceZeroCopy>(args, result_buffer, events);
+  }
+
+  // Starts the recompilation if it has not started yet, waits for it to finish
+  // and switches to the optimized code. Returns the status of the
+  // recompilation.
+  absl::Status WaitForOptimizedCode();
+
+  // Returns true if runs use the optimized code.
+  bool optimized() const { return optimized_; }
+
+  // Returns the JIT currently used by runs. It is replaced when switching to
+  // the optimized code.
+  FunctionJit* current_jit() const { return jit_.get(); }
+
+ private:
+  TieredFunctionJit(Function* function, const TieredJitOptions& options,
+                    std::unique_ptr<FunctionJit> initial_jit)
+      : function_(function), options_(options), jit_(std::move(initial_jit)) {}
+
+  // Counts a run and starts the recompilation or switches to its result when
+  // due.
+  void CountRun();
+  void StartRecompilation();
+  void SwitchToOptimizedCode();
+
+  Function* function_;
+  TieredJitOptions options_;
+  std::unique_ptr<FunctionJit> jit_;
+  int64_t run_count_ = 0;
+  bool optimized_ = false;
+  // Whether the result of the recompilation has been consumed.
+  bool recompilation_done_ = false;
+
+  std::unique_ptr<Thread> compile_thread_;
+  std::atomic<bool> recompilation_finished_ = false;
+  absl::Mutex mutex_;
+  std::unique_ptr<FunctionJit> optimized_jit_ ABSL_GUARDED_BY(mutex_);
+  absl::Status recompilation_status_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_TIERED_FUNCTION_JIT_H_
@@ -0,0 +1,98 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/tiered_function_jit.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_jit.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOk;
+
+class TieredFunctionJitTest : public IrTestBase {};
+
+constexpr char kMulAdd[] = R"(
+fn muladd(x: bits[32], y: bits[32], z: bits[32]) -> bits[32] {
+  umul.4: bits[32] = umul(x, y)
+  ret add.5: bits[32] = add(umul.4, z)
+}
+)";
+
+TEST_F(TieredFunctionJitTest, SwitchesToOptimizedCodeWhenHot) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(kMulAdd, p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TieredFunctionJit> jit,
+      TieredFunctionJit::Create(f, {.hot_run_count = 3}));
+  FunctionJit* initial_jit = jit->current_jit();
+
+  for (int64_t i = 0; i < 5; ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        InterpreterResult<Value> result,
+        jit->Run({Value(UBits(i, 32)), Value(UBits(3, 32)),
+                  Value(UBits(1, 32))}));
+    EXPECT_EQ(result.value, Value(UBits(3 * i + 1, 32)));
+  }
+  EXPECT_THAT(jit->WaitForOptimizedCode(), IsOk());
+  EXPECT_TRUE(jit->optimized());
+  EXPECT_NE(jit->current_jit(), initial_jit);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      InterpreterResult<Value> result,
+      jit->Run({Value(UBits(7, 32)), Value(UBits(6, 32)),
+                Value(UBits(5, 32))}));
+  EXPECT_EQ(result.value, Value(UBits(47, 32)));
+}
+
+TEST_F(TieredFunctionJitTest, RunWithViewsAcrossTiers) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(kMulAdd, p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TieredFunctionJit> jit,
+      TieredFunctionJit::Create(f, {.hot_run_count = 0}));
+
+  uint32_t x = 2, y = 10, z = 4, result = 0;
+  std::vector<uint8_t*> args = {reinterpret_cast<uint8_t*>(&x),
+                                reinterpret_cast<uint8_t*>(&y),
+                                reinterpret_cast<uint8_t*>(&z)};
+  absl::Span<uint8_t> result_buffer(reinterpret_cast<uint8_t*>(&result),
+                                    sizeof(result));
+  InterpreterEvents events;
+  XLS_ASSERT_OK(jit->RunWithViews(args, result_buffer, &events));
+  EXPECT_EQ(result, 24);
+
+  XLS_ASSERT_OK(jit->WaitForOptimizedCode());
+  EXPECT_TRUE(jit->optimized());
+  z = 5;
+  XLS_ASSERT_OK(jit->RunWithViews(args, result_buffer, &events));
+  EXPECT_EQ(result, 25);
+}
+
+}  // namespace
+}  // namespace xls
@@ -28,6 +28,7 @@
 #include "absl/types/span.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/data_structures/inline_bitmap.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
@@ -198,6 +199,115 @@ std::vector<uint8_t> TypeLayout::mask() const {
   return res;
 }
 
+PackedTypeLayout::PackedTypeLayout(absl::Span<Type* const> types)
+    : types_(types.begin(), types.end()) {
+  bit_offsets_.reserve(types.size());
+  for (Type* type : types) {
+    bit_offsets_.push_back(bit_count_);
+    bit_count_ += type->GetFlatBitCount();
+  }
+}
+
+// Writes the leaves of `value` into `buffer` in packed order starting at bit
+// `*bit_offset`, advancing `*bit_offset` past the written bits.
+static void ValueToPackedLayoutInternal(const Value& value,
+                                        int64_t* bit_offset,
+                                        uint8_t* buffer) {
+  if (value.IsBits()) {
+    const Bits& bits = value.bits();
+    for (int64_t i = 0; i < bits.bit_count(); ++i) {
+      int64_t bit = *bit_offset + i;
+      uint8_t mask = uint8_t{1} << (bit % 8);
+      if (bits.Get(i)) {
+        buffer[bit / 8] |= mask;
+      } else {
+        buffer[bit / 8] &= ~mask;
+      }
+    }
+    *bit_offset += bits.bit_count();
+    return;
+  }
+  if (value.IsToken()) {
+    return;
+  }
+  if (value.IsTuple()) {
+    for (int64_t i = value.size() - 1; i >= 0; --i) {
+      ValueToPackedLayoutInternal(value.element(i), bit_offset, buffer);
+    }
+    return;
+  }
+  CHECK(value.IsArray());
+  for (int64_t i = 0; i < value.size(); ++i) {
+    ValueToPackedLayoutInternal(value.element(i), bit_offset, buffer);
+  }
+}
+
+// Reads a value of type `type` stored in packed order in `buffer` starting at
+// bit `*bit_offset`, advancing `*bit_offset` past the read bits.
+static Value PackedLayoutToValueInternal(Type* type, const uint8_t* buffer,
+                                         int64_t* bit_offset) {
+  if (type->IsBits()) {
+    int64_t bit_count = type->AsBitsOrDie()->bit_count();
+    InlineBitmap bitmap(bit_count);
+    for (int64_t i = 0; i < bit_count; ++i) {
+      int64_t bit = *bit_offset + i;
+      bitmap.Set(i, (buffer[bit / 8] >> (bit % 8)) & 1);
+    }
+    *bit_offset += bit_count;
+    return Value(Bits::FromBitmap(std::move(bitmap)));
+  }
+  if (type->IsToken()) {
+    return Value::Token();
+  }
+  if (type->IsTuple()) {
+    TupleType* tuple_type = type->AsTupleOrDie();
+    std::vector<Value> elements(tuple_type->size());
+    for (int64_t i = tuple_type->size() - 1; i >= 0; --i) {
+      elements[i] = PackedLayoutToValueInternal(tuple_type->element_type(i),
+                                                buffer, bit_offset);
+    }
+    return Value::TupleOwned(std::move(elements));
+  }
+  CHECK(type->IsArray());
+  ArrayType* array_type = type->AsArrayOrDie();
+  std::vector<Value> elements;
+  elements.reserve(array_type->size());
+  for (int64_t i = 0; i < array_type->size(); ++i) {
+    elements.push_back(PackedLayoutToValueInternal(array_type->element_type(),
+                                                   buffer, bit_offset));
+  }
+  return Value::ArrayOwned(std::move(elements));
+}
+
+void PackedTypeLayout::ValueToPackedLayout(int64_t index, const Value& value,
+                                           uint8_t* buffer) const {
+  DCHECK(ValueConformsToType(value, types_.at(index))) << absl::StreamFormat(
+      "Value `%s` is not of type `%s`", value.ToString(),
+      types_.at(index)->ToString());
+  int64_t bit_offset = bit_offsets_.at(index);
+  ValueToPackedLayoutInternal(value, &bit_offset, buffer);
+}
+
+Value PackedTypeLayout::PackedLayoutToValue(int64_t index,
+                                            const uint8_t* buffer) const {
+  int64_t bit_offset = bit_offsets_.at(index);
+  return PackedLayoutToValueInternal(types_.at(index), buffer, &bit_offset);
+}
+
+std::string PackedTypeLayout::ToString() const {
+  std::vector<std::string> lines;
+  lines.push_back("PackedTypeLayout {");
+  lines.push_back(absl::StrFormat("  size = %d", size()));
+  lines.push_back("  elements = {");
+  for (int64_t i = 0; i < types_.size(); ++i) {
+    lines.push_back(absl::StrFormat("    %s @ bit %d", types_[i]->ToString(),
+                                    bit_offsets_[i]));
+  }
+  lines.push_back("  }");
+  lines.push_back("}");
+  return absl::StrJoin(lines, "\n");
+}
+
 std::ostream& operator<<(std::ostream& os, ElementLayout layout) {
   os << layout.ToString();
   return os;
@@ -208,4 +318,9 @@ std::ostream& operator<<(std::ostream& os, const TypeLayout& layout) {
   return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const PackedTypeLayout& layout) {
+  os << layout.ToString();
+  return os;
+}
+
 }  // namespace xls
@@ -23,6 +23,7 @@
 #include "absl/log/check.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "xls/common/math_util.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
@@ -32,9 +33,8 @@ namespace xls {
 
 // Data structure describing the layout of a single leaf element of an xls::Type
 // in the native layout used by the JIT. All offsets and sizes are in
-// bytes. Sub-byte alignment is not supported.
-// TODO(meheff): 2022/11/08 Add support for sub-byte alignment to allow
-// expression of our "packed" representation.
+// bytes. Sub-byte alignment is not supported; see PackedTypeLayout for the
+// bit-packed representation.
 struct ElementLayout {
   // Byte offset of this leaf element in the type it is contained in.
   int64_t offset;
@@ -127,8 +127,57 @@ class TypeLayout {
   std::vector<ElementLayout> elements_;
 };
 
+// Layout of a sequence of values of the given types (e.g., the state elements
+// of a proc) bit-packed back to back into a single buffer with no padding.
+// Value `i` occupies `types[i]->GetFlatBitCount()` bits starting at bit
+// `bit_offset(i)`, where bit `k` of the buffer is bit `k % 8` of byte `k / 8`.
+// Within a value the bits are in the packed order used by the JIT: the
+// elements of a tuple are stored from the last element at the lowest bits and
+// the elements of an array from element 0 at the lowest bits. Example:
+//
+// Types                      Bit offsets   Size (bytes)
+// ------------------------------------------------------
+// bits[1], bits[3], bits[1]  0, 1, 4       1
+// bits[7], (bits[2], token)  0, 7          2
+//
+// Compared to the native layout, where each leaf is padded to at least a byte,
+// this shrinks values made of many narrow leaves at the cost of shifting and
+// masking on every access.
+class PackedTypeLayout {
+ public:
+  explicit PackedTypeLayout(absl::Span<Type* const> types);
+
+  // Writes `value` into the bits of the `index`-th value in `buffer`. Other
+  // bits of `buffer` are left unchanged. `buffer` must have room for at least
+  // `size()` bytes.
+  void ValueToPackedLayout(int64_t index, const Value& value,
+                           uint8_t* buffer) const;
+
+  // Returns the `index`-th value stored in `buffer`.
+  Value PackedLayoutToValue(int64_t index, const uint8_t* buffer) const;
+
+  absl::Span<Type* const> types() const { return types_; }
+
+  // Returns the offset in bits of the `index`-th value in the buffer.
+  int64_t bit_offset(int64_t index) const { return bit_offsets_.at(index); }
+
+  // Returns the total number of bits of the packed values.
+  int64_t bit_count() const { return bit_count_; }
+
+  // Returns the number of bytes the packed values occupy.
+  int64_t size() const { return CeilOfRatio(bit_count_, int64_t{8}); }
+
+  std::string ToString() const;
+
+ private:
+  std::vector<Type*> types_;
+  std::vector<int64_t> bit_offsets_;
+  int64_t bit_count_ = 0;
+};
+
 std::ostream& operator<<(std::ostream& os, ElementLayout layout);
 std::ostream& operator<<(std::ostream& os, const TypeLayout& layout);
+std::ostream& operator<<(std::ostream& os, const PackedTypeLayout& layout);
 
 }  // namespace xls
 
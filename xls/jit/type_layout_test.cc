@@ -371,5 +371,74 @@ TEST_F(TypeLayoutTest, JitTypes) {
   }
 }
 
+TEST_F(TypeLayoutTest, PackedLayout) {
+  auto package = CreatePackage();
+  std::vector<Type*> types;
+  for (const char* type_str :
+       {"bits[1]", "bits[3]", "(bits[2], bits[5])", "bits[1][2]"}) {
+    XLS_ASSERT_OK_AND_ASSIGN(Type * type,
+                             Parser::ParseType(type_str, package.get()));
+    types.push_back(type);
+  }
+  PackedTypeLayout layout(types);
+  EXPECT_EQ(layout.bit_offset(0), 0);
+  EXPECT_EQ(layout.bit_offset(1), 1);
+  EXPECT_EQ(layout.bit_offset(2), 4);
+  EXPECT_EQ(layout.bit_offset(3), 11);
+  EXPECT_EQ(layout.bit_count(), 13);
+  EXPECT_EQ(layout.size(), 2);
+
+  std::vector<Value> values = {
+      Value(UBits(1, 1)), Value(UBits(0b101, 3)),
+      Value::Tuple({Value(UBits(0b10, 2)), Value(UBits(0b10011, 5))}),
+      Value::UBitsArray({1, 0}, 1).value()};
+  std::vector<uint8_t> buffer(layout.size(), 0);
+  for (int64_t i = 0; i < values.size(); ++i) {
+    layout.ValueToPackedLayout(i, values[i], buffer.data());
+  }
+  // Tuple elements are packed from the last element at the lowest bits, array
+  // elements from element 0.
+  EXPECT_THAT(buffer, ElementsAre(0x3b, 0x0d));
+  for (int64_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(layout.PackedLayoutToValue(i, buffer.data()), values[i]);
+  }
+
+  // Overwriting a value leaves its neighbors unchanged.
+  layout.ValueToPackedLayout(1, Value(UBits(0b010, 3)), buffer.data());
+  EXPECT_THAT(buffer, ElementsAre(0x35, 0x0d));
+  EXPECT_EQ(layout.PackedLayoutToValue(0, buffer.data()), values[0]);
+  EXPECT_EQ(layout.PackedLayoutToValue(2, buffer.data()), values[2]);
+}
+
+TEST_F(TypeLayoutTest, PackedLayoutRoundTrip) {
+  constexpr int64_t kValuesPerType = 10;
+  auto package = CreatePackage();
+  std::minstd_rand bitgen;
+  std::vector<Type*> types;
+  for (const char* type_str :
+       {"bits[1]", "()", "bits[3]", "token", "bits[64]", "bits[1][100]",
+        "(bits[1], (bits[8], bits[16], bits[1][3])[2], bits[77])", "bits[0]",
+        "bits[1024]"}) {
+    XLS_ASSERT_OK_AND_ASSIGN(Type * type,
+                             Parser::ParseType(type_str, package.get()));
+    types.push_back(type);
+  }
+  PackedTypeLayout layout(types);
+  VLOG(1) << layout.ToString();
+
+  for (int64_t i = 0; i < kValuesPerType; ++i) {
+    std::vector<Value> values;
+    std::vector<uint8_t> buffer(layout.size(), 0xff);
+    for (int64_t j = 0; j < types.size(); ++j) {
+      values.push_back(RandomValue(types[j], bitgen));
+      layout.ValueToPackedLayout(j, values[j], buffer.data());
+    }
+    XLS_VLOG_LINES(1, BytesToString(buffer));
+    for (int64_t j = 0; j < types.size(); ++j) {
+      EXPECT_EQ(layout.PackedLayoutToValue(j, buffer.data()), values[j]);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,288 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/wide_arithmetic.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/log/check.h"
+#include "absl/numeric/bits.h"
+#include "absl/types/span.h"
+
+namespace xls {
+namespace {
+
+using uint128_t = unsigned __int128;
+
+// Returns the number of words of `value` without its leading zero words.
+int64_t SignificantWords(absl::Span<const uint64_t> value) {
+  int64_t size = value.size();
+  while (size > 0 && value[size - 1] == 0) {
+    --size;
+  }
+  return size;
+}
+
+// Adds `addend` to `sum`, dropping the carry out of `sum`. Words of `addend`
+// beyond the end of `sum` must be zero.
+void AddInto(absl::Span<uint64_t> sum, absl::Span<const uint64_t> addend) {
+  uint64_t carry = 0;
+  int64_t i = 0;
+  for (; i < addend.size() && i < sum.size(); ++i) {
+    uint128_t word = uint128_t{sum[i]} + addend[i] + carry;
+    sum[i] = static_cast<uint64_t>(word);
+    carry = static_cast<uint64_t>(word >> 64);
+  }
+  for (; carry != 0 && i < sum.size(); ++i) {
+    carry = ++sum[i] == 0 ? 1 : 0;
+  }
+}
+
+// Subtracts `subtrahend` from `difference`, which must not be smaller.
+void SubtractFrom(absl::Span<uint64_t> difference,
+                  absl::Span<const uint64_t> subtrahend) {
+  uint64_t borrow = 0;
+  int64_t i = 0;
+  for (; i < subtrahend.size(); ++i) {
+    uint64_t x = difference[i];
+    uint64_t y = subtrahend[i];
+    difference[i] = x - y - borrow;
+    borrow = (x < y || x - y < borrow) ? 1 : 0;
+  }
+  for (; borrow != 0 && i < difference.size(); ++i) {
+    borrow = difference[i]-- == 0 ? 1 : 0;
+  }
+}
+
+// Sets `product` to the low words of `lhs * rhs` by multiplying word by word.
+void SchoolbookMultiply(absl::Span<const uint64_t> lhs,
+                        absl::Span<const uint64_t> rhs,
+                        absl::Span<uint64_t> product) {
+  std::fill(product.begin(), product.end(), 0);
+  for (int64_t i = 0; i < lhs.size() && i < product.size(); ++i) {
+    if (lhs[i] == 0) {
+      continue;
+    }
+    uint64_t carry = 0;
+    int64_t j = 0;
+    for (; j < rhs.size() && i + j < product.size(); ++j) {
+      uint128_t word = uint128_t{lhs[i]} * rhs[j] + product[i + j] + carry;
+      product[i + j] = static_cast<uint64_t>(word);
+      carry = static_cast<uint64_t>(word >> 64);
+    }
+    if (i + j < product.size()) {
+      product[i + j] = carry;
+    }
+  }
+}
+
+// Sets `product` (2n words) to `lhs * rhs` (n words each).
+void KaratsubaMultiply(absl::Span<const uint64_t> lhs,
+                       absl::Span<const uint64_t> rhs,
+                       absl::Span<uint64_t> product) {
+  const int64_t n = lhs.size();
+  DCHECK_EQ(rhs.size(), n);
+  DCHECK_EQ(product.size(), 2 * n);
+  if (n < kKaratsubaMinWords) {
+    SchoolbookMultiply(lhs, rhs, product);
+    return;
+  }
+  // lhs = lhs_high * B^low + lhs_low where B = 2^64, and likewise for rhs.
+  const int64_t low = n / 2;
+  const int64_t high = n - low;
+  absl::Span<const uint64_t> lhs_low = lhs.first(low);
+  absl::Span<const uint64_t> lhs_high = lhs.subspan(low);
+  absl::Span<const uint64_t> rhs_low = rhs.first(low);
+  absl::Span<const uint64_t> rhs_high = rhs.subspan(low);
+
+  // product = z2 * B^(2 low) + z1 * B^low + z0 where
+  //   z0 = lhs_low * rhs_low
+  //   z2 = lhs_high * rhs_high
+  //   z1 = (lhs_low + lhs_high) * (rhs_low + rhs_high) - z0 - z2
+  absl::Span<uint64_t> z0 = product.first(2 * low);
+  absl::Span<uint64_t> z2 = product.subspan(2 * low);
+  KaratsubaMultiply(lhs_low, rhs_low, z0);
+  KaratsubaMultiply(lhs_high, rhs_high, z2);
+
+  std::vector<uint64_t> lhs_sum(lhs_high.begin(), lhs_high.end());
+  lhs_sum.push_back(0);
+  AddInto(absl::MakeSpan(lhs_sum), lhs_low);
+  std::vector<uint64_t> rhs_sum(rhs_high.begin(), rhs_high.end());
+  rhs_sum.push_back(0);
+  AddInto(absl::MakeSpan(rhs_sum), rhs_low);
+  std::vector<uint64_t> z1(2 * (high + 1));
+  KaratsubaMultiply(lhs_sum, rhs_sum, absl::MakeSpan(z1));
+  SubtractFrom(absl::MakeSpan(z1), z0);
+  SubtractFrom(absl::MakeSpan(z1), z2);
+  AddInto(product.subspan(low), z1);
+}
+
+// Sets `product` to the low n words of `lhs * rhs` (n words each).
+void TruncatedMultiply(absl::Span<const uint64_t> lhs,
+                       absl::Span<const uint64_t> rhs,
+                       absl::Span<uint64_t> product) {
+  const int64_t n = product.size();
+  if (n < kKaratsubaMinWords) {
+    SchoolbookMultiply(lhs, rhs, product);
+    return;
+  }
+  // Modulo B^n, lhs * rhs = lhs_low * rhs_low + B^low * (lhs_high * rhs_low +
+  // lhs_low * rhs_high) where only the low n - low words of the cross terms
+  // matter.
+  const int64_t low = n - n / 2;
+  const int64_t high = n - low;
+  std::vector<uint64_t> low_product(2 * low);
+  KaratsubaMultiply(lhs.first(low), rhs.first(low),
+                    absl::MakeSpan(low_product));
+  std::copy_n(low_product.begin(), n, product.begin());
+  std::vector<uint64_t> cross(high);
+  TruncatedMultiply(lhs.subspan(low, high), rhs.first(high),
+                    absl::MakeSpan(cross));
+  AddInto(product.subspan(low), cross);
+  TruncatedMultiply(lhs.first(high), rhs.subspan(low, high),
+                    absl::MakeSpan(cross));
+  AddInto(product.subspan(low), cross);
+}
+
+}  // namespace
+
+void WideMultiply(absl::Span<const uint64_t> lhs,
+                  absl::Span<const uint64_t> rhs,
+                  absl::Span<uint64_t> product) {
+  const int64_t n = product.size();
+  CHECK_GE(lhs.size(), n);
+  CHECK_GE(rhs.size(), n);
+  int64_t lhs_words = SignificantWords(lhs.first(n));
+  int64_t rhs_words = SignificantWords(rhs.first(n));
+  int64_t operand_words = std::max(lhs_words, rhs_words);
+  if (std::min(lhs_words, rhs_words) < kKaratsubaMinWords) {
+    SchoolbookMultiply(lhs.first(lhs_words), rhs.first(rhs_words), product);
+  } else if (2 * operand_words <= n) {
+    // Operands zero-extended to the product width, as when computing a full
+    // product, don't need truncation.
+    std::fill(product.begin() + 2 * operand_words, product.end(), 0);
+    KaratsubaMultiply(lhs.first(operand_words), rhs.first(operand_words),
+                      product.first(2 * operand_words));
+  } else {
+    TruncatedMultiply(lhs.first(n), rhs.first(n), product);
+  }
+}
+
+void WideDivide(absl::Span<const uint64_t> lhs, absl::Span<const uint64_t> rhs,
+                absl::Span<uint64_t> quotient,
+                absl::Span<uint64_t> remainder) {
+  CHECK_EQ(rhs.size(), lhs.size());
+  CHECK_EQ(quotient.size(), lhs.size());
+  CHECK_EQ(remainder.size(), lhs.size());
+  std::fill(quotient.begin(), quotient.end(), 0);
+  std::fill(remainder.begin(), remainder.end(), 0);
+  const int64_t m = SignificantWords(lhs);
+  const int64_t n = SignificantWords(rhs);
+  CHECK_GT(n, 0) << "Division by zero";
+  if (m < n) {
+    std::copy(lhs.begin(), lhs.end(), remainder.begin());
+    return;
+  }
+  if (n == 1) {
+    uint64_t divisor = rhs[0];
+    uint64_t rest = 0;
+    for (int64_t j = m - 1; j >= 0; --j) {
+      uint128_t dividend = (uint128_t{rest} << 64) | lhs[j];
+      quotient[j] = static_cast<uint64_t>(dividend / divisor);
+      rest = static_cast<uint64_t>(dividend % divisor);
+    }
+    remainder[0] = rest;
+    return;
+  }
+
+  // Normalize so the top word of the divisor has its high bit set, which
+  // bounds the error of each quotient word estimate by two.
+  const int shift = absl::countl_zero(rhs[n - 1]);
+  auto shifted_word = [shift](absl::Span<const uint64_t> value, int64_t i) {
+    uint64_t high = i < value.size() ? value[i] << shift : 0;
+    uint64_t low = (shift == 0 || i == 0) ? 0 : value[i - 1] >> (64 - shift);
+    return high | low;
+  };
+  absl::InlinedVector<uint64_t, 16> divisor(n);
+  for (int64_t i = 0; i < n; ++i) {
+    divisor[i] = shifted_word(rhs, i);
+  }
+  absl::InlinedVector<uint64_t, 16> rest(m + 1);
+  for (int64_t i = 0; i <= m; ++i) {
+    rest[i] = shifted_word(lhs.first(m), i);
+  }
+
+  const uint64_t divisor_top = divisor[n - 1];
+  const uint64_t divisor_next = divisor[n - 2];
+  for (int64_t j = m - n; j >= 0; --j) {
+    // Estimate the quotient word from the top two words of the remainder.
+    uint128_t top = (uint128_t{rest[j + n]} << 64) | rest[j + n - 1];
+    uint128_t estimate = top / divisor_top;
+    uint128_t estimate_rest = top % divisor_top;
+    while ((estimate >> 64) != 0 ||
+           estimate * divisor_next >
+               ((estimate_rest << 64) | rest[j + n - 2])) {
+      --estimate;
+      estimate_rest += divisor_top;
+      if ((estimate_rest >> 64) != 0) {
+        break;
+      }
+    }
+
+    // Subtract estimate * divisor from the remainder.
+    uint64_t word_estimate = static_cast<uint64_t>(estimate);
+    uint64_t carry = 0;
+    uint64_t borrow = 0;
+    for (int64_t i = 0; i < n; ++i) {
+      uint128_t product = uint128_t{word_estimate} * divisor[i] + carry;
+      carry = static_cast<uint64_t>(product >> 64);
+      uint64_t product_low = static_cast<uint64_t>(product);
+      uint64_t x = rest[i + j];
+      uint64_t difference = x - product_low;
+      uint64_t next_borrow = x < product_low ? 1 : 0;
+      next_borrow += difference < borrow ? 1 : 0;
+      rest[i + j] = difference - borrow;
+      borrow = next_borrow;
+    }
+    uint64_t x = rest[j + n];
+    uint64_t difference = x - carry;
+    bool negative = x < carry || difference < borrow;
+    rest[j + n] = difference - borrow;
+
+    quotient[j] = word_estimate;
+    if (negative) {
+      // The estimate was one too large; add the divisor back.
+      --quotient[j];
+      uint64_t add_carry = 0;
+      for (int64_t i = 0; i < n; ++i) {
+        uint128_t sum = uint128_t{rest[i + j]} + divisor[i] + add_carry;
+        rest[i + j] = static_cast<uint64_t>(sum);
+        add_carry = static_cast<uint64_t>(sum >> 64);
+      }
+      rest[j + n] += add_carry;
+    }
+  }
+
+  // Denormalize the remainder.
+  for (int64_t i = 0; i < n; ++i) {
+    uint64_t high =
+        (shift == 0 || i == n - 1) ? 0 : rest[i + 1] << (64 - shift);
+    remainder[i] = (rest[i] >> shift) | high;
+  }
+}
+
+}  // namespace xls
@@ -0,0 +1,46 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_WIDE_ARITHMETIC_H_
+#define XLS_JIT_WIDE_ARITHMETIC_H_
+
+#include <cstdint>
+
+#include "absl/types/span.h"
+
+// Unsigned arithmetic on integers wider than LLVM lowers efficiently. The JIT
+// calls these for multiplications and divisions wider than 128 bits rather
+// than emitting LLVM's expansions. Integers are little-endian arrays of 64-bit
+// words.
+
+namespace xls {
+
+// Operands at least this many words long are multiplied with Karatsuba's
+// algorithm rather than word by word.
+inline constexpr int64_t kKaratsubaMinWords = 24;
+
+// Sets `product` to the low `product.size()` words of `lhs * rhs`. The
+// operands must be at least as long as `product`.
+void WideMultiply(absl::Span<const uint64_t> lhs,
+                  absl::Span<const uint64_t> rhs, absl::Span<uint64_t> product);
+
+// Sets `quotient` and `remainder` to the quotient and remainder of
+// `lhs / rhs`. All spans must have the same length and `rhs` must not be zero.
+// Uses Knuth's algorithm D (TAOCP vol. 2, 4.3.1).
+void WideDivide(absl::Span<const uint64_t> lhs, absl::Span<const uint64_t> rhs,
+                absl::Span<uint64_t> quotient, absl::Span<uint64_t> remainder);
+
+}  // namespace xls
+
+#endif  // XLS_JIT_WIDE_ARITHMETIC_H_
@@ -0,0 +1,131 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/wide_arithmetic.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/random/random.h"
+#include "absl/types/span.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+
+namespace xls {
+namespace {
+
+Bits ToBits(absl::Span<const uint64_t> words) {
+  std::vector<uint8_t> bytes(words.size() * sizeof(uint64_t));
+  std::memcpy(bytes.data(), words.data(), bytes.size());
+  return Bits::FromBytes(bytes, bytes.size() * 8);
+}
+
+// Returns `word_count` words of which the low `significant_words` are
+// nonzero-ish, drawn to include the boundary values the algorithms special
+// case.
+std::vector<uint64_t> RandomWords(int64_t word_count, int64_t significant_words,
+                                  absl::BitGen& bitgen) {
+  std::vector<uint64_t> words(word_count, 0);
+  for (int64_t i = 0; i < significant_words; ++i) {
+    switch (absl::Uniform(bitgen, 0, 6)) {
+      case 0:
+        words[i] = 0;
+        break;
+      case 1:
+        words[i] = std::numeric_limits<uint64_t>::max();
+        break;
+      case 2:
+        words[i] = uint64_t{1} << 63;
+        break;
+      case 3:
+        words[i] = (uint64_t{1} << 63) - 1;
+        break;
+      default:
+        words[i] = absl::Uniform<uint64_t>(bitgen);
+        break;
+    }
+  }
+  if (significant_words > 0 && words[significant_words - 1] == 0) {
+    words[significant_words - 1] = 1;
+  }
+  return words;
+}
+
+TEST(WideArithmeticTest, MultiplyMatchesBitsOps) {
+  absl::BitGen bitgen;
+  for (int64_t word_count :
+       {1, 2, 3, 8, kKaratsubaMinWords - 1, kKaratsubaMinWords,
+        kKaratsubaMinWords + 1, 2 * kKaratsubaMinWords + 3, 100}) {
+    for (int64_t i = 0; i < 20; ++i) {
+      std::vector<uint64_t> lhs = RandomWords(
+          word_count, absl::Uniform<int64_t>(absl::IntervalClosed, bitgen, 0,
+                                             word_count),
+          bitgen);
+      std::vector<uint64_t> rhs = RandomWords(
+          word_count, absl::Uniform<int64_t>(absl::IntervalClosed, bitgen, 0,
+                                             word_count),
+          bitgen);
+      std::vector<uint64_t> product(word_count);
+      WideMultiply(lhs, rhs, absl::MakeSpan(product));
+      EXPECT_EQ(ToBits(product),
+                bits_ops::UMul(ToBits(lhs), ToBits(rhs))
+                    .Slice(0, word_count * 64))
+          << "words: " << word_count;
+    }
+  }
+}
+
+TEST(WideArithmeticTest, DivideMatchesBitsOps) {
+  absl::BitGen bitgen;
+  for (int64_t word_count : {1, 2, 3, 4, 8, 17, 32}) {
+    for (int64_t i = 0; i < 50; ++i) {
+      std::vector<uint64_t> lhs = RandomWords(
+          word_count, absl::Uniform<int64_t>(absl::IntervalClosed, bitgen, 0,
+                                             word_count),
+          bitgen);
+      std::vector<uint64_t> rhs = RandomWords(
+          word_count, absl::Uniform<int64_t>(absl::IntervalClosed, bitgen, 1,
+                                             word_count),
+          bitgen);
+      std::vector<uint64_t> quotient(word_count);
+      std::vector<uint64_t> remainder(word_count);
+      WideDivide(lhs, rhs, absl::MakeSpan(quotient),
+                 absl::MakeSpan(remainder));
+      EXPECT_EQ(ToBits(quotient), bits_ops::UDiv(ToBits(lhs), ToBits(rhs)))
+          << "words: " << word_count;
+      EXPECT_EQ(ToBits(remainder), bits_ops::UMod(ToBits(lhs), ToBits(rhs)))
+          << "words: " << word_count;
+    }
+  }
+}
+
+TEST(WideArithmeticTest, DivideNeedingCorrection) {
+  // A divisor whose top word is exactly half the base stresses the
+  // correction of the estimated quotient words.
+  std::vector<uint64_t> lhs = {std::numeric_limits<uint64_t>::max(),
+                               std::numeric_limits<uint64_t>::max(),
+                               (uint64_t{1} << 63) - 1, 0};
+  std::vector<uint64_t> rhs = {1, uint64_t{1} << 63, 0, 0};
+  std::vector<uint64_t> quotient(4);
+  std::vector<uint64_t> remainder(4);
+  WideDivide(lhs, rhs, absl::MakeSpan(quotient), absl::MakeSpan(remainder));
+  EXPECT_EQ(ToBits(quotient), bits_ops::UDiv(ToBits(lhs), ToBits(rhs)));
+  EXPECT_EQ(ToBits(remainder), bits_ops::UMod(ToBits(lhs), ToBits(rhs)));
+}
+
+}  // namespace
+}  // namespace xls
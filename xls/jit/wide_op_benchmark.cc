@@ -0,0 +1,141 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "absl/log/check.h"
+#include "absl/strings/substitute.h"
+#include "include/benchmark/benchmark.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_buffer.h"
+
+namespace xls {
+namespace {
+
+// Measure the performance of jitted bits operations on wide values. `$0` is
+// the width of the operands and `$1` half of it. Each function applies its
+// operation several times in a dependent chain so it dominates the call
+// overhead.
+constexpr int kNumOps = 8;
+const char* kOpNames[] = {
+    "and", "xor", "add", "sub", "shll", "shra", "concat", "bit_slice",
+};
+const char* kOpIr[] = {
+    // and
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      a: bits[$0] = and(x, y)
+      b: bits[$0] = and(a, x)
+      c: bits[$0] = and(b, y)
+      ret d: bits[$0] = and(c, x)
+    })",
+    // xor
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      a: bits[$0] = xor(x, y)
+      b: bits[$0] = xor(a, x)
+      c: bits[$0] = xor(b, y)
+      ret d: bits[$0] = xor(c, x)
+    })",
+    // add
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      a: bits[$0] = add(x, y)
+      b: bits[$0] = add(a, x)
+      c: bits[$0] = add(b, y)
+      ret d: bits[$0] = add(c, x)
+    })",
+    // sub
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      a: bits[$0] = sub(x, y)
+      b: bits[$0] = sub(a, x)
+      c: bits[$0] = sub(b, y)
+      ret d: bits[$0] = sub(c, x)
+    })",
+    // shll
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      a: bits[$0] = shll(x, s)
+      b: bits[$0] = shll(a, s)
+      c: bits[$0] = shll(b, s)
+      ret d: bits[$0] = shll(c, s)
+    })",
+    // shra
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      a: bits[$0] = shra(x, s)
+      b: bits[$0] = shra(a, s)
+      c: bits[$0] = shra(b, s)
+      ret d: bits[$0] = shra(c, s)
+    })",
+    // concat
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      x_hi: bits[$1] = bit_slice(x, start=$1, width=$1)
+      y_lo: bits[$1] = bit_slice(y, start=0, width=$1)
+      a: bits[$0] = concat(x_hi, y_lo)
+      a_lo: bits[$1] = bit_slice(a, start=0, width=$1)
+      ret b: bits[$0] = concat(a_lo, x_hi)
+    })",
+    // bit_slice
+    R"(fn f(x: bits[$0], y: bits[$0], s: bits[32]) -> bits[$0] {
+      a: bits[$1] = bit_slice(x, start=3, width=$1)
+      b: bits[$1] = bit_slice(y, start=7, width=$1)
+      c: bits[$0] = concat(a, b)
+      ret d: bits[$0] = bit_slice(c, start=0, width=$0)
+    })",
+};
+
+static void BM_WideOp(benchmark::State& state) {
+  int64_t width = state.range(1);
+  state.SetLabel(absl::Substitute("$0/bits[$1]", kOpNames[state.range(0)],
+                                  width));
+  Package package("BM");
+  Function* function =
+      Parser::ParseFunction(
+          absl::Substitute(kOpIr[state.range(0)], width, width / 2), &package)
+          .value();
+  std::unique_ptr<FunctionJit> jit = FunctionJit::Create(function).value();
+
+  JitArgumentSet args = jit->jitted_function_base().CreateInputBuffer();
+  JitArgumentSet result = jit->jitted_function_base().CreateOutputBuffer();
+  std::minstd_rand bitgen;
+  for (int64_t i = 0; i < 2; ++i) {
+    for (int64_t j = 0; j < jit->GetArgTypeSize(i); ++j) {
+      args.pointers()[i][j] = static_cast<uint8_t>(bitgen());
+    }
+  }
+  uint32_t shift = 13;
+  std::memcpy(args.pointers()[2], &shift, sizeof(shift));
+
+  InterpreterEvents events;
+  for (auto _ : state) {
+    CHECK_OK((jit->RunWithViews</*kForceZeroCopy=*/true>(
+        args.pointers(),
+        absl::MakeSpan(result.pointers()[0], jit->GetReturnTypeSize()),
+        &events)));
+    benchmark::DoNotOptimize(result.pointers()[0][0]);
+  }
+}
+
+BENCHMARK(BM_WideOp)->ArgsProduct({benchmark::CreateDenseRange(0, kNumOps - 1,
+                                                               /*step=*/1),
+                                   {64, 128, 256, 512, 1024, 2048, 4096}});
+
+}  // namespace
+}  // namespace xls
+
+BENCHMARK_MAIN();
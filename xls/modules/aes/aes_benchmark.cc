@@ -0,0 +1,228 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput benchmarks of the AES modules on the XLS runtimes. Each benchmark
+// reports the bytes of plaintext encrypted per second:
+//
+//  * BM_AesEncryptFunctionJit and BM_AesEncryptBlockJit encrypt single blocks
+//    with the `encrypt` function, compiled as a function and as a
+//    combinational block respectively.
+//  * BM_AesGcmSerialProcJit and BM_AesGcmAot encrypt whole messages with the
+//    `aes_gcm` proc, JIT compiled from its IR and ahead-of-time compiled into
+//    the benchmark respectively.
+//
+// The argument of each benchmark is the number of blocks encrypted per
+// iteration (for AES-GCM, the number of blocks in the message).
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "include/benchmark/benchmark.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/get_runfile_path.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/proc_runtime.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/block_jit.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_proc_runtime.h"
+#include "xls/modules/aes/aes_gcm_wrapper.h"
+#include "xls/modules/aes/aes_test_common.h"
+
+namespace xls::aes {
+namespace {
+
+constexpr std::string_view kEncryptIrPath = "xls/modules/aes/aes_encrypt.ir";
+constexpr std::string_view kEncryptBlockIrPath =
+    "xls/modules/aes/aes_encrypt.block.ir";
+constexpr std::string_view kGcmIrPath = "xls/modules/aes/aes_gcm.ir";
+
+constexpr std::string_view kCmdChannelName = "aes_gcm__command_in";
+constexpr std::string_view kDataInChannelName = "aes_gcm__data_r";
+constexpr std::string_view kDataOutChannelName = "aes_gcm__data_s";
+
+// KeyWidth::KEY_256.
+constexpr int64_t kKeyWidth256 = 2;
+
+absl::StatusOr<std::unique_ptr<Package>> ParseIrFile(std::string_view path) {
+  XLS_ASSIGN_OR_RETURN(std::filesystem::path ir_path, GetXlsRunfilePath(path));
+  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
+  return Parser::ParsePackage(ir_text);
+}
+
+Key RandomKey(absl::BitGen& bitgen) {
+  Key key;
+  for (uint8_t& byte : key) {
+    byte = absl::Uniform<uint8_t>(bitgen);
+  }
+  return key;
+}
+
+std::vector<Block> RandomBlocks(int64_t count, absl::BitGen& bitgen) {
+  std::vector<Block> blocks(count);
+  for (Block& block : blocks) {
+    for (uint8_t& byte : block) {
+      byte = absl::Uniform<uint8_t>(bitgen);
+    }
+  }
+  return blocks;
+}
+
+std::vector<Value> RandomBlockValues(int64_t count, absl::BitGen& bitgen) {
+  std::vector<Value> values;
+  for (const Block& block : RandomBlocks(count, bitgen)) {
+    values.push_back(BlockToValue(block).value());
+  }
+  return values;
+}
+
+void BM_AesEncryptFunctionJit(benchmark::State& state) {
+  absl::BitGen bitgen;
+  std::unique_ptr<Package> package = ParseIrFile(kEncryptIrPath).value();
+  Function* encrypt = package->GetTopAsFunction().value();
+  std::unique_ptr<FunctionJit> jit = FunctionJit::Create(encrypt).value();
+
+  Value key = KeyToValue(RandomKey(bitgen)).value();
+  Value key_width(UBits(kKeyWidth256, 2));
+  std::vector<Value> blocks = RandomBlockValues(state.range(0), bitgen);
+  for (auto _ : state) {
+    for (const Value& block : blocks) {
+      InterpreterResult<Value> result =
+          jit->Run({key, key_width, block}).value();
+      benchmark::DoNotOptimize(result.value);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * blocks.size() * kBlockBytes);
+}
+
+void BM_AesEncryptBlockJit(benchmark::State& state) {
+  absl::BitGen bitgen;
+  std::unique_ptr<Package> package = ParseIrFile(kEncryptBlockIrPath).value();
+  xls::Block* block = package->GetTopAsBlock().value();
+  std::unique_ptr<BlockJit> jit = BlockJit::Create(block).value();
+  std::unique_ptr<BlockJitContinuation> continuation = jit->NewContinuation();
+
+  absl::flat_hash_map<std::string, int64_t> port_indices =
+      continuation->GetInputPortIndices();
+  std::vector<Value> inputs(port_indices.size());
+  inputs[port_indices.at("key")] = KeyToValue(RandomKey(bitgen)).value();
+  inputs[port_indices.at("key_width")] = Value(UBits(kKeyWidth256, 2));
+  int64_t block_index = port_indices.at("block");
+  std::vector<Value> blocks = RandomBlockValues(state.range(0), bitgen);
+  for (auto _ : state) {
+    for (const Value& block_value : blocks) {
+      inputs[block_index] = block_value;
+      CHECK_OK(continuation->SetInputPorts(inputs));
+      CHECK_OK(jit->RunOneCycle(*continuation));
+      benchmark::DoNotOptimize(continuation->output_port_pointers());
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * blocks.size() * kBlockBytes);
+}
+
+// Returns the command starting the encryption of a message of `msg_blocks`
+// blocks following `aad_blocks` blocks of additional authenticated data.
+Value GcmCommand(const Key& key, const InitVector& init_vector,
+                 int64_t msg_blocks, int64_t aad_blocks) {
+  return Value::Tuple({
+      Value(UBits(/*encrypt=*/1, 1)),
+      Value(UBits(msg_blocks, 32)),
+      Value(UBits(aad_blocks, 32)),
+      KeyToValue(key).value(),
+      Value(UBits(kKeyWidth256, 2)),
+      InitVectorToValue(init_vector),
+  });
+}
+
+// Encrypts messages of `state.range(0)` blocks, with a single block of
+// additional authenticated data, with the aes_gcm proc in `package` run by
+// `runtime`.
+void RunAesGcm(benchmark::State& state, Package* package,
+               ProcRuntime* runtime) {
+  absl::BitGen bitgen;
+  Channel* cmd_channel = package->GetChannel(kCmdChannelName).value();
+  Channel* data_in_channel = package->GetChannel(kDataInChannelName).value();
+  Channel* data_out_channel = package->GetChannel(kDataOutChannelName).value();
+  ChannelQueue& cmd_queue = runtime->queue_manager().GetQueue(cmd_channel);
+  ChannelQueue& data_in_queue =
+      runtime->queue_manager().GetQueue(data_in_channel);
+  ChannelQueue& data_out_queue =
+      runtime->queue_manager().GetQueue(data_out_channel);
+
+  InitVector init_vector;
+  for (uint8_t& byte : init_vector) {
+    byte = absl::Uniform<uint8_t>(bitgen);
+  }
+  int64_t msg_blocks = state.range(0);
+  Value command =
+      GcmCommand(RandomKey(bitgen), init_vector, msg_blocks, /*aad_blocks=*/1);
+  std::vector<Value> data = RandomBlockValues(msg_blocks + 1, bitgen);
+  // The ciphertext is followed by the authentication tag.
+  absl::flat_hash_map<Channel*, int64_t> output_counts = {
+      {data_out_channel, msg_blocks + 1}};
+  for (auto _ : state) {
+    CHECK_OK(cmd_queue.Write(command));
+    for (const Value& block : data) {
+      CHECK_OK(data_in_queue.Write(block));
+    }
+    CHECK_OK(runtime->TickUntilOutput(output_counts).status());
+    for (int64_t i = 0; i < msg_blocks + 1; ++i) {
+      std::optional<Value> block = data_out_queue.Read();
+      CHECK(block.has_value());
+      benchmark::DoNotOptimize(*block);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * msg_blocks * kBlockBytes);
+}
+
+void BM_AesGcmSerialProcJit(benchmark::State& state) {
+  std::unique_ptr<Package> package = ParseIrFile(kGcmIrPath).value();
+  std::unique_ptr<ProcRuntime> runtime =
+      CreateJitSerialProcRuntime(package.get()).value();
+  RunAesGcm(state, package.get(), runtime.get());
+}
+
+void BM_AesGcmAot(benchmark::State& state) {
+  std::unique_ptr<wrapped::AesGcm> aes_gcm = wrapped::AesGcm::Create().value();
+  auto [package, runtime] = wrapped::AesGcm::TakeRuntime(std::move(aes_gcm));
+  RunAesGcm(state, package.get(), runtime.get());
+}
+
+BENCHMARK(BM_AesEncryptFunctionJit)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_AesEncryptBlockJit)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_AesGcmSerialProcJit)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_AesGcmAot)->Arg(1)->Arg(16)->Arg(128);
+
+}  // namespace
+}  // namespace xls::aes
+
+BENCHMARK_MAIN();
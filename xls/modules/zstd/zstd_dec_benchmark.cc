@@ -0,0 +1,179 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Throughput benchmarks of the ZSTD decoder proc on the XLS runtimes, JIT
+// compiled from its IR and ahead-of-time compiled into the benchmark. Each
+// benchmark reports the bytes of decompressed data produced per second.
+//
+// The argument of each benchmark is the number of frames decoded per
+// iteration. The frames are generated with decodecorpus and consist of raw and
+// RLE blocks, the block types supported by the decoder.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "include/benchmark/benchmark.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/get_runfile_path.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/proc_runtime.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/jit_proc_runtime.h"
+#include "xls/modules/zstd/data_generator.h"
+#include "xls/modules/zstd/zstd_dec_wrapper.h"
+#include "external/zstd/lib/zstd.h"
+
+namespace xls::zstd {
+namespace {
+
+constexpr std::string_view kIrPath = "xls/modules/zstd/zstd_dec_test.ir";
+constexpr std::string_view kInputChannelName = "zstd_dec__input_r";
+constexpr std::string_view kOutputChannelName = "zstd_dec__output_s";
+
+// The decoder consumes and produces 64-bit words.
+constexpr int64_t kWordBytes = 8;
+
+// A compressed frame, split into the words sent to the decoder, and the number
+// of words it decodes to.
+struct EncodedFrame {
+  std::vector<Value> words;
+  int64_t decoded_bytes;
+  int64_t decoded_words;
+};
+
+absl::StatusOr<std::unique_ptr<Package>> ParseIrFile(std::string_view path) {
+  XLS_ASSIGN_OR_RETURN(std::filesystem::path ir_path, GetXlsRunfilePath(path));
+  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
+  return Parser::ParsePackage(ir_text);
+}
+
+// Returns the size of `frame` once decompressed by the reference library.
+int64_t DecodedSize(std::vector<uint8_t> frame) {
+  std::vector<uint8_t> buffer(ZSTD_DStreamOutSize());
+  ZSTD_DCtx* dctx = ZSTD_createDCtx();
+  CHECK(dctx != nullptr);
+  ZSTD_inBuffer input = {frame.data(), frame.size(), 0};
+  int64_t size = 0;
+  while (input.pos < input.size) {
+    ZSTD_outBuffer output = {buffer.data(), buffer.size(), 0};
+    size_t result = ZSTD_decompressStream(dctx, &output, &input);
+    CHECK(!ZSTD_isError(result)) << ZSTD_getErrorName(result);
+    size += output.pos;
+  }
+  ZSTD_freeDCtx(dctx);
+  return size;
+}
+
+std::vector<EncodedFrame> GenerateFrames(int64_t count) {
+  std::vector<EncodedFrame> frames;
+  for (int64_t seed = 0; seed < count; ++seed) {
+    BlockType block_type = seed % 2 == 0 ? BlockType::RAW : BlockType::RLE;
+    std::vector<uint8_t> frame = GenerateFrame(seed, block_type).value();
+    EncodedFrame encoded;
+    encoded.decoded_bytes = DecodedSize(frame);
+    encoded.decoded_words =
+        (encoded.decoded_bytes + kWordBytes - 1) / kWordBytes;
+    for (int64_t i = 0; i < frame.size(); i += kWordBytes) {
+      // The last word is padded with zeros.
+      std::array<uint8_t, kWordBytes> word = {};
+      std::copy(frame.begin() + i,
+                frame.begin() + std::min<int64_t>(i + kWordBytes, frame.size()),
+                word.begin());
+      encoded.words.push_back(
+          Value(Bits::FromBytes(absl::MakeSpan(word), kWordBytes * 8)));
+    }
+    frames.push_back(std::move(encoded));
+  }
+  return frames;
+}
+
+// Decodes `state.range(0)` frames with the decoder proc in `package` run by
+// `runtime`.
+void RunZstdDecoder(benchmark::State& state, Package* package,
+                    ProcRuntime* runtime) {
+  std::vector<EncodedFrame> frames = GenerateFrames(state.range(0));
+  ChannelQueue& input_queue = runtime->queue_manager().GetQueue(
+      package->GetChannel(kInputChannelName).value());
+  Channel* output_channel = package->GetChannel(kOutputChannelName).value();
+  ChannelQueue& output_queue =
+      runtime->queue_manager().GetQueue(output_channel);
+
+  int64_t decoded_bytes = 0;
+  for (auto _ : state) {
+    for (const EncodedFrame& frame : frames) {
+      // As in the decoder's tests, the frame is streamed in while the decoder
+      // runs rather than queued up front.
+      for (const Value& word : frame.words) {
+        CHECK_OK(input_queue.Write(word));
+        CHECK_OK(runtime->Tick());
+      }
+      absl::flat_hash_map<Channel*, int64_t> output_counts = {
+          {output_channel, frame.decoded_words}};
+      CHECK_OK(runtime->TickUntilOutput(output_counts).status());
+      for (int64_t i = 0; i < frame.decoded_words; ++i) {
+        std::optional<Value> word = output_queue.Read();
+        CHECK(word.has_value());
+        benchmark::DoNotOptimize(*word);
+      }
+      decoded_bytes += frame.decoded_bytes;
+
+      // Each frame is decoded from the decoder's initial state.
+      state.PauseTiming();
+      runtime->ResetState();
+      state.ResumeTiming();
+    }
+  }
+  state.SetBytesProcessed(decoded_bytes);
+}
+
+void BM_ZstdDecoderSerialProcJit(benchmark::State& state) {
+  std::unique_ptr<Package> package = ParseIrFile(kIrPath).value();
+  std::unique_ptr<ProcRuntime> runtime =
+      CreateJitSerialProcRuntime(package.get()).value();
+  RunZstdDecoder(state, package.get(), runtime.get());
+}
+
+void BM_ZstdDecoderAot(benchmark::State& state) {
+  std::unique_ptr<wrapped::ZstdDecoder> decoder =
+      wrapped::ZstdDecoder::Create().value();
+  auto [package, runtime] =
+      wrapped::ZstdDecoder::TakeRuntime(std::move(decoder));
+  RunZstdDecoder(state, package.get(), runtime.get());
+}
+
+BENCHMARK(BM_ZstdDecoderSerialProcJit)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK(BM_ZstdDecoderAot)->Arg(1)->Arg(8)->Arg(32);
+
+}  // namespace
+}  // namespace xls::zstd
+
+BENCHMARK_MAIN();
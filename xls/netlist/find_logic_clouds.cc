@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -26,7 +27,7 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/types/span.h"
-#include "xls/data_structures/union_find.h"
+#include "xls/common/thread.h"
 #include "xls/netlist/cell_library.h"
 #include "xls/netlist/netlist.h"
 
@@ -50,36 +51,61 @@ void Cluster::SortCells() {
   std::sort(other_cells_.begin(), other_cells_.end(), cell_name_lt);
 }
 
-std::vector<Cluster> FindLogicClouds(const Module& module,
-                                     bool include_vacuous) {
-  UnionFind<Cell*> cell_to_uf;
+namespace {
 
-  // Gets-or-adds the given cell to the UnionFind.
-  auto get_uf = [&cell_to_uf](Cell* c) -> Cell* {
-    cell_to_uf.Insert(c);
-    return cell_to_uf.Find(c);
-  };
+// A union-find over the dense ids [0, size), with path halving and union by
+// size. Unlike UnionFind<T> it needs no hashing, so it stays cheap on netlists
+// with millions of cells.
+class DenseUnionFind {
+ public:
+  explicit DenseUnionFind(int64_t size) : parent_(size), size_(size, 1) {
+    for (int64_t i = 0; i < size; ++i) {
+      parent_[i] = i;
+    }
+  }
 
-  // Helper for debugging that counts the number of equivalence classes in
-  // cell_to_uf.
-  auto count_equivalence_classes = [&cell_to_uf]() -> int64_t {
-    return cell_to_uf.GetRepresentatives().size();
-  };
+  int64_t Find(int64_t x) {
+    while (parent_[x] != x) {
+      parent_[x] = parent_[parent_[x]];
+      x = parent_[x];
+    }
+    return x;
+  }
 
-  for (auto& item : module.cells()) {
-    Cell* cell = item.get();
+  void Union(int64_t x, int64_t y) {
+    x = Find(x);
+    y = Find(y);
+    if (x == y) {
+      return;
+    }
+    if (size_[x] < size_[y]) {
+      std::swap(x, y);
+    }
+    parent_[y] = x;
+    size_[x] += size_[y];
+  }
+
+ private:
+  std::vector<int64_t> parent_;
+  std::vector<int64_t> size_;
+};
+
+// Merges, in `uf`, the equivalence classes of the cells in `cells` with those
+// of the cells they are connected to. `cell_ids` maps every cell of the module
+// to its index in `uf`.
+void ConnectCells(absl::Span<const std::unique_ptr<Cell>> cells,
+                  const absl::flat_hash_map<const Cell*, int64_t>& cell_ids,
+                  DenseUnionFind& uf) {
+  for (const std::unique_ptr<Cell>& item : cells) {
+    const Cell* cell = item.get();
     VLOG(4) << "Considering cell: " << cell->name();
 
     // Flop output connectivity is excluded from the equivalence class, so we
     // get partitions along flop (output) boundaries.
     if (cell->kind() == CellKind::kFlop) {
-      // For flops we just make sure an equivalence class is present in the
-      // map, in case it doesn't have any cells on the input side.
-      get_uf(cell);
-      VLOG(4) << "--- Now " << count_equivalence_classes()
-              << " equivalence classes for " << cell_to_uf.size() << " cells.";
       continue;
     }
+    const int64_t cell_id = cell_ids.at(cell);
 
     for (auto& input : cell->inputs()) {
       VLOG(4) << "- Considering input net: " << input.netref->name();
@@ -96,10 +122,7 @@ std::vector<Cluster> FindLogicClouds(const Module& module,
         }
         VLOG(4) << absl::StreamFormat("-- Cell %s is connected to cell %s",
                                       cell->name(), connected->name());
-        cell_to_uf.Union(get_uf(cell), get_uf(connected));
-        VLOG(4) << "--- Now " << count_equivalence_classes()
-                << " equivalence classes for " << cell_to_uf.size()
-                << " cells.";
+        uf.Union(cell_id, cell_ids.at(connected));
       }
     }
 
@@ -112,38 +135,89 @@ std::vector<Cluster> FindLogicClouds(const Module& module,
         }
         VLOG(4) << absl::StreamFormat("-- Cell %s is connected to cell %s",
                                       cell->name(), connected->name());
-        cell_to_uf.Union(get_uf(cell), get_uf(connected));
-        VLOG(4) << "--- Now " << count_equivalence_classes()
-                << " equivalence classes for " << cell_to_uf.size()
-                << " cells.";
+        uf.Union(cell_id, cell_ids.at(connected));
       }
     }
   }
+}
 
-  // Run through the cells and put them into clusters according to their
-  // equivalence classes.
-  absl::flat_hash_map<Cell*, Cluster> equivalence_set_to_cluster;
-  for (auto& item : module.cells()) {
-    Cell* cell = item.get();
-    equivalence_set_to_cluster[get_uf(cell)].Add(cell);
+}  // namespace
+
+std::vector<Cluster> FindLogicClouds(const Module& module,
+                                     const LogicCloudOptions& options) {
+  absl::Span<const std::unique_ptr<Cell>> cells = module.cells();
+  const int64_t cell_count = cells.size();
+  absl::flat_hash_map<const Cell*, int64_t> cell_ids;
+  cell_ids.reserve(cell_count);
+  for (int64_t i = 0; i < cell_count; ++i) {
+    cell_ids[cells[i].get()] = i;
   }
 
-  // Put them into a vector and sort each cluster's internal cells for
-  // determinism.
+  // Each thread scans the connections of a contiguous range of cells into its
+  // own union-find; the partitions are then merged into the first.
+  const int64_t thread_count = std::max<int64_t>(
+      std::min<int64_t>(options.thread_count, cell_count), 1);
+  const int64_t chunk_size = (cell_count + thread_count - 1) / thread_count;
+  std::vector<DenseUnionFind> partitions(thread_count,
+                                         DenseUnionFind(cell_count));
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t i = 0; i < thread_count; ++i) {
+      absl::Span<const std::unique_ptr<Cell>> chunk =
+          cells.subspan(std::min(i * chunk_size, cell_count), chunk_size);
+      DenseUnionFind* uf = &partitions[i];
+      auto scan = [chunk, &cell_ids, uf] {
+        ConnectCells(chunk, cell_ids, *uf);
+      };
+      if (i + 1 == thread_count) {
+        scan();
+      } else {
+        threads.push_back(std::make_unique<Thread>(scan));
+      }
+    }
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+  }
+  DenseUnionFind& uf = partitions.front();
+  for (int64_t i = 1; i < thread_count; ++i) {
+    for (int64_t id = 0; id < cell_count; ++id) {
+      int64_t representative = partitions[i].Find(id);
+      if (representative != id) {
+        uf.Union(id, representative);
+      }
+    }
+  }
+
+  // Run through the cells and put them into clusters according to their
+  // equivalence classes, ordered by the first cell of each in the module.
   std::vector<Cluster> clusters;
-  for (auto& item : equivalence_set_to_cluster) {
-    Cluster& cluster = item.second;
-    if (!include_vacuous && (cluster.terminating_flops().size() == 1 &&
-                             cluster.other_cells().empty())) {
-      // Vacuous 'just a flop' cluster.
-      continue;
+  std::vector<int64_t> representative_to_cluster(cell_count, -1);
+  for (int64_t id = 0; id < cell_count; ++id) {
+    int64_t& cluster_index = representative_to_cluster[uf.Find(id)];
+    if (cluster_index == -1) {
+      cluster_index = clusters.size();
+      clusters.emplace_back();
     }
-    cluster.SortCells();
-    clusters.push_back(std::move(cluster));
+    clusters[cluster_index].Add(cells[id].get());
+  }
+  if (!options.include_vacuous) {
+    // Vacuous 'just a flop' clusters.
+    std::erase_if(clusters, [](const Cluster& cluster) {
+      return cluster.terminating_flops().size() == 1 &&
+             cluster.other_cells().empty();
+    });
+  }
+  if (!options.sort_by_name) {
+    return clusters;
   }
 
+  // Sort each cluster's internal cells, then the clusters themselves, by name.
   // For convenience (for now) we convert the cell names to a string and rely on
   // string comparison for deterministic order.
+  for (Cluster& cluster : clusters) {
+    cluster.SortCells();
+  }
   auto cells_to_str = [](absl::Span<const Cell* const> cells) {
     return absl::StrJoin(cells, ", ", [](std::string* out, const Cell* cell) {
       absl::StrAppend(out, cell->name());
@@ -159,6 +233,14 @@ std::vector<Cluster> FindLogicClouds(const Module& module,
   return clusters;
 }
 
+std::vector<Cluster> FindLogicClouds(const Module& module,
+                                     bool include_vacuous) {
+  return FindLogicClouds(module, LogicCloudOptions{
+                                     .include_vacuous = include_vacuous,
+                                     .sort_by_name = true,
+                                 });
+}
+
 std::string ClustersToString(absl::Span<const Cluster> clusters) {
   std::string s;
   for (const Cluster& cluster : clusters) {
@@ -15,6 +15,7 @@
 #ifndef XLS_NETLIST_FIND_LOGIC_CLOUDS_H_
 #define XLS_NETLIST_FIND_LOGIC_CLOUDS_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -45,14 +46,29 @@ class Cluster {
   std::vector<Cell*> other_cells_;
 };
 
+struct LogicCloudOptions {
+  // Whether a terminating flop with no connected logic (e.g. a layer of flops
+  // that flop input to the module) should be considered to be a cluster, or
+  // just discarded.
+  bool include_vacuous = false;
+
+  // Whether to sort the cells of each cluster, and then the clusters, by cell
+  // name. Otherwise cells and clusters are in the order of the module's cells,
+  // which is deterministic but depends on the netlist's layout.
+  bool sort_by_name = false;
+
+  // The number of threads scanning the cells' connections.
+  int64_t thread_count = 1;
+};
+
 // Finds the connected clusters of logic cells between flops in the given module
 // and returns them. As noted in the definition of "Cluster", flops are
 // associated with their "input side" subgraphs; any logic following a final
 // flop stage has no associated "terminating flop".
-//
-// include_vacuous indicates whether a terminating flop with no connected logic
-// (e.g. a layer of flops that flop input to the module) should be considered to
-// be a cluster, or just discarded.
+std::vector<Cluster> FindLogicClouds(const Module& module,
+                                     const LogicCloudOptions& options);
+
+// As above, with the clusters sorted by name and scanned on a single thread.
 std::vector<Cluster> FindLogicClouds(const Module& module,
                                      bool include_vacuous = false);
 
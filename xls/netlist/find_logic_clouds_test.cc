@@ -133,6 +133,52 @@ cluster {
             ClustersToString(clusters));
 }
 
+TEST(ClusterTest, UnsortedClustersOnMultipleThreads) {
+  std::string netlist = R"(module main(clk, a0, b0, ao, bo);
+  input clk;
+  input a0, b0;
+  output ao, bo;
+  wire a1, a1n, ab1, b1;
+
+  DFF dff_a0_a1(.D(a0), .Q(a1), .CLK(clk));
+  INV inv_a1_a1n(.A(a1), .ZN(a1n));
+  DFF dff_a1n_ao(.D(a1n), .Q(ao), .CLK(clk));
+
+  DFF dff_b0_b1(.D(b0), .Q(b1), .CLK(clk));
+  AND and_a1_b1(.A(a1), .B(b1), .Z(ab1));
+  DFF dff_ab1_bo(.D(ab1), .Q(bo), .CLK(clk));
+endmodule)";
+  Scanner scanner(netlist);
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Netlist> n,
+                           Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const Module* m, n->GetModule("main"));
+  // The cells connected through `a1` are scanned on different threads. Unsorted
+  // clusters and cells are in the order of the module's cells.
+  std::vector<Cluster> clusters =
+      FindLogicClouds(*m, LogicCloudOptions{.include_vacuous = true,
+                                            .sort_by_name = false,
+                                            .thread_count = 4});
+  EXPECT_EQ(R"(cluster {
+  terminating_flop: dff_a0_a1
+}
+cluster {
+  terminating_flop: dff_a1n_ao
+  terminating_flop: dff_ab1_bo
+  other_cell: inv_a1_a1n
+  other_cell: and_a1_b1
+}
+cluster {
+  terminating_flop: dff_b0_b1
+}
+)",
+            ClustersToString(clusters));
+
+  clusters = FindLogicClouds(*m, LogicCloudOptions{.thread_count = 4});
+  ASSERT_EQ(clusters.size(), 1);
+  EXPECT_EQ(clusters[0].other_cells().size(), 2);
+}
+
 }  // namespace
 }  // namespace rtl
 }  // namespace netlist
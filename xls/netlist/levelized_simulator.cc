@@ -0,0 +1,404 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/levelized_simulator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/netlist/cell_library.h"
+#include "xls/netlist/function_parser.h"
+#include "xls/netlist/netlist.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+// The slots holding the constant nets.
+constexpr int32_t kZeroSlot = 0;
+constexpr int32_t kOneSlot = 1;
+
+// A cell of the flattened module, with its nets resolved to slots.
+struct FlatCell {
+  // The cell, or nullptr for a buffer which connects an output of a flattened
+  // submodule to the net it drives in the instantiating module.
+  const rtl::Cell* cell;
+  // Parallel to cell->inputs() and cell->outputs().
+  std::vector<int32_t> input_slots;
+  std::vector<int32_t> output_slots;
+};
+
+// Flattens a module and its submodules into a list of cells over slots.
+class Flattener {
+ public:
+  explicit Flattener(const rtl::Netlist& netlist) : netlist_(netlist) {}
+
+  // Flattens `module`, whose inputs are held in `input_slots`, and returns the
+  // slots holding its outputs.
+  absl::StatusOr<std::vector<int32_t>> Flatten(
+      const rtl::Module* module, absl::Span<const int32_t> input_slots);
+
+  int32_t NewSlot() { return slot_count_++; }
+
+  int32_t slot_count() const { return slot_count_; }
+  std::vector<FlatCell>& cells() { return cells_; }
+
+ private:
+  const rtl::Netlist& netlist_;
+  int32_t slot_count_ = 2;
+  std::vector<FlatCell> cells_;
+};
+
+absl::StatusOr<std::vector<int32_t>> Flattener::Flatten(
+    const rtl::Module* module, absl::Span<const int32_t> input_slots) {
+  XLS_RET_CHECK_EQ(input_slots.size(), module->inputs().size());
+  absl::flat_hash_map<rtl::NetRef, int32_t> slots;
+  slots[module->zero()] = kZeroSlot;
+  slots[module->one()] = kOneSlot;
+  for (int64_t i = 0; i < input_slots.size(); ++i) {
+    slots[module->inputs()[i]] = input_slots[i];
+  }
+  // Nets which are assigned from another net share its slot.
+  auto slot_of = [&](rtl::NetRef net) {
+    while (module->assigns().contains(net)) {
+      net = module->assigns().at(net);
+    }
+    auto [it, inserted] = slots.try_emplace(net, slot_count_);
+    if (inserted) {
+      ++slot_count_;
+    }
+    return it->second;
+  };
+
+  for (const auto& cell : module->cells()) {
+    std::optional<const rtl::Module*> submodule =
+        netlist_.MaybeGetModule(cell->cell_library_entry()->name());
+    if (!submodule.has_value()) {
+      FlatCell flat_cell{.cell = cell.get()};
+      for (const auto& input : cell->inputs()) {
+        flat_cell.input_slots.push_back(slot_of(input.netref));
+      }
+      for (const auto& output : cell->outputs()) {
+        flat_cell.output_slots.push_back(slot_of(output.netref));
+      }
+      cells_.push_back(std::move(flat_cell));
+      continue;
+    }
+
+    // Match the pins of the cell to the ports of the submodule by name.
+    std::vector<int32_t> submodule_input_slots;
+    for (const rtl::NetRef submodule_input : (*submodule)->inputs()) {
+      auto it = std::find_if(cell->inputs().begin(), cell->inputs().end(),
+                             [&](const rtl::Cell::Pin& pin) {
+                               return pin.name == submodule_input->name();
+                             });
+      if (it == cell->inputs().end()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Input pin \"%s\" of module \"%s\" is not connected in cell "
+            "\"%s\"",
+            submodule_input->name(), (*submodule)->name(), cell->name()));
+      }
+      submodule_input_slots.push_back(slot_of(it->netref));
+    }
+    XLS_ASSIGN_OR_RETURN(std::vector<int32_t> submodule_output_slots,
+                         Flatten(*submodule, submodule_input_slots));
+    for (const auto& output : cell->outputs()) {
+      const std::vector<rtl::NetRef>& submodule_outputs =
+          (*submodule)->outputs();
+      auto it = std::find_if(
+          submodule_outputs.begin(), submodule_outputs.end(),
+          [&](rtl::NetRef net) { return net->name() == output.name; });
+      if (it == submodule_outputs.end()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Could not find output pin \"%s\" in module \"%s\", referenced in "
+            "cell \"%s\"",
+            output.name, (*submodule)->name(), cell->name()));
+      }
+      cells_.push_back(FlatCell{
+          .cell = nullptr,
+          .input_slots = {submodule_output_slots[std::distance(
+              submodule_outputs.begin(), it)]},
+          .output_slots = {slot_of(output.netref)}});
+    }
+  }
+
+  std::vector<int32_t> output_slots;
+  for (const rtl::NetRef output : module->outputs()) {
+    output_slots.push_back(slot_of(output));
+  }
+  return output_slots;
+}
+
+// Returns the cells in an order in which every cell comes after the cells
+// driving its inputs, i.e. levelized.
+absl::StatusOr<std::vector<const FlatCell*>> Levelize(
+    absl::Span<const FlatCell> cells, int32_t slot_count,
+    absl::Span<const int32_t> input_slots) {
+  std::vector<bool> driven(slot_count, false);
+  driven[kZeroSlot] = true;
+  driven[kOneSlot] = true;
+  for (int32_t slot : input_slots) {
+    driven[slot] = true;
+  }
+
+  // The number of input pins of each cell which are not yet driven, and the
+  // cells reading each slot which is not yet driven.
+  std::vector<int64_t> missing_inputs(cells.size(), 0);
+  std::vector<std::vector<int64_t>> readers(slot_count);
+  std::vector<const FlatCell*> order;
+  order.reserve(cells.size());
+  for (int64_t i = 0; i < cells.size(); ++i) {
+    for (int32_t slot : cells[i].input_slots) {
+      if (!driven[slot]) {
+        ++missing_inputs[i];
+        readers[slot].push_back(i);
+      }
+    }
+    if (missing_inputs[i] == 0) {
+      order.push_back(&cells[i]);
+    }
+  }
+
+  // `order` doubles as the worklist of cells whose inputs are all driven.
+  for (int64_t next = 0; next < order.size(); ++next) {
+    for (int32_t slot : order[next]->output_slots) {
+      if (driven[slot]) {
+        continue;
+      }
+      driven[slot] = true;
+      for (int64_t reader : readers[slot]) {
+        if (--missing_inputs[reader] == 0) {
+          order.push_back(&cells[reader]);
+        }
+      }
+    }
+  }
+
+  if (order.size() < cells.size()) {
+    for (int64_t i = 0; i < cells.size(); ++i) {
+      if (missing_inputs[i] > 0) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Netlist contains unconnected subgraphs or cycles and cannot be "
+            "simulated. Example: cell %s",
+            cells[i].cell == nullptr ? "<submodule output>"
+                                     : cells[i].cell->name()));
+      }
+    }
+  }
+  return order;
+}
+
+}  // namespace
+
+absl::StatusOr<LevelizedSimulator> LevelizedSimulator::Create(
+    const rtl::Netlist& netlist, const rtl::Module* module) {
+  LevelizedSimulator simulator;
+  Flattener flattener(netlist);
+  for (int64_t i = 0; i < module->inputs().size(); ++i) {
+    simulator.input_slots_.push_back(flattener.NewSlot());
+  }
+  XLS_ASSIGN_OR_RETURN(simulator.output_slots_,
+                       flattener.Flatten(module, simulator.input_slots_));
+  simulator.slot_count_ = flattener.slot_count();
+  simulator.cell_count_ = flattener.cells().size();
+
+  XLS_ASSIGN_OR_RETURN(std::vector<const FlatCell*> order,
+                       Levelize(flattener.cells(), flattener.slot_count(),
+                                simulator.input_slots_));
+
+  // As in the Interpreter, an output which nothing drives is more likely a bug
+  // in the netlist than intended.
+  std::vector<bool> driven(flattener.slot_count(), false);
+  driven[kZeroSlot] = true;
+  driven[kOneSlot] = true;
+  for (int32_t slot : simulator.input_slots_) {
+    driven[slot] = true;
+  }
+  for (const FlatCell& flat_cell : flattener.cells()) {
+    for (int32_t slot : flat_cell.output_slots) {
+      driven[slot] = true;
+    }
+  }
+  for (int64_t i = 0; i < module->outputs().size(); ++i) {
+    if (!driven[simulator.output_slots_[i]]) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Output %s of module %s is not driven",
+                          module->outputs()[i]->name(), module->name()));
+    }
+  }
+
+  // Cells of the same type share their functions, so only parse each once.
+  absl::flat_hash_map<std::string, function::Ast> asts;
+  for (const FlatCell* flat_cell : order) {
+    if (flat_cell->cell == nullptr) {
+      simulator.program_.push_back(
+          {Instruction::Op::kLoad, flat_cell->input_slots[0]});
+      simulator.program_.push_back(
+          {Instruction::Op::kStore, flat_cell->output_slots[0]});
+      simulator.max_stack_depth_ = std::max<int64_t>(
+          simulator.max_stack_depth_, 1);
+      continue;
+    }
+    const rtl::Cell& cell = *flat_cell->cell;
+    const CellLibraryEntry::OutputPinToFunction& functions =
+        cell.cell_library_entry()->output_pin_to_function();
+    for (int64_t i = 0; i < cell.outputs().size(); ++i) {
+      const rtl::Cell::OutputPin& output = cell.outputs()[i];
+      if (output.eval != nullptr) {
+        return absl::UnimplementedError(absl::StrFormat(
+            "Cell %s has an evaluation function for pin %s; only cell library "
+            "functions can be simulated",
+            cell.name(), output.name));
+      }
+      auto function_it = functions.find(output.name);
+      if (function_it == functions.end()) {
+        return absl::NotFoundError(
+            absl::StrFormat("No function for output pin %s of cell %s",
+                            output.name, cell.name()));
+      }
+      auto ast_it = asts.find(function_it->second);
+      if (ast_it == asts.end()) {
+        XLS_ASSIGN_OR_RETURN(
+            function::Ast ast,
+            function::Parser::ParseFunction(function_it->second));
+        ast_it = asts.emplace(function_it->second, std::move(ast)).first;
+      }
+      XLS_RETURN_IF_ERROR(simulator.LowerFunction(
+          cell, flat_cell->input_slots, ast_it->second, /*depth=*/1));
+      simulator.program_.push_back(
+          {Instruction::Op::kStore, flat_cell->output_slots[i]});
+    }
+  }
+  return simulator;
+}
+
+absl::Status LevelizedSimulator::LowerFunction(
+    const rtl::Cell& cell, absl::Span<const int32_t> input_slots,
+    const function::Ast& ast, int64_t depth) {
+  max_stack_depth_ = std::max(max_stack_depth_, depth);
+  switch (ast.kind()) {
+    case function::Ast::Kind::kIdentifier: {
+      for (int64_t i = 0; i < cell.inputs().size(); ++i) {
+        if (cell.inputs()[i].name == ast.name()) {
+          program_.push_back({Instruction::Op::kLoad, input_slots[i]});
+          return absl::OkStatus();
+        }
+      }
+      for (const auto& internal : cell.internal_pins()) {
+        if (internal.name == ast.name()) {
+          return absl::UnimplementedError(absl::StrFormat(
+              "Cell %s uses a state table; only cell library functions can be "
+              "simulated",
+              cell.name()));
+        }
+      }
+      return absl::NotFoundError(
+          absl::StrFormat("Identifier \"%s\" not found in cell %s's inputs "
+                          "or internal signals.",
+                          ast.name(), cell.name()));
+    }
+    case function::Ast::Kind::kLiteralOne:
+      program_.push_back({Instruction::Op::kLoad, kOneSlot});
+      return absl::OkStatus();
+    case function::Ast::Kind::kLiteralZero:
+      program_.push_back({Instruction::Op::kLoad, kZeroSlot});
+      return absl::OkStatus();
+    case function::Ast::Kind::kNot:
+      XLS_RETURN_IF_ERROR(
+          LowerFunction(cell, input_slots, ast.children()[0], depth));
+      program_.push_back({Instruction::Op::kNot});
+      return absl::OkStatus();
+    case function::Ast::Kind::kAnd:
+    case function::Ast::Kind::kOr:
+    case function::Ast::Kind::kXor: {
+      XLS_RETURN_IF_ERROR(
+          LowerFunction(cell, input_slots, ast.children()[0], depth));
+      XLS_RETURN_IF_ERROR(
+          LowerFunction(cell, input_slots, ast.children()[1], depth + 1));
+      Instruction::Op op = ast.kind() == function::Ast::Kind::kAnd
+                               ? Instruction::Op::kAnd
+                           : ast.kind() == function::Ast::Kind::kOr
+                               ? Instruction::Op::kOr
+                               : Instruction::Op::kXor;
+      program_.push_back({op});
+      return absl::OkStatus();
+    }
+  }
+  return absl::InvalidArgumentError(
+      absl::StrFormat("Unknown AST element type: %d",
+                      static_cast<int>(ast.kind())));
+}
+
+absl::StatusOr<std::vector<uint64_t>> LevelizedSimulator::Simulate(
+    absl::Span<const uint64_t> inputs) const {
+  if (inputs.size() != input_slots_.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Expected %d input words, got %d", input_slots_.size(),
+                        inputs.size()));
+  }
+  std::vector<uint64_t> values(slot_count_, 0);
+  values[kOneSlot] = ~uint64_t{0};
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    values[input_slots_[i]] = inputs[i];
+  }
+
+  std::vector<uint64_t> stack(max_stack_depth_);
+  int64_t top = 0;
+  for (const Instruction& instruction : program_) {
+    switch (instruction.op) {
+      case Instruction::Op::kLoad:
+        stack[top++] = values[instruction.slot];
+        break;
+      case Instruction::Op::kStore:
+        values[instruction.slot] = stack[--top];
+        break;
+      case Instruction::Op::kNot:
+        stack[top - 1] = ~stack[top - 1];
+        break;
+      case Instruction::Op::kAnd:
+        --top;
+        stack[top - 1] &= stack[top];
+        break;
+      case Instruction::Op::kOr:
+        --top;
+        stack[top - 1] |= stack[top];
+        break;
+      case Instruction::Op::kXor:
+        --top;
+        stack[top - 1] ^= stack[top];
+        break;
+    }
+  }
+
+  std::vector<uint64_t> outputs;
+  outputs.reserve(output_slots_.size());
+  for (int32_t slot : output_slots_) {
+    outputs.push_back(values[slot]);
+  }
+  return outputs;
+}
+
+}  // namespace netlist
+}  // namespace xls
@@ -0,0 +1,99 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_NETLIST_LEVELIZED_SIMULATOR_H_
+#define XLS_NETLIST_LEVELIZED_SIMULATOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/netlist/function_parser.h"
+#include "xls/netlist/netlist.h"
+
+namespace xls {
+namespace netlist {
+
+// Simulates a combinational module 64 input vectors at a time.
+//
+// Unlike the Interpreter, which discovers the evaluation order of cells on
+// every call by propagating values through hash maps, the module is compiled
+// once: submodules are flattened, the cells are levelized (topologically
+// sorted) and each output pin's function is lowered to a short postfix
+// program over slots in a dense array of net values. Each slot holds one
+// 64-bit word, with bit i holding the value of the net in input vector i, so
+// every cell function is evaluated for all 64 vectors with a handful of
+// bitwise operations.
+//
+// Cells must be described by their cell library functions; state tables and
+// cell evaluation functions (see AbstractModule::AddCellEvaluationFns) are not
+// supported.
+class LevelizedSimulator {
+ public:
+  // The number of input vectors simulated per call of Simulate().
+  static constexpr int64_t kLanes = 64;
+
+  // Compiles `module`; any of its cells which are modules of `netlist` are
+  // flattened into it.
+  static absl::StatusOr<LevelizedSimulator> Create(const rtl::Netlist& netlist,
+                                                   const rtl::Module* module);
+
+  // Simulates the module on up to kLanes input vectors. `inputs` holds one
+  // word per module input, in the order of module->inputs(); bit i of each
+  // word is the value of that input in vector i. Returns one word per module
+  // output, in the order of module->outputs(), laid out the same way.
+  absl::StatusOr<std::vector<uint64_t>> Simulate(
+      absl::Span<const uint64_t> inputs) const;
+
+  // The number of slots in the net value array, and the number of (flattened)
+  // cells evaluated per call.
+  int64_t slot_count() const { return slot_count_; }
+  int64_t cell_count() const { return cell_count_; }
+
+ private:
+  // An instruction of the postfix programs the cell functions are lowered to.
+  // Loads push the value of a slot, stores pop the top of the stack into a
+  // slot, and the logical operations replace the top one or two values of the
+  // stack with their result.
+  struct Instruction {
+    enum class Op : uint8_t { kLoad, kStore, kNot, kAnd, kOr, kXor };
+    Op op;
+    int32_t slot = 0;
+  };
+
+  LevelizedSimulator() = default;
+
+  // Appends the program evaluating `ast` for `cell` (whose input pins are held
+  // in `input_slots`) to program_, leaving the result on the stack. `depth` is
+  // the stack depth the result ends up at.
+  absl::Status LowerFunction(const rtl::Cell& cell,
+                             absl::Span<const int32_t> input_slots,
+                             const function::Ast& ast, int64_t depth);
+
+  int64_t slot_count_ = 0;
+  int64_t cell_count_ = 0;
+  int64_t max_stack_depth_ = 0;
+  // The slots of the module's inputs and outputs.
+  std::vector<int32_t> input_slots_;
+  std::vector<int32_t> output_slots_;
+  // The programs of all cells, in level order.
+  std::vector<Instruction> program_;
+};
+
+}  // namespace netlist
+}  // namespace xls
+
+#endif  // XLS_NETLIST_LEVELIZED_SIMULATOR_H_
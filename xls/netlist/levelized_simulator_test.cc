@@ -0,0 +1,124 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/netlist/levelized_simulator.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "xls/common/status/matchers.h"
+#include "xls/netlist/cell_library.h"
+#include "xls/netlist/fake_cell_library.h"
+#include "xls/netlist/interpreter.h"
+#include "xls/netlist/netlist.h"
+#include "xls/netlist/netlist_parser.h"
+
+namespace xls {
+namespace netlist {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+
+// Cells are deliberately listed out of topological order.
+constexpr char kNetlist[] = R"(
+module half_adder (a, b, s, c);
+  input a, b;
+  output s, c;
+
+  XOR xor0( .A(a), .B(b), .Z(s) );
+  AND and0( .A(a), .B(b), .Z(c) );
+endmodule
+
+module main (i0, i1, i2, i3, o0, o1, o2);
+  input i0, i1, i2, i3;
+  output o0, o1, o2;
+  wire s0, c0, n0, inv;
+
+  AOI21 aoi0( .A(s0), .B(n0), .C(c0), .ZN(o0) );
+  NAND nand0( .A(i2), .B(inv), .ZN(n0) );
+  INV inv0( .A(i3), .ZN(inv) );
+  half_adder ha0( .a(i0), .b(i1), .s(s0), .c(c0) );
+  assign o1 = i1;
+  assign o2 = 1'b1;
+endmodule
+)";
+
+TEST(LevelizedSimulatorTest, MatchesInterpreter) {
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(kNetlist);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(LevelizedSimulator simulator,
+                           LevelizedSimulator::Create(*netlist, module));
+  EXPECT_EQ(simulator.cell_count(), 7);
+
+  // Simulate all 16 input combinations at once: lane i holds combination
+  // i % 16.
+  std::vector<uint64_t> inputs(4, 0);
+  for (int64_t lane = 0; lane < LevelizedSimulator::kLanes; ++lane) {
+    for (int64_t input = 0; input < 4; ++input) {
+      inputs[input] |= uint64_t{(lane >> input) & 1} << lane;
+    }
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<uint64_t> outputs,
+                           simulator.Simulate(inputs));
+  ASSERT_EQ(outputs.size(), 3);
+
+  Interpreter interpreter(netlist.get());
+  for (int64_t lane = 0; lane < 16; ++lane) {
+    NetRef2Value interpreter_inputs;
+    for (int64_t input = 0; input < 4; ++input) {
+      interpreter_inputs[module->inputs()[input]] = (lane >> input) & 1;
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(
+        NetRef2Value expected,
+        interpreter.InterpretModule(module, interpreter_inputs));
+    for (int64_t output = 0; output < 3; ++output) {
+      EXPECT_EQ((outputs[output] >> lane) & 1,
+                expected.at(module->outputs()[output]))
+          << "lane " << lane << ", output " << output;
+    }
+  }
+}
+
+TEST(LevelizedSimulatorTest, RejectsUndrivenOutputs) {
+  std::string module_text = R"(
+module main (i0, o0, o1);
+  input i0;
+  output o0, o1;
+
+  INV inv0( .A(i0), .ZN(o0) );
+endmodule
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  rtl::Scanner scanner(module_text);
+  XLS_ASSERT_OK_AND_ASSIGN(auto netlist,
+                           rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  XLS_ASSERT_OK_AND_ASSIGN(const rtl::Module* module,
+                           netlist->GetModule("main"));
+  EXPECT_THAT(LevelizedSimulator::Create(*netlist, module),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Output o1 of module main is not driven")));
+}
+
+}  // namespace
+}  // namespace netlist
+}  // namespace xls
@@ -474,9 +474,10 @@ class AbstractModule {
   absl::flat_hash_map<AbstractNetRef<EvalT>, AbstractNetRef<EvalT>>
       assign_nets_;
   std::vector<std::unique_ptr<AbstractNetDef<EvalT>>> nets_;
-  absl::flat_hash_map<std::string, AbstractNetRef<EvalT>> name_to_netref_;
+  // Keyed by the names owned by the nets and cells themselves.
+  absl::flat_hash_map<std::string_view, AbstractNetRef<EvalT>> name_to_netref_;
   std::vector<std::unique_ptr<AbstractCell<EvalT>>> cells_;
-  absl::flat_hash_map<std::string, AbstractCell<EvalT>*> name_to_cell_;
+  absl::flat_hash_map<std::string_view, AbstractCell<EvalT>*> name_to_cell_;
   AbstractNetRef<EvalT> zero_;
   AbstractNetRef<EvalT> one_;
   AbstractNetRef<EvalT> dummy_;
@@ -595,7 +596,8 @@ absl::StatusOr<AbstractCell<EvalT>*> AbstractModule<EvalT>::AddCell(
 
   cells_.push_back(std::make_unique<AbstractCell<EvalT>>(cell));
   auto cell_ptr = cells_.back().get();
-  name_to_cell_[cell.name()] = cell_ptr;
+  // Key by the name owned by the cell so that each name is only stored once.
+  name_to_cell_[cell_ptr->name()] = cell_ptr;
   return cell_ptr;
 }
 
@@ -614,7 +616,7 @@ absl::Status AbstractModule<EvalT>::AddNetDecl(NetDeclKind kind,
 
   nets_.emplace_back(std::make_unique<AbstractNetDef<EvalT>>(name, kind));
   AbstractNetRef<EvalT> ref = nets_.back().get();
-  name_to_netref_[name] = ref;
+  name_to_netref_[ref->name()] = ref;
   switch (kind) {
     case NetDeclKind::kInput:
       input_nets_.push_back(ref);
@@ -28,6 +28,7 @@
 #include "xls/codegen/flattening.h"
 #include "xls/common/exit_status.h"
 #include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -99,10 +100,12 @@ static absl::Status RealMain(const std::string& netlist_path,
       netlist::CellLibrary cell_library,
       GetCellLibrary(cell_library_path, cell_library_proto_path));
 
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
-  XLS_ASSIGN_OR_RETURN(auto netlist, netlist::rtl::Parser::ParseNetlist(
-                                         &cell_library, &scanner));
+  // Only the module being interpreted (and its submodules) are parsed.
+  XLS_ASSIGN_OR_RETURN(MappedFile netlist_file, MappedFile::Open(netlist_path));
+  XLS_ASSIGN_OR_RETURN(
+      auto netlist,
+      netlist::rtl::Parser::ParseNetlistForModule(
+          &cell_library, netlist_file.contents(), module_name));
   XLS_ASSIGN_OR_RETURN(const auto* module, netlist->GetModule(module_name));
 
   // Input values are listed in the same order as inputs are declared by
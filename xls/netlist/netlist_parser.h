@@ -18,6 +18,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -93,6 +94,11 @@ class Scanner {
  public:
   explicit Scanner(std::string_view text) : text_(text) {}
 
+  // Scans `text`, which starts at position `start` of some larger text, e.g.
+  // a single module of a netlist file.
+  Scanner(std::string_view text, Pos start)
+      : text_(text), lineno_(start.lineno), colno_(start.colno) {}
+
   absl::StatusOr<Token> Peek();
 
   absl::StatusOr<Token> Pop();
@@ -102,6 +108,17 @@ class Scanner {
     return index_ >= text_.size();
   }
 
+  // Returns the offset in the text of the next character to scan, and its
+  // position. Must not be called while a token has been peeked but not popped.
+  int64_t offset() const {
+    CHECK(!lookahead_.has_value());
+    return index_;
+  }
+  Pos pos() const {
+    CHECK(!lookahead_.has_value());
+    return GetPos();
+  }
+
  private:
   absl::StatusOr<Token> ScanName(char startc, Pos pos, bool is_escaped);
   absl::StatusOr<Token> ScanNumber(char startc, Pos pos);
@@ -147,7 +164,38 @@ class AbstractParser {
     return ParseNetlist(cell_library, scanner, EvalT{false}, EvalT{true});
   }
 
+  // Parses only the module `module_name` of the netlist `text` and the modules
+  // it (transitively) instantiates. The other modules are only scanned to find
+  // where they end, so no nets or cells are built for them; for large netlist
+  // files holding many modules this saves most of the time and memory of
+  // ParseNetlist. `text` need not outlive the returned netlist, so it may be
+  // e.g. the contents of a MappedFile.
+  static absl::StatusOr<std::unique_ptr<AbstractNetlist<EvalT>>>
+  ParseNetlistForModule(AbstractCellLibrary<EvalT>* cell_library,
+                        std::string_view text, std::string_view module_name,
+                        EvalT zero, EvalT one);
+  template <typename = std::is_constructible<EvalT, bool>>
+  static absl::StatusOr<std::unique_ptr<AbstractNetlist<EvalT>>>
+  ParseNetlistForModule(AbstractCellLibrary<EvalT>* cell_library,
+                        std::string_view text, std::string_view module_name) {
+    return ParseNetlistForModule(cell_library, text, module_name, EvalT{false},
+                                 EvalT{true});
+  }
+
  private:
+  // Where a module is in the text of a netlist, and the names of the cells or
+  // modules it instantiates.
+  struct ModuleExtent {
+    int64_t offset;
+    int64_t size;
+    Pos pos;
+    absl::flat_hash_set<std::string> instantiated;
+  };
+
+  // Scans (without parsing) the modules of a netlist to find their extents.
+  static absl::StatusOr<absl::flat_hash_map<std::string, ModuleExtent>>
+  ScanModuleExtents(std::string_view text);
+
   explicit AbstractParser(AbstractCellLibrary<EvalT>* cell_library,
                           Scanner* scanner, EvalT zero, EvalT one)
       : cell_library_(cell_library),
@@ -797,6 +845,109 @@ AbstractParser<EvalT>::ParseNetlist(AbstractCellLibrary<EvalT>* cell_library,
   return std::move(netlist);
 }
 
+template <typename EvalT>
+auto AbstractParser<EvalT>::ScanModuleExtents(std::string_view text)
+    -> absl::StatusOr<absl::flat_hash_map<std::string, ModuleExtent>> {
+  absl::flat_hash_map<std::string, ModuleExtent> extents;
+  Scanner scanner(text);
+  while (!scanner.AtEof()) {
+    ModuleExtent extent{.offset = scanner.offset(), .pos = scanner.pos()};
+    XLS_ASSIGN_OR_RETURN(Token token, scanner.Pop());
+    if (token.kind != TokenKind::kName || token.value != "module") {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Expected keyword 'module' @ %s; got %s",
+                          token.pos.ToHumanString(), token.ToString()));
+    }
+    XLS_ASSIGN_OR_RETURN(Token name, scanner.Pop());
+    if (name.kind != TokenKind::kName) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Expected module name @ %s; got %s",
+                          name.pos.ToHumanString(), name.ToString()));
+    }
+
+    // Every statement of a module ends with a semicolon, and the statements
+    // which are not declarations instantiate the cell or module they start
+    // with.
+    bool at_statement_start = false;
+    while (true) {
+      if (scanner.AtEof()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Module %s @ %s has no endmodule", name.value,
+            extent.pos.ToHumanString()));
+      }
+      XLS_ASSIGN_OR_RETURN(token, scanner.Pop());
+      if (token.kind == TokenKind::kSemicolon) {
+        at_statement_start = true;
+        continue;
+      }
+      if (!at_statement_start) {
+        continue;
+      }
+      at_statement_start = false;
+      if (token.kind != TokenKind::kName) {
+        continue;
+      }
+      if (token.value == "endmodule") {
+        break;
+      }
+      if (token.value != "input" && token.value != "output" &&
+          token.value != "wire" && token.value != "assign") {
+        extent.instantiated.insert(token.value);
+      }
+    }
+    extent.size = scanner.offset() - extent.offset;
+    if (!extents.emplace(name.value, std::move(extent)).second) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Duplicate module %s @ %s", name.value, name.pos.ToHumanString()));
+    }
+  }
+  return extents;
+}
+
+template <typename EvalT>
+absl::StatusOr<std::unique_ptr<AbstractNetlist<EvalT>>>
+AbstractParser<EvalT>::ParseNetlistForModule(
+    AbstractCellLibrary<EvalT>* cell_library, std::string_view text,
+    std::string_view module_name, EvalT zero, EvalT one) {
+  XLS_ASSIGN_OR_RETURN(auto extents, ScanModuleExtents(text));
+  if (!extents.contains(module_name)) {
+    return absl::NotFoundError(
+        absl::StrCat("Could not find module: ", module_name));
+  }
+
+  // Modules must be parsed after the modules they instantiate, so that their
+  // instances resolve to the module rather than to the cell library.
+  auto netlist = std::make_unique<AbstractNetlist<EvalT>>();
+  absl::flat_hash_set<std::string> parsed;
+  absl::flat_hash_set<std::string> on_stack;
+  std::function<absl::Status(const std::string&)> parse_module =
+      [&](const std::string& name) -> absl::Status {
+    if (parsed.contains(name)) {
+      return absl::OkStatus();
+    }
+    if (!on_stack.insert(name).second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Module instantiates itself: ", name));
+    }
+    const ModuleExtent& extent = extents.at(name);
+    for (const std::string& instantiated : extent.instantiated) {
+      if (extents.contains(instantiated)) {
+        XLS_RETURN_IF_ERROR(parse_module(instantiated));
+      }
+    }
+    Scanner scanner(text.substr(extent.offset, extent.size), extent.pos);
+    AbstractParser<EvalT> p(cell_library, &scanner, zero, one);
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<AbstractModule<EvalT>> module,
+                         p.ParseModule(*netlist));
+    netlist->AddModule(std::move(module));
+    on_stack.erase(name);
+    parsed.insert(name);
+    return absl::OkStatus();
+  };
+  XLS_RETURN_IF_ERROR(parse_module(std::string(module_name)));
+  return std::move(netlist);
+}
+
 }  // namespace rtl
 }  // namespace netlist
 }  // namespace xls
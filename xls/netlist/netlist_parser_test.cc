@@ -448,6 +448,44 @@ endmodule)";
   TestAssignHelper(m);
 }
 
+TEST(NetlistParserTest, ParseNetlistForModule) {
+  // `unused` instantiates a cell which is not in the library, so it would fail
+  // to parse; `sub` is defined after the module instantiating it.
+  std::string netlist = R"(module unused(a, z);
+  input a;
+  output z;
+  BOGUS bogus_0(.A(a), .ZN(z));
+endmodule
+module main(a, z);
+  input a;
+  output z;
+  wire t;
+  sub sub_0(.x(a), .y(t));
+  INV inv_0(.A(t), .ZN(z));
+endmodule
+module sub(x, y);
+  input x;
+  output y;
+  INV inv_0(.A(x), .ZN(y));
+endmodule)";
+  XLS_ASSERT_OK_AND_ASSIGN(CellLibrary cell_library, MakeFakeCellLibrary());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Netlist> n,
+      Parser::ParseNetlistForModule(&cell_library, netlist, "main"));
+  EXPECT_EQ(n->modules().size(), 2);
+  EXPECT_FALSE(n->MaybeGetModule("unused").has_value());
+  XLS_ASSERT_OK_AND_ASSIGN(const Module* sub, n->GetModule("sub"));
+  XLS_ASSERT_OK_AND_ASSIGN(const Module* m, n->GetModule("main"));
+  XLS_ASSERT_OK_AND_ASSIGN(Cell * c, m->ResolveCell("sub_0"));
+  EXPECT_EQ(c->cell_library_entry(), sub->AsCellLibraryEntry());
+
+  EXPECT_THAT(Parser::ParseNetlistForModule(&cell_library, netlist, "unused"),
+              StatusIs(absl::StatusCode::kNotFound, HasSubstr("BOGUS")));
+  EXPECT_THAT(Parser::ParseNetlistForModule(&cell_library, netlist, "other"),
+              StatusIs(absl::StatusCode::kNotFound,
+                       HasSubstr("Could not find module: other")));
+}
+
 }  // namespace
 }  // namespace rtl
 }  // namespace netlist
@@ -16,19 +16,29 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/noc/config/network_config.pb.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/flit.h"
 #include "xls/noc/simulation/global_routing_table.h"
@@ -141,29 +151,92 @@ absl::Status ExperimentMetrics::DebugDump() const {
   return absl::OkStatus();
 }
 
-absl::StatusOr<ExperimentData> ExperimentRunner::RunExperiment(
-    const ExperimentConfig& experiment_config,
-    DistributedRoutingTableBuilderBase&& distributed_routing_table_builder)
-    const {
-  // Build and assign simulation objects.
-  NetworkManager graph;
-  NocParameters params;
+absl::StatusOr<std::unique_ptr<ExperimentNetwork>> ExperimentNetwork::Create(
+    const NetworkConfigProto& network_config,
+    DistributedRoutingTableBuilderBase& distributed_routing_table_builder) {
+  auto network = absl::WrapUnique(new ExperimentNetwork());
 
+  // Build and assign network objects.
   XLS_RETURN_IF_ERROR(BuildNetworkGraphFromProto(
-      experiment_config.GetNetworkConfig(), &graph, &params));
+      network_config, &network->graph_, &network->params_));
 
   // Create global routing table.
   XLS_ASSIGN_OR_RETURN(
-      DistributedRoutingTable routing_table,
+      network->routing_table_,
       distributed_routing_table_builder.BuildNetworkRoutingTables(
-          graph.GetNetworkIds()[0], graph, params));
+          network->GetNetworkId(), network->graph_, network->params_));
+
+  return network;
+}
+
+std::string FormatSweepTable(absl::Span<const ExperimentData> step_data) {
+  // Gather the columns from all steps, as steps may have different flows
+  // and networks.
+  absl::btree_set<std::string> float_columns;
+  absl::btree_set<std::string> integer_columns;
+  for (const ExperimentData& data : step_data) {
+    for (const auto& [name, value] : data.metrics.GetFloatMetrics()) {
+      bool is_rate = absl::EndsWith(name, ":TrafficRateInMiBps") &&
+                     !absl::StrContains(name, ":VC:");
+      if (is_rate || absl::EndsWith(name, ":AverageLatency")) {
+        float_columns.insert(name);
+      }
+    }
+    for (const auto& [name, value] : data.metrics.GetIntegerMetrics()) {
+      if (absl::EndsWith(name, ":MaximumLatency")) {
+        integer_columns.insert(name);
+      }
+    }
+  }
+
+  std::vector<std::string> header = {"Step"};
+  header.insert(header.end(), float_columns.begin(), float_columns.end());
+  header.insert(header.end(), integer_columns.begin(), integer_columns.end());
+  std::string table = absl::StrCat(absl::StrJoin(header, ","), "\n");
+
+  for (int64_t step = 0; step < step_data.size(); ++step) {
+    const ExperimentMetrics& metrics = step_data[step].metrics;
+    std::vector<std::string> row = {absl::StrCat(step)};
+    for (const std::string& name : float_columns) {
+      auto it = metrics.GetFloatMetrics().find(name);
+      row.push_back(it == metrics.GetFloatMetrics().end()
+                        ? ""
+                        : absl::StrFormat("%g", it->second));
+    }
+    for (const std::string& name : integer_columns) {
+      auto it = metrics.GetIntegerMetrics().find(name);
+      row.push_back(it == metrics.GetIntegerMetrics().end()
+                        ? ""
+                        : absl::StrCat(it->second));
+    }
+    absl::StrAppend(&table, absl::StrJoin(row, ","), "\n");
+  }
+
+  return table;
+}
+
+absl::StatusOr<ExperimentData> ExperimentRunner::RunExperiment(
+    const ExperimentConfig& experiment_config,
+    DistributedRoutingTableBuilderBase&& distributed_routing_table_builder)
+    const {
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<ExperimentNetwork> network,
+      ExperimentNetwork::Create(experiment_config.GetNetworkConfig(),
+                                distributed_routing_table_builder));
+  return RunExperiment(*network, experiment_config.GetTrafficConfig());
+}
+
+absl::StatusOr<ExperimentData> ExperimentRunner::RunExperiment(
+    ExperimentNetwork& network, const NocTrafficManager& traffic_config) const {
+  NetworkManager& graph = network.GetNetworkManager();
+  NocParameters& params = network.GetNocParameters();
+  DistributedRoutingTable& routing_table = network.GetRoutingTable();
 
   // Build traffic model.
   RandomNumberInterface rnd;
   rnd.SetSeed(seed_);
 
-  const NocTrafficManager& traffic_manager =
-      experiment_config.GetTrafficConfig();
+  const NocTrafficManager& traffic_manager = traffic_config;
   XLS_ASSIGN_OR_RETURN(TrafficModeId mode_id,
                        traffic_manager.GetTrafficModeIdByName(mode_name_));
   XLS_ASSIGN_OR_RETURN(
@@ -332,4 +405,72 @@ absl::StatusOr<ExperimentData> ExperimentRunner::RunExperiment(
   return experiment_data;
 }
 
+absl::StatusOr<std::vector<ExperimentData>> Experiment::RunAllSteps(
+    int64_t thread_count,
+    DistributedRoutingTableBuilderBase&& distributed_routing_table_builder)
+    const {
+  XLS_RET_CHECK_GT(thread_count, 0);
+  int64_t step_count = GetStepCount();
+
+  // Build the network of each step, once per distinct network config. Configs
+  // are compared by their serialization, which at worst builds an identical
+  // network twice.
+  std::vector<ExperimentConfig> configs;
+  std::vector<std::unique_ptr<ExperimentNetwork>> networks;
+  std::vector<int64_t> step_network(step_count);
+  absl::flat_hash_map<std::string, int64_t> network_index;
+  for (int64_t step = 0; step < step_count; ++step) {
+    XLS_ASSIGN_OR_RETURN(ExperimentConfig config, GetConfigForStep(step));
+    auto [it, inserted] = network_index.try_emplace(
+        config.GetNetworkConfig().SerializeAsString(), networks.size());
+    if (inserted) {
+      XLS_ASSIGN_OR_RETURN(
+          std::unique_ptr<ExperimentNetwork> network,
+          ExperimentNetwork::Create(config.GetNetworkConfig(),
+                                    distributed_routing_table_builder));
+      networks.push_back(std::move(network));
+    }
+    step_network[step] = it->second;
+    configs.push_back(std::move(config));
+  }
+  VLOG(1) << absl::StreamFormat("Running %d steps on %d networks", step_count,
+                                networks.size());
+
+  // Each thread runs the next step not yet started, until all are.
+  std::vector<absl::StatusOr<ExperimentData>> results(
+      step_count, absl::UnknownError("Step was not run"));
+  absl::Mutex mutex;
+  int64_t next_step = 0;
+  auto run_steps = [&]() {
+    while (true) {
+      int64_t step;
+      {
+        absl::MutexLock lock(&mutex);
+        if (next_step == step_count) {
+          return;
+        }
+        step = next_step++;
+      }
+      results[step] = runner_.RunExperiment(*networks[step_network[step]],
+                                            configs[step].GetTrafficConfig());
+    }
+  };
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t i = 1; i < std::min(thread_count, step_count); ++i) {
+    threads.push_back(std::make_unique<Thread>(run_steps));
+  }
+  run_steps();
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+
+  std::vector<ExperimentData> step_data;
+  step_data.reserve(step_count);
+  for (absl::StatusOr<ExperimentData>& result : results) {
+    XLS_ASSIGN_OR_RETURN(ExperimentData data, std::move(result));
+    step_data.push_back(std::move(data));
+  }
+  return step_data;
+}
+
 }  // namespace xls::noc
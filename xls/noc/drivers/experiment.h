@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -35,6 +36,8 @@
 #include "xls/noc/config/network_config.pb.h"
 #include "xls/noc/simulation/flit.h"
 #include "xls/noc/simulation/global_routing_table.h"
+#include "xls/noc/simulation/network_graph.h"
+#include "xls/noc/simulation/parameters.h"
 #include "xls/noc/simulation/traffic_description.h"
 
 // This file contains classes used to construct different
@@ -143,6 +146,16 @@ class ExperimentMetrics {
     return integer_integer_map_metrics_.at(metric);
   }
 
+  // Returns all floating point metrics, ordered by name.
+  const absl::btree_map<std::string, double>& GetFloatMetrics() const {
+    return float_metrics_;
+  }
+
+  // Returns all integer metrics, ordered by name.
+  const absl::btree_map<std::string, int64_t>& GetIntegerMetrics() const {
+    return integer_metrics_;
+  }
+
   // Prints out the metrics and values stored.
   absl::Status DebugDump() const;
 
@@ -215,6 +228,41 @@ struct ExperimentData {
   ExperimentInfo info;
 };
 
+// A network built from a NetworkConfigProto, along with its routing tables.
+//
+// Building the routing tables is the most expensive part of setting up a
+// simulation of a large network. Simulations only read the network, so steps
+// of an experiment which only differ in their traffic can share it, including
+// when they are run concurrently.
+class ExperimentNetwork {
+ public:
+  static absl::StatusOr<std::unique_ptr<ExperimentNetwork>> Create(
+      const NetworkConfigProto& network_config,
+      DistributedRoutingTableBuilderBase& distributed_routing_table_builder);
+
+  NetworkManager& GetNetworkManager() { return graph_; }
+  NocParameters& GetNocParameters() { return params_; }
+  DistributedRoutingTable& GetRoutingTable() { return routing_table_; }
+
+  NetworkId GetNetworkId() const { return graph_.GetNetworkIds()[0]; }
+
+ private:
+  ExperimentNetwork() = default;
+
+  NetworkManager graph_;
+  NocParameters params_;
+  // Refers to graph_ and params_, hence the object isn't movable.
+  DistributedRoutingTable routing_table_;
+};
+
+// Formats the throughput and latency metrics of the data of each step of a
+// sweep as a comma-separated table, with a row per step.
+//
+// The columns are the traffic rates of the flows (offered load) and sinks
+// (accepted load), and the average and maximum latencies at each sink and vc.
+// Metrics missing from a step are left empty.
+std::string FormatSweepTable(absl::Span<const ExperimentData> step_data);
+
 // Class to setup and run a single step of the experiment,
 // including the setup and initialization of the traffic model.
 class ExperimentRunner {
@@ -227,6 +275,13 @@ class ExperimentRunner {
       DistributedRoutingTableBuilderBase&& distributed_routing_table_builder =
           DistributedRoutingTableBuilderForTrees()) const;
 
+  // Runs the experiment with the given traffic on a network built
+  // beforehand. The network is not modified, so several experiments can run
+  // concurrently on the same network.
+  absl::StatusOr<ExperimentData> RunExperiment(
+      ExperimentNetwork& network,
+      const NocTrafficManager& traffic_config) const;
+
   ExperimentRunner& SetSimulationCycleCount(int64_t count) {
     CHECK_GE(count, 0);
     total_simulation_cycle_count_ = count;
@@ -293,6 +348,17 @@ class Experiment {
                                 std::move(distributed_routing_table_builder));
   }
 
+  // Runs all steps of the experiment with up to thread_count threads, and
+  // returns their data in step order.
+  //
+  // Steps with identical network configs share the network and its routing
+  // tables, which are built once before any step runs. Results are the same
+  // as those of RunStep.
+  absl::StatusOr<std::vector<ExperimentData>> RunAllSteps(
+      int64_t thread_count,
+      DistributedRoutingTableBuilderBase&& distributed_routing_table_builder =
+          DistributedRoutingTableBuilderForTrees()) const;
+
   // Get the configuration for step N.
   absl::StatusOr<ExperimentConfig> GetConfigForStep(int64_t step) const {
     XLS_RET_CHECK(step >= 0 && step < GetStepCount());
@@ -0,0 +1,116 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>  // NOLINT for std::thread::hardware_concurrency()
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "xls/common/exit_status.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/noc/drivers/experiment.h"
+#include "xls/noc/drivers/experiment_factory.h"
+#include "xls/noc/drivers/sample_experiments.h"
+#include "xls/noc/simulation/global_routing_table.h"
+
+static constexpr std::string_view kUsage = R"(
+Runs all steps of a NOC experiment concurrently and prints a table of the
+throughput and latency measured at each step, in CSV format.
+
+Steps which only differ in their traffic share the network and its routing
+tables, which are built once.
+
+Example:
+  noc_sweep_main --experiment=SimpleVCExperiment --threads=4
+)";
+
+ABSL_FLAG(std::string, experiment, "",
+          "Tag of the experiment to run, see --list_experiments.");
+ABSL_FLAG(bool, list_experiments, false,
+          "Lists the tags of the available experiments and exits.");
+ABSL_FLAG(int64_t, threads, 0,
+          "Number of threads running the steps; 0 uses one per core.");
+ABSL_FLAG(bool, multiple_paths_routing, false,
+          "Builds routing tables for networks with multiple paths between "
+          "sources and sinks, rather than for trees.");
+ABSL_FLAG(std::string, output, "",
+          "File to write the table to, rather than stdout.");
+
+namespace xls::noc {
+namespace {
+
+absl::Status RealMain(std::string_view tag, int64_t thread_count,
+                      bool multiple_paths_routing, std::string_view output) {
+  ExperimentFactory factory;
+  XLS_RETURN_IF_ERROR(RegisterSampleExperiments(factory));
+  XLS_ASSIGN_OR_RETURN(Experiment experiment, factory.BuildExperiment(tag));
+
+  std::vector<ExperimentData> step_data;
+  if (multiple_paths_routing) {
+    XLS_ASSIGN_OR_RETURN(step_data,
+                         experiment.RunAllSteps(
+                             thread_count,
+                             DistributedRoutingTableBuilderForMultiplePaths()));
+  } else {
+    XLS_ASSIGN_OR_RETURN(step_data, experiment.RunAllSteps(thread_count));
+  }
+
+  std::string table = FormatSweepTable(step_data);
+  if (output.empty()) {
+    std::cout << table;
+    return absl::OkStatus();
+  }
+  return SetFileContents(output, table);
+}
+
+}  // namespace
+}  // namespace xls::noc
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  QCHECK(positional_arguments.empty())
+      << "Unexpected positional arguments: "
+      << absl::StrJoin(positional_arguments, " ");
+
+  if (absl::GetFlag(FLAGS_list_experiments)) {
+    xls::noc::ExperimentFactory factory;
+    QCHECK_OK(xls::noc::RegisterSampleExperiments(factory));
+    std::cout << absl::StrJoin(factory.ListExperimentTags(), "\n") << "\n";
+    return 0;
+  }
+
+  QCHECK(!absl::GetFlag(FLAGS_experiment).empty())
+      << "Must specify --experiment";
+  int64_t thread_count = absl::GetFlag(FLAGS_threads);
+  QCHECK_GE(thread_count, 0) << "--threads must not be negative";
+  if (thread_count == 0) {
+    thread_count = std::max<int64_t>(1, std::thread::hardware_concurrency());
+  }
+
+  return xls::ExitStatus(
+      xls::noc::RealMain(absl::GetFlag(FLAGS_experiment), thread_count,
+                         absl::GetFlag(FLAGS_multiple_paths_routing),
+                         absl::GetFlag(FLAGS_output)));
+}
@@ -23,6 +23,7 @@
 #include "absl/container/btree_map.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
 #include "xls/common/status/matchers.h"
 #include "xls/noc/drivers/experiment.h"
 #include "xls/noc/drivers/experiment_factory.h"
@@ -166,6 +167,39 @@ TEST(SampleExperimentsTest, SimpleVCExperiment) {
       link_to_packet_count_map.at("Link0A").begin()->second);
 }
 
+TEST(SampleExperimentsTest, SimpleVCExperimentAllSteps) {
+  ExperimentFactory experiment_factory;
+  XLS_ASSERT_OK(RegisterSampleExperiments(experiment_factory));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Experiment experiment,
+      experiment_factory.BuildExperiment("SimpleVCExperiment"));
+
+  // Steps 0 and 1 share a network, as do steps 2 and 3.
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<ExperimentData> experiment_data,
+                           experiment.RunAllSteps(/*thread_count=*/4));
+  ASSERT_EQ(experiment_data.size(), 4);
+
+  for (int64_t i = 0; i < experiment_data.size(); ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(ExperimentData expected, experiment.RunStep(i));
+    EXPECT_EQ(experiment_data[i].metrics.GetFloatMetrics(),
+              expected.metrics.GetFloatMetrics())
+        << "step " << i;
+    EXPECT_EQ(experiment_data[i].metrics.GetIntegerMetrics(),
+              expected.metrics.GetIntegerMetrics())
+        << "step " << i;
+  }
+
+  std::vector<std::string> table_lines =
+      absl::StrSplit(FormatSweepTable(experiment_data), '\n',
+                     absl::SkipEmpty());
+  ASSERT_EQ(table_lines.size(), 5);
+  EXPECT_THAT(table_lines[0],
+              ::testing::StartsWith("Step,Flow:flow_0:TrafficRateInMiBps,"));
+  EXPECT_THAT(table_lines[0],
+              ::testing::HasSubstr("Sink:RecvPort0:VC:1:AverageLatency"));
+  EXPECT_THAT(table_lines[4], ::testing::StartsWith("3,"));
+}
+
 TEST(SampleExperimentsTest, AggregateTreeTest) {
   ExperimentFactory experiment_factory;
   XLS_ASSERT_OK(RegisterSampleExperiments(experiment_factory));
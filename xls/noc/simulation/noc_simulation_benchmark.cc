@@ -0,0 +1,126 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "include/benchmark/benchmark.h"
+#include "xls/noc/config/network_config.pb.h"
+#include "xls/noc/simulation/common.h"
+#include "xls/noc/simulation/global_routing_table.h"
+#include "xls/noc/simulation/network_graph.h"
+#include "xls/noc/simulation/noc_traffic_injector.h"
+#include "xls/noc/simulation/parameters.h"
+#include "xls/noc/simulation/random_number_interface.h"
+#include "xls/noc/simulation/sample_network_graphs.h"
+#include "xls/noc/simulation/sim_objects.h"
+#include "xls/noc/simulation/simulator_to_traffic_injector_shim.h"
+#include "xls/noc/simulation/traffic_description.h"
+
+namespace xls::noc {
+namespace {
+
+using BuildNetworkGraphFn = absl::Status (*)(NetworkConfigProto*,
+                                             NetworkManager*, NocParameters*);
+
+// Simulates a sample network with random traffic from SendPort<i> to
+// RecvPort<i>, for i in [0, port_count), each at the given rate.
+//
+// The first argument of the benchmark is the traffic rate of each flow in
+// MiBps, the second one is the number of partitions the network is
+// simulated in (see NocSimulator::EnableParallelSimulation), and the third one
+// enables the event-driven mode (see NocSimulator::SetEventDriven).
+void BM_SimulateNetwork(benchmark::State& state, BuildNetworkGraphFn build,
+                        int64_t port_count) {
+  constexpr int64_t kCyclesPerIteration = 1000;
+  int64_t rate_in_mibps = state.range(0);
+  int64_t partition_count = state.range(1);
+  bool event_driven = state.range(2) != 0;
+
+  NocTrafficManager traffic_mgr;
+  TrafficModeId mode_id = traffic_mgr.CreateTrafficMode().value();
+  TrafficMode& mode = traffic_mgr.GetTrafficMode(mode_id);
+  mode.SetName("Mode 0");
+  for (int64_t i = 0; i < port_count; ++i) {
+    TrafficFlowId flow_id = traffic_mgr.CreateTrafficFlow().value();
+    traffic_mgr.GetTrafficFlow(flow_id)
+        .SetName(absl::StrFormat("flow%d", i))
+        .SetSource(absl::StrFormat("SendPort%d", i))
+        .SetDestination(absl::StrFormat("RecvPort%d", i))
+        .SetVC("VC0")
+        .SetTrafficRateInMiBps(rate_in_mibps)
+        .SetPacketSizeInBits(128)
+        .SetBurstProbInMils(7);
+    mode.RegisterTrafficFlow(flow_id);
+  }
+
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  CHECK_OK(build(&proto, &graph, &params));
+
+  DistributedRoutingTableBuilderForMultiplePaths route_builder;
+  DistributedRoutingTable routing_table =
+      route_builder
+          .BuildNetworkRoutingTables(graph.GetNetworkIds()[0], graph, params)
+          .value();
+
+  RandomNumberInterface rnd;
+  int64_t cycle_time_in_ps = 400;
+  rnd.SetSeed(1000);
+  NocTrafficInjector traffic_injector =
+      NocTrafficInjectorBuilder()
+          .Build(cycle_time_in_ps, mode_id,
+                 routing_table.GetSourceIndices().GetNetworkComponents(),
+                 routing_table.GetSinkIndices().GetNetworkComponents(),
+                 params.GetNetworkParam(graph.GetNetworkIds()[0])
+                     ->GetVirtualChannels(),
+                 traffic_mgr, graph, params, rnd)
+          .value();
+
+  NocSimulator simulator;
+  CHECK_OK(simulator.Initialize(graph, params, routing_table,
+                                graph.GetNetworkIds()[0]));
+  CHECK_OK(simulator.EnableParallelSimulation(partition_count));
+  simulator.SetEventDriven(event_driven);
+
+  NocSimulatorToNocTrafficInjectorShim injector_shim(simulator,
+                                                     traffic_injector);
+  traffic_injector.SetSimulatorShim(injector_shim);
+  simulator.RegisterPreCycleService(injector_shim);
+
+  for (auto _ : state) {
+    CHECK_OK(simulator.RunCycles(kCyclesPerIteration));
+  }
+  // Items are simulated cycles, bytes are the injected traffic.
+  state.SetItemsProcessed(state.iterations() * kCyclesPerIteration);
+  int64_t bits_sent = 0;
+  for (int64_t flow = 0; flow < traffic_injector.FlowCount(); ++flow) {
+    bits_sent += traffic_injector.MeasuredBitsSent(flow);
+  }
+  state.SetBytesProcessed(bits_sent / 8);
+}
+
+BENCHMARK_CAPTURE(BM_SimulateNetwork, Linear001, BuildNetworkGraphLinear001,
+                  /*port_count=*/2)
+    ->ArgsProduct({{64, 256, 1024, 3 * 1024}, {1, 2}, {0, 1}});
+
+BENCHMARK_CAPTURE(BM_SimulateNetwork, Loop001, BuildNetworkGraphLoop001,
+                  /*port_count=*/4)
+    ->ArgsProduct({{64, 256, 1024, 3 * 1024}, {1, 2}, {0, 1}});
+
+}  // namespace
+}  // namespace xls::noc
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string_view>
 #include <utility>
@@ -90,6 +91,37 @@ absl::Status NocTrafficInjector::RunCycle() {
   return absl::OkStatus();
 }
 
+int64_t NocTrafficInjector::GetNextInjectionCycle() const {
+  int64_t next_cycle = std::numeric_limits<int64_t>::max();
+  for (const std::unique_ptr<TrafficModel>& model : traffic_models_) {
+    next_cycle = std::min(next_cycle, model->GetNextPacketCycle());
+  }
+  return next_cycle;
+}
+
+absl::Status NocTrafficInjector::SkipCycles(int64_t cycle_count) {
+  XLS_RET_CHECK_GE(cycle_count, 0);
+  if (cycle_count == 0) {
+    return absl::OkStatus();
+  }
+  XLS_RET_CHECK_LT(cycle_ + cycle_count, GetNextInjectionCycle())
+      << "Unable to skip cycles in which packets are injected.";
+
+  cycle_ += cycle_count;
+
+  // Only the last skipped cycle is presented to the models and monitors, so
+  // that they account for the elapsed time.
+  for (int64_t i = 0; i < traffic_models_.size(); ++i) {
+    std::vector<DataPacket> packets =
+        traffic_models_[i]->GetNewCyclePackets(cycle_);
+    XLS_RET_CHECK(packets.empty());
+    traffic_model_monitor_[i].AcceptNewPackets(absl::MakeSpan(packets),
+                                               cycle_);
+  }
+
+  return absl::OkStatus();
+}
+
 namespace {
 
 // Function that calls run_action(i, j) for each flow and network_component
@@ -48,6 +48,14 @@ class NocTrafficInjector {
   // on the current_cycle.
   absl::Status RunCycle();
 
+  // Returns the next cycle in which packets are injected, or
+  // std::numeric_limits<int64_t>::max() if none will be.
+  int64_t GetNextInjectionCycle() const;
+
+  // Advances by cycle_count cycles in which no packets are injected, in
+  // place of as many calls to RunCycle().
+  absl::Status SkipCycles(int64_t cycle_count);
+
   // Provides the interface between this object and the NOC simulator.
   void SetSimulatorShim(NocSimulatorTrafficServiceShim& simulator) {
     simulator_ = &simulator;
@@ -255,6 +263,14 @@ class NocTrafficInjectorService : public NocSimulatorServiceShim {
 
   absl::Status RunCycle() override { return injector_->RunCycle(); }
 
+  int64_t GetNextEventCycle(int64_t cycle) override {
+    return injector_->GetNextInjectionCycle();
+  }
+
+  absl::Status SkipCycles(int64_t cycle_count) override {
+    return injector_->SkipCycles(cycle_count);
+  }
+
  private:
   NocTrafficInjector* injector_;
 };
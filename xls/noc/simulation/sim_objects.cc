@@ -14,20 +14,27 @@
 
 #include "xls/noc/simulation/sim_objects.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <queue>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/ir/bits.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/flit.h"
@@ -51,12 +58,13 @@ class SimplePipelineImpl {
  public:
   SimplePipelineImpl(int64_t stage_count, DataTimePhitT& from_channel,
                      DataTimePhitT& to_channel,
-                     std::queue<DataTimePhitT>& state,
+                     FlitRingPool<DataTimePhitT>& state, int64_t state_ring,
                      int64_t& internal_propagated_cycle)
       : stage_count_(stage_count),
         from_(from_channel),
         to_(to_channel),
         state_(state),
+        state_ring_(state_ring),
         internal_propagated_cycle_(internal_propagated_cycle) {}
 
   bool TryPropagation(NocSimulator& simulator);
@@ -66,7 +74,10 @@ class SimplePipelineImpl {
   DataTimePhitT& from_;
   DataTimePhitT& to_;
   // TODO(vmirian) 09-07-21 Optimize to select flit data and its metadata
-  std::queue<DataTimePhitT>& state_;
+  // The ring of state_ holding the phits in the pipeline stages, its
+  // capacity is the stage count.
+  FlitRingPool<DataTimePhitT>& state_;
+  int64_t state_ring_;
   int64_t& internal_propagated_cycle_;
 };
 
@@ -99,11 +110,12 @@ bool SimplePipelineImpl<DataTimePhitT>::TryPropagation(
     // There is one pipeline stage so output can be updated
     // immediately.
     if (to_.cycle != current_cycle) {
-      if (state_.size() >= stage_count_) {
-        to_.flit = state_.front().flit;
+      if (state_.size(state_ring_) >= stage_count_) {
+        DataTimePhitT& front = state_.front(state_ring_);
+        to_.flit = front.flit;
         to_.cycle = current_cycle;
-        to_.metadata = state_.front().metadata;
-        state_.pop();
+        to_.metadata = front.metadata;
+        state_.pop(state_ring_);
       } else {
         to_.flit.type = FlitType::kInvalid;
         to_.flit.data = Bits(32);
@@ -116,7 +128,7 @@ bool SimplePipelineImpl<DataTimePhitT>::TryPropagation(
     }
 
     if (from_.cycle == current_cycle) {
-      state_.push(from_);
+      state_.push(state_ring_, from_);
       VLOG(2) << absl::StreamFormat("... link received data %v type %d",
                                     from_.flit.data, from_.flit.type);
 
@@ -130,8 +142,154 @@ bool SimplePipelineImpl<DataTimePhitT>::TryPropagation(
   return internal_propagated_cycle_ == current_cycle;
 }
 
+// Blocks threads until all of them have reached the end of the current phase
+// of a cycle. Can be reused for any number of phases.
+class PhaseBarrier {
+ public:
+  explicit PhaseBarrier(int64_t thread_count) : thread_count_(thread_count) {}
+
+  void ArriveAndWait() {
+    absl::MutexLock lock(&mutex_);
+    int64_t phase = phase_;
+    if (++arrived_count_ == thread_count_) {
+      arrived_count_ = 0;
+      ++phase_;
+      cond_var_.SignalAll();
+      return;
+    }
+    while (phase == phase_) {
+      cond_var_.Wait(&mutex_);
+    }
+  }
+
+ private:
+  const int64_t thread_count_;
+  absl::Mutex mutex_;
+  absl::CondVar cond_var_;
+  int64_t arrived_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t phase_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
 }  // namespace
 
+class NocParallelSimulation {
+ public:
+  // Components simulated by one thread.
+  struct Partition {
+    // Components ticked until convergence, in the order of the serial
+    // simulator.
+    std::vector<SimNetworkComponentBase*> components;
+
+    // Links cutting the network, ticked by this partition's thread before
+    // (to drive their outputs) and after (to consume their inputs) the
+    // partitions converge.
+    std::vector<SimNetworkComponentBase*> cut_links;
+
+    absl::Status status;
+  };
+
+  NocParallelSimulation(NocSimulator& simulator,
+                        std::vector<Partition> partitions)
+      : simulator_(simulator),
+        partitions_(std::move(partitions)),
+        barrier_(partitions_.size()) {
+    // The first partition is run by the thread calling RunCycle.
+    for (int64_t i = 1; i < partitions_.size(); ++i) {
+      threads_.push_back(std::make_unique<Thread>([this, i]() {
+        while (true) {
+          barrier_.ArriveAndWait();
+          if (shutdown_) {
+            return;
+          }
+          RunPartition(i);
+          barrier_.ArriveAndWait();
+        }
+      }));
+    }
+  }
+
+  ~NocParallelSimulation() {
+    shutdown_ = true;
+    barrier_.ArriveAndWait();
+    for (std::unique_ptr<Thread>& thread : threads_) {
+      thread->Join();
+    }
+  }
+
+  int64_t partition_count() const { return partitions_.size(); }
+
+  // Simulates the current cycle of the simulator on all partitions.
+  absl::Status RunCycle(int64_t max_ticks) {
+    max_ticks_ = max_ticks;
+    barrier_.ArriveAndWait();
+    RunPartition(0);
+    barrier_.ArriveAndWait();
+    for (const Partition& partition : partitions_) {
+      XLS_RETURN_IF_ERROR(partition.status);
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  // Runs the phases of a cycle on a partition, synchronizing with the
+  // threads of the other partitions in between. No connection is accessed by
+  // two threads within a phase: in the first and last phases, only cut links
+  // are ticked and no two of them are connected to each other, and in the
+  // second phase, the connections of cut links are only accessed from the
+  // single component on their other side.
+  void RunPartition(int64_t index) {
+    Partition& partition = partitions_[index];
+    partition.status = absl::OkStatus();
+    int64_t cycle = simulator_.GetCurrentCycle();
+
+    // The inputs of the cut links aren't ready yet, but their pipeline
+    // stages drive their outputs for the cycle.
+    for (SimNetworkComponentBase* link : partition.cut_links) {
+      link->Tick(simulator_);
+    }
+    barrier_.ArriveAndWait();
+
+    bool converged = false;
+    int64_t nticks = 0;
+    while (!converged) {
+      converged = true;
+      for (SimNetworkComponentBase* nc : partition.components) {
+        converged &= nc->Tick(simulator_);
+      }
+      ++nticks;
+      if (!converged && nticks >= max_ticks_) {
+        partition.status = absl::InternalError(absl::StrFormat(
+            "Simulator partition %d unable to converge after %d ticks for "
+            "cycle %d",
+            index, nticks, cycle));
+        break;
+      }
+    }
+    barrier_.ArriveAndWait();
+
+    for (SimNetworkComponentBase* link : partition.cut_links) {
+      if (!link->Tick(simulator_) && partition.status.ok()) {
+        partition.status = absl::InternalError(absl::StrFormat(
+            "Link %x cutting the network unable to converge for cycle %d",
+            link->GetId().AsUInt64(), cycle));
+      }
+    }
+  }
+
+  NocSimulator& simulator_;
+  std::vector<Partition> partitions_;
+  PhaseBarrier barrier_;
+
+  // Only written by the thread calling RunCycle while the other threads wait
+  // at the barrier.
+  int64_t max_ticks_ = 0;
+  bool shutdown_ = false;
+
+  std::vector<std::unique_ptr<Thread>> threads_;
+};
+
+NocSimulator::~NocSimulator() = default;
+
 absl::Status NocSimulator::CreateSimulationObjects(NetworkId network) {
   Network& network_obj = mgr_->GetNetwork(network);
 
@@ -267,16 +425,20 @@ absl::Status NocSimulator::RunCycle(int64_t max_ticks) {
     XLS_RET_CHECK_OK(svc->RunCycle());
   }
 
-  bool converged = false;
-  int64_t nticks = 0;
-  while (!converged) {
-    VLOG(2) << absl::StreamFormat("Tick %d", nticks);
-    converged = Tick();
-    ++nticks;
-    if (nticks >= max_ticks) {
-      return absl::InternalError(absl::StrFormat(
-          "Simulator unable to converge after %d ticks for cycle %d", nticks,
-          cycle_));
+  if (parallel_ != nullptr) {
+    XLS_RETURN_IF_ERROR(parallel_->RunCycle(max_ticks));
+  } else {
+    bool converged = false;
+    int64_t nticks = 0;
+    while (!converged) {
+      VLOG(2) << absl::StreamFormat("Tick %d", nticks);
+      converged = Tick();
+      ++nticks;
+      if (nticks >= max_ticks) {
+        return absl::InternalError(absl::StrFormat(
+            "Simulator unable to converge after %d ticks for cycle %d", nticks,
+            cycle_));
+      }
     }
   }
 
@@ -300,6 +462,228 @@ absl::Status NocSimulator::RunCycle(int64_t max_ticks) {
   return absl::OkStatus();
 }
 
+absl::Status NocSimulator::RunCycles(int64_t cycle_count, int64_t max_ticks) {
+  XLS_RET_CHECK_GE(cycle_count, 0);
+  int64_t last_cycle = cycle_ + cycle_count;
+
+  while (cycle_ < last_cycle) {
+    if (event_driven_ && IsIdle()) {
+      // The network stays idle until a service next acts on it. The last
+      // cycle is always simulated so that connections hold its state.
+      int64_t next_cycle = last_cycle;
+      for (NocSimulatorServiceShim* svc : pre_cycle_services_) {
+        next_cycle = std::min(next_cycle, svc->GetNextEventCycle(cycle_));
+      }
+      for (NocSimulatorServiceShim* svc : post_cycle_services_) {
+        next_cycle = std::min(next_cycle, svc->GetNextEventCycle(cycle_));
+      }
+
+      int64_t skipped_cycles = next_cycle - cycle_ - 1;
+      if (skipped_cycles > 0) {
+        for (NocSimulatorServiceShim* svc : pre_cycle_services_) {
+          XLS_RETURN_IF_ERROR(svc->SkipCycles(skipped_cycles));
+        }
+        for (NocSimulatorServiceShim* svc : post_cycle_services_) {
+          XLS_RETURN_IF_ERROR(svc->SkipCycles(skipped_cycles));
+        }
+        cycle_ += skipped_cycles;
+        skipped_cycle_count_ += skipped_cycles;
+        VLOG(2) << absl::StreamFormat("*** Skipped %d idle cycles to cycle %d",
+                                      skipped_cycles, cycle_);
+      }
+    }
+
+    XLS_RETURN_IF_ERROR(RunCycle(max_ticks));
+  }
+
+  return absl::OkStatus();
+}
+
+bool NocSimulator::IsIdle() const {
+  if (cycle_ < 0) {
+    return false;
+  }
+  // Sinks don't buffer traffic, so they are always idle.
+  for (const SimNetworkInterfaceSrc& nc : network_interface_sources_) {
+    if (!nc.IsIdle()) {
+      return false;
+    }
+  }
+  for (const SimLink& nc : links_) {
+    if (!nc.IsIdle()) {
+      return false;
+    }
+  }
+  for (const SimInputBufferedVCRouter& nc : routers_) {
+    if (!nc.IsIdle()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::Status NocSimulator::EnableParallelSimulation(int64_t partition_count) {
+  XLS_RET_CHECK_GT(partition_count, 0);
+  XLS_RET_CHECK(parallel_ == nullptr)
+      << "Parallel simulation is already enabled";
+  XLS_RET_CHECK_EQ(cycle_, -1)
+      << "Parallel simulation must be enabled before running cycles";
+  if (partition_count == 1) {
+    return absl::OkStatus();
+  }
+
+  // All simulation objects, in the order they are ticked by Tick().
+  std::vector<SimNetworkComponentBase*> components;
+  for (SimNetworkInterfaceSrc& nc : network_interface_sources_) {
+    components.push_back(&nc);
+  }
+  for (SimLink& nc : links_) {
+    components.push_back(&nc);
+  }
+  for (SimInputBufferedVCRouter& nc : routers_) {
+    components.push_back(&nc);
+  }
+  for (SimNetworkInterfaceSink& nc : network_interface_sinks_) {
+    components.push_back(&nc);
+  }
+  absl::flat_hash_map<NetworkComponentId, int64_t> component_index;
+  for (int64_t i = 0; i < components.size(); ++i) {
+    component_index[components[i]->GetId()] = i;
+  }
+
+  // Components connected to each component.
+  std::vector<std::vector<int64_t>> neighbors(components.size());
+  for (int64_t i = 0; i < components.size(); ++i) {
+    for (const Port& port :
+         mgr_->GetNetworkComponent(components[i]->GetId()).GetPorts()) {
+      if (!port.connection().IsValid()) {
+        continue;
+      }
+      Connection& connection = mgr_->GetConnection(port.connection());
+      PortId other =
+          connection.src() == port.id() ? connection.sink() : connection.src();
+      if (!other.IsValid()) {
+        continue;
+      }
+      auto it = component_index.find(other.GetNetworkComponentId());
+      if (it != component_index.end()) {
+        neighbors[i].push_back(it->second);
+      }
+    }
+  }
+
+  // The network is cut at links with pipeline stages in both directions,
+  // unless they are connected to another link.
+  auto is_link = [&](int64_t i) {
+    return mgr_->GetNetworkComponent(components[i]->GetId()).kind() ==
+           NetworkComponentKind::kLink;
+  };
+  std::vector<bool> is_cut(components.size(), false);
+  for (int64_t i = 0; i < components.size(); ++i) {
+    if (!is_link(i)) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(
+        NetworkComponentParam nc_param,
+        params_->GetNetworkComponentParam(components[i]->GetId()));
+    LinkParam& param = std::get<LinkParam>(nc_param);
+    is_cut[i] = param.GetSourceToSinkPipelineStages() > 0 &&
+                param.GetSinkToSourcePipelineStages() > 0 &&
+                absl::c_none_of(neighbors[i], is_link);
+  }
+
+  // Visit the network breadth-first so that clusters of components which
+  // aren't separated by cut links are numbered in an order where neighboring
+  // clusters are close.
+  std::vector<int64_t> order;
+  std::vector<bool> visited(components.size(), false);
+  for (int64_t start = 0; start < components.size(); ++start) {
+    if (visited[start]) {
+      continue;
+    }
+    visited[start] = true;
+    order.push_back(start);
+    for (int64_t next = order.size() - 1; next < order.size(); ++next) {
+      for (int64_t neighbor : neighbors[order[next]]) {
+        if (!visited[neighbor]) {
+          visited[neighbor] = true;
+          order.push_back(neighbor);
+        }
+      }
+    }
+  }
+  std::vector<int64_t> cluster(components.size(), -1);
+  std::vector<int64_t> cluster_sizes;
+  for (int64_t i : order) {
+    if (is_cut[i] || cluster[i] >= 0) {
+      continue;
+    }
+    int64_t c = cluster_sizes.size();
+    cluster_sizes.push_back(0);
+    cluster[i] = c;
+    std::vector<int64_t> worklist = {i};
+    while (!worklist.empty()) {
+      int64_t current = worklist.back();
+      worklist.pop_back();
+      ++cluster_sizes[c];
+      for (int64_t neighbor : neighbors[current]) {
+        if (!is_cut[neighbor] && cluster[neighbor] < 0) {
+          cluster[neighbor] = c;
+          worklist.push_back(neighbor);
+        }
+      }
+    }
+  }
+  if (cluster_sizes.size() < 2) {
+    VLOG(1) << "Network can't be partitioned, simulating serially";
+    return absl::OkStatus();
+  }
+
+  // Assign consecutive clusters to partitions of balanced sizes.
+  partition_count =
+      std::min(partition_count, static_cast<int64_t>(cluster_sizes.size()));
+  int64_t total_size = absl::c_accumulate(cluster_sizes, int64_t{0});
+  std::vector<int64_t> cluster_partition(cluster_sizes.size());
+  int64_t preceding_size = 0;
+  for (int64_t c = 0; c < cluster_sizes.size(); ++c) {
+    cluster_partition[c] = preceding_size * partition_count / total_size;
+    preceding_size += cluster_sizes[c];
+  }
+
+  // A cut link is ticked by the partition of (one of) its neighbors.
+  std::vector<NocParallelSimulation::Partition> partitions(partition_count);
+  for (int64_t i = 0; i < components.size(); ++i) {
+    if (is_cut[i]) {
+      int64_t partition = neighbors[i].empty()
+                              ? 0
+                              : cluster_partition[cluster[neighbors[i][0]]];
+      partitions[partition].cut_links.push_back(components[i]);
+    } else {
+      partitions[cluster_partition[cluster[i]]].components.push_back(
+          components[i]);
+    }
+  }
+  std::erase_if(partitions,
+                [](const NocParallelSimulation::Partition& partition) {
+                  return partition.components.empty() &&
+                         partition.cut_links.empty();
+                });
+  if (partitions.size() < 2) {
+    return absl::OkStatus();
+  }
+
+  VLOG(1) << absl::StreamFormat(
+      "Simulating %d components in %d partitions (%d clusters)",
+      components.size(), partitions.size(), cluster_sizes.size());
+  parallel_ =
+      std::make_unique<NocParallelSimulation>(*this, std::move(partitions));
+  return absl::OkStatus();
+}
+
+int64_t NocSimulator::GetPartitionCount() const {
+  return parallel_ == nullptr ? 1 : parallel_->partition_count();
+}
+
 bool NocSimulator::Tick() {
   // Goes through each simulator object and run atick.
   // Converges when everyone returns True -- that determines new cycle
@@ -370,6 +754,33 @@ int64_t SimLink::GetSourceConnectionIndex() const {
   return src_connection_index_;
 }
 
+bool SimLink::IsIdle() const {
+  // Until the stages are full, the output of the link is invalid regardless
+  // of its input, so the fill level of the stages matters too.
+  if (forward_data_stages_.size(0) != forward_pipeline_stages_) {
+    return false;
+  }
+  for (int64_t i = 0; i < forward_pipeline_stages_; ++i) {
+    if (forward_data_stages_.at(0, i).flit.type != FlitType::kInvalid) {
+      return false;
+    }
+  }
+
+  for (int64_t vc = 0; vc < reverse_credit_stages_.ring_count(); ++vc) {
+    if (reverse_credit_stages_.size(vc) != reverse_pipeline_stages_) {
+      return false;
+    }
+    for (int64_t i = 0; i < reverse_pipeline_stages_; ++i) {
+      const MetadataFlit& credit = reverse_credit_stages_.at(vc, i).flit;
+      if (credit.type != FlitType::kInvalid && !credit.data.IsZero()) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 absl::Status SimLink::InitializeImpl(NocSimulator& simulator) {
   XLS_ASSIGN_OR_RETURN(
       NetworkComponentParam nc_param,
@@ -406,8 +817,14 @@ absl::Status SimLink::InitializeImpl(NocSimulator& simulator) {
   SimConnectionState& sink =
       simulator.GetSimConnectionByIndex(sink_connection_index_);
 
+  // The stages hold at most one phit per stage: the output is updated before
+  // the input is registered every cycle.
+  forward_data_stages_.AddRing(forward_pipeline_stages_);
+
   int64_t reverse_channel_count = sink.reverse_channels.size();
-  reverse_credit_stages_.resize(reverse_channel_count);
+  for (int64_t vc = 0; vc < reverse_channel_count; ++vc) {
+    reverse_credit_stages_.AddRing(reverse_pipeline_stages_);
+  }
   internal_reverse_propagated_cycle_ =
       std::vector(reverse_channel_count, simulator.GetCurrentCycle());
 
@@ -450,6 +867,15 @@ absl::Status SimNetworkInterfaceSrc::SendFlitAtTime(TimedDataFlit flit) {
                       data_to_send_.size()));
 }
 
+bool SimNetworkInterfaceSrc::IsIdle() const {
+  for (int64_t vc = 0; vc < data_to_send_.size(); ++vc) {
+    if (!data_to_send_[vc].empty() || credit_update_[vc].credit != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 absl::Status SimNetworkInterfaceSink::InitializeImpl(NocSimulator& simulator) {
   XLS_ASSIGN_OR_RETURN(
       NetworkComponentParam nc_param,
@@ -461,10 +887,9 @@ absl::Status SimNetworkInterfaceSink::InitializeImpl(NocSimulator& simulator) {
   std::vector<VirtualChannelParam> vc_params = port_param.GetVirtualChannels();
   int64_t virtual_channel_count = port_param.VirtualChannelCount();
 
-  input_buffers_.resize(virtual_channel_count);
-
+  input_buffer_depths_.resize(virtual_channel_count);
   for (int64_t vc = 0; vc < virtual_channel_count; ++vc) {
-    input_buffers_[vc].max_queue_size = vc_params[vc].GetDepth();
+    input_buffer_depths_[vc] = vc_params[vc].GetDepth();
   }
 
   NetworkManager* network_manager = simulator.GetNetworkManager();
@@ -480,6 +905,17 @@ absl::Status SimNetworkInterfaceSink::InitializeImpl(NocSimulator& simulator) {
 int64_t SimInputBufferedVCRouter::GetUtilizationCycleCount() const {
   return utilization_cycle_count_;
 }
+
+bool SimInputBufferedVCRouter::IsIdle() const {
+  for (int64_t i = 0; i < input_buffers_.ring_count(); ++i) {
+    if (!input_buffers_.empty(i)) {
+      return false;
+    }
+  }
+  return absl::c_all_of(credit_update_, [](const CreditState& update) {
+    return update.credit == 0;
+  });
+}
 absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
   NetworkManager* network_manager = simulator.GetNetworkManager();
   NetworkComponent& nc = network_manager->GetNetworkComponent(id_);
@@ -495,8 +931,8 @@ absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
   absl::Span<int64_t> input_indices = simulator.GetConnectionIndicesStore(
       input_connection_index_start_, input_connection_count_);
 
-  input_buffers_.resize(input_connection_count_);
-  input_credit_to_send_.resize(input_connection_count_);
+  input_vc_start_.resize(input_connection_count_ + 1);
+  input_vc_start_[0] = 0;
   max_vc_ = 0;
   for (int64_t i = 0; i < input_connection_count_; ++i) {
     XLS_ASSIGN_OR_RETURN(
@@ -510,15 +946,17 @@ absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
     std::vector<VirtualChannelParam> vc_params =
         port_param.GetVirtualChannels();
 
-    input_buffers_[i].resize(port_param.VirtualChannelCount());
+    // Rings are added in the order of the flat per-(port, vc) index.
     for (int64_t vc = 0; vc < port_param.VirtualChannelCount(); ++vc) {
-      input_buffers_[i][vc].max_queue_size = vc_params[vc].GetDepth();
+      input_buffers_.AddRing(vc_params[vc].GetDepth());
     }
-    input_credit_to_send_[i].resize(port_param.VirtualChannelCount());
+    input_vc_start_[i + 1] =
+        input_vc_start_[i] + port_param.VirtualChannelCount();
     if (max_vc_ < port_param.VirtualChannelCount()) {
       max_vc_ = port_param.VirtualChannelCount();
     }
   }
+  input_credit_to_send_.resize(input_vc_start_.back(), 0);
 
   // Setup structures associated with the outputs.
   //  - output to SimConnectionState (output_connection_index_start_ and count_)
@@ -528,8 +966,8 @@ absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
       simulator.GetNewConnectionIndicesStore(output_connection_count_);
   absl::Span<int64_t> output_indices = simulator.GetConnectionIndicesStore(
       output_connection_index_start_, output_connection_count_);
-  credit_.resize(output_connection_count_);
-  credit_update_.resize(output_connection_count_);
+  output_vc_start_.resize(output_connection_count_ + 1);
+  output_vc_start_[0] = 0;
   for (int64_t i = 0; i < output_connection_count_; ++i) {
     XLS_ASSIGN_OR_RETURN(
         PortId port_id,
@@ -539,10 +977,12 @@ absl::Status SimInputBufferedVCRouter::InitializeImpl(NocSimulator& simulator) {
 
     XLS_ASSIGN_OR_RETURN(PortParam port_param,
                          simulator.GetNocParameters()->GetPortParam(port_id));
-    credit_[i].resize(port_param.VirtualChannelCount(), 0);
-    credit_update_[i].resize(port_param.VirtualChannelCount(),
-                             CreditState{simulator.GetCurrentCycle(), 0});
+    output_vc_start_[i + 1] =
+        output_vc_start_[i] + port_param.VirtualChannelCount();
   }
+  credit_.resize(output_vc_start_.back(), 0);
+  credit_update_.resize(output_vc_start_.back(),
+                        CreditState{simulator.GetCurrentCycle(), 0});
 
   internal_propagated_cycle_ = simulator.GetCurrentCycle();
   utilization_cycle_count_ = 0;
@@ -559,7 +999,8 @@ bool SimLink::TryForwardPropagation(NocSimulator& simulator) {
   bool did_propagate =
       SimplePipelineImpl<TimedDataFlit>(
           forward_pipeline_stages_, src.forward_channels, sink.forward_channels,
-          forward_data_stages_, internal_forward_propagated_cycle_)
+          forward_data_stages_, /*state_ring=*/0,
+          internal_forward_propagated_cycle_)
           .TryPropagation(simulator);
 
   if (did_propagate) {
@@ -582,7 +1023,7 @@ bool SimLink::TryReversePropagation(NocSimulator& simulator) {
   for (int64_t vc = 0; vc < vc_count; ++vc) {
     if (SimplePipelineImpl<TimedMetadataFlit>(
             reverse_pipeline_stages_, sink.reverse_channels.at(vc),
-            src.reverse_channels.at(vc), reverse_credit_stages_.at(vc),
+            src.reverse_channels.at(vc), reverse_credit_stages_, vc,
             internal_reverse_propagated_cycle_.at(vc))
             .TryPropagation(simulator)) {
       ++num_propagated;
@@ -740,20 +1181,22 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
 
   // Update credits (for output ports)
   if (internal_propagated_cycle_ != current_cycle) {
-    for (int64_t i = 0; i < credit_update_.size(); ++i) {
-      for (int64_t vc = 0; vc < credit_update_[i].size(); ++vc) {
-        if (credit_update_[i][vc].credit > 0) {
-          credit_[i][vc] += credit_update_[i][vc].credit;
+    for (int64_t i = 0; i < output_connection_count_; ++i) {
+      for (int64_t vc = 0; vc < output_vc_start_[i + 1] - output_vc_start_[i];
+           ++vc) {
+        int64_t index = output_vc_start_[i] + vc;
+        if (credit_update_[index].credit > 0) {
+          credit_[index] += credit_update_[index].credit;
           VLOG(2) << absl::StrFormat(
               "... router %x output port %d vc %d added credits %d, now %d",
-              GetId().AsUInt64(), i, vc, credit_update_[i][vc].credit,
-              credit_[i][vc]);
+              GetId().AsUInt64(), i, vc, credit_update_[index].credit,
+              credit_[index]);
         } else {
           VLOG(2) << absl::StrFormat(
               "... router %x output port %d vc %d did not add credits %d, now "
               "%d",
-              GetId().AsUInt64(), i, vc, credit_update_[i][vc].credit,
-              credit_[i][vc]);
+              GetId().AsUInt64(), i, vc, credit_update_[index].credit,
+              credit_[index]);
         }
       }
     }
@@ -778,11 +1221,7 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
   }
 
   // Reset credits to send on reverse channel to 0.
-  for (int64_t i = 0; i < input_connection_count_; ++i) {
-    for (int64_t vc = 0; vc < input_credit_to_send_[i].size(); ++vc) {
-      input_credit_to_send_[i][vc] = 0;
-    }
-  }
+  absl::c_fill(input_credit_to_send_, 0);
 
   bool flit_sent = false;
   // This router supports bypass so a flit arriving at the
@@ -793,7 +1232,8 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
 
     if (input.forward_channels.flit.type != FlitType::kInvalid) {
       int64_t vc = input.forward_channels.flit.vc;
-      input_buffers_[i][vc].queue.push(
+      input_buffers_.push(
+          input_vc_start_[i] + vc,
           {input.forward_channels.flit, input.forward_channels.metadata});
 
       VLOG(2) << absl::StrFormat(
@@ -806,18 +1246,19 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
   // Use fixed priority to route to output ports.
   // Priority goes to the port with the least vc and the least port index.
   for (int64_t vc = 0; vc < max_vc_; ++vc) {
-    for (int64_t i = 0; i < input_buffers_.size(); ++i) {
-      if (vc >= input_buffers_[i].size()) {
+    for (int64_t i = 0; i < input_connection_count_; ++i) {
+      if (vc >= input_vc_start_[i + 1] - input_vc_start_[i]) {
         continue;
       }
+      int64_t input_index = input_vc_start_[i] + vc;
 
       // See if we have a flit to route and can route it.
-      if (input_buffers_[i][vc].queue.empty()) {
+      if (input_buffers_.empty(input_index)) {
         continue;
       }
 
-      DataFlit flit = input_buffers_[i][vc].queue.front().flit;
-      TimedDataFlitInfo metadata = input_buffers_[i][vc].queue.front().metadata;
+      const DataFlitQueueElement& element = input_buffers_.front(input_index);
+      const DataFlit& flit = element.flit;
       int64_t destination_index = flit.destination_index;
 
       PortIndexAndVCIndex input{i, vc};
@@ -828,12 +1269,13 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
       PortIndexAndVCIndex output = output_status.value();
 
       // Now see if we have sufficient credits.
-      if (credit_.at(output.port_index).at(output.vc_index) <= 0) {
+      int64_t output_index = output_vc_start_[output.port_index] +
+                             output.vc_index;
+      if (credit_[output_index] <= 0) {
         VLOG(2) << absl::StreamFormat(
             "... router unable to send data %s vc %d credit now %d"
             " from port index %d to port index %d.",
-            flit, flit.vc, credit_.at(output.port_index).at(output.vc_index), i,
-            output.port_index);
+            flit, flit.vc, credit_[output_index], i, output.port_index);
         continue;
       }
 
@@ -849,16 +1291,16 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
       output_state.forward_channels.flit = flit;
       output_state.forward_channels.flit.vc = output.vc_index;
       output_state.forward_channels.cycle = current_cycle;
-      output_state.forward_channels.metadata = metadata;
+      output_state.forward_channels.metadata = element.metadata;
       output_state.forward_channels.metadata.timed_route_info.route.push_back(
           TimedRouteItem{id_, current_cycle});
 
       // Update credit on output.
-      --credit_.at(output.port_index).at(output.vc_index);
+      --credit_[output_index];
 
       // Update credit to send back to input.
-      ++input_credit_to_send_[i][vc];
-      input_buffers_[i][vc].queue.pop();
+      ++input_credit_to_send_[input_index];
+      input_buffers_.pop(input_index);
 
       flit_sent = true;
 
@@ -866,8 +1308,7 @@ bool SimInputBufferedVCRouter::TryForwardPropagation(NocSimulator& simulator) {
           "... router sending data %s vc %d credit now %d"
           " from port index %d to port index %d on %x.",
           output_state.forward_channels.flit,
-          output_state.forward_channels.flit.vc,
-          credit_.at(output.port_index).at(output.vc_index), i,
+          output_state.forward_channels.flit.vc, credit_[output_index], i,
           output.port_index, output_state.id.AsUInt64());
     }
   }
@@ -914,12 +1355,13 @@ bool SimInputBufferedVCRouter::TryReversePropagation(NocSimulator& simulator) {
       input.reverse_channels[vc].flit.type = FlitType::kTail;
 
       // Upon reset (cycle-0) a full update of credits is sent.
+      int64_t input_index = input_vc_start_[i] + vc;
       if (current_cycle == 0) {
         input.reverse_channels[vc].flit.data =
-            UBits(input_buffers_[i][vc].max_queue_size, 32);
+            UBits(input_buffers_.capacity(input_index), 32);
       } else {
         input.reverse_channels[vc].flit.data =
-            UBits(input_credit_to_send_[i][vc], 32);
+            UBits(input_credit_to_send_[input_index], 32);
       }
       input.reverse_channels[vc].cycle = current_cycle;
 
@@ -938,28 +1380,30 @@ bool SimInputBufferedVCRouter::TryReversePropagation(NocSimulator& simulator) {
 
   int64_t num_propagated = 0;
   int64_t possible_propagation = 0;
-  for (int64_t i = 0; i < credit_update_.size(); ++i) {
+  for (int64_t i = 0; i < output_connection_count_; ++i) {
     SimConnectionState& output =
         simulator.GetSimConnectionByIndex(output_connection_index.at(i));
 
-    for (int64_t vc = 0; vc < credit_update_[i].size(); ++vc) {
-      TimedMetadataFlit possible_credit = output.reverse_channels[vc];
+    for (int64_t vc = 0; vc < output_vc_start_[i + 1] - output_vc_start_[i];
+         ++vc) {
+      const TimedMetadataFlit& possible_credit = output.reverse_channels[vc];
+      CreditState& credit_update = credit_update_[output_vc_start_[i] + vc];
 
       if (possible_credit.cycle == current_cycle) {
-        if (credit_update_[i][vc].cycle != current_cycle) {
-          credit_update_[i][vc].cycle = current_cycle;
+        if (credit_update.cycle != current_cycle) {
+          credit_update.cycle = current_cycle;
 
           if (possible_credit.flit.type != FlitType::kInvalid) {
             int64_t credit = possible_credit.flit.data.ToInt64().value();
-            credit_update_[i][vc].credit = credit;
+            credit_update.credit = credit;
           } else {
-            credit_update_[i][vc].credit = 0;
+            credit_update.credit = 0;
           }
 
           VLOG(2) << absl::StreamFormat(
               "... router received credit %d output port %d vc %d via "
               "connection %x",
-              credit_update_[i][vc].credit, i, vc, output.id.AsUInt64());
+              credit_update.credit, i, vc, output.id.AsUInt64());
         }
 
         ++num_propagated;
@@ -1000,7 +1444,7 @@ bool SimNetworkInterfaceSink::TryForwardPropagation(NocSimulator& simulator) {
 
     // TODO(tedhong): 2021-01-31 Support blocking traffic at sink.
     // without blocking, the queue never gets empty so we don't
-    // emplace into input_buffers_[vc].queue.
+    // buffer the flit.
     TimedDataFlit received_flit;
     received_flit.cycle = current_cycle;
     received_flit.flit = src.forward_channels.flit;
@@ -1025,12 +1469,11 @@ bool SimNetworkInterfaceSink::TryForwardPropagation(NocSimulator& simulator) {
     for (int64_t vc = 0; vc < src.reverse_channels.size(); ++vc) {
       src.reverse_channels[vc].cycle = current_cycle;
       src.reverse_channels[vc].flit.type = FlitType::kTail;
-      src.reverse_channels[vc].flit.data =
-          UBits(input_buffers_[vc].max_queue_size, 32);
+      src.reverse_channels[vc].flit.data = UBits(input_buffer_depths_[vc], 32);
 
       VLOG(2) << absl::StreamFormat(
           "... sink %x sending %d credit vc %d on %x", GetId().AsUInt64(),
-          input_buffers_[vc].max_queue_size, vc, src.id.AsUInt64());
+          input_buffer_depths_[vc], vc, src.id.AsUInt64());
     }
   } else {
     for (int64_t vc = 0; vc < src.reverse_channels.size(); ++vc) {
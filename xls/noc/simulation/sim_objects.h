@@ -16,10 +16,12 @@
 #define XLS_NOC_SIMULATION_SIM_OBJECTS_H_
 
 #include <cstdint>
+#include <memory>
 #include <queue>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
@@ -57,13 +59,81 @@ struct DataFlitQueueElement {
   TimedDataFlitInfo metadata;
 };
 
-// Represents a fifo/buffer used to store phits.
-struct DataFlitQueue {
-  std::queue<DataFlitQueueElement> queue;
-  int64_t max_queue_size;
-};
+// Represents fixed-capacity fifos/buffers (rings) of phits.
+//
+// All rings of a simulation object share a single buffer allocated as they
+// are added, with their state stored as arrays indexed by ring, so that
+// phits are pushed and popped without allocating or chasing pointers. Phits
+// are copied into their slot, reusing the storage of the phit which occupied
+// it previously.
+template <typename PhitT>
+class FlitRingPool {
+ public:
+  // Adds a ring which can store up to capacity phits, returns its index.
+  int64_t AddRing(int64_t capacity) {
+    int64_t ring = base_.size();
+    base_.push_back(slots_.size());
+    capacity_.push_back(capacity);
+    head_.push_back(0);
+    size_.push_back(0);
+    slots_.resize(slots_.size() + capacity);
+    return ring;
+  }
+
+  int64_t ring_count() const { return base_.size(); }
+  int64_t capacity(int64_t ring) const { return capacity_[ring]; }
+  int64_t size(int64_t ring) const { return size_[ring]; }
+  bool empty(int64_t ring) const { return size_[ring] == 0; }
 
-// Represents a fifo/buffer used to store metadata phits.
+  // Returns the oldest phit of a non-empty ring.
+  PhitT& front(int64_t ring) {
+    DCHECK_GT(size_[ring], 0);
+    return slots_[base_[ring] + head_[ring]];
+  }
+
+  // Returns the i-th oldest phit of a ring.
+  const PhitT& at(int64_t ring, int64_t i) const {
+    DCHECK_LT(i, size_[ring]);
+    int64_t slot = head_[ring] + i;
+    if (slot >= capacity_[ring]) {
+      slot -= capacity_[ring];
+    }
+    return slots_[base_[ring] + slot];
+  }
+
+  // Pushes a phit, the ring must not be full. Flow control guarantees that
+  // buffers never hold more phits than their depth.
+  void push(int64_t ring, const PhitT& phit) {
+    CHECK_LT(size_[ring], capacity_[ring])
+        << "Overflow of flit ring " << ring << " of capacity "
+        << capacity_[ring];
+    int64_t tail = head_[ring] + size_[ring];
+    if (tail >= capacity_[ring]) {
+      tail -= capacity_[ring];
+    }
+    slots_[base_[ring] + tail] = phit;
+    ++size_[ring];
+  }
+
+  // Pops the oldest phit of a non-empty ring.
+  void pop(int64_t ring) {
+    DCHECK_GT(size_[ring], 0);
+    if (++head_[ring] == capacity_[ring]) {
+      head_[ring] = 0;
+    }
+    --size_[ring];
+  }
+
+ private:
+  std::vector<PhitT> slots_;
+
+  // Per ring: offset of its first slot, capacity, offset of its oldest phit
+  // relative to its first slot, and number of phits.
+  std::vector<int64_t> base_;
+  std::vector<int64_t> capacity_;
+  std::vector<int64_t> head_;
+  std::vector<int64_t> size_;
+};
 
 class NocSimulator;
 
@@ -84,6 +154,11 @@ class SimNetworkComponentBase {
   // Returns the associated NetworkComponentId.
   NetworkComponentId GetId() const { return id_; }
 
+  // Returns true if the component holds neither flits nor credits. An idle
+  // component only sends invalid flits and its state does not change until
+  // traffic is injected into the network.
+  virtual bool IsIdle() const { return true; }
+
   virtual ~SimNetworkComponentBase() = default;
 
  protected:
@@ -155,6 +230,10 @@ class SimLink : public SimNetworkComponentBase {
 
   // Get the sink connection index that in used in the simulator.
 
+  // The pipeline stages of an idle link are full of invalid phits and empty
+  // credit updates.
+  bool IsIdle() const override;
+
  private:
   SimLink() = default;
 
@@ -172,10 +251,12 @@ class SimLink : public SimNetworkComponentBase {
   int64_t src_connection_index_;
   int64_t sink_connection_index_;
 
-  std::queue<TimedDataFlit> forward_data_stages_;
+  // A single ring holding the phits in the forward pipeline stages.
+  FlitRingPool<TimedDataFlit> forward_data_stages_;
   int64_t internal_forward_propagated_cycle_;
 
-  std::vector<std::queue<TimedMetadataFlit>> reverse_credit_stages_;
+  // A ring per vc holding the credits in the reverse pipeline stages.
+  FlitRingPool<TimedMetadataFlit> reverse_credit_stages_;
   std::vector<int64_t> internal_reverse_propagated_cycle_;
 };
 
@@ -192,6 +273,8 @@ class SimNetworkInterfaceSrc : public SimNetworkComponentBase {
   // Register a flit to be sent at a specific time.
   absl::Status SendFlitAtTime(TimedDataFlit flit);
 
+  bool IsIdle() const override;
+
  private:
   SimNetworkInterfaceSrc() = default;
 
@@ -258,7 +341,11 @@ class SimNetworkInterfaceSink : public SimNetworkComponentBase {
   bool TryForwardPropagation(NocSimulator& simulator) override;
 
   int64_t src_connection_index_;
-  std::vector<DataFlitQueue> input_buffers_;
+
+  // Depth of the buffer of each vc.
+  // TODO(tedhong): 2021-01-31 Support blocking traffic at sink, which will
+  //                need the buffers themselves.
+  std::vector<int64_t> input_buffer_depths_;
   std::vector<TimedDataFlit> received_traffic_;
 };
 
@@ -295,6 +382,8 @@ class SimInputBufferedVCRouter : public SimNetworkComponentBase {
 
   int64_t GetUtilizationCycleCount() const;
 
+  bool IsIdle() const override;
+
  private:
   SimInputBufferedVCRouter() = default;
 
@@ -340,34 +429,53 @@ class SimInputBufferedVCRouter : public SimNetworkComponentBase {
   // updated its credit count from the updates received in the previous cycle.
   int64_t internal_propagated_cycle_;
 
-  // Stores the input buffers associated with each input port and vc.
-  std::vector<std::vector<DataFlitQueue>> input_buffers_;
+  // The state of each port and vc is stored in flat arrays, in which the
+  // state of vc v of port i is at index vc_start[i] + v. The last element of
+  // the vc_start arrays is the total number of vcs.
+  std::vector<int64_t> input_vc_start_;
+  std::vector<int64_t> output_vc_start_;
+
+  // Stores the input buffers associated with each input port and vc, one
+  // ring per input vc sized by the depth of the vc.
+  FlitRingPool<DataFlitQueueElement> input_buffers_;
 
   // Stores the credit count associated with each output port and vc.
   // Each cycle, the router updates its credit count from credit_update_.
-  std::vector<std::vector<int64_t>> credit_;
+  std::vector<int64_t> credit_;
 
-  // Stores the credit count received on cycle N-1.
-  std::vector<std::vector<CreditState>> credit_update_;
+  // Stores the credit count received on cycle N-1, for each output port and
+  // vc.
+  std::vector<CreditState> credit_update_;
 
   // The maximum number of vcs on for an input port.
   // Used for the priority scheme implementation.
   int64_t max_vc_;
 
   // Used by forward propagation to store the number of phits that left
-  // the input buffers and hence credits that can be sent back upstream.
-  std::vector<std::vector<int64_t>> input_credit_to_send_;
+  // the input buffers and hence credits that can be sent back upstream, for
+  // each input port and vc.
+  std::vector<int64_t> input_credit_to_send_;
 
   // The number of cycles that a transfer from input to output occurred.
   int64_t utilization_cycle_count_;
 };
 
+// Threads and partitions of a NocSimulator running in parallel mode.
+// Defined in sim_objects.cc.
+class NocParallelSimulation;
+
 // Main simulator class that drives the simulation and stores simulation
 // state and objects.
 class NocSimulator {
  public:
   NocSimulator()
-      : mgr_(nullptr), params_(nullptr), routing_(nullptr), cycle_(-1) {}
+      : mgr_(nullptr),
+        params_(nullptr),
+        routing_(nullptr),
+        cycle_(-1),
+        event_driven_(false),
+        skipped_cycle_count_(0) {}
+  ~NocSimulator();
 
   // Creates all simulation objects for a given network.
   // NetworkManager, NocParameters, and DistributedRoutingTable should
@@ -379,6 +487,7 @@ class NocSimulator {
     routing_ = &routing;
     network_ = network;
     cycle_ = -1;
+    skipped_cycle_count_ = 0;
 
     return CreateSimulationObjects(network);
   }
@@ -434,8 +543,56 @@ class NocSimulator {
   void Dump();
 
   // Run a single cycle of the simulator.
+  //
+  // In parallel mode (see EnableParallelSimulation), max_ticks bounds the
+  // number of ticks of each partition.
   absl::Status RunCycle(int64_t max_ticks = 9999);
 
+  // Runs cycle_count cycles of the simulator.
+  //
+  // In event-driven mode (see SetEventDriven), cycles in which nothing
+  // happens are skipped.
+  absl::Status RunCycles(int64_t cycle_count, int64_t max_ticks = 9999);
+
+  // Enables or disables the event-driven mode of RunCycles.
+  //
+  // At low injection rates, the network is mostly idle: no component holds
+  // flits or credits, and each cycle only moves invalid flits around. Once
+  // the network is idle, the services are asked for the next cycle they act
+  // on it (see NocSimulatorServiceShim::GetNextEventCycle), and all cycles
+  // until then are skipped at once rather than simulated. Idle cycles do not
+  // change the state of the components, so results are identical to those of
+  // simulating each cycle. Services which don't support skipping cycles keep
+  // every cycle simulated.
+  void SetEventDriven(bool event_driven) { event_driven_ = event_driven; }
+  bool IsEventDriven() const { return event_driven_; }
+
+  // Returns the number of cycles skipped by the event-driven mode.
+  int64_t GetSkippedCycleCount() const { return skipped_cycle_count_; }
+
+  // Switches the simulator to simulating each cycle with up to
+  // partition_count threads. Must be called after Initialize and before the
+  // first cycle is run.
+  //
+  // Links with pipeline stages in both directions are at least one cycle of
+  // lookahead: their outputs for a cycle only depend on the state at the end
+  // of the previous one. The network is cut at such links into partitions of
+  // neighboring components, each of which runs its ticks to convergence on
+  // its own thread. Every cycle, the cut links first drive their outputs,
+  // then the partitions converge in parallel, and finally the cut links
+  // consume their inputs, with the threads synchronized in between. Since
+  // components only propagate once their inputs for the cycle are ready,
+  // cycle-level results are identical to those of the serial simulator.
+  //
+  // Services still run serially at the beginning and the end of each cycle.
+  // If the network can't be cut into several partitions, it keeps being
+  // simulated serially.
+  absl::Status EnableParallelSimulation(int64_t partition_count);
+
+  // Returns the number of partitions simulated in parallel, 1 when the
+  // simulation is serial.
+  int64_t GetPartitionCount() const;
+
   // Runs a single tick of the simulator.
   bool Tick();
 
@@ -474,6 +631,11 @@ class NocSimulator {
   absl::Status CreateLink(NetworkComponentId nc_id);
   absl::Status CreateRouter(NetworkComponentId nc_id);
 
+  // Returns true if the network is idle after the current cycle: cycle 0,
+  // in which credits are initialized, has been simulated and all components
+  // are idle.
+  bool IsIdle() const;
+
   NetworkManager* mgr_;
   NocParameters* params_;
   DistributedRoutingTable* routing_;
@@ -481,6 +643,9 @@ class NocSimulator {
   NetworkId network_;
   int64_t cycle_;
 
+  bool event_driven_;
+  int64_t skipped_cycle_count_;
+
   // Map a specific ConnectionId to an index used to access
   // a specific SimConnectionState via the connections_ object.
   absl::flat_hash_map<ConnectionId, int64_t> connection_index_map_;
@@ -515,6 +680,9 @@ class NocSimulator {
 
   // Shims to services to run at the end of each cycle.
   std::vector<NocSimulatorServiceShim*> post_cycle_services_;
+
+  // Set by EnableParallelSimulation if the network was partitioned.
+  std::unique_ptr<NocParallelSimulation> parallel_;
 };
 
 }  // namespace noc
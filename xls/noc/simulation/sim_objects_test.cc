@@ -302,6 +302,33 @@ TEST(SimObjectsTest, TreeNetwork0) {
       38146);
 }
 
+TEST(SimObjectsTest, FlitRingPool) {
+  FlitRingPool<int64_t> pool;
+  EXPECT_EQ(pool.AddRing(3), 0);
+  EXPECT_EQ(pool.AddRing(2), 1);
+  EXPECT_EQ(pool.ring_count(), 2);
+  EXPECT_EQ(pool.capacity(0), 3);
+  EXPECT_EQ(pool.capacity(1), 2);
+
+  // Wrap around ring 0 while ring 1 holds its own elements.
+  pool.push(1, 100);
+  for (int64_t i = 0; i < 10; ++i) {
+    pool.push(0, i);
+    pool.push(0, i + 10);
+    EXPECT_EQ(pool.size(0), 2);
+    EXPECT_EQ(pool.front(0), i);
+    pool.pop(0);
+    EXPECT_EQ(pool.front(0), i + 10);
+    pool.pop(0);
+    EXPECT_TRUE(pool.empty(0));
+  }
+  EXPECT_EQ(pool.size(1), 1);
+  EXPECT_EQ(pool.front(1), 100);
+
+  pool.push(1, 101);
+  EXPECT_DEATH(pool.push(1, 102), "Overflow of flit ring 1");
+}
+
 }  // namespace
 }  // namespace noc
 }  // namespace xls
@@ -13,13 +13,21 @@
 // limitations under the License.
 
 #include <cstdint>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/noc/config/network_config.pb.h"
 #include "xls/noc/simulation/common.h"
+#include "xls/noc/simulation/flit.h"
 #include "xls/noc/simulation/global_routing_table.h"
 #include "xls/noc/simulation/network_graph.h"
 #include "xls/noc/simulation/network_graph_builder.h"
@@ -35,6 +43,8 @@
 namespace xls::noc {
 namespace {
 
+using ::absl_testing::StatusIs;
+
 TEST(SimTrafficTest, BackToBackNetwork0) {
   // Construct traffic flows
   NocTrafficManager traffic_mgr;
@@ -387,5 +397,257 @@ TEST(SimTrafficTest, NetworkWithMultiplePathsAndReplay) {
   EXPECT_EQ(simulator.GetRouters()[1].GetUtilizationCycleCount(), 10);
 }
 
+// Flits received at each sink of Linear001 with random traffic between both
+// pairs of ports, simulated with the given number of partitions, and
+// optionally in event-driven mode. The traffic rates are divided by
+// rate_divisor.
+absl::StatusOr<std::vector<std::vector<TimedDataFlit>>> SimulateLinear001(
+    int64_t partition_count, int64_t cycle_count, bool event_driven = false,
+    int64_t rate_divisor = 1) {
+  NocTrafficManager traffic_mgr;
+  XLS_ASSIGN_OR_RETURN(TrafficFlowId flow0_id,
+                       traffic_mgr.CreateTrafficFlow());
+  traffic_mgr.GetTrafficFlow(flow0_id)
+      .SetName("flow0")
+      .SetSource("SendPort0")
+      .SetDestination("RecvPort0")
+      .SetVC("VC0")
+      .SetTrafficRateInMiBps(3 * 1024 / rate_divisor)
+      .SetPacketSizeInBits(128)
+      .SetBurstProbInMils(7);
+  XLS_ASSIGN_OR_RETURN(TrafficFlowId flow1_id,
+                       traffic_mgr.CreateTrafficFlow());
+  traffic_mgr.GetTrafficFlow(flow1_id)
+      .SetName("flow1")
+      .SetSource("SendPort1")
+      .SetDestination("RecvPort1")
+      .SetVC("VC0")
+      .SetTrafficRateInMiBps(2 * 1024 / rate_divisor)
+      .SetPacketSizeInBits(128)
+      .SetBurstProbInMils(7);
+  XLS_ASSIGN_OR_RETURN(TrafficModeId mode0_id, traffic_mgr.CreateTrafficMode());
+  traffic_mgr.GetTrafficMode(mode0_id)
+      .SetName("Mode 0")
+      .RegisterTrafficFlow(flow0_id)
+      .RegisterTrafficFlow(flow1_id);
+
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_RETURN_IF_ERROR(BuildNetworkGraphLinear001(&proto, &graph, &params));
+
+  DistributedRoutingTableBuilderForMultiplePaths route_builder;
+  XLS_ASSIGN_OR_RETURN(DistributedRoutingTable routing_table,
+                       route_builder.BuildNetworkRoutingTables(
+                           graph.GetNetworkIds()[0], graph, params));
+
+  RandomNumberInterface rnd;
+  int64_t cycle_time_in_ps = 400;
+  rnd.SetSeed(1000);
+  XLS_ASSIGN_OR_RETURN(
+      NocTrafficInjector traffic_injector,
+      NocTrafficInjectorBuilder().Build(
+          cycle_time_in_ps, mode0_id,
+          routing_table.GetSourceIndices().GetNetworkComponents(),
+          routing_table.GetSinkIndices().GetNetworkComponents(),
+          params.GetNetworkParam(graph.GetNetworkIds()[0])
+              ->GetVirtualChannels(),
+          traffic_mgr, graph, params, rnd));
+
+  NocSimulator simulator;
+  XLS_RETURN_IF_ERROR(simulator.Initialize(graph, params, routing_table,
+                                           graph.GetNetworkIds()[0]));
+  XLS_RETURN_IF_ERROR(simulator.EnableParallelSimulation(partition_count));
+  simulator.SetEventDriven(event_driven);
+
+  NocSimulatorToNocTrafficInjectorShim injector_shim(simulator,
+                                                     traffic_injector);
+  traffic_injector.SetSimulatorShim(injector_shim);
+  simulator.RegisterPreCycleService(injector_shim);
+
+  XLS_RETURN_IF_ERROR(simulator.RunCycles(cycle_count));
+  XLS_RET_CHECK_EQ(simulator.GetCurrentCycle(), cycle_count - 1);
+  XLS_RET_CHECK_EQ(simulator.GetSkippedCycleCount() > 0, event_driven);
+
+  std::vector<std::vector<TimedDataFlit>> received;
+  for (const char* name : {"RecvPort0", "RecvPort1"}) {
+    XLS_ASSIGN_OR_RETURN(NetworkComponentId recv_port,
+                         FindNetworkComponentByName(name, graph, params));
+    XLS_ASSIGN_OR_RETURN(SimNetworkInterfaceSink * sim_recv_port,
+                         simulator.GetSimNetworkInterfaceSink(recv_port));
+    absl::Span<const TimedDataFlit> traffic =
+        sim_recv_port->GetReceivedTraffic();
+    received.emplace_back(traffic.begin(), traffic.end());
+  }
+  return received;
+}
+
+TEST(SimTrafficTest, ParallelSimulationMatchesSerial) {
+  constexpr int64_t kCycleCount = 20'000;
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<std::vector<TimedDataFlit>> serial,
+                           SimulateLinear001(1, kCycleCount));
+  ASSERT_EQ(serial.size(), 2);
+  EXPECT_GT(serial[0].size(), 0);
+  EXPECT_GT(serial[1].size(), 0);
+
+  for (int64_t partition_count : {2, 3, 64}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::vector<std::vector<TimedDataFlit>> parallel,
+        SimulateLinear001(partition_count, kCycleCount));
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (int64_t sink = 0; sink < serial.size(); ++sink) {
+      ASSERT_EQ(parallel[sink].size(), serial[sink].size())
+          << "partition_count = " << partition_count << ", sink " << sink;
+      for (int64_t i = 0; i < serial[sink].size(); ++i) {
+        const TimedDataFlit& expected = serial[sink][i];
+        const TimedDataFlit& actual = parallel[sink][i];
+        EXPECT_EQ(actual.cycle, expected.cycle);
+        EXPECT_EQ(actual.flit.source_index, expected.flit.source_index);
+        EXPECT_EQ(actual.flit.vc, expected.flit.vc);
+        EXPECT_EQ(actual.flit.data, expected.flit.data);
+        EXPECT_EQ(actual.metadata.injection_cycle_time,
+                  expected.metadata.injection_cycle_time);
+        EXPECT_EQ(actual.metadata.timed_route_info,
+                  expected.metadata.timed_route_info);
+      }
+    }
+  }
+}
+
+TEST(SimTrafficTest, EventDrivenSimulationMatchesCycleByCycle) {
+  constexpr int64_t kCycleCount = 50'000;
+  constexpr int64_t kRateDivisor = 64;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::vector<TimedDataFlit>> expected_traffic,
+      SimulateLinear001(1, kCycleCount, /*event_driven=*/false, kRateDivisor));
+  ASSERT_EQ(expected_traffic.size(), 2);
+  EXPECT_GT(expected_traffic[0].size(), 0);
+  EXPECT_GT(expected_traffic[1].size(), 0);
+
+  for (int64_t partition_count : {1, 3}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::vector<std::vector<TimedDataFlit>> traffic,
+        SimulateLinear001(partition_count, kCycleCount, /*event_driven=*/true,
+                          kRateDivisor));
+    ASSERT_EQ(traffic.size(), expected_traffic.size());
+    for (int64_t sink = 0; sink < traffic.size(); ++sink) {
+      ASSERT_EQ(traffic[sink].size(), expected_traffic[sink].size())
+          << "partition_count = " << partition_count << ", sink " << sink;
+      for (int64_t i = 0; i < traffic[sink].size(); ++i) {
+        const TimedDataFlit& expected = expected_traffic[sink][i];
+        const TimedDataFlit& actual = traffic[sink][i];
+        EXPECT_EQ(actual.cycle, expected.cycle);
+        EXPECT_EQ(actual.flit.source_index, expected.flit.source_index);
+        EXPECT_EQ(actual.flit.vc, expected.flit.vc);
+        EXPECT_EQ(actual.metadata.injection_cycle_time,
+                  expected.metadata.injection_cycle_time);
+        EXPECT_EQ(actual.metadata.timed_route_info,
+                  expected.metadata.timed_route_info);
+      }
+    }
+  }
+}
+
+TEST(SimTrafficTest, EventDrivenSimulationSkipsIdleCycles) {
+  NocTrafficManager traffic_mgr;
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficFlowId flow0_id,
+                           traffic_mgr.CreateTrafficFlow());
+  traffic_mgr.GetTrafficFlow(flow0_id)
+      .SetName("flow0")
+      .SetSource("SendPort0")
+      .SetDestination("RecvPort0")
+      .SetVC("VC0")
+      .SetPacketSizeInBits(128)
+      .SetClockCycleTimes({0, 1000, 1001, 50'000});
+  XLS_ASSERT_OK_AND_ASSIGN(TrafficModeId mode0_id,
+                           traffic_mgr.CreateTrafficMode());
+  traffic_mgr.GetTrafficMode(mode0_id).SetName("Mode 0").RegisterTrafficFlow(
+      flow0_id);
+
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_ASSERT_OK(BuildNetworkGraphLinear001(&proto, &graph, &params));
+  DistributedRoutingTableBuilderForMultiplePaths route_builder;
+  XLS_ASSERT_OK_AND_ASSIGN(DistributedRoutingTable routing_table,
+                           route_builder.BuildNetworkRoutingTables(
+                               graph.GetNetworkIds()[0], graph, params));
+
+  RandomNumberInterface rnd;
+  int64_t cycle_time_in_ps = 400;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      NocTrafficInjector traffic_injector,
+      NocTrafficInjectorBuilder().Build(
+          cycle_time_in_ps, mode0_id,
+          routing_table.GetSourceIndices().GetNetworkComponents(),
+          routing_table.GetSinkIndices().GetNetworkComponents(),
+          params.GetNetworkParam(graph.GetNetworkIds()[0])
+              ->GetVirtualChannels(),
+          traffic_mgr, graph, params, rnd));
+
+  NocSimulator simulator;
+  XLS_ASSERT_OK(simulator.Initialize(graph, params, routing_table,
+                                     graph.GetNetworkIds()[0]));
+  simulator.SetEventDriven(true);
+
+  NocSimulatorToNocTrafficInjectorShim injector_shim(simulator,
+                                                     traffic_injector);
+  traffic_injector.SetSimulatorShim(injector_shim);
+  simulator.RegisterPreCycleService(injector_shim);
+  NocSimulatorToLinkMonitorServiceShim link_monitor(simulator);
+  simulator.RegisterPostCycleService(link_monitor);
+
+  XLS_ASSERT_OK(simulator.RunCycles(100'000));
+  EXPECT_EQ(simulator.GetCurrentCycle(), 99'999);
+  // Only the cycles around the injections are simulated.
+  EXPECT_GT(simulator.GetSkippedCycleCount(), 99'000);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      NetworkComponentId recv_port,
+      FindNetworkComponentByName("RecvPort0", graph, params));
+  XLS_ASSERT_OK_AND_ASSIGN(SimNetworkInterfaceSink * sim_recv_port,
+                           simulator.GetSimNetworkInterfaceSink(recv_port));
+  absl::Span<const TimedDataFlit> traffic = sim_recv_port->GetReceivedTraffic();
+  ASSERT_EQ(traffic.size(), 4);
+  EXPECT_EQ(traffic[0].metadata.injection_cycle_time, 0);
+  EXPECT_EQ(traffic[1].metadata.injection_cycle_time, 1000);
+  EXPECT_EQ(traffic[2].metadata.injection_cycle_time, 1001);
+  EXPECT_EQ(traffic[3].metadata.injection_cycle_time, 50'000);
+  // Packets injected into an idle network have the same latency.
+  EXPECT_EQ(traffic[3].cycle - 50'000, traffic[1].cycle - 1000);
+
+  // Each link along the path saw all four packets.
+  EXPECT_FALSE(link_monitor.GetLinkToPacketCountMap().empty());
+  for (const auto& [link, packet_counts] :
+       link_monitor.GetLinkToPacketCountMap()) {
+    for (const auto& [destination, packet_count] : packet_counts) {
+      EXPECT_EQ(packet_count, 4);
+    }
+  }
+}
+
+TEST(SimTrafficTest, ParallelSimulationPartitionsAtPipelinedLinks) {
+  NetworkConfigProto proto;
+  NetworkManager graph;
+  NocParameters params;
+  XLS_ASSERT_OK(BuildNetworkGraphLinear001(&proto, &graph, &params));
+  DistributedRoutingTableBuilderForMultiplePaths route_builder;
+  XLS_ASSERT_OK_AND_ASSIGN(DistributedRoutingTable routing_table,
+                           route_builder.BuildNetworkRoutingTables(
+                               graph.GetNetworkIds()[0], graph, params));
+
+  NocSimulator simulator;
+  XLS_ASSERT_OK(simulator.Initialize(graph, params, routing_table,
+                                     graph.GetNetworkIds()[0]));
+  EXPECT_EQ(simulator.GetPartitionCount(), 1);
+
+  // Every link has pipeline stages in both directions, so each of the two
+  // routers and four network interfaces can be in a partition of its own.
+  XLS_ASSERT_OK(simulator.EnableParallelSimulation(64));
+  EXPECT_EQ(simulator.GetPartitionCount(), 6);
+  EXPECT_THAT(simulator.EnableParallelSimulation(2),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
 }  // namespace
 }  // namespace xls::noc
@@ -15,6 +15,8 @@
 #ifndef XLS_NOC_SIMULATION_SIMULATOR_SHIMS_H_
 #define XLS_NOC_SIMULATION_SIMULATOR_SHIMS_H_
 
+#include <cstdint>
+
 #include "absl/status/status.h"
 #include "xls/noc/simulation/common.h"
 #include "xls/noc/simulation/flit.h"
@@ -29,6 +31,21 @@ namespace xls::noc {
 class NocSimulatorServiceShim {
  public:
   virtual absl::Status RunCycle() = 0;
+
+  // Used by the event-driven mode of the simulator (see
+  // NocSimulator::SetEventDriven).
+  //
+  // Returns the next cycle, after the given cycle which was the last one
+  // simulated, in which the service acts on an idle network. By default,
+  // services act on every cycle, which prevents skipping any.
+  virtual int64_t GetNextEventCycle(int64_t cycle) { return cycle + 1; }
+
+  // Called in place of cycle_count calls of RunCycle() for cycles skipped
+  // while the network is idle, all of which precede GetNextEventCycle().
+  virtual absl::Status SkipCycles(int64_t cycle_count) {
+    return absl::UnimplementedError("Service does not support skipping cycles");
+  }
+
   virtual ~NocSimulatorServiceShim() = default;
 };
 
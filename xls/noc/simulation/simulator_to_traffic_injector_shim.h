@@ -15,6 +15,8 @@
 #ifndef XLS_NOC_SIMULATION_SIMULATOR_TO_TRAFFIC_INJECTOR_SHIM_H_
 #define XLS_NOC_SIMULATION_SIMULATOR_TO_TRAFFIC_INJECTOR_SHIM_H_
 
+#include <cstdint>
+
 #include "absl/status/status.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/noc/simulation/common.h"
@@ -36,6 +38,16 @@ class NocSimulatorToNocTrafficInjectorShim
   // Called by the simulator each cycle to request for traffic.
   absl::Status RunCycle() override { return traffic_injector_->RunCycle(); }
 
+  // Called by the simulator in event-driven mode to skip idle cycles until
+  // the next injection.
+  int64_t GetNextEventCycle(int64_t cycle) override {
+    return traffic_injector_->GetNextInjectionCycle();
+  }
+
+  absl::Status SkipCycles(int64_t cycle_count) override {
+    return traffic_injector_->SkipCycles(cycle_count);
+  }
+
   // Called by the traffic injector to inject traffic.
   absl::Status SendFlitAtTime(TimedDataFlit flit,
                               NetworkComponentId source) override {
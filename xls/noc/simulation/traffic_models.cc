@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -152,6 +153,13 @@ std::vector<DataPacket> ReplayTrafficModel::GetNewCyclePackets(int64_t cycle) {
   return packets;
 }
 
+int64_t ReplayTrafficModel::GetNextPacketCycle() const {
+  if (clock_cycle_iter_ == clock_cycles_.end()) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return *clock_cycle_iter_;
+}
+
 double ReplayTrafficModel::ExpectedTrafficRateInMiBps(
     int64_t cycle_time_ps) const {
   double total_sec = static_cast<double>(cycle_count_ + 1) *
@@ -41,10 +41,14 @@ class TrafficModel {
   //       a call to GetNewCyclePackets(N) should not be called multiple times.
   // Note: The simulator will successively call GetNewCyclePackets(0),
   //       GetNewCyclePackets(1), GetNewCyclePackets(2), ...
-  //
-  // TODO(tedhong): 2021-06-27 Add an interface to support fast-forwarding.
+  //       except for cycles before GetNextPacketCycle(), which may be
+  //       skipped.
   virtual std::vector<DataPacket> GetNewCyclePackets(int64_t cycle) = 0;
 
+  // Returns the next cycle in which GetNewCyclePackets() may return packets,
+  // or std::numeric_limits<int64_t>::max() if it never will.
+  virtual int64_t GetNextPacketCycle() const = 0;
+
   // Returns expected rate of traffic injected in MebiBytes Per Sec.
   virtual double ExpectedTrafficRateInMiBps(int64_t cycle_time_ps) const = 0;
 
@@ -140,6 +144,11 @@ class GeneralizedGeometricTrafficModel : public TrafficModel {
 
   std::vector<DataPacket> GetNewCyclePackets(int64_t cycle) override;
 
+  int64_t GetNextPacketCycle() const override {
+    // Packets can be sent on cycle 0 due to a burst.
+    return next_packet_cycle_ == -1 ? 0 : next_packet_cycle_;
+  }
+
   double ExpectedTrafficRateInMiBps(int64_t cycle_time_ps) const override {
     double num_cycles = 1.0e12 / static_cast<double>(cycle_time_ps);
     double num_packets = lambda_ * num_cycles;
@@ -202,6 +211,8 @@ class ReplayTrafficModel : public TrafficModel {
 
   std::vector<DataPacket> GetNewCyclePackets(int64_t cycle) override;
 
+  int64_t GetNextPacketCycle() const override;
+
   double ExpectedTrafficRateInMiBps(int64_t cycle_time_ps) const override;
 
   // Sets clock cycles to list and sorts the complete list of clock cycle.
@@ -0,0 +1,64 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/analysis_manager.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+
+AnalysisManager::Analyses& AnalysisManager::GetAnalyses(FunctionBase* f) {
+  absl::MutexLock lock(&mutex_);
+  std::unique_ptr<Analyses>& analyses = analyses_[f];
+  if (analyses == nullptr || analyses->function_uid != f->uid()) {
+    analyses = std::make_unique<Analyses>(Analyses{.function_uid = f->uid()});
+  }
+  return *analyses;
+}
+
+absl::StatusOr<TernaryQueryEngine*> AnalysisManager::GetTernaryQueryEngine(
+    FunctionBase* f) {
+  Analyses& analyses = GetAnalyses(f);
+  if (analyses.ternary == nullptr) {
+    auto engine = std::make_unique<TernaryQueryEngine>();
+    XLS_RETURN_IF_ERROR(engine->Populate(f).status());
+    analyses.ternary = std::move(engine);
+  } else {
+    XLS_RETURN_IF_ERROR(analyses.ternary->Update(f).status());
+  }
+  return analyses.ternary.get();
+}
+
+absl::StatusOr<RangeQueryEngine*> AnalysisManager::GetRangeQueryEngine(
+    FunctionBase* f) {
+  Analyses& analyses = GetAnalyses(f);
+  if (analyses.range == nullptr) {
+    auto engine = std::make_unique<RangeQueryEngine>();
+    XLS_RETURN_IF_ERROR(engine->Populate(f).status());
+    analyses.range = std::move(engine);
+  } else {
+    XLS_RETURN_IF_ERROR(analyses.range->Update(f).status());
+  }
+  return analyses.range.get();
+}
+
+}  // namespace xls
@@ -0,0 +1,85 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_ANALYSIS_MANAGER_H_
+#define XLS_PASSES_ANALYSIS_MANAGER_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+
+// A cache of analyses shared by the passes of a pipeline. Many passes build
+// the same query engines for a function base, often right after the previous
+// pass built them for the unchanged function. Passes which get their engines
+// from the analysis manager instead share them.
+//
+// Engines are computed lazily the first time they are requested for a
+// function base. Later requests bring the cached engine up to date with any
+// changes made to the function base in the meantime (see
+// FunctionBase::NewChangeEpoch) before returning it, so the returned engine
+// describes the function base at the time of the request. As with an engine
+// built by the pass itself, it is not updated as the pass makes changes.
+//
+// The returned engines are owned by the analysis manager and must not be
+// populated by the caller. They remain valid until the next request for the
+// same function base or until Clear() is called.
+//
+// Engines for different function bases may be requested concurrently.
+class AnalysisManager {
+ public:
+  AnalysisManager() = default;
+  AnalysisManager(const AnalysisManager&) = delete;
+  AnalysisManager& operator=(const AnalysisManager&) = delete;
+
+  absl::StatusOr<TernaryQueryEngine*> GetTernaryQueryEngine(FunctionBase* f);
+  absl::StatusOr<RangeQueryEngine*> GetRangeQueryEngine(FunctionBase* f);
+
+  // Drops all cached analyses.
+  void Clear() {
+    absl::MutexLock lock(&mutex_);
+    analyses_.clear();
+  }
+
+ private:
+  struct Analyses {
+    // FunctionBase::uid of the function base the analyses are for. Function
+    // bases may be destroyed and their address reused at any time.
+    int64_t function_uid;
+    std::unique_ptr<TernaryQueryEngine> ternary;
+    std::unique_ptr<RangeQueryEngine> range;
+  };
+
+  // Returns the cached analyses for `f`, discarding any left over from a
+  // destroyed function base at the same address.
+  Analyses& GetAnalyses(FunctionBase* f);
+
+  absl::Mutex mutex_;
+  // Held by pointer so the analyses of one function base stay put while those
+  // of another are added.
+  absl::flat_hash_map<FunctionBase*, std::unique_ptr<Analyses>> analyses_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_ANALYSIS_MANAGER_H_
@@ -0,0 +1,96 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/analysis_manager.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/value.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+namespace {
+
+class AnalysisManagerTest : public IrTestBase {};
+
+TEST_F(AnalysisManagerTest, EnginesAreSharedAndUpdated) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue mask = fb.Literal(UBits(0x0f, 8));
+  BValue masked = fb.And(x, mask);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  AnalysisManager analyses;
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * ternary,
+                           analyses.GetTernaryQueryEngine(f));
+  XLS_ASSERT_OK_AND_ASSIGN(RangeQueryEngine * range,
+                           analyses.GetRangeQueryEngine(f));
+  EXPECT_EQ(ternary->ToString(masked.node()), "0b0000_XXXX");
+  EXPECT_EQ(range->MaxUnsignedValue(masked.node()), UBits(15, 8));
+
+  // The same engines are handed out again...
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * ternary_again,
+                           analyses.GetTernaryQueryEngine(f));
+  XLS_ASSERT_OK_AND_ASSIGN(RangeQueryEngine * range_again,
+                           analyses.GetRangeQueryEngine(f));
+  EXPECT_EQ(ternary_again, ternary);
+  EXPECT_EQ(range_again, range);
+
+  // ...and reflect changes made to the function in the meantime.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * narrower_mask,
+      f->MakeNode<Literal>(SourceInfo(), Value(UBits(0x03, 8))));
+  ASSERT_TRUE(masked.node()->ReplaceOperand(mask.node(), narrower_mask));
+  XLS_ASSERT_OK(f->RemoveNode(mask.node()));
+  XLS_ASSERT_OK_AND_ASSIGN(ternary, analyses.GetTernaryQueryEngine(f));
+  XLS_ASSERT_OK_AND_ASSIGN(range, analyses.GetRangeQueryEngine(f));
+  EXPECT_EQ(ternary->ToString(masked.node()), "0b0000_00XX");
+  EXPECT_EQ(range->MaxUnsignedValue(masked.node()), UBits(3, 8));
+}
+
+TEST_F(AnalysisManagerTest, FunctionsAreAnalyzedSeparately) {
+  auto p = CreatePackage();
+  FunctionBuilder fb1("f1", p.get());
+  BValue x1 = fb1.Param("x", p->GetBitsType(8));
+  BValue and1 = fb1.And(x1, fb1.Literal(UBits(0x01, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f1, fb1.Build());
+  FunctionBuilder fb2("f2", p.get());
+  BValue x2 = fb2.Param("x", p->GetBitsType(8));
+  BValue and2 = fb2.And(x2, fb2.Literal(UBits(0x80, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f2, fb2.Build());
+
+  AnalysisManager analyses;
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * ternary1,
+                           analyses.GetTernaryQueryEngine(f1));
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * ternary2,
+                           analyses.GetTernaryQueryEngine(f2));
+  EXPECT_NE(ternary1, ternary2);
+  EXPECT_EQ(ternary1->ToString(and1.node()), "0b0000_000X");
+  EXPECT_EQ(ternary2->ToString(and2.node()), "0bX000_0000");
+  EXPECT_NE(f1->uid(), f2->uid());
+}
+
+}  // namespace
+}  // namespace xls
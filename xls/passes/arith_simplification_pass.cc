@@ -24,6 +24,7 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
@@ -35,6 +36,7 @@
 #include "xls/ir/big_int.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/nodes.h"
@@ -1524,6 +1526,35 @@ absl::StatusOr<bool> MatchArithPatterns(int64_t opt_level, Node* n,
   return false;
 }
 
+// The patterns above inspect nodes at most this many edges (in either
+// direction) away from the node being matched.
+constexpr int64_t kPatternRadius = 2;
+
+// Returns the nodes within kPatternRadius edges of a node changed in `epoch`
+// or later. These are the only nodes whose matches can have been affected by
+// the changes.
+absl::flat_hash_set<Node*> DirtyRegion(FunctionBase* f, int64_t epoch) {
+  std::vector<Node*> frontier = f->NodesChangedSince(epoch);
+  absl::flat_hash_set<Node*> region(frontier.begin(), frontier.end());
+  for (int64_t i = 0; i < kPatternRadius; ++i) {
+    std::vector<Node*> next_frontier;
+    for (Node* node : frontier) {
+      for (Node* neighbor : node->operands()) {
+        if (region.insert(neighbor).second) {
+          next_frontier.push_back(neighbor);
+        }
+      }
+      for (Node* neighbor : node->users()) {
+        if (region.insert(neighbor).second) {
+          next_frontier.push_back(neighbor);
+        }
+      }
+    }
+    frontier = std::move(next_frontier);
+  }
+  return region;
+}
+
 }  // namespace
 
 absl::StatusOr<bool> ArithSimplificationPass::RunOnFunctionBaseInternal(
@@ -1531,10 +1562,14 @@ absl::StatusOr<bool> ArithSimplificationPass::RunOnFunctionBaseInternal(
     PassResults* results) const {
   bool changed = false;
   bool pass_changed = false;
+  // After the first sweep over the whole function only the region around the
+  // nodes changed by the previous sweep is revisited.
+  std::optional<absl::flat_hash_set<Node*>> dirty;
   do {
     pass_changed = false;
+    int64_t epoch = f->NewChangeEpoch();
     for (Node* n : ReverseTopoSort(f)) {
-      if (n->IsDead()) {
+      if (n->IsDead() || (dirty.has_value() && !dirty->contains(n))) {
         continue;
       }
       XLS_ASSIGN_OR_RETURN(
@@ -1545,6 +1580,11 @@ absl::StatusOr<bool> ArithSimplificationPass::RunOnFunctionBaseInternal(
       }
     }
     changed |= pass_changed;
+    if (pass_changed && !f->NodesRemovedSince(epoch)) {
+      dirty = DirtyRegion(f, epoch);
+    } else {
+      dirty.reset();
+    }
   } while (pass_changed);
   return changed;
 }
@@ -30,8 +30,10 @@
 #include "xls/estimators/delay_model/delay_estimators.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
 #include "xls/ir/topo_sort.h"
 #include "xls/passes/bdd_function.h"
+#include "xls/passes/function_deduplication.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -98,6 +100,19 @@ absl::StatusOr<std::vector<Node*>> GetNodeOrder(FunctionBase* f) {
 
 }  // namespace
 
+absl::StatusOr<bool> BddCsePass::RunInternal(
+    Package* p, const OptimizationPassOptions& options,
+    PassResults* results) const {
+  bool changed = false;
+  if (deduplicate_functions_) {
+    XLS_ASSIGN_OR_RETURN(changed, DeduplicateFunctions(p));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      bool cse_changed,
+      OptimizationFunctionBasePass::RunInternal(p, options, results));
+  return changed || cse_changed;
+}
+
 absl::StatusOr<bool> BddCsePass::RunOnFunctionBaseInternal(
     FunctionBase* f, const OptimizationPassOptions& options,
     PassResults* results) const {
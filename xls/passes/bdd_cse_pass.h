@@ -19,6 +19,7 @@
 
 #include "absl/status/statusor.h"
 #include "xls/ir/function_base.h"
+#include "xls/ir/package.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
 
@@ -26,18 +27,33 @@ namespace xls {
 
 // Pass which commons equivalent expressions in the graph using binary decision
 // diagrams.
+//
+// If `deduplicate_functions` is true, the pass first commons whole functions
+// across the package: calls of a function which is definitely equivalent to an
+// earlier function in the package (see Function::IsDefinitelyEqualTo) are
+// redirected to the earlier function, leaving the duplicate dead (see
+// DeduplicateFunctions). This is intended to run before inlining so that multiple instantiations of the same
+// parametric function are optimized once rather than once per instantiation.
 class BddCsePass : public OptimizationFunctionBasePass {
  public:
   static constexpr std::string_view kName = "bdd_cse";
-  explicit BddCsePass()
+  explicit BddCsePass(bool deduplicate_functions = false)
       : OptimizationFunctionBasePass(
-            kName, "BDD-based Common Subexpression Elimination") {}
+            kName, "BDD-based Common Subexpression Elimination"),
+        deduplicate_functions_(deduplicate_functions) {}
   ~BddCsePass() override = default;
 
  protected:
+  absl::StatusOr<bool> RunInternal(Package* p,
+                                   const OptimizationPassOptions& options,
+                                   PassResults* results) const override;
+
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const OptimizationPassOptions& options,
       PassResults* results) const override;
+
+ private:
+  bool deduplicate_functions_;
 };
 
 }  // namespace xls
@@ -14,6 +14,8 @@
 
 #include "xls/passes/bdd_cse_pass.h"
 
+#include <memory>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
@@ -23,6 +25,8 @@
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/passes/dfe_pass.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
 
@@ -42,6 +46,12 @@ class BddCsePassTest : public IrTestBase {
     return BddCsePass().RunOnFunctionBase(f, OptimizationPassOptions(),
                                           &results);
   }
+
+  absl::StatusOr<bool> RunWithFunctionDeduplication(Package* p) {
+    PassResults results;
+    return BddCsePass(/*deduplicate_functions=*/true)
+        .Run(p, OptimizationPassOptions(), &results);
+  }
 };
 
 TEST_F(BddCsePassTest, EqEquivalentToNotNe) {
@@ -89,5 +99,68 @@ TEST_F(BddCsePassTest, DecodeEquivalentToDeconstructedDecode) {
   EXPECT_THAT(f->return_value(), m::Tuple(m::Decode(), m::Decode()));
 }
 
+TEST_F(BddCsePassTest, DeduplicatesEquivalentFunctions) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
+package test
+
+fn add_0(x: bits[8], y: bits[8]) -> bits[8] {
+  ret add.1: bits[8] = add(x, y)
+}
+
+fn add_1(a: bits[8], b: bits[8]) -> bits[8] {
+  ret add.2: bits[8] = add(a, b)
+}
+
+fn sub(x: bits[8], y: bits[8]) -> bits[8] {
+  ret sub.3: bits[8] = sub(x, y)
+}
+
+top fn main(x: bits[8], y: bits[8]) -> (bits[8], bits[8], bits[8]) {
+  invoke.4: bits[8] = invoke(x, y, to_apply=add_0)
+  invoke.5: bits[8] = invoke(x, y, to_apply=add_1)
+  invoke.6: bits[8] = invoke(x, y, to_apply=sub)
+  ret result: (bits[8], bits[8], bits[8]) = tuple(invoke.4, invoke.5, invoke.6)
+}
+)"));
+  EXPECT_THAT(RunWithFunctionDeduplication(p.get()), IsOkAndHolds(true));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * add_0, p->GetFunction("add_0"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * sub, p->GetFunction("sub"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * main, p->GetFunction("main"));
+  EXPECT_THAT(main->return_value(),
+              m::Tuple(m::Invoke(), m::Invoke(), m::Invoke()));
+  EXPECT_EQ(main->return_value()->operand(0)->As<Invoke>()->to_apply(), add_0);
+  EXPECT_EQ(main->return_value()->operand(1)->As<Invoke>()->to_apply(), add_0);
+  EXPECT_EQ(main->return_value()->operand(2)->As<Invoke>()->to_apply(), sub);
+
+  PassResults results;
+  EXPECT_THAT(DeadFunctionEliminationPass().Run(
+                  p.get(), OptimizationPassOptions(), &results),
+              IsOkAndHolds(true));
+  EXPECT_FALSE(p->GetFunction("add_1").ok());
+}
+
+TEST_F(BddCsePassTest, DoesNotDeduplicateFunctionsWithSideEffects) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
+package test
+
+fn checked_0(tkn: token, x: bits[1]) -> bits[1] {
+  assert.1: token = assert(tkn, x, message="x is zero", id=1)
+  ret not.2: bits[1] = not(x)
+}
+
+fn checked_1(tkn: token, x: bits[1]) -> bits[1] {
+  assert.3: token = assert(tkn, x, message="x is 0", id=3)
+  ret not.4: bits[1] = not(x)
+}
+
+top fn main(tkn: token, x: bits[1]) -> (bits[1], bits[1]) {
+  invoke.5: bits[1] = invoke(tkn, x, to_apply=checked_0)
+  invoke.6: bits[1] = invoke(tkn, x, to_apply=checked_1)
+  ret tuple.7: (bits[1], bits[1]) = tuple(invoke.5, invoke.6)
+}
+)"));
+  EXPECT_THAT(RunWithFunctionDeduplication(p.get()), IsOkAndHolds(false));
+}
+
 }  // namespace
 }  // namespace xls
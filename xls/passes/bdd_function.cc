@@ -255,6 +255,7 @@ class BddStatistics {
   VLOG(3) << "BDD expressions:";
   absl::flat_hash_map<Node*, SaturatingBddNodeVector> values;
   BddStatistics bdd_stats;
+  int64_t gc_threshold = kGarbageCollectionThreshold;
   for (Node* node : TopoSort(f)) {
     VLOG(3) << "node: " << node->ToString();
     if (!node->GetType()->IsBits()) {
@@ -311,6 +312,20 @@ class BddStatistics {
     if (stop_watch.has_value()) {
       bdd_stats.AddOp(node->op(), stop_watch->GetElapsedTime());
     }
+
+    // Reclaim the intermediate BDD nodes created while evaluating, keeping
+    // only the expressions of the XLS nodes evaluated so far.
+    if (bdd_function->bdd().size() >= gc_threshold) {
+      std::vector<BddNodeIndex> roots;
+      for (const auto& [_, vector] : values) {
+        for (const SaturatingBddNodeIndex& value : vector) {
+          roots.push_back(std::get<BddNodeIndex>(value));
+        }
+      }
+      bdd_function->bdd().GarbageCollect(roots);
+      gc_threshold =
+          std::max(kGarbageCollectionThreshold, 2 * bdd_function->bdd().size());
+    }
   }
   XLS_VLOG_LINES(2, bdd_stats.ToString());
 
@@ -57,6 +57,11 @@ class BddFunction {
   // variable. This provides a mechanism for limiting the growth of the BDD.
   static constexpr int64_t kDefaultPathLimit = 1024;
 
+  // Nodes of the BDD which are not part of the expression of any XLS node are
+  // reclaimed whenever the BDD has grown to this many nodes, and then whenever
+  // it has doubled in size since the last collection.
+  static constexpr int64_t kGarbageCollectionThreshold = 1 << 16;
+
   // Construct a BDD representing the given function/proc.
   // `node_filter` is an optional function which filters the nodes to be
   // evaluated. If this function returns false for a node then the node will not
@@ -19,7 +19,6 @@
 #include <deque>
 #include <functional>
 #include <limits>
-#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -47,6 +46,7 @@
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -59,18 +59,22 @@
 namespace xls {
 namespace {
 
-static absl::StatusOr<std::unique_ptr<QueryEngine>> GetQueryEngine(
-    FunctionBase* f, int64_t opt_level) {
-  std::vector<std::unique_ptr<QueryEngine>> engines;
-  engines.push_back(std::make_unique<StatelessQueryEngine>());
-  engines.push_back(std::make_unique<TernaryQueryEngine>());
+// Returns the engines to query, which (apart from `stateless_query_engine`)
+// are owned by `analyses`.
+static absl::StatusOr<std::vector<QueryEngine*>> GetQueryEngines(
+    FunctionBase* f, int64_t opt_level, AnalysisManager& analyses,
+    StatelessQueryEngine& stateless_query_engine) {
+  std::vector<QueryEngine*> engines;
+  engines.push_back(&stateless_query_engine);
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * ternary_query_engine,
+                       analyses.GetTernaryQueryEngine(f));
+  engines.push_back(ternary_query_engine);
   if (opt_level >= 3) {
-    engines.push_back(std::make_unique<RangeQueryEngine>());
+    XLS_ASSIGN_OR_RETURN(RangeQueryEngine * range_query_engine,
+                         analyses.GetRangeQueryEngine(f));
+    engines.push_back(range_query_engine);
   }
-  auto query_engine = std::make_unique<UnionQueryEngine>(std::move(engines));
-
-  XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
-  return std::move(query_engine);
+  return engines;
 }
 
 // If we can identify `scaled_index` as a known multiple of `scale`, return the
@@ -1064,8 +1068,15 @@ absl::StatusOr<bool> BitSliceSimplificationPass::RunOnFunctionBaseInternal(
     PassResults* results) const {
   bool changed = false;
 
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<QueryEngine> query_engine,
-                       GetQueryEngine(f, options.opt_level));
+  AnalysisManager local_analyses;
+  AnalysisManager& analyses = options.analysis_manager != nullptr
+                                  ? *options.analysis_manager
+                                  : local_analyses;
+  StatelessQueryEngine stateless_query_engine;
+  XLS_ASSIGN_OR_RETURN(std::vector<QueryEngine*> engines,
+                       GetQueryEngines(f, options.opt_level, analyses,
+                                       stateless_query_engine));
+  UnownedUnionQueryEngine query_engine(std::move(engines));
 
   // Iterating through these operations in reverse topological order makes sure
   // we don't need to re-populate the query engine between nodes.
@@ -1077,11 +1088,11 @@ absl::StatusOr<bool> BitSliceSimplificationPass::RunOnFunctionBaseInternal(
     if (node->Is<DynamicBitSlice>()) {
       XLS_ASSIGN_OR_RETURN(node_changed,
                            SimplifyDynamicBitSlice(node->As<DynamicBitSlice>(),
-                                                   query_engine.get()));
+                                                   &query_engine));
     } else if (node->Is<BitSliceUpdate>()) {
       XLS_ASSIGN_OR_RETURN(node_changed,
                            SimplifyBitSliceUpdate(node->As<BitSliceUpdate>(),
-                                                  query_engine.get()));
+                                                  &query_engine));
     }
 
     if (node_changed) {
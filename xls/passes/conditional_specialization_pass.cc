@@ -105,6 +105,15 @@ struct Condition {
     }
     return *range == *other.range;
   }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const Condition& condition) {
+    // Ranges are left out since equal ranges need not have equal hashes
+    // unless normalized.
+    return H::combine(std::move(h), condition.node, condition.value,
+                      condition.range.has_value() &&
+                          !condition.range->IsMaximal());
+  }
 };
 
 // A comparison functor for ordering Conditions. The functor orders conditions
@@ -189,6 +198,15 @@ class ConditionSet {
 
   absl::Span<const Condition> conditions() const { return conditions_; }
 
+  friend bool operator==(const ConditionSet& lhs, const ConditionSet& rhs) {
+    return lhs.conditions_ == rhs.conditions_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const ConditionSet& set) {
+    return H::combine(std::move(h), set.conditions_);
+  }
+
   std::string ToString() const {
     std::vector<std::string> pieces;
     pieces.reserve(conditions_.size());
@@ -515,6 +533,13 @@ absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
   // Iterate backwards through the graph because we add conditions at the case
   // arm operands of selects and propagate them upwards through the expressions
   // which compute the case arm.
+  // Query engines specialized for each condition set seen so far. Many edges
+  // share a condition set, and since `query_engine` is not updated as the
+  // function is transformed (and no node is removed), an engine can be reused
+  // for every edge with the same conditions.
+  absl::flat_hash_map<ConditionSet, std::unique_ptr<QueryEngine>>
+      specialized_query_engines;
+
   bool changed = false;
   for (Node* node : ReverseTopoSort(f)) {
     ConditionSet& set = condition_map.GetNodeConditionSet(node);
@@ -767,8 +792,13 @@ absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
                                  operand->GetName(), node->GetName(),
                                  edge_set.ToString());
 
-      std::unique_ptr<QueryEngine> specialized_query_engine =
-          query_engine.SpecializeGiven(edge_set.GetAsGivens());
+      auto [engine_it, inserted] =
+          specialized_query_engines.try_emplace(edge_set);
+      if (inserted) {
+        engine_it->second =
+            query_engine.SpecializeGiven(edge_set.GetAsGivens());
+      }
+      QueryEngine* specialized_query_engine = engine_it->second.get();
 
       // First check to see if the condition set directly implies a value for
       // the operand. If so replace with the implied value.
@@ -14,19 +14,24 @@
 
 #include "xls/passes/cse_pass.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/hash/hash.h"
-#include "absl/log/check.h"
+#include "absl/algorithm/container.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/ir/function_base.h"
-#include "xls/ir/node_util.h"
+#include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/ir/topo_sort.h"
@@ -38,98 +43,234 @@ namespace xls {
 
 namespace {
 
-// Returns the operands of the given node for the purposes of the CSE
-// optimization. The order of the nodes may not match the order of the node's
-// actual operands. Motivation: generally for nodes to be considered equivalent
-// the operands must be in the same order. However, commutative operations are
-// agnostic to operand order. So to expand the CSE optimization, compare
-// operands as an unordered set for commutative operands. This is done be
-// ordered commutative operation operands by id prior to comparison. To avoid
-// having to construct a vector every time, a span is returned by this
-// function. If the operation is not commutative, the node's own operand span is
-// simply returned. For the commutative case, a vector of sorted operands is
-// constructed in span_backing_store from which a span is constructed.
-absl::Span<Node* const> GetOperandsForCse(
-    Node* node, std::vector<Node*>* span_backing_store) {
-  CHECK(span_backing_store->empty());
-  if (!OpIsCommutative(node->op())) {
-    return node->operands();
+// Topological levels with fewer nodes than this are classified on the calling
+// thread as spreading them across threads would cost more than it saves.
+constexpr int64_t kMinParallelLevelSize = 4096;
+
+// Partitions the nodes of a function base into classes of definitely equal
+// nodes (i.e., value numbering). Two nodes are in the same class if they have
+// the same op and attributes and their operands are in the same classes, with
+// operands of commutative ops compared as an unordered set. Each class is led
+// by its member which is earliest in topological order, and all other members
+// may be replaced with the leader.
+//
+// Nodes are referred to by their position in a topological order and a class
+// by the position of the first node classified into it. Candidate classes are
+// bucketed by a hash of the node signatures (see Node::SignatureHash) and the
+// classes of the operands, and the buckets are sharded by hash so nodes in
+// different shards can be classified concurrently.
+class NodeClasses {
+ public:
+  // Scratch space for classifying a node, reused to avoid allocating.
+  struct Scratch {
+    std::vector<int64_t> node_operands;
+    std::vector<int64_t> candidate_operands;
+  };
+
+  NodeClasses(FunctionBase* f, bool common_literals, int64_t shard_count)
+      : order_(TopoSort(f)),
+        common_literals_(common_literals),
+        position_(f->node_count()),
+        class_of_(order_.size()),
+        leader_(order_.size()),
+        shards_(shard_count) {
+    for (int64_t i = 0; i < order_.size(); ++i) {
+      position_[order_[i]->dense_index()] = i;
+    }
   }
-  span_backing_store->insert(span_backing_store->begin(),
-                             node->operands().begin(), node->operands().end());
-  SortByNodeId(span_backing_store);
-  return *span_backing_store;
-}
 
-}  // namespace
+  const std::vector<Node*>& order() const { return order_; }
+  int64_t position(Node* node) const { return position_[node->dense_index()]; }
 
-absl::StatusOr<bool> RunCse(FunctionBase* f,
-                            absl::flat_hash_map<Node*, Node*>* replacements,
-                            bool common_literals) {
-  // To improve efficiency, bucket potentially common nodes together. The
-  // bucketing is done via an int64_t hash value which is constructed from the
-  // op() of the node and the uid's of the node's operands.
-  auto hasher = absl::Hash<std::vector<int64_t>>();
-  auto node_hash = [&](Node* n) {
-    std::vector<int64_t> values_to_hash = {static_cast<int64_t>(n->op())};
-    std::vector<Node*> span_backing_store;
-    for (Node* operand : GetOperandsForCse(n, &span_backing_store)) {
-      values_to_hash.push_back(operand->id());
+  // Returns the hash under which the node at `position` is bucketed, or
+  // std::nullopt if the node is never commoned. The operands of the node must
+  // have been classified.
+  std::optional<uint64_t> Key(int64_t position, Scratch& scratch) const {
+    Node* node = order_[position];
+    if (OpIsSideEffecting(node->op()) ||
+        (node->Is<Literal>() && !common_literals_)) {
+      return std::nullopt;
     }
-    // If this is slow because of many literals, the Literal values could be
-    // combined into the hash. As is, all literals get the same hash value.
-    return hasher(values_to_hash);
-  };
+    GetOperandClasses(node, scratch.node_operands);
+    return absl::HashOf(node->SignatureHash(), scratch.node_operands);
+  }
 
-  bool changed = false;
-  absl::flat_hash_map<int64_t, std::vector<Node*>> node_buckets;
-  node_buckets.reserve(f->node_count());
-  for (Node* node : TopoSort(f)) {
-    if (OpIsSideEffecting(node->op())) {
-      continue;
+  int64_t ShardOf(uint64_t key) const { return key % shards_.size(); }
+
+  // Classifies the node at `position` which has the given key. The operands
+  // of the node must have been classified. Nodes in different shards may be
+  // classified concurrently.
+  void Classify(int64_t position, std::optional<uint64_t> key,
+                Scratch& scratch) {
+    class_of_[position] = position;
+    leader_[position] = position;
+    if (!key.has_value()) {
+      return;
+    }
+    Node* node = order_[position];
+    std::vector<int64_t>& bucket = shards_[ShardOf(*key)][*key];
+    if (!bucket.empty()) {
+      GetOperandClasses(node, scratch.node_operands);
+      for (int64_t candidate_class : bucket) {
+        Node* candidate = order_[candidate_class];
+        GetOperandClasses(candidate, scratch.candidate_operands);
+        if (scratch.node_operands == scratch.candidate_operands &&
+            node->IsDefinitelyEqualTo(candidate)) {
+          class_of_[position] = candidate_class;
+          leader_[candidate_class] =
+              std::min(leader_[candidate_class], position);
+          return;
+        }
+      }
     }
+    bucket.push_back(position);
+  }
 
-    if (node->Is<Literal>() && !common_literals) {
-      continue;
+  // Returns the leader of the class of the node at `position`.
+  Node* Leader(int64_t position) const {
+    return order_[leader_[class_of_[position]]];
+  }
+
+ private:
+  // Sets `classes` to the classes of the operands of `node`, sorted if the
+  // operation is commutative.
+  void GetOperandClasses(Node* node, std::vector<int64_t>& classes) const {
+    classes.clear();
+    for (Node* operand : node->operands()) {
+      classes.push_back(class_of_[position(operand)]);
+    }
+    if (OpIsCommutative(node->op())) {
+      absl::c_sort(classes);
     }
+  }
+
+  std::vector<Node*> order_;
+  bool common_literals_;
+  // Indexed by Node::dense_index.
+  std::vector<int64_t> position_;
+  // Indexed by position.
+  std::vector<int64_t> class_of_;
+  // Indexed by class.
+  std::vector<int64_t> leader_;
+  // Map from key to the classes with that key, in order of creation.
+  std::vector<absl::flat_hash_map<uint64_t, std::vector<int64_t>>> shards_;
+};
 
-    int64_t hash = node_hash(node);
-    if (!node_buckets.contains(hash)) {
-      node_buckets[hash].push_back(node);
+// Runs `fn(i)` for each `i` in [0, count) on its own thread.
+void RunOnThreads(int64_t count, const std::function<void(int64_t)>& fn) {
+  std::vector<std::unique_ptr<Thread>> threads;
+  threads.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    threads.push_back(std::make_unique<Thread>([&fn, i]() { fn(i); }));
+  }
+  // Threads are joined on destruction.
+}
+
+// Classifies all nodes using up to `thread_count` threads. Nodes are
+// classified one topological level (the length of the longest path to the node
+// from a node without operands) at a time as nodes in the same level do not
+// depend on each other. Wide levels are classified by first computing the keys
+// of their nodes in parallel and then classifying each shard on its own
+// thread. The result is the same as that of classifying the nodes serially.
+void ClassifyInParallel(NodeClasses& classes, int64_t thread_count) {
+  const std::vector<Node*>& order = classes.order();
+  std::vector<int64_t> level(order.size(), 0);
+  int64_t level_count = 0;
+  for (int64_t i = 0; i < order.size(); ++i) {
+    for (Node* operand : order[i]->operands()) {
+      level[i] = std::max(level[i], level[classes.position(operand)] + 1);
+    }
+    level_count = std::max(level_count, level[i] + 1);
+  }
+  // Positions grouped by level, in topological order within each level.
+  std::vector<int64_t> level_begin(level_count + 1, 0);
+  for (int64_t i = 0; i < order.size(); ++i) {
+    ++level_begin[level[i] + 1];
+  }
+  for (int64_t l = 0; l < level_count; ++l) {
+    level_begin[l + 1] += level_begin[l];
+  }
+  std::vector<int64_t> by_level(order.size());
+  std::vector<int64_t> next = level_begin;
+  for (int64_t i = 0; i < order.size(); ++i) {
+    by_level[next[level[i]]++] = i;
+  }
+
+  std::vector<std::optional<uint64_t>> keys(order.size());
+  NodeClasses::Scratch scratch;
+  for (int64_t l = 0; l < level_count; ++l) {
+    absl::Span<const int64_t> positions =
+        absl::MakeConstSpan(by_level)
+            .subspan(level_begin[l], level_begin[l + 1] - level_begin[l]);
+    if (positions.size() < kMinParallelLevelSize) {
+      for (int64_t position : positions) {
+        classes.Classify(position, classes.Key(position, scratch), scratch);
+      }
       continue;
     }
-    bool replaced = false;
-    std::vector<Node*> node_span_backing_store;
-    absl::Span<Node* const> node_operands_for_cse =
-        GetOperandsForCse(node, &node_span_backing_store);
-    for (Node* candidate : node_buckets.at(hash)) {
-      std::vector<Node*> candidate_span_backing_store;
-      if (node_operands_for_cse ==
-              GetOperandsForCse(candidate, &candidate_span_backing_store) &&
-          node->IsDefinitelyEqualTo(candidate)) {
-        VLOG(3) << absl::StreamFormat("Replacing %s with equivalent node %s",
-                                      node->GetName(), candidate->GetName());
-        XLS_RETURN_IF_ERROR(node->ReplaceUsesWith(candidate));
-        if (replacements != nullptr) {
-          (*replacements)[node] = candidate;
+    RunOnThreads(thread_count, [&](int64_t thread) {
+      NodeClasses::Scratch thread_scratch;
+      for (int64_t i = thread; i < positions.size(); i += thread_count) {
+        int64_t position = positions[i];
+        keys[position] = classes.Key(position, thread_scratch);
+        if (!keys[position].has_value()) {
+          // Never bucketed so no other thread looks at this node's class.
+          classes.Classify(position, std::nullopt, thread_scratch);
         }
-        changed = true;
-        replaced = true;
-        break;
       }
-    }
-    if (!replaced) {
-      node_buckets[hash].push_back(node);
+    });
+    RunOnThreads(thread_count, [&](int64_t shard) {
+      NodeClasses::Scratch thread_scratch;
+      for (int64_t position : positions) {
+        if (keys[position].has_value() &&
+            classes.ShardOf(*keys[position]) == shard) {
+          classes.Classify(position, keys[position], thread_scratch);
+        }
+      }
+    });
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<bool> RunCse(FunctionBase* f,
+                            absl::flat_hash_map<Node*, Node*>* replacements,
+                            bool common_literals, int64_t parallelism) {
+  NodeClasses classes(f, common_literals, std::max<int64_t>(parallelism, 1));
+  const std::vector<Node*>& order = classes.order();
+  if (parallelism > 1) {
+    ClassifyInParallel(classes, parallelism);
+  } else {
+    NodeClasses::Scratch scratch;
+    for (int64_t i = 0; i < order.size(); ++i) {
+      classes.Classify(i, classes.Key(i, scratch), scratch);
     }
   }
 
+  // Every leader precedes the members of its class in topological order, so
+  // replacing members with their leaders cannot introduce a cycle.
+  bool changed = false;
+  for (int64_t i = 0; i < order.size(); ++i) {
+    Node* node = order[i];
+    Node* leader = classes.Leader(i);
+    if (leader == node) {
+      continue;
+    }
+    VLOG(3) << absl::StreamFormat("Replacing %s with equivalent node %s",
+                                  node->GetName(), leader->GetName());
+    XLS_RETURN_IF_ERROR(node->ReplaceUsesWith(leader));
+    if (replacements != nullptr) {
+      (*replacements)[node] = leader;
+    }
+    changed = true;
+  }
   return changed;
 }
 
 absl::StatusOr<bool> CsePass::RunOnFunctionBaseInternal(
     FunctionBase* f, const OptimizationPassOptions& options,
     PassResults* results) const {
-  return RunCse(f, nullptr, common_literals_);
+  return RunCse(f, nullptr, common_literals_, options.node_parallelism);
 }
 
 REGISTER_OPT_PASS(CsePass);
@@ -15,6 +15,7 @@
 #ifndef XLS_PASSES_CSE_PASS_H_
 #define XLS_PASSES_CSE_PASS_H_
 
+#include <cstdint>
 #include <string_view>
 
 #include "absl/container/flat_hash_map.h"
@@ -31,10 +32,12 @@ namespace xls {
 // extract which nodes were merged. Each replacement done by the pass is added
 // to the `replacements` hash map if it is not `nullptr`. Note that for many
 // common uses of the `replacements` map, you'll want to compute the transitive
-// closure of the relation rather than using it as-is.
+// closure of the relation rather than using it as-is. Equivalent nodes are
+// found using up to `parallelism` threads; the result does not depend on it.
 absl::StatusOr<bool> RunCse(FunctionBase* f,
                             absl::flat_hash_map<Node*, Node*>* replacements,
-                            bool common_literals = true);
+                            bool common_literals = true,
+                            int64_t parallelism = 1);
 
 // Computes the fixed point of a strict partial order, i.e.: the relation that
 // solves the equation `F = R ∘ F` where `R` is the given strict partial order.
@@ -14,19 +14,24 @@
 
 #include "xls/passes/cse_pass.h"
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/function.h"
+#include "xls/ir/bits.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
 #include "xls/ir/op.h"
 #include "xls/ir/package.h"
 #include "xls/passes/dce_pass.h"
@@ -253,5 +258,42 @@ TEST_F(CsePassTest, NonCommutativeOperands) {
   EXPECT_NE(f->return_value()->operand(0), f->return_value()->operand(1));
 }
 
+TEST_F(CsePassTest, ParallelMatchesSerial) {
+  // Wide enough that some levels are classified on several threads.
+  constexpr int64_t kWidth = 5000;
+  auto build = [&](Package* p) -> absl::StatusOr<Function*> {
+    FunctionBuilder fb(TestName(), p);
+    BValue x = fb.Param("x", p->GetBitsType(32));
+    std::vector<BValue> elements;
+    for (int64_t i = 0; i < kWidth; ++i) {
+      BValue a = fb.Add(x, fb.Literal(UBits(i % 100, 32)));
+      BValue b = fb.Add(fb.Literal(UBits(i % 100, 32)), x);
+      elements.push_back(fb.Xor(a, b));
+    }
+    return fb.BuildWithReturnValue(fb.Tuple(elements));
+  };
+  auto serial_package = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * serial, build(serial_package.get()));
+  auto parallel_package = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * parallel, build(parallel_package.get()));
+
+  absl::flat_hash_map<Node*, Node*> serial_replacements;
+  absl::flat_hash_map<Node*, Node*> parallel_replacements;
+  EXPECT_THAT(RunCse(serial, &serial_replacements), IsOkAndHolds(true));
+  EXPECT_THAT(RunCse(parallel, &parallel_replacements,
+                     /*common_literals=*/true, /*parallelism=*/4),
+              IsOkAndHolds(true));
+  EXPECT_EQ(serial_replacements.size(), parallel_replacements.size());
+  EXPECT_EQ(serial->DumpIr(), parallel->DumpIr());
+
+  // Each xor is of two equal adds and there are 100 distinct ones.
+  absl::flat_hash_set<Node*> distinct;
+  for (Node* element : parallel->return_value()->operands()) {
+    EXPECT_EQ(element->operand(0), element->operand(1));
+    distinct.insert(element);
+  }
+  EXPECT_EQ(distinct.size(), 100);
+}
+
 }  // namespace
 }  // namespace xls
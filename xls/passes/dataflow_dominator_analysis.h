@@ -15,20 +15,25 @@
 #ifndef XLS_PASSES_DATAFLOW_DOMINATOR_ANALYSIS_H_
 #define XLS_PASSES_DATAFLOW_DOMINATOR_ANALYSIS_H_
 
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
+#include "xls/ir/node_graph.h"
+#include "xls/passes/dominator_tree.h"
 
 namespace xls {
 
 // A class for dataflow dominator analysis of the IR instructions in a function.
 //
 // This finds all dominators of each node, accounting for potential external
-// sources of data and disregarding literals.
+// sources of data and disregarding literals. Dominance queries take constant
+// time; the node lists returned by the getters are materialized on first
+// request.
 class DataflowDominatorAnalysis {
  public:
   // Performs dataflow dominator analysis on the function and returns the
@@ -36,34 +41,32 @@ class DataflowDominatorAnalysis {
   static absl::StatusOr<DataflowDominatorAnalysis> Run(FunctionBase* f);
 
   // Returns the nodes that dominate this node.
-  absl::Span<Node* const> GetDominatorsOfNode(const Node* node) const {
-    return dominated_node_to_dominators_ordered_by_id_.at(node);
-  }
+  absl::Span<Node* const> GetDominatorsOfNode(const Node* node) const;
   // Returns the nodes that are dominated by this node.
-  absl::Span<Node* const> GetNodesDominatedByNode(const Node* node) const {
-    return dominator_to_dominated_nodes_ordered_by_id_.at(node);
-  }
+  absl::Span<Node* const> GetNodesDominatedByNode(const Node* node) const;
   // Returns true if 'node' is dominated by 'dominator'.
   bool NodeIsDominatedBy(const Node* node, const Node* dominator) const {
-    return dominated_node_to_dominators_.at(node).contains(dominator);
+    return tree_.Dominates(graph_.index(dominator), graph_.index(node));
   }
   // Returns true if 'node' dominates 'dominated'.
   bool NodeDominates(const Node* node, const Node* dominated) const {
-    return dominator_to_dominated_nodes_.at(node).contains(dominated);
+    return tree_.Dominates(graph_.index(node), graph_.index(dominated));
   }
 
  private:
-  // Maps from a node to all nodes that dominate the node.
-  absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>>
-      dominated_node_to_dominators_;
-  absl::flat_hash_map<Node*, std::vector<Node*>>
-      dominated_node_to_dominators_ordered_by_id_;
+  DataflowDominatorAnalysis(NodeGraph graph, DominatorTree tree)
+      : graph_(std::move(graph)), tree_(std::move(tree)) {}
+
+  NodeGraph graph_;
+  // Tree over the node indices of `graph_`. Nodes which don't provide
+  // variable data are not in the tree.
+  DominatorTree tree_;
 
-  // Maps from a node to all nodes that are dominated by the node.
-  absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>>
-      dominator_to_dominated_nodes_;
-  absl::flat_hash_map<Node*, std::vector<Node*>>
-      dominator_to_dominated_nodes_ordered_by_id_;
+  // Node lists ordered by id, materialized on first request.
+  mutable absl::flat_hash_map<const Node*, std::vector<Node*>>
+      dominators_ordered_by_id_;
+  mutable absl::flat_hash_map<const Node*, std::vector<Node*>>
+      dominated_nodes_ordered_by_id_;
 };
 
 }  // namespace xls
@@ -15,14 +15,14 @@
 #include "xls/passes/dce_pass.h"
 
 #include <cstdint>
-#include <deque>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/function_base.h"
-#include "xls/ir/node_util.h"
+#include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/passes/optimization_pass.h"
@@ -39,35 +39,40 @@ absl::StatusOr<bool> DeadCodeEliminationPass::RunOnFunctionBaseInternal(
            (!OpIsSideEffecting(n->op()) || n->Is<Gate>());
   };
 
-  std::deque<Node*> worklist;
+  // Number of distinct users of each node, indexed by dense index, which have
+  // not been found to be dead. A node becomes dead when this reaches zero.
+  // Nodes are only removed once all dead nodes are known, in one batch.
+  std::vector<int64_t> live_user_count(f->node_count());
+  std::vector<Node*> worklist;
   for (Node* n : f->nodes()) {
+    live_user_count[n->dense_index()] = n->users().size();
     if (n->users().empty() && is_deletable(n)) {
       worklist.push_back(n);
     }
   }
-  int64_t removed_count = 0;
+  std::vector<Node*> dead;
   absl::flat_hash_set<Node*> unique_operands;
   while (!worklist.empty()) {
-    Node* node = worklist.front();
-    worklist.pop_front();
+    Node* node = worklist.back();
+    worklist.pop_back();
+    dead.push_back(node);
 
     // A node may appear more than once as an operand of 'node'. Keep track of
     // which operands have been handled in a set.
     unique_operands.clear();
     for (Node* operand : node->operands()) {
-      if (unique_operands.insert(operand).second) {
-        if (HasSingleUse(operand) && is_deletable(operand)) {
-          worklist.push_back(operand);
-        }
+      if (unique_operands.insert(operand).second &&
+          --live_user_count[operand->dense_index()] == 0 &&
+          is_deletable(operand)) {
+        worklist.push_back(operand);
       }
     }
     VLOG(3) << "DCE removing " << node->ToString();
-    XLS_RETURN_IF_ERROR(f->RemoveNode(node));
-    removed_count++;
   }
+  XLS_RETURN_IF_ERROR(f->RemoveNodes(dead));
 
-  VLOG(2) << "Removed " << removed_count << " dead nodes";
-  return removed_count > 0;
+  VLOG(2) << "Removed " << dead.size() << " dead nodes";
+  return !dead.empty();
 }
 
 REGISTER_OPT_PASS(DeadCodeEliminationPass);
@@ -0,0 +1,113 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/dominator_tree.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+
+namespace xls {
+
+void DominatorTree::Add(NodeIndex node, JumpPointerTree::Index parent) {
+  CHECK(!finalized_);
+  CHECK(!InTree(node)) << "Node " << node << " added twice";
+  tree_index_[node] = tree_.AddChild(parent);
+  nodes_.push_back(node);
+}
+
+bool DominatorTree::AddNode(NodeIndex node,
+                            absl::Span<const NodeIndex> predecessors) {
+  std::optional<JumpPointerTree::Index> dominator;
+  for (NodeIndex predecessor : predecessors) {
+    JumpPointerTree::Index index = tree_index_[predecessor];
+    if (index == kNotInTree) {
+      continue;
+    }
+    dominator = dominator.has_value()
+                    ? tree_.NearestCommonAncestor(*dominator, index)
+                    : index;
+    if (*dominator == JumpPointerTree::kRoot) {
+      break;
+    }
+  }
+  if (!dominator.has_value()) {
+    return false;
+  }
+  Add(node, *dominator);
+  return true;
+}
+
+void DominatorTree::Finalize() {
+  CHECK(!finalized_);
+  finalized_ = true;
+
+  // Parents precede their children in `tree_`, so subtree sizes accumulate
+  // bottom-up in one backwards sweep, and a forwards sweep then lays out every
+  // subtree after its root and its earlier siblings' subtrees.
+  int64_t tree_size = tree_.size();
+  std::vector<int64_t> size(tree_size, 1);
+  for (JumpPointerTree::Index t = tree_size - 1; t > 0; --t) {
+    size[tree_.parent(t)] += size[t];
+  }
+  // The virtual root itself does not appear in the preorder.
+  std::vector<int64_t> position(tree_size, 0);
+  std::vector<int64_t> next_position(tree_size, 0);
+  for (JumpPointerTree::Index t = 1; t < tree_size; ++t) {
+    JumpPointerTree::Index parent = tree_.parent(t);
+    position[t] = next_position[parent];
+    next_position[parent] += size[t];
+    next_position[t] = position[t] + 1;
+  }
+
+  preorder_.resize(tree_size - 1);
+  preorder_index_.assign(tree_index_.size(), -1);
+  subtree_size_.assign(tree_index_.size(), 0);
+  for (JumpPointerTree::Index t = 1; t < tree_size; ++t) {
+    NodeIndex node = nodes_[t - 1];
+    preorder_[position[t]] = node;
+    preorder_index_[node] = position[t];
+    subtree_size_[node] = size[t];
+  }
+}
+
+std::optional<DominatorTree::NodeIndex> DominatorTree::ImmediateDominator(
+    NodeIndex node) const {
+  if (!InTree(node)) {
+    return std::nullopt;
+  }
+  JumpPointerTree::Index parent = tree_.parent(tree_index_[node]);
+  if (parent == JumpPointerTree::kRoot) {
+    return std::nullopt;
+  }
+  return nodes_[parent - 1];
+}
+
+std::vector<DominatorTree::NodeIndex> DominatorTree::GetDominators(
+    NodeIndex node) const {
+  std::vector<NodeIndex> dominators;
+  if (!InTree(node)) {
+    return dominators;
+  }
+  for (JumpPointerTree::Index t = tree_index_[node];
+       t != JumpPointerTree::kRoot; t = tree_.parent(t)) {
+    dominators.push_back(nodes_[t - 1]);
+  }
+  return dominators;
+}
+
+}  // namespace xls
@@ -0,0 +1,181 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_DOMINATOR_TREE_H_
+#define XLS_PASSES_DOMINATOR_TREE_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+
+namespace xls {
+
+// A rooted tree grown one leaf at a time which answers nearest common ancestor
+// queries in O(log depth) time. Besides its parent every node keeps a jump
+// pointer to an ancestor chosen such that the jumps form a skew-binary ladder
+// (E. W. Myers, "An applicative random-access stack", 1983), so the tree needs
+// only constant space per node and no rebuilding as it grows.
+class JumpPointerTree {
+ public:
+  using Index = int64_t;
+  static constexpr Index kRoot = 0;
+
+  JumpPointerTree() { nodes_.push_back({.parent = kRoot, .jump = kRoot}); }
+
+  // Adds a new child of `parent` and returns its index. Indices are assigned
+  // consecutively starting from 1.
+  Index AddChild(Index parent) {
+    DCHECK_LT(parent, size());
+    const Entry& p = nodes_[parent];
+    const Entry& j = nodes_[p.jump];
+    Index jump = p.depth - j.depth == j.depth - nodes_[j.jump].depth
+                     ? j.jump
+                     : parent;
+    nodes_.push_back({.parent = parent, .jump = jump, .depth = p.depth + 1});
+    return nodes_.size() - 1;
+  }
+
+  int64_t size() const { return nodes_.size(); }
+  Index parent(Index node) const { return nodes_[node].parent; }
+  int64_t depth(Index node) const { return nodes_[node].depth; }
+
+  // Returns the ancestor of `node` at depth `depth`, which must be no larger
+  // than the depth of `node`.
+  Index AncestorAtDepth(Index node, int64_t depth) const {
+    DCHECK_LE(depth, nodes_[node].depth);
+    while (nodes_[node].depth > depth) {
+      const Entry& entry = nodes_[node];
+      node = nodes_[entry.jump].depth >= depth ? entry.jump : entry.parent;
+    }
+    return node;
+  }
+
+  Index NearestCommonAncestor(Index a, Index b) const {
+    if (nodes_[a].depth > nodes_[b].depth) {
+      a = AncestorAtDepth(a, nodes_[b].depth);
+    } else {
+      b = AncestorAtDepth(b, nodes_[a].depth);
+    }
+    // Nodes at the same depth have their jump pointers at the same depth, so
+    // the two walks stay in step.
+    while (a != b) {
+      if (nodes_[a].jump != nodes_[b].jump) {
+        a = nodes_[a].jump;
+        b = nodes_[b].jump;
+      } else {
+        a = nodes_[a].parent;
+        b = nodes_[b].parent;
+      }
+    }
+    return a;
+  }
+
+ private:
+  struct Entry {
+    Index parent;
+    Index jump;
+    int64_t depth = 0;
+  };
+  std::vector<Entry> nodes_;
+};
+
+// The dominator tree of an acyclic graph with nodes numbered [0, node_count).
+//
+// Nodes are added in a topological order of the graph, i.e., after all of
+// their predecessors. Since every path to a node passes through one of its
+// predecessors and all of them are already in the tree, the immediate
+// dominator of a node is the nearest common ancestor of its predecessors in
+// the tree. This is the final step of the semi-NCA algorithm, which on an
+// acyclic graph visited in topological order needs no semidominators, and
+// takes O((V + E) log V) time in total. Entry nodes hang off a virtual root
+// which dominates everything.
+//
+// Once finalized the tree is numbered in depth-first order so that dominance
+// queries take constant time and the nodes dominated by a node are a
+// contiguous span.
+class DominatorTree {
+ public:
+  using NodeIndex = int64_t;
+
+  explicit DominatorTree(int64_t node_count)
+      : tree_index_(node_count, kNotInTree) {}
+
+  // Adds `node` as an entry of the graph, dominated by nothing else.
+  void AddEntry(NodeIndex node) { Add(node, JumpPointerTree::kRoot); }
+
+  // Adds `node` with the given predecessors. Predecessors which are not in the
+  // tree are ignored, and if none is in the tree neither is `node`. Returns
+  // whether `node` was added.
+  bool AddNode(NodeIndex node, absl::Span<const NodeIndex> predecessors);
+
+  // Numbers the tree. Must be called after the last node is added and before
+  // any of the queries below.
+  void Finalize();
+
+  bool InTree(NodeIndex node) const { return tree_index_[node] != kNotInTree; }
+
+  // Returns the immediate dominator of `node`, or nullopt if `node` is an
+  // entry or not in the tree.
+  std::optional<NodeIndex> ImmediateDominator(NodeIndex node) const;
+
+  // Returns whether `a` dominates `b`. Every node in the tree dominates
+  // itself; nodes not in the tree dominate and are dominated by nothing.
+  bool Dominates(NodeIndex a, NodeIndex b) const {
+    DCHECK(finalized_);
+    if (!InTree(a) || !InTree(b)) {
+      return false;
+    }
+    return preorder_index_[a] <= preorder_index_[b] &&
+           preorder_index_[b] < preorder_index_[a] + subtree_size_[a];
+  }
+
+  // Returns the dominators of `node` from `node` itself up to its entry.
+  std::vector<NodeIndex> GetDominators(NodeIndex node) const;
+
+  // Returns the nodes dominated by `node`, including `node`, in depth-first
+  // order.
+  absl::Span<const NodeIndex> GetDominatedNodes(NodeIndex node) const {
+    DCHECK(finalized_);
+    if (!InTree(node)) {
+      return {};
+    }
+    return absl::MakeConstSpan(preorder_).subspan(preorder_index_[node],
+                                                  subtree_size_[node]);
+  }
+
+ private:
+  static constexpr JumpPointerTree::Index kNotInTree = -1;
+
+  void Add(NodeIndex node, JumpPointerTree::Index parent);
+
+  JumpPointerTree tree_;
+  // Index in `tree_` of each node, or kNotInTree.
+  std::vector<JumpPointerTree::Index> tree_index_;
+  // Node at each index in `tree_`, starting from index 1.
+  std::vector<NodeIndex> nodes_;
+
+  bool finalized_ = false;
+  // The nodes in depth-first preorder, the position of each node in it, and
+  // the size of the subtree rooted at each node.
+  std::vector<NodeIndex> preorder_;
+  std::vector<int64_t> preorder_index_;
+  std::vector<int64_t> subtree_size_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_DOMINATOR_TREE_H_
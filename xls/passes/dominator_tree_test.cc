@@ -0,0 +1,85 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/dominator_tree.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace xls {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+using ::testing::UnorderedElementsAre;
+
+TEST(JumpPointerTreeTest, NearestCommonAncestorOfDeepBranches) {
+  JumpPointerTree tree;
+  std::vector<JumpPointerTree::Index> chain = {JumpPointerTree::kRoot};
+  for (int64_t i = 0; i < 1000; ++i) {
+    chain.push_back(tree.AddChild(chain.back()));
+  }
+  JumpPointerTree::Index branch = chain[500];
+  for (int64_t i = 0; i < 300; ++i) {
+    branch = tree.AddChild(branch);
+  }
+  EXPECT_EQ(tree.depth(branch), 800);
+  EXPECT_EQ(tree.AncestorAtDepth(chain.back(), 123), chain[123]);
+  EXPECT_EQ(tree.NearestCommonAncestor(chain.back(), branch), chain[500]);
+  EXPECT_EQ(tree.NearestCommonAncestor(branch, chain[700]), chain[500]);
+  EXPECT_EQ(tree.NearestCommonAncestor(chain[42], chain.back()), chain[42]);
+  EXPECT_EQ(tree.NearestCommonAncestor(branch, branch), branch);
+}
+
+// Diamond 0 -> {1, 2} -> 3 -> 4 plus a second entry 5 feeding 4, and a node 6
+// whose only predecessor is not in the tree.
+TEST(DominatorTreeTest, Diamond) {
+  DominatorTree tree(8);
+  tree.AddEntry(0);
+  EXPECT_TRUE(tree.AddNode(1, {0}));
+  EXPECT_TRUE(tree.AddNode(2, {0}));
+  EXPECT_TRUE(tree.AddNode(3, {1, 2}));
+  tree.AddEntry(5);
+  EXPECT_TRUE(tree.AddNode(4, {3, 5}));
+  EXPECT_FALSE(tree.AddNode(6, {7}));
+  EXPECT_TRUE(tree.AddNode(7, {3, 6}));
+  tree.Finalize();
+
+  EXPECT_EQ(tree.ImmediateDominator(0), std::nullopt);
+  EXPECT_THAT(tree.ImmediateDominator(3), Optional(0));
+  EXPECT_EQ(tree.ImmediateDominator(4), std::nullopt);
+  EXPECT_THAT(tree.ImmediateDominator(7), Optional(3));
+  EXPECT_FALSE(tree.InTree(6));
+
+  EXPECT_THAT(tree.GetDominators(7), ElementsAre(7, 3, 0));
+  EXPECT_THAT(tree.GetDominators(4), ElementsAre(4));
+  EXPECT_THAT(tree.GetDominators(6), IsEmpty());
+  EXPECT_THAT(tree.GetDominatedNodes(0), UnorderedElementsAre(0, 1, 2, 3, 7));
+  EXPECT_THAT(tree.GetDominatedNodes(3), UnorderedElementsAre(3, 7));
+  EXPECT_THAT(tree.GetDominatedNodes(6), IsEmpty());
+
+  EXPECT_TRUE(tree.Dominates(0, 7));
+  EXPECT_TRUE(tree.Dominates(3, 3));
+  EXPECT_FALSE(tree.Dominates(1, 3));
+  EXPECT_FALSE(tree.Dominates(0, 4));
+  EXPECT_FALSE(tree.Dominates(6, 6));
+}
+
+}  // namespace
+}  // namespace xls
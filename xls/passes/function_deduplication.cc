@@ -0,0 +1,150 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/function_deduplication.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/call_graph.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/topo_sort.h"
+
+namespace xls {
+namespace {
+
+// Returns a hash of the expression computing the return value of `f`.
+// Functions which are definitely equal (see Function::IsDefinitelyEqualTo)
+// have equal hashes.
+uint64_t FunctionSignatureHash(Function* f) {
+  absl::flat_hash_map<Node*, uint64_t> hashes;
+  for (int64_t i = 0; i < f->params().size(); ++i) {
+    hashes[f->param(i)] = absl::HashOf(f->param(i)->SignatureHash(), i);
+  }
+  for (Node* node : TopoSort(f)) {
+    if (node->Is<Param>()) {
+      continue;
+    }
+    uint64_t hash = node->SignatureHash();
+    for (Node* operand : node->operands()) {
+      hash = absl::HashOf(hash, hashes.at(operand));
+    }
+    hashes[node] = hash;
+  }
+  return absl::HashOf(f->params().size(), hashes.at(f->return_value()));
+}
+
+// Replaces `call`, which must call a function, with an identical node calling
+// `callee` instead.
+absl::Status RedirectCall(Node* call, Function* callee) {
+  switch (call->op()) {
+    case Op::kInvoke:
+      XLS_RETURN_IF_ERROR(
+          call->ReplaceUsesWithNew<Invoke>(call->operands(), callee).status());
+      break;
+    case Op::kMap:
+      XLS_RETURN_IF_ERROR(
+          call->ReplaceUsesWithNew<Map>(call->operand(Map::kArgOperand), callee)
+              .status());
+      break;
+    case Op::kCountedFor: {
+      CountedFor* loop = call->As<CountedFor>();
+      XLS_RETURN_IF_ERROR(
+          call->ReplaceUsesWithNew<CountedFor>(
+                  loop->initial_value(), loop->invariant_args(),
+                  loop->trip_count(), loop->stride(), callee)
+              .status());
+      break;
+    }
+    case Op::kDynamicCountedFor: {
+      DynamicCountedFor* loop = call->As<DynamicCountedFor>();
+      XLS_RETURN_IF_ERROR(
+          call->ReplaceUsesWithNew<DynamicCountedFor>(
+                  loop->initial_value(), loop->trip_count(), loop->stride(),
+                  loop->invariant_args(), callee)
+              .status());
+      break;
+    }
+    default:
+      return absl::InternalError(absl::StrFormat(
+          "Node %s does not call a function", call->GetName()));
+  }
+  return call->function_base()->RemoveNode(call);
+}
+
+}  // namespace
+
+absl::StatusOr<bool> DeduplicateFunctions(Package* p) {
+  // Callees are visited before their callers, so whether a function has side
+  // effects through its callees is known by the time it is visited.
+  absl::flat_hash_map<FunctionBase*, bool> has_side_effects;
+  absl::flat_hash_map<uint64_t, std::vector<Function*>> buckets;
+  std::vector<std::pair<Function*, Function*>> duplicates;
+  for (FunctionBase* f : FunctionsInPostOrder(p)) {
+    bool side_effects = absl::c_any_of(f->nodes(), [](Node* node) {
+      return !node->Is<Param>() && OpIsSideEffecting(node->op());
+    });
+    for (FunctionBase* callee : GetDependentFunctions(f)) {
+      if (callee != f && has_side_effects.at(callee)) {
+        side_effects = true;
+      }
+    }
+    has_side_effects[f] = side_effects;
+    // Foreign functions are code generated from their template rather than
+    // their body, so two with the same body are not interchangeable.
+    if (side_effects || !f->IsFunction() ||
+        f->ForeignFunctionData().has_value()) {
+      continue;
+    }
+
+    Function* function = f->AsFunctionOrDie();
+    std::vector<Function*>& bucket = buckets[FunctionSignatureHash(function)];
+    auto it = absl::c_find_if(bucket, [&](Function* candidate) {
+      return candidate->IsDefinitelyEqualTo(function);
+    });
+    if (it == bucket.end()) {
+      bucket.push_back(function);
+      continue;
+    }
+    VLOG(2) << absl::StreamFormat("Function %s is equivalent to %s",
+                                  function->name(), (*it)->name());
+    duplicates.push_back({function, *it});
+  }
+
+  bool changed = false;
+  for (const auto& [duplicate, canonical] : duplicates) {
+    for (Node* call : GetNodesWhichCall(duplicate)) {
+      XLS_RETURN_IF_ERROR(RedirectCall(call, canonical));
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+}  // namespace xls
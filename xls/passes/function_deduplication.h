@@ -0,0 +1,34 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_PASSES_FUNCTION_DEDUPLICATION_H_
+#define XLS_PASSES_FUNCTION_DEDUPLICATION_H_
+
+#include "absl/status/statusor.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// Redirects calls of functions which are definitely equivalent to an earlier
+// function in the package to that function. Only functions without
+// side-effecting operations (transitively) are considered because equivalence
+// is established on the return value alone, and foreign functions are never
+// considered. The duplicate functions are left in the package for dead function
+// elimination to remove. Returns true if any call was redirected.
+absl::StatusOr<bool> DeduplicateFunctions(Package* p);
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_FUNCTION_DEDUPLICATION_H_
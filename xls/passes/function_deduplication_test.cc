@@ -0,0 +1,111 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/function_deduplication.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+
+class FunctionDeduplicationTest : public IrTestBase {};
+
+TEST_F(FunctionDeduplicationTest, RedirectsMapsAndLoops) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
+package test
+
+fn inc_0(x: bits[8]) -> bits[8] {
+  literal.1: bits[8] = literal(value=1)
+  ret add.2: bits[8] = add(x, literal.1)
+}
+
+fn inc_1(y: bits[8]) -> bits[8] {
+  literal.3: bits[8] = literal(value=1)
+  ret add.4: bits[8] = add(y, literal.3)
+}
+
+fn body_0(i: bits[8], acc: bits[8]) -> bits[8] {
+  ret add.5: bits[8] = add(i, acc)
+}
+
+fn body_1(j: bits[8], sum: bits[8]) -> bits[8] {
+  ret add.6: bits[8] = add(j, sum)
+}
+
+top fn main(a: bits[8][4], x: bits[8]) -> (bits[8][4], bits[8][4], bits[8], bits[8]) {
+  map.7: bits[8][4] = map(a, to_apply=inc_0)
+  map.8: bits[8][4] = map(a, to_apply=inc_1)
+  counted_for.9: bits[8] = counted_for(x, trip_count=4, stride=1, body=body_0)
+  counted_for.10: bits[8] = counted_for(x, trip_count=4, stride=1, body=body_1)
+  ret result: (bits[8][4], bits[8][4], bits[8], bits[8]) = tuple(map.7, map.8, counted_for.9, counted_for.10)
+}
+)"));
+  EXPECT_THAT(DeduplicateFunctions(p.get()), IsOkAndHolds(true));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * inc_0, p->GetFunction("inc_0"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * body_0, p->GetFunction("body_0"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * main, p->GetFunction("main"));
+  Node* result = main->return_value();
+  EXPECT_EQ(result->operand(0)->As<Map>()->to_apply(), inc_0);
+  EXPECT_EQ(result->operand(1)->As<Map>()->to_apply(), inc_0);
+  EXPECT_EQ(result->operand(2)->As<CountedFor>()->body(), body_0);
+  EXPECT_EQ(result->operand(3)->As<CountedFor>()->body(), body_0);
+  EXPECT_EQ(result->operand(3)->As<CountedFor>()->trip_count(), 4);
+
+  // Nothing is left to merge.
+  EXPECT_THAT(DeduplicateFunctions(p.get()), IsOkAndHolds(false));
+}
+
+TEST_F(FunctionDeduplicationTest, KeepsDifferentFunctions) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
+package test
+
+fn shl_by_1(x: bits[8]) -> bits[8] {
+  literal.1: bits[8] = literal(value=1)
+  ret shll.2: bits[8] = shll(x, literal.1)
+}
+
+fn shl_by_2(x: bits[8]) -> bits[8] {
+  literal.3: bits[8] = literal(value=2)
+  ret shll.4: bits[8] = shll(x, literal.3)
+}
+
+fn wide(x: bits[16]) -> bits[16] {
+  literal.5: bits[16] = literal(value=1)
+  ret shll.6: bits[16] = shll(x, literal.5)
+}
+
+top fn main(x: bits[8], y: bits[16]) -> (bits[8], bits[8], bits[16]) {
+  invoke.7: bits[8] = invoke(x, to_apply=shl_by_1)
+  invoke.8: bits[8] = invoke(x, to_apply=shl_by_2)
+  invoke.9: bits[16] = invoke(y, to_apply=wide)
+  ret result: (bits[8], bits[8], bits[16]) = tuple(invoke.7, invoke.8, invoke.9)
+}
+)"));
+  EXPECT_THAT(DeduplicateFunctions(p.get()), IsOkAndHolds(false));
+}
+
+}  // namespace
+}  // namespace xls
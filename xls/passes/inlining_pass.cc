@@ -34,6 +34,7 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/topo_sort.h"
+#include "xls/passes/function_deduplication.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -95,6 +96,19 @@ static bool IsInlineable(const Invoke* invoke) {
   return !invoke->to_apply()->ForeignFunctionData().has_value();
 }
 
+// Returns the number of invokes of each function in the package.
+absl::flat_hash_map<Function*, int64_t> GetInvokeCounts(Package* p) {
+  absl::flat_hash_map<Function*, int64_t> invoke_counts;
+  for (FunctionBase* f : p->GetFunctionBases()) {
+    for (Node* node : f->nodes()) {
+      if (node->Is<Invoke>()) {
+        ++invoke_counts[node->As<Invoke>()->to_apply()];
+      }
+    }
+  }
+  return invoke_counts;
+}
+
 // Inlines the node "invoke" by replacing it with the contents of the called
 // function.
 template <bool kCheckNoSubInvokes = true>
@@ -210,20 +224,50 @@ absl::StatusOr<bool> InliningPass::RunInternal(
     Package* p, const OptimizationPassOptions& options,
     PassResults* results) const {
   bool changed = false;
+  const std::optional<int64_t> max_callee_node_count =
+      options.max_inlined_callee_node_count;
+  absl::flat_hash_map<Function*, int64_t> invoke_counts;
+  if (max_callee_node_count.has_value()) {
+    // Invokes of large functions may be kept, so calls of identical functions
+    // are merged first so that one copy of each is kept rather than one per
+    // instantiation.
+    XLS_ASSIGN_OR_RETURN(changed, DeduplicateFunctions(p));
+    invoke_counts = GetInvokeCounts(p);
+  }
+  // Inlining a function called from a single site does not duplicate any
+  // nodes, so only the invokes of large functions called from several sites
+  // are kept.
+  auto should_inline = [&](Invoke* invoke) {
+    if (!IsInlineable(invoke)) {
+      return false;
+    }
+    if (!max_callee_node_count.has_value()) {
+      return true;
+    }
+    return invoke->to_apply()->node_count() <= *max_callee_node_count ||
+           invoke_counts.at(invoke->to_apply()) <= 1;
+  };
+
   // Inline all the invokes of each function where functions are processed in a
   // post order of the call graph (leaves first). This ensures that when a
-  // function Foo is inlined into its callsites, no invokes remain in Foo. This
-  // avoid duplicate work.
+  // function Foo is inlined into its callsites, no invokes remain in Foo (other
+  // than kept ones). This avoid duplicate work.
   int inline_count = 0;
   for (FunctionBase* f : FunctionsInPostOrder(p)) {
     // Create copy of nodes() because we will be adding and removing nodes
     // during inlining.
     std::vector<Node*> nodes(f->nodes().begin(), f->nodes().end());
     for (Node* node : nodes) {
-      if (node->Is<Invoke>() && IsInlineable(node->As<Invoke>())) {
+      if (!node->Is<Invoke>() || !should_inline(node->As<Invoke>())) {
+        continue;
+      }
+      if (max_callee_node_count.has_value()) {
+        XLS_RETURN_IF_ERROR(InlineInvoke</*kCheckNoSubInvokes=*/false>(
+            node->As<Invoke>(), inline_count++));
+      } else {
         XLS_RETURN_IF_ERROR(InlineInvoke(node->As<Invoke>(), inline_count++));
-        changed = true;
       }
+      changed = true;
     }
   }
   return changed;
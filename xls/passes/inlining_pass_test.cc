@@ -295,5 +295,58 @@ fn caller(the_token: token, x: bits[32]) -> (token, bits[32]) {
   }
 }
 
+TEST_F(InliningPassTest, KeepsInvokesOfLargeFunctionsCalledMoreThanOnce) {
+  const std::string kProgram = R"(
+package some_package
+
+fn big_0(x: bits[8], y: bits[8]) -> bits[8] {
+  add.1: bits[8] = add(x, y)
+  umul.2: bits[8] = umul(add.1, y)
+  ret sub.3: bits[8] = sub(umul.2, x)
+}
+
+fn big_1(a: bits[8], b: bits[8]) -> bits[8] {
+  add.4: bits[8] = add(a, b)
+  umul.5: bits[8] = umul(add.4, b)
+  ret sub.6: bits[8] = sub(umul.5, a)
+}
+
+fn big_once(x: bits[8], y: bits[8]) -> bits[8] {
+  add.7: bits[8] = add(x, y)
+  umul.8: bits[8] = umul(add.7, x)
+  ret sub.9: bits[8] = sub(umul.8, y)
+}
+
+fn small(x: bits[8]) -> bits[8] {
+  ret neg.10: bits[8] = neg(x)
+}
+
+top fn main(x: bits[8], y: bits[8]) -> bits[8][5] {
+  invoke.11: bits[8] = invoke(x, y, to_apply=big_0)
+  invoke.12: bits[8] = invoke(y, x, to_apply=big_1)
+  invoke.13: bits[8] = invoke(x, y, to_apply=big_once)
+  invoke.14: bits[8] = invoke(x, to_apply=small)
+  invoke.15: bits[8] = invoke(y, to_apply=small)
+  ret result: bits[8][5] = array(invoke.11, invoke.12, invoke.13, invoke.14, invoke.15)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto package, ParsePackage(kProgram));
+  OptimizationPassOptions options;
+  options.max_inlined_callee_node_count = 4;
+  PassResults results;
+  ASSERT_THAT(InliningPass().Run(package.get(), options, &results),
+              IsOkAndHolds(true));
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * big_0, package->GetFunction("big_0"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * main, package->GetFunction("main"));
+  EXPECT_THAT(main->return_value(),
+              m::Array(m::Invoke(m::Param("x"), m::Param("y")),
+                       m::Invoke(m::Param("y"), m::Param("x")),
+                       m::Sub(m::UMul(), m::Param("y")),
+                       m::Neg(m::Param("x")), m::Neg(m::Param("y"))));
+  EXPECT_EQ(main->return_value()->operand(0)->As<Invoke>()->to_apply(), big_0);
+  EXPECT_EQ(main->return_value()->operand(1)->As<Invoke>()->to_apply(), big_0);
+}
+
 }  // namespace
 }  // namespace xls
@@ -17,7 +17,6 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
@@ -26,6 +25,7 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
@@ -89,6 +89,106 @@ bool IsTriviallyDerived(Node* node, absl::flat_hash_set<Node*> ancestors) {
   return false;
 }
 
+// Bound on the number of nodes evaluated to convert one selector into a lookup
+// table, i.e., the number of values of its min cut times the size of the cone
+// between the min cut and the selector.
+constexpr int64_t kMaxLutEvaluations = int64_t{1} << 20;
+
+// The nodes computing a selector from the nodes of a cut, in topological order,
+// with everything known about them folded in: nodes with known values are
+// constants, and only the nodes which depend on the cut are evaluated. This is
+// extracted once for the selector and then evaluated for every value of the
+// cut.
+class SelectorCone {
+ public:
+  static absl::StatusOr<SelectorCone> Create(Node* selector,
+                                             absl::Span<Node* const> cut,
+                                             const QueryEngine& query_engine) {
+    SelectorCone cone;
+    absl::flat_hash_map<Node*, int64_t> slots;
+    auto add_slot = [&](Node* node, Value value) {
+      slots[node] = cone.initial_values_.size();
+      cone.initial_values_.push_back(std::move(value));
+    };
+    // The cut nodes come first, so callers can set their values by position.
+    for (Node* node : cut) {
+      XLS_RET_CHECK(!slots.contains(node));
+      add_slot(node, Value());
+    }
+
+    // Visit the nodes in post order, stopping at the cut and at known values.
+    std::vector<std::pair<Node*, bool>> stack = {{selector, false}};
+    while (!stack.empty()) {
+      auto [node, operands_done] = stack.back();
+      stack.pop_back();
+      if (slots.contains(node)) {
+        continue;
+      }
+      if (operands_done) {
+        Step step{.node = node};
+        step.operand_slots.reserve(node->operand_count());
+        for (Node* operand : node->operands()) {
+          step.operand_slots.push_back(slots.at(operand));
+        }
+        step.slot = cone.initial_values_.size();
+        add_slot(node, Value());
+        cone.steps_.push_back(std::move(step));
+        continue;
+      }
+      if (std::optional<Value> known_value = query_engine.KnownValue(node);
+          known_value.has_value()) {
+        add_slot(node, *std::move(known_value));
+        continue;
+      }
+      if (node->operand_count() == 0) {
+        return absl::InternalError(absl::StrFormat(
+            "Selector %s depends on %s, which is neither known nor in the cut",
+            selector->GetName(), node->GetName()));
+      }
+      stack.push_back({node, true});
+      for (Node* operand : node->operands()) {
+        if (!slots.contains(operand)) {
+          stack.push_back({operand, false});
+        }
+      }
+    }
+    cone.selector_slot_ = slots.at(selector);
+    return cone;
+  }
+
+  int64_t size() const { return steps_.size(); }
+
+  // Values to pass to Evaluate(), once the values of the cut nodes (the first
+  // elements, in order) are filled in.
+  const std::vector<Value>& initial_values() const { return initial_values_; }
+
+  // Returns the value of the selector, given `values` as initialized by
+  // initial_values() with the values of the cut filled in.
+  absl::StatusOr<Value> Evaluate(std::vector<Value>& values) const {
+    std::vector<Value> operands;
+    for (const Step& step : steps_) {
+      operands.clear();
+      for (int64_t slot : step.operand_slots) {
+        operands.push_back(values[slot]);
+      }
+      XLS_ASSIGN_OR_RETURN(values[step.slot],
+                           InterpretNode(step.node, operands));
+    }
+    return values[selector_slot_];
+  }
+
+ private:
+  struct Step {
+    Node* node;
+    std::vector<int64_t> operand_slots;
+    int64_t slot;
+  };
+
+  std::vector<Value> initial_values_;
+  std::vector<Step> steps_;
+  int64_t selector_slot_ = -1;
+};
+
 int64_t CaseCount(Select* select) {
   if (select->default_value().has_value()) {
     return select->cases().size() + 1;
@@ -204,27 +304,6 @@ absl::StatusOr<bool> MaybeMergeLutIntoSelects(
     }
   }
 
-  // Populate an interpreter with all known values that feed into the
-  // selector.
-  IrInterpreter base_interpreter;
-  std::vector<Node*> to_visit({selector});
-  absl::flat_hash_set<Node*> visited;
-  while (!to_visit.empty()) {
-    Node* n = to_visit.back();
-    to_visit.pop_back();
-    if (visited.contains(n) || base_interpreter.IsVisited(n)) {
-      continue;
-    }
-    if (std::optional<Value> known_value = query_engine.KnownValue(n);
-        known_value.has_value()) {
-      XLS_RETURN_IF_ERROR(base_interpreter.SetValueResult(n, *known_value));
-      base_interpreter.MarkVisited(n);
-    } else {
-      absl::c_copy(n->operands(), std::back_inserter(to_visit));
-      visited.insert(n);
-    }
-  }
-
   std::vector<std::vector<Value>> cut_values(min_cut.size());
   for (size_t i = 0; i < min_cut.size(); ++i) {
     XLS_ASSIGN_OR_RETURN(cut_values[i],
@@ -240,46 +319,31 @@ absl::StatusOr<bool> MaybeMergeLutIntoSelects(
     values_radix.push_back(cut_value.size());
   }
 
+  XLS_ASSIGN_OR_RETURN(SelectorCone cone,
+                       SelectorCone::Create(selector, min_cut, query_engine));
+  if (new_case_count * cone.size() > kMaxLutEvaluations) {
+    VLOG(3) << "Not converting " << selector->GetName() << "; evaluating its "
+            << cone.size() << "-node cone for all " << new_case_count
+            << " values of the min cut is too expensive";
+    return false;
+  }
+
   std::vector<Bits> new_case_sequence;
   new_case_sequence.reserve(new_case_count);
+  std::vector<Value> values = cone.initial_values();
   absl::Status status = absl::OkStatus();
   MixedRadixIterate(
       values_radix, [&](const std::vector<int64_t>& value_indices) {
-        // Invoke an interpreter using known values & these values on the
-        // min-cut to compute the value of the selector.
-        IrInterpreter interpreter = base_interpreter;
         for (size_t i = 0; i < value_indices.size(); ++i) {
-          Node* cut_node = min_cut[i];
-          int64_t value_index = value_indices[i];
-          const Value& cut_value = cut_values[i][value_index];
-          if (interpreter.IsVisited(cut_node)) {
-            // It seems this cut node is actually fully-known!
-            if (const Value& resolved_value =
-                    interpreter.ResolveAsValue(cut_node);
-                resolved_value != cut_value) {
-              status.Update(absl::InternalError(absl::StrFormat(
-                  "Cut node %s has different value in interpreter (%s) than "
-                  "expected (%s)",
-                  cut_node->ToString(), resolved_value.ToString(),
-                  cut_value.ToString())));
-              return true;
-            }
-          } else {
-            status.Update(interpreter.SetValueResult(cut_node, cut_value));
-            if (!status.ok()) {
-              return true;
-            }
-            interpreter.MarkVisited(cut_node);
-          }
+          values[i] = cut_values[i][value_indices[i]];
         }
-        status.Update(selector->Accept(&interpreter));
-        if (!status.ok()) {
+        absl::StatusOr<Value> selector_value = cone.Evaluate(values);
+        if (!selector_value.ok()) {
+          status = selector_value.status();
           return true;
         }
-
-        Value selector_value = interpreter.ResolveAsValue(selector);
-        CHECK(selector_value.IsBits());
-        new_case_sequence.push_back(std::move(selector_value).bits());
+        CHECK(selector_value->IsBits());
+        new_case_sequence.push_back(std::move(selector_value).value().bits());
         return false;
       });
   XLS_RETURN_IF_ERROR(status);
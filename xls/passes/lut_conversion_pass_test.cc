@@ -14,13 +14,19 @@
 
 #include "xls/passes/lut_conversion_pass.h"
 
+#include <cstdint>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
 #include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
 #include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
@@ -207,5 +213,26 @@ TEST_F(LutConversionPassTest, ComplexExample) {
                                         m::Literal(0), m::Literal(0)}));
 }
 
+TEST_F(LutConversionPassTest, WideSelector) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(10));
+  std::vector<BValue> cases;
+  for (int64_t i = 0; i < 1024; ++i) {
+    cases.push_back(fb.Literal(UBits(i, 10)));
+  }
+  fb.Select(fb.Add(x, x), cases);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  EXPECT_THAT(Run(p.get()), IsOkAndHolds(true));
+  ASSERT_THAT(f->return_value(), m::Select());
+  Select* select = f->return_value()->As<Select>();
+  EXPECT_THAT(select->selector(), m::Param("x"));
+  ASSERT_EQ(select->cases().size(), 1024);
+  for (int64_t i : {0, 1, 511, 512, 1023}) {
+    EXPECT_THAT(select->get_case(i), m::Literal((2 * i) % 1024));
+  }
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,165 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/node_reachability_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/topo_sort.h"
+
+namespace xls {
+
+/* static */ NodeReachabilityIndex NodeReachabilityIndex::Create(
+    FunctionBase* f, int64_t label_count, uint64_t seed) {
+  CHECK_GT(label_count, 0);
+  NodeReachabilityIndex index(label_count);
+  std::vector<Node*> order = TopoSort(f);
+  int32_t node_count = static_cast<int32_t>(order.size());
+  index.node_indices_.reserve(node_count);
+  for (int32_t i = 0; i < node_count; ++i) {
+    index.node_indices_[order[i]] = i;
+  }
+  index.user_offsets_.reserve(node_count + 1);
+  index.user_offsets_.push_back(0);
+  for (Node* node : order) {
+    for (Node* user : node->users()) {
+      index.users_.push_back(index.node_indices_.at(user));
+    }
+    index.user_offsets_.push_back(static_cast<int32_t>(index.users_.size()));
+  }
+
+  // Each label is computed by a post-order traversal of the user graph which
+  // starts from the nodes in random order and visits the users of each node
+  // from a random rotation. The rank of a node is its post-order number and
+  // its low is the smallest rank among the nodes it reaches.
+  index.labels_.resize(node_count * label_count);
+  std::mt19937_64 rng(seed);
+  std::vector<int32_t> roots(node_count);
+  std::iota(roots.begin(), roots.end(), 0);
+  std::vector<bool> visited;
+  struct Frame {
+    int32_t node;
+    int32_t offset;
+    int32_t next;
+  };
+  std::vector<Frame> stack;
+  for (int64_t label = 0; label < label_count; ++label) {
+    std::shuffle(roots.begin(), roots.end(), rng);
+    visited.assign(node_count, false);
+    int32_t rank = 0;
+    auto push = [&](int32_t node) {
+      visited[node] = true;
+      int32_t user_count =
+          index.user_offsets_[node + 1] - index.user_offsets_[node];
+      int32_t offset =
+          user_count == 0
+              ? 0
+              : std::uniform_int_distribution<int32_t>(0, user_count - 1)(rng);
+      stack.push_back(Frame{.node = node, .offset = offset, .next = 0});
+    };
+    for (int32_t root : roots) {
+      if (visited[root]) {
+        continue;
+      }
+      push(root);
+      while (!stack.empty()) {
+        Frame& frame = stack.back();
+        int32_t begin = index.user_offsets_[frame.node];
+        int32_t user_count = index.user_offsets_[frame.node + 1] - begin;
+        if (frame.next < user_count) {
+          int32_t user =
+              index.users_[begin + (frame.offset + frame.next) % user_count];
+          ++frame.next;
+          if (!visited[user]) {
+            push(user);
+          }
+          continue;
+        }
+        Interval& interval = index.labels_[frame.node * label_count + label];
+        interval.rank = rank++;
+        interval.low = interval.rank;
+        for (int32_t i = begin; i < begin + user_count; ++i) {
+          interval.low = std::min(
+              interval.low,
+              index.labels_[index.users_[i] * label_count + label].low);
+        }
+        stack.pop_back();
+      }
+    }
+  }
+  return index;
+}
+
+bool NodeReachabilityIndex::Excludes(int64_t from, int64_t to) const {
+  // Users always come after their operands in the topological order.
+  if (from >= to) {
+    return true;
+  }
+  for (int64_t label = 0; label < label_count_; ++label) {
+    if (!labels_[from * label_count_ + label].Contains(
+            labels_[to * label_count_ + label])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+absl::StatusOr<bool> NodeReachabilityIndex::IsReachable(Node* from,
+                                                        Node* to) const {
+  auto from_it = node_indices_.find(from);
+  auto to_it = node_indices_.find(to);
+  if (from_it == node_indices_.end() || to_it == node_indices_.end()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "%s is not in the indexed function base",
+        (from_it == node_indices_.end() ? from : to)->GetName()));
+  }
+  int32_t source = from_it->second;
+  int32_t target = to_it->second;
+  if (source == target) {
+    return true;
+  }
+  if (Excludes(source, target)) {
+    return false;
+  }
+  std::vector<int32_t> worklist = {source};
+  absl::flat_hash_set<int32_t> visited = {source};
+  while (!worklist.empty()) {
+    int32_t node = worklist.back();
+    worklist.pop_back();
+    for (int32_t i = user_offsets_[node]; i < user_offsets_[node + 1]; ++i) {
+      int32_t user = users_[i];
+      if (user == target) {
+        return true;
+      }
+      if (!Excludes(user, target) && visited.insert(user).second) {
+        worklist.push_back(user);
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace xls
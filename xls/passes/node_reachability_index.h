@@ -0,0 +1,92 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_NODE_REACHABILITY_INDEX_H_
+#define XLS_PASSES_NODE_REACHABILITY_INDEX_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+
+namespace xls {
+
+// Index answering whether one node of a function base transitively feeds
+// another, using memory linear in the number of nodes. It answers the same
+// queries as NodeDependencyAnalysis::ForwardDependents(f) without
+// materializing a bitmap over all nodes for every node, which is quadratic.
+//
+// Each node is labeled with its position in a topological order and with
+// `label_count` GRAIL intervals [low, rank] computed from randomized
+// post-order traversals of the user graph: if `from` reaches `to` then every
+// interval of `to` is contained in the corresponding interval of `from`. Most
+// negative queries are answered by these checks in constant time; the rest,
+// and all positive ones, fall back to a depth-first search over users which is
+// pruned by the same labels.
+//
+// The index is a snapshot: it must be rebuilt after the function is modified.
+class NodeReachabilityIndex {
+ public:
+  static constexpr int64_t kDefaultLabelCount = 2;
+
+  // Builds the index of `f`. The traversals used to build the labels are
+  // seeded by `seed` so the index is deterministic.
+  static NodeReachabilityIndex Create(
+      FunctionBase* f, int64_t label_count = kDefaultLabelCount,
+      uint64_t seed = 0);
+
+  NodeReachabilityIndex(NodeReachabilityIndex&&) = default;
+  NodeReachabilityIndex& operator=(NodeReachabilityIndex&&) = default;
+
+  // Returns whether a change in `from` could cause a change in `to`, that is
+  // whether `to` is `from` or transitively uses it. Returns an error if either
+  // node is not part of the indexed function base.
+  absl::StatusOr<bool> IsReachable(Node* from, Node* to) const;
+
+  int64_t label_count() const { return label_count_; }
+
+ private:
+  struct Interval {
+    int32_t low;
+    int32_t rank;
+
+    bool Contains(const Interval& other) const {
+      return low <= other.low && other.rank <= rank;
+    }
+  };
+
+  explicit NodeReachabilityIndex(int64_t label_count)
+      : label_count_(label_count) {}
+
+  // Returns whether the labels of the node with index `from` rule out reaching
+  // the node with index `to`.
+  bool Excludes(int64_t from, int64_t to) const;
+
+  int64_t label_count_;
+  // Dense index of every node; also its position in a topological order.
+  absl::flat_hash_map<Node*, int32_t> node_indices_;
+  // Users of the node with dense index `i`, by dense index, are
+  // users_[user_offsets_[i]] to users_[user_offsets_[i + 1]] (exclusive).
+  std::vector<int32_t> user_offsets_;
+  std::vector<int32_t> users_;
+  // `label_count_` consecutive intervals per node, by dense index.
+  std::vector<Interval> labels_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_NODE_REACHABILITY_INDEX_H_
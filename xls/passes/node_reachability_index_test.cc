@@ -0,0 +1,115 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/node_reachability_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+#include "xls/passes/node_dependency_analysis.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+
+class NodeReachabilityIndexTest : public IrTestBase {};
+
+TEST_F(NodeReachabilityIndexTest, Basic) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue a = fb.Param("a", p->GetBitsType(8));
+  BValue b = fb.Param("b", p->GetBitsType(8));
+  BValue c = fb.Param("c", p->GetBitsType(8));
+  BValue ab = fb.Add(a, b);
+  BValue bc = fb.Add(b, c);
+  BValue out = fb.Tuple({ab, bc});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  NodeReachabilityIndex index = NodeReachabilityIndex::Create(f);
+  EXPECT_THAT(index.IsReachable(a.node(), a.node()), IsOkAndHolds(true));
+  EXPECT_THAT(index.IsReachable(a.node(), ab.node()), IsOkAndHolds(true));
+  EXPECT_THAT(index.IsReachable(a.node(), out.node()), IsOkAndHolds(true));
+  EXPECT_THAT(index.IsReachable(a.node(), bc.node()), IsOkAndHolds(false));
+  EXPECT_THAT(index.IsReachable(ab.node(), a.node()), IsOkAndHolds(false));
+  EXPECT_THAT(index.IsReachable(ab.node(), bc.node()), IsOkAndHolds(false));
+  EXPECT_THAT(index.IsReachable(b.node(), bc.node()), IsOkAndHolds(true));
+}
+
+TEST_F(NodeReachabilityIndexTest, NodeFromOtherFunction) {
+  auto p = CreatePackage();
+  FunctionBuilder fb1("f1", p.get());
+  BValue x = fb1.Param("x", p->GetBitsType(8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f1, fb1.Build());
+  FunctionBuilder fb2("f2", p.get());
+  BValue y = fb2.Param("y", p->GetBitsType(8));
+  XLS_ASSERT_OK(fb2.Build().status());
+
+  NodeReachabilityIndex index = NodeReachabilityIndex::Create(f1);
+  EXPECT_THAT(index.IsReachable(x.node(), y.node()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(NodeReachabilityIndexTest, MatchesDependencyAnalysis) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  std::mt19937_64 rng(42);
+  std::vector<BValue> values;
+  for (int64_t i = 0; i < 8; ++i) {
+    values.push_back(fb.Literal(UBits(i, 8)));
+  }
+  for (int64_t i = 0; i < 200; ++i) {
+    // Mostly pick recent values so the graph has long paths as well as
+    // disconnected regions.
+    auto pick = [&]() {
+      int64_t window = std::min<int64_t>(values.size(), 16);
+      return values[values.size() - 1 -
+                    std::uniform_int_distribution<int64_t>(0, window - 1)(
+                        rng)];
+    };
+    values.push_back(i % 7 == 0 ? fb.Add(values[rng() % values.size()], pick())
+                                : fb.Xor(pick(), pick()));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  NodeDependencyAnalysis nda = NodeDependencyAnalysis::ForwardDependents(f);
+  for (int64_t label_count : {1, 2, 4}) {
+    NodeReachabilityIndex index =
+        NodeReachabilityIndex::Create(f, label_count, /*seed=*/label_count);
+    for (Node* from : f->nodes()) {
+      for (Node* to : f->nodes()) {
+        XLS_ASSERT_OK_AND_ASSIGN(bool expected, nda.IsDependent(from, to));
+        EXPECT_THAT(index.IsReachable(from, to), IsOkAndHolds(expected))
+            << from->GetName() << " -> " << to->GetName();
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace xls
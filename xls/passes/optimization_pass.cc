@@ -14,28 +14,44 @@
 
 #include "xls/passes/optimization_pass.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/math_util.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
+#include "xls/ir/call_graph.h"
+#include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/ram_rewrite.pb.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/ir/value_utils.h"
 #include "xls/passes/pass_base.h"
 
 namespace xls {
@@ -95,12 +111,55 @@ absl::StatusOr<RamKind> RamKindFromProto(RamKindProto proto) {
   };
 }
 
+std::string_view RamBankingSchemeToString(RamBankingScheme scheme) {
+  switch (scheme) {
+    case RamBankingScheme::kAuto:
+      return "auto";
+    case RamBankingScheme::kInterleaved:
+      return "interleaved";
+    case RamBankingScheme::kBlock:
+      return "block";
+  }
+}
+
+/* static */ absl::StatusOr<RamBanking> RamBanking::FromProto(
+    const RamBankingProto& proto) {
+  RamBankingScheme scheme;
+  switch (proto.scheme()) {
+    case RamBankingSchemeProto::RAM_BANKING_AUTO:
+      scheme = RamBankingScheme::kAuto;
+      break;
+    case RamBankingSchemeProto::RAM_BANKING_INTERLEAVED:
+      scheme = RamBankingScheme::kInterleaved;
+      break;
+    case RamBankingSchemeProto::RAM_BANKING_BLOCK:
+      scheme = RamBankingScheme::kBlock;
+      break;
+    default:
+      return absl::InvalidArgumentError("Invalid RamBankingScheme");
+  }
+  if (proto.bank_count() < 2 || !IsPowerOfTwo(proto.bank_count())) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "RAM bank count must be a power of two greater than one, got %d",
+        proto.bank_count()));
+  }
+  return RamBanking{.scheme = scheme, .bank_count = proto.bank_count()};
+}
+
+std::string RamBankNamePrefix(std::string_view to_name_prefix, int64_t bank) {
+  return absl::StrCat(to_name_prefix, "_bank", bank);
+}
+
 /* static */ absl::StatusOr<RamRewrite> RamRewrite::FromProto(
     const RamRewriteProto& proto) {
   XLS_ASSIGN_OR_RETURN(RamConfig from_config,
                        RamConfig::FromProto(proto.from_config()));
   XLS_ASSIGN_OR_RETURN(RamConfig to_config,
                        RamConfig::FromProto(proto.to_config()));
+  std::optional<RamBanking> banking;
+  if (proto.has_banking()) {
+    XLS_ASSIGN_OR_RETURN(banking, RamBanking::FromProto(proto.banking()));
+  }
   return RamRewrite{
       .from_config = from_config,
       .from_channels_logical_to_physical =
@@ -112,6 +171,7 @@ absl::StatusOr<RamKind> RamKindFromProto(RamKindProto proto) {
       .proc_name = proto.has_proc_name()
                        ? std::optional<std::string>(proto.proc_name())
                        : std::nullopt,
+      .banking = banking,
   };
 }
 
@@ -147,12 +207,240 @@ absl::StatusOr<bool> OptimizationFunctionBasePass::RunOnFunctionBase(
 absl::StatusOr<bool> OptimizationFunctionBasePass::RunInternal(
     Package* p, const OptimizationPassOptions& options,
     PassResults* results) const {
-  bool changed = false;
+  std::vector<FunctionBase*> sequential;
+  std::vector<FunctionBase*> concurrent;
+  if (options.function_base_parallelism > 1) {
+    // Passes may look into the function bases called by the function base
+    // they run on (e.g., to interpret an invoke), so only function bases which
+    // are not part of any call are safe to run on concurrently.
+    absl::flat_hash_set<FunctionBase*> in_calls;
+    for (FunctionBase* f : p->GetFunctionBases()) {
+      std::vector<FunctionBase*> dependencies = GetDependentFunctions(f);
+      if (dependencies.size() > 1) {
+        in_calls.insert(dependencies.begin(), dependencies.end());
+      }
+    }
+    for (FunctionBase* f : p->GetFunctionBases()) {
+      if (f->IsBlock() || in_calls.contains(f)) {
+        sequential.push_back(f);
+      } else {
+        concurrent.push_back(f);
+      }
+    }
+  } else {
+    sequential = p->GetFunctionBases();
+  }
+
+  // A run of the pass on `f` may be skipped if it previously made no change
+  // and neither `f` nor any function base it calls has changed since.
+  absl::flat_hash_map<int64_t, FunctionBase*> function_bases_by_uid;
   for (FunctionBase* f : p->GetFunctionBases()) {
+    function_bases_by_uid[f->uid()] = f;
+  }
+  auto is_known_no_op = [&](FunctionBase* f) {
+    auto it = results->no_op_runs.find({this, f->uid()});
+    if (it == results->no_op_runs.end()) {
+      return false;
+    }
+    return absl::c_all_of(
+        it->second.versions, [&](const std::pair<int64_t, int64_t>& version) {
+          auto dependency = function_bases_by_uid.find(version.first);
+          return dependency != function_bases_by_uid.end() &&
+                 dependency->second->version() == version.second;
+        });
+  };
+  // Not every change a pass can make is recorded per node, so the version is
+  // incremented explicitly when the pass reports a change.
+  auto record_run = [&](FunctionBase* f, bool function_changed) {
+    if (function_changed) {
+      f->IncrementVersion();
+      return;
+    }
+    FunctionBaseNoOpRun& run = results->no_op_runs[{this, f->uid()}];
+    run.versions.clear();
+    for (FunctionBase* dependency : GetDependentFunctions(f)) {
+      run.versions.push_back({dependency->uid(), dependency->version()});
+    }
+  };
+  auto skip = [&](FunctionBase* f) {
+    if (!is_known_no_op(f)) {
+      return false;
+    }
+    VLOG(2) << absl::StreamFormat(
+        "Skipping %s on %s, it made no change since it was last run there.",
+        short_name(), f->name());
+    return true;
+  };
+  std::erase_if(concurrent, skip);
+
+  // Runs the pass on `f` and records the run in the profile, if any.
+  auto run_on_function_base =
+      [&](FunctionBase* f, int64_t thread,
+          std::optional<PassBudgetEvent>& budget_event) -> absl::StatusOr<bool> {
+    if (results->profile == nullptr) {
+      return RunOnFunctionBaseWithinBudget(f, options, results, budget_event);
+    }
+    TransformMetrics before_metrics = f->transform_metrics();
+    absl::Time start = absl::Now();
+    XLS_ASSIGN_OR_RETURN(
+        bool function_changed,
+        RunOnFunctionBaseWithinBudget(f, options, results, budget_event));
+    results->profile->AddFunctionBaseRun(
+        short_name(), f->name(), thread, start, absl::Now() - start,
+        function_changed, f->transform_metrics() - before_metrics);
+    return function_changed;
+  };
+
+  bool changed = false;
+  for (FunctionBase* f : sequential) {
+    if (skip(f)) {
+      continue;
+    }
+    std::optional<PassBudgetEvent> budget_event;
     XLS_ASSIGN_OR_RETURN(bool function_changed,
-                         RunOnFunctionBaseInternal(f, options, results));
+                         run_on_function_base(f, /*thread=*/0, budget_event));
+    if (budget_event.has_value()) {
+      results->budget_events.push_back(*std::move(budget_event));
+    }
+    record_run(f, function_changed);
     changed = changed || function_changed;
   }
+  if (concurrent.empty()) {
+    return changed;
+  }
+
+  std::vector<absl::StatusOr<bool>> concurrent_results(concurrent.size(),
+                                                       false);
+  std::vector<std::optional<PassBudgetEvent>> budget_events(concurrent.size());
+  std::atomic<int64_t> next_index = 0;
+  auto worker = [&](int64_t thread) {
+    for (int64_t i = next_index++; i < concurrent.size(); i = next_index++) {
+      concurrent_results[i] =
+          run_on_function_base(concurrent[i], thread, budget_events[i]);
+    }
+  };
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    int64_t thread_count = std::min<int64_t>(options.function_base_parallelism,
+                                             concurrent.size());
+    for (int64_t i = 0; i < thread_count; ++i) {
+      threads.push_back(
+          std::make_unique<Thread>([&worker, i]() { worker(i + 1); }));
+    }
+    // Threads are joined on destruction.
+  }
+  for (int64_t i = 0; i < concurrent.size(); ++i) {
+    XLS_RETURN_IF_ERROR(concurrent_results[i].status());
+    changed = changed || *concurrent_results[i];
+    if (budget_events[i].has_value()) {
+      results->budget_events.push_back(*std::move(budget_events[i]));
+    }
+    record_run(concurrent[i], *concurrent_results[i]);
+  }
+  return changed;
+}
+
+namespace {
+
+// Replaces the body of `f` with that of `snapshot`, a clone of `f` made before
+// it was changed.
+absl::Status RestoreFunction(Function* f, Function* snapshot) {
+  XLS_RET_CHECK_EQ(f->params().size(), snapshot->params().size());
+  for (int64_t i = 0; i < f->params().size(); ++i) {
+    XLS_RET_CHECK(f->param(i)->GetType()->IsEqualTo(
+        snapshot->param(i)->GetType()));
+  }
+
+  // Return a placeholder while every node other than the parameters is
+  // removed, as the return value cannot be removed.
+  XLS_ASSIGN_OR_RETURN(
+      Node * placeholder,
+      f->MakeNode<Literal>(SourceInfo(),
+                           ZeroOfType(f->return_value()->GetType())));
+  XLS_RETURN_IF_ERROR(f->set_return_value(placeholder));
+  for (Node* node : ReverseTopoSort(f)) {
+    if (node != placeholder && !node->Is<Param>()) {
+      XLS_RETURN_IF_ERROR(f->RemoveNode(node));
+    }
+  }
+
+  absl::flat_hash_map<Node*, Node*> restored;
+  for (int64_t i = 0; i < f->params().size(); ++i) {
+    restored[snapshot->param(i)] = f->param(i);
+  }
+  for (Node* node : TopoSort(snapshot)) {
+    if (node->Is<Param>()) {
+      continue;
+    }
+    std::vector<Node*> operands;
+    operands.reserve(node->operand_count());
+    for (Node* operand : node->operands()) {
+      operands.push_back(restored.at(operand));
+    }
+    XLS_ASSIGN_OR_RETURN(restored[node], node->CloneInNewFunction(operands, f));
+  }
+  XLS_RETURN_IF_ERROR(
+      f->set_return_value(restored.at(snapshot->return_value())));
+  return f->RemoveNode(placeholder);
+}
+
+}  // namespace
+
+absl::StatusOr<bool> OptimizationFunctionBasePass::RunOnFunctionBaseWithinBudget(
+    FunctionBase* f, const OptimizationPassOptions& options,
+    PassResults* results, std::optional<PassBudgetEvent>& budget_event) const {
+  if (!options.pass_time_budget.has_value() &&
+      !options.pass_node_budget.has_value()) {
+    return RunOnFunctionBaseInternal(f, options, results);
+  }
+  if (results->ExceededBudget(short_name(), f->name())) {
+    VLOG(1) << absl::StreamFormat(
+        "Skipping %s on %s, it previously exceeded its budget there.",
+        short_name(), f->name());
+    return false;
+  }
+
+  // Functions are cloned into a scratch package so that the changes can be
+  // discarded. Procs and blocks are not, so passes exceeding their budget on
+  // them keep their changes.
+  std::unique_ptr<Package> snapshot_package;
+  Function* snapshot = nullptr;
+  if (f->IsFunction()) {
+    snapshot_package = std::make_unique<Package>(f->package()->name());
+    XLS_ASSIGN_OR_RETURN(snapshot, f->AsFunctionOrDie()->Clone(
+                                       f->name(), snapshot_package.get()));
+  }
+
+  int64_t node_count_before = f->node_count();
+  absl::Time start = absl::Now();
+  XLS_ASSIGN_OR_RETURN(bool changed,
+                       RunOnFunctionBaseInternal(f, options, results));
+  absl::Duration duration = absl::Now() - start;
+  int64_t nodes_added = f->node_count() - node_count_before;
+  if ((!options.pass_time_budget.has_value() ||
+       duration <= *options.pass_time_budget) &&
+      (!options.pass_node_budget.has_value() ||
+       nodes_added <= *options.pass_node_budget)) {
+    return changed;
+  }
+
+  budget_event = PassBudgetEvent{.pass_name = short_name(),
+                                 .function_base_name = f->name(),
+                                 .run_duration = duration,
+                                 .nodes_added = nodes_added,
+                                 .rolled_back = false};
+  if (changed && snapshot != nullptr) {
+    XLS_RETURN_IF_ERROR(RestoreFunction(f->AsFunctionOrDie(), snapshot));
+    budget_event->rolled_back = true;
+  }
+  LOG(WARNING) << absl::StreamFormat(
+      "Pass %s exceeded its budget on %s (%s, %d nodes added)%s; it will not "
+      "be run on %s again.",
+      short_name(), f->name(), absl::FormatDuration(duration), nodes_added,
+      budget_event->rolled_back ? " and its changes were discarded" : "",
+      f->name());
+  // Even when rolled back the function was rebuilt (with new node ids), so it
+  // is reported as changed.
   return changed;
 }
 
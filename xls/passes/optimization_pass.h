@@ -43,6 +43,8 @@
 
 namespace xls {
 
+class AnalysisManager;
+
 inline constexpr int64_t kMaxOptLevel = 3;
 
 // Metadata for RAMs.
@@ -78,6 +80,33 @@ struct RamConfig {
   static absl::StatusOr<RamConfig> FromProto(const RamConfigProto& proto);
 };
 
+// How the addresses of a RAM are distributed among its banks.
+enum class RamBankingScheme {
+  // Interleaved or block, as suggested by the addresses the procs send.
+  kAuto,
+  // Bank `addr % bank_count`, address `addr / bank_count` within it.
+  kInterleaved,
+  // Bank `addr / depth`, address `addr % depth` within it, where `depth` is
+  // the depth of a bank.
+  kBlock,
+};
+
+std::string_view RamBankingSchemeToString(RamBankingScheme scheme);
+
+// Configuration describing how to split a RAM into banks which can each be
+// accessed independently.
+struct RamBanking {
+  RamBankingScheme scheme;
+  // Must be a power of two greater than one.
+  int64_t bank_count;
+
+  static absl::StatusOr<RamBanking> FromProto(const RamBankingProto& proto);
+};
+
+// Returns the name prefix of the channels of bank `bank` of the RAM rewritten
+// to `to_name_prefix`.
+std::string RamBankNamePrefix(std::string_view to_name_prefix, int64_t bank);
+
 // A configuration describing a desired RAM rewrite.
 struct RamRewrite {
   // Configuration of RAM we start with.
@@ -95,6 +124,10 @@ struct RamRewrite {
   // defined in.
   std::optional<std::string> proc_name;
 
+  // If set, the RAM is split into `banking->bank_count` RAMs, each described by
+  // `to_config` and named with RamBankNamePrefix(to_name_prefix, bank).
+  std::optional<RamBanking> banking = std::nullopt;
+
   static absl::StatusOr<RamRewrite> FromProto(const RamRewriteProto& proto);
 };
 
@@ -156,6 +189,46 @@ struct OptimizationPassOptions : public PassOptionsBase {
 
   // Use select context during narrowing range analysis.
   bool use_context_narrowing_analysis = false;
+
+  // If set, UnrollPass unrolls loops incrementally, about this many nodes at a
+  // time, simplifying the function between steps (see UnrollPass).
+  std::optional<int64_t> unroll_step_node_count = std::nullopt;
+
+  // If set along with `unroll_step_node_count`, UnrollPass leaves the remaining
+  // iterations of a loop rolled once a step of unrolling it grows the function
+  // by more than this many nodes per iteration after simplification. Loops left
+  // rolled must be unrolled by a later pass before codegen.
+  std::optional<int64_t> max_unrolled_iteration_growth = std::nullopt;
+
+  // If set, InliningPass keeps the invokes of functions with more than this
+  // many nodes which are called from more than one site, after merging the
+  // calls of identical functions (see DeduplicateFunctions). This bounds the
+  // growth of call-heavy designs. Kept invokes are supported by the JIT and the
+  // interpreters but not by codegen.
+  std::optional<int64_t> max_inlined_callee_node_count = std::nullopt;
+
+  // If non-null, analyses shared across the passes of the pipeline. Passes
+  // which support it get their query engines from here rather than building
+  // their own.
+  AnalysisManager* analysis_manager = nullptr;
+
+  // The maximum number of function bases which a function base pass (see
+  // OptimizationFunctionBasePass) runs on concurrently. Function bases which
+  // call or are called by another function base are always run on one at a
+  // time. Node ids, and so the names of unnamed nodes, depend on the order in
+  // which nodes are created and so are not deterministic if this is greater
+  // than one.
+  int64_t function_base_parallelism = 1;
+
+  // The maximum number of threads which a pass may use on the nodes of a
+  // single function base. Only some passes (e.g., CsePass) make use of this,
+  // and their results do not depend on it.
+  int64_t node_parallelism = 1;
+
+  // If true, VerifierChecker only re-verifies the functions which changed
+  // since its previous check (see VerifyPackageIncrementally). Whoever runs
+  // the pipeline should then verify the whole package once it is done.
+  bool incremental_verification = false;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -202,6 +275,10 @@ class DynamicCapOptLevel : public OptimizationPass {
     return res;
   }
 
+  bool RecordsChangesInVersions() const override {
+    return inner_.RecordsChangesInVersions();
+  }
+
  protected:
   absl::StatusOr<bool> RunInternal(Package* ir,
                                    const OptimizationPassOptions& options,
@@ -241,6 +318,10 @@ class DynamicIfOptLevelAtLeast : public OptimizationPass {
     return res;
   }
 
+  bool RecordsChangesInVersions() const override {
+    return inner_.RecordsChangesInVersions();
+  }
+
  protected:
   absl::StatusOr<bool> RunInternal(Package* ir,
                                    const OptimizationPassOptions& options,
@@ -330,17 +411,36 @@ class OptimizationFunctionBasePass : public OptimizationPass {
                                          const OptimizationPassOptions& options,
                                          PassResults* results) const;
 
+  // The version of a function base is incremented whenever the pass changes
+  // it.
+  bool RecordsChangesInVersions() const override { return true; }
+
  protected:
   // Iterates over each function and proc in the package calling
-  // RunOnFunctionBase.
+  // RunOnFunctionBase, on several function bases at once if
+  // `options.function_base_parallelism` allows it. Function bases on which the
+  // pass previously made no change are skipped if neither they nor any
+  // function base they call has changed since.
   absl::StatusOr<bool> RunInternal(Package* p,
                                    const OptimizationPassOptions& options,
                                    PassResults* results) const override;
 
+  // Runs the pass on `f`. May be called concurrently for different function
+  // bases which do not call each other, so implementations must not modify
+  // state shared between function bases other than through the (thread-safe)
+  // package type and node id allocation, and must not modify `results`.
   virtual absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const OptimizationPassOptions& options,
       PassResults* results) const = 0;
 
+  // Calls RunOnFunctionBaseInternal enforcing the pass time and node budgets
+  // of `options`. If the budget is exceeded, the changes are discarded (for
+  // functions) and `budget_event` is set. Runs which previously exceeded their
+  // budget on `f` are skipped.
+  absl::StatusOr<bool> RunOnFunctionBaseWithinBudget(
+      FunctionBase* f, const OptimizationPassOptions& options,
+      PassResults* results, std::optional<PassBudgetEvent>& budget_event) const;
+
   // Calls the given function for every node in the graph in a loop until no
   // further simplifications are possible.  simplify_f should return true if the
   // IR was modified. simplify_f can add or remove nodes including the node
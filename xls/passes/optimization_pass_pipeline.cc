@@ -32,6 +32,7 @@
 #include "xls/common/module_initializer.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/package.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/arith_simplification_pass.h"
 #include "xls/passes/array_simplification_pass.h"
 #include "xls/passes/array_untuple_pass.h"
@@ -139,6 +140,22 @@ void AddSimplificationPasses(OptimizationCompoundPass& pass) {
   pass.Add<DeadCodeEliminationPass>();
 }
 
+// Function base passes run by UnrollPass between steps of incremental
+// unrolling. These should be cheap as they are run many times per loop.
+std::vector<std::unique_ptr<OptimizationFunctionBasePass>>
+UnrollSimplificationPasses() {
+  std::vector<std::unique_ptr<OptimizationFunctionBasePass>> passes;
+  passes.push_back(std::make_unique<ConstantFoldingPass>());
+  passes.push_back(std::make_unique<DeadCodeEliminationPass>());
+  passes.push_back(std::make_unique<BasicSimplificationPass>());
+  passes.push_back(std::make_unique<ArithSimplificationPass>());
+  passes.push_back(std::make_unique<BitSliceSimplificationPass>());
+  passes.push_back(std::make_unique<ConcatSimplificationPass>());
+  passes.push_back(std::make_unique<CsePass>());
+  passes.push_back(std::make_unique<DeadCodeEliminationPass>());
+  return passes;
+}
+
 }  // namespace
 
 SimplificationPass::SimplificationPass()
@@ -168,7 +185,7 @@ PreInliningPassGroup::PreInliningPassGroup()
 UnrollingAndInliningPassGroup::UnrollingAndInliningPassGroup()
     : OptimizationCompoundPass(UnrollingAndInliningPassGroup::kName,
                                "full function inlining passes") {
-  Add<UnrollPass>();
+  Add<UnrollPass>(UnrollSimplificationPasses());
   Add<MapInliningPass>();
   Add<InliningPass>();
   Add<DeadFunctionEliminationPass>();
@@ -311,9 +328,12 @@ absl::StatusOr<bool> RunOptimizationPassPipeline(Package* package,
                                                  int64_t opt_level) {
   std::unique_ptr<OptimizationCompoundPass> pipeline =
       CreateOptimizationPassPipeline();
+  AnalysisManager analysis_manager;
+  OptimizationPassOptions options;
+  options.opt_level = opt_level;
+  options.analysis_manager = &analysis_manager;
   PassResults results;
-  return pipeline->Run(
-      package, OptimizationPassOptions().WithOptLevel(opt_level), &results);
+  return pipeline->Run(package, options, &results);
 }
 
 absl::Status OptimizationPassPipelineGenerator::AddPassToPipeline(
@@ -44,6 +44,7 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/package.h"
 #include "xls/passes/pass_pipeline.pb.h"
+#include "xls/passes/pass_profile.h"
 
 namespace xls {
 
@@ -70,6 +71,17 @@ struct PassOptionsBase {
   // number of passes executed might change due to setting this field as
   // fixed-points may complete earlier.
   std::optional<int64_t> bisect_limit;
+
+  // If present, the longest a pass may run on a single function or proc. A
+  // pass which exceeds this is not preempted, but its changes to that function
+  // are rolled back where possible and the pass is not run on it again. See
+  // OptimizationFunctionBasePass for which passes honor the budgets.
+  std::optional<absl::Duration> pass_time_budget;
+
+  // If present, the largest number of nodes a pass may add to a single
+  // function or proc. Exceeding it is handled like exceeding
+  // `pass_time_budget`.
+  std::optional<int64_t> pass_node_budget;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -85,11 +97,60 @@ struct PassInvocation {
   absl::Duration run_duration;
 };
 
+// A record of a pass exceeding its time or node budget on a function or proc.
+struct PassBudgetEvent {
+  // The short name of the pass.
+  std::string pass_name;
+
+  // The name of the function or proc the pass was run on.
+  std::string function_base_name;
+
+  // The run duration of the pass and the number of nodes it added.
+  absl::Duration run_duration;
+  int64_t nodes_added;
+
+  // Whether the changes made by the pass were discarded.
+  bool rolled_back;
+};
+
+// A run of a pass on a function base which made no change. Until one of the
+// function bases it depends on changes, running the pass again is a no-op.
+struct FunctionBaseNoOpRun {
+  // The uids and versions (see FunctionBase::version()) of the function base
+  // and of every function base it calls, directly or indirectly, at the time of
+  // the run.
+  std::vector<std::pair<int64_t, int64_t>> versions;
+};
+
 // A object to which metadata may be written in each pass invocation. This data
 // structure is passed by mutable pointer to PassBase::Run.
 struct PassResults {
   // This vector contains and entry for each invocation of each pass.
   std::vector<PassInvocation> invocations;
+
+  // An entry for each time a pass exceeded its budget on a function or proc.
+  // The pass is not run on that function or proc again.
+  std::vector<PassBudgetEvent> budget_events;
+
+  // If set, the run time and transformations of each pass are recorded here.
+  PassProfile* profile = nullptr;
+
+  // The runs of function base passes which made no change, keyed by the pass
+  // and the uid of the function base. Discarded whenever a pass whose changes
+  // are not all recorded in function base versions changes the IR (see
+  // PassBase::RecordsChangesInVersions).
+  absl::flat_hash_map<std::pair<const void*, int64_t>, FunctionBaseNoOpRun>
+      no_op_runs;
+
+  // Returns true if the given pass has exceeded its budget on the function or
+  // proc of the given name.
+  bool ExceededBudget(std::string_view pass_name,
+                      std::string_view function_base_name) const {
+    return absl::c_any_of(budget_events, [&](const PassBudgetEvent& event) {
+      return event.pass_name == pass_name &&
+             event.function_base_name == function_base_name;
+    });
+  }
 };
 
 // Base class for all compiler passes. Template parameters:
@@ -174,6 +235,12 @@ class PassBase {
   // Returns true if this is a compound pass.
   virtual bool IsCompound() const { return false; }
 
+  // Returns true if every change the pass makes to the IR is recorded in the
+  // version of the function base it is made to (see FunctionBase::version()).
+  // When any other pass changes the IR, the memoized no-op runs of function
+  // base passes are discarded as they may no longer be no-ops.
+  virtual bool RecordsChangesInVersions() const { return false; }
+
  protected:
   // Derived classes should override this function which is invoked from Run.
   virtual absl::StatusOr<bool> RunInternal(IrT* ir, const OptionsT& options,
@@ -196,6 +263,10 @@ class WrapperPassBase final : public PassBase<IrT, OptionsT, ResultsT> {
     return base_->ToProto();
   }
 
+  bool RecordsChangesInVersions() const final {
+    return base_->RecordsChangesInVersions();
+  }
+
  protected:
   absl::StatusOr<bool> RunInternal(IrT* ir, const OptionsT& options,
                                    ResultsT* results) const final {
@@ -237,6 +308,15 @@ class CompoundPassResult {
   bool changed() const { return changed_; }
   void set_changed(bool value) { changed_ = value; }
 
+  // The number of times the passes were run if this is the result of a fixed
+  // point compound pass.
+  std::optional<int64_t> fixed_point_iterations() const {
+    return fixed_point_iterations_;
+  }
+  void set_fixed_point_iterations(int64_t value) {
+    fixed_point_iterations_ = value;
+  }
+
   // Add the results of a single run of a pass.
   void AddSinglePassResult(std::string_view pass_name, bool changed,
                            absl::Duration duration,
@@ -249,6 +329,7 @@ class CompoundPassResult {
 
  private:
   bool changed_ = false;
+  std::optional<int64_t> fixed_point_iterations_;
 
   // Aggregate results for each pass. Indexed by short name.
   absl::flat_hash_map<std::string, SinglePassResult> pass_results_;
@@ -324,14 +405,29 @@ class CompoundPassBase : public PassBase<IrT, OptionsT, ResultsT> {
                                  "start",
                                  /*ordinal=*/0, /*changed=*/false));
     }
+    std::optional<int64_t> profile_index;
+    TransformMetrics before_metrics;
+    if (results->profile != nullptr) {
+      profile_index = results->profile->BeginPass(this->short_name(),
+                                                  /*compound=*/true);
+      before_metrics = ir->transform_metrics();
+    }
     XLS_ASSIGN_OR_RETURN(CompoundPassResult compound_result,
                          RunNested(ir, options, results, this->short_name(),
                                    /*invariant_checkers=*/{}));
+    if (profile_index.has_value()) {
+      results->profile->EndPass(*profile_index, compound_result.changed(),
+                                ir->transform_metrics() - before_metrics,
+                                compound_result.fixed_point_iterations());
+    }
     return compound_result.changed();
   }
 
   bool IsCompound() const override { return true; }
 
+  // The changes of the nested passes are accounted for as they are run.
+  bool RecordsChangesInVersions() const override { return true; }
+
  protected:
   // Internal implementation of Run for compound passes. Invoked when a compound
   // pass is nested within another compound pass. Enables passing of invariant
@@ -406,6 +502,7 @@ class FixedPointCompoundPassBase
         "Fixed point compound pass %s iterated %d times.", this->long_name(),
         iteration_count);
     XLS_VLOG_LINES(2, aggregate_result.ToString());
+    aggregate_result.set_fixed_point_iterations(iteration_count);
     return aggregate_result;
   }
 };
@@ -449,7 +546,7 @@ CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
                                   results->invocations.size(), ir->name());
 
     TransformMetrics before_metrics;
-    if (VLOG_IS_ON(1)) {
+    if (VLOG_IS_ON(1) || results->profile != nullptr) {
       before_metrics = ir->transform_metrics();
     }
 
@@ -473,8 +570,14 @@ CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
     // do not check it in optimized builds.
     std::string ir_before = ir->DumpIr();
 #endif
+    std::optional<int64_t> profile_index;
+    if (results->profile != nullptr) {
+      profile_index =
+          results->profile->BeginPass(pass->short_name(), pass->IsCompound());
+    }
     absl::Time start = absl::Now();
     bool pass_changed;
+    std::optional<int64_t> fixed_point_iterations;
     if (pass->IsCompound()) {
       XLS_ASSIGN_OR_RETURN(
           CompoundPassResult compound_result,
@@ -483,6 +586,7 @@ CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
           _ << "Running pass #" << results->invocations.size() << ": "
             << pass->long_name() << " [short: " << pass->short_name() << "]");
       pass_changed = compound_result.changed();
+      fixed_point_iterations = compound_result.fixed_point_iterations();
     } else {
       XLS_ASSIGN_OR_RETURN(pass_changed, pass->Run(ir, options, results));
     }
@@ -505,7 +609,14 @@ CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
     }
 #endif
     changed = changed || pass_changed;
+    if (pass_changed && !pass->RecordsChangesInVersions()) {
+      results->no_op_runs.clear();
+    }
     TransformMetrics pass_metrics = ir->transform_metrics() - before_metrics;
+    if (profile_index.has_value()) {
+      results->profile->EndPass(*profile_index, pass_changed, pass_metrics,
+                                fixed_point_iterations);
+    }
     VLOG(1) << absl::StreamFormat(
         "[elapsed %s] Pass %s %s.", FormatDuration(duration),
         pass->short_name(),
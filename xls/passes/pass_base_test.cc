@@ -14,15 +14,21 @@
 
 #include "xls/passes/pass_base.h"
 
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
@@ -39,16 +45,21 @@
 #include "xls/ir/value.h"
 #include "xls/passes/dce_pass.h"
 #include "xls/passes/optimization_pass.h"
+#include "xls/passes/pass_profile.h"
+#include "xls/passes/pass_profile.pb.h"
 
 namespace m = ::xls::op_matchers;
 namespace xls {
 namespace {
 
 using ::absl_testing::IsOk;
+using ::absl_testing::IsOkAndHolds;
+using ::testing::AllOf;
 using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::Field;
 using ::testing::IsEmpty;
+using ::testing::SizeIs;
 
 class PassBaseTest : public IrTestBase {};
 
@@ -120,6 +131,44 @@ class LevelUpPass : public OptimizationFunctionBasePass {
   }
 };
 
+// Counts its runs on each function base without changing anything.
+class CountRunsPass : public OptimizationFunctionBasePass {
+ public:
+  CountRunsPass() : OptimizationFunctionBasePass("count_runs", "Count runs") {}
+  ~CountRunsPass() override = default;
+
+  int64_t run_count(std::string_view name) const {
+    return run_counts_.contains(name) ? run_counts_.at(name) : 0;
+  }
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const OptimizationPassOptions& options,
+      PassResults* results) const override {
+    ++run_counts_[f->name()];
+    return false;
+  }
+
+ private:
+  mutable absl::flat_hash_map<std::string, int64_t> run_counts_;
+};
+
+// Renames the parameter of function `g`, which is not recorded in its version.
+class RenameParamPass : public OptimizationPass {
+ public:
+  RenameParamPass() : OptimizationPass("rename_param", "Rename param") {}
+  ~RenameParamPass() override = default;
+
+ protected:
+  absl::StatusOr<bool> RunInternal(Package* p,
+                                   const OptimizationPassOptions& options,
+                                   PassResults* results) const override {
+    XLS_ASSIGN_OR_RETURN(Function * g, p->GetFunction("g"));
+    g->param(0)->SetName("renamed");
+    return true;
+  }
+};
+
 auto DceInvoke() { return Field(&PassInvocation::pass_name, Eq("dce")); }
 auto LevelUpInvoke() {
   return Field(&PassInvocation::pass_name, Eq("level_up"));
@@ -289,5 +338,178 @@ TEST_F(PassBaseTest, BisectLimitZero) {
   EXPECT_THAT(results.invocations, IsEmpty());
 }
 
+TEST_F(PassBaseTest, RunOnFunctionBasesConcurrently) {
+  auto p = CreatePackage();
+  std::vector<Function*> functions;
+  for (int64_t i = 0; i < 16; ++i) {
+    FunctionBuilder fb(absl::StrCat(TestName(), i), p.get());
+    fb.Add(fb.Literal(UBits(i, 64)), fb.Param("x", p->GetBitsType(64)));
+    XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+    functions.push_back(f);
+  }
+  // A caller and callee are run on one at a time.
+  FunctionBuilder caller_fb("caller", p.get());
+  caller_fb.Add(caller_fb.Literal(UBits(100, 64)),
+                caller_fb.Invoke({caller_fb.Param("x", p->GetBitsType(64))},
+                                 functions.front()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * caller, caller_fb.Build());
+
+  LevelUpPass pass;
+  OptimizationPassOptions options;
+  options.function_base_parallelism = 4;
+  PassResults results;
+  EXPECT_THAT(pass.Run(p.get(), options, &results), IsOkAndHolds(true));
+  for (int64_t i = 0; i < functions.size(); ++i) {
+    EXPECT_THAT(functions[i]->return_value(),
+                m::Add(m::Literal(UBits(i + 1, 64)), m::Param("x")));
+  }
+  EXPECT_THAT(caller->return_value(),
+              m::Add(m::Literal(UBits(101, 64)), m::Invoke()));
+}
+
+TEST_F(PassBaseTest, NodeBudgetRollsBackFunction) {
+  auto p = CreatePackage();
+  FunctionBuilder small_fb("small", p.get());
+  small_fb.Add(small_fb.Literal(UBits(1, 64)),
+               small_fb.Param("x", p->GetBitsType(64)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * small, small_fb.Build());
+  FunctionBuilder big_fb("big", p.get());
+  BValue x = big_fb.Param("x", p->GetBitsType(64));
+  big_fb.Add(big_fb.Add(big_fb.Literal(UBits(1, 64)), x),
+             big_fb.Add(big_fb.Literal(UBits(2, 64)),
+                        big_fb.Literal(UBits(3, 64))));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * big, big_fb.Build());
+  int64_t big_node_count = big->node_count();
+
+  // The pass adds one literal per literal in the function, so it stays within
+  // the budget on `small` but not on `big`.
+  LevelUpPass pass;
+  OptimizationPassOptions options;
+  options.pass_node_budget = 1;
+  PassResults results;
+  EXPECT_THAT(pass.Run(p.get(), options, &results), IsOkAndHolds(true));
+  EXPECT_THAT(small->return_value(),
+              m::Add(m::Literal(UBits(2, 64)), m::Param("x")));
+  EXPECT_EQ(big->node_count(), big_node_count);
+  EXPECT_THAT(big->return_value(),
+              m::Add(m::Add(m::Literal(UBits(1, 64)), m::Param("x")),
+                     m::Add(m::Literal(UBits(2, 64)), m::Literal(UBits(3, 64)))));
+  EXPECT_THAT(
+      results.budget_events,
+      ElementsAre(AllOf(
+          Field(&PassBudgetEvent::pass_name, Eq("level_up")),
+          Field(&PassBudgetEvent::function_base_name, Eq("big")),
+          Field(&PassBudgetEvent::nodes_added, Eq(3)),
+          Field(&PassBudgetEvent::rolled_back, Eq(true)))));
+  EXPECT_TRUE(results.ExceededBudget("level_up", "big"));
+  EXPECT_FALSE(results.ExceededBudget("level_up", "small"));
+
+  // The pass is not run on `big` again, even with a budget it would fit in.
+  options.pass_node_budget = 100;
+  EXPECT_THAT(pass.Run(p.get(), options, &results), IsOkAndHolds(true));
+  EXPECT_THAT(small->return_value(),
+              m::Add(m::Literal(UBits(3, 64)), m::Param("x")));
+  EXPECT_EQ(big->node_count(), big_node_count);
+  EXPECT_EQ(results.budget_events.size(), 1);
+}
+
+TEST_F(PassBaseTest, NoOpRunsAreSkippedUntilFunctionChanges) {
+  auto p = CreatePackage();
+  FunctionBuilder fb("f", p.get());
+  fb.Literal(UBits(0, 2));
+  XLS_ASSERT_OK(fb.Build().status());
+  FunctionBuilder gb("g", p.get());
+  gb.Param("x", p->GetBitsType(8));
+  XLS_ASSERT_OK(gb.Build().status());
+  OptimizationFixedPointCompoundPass fixed("fixed", "fixed");
+  CountRunsPass* count_runs = fixed.Add<CountRunsPass>();
+  fixed.Add<LevelUpPass>();
+  fixed.Add<DeadCodeEliminationPass>();
+  PassResults results;
+  EXPECT_THAT(fixed.Run(p.get(), OptimizationPassOptions(), &results),
+              IsOkAndHolds(true));
+
+  // `f` changes in the first three of the four iterations; `g` never does.
+  EXPECT_EQ(count_runs->run_count("f"), 4);
+  EXPECT_EQ(count_runs->run_count("g"), 1);
+  EXPECT_THAT(results.invocations, SizeIs(12));
+
+  // Nothing has changed since, so every run is skipped.
+  EXPECT_THAT(fixed.Run(p.get(), OptimizationPassOptions(), &results),
+              IsOkAndHolds(false));
+  EXPECT_EQ(count_runs->run_count("f"), 4);
+  EXPECT_EQ(count_runs->run_count("g"), 1);
+
+  // A change which is not recorded in function base versions discards the
+  // memoized runs.
+  OptimizationCompoundPass rename("rename", "rename");
+  rename.Add<RenameParamPass>();
+  EXPECT_THAT(rename.Run(p.get(), OptimizationPassOptions(), &results),
+              IsOkAndHolds(true));
+  EXPECT_THAT(fixed.Run(p.get(), OptimizationPassOptions(), &results),
+              IsOkAndHolds(false));
+  EXPECT_EQ(count_runs->run_count("f"), 5);
+  EXPECT_EQ(count_runs->run_count("g"), 2);
+}
+
+TEST_F(PassBaseTest, Profile) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  fb.Literal(UBits(0, 2));
+  XLS_ASSERT_OK(fb.Build().status());
+  OptimizationCompoundPass opt("opt", "opt");
+  {
+    auto fp =
+        std::make_unique<OptimizationFixedPointCompoundPass>("fixed", "fixed");
+    fp->Add<LevelUpPass>();
+    fp->Add<DeadCodeEliminationPass>();
+    opt.AddOwned(std::move(fp));
+  }
+  PassProfile profile;
+  PassResults results;
+  results.profile = &profile;
+  EXPECT_THAT(opt.Run(p.get(), OptimizationPassOptions(), &results),
+              IsOkAndHolds(true));
+
+  // The literal is leveled up from 0 to 3 and the fixed point is reached on
+  // the fourth iteration. Each pass run records an event for the package and
+  // one for the function.
+  PassProfileProto proto = profile.ToProto();
+  ASSERT_EQ(proto.events_size(), 2 + 4 * 2 * 2);
+  EXPECT_EQ(proto.events(0).pass_name(), "opt");
+  EXPECT_TRUE(proto.events(0).compound());
+  EXPECT_FALSE(proto.events(0).has_parent());
+  EXPECT_EQ(proto.events(0).nodes_added(), 3);
+  EXPECT_EQ(proto.events(0).nodes_removed(), 3);
+  EXPECT_EQ(proto.events(1).pass_name(), "fixed");
+  EXPECT_EQ(proto.events(1).parent(), 0);
+  EXPECT_EQ(proto.events(1).fixed_point_iterations(), 4);
+
+  const PassProfileProto::Event& level_up = proto.events(2);
+  EXPECT_EQ(level_up.pass_name(), "level_up");
+  EXPECT_FALSE(level_up.compound());
+  EXPECT_EQ(level_up.parent(), 1);
+  EXPECT_FALSE(level_up.has_function_base());
+  EXPECT_TRUE(level_up.changed());
+  EXPECT_EQ(level_up.nodes_added(), 1);
+  const PassProfileProto::Event& level_up_f = proto.events(3);
+  EXPECT_EQ(level_up_f.pass_name(), "level_up");
+  EXPECT_EQ(level_up_f.function_base(), TestName());
+  EXPECT_EQ(level_up_f.parent(), 2);
+  EXPECT_EQ(level_up_f.thread(), 0);
+  EXPECT_TRUE(level_up_f.changed());
+  EXPECT_EQ(level_up_f.nodes_added(), 1);
+  EXPECT_EQ(proto.events(4).pass_name(), "dce");
+  EXPECT_EQ(proto.events(4).parent(), 1);
+  EXPECT_EQ(proto.events(5).nodes_removed(), 1);
+
+  // The last run of dce does not change anything.
+  const PassProfileProto::Event& last_dce = proto.events(proto.events_size() - 1);
+  EXPECT_EQ(last_dce.pass_name(), "dce");
+  EXPECT_EQ(last_dce.function_base(), TestName());
+  EXPECT_FALSE(last_dce.changed());
+  EXPECT_EQ(last_dce.nodes_removed(), 0);
+}
+
 }  // namespace
 }  // namespace xls
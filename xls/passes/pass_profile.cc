@@ -0,0 +1,165 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/pass_profile.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/ir/package.h"
+#include "xls/passes/pass_profile.pb.h"
+
+namespace xls {
+namespace {
+
+void SetMetrics(const TransformMetrics& metrics,
+                PassProfileProto::Event* event) {
+  event->set_nodes_added(metrics.nodes_added);
+  event->set_nodes_removed(metrics.nodes_removed);
+  event->set_nodes_replaced(metrics.nodes_replaced);
+  event->set_operands_replaced(metrics.operands_replaced);
+}
+
+std::string JsonString(std::string_view s) {
+  std::string result = "\"";
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        absl::StrAppend(&result, "\\\"");
+        break;
+      case '\\':
+        absl::StrAppend(&result, "\\\\");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&result, "\\u%04x", c);
+        } else {
+          result.push_back(c);
+        }
+    }
+  }
+  result.push_back('"');
+  return result;
+}
+
+}  // namespace
+
+int64_t PassProfile::StartMicros(absl::Time start) {
+  if (!epoch_.has_value()) {
+    epoch_ = start;
+  }
+  return absl::ToInt64Microseconds(start - *epoch_);
+}
+
+int64_t PassProfile::BeginPass(std::string_view pass_name, bool compound) {
+  absl::MutexLock lock(&mutex_);
+  absl::Time start = absl::Now();
+  int64_t index = proto_.events_size();
+  PassProfileProto::Event* event = proto_.add_events();
+  event->set_pass_name(pass_name);
+  event->set_compound(compound);
+  if (!open_events_.empty()) {
+    event->set_parent(open_events_.back().first);
+  }
+  event->set_start_us(StartMicros(start));
+  event->set_thread(0);
+  open_events_.push_back({index, start});
+  return index;
+}
+
+void PassProfile::EndPass(int64_t index, bool changed,
+                          const TransformMetrics& metrics,
+                          std::optional<int64_t> fixed_point_iterations) {
+  absl::MutexLock lock(&mutex_);
+  CHECK(!open_events_.empty() && open_events_.back().first == index)
+      << "Pass profile event " << index << " is not the innermost open event.";
+  PassProfileProto::Event* event = proto_.mutable_events(index);
+  event->set_duration_us(
+      absl::ToInt64Microseconds(absl::Now() - open_events_.back().second));
+  event->set_changed(changed);
+  if (fixed_point_iterations.has_value()) {
+    event->set_fixed_point_iterations(*fixed_point_iterations);
+  }
+  SetMetrics(metrics, event);
+  open_events_.pop_back();
+}
+
+void PassProfile::AddFunctionBaseRun(std::string_view pass_name,
+                                     std::string_view function_base,
+                                     int64_t thread, absl::Time start,
+                                     absl::Duration duration, bool changed,
+                                     const TransformMetrics& metrics) {
+  absl::MutexLock lock(&mutex_);
+  PassProfileProto::Event* event = proto_.add_events();
+  event->set_pass_name(pass_name);
+  event->set_function_base(function_base);
+  event->set_compound(false);
+  if (!open_events_.empty()) {
+    event->set_parent(open_events_.back().first);
+  }
+  event->set_start_us(StartMicros(start));
+  event->set_duration_us(absl::ToInt64Microseconds(duration));
+  event->set_thread(thread);
+  event->set_changed(changed);
+  SetMetrics(metrics, event);
+}
+
+PassProfileProto PassProfile::ToProto() const {
+  absl::MutexLock lock(&mutex_);
+  return proto_;
+}
+
+std::string PassProfile::ToChromeTraceJson() const {
+  absl::MutexLock lock(&mutex_);
+  std::vector<std::string> trace_events;
+  trace_events.reserve(proto_.events_size());
+  for (const PassProfileProto::Event& event : proto_.events()) {
+    std::string name = event.has_function_base()
+                           ? absl::StrCat(event.pass_name(), " [",
+                                          event.function_base(), "]")
+                           : event.pass_name();
+    std::string args = absl::StrFormat(
+        "\"changed\":%s,\"nodes_added\":%d,\"nodes_removed\":%d,"
+        "\"nodes_replaced\":%d,\"operands_replaced\":%d",
+        event.changed() ? "true" : "false", event.nodes_added(),
+        event.nodes_removed(), event.nodes_replaced(),
+        event.operands_replaced());
+    if (event.has_fixed_point_iterations()) {
+      absl::StrAppendFormat(&args, ",\"fixed_point_iterations\":%d",
+                            event.fixed_point_iterations());
+    }
+    trace_events.push_back(absl::StrFormat(
+        "{\"name\":%s,\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%d,\"dur\":%d,"
+        "\"pid\":0,\"tid\":%d,\"args\":{%s}}",
+        JsonString(name),
+        event.compound()            ? "compound"
+        : event.has_function_base() ? "function_base"
+                                    : "pass",
+        event.start_us(), event.duration_us(), event.thread(), args));
+  }
+  return absl::StrCat("{\"traceEvents\":[\n",
+                      absl::StrJoin(trace_events, ",\n"), "\n]}\n");
+}
+
+}  // namespace xls
@@ -0,0 +1,83 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_PASSES_PASS_PROFILE_H_
+#define XLS_PASSES_PASS_PROFILE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "xls/ir/package.h"
+#include "xls/passes/pass_profile.pb.h"
+
+namespace xls {
+
+// Records the wall time spent in and the changes made by each pass of a
+// pipeline, both for the pipeline as a whole and for each function base a pass
+// is run on. Compound passes record the passes nested in them, so the events
+// form a tree rooted at the top-level pass. Passes record into the profile set
+// in PassResults::profile if there is one.
+//
+// Function base runs may be recorded concurrently. Passes on the whole package
+// are begun and ended by a single thread.
+class PassProfile {
+ public:
+  PassProfile() = default;
+
+  // Starts an event for a run of the given pass on the whole package, nested
+  // in the innermost event which has not ended yet. Returns the index of the
+  // event.
+  int64_t BeginPass(std::string_view pass_name, bool compound);
+
+  // Ends the event at `index`, which must be the innermost unended event.
+  void EndPass(int64_t index, bool changed, const TransformMetrics& metrics,
+               std::optional<int64_t> fixed_point_iterations = std::nullopt);
+
+  // Records a run of the given pass on a single function base, nested in the
+  // innermost unended event. `thread` identifies the thread the run was made
+  // on, with 0 being the thread running the pipeline.
+  void AddFunctionBaseRun(std::string_view pass_name,
+                          std::string_view function_base, int64_t thread,
+                          absl::Time start, absl::Duration duration,
+                          bool changed, const TransformMetrics& metrics);
+
+  PassProfileProto ToProto() const;
+
+  // Returns the profile in the Chrome trace event format, viewable in
+  // chrome://tracing or Perfetto.
+  std::string ToChromeTraceJson() const;
+
+ private:
+  int64_t StartMicros(absl::Time start) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  // The start of the first event. Event start times are relative to it.
+  std::optional<absl::Time> epoch_ ABSL_GUARDED_BY(mutex_);
+  PassProfileProto proto_ ABSL_GUARDED_BY(mutex_);
+  // The indices and start times of the events which have not ended.
+  std::vector<std::pair<int64_t, absl::Time>> open_events_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_PASS_PROFILE_H_
@@ -0,0 +1,100 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/pass_profile.h"
+
+#include <cstdint>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xls/ir/package.h"
+#include "xls/passes/pass_profile.pb.h"
+
+namespace xls {
+namespace {
+
+using ::testing::HasSubstr;
+
+TEST(PassProfileTest, EventsAreNested) {
+  PassProfile profile;
+  int64_t pipeline = profile.BeginPass("pipeline", /*compound=*/true);
+  int64_t fixed = profile.BeginPass("fixed", /*compound=*/true);
+  int64_t dce = profile.BeginPass("dce", /*compound=*/false);
+  profile.AddFunctionBaseRun("dce", "f", /*thread=*/0, absl::Now(),
+                             absl::Microseconds(3), /*changed=*/true,
+                             TransformMetrics{.nodes_removed = 2});
+  profile.AddFunctionBaseRun("dce", "g", /*thread=*/1, absl::Now(),
+                             absl::Microseconds(5), /*changed=*/false,
+                             TransformMetrics{});
+  profile.EndPass(dce, /*changed=*/true, TransformMetrics{.nodes_removed = 2});
+  profile.EndPass(fixed, /*changed=*/true,
+                  TransformMetrics{.nodes_removed = 2},
+                  /*fixed_point_iterations=*/2);
+  profile.EndPass(pipeline, /*changed=*/true,
+                  TransformMetrics{.nodes_removed = 2});
+
+  PassProfileProto proto = profile.ToProto();
+  ASSERT_EQ(proto.events_size(), 5);
+  EXPECT_EQ(proto.events(0).pass_name(), "pipeline");
+  EXPECT_TRUE(proto.events(0).compound());
+  EXPECT_FALSE(proto.events(0).has_parent());
+  EXPECT_EQ(proto.events(0).start_us(), 0);
+  EXPECT_EQ(proto.events(1).pass_name(), "fixed");
+  EXPECT_EQ(proto.events(1).parent(), pipeline);
+  EXPECT_EQ(proto.events(1).fixed_point_iterations(), 2);
+  EXPECT_EQ(proto.events(2).pass_name(), "dce");
+  EXPECT_FALSE(proto.events(2).compound());
+  EXPECT_EQ(proto.events(2).parent(), fixed);
+  EXPECT_FALSE(proto.events(2).has_function_base());
+  EXPECT_FALSE(proto.events(2).has_fixed_point_iterations());
+  EXPECT_EQ(proto.events(3).function_base(), "f");
+  EXPECT_EQ(proto.events(3).parent(), dce);
+  EXPECT_EQ(proto.events(3).duration_us(), 3);
+  EXPECT_EQ(proto.events(3).nodes_removed(), 2);
+  EXPECT_TRUE(proto.events(3).changed());
+  EXPECT_EQ(proto.events(4).function_base(), "g");
+  EXPECT_EQ(proto.events(4).thread(), 1);
+  EXPECT_FALSE(proto.events(4).changed());
+  for (const PassProfileProto::Event& event : proto.events()) {
+    EXPECT_GE(event.start_us(), 0);
+  }
+}
+
+TEST(PassProfileTest, ChromeTrace) {
+  PassProfile profile;
+  int64_t fixed = profile.BeginPass("fixed", /*compound=*/true);
+  profile.AddFunctionBaseRun("dce", "a \"quoted\" name", /*thread=*/2,
+                             absl::Now(), absl::Microseconds(7),
+                             /*changed=*/true,
+                             TransformMetrics{.nodes_added = 1});
+  profile.EndPass(fixed, /*changed=*/true, TransformMetrics{.nodes_added = 1},
+                  /*fixed_point_iterations=*/3);
+
+  std::string trace = profile.ToChromeTraceJson();
+  EXPECT_THAT(trace, HasSubstr("\"traceEvents\":["));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"fixed\",\"cat\":\"compound\""));
+  EXPECT_THAT(trace, HasSubstr("\"fixed_point_iterations\":3"));
+  EXPECT_THAT(trace,
+              HasSubstr("\"name\":\"dce [a \\\"quoted\\\" name]\","
+                        "\"cat\":\"function_base\""));
+  EXPECT_THAT(trace, HasSubstr("\"dur\":7,\"pid\":0,\"tid\":2"));
+  EXPECT_THAT(trace, HasSubstr("\"nodes_added\":1"));
+}
+
+}  // namespace
+}  // namespace xls
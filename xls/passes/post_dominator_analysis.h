@@ -16,17 +16,24 @@
 #define XLS_PASSES_POST_DOMINATOR_ANALYSIS_H_
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
+#include "xls/ir/node_graph.h"
+#include "xls/passes/dominator_tree.h"
 
 namespace xls {
 
 // A class for post-dominator analysis of the IR instructions in a function.
+//
+// The analysis builds the post-dominator tree of the function, so dominance
+// queries take constant time. The node lists returned by the getters are
+// materialized on first request.
 class PostDominatorAnalysis {
  public:
   // Performs post-dominator analysis on the function and returns the result.
@@ -34,35 +41,32 @@ class PostDominatorAnalysis {
       FunctionBase* f);
 
   // Returns the nodes that post-dominate this node.
-  absl::Span<Node* const> GetPostDominatorsOfNode(const Node* node) const {
-    return dominated_node_to_post_dominators_ordered_by_id_.at(node);
-  }
+  absl::Span<Node* const> GetPostDominatorsOfNode(const Node* node) const;
   // Returns the nodes that are post-dominated by this node.
-  absl::Span<Node* const> GetNodesPostDominatedByNode(const Node* node) const {
-    return post_dominator_to_dominated_nodes_ordered_by_id_.at(node);
-  }
+  absl::Span<Node* const> GetNodesPostDominatedByNode(const Node* node) const;
   // Returns true if 'node' is post-dominated by 'post_dominator'.
   bool NodeIsPostDominatedBy(const Node* node,
                              const Node* post_dominator) const {
-    return dominated_node_to_post_dominators_.at(node).contains(post_dominator);
+    return tree_.Dominates(graph_.index(post_dominator), graph_.index(node));
   }
   // Returns true if 'node' post_dominates 'post_dominated'.
   bool NodePostDominates(const Node* node, const Node* post_dominated) const {
-    return post_dominator_to_dominated_nodes_.at(node).contains(post_dominated);
+    return tree_.Dominates(graph_.index(node), graph_.index(post_dominated));
   }
 
  private:
-  // Maps from a node to all nodes that post-dominate the node.
-  absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>>
-      dominated_node_to_post_dominators_;
-  absl::flat_hash_map<Node*, std::vector<Node*>>
-      dominated_node_to_post_dominators_ordered_by_id_;
+  PostDominatorAnalysis(NodeGraph graph, DominatorTree tree)
+      : graph_(std::move(graph)), tree_(std::move(tree)) {}
+
+  NodeGraph graph_;
+  // Tree over the node indices of `graph_`.
+  DominatorTree tree_;
 
-  // Maps from a node to all nodes that are post-dominated by the node.
-  absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>>
-      post_dominator_to_dominated_nodes_;
-  absl::flat_hash_map<Node*, std::vector<Node*>>
-      post_dominator_to_dominated_nodes_ordered_by_id_;
+  // Node lists ordered by id, materialized on first request.
+  mutable absl::flat_hash_map<const Node*, std::vector<Node*>>
+      post_dominators_ordered_by_id_;
+  mutable absl::flat_hash_map<const Node*, std::vector<Node*>>
+      post_dominated_nodes_ordered_by_id_;
 };
 
 }  // namespace xls
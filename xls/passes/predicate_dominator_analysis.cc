@@ -27,6 +27,7 @@
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/topo_sort.h"
+#include "xls/passes/dominator_tree.h"
 #include "xls/passes/predicate_state.h"
 
 namespace xls {
@@ -64,11 +65,11 @@ static constexpr PredicateStackId kRootPredicateId(0);
 // Traverse the node graph from return values up towards parameters (in reverse
 // topo-sort order). For each node merge the predicate stack of its users by
 // finding their common predication path in the graph (ie suffix string).
-// This is O(N^3) in the worst case (since its for each node (N) check each user
-// (N) for the whole predicate stack size (N)) in a pathological case where
-// stacked selects are collapsed. This would be a highly degenerate graph
-// however. Normal graphs are generally not very top-heavy with most nodes only
-// having a few (or zero) predicates guarding their use.
+// The lists form a tree rooted at the empty list, so this is the nearest common
+// ancestor of the list heads in that tree. The tree is mirrored in a
+// JumpPointerTree (the same structure the dominator tree uses) so each join
+// takes O(log N) time even when deeply stacked selects are collapsed, rather
+// than a walk over the whole predicate stack.
 struct PredicateStackNode {
   // Select with the arm we are choosing.
   Node* const selector;
@@ -175,6 +176,8 @@ class AnalysisHelper {
               predicate_stacks_[prev.value()].distance_to_root + 1};
       PredicateStackId new_id = NextId();
       predicate_stacks_.push_back(cons_set);
+      JumpPointerTree::Index tree_index = stack_tree_.AddChild(prev.value());
+      CHECK_EQ(tree_index, new_id.value());
       // Find the actual join-point.
       head = FindJoinPoint(new_id, head);
     };
@@ -193,14 +196,7 @@ class AnalysisHelper {
     return PredicateStackId(predicate_stacks_.size());
   }
 
-  // Since set-ids monotonically increase we could do this with each node
-  // holding a bit-map and count-leading-zeros?  Normally these select-chains
-  // aren't terribly deep compared to the number of selects (i.e. most selects
-  // are independent of one another on a structural level) so doing the list
-  // traversal is better thanks to saving memory allocation.
-  //
-  // The pathological case where this functions non-optimally is just a huge
-  // number of nested ifs.
+  // Returns the longest common tail of the lists headed by `a` and `b`.
   PredicateStackId FindJoinPoint(std::optional<PredicateStackId> a,
                                  std::optional<PredicateStackId> b) {
     CHECK(a.has_value() || b.has_value()) << "Both predicates unassigned!";
@@ -226,35 +222,8 @@ class AnalysisHelper {
     if (!b.has_value()) {
       return a.value();
     }
-    const PredicateStackNode& a_set = predicate_stacks_[a->value()];
-    const PredicateStackNode& b_set = predicate_stacks_[b->value()];
-    // Simplify by ensuring that b is always longer.
-    if (a_set.distance_to_root > b_set.distance_to_root) {
-      return FindJoinPoint(b, a);
-    }
-    // a_set is smaller than b_set
-    size_t len_diff = b_set.distance_to_root - a_set.distance_to_root;
-    PredicateStackId b_candidate = b.value();
-    PredicateStackId a_candidate = a.value();
-    // Get sublist of b that is same length as a
-    for (size_t i = 0; i < len_diff; ++i) {
-      // (tail b)
-      CHECK_LT(b_candidate, NextId()) << "Invalid list head!";
-      b_candidate = predicate_stacks_[b_candidate.value()].previous;
-    }
-    // Walk down both lists until we find a join.
-    while (a_candidate != b_candidate) {
-      CHECK_LT(a_candidate, NextId()) << "Invalid list head!";
-      CHECK_LT(b_candidate, NextId()) << "Invalid list head!";
-      CHECK_NE(a_candidate, kRootPredicateId)
-          << "list element had invalid length!";
-      CHECK_NE(b_candidate, kRootPredicateId)
-          << "list element had invalid length!";
-      a_candidate = predicate_stacks_[a_candidate.value()].previous;
-      b_candidate = predicate_stacks_[b_candidate.value()].previous;
-    }
-    CHECK_LT(a_candidate, NextId()) << "Invalid list head!";
-    return a_candidate;
+    return PredicateStackId(
+        stack_tree_.NearestCommonAncestor(a->value(), b->value()));
   }
 
  private:
@@ -263,6 +232,8 @@ class AnalysisHelper {
   absl::flat_hash_map<Node*, PredicateStackId> node_states_;
   // Map from 'PredicateStackId' to the predicate node.
   std::vector<PredicateStackNode> predicate_stacks_;
+  // The lists as a tree indexed by 'PredicateStackId', for finding joins.
+  JumpPointerTree stack_tree_;
 };
 }  // namespace
 
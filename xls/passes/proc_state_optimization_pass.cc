@@ -16,7 +16,6 @@
 
 #include <algorithm>
 #include <cstdint>
-#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -29,6 +28,7 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -89,8 +89,8 @@ absl::StatusOr<bool> RemoveZeroWidthStateElements(Proc* proc) {
     XLS_RETURN_IF_ERROR(
         state_read->ReplaceUsesWithNew<Literal>(state_element->initial_value())
             .status());
-    XLS_RETURN_IF_ERROR(proc->RemoveStateElement(i));
   }
+  XLS_RETURN_IF_ERROR(proc->RemoveStateElements(to_remove));
   return true;
 }
 
@@ -153,8 +153,8 @@ absl::StatusOr<bool> RemoveConstantStateElements(Proc* proc,
     }
     XLS_RETURN_IF_ERROR(
         state_read->ReplaceUsesWithNew<Literal>(value).status());
-    XLS_RETURN_IF_ERROR(proc->RemoveStateElement(i));
   }
+  XLS_RETURN_IF_ERROR(proc->RemoveStateElements(to_remove));
   return true;
 }
 
@@ -229,6 +229,19 @@ class StateDependencyVisitor : public DataflowVisitor<InlineBitmap> {
   Proc* proc_;
 };
 
+// Returns the indices of the bits set in `bitmap` in increasing order. Procs
+// can have many thousands of state elements, so this skips over the zero words
+// of the bitmap rather than testing each bit.
+std::vector<int64_t> SetBitIndices(const InlineBitmap& bitmap) {
+  std::vector<int64_t> indices;
+  for (int64_t wordno = 0; wordno < bitmap.word_count(); ++wordno) {
+    for (uint64_t word = bitmap.GetWord(wordno); word != 0; word &= word - 1) {
+      indices.push_back(wordno * 64 + absl::countr_zero(word));
+    }
+  }
+  return indices;
+}
+
 // Computes which state elements each node is dependent upon. Dependence is
 // represented as a bit-vector with one bit per state element in the proc.
 // Dependencies are only computed in a single forward pass so dependencies
@@ -245,10 +258,8 @@ ComputeStateDependencies(Proc* proc) {
     VLOG(3) << "State dependencies (** side-effecting operation):";
     for (Node* node : TopoSort(proc)) {
       std::vector<std::string> dependent_elements;
-      for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
-        if (state_dependencies.at(node).Get(i)) {
-          dependent_elements.push_back(proc->GetStateRead(i)->GetName());
-        }
+      for (int64_t i : SetBitIndices(state_dependencies.at(node))) {
+        dependent_elements.push_back(proc->GetStateRead(i)->GetName());
       }
       VLOG(3) << absl::StrFormat("  %s : {%s}%s", node->GetName(),
                                  absl::StrJoin(dependent_elements, ", "),
@@ -299,10 +310,7 @@ absl::StatusOr<bool> RemoveUnobservableStateElements(Proc* proc) {
       // `node` is side-effecting. All state elements that `node` is dependent
       // on are observable, except if the only side effect is to change the
       // state element.
-      for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
-        if (!state_dependencies.at(node).Get(i)) {
-          continue;
-        }
+      for (int64_t i : SetBitIndices(state_dependencies.at(node))) {
         if (node->Is<Next>() &&
             node->As<Next>()->state_read() == proc->GetStateRead(i)) {
           // The only side-effect is to change this state element, so this
@@ -321,21 +329,21 @@ absl::StatusOr<bool> RemoveUnobservableStateElements(Proc* proc) {
       }
     }
     if (next_state_indices.contains(node)) {
+      std::vector<int64_t> dependencies =
+          SetBitIndices(state_dependencies.at(node));
       for (int64_t next_state_index : next_state_indices.at(node)) {
         // `node` is the next state node for state element with index
         // `next_state_index`. Union `next_state_index` with each state index
         // that `node` is dependent on.
-        for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
-          if (state_dependencies.at(node).Get(i)) {
-            VLOG(4) << absl::StreamFormat(
-                "Unioning state elements `%s` (%d) and `%s` (%d) because next "
-                "state of `%s` (node `%s`) depends on `%s`",
-                proc->GetStateElement(next_state_index)->name(),
-                next_state_index, proc->GetStateElement(i)->name(), i,
-                proc->GetStateElement(next_state_index)->name(),
-                node->GetName(), proc->GetStateElement(i)->name());
-            state_components.Union(i, next_state_index);
-          }
+        for (int64_t i : dependencies) {
+          VLOG(4) << absl::StreamFormat(
+              "Unioning state elements `%s` (%d) and `%s` (%d) because next "
+              "state of `%s` (node `%s`) depends on `%s`",
+              proc->GetStateElement(next_state_index)->name(),
+              next_state_index, proc->GetStateElement(i)->name(), i,
+              proc->GetStateElement(next_state_index)->name(), node->GetName(),
+              proc->GetStateElement(i)->name());
+          state_components.Union(i, next_state_index);
         }
       }
     }
@@ -388,8 +396,8 @@ absl::StatusOr<bool> RemoveUnobservableStateElements(Proc* proc) {
     VLOG(2) << absl::StreamFormat("Removing dead state element %s of type %s",
                                   proc->GetStateElement(i)->name(),
                                   proc->GetStateElement(i)->type()->ToString());
-    XLS_RETURN_IF_ERROR(proc->RemoveStateElement(i));
   }
+  XLS_RETURN_IF_ERROR(proc->RemoveStateElements(to_remove));
   return true;
 }
 
@@ -485,7 +493,8 @@ absl::Status ConstantChainToStateMachine(Proc* proc,
       proc->MakeNode<Literal>(chain_constant->loc(),
                               *query_engine.KnownValue(chain_constant)));
 
-  absl::btree_set<int64_t, std::greater<int64_t>> indices_to_remove;
+  std::vector<int64_t> indices_to_remove;
+  indices_to_remove.reserve(chain.size());
   for (int64_t chain_index = 0; chain_index < chain.size(); ++chain_index) {
     int64_t state_index = chain.at(chain_index);
     std::vector<Node*> cases = initial_state_literals;
@@ -503,11 +512,9 @@ absl::Status ConstantChainToStateMachine(Proc* proc,
                             ->ReplaceUsesWithNew<Select>(state_machine_read,
                                                          cases, chain_literal)
                             .status());
-    indices_to_remove.insert(state_index);
-  }
-  for (int64_t state_index : indices_to_remove) {
-    XLS_RETURN_IF_ERROR(proc->RemoveStateElement(state_index));
+    indices_to_remove.push_back(state_index);
   }
+  XLS_RETURN_IF_ERROR(proc->RemoveStateElements(indices_to_remove));
 
   return absl::OkStatus();
 }
@@ -18,19 +18,25 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
+#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
+#include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/bits.h"
@@ -40,6 +46,7 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/proc.h"
 #include "xls/ir/proc_instantiation.h"
+#include "xls/ir/source_location.h"
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
@@ -47,6 +54,8 @@
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
+#include "xls/passes/query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
 
 namespace xls {
 namespace {
@@ -60,6 +69,8 @@ struct RamChannel {
 // A btree is used for stable iteration.
 using RamChannelMap = absl::btree_map<RamLogicalChannel, RamChannel>;
 
+using ReverseRamChannelMap = absl::flat_hash_map<ChannelRef, RamLogicalChannel>;
+
 // Data structure gathering together information about a RAM prior to
 // rewriting.
 struct RamMetadata {
@@ -759,6 +770,24 @@ absl::Status ReplaceReceive(Proc* proc, Receive* old_receive,
   return absl::OkStatus();
 }
 
+// Returns a mapping from the RAM's channels to their logical names. Used for
+// figuring out what kind of channel each send/recv is operating on.
+absl::StatusOr<ReverseRamChannelMap> ReverseChannelMap(
+    const RamMetadata& metadata) {
+  ReverseRamChannelMap reverse_from_mapping;
+  for (auto& [logical_channel, ram_channel] : metadata.channel_map) {
+    if (auto [it, inserted] = reverse_from_mapping.try_emplace(
+            ram_channel.channel_ref, logical_channel);
+        !inserted) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Channel mapping must be one-to-one, got multiple "
+                          "names for channel %s.",
+                          ChannelRefName(ram_channel.channel_ref)));
+    }
+  }
+  return reverse_from_mapping;
+}
+
 // Replace sends and receives on old channels with sends and receives on new
 // channels. This involves:
 // 1. Repacking the inputs to sends.
@@ -774,19 +803,8 @@ absl::Status ReplaceReceive(Proc* proc, Receive* old_receive,
 // have been replaced.
 absl::Status ReplaceChannelReferences(Package* p, const RamMetadata& metadata,
                                       const RamChannelMap& to_mapping) {
-  // Make a reverse mapping from channel -> logical name.
-  // Used for figuring out what kind of channel each send/recv is operating on.
-  absl::flat_hash_map<ChannelRef, RamLogicalChannel> reverse_from_mapping;
-  for (auto& [logical_channel, ram_channel] : metadata.channel_map) {
-    if (auto [it, inserted] = reverse_from_mapping.try_emplace(
-            ram_channel.channel_ref, logical_channel);
-        !inserted) {
-      return absl::InvalidArgumentError(
-          absl::StrFormat("Channel mapping must be one-to-one, got multiple "
-                          "names for channel %s.",
-                          ChannelRefName(ram_channel.channel_ref)));
-    }
-  }
+  XLS_ASSIGN_OR_RETURN(ReverseRamChannelMap reverse_from_mapping,
+                       ReverseChannelMap(metadata));
 
   auto handle_send = [&](Send* send,
                          std::optional<Proc*> proc_scope) -> absl::Status {
@@ -866,6 +884,414 @@ absl::Status ReplaceChannelReferences(Package* p, const RamMetadata& metadata,
   return absl::OkStatus();
 }
 
+// Where the bank index and the address within the bank lie in an address of a
+// banked RAM.
+struct BankAddressLayout {
+  int64_t bank_start;
+  int64_t bank_width;
+  int64_t local_start;
+  int64_t local_width;
+};
+
+BankAddressLayout GetBankAddressLayout(RamBankingScheme scheme,
+                                       int64_t bank_count,
+                                       const RamConfig& bank_config) {
+  int64_t bank_width = CeilOfLog2(bank_count);
+  int64_t local_width = bank_config.addr_width();
+  if (scheme == RamBankingScheme::kBlock) {
+    return BankAddressLayout{.bank_start = local_width,
+                             .bank_width = bank_width,
+                             .local_start = 0,
+                             .local_width = local_width};
+  }
+  return BankAddressLayout{.bank_start = 0,
+                           .bank_width = bank_width,
+                           .local_start = bank_width,
+                           .local_width = local_width};
+}
+
+// Returns the bank accessed by the request `payload`, whose first element is
+// the address, if `query_engine` knows it.
+std::optional<int64_t> KnownBank(const QueryEngine& query_engine,
+                                 Node* payload,
+                                 const BankAddressLayout& layout) {
+  int64_t bank = 0;
+  for (int64_t i = 0; i < layout.bank_width; ++i) {
+    std::optional<bool> bit = query_engine.KnownValue(TreeBitLocation(
+        payload, layout.bank_start + i, /*tree_index=*/{0}));
+    if (!bit.has_value()) {
+      return std::nullopt;
+    }
+    bank |= static_cast<int64_t>(*bit) << i;
+  }
+  return bank;
+}
+
+// Returns the procs which may access the RAM.
+std::vector<Proc*> GetRamProcs(Package* p, const RamMetadata& metadata) {
+  if (metadata.proc_scope.has_value()) {
+    return {*metadata.proc_scope};
+  }
+  std::vector<Proc*> procs;
+  for (const std::unique_ptr<Proc>& proc : p->procs()) {
+    procs.push_back(proc.get());
+  }
+  return procs;
+}
+
+// Returns the logical channel of the RAM which `node` sends on or receives
+// from, if any.
+absl::StatusOr<std::optional<RamLogicalChannel>> GetRamLogicalChannel(
+    Node* node, const RamMetadata& metadata,
+    const ReverseRamChannelMap& reverse_from_mapping) {
+  if (!node->Is<ChannelNode>()) {
+    return std::nullopt;
+  }
+  XLS_ASSIGN_OR_RETURN(
+      ChannelRef channel,
+      GetChannelRef(node->package(), node->As<ChannelNode>()->channel_name(),
+                    node->Is<Send>() ? Direction::kSend : Direction::kReceive,
+                    metadata.proc_scope));
+  auto it = reverse_from_mapping.find(channel);
+  if (it == reverse_from_mapping.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+// Returns the scheme to bank the RAM with. For kAuto, this is the scheme under
+// which every request selects its bank statically, preferring interleaving.
+absl::StatusOr<RamBankingScheme> ResolveBankingScheme(
+    Package* p, const RamMetadata& metadata, const RamConfig& bank_config,
+    const ReverseRamChannelMap& reverse_from_mapping) {
+  const RamBanking& banking = *metadata.rewrite.banking;
+  if (banking.scheme != RamBankingScheme::kAuto) {
+    return banking.scheme;
+  }
+  bool block_is_possible = IsPowerOfTwo(bank_config.depth);
+  std::vector<RamBankingScheme> candidates = {RamBankingScheme::kInterleaved};
+  if (block_is_possible) {
+    candidates.push_back(RamBankingScheme::kBlock);
+  }
+  for (RamBankingScheme scheme : candidates) {
+    BankAddressLayout layout =
+        GetBankAddressLayout(scheme, banking.bank_count, bank_config);
+    bool all_known = true;
+    for (Proc* proc : GetRamProcs(p, metadata)) {
+      TernaryQueryEngine query_engine;
+      XLS_RETURN_IF_ERROR(query_engine.Populate(proc).status());
+      for (Node* node : proc->nodes()) {
+        if (!node->Is<Send>()) {
+          continue;
+        }
+        XLS_ASSIGN_OR_RETURN(
+            std::optional<RamLogicalChannel> logical_channel,
+            GetRamLogicalChannel(node, metadata, reverse_from_mapping));
+        if (logical_channel.has_value() &&
+            !KnownBank(query_engine, node->As<Send>()->data(), layout)
+                 .has_value()) {
+          all_known = false;
+          break;
+        }
+      }
+      if (!all_known) {
+        break;
+      }
+    }
+    if (all_known) {
+      return scheme;
+    }
+  }
+  return RamBankingScheme::kInterleaved;
+}
+
+// The bank a request on a banked RAM accesses.
+struct BankSelection {
+  RamLogicalChannel request_channel;
+  // The bank, if known statically.
+  std::optional<int64_t> bank;
+  // The index of the bank, computed from the address.
+  Node* bank_index;
+};
+
+// Returns the predicate of an operation on bank `bank` on behalf of an
+// operation with predicate `predicate` which accesses the bank `selection`.
+absl::StatusOr<std::optional<Node*>> BankPredicate(
+    FunctionBase* fb, const SourceInfo& loc, std::optional<Node*> predicate,
+    const BankSelection& selection, int64_t bank) {
+  if (selection.bank.has_value()) {
+    return predicate;
+  }
+  XLS_ASSIGN_OR_RETURN(
+      Node * bank_literal,
+      fb->MakeNode<Literal>(
+          loc, Value(UBits(bank, selection.bank_index->BitCountOrDie()))));
+  XLS_ASSIGN_OR_RETURN(Node * selected,
+                       fb->MakeNode<CompareOp>(loc, selection.bank_index,
+                                               bank_literal, Op::kEq));
+  if (!predicate.has_value()) {
+    return selected;
+  }
+  return fb->MakeNode<NaryOp>(loc, std::vector<Node*>{*predicate, selected},
+                              Op::kAnd);
+}
+
+// Returns the banks an operation on behalf of `selection` must access.
+std::vector<int64_t> SelectedBanks(const BankSelection& selection,
+                                   int64_t bank_count) {
+  if (selection.bank.has_value()) {
+    return {*selection.bank};
+  }
+  std::vector<int64_t> banks(bank_count);
+  for (int64_t i = 0; i < bank_count; ++i) {
+    banks[i] = i;
+  }
+  return banks;
+}
+
+// Returns the request whose response `receive` receives on
+// `logical_channel`: the closest request on the matching request channel in
+// the token chain of the receive.
+absl::StatusOr<BankSelection> FindBankRequest(
+    Receive* receive, RamLogicalChannel logical_channel,
+    const absl::flat_hash_map<Node*, BankSelection>& requests) {
+  RamLogicalChannel request_channel =
+      logical_channel == RamLogicalChannel::kAbstractReadResp
+          ? RamLogicalChannel::kAbstractReadReq
+          : RamLogicalChannel::kAbstractWriteReq;
+  std::deque<Node*> worklist = {receive->token()};
+  absl::flat_hash_set<Node*> visited = {receive->token()};
+  while (!worklist.empty()) {
+    Node* node = worklist.front();
+    worklist.pop_front();
+    if (auto it = requests.find(node);
+        it != requests.end() && it->second.request_channel == request_channel) {
+      return it->second;
+    }
+    for (Node* operand : node->operands()) {
+      if (TypeHasToken(operand->GetType()) && visited.insert(operand).second) {
+        worklist.push_back(operand);
+      }
+    }
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Cannot determine the RAM bank %s receives from: no %s request precedes "
+      "it in its token chain.",
+      receive->GetName(), RamLogicalChannelName(request_channel)));
+}
+
+// Rewrites the RAM described by `metadata` into banks, each a RAM of
+// `to_config` communicating over the channels in `bank_channels`.
+//
+// A request is sent to the bank its address selects. If the bank is known
+// statically only that bank's channel is used, so requests to different banks
+// do not contend for a channel and may be scheduled in the same cycle.
+// Otherwise the request is sent to every bank, predicated on the bank being the
+// selected one. Responses are received from the bank of the request which
+// precedes them in their token chain.
+absl::Status ReplaceBankedChannelReferences(
+    Package* p, const RamMetadata& metadata, RamBankingScheme scheme,
+    const RamConfig& bank_from_config,
+    absl::Span<const RamChannelMap> bank_channels) {
+  XLS_ASSIGN_OR_RETURN(ReverseRamChannelMap reverse_from_mapping,
+                       ReverseChannelMap(metadata));
+  const RamConfig& to_config = metadata.rewrite.to_config;
+  const int64_t bank_count = metadata.rewrite.banking->bank_count;
+  const BankAddressLayout layout =
+      GetBankAddressLayout(scheme, bank_count, to_config);
+  auto bank_channel_name = [&](int64_t bank, RamLogicalChannel logical_channel)
+      -> absl::StatusOr<std::string_view> {
+    XLS_ASSIGN_OR_RETURN(RamLogicalChannel new_logical_channel,
+                         MapChannel(metadata.rewrite.from_config.kind,
+                                    logical_channel, to_config.kind));
+    return ChannelRefName(
+        bank_channels[bank].at(new_logical_channel).channel_ref);
+  };
+
+  for (Proc* proc : GetRamProcs(p, metadata)) {
+    TernaryQueryEngine query_engine;
+    XLS_RETURN_IF_ERROR(query_engine.Populate(proc).status());
+    // The token of each rewritten request, and the bank it accesses.
+    absl::flat_hash_map<Node*, BankSelection> requests;
+    for (Node* node : TopoSort(proc)) {
+      XLS_ASSIGN_OR_RETURN(
+          std::optional<RamLogicalChannel> logical_channel,
+          GetRamLogicalChannel(node, metadata, reverse_from_mapping));
+      if (!logical_channel.has_value()) {
+        continue;
+      }
+      if (node->Is<Send>()) {
+        Send* send = node->As<Send>();
+        Node* payload = send->data();
+        XLS_ASSIGN_OR_RETURN(Node * addr, proc->MakeNode<TupleIndex>(
+                                              send->loc(), payload, 0));
+        XLS_ASSIGN_OR_RETURN(
+            Node * bank_index,
+            proc->MakeNode<BitSlice>(send->loc(), addr, layout.bank_start,
+                                     layout.bank_width));
+        XLS_ASSIGN_OR_RETURN(
+            Node * local_addr,
+            proc->MakeNode<BitSlice>(send->loc(), addr, layout.local_start,
+                                     layout.local_width));
+        std::vector<Node*> elements = {local_addr};
+        for (int64_t i = 1; i < payload->GetType()->AsTupleOrDie()->size();
+             ++i) {
+          XLS_ASSIGN_OR_RETURN(elements.emplace_back(),
+                               proc->MakeNode<TupleIndex>(send->loc(),
+                                                          payload, i));
+        }
+        XLS_ASSIGN_OR_RETURN(Node * bank_payload,
+                             proc->MakeNode<Tuple>(send->loc(), elements));
+        XLS_ASSIGN_OR_RETURN(
+            Node * new_payload,
+            RepackPayload(proc, bank_payload, *logical_channel,
+                          bank_from_config, to_config, metadata.data_type));
+        BankSelection selection{
+            .request_channel = *logical_channel,
+            .bank = KnownBank(query_engine, payload, layout),
+            .bank_index = bank_index,
+        };
+        std::vector<Node*> tokens;
+        for (int64_t bank : SelectedBanks(selection, bank_count)) {
+          XLS_ASSIGN_OR_RETURN(std::optional<Node*> predicate,
+                               BankPredicate(proc, send->loc(),
+                                             send->predicate(), selection,
+                                             bank));
+          XLS_ASSIGN_OR_RETURN(std::string_view channel_name,
+                               bank_channel_name(bank, *logical_channel));
+          XLS_ASSIGN_OR_RETURN(
+              tokens.emplace_back(),
+              proc->MakeNode<Send>(send->loc(), send->token(), new_payload,
+                                   predicate, channel_name));
+        }
+        Node* token = tokens.front();
+        if (tokens.size() > 1) {
+          XLS_ASSIGN_OR_RETURN(token,
+                               proc->MakeNode<AfterAll>(send->loc(), tokens));
+        }
+        XLS_RETURN_IF_ERROR(send->ReplaceUsesWith(token));
+        XLS_RETURN_IF_ERROR(proc->RemoveNode(send));
+        requests.emplace(token, selection);
+        continue;
+      }
+
+      Receive* receive = node->As<Receive>();
+      XLS_ASSIGN_OR_RETURN(
+          BankSelection selection,
+          FindBankRequest(receive, *logical_channel, requests));
+      std::vector<Node*> results;
+      for (int64_t bank : SelectedBanks(selection, bank_count)) {
+        XLS_ASSIGN_OR_RETURN(std::optional<Node*> predicate,
+                             BankPredicate(proc, receive->loc(),
+                                           receive->predicate(), selection,
+                                           bank));
+        XLS_ASSIGN_OR_RETURN(std::string_view channel_name,
+                             bank_channel_name(bank, *logical_channel));
+        XLS_ASSIGN_OR_RETURN(
+            Node * new_receive,
+            proc->MakeNode<Receive>(receive->loc(), receive->token(),
+                                    predicate, channel_name,
+                                    receive->is_blocking()));
+        XLS_ASSIGN_OR_RETURN(
+            results.emplace_back(),
+            RepackPayload(proc, new_receive, *logical_channel,
+                          bank_from_config, to_config, metadata.data_type));
+      }
+      Node* result = results.front();
+      if (results.size() > 1) {
+        // Receives from the banks not selected produce zeros and are not
+        // forwarded, but their tokens are.
+        std::vector<Node*> tokens;
+        for (Node* bank_result : results) {
+          XLS_ASSIGN_OR_RETURN(tokens.emplace_back(),
+                               proc->MakeNode<TupleIndex>(receive->loc(),
+                                                          bank_result, 0));
+        }
+        XLS_ASSIGN_OR_RETURN(Node * token, proc->MakeNode<AfterAll>(
+                                               receive->loc(), tokens));
+        XLS_ASSIGN_OR_RETURN(
+            Node * selected,
+            proc->MakeNode<Select>(receive->loc(), selection.bank_index,
+                                   results, /*default_value=*/std::nullopt));
+        std::vector<Node*> elements = {token};
+        for (int64_t i = 1; i < selected->GetType()->AsTupleOrDie()->size();
+             ++i) {
+          XLS_ASSIGN_OR_RETURN(elements.emplace_back(),
+                               proc->MakeNode<TupleIndex>(receive->loc(),
+                                                          selected, i));
+        }
+        XLS_ASSIGN_OR_RETURN(result,
+                             proc->MakeNode<Tuple>(receive->loc(), elements));
+      }
+      XLS_RETURN_IF_ERROR(receive->ReplaceUsesWith(result));
+      XLS_RETURN_IF_ERROR(proc->RemoveNode(receive));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Splits the RAM described by `metadata` into banks as described by its
+// rewrite's banking, creating the channels of each bank and rewriting the
+// procs to use them.
+absl::Status RewriteBankedRam(Package* p, const RamMetadata& metadata) {
+  const RamRewrite& rewrite = metadata.rewrite;
+  const RamBanking& banking = *rewrite.banking;
+  if (rewrite.from_config.kind != RamKind::kAbstract) {
+    return absl::UnimplementedError(
+        absl::StrFormat("Cannot bank RAM of kind %s, only abstract RAMs.",
+                        RamKindToString(rewrite.from_config.kind)));
+  }
+  if (rewrite.from_config.depth !=
+      banking.bank_count * rewrite.to_config.depth) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Banked RAM of depth %d must be split into banks of depth %d, got %d.",
+        rewrite.from_config.depth,
+        rewrite.from_config.depth / banking.bank_count,
+        rewrite.to_config.depth));
+  }
+  if (banking.scheme == RamBankingScheme::kBlock &&
+      !IsPowerOfTwo(rewrite.to_config.depth)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Block banking requires banks whose depth is a power of two, got %d.",
+        rewrite.to_config.depth));
+  }
+  XLS_ASSIGN_OR_RETURN(ReverseRamChannelMap reverse_from_mapping,
+                       ReverseChannelMap(metadata));
+  XLS_ASSIGN_OR_RETURN(
+      RamBankingScheme scheme,
+      ResolveBankingScheme(p, metadata, rewrite.to_config,
+                           reverse_from_mapping));
+  VLOG(2) << absl::StreamFormat("Banking RAM %s with %s scheme into %d banks.",
+                                rewrite.to_name_prefix,
+                                RamBankingSchemeToString(scheme),
+                                banking.bank_count);
+
+  // Each bank is the rewrite of an abstract RAM of its depth.
+  RamConfig bank_from_config = rewrite.from_config;
+  bank_from_config.depth = rewrite.to_config.depth;
+  std::vector<RamRewrite> bank_rewrites;
+  bank_rewrites.reserve(banking.bank_count);
+  for (int64_t bank = 0; bank < banking.bank_count; ++bank) {
+    RamRewrite& bank_rewrite = bank_rewrites.emplace_back(rewrite);
+    bank_rewrite.from_config = bank_from_config;
+    bank_rewrite.to_name_prefix =
+        RamBankNamePrefix(rewrite.to_name_prefix, bank);
+    bank_rewrite.banking = std::nullopt;
+  }
+  std::vector<RamChannelMap> bank_channels;
+  for (const RamRewrite& bank_rewrite : bank_rewrites) {
+    RamMetadata bank_metadata{.rewrite = bank_rewrite,
+                              .channel_map = metadata.channel_map,
+                              .strictness = metadata.strictness,
+                              .data_type = metadata.data_type,
+                              .proc_scope = metadata.proc_scope};
+    XLS_ASSIGN_OR_RETURN(bank_channels.emplace_back(),
+                         CreateChannelsForNewRam(p, bank_metadata));
+  }
+  return ReplaceBankedChannelReferences(p, metadata, scheme, bank_from_config,
+                                        bank_channels);
+}
+
 absl::Status RemoveRamChannel(Package* p, const RamChannel& ram_channel,
                               std::optional<Proc*> proc_scope) {
   if (proc_scope.has_value()) {
@@ -978,11 +1404,15 @@ absl::StatusOr<bool> RamRewritePass::RunInternal(
     XLS_ASSIGN_OR_RETURN(RamMetadata metadata,
                          GetRamMetadata(p, proc_scope, rewrite));
 
-    RamChannelMap new_logical_to_channels;
-    XLS_ASSIGN_OR_RETURN(new_logical_to_channels,
-                         CreateChannelsForNewRam(p, metadata));
-    XLS_RETURN_IF_ERROR(
-        ReplaceChannelReferences(p, metadata, new_logical_to_channels));
+    if (rewrite.banking.has_value()) {
+      XLS_RETURN_IF_ERROR(RewriteBankedRam(p, metadata));
+    } else {
+      RamChannelMap new_logical_to_channels;
+      XLS_ASSIGN_OR_RETURN(new_logical_to_channels,
+                           CreateChannelsForNewRam(p, metadata));
+      XLS_RETURN_IF_ERROR(
+          ReplaceChannelReferences(p, metadata, new_logical_to_channels));
+    }
 
     // ReplaceChannelReferences() removes old sends and receives, but the old
     // channels are still there.
@@ -38,7 +38,10 @@
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc.h"
 #include "xls/ir/value.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_pipeline.h"
@@ -51,6 +54,7 @@ namespace m = xls::op_matchers;
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
 using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
 
 class RamRewritePassTest : public IrTestBase {
  protected:
@@ -64,6 +68,17 @@ class RamRewritePassTest : public IrTestBase {
     return CreateOptimizationPassPipeline()->Run(p, options, &results);
   }
 
+  // Returns the names of the channels `proc` sends on or receives from.
+  static std::vector<std::string> ChannelOpNames(Proc* proc) {
+    std::vector<std::string> names;
+    for (Node* node : proc->nodes()) {
+      if (node->Is<ChannelNode>()) {
+        names.push_back(node->As<ChannelNode>()->channel_name());
+      }
+    }
+    return names;
+  }
+
   std::unique_ptr<TokenlessProcBuilder> MakeProcBuilder(Package* p,
                                                         std::string_view name) {
     return std::make_unique<TokenlessProcBuilder>(
@@ -797,6 +812,211 @@ TEST_F(RamRewritePassTest, MultipleAbstractTo1RWAnd1R1WRewrite) {
               m::ChannelWithType("()"));
 }
 
+TEST_F(RamRewritePassTest, BankedAbstractTo1R1WRewriteStaticBanks) {
+  auto p = std::make_unique<Package>(TestName());
+  auto pb = MakeProcBuilder(p.get(), "p");
+  RamConfig config_abstract{.kind = RamKind::kAbstract,
+                            .depth = 1024,
+                            .word_partition_size = std::nullopt,
+                            .initial_value = std::nullopt};
+  RamConfig config_1r1w = config_abstract;
+  config_1r1w.kind = RamKind::k1R1W;
+  config_1r1w.depth = 512;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      RamChannels channels,
+      MakeAbstractRam(p.get(), config_abstract, "ram_abstract",
+                      /*data_type=*/p->GetBitsType(32)));
+
+  // Address 3 is in bank 1 and address 4 in bank 0.
+  pb->Send(channels.read_req,
+           pb->Literal(Value::Tuple({Value(UBits(3, 10)), Value::Tuple({})})));
+  pb->Receive(channels.read_resp);
+  pb->Send(channels.write_req,
+           pb->Literal(Value::Tuple(
+               {Value(UBits(4, 10)), Value(UBits(0, 32)), Value::Tuple({})})));
+  pb->Receive(channels.write_resp);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb->Build({}));
+  XLS_ASSERT_OK(p->SetTopByName("p"));
+
+  std::vector<RamRewrite> ram_rewrites{RamRewrite{
+      .from_config = config_abstract,
+      .from_channels_logical_to_physical =
+          absl::flat_hash_map<std::string, std::string>{
+              {"abstract_read_req", "ram_abstract_read_req"},
+              {"abstract_read_resp", "ram_abstract_read_resp"},
+              {"abstract_write_req", "ram_abstract_write_req"},
+              {"write_completion", "ram_abstract_write_resp"},
+          },
+      .to_config = config_1r1w,
+      .to_name_prefix = "ram_1r1w",
+      .proc_name = std::nullopt,
+      .banking = RamBanking{.scheme = RamBankingScheme::kInterleaved,
+                            .bank_count = 2},
+  }};
+  EXPECT_THAT(Run(p.get(), ram_rewrites), IsOkAndHolds(true));
+  EXPECT_EQ(p->channels().size(), 8);
+  for (std::string_view bank : {"bank0", "bank1"}) {
+    EXPECT_THAT(
+        p->GetChannel(absl::StrFormat("ram_1r1w_%s_read_req", bank)).value(),
+        m::ChannelWithType("(bits[9], ())"));
+    EXPECT_THAT(
+        p->GetChannel(absl::StrFormat("ram_1r1w_%s_write_req", bank)).value(),
+        m::ChannelWithType("(bits[9], bits[32], ())"));
+  }
+  EXPECT_THAT(ChannelOpNames(proc),
+              UnorderedElementsAre("ram_1r1w_bank1_read_req",
+                                   "ram_1r1w_bank1_read_resp",
+                                   "ram_1r1w_bank0_write_req",
+                                   "ram_1r1w_bank0_write_completion"));
+}
+
+TEST_F(RamRewritePassTest, BankedAbstractTo1R1WRewriteAutoScheme) {
+  auto p = std::make_unique<Package>(TestName());
+  auto pb = MakeProcBuilder(p.get(), "p");
+  RamConfig config_abstract{.kind = RamKind::kAbstract,
+                            .depth = 1024,
+                            .word_partition_size = std::nullopt,
+                            .initial_value = std::nullopt};
+  RamConfig config_1r1w = config_abstract;
+  config_1r1w.kind = RamKind::k1R1W;
+  config_1r1w.depth = 512;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      RamChannels channels,
+      MakeAbstractRam(p.get(), config_abstract, "ram_abstract",
+                      /*data_type=*/p->GetBitsType(32)));
+
+  // Only the most significant bit of the addresses is known, so the RAM is
+  // split into blocks: reads are from bank 1 and writes to bank 0.
+  BValue index = pb->StateElement("index", Value(UBits(0, 9)));
+  pb->Send(channels.read_req,
+           pb->Tuple({pb->Concat({pb->Literal(UBits(1, 1)), index}),
+                      pb->Literal(Value::Tuple({}))}));
+  pb->Receive(channels.read_resp);
+  pb->Send(channels.write_req,
+           pb->Tuple({pb->Concat({pb->Literal(UBits(0, 1)), index}),
+                      pb->Literal(UBits(0, 32)),
+                      pb->Literal(Value::Tuple({}))}));
+  pb->Receive(channels.write_resp);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb->Build({pb->Add(index, pb->Literal(UBits(1, 9)))}));
+  XLS_ASSERT_OK(p->SetTopByName("p"));
+
+  std::vector<RamRewrite> ram_rewrites{RamRewrite{
+      .from_config = config_abstract,
+      .from_channels_logical_to_physical =
+          absl::flat_hash_map<std::string, std::string>{
+              {"abstract_read_req", "ram_abstract_read_req"},
+              {"abstract_read_resp", "ram_abstract_read_resp"},
+              {"abstract_write_req", "ram_abstract_write_req"},
+              {"write_completion", "ram_abstract_write_resp"},
+          },
+      .to_config = config_1r1w,
+      .to_name_prefix = "ram_1r1w",
+      .proc_name = std::nullopt,
+      .banking =
+          RamBanking{.scheme = RamBankingScheme::kAuto, .bank_count = 2},
+  }};
+  EXPECT_THAT(Run(p.get(), ram_rewrites), IsOkAndHolds(true));
+  EXPECT_THAT(ChannelOpNames(proc),
+              UnorderedElementsAre("ram_1r1w_bank1_read_req",
+                                   "ram_1r1w_bank1_read_resp",
+                                   "ram_1r1w_bank0_write_req",
+                                   "ram_1r1w_bank0_write_completion"));
+}
+
+TEST_F(RamRewritePassTest, BankedAbstractTo1RWRewriteDynamicBank) {
+  auto p = std::make_unique<Package>(TestName());
+  auto pb = MakeProcBuilder(p.get(), "p");
+  RamConfig config_abstract{.kind = RamKind::kAbstract,
+                            .depth = 1024,
+                            .word_partition_size = std::nullopt,
+                            .initial_value = std::nullopt};
+  RamConfig config_1rw = config_abstract;
+  config_1rw.kind = RamKind::k1RW;
+  config_1rw.depth = 256;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      RamChannels channels,
+      MakeAbstractRam(p.get(), config_abstract, "ram_abstract",
+                      /*data_type=*/p->GetBitsType(32)));
+
+  // The bank of the address is only known at runtime, so the read goes to
+  // every bank.
+  BValue addr = pb->StateElement("addr", Value(UBits(0, 10)));
+  pb->Send(channels.read_req,
+           pb->Tuple({addr, pb->Literal(Value::Tuple({}))}));
+  pb->Receive(channels.read_resp);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb->Build({pb->Add(addr, pb->Literal(UBits(1, 10)))}));
+  XLS_ASSERT_OK(p->SetTopByName("p"));
+
+  std::vector<RamRewrite> ram_rewrites{RamRewrite{
+      .from_config = config_abstract,
+      .from_channels_logical_to_physical =
+          absl::flat_hash_map<std::string, std::string>{
+              {"abstract_read_req", "ram_abstract_read_req"},
+              {"abstract_read_resp", "ram_abstract_read_resp"},
+              {"abstract_write_req", "ram_abstract_write_req"},
+              {"write_completion", "ram_abstract_write_resp"},
+          },
+      .to_config = config_1rw,
+      .to_name_prefix = "ram_1rw",
+      .proc_name = std::nullopt,
+      .banking = RamBanking{.scheme = RamBankingScheme::kInterleaved,
+                            .bank_count = 4},
+  }};
+  EXPECT_THAT(Run(p.get(), ram_rewrites), IsOkAndHolds(true));
+  EXPECT_THAT(p->GetChannel("ram_1rw_bank3_req").value(),
+              m::ChannelWithType(
+                  "(bits[8], bits[32], (), (), bits[1], bits[1])"));
+  EXPECT_THAT(ChannelOpNames(proc),
+              UnorderedElementsAre("ram_1rw_bank0_req", "ram_1rw_bank0_resp",
+                                   "ram_1rw_bank1_req", "ram_1rw_bank1_resp",
+                                   "ram_1rw_bank2_req", "ram_1rw_bank2_resp",
+                                   "ram_1rw_bank3_req", "ram_1rw_bank3_resp"));
+}
+
+TEST_F(RamRewritePassTest, BankedRewriteWithMismatchedDepth) {
+  auto p = std::make_unique<Package>(TestName());
+  auto pb = MakeProcBuilder(p.get(), "p");
+  RamConfig config_abstract{.kind = RamKind::kAbstract,
+                            .depth = 1024,
+                            .word_partition_size = std::nullopt,
+                            .initial_value = std::nullopt};
+  RamConfig config_1rw = config_abstract;
+  config_1rw.kind = RamKind::k1RW;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      RamChannels channels,
+      MakeAbstractRam(p.get(), config_abstract, "ram_abstract",
+                      /*data_type=*/p->GetBitsType(32)));
+  pb->Send(channels.read_req,
+           pb->Literal(Value::Tuple({Value(UBits(0, 10)), Value::Tuple({})})));
+  pb->Receive(channels.read_resp);
+  XLS_ASSERT_OK(pb->Build({}).status());
+  XLS_ASSERT_OK(p->SetTopByName("p"));
+
+  std::vector<RamRewrite> ram_rewrites{RamRewrite{
+      .from_config = config_abstract,
+      .from_channels_logical_to_physical =
+          absl::flat_hash_map<std::string, std::string>{
+              {"abstract_read_req", "ram_abstract_read_req"},
+              {"abstract_read_resp", "ram_abstract_read_resp"},
+              {"abstract_write_req", "ram_abstract_write_req"},
+              {"write_completion", "ram_abstract_write_resp"},
+          },
+      .to_config = config_1rw,
+      .to_name_prefix = "ram_1rw",
+      .proc_name = std::nullopt,
+      .banking = RamBanking{.scheme = RamBankingScheme::kInterleaved,
+                            .bank_count = 2},
+  }};
+  EXPECT_THAT(Run(p.get(), ram_rewrites),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("must be split into banks of depth 512")));
+}
+
 TEST_F(RamRewritePassTest, SingleAbstractTo1RWRewriteProcScoped) {
   auto p = std::make_unique<Package>(TestName());
   TokenlessProcBuilder pb(NewStyleProc(), TestName(), "tkn", p.get());
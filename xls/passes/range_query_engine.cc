@@ -28,6 +28,8 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
@@ -42,6 +44,7 @@
 #include "xls/ir/bits.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/dfs_visitor.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/interval.h"
 #include "xls/ir/interval_ops.h"
 #include "xls/ir/interval_set.h"
@@ -49,6 +52,7 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
 #include "xls/ir/ternary.h"
+#include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
@@ -111,9 +115,6 @@ class RangeQueryVisitor : public DfsVisitor {
   // precision of the analysis.
   static constexpr int64_t kMaxResIntervalSetSize = 64;
 
-  // What size we should minimize interval sets to by default.
-  static constexpr int64_t kDefaultIntervalSize = 16;
-
   // The maximum number of points covered by an interval set that can be
   // iterated over in an analysis.
   static constexpr int64_t kMaxIterationSize = 1024;
@@ -291,13 +292,112 @@ class RangeQueryVisitor : public DfsVisitor {
   ReachedFixpoint rf_;
 };
 
+namespace {
+
+// Visits only the given nodes, in topological order.
+class ConeProvider final : public RangeDataProvider {
+ public:
+  ConeProvider(FunctionBase* function, const absl::flat_hash_set<Node*>& cone)
+      : function_(function), cone_(cone) {}
+
+  std::optional<RangeData> GetKnownIntervals(Node* node) override {
+    return std::nullopt;
+  }
+
+  absl::Status IterateFunction(DfsVisitor* visitor) override {
+    for (Node* node : TopoSort(function_)) {
+      if (cone_.contains(node)) {
+        XLS_RETURN_IF_ERROR(node->VisitSingleNode(visitor));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  FunctionBase* function_;
+  const absl::flat_hash_set<Node*>& cone_;
+};
+
+}  // namespace
+
+absl::StatusOr<ReachedFixpoint> RangeQueryEngine::Populate(FunctionBase* f) {
+  NoGivensProvider givens(f);
+  XLS_ASSIGN_OR_RETURN(ReachedFixpoint rf, PopulateWithGivens(givens));
+  populated_function_ = f;
+  populated_epoch_ = f->NewChangeEpoch();
+  return rf;
+}
+
 absl::StatusOr<ReachedFixpoint> RangeQueryEngine::PopulateWithGivens(
     RangeDataProvider& givens) {
+  populated_function_ = nullptr;
   RangeQueryVisitor visitor(this, givens);
   XLS_RETURN_IF_ERROR(givens.IterateFunction(&visitor));
   return visitor.GetReachedFixpoint();
 }
 
+absl::StatusOr<ReachedFixpoint> RangeQueryEngine::Update(FunctionBase* f) {
+  if (populated_function_ != f) {
+    known_bits_.clear();
+    known_bit_values_.clear();
+    interval_sets_.clear();
+    return Populate(f);
+  }
+  std::vector<Node*> changed = f->NodesChangedSince(populated_epoch_);
+  if (f->NodesRemovedSince(populated_epoch_)) {
+    absl::flat_hash_set<Node*> live(f->nodes().begin(), f->nodes().end());
+    auto is_dead = [&](const auto& entry) {
+      return !live.contains(entry.first);
+    };
+    absl::erase_if(known_bits_, is_dead);
+    absl::erase_if(known_bit_values_, is_dead);
+    absl::erase_if(interval_sets_, is_dead);
+  }
+  populated_epoch_ = f->NewChangeEpoch();
+
+  // Only the forward cone of the changed nodes can have different values.
+  absl::flat_hash_set<Node*> cone(changed.begin(), changed.end());
+  std::vector<Node*> worklist = std::move(changed);
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    for (Node* user : node->users()) {
+      if (cone.insert(user).second) {
+        worklist.push_back(user);
+      }
+    }
+  }
+  if (cone.empty()) {
+    return ReachedFixpoint::Unchanged;
+  }
+
+  // Setting the intervals of a node narrows (intersects) any it already has,
+  // so the previous values of the cone are cleared before re-evaluating it.
+  absl::flat_hash_map<Node*, IntervalSetTree> previous;
+  for (Node* node : cone) {
+    if (auto it = interval_sets_.find(node); it != interval_sets_.end()) {
+      previous.emplace(node, std::move(it->second));
+      interval_sets_.erase(it);
+    }
+    known_bits_.erase(node);
+    known_bit_values_.erase(node);
+  }
+  ConeProvider provider(f, cone);
+  RangeQueryVisitor visitor(this, provider);
+  XLS_RETURN_IF_ERROR(provider.IterateFunction(&visitor));
+
+  for (Node* node : cone) {
+    auto old_it = previous.find(node);
+    auto new_it = interval_sets_.find(node);
+    bool had_old = old_it != previous.end();
+    bool has_new = new_it != interval_sets_.end();
+    if (had_old != has_new || (has_new && old_it->second != new_it->second)) {
+      return ReachedFixpoint::Changed;
+    }
+  }
+  return ReachedFixpoint::Unchanged;
+}
+
 IntervalSetTree RangeQueryEngine::GetIntervalSetTree(Node* node) const {
   if (interval_sets_.contains(node)) {
     return interval_sets_.at(node);
@@ -507,7 +607,7 @@ absl::Status RangeQueryVisitor::HandleDecode(Decode* decode) {
   return SetIntervalSet(decode,
                         interval_ops::MinimizeIntervals(
                             interval_ops::Decode(a, decode->BitCountOrDie()),
-                            kDefaultIntervalSize));
+                            engine_->max_interval_count()));
 }
 
 absl::Status RangeQueryVisitor::HandleDynamicBitSlice(
@@ -1032,8 +1132,8 @@ absl::Status RangeQueryVisitor::HandleOneHotSel(OneHotSelect* sel) {
   }
 
   for (IntervalSet& intervals : result.elements()) {
-    intervals =
-        interval_ops::MinimizeIntervals(intervals, kDefaultIntervalSize);
+    intervals = interval_ops::MinimizeIntervals(intervals,
+                                                engine_->max_interval_count());
   }
   SetIntervalSetTree(sel, std::move(result));
   return absl::OkStatus();
@@ -1085,8 +1185,8 @@ absl::Status RangeQueryVisitor::HandlePrioritySel(PrioritySelect* sel) {
     }
   }
   for (IntervalSet& intervals : result.elements()) {
-    intervals =
-        interval_ops::MinimizeIntervals(intervals, kDefaultIntervalSize);
+    intervals = interval_ops::MinimizeIntervals(intervals,
+                                                engine_->max_interval_count());
   }
   SetIntervalSetTree(sel, std::move(result));
   return absl::OkStatus();
@@ -1236,8 +1336,8 @@ absl::Status RangeQueryVisitor::HandleSel(Select* sel) {
   XLS_RETURN_IF_ERROR(status);
 
   for (IntervalSet& intervals : result.elements()) {
-    intervals =
-        interval_ops::MinimizeIntervals(intervals, kDefaultIntervalSize);
+    intervals = interval_ops::MinimizeIntervals(intervals,
+                                                engine_->max_interval_count());
   }
   SetIntervalSetTree(sel, std::move(result));
   return absl::OkStatus();
@@ -22,6 +22,7 @@
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
@@ -102,8 +103,21 @@ class NoGivensProvider final : public RangeDataProvider {
 // A query engine which tracks sets of intervals that a value can be in.
 class RangeQueryEngine : public QueryEngine {
  public:
+  // The default bound on the number of intervals kept for each leaf of a
+  // node's value.
+  static constexpr int64_t kDefaultMaxIntervalCount = 16;
+
   // Create a `RangeQueryEngine` that contains no data.
   RangeQueryEngine() = default;
+
+  // Create a `RangeQueryEngine` that contains no data and which merges the
+  // closest intervals of the interval sets it computes for selects, decodes
+  // and the like down to at most `max_interval_count` intervals. Fewer
+  // intervals make the analysis faster and less precise.
+  explicit RangeQueryEngine(int64_t max_interval_count)
+      : max_interval_count_(max_interval_count) {
+    CHECK_GT(max_interval_count, 0);
+  }
   RangeQueryEngine(RangeQueryEngine&&) = default;
   RangeQueryEngine(const RangeQueryEngine&) = default;
   RangeQueryEngine& operator=(const RangeQueryEngine&) = default;
@@ -111,10 +125,7 @@ class RangeQueryEngine : public QueryEngine {
 
   // Populate the data in this `RangeQueryEngine` using the
   // given `FunctionBase*`;
-  absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override {
-    NoGivensProvider givens(f);
-    return PopulateWithGivens(givens);
-  }
+  absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
   // Populate the data in this `RangeQueryEngine givens` with the data returned
   // by `RangeGivensHelper` taken as a given. If `givens` is null proceed as
@@ -122,6 +133,14 @@ class RangeQueryEngine : public QueryEngine {
   // std::nullopt and `ShouldContinue` always returns true)
   absl::StatusOr<ReachedFixpoint> PopulateWithGivens(RangeDataProvider& givens);
 
+  // Brings the engine up to date with the changes made to `f` since the last
+  // call to Populate or Update. Only the nodes changed since then and the
+  // nodes they transitively feed are re-evaluated; the re-evaluated values
+  // replace the previous ones so the result is the same as populating a new
+  // engine with `f`. Falls back to populating from scratch if the engine was
+  // not last populated by Populate(f).
+  absl::StatusOr<ReachedFixpoint> Update(FunctionBase* f);
+
   bool IsTracked(Node* node) const override {
     return known_bits_.contains(node);
   }
@@ -238,12 +257,21 @@ class RangeQueryEngine : public QueryEngine {
   Bits MaxUnsignedValue(Node* n) const override;
   Bits MinUnsignedValue(Node* n) const override;
 
+  int64_t max_interval_count() const { return max_interval_count_; }
+
  private:
   friend class RangeQueryVisitor;
 
+  int64_t max_interval_count_ = kDefaultMaxIntervalCount;
+
   absl::flat_hash_map<Node*, Bits> known_bits_;
   absl::flat_hash_map<Node*, Bits> known_bit_values_;
   absl::flat_hash_map<Node*, IntervalSetTree> interval_sets_;
+
+  // The function the engine was last populated or updated with (without
+  // givens) and the change epoch of that function at the time.
+  FunctionBase* populated_function_ = nullptr;
+  int64_t populated_epoch_ = 0;
 };
 
 std::string IntervalSetTreeToString(const IntervalSetTree& tree);
@@ -45,7 +45,9 @@
 #include "xls/ir/interval_set_test_utils.h"
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
 #include "xls/ir/ternary.h"
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/type.h"
@@ -55,6 +57,8 @@
 namespace xls {
 namespace {
 
+using ::absl_testing::IsOkAndHolds;
+
 class RangeQueryEngineTest : public IrTestBase {};
 
 IntervalSet CreateIntervalSet(
@@ -1461,6 +1465,37 @@ TEST_F(RangeQueryEngineTest, Sel) {
             engine.GetIntervalSetTree(expr.node()).Get({}));
 }
 
+TEST_F(RangeQueryEngineTest, SelWithMaxIntervalCount) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+
+  BValue selector = fb.Param("selector", p->GetBitsType(1));
+  BValue x = fb.Param("x", p->GetBitsType(10));
+  BValue y = fb.Param("y", p->GetBitsType(10));
+  BValue expr = fb.Select(selector, {x, y});
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  IntervalSetTree x_ist =
+      BitsLTT(x.node(), {Interval(UBits(100, 10), UBits(150, 10))});
+  IntervalSetTree y_ist =
+      BitsLTT(y.node(), {Interval(UBits(200, 10), UBits(250, 10))});
+
+  // The two cases are merged into their convex hull.
+  RangeQueryEngine engine(/*max_interval_count=*/1);
+  engine.SetIntervalSetTree(x.node(), x_ist);
+  engine.SetIntervalSetTree(y.node(), y_ist);
+  XLS_ASSERT_OK(engine.Populate(f));
+  EXPECT_EQ(engine.GetIntervalSetTree(expr.node()).Get({}),
+            IntervalSet::Of({Interval(UBits(100, 10), UBits(250, 10))}));
+
+  engine = RangeQueryEngine(/*max_interval_count=*/2);
+  engine.SetIntervalSetTree(x.node(), x_ist);
+  engine.SetIntervalSetTree(y.node(), y_ist);
+  XLS_ASSERT_OK(engine.Populate(f));
+  EXPECT_EQ(engine.GetIntervalSetTree(expr.node()).Get({}),
+            IntervalSet::Combine(x_ist.Get({}), y_ist.Get({})));
+}
+
 TEST_F(RangeQueryEngineTest, SelHugeSelector) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -2603,5 +2638,40 @@ TEST_F(RangeQueryEngineTest, MaxMinUnsignedValue) {
   EXPECT_EQ(engine.MinUnsignedValue(xy.node()), UBits(3, 8));
 }
 
+TEST_F(RangeQueryEngineTest, UpdateAfterChange) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue mask = fb.Literal(UBits(15, 8));
+  BValue masked = fb.And(x, mask);
+  BValue sum = fb.Add(masked, fb.Literal(UBits(1, 8)));
+  BValue other = fb.UMod(x, fb.Literal(UBits(10, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  RangeQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(f));
+  EXPECT_EQ(engine.MaxUnsignedValue(sum.node()), UBits(16, 8));
+  EXPECT_THAT(engine.Update(f), IsOkAndHolds(ReachedFixpoint::Unchanged));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * narrower_mask,
+      f->MakeNode<Literal>(SourceInfo(), Value(UBits(3, 8))));
+  ASSERT_TRUE(masked.node()->ReplaceOperand(mask.node(), narrower_mask));
+  XLS_ASSERT_OK(f->RemoveNode(mask.node()));
+  EXPECT_THAT(engine.Update(f), IsOkAndHolds(ReachedFixpoint::Changed));
+  EXPECT_EQ(engine.MaxUnsignedValue(sum.node()), UBits(4, 8));
+  EXPECT_EQ(engine.MinUnsignedValue(sum.node()), UBits(1, 8));
+
+  RangeQueryEngine fresh_engine;
+  XLS_ASSERT_OK(fresh_engine.Populate(f));
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(IntervalSetTreeToString(engine.GetIntervalSetTree(node)),
+              IntervalSetTreeToString(fresh_engine.GetIntervalSetTree(node)))
+        << node;
+  }
+  EXPECT_EQ(engine.MaxUnsignedValue(other.node()),
+            fresh_engine.MaxUnsignedValue(other.node()));
+}
+
 }  // namespace
 }  // namespace xls
@@ -97,26 +97,37 @@ struct AddSubLeaf {
   bool negated;
   Node* node;
 };
-absl::Status GatherAddsAndSubtracts(Node* node, bool negated,
+//
+// Operands with more than one user are leaves, so that every add and subtract
+// is an interior node of exactly one expression; otherwise expressions sharing
+// subexpressions would each walk them, which is quadratic in long chains of
+// partial sums.
+absl::Status GatherAddsAndSubtracts(Node* root,
                                     std::vector<AddSubLeaf>* leaves,
                                     std::vector<Node*>* interior_nodes) {
-  if ((node->op() != Op::kAdd && node->op() != Op::kSub) ||
-      !NodeAndOperandsSameType(node)) {
-    // 'node' is not an add or subtract or has differently typed operads.
-    leaves->push_back(AddSubLeaf{negated, node});
-    return absl::OkStatus();
-  }
+  // The tree is walked with an explicit stack, as it may be very deep.
+  std::vector<AddSubLeaf> stack = {AddSubLeaf{false, root}};
+  while (!stack.empty()) {
+    auto [negated, node] = stack.back();
+    stack.pop_back();
+    if ((node->op() != Op::kAdd && node->op() != Op::kSub) ||
+        !NodeAndOperandsSameType(node) ||
+        (node != root && !HasSingleUse(node))) {
+      // 'node' is not an add or subtract, has differently typed operands or is
+      // shared with other expressions.
+      leaves->push_back(AddSubLeaf{negated, node});
+      continue;
+    }
 
-  interior_nodes->push_back(node);
+    interior_nodes->push_back(node);
 
-  XLS_RET_CHECK_EQ(node->operand_count(), 2);
-  for (int64_t operand_no = 0; operand_no < 2; ++operand_no) {
-    Node* operand = node->operand(operand_no);
-    // Subtraction negates it's second operand (operand number 1).
-    bool negated_next =
-        (operand_no == 1 && node->op() == Op::kSub) ? !negated : negated;
-    XLS_RETURN_IF_ERROR(
-        GatherAddsAndSubtracts(operand, negated_next, leaves, interior_nodes));
+    XLS_RET_CHECK_EQ(node->operand_count(), 2);
+    // Subtraction negates it's second operand (operand number 1). The operands
+    // are pushed in reverse so they are visited in order.
+    stack.push_back(
+        AddSubLeaf{node->op() == Op::kSub ? !negated : negated,
+                   node->operand(1)});
+    stack.push_back(AddSubLeaf{negated, node->operand(0)});
   }
   return absl::OkStatus();
 }
@@ -133,12 +144,13 @@ absl::Status GatherAddsAndSubtracts(Node* node, bool negated,
 // TODO(meheff): 2021-01-27 Use n-ary adds when they are supported.
 absl::StatusOr<Node*> CreateSum(absl::Span<Node* const> nodes) {
   XLS_RET_CHECK(!nodes.empty());
-  if (nodes.size() == 1) {
-    return nodes.front();
+  Node* sum = nodes.back();
+  for (auto it = nodes.rbegin() + 1; it != nodes.rend(); ++it) {
+    Node* lhs = *it;
+    XLS_ASSIGN_OR_RETURN(sum, lhs->function_base()->MakeNode<BinOp>(
+                                  lhs->loc(), lhs, sum, Op::kAdd));
   }
-  Node* lhs = nodes.front();
-  XLS_ASSIGN_OR_RETURN(Node * rhs, CreateSum(nodes.subspan(1)));
-  return lhs->function_base()->MakeNode<BinOp>(lhs->loc(), lhs, rhs, Op::kAdd);
+  return sum;
 }
 
 // Attempts to simplify expressions containing adds and subtracts using
@@ -182,8 +194,7 @@ absl::StatusOr<bool> ReassociateSubtracts(FunctionBase* f,
 
     std::vector<AddSubLeaf> leaves;
     std::vector<Node*> interior_nodes;
-    XLS_RETURN_IF_ERROR(GatherAddsAndSubtracts(node, /*negated=*/false, &leaves,
-                                               &interior_nodes));
+    XLS_RETURN_IF_ERROR(GatherAddsAndSubtracts(node, &leaves, &interior_nodes));
 
     // Count the number of subtraction operations in the tree, and mark any
     // interior nodes as visited so they are not traverse in later iterations.
@@ -277,8 +288,16 @@ absl::StatusOr<bool> ReassociateSubtracts(FunctionBase* f,
   return changed;
 }
 
+// A node to visit when walking an expression tree, at `depth` below the root;
+// `is_leaf` if it is known to be a leaf of the tree.
+struct TreeWalkEntry {
+  Node* node;
+  int64_t depth;
+  bool is_leaf = false;
+};
+
 // Walks an expression tree of full-width additions using the given
-// `extension_op`. 'node' is the node currently being visited.  The leaves of
+// `extension_op`. 'root' is the root of the tree.  The leaves of
 // the expression tree are added to 'leaves', and the interior nodes of the tree
 // are added to 'interior_nodes'. Returns the height of the tree.
 //
@@ -307,36 +326,45 @@ absl::StatusOr<bool> ReassociateSubtracts(FunctionBase* f,
 //
 // And the function would return 2, the depth of the tree (not counting the
 // leaves or the extensions).
-int64_t GatherFullWidthAdditionLeaves(Op extension_op, Node* node,
+int64_t GatherFullWidthAdditionLeaves(Op extension_op, Node* root,
                                       std::vector<Node*>* leaves,
                                       std::vector<Node*>* interior_nodes) {
-  if (!IsFullWidthAddition(node) || node->operand(0)->op() != extension_op) {
-    // 'node' is not a full-width addition of the same type and is therefore a
-    // leaf.
-    leaves->push_back(node);
-    return 0;
-  }
-  // 'node' could be an interior node in the tree of full-width additions.
-  // Traverse into the operands if the operand & its extension are both
-  // single-use; otherwise the operand is a leaf.
-  interior_nodes->push_back(node);
-  int64_t max_depth = 1;
-  for (Node* extension : node->operands()) {
-    Node* operand = extension->operand(0);
-    // TODO(meheff): 2021-01-27 Consider handling cases with more than one user.
-    if (HasSingleUse(extension) && HasSingleUse(operand)) {
-      max_depth = std::max(
-          max_depth, 1 + GatherFullWidthAdditionLeaves(extension_op, operand,
-                                                       leaves, interior_nodes));
-    } else {
-      leaves->push_back(operand);
+  // The tree is walked with an explicit stack, as it may be very deep.
+  int64_t max_depth = 0;
+  std::vector<TreeWalkEntry> stack = {{.node = root, .depth = 0}};
+  while (!stack.empty()) {
+    auto [node, depth, is_leaf] = stack.back();
+    stack.pop_back();
+    if (is_leaf || !IsFullWidthAddition(node) ||
+        node->operand(0)->op() != extension_op) {
+      // 'node' is not a full-width addition of the same type and is therefore
+      // a leaf.
+      leaves->push_back(node);
+      continue;
+    }
+    // 'node' could be an interior node in the tree of full-width additions.
+    // Traverse into the operands if the operand & its extension are both
+    // single-use; otherwise the operand is a leaf.
+    interior_nodes->push_back(node);
+    max_depth = std::max(max_depth, depth + 1);
+    // Leaves are reported in operand order, so push the operands in reverse.
+    for (auto it = node->operands().rbegin(); it != node->operands().rend();
+         ++it) {
+      Node* extension = *it;
+      Node* operand = extension->operand(0);
+      // TODO(meheff): 2021-01-27 Consider handling cases with more than one
+      // user.
+      stack.push_back(
+          {.node = operand,
+           .depth = depth + 1,
+           .is_leaf = !HasSingleUse(extension) || !HasSingleUse(operand)});
     }
   }
   return max_depth;
 }
 
 // Walks an expression tree of operations with the given op and bit
-// width. 'node' is the node currently being visited.  The leaves of the
+// width. 'root' is the root of the tree.  The leaves of the
 // expression tree are added to 'leaves', and the interior nodes of the tree are
 // added to 'interior_nodes'. Returns the height of the tree.
 //
@@ -355,26 +383,32 @@ int64_t GatherFullWidthAdditionLeaves(Op extension_op, Node* node,
 //
 // And the function would return 2, the depth of the tree (not counting the
 // leaves).
-int64_t GatherExpressionLeaves(Op op, Node* node, std::vector<Node*>* leaves,
+int64_t GatherExpressionLeaves(Op op, Node* root, std::vector<Node*>* leaves,
                                std::vector<Node*>* interior_nodes) {
-  if (node->op() != op || !NodeAndOperandsSameType(node)) {
-    // 'node' does not match the other nodes of the tree and is thus a leaf.
-    leaves->push_back(node);
-    return 0;
-  }
-  // 'node' is an interior node in the tree of identical operations. Traverse
-  // into the operands if the operand has a single use, otherwise the operand is
-  // a leaf.
-  interior_nodes->push_back(node);
-  int64_t max_depth = 1;
-  for (Node* operand : node->operands()) {
-    // TODO(meheff): 2021-01-27 Consider handling cases with more than one user.
-    if (HasSingleUse(operand)) {
-      max_depth = std::max(
-          max_depth,
-          1 + GatherExpressionLeaves(op, operand, leaves, interior_nodes));
-    } else {
-      leaves->push_back(operand);
+  // The tree is walked with an explicit stack, as it may be very deep.
+  int64_t max_depth = 0;
+  std::vector<TreeWalkEntry> stack = {{.node = root, .depth = 0}};
+  while (!stack.empty()) {
+    auto [node, depth, is_leaf] = stack.back();
+    stack.pop_back();
+    if (is_leaf || node->op() != op || !NodeAndOperandsSameType(node)) {
+      // 'node' does not match the other nodes of the tree and is thus a leaf.
+      leaves->push_back(node);
+      continue;
+    }
+    // 'node' is an interior node in the tree of identical operations. Traverse
+    // into the operands if the operand has a single use, otherwise the operand
+    // is a leaf.
+    interior_nodes->push_back(node);
+    max_depth = std::max(max_depth, depth + 1);
+    // Leaves are reported in operand order, so push the operands in reverse.
+    for (auto it = node->operands().rbegin(); it != node->operands().rend();
+         ++it) {
+      // TODO(meheff): 2021-01-27 Consider handling cases with more than one
+      // user.
+      stack.push_back({.node = *it,
+                       .depth = depth + 1,
+                       .is_leaf = !HasSingleUse(*it)});
     }
   }
   return max_depth;
@@ -14,10 +14,12 @@
 
 #include "xls/passes/reassociation_pass.h"
 
+#include <algorithm>
 #include <cstdint>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
@@ -26,7 +28,10 @@
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
 #include "xls/ir/package.h"
+#include "xls/ir/topo_sort.h"
 #include "xls/ir/value.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
@@ -239,6 +244,28 @@ TEST_F(ReassociationPassTest, DeepChain) {
   ASSERT_THAT(Run(p.get()), IsOkAndHolds(true));
 }
 
+TEST_F(ReassociationPassTest, VeryDeepChain) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue lhs = x;
+  for (int64_t i = 1; i < 100000; ++i) {
+    lhs = fb.Add(lhs, x);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  ASSERT_THAT(Run(p.get()), IsOkAndHolds(true));
+
+  absl::flat_hash_map<Node*, int64_t> depth;
+  for (Node* node : TopoSort(f)) {
+    int64_t operand_depth = 0;
+    for (Node* operand : node->operands()) {
+      operand_depth = std::max(operand_depth, depth.at(operand));
+    }
+    depth[node] = node->op() == Op::kAdd ? operand_depth + 1 : operand_depth;
+  }
+  EXPECT_EQ(depth.at(f->return_value()), 17);
+}
+
 TEST_F(ReassociationPassTest, DeepChainOfFullWidthUnsignedAdds) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -415,5 +442,24 @@ TEST_F(ReassociationPassTest, SubOfSub) {
               m::Sub(m::Add(m::Param("x"), m::Param("z")), m::Param("y")));
 }
 
+TEST_F(ReassociationPassTest, SharedPartialDifference) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  Type* u32 = p->GetBitsType(32);
+  BValue a_minus_b = fb.Subtract(fb.Param("a", u32), fb.Param("b", u32));
+  BValue c = fb.Param("c", u32);
+  BValue d = fb.Param("d", u32);
+  fb.Tuple({fb.Subtract(fb.Subtract(a_minus_b, c), d), a_minus_b});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  ASSERT_THAT(Run(p.get()), IsOkAndHolds(true));
+  // The shared difference is a leaf of the expression using it rather than
+  // being reassociated into it.
+  EXPECT_THAT(
+      f->return_value(),
+      m::Tuple(m::Sub(m::Sub(m::Param("a"), m::Param("b")),
+                      m::Add(m::Param("c"), m::Param("d"))),
+               m::Sub(m::Param("a"), m::Param("b"))));
+}
+
 }  // namespace
 }  // namespace xls
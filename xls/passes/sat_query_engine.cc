@@ -0,0 +1,195 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/sat_query_engine.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/passes/query_engine.h"
+#include "xls/solvers/z3_ir_translator.h"
+#include "xls/solvers/z3_utils.h"
+#include "z3/src/api/z3_api.h"
+
+namespace xls {
+
+SatQueryEngine::~SatQueryEngine() {
+  if (solver_ != nullptr) {
+    Z3_solver_dec_ref(translator_->ctx(), solver_);
+  }
+}
+
+absl::StatusOr<ReachedFixpoint> SatQueryEngine::Populate(FunctionBase* f) {
+  if (solver_ != nullptr) {
+    Z3_solver_dec_ref(translator_->ctx(), solver_);
+    solver_ = nullptr;
+  }
+  translator_.reset();
+  memo_.clear();
+  function_base_ = f;
+  return ReachedFixpoint::Unknown;
+}
+
+bool SatQueryEngine::ConeIsSmallEnough(
+    absl::Span<TreeBitLocation const> bits) const {
+  absl::flat_hash_set<Node*> visited;
+  std::vector<Node*> worklist;
+  for (const TreeBitLocation& bit : bits) {
+    worklist.push_back(bit.node());
+  }
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    if (!visited.insert(node).second) {
+      continue;
+    }
+    if (visited.size() > max_cone_size_) {
+      return false;
+    }
+    worklist.insert(worklist.end(), node->operands().begin(),
+                    node->operands().end());
+  }
+  return true;
+}
+
+std::optional<Z3_ast> SatQueryEngine::GetBit(const TreeBitLocation& bit) const {
+  if (!bit.tree_index().empty() || !bit.node()->GetType()->IsBits() ||
+      bit.node()->function_base() != function_base_) {
+    return std::nullopt;
+  }
+  Z3_context ctx = translator_->ctx();
+  solvers::z3::ScopedErrorHandler seh(ctx);
+  absl::Status status = bit.node()->Accept(translator_.get());
+  if (!status.ok() || !seh.status().ok()) {
+    VLOG(2) << "Unable to translate " << bit.node()->GetName()
+            << " to Z3: " << (status.ok() ? seh.status() : status);
+    return std::nullopt;
+  }
+  Z3_ast value = translator_->GetTranslation(bit.node());
+  return solvers::z3::BitVectorToBoolean(
+      ctx, Z3_mk_extract(ctx, bit.bit_index(), bit.bit_index(), value));
+}
+
+Z3_ast SatQueryEngine::Counterexample(QueryKind kind,
+                                      absl::Span<const Z3_ast> bits) const {
+  Z3_context ctx = translator_->ctx();
+  switch (kind) {
+    case QueryKind::kAtMostOneTrue:
+      return Z3_mk_not(ctx, Z3_mk_atmost(ctx, bits.size(), bits.data(), 1));
+    case QueryKind::kAtLeastOneTrue:
+      return Z3_mk_not(ctx, Z3_mk_or(ctx, bits.size(), bits.data()));
+    case QueryKind::kImplies: {
+      Z3_ast a_and_not_b[] = {bits[0], Z3_mk_not(ctx, bits[1])};
+      return Z3_mk_and(ctx, 2, a_and_not_b);
+    }
+    case QueryKind::kKnownEquals:
+      return Z3_mk_xor(ctx, bits[0], bits[1]);
+    case QueryKind::kKnownNotEquals:
+      return Z3_mk_eq(ctx, bits[0], bits[1]);
+  }
+  LOG(FATAL) << "Unknown query kind";
+}
+
+bool SatQueryEngine::Prove(QueryKind kind,
+                           absl::Span<TreeBitLocation const> bits) const {
+  auto key = std::make_pair(
+      kind, std::vector<TreeBitLocation>(bits.begin(), bits.end()));
+  if (auto it = memo_.find(key); it != memo_.end()) {
+    return it->second;
+  }
+  if (function_base_ == nullptr || !ConeIsSmallEnough(bits)) {
+    return false;
+  }
+
+  if (translator_ == nullptr) {
+    absl::StatusOr<std::unique_ptr<solvers::z3::IrTranslator>> translator =
+        solvers::z3::IrTranslator::CreateAndTranslate(
+            /*source=*/nullptr, /*allow_unsupported=*/true);
+    if (!translator.ok()) {
+      return false;
+    }
+    translator_ = *std::move(translator);
+    translator_->SetRlimit(rlimit_);
+    solver_ = solvers::z3::CreateSolver(translator_->ctx(), 1);
+  }
+
+  std::vector<Z3_ast> z3_bits;
+  z3_bits.reserve(bits.size());
+  for (const TreeBitLocation& bit : bits) {
+    std::optional<Z3_ast> z3_bit = GetBit(bit);
+    if (!z3_bit.has_value()) {
+      memo_[key] = false;
+      return false;
+    }
+    z3_bits.push_back(*z3_bit);
+  }
+
+  Z3_context ctx = translator_->ctx();
+  Z3_solver_push(ctx, solver_);
+  Z3_solver_assert(ctx, solver_, Counterexample(kind, z3_bits));
+  Z3_lbool satisfiable = Z3_solver_check(ctx, solver_);
+  Z3_solver_pop(ctx, solver_, 1);
+  ++solver_query_count_;
+  if (satisfiable == Z3_L_UNDEF) {
+    VLOG(3) << "Z3 ran out of resources proving query over "
+            << bits.front().node()->GetName();
+  }
+  bool proven = satisfiable == Z3_L_FALSE;
+  memo_[key] = proven;
+  return proven;
+}
+
+bool SatQueryEngine::AtMostOneTrue(
+    absl::Span<TreeBitLocation const> bits) const {
+  if (bits.size() <= 1) {
+    return true;
+  }
+  return Prove(QueryKind::kAtMostOneTrue, bits);
+}
+
+bool SatQueryEngine::AtLeastOneTrue(
+    absl::Span<TreeBitLocation const> bits) const {
+  if (bits.empty()) {
+    return false;
+  }
+  return Prove(QueryKind::kAtLeastOneTrue, bits);
+}
+
+bool SatQueryEngine::Implies(const TreeBitLocation& a,
+                             const TreeBitLocation& b) const {
+  return Prove(QueryKind::kImplies, {a, b});
+}
+
+bool SatQueryEngine::KnownEquals(const TreeBitLocation& a,
+                                 const TreeBitLocation& b) const {
+  return Prove(QueryKind::kKnownEquals, {a, b});
+}
+
+bool SatQueryEngine::KnownNotEquals(const TreeBitLocation& a,
+                                    const TreeBitLocation& b) const {
+  return Prove(QueryKind::kKnownNotEquals, {a, b});
+}
+
+}  // namespace xls
@@ -0,0 +1,139 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef XLS_PASSES_SAT_QUERY_ENGINE_H_
+#define XLS_PASSES_SAT_QUERY_ENGINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/data_structures/leaf_type_tree.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/ternary.h"
+#include "xls/passes/query_engine.h"
+#include "xls/solvers/z3_ir_translator.h"
+#include "z3/src/api/z3_api.h"
+
+namespace xls {
+
+// A query engine which answers questions about the relationships between bits
+// (implication, equality and mutual exclusion) by proving them with Z3. Unlike
+// BDDs, the cost of a query does not depend on the size of the expressions
+// involved so arithmetic and comparisons are handled precisely, but each query
+// is a solver call. Queries are therefore only attempted when the combined
+// cone of the nodes involved has at most `max_cone_size` nodes, each query may
+// use at most `rlimit` units of solver resources (an rlimit of zero is
+// unlimited), and answers are memoized. A query which is not attempted or
+// which exhausts its budget answers conservatively.
+//
+// The function is translated lazily, one cone at a time, into a single Z3
+// context and queries are made with push/pop on a single incremental solver.
+// The engine provides no knowledge about individual bits (GetTernary returns
+// std::nullopt) and is meant to be combined with other engines in a
+// UnionQueryEngine.
+class SatQueryEngine : public QueryEngine {
+ public:
+  static constexpr int64_t kDefaultMaxConeSize = 1024;
+  static constexpr int64_t kDefaultRlimit = 100000;
+
+  explicit SatQueryEngine(int64_t max_cone_size = kDefaultMaxConeSize,
+                          int64_t rlimit = kDefaultRlimit)
+      : max_cone_size_(max_cone_size), rlimit_(rlimit) {}
+  ~SatQueryEngine() override;
+
+  absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
+
+  bool IsTracked(Node* node) const override {
+    return node->function_base() == function_base_;
+  }
+
+  std::optional<SharedLeafTypeTree<TernaryVector>> GetTernary(
+      Node* node) const override {
+    return std::nullopt;
+  }
+
+  bool AtMostOneTrue(absl::Span<TreeBitLocation const> bits) const override;
+  bool AtLeastOneTrue(absl::Span<TreeBitLocation const> bits) const override;
+  bool Implies(const TreeBitLocation& a,
+               const TreeBitLocation& b) const override;
+  bool KnownEquals(const TreeBitLocation& a,
+                   const TreeBitLocation& b) const override;
+  bool KnownNotEquals(const TreeBitLocation& a,
+                      const TreeBitLocation& b) const override;
+
+  std::optional<Bits> ImpliedNodeValue(
+      absl::Span<const std::pair<TreeBitLocation, bool>> predicate_bit_values,
+      Node* node) const override {
+    return std::nullopt;
+  }
+  std::optional<TernaryVector> ImpliedNodeTernary(
+      absl::Span<const std::pair<TreeBitLocation, bool>> predicate_bit_values,
+      Node* node) const override {
+    return std::nullopt;
+  }
+
+  // Returns the number of queries which were answered by the solver (rather
+  // than from the memo or rejected because of the cone size).
+  int64_t solver_query_count() const { return solver_query_count_; }
+
+ private:
+  enum class QueryKind : uint8_t {
+    kAtMostOneTrue,
+    kAtLeastOneTrue,
+    kImplies,
+    kKnownEquals,
+    kKnownNotEquals,
+  };
+
+  // Returns true if the query is known to hold. The bits are those of the
+  // query in order.
+  bool Prove(QueryKind kind, absl::Span<TreeBitLocation const> bits) const;
+
+  // Returns true if the union of the cones of the given bits has at most
+  // max_cone_size_ nodes.
+  bool ConeIsSmallEnough(absl::Span<TreeBitLocation const> bits) const;
+
+  // Returns the Z3 boolean for the given bit, translating its cone if
+  // necessary. Returns std::nullopt if the bit cannot be translated.
+  std::optional<Z3_ast> GetBit(const TreeBitLocation& bit) const;
+
+  // Builds the formula which is unsatisfiable iff the query holds.
+  Z3_ast Counterexample(QueryKind kind, absl::Span<const Z3_ast> bits) const;
+
+  int64_t max_cone_size_;
+  int64_t rlimit_;
+  FunctionBase* function_base_ = nullptr;
+
+  // The translator and solver are created lazily by the first query after
+  // Populate. Queries mutate them, so they are mutable.
+  mutable std::unique_ptr<solvers::z3::IrTranslator> translator_;
+  mutable Z3_solver solver_ = nullptr;
+  mutable absl::flat_hash_map<
+      std::pair<QueryKind, std::vector<TreeBitLocation>>, bool>
+      memo_;
+  mutable int64_t solver_query_count_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_SAT_QUERY_ENGINE_H_
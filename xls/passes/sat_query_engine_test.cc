@@ -0,0 +1,137 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/passes/sat_query_engine.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/types/span.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/passes/query_engine.h"
+
+namespace xls {
+namespace {
+
+class SatQueryEngineTest : public IrTestBase {
+ protected:
+  // Convenience methods for testing implication, equality, and inverse for
+  // single-bit node values.
+  bool Implies(const QueryEngine& engine, BValue a, BValue b) {
+    return engine.Implies(TreeBitLocation(a.node(), 0),
+                          TreeBitLocation(b.node(), 0));
+  }
+  bool KnownEquals(const QueryEngine& engine, BValue a, BValue b) {
+    return engine.KnownEquals(TreeBitLocation(a.node(), 0),
+                              TreeBitLocation(b.node(), 0));
+  }
+  bool KnownNotEquals(const QueryEngine& engine, BValue a, BValue b) {
+    return engine.KnownNotEquals(TreeBitLocation(a.node(), 0),
+                                 TreeBitLocation(b.node(), 0));
+  }
+  // Returns the locations of bit 0 of each of the given values.
+  std::vector<TreeBitLocation> LowBits(absl::Span<const BValue> values) {
+    std::vector<TreeBitLocation> bits;
+    for (BValue value : values) {
+      bits.push_back(TreeBitLocation(value.node(), 0));
+    }
+    return bits;
+  }
+};
+
+TEST_F(SatQueryEngineTest, ComparisonImplications) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(16));
+  BValue y = fb.Param("y", p->GetBitsType(16));
+  BValue x_lt_5 = fb.ULt(x, fb.Literal(UBits(5, 16)));
+  BValue x_lt_10 = fb.ULt(x, fb.Literal(UBits(10, 16)));
+  BValue x_lt_y = fb.ULt(x, y);
+  BValue y_gt_x = fb.UGt(y, x);
+  BValue x_ge_y = fb.UGe(x, y);
+  BValue sum_gt = fb.UGt(fb.Add(x, y), fb.Add(y, x));
+  BValue zero = fb.Literal(UBits(0, 1));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  SatQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(f).status());
+
+  EXPECT_TRUE(Implies(engine, x_lt_5, x_lt_10));
+  EXPECT_FALSE(Implies(engine, x_lt_10, x_lt_5));
+  EXPECT_TRUE(KnownEquals(engine, x_lt_y, y_gt_x));
+  EXPECT_FALSE(KnownEquals(engine, x_lt_y, x_lt_5));
+  EXPECT_TRUE(KnownNotEquals(engine, x_lt_y, x_ge_y));
+  EXPECT_FALSE(KnownNotEquals(engine, x_lt_y, x_lt_5));
+  EXPECT_TRUE(KnownEquals(engine, sum_gt, zero));
+}
+
+TEST_F(SatQueryEngineTest, AtMostAndAtLeastOneTrue) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue x_eq_0 = fb.Eq(x, fb.Literal(UBits(0, 8)));
+  BValue x_eq_1 = fb.Eq(x, fb.Literal(UBits(1, 8)));
+  BValue x_eq_2 = fb.Eq(x, fb.Literal(UBits(2, 8)));
+  BValue x_lt_2 = fb.ULt(x, fb.Literal(UBits(2, 8)));
+  BValue x_ge_2 = fb.UGe(x, fb.Literal(UBits(2, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  SatQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(f).status());
+
+  EXPECT_TRUE(engine.AtMostOneTrue(LowBits({x_eq_0, x_eq_1, x_eq_2})));
+  EXPECT_FALSE(engine.AtMostOneTrue(LowBits({x_eq_0, x_lt_2})));
+  EXPECT_TRUE(engine.AtLeastOneTrue(LowBits({x_lt_2, x_ge_2})));
+  EXPECT_FALSE(engine.AtLeastOneTrue(LowBits({x_eq_0, x_eq_1, x_eq_2})));
+}
+
+TEST_F(SatQueryEngineTest, QueriesAreMemoized) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue x_lt_5 = fb.ULt(x, fb.Literal(UBits(5, 8)));
+  BValue x_lt_10 = fb.ULt(x, fb.Literal(UBits(10, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  SatQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(f).status());
+  EXPECT_TRUE(Implies(engine, x_lt_5, x_lt_10));
+  EXPECT_TRUE(Implies(engine, x_lt_5, x_lt_10));
+  EXPECT_EQ(engine.solver_query_count(), 1);
+}
+
+TEST_F(SatQueryEngineTest, LargeConesAreNotQueried) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue x_lt_5 = fb.ULt(x, fb.Literal(UBits(5, 8)));
+  BValue x_lt_10 = fb.ULt(x, fb.Literal(UBits(10, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  SatQueryEngine engine(/*max_cone_size=*/3);
+  XLS_ASSERT_OK(engine.Populate(f).status());
+  EXPECT_FALSE(Implies(engine, x_lt_5, x_lt_10));
+  EXPECT_EQ(engine.solver_query_count(), 0);
+}
+
+}  // namespace
+}  // namespace xls
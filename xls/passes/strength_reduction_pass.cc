@@ -17,7 +17,6 @@
 #include <array>
 #include <cstdint>
 #include <iterator>
-#include <memory>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -41,6 +40,7 @@
 #include "xls/ir/ternary.h"
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/value.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -573,12 +573,15 @@ absl::StatusOr<bool> StrengthReduceNode(
 absl::StatusOr<bool> StrengthReductionPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const OptimizationPassOptions& options,
     PassResults* results) const {
-  std::vector<std::unique_ptr<QueryEngine>> query_engines;
-  query_engines.push_back(std::make_unique<StatelessQueryEngine>());
-  query_engines.push_back(std::make_unique<TernaryQueryEngine>());
-
-  UnionQueryEngine query_engine(std::move(query_engines));
-  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+  AnalysisManager local_analyses;
+  AnalysisManager& analyses = options.analysis_manager != nullptr
+                                  ? *options.analysis_manager
+                                  : local_analyses;
+  StatelessQueryEngine stateless_query_engine;
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * ternary_query_engine,
+                       analyses.GetTernaryQueryEngine(f));
+  UnownedUnionQueryEngine query_engine(
+      {&stateless_query_engine, ternary_query_engine});
 
   XLS_ASSIGN_OR_RETURN(absl::flat_hash_set<Node*> reducible_adds,
                        FindReducibleAdds(f, query_engine));
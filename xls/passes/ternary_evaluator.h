@@ -15,8 +15,14 @@
 #ifndef XLS_PASSES_TERNARY_EVALUATOR_H_
 #define XLS_PASSES_TERNARY_EVALUATOR_H_
 
+#include <cstdint>
+#include <limits>
+
+#include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "xls/ir/abstract_evaluator.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
 #include "xls/ir/ternary.h"
 
 namespace xls {
@@ -61,6 +67,107 @@ class TernaryEvaluator
     }
     return TernaryValue::kUnknown;
   }
+
+  // Word-parallel versions of the vector operations of the base class which
+  // operate on packed ternary vectors (see PackedTernaryVector). The results
+  // are at least as precise as those of the bit-at-a-time implementations.
+  Vector BitwiseNot(const Span& input) {
+    return ternary_ops::Unpack(ternary_ops::Not(ternary_ops::Pack(input)));
+  }
+  Vector BitwiseAnd(SpanOfSpan inputs) {
+    return PackedNaryOp(inputs, [](const PackedTernaryVector& a,
+                                   const PackedTernaryVector& b) {
+      return ternary_ops::And(a, b);
+    });
+  }
+  Vector BitwiseOr(SpanOfSpan inputs) {
+    return PackedNaryOp(inputs, [](const PackedTernaryVector& a,
+                                   const PackedTernaryVector& b) {
+      return ternary_ops::Or(a, b);
+    });
+  }
+  Vector BitwiseXor(SpanOfSpan inputs) {
+    return PackedNaryOp(inputs, [](const PackedTernaryVector& a,
+                                   const PackedTernaryVector& b) {
+      return ternary_ops::Xor(a, b);
+    });
+  }
+  Vector BitwiseAnd(Span a, Span b) { return BitwiseAnd({a, b}); }
+  Vector BitwiseOr(Span a, Span b) { return BitwiseOr({a, b}); }
+  Vector BitwiseXor(Span a, Span b) { return BitwiseXor({a, b}); }
+
+  Vector Add(Span a, Span b) {
+    return ternary_ops::Unpack(
+        ternary_ops::Add(ternary_ops::Pack(a), ternary_ops::Pack(b)));
+  }
+
+  // Products of fully known values are computed directly; others fall back to
+  // the bit-at-a-time multiplier. SMul goes through this too.
+  Vector UMul(Span a, Span b) {
+    if (!ternary_ops::IsFullyKnown(a) || !ternary_ops::IsFullyKnown(b)) {
+      return AbstractEvaluator::UMul(a, b);
+    }
+    return ternary_ops::BitsToTernary(bits_ops::UMul(
+        ternary_ops::ToKnownBitsValues(a), ternary_ops::ToKnownBitsValues(b)));
+  }
+
+  TernaryValue Equals(Span a, Span b) {
+    return ternary_ops::Equals(ternary_ops::Pack(a), ternary_ops::Pack(b));
+  }
+  TernaryValue ULessThan(Span a, Span b) {
+    return ternary_ops::ULessThan(ternary_ops::Pack(a), ternary_ops::Pack(b));
+  }
+  TernaryValue ULessThanOrEqual(Span a, Span b) {
+    return Not(ULessThan(b, a));
+  }
+  TernaryValue UGreaterThan(Span a, Span b) { return ULessThan(b, a); }
+  TernaryValue UGreaterThanOrEqual(Span a, Span b) {
+    return Not(ULessThan(a, b));
+  }
+
+  // Shifts by a fully known amount are done word-parallel; others fall back
+  // to the bit-at-a-time implementation.
+  Vector ShiftLeftLogical(Span input, Span amount) {
+    if (!ternary_ops::IsFullyKnown(amount)) {
+      return AbstractEvaluator::ShiftLeftLogical(input, amount);
+    }
+    return ternary_ops::Unpack(ternary_ops::ShiftLeftLogical(
+        ternary_ops::Pack(input), KnownShiftAmount(amount)));
+  }
+  Vector ShiftRightLogical(Span input, Span amount) {
+    if (!ternary_ops::IsFullyKnown(amount)) {
+      return AbstractEvaluator::ShiftRightLogical(input, amount);
+    }
+    return ternary_ops::Unpack(ternary_ops::ShiftRightLogical(
+        ternary_ops::Pack(input), KnownShiftAmount(amount)));
+  }
+  Vector ShiftRightArith(Span input, Span amount) {
+    if (!ternary_ops::IsFullyKnown(amount)) {
+      return AbstractEvaluator::ShiftRightArith(input, amount);
+    }
+    return ternary_ops::Unpack(ternary_ops::ShiftRightArith(
+        ternary_ops::Pack(input), KnownShiftAmount(amount)));
+  }
+
+ private:
+  template <typename F>
+  Vector PackedNaryOp(SpanOfSpan inputs, F f) {
+    CHECK_GT(inputs.size(), 0);
+    PackedTernaryVector result = ternary_ops::Pack(inputs.front());
+    for (Span input : inputs.subspan(1)) {
+      result = f(result, ternary_ops::Pack(input));
+    }
+    return ternary_ops::Unpack(result);
+  }
+
+  // Returns the value of the fully known shift amount `amount`, saturated at
+  // the largest int64_t.
+  static int64_t KnownShiftAmount(Span amount) {
+    Bits bits = ternary_ops::ToKnownBitsValues(amount);
+    return bits_ops::UGreaterThan(bits, std::numeric_limits<int64_t>::max())
+               ? std::numeric_limits<int64_t>::max()
+               : static_cast<int64_t>(bits.ToUint64().value());
+  }
 };
 
 }  // namespace xls
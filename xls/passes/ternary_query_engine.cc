@@ -24,6 +24,7 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -33,6 +34,7 @@
 #include "xls/data_structures/leaf_type_tree.h"
 #include "xls/ir/abstract_node_evaluator.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/op.h"
@@ -316,24 +318,29 @@ class NoOpGivens final : public TernaryDataProvider {
   }
 };
 
+// Evaluates `n` with `ternary_visitor`, whose values must include the operands
+// of `n`.
+absl::Status EvaluateNode(Node* n, const TernaryDataProvider& givens,
+                          TernaryNodeEvaluator& ternary_visitor) {
+  std::optional<LeafTypeTree<TernaryVector>> given = givens.GetKnownTernary(n);
+  if (given) {
+    return ternary_visitor.SetGivenValue(n, *std::move(given));
+  }
+  if (IsExpensiveToEvaluate(n, ternary_visitor.values())) {
+    return ternary_visitor.DefaultHandler(n);
+  }
+  return n->VisitSingleNode(&ternary_visitor);
+}
+
 }  // namespace
 
 absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::PopulateWithGivens(
     FunctionBase* f, const TernaryDataProvider& givens) {
+  populated_function_ = nullptr;
   TernaryEvaluator evaluator;
   TernaryNodeEvaluator ternary_visitor(evaluator);
   for (Node* n : TopoSort(f)) {
-    std::optional<LeafTypeTree<TernaryVector>> given =
-        givens.GetKnownTernary(n);
-    if (given) {
-      XLS_RETURN_IF_ERROR(ternary_visitor.SetGivenValue(n, *std::move(given)));
-      continue;
-    }
-    if (IsExpensiveToEvaluate(n, ternary_visitor.values())) {
-      XLS_RETURN_IF_ERROR(ternary_visitor.DefaultHandler(n));
-      continue;
-    }
-    XLS_RETURN_IF_ERROR(n->VisitSingleNode(&ternary_visitor));
+    XLS_RETURN_IF_ERROR(EvaluateNode(n, givens, ternary_visitor));
   }
 
   absl::flat_hash_map<Node*, LeafTypeTree<TernaryVector>> new_values =
@@ -341,10 +348,10 @@ absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::PopulateWithGivens(
   ReachedFixpoint rf = ReachedFixpoint::Unchanged;
   for (Node* node : f->nodes()) {
     CHECK(new_values.contains(node));
-    if (values_.contains(node) &&
-        values_[node].type() == new_values[node].type()) {
+    auto it = values_.find(node);
+    if (it != values_.end() && it->second.type() == new_values[node].type()) {
       leaf_type_tree::SimpleUpdateFrom<TernaryVector, TernaryVector>(
-          values_[node].AsMutableView(), new_values[node].AsView(),
+          it->second, new_values[node].AsView(),
           [&rf](TernaryVector& lhs, const TernaryVector& rhs) {
             if (lhs != rhs) {
               rf = ReachedFixpoint::Changed;
@@ -352,15 +359,92 @@ absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::PopulateWithGivens(
             CHECK_OK(ternary_ops::UpdateWithUnion(lhs, rhs));
           });
     } else {
-      values_[node] = std::move(new_values[node]);
+      SetValue(node, std::move(new_values[node]));
     }
   }
   return rf;
 }
 
+void TernaryQueryEngine::SetValue(Node* node,
+                                  LeafTypeTree<TernaryVector>&& value) {
+  auto it = values_.find(node);
+  if (it != values_.end() && it->second.type() == value.type()) {
+    absl::c_move(value.elements(), it->second.elements().begin());
+    return;
+  }
+  values_.insert_or_assign(node, arena_.Allocate(std::move(value)));
+}
+
 absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Populate(FunctionBase* f) {
   NoOpGivens givens;
-  return PopulateWithGivens(f, givens);
+  XLS_ASSIGN_OR_RETURN(ReachedFixpoint rf, PopulateWithGivens(f, givens));
+  populated_function_ = f;
+  populated_epoch_ = f->NewChangeEpoch();
+  return rf;
+}
+
+absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Update(FunctionBase* f) {
+  if (populated_function_ != f) {
+    values_.clear();
+    arena_.Clear();
+    return Populate(f);
+  }
+  std::vector<Node*> changed = f->NodesChangedSince(populated_epoch_);
+  if (f->NodesRemovedSince(populated_epoch_)) {
+    absl::flat_hash_set<Node*> live(f->nodes().begin(), f->nodes().end());
+    absl::erase_if(values_, [&](const auto& entry) {
+      return !live.contains(entry.first);
+    });
+  }
+  populated_epoch_ = f->NewChangeEpoch();
+
+  // Only the forward cone of the changed nodes can have different values.
+  absl::flat_hash_set<Node*> cone(changed.begin(), changed.end());
+  std::vector<Node*> worklist = std::move(changed);
+  while (!worklist.empty()) {
+    Node* node = worklist.back();
+    worklist.pop_back();
+    for (Node* user : node->users()) {
+      if (cone.insert(user).second) {
+        worklist.push_back(user);
+      }
+    }
+  }
+  if (cone.empty()) {
+    return ReachedFixpoint::Unchanged;
+  }
+
+  NoOpGivens givens;
+  TernaryEvaluator evaluator;
+  TernaryNodeEvaluator ternary_visitor(evaluator);
+  absl::flat_hash_set<Node*> seeded;
+  for (Node* n : TopoSort(f)) {
+    if (!cone.contains(n)) {
+      continue;
+    }
+    // Operands outside of the cone keep their previous values.
+    for (Node* operand : n->operands()) {
+      if (!cone.contains(operand) && seeded.insert(operand).second) {
+        XLS_RETURN_IF_ERROR(
+            ternary_visitor.SetGivenValue(
+                operand, leaf_type_tree::Clone(values_.at(operand).AsView())));
+      }
+    }
+    XLS_RETURN_IF_ERROR(EvaluateNode(n, givens, ternary_visitor));
+  }
+
+  absl::flat_hash_map<Node*, LeafTypeTree<TernaryVector>> new_values =
+      std::move(ternary_visitor).values();
+  ReachedFixpoint rf = ReachedFixpoint::Unchanged;
+  for (Node* node : cone) {
+    auto it = values_.find(node);
+    if (it == values_.end() ||
+        it->second.AsView() != new_values.at(node).AsView()) {
+      rf = ReachedFixpoint::Changed;
+    }
+    SetValue(node, std::move(new_values.at(node)));
+  }
+  return rf;
 }
 
 bool TernaryQueryEngine::AtMostOneTrue(
@@ -15,6 +15,7 @@
 #ifndef XLS_PASSES_TERNARY_QUERY_ENGINE_H_
 #define XLS_PASSES_TERNARY_QUERY_ENGINE_H_
 
+#include <cstdint>
 #include <optional>
 #include <utility>
 #include <variant>
@@ -25,6 +26,7 @@
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "xls/data_structures/leaf_type_tree.h"
+#include "xls/data_structures/leaf_type_tree_arena.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
@@ -55,6 +57,14 @@ class TernaryQueryEngine : public QueryEngine {
   absl::StatusOr<ReachedFixpoint> PopulateWithGivens(
       FunctionBase* f, const TernaryDataProvider& givens);
 
+  // Brings the engine up to date with the changes made to `f` since the last
+  // call to Populate or Update. Only the nodes changed since then and the
+  // nodes they transitively feed are re-evaluated; the re-evaluated values
+  // replace the previous ones so the result is the same as populating a new
+  // engine with `f`. Falls back to populating from scratch if the engine was
+  // not last populated by Populate(f).
+  absl::StatusOr<ReachedFixpoint> Update(FunctionBase* f);
+
   bool IsTracked(Node* node) const override {
     return values_.contains(node) && values_.at(node).type() == node->GetType();
   }
@@ -105,8 +115,21 @@ class TernaryQueryEngine : public QueryEngine {
   }
 
  private:
-  // Holds which bits values are known for nodes in the function.
-  absl::flat_hash_map<Node*, LeafTypeTree<TernaryEvaluator::Vector>> values_;
+  // Sets the value of `node`, reusing its storage in `arena_` if its type is
+  // unchanged.
+  void SetValue(Node* node, LeafTypeTree<TernaryEvaluator::Vector>&& value);
+
+  // Holds which bits values are known for nodes in the function. The values
+  // are stored in `arena_`; storage of values which are replaced by values of
+  // a different type or of removed nodes is only reclaimed by repopulating.
+  absl::flat_hash_map<Node*, MutableLeafTypeTreeView<TernaryEvaluator::Vector>>
+      values_;
+  LeafTypeTreeArena<TernaryEvaluator::Vector> arena_;
+
+  // The function the engine was last populated or updated with (without
+  // givens) and the change epoch of that function at the time.
+  FunctionBase* populated_function_ = nullptr;
+  int64_t populated_epoch_ = 0;
 };
 
 }  // namespace xls
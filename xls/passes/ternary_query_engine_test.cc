@@ -1785,6 +1785,40 @@ TEST_F(TernaryQueryEngineTest, Givens) {
   EXPECT_THAT(query_engine.ToString(v.node()), "0bXX11_11XX");
 }
 
+TEST_F(TernaryQueryEngineTest, UpdateAfterChange) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue low_mask = fb.Literal(UBits(0x0f, 8));
+  BValue masked = fb.And(x, low_mask);
+  BValue high_bit = fb.Or(x, fb.Literal(UBits(0x80, 8)));
+  BValue result = fb.Concat({masked, high_bit});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  TernaryQueryEngine query_engine;
+  XLS_ASSERT_OK(query_engine.Populate(f).status());
+  EXPECT_EQ(query_engine.ToString(masked.node()), "0b0000_XXXX");
+  EXPECT_THAT(query_engine.Update(f), IsOkAndHolds(ReachedFixpoint::Unchanged));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * high_mask,
+      f->MakeNode<Literal>(SourceInfo(), Value(UBits(0xf0, 8))));
+  ASSERT_TRUE(masked.node()->ReplaceOperand(low_mask.node(), high_mask));
+  XLS_ASSERT_OK(f->RemoveNode(low_mask.node()));
+  EXPECT_THAT(query_engine.Update(f), IsOkAndHolds(ReachedFixpoint::Changed));
+  EXPECT_EQ(query_engine.ToString(masked.node()), "0bXXXX_0000");
+  EXPECT_EQ(query_engine.ToString(high_bit.node()), "0b1XXX_XXXX");
+
+  TernaryQueryEngine fresh_engine;
+  XLS_ASSERT_OK(fresh_engine.Populate(f).status());
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(query_engine.ToString(node), fresh_engine.ToString(node))
+        << node;
+  }
+  EXPECT_EQ(query_engine.ToString(result.node()),
+            "0bXXXX_0000_1XXX_XXXX");
+}
+
 namespace {
 
 class ArrayCreation : public benchmark_support::strategy::NaryNode {
@@ -95,7 +95,7 @@ absl::StatusOr<bool> TokenDependencyPass::RunOnFunctionBaseInternal(
   XLS_VLOG_LINES(3, relation_to_string(data_deps));
 
   // The transitive closure of the token dependency relation.
-  NodeRelation token_deps_closure = TransitiveClosure<Node*>(token_deps);
+  NodeRelation token_deps_closure = DenseTransitiveClosure<Node*>(token_deps);
   VLOG(3) << "Token deps closure:";
   XLS_VLOG_LINES(3, relation_to_string(token_deps_closure));
 
@@ -14,19 +14,30 @@
 
 #include "xls/passes/unroll_pass.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/value.h"
+#include "xls/passes/inlining_pass.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_registry.h"
 #include "xls/passes/pass_base.h"
@@ -35,11 +46,14 @@ namespace xls {
 namespace {
 
 // Finds an "effectively used" (has users or is return value) counted for in the
-// function f, or returns nullptr if none is found.
-CountedFor* FindCountedFor(FunctionBase* f) {
+// function f whose body is not in `skipped_bodies`, or returns nullptr if none
+// is found.
+CountedFor* FindCountedFor(
+    FunctionBase* f, const absl::flat_hash_set<Function*>& skipped_bodies) {
   for (Node* node : TopoSort(f)) {
     if (node->Is<CountedFor>() &&
-        (f->HasImplicitUse(node) || !node->users().empty())) {
+        (f->HasImplicitUse(node) || !node->users().empty()) &&
+        !skipped_bodies.contains(node->As<CountedFor>()->body())) {
       return node->As<CountedFor>();
     }
   }
@@ -73,18 +87,175 @@ absl::Status UnrollCountedFor(CountedFor* loop) {
   return f->RemoveNode(loop);
 }
 
+// Creates a function which invokes `body` with its induction variable offset
+// by an additional parameter:
+//
+//   fn remainder(i, carry, offset, invariants...) {
+//     ret invoke(i + offset, carry, invariants..., to_apply=body)
+//   }
+//
+// A counted_for of this function passing the number of iterations already
+// unrolled (times the stride) as `offset` performs the remaining iterations of
+// a loop of `body`.
+absl::StatusOr<Function*> MakeRemainderBody(Function* body) {
+  Package* p = body->package();
+  std::string name = absl::StrCat(body->name(), "__unroll_remainder");
+  for (int64_t i = 1; p->TryGetFunction(name).has_value(); ++i) {
+    name = absl::StrCat(body->name(), "__unroll_remainder_", i);
+  }
+  FunctionBuilder fb(name, p);
+  BValue iv = fb.Param("i", body->param(0)->GetType());
+  BValue carry = fb.Param("carry", body->param(1)->GetType());
+  BValue offset = fb.Param("offset", body->param(0)->GetType());
+  std::vector<BValue> args = {fb.Add(iv, offset), carry};
+  for (int64_t i = 2; i < body->params().size(); ++i) {
+    args.push_back(fb.Param(absl::StrCat("invariant_", i - 2),
+                            body->param(i)->GetType()));
+  }
+  return fb.BuildWithReturnValue(fb.Invoke(args, body));
+}
+
+// Returns the counted_for of `remainder_body` in `f`, or nullptr if there is
+// none (e.g., because simplification folded it away).
+CountedFor* FindRemainder(FunctionBase* f, Function* remainder_body) {
+  for (Node* node : f->nodes()) {
+    if (node->Is<CountedFor>() &&
+        node->As<CountedFor>()->body() == remainder_body) {
+      return node->As<CountedFor>();
+    }
+  }
+  return nullptr;
+}
+
 }  // namespace
 
+absl::Status UnrollPass::Simplify(
+    FunctionBase* f, const OptimizationPassOptions& options) const {
+  // The results of these nested runs are not part of this pass's results.
+  PassResults results;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const std::unique_ptr<OptimizationFunctionBasePass>& pass :
+         simplification_passes_) {
+      XLS_ASSIGN_OR_RETURN(bool pass_changed,
+                           pass->RunOnFunctionBase(f, options, &results));
+      changed = changed || pass_changed;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Function*> UnrollPass::UnrollIncrementally(
+    CountedFor* loop, const OptimizationPassOptions& options) const {
+  FunctionBase* f = loop->function_base();
+  Function* body = loop->body();
+  SourceInfo loc = loop->loc();
+  int64_t stride = loop->stride();
+  int64_t ivar_bit_count = body->params()[0]->BitCountOrDie();
+  int64_t step_iterations = std::max<int64_t>(
+      1, *options.unroll_step_node_count / std::max<int64_t>(
+                                              1, body->node_count()));
+  XLS_ASSIGN_OR_RETURN(Function * remainder_body, MakeRemainderBody(body));
+
+  // Replaces `old_loop` with `carry` if no iterations remain and otherwise
+  // with a counted_for of `remainder_body` starting after `done` iterations.
+  auto replace_loop = [&](Node* old_loop, Node* carry,
+                          absl::Span<Node* const> invariant_args,
+                          int64_t remaining, int64_t done) -> absl::Status {
+    if (remaining == 0) {
+      XLS_RETURN_IF_ERROR(old_loop->ReplaceUsesWith(carry));
+      return f->RemoveNode(old_loop);
+    }
+    XLS_ASSIGN_OR_RETURN(
+        Literal * offset,
+        f->MakeNode<Literal>(loc, Value(UBits(done * stride, ivar_bit_count))));
+    std::vector<Node*> remainder_args = {offset};
+    remainder_args.insert(remainder_args.end(), invariant_args.begin(),
+                          invariant_args.end());
+    XLS_RETURN_IF_ERROR(old_loop
+                            ->ReplaceUsesWithNew<CountedFor>(
+                                carry, remainder_args, remaining, stride,
+                                remainder_body)
+                            .status());
+    return f->RemoveNode(old_loop);
+  };
+
+  std::vector<Node*> invariant_args(loop->invariant_args().begin(),
+                                    loop->invariant_args().end());
+  XLS_RETURN_IF_ERROR(replace_loop(loop, loop->initial_value(), invariant_args,
+                                   loop->trip_count(), /*done=*/0));
+  int64_t done = 0;
+  while (CountedFor* remainder = FindRemainder(f, remainder_body)) {
+    int64_t node_count_before = f->node_count();
+    int64_t iterations = std::min(step_iterations, remainder->trip_count());
+    // The invariant arguments follow the offset.
+    invariant_args.assign(remainder->invariant_args().begin() + 1,
+                          remainder->invariant_args().end());
+    Node* carry = remainder->initial_value();
+    std::vector<Invoke*> invokes;
+    for (int64_t trip = 0; trip < iterations; ++trip) {
+      XLS_ASSIGN_OR_RETURN(
+          Literal * iv_node,
+          f->MakeNode<Literal>(
+              loc, Value(UBits((done + trip) * stride, ivar_bit_count))));
+      std::vector<Node*> invoke_args = {iv_node, carry};
+      invoke_args.insert(invoke_args.end(), invariant_args.begin(),
+                         invariant_args.end());
+      XLS_ASSIGN_OR_RETURN(
+          Invoke * invoke,
+          f->MakeNode<Invoke>(loc, absl::MakeSpan(invoke_args), body));
+      invokes.push_back(invoke);
+      carry = invoke;
+    }
+    done += iterations;
+    int64_t remaining = remainder->trip_count() - iterations;
+    XLS_RETURN_IF_ERROR(
+        replace_loop(remainder, carry, invariant_args, remaining, done));
+    // Inlining an invoke replaces its uses, so the chain must be complete
+    // first.
+    for (Invoke* invoke : invokes) {
+      XLS_RETURN_IF_ERROR(InliningPass::InlineOneInvoke(invoke));
+    }
+    XLS_RETURN_IF_ERROR(Simplify(f, options));
+    if (remaining == 0) {
+      break;
+    }
+    int64_t growth = f->node_count() - node_count_before;
+    if (options.max_unrolled_iteration_growth.has_value() &&
+        growth > *options.max_unrolled_iteration_growth * iterations) {
+      VLOG(2) << absl::StreamFormat(
+          "Leaving %d iterations of a loop of %s rolled, the last %d "
+          "iterations added %d nodes.",
+          remaining, body->name(), iterations, growth);
+      return remainder_body;
+    }
+  }
+  return nullptr;
+}
+
 absl::StatusOr<bool> UnrollPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const OptimizationPassOptions& options,
     PassResults* results) const {
+  bool incremental = options.unroll_step_node_count.has_value() &&
+                     !simplification_passes_.empty();
+  // Bodies of loops whose remaining iterations were left rolled.
+  absl::flat_hash_set<Function*> rolled_bodies;
   bool changed = false;
   while (true) {
-    CountedFor* loop = FindCountedFor(f);
+    CountedFor* loop = FindCountedFor(f, rolled_bodies);
     if (loop == nullptr) {
       break;
     }
-    XLS_RETURN_IF_ERROR(UnrollCountedFor(loop));
+    if (incremental && !loop->body()->ForeignFunctionData().has_value()) {
+      XLS_ASSIGN_OR_RETURN(Function * rolled_body,
+                           UnrollIncrementally(loop, options));
+      if (rolled_body != nullptr) {
+        rolled_bodies.insert(rolled_body);
+      }
+    } else {
+      XLS_RETURN_IF_ERROR(UnrollCountedFor(loop));
+    }
     changed = true;
   }
   return changed;
@@ -15,24 +15,60 @@
 #ifndef XLS_PASSES_UNROLL_PASS_H_
 #define XLS_PASSES_UNROLL_PASS_H_
 
+#include <memory>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "absl/status/statusor.h"
+#include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
+#include "xls/ir/nodes.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
 
 namespace xls {
 
+// Unrolls counted loops, replacing each counted_for with a chain of invokes of
+// its body.
+//
+// Fully unrolling a loop with a large trip count multiplies the size of the IR
+// before anything has had a chance to simplify it. So if
+// `options.unroll_step_node_count` is set and the pass was constructed with
+// simplification passes, loops are instead unrolled incrementally: each step
+// unrolls and inlines about that many nodes worth of iterations and then runs
+// the simplification passes on the function base to a fixed point, with the
+// iterations still to go kept as a counted_for. If
+// `options.max_unrolled_iteration_growth` is also set, unrolling of a loop
+// stops once a step grows the function base by more than that many nodes per
+// iteration, and the remaining iterations are left rolled.
 class UnrollPass : public OptimizationFunctionBasePass {
  public:
   static constexpr std::string_view kName = "loop_unroll";
-  UnrollPass() : OptimizationFunctionBasePass(kName, "Unroll counted loops") {}
+  explicit UnrollPass(
+      std::vector<std::unique_ptr<OptimizationFunctionBasePass>>
+          simplification_passes = {})
+      : OptimizationFunctionBasePass(kName, "Unroll counted loops"),
+        simplification_passes_(std::move(simplification_passes)) {}
 
  protected:
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const OptimizationPassOptions& options,
       PassResults* results) const override;
+
+ private:
+  // Unrolls `loop` incrementally. Returns the body of the counted_for holding
+  // the remaining iterations if unrolling stopped early, or nullptr if the loop
+  // was unrolled completely.
+  absl::StatusOr<Function*> UnrollIncrementally(
+      CountedFor* loop, const OptimizationPassOptions& options) const;
+
+  // Runs the simplification passes on `f` until none of them changes it.
+  absl::Status Simplify(FunctionBase* f,
+                        const OptimizationPassOptions& options) const;
+
+  std::vector<std::unique_ptr<OptimizationFunctionBasePass>>
+      simplification_passes_;
 };
 
 }  // namespace xls
@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -23,7 +24,10 @@
 #include "xls/ir/function.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
+#include "xls/passes/constant_folding_pass.h"
+#include "xls/passes/dce_pass.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
 
@@ -33,6 +37,7 @@ namespace xls {
 namespace {
 
 using ::absl_testing::IsOkAndHolds;
+using ::testing::ElementsAre;
 
 TEST(UnrollPassTest, UnrollsCountedForWithInvariantArgsAndStride) {
   const std::string program = R"(
@@ -63,5 +68,81 @@ fn unrollable() -> bits[32] {
                         m::Literal(0)));
 }
 
+std::vector<std::unique_ptr<OptimizationFunctionBasePass>>
+SimplificationPasses() {
+  std::vector<std::unique_ptr<OptimizationFunctionBasePass>> passes;
+  passes.push_back(std::make_unique<ConstantFoldingPass>());
+  passes.push_back(std::make_unique<DeadCodeEliminationPass>());
+  return passes;
+}
+
+TEST(UnrollPassTest, IncrementalUnrollSimplifiesBetweenSteps) {
+  const std::string program = R"(
+package some_package
+
+fn body(i: bits[8], accum: bits[32]) -> bits[32] {
+  zero_ext.3: bits[32] = zero_ext(i, new_bit_count=32)
+  ret add.4: bits[32] = add(zero_ext.3, accum)
+}
+
+fn unrollable(x: bits[32]) -> bits[32] {
+  ret counted_for.2: bits[32] = counted_for(x, trip_count=3, stride=1, body=body)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(program));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("unrollable"));
+  PassResults results;
+  UnrollPass pass(SimplificationPasses());
+  OptimizationPassOptions options;
+  options.unroll_step_node_count = 1;
+  EXPECT_THAT(pass.RunOnFunctionBase(f, options, &results), IsOkAndHolds(true));
+  // The iterations are inlined and their zero extensions folded.
+  EXPECT_THAT(f->return_value(),
+              m::Add(m::Literal(2),
+                     m::Add(m::Literal(1),
+                            m::Add(m::Literal(0), m::Param("x")))));
+  EXPECT_EQ(f->node_count(), 7);
+}
+
+TEST(UnrollPassTest, IncrementalUnrollLeavesUnprofitableLoopRolled) {
+  const std::string program = R"(
+package some_package
+
+fn body(i: bits[8], accum: bits[32], x: bits[32]) -> bits[32] {
+  zero_ext.4: bits[32] = zero_ext(i, new_bit_count=32)
+  umul.5: bits[32] = umul(accum, x)
+  ret add.6: bits[32] = add(zero_ext.4, umul.5)
+}
+
+fn unrollable(x: bits[32]) -> bits[32] {
+  literal.1: bits[32] = literal(value=1)
+  ret counted_for.2: bits[32] = counted_for(literal.1, trip_count=8, stride=2, body=body, invariant_args=[x])
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p,
+                           Parser::ParsePackage(program));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, p->GetFunction("unrollable"));
+  PassResults results;
+  UnrollPass pass(SimplificationPasses());
+  OptimizationPassOptions options;
+  options.unroll_step_node_count = 1;
+  options.max_unrolled_iteration_growth = 0;
+  EXPECT_THAT(pass.RunOnFunctionBase(f, options, &results), IsOkAndHolds(true));
+
+  // One iteration was unrolled and the remaining ones start from the stride.
+  ASSERT_TRUE(f->return_value()->Is<CountedFor>());
+  CountedFor* remainder = f->return_value()->As<CountedFor>();
+  EXPECT_EQ(remainder->trip_count(), 7);
+  EXPECT_EQ(remainder->stride(), 2);
+  EXPECT_EQ(remainder->body()->name(), "body__unroll_remainder");
+  EXPECT_THAT(remainder->initial_value(),
+              m::Add(m::Literal(0), m::UMul(m::Literal(1), m::Param("x"))));
+  EXPECT_THAT(remainder->invariant_args(),
+              ElementsAre(m::Literal(2), m::Param("x")));
+}
+
 }  // namespace
 }  // namespace xls
@@ -15,6 +15,7 @@
 #include "xls/passes/verifier_checker.h"
 
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/ir/verifier.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
@@ -24,6 +25,10 @@ namespace xls {
 absl::Status VerifierChecker::Run(Package* p,
                                   const OptimizationPassOptions& options,
                                   PassResults* results) const {
+  if (options.incremental_verification) {
+    absl::MutexLock lock(&mutex_);
+    return VerifyPackageIncrementally(p, verified_);
+  }
   return VerifyPackage(p);
 }
 
@@ -15,18 +15,27 @@
 #ifndef XLS_PASSES_VERIFIER_CHECKER_H_
 #define XLS_PASSES_VERIFIER_CHECKER_H_
 
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/ir/package.h"
+#include "xls/ir/verifier.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_base.h"
 
 namespace xls {
 
-// Invariant checker which just runs xls::Verifier.
+// Invariant checker which just runs xls::Verifier. With
+// OptimizationPassOptions::incremental_verification the functions which are
+// unchanged since the previous check are not verified again.
 class VerifierChecker : public OptimizationInvariantChecker {
  public:
   absl::Status Run(Package* p, const OptimizationPassOptions& options,
                    PassResults* results) const override;
+
+ private:
+  mutable absl::Mutex mutex_;
+  mutable VerifiedFunctions verified_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace xls
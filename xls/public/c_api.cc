@@ -32,20 +32,39 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/init_xls.h"
+#include "absl/types/span.h"
+#include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/function_interpreter.h"
+#include "xls/interpreter/interpreter_proc_runtime.h"
+#include "xls/interpreter/serial_proc_runtime.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/events.h"
 #include "xls/ir/format_preference.h"
 #include "xls/ir/function.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/ir/value_utils.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/jit_proc_runtime.h"
 #include "xls/public/c_api_format_preference.h"
 #include "xls/public/c_api_impl_helpers.h"
 #include "xls/public/c_api_vast.h"
 #include "xls/public/runtime_build_actions.h"
 
+namespace {
+
+// The object behind an `xls_function_jit`: the jitted function along with the
+// function it was compiled from, which gives the types of the buffers.
+struct FunctionJitHandle {
+  xls::Function* function;
+  std::unique_ptr<xls::FunctionJit> jit;
+};
+
+}  // namespace
+
 extern "C" {
 
 void xls_init_xls(const char* usage, int argc, char* argv[]) {
@@ -401,4 +420,278 @@ bool xls_interpret_function(struct xls_function* function, size_t argc,
   return true;
 }
 
+bool xls_function_jit_create(struct xls_function* function, char** error_out,
+                             struct xls_function_jit** result_out) {
+  CHECK(function != nullptr);
+  CHECK(error_out != nullptr);
+  CHECK(result_out != nullptr);
+  xls::Function* xls_function = reinterpret_cast<xls::Function*>(function);
+  absl::StatusOr<std::unique_ptr<xls::FunctionJit>> jit =
+      xls::FunctionJit::Create(xls_function);
+  if (!jit.ok()) {
+    *result_out = nullptr;
+    *error_out = xls::ToOwnedCString(jit.status().ToString());
+    return false;
+  }
+  *result_out = reinterpret_cast<xls_function_jit*>(
+      new FunctionJitHandle{xls_function, std::move(jit).value()});
+  *error_out = nullptr;
+  return true;
+}
+
+void xls_function_jit_free(struct xls_function_jit* jit) {
+  delete reinterpret_cast<FunctionJitHandle*>(jit);
+}
+
+bool xls_function_jit_run(struct xls_function_jit* jit, size_t argc,
+                          const struct xls_value** args, char** error_out,
+                          struct xls_value** result_out) {
+  CHECK(jit != nullptr);
+  CHECK(args != nullptr);
+  CHECK(error_out != nullptr);
+  CHECK(result_out != nullptr);
+  FunctionJitHandle* handle = reinterpret_cast<FunctionJitHandle*>(jit);
+
+  std::vector<xls::Value> xls_args;
+  xls_args.reserve(argc);
+  for (size_t i = 0; i < argc; ++i) {
+    CHECK(args[i] != nullptr);
+    xls_args.push_back(*reinterpret_cast<const xls::Value*>(args[i]));
+  }
+
+  absl::StatusOr<xls::Value> result_value =
+      xls::InterpreterResultToStatusOrValue(handle->jit->Run(xls_args));
+  if (!result_value.ok()) {
+    *result_out = nullptr;
+    *error_out = xls::ToOwnedCString(result_value.status().ToString());
+    return false;
+  }
+  *result_out = reinterpret_cast<struct xls_value*>(
+      new xls::Value(std::move(result_value.value())));
+  *error_out = nullptr;
+  return true;
+}
+
+int64_t xls_function_jit_get_arg_size(struct xls_function_jit* jit,
+                                      int64_t arg_index) {
+  CHECK(jit != nullptr);
+  return reinterpret_cast<FunctionJitHandle*>(jit)->jit->GetArgTypeSize(
+      arg_index);
+}
+
+int64_t xls_function_jit_get_arg_alignment(struct xls_function_jit* jit,
+                                           int64_t arg_index) {
+  CHECK(jit != nullptr);
+  return reinterpret_cast<FunctionJitHandle*>(jit)->jit->GetArgTypeAlignment(
+      arg_index);
+}
+
+int64_t xls_function_jit_get_result_size(struct xls_function_jit* jit) {
+  CHECK(jit != nullptr);
+  return reinterpret_cast<FunctionJitHandle*>(jit)->jit->GetReturnTypeSize();
+}
+
+int64_t xls_function_jit_get_result_alignment(struct xls_function_jit* jit) {
+  CHECK(jit != nullptr);
+  return reinterpret_cast<FunctionJitHandle*>(jit)
+      ->jit->GetReturnTypeAlignment();
+}
+
+bool xls_function_jit_pack_arg(struct xls_function_jit* jit,
+                               int64_t arg_index, const struct xls_value* value,
+                               uint8_t* buffer, char** error_out) {
+  CHECK(jit != nullptr);
+  CHECK(value != nullptr);
+  CHECK(buffer != nullptr);
+  CHECK(error_out != nullptr);
+  FunctionJitHandle* handle = reinterpret_cast<FunctionJitHandle*>(jit);
+  const xls::Value* xls_value = reinterpret_cast<const xls::Value*>(value);
+  xls::FunctionType* type = handle->function->GetType();
+  if (arg_index < 0 || arg_index >= type->parameter_count()) {
+    *error_out = xls::ToOwnedCString(
+        absl::StrFormat("Argument index %d out of range; function %s has %d "
+                        "parameters",
+                        arg_index, handle->function->name(),
+                        type->parameter_count()));
+    return false;
+  }
+  xls::Type* arg_type = type->parameter_type(arg_index);
+  if (!xls::ValueConformsToType(*xls_value, arg_type)) {
+    *error_out = xls::ToOwnedCString(absl::StrFormat(
+        "Value %s does not match the type %s of argument %d",
+        xls_value->ToString(), arg_type->ToString(), arg_index));
+    return false;
+  }
+  handle->jit->runtime()->BlitValueToBuffer(
+      *xls_value, arg_type,
+      absl::MakeSpan(buffer, handle->jit->GetArgTypeSize(arg_index)));
+  *error_out = nullptr;
+  return true;
+}
+
+bool xls_function_jit_unpack_result(struct xls_function_jit* jit,
+                                    const uint8_t* buffer, char** error_out,
+                                    struct xls_value** result_out) {
+  CHECK(jit != nullptr);
+  CHECK(buffer != nullptr);
+  CHECK(error_out != nullptr);
+  CHECK(result_out != nullptr);
+  FunctionJitHandle* handle = reinterpret_cast<FunctionJitHandle*>(jit);
+  *result_out = reinterpret_cast<struct xls_value*>(
+      new xls::Value(handle->jit->runtime()->UnpackBuffer(
+          buffer, handle->function->GetType()->return_type())));
+  *error_out = nullptr;
+  return true;
+}
+
+bool xls_function_jit_run_with_buffers(struct xls_function_jit* jit,
+                                       size_t argc, uint8_t* const* args,
+                                       uint8_t* result, char** error_out) {
+  CHECK(jit != nullptr);
+  CHECK(args != nullptr || argc == 0);
+  CHECK(result != nullptr);
+  CHECK(error_out != nullptr);
+  FunctionJitHandle* handle = reinterpret_cast<FunctionJitHandle*>(jit);
+  xls::InterpreterEvents events;
+  absl::Status status = handle->jit->RunWithViews(
+      absl::MakeConstSpan(args, argc),
+      absl::MakeSpan(result, handle->jit->GetReturnTypeSize()), &events);
+  if (status.ok()) {
+    status = xls::InterpreterEventsToStatus(events);
+  }
+  if (!status.ok()) {
+    *error_out = xls::ToOwnedCString(status.ToString());
+    return false;
+  }
+  *error_out = nullptr;
+  return true;
+}
+
+bool xls_proc_runtime_create(struct xls_package* package, bool use_jit,
+                             char** error_out,
+                             struct xls_proc_runtime** result_out) {
+  CHECK(package != nullptr);
+  CHECK(error_out != nullptr);
+  CHECK(result_out != nullptr);
+  xls::Package* xls_package = reinterpret_cast<xls::Package*>(package);
+
+  // New-style procs are elaborated from the top proc; old-style procs are all
+  // run from the package.
+  std::optional<xls::Proc*> top;
+  if (std::optional<xls::FunctionBase*> top_function_base =
+          xls_package->GetTop();
+      top_function_base.has_value() && (*top_function_base)->IsProc() &&
+      (*top_function_base)->AsProcOrDie()->is_new_style_proc()) {
+    top = (*top_function_base)->AsProcOrDie();
+  }
+  absl::StatusOr<std::unique_ptr<xls::SerialProcRuntime>> runtime;
+  if (use_jit) {
+    runtime = top.has_value() ? xls::CreateJitSerialProcRuntime(*top)
+                              : xls::CreateJitSerialProcRuntime(xls_package);
+  } else {
+    runtime = top.has_value()
+                  ? xls::CreateInterpreterSerialProcRuntime(*top)
+                  : xls::CreateInterpreterSerialProcRuntime(xls_package);
+  }
+  if (!runtime.ok()) {
+    *result_out = nullptr;
+    *error_out = xls::ToOwnedCString(runtime.status().ToString());
+    return false;
+  }
+  *result_out =
+      reinterpret_cast<xls_proc_runtime*>(runtime.value().release());
+  *error_out = nullptr;
+  return true;
+}
+
+void xls_proc_runtime_free(struct xls_proc_runtime* runtime) {
+  delete reinterpret_cast<xls::SerialProcRuntime*>(runtime);
+}
+
+bool xls_proc_runtime_tick(struct xls_proc_runtime* runtime,
+                           char** error_out) {
+  CHECK(runtime != nullptr);
+  CHECK(error_out != nullptr);
+  absl::Status status =
+      reinterpret_cast<xls::SerialProcRuntime*>(runtime)->Tick();
+  if (!status.ok()) {
+    *error_out = xls::ToOwnedCString(status.ToString());
+    return false;
+  }
+  *error_out = nullptr;
+  return true;
+}
+
+bool xls_proc_runtime_tick_until_blocked(struct xls_proc_runtime* runtime,
+                                         int64_t max_ticks, char** error_out,
+                                         int64_t* ticks_out) {
+  CHECK(runtime != nullptr);
+  CHECK(error_out != nullptr);
+  CHECK(ticks_out != nullptr);
+  absl::StatusOr<int64_t> ticks =
+      reinterpret_cast<xls::SerialProcRuntime*>(runtime)->TickUntilBlocked(
+          max_ticks > 0 ? std::make_optional(max_ticks) : std::nullopt);
+  if (!ticks.ok()) {
+    *ticks_out = 0;
+    *error_out = xls::ToOwnedCString(ticks.status().ToString());
+    return false;
+  }
+  *ticks_out = ticks.value();
+  *error_out = nullptr;
+  return true;
+}
+
+bool xls_proc_runtime_channel_enqueue(struct xls_proc_runtime* runtime,
+                                      const char* channel_name,
+                                      const struct xls_value* value,
+                                      char** error_out) {
+  CHECK(runtime != nullptr);
+  CHECK(channel_name != nullptr);
+  CHECK(value != nullptr);
+  CHECK(error_out != nullptr);
+  absl::StatusOr<xls::ChannelQueue*> queue =
+      reinterpret_cast<xls::SerialProcRuntime*>(runtime)
+          ->queue_manager()
+          .GetQueueByName(channel_name);
+  absl::Status status = queue.status();
+  if (status.ok()) {
+    status = (*queue)->Write(*reinterpret_cast<const xls::Value*>(value));
+  }
+  if (!status.ok()) {
+    *error_out = xls::ToOwnedCString(status.ToString());
+    return false;
+  }
+  *error_out = nullptr;
+  return true;
+}
+
+bool xls_proc_runtime_channel_dequeue(struct xls_proc_runtime* runtime,
+                                      const char* channel_name,
+                                      char** error_out, bool* has_value_out,
+                                      struct xls_value** value_out) {
+  CHECK(runtime != nullptr);
+  CHECK(channel_name != nullptr);
+  CHECK(error_out != nullptr);
+  CHECK(has_value_out != nullptr);
+  CHECK(value_out != nullptr);
+  *has_value_out = false;
+  *value_out = nullptr;
+  absl::StatusOr<xls::ChannelQueue*> queue =
+      reinterpret_cast<xls::SerialProcRuntime*>(runtime)
+          ->queue_manager()
+          .GetQueueByName(channel_name);
+  if (!queue.ok()) {
+    *error_out = xls::ToOwnedCString(queue.status().ToString());
+    return false;
+  }
+  std::optional<xls::Value> value = (*queue)->Read();
+  if (value.has_value()) {
+    *has_value_out = true;
+    *value_out = reinterpret_cast<struct xls_value*>(
+        new xls::Value(std::move(value).value()));
+  }
+  *error_out = nullptr;
+  return true;
+}
+
 }  // extern "C"
@@ -48,6 +48,8 @@ struct xls_package;
 struct xls_function;
 struct xls_type;
 struct xls_function_type;
+struct xls_function_jit;
+struct xls_proc_runtime;
 
 void xls_init_xls(const char* usage, int argc, char* argv[]);
 
@@ -182,6 +184,83 @@ bool xls_interpret_function(struct xls_function* function, size_t argc,
                             const struct xls_value** args, char** error_out,
                             struct xls_value** result_out);
 
+// Compiles the given `function` to native code. The function (and so its
+// package) must outlive the returned object, which must be freed with
+// `xls_function_jit_free`.
+bool xls_function_jit_create(struct xls_function* function, char** error_out,
+                             struct xls_function_jit** result_out);
+
+void xls_function_jit_free(struct xls_function_jit* jit);
+
+// Runs the compiled function on the given `args` (an array of size `argc`) --
+// as `xls_interpret_function` but with natively compiled code.
+bool xls_function_jit_run(struct xls_function_jit* jit, size_t argc,
+                          const struct xls_value** args, char** error_out,
+                          struct xls_value** result_out);
+
+// Returns the size and alignment in bytes of the buffers holding the argument
+// at `arg_index` and the result in the native data layout of the compiled
+// function (see xls/jit/type_layout.h).
+int64_t xls_function_jit_get_arg_size(struct xls_function_jit* jit,
+                                      int64_t arg_index);
+int64_t xls_function_jit_get_arg_alignment(struct xls_function_jit* jit,
+                                           int64_t arg_index);
+int64_t xls_function_jit_get_result_size(struct xls_function_jit* jit);
+int64_t xls_function_jit_get_result_alignment(struct xls_function_jit* jit);
+
+// Writes `value` in the native data layout of the argument at `arg_index` to
+// `buffer`, which must hold `xls_function_jit_get_arg_size` bytes.
+bool xls_function_jit_pack_arg(struct xls_function_jit* jit,
+                               int64_t arg_index, const struct xls_value* value,
+                               uint8_t* buffer, char** error_out);
+
+// Returns the value held by `buffer` in the native data layout of the result.
+bool xls_function_jit_unpack_result(struct xls_function_jit* jit,
+                                    const uint8_t* buffer, char** error_out,
+                                    struct xls_value** result_out);
+
+// Runs the compiled function on caller-owned buffers holding the arguments
+// (an array of size `argc`) and receiving the result in the native data
+// layout. Buffers aligned as given by the `_alignment` functions above are
+// used in place; others are copied. Performs no allocation unless an error is
+// returned, so it is the entry point to use in loops.
+bool xls_function_jit_run_with_buffers(struct xls_function_jit* jit,
+                                       size_t argc, uint8_t* const* args,
+                                       uint8_t* result, char** error_out);
+
+// Creates a runtime for the procs of the given `package`, using natively
+// compiled procs if `use_jit` is set and the IR interpreter otherwise. The
+// package must outlive the returned object, which must be freed with
+// `xls_proc_runtime_free`.
+bool xls_proc_runtime_create(struct xls_package* package, bool use_jit,
+                             char** error_out,
+                             struct xls_proc_runtime** result_out);
+
+void xls_proc_runtime_free(struct xls_proc_runtime* runtime);
+
+// Executes a single tick of every proc.
+bool xls_proc_runtime_tick(struct xls_proc_runtime* runtime, char** error_out);
+
+// Ticks until every proc is blocked on a receive, or until `max_ticks` ticks
+// (if positive) have been executed, in which case an error is returned. The
+// number of ticks executed is placed in `ticks_out`.
+bool xls_proc_runtime_tick_until_blocked(struct xls_proc_runtime* runtime,
+                                         int64_t max_ticks, char** error_out,
+                                         int64_t* ticks_out);
+
+// Writes `value` to the queue of the channel named `channel_name`.
+bool xls_proc_runtime_channel_enqueue(struct xls_proc_runtime* runtime,
+                                      const char* channel_name,
+                                      const struct xls_value* value,
+                                      char** error_out);
+
+// Reads a value from the queue of the channel named `channel_name`. If the
+// queue is empty, `has_value_out` is set to false and `value_out` to null.
+bool xls_proc_runtime_channel_dequeue(struct xls_proc_runtime* runtime,
+                                      const char* channel_name,
+                                      char** error_out, bool* has_value_out,
+                                      struct xls_value** value_out);
+
 }  // extern "C"
 
 #endif  // XLS_PUBLIC_C_API_H_
@@ -227,6 +227,135 @@ top fn f() -> bits[32] {
   EXPECT_EQ(std::string_view(opt_ir), kWant);
 }
 
+TEST(XlsCApiTest, JitFunctionRunWithValuesAndBuffers) {
+  const std::string kPackage = R"(package p
+
+fn f(x: bits[32], y: bits[32]) -> bits[32] {
+  ret result: bits[32] = add(x, y)
+}
+)";
+
+  char* error = nullptr;
+  struct xls_package* package = nullptr;
+  ASSERT_TRUE(xls_parse_ir_package(kPackage.c_str(), "p.ir", &error, &package))
+      << "xls_parse_ir_package error: " << error;
+  absl::Cleanup free_package([package] { xls_package_free(package); });
+
+  struct xls_function* function = nullptr;
+  ASSERT_TRUE(xls_package_get_function(package, "f", &error, &function));
+
+  struct xls_function_jit* jit = nullptr;
+  ASSERT_TRUE(xls_function_jit_create(function, &error, &jit)) << error;
+  absl::Cleanup free_jit([jit] { xls_function_jit_free(jit); });
+
+  struct xls_value* x = nullptr;
+  ASSERT_TRUE(xls_parse_typed_value("bits[32]:0x40", &error, &x));
+  absl::Cleanup free_x([x] { xls_value_free(x); });
+  struct xls_value* y = nullptr;
+  ASSERT_TRUE(xls_parse_typed_value("bits[32]:0x2", &error, &y));
+  absl::Cleanup free_y([y] { xls_value_free(y); });
+  struct xls_value* want = nullptr;
+  ASSERT_TRUE(xls_parse_typed_value("bits[32]:0x42", &error, &want));
+  absl::Cleanup free_want([want] { xls_value_free(want); });
+
+  const struct xls_value* args[] = {x, y};
+  struct xls_value* result = nullptr;
+  ASSERT_TRUE(xls_function_jit_run(jit, /*argc=*/2, args, &error, &result))
+      << error;
+  absl::Cleanup free_result([result] { xls_value_free(result); });
+  EXPECT_TRUE(xls_value_eq(want, result));
+
+  // Now through caller-owned buffers in the native layout.
+  ASSERT_EQ(xls_function_jit_get_arg_size(jit, 0), 4);
+  ASSERT_EQ(xls_function_jit_get_result_size(jit), 4);
+  alignas(16) uint8_t x_buffer[4];
+  alignas(16) uint8_t y_buffer[4];
+  alignas(16) uint8_t result_buffer[4];
+  ASSERT_TRUE(xls_function_jit_pack_arg(jit, 0, x, x_buffer, &error));
+  ASSERT_TRUE(xls_function_jit_pack_arg(jit, 1, y, y_buffer, &error));
+  uint8_t* const arg_buffers[] = {x_buffer, y_buffer};
+  ASSERT_TRUE(xls_function_jit_run_with_buffers(jit, /*argc=*/2, arg_buffers,
+                                                result_buffer, &error))
+      << error;
+  struct xls_value* buffer_result = nullptr;
+  ASSERT_TRUE(xls_function_jit_unpack_result(jit, result_buffer, &error,
+                                             &buffer_result));
+  absl::Cleanup free_buffer_result(
+      [buffer_result] { xls_value_free(buffer_result); });
+  EXPECT_TRUE(xls_value_eq(want, buffer_result));
+
+  // Values of the wrong type are rejected.
+  struct xls_value* wide = nullptr;
+  ASSERT_TRUE(xls_parse_typed_value("bits[64]:0x1", &error, &wide));
+  absl::Cleanup free_wide([wide] { xls_value_free(wide); });
+  ASSERT_FALSE(xls_function_jit_pack_arg(jit, 0, wide, x_buffer, &error));
+  absl::Cleanup free_error([&error] { xls_c_str_free(error); });
+  EXPECT_THAT(error, HasSubstr("does not match the type bits[32]"));
+}
+
+TEST(XlsCApiTest, ProcRuntimeEnqueueAndDequeue) {
+  const std::string kPackage = R"(package p
+
+chan in(bits[32], id=0, kind=streaming, ops=receive_only, flow_control=ready_valid, strictness=proven_mutually_exclusive)
+chan out(bits[32], id=1, kind=streaming, ops=send_only, flow_control=ready_valid, strictness=proven_mutually_exclusive)
+
+top proc doubler() {
+  tok: token = literal(value=token)
+  rcv: (token, bits[32]) = receive(tok, channel=in)
+  rcv_tok: token = tuple_index(rcv, index=0)
+  data: bits[32] = tuple_index(rcv, index=1)
+  doubled: bits[32] = add(data, data)
+  snd: token = send(rcv_tok, doubled, channel=out)
+}
+)";
+
+  char* error = nullptr;
+  struct xls_package* package = nullptr;
+  ASSERT_TRUE(xls_parse_ir_package(kPackage.c_str(), "p.ir", &error, &package))
+      << "xls_parse_ir_package error: " << error;
+  absl::Cleanup free_package([package] { xls_package_free(package); });
+
+  for (bool use_jit : {false, true}) {
+    struct xls_proc_runtime* runtime = nullptr;
+    ASSERT_TRUE(xls_proc_runtime_create(package, use_jit, &error, &runtime))
+        << error;
+    absl::Cleanup free_runtime([runtime] { xls_proc_runtime_free(runtime); });
+
+    struct xls_value* input = nullptr;
+    ASSERT_TRUE(xls_parse_typed_value("bits[32]:21", &error, &input));
+    absl::Cleanup free_input([input] { xls_value_free(input); });
+    ASSERT_TRUE(xls_proc_runtime_channel_enqueue(runtime, "in", input, &error))
+        << error;
+
+    int64_t ticks = 0;
+    ASSERT_TRUE(xls_proc_runtime_tick_until_blocked(runtime, /*max_ticks=*/10,
+                                                    &error, &ticks))
+        << error;
+
+    bool has_value = false;
+    struct xls_value* output = nullptr;
+    ASSERT_TRUE(xls_proc_runtime_channel_dequeue(runtime, "out", &error,
+                                                 &has_value, &output))
+        << error;
+    ASSERT_TRUE(has_value);
+    absl::Cleanup free_output([output] { xls_value_free(output); });
+    char* output_str = nullptr;
+    ASSERT_TRUE(xls_value_to_string(output, &output_str));
+    absl::Cleanup free_output_str([output_str] { xls_c_str_free(output_str); });
+    EXPECT_EQ(std::string_view(output_str), "bits[32]:42");
+
+    ASSERT_TRUE(xls_proc_runtime_channel_dequeue(runtime, "out", &error,
+                                                 &has_value, &output))
+        << error;
+    EXPECT_FALSE(has_value);
+
+    ASSERT_FALSE(xls_proc_runtime_channel_enqueue(runtime, "nonexistent",
+                                                  input, &error));
+    xls_c_str_free(error);
+    error = nullptr;
+  }
+}
+
 TEST(XlsCApiTest, MangleDslxName) {
   std::string module_name = "foo_bar";
   std::string function_name = "baz_bat";
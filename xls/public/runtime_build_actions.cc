@@ -18,6 +18,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
@@ -30,6 +31,7 @@
 #include "xls/dslx/frontend/ast.h"
 #include "xls/dslx/frontend/pos.h"
 #include "xls/dslx/import_data.h"
+#include "xls/dslx/ir_convert/conversion_info.h"
 #include "xls/dslx/ir_convert/convert_options.h"
 #include "xls/dslx/ir_convert/ir_converter.h"
 #include "xls/dslx/mangle.h"
@@ -48,7 +50,7 @@ namespace xls {
 
 std::string_view GetDefaultDslxStdlibPath() { return kDefaultDslxStdlibPath; }
 
-absl::StatusOr<std::string> ConvertDslxToIr(
+absl::StatusOr<std::unique_ptr<Package>> ConvertDslxToPackage(
     std::string_view dslx, std::string_view path, std::string_view module_name,
     std::string_view dslx_stdlib_path,
     absl::Span<const std::filesystem::path> additional_search_paths) {
@@ -60,17 +62,40 @@ absl::StatusOr<std::string> ConvertDslxToIr(
   XLS_ASSIGN_OR_RETURN(
       dslx::TypecheckedModule typechecked,
       dslx::ParseAndTypecheck(dslx, path, module_name, &import_data));
-  return dslx::ConvertModule(typechecked.module, &import_data,
-                             dslx::ConvertOptions{});
+  XLS_ASSIGN_OR_RETURN(dslx::PackageConversionData conv,
+                       dslx::ConvertModuleToPackage(
+                           typechecked.module, &import_data,
+                           dslx::ConvertOptions{}));
+  return std::move(conv.package);
 }
 
-absl::StatusOr<std::string> ConvertDslxPathToIr(
+absl::StatusOr<std::unique_ptr<Package>> ConvertDslxPathToPackage(
     const std::filesystem::path& path, std::string_view dslx_stdlib_path,
     absl::Span<const std::filesystem::path> additional_search_paths) {
   XLS_ASSIGN_OR_RETURN(std::string dslx, GetFileContents(path));
   XLS_ASSIGN_OR_RETURN(std::string module_name, dslx::ExtractModuleName(path));
-  return ConvertDslxToIr(dslx, std::string{path}, module_name, dslx_stdlib_path,
-                         additional_search_paths);
+  return ConvertDslxToPackage(dslx, std::string{path}, module_name,
+                              dslx_stdlib_path, additional_search_paths);
+}
+
+absl::StatusOr<std::string> ConvertDslxToIr(
+    std::string_view dslx, std::string_view path, std::string_view module_name,
+    std::string_view dslx_stdlib_path,
+    absl::Span<const std::filesystem::path> additional_search_paths) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ConvertDslxToPackage(dslx, path, module_name,
+                                            dslx_stdlib_path,
+                                            additional_search_paths));
+  return package->DumpIr();
+}
+
+absl::StatusOr<std::string> ConvertDslxPathToIr(
+    const std::filesystem::path& path, std::string_view dslx_stdlib_path,
+    absl::Span<const std::filesystem::path> additional_search_paths) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ConvertDslxPathToPackage(path, dslx_stdlib_path,
+                                                additional_search_paths));
+  return package->DumpIr();
 }
 
 absl::StatusOr<std::string> OptimizeIr(std::string_view ir,
@@ -29,6 +29,7 @@
 // these actions remaining stable, they will evolve as the XLS system evolves.
 
 #include <filesystem>  // NOLINT
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -75,6 +76,17 @@ absl::StatusOr<std::string> ConvertDslxPathToIr(
     const std::filesystem::path& path, std::string_view dslx_stdlib_path,
     absl::Span<const std::filesystem::path> additional_search_paths);
 
+// As the two functions above, but return the converted package itself rather
+// than its IR text, for callers which go on to transform, merge or codegen the
+// package in memory and would otherwise have to parse the text back.
+absl::StatusOr<std::unique_ptr<Package>> ConvertDslxToPackage(
+    std::string_view dslx, std::string_view path, std::string_view module_name,
+    std::string_view dslx_stdlib_path,
+    absl::Span<const std::filesystem::path> additional_search_paths);
+absl::StatusOr<std::unique_ptr<Package>> ConvertDslxPathToPackage(
+    const std::filesystem::path& path, std::string_view dslx_stdlib_path,
+    absl::Span<const std::filesystem::path> additional_search_paths);
+
 // Optimizes the generated XLS IR with the given top-level entity (e.g.,
 // function, proc, etc).
 absl::StatusOr<std::string> OptimizeIr(std::string_view ir,
@@ -14,12 +14,14 @@
 
 #include "xls/public/runtime_build_actions.h"
 
+#include <memory>
 #include <string>
 #include <string_view>
 
 #include "gtest/gtest.h"
 #include "xls/common/status/matchers.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
+#include "xls/public/ir.h"
 
 namespace xls {
 namespace {
@@ -62,6 +64,20 @@ pub struct TestRepeatedMessage {
 pub const MY_TEST_MESSAGE = TestRepeatedMessage { messages: [TestMessage { test_field: sN[32]:42 }, TestMessage { test_field: sN[32]:64 }], messages_count: u32:2 };)");
 }
 
+TEST(RuntimeBuildActionsTest, ConvertDslxToPackage) {
+  constexpr std::string_view kDslx = "fn f(x: u32) -> u32 { x + u32:1 }";
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Package> package,
+      ConvertDslxToPackage(kDslx, "<test>", "test_module",
+                           GetDefaultDslxStdlibPath(), {}));
+  XLS_EXPECT_OK(package->GetFunction("__test_module__f"));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::string ir, ConvertDslxToIr(kDslx, "<test>", "test_module",
+                                      GetDefaultDslxStdlibPath(), {}));
+  EXPECT_EQ(ir, package->DumpIr());
+}
+
 TEST(RuntimeBuildActionsTest, DefaultDslxPath) {
   EXPECT_EQ(GetDefaultDslxStdlibPath(), kDefaultDslxStdlibPath);
 }
@@ -26,7 +26,6 @@
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/source_location.h"
-#include "xls/ir/topo_sort.h"
 #include "xls/scheduling/pipeline_schedule.h"
 
 namespace xls {
@@ -41,43 +40,43 @@ absl::StatusOr<Function*> ExtractStage(FunctionBase* src,
       absl::StrFormat("%s_stage_%d", src->name(), stage), package);
   absl::flat_hash_map<Node*, Node*> node_map;
   std::vector<Node*> live_out;
-  for (Node* node : TopoSort(src)) {
-    if (schedule.cycle(node) == stage) {
-      std::vector<Node*> new_operands;
-      for (Node* operand : node->operands()) {
-        if (node_map.contains(operand)) {
-          new_operands.push_back(node_map.at(operand));
-        } else {
-          Node* new_param = new_f->AddNode(
-              std::make_unique<Param>(operand->loc(), operand->GetType(),
-                                      operand->GetName(), new_f.get()));
-          node_map[operand] = new_param;
-          new_operands.push_back(new_param);
-        }
-      }
-      // hack to support viewing procs as functions
-      Node* new_node;
-      if (node->Is<StateRead>() || node->Is<Next>() || node->Is<Send>() ||
-          node->Is<Receive>()) {
-        // NB The fact that data-dependencies is dropped is fine since prior to
-        // this anything used by the Send or Next node is marked for return
-        // below.
-        new_node = new_f->AddNode(std::make_unique<xls::Param>(
-            node->loc(), node->GetType(), node->GetName(), new_f.get()));
+  // The schedule holds the nodes of each stage in topological order, so only
+  // the stage itself is walked.
+  for (Node* node : schedule.nodes_in_cycle(stage)) {
+    std::vector<Node*> new_operands;
+    for (Node* operand : node->operands()) {
+      if (node_map.contains(operand)) {
+        new_operands.push_back(node_map.at(operand));
       } else {
-        XLS_ASSIGN_OR_RETURN(
-            new_node, node->CloneInNewFunction(new_operands, new_f.get()));
-      }
-      node_map[node] = new_node;
-      // NB This checks whether the value is *USED* by a send or next and
-      // returns it.
-      if (std::any_of(node->users().begin(), node->users().end(), [&](Node* u) {
-            return schedule.cycle(u) > stage || u->Is<Send>() ||
-                   u->Is<Next>() || new_f->HasImplicitUse(node);
-          })) {
-        live_out.push_back(new_node);
+        Node* new_param = new_f->AddNode(
+            std::make_unique<Param>(operand->loc(), operand->GetType(),
+                                    operand->GetName(), new_f.get()));
+        node_map[operand] = new_param;
+        new_operands.push_back(new_param);
       }
     }
+    // hack to support viewing procs as functions
+    Node* new_node;
+    if (node->Is<StateRead>() || node->Is<Next>() || node->Is<Send>() ||
+        node->Is<Receive>()) {
+      // NB The fact that data-dependencies is dropped is fine since prior to
+      // this anything used by the Send or Next node is marked for return
+      // below.
+      new_node = new_f->AddNode(std::make_unique<xls::Param>(
+          node->loc(), node->GetType(), node->GetName(), new_f.get()));
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          new_node, node->CloneInNewFunction(new_operands, new_f.get()));
+    }
+    node_map[node] = new_node;
+    // NB This checks whether the value is *USED* by a send or next and
+    // returns it.
+    if (std::any_of(node->users().begin(), node->users().end(), [&](Node* u) {
+          return schedule.cycle(u) > stage || u->Is<Send>() ||
+                 u->Is<Next>() || new_f->HasImplicitUse(node);
+        })) {
+      live_out.push_back(new_node);
+    }
   }
 
   // If this stage doesn't include the function output, create a final tuple
@@ -99,4 +98,16 @@ absl::StatusOr<Function*> ExtractStage(FunctionBase* src,
   }
   return package->AddFunction(std::move(new_f));
 }
+
+absl::StatusOr<std::vector<Function*>> ExtractStages(
+    FunctionBase* src, const PipelineSchedule& schedule) {
+  std::vector<Function*> stages;
+  stages.reserve(schedule.length());
+  for (int stage = 0; stage < schedule.length(); ++stage) {
+    XLS_ASSIGN_OR_RETURN(stages.emplace_back(),
+                         ExtractStage(src, schedule, stage));
+  }
+  return stages;
+}
+
 }  // namespace xls
@@ -15,6 +15,8 @@
 #ifndef XLS_SCHEDULING_EXTRACT_STAGE_H_
 #define XLS_SCHEDULING_EXTRACT_STAGE_H_
 
+#include <vector>
+
 #include "absl/status/statusor.h"
 #include "xls/ir/function.h"
 #include "xls/ir/function_base.h"
@@ -28,6 +30,12 @@ absl::StatusOr<Function*> ExtractStage(FunctionBase* src,
                                        const PipelineSchedule& schedule,
                                        int stage);
 
+// Extracts every stage of the schedule as ExtractStage does, returning the new
+// functions in stage order. Each stage walks only its own nodes, so extracting
+// all the stages costs about as much as a single walk of 'src'.
+absl::StatusOr<std::vector<Function*>> ExtractStages(
+    FunctionBase* src, const PipelineSchedule& schedule);
+
 }  // namespace xls
 
 #endif  // XLS_SCHEDULING_EXTRACT_STAGE_H_
@@ -15,6 +15,7 @@
 #include "xls/scheduling/extract_stage.h"
 
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -107,6 +108,45 @@ fn main(i0: bits[3], i1: bits[3]) -> bits[3] {
   }
 }
 
+TEST_F(ExtractStageTest, ExtractAllStages) {
+  std::string ir_text = R"(
+package p
+
+fn main(i0: bits[3], i1: bits[3]) -> bits[3] {
+  add.1: bits[3] = add(i0, i1)
+  sub.2: bits[3] = sub(add.1, i1)
+  or.3: bits[3] = or(sub.2, add.1)
+  ret and.4: bits[3] = and(or.3, sub.2)
+}
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function, package->GetFunction("main"));
+  ScheduleCycleMap cycle_map;
+  cycle_map[FindNode("i0", function)] = 0;
+  cycle_map[FindNode("i1", function)] = 0;
+  cycle_map[FindNode("add.1", function)] = 0;
+  cycle_map[FindNode("sub.2", function)] = 1;
+  cycle_map[FindNode("or.3", function)] = 1;
+  cycle_map[FindNode("and.4", function)] = 2;
+
+  PipelineSchedule schedule(function, cycle_map);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<Function*> stages,
+                           ExtractStages(function, schedule));
+  ASSERT_EQ(stages.size(), 3);
+  for (int i = 0; i < stages.size(); ++i) {
+    EXPECT_EQ(stages[i]->name(), absl::StrFormat("main_stage_%d", i));
+  }
+  EXPECT_THAT(
+      stages[0]->return_value(),
+      m::Tuple(m::Param("i1"), m::Add(m::Param("i0"), m::Param("i1"))));
+  EXPECT_THAT(stages[1]->return_value(),
+              m::Tuple(m::Sub(m::Param("add.1"), m::Param("i1")),
+                       m::Or(m::Sub(), m::Param("add.1"))));
+  EXPECT_THAT(stages[2]->return_value(),
+              m::And(m::Param("or.3"), m::Param("sub.2")));
+}
+
 // Verifies that stages w/multiple outputs have them grouped into a tuple.
 TEST_F(ExtractStageTest, TuplizesStageOutputs) {
   std::string ir_text = R"(
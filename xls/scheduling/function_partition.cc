@@ -15,14 +15,11 @@
 #include "xls/scheduling/function_partition.h"
 
 #include <cstdint>
-#include <iterator>
 #include <limits>
 #include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
-#include "absl/container/flat_hash_map.h"
-#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
@@ -36,60 +33,101 @@
 namespace xls {
 namespace sched {
 
-std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
-    FunctionBase* f, absl::Span<Node* const> partitionable_nodes) {
+namespace {
+
+constexpr int64_t kMaxWeight = std::numeric_limits<int64_t>::max();
+
+// Graph nodes of the artificial source and sink. The graph node of the XLS
+// node with dense index `i` is `kFirstNode + i`.
+constexpr operations_research::NodeIndex kSource = 0;
+constexpr operations_research::NodeIndex kSink = 1;
+constexpr operations_research::NodeIndex kFirstNode = 2;
+
+}  // namespace
+
+MinCostPartitioner::MinCostPartitioner(FunctionBase* f)
+    : f_(f),
+      nodes_(f->node_count()),
+      in_graph_(f->node_count(), false),
+      partitionable_(f->node_count(), false) {
+  for (Node* node : f->nodes()) {
+    nodes_[node->dense_index()] = node;
+  }
+
+  // Adds an edge to the mincut graph. To enforce that the cut is a dicut (no
+  // circular dependencies between the two partitions), the edge comes with an
+  // opposing edge of maximum weight. All edges start out with no capacity.
+  auto add_edge = [&](operations_research::NodeIndex src,
+                      operations_research::NodeIndex tgt) {
+    return Edge{.forward = max_flow_.AddArcWithCapacity(src, tgt, 0),
+                .backward = max_flow_.AddArcWithCapacity(tgt, src, 0)};
+  };
+
+  operations_research::NodeIndex next_fan_in_node =
+      kFirstNode + static_cast<operations_research::NodeIndex>(nodes_.size());
+  source_edges_.reserve(nodes_.size());
+  sink_edges_.reserve(nodes_.size());
+  user_edges_.resize(nodes_.size());
+  fan_in_edges_.resize(nodes_.size());
+  for (int64_t i = 0; i < nodes_.size(); ++i) {
+    Node* node = nodes_[i];
+    operations_research::NodeIndex graph_node = kFirstNode + i;
+    source_edges_.push_back(add_edge(kSource, graph_node));
+    sink_edges_.push_back(add_edge(graph_node, kSink));
+    operations_research::NodeIndex fan_in_node =
+        node->users().size() > 1 ? next_fan_in_node++ : -1;
+    for (Node* user : node->users()) {
+      operations_research::NodeIndex user_node =
+          kFirstNode + user->dense_index();
+      user_edges_[i].push_back(add_edge(graph_node, user_node));
+      if (fan_in_node >= 0) {
+        fan_in_edges_[i].push_back(add_edge(user_node, fan_in_node));
+      }
+    }
+  }
+}
+
+void MinCostPartitioner::ActivateEdge(const Edge& edge, int64_t weight) {
+  max_flow_.SetArcCapacity(edge.forward, weight);
+  max_flow_.SetArcCapacity(edge.backward, kMaxWeight);
+  active_edges_.push_back(edge);
+}
+
+std::pair<std::vector<Node*>, std::vector<Node*>>
+MinCostPartitioner::Partition(absl::Span<Node* const> partitionable_nodes) {
   if (VLOG_IS_ON(4)) {
-    VLOG(4) << "Computing min-cut of function " << f->name()
+    VLOG(4) << "Computing min-cut of function " << f_->name()
             << ", partitionable nodes:";
     for (Node* node : partitionable_nodes) {
       VLOG(4) << "  " << node->GetName();
     }
   }
 
-  absl::flat_hash_set<Node*> partitionable_nodes_set(
-      partitionable_nodes.begin(), partitionable_nodes.end());
-  CHECK_EQ(partitionable_nodes_set.size(), partitionable_nodes.size());
-
-  operations_research::SimpleMaxFlow max_flow;
-  using NodeId = operations_research::NodeIndex;
-
-  const NodeId source = 0;
-  const NodeId sink = 1;
+  // Remove the edges of the previous partition from the graph.
+  for (const Edge& edge : active_edges_) {
+    max_flow_.SetArcCapacity(edge.forward, 0);
+    max_flow_.SetArcCapacity(edge.backward, 0);
+  }
+  active_edges_.clear();
 
-  NodeId num_nodes = 2;
-  auto next_node_id = [&]() { return num_nodes++; };
+  for (Node* node : partitionable_nodes) {
+    CHECK(!partitionable_[node->dense_index()]);
+    partitionable_[node->dense_index()] = true;
+  }
 
   std::vector<Node*> xls_nodes_in_mincut_graph;
-
-  // Maps to/from XLS Nodes to nodes in the mincut graph.
-  absl::flat_hash_map<Node*, NodeId> xls_to_mincut_node;
-  absl::flat_hash_map<NodeId, Node*> mincut_to_xls_node;
-
-  const int64_t kMaxWeight = std::numeric_limits<int64_t>::max();
-
-  // Adds an edge to the mincut graph. To enforce that the cut is a dicut (no
-  // circular dependencies between the two partitions), add an opposing edge of
-  // maximum weight.
-  auto add_edge = [&](NodeId src, NodeId tgt, int64_t weight) {
-    max_flow.AddArcWithCapacity(src, tgt, weight);
-    max_flow.AddArcWithCapacity(tgt, src, kMaxWeight);
-  };
-
   auto add_node_to_mincut_graph = [&](Node* node) {
-    CHECK(!xls_to_mincut_node.contains(node));
-    NodeId graph_node_id = next_node_id();
-    xls_to_mincut_node[node] = graph_node_id;
-    mincut_to_xls_node[graph_node_id] = node;
+    CHECK(!in_graph_[node->dense_index()]);
+    in_graph_[node->dense_index()] = true;
     xls_nodes_in_mincut_graph.push_back(node);
-    return graph_node_id;
   };
 
   for (Node* node : partitionable_nodes) {
-    NodeId node_id = add_node_to_mincut_graph(node);
+    add_node_to_mincut_graph(node);
     if (node->Is<Param>()) {
       // Add a maximum weight edge from the artificial source node to each
       // parameter node. This forces the cut to be below the parameter nodes.
-      add_edge(source, node_id, kMaxWeight);
+      ActivateEdge(source_edges_[node->dense_index()], kMaxWeight);
     }
 
     // Add a node in the mincut graph for each operand of a node in the
@@ -98,10 +136,10 @@ std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
     // maximum weight from the source node to each of these operand nodes to
     // enforce that the cut goes below these nodes.
     for (Node* operand : node->operands()) {
-      if (!partitionable_nodes_set.contains(operand) &&
-          !xls_to_mincut_node.contains(operand)) {
-        NodeId operand_node = add_node_to_mincut_graph(operand);
-        add_edge(source, operand_node, kMaxWeight);
+      if (!partitionable_[operand->dense_index()] &&
+          !in_graph_[operand->dense_index()]) {
+        add_node_to_mincut_graph(operand);
+        ActivateEdge(source_edges_[operand->dense_index()], kMaxWeight);
       }
     }
 
@@ -111,10 +149,10 @@ std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
     // the sink node from each of these users to enforce that the cut goes above
     // these nodes.
     for (Node* user : node->users()) {
-      if (!partitionable_nodes_set.contains(user) &&
-          !xls_to_mincut_node.contains(user)) {
-        NodeId user_node = add_node_to_mincut_graph(user);
-        add_edge(user_node, sink, kMaxWeight);
+      if (!partitionable_[user->dense_index()] &&
+          !in_graph_[user->dense_index()]) {
+        add_node_to_mincut_graph(user);
+        ActivateEdge(sink_edges_[user->dense_index()], kMaxWeight);
       }
     }
   }
@@ -133,25 +171,17 @@ std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
   // reduce rounding error because bit-widths are divided by fan-out to avoid
   // double-counting non-unit fanout nodes in the min-cut cost computation.
   for (Node* node : xls_nodes_in_mincut_graph) {
-    std::vector<NodeId> successors;
-    for (Node* user : node->users()) {
-      if (xls_to_mincut_node.contains(user)) {
-        successors.push_back(xls_to_mincut_node.at(user));
-      }
-    }
-    if (successors.empty()) {
+    int64_t fan_out = absl::c_count_if(node->users(), [&](Node* user) {
+      return in_graph_[user->dense_index()];
+    });
+    if (fan_out == 0) {
       continue;
     }
-    if (successors.size() == 1) {
-      add_edge(xls_to_mincut_node.at(node), successors.front(),
-               edge_weight(node, /*fan_out=*/1));
-      continue;
-    }
-    // The node in the mincut graph has a fanout greater than one. To avoid
-    // double counting of bit-widths in the cut, we need divide the edge weight
-    // by the fan-out amount and add a new node with a corresponding fan-in. For
-    // example, given a node 'x' in the XLS graph with a fan out of three and
-    // bit-count of C:
+    // If the node in the mincut graph has a fanout greater than one, we need
+    // to divide the edge weight by the fan-out amount and add a node with a
+    // corresponding fan-in to avoid double counting of bit-widths in the cut.
+    // For example, given a node 'x' in the XLS graph with a fan out of three
+    // and bit-count of C:
     //
     //      x
     //    / | \
@@ -168,41 +198,48 @@ std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
     //      \ | / kWeightFactor * C/3
     //     x_fanin
     //
-    NodeId node_sink = next_node_id();
-    int64_t weight = edge_weight(node, /*fan_out=*/successors.size());
-    for (NodeId successor : successors) {
-      add_edge(xls_to_mincut_node.at(node), successor, weight);
-      add_edge(successor, node_sink, weight);
+    int64_t weight = edge_weight(node, fan_out);
+    absl::Span<Node* const> users = node->users();
+    for (int64_t i = 0; i < users.size(); ++i) {
+      if (!in_graph_[users[i]->dense_index()]) {
+        continue;
+      }
+      ActivateEdge(user_edges_[node->dense_index()][i], weight);
+      if (fan_out > 1) {
+        ActivateEdge(fan_in_edges_[node->dense_index()][i], weight);
+      }
     }
   }
 
-  CHECK_EQ(max_flow.Solve(source, sink),
+  CHECK_EQ(max_flow_.Solve(kSource, kSink),
            operations_research::SimpleMaxFlow::OPTIMAL);
 
   // Map the mincut graph partition back to the XLS graph.
+  std::vector<bool> in_source_partition(max_flow_.NumNodes(), false);
+  {
+    std::vector<operations_research::NodeIndex> source_partition_ids;
+    max_flow_.GetSourceSideMinCut(&source_partition_ids);
+    for (operations_research::NodeIndex id : source_partition_ids) {
+      in_source_partition[id] = true;
+    }
+  }
   std::pair<std::vector<Node*>, std::vector<Node*>> partitions;
   auto& [source_partition, sink_partition] = partitions;
+  for (Node* node : partitionable_nodes) {
+    if (in_source_partition[kFirstNode + node->dense_index()]) {
+      source_partition.push_back(node);
+    } else {
+      sink_partition.push_back(node);
+    }
+  }
 
-  absl::flat_hash_set<NodeId> source_partition_id_set;
-  {
-    std::vector<NodeId> source_partition_ids;
-    max_flow.GetSourceSideMinCut(&source_partition_ids);
-    absl::c_move(source_partition_ids,
-                 std::inserter(source_partition_id_set,
-                               source_partition_id_set.begin()));
+  for (Node* node : xls_nodes_in_mincut_graph) {
+    in_graph_[node->dense_index()] = false;
   }
-  for (NodeId id = 0; id < num_nodes; ++id) {
-    if (mincut_to_xls_node.contains(id)) {
-      Node* node = mincut_to_xls_node.at(id);
-      if (partitionable_nodes_set.contains(node)) {
-        if (source_partition_id_set.contains(id)) {
-          source_partition.push_back(node);
-        } else {
-          sink_partition.push_back(node);
-        }
-      }
-    }
+  for (Node* node : partitionable_nodes) {
+    partitionable_[node->dense_index()] = false;
   }
+
   if (VLOG_IS_ON(4)) {
     VLOG(4) << "Before cut";
     for (Node* node : partitions.first) {
@@ -216,5 +253,10 @@ std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
   return partitions;
 }
 
+std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
+    FunctionBase* f, absl::Span<Node* const> partitionable_nodes) {
+  return MinCostPartitioner(f).Partition(partitionable_nodes);
+}
+
 }  // namespace sched
 }  // namespace xls
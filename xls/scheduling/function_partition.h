@@ -15,11 +15,15 @@
 #ifndef XLS_SCHEDULING_FUNCTION_PARTITION_H_
 #define XLS_SCHEDULING_FUNCTION_PARTITION_H_
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
 #include "absl/types/span.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
+#include "ortools/graph/ebert_graph.h"
+#include "ortools/graph/max_flow.h"
 
 namespace xls {
 namespace sched {
@@ -55,6 +59,53 @@ namespace sched {
 std::pair<std::vector<Node*>, std::vector<Node*>> MinCostFunctionPartition(
     FunctionBase* f, absl::Span<Node* const> partitionable_nodes);
 
+// Computes partitions as MinCostFunctionPartition does for any number of sets
+// of nodes of one function, such as the nodes spanning each stage boundary of
+// a schedule. The flow network covering the whole function is built once and
+// each partition only sets the capacities of the edges among the nodes
+// involved in it. The function must not be modified while the partitioner is
+// in use. Not thread-safe; concurrent partitions need their own partitioner.
+class MinCostPartitioner {
+ public:
+  explicit MinCostPartitioner(FunctionBase* f);
+
+  MinCostPartitioner(const MinCostPartitioner&) = delete;
+  MinCostPartitioner& operator=(const MinCostPartitioner&) = delete;
+
+  // Same as MinCostFunctionPartition(f, partitionable_nodes).
+  std::pair<std::vector<Node*>, std::vector<Node*>> Partition(
+      absl::Span<Node* const> partitionable_nodes);
+
+ private:
+  // An edge of the flow network along with the opposing edge which prevents
+  // the cut from crossing it backwards.
+  struct Edge {
+    operations_research::ArcIndex forward;
+    operations_research::ArcIndex backward;
+  };
+
+  // Gives `edge` the given weight for the current partition.
+  void ActivateEdge(const Edge& edge, int64_t weight);
+
+  FunctionBase* f_;
+  operations_research::SimpleMaxFlow max_flow_;
+
+  // The nodes of the function and their edges, indexed by dense index.
+  std::vector<Node*> nodes_;
+  std::vector<Edge> source_edges_;
+  std::vector<Edge> sink_edges_;
+  // The edges to each user of a node, and from each user to the fan-in node of
+  // nodes with more than one user, in the order of Node::users().
+  std::vector<std::vector<Edge>> user_edges_;
+  std::vector<std::vector<Edge>> fan_in_edges_;
+
+  // The edges given a capacity by the last partition.
+  std::vector<Edge> active_edges_;
+  // Scratch space, all false between partitions.
+  std::vector<bool> in_graph_;
+  std::vector<bool> partitionable_;
+};
+
 }  // namespace sched
 }  // namespace xls
 
@@ -138,6 +138,52 @@ TEST_F(FunctionPartitionTest, LinearGraphCut) {
   }
 }
 
+TEST_F(FunctionPartitionTest, ReusedPartitioner) {
+  // The partitions of a partitioner which is used repeatedly should not depend
+  // on the partitions computed before them.
+  //
+  //      x
+  //      |
+  //  bit-slice
+  //      |   \
+  //   zero-extend  not
+  //      |
+  //    negate
+  //
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  auto x = fb.Param("x", p->GetBitsType(32));
+  auto bit_slice = fb.BitSlice(x, /*start=*/0, /*width=*/16);
+  auto zext = fb.ZeroExtend(bit_slice, /*new_bit_count=*/128);
+  auto not_slice = fb.Not(bit_slice);
+  auto neg = fb.Negate(zext);
+  fb.Tuple({neg, not_slice});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  MinCostPartitioner partitioner(f);
+  for (int64_t i = 0; i < 2; ++i) {
+    {
+      auto partition =
+          partitioner.Partition({x.node(), bit_slice.node(), zext.node()});
+      EXPECT_THAT(partition.first,
+                  UnorderedElementsAre(x.node(), bit_slice.node()));
+      EXPECT_THAT(partition.second, UnorderedElementsAre(zext.node()));
+    }
+    {
+      auto partition = partitioner.Partition({zext.node(), neg.node()});
+      EXPECT_THAT(partition.first, UnorderedElementsAre());
+      EXPECT_THAT(partition.second,
+                  UnorderedElementsAre(zext.node(), neg.node()));
+    }
+    {
+      auto partition = partitioner.Partition(AllNodes(f));
+      auto expected = MinCostFunctionPartition(f, AllNodes(f));
+      EXPECT_EQ(PartitionCost(partition.first, partition.second),
+                PartitionCost(expected.first, expected.second));
+    }
+  }
+}
+
 TEST_F(FunctionPartitionTest, DisconnectedGraph) {
   // Partition a disconnected graph:
   //
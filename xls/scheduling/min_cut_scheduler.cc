@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <optional>
 #include <utility>
@@ -33,6 +34,7 @@
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
@@ -47,24 +49,27 @@ namespace {
 
 // Splits the nodes at the boundary between 'cycle' and 'cycle + 1' by
 // performing a minimum cost cut and tightens the bounds accordingly. Upon
-// return no node in the function will have a range which spans both 'cycle' and
-// 'cycle + 1'.
+// return no node in 'nodes' will have a range which spans both 'cycle' and
+// 'cycle + 1'. 'nodes' must include every node in the function whose range
+// spans both.
 absl::Status SplitAfterCycle(FunctionBase* f, int64_t cycle,
                              const DelayEstimator& delay_estimator,
+                             absl::Span<Node* const> nodes,
+                             sched::MinCostPartitioner& partitioner,
                              sched::ScheduleBounds* bounds) {
   VLOG(3) << "Splitting after cycle " << cycle;
 
   // The nodes which need to be partitioned are those which can be scheduled in
   // either 'cycle' or 'cycle + 1'.
   std::vector<Node*> partitionable_nodes;
-  for (Node* node : f->nodes()) {
+  for (Node* node : nodes) {
     if (bounds->lb(node) <= cycle && bounds->ub(node) >= cycle + 1) {
       partitionable_nodes.push_back(node);
     }
   }
 
   std::pair<std::vector<Node*>, std::vector<Node*>> partitions =
-      sched::MinCostFunctionPartition(f, partitionable_nodes);
+      partitioner.Partition(partitionable_nodes);
 
   // Tighten bounds based on the cut.
   for (Node* node : partitions.first) {
@@ -118,6 +123,116 @@ std::vector<int64_t> MiddleFirstOrder(int64_t first, int64_t last) {
   return ret;
 }
 
+// Applies the constraints of the min-cut scheduler which are not expressed by
+// the ASAP/ALAP bounds to `bounds`.
+absl::Status ConstrainBounds(
+    FunctionBase* f, int64_t pipeline_stages, sched::ScheduleBounds* bounds,
+    absl::Span<const SchedulingConstraint> constraints) {
+  for (const SchedulingConstraint& constraint : constraints) {
+    if (std::holds_alternative<RecvsFirstSendsLastConstraint>(constraint)) {
+      for (Node* node : f->nodes()) {
+        if (node->Is<Receive>()) {
+          XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, 0));
+          XLS_RETURN_IF_ERROR(bounds->PropagateUpperBounds());
+        }
+        if (node->Is<Send>()) {
+          XLS_RETURN_IF_ERROR(bounds->TightenNodeLb(node, pipeline_stages - 1));
+          XLS_RETURN_IF_ERROR(bounds->PropagateLowerBounds());
+        }
+      }
+    } else {
+      return absl::InternalError(
+          "MinCutScheduler doesn't support constraints "
+          "other than receives-first-sends-last.");
+    }
+  }
+
+  for (Node* node : f->nodes()) {
+    if (node->Is<MinDelay>()) {
+      return absl::InternalError(
+          "MinCutScheduler doesn't support min_delay nodes.");
+    }
+  }
+
+  // The state backedge must be in the first cycle.
+  if (Proc* proc = dynamic_cast<Proc*>(f)) {
+    for (Node* node : proc->params()) {
+      XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, 0));
+      XLS_RETURN_IF_ERROR(bounds->PropagateUpperBounds());
+    }
+    for (Node* node : proc->NextState()) {
+      XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, 0));
+      XLS_RETURN_IF_ERROR(bounds->PropagateUpperBounds());
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Schedules `nodes`, whose ranges all lie within [first_cycle, last_cycle],
+// by splitting them after the middle cycle of the range and then scheduling
+// the two halves recursively. Every edge between the halves crosses the
+// split, so propagating the bounds of one half never changes the other. Halves
+// of regions with more than `max_region_size` nodes are therefore scheduled
+// concurrently, each on its own copy of the bounds.
+absl::Status ScheduleRegion(FunctionBase* f, int64_t first_cycle,
+                            int64_t last_cycle, absl::Span<Node* const> nodes,
+                            int64_t max_region_size,
+                            const DelayEstimator& delay_estimator,
+                            sched::MinCostPartitioner& partitioner,
+                            sched::ScheduleBounds* bounds) {
+  if (first_cycle >= last_cycle || nodes.empty()) {
+    return absl::OkStatus();
+  }
+  int64_t middle = (first_cycle + last_cycle) / 2;
+  XLS_RETURN_IF_ERROR(
+      SplitAfterCycle(f, middle, delay_estimator, nodes, partitioner, bounds));
+  XLS_RETURN_IF_ERROR(bounds->PropagateLowerBounds());
+  XLS_RETURN_IF_ERROR(bounds->PropagateUpperBounds());
+
+  std::vector<Node*> head;
+  std::vector<Node*> tail;
+  for (Node* node : nodes) {
+    (bounds->ub(node) <= middle ? head : tail).push_back(node);
+  }
+  if (static_cast<int64_t>(nodes.size()) <= max_region_size) {
+    XLS_RETURN_IF_ERROR(ScheduleRegion(f, first_cycle, middle, head,
+                                       max_region_size, delay_estimator,
+                                       partitioner, bounds));
+    return ScheduleRegion(f, middle + 1, last_cycle, tail, max_region_size,
+                          delay_estimator, partitioner, bounds);
+  }
+
+  VLOG(3) << absl::StreamFormat(
+      "Scheduling cycles [%d, %d] (%d nodes) and [%d, %d] (%d nodes) "
+      "concurrently",
+      first_cycle, middle, head.size(), middle + 1, last_cycle, tail.size());
+  sched::ScheduleBounds head_bounds = *bounds;
+  absl::Status head_status;
+  absl::Status tail_status;
+  {
+    // Threads are joined on destruction. A partitioner may only be used by one
+    // thread at a time so the head gets its own.
+    Thread thread([&]() {
+      sched::MinCostPartitioner head_partitioner(f);
+      head_status = ScheduleRegion(f, first_cycle, middle, head,
+                                   max_region_size, delay_estimator,
+                                   head_partitioner, &head_bounds);
+    });
+    tail_status =
+        ScheduleRegion(f, middle + 1, last_cycle, tail, max_region_size,
+                       delay_estimator, partitioner, bounds);
+  }
+  XLS_RETURN_IF_ERROR(head_status);
+  XLS_RETURN_IF_ERROR(tail_status);
+
+  // Stitch the schedule of the head back into `bounds`.
+  for (Node* node : head) {
+    XLS_RETURN_IF_ERROR(bounds->TightenNodeLb(node, head_bounds.lb(node)));
+    XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, head_bounds.ub(node)));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 std::vector<std::vector<int64_t>> GetMinCutCycleOrders(int64_t length) {
@@ -157,72 +272,90 @@ absl::StatusOr<ScheduleCycleMap> MinCutScheduler(
   VLOG(4) << "Initial bounds:";
   XLS_VLOG_LINES(4, bounds->ToString());
 
-  for (const SchedulingConstraint& constraint : constraints) {
-    if (std::holds_alternative<RecvsFirstSendsLastConstraint>(constraint)) {
-      for (Node* node : f->nodes()) {
-        if (node->Is<Receive>()) {
-          XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, 0));
-          XLS_RETURN_IF_ERROR(bounds->PropagateUpperBounds());
-        }
-        if (node->Is<Send>()) {
-          XLS_RETURN_IF_ERROR(bounds->TightenNodeLb(node, pipeline_stages - 1));
-          XLS_RETURN_IF_ERROR(bounds->PropagateLowerBounds());
-        }
-      }
-    } else {
-      return absl::InternalError(
-          "MinCutScheduler doesn't support constraints "
-          "other than receives-first-sends-last.");
-    }
-  }
-
-  for (Node* node : f->nodes()) {
-    if (node->Is<MinDelay>()) {
-      return absl::InternalError(
-          "MinCutScheduler doesn't support min_delay nodes.");
-    }
-  }
+  XLS_RETURN_IF_ERROR(
+      ConstrainBounds(f, pipeline_stages, bounds, constraints));
+  std::vector<Node*> nodes(f->nodes().begin(), f->nodes().end());
 
-  // The state backedge must be in the first cycle.
-  if (Proc* proc = dynamic_cast<Proc*>(f)) {
-    for (Node* node : proc->params()) {
-      XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, 0));
-      XLS_RETURN_IF_ERROR(bounds->PropagateUpperBounds());
-    }
-    for (Node* node : proc->NextState()) {
-      XLS_RETURN_IF_ERROR(bounds->TightenNodeUb(node, 0));
-      XLS_RETURN_IF_ERROR(bounds->PropagateUpperBounds());
+  // Try a number of different orderings of cycle boundary at which the min-cut
+  // is performed and keep the best one. The trials are independent of each
+  // other so each runs on its own thread with its own copy of the bounds and
+  // its own flow network, which is reused for every cut of the trial.
+  std::vector<std::vector<int64_t>> cut_orders =
+      GetMinCutCycleOrders(pipeline_stages - 1);
+  std::vector<sched::ScheduleBounds> trial_bounds(cut_orders.size(), *bounds);
+  std::vector<absl::StatusOr<int64_t>> trial_register_counts(
+      cut_orders.size());
+  auto run_trial = [&](int64_t trial) {
+    trial_register_counts[trial] = [&]() -> absl::StatusOr<int64_t> {
+      VLOG(3) << absl::StreamFormat("Trying cycle order: {%s}",
+                                    absl::StrJoin(cut_orders[trial], ", "));
+      sched::MinCostPartitioner partitioner(f);
+      // Partition the nodes at each cycle boundary. For each iteration, this
+      // splits the nodes into those which must be scheduled at or before the
+      // cycle and those which must be scheduled after. Upon loop completion
+      // each node will have a range of exactly one cycle.
+      for (int64_t cycle : cut_orders[trial]) {
+        XLS_RETURN_IF_ERROR(SplitAfterCycle(f, cycle, delay_estimator, nodes,
+                                            partitioner,
+                                            &trial_bounds[trial]));
+        XLS_RETURN_IF_ERROR(trial_bounds[trial].PropagateLowerBounds());
+        XLS_RETURN_IF_ERROR(trial_bounds[trial].PropagateUpperBounds());
+      }
+      return CountInteriorPipelineRegisters(f, trial_bounds[trial]);
+    }();
+  };
+  if (cut_orders.size() == 1) {
+    run_trial(0);
+  } else {
+    // Threads are joined on destruction.
+    std::vector<std::unique_ptr<Thread>> threads;
+    threads.reserve(cut_orders.size());
+    for (int64_t trial = 0; trial < cut_orders.size(); ++trial) {
+      threads.push_back(std::make_unique<Thread>(
+          [&run_trial, trial]() { run_trial(trial); }));
     }
   }
 
-  // Try a number of different orderings of cycle boundary at which the min-cut
-  // is performed and keep the best one.
+  // Pick the first of the trials with the fewest registers so the result does
+  // not depend on the order in which the threads finish.
   int64_t best_register_count = std::numeric_limits<int64_t>::max();
-  std::optional<sched::ScheduleBounds> best_bounds;
-  for (const std::vector<int64_t>& cut_order :
-       GetMinCutCycleOrders(pipeline_stages - 1)) {
-    VLOG(3) << absl::StreamFormat("Trying cycle order: {%s}",
-                                  absl::StrJoin(cut_order, ", "));
-    sched::ScheduleBounds trial_bounds = *bounds;
-    // Partition the nodes at each cycle boundary. For each iteration, this
-    // splits the nodes into those which must be scheduled at or before the
-    // cycle and those which must be scheduled after. Upon loop completion each
-    // node will have a range of exactly one cycle.
-    for (int64_t cycle : cut_order) {
-      XLS_RETURN_IF_ERROR(
-          SplitAfterCycle(f, cycle, delay_estimator, &trial_bounds));
-      XLS_RETURN_IF_ERROR(trial_bounds.PropagateLowerBounds());
-      XLS_RETURN_IF_ERROR(trial_bounds.PropagateUpperBounds());
-    }
+  std::optional<int64_t> best_trial;
+  for (int64_t trial = 0; trial < cut_orders.size(); ++trial) {
     XLS_ASSIGN_OR_RETURN(int64_t trial_register_count,
-                         CountInteriorPipelineRegisters(f, trial_bounds));
-    if (!best_bounds.has_value() ||
+                         trial_register_counts[trial]);
+    if (!best_trial.has_value() ||
         best_register_count > trial_register_count) {
-      best_bounds = std::move(trial_bounds);
+      best_trial = trial;
       best_register_count = trial_register_count;
     }
   }
-  *bounds = std::move(*best_bounds);
+  *bounds = std::move(trial_bounds[*best_trial]);
+
+  ScheduleCycleMap cycle_map;
+  for (Node* node : f->nodes()) {
+    XLS_RET_CHECK_EQ(bounds->lb(node), bounds->ub(node)) << node->GetName();
+    cycle_map[node] = bounds->lb(node);
+  }
+  return cycle_map;
+}
+
+absl::StatusOr<ScheduleCycleMap> PartitionedMinCutScheduler(
+    FunctionBase* f, int64_t pipeline_stages, int64_t clock_period_ps,
+    const DelayEstimator& delay_estimator, sched::ScheduleBounds* bounds,
+    absl::Span<const SchedulingConstraint> constraints,
+    int64_t max_region_size) {
+  VLOG(3) << "PartitionedMinCutScheduler()";
+  VLOG(3) << "  pipeline stages = " << pipeline_stages;
+  VLOG(3) << "  max region size = " << max_region_size;
+
+  XLS_RETURN_IF_ERROR(
+      ConstrainBounds(f, pipeline_stages, bounds, constraints));
+  std::vector<Node*> nodes(f->nodes().begin(), f->nodes().end());
+  sched::MinCostPartitioner partitioner(f);
+  XLS_RETURN_IF_ERROR(ScheduleRegion(f, /*first_cycle=*/0,
+                                     /*last_cycle=*/pipeline_stages - 1, nodes,
+                                     max_region_size, delay_estimator,
+                                     partitioner, bounds));
 
   ScheduleCycleMap cycle_map;
   for (Node* node : f->nodes()) {
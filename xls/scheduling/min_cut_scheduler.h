@@ -36,6 +36,19 @@ absl::StatusOr<ScheduleCycleMap> MinCutScheduler(
     const DelayEstimator& delay_estimator, sched::ScheduleBounds* bounds,
     absl::Span<const SchedulingConstraint> constraints);
 
+// Schedules as MinCutScheduler, but divides and conquers: the nodes are split
+// at the middle cycle boundary of the pipeline with a minimum cost cut, and the
+// nodes on either side are then scheduled recursively in the cycles on their
+// side. The two sides are independent, so while a side has more than
+// `max_region_size` nodes its halves are scheduled concurrently. Only one cut
+// order is tried, so this is cheaper but may use more registers than
+// MinCutScheduler.
+absl::StatusOr<ScheduleCycleMap> PartitionedMinCutScheduler(
+    FunctionBase* f, int64_t pipeline_stages, int64_t clock_period_ps,
+    const DelayEstimator& delay_estimator, sched::ScheduleBounds* bounds,
+    absl::Span<const SchedulingConstraint> constraints,
+    int64_t max_region_size);
+
 // Returns the list of ordering of cycles (pipeline stages) in which to compute
 // min cut of the graph. Each min cut of the graph computes which XLS node
 // values are in registers after a particular stage in the pipeline schedule. A
@@ -19,7 +19,6 @@
 #include <functional>
 #include <iterator>
 #include <memory>
-#include <numeric>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -56,8 +55,13 @@
 #include "xls/ir/topo_sort.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
+#include "xls/passes/bdd_function.h"
+#include "xls/passes/bdd_query_engine.h"
 #include "xls/passes/post_dominator_analysis.h"
+#include "xls/passes/query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
 #include "xls/passes/token_provenance_analysis.h"
+#include "xls/passes/union_query_engine.h"
 #include "xls/scheduling/scheduling_options.h"
 #include "xls/scheduling/scheduling_pass.h"
 #include "xls/solvers/z3_ir_translator.h"
@@ -124,6 +128,14 @@ std::vector<std::pair<Node*, int64_t>> PredicateNodes(Predicates* p,
 
 bool IsHeavyOp(Op op) { return op == Op::kSend || op == Op::kReceive; }
 
+// Only sends (or receives) on the same channel can be merged, so the analysis
+// only ever relates channel operations with the same key.
+using ChannelOpKey = std::pair<Op, std::string>;
+
+ChannelOpKey GetChannelOpKey(Node* node) {
+  return {node->op(), node->As<ChannelNode>()->channel_name()};
+}
+
 using NodeRelation = absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>>;
 
 // Find all nodes that the given node transitively depends on.
@@ -208,7 +220,7 @@ absl::StatusOr<NodeRelation> ComputeMergableEffects(FunctionBase* f) {
   };
 
   NodeRelation result;
-  NodeRelation transitive_closure = TransitiveClosure<Node*>(token_dag);
+  NodeRelation transitive_closure = DenseTransitiveClosure<Node*>(token_dag);
   for (Node* node : ReverseTopoSort(f)) {
     if (node->Is<Send>() || node->Is<Receive>()) {
       absl::flat_hash_set<Node*> subgraph =
@@ -261,15 +273,10 @@ absl::StatusOr<NodeRelation> ComputeMergableEffects(FunctionBase* f) {
 // A merge class is a set of nodes that are all jointly mutually exclusive.
 absl::StatusOr<std::vector<absl::flat_hash_set<Node*>>> ComputeMergeClasses(
     Predicates* p, FunctionBase* f, const ScheduleCycleMap& scm) {
-  absl::flat_hash_set<Node*> nodes;
-  std::vector<Node*> ordered_nodes;
-  absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>> neighborhoods;
-
+  absl::btree_map<ChannelOpKey, std::vector<Node*>> groups;
   for (Node* node : TopoSort(f)) {
-    if (IsHeavyOp(node->op())) {
-      nodes.insert(node);
-      neighborhoods[node];
-      ordered_nodes.push_back(node);
+    if (IsHeavyOp(node->op()) && p->GetPredicate(node).has_value()) {
+      groups[GetChannelOpKey(node)].push_back(node);
     }
   }
 
@@ -280,80 +287,67 @@ absl::StatusOr<std::vector<absl::flat_hash_set<Node*>>> ComputeMergeClasses(
            scm.at(x) == scm.at(y);
   };
 
-  for (Node* x : nodes) {
-    if (!(p->GetPredicate(x).has_value())) {
+  // Each group is colored on its own, as no merge class spans two groups.
+  std::vector<absl::flat_hash_set<Node*>> coloring;
+  for (const auto& [key, members] : groups) {
+    if (members.size() < 2) {
       continue;
     }
-    Node* px = p->GetPredicate(x).value();
-    for (Node* y : nodes) {
-      if (!(p->GetPredicate(y).has_value())) {
-        continue;
-      }
-      Node* py = p->GetPredicate(y).value();
-      if (x->op() != y->op()) {
-        continue;
-      }
-      if ((x->op() == Op::kSend) &&
-          (!is_mergable(x, y) ||
-           (x->As<Send>()->channel_name() != y->As<Send>()->channel_name()))) {
-        continue;
-      }
-      if ((x->op() == Op::kReceive) &&
-          (!is_mergable(x, y) || (x->As<Receive>()->channel_name() !=
-                                  y->As<Receive>()->channel_name()))) {
-        continue;
-      }
-      if (p->QueryMutuallyExclusive(px, py) == std::make_optional(true)) {
-        neighborhoods[x].insert(y);
-        neighborhoods[y].insert(x);
-      }
+    absl::flat_hash_map<Node*, int64_t> member_index;
+    for (int64_t i = 0; i < members.size(); ++i) {
+      member_index[members[i]] = i;
     }
-  }
-
-  // The complement of the `neighborhoods` graph
-  absl::flat_hash_map<Node*, absl::flat_hash_set<Node*>> inverted_neighborhoods;
 
-  for (Node* node : nodes) {
-    inverted_neighborhoods[node] = nodes;
-    for (Node* neighbor : neighborhoods.at(node)) {
-      inverted_neighborhoods[node].erase(neighbor);
+    // Find the pairs of operations which may share a merge class by following
+    // the proven exclusions of their predicates, rather than by visiting every
+    // pair of operations in the group.
+    std::vector<absl::flat_hash_set<int64_t>> exclusive(members.size());
+    for (int64_t i = 0; i < members.size(); ++i) {
+      Node* x = members[i];
+      for (const auto& [py, is_exclusive] :
+           p->MutualExclusionNeighbors(p->GetPredicate(x).value())) {
+        if (!is_exclusive) {
+          continue;
+        }
+        for (Node* y : p->GetNodesPredicatedBy(py)) {
+          auto it = member_index.find(y);
+          if (it != member_index.end() && is_mergable(x, y)) {
+            exclusive[i].insert(it->second);
+          }
+        }
+      }
     }
-  }
-
-  absl::flat_hash_map<Node*, int64_t> node_to_index;
-  for (int64_t i = 0; i < ordered_nodes.size(); ++i) {
-    node_to_index[ordered_nodes[i]] = i;
-  }
-
-  std::vector<int64_t> iota(ordered_nodes.size());
-  std::iota(iota.begin(), iota.end(), 0);
-  std::vector<absl::flat_hash_set<int64_t>> coloring_indices =
-      RecursiveLargestFirstColoring<int64_t>(
-          absl::flat_hash_set<int64_t>(iota.begin(), iota.end()),
-          [&](int64_t node_index) -> absl::flat_hash_set<int64_t> {
-            absl::flat_hash_set<Node*> inv_neighbors =
-                inverted_neighborhoods.at(ordered_nodes.at(node_index));
-            absl::flat_hash_set<int64_t> result;
-            for (Node* inv_neighbor : inv_neighbors) {
-              result.insert(node_to_index.at(inv_neighbor));
-            }
-            return result;
-          });
 
-  std::vector<absl::flat_hash_set<Node*>> coloring;
-  for (const absl::flat_hash_set<int64_t>& color_class : coloring_indices) {
-    absl::flat_hash_set<Node*> color_node_class;
-    for (int64_t index : color_class) {
-      color_node_class.insert(ordered_nodes[index]);
+    // Operations exclusive with no other operation stay in a class of their
+    // own; the rest are colored by the complement of the exclusion graph.
+    absl::flat_hash_set<int64_t> candidates;
+    for (int64_t i = 0; i < members.size(); ++i) {
+      if (!exclusive[i].empty()) {
+        candidates.insert(i);
+      }
     }
-    coloring.push_back(color_node_class);
-  }
-
-  for (const absl::flat_hash_set<Node*>& color_class : coloring) {
-    CHECK(!color_class.empty());
-    Op op = (*(color_class.cbegin()))->op();
-    for (Node* node : color_class) {
-      CHECK_EQ(node->op(), op);
+    if (candidates.empty()) {
+      continue;
+    }
+    absl::flat_hash_map<int64_t, absl::flat_hash_set<int64_t>> conflicts;
+    for (int64_t i : candidates) {
+      absl::flat_hash_set<int64_t>& conflicts_of_i = conflicts[i];
+      for (int64_t j : candidates) {
+        if (j != i && !exclusive[i].contains(j)) {
+          conflicts_of_i.insert(j);
+        }
+      }
+    }
+    for (const absl::flat_hash_set<int64_t>& color_class :
+         RecursiveLargestFirstColoring<int64_t>(
+             candidates,
+             [&](const int64_t& i) -> absl::flat_hash_set<int64_t> {
+               return conflicts.at(i);
+             })) {
+      absl::flat_hash_set<Node*>& color_node_class = coloring.emplace_back();
+      for (int64_t index : color_class) {
+        color_node_class.insert(members[index]);
+      }
     }
   }
 
@@ -962,61 +956,79 @@ absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f,
     }
   }
 
-  absl::flat_hash_map<Node*, absl::flat_hash_set<Op>> ops_for_pred;
+  // Group the predicates by the channel operations they control. Only
+  // predicates sharing a group are ever compared, and predicates sharing no
+  // group with another predicate are irrelevant.
+  absl::btree_map<ChannelOpKey, std::vector<int64_t>> groups;
   for (const auto& [node, index] : predicate_nodes) {
-    bool includes_heavy_op = false;
     for (Node* predicated_by : p->GetNodesPredicatedBy(node)) {
-      ops_for_pred[node].insert(predicated_by->op());
-      if (IsHeavyOp(predicated_by->op())) {
-        includes_heavy_op = true;
+      if (!IsHeavyOp(predicated_by->op())) {
+        continue;
+      }
+      std::vector<int64_t>& members = groups[GetChannelOpKey(predicated_by)];
+      if (members.empty() || members.back() != index) {
+        members.push_back(index);
       }
-    }
-    if (!includes_heavy_op) {
-      // Irrelevant; doesn't affect any heavy operation.
-      ops_for_pred.erase(node);
     }
   }
-
-  // Remove any predicate nodes that don't participate in any potential mutual
-  // exclusion computations.
+  absl::erase_if(groups, [](const auto& group) {
+    const auto& [key, members] = group;
+    return members.size() < 2;
+  });
+  absl::flat_hash_set<int64_t> relevant;
+  for (const auto& [key, members] : groups) {
+    relevant.insert(members.begin(), members.end());
+  }
   std::erase_if(predicate_nodes,
                 [&](const std::pair<Node*, int64_t>& predicate_node) {
-                  const auto& [node, index] = predicate_node;
-                  return !ops_for_pred.contains(node);
+                  return !relevant.contains(predicate_node.second);
                 });
-  std::erase_if(
-      predicate_nodes, [&](const std::pair<Node*, int64_t>& predicate_node) {
-        const auto& [node, index] = predicate_node;
-        const absl::flat_hash_set<Op>& ops = ops_for_pred.at(node);
-        return absl::c_none_of(
-            predicate_nodes, [&](const std::pair<Node*, int64_t>& other) {
-              const auto& [other_node, other_index] = other;
-              if (other_node == node) {
-                // Skip if this is the same instance - but otherwise, if the
-                // nodes match, the ops definitely intersect!
-                return other_index != index;
-              }
-              return HasIntersection(ops, ops_for_pred.at(other_node));
-            });
-      });
 
   if (predicate_nodes.empty()) {
     return absl::OkStatus();
   }
+  absl::flat_hash_map<int64_t, Node*> predicate_by_index;
+  for (const auto& [node, index] : predicate_nodes) {
+    predicate_by_index[index] = node;
+  }
 
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<solvers::z3::IrTranslator> translator,
-                       solvers::z3::IrTranslator::CreateAndTranslate(f, true));
-
-  Z3_context ctx = translator->ctx();
-
-  solvers::z3::ScopedErrorHandler seh(ctx);
+  // Ternary and BDD analysis settle most pairs of predicates (e.g., tests of
+  // the same value against different constants) far more cheaply than Z3, so
+  // the function is only translated for Z3 once they fail.
+  std::vector<std::unique_ptr<QueryEngine>> query_engines;
+  query_engines.push_back(std::make_unique<TernaryQueryEngine>());
+  query_engines.push_back(std::make_unique<BddQueryEngine>(
+      BddFunction::kDefaultPathLimit, IsCheapForBdds));
+  UnionQueryEngine query_engine(std::move(query_engines));
+  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+
+  std::unique_ptr<solvers::z3::IrTranslator> translator;
+  std::optional<solvers::z3::ScopedErrorHandler> seh;
+  auto get_translator = [&]() -> absl::StatusOr<solvers::z3::IrTranslator*> {
+    if (translator == nullptr) {
+      XLS_ASSIGN_OR_RETURN(
+          translator, solvers::z3::IrTranslator::CreateAndTranslate(f, true));
+      seh.emplace(translator->ctx());
+    }
+    return translator.get();
+  };
 
-  // Determine for each predicate whether it is always false using Z3.
+  // Determine for each predicate whether it is always false, and remember
+  // those which can be true.
   // Dead nodes are mutually exclusive with all other nodes, so this can reduce
   // the runtime by doing only a linear amount of Z3 calls to remove
   // quadratically many Z3 calls.
+  absl::flat_hash_set<Node*> always_false;
+  absl::flat_hash_set<Node*> satisfiable;
   for (const auto& [node, index] : predicate_nodes) {
-    Z3_ast translated = translator->GetTranslation(node);
+    if (query_engine.IsAllZeros(node)) {
+      always_false.insert(node);
+      continue;
+    }
+    if (query_engine.IsAllOnes(node)) {
+      satisfiable.insert(node);
+      continue;
+    }
     // Check whether it's possible for `node` to need to be proven mutually
     // exclusive with some other node in order for channel operations to be
     // legal; if so, we remove the rlimit on the prover.
@@ -1028,85 +1040,128 @@ absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f,
                 << node->GetName()
                 << " as mutual exclusion is required for compilation.";
     }
-    translator->SetRlimit(z3_rlimit);
-    if (RunSolver(ctx, solvers::z3::BitVectorToBoolean(ctx, translated)) ==
-        Z3_L_FALSE) {
-      VLOG(3) << "Proved that " << node << " is always false";
-      // A constant false node is mutually exclusive with all other nodes.
-      for (const auto& [other, other_index] : predicate_nodes) {
-        if (index != other_index) {
-          XLS_RETURN_IF_ERROR(p->MarkMutuallyExclusive(node, other));
-        }
+    XLS_ASSIGN_OR_RETURN(solvers::z3::IrTranslator * z3, get_translator());
+    z3->SetRlimit(z3_rlimit);
+    Z3_lbool result =
+        RunSolver(z3->ctx(), solvers::z3::BitVectorToBoolean(
+                                 z3->ctx(), z3->GetTranslation(node)));
+    if (result == Z3_L_FALSE) {
+      always_false.insert(node);
+    } else if (result == Z3_L_TRUE) {
+      satisfiable.insert(node);
+    }
+  }
+  for (const auto& [node, index] : predicate_nodes) {
+    if (!always_false.contains(node)) {
+      continue;
+    }
+    VLOG(3) << "Proved that " << node << " is always false";
+    // A constant false node is mutually exclusive with all other nodes.
+    for (const auto& [other, other_index] : predicate_nodes) {
+      if (index != other_index) {
+        XLS_RETURN_IF_ERROR(p->MarkMutuallyExclusive(node, other));
       }
     }
   }
 
+  absl::flat_hash_map<Node*, absl::flat_hash_set<Channel*>> channels;
+  for (const auto& [node, index] : predicate_nodes) {
+    XLS_ASSIGN_OR_RETURN(
+        channels[node],
+        GetControlledProvenMutuallyExclusiveChannels(node, p, f));
+  }
+
   int64_t known_false = 0;
   int64_t known_true = 0;
   int64_t unknown = 0;
+  int64_t solver_calls = 0;
+
+  // A pair of predicates may share several groups; this prevents checking it
+  // again, including when Z3 could not decide it.
+  absl::flat_hash_set<std::pair<int64_t, int64_t>> checked;
+  for (const auto& [key, members] : groups) {
+    for (int64_t i = 0; i < members.size(); ++i) {
+      for (int64_t j = i + 1; j < members.size(); ++j) {
+        int64_t index_a = members[i];
+        int64_t index_b = members[j];
+        if (!checked.insert({index_a, index_b}).second) {
+          continue;
+        }
+        Node* node_a = predicate_by_index.at(index_a);
+        Node* node_b = predicate_by_index.at(index_b);
 
-  for (const auto& [node_a, index_a] : predicate_nodes) {
-    XLS_ASSIGN_OR_RETURN(
-        absl::flat_hash_set<Channel*> channels_a,
-        GetControlledProvenMutuallyExclusiveChannels(node_a, p, f));
-    for (const auto& [node_b, index_b] : predicate_nodes) {
-      // This prevents checking `a NAND b` and then later checking `b NAND a`.
-      if (index_a >= index_b) {
-        continue;
-      }
-
-      // Skip this pair if we already know whether they are mutually exclusive.
-      if (p->QueryMutuallyExclusive(node_a, node_b).has_value()) {
-        continue;
-      }
-
-      if (!ops_for_pred.contains(node_a) || !ops_for_pred.contains(node_b) ||
-          !HasIntersection(ops_for_pred.at(node_a), ops_for_pred.at(node_b))) {
-        continue;
-      }
-
-      Z3_ast z3_a = translator->GetTranslation(node_a);
-      Z3_ast z3_b = translator->GetTranslation(node_b);
+        // Skip this pair if we already know whether they are mutually
+        // exclusive.
+        if (p->QueryMutuallyExclusive(node_a, node_b).has_value()) {
+          continue;
+        }
 
-      // We try to find out if `a ∧ b` is satisfiable, which is true iff
-      // `a NAND b` is not valid.
-      Z3_ast a_and_b =
-          solvers::z3::BitVectorToBoolean(ctx, Z3_mk_bvand(ctx, z3_a, z3_b));
+        if (query_engine.AtMostOneNodeTrue({node_a, node_b})) {
+          known_true += 1;
+          XLS_RETURN_IF_ERROR(p->MarkMutuallyExclusive(node_a, node_b));
+          continue;
+        }
+        // If either predicate can be true and implies the other, both can be
+        // true at once.
+        TreeBitLocation bit_a(node_a, 0);
+        TreeBitLocation bit_b(node_b, 0);
+        if ((satisfiable.contains(node_a) &&
+             query_engine.Implies(bit_a, bit_b)) ||
+            (satisfiable.contains(node_b) &&
+             query_engine.Implies(bit_b, bit_a))) {
+          known_false += 1;
+          XLS_RETURN_IF_ERROR(p->MarkNotMutuallyExclusive(node_a, node_b));
+          continue;
+        }
 
-      // Check whether `a` and `b` must be proven mutually exclusive in order
-      // for channel operations to be legal; if so, we remove the rlimit on the
-      // prover.
-      XLS_ASSIGN_OR_RETURN(
-          absl::flat_hash_set<Channel*> channels_b,
-          GetControlledProvenMutuallyExclusiveChannels(node_b, p, f));
-      bool required_for_compilation = HasIntersection(channels_a, channels_b);
-      translator->SetRlimit(required_for_compilation ? 0 : z3_rlimit);
-      if (required_for_compilation) {
-        LOG(INFO) << "Removing Z3's rlimit for mutual exclusion between "
-                  << node_a->GetName() << " and " << node_b->GetName()
-                  << " as mutual exclusion is required for compilation.";
-      }
-      Z3_lbool satisfiable = RunSolver(ctx, a_and_b);
-
-      if (satisfiable == Z3_L_FALSE) {
-        known_true += 1;
-        XLS_RETURN_IF_ERROR(p->MarkMutuallyExclusive(node_a, node_b));
-      } else if (satisfiable == Z3_L_TRUE) {
-        known_false += 1;
-        XLS_RETURN_IF_ERROR(p->MarkNotMutuallyExclusive(node_a, node_b));
-      } else {
-        unknown += 1;
-        VLOG(3) << "Z3 ran out of time checking mutual exclusion of "
-                << node_a->GetName() << " and " << node_b->GetName();
+        XLS_ASSIGN_OR_RETURN(solvers::z3::IrTranslator * z3,
+                             get_translator());
+        Z3_context ctx = z3->ctx();
+        Z3_ast z3_a = z3->GetTranslation(node_a);
+        Z3_ast z3_b = z3->GetTranslation(node_b);
+
+        // We try to find out if `a ∧ b` is satisfiable, which is true iff
+        // `a NAND b` is not valid.
+        Z3_ast a_and_b =
+            solvers::z3::BitVectorToBoolean(ctx, Z3_mk_bvand(ctx, z3_a, z3_b));
+
+        // Check whether `a` and `b` must be proven mutually exclusive in order
+        // for channel operations to be legal; if so, we remove the rlimit on
+        // the prover.
+        bool required_for_compilation =
+            HasIntersection(channels.at(node_a), channels.at(node_b));
+        z3->SetRlimit(required_for_compilation ? 0 : z3_rlimit);
+        if (required_for_compilation) {
+          LOG(INFO) << "Removing Z3's rlimit for mutual exclusion between "
+                    << node_a->GetName() << " and " << node_b->GetName()
+                    << " as mutual exclusion is required for compilation.";
+        }
+        solver_calls += 1;
+        Z3_lbool result = RunSolver(ctx, a_and_b);
+
+        if (result == Z3_L_FALSE) {
+          known_true += 1;
+          XLS_RETURN_IF_ERROR(p->MarkMutuallyExclusive(node_a, node_b));
+        } else if (result == Z3_L_TRUE) {
+          known_false += 1;
+          XLS_RETURN_IF_ERROR(p->MarkNotMutuallyExclusive(node_a, node_b));
+        } else {
+          unknown += 1;
+          VLOG(3) << "Z3 ran out of time checking mutual exclusion of "
+                  << node_a->GetName() << " and " << node_b->GetName();
+        }
       }
     }
   }
 
-  VLOG(3) << "known_false = " << known_false;
-  VLOG(3) << "known_true  = " << known_true;
-  VLOG(3) << "unknown     = " << unknown;
+  VLOG(3) << "known_false  = " << known_false;
+  VLOG(3) << "known_true   = " << known_true;
+  VLOG(3) << "unknown      = " << unknown;
+  VLOG(3) << "solver_calls = " << solver_calls;
 
-  XLS_RETURN_IF_ERROR(seh.status());
+  if (seh.has_value()) {
+    XLS_RETURN_IF_ERROR(seh->status());
+  }
 
   return absl::OkStatus();
 }
@@ -103,7 +103,9 @@ absl::StatusOr<Node*> AddPredicate(Predicates* p, Node* node, Node* pred);
 absl::Status AddSelectPredicates(Predicates* p, FunctionBase* f);
 
 // Use an SMT solver to populate the given `Predicates*` with information about
-// whether nodes are used in a mutually exclusive way.
+// whether nodes are used in a mutually exclusive way. Only predicates of sends
+// (or receives) on the same channel are compared, and ternary and BDD analysis
+// is tried on each pair before the solver.
 absl::Status ComputeMutualExclusion(Predicates* p, FunctionBase* f,
                                     int64_t z3_rlimit);
 
@@ -18,6 +18,7 @@
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -101,18 +102,23 @@ absl::StatusOr<bool> RunMutualExclusionPass(FunctionBase* f,
                                 pass_options);
 }
 
+// The predicates of the sends, `st + 1 == 0` and `st == 0`, are only exclusive
+// through arithmetic, which the ternary and BDD analyses do not model, so
+// proving them exclusive takes the solver.
 absl::StatusOr<Proc*> CreateTwoParallelSendsProc(Package* p,
                                                  std::string_view name,
                                                  Channel* channel) {
   ProcBuilder pb(name, p);
   BValue tok = pb.StateElement("__token", Value::Token());
-  BValue st = pb.StateElement("__state", Value(UBits(0, 1)));
-  BValue not_st = pb.Not(st);
+  BValue st = pb.StateElement("__state", Value(UBits(0, 8)));
+  BValue next_st = pb.Add(st, pb.Literal(UBits(1, 8)));
+  BValue pred0 = pb.Eq(next_st, pb.Literal(UBits(0, 8)));
+  BValue pred1 = pb.Eq(st, pb.Literal(UBits(0, 8)));
   BValue lit50 = pb.Literal(UBits(50, 32));
   BValue lit60 = pb.Literal(UBits(60, 32));
-  BValue send0 = pb.SendIf(channel, tok, st, lit50);
-  BValue send1 = pb.SendIf(channel, tok, not_st, lit60);
-  return pb.Build({pb.AfterAll({send0, send1}), not_st});
+  BValue send0 = pb.SendIf(channel, tok, pred0, lit50);
+  BValue send1 = pb.SendIf(channel, tok, pred1, lit60);
+  return pb.Build({pb.AfterAll({send0, send1}), next_st});
 }
 
 absl::StatusOr<Node*> FindOp(FunctionBase* f, Op op) {
@@ -227,6 +233,37 @@ TEST_F(MutualExclusionPassTest, ThreeParallelSends) {
                        *proc->GetNode("literal.4")}));
 }
 
+TEST_F(MutualExclusionPassTest, ManyParallelSendsWithoutSolver) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * test_channel,
+      p->CreateStreamingChannel(
+          "test_channel", ChannelOps::kSendOnly, p->GetBitsType(32),
+          /*initial_values=*/{}, /*fifo_config=*/std::nullopt,
+          /*flow_control=*/FlowControl::kReadyValid,
+          /*strictness=*/ChannelStrictness::kArbitraryStaticOrder));
+  constexpr int64_t kSendCount = 64;
+  ProcBuilder pb(TestName(), p.get());
+  BValue tok = pb.StateElement("__token", Value::Token());
+  BValue st = pb.StateElement("__state", Value(UBits(0, 6)));
+  std::vector<BValue> sends;
+  for (int64_t i = 0; i < kSendCount; ++i) {
+    sends.push_back(pb.SendIf(test_channel, tok,
+                              pb.Eq(st, pb.Literal(UBits(i, 6))),
+                              pb.Literal(UBits(i, 32))));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc,
+      pb.Build({pb.AfterAll(sends), pb.Add(st, pb.Literal(UBits(1, 6)))}));
+  // Tests of the same value against different constants are proven exclusive
+  // without the solver, which could not prove anything with this limit.
+  EXPECT_THAT(RunMutualExclusionPass(
+                  proc, SchedulingOptions().mutual_exclusion_z3_rlimit(1)),
+              IsOkAndHolds(true));
+  EXPECT_EQ(NumberOfOp(proc, Op::kSend), 1);
+  XLS_EXPECT_OK(VerifyProc(proc, true));
+}
+
 TEST_F(MutualExclusionPassTest, TwoSequentialSends) {
   XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, ParsePackage(R"(
      package test_module
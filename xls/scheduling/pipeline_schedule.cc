@@ -588,6 +588,62 @@ int64_t PipelineSchedule::CountFinalInteriorPipelineRegisters() const {
   return reg_count;
 }
 
+int64_t PipelineSchedule::CountFinalPipelineFlops() const {
+  // Two stages are mutually exclusive if both lie between the read of some
+  // state element and its earliest write, as computed by codegen.
+  std::vector<std::vector<bool>> mutex(length(),
+                                       std::vector<bool>(length(), false));
+  if (function_base_->IsProc()) {
+    Proc* proc = function_base_->AsProcOrDie();
+    for (int64_t index = 0; index < proc->GetStateElementCount(); ++index) {
+      StateRead* state_read = proc->GetStateRead(index);
+      std::optional<int64_t> write_stage;
+      for (Next* next : proc->next_values(state_read)) {
+        write_stage = std::min(write_stage.value_or(cycle(next)), cycle(next));
+      }
+      Node* next_state = proc->GetNextStateElement(index);
+      if (!write_stage.has_value() && next_state != state_read) {
+        write_stage = cycle(next_state);
+      }
+      if (!write_stage.has_value()) {
+        continue;
+      }
+      for (int64_t i = cycle(state_read); i <= *write_stage; ++i) {
+        for (int64_t j = cycle(state_read); j <= *write_stage; ++j) {
+          mutex[i][j] = i != j;
+        }
+      }
+    }
+  }
+
+  int64_t flop_count = 0;
+  for (Node* node : function_base_->nodes()) {
+    int64_t bit_count = node->GetType()->GetFlatBitCount();
+    if (bit_count == 0) {
+      continue;
+    }
+    // The registers carrying the node through successive stages form a chain.
+    // As in RegisterChains::SplitBetweenMutexRegions, the chain is split into
+    // groups whose registers are pairwise mutually exclusive; each group
+    // becomes a single register. The register written in stage `s` is read in
+    // stage `s + 1`.
+    int64_t group_count = 0;
+    int64_t group_start = 0;
+    for (int64_t stage = cycle(node); IsLiveOutOfCycle(node, stage); ++stage) {
+      bool joins_group = group_count > 0 && mutex[stage][stage + 1];
+      for (int64_t s = group_start; joins_group && s < stage; ++s) {
+        joins_group = mutex[s][stage] && mutex[s + 1][stage + 1];
+      }
+      if (!joins_group) {
+        ++group_count;
+        group_start = stage;
+      }
+    }
+    flop_count += bit_count * group_count;
+  }
+  return flop_count;
+}
+
 /* static */ absl::StatusOr<PackagePipelineSchedules>
 PackagePipelineSchedulesFromProto(Package* p,
                                   const PackagePipelineSchedulesProto& proto) {
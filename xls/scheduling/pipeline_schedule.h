@@ -116,6 +116,12 @@ class PipelineSchedule {
   // Returns the number of internal registers in this schedule.
   int64_t CountFinalInteriorPipelineRegisters() const;
 
+  // Returns the number of internal register bits left after codegen merges
+  // the registers carrying a value through mutually exclusive stages of a proc
+  // (see RegisterCombiningPass). For functions this is the same as
+  // CountFinalInteriorPipelineRegisters.
+  int64_t CountFinalPipelineFlops() const;
+
   // Returns the underlying cycle map.
   const ScheduleCycleMap& GetCycleMap() const { return cycle_map_; }
 
@@ -16,12 +16,14 @@
 
 #include <cstdint>
 #include <limits>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
@@ -460,6 +462,58 @@ TEST_F(PipelineScheduleTest, JustPipelineLengthGiven) {
   EXPECT_THAT(scheduled_ops(5), UnorderedElementsAre(Op::kNeg));
 }
 
+TEST_F(PipelineScheduleTest, ParallelClockPeriodSearch) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue acc = x;
+  for (int64_t i = 0; i < 20; ++i) {
+    acc = i % 3 == 0 ? fb.Add(acc, y) : fb.Negate(acc);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.Build());
+
+  for (int64_t parallelism : {1, 3, 8}) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule schedule,
+        RunPipelineSchedule(
+            func, TestDelayEstimator(),
+            SchedulingOptions().pipeline_stages(3).clock_search_parallelism(
+                parallelism)));
+    EXPECT_EQ(schedule.length(), 3);
+    ASSERT_TRUE(schedule.min_clock_period_ps().has_value());
+    EXPECT_EQ(*schedule.min_clock_period_ps(), 7) << parallelism;
+  }
+}
+
+TEST_F(PipelineScheduleTest, PartitionedScheduling) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  BValue a = x;
+  BValue b = y;
+  for (int64_t i = 0; i < 30; ++i) {
+    a = i % 4 == 0 ? fb.Add(a, b) : fb.Negate(a);
+    b = i % 5 == 0 ? fb.Subtract(b, x) : fb.Not(b);
+  }
+  fb.Add(a, b);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.Build());
+
+  for (SchedulingStrategy strategy :
+       {SchedulingStrategy::SDC, SchedulingStrategy::MIN_CUT}) {
+    // RunPipelineSchedule verifies the schedule's dependencies and timing.
+    XLS_ASSERT_OK_AND_ASSIGN(
+        PipelineSchedule schedule,
+        RunPipelineSchedule(func, TestDelayEstimator(),
+                            SchedulingOptions(strategy)
+                                .pipeline_stages(10)
+                                .clock_period_ps(5)
+                                .max_partition_size(8)));
+    EXPECT_EQ(schedule.length(), 10);
+  }
+}
+
 TEST_F(PipelineScheduleTest, LongPipelineLength) {
   // Generate an absurdly long pipeline schedule. Most stages are empty, but it
   // should not crash.
@@ -584,6 +638,80 @@ TEST_F(PipelineScheduleTest, PeriodRelaxation) {
   }
 }
 
+TEST_F(PipelineScheduleTest, FlopRelaxation) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  Type* u32 = p->GetBitsType(32);
+  auto x = fb.Param("x", u32);
+
+  // Fanout
+  auto x1 = fb.Negate(x);
+  auto x11 = fb.Negate(x1);
+  auto x21 = fb.Negate(x1);
+  auto x111 = fb.Negate(x11);
+  auto x211 = fb.Negate(x11);
+  auto x121 = fb.Negate(x21);
+  auto x221 = fb.Negate(x21);
+
+  // Fanin
+  auto y11 = fb.Or(x111, x211);
+  auto y21 = fb.Or(x121, x221);
+  auto y1 = fb.Or(y11, y21);
+  fb.Negate(y1);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      RunPipelineSchedule(func, TestDelayEstimator(),
+                          SchedulingOptions().pipeline_stages(2)));
+  int64_t flops_default = schedule.CountFinalPipelineFlops();
+  EXPECT_EQ(flops_default, schedule.CountFinalInteriorPipelineRegisters());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule relaxed_schedule,
+      RunPipelineSchedule(
+          func, TestDelayEstimator(),
+          SchedulingOptions().pipeline_stages(2).flop_relaxation_percent(100)));
+  EXPECT_EQ(relaxed_schedule.length(), 2);
+  EXPECT_LT(relaxed_schedule.CountFinalPipelineFlops(), flops_default);
+
+  // The clock period is never relaxed past the target.
+  SchedulingOptions options =
+      SchedulingOptions().pipeline_stages(2).clock_period_ps(
+          *schedule.min_clock_period_ps());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule target_schedule,
+      RunPipelineSchedule(func, TestDelayEstimator(), options));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule capped_schedule,
+      RunPipelineSchedule(func, TestDelayEstimator(),
+                          options.flop_relaxation_percent(100)));
+  EXPECT_EQ(capped_schedule.GetCycleMap(), target_schedule.GetCycleMap());
+}
+
+TEST_F(PipelineScheduleTest, FlopsMergedAcrossMutuallyExclusiveStages) {
+  Package p(TestName());
+  TokenlessProcBuilder pb(TestName(), "tkn", &p);
+  BValue st = pb.StateElement("st", Value(UBits(0, 16)));
+  BValue x = pb.Not(st);
+  BValue y = pb.Negate(x);
+  BValue z = pb.Add(y, x);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({z}));
+
+  // The state element is read in stage 0 and written in stage 3, so stages 0
+  // through 3 are mutually exclusive and each value needs a single register.
+  ScheduleCycleMap cycle_map;
+  for (Node* node : proc->nodes()) {
+    cycle_map[node] = 0;
+  }
+  cycle_map[y.node()] = 1;
+  cycle_map[z.node()] = 3;
+  PipelineSchedule schedule(proc, cycle_map, /*length=*/4);
+  EXPECT_EQ(schedule.CountFinalInteriorPipelineRegisters(), 3 * 16 + 2 * 16);
+  EXPECT_EQ(schedule.CountFinalPipelineFlops(), 16 + 16);
+}
+
 TEST_F(PipelineScheduleTest, SerializeAndDeserialize) {
   auto p = CreatePackage();
   FunctionBuilder fb(TestName(), p.get());
@@ -636,6 +764,98 @@ TEST_F(PipelineScheduleTest, NodeDelayInScheduleProto) {
   }
 }
 
+// Returns a schedule hint for a chain of `length` inverters scheduled in three
+// stages, along with the cycle it gives each node by name.
+std::pair<PackagePipelineSchedulesProto,
+          absl::flat_hash_map<std::string, int64_t>>
+HintForInverterChain(Package* p, int64_t length) {
+  FunctionBuilder fb("chain", p);
+  BValue x = fb.Param("x", p->GetBitsType(1));
+  for (int64_t i = 0; i < length; ++i) {
+    x = fb.Not(x);
+  }
+  Function* f = fb.Build().value();
+  PipelineSchedule schedule =
+      RunPipelineSchedule(f, TestDelayEstimator(),
+                          SchedulingOptions().pipeline_stages(3))
+          .value();
+  absl::flat_hash_map<std::string, int64_t> cycles;
+  for (Node* node : f->nodes()) {
+    cycles[node->GetName()] = schedule.cycle(node);
+  }
+  PackagePipelineSchedulesProto hint;
+  hint.mutable_schedules()->emplace(f->name(),
+                                    schedule.ToProto(TestDelayEstimator()));
+  return {std::move(hint), std::move(cycles)};
+}
+
+TEST_F(PipelineScheduleTest, ScheduleHintIsReused) {
+  auto [hint, hinted_cycles] =
+      HintForInverterChain(CreatePackage().get(), /*length=*/6);
+
+  // The same function, which fits in a single stage at this clock period.
+  auto p = CreatePackage();
+  FunctionBuilder fb("chain", p.get());
+  BValue x = fb.Param("x", p->GetBitsType(1));
+  for (int64_t i = 0; i < 6; ++i) {
+    x = fb.Not(x);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      RunPipelineSchedule(
+          f, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(10).schedule_hint(hint)));
+  EXPECT_EQ(schedule.length(), 3);
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(schedule.cycle(node), hinted_cycles.at(node->GetName()));
+  }
+
+  // The hinted schedule does not meet a shorter clock period.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      schedule,
+      RunPipelineSchedule(
+          f, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(1).schedule_hint(hint)));
+  EXPECT_EQ(schedule.length(), 6);
+}
+
+TEST_F(PipelineScheduleTest, ScheduleHintIsPinned) {
+  auto [hint, hinted_cycles] =
+      HintForInverterChain(CreatePackage().get(), /*length=*/6);
+
+  // The same function with a node added at the end.
+  auto p = CreatePackage();
+  FunctionBuilder fb("chain", p.get());
+  BValue x = fb.Param("x", p->GetBitsType(1));
+  std::vector<Node*> unchanged = {x.node()};
+  for (int64_t i = 0; i < 6; ++i) {
+    x = fb.Not(x);
+    unchanged.push_back(x.node());
+  }
+  // The last inverter is used by the new node.
+  unchanged.pop_back();
+  fb.Negate(x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      RunPipelineSchedule(
+          f, TestDelayEstimator(),
+          SchedulingOptions().clock_period_ps(10).schedule_hint(hint)));
+  EXPECT_EQ(schedule.length(), 1);
+
+  XLS_ASSERT_OK_AND_ASSIGN(schedule,
+                           RunPipelineSchedule(f, TestDelayEstimator(),
+                                               SchedulingOptions()
+                                                   .clock_period_ps(10)
+                                                   .schedule_hint(hint)
+                                                   .pin_schedule_hint(true)));
+  for (Node* node : unchanged) {
+    EXPECT_EQ(schedule.cycle(node), hinted_cycles.at(node->GetName()));
+  }
+}
+
 TEST_F(PipelineScheduleTest, ProcSchedule) {
   Package p("p");
   Type* u16 = p.GetBitsType(16);
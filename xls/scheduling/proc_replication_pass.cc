@@ -0,0 +1,302 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/proc_replication_pass.h"
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/math_util.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/channel_ops.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/value.h"
+#include "xls/scheduling/scheduling_pass.h"
+
+namespace xls {
+
+namespace {
+
+// The channels the top proc communicates on.
+struct ReplicatedChannels {
+  Channel* input;
+  Channel* output;
+};
+
+absl::StatusOr<ReplicatedChannels> GetReplicatedChannels(Proc* proc) {
+  if (proc->is_new_style_proc()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Cannot replicate proc %s: proc-scoped channels are not supported",
+        proc->name()));
+  }
+  std::vector<ChannelNode*> receives;
+  std::vector<ChannelNode*> sends;
+  for (Node* node : proc->nodes()) {
+    if (node->Is<Receive>()) {
+      receives.push_back(node->As<ChannelNode>());
+    } else if (node->Is<Send>()) {
+      sends.push_back(node->As<ChannelNode>());
+    }
+  }
+  if (receives.size() != 1 || sends.size() != 1) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Cannot replicate proc %s: it must have exactly one receive and one "
+        "send, has %d receives and %d sends",
+        proc->name(), receives.size(), sends.size()));
+  }
+  Package* package = proc->package();
+  XLS_ASSIGN_OR_RETURN(Channel * input,
+                       package->GetChannel(receives[0]->channel_name()));
+  XLS_ASSIGN_OR_RETURN(Channel * output,
+                       package->GetChannel(sends[0]->channel_name()));
+  for (Channel* channel : {input, output}) {
+    if (channel->kind() != ChannelKind::kStreaming) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Cannot replicate proc %s: channel %s is not a streaming channel",
+          proc->name(), channel->name()));
+    }
+  }
+  return ReplicatedChannels{.input = input, .output = output};
+}
+
+// Returns an internal channel connecting the dispatching or collecting proc to
+// a copy of the top proc, of the same type as `channel`.
+absl::StatusOr<Channel*> CreateReplicaChannel(Package* package,
+                                              Channel* channel,
+                                              int64_t replica) {
+  std::string name =
+      absl::StrFormat("%s__replica%d", channel->name(), replica);
+  if (package->HasChannelWithName(name)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Cannot replicate proc: channel %s already exists", name));
+  }
+  return package->CreateStreamingChannel(
+      name, ChannelOps::kSendReceive, channel->type(),
+      /*initial_values=*/{},
+      FifoConfig(/*depth=*/1, /*bypass=*/false,
+                 /*register_push_outputs=*/false,
+                 /*register_pop_outputs=*/false));
+}
+
+absl::StatusOr<Node*> IndexEquals(Node* index, int64_t value) {
+  FunctionBase* f = index->function_base();
+  XLS_ASSIGN_OR_RETURN(
+      Node * literal,
+      f->MakeNode<Literal>(index->loc(),
+                           Value(UBits(value, index->BitCountOrDie()))));
+  return f->MakeNode<CompareOp>(index->loc(), index, literal, Op::kEq);
+}
+
+// Adds to `proc` a state element which counts up to `count - 1` and wraps
+// around to zero, one step per activation. Returns its state read.
+absl::StatusOr<Node*> AddRoundRobinIndex(Proc* proc, int64_t count) {
+  const int64_t width = CeilOfLog2(count);
+  SourceInfo loc;
+  XLS_ASSIGN_OR_RETURN(
+      StateRead * index,
+      proc->AppendStateElement("replica_index", Value(UBits(0, width))));
+  XLS_ASSIGN_OR_RETURN(Node * one,
+                       proc->MakeNode<Literal>(loc, Value(UBits(1, width))));
+  XLS_ASSIGN_OR_RETURN(Node * zero,
+                       proc->MakeNode<Literal>(loc, Value(UBits(0, width))));
+  XLS_ASSIGN_OR_RETURN(Node * incremented,
+                       proc->MakeNode<BinOp>(loc, index, one, Op::kAdd));
+  XLS_ASSIGN_OR_RETURN(Node * last, IndexEquals(index, count - 1));
+  XLS_ASSIGN_OR_RETURN(
+      Node * next_index,
+      proc->MakeNode<Select>(loc, last,
+                             std::vector<Node*>{incremented, zero},
+                             /*default_value=*/std::nullopt));
+  XLS_RETURN_IF_ERROR(proc->MakeNode<Next>(loc, index, next_index,
+                                           /*predicate=*/std::nullopt)
+                          .status());
+  return index;
+}
+
+// Removes every node and state element of `proc`.
+absl::Status ClearProc(Proc* proc) {
+  for (int64_t index = 0; index < proc->GetStateElementCount(); ++index) {
+    XLS_RETURN_IF_ERROR(
+        proc->SetNextStateElement(index, proc->GetStateRead(index)));
+  }
+  std::vector<Node*> nodes;
+  for (Node* node : proc->nodes()) {
+    if (!node->Is<StateRead>()) {
+      nodes.push_back(node);
+    }
+  }
+  XLS_RETURN_IF_ERROR(proc->RemoveNodes(nodes));
+  std::vector<int64_t> indices(proc->GetStateElementCount());
+  std::iota(indices.begin(), indices.end(), 0);
+  return proc->RemoveStateElements(indices);
+}
+
+// Replaces the contents of `proc` with a proc which receives from `input` and
+// sends each value to the next of `replica_inputs` in turn.
+absl::Status BuildDispatcher(Proc* proc, Channel* input,
+                             absl::Span<Channel* const> replica_inputs) {
+  XLS_RETURN_IF_ERROR(ClearProc(proc));
+  SourceInfo loc;
+  XLS_ASSIGN_OR_RETURN(Node * index,
+                       AddRoundRobinIndex(proc, replica_inputs.size()));
+  XLS_ASSIGN_OR_RETURN(Node * token,
+                       proc->MakeNode<AfterAll>(loc, std::vector<Node*>{}));
+  XLS_ASSIGN_OR_RETURN(
+      Node * receive,
+      proc->MakeNode<Receive>(loc, token, /*predicate=*/std::nullopt,
+                              input->name(), /*is_blocking=*/true));
+  XLS_ASSIGN_OR_RETURN(Node * received_token,
+                       proc->MakeNode<TupleIndex>(loc, receive, 0));
+  XLS_ASSIGN_OR_RETURN(Node * data,
+                       proc->MakeNode<TupleIndex>(loc, receive, 1));
+  for (int64_t replica = 0; replica < replica_inputs.size(); ++replica) {
+    XLS_ASSIGN_OR_RETURN(Node * selected, IndexEquals(index, replica));
+    XLS_RETURN_IF_ERROR(
+        proc->MakeNode<Send>(loc, received_token, data, selected,
+                             replica_inputs[replica]->name())
+            .status());
+  }
+  return absl::OkStatus();
+}
+
+// Adds a proc named `name` which receives from each of `replica_outputs` in
+// turn and sends the values on to `output`.
+absl::Status BuildCollector(Package* package, std::string_view name,
+                            Channel* output,
+                            absl::Span<Channel* const> replica_outputs) {
+  Proc* proc = package->AddProc(std::make_unique<Proc>(name, package));
+  SourceInfo loc;
+  XLS_ASSIGN_OR_RETURN(Node * index,
+                       AddRoundRobinIndex(proc, replica_outputs.size()));
+  XLS_ASSIGN_OR_RETURN(Node * token,
+                       proc->MakeNode<AfterAll>(loc, std::vector<Node*>{}));
+  std::vector<Node*> tokens;
+  std::vector<Node*> values;
+  for (int64_t replica = 0; replica < replica_outputs.size(); ++replica) {
+    XLS_ASSIGN_OR_RETURN(Node * selected, IndexEquals(index, replica));
+    XLS_ASSIGN_OR_RETURN(
+        Node * receive,
+        proc->MakeNode<Receive>(loc, token, selected,
+                                replica_outputs[replica]->name(),
+                                /*is_blocking=*/true));
+    XLS_ASSIGN_OR_RETURN(Node * received_token,
+                         proc->MakeNode<TupleIndex>(loc, receive, 0));
+    XLS_ASSIGN_OR_RETURN(Node * value,
+                         proc->MakeNode<TupleIndex>(loc, receive, 1));
+    tokens.push_back(received_token);
+    values.push_back(value);
+  }
+  // Only the selected receive produces a value; the others produce zero.
+  std::optional<Node*> default_value;
+  if (static_cast<int64_t>(values.size()) !=
+      int64_t{1} << index->BitCountOrDie()) {
+    default_value = values.front();
+  }
+  XLS_ASSIGN_OR_RETURN(
+      Node * value,
+      proc->MakeNode<Select>(loc, index, values, default_value));
+  XLS_ASSIGN_OR_RETURN(Node * all_received,
+                       proc->MakeNode<AfterAll>(loc, tokens));
+  return proc
+      ->MakeNode<Send>(loc, all_received, value, /*predicate=*/std::nullopt,
+                       output->name())
+      .status();
+}
+
+}  // namespace
+
+absl::StatusOr<bool> ProcReplicationPass::RunInternal(
+    SchedulingUnit* unit, const SchedulingPassOptions& options,
+    SchedulingPassResults* results) const {
+  std::optional<int64_t> factor =
+      options.scheduling_options.proc_replication_factor();
+  if (!factor.has_value() || *factor <= 1) {
+    return false;
+  }
+  Package* package = unit->GetPackage();
+  std::optional<FunctionBase*> top = package->GetTop();
+  if (!top.has_value() || !(*top)->IsProc()) {
+    return absl::InvalidArgumentError(
+        "Proc replication requires the top of the package to be a proc");
+  }
+  if (!unit->IsWholePackage()) {
+    return absl::InvalidArgumentError(
+        "Proc replication requires scheduling every proc in the package");
+  }
+  Proc* proc = (*top)->AsProcOrDie();
+  XLS_ASSIGN_OR_RETURN(ReplicatedChannels channels,
+                       GetReplicatedChannels(proc));
+  std::string collector_name = absl::StrCat(proc->name(), "__collect");
+  std::vector<std::string> replica_names;
+  for (int64_t replica = 0; replica < *factor; ++replica) {
+    replica_names.push_back(
+        absl::StrFormat("%s__replica%d", proc->name(), replica));
+  }
+  std::vector<std::string> new_names = replica_names;
+  new_names.push_back(collector_name);
+  for (const std::string& name : new_names) {
+    if (package->TryGetProc(name).has_value()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Cannot replicate proc %s: proc %s already exists", proc->name(),
+          name));
+    }
+  }
+
+  std::vector<Channel*> replica_inputs;
+  std::vector<Channel*> replica_outputs;
+  for (int64_t replica = 0; replica < *factor; ++replica) {
+    XLS_ASSIGN_OR_RETURN(
+        Channel * input,
+        CreateReplicaChannel(package, channels.input, replica));
+    XLS_ASSIGN_OR_RETURN(
+        Channel * output,
+        CreateReplicaChannel(package, channels.output, replica));
+    replica_inputs.push_back(input);
+    replica_outputs.push_back(output);
+    absl::flat_hash_map<std::string, std::string> channel_remapping = {
+        {channels.input->name(), input->name()},
+        {channels.output->name(), output->name()},
+    };
+    XLS_RETURN_IF_ERROR(
+        proc->Clone(replica_names[replica], package, channel_remapping)
+            .status());
+  }
+  XLS_RETURN_IF_ERROR(BuildCollector(package, collector_name, channels.output,
+                                     replica_outputs));
+  // The top proc keeps its identity, becoming the dispatcher, as callers hold
+  // on to it.
+  XLS_RETURN_IF_ERROR(BuildDispatcher(proc, channels.input, replica_inputs));
+  return true;
+}
+
+}  // namespace xls
@@ -0,0 +1,61 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SCHEDULING_PROC_REPLICATION_PASS_H_
+#define XLS_SCHEDULING_PROC_REPLICATION_PASS_H_
+
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "xls/scheduling/scheduling_pass.h"
+
+namespace xls {
+
+// Pass which replaces the top proc with N copies of itself handling
+// transactions in turn, where N is SchedulingOptions::proc_replication_factor.
+//
+// A proc whose state feeds back through a long path can be scheduled to start
+// an activation only every few cycles. If its transactions are independent, N
+// copies of it together accept a transaction every cycle at N times the area.
+//
+// The top proc must be an old-style proc with exactly one receive, from a
+// streaming input channel, and one send, to a streaming output channel. Each
+// value received starts a transaction, which may take any number of
+// activations, and must produce exactly one value sent. The top proc is
+// rewritten to receive from the input channel and dispatch each value to the
+// copies `<top>__replica<i>` in round-robin order, and a new proc
+// `<top>__collect` receives the results from the copies in the same order and
+// sends them on to the output channel, so results leave in the order the
+// transactions arrived.
+//
+// Each copy keeps its own state and sees only every Nth transaction, so this
+// preserves the behavior of the proc only if no transaction depends on state
+// left behind by an earlier one. The new procs are only scheduled if the whole
+// package is.
+class ProcReplicationPass : public SchedulingPass {
+ public:
+  static constexpr std::string_view kName = "proc_replication";
+
+  ProcReplicationPass() : SchedulingPass(kName, "Proc Replication") {}
+  ~ProcReplicationPass() override = default;
+
+ protected:
+  absl::StatusOr<bool> RunInternal(
+      SchedulingUnit* unit, const SchedulingPassOptions& options,
+      SchedulingPassResults* results) const override;
+};
+
+}  // namespace xls
+
+#endif  // XLS_SCHEDULING_PROC_REPLICATION_PASS_H_
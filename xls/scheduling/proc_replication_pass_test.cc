@@ -0,0 +1,167 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/proc_replication_pass.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/interpreter_proc_runtime.h"
+#include "xls/interpreter/serial_proc_runtime.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/channel_ops.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/value.h"
+#include "xls/ir/verifier.h"
+#include "xls/scheduling/scheduling_options.h"
+#include "xls/scheduling/scheduling_pass.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
+
+class ProcReplicationPassTest : public IrTestBase {
+ protected:
+  absl::StatusOr<bool> Run(SchedulingUnit unit, int64_t factor) {
+    SchedulingPassOptions options;
+    options.scheduling_options.proc_replication_factor(factor);
+    SchedulingPassResults results;
+    return ProcReplicationPass().Run(&unit, options, &results);
+  }
+
+  // Builds a proc which takes two activations per transaction: one receiving
+  // a value from `in` and one sending the value plus one to `out`.
+  absl::StatusOr<Proc*> BuildTwoActivationProc(Package* p) {
+    XLS_ASSIGN_OR_RETURN(
+        Channel * in,
+        p->CreateStreamingChannel("in", ChannelOps::kReceiveOnly,
+                                  p->GetBitsType(32)));
+    XLS_ASSIGN_OR_RETURN(
+        Channel * out,
+        p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                  p->GetBitsType(32)));
+    TokenlessProcBuilder pb("the_proc", "tkn", p);
+    BValue sending = pb.StateElement("sending", UBits(0, 1));
+    BValue held = pb.StateElement("held", UBits(0, 32));
+    BValue received = pb.ReceiveIf(in, pb.Not(sending));
+    pb.SendIf(out, sending, pb.Add(held, pb.Literal(UBits(1, 32))));
+    XLS_ASSIGN_OR_RETURN(
+        Proc * proc,
+        pb.Build({pb.Not(sending), pb.Select(sending, {received, held})}));
+    XLS_RETURN_IF_ERROR(p->SetTop(proc));
+    return proc;
+  }
+};
+
+TEST_F(ProcReplicationPassTest, NoReplicationByDefault) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK(BuildTwoActivationProc(p.get()).status());
+  SchedulingUnit unit = SchedulingUnit::CreateForWholePackage(p.get());
+  SchedulingPassResults results;
+  EXPECT_THAT(
+      ProcReplicationPass().Run(&unit, SchedulingPassOptions(), &results),
+      IsOkAndHolds(false));
+  EXPECT_THAT(Run(SchedulingUnit::CreateForWholePackage(p.get()), 1),
+              IsOkAndHolds(false));
+  EXPECT_EQ(p->procs().size(), 1);
+}
+
+TEST_F(ProcReplicationPassTest, ReplicatesTopProc) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, BuildTwoActivationProc(p.get()));
+  EXPECT_THAT(Run(SchedulingUnit::CreateForWholePackage(p.get()), 3),
+              IsOkAndHolds(true));
+  XLS_ASSERT_OK(VerifyPackage(p.get()));
+
+  std::vector<std::string> proc_names;
+  for (const std::unique_ptr<Proc>& f : p->procs()) {
+    proc_names.push_back(f->name());
+  }
+  EXPECT_THAT(proc_names,
+              UnorderedElementsAre("the_proc", "the_proc__replica0",
+                                   "the_proc__replica1", "the_proc__replica2",
+                                   "the_proc__collect"));
+  EXPECT_EQ(p->GetTop().value(), proc);
+  EXPECT_EQ(proc->GetStateElementCount(), 1);
+
+  // The values are processed by the replicas in turn, and come out in the
+  // order they went in.
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SerialProcRuntime> runtime,
+                           CreateInterpreterSerialProcRuntime(p.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Channel * in, p->GetChannel("in"));
+  XLS_ASSERT_OK_AND_ASSIGN(Channel * out, p->GetChannel("out"));
+  ChannelQueue& in_queue = runtime->queue_manager().GetQueue(in);
+  ChannelQueue& out_queue = runtime->queue_manager().GetQueue(out);
+  constexpr int64_t kCount = 10;
+  for (int64_t i = 0; i < kCount; ++i) {
+    XLS_ASSERT_OK(in_queue.Write(Value(UBits(100 * i, 32))));
+  }
+  absl::flat_hash_map<Channel*, int64_t> output_counts = {{out, kCount}};
+  XLS_ASSERT_OK(runtime->TickUntilOutput(output_counts).status());
+  for (int64_t i = 0; i < kCount; ++i) {
+    std::optional<Value> value = out_queue.Read();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, Value(UBits(100 * i + 1, 32)));
+  }
+}
+
+TEST_F(ProcReplicationPassTest, RequiresWholePackage) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, BuildTwoActivationProc(p.get()));
+  EXPECT_THAT(Run(SchedulingUnit::CreateForSingleFunction(proc), 2),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("every proc in the package")));
+}
+
+TEST_F(ProcReplicationPassTest, RequiresOneReceiveAndOneSend) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in0, p->CreateStreamingChannel("in0", ChannelOps::kReceiveOnly,
+                                               p->GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * in1, p->CreateStreamingChannel("in1", ChannelOps::kReceiveOnly,
+                                               p->GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * out, p->CreateStreamingChannel("out", ChannelOps::kSendOnly,
+                                               p->GetBitsType(32)));
+  TokenlessProcBuilder pb("the_proc", "tkn", p.get());
+  pb.Send(out, pb.Add(pb.Receive(in0), pb.Receive(in1)));
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({}));
+  XLS_ASSERT_OK(p->SetTop(proc));
+  EXPECT_THAT(Run(SchedulingUnit::CreateForWholePackage(p.get()), 2),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("has 2 receives and 1 sends")));
+}
+
+}  // namespace
+}  // namespace xls
@@ -20,6 +20,7 @@
 #include <optional>
 #include <random>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -27,6 +28,7 @@
 #include "absl/algorithm/container.h"
 #include "absl/base/log_severity.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/random/distributions.h"
@@ -35,10 +37,12 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/data_structures/binary_search.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/fdo/delay_manager.h"
@@ -54,8 +58,10 @@
 #include "xls/scheduling/min_cut_scheduler.h"
 #include "xls/scheduling/pipeline_schedule.h"
 #include "xls/scheduling/schedule_bounds.h"
+#include "xls/scheduling/schedule_hint.h"
 #include "xls/scheduling/scheduling_options.h"
 #include "xls/scheduling/sdc_scheduler.h"
+#include "ortools/util/solve_interrupter.h"
 
 namespace xls {
 
@@ -178,15 +184,120 @@ absl::StatusOr<int64_t> ComputeCriticalPath(
   return ComputeCriticalPath(TopoSort(f), delay_estimator);
 }
 
+using SDCSchedulerFactory =
+    absl::FunctionRef<absl::StatusOr<std::unique_ptr<SDCScheduler>>()>;
+
+// Returns whether the given clock period is feasible, solving with the given
+// scheduler. The solve may be cut short through `interrupter`.
+using ClockPeriodProbe = absl::FunctionRef<bool(
+    SDCScheduler& scheduler, int64_t clk_period_ps,
+    const operations_research::SolveInterrupter* interrupter)>;
+
+// Returns the minimum clock period in [`min_clk_period_ps`,
+// `max_clk_period_ps`] accepted by `probe`, given that the maximum is accepted
+// and that any period above an accepted one is also accepted.
+//
+// Each round probes up to `parallelism` periods spread evenly over the
+// remaining interval at once, each on its own thread and with its own
+// scheduler; `scheduler` is used by the first and the others are created with
+// `create_scheduler` as needed and reused across rounds. Once a probe finishes,
+// the probes whose outcome it implies are interrupted.
+absl::StatusOr<int64_t> ParallelSearchMinClockPeriod(
+    int64_t min_clk_period_ps, int64_t max_clk_period_ps, int64_t parallelism,
+    SDCScheduler& scheduler, SDCSchedulerFactory create_scheduler,
+    ClockPeriodProbe probe) {
+  enum class Outcome : uint8_t { kUnknown, kFeasible, kInfeasible };
+
+  std::vector<std::unique_ptr<SDCScheduler>> schedulers(parallelism);
+  int64_t lo = min_clk_period_ps;
+  int64_t hi = max_clk_period_ps;
+  while (lo < hi) {
+    const int64_t probe_count = std::min(parallelism, hi - lo);
+    std::vector<int64_t> periods(probe_count);
+    for (int64_t i = 0; i < probe_count; ++i) {
+      periods[i] = lo + (hi - lo) * i / probe_count;
+    }
+    VLOG(4) << absl::StreamFormat("Probing clock periods [%s]",
+                                  absl::StrJoin(periods, ", "));
+
+    std::vector<Outcome> outcomes(probe_count, Outcome::kUnknown);
+    std::vector<absl::Status> statuses(probe_count);
+    std::vector<std::unique_ptr<operations_research::SolveInterrupter>>
+        interrupters;
+    for (int64_t i = 0; i < probe_count; ++i) {
+      interrupters.push_back(
+          std::make_unique<operations_research::SolveInterrupter>());
+    }
+    absl::Mutex mutex;
+    {
+      std::vector<std::unique_ptr<Thread>> threads;
+      for (int64_t i = 0; i < probe_count; ++i) {
+        threads.push_back(std::make_unique<Thread>([&, i]() {
+          SDCScheduler* probe_scheduler = &scheduler;
+          if (i > 0) {
+            if (schedulers[i] == nullptr) {
+              absl::StatusOr<std::unique_ptr<SDCScheduler>> created =
+                  create_scheduler();
+              if (!created.ok()) {
+                statuses[i] = created.status();
+                return;
+              }
+              schedulers[i] = *std::move(created);
+            }
+            probe_scheduler = schedulers[i].get();
+          }
+          bool feasible =
+              probe(*probe_scheduler, periods[i], interrupters[i].get());
+
+          absl::MutexLock lock(&mutex);
+          if (interrupters[i]->IsInterrupted()) {
+            return;
+          }
+          outcomes[i] = feasible ? Outcome::kFeasible : Outcome::kInfeasible;
+          // A feasible period implies all longer ones are, and an infeasible
+          // one that all shorter ones are not.
+          for (int64_t j = 0; j < probe_count; ++j) {
+            if (feasible ? j > i : j < i) {
+              interrupters[j]->Interrupt();
+            }
+          }
+        }));
+      }
+      // Threads are joined on destruction.
+    }
+    for (const absl::Status& status : statuses) {
+      XLS_RETURN_IF_ERROR(status);
+    }
+
+    // The first probe to finish is never interrupted, so each round narrows
+    // the interval.
+    for (int64_t i = 0; i < probe_count; ++i) {
+      if (outcomes[i] == Outcome::kFeasible) {
+        hi = periods[i];
+        break;
+      }
+    }
+    for (int64_t i = probe_count - 1; i >= 0; --i) {
+      if (outcomes[i] == Outcome::kInfeasible && periods[i] < hi) {
+        lo = std::max(lo, periods[i] + 1);
+        break;
+      }
+    }
+  }
+  return hi;
+}
+
 // Returns the minimum clock period in picoseconds for which it is feasible to
 // schedule the function into a pipeline with the given number of stages. If
 // `target_clock_period_ps` is specified, will not try to check lower clock
-// periods than this.
+// periods than this. With a `parallelism` above one, several clock periods are
+// tried at once, using additional schedulers from `create_scheduler`.
 absl::StatusOr<int64_t> FindMinimumClockPeriod(
     FunctionBase* f, std::optional<int64_t> pipeline_stages,
     std::optional<int64_t> worst_case_throughput,
     const DelayEstimator& delay_estimator, SDCScheduler& scheduler,
-    SchedulingFailureBehavior failure_behavior,
+    SchedulingFailureBehavior failure_behavior, int64_t parallelism,
+    SDCSchedulerFactory create_scheduler,
     std::optional<int64_t> target_clock_period_ps = std::nullopt) {
   VLOG(4) << "FindMinimumClockPeriod()";
   VLOG(4) << "  pipeline stages = "
@@ -233,15 +344,32 @@ absl::StatusOr<int64_t> FindMinimumClockPeriod(
   // Don't waste time explaining infeasibility for the failing points in the
   // search.
   failure_behavior.explain_infeasibility = false;
-  int64_t min_clk_period_ps = BinarySearchMinTrue(
-      optimistic_clk_period_ps, pessimistic_clk_period_ps,
-      [&](int64_t clk_period_ps) {
-        return scheduler
-            .Schedule(pipeline_stages, clk_period_ps, failure_behavior,
-                      /*check_feasibility=*/true, worst_case_throughput)
-            .ok();
-      },
-      BinarySearchAssumptions::kEndKnownTrue);
+  int64_t min_clk_period_ps;
+  if (parallelism > 1) {
+    XLS_ASSIGN_OR_RETURN(
+        min_clk_period_ps,
+        ParallelSearchMinClockPeriod(
+            optimistic_clk_period_ps, pessimistic_clk_period_ps, parallelism,
+            scheduler, create_scheduler,
+            [&](SDCScheduler& probe_scheduler, int64_t clk_period_ps,
+                const operations_research::SolveInterrupter* interrupter) {
+              return probe_scheduler
+                  .Schedule(pipeline_stages, clk_period_ps, failure_behavior,
+                            /*check_feasibility=*/true, worst_case_throughput,
+                            interrupter)
+                  .ok();
+            }));
+  } else {
+    min_clk_period_ps = BinarySearchMinTrue(
+        optimistic_clk_period_ps, pessimistic_clk_period_ps,
+        [&](int64_t clk_period_ps) {
+          return scheduler
+              .Schedule(pipeline_stages, clk_period_ps, failure_behavior,
+                        /*check_feasibility=*/true, worst_case_throughput)
+              .ok();
+        },
+        BinarySearchAssumptions::kEndKnownTrue);
+  }
   VLOG(4) << "minimum clock period = " << min_clk_period_ps;
 
   return min_clk_period_ps;
@@ -319,6 +447,134 @@ absl::StatusOr<int64_t> FindMinimumWorstCaseThroughput(
   return min_worst_case_throughput;
 }
 
+// Reschedules `f` at a few clock periods between `clock_period_ps`, the period
+// `cycle_map` was scheduled for, and `max_clock_period_ps`. Returns the
+// schedule with the fewest flops after codegen merges pipeline registers (see
+// PipelineSchedule::CountFinalPipelineFlops) along with its clock period,
+// preferring the shortest clock period among equals.
+absl::StatusOr<std::pair<ScheduleCycleMap, int64_t>> ScheduleForFewestFlops(
+    FunctionBase* f, std::optional<int64_t> pipeline_stages,
+    int64_t clock_period_ps, int64_t max_clock_period_ps,
+    std::optional<int64_t> worst_case_throughput, SDCScheduler& scheduler,
+    ScheduleCycleMap cycle_map) {
+  constexpr int64_t kCandidatePeriods = 4;
+
+  int64_t best_flops =
+      PipelineSchedule(f, cycle_map, pipeline_stages).CountFinalPipelineFlops();
+  int64_t best_clock_period_ps = clock_period_ps;
+  ScheduleCycleMap best_cycle_map = std::move(cycle_map);
+  int64_t previous_clock_period_ps = clock_period_ps;
+  for (int64_t i = 1; i <= kCandidatePeriods; ++i) {
+    int64_t candidate_clock_period_ps =
+        clock_period_ps +
+        (max_clock_period_ps - clock_period_ps) * i / kCandidatePeriods;
+    if (candidate_clock_period_ps == previous_clock_period_ps) {
+      continue;
+    }
+    previous_clock_period_ps = candidate_clock_period_ps;
+
+    absl::StatusOr<ScheduleCycleMap> candidate = scheduler.Schedule(
+        pipeline_stages, candidate_clock_period_ps,
+        SchedulingFailureBehavior{.explain_infeasibility = false},
+        /*check_feasibility=*/false, worst_case_throughput);
+    if (!candidate.ok()) {
+      VLOG(2) << "Failed to schedule at clock period "
+              << candidate_clock_period_ps << "ps: " << candidate.status();
+      continue;
+    }
+    int64_t flops = PipelineSchedule(f, *candidate, pipeline_stages)
+                        .CountFinalPipelineFlops();
+    VLOG(2) << absl::StreamFormat("Clock period %dps: %d pipeline flops",
+                                  candidate_clock_period_ps, flops);
+    if (flops < best_flops) {
+      best_flops = flops;
+      best_clock_period_ps = candidate_clock_period_ps;
+      best_cycle_map = *std::move(candidate);
+    }
+  }
+  return std::make_pair(std::move(best_cycle_map), best_clock_period_ps);
+}
+
+// Returns the cycles the schedule hint in `options` gives the nodes of `f`, or
+// nullopt if there is no hint for `f`.
+absl::StatusOr<std::optional<ScheduleCycleMap>> GetHintedCycles(
+    FunctionBase* f, const SchedulingOptions& options) {
+  if (!options.schedule_hint().has_value()) {
+    return std::nullopt;
+  }
+  auto it = options.schedule_hint()->schedules().find(f->name());
+  if (it == options.schedule_hint()->schedules().end()) {
+    return std::nullopt;
+  }
+  return MatchScheduleHint(f, it->second);
+}
+
+// Returns whether `hinted_cycles` schedules every node of `f` and is still a
+// valid schedule of `f` at the given clock period.
+bool CanReuseHintedCycles(FunctionBase* f,
+                          const ScheduleCycleMap& hinted_cycles,
+                          int64_t clock_period_ps,
+                          const DelayEstimator& delay_estimator,
+                          const SchedulingOptions& options) {
+  if (hinted_cycles.size() != f->node_count()) {
+    VLOG(2) << "Not reusing the hinted schedule of " << f->name() << ": "
+            << f->node_count() - hinted_cycles.size()
+            << " nodes are not in the hint";
+    return false;
+  }
+  if (options.pipeline_stages().has_value() &&
+      absl::c_any_of(hinted_cycles, [&](const auto& node_and_cycle) {
+        return node_and_cycle.second >= *options.pipeline_stages();
+      })) {
+    VLOG(2) << "Not reusing the hinted schedule of " << f->name()
+            << ": it has more than " << *options.pipeline_stages()
+            << " stages";
+    return false;
+  }
+  PipelineSchedule schedule(f, hinted_cycles, options.pipeline_stages());
+  absl::Status status = schedule.Verify();
+  if (status.ok()) {
+    status = schedule.VerifyTiming(clock_period_ps, delay_estimator);
+  }
+  if (status.ok()) {
+    status = schedule.VerifyConstraints(options.constraints(),
+                                        f->GetInitiationInterval());
+  }
+  if (!status.ok()) {
+    VLOG(2) << "Not reusing the hinted schedule of " << f->name() << ": "
+            << status;
+    return false;
+  }
+  return true;
+}
+
+// Schedules `f` with the SDC scheduler, keeping the nodes away from the changes
+// since the hinted schedule `hinted_cycles` in their hinted cycles (see
+// PinHintedNodes). Returns nullopt if that is infeasible.
+absl::StatusOr<std::optional<ScheduleCycleMap>> ScheduleAroundHint(
+    FunctionBase* f, const ScheduleCycleMap& hinted_cycles,
+    int64_t clock_period_ps, std::optional<int64_t> worst_case_throughput,
+    const DelayEstimator& delay_estimator, const SchedulingOptions& options) {
+  std::vector<SchedulingConstraint> pins =
+      PinHintedNodes(f, hinted_cycles, options.pipeline_stages());
+  VLOG(2) << "Pinning " << pins.size() << " of " << f->node_count()
+          << " nodes of " << f->name() << " to their hinted cycles";
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<SDCScheduler> scheduler,
+                       SDCScheduler::Create(f, delay_estimator));
+  XLS_RETURN_IF_ERROR(scheduler->AddConstraints(options.constraints()));
+  XLS_RETURN_IF_ERROR(scheduler->AddConstraints(pins));
+  absl::StatusOr<ScheduleCycleMap> cycle_map = scheduler->Schedule(
+      options.pipeline_stages(), clock_period_ps,
+      SchedulingFailureBehavior{.explain_infeasibility = false},
+      /*check_feasibility=*/false, worst_case_throughput);
+  if (!cycle_map.ok()) {
+    VLOG(2) << "Failed to schedule " << f->name()
+            << " around its hinted schedule: " << cycle_map.status();
+    return std::nullopt;
+  }
+  return *std::move(cycle_map);
+}
+
 }  // namespace
 
 absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
@@ -381,12 +637,17 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
     return schedule;
   }
 
+  auto create_sdc_scheduler =
+      [&]() -> absl::StatusOr<std::unique_ptr<SDCScheduler>> {
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<SDCScheduler> scheduler,
+                         SDCScheduler::Create(f, io_delay_added));
+    XLS_RETURN_IF_ERROR(scheduler->AddConstraints(options.constraints()));
+    return scheduler;
+  };
   std::unique_ptr<SDCScheduler> sdc_scheduler;
   auto initialize_sdc_scheduler = [&]() -> absl::Status {
     if (sdc_scheduler == nullptr) {
-      XLS_ASSIGN_OR_RETURN(sdc_scheduler,
-                           SDCScheduler::Create(f, io_delay_added));
-      XLS_RETURN_IF_ERROR(sdc_scheduler->AddConstraints(options.constraints()));
+      XLS_ASSIGN_OR_RETURN(sdc_scheduler, create_sdc_scheduler());
     }
     return absl::OkStatus();
   };
@@ -428,7 +689,8 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
             f, options.pipeline_stages(),
             /*worst_case_throughput=*/f->IsProc() ? f->GetInitiationInterval()
                                                   : std::nullopt,
-            io_delay_added, *sdc_scheduler, options.failure_behavior()));
+            io_delay_added, *sdc_scheduler, options.failure_behavior(),
+            options.clock_search_parallelism(), create_sdc_scheduler));
     min_clock_period_ps_for_tracing = clock_period_ps;
 
     if (options.period_relaxation_percent().has_value()) {
@@ -482,8 +744,60 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
     }
   }
 
+  // Very large functions are cut into parts which are scheduled in parallel
+  // rather than scheduled with a single solve, provided the partitioned
+  // scheduler supports everything they need.
+  bool partition =
+      options.max_partition_size().value_or(0) > 0 &&
+      f->node_count() > *options.max_partition_size() && !options.use_fdo() &&
+      (options.strategy() == SchedulingStrategy::SDC ||
+       options.strategy() == SchedulingStrategy::MIN_CUT) &&
+      absl::c_all_of(options.constraints(),
+                     [](const SchedulingConstraint& constraint) {
+                       return std::holds_alternative<
+                           RecvsFirstSendsLastConstraint>(constraint);
+                     }) &&
+      absl::c_none_of(f->nodes(),
+                      [](Node* node) { return node->Is<MinDelay>(); });
+
+  // A schedule of an earlier version of `f` is kept if it is still valid.
+  // Otherwise, if asked to, the parts of `f` away from the changes are kept
+  // where they were, falling back to scheduling from scratch if that fails.
+  std::optional<ScheduleCycleMap> hinted_schedule;
+  XLS_ASSIGN_OR_RETURN(std::optional<ScheduleCycleMap> hinted_cycles,
+                       GetHintedCycles(f, options));
+  if (hinted_cycles.has_value()) {
+    if (CanReuseHintedCycles(f, *hinted_cycles, clock_period_ps,
+                             io_delay_added, options)) {
+      VLOG(2) << "Reusing the hinted schedule of " << f->name();
+      hinted_schedule = *std::move(hinted_cycles);
+    } else if (options.pin_schedule_hint() && !partition &&
+               options.strategy() == SchedulingStrategy::SDC &&
+               !options.use_fdo()) {
+      XLS_ASSIGN_OR_RETURN(
+          hinted_schedule,
+          ScheduleAroundHint(f, *hinted_cycles, clock_period_ps,
+                             worst_case_throughput, io_delay_added, options));
+    }
+  }
+
   ScheduleCycleMap cycle_map;
-  if (options.strategy() == SchedulingStrategy::SDC) {
+  if (hinted_schedule.has_value()) {
+    cycle_map = *std::move(hinted_schedule);
+  } else if (partition) {
+    VLOG(2) << "Scheduling " << f->name() << " (" << f->node_count()
+            << " nodes) in parts of at most " << *options.max_partition_size()
+            << " nodes";
+    sched::ScheduleBounds bounds(f, TopoSort(f), clock_period_ps,
+                                 io_delay_added);
+    XLS_RETURN_IF_ERROR(TightenBounds(bounds, f, options.pipeline_stages()));
+    XLS_ASSIGN_OR_RETURN(
+        cycle_map,
+        PartitionedMinCutScheduler(
+            f, options.pipeline_stages().value_or(bounds.max_lower_bound() + 1),
+            clock_period_ps, io_delay_added, &bounds, options.constraints(),
+            *options.max_partition_size()));
+  } else if (options.strategy() == SchedulingStrategy::SDC) {
     // Enable iterative SDC scheduling when use_fdo is true
     if (options.use_fdo()) {
       if (!options.clock_period_ps().has_value()) {
@@ -503,7 +817,10 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
       isdc_options.path_evaluate_strategy =
           options.fdo_path_evaluate_strategy();
 
-      DelayManager delay_manager(f, delay_estimator);
+      // Timing constraints only need the paths which first go over the clock
+      // period, so bound the tracked delays by it.
+      DelayManager delay_manager(f, delay_estimator,
+                                 /*max_tracked_delay=*/clock_period_ps);
       XLS_ASSIGN_OR_RETURN(
           cycle_map,
           ScheduleByIterativeSDC(f, options.pipeline_stages(), clock_period_ps,
@@ -551,6 +868,7 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
           absl::StatusOr<int64_t> min_clock_period_ps = FindMinimumClockPeriod(
               f, options.pipeline_stages(), worst_case_throughput,
               io_delay_added, *sdc_scheduler, options.failure_behavior(),
+              options.clock_search_parallelism(), create_sdc_scheduler,
               target_clock_period_ps);
           if (min_clock_period_ps.ok()) {
             min_clock_period_ps_for_tracing = *min_clock_period_ps;
@@ -613,6 +931,25 @@ absl::StatusOr<PipelineSchedule> RunPipelineSchedule(
       return schedule_cycle_map.status();
     }
     cycle_map = *std::move(schedule_cycle_map);
+
+    if (options.flop_relaxation_percent().value_or(0) > 0) {
+      // Give up some slack for fewer flops, without going past the user's
+      // target clock period.
+      int64_t max_clock_period_ps =
+          clock_period_ps +
+          (clock_period_ps * *options.flop_relaxation_percent() + 50) / 100;
+      if (options.clock_period_ps().has_value()) {
+        max_clock_period_ps =
+            std::min(max_clock_period_ps,
+                     std::max(clock_period_ps, *options.clock_period_ps()));
+      }
+      XLS_ASSIGN_OR_RETURN(
+          (std::pair<ScheduleCycleMap, int64_t> fewest_flops),
+          ScheduleForFewestFlops(f, options.pipeline_stages(), clock_period_ps,
+                                 max_clock_period_ps, worst_case_throughput,
+                                 *sdc_scheduler, std::move(cycle_map)));
+      std::tie(cycle_map, clock_period_ps) = std::move(fewest_flops);
+    }
   } else {
     // Run an initial ASAP/ALAP scheduling pass, which we'll refine with the
     // chosen scheduler.
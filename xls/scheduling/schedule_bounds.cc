@@ -16,12 +16,13 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <limits>
+#include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -53,20 +54,35 @@ ScheduleBounds::ScheduleBounds(FunctionBase* f, std::vector<Node*> topo_sort,
 }
 
 void ScheduleBounds::Reset() {
-  max_lower_bound_ = 0;
-  min_upper_bound_ = 0;
+  int64_t size = 0;
   for (Node* node : topo_sort_) {
-    bounds_[node] = {0, std::numeric_limits<int64_t>::max()};
-    max_lower_bound_ = 0;
-    min_upper_bound_ = std::numeric_limits<int64_t>::max();
+    size = std::max(size, node->dense_index() + 1);
+  }
+  nodes_.assign(size, nullptr);
+  topo_position_.assign(size, -1);
+  for (int64_t i = 0; i < topo_sort_.size(); ++i) {
+    nodes_[topo_sort_[i]->dense_index()] = topo_sort_[i];
+    topo_position_[topo_sort_[i]->dense_index()] = i;
   }
+  bounds_.assign(size, {0, std::numeric_limits<int64_t>::max()});
+  lb_in_cycle_delay_.assign(size, 0);
+  ub_in_cycle_delay_.assign(size, 0);
+  lb_dirty_.assign(size, false);
+  ub_dirty_.assign(size, false);
+  lb_dirty_nodes_.clear();
+  ub_dirty_nodes_.clear();
+  lb_propagated_ = false;
+  ub_propagated_ = false;
+  max_lower_bound_ = 0;
+  min_upper_bound_ = std::numeric_limits<int64_t>::max();
 }
 
 std::string ScheduleBounds::ToString() const {
   std::string out = "Bounds:\n";
-  if (!bounds_.empty()) {
-    for (Node* node : TopoSort(bounds_.begin()->first->function_base())) {
-      if (bounds_.contains(node)) {
+  if (!topo_sort_.empty()) {
+    for (Node* node : TopoSort(topo_sort_.front()->function_base())) {
+      if (node->dense_index() < nodes_.size() &&
+          nodes_[node->dense_index()] == node) {
         absl::StrAppendFormat(&out, "  %s : [%d, %d]\n", node->GetName(),
                               lb(node), ub(node));
       }
@@ -75,109 +91,208 @@ std::string ScheduleBounds::ToString() const {
   return out;
 }
 
-absl::Status ScheduleBounds::PropagateLowerBounds() {
-  VLOG(4) << "PropagateLowerBounds()";
-  // The delay in picoseconds from the beginning of a cycle to the start of the
-  // node.
-  absl::flat_hash_map<Node*, int64_t> in_cycle_delay;
+absl::Status ScheduleBounds::EstimateNodeDelays() {
+  if (node_delays_.size() == nodes_.size()) {
+    return absl::OkStatus();
+  }
+  XLS_ASSIGN_OR_RETURN(std::vector<int64_t> delays,
+                       delay_estimator_->GetOperationDelaysInPs(topo_sort_));
+  node_delays_.assign(nodes_.size(), 0);
+  for (int64_t i = 0; i < topo_sort_.size(); ++i) {
+    node_delays_[topo_sort_[i]->dense_index()] = delays[i];
+  }
+  return absl::OkStatus();
+}
 
-  // Compute the lower bound of each node based on the lower bounds of the
-  // operands of the node.
-  for (Node* node : topo_sort_) {
-    int64_t& node_in_cycle_delay = in_cycle_delay[node];
-    VLOG(4) << absl::StreamFormat("  %s : original lb=%d", node->GetName(),
-                                  lb(node));
-    for (Node* operand : node->operands()) {
-      int64_t operand_lb = lb(operand);
-      if (operand_lb < lb(node)) {
-        continue;
-      }
-      XLS_ASSIGN_OR_RETURN(int64_t operand_delay,
-                           delay_estimator_->GetOperationDelayInPs(operand));
-      if (operand_lb > lb(node)) {
-        VLOG(4) << absl::StreamFormat(
-            "    tightened lb to %d because of operand %s", operand_lb,
-            operand->GetName());
-        XLS_RETURN_IF_ERROR(TightenNodeLb(node, operand_lb));
-        node_in_cycle_delay = in_cycle_delay.at(operand) + operand_delay;
-        continue;
-      }
-      int64_t min_delay =
-          operand->Is<MinDelay>() ? operand->As<MinDelay>()->delay() : 0;
-      if (operand_lb + min_delay > lb(node)) {
-        VLOG(4) << absl::StreamFormat(
-            "    tightened lb to %d because of operand %s", operand_lb,
-            operand->GetName());
-        XLS_RETURN_IF_ERROR(TightenNodeLb(node, operand_lb + min_delay));
-        node_in_cycle_delay = 0;
-        continue;
-      }
-      node_in_cycle_delay = std::max(
-          node_in_cycle_delay, in_cycle_delay.at(operand) + operand_delay);
+absl::Status ScheduleBounds::UpdateLowerBound(int64_t index) {
+  Node* node = nodes_[index];
+  int64_t node_in_cycle_delay = 0;
+  VLOG(4) << absl::StreamFormat("  %s : original lb=%d", node->GetName(),
+                                bounds_[index].first);
+  for (Node* operand : node->operands()) {
+    int64_t operand_index = Index(operand);
+    int64_t operand_lb = bounds_[operand_index].first;
+    if (operand_lb < bounds_[index].first) {
+      continue;
     }
-    XLS_ASSIGN_OR_RETURN(int64_t node_delay,
-                         delay_estimator_->GetOperationDelayInPs(node));
-    if (node_delay > clock_period_ps_) {
-      return absl::ResourceExhaustedError(absl::StrFormat(
-          "Node %s has a greater delay (%dps) than the clock period (%dps)",
-          node->GetName(), node_delay, clock_period_ps_));
+    int64_t operand_delay = node_delays_[operand_index];
+    if (operand_lb > bounds_[index].first) {
+      VLOG(4) << absl::StreamFormat(
+          "    tightened lb to %d because of operand %s", operand_lb,
+          operand->GetName());
+      XLS_RETURN_IF_ERROR(SetLb(index, operand_lb));
+      node_in_cycle_delay = lb_in_cycle_delay_[operand_index] + operand_delay;
+      continue;
     }
-    if (node_in_cycle_delay + node_delay > clock_period_ps_) {
-      // Node does not fit in this cycle. Move to next cycle.
-      VLOG(4) << "    overflows clock period, tightened lb to " << lb(node) + 1;
-      XLS_RETURN_IF_ERROR(TightenNodeLb(node, lb(node) + 1));
+    int64_t min_delay =
+        operand->Is<MinDelay>() ? operand->As<MinDelay>()->delay() : 0;
+    if (operand_lb + min_delay > bounds_[index].first) {
+      VLOG(4) << absl::StreamFormat(
+          "    tightened lb to %d because of operand %s", operand_lb,
+          operand->GetName());
+      XLS_RETURN_IF_ERROR(SetLb(index, operand_lb + min_delay));
       node_in_cycle_delay = 0;
+      continue;
     }
+    node_in_cycle_delay = std::max(
+        node_in_cycle_delay, lb_in_cycle_delay_[operand_index] + operand_delay);
+  }
+  int64_t node_delay = node_delays_[index];
+  if (node_delay > clock_period_ps_) {
+    return absl::ResourceExhaustedError(absl::StrFormat(
+        "Node %s has a greater delay (%dps) than the clock period (%dps)",
+        node->GetName(), node_delay, clock_period_ps_));
+  }
+  if (node_in_cycle_delay + node_delay > clock_period_ps_) {
+    // Node does not fit in this cycle. Move to next cycle.
+    VLOG(4) << "    overflows clock period, tightened lb to "
+            << bounds_[index].first + 1;
+    XLS_RETURN_IF_ERROR(SetLb(index, bounds_[index].first + 1));
+    node_in_cycle_delay = 0;
   }
+  lb_in_cycle_delay_[index] = node_in_cycle_delay;
   return absl::OkStatus();
 }
 
-absl::Status ScheduleBounds::PropagateUpperBounds() {
-  VLOG(4) << "PropagateUpperBounds()";
-  // The delay in picoseconds from the end of a cycle to the end of the node.
-  absl::flat_hash_map<Node*, int64_t> in_cycle_delay;
+absl::Status ScheduleBounds::UpdateUpperBound(int64_t index) {
+  Node* node = nodes_[index];
+  int64_t node_in_cycle_delay = 0;
+  VLOG(4) << absl::StreamFormat("  %s : original ub=%d", node->GetName(),
+                                bounds_[index].second);
+  for (Node* user : node->users()) {
+    int64_t user_index = Index(user);
+    int64_t user_ub = bounds_[user_index].second;
+    if (user_ub == std::numeric_limits<int64_t>::max() ||
+        user_ub > bounds_[index].second) {
+      continue;
+    }
+    int64_t user_delay = node_delays_[user_index];
+    if (user_ub < bounds_[index].second) {
+      VLOG(4) << absl::StreamFormat("    tightened ub to %d because of user %s",
+                                    user_ub, user->GetName());
+      XLS_RETURN_IF_ERROR(SetUb(index, user_ub));
+      node_in_cycle_delay = ub_in_cycle_delay_[user_index] + user_delay;
+      continue;
+    }
+    node_in_cycle_delay = std::max(
+        node_in_cycle_delay, ub_in_cycle_delay_[user_index] + user_delay);
+  }
+  int64_t node_delay = node_delays_[index];
+  if (node_delay > clock_period_ps_) {
+    return absl::ResourceExhaustedError(absl::StrFormat(
+        "Node %s has a greater delay (%dps) than the clock period (%dps)",
+        node->GetName(), node_delay, clock_period_ps_));
+  }
+  if (node_in_cycle_delay + node_delay > clock_period_ps_) {
+    // Node does not fit in this cycle. Move to next cycle.
+    VLOG(4) << "    overflows clock period, tightened ub to "
+            << bounds_[index].second - 1;
+    XLS_RETURN_IF_ERROR(SetUb(index, bounds_[index].second - 1));
+    node_in_cycle_delay = 0;
+  }
+  ub_in_cycle_delay_[index] = node_in_cycle_delay;
+  return absl::OkStatus();
+}
 
-  // Compute the upper bound of each node based on the upper bounds of the
-  // users of the node.
-  for (auto it = topo_sort_.rbegin(); it != topo_sort_.rend(); ++it) {
-    Node* node = *it;
-    int64_t& node_in_cycle_delay = in_cycle_delay[node];
-    VLOG(4) << absl::StreamFormat("  %s : original ub=%d", node->GetName(),
-                                  ub(node));
-    for (Node* user : node->users()) {
-      int64_t user_ub = ub(user);
-      if (user_ub == std::numeric_limits<int64_t>::max() ||
-          user_ub > ub(node)) {
-        continue;
+absl::Status ScheduleBounds::PropagateLowerBounds() {
+  VLOG(4) << "PropagateLowerBounds()";
+  XLS_RETURN_IF_ERROR(EstimateNodeDelays());
+  auto propagate = [&]() -> absl::Status {
+    if (!lb_propagated_) {
+      for (Node* node : topo_sort_) {
+        XLS_RETURN_IF_ERROR(UpdateLowerBound(node->dense_index()));
       }
-      XLS_ASSIGN_OR_RETURN(int64_t user_delay,
-                           delay_estimator_->GetOperationDelayInPs(user));
-      if (user_ub < ub(node)) {
-        VLOG(4) << absl::StreamFormat(
-            "    tightened ub to %d because of user %s", user_ub,
-            user->GetName());
-        XLS_RETURN_IF_ERROR(TightenNodeUb(node, user_ub));
-        node_in_cycle_delay = in_cycle_delay.at(user) + user_delay;
+      return absl::OkStatus();
+    }
+    // Visit the fan-out cone of the tightened nodes in topological order. A
+    // node's users only need to be revisited if its lower bound or in-cycle
+    // delay changed; the in-cycle delays of the tightened nodes were
+    // invalidated when they were tightened, so their users are always visited.
+    std::priority_queue<std::pair<int64_t, int64_t>,
+                        std::vector<std::pair<int64_t, int64_t>>,
+                        std::greater<>>
+        worklist;
+    for (int64_t index : lb_dirty_nodes_) {
+      worklist.push({topo_position_[index], index});
+    }
+    while (!worklist.empty()) {
+      int64_t index = worklist.top().second;
+      worklist.pop();
+      lb_dirty_[index] = false;
+      std::pair<int64_t, int64_t> old = {bounds_[index].first,
+                                         lb_in_cycle_delay_[index]};
+      XLS_RETURN_IF_ERROR(UpdateLowerBound(index));
+      if (old ==
+          std::make_pair(bounds_[index].first, lb_in_cycle_delay_[index])) {
         continue;
       }
-      node_in_cycle_delay =
-          std::max(node_in_cycle_delay, in_cycle_delay.at(user) + user_delay);
+      for (Node* user : nodes_[index]->users()) {
+        int64_t user_index = Index(user);
+        if (!lb_dirty_[user_index]) {
+          lb_dirty_[user_index] = true;
+          worklist.push({topo_position_[user_index], user_index});
+        }
+      }
+    }
+    return absl::OkStatus();
+  };
+  bool full = !lb_propagated_;
+  absl::Status status = propagate();
+  if (full || !status.ok()) {
+    lb_dirty_.assign(lb_dirty_.size(), false);
+  }
+  lb_dirty_nodes_.clear();
+  // After a failure the in-cycle delays may be inconsistent, so the next
+  // propagation starts over.
+  lb_propagated_ = status.ok();
+  return status;
+}
+
+absl::Status ScheduleBounds::PropagateUpperBounds() {
+  VLOG(4) << "PropagateUpperBounds()";
+  XLS_RETURN_IF_ERROR(EstimateNodeDelays());
+  auto propagate = [&]() -> absl::Status {
+    if (!ub_propagated_) {
+      for (auto it = topo_sort_.rbegin(); it != topo_sort_.rend(); ++it) {
+        XLS_RETURN_IF_ERROR(UpdateUpperBound((*it)->dense_index()));
+      }
+      return absl::OkStatus();
     }
-    XLS_ASSIGN_OR_RETURN(int64_t node_delay,
-                         delay_estimator_->GetOperationDelayInPs(node));
-    if (node_delay > clock_period_ps_) {
-      return absl::ResourceExhaustedError(absl::StrFormat(
-          "Node %s has a greater delay (%dps) than the clock period (%dps)",
-          node->GetName(), node_delay, clock_period_ps_));
+    // Visit the fan-in cone of the tightened nodes in reverse topological
+    // order, as for lower bounds.
+    std::priority_queue<std::pair<int64_t, int64_t>> worklist;
+    for (int64_t index : ub_dirty_nodes_) {
+      worklist.push({topo_position_[index], index});
     }
-    if (node_in_cycle_delay + node_delay > clock_period_ps_) {
-      // Node does not fit in this cycle. Move to next cycle.
-      VLOG(4) << "    overflows clock period, tightened ub to " << ub(node) - 1;
-      XLS_RETURN_IF_ERROR(TightenNodeUb(node, ub(node) - 1));
-      node_in_cycle_delay = 0;
+    while (!worklist.empty()) {
+      int64_t index = worklist.top().second;
+      worklist.pop();
+      ub_dirty_[index] = false;
+      std::pair<int64_t, int64_t> old = {bounds_[index].second,
+                                         ub_in_cycle_delay_[index]};
+      XLS_RETURN_IF_ERROR(UpdateUpperBound(index));
+      if (old ==
+          std::make_pair(bounds_[index].second, ub_in_cycle_delay_[index])) {
+        continue;
+      }
+      for (Node* operand : nodes_[index]->operands()) {
+        int64_t operand_index = Index(operand);
+        if (!ub_dirty_[operand_index]) {
+          ub_dirty_[operand_index] = true;
+          worklist.push({topo_position_[operand_index], operand_index});
+        }
+      }
     }
+    return absl::OkStatus();
+  };
+  bool full = !ub_propagated_;
+  absl::Status status = propagate();
+  if (full || !status.ok()) {
+    ub_dirty_.assign(ub_dirty_.size(), false);
   }
-  return absl::OkStatus();
+  ub_dirty_nodes_.clear();
+  ub_propagated_ = status.ok();
+  return status;
 }
 
 /* static */ absl::StatusOr<ScheduleBounds>
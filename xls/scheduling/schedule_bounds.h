@@ -21,10 +21,11 @@
 #include <utility>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/ir/node.h"
 
@@ -65,25 +66,28 @@ class ScheduleBounds {
   void Reset();
 
   // Return the lower/upper bound of the given node.
-  int64_t lb(Node* node) const { return bounds_.at(node).first; }
-  int64_t ub(Node* node) const { return bounds_.at(node).second; }
+  int64_t lb(Node* node) const { return bounds_[Index(node)].first; }
+  int64_t ub(Node* node) const { return bounds_[Index(node)].second; }
 
   // Return the lower and upper bound as a pair (lower bound is first element).
   const std::pair<int64_t, int64_t>& bounds(Node* node) const {
-    return bounds_.at(node);
+    return bounds_[Index(node)];
   }
 
   // Sets the lower bound of the given node to the maximum of its existing value
   // and the given value. Raises a ResourceExhaustedError if the new value
   // results in infeasible bounds (lower bound is greater than upper bound).
   absl::Status TightenNodeLb(Node* node, int64_t value) {
-    if (value > ub(node)) {
-      return absl::ResourceExhaustedError(
-          absl::StrFormat("Unable to tighten the lower bound of node %s to %d.",
-                          node->GetName(), value));
+    int64_t index = Index(node);
+    int64_t old_lb = bounds_[index].first;
+    XLS_RETURN_IF_ERROR(SetLb(index, value));
+    if (bounds_[index].first != old_lb && !lb_dirty_[index]) {
+      lb_dirty_[index] = true;
+      lb_dirty_nodes_.push_back(index);
+      // Invalidate the in-cycle delay so that propagation visits the users of
+      // the node even if recomputing the delay gives the same value.
+      lb_in_cycle_delay_[index] = -1;
     }
-    bounds_.at(node).first = std::max(bounds_.at(node).first, value);
-    max_lower_bound_ = std::max(max_lower_bound_, value);
     return absl::OkStatus();
   }
 
@@ -91,13 +95,16 @@ class ScheduleBounds {
   // and the given value. Raises a ResourceExhaustedError if the new value
   // results in infeasible bounds (lower bound is greater than upper bound).
   absl::Status TightenNodeUb(Node* node, int64_t value) {
-    if (value < lb(node)) {
-      return absl::ResourceExhaustedError(
-          absl::StrFormat("Unable to tighten the upper bound of node %s to %d.",
-                          node->GetName(), value));
+    int64_t index = Index(node);
+    int64_t old_ub = bounds_[index].second;
+    XLS_RETURN_IF_ERROR(SetUb(index, value));
+    if (bounds_[index].second != old_ub && !ub_dirty_[index]) {
+      ub_dirty_[index] = true;
+      ub_dirty_nodes_.push_back(index);
+      // Invalidate the in-cycle delay so that propagation visits the users of
+      // the node even if recomputing the delay gives the same value.
+      ub_in_cycle_delay_[index] = -1;
     }
-    bounds_.at(node).second = std::min(bounds_.at(node).second, value);
-    min_upper_bound_ = std::min(min_upper_bound_, value);
     return absl::OkStatus();
   }
 
@@ -113,18 +120,89 @@ class ScheduleBounds {
   // throughout the graph. This method only tightens bounds (increases lower
   // bounds and decreases upper bounds). Returns an error if propagation results
   // in infeasible bounds (lower bound is greater than upper bound for a node).
+  //
+  // The first propagation after construction or Reset visits every node. Later
+  // propagations only revisit the fan-out (fan-in) cone of the nodes whose
+  // bounds were tightened since, stopping wherever a node's bound and
+  // in-cycle delay are unchanged.
   absl::Status PropagateLowerBounds();
   absl::Status PropagateUpperBounds();
 
  private:
+  // Returns the index of the given node in the per-node arrays below.
+  int64_t Index(Node* node) const {
+    int64_t index = node->dense_index();
+    DCHECK(index < static_cast<int64_t>(nodes_.size()) && nodes_[index] == node)
+        << "No bounds for node " << node->GetName();
+    return index;
+  }
+
+  // Tightens the bounds of the node with the given index without scheduling
+  // it for propagation.
+  absl::Status SetLb(int64_t index, int64_t value) {
+    if (value > bounds_[index].second) {
+      return absl::ResourceExhaustedError(
+          absl::StrFormat("Unable to tighten the lower bound of node %s to %d.",
+                          nodes_[index]->GetName(), value));
+    }
+    bounds_[index].first = std::max(bounds_[index].first, value);
+    max_lower_bound_ = std::max(max_lower_bound_, value);
+    return absl::OkStatus();
+  }
+  absl::Status SetUb(int64_t index, int64_t value) {
+    if (value < bounds_[index].first) {
+      return absl::ResourceExhaustedError(
+          absl::StrFormat("Unable to tighten the upper bound of node %s to %d.",
+                          nodes_[index]->GetName(), value));
+    }
+    bounds_[index].second = std::min(bounds_[index].second, value);
+    min_upper_bound_ = std::min(min_upper_bound_, value);
+    return absl::OkStatus();
+  }
+
+  // Recomputes the lower (upper) bound and in-cycle delay of the node with the
+  // given index from those of its operands (users).
+  absl::Status UpdateLowerBound(int64_t index);
+  absl::Status UpdateUpperBound(int64_t index);
+
+  // Estimates the delays of all nodes in the topological sort with a single
+  // batched query, if not done already.
+  absl::Status EstimateNodeDelays();
+
   // A topological sort of the nodes in the function.
   std::vector<Node*> topo_sort_;
 
   int64_t clock_period_ps_;
   const DelayEstimator* delay_estimator_;
 
+  // The per-node state below is indexed by Node::dense_index(). `nodes_` maps
+  // an index back to its node and is null for indices of nodes which are not
+  // in the topological sort.
+  std::vector<Node*> nodes_;
+  std::vector<int64_t> topo_position_;
+
   // The bounds of each node stored as a {lower, upper} pair.
-  absl::flat_hash_map<Node*, std::pair<int64_t, int64_t>> bounds_;
+  std::vector<std::pair<int64_t, int64_t>> bounds_;
+
+  // The estimated delay of each node, filled in by EstimateNodeDelays.
+  // Propagation visits each node once per operand and user, so the delays are
+  // looked up here rather than queried from the estimator each time.
+  std::vector<int64_t> node_delays_;
+
+  // The delay from the start of the cycle to the start of each node (from the
+  // end of each node to the end of the cycle) as of the last propagation of
+  // lower (upper) bounds.
+  std::vector<int64_t> lb_in_cycle_delay_;
+  std::vector<int64_t> ub_in_cycle_delay_;
+
+  // The nodes whose lower (upper) bound was tightened since the last
+  // propagation, and whether the bounds have been propagated at all.
+  std::vector<bool> lb_dirty_;
+  std::vector<bool> ub_dirty_;
+  std::vector<int64_t> lb_dirty_nodes_;
+  std::vector<int64_t> ub_dirty_nodes_;
+  bool lb_propagated_ = false;
+  bool ub_propagated_ = false;
 
   int64_t max_lower_bound_;
   int64_t min_upper_bound_;
@@ -16,14 +16,17 @@
 
 #include <cstdint>
 #include <limits>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
 #include "xls/common/status/matchers.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
+#include "xls/ir/function.h"
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
 #include "xls/ir/op.h"
 
 namespace xls {
@@ -167,6 +170,48 @@ TEST_F(ScheduleBoundsTest, SimpleExpressionTightenBounds) {
   EXPECT_EQ(bounds.lb(result.node()), 23);
 }
 
+TEST_F(ScheduleBoundsTest, IncrementalPropagationMatchesFullPropagation) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue y = fb.Param("y", p->GetBitsType(32));
+  std::vector<BValue> chain = {x};
+  for (int64_t i = 0; i < 8; ++i) {
+    chain.push_back(i % 3 == 2 ? fb.Add(chain.back(), y)
+                               : fb.Not(chain.back()));
+  }
+  BValue side = fb.Not(fb.Not(y));
+  fb.Add(chain.back(), side);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  Node* tightened = chain[4].node();
+  Node* root = f->return_value();
+
+  // Tighten after an initial propagation so only the affected cones are
+  // revisited...
+  ScheduleBounds incremental(f, /*clock_period_ps=*/3, delay_estimator_);
+  XLS_ASSERT_OK(incremental.PropagateLowerBounds());
+  XLS_ASSERT_OK(incremental.TightenNodeUb(root, 10));
+  XLS_ASSERT_OK(incremental.PropagateUpperBounds());
+  XLS_ASSERT_OK(incremental.TightenNodeLb(tightened, 3));
+  XLS_ASSERT_OK(incremental.PropagateLowerBounds());
+  XLS_ASSERT_OK(incremental.TightenNodeUb(tightened, 4));
+  XLS_ASSERT_OK(incremental.PropagateUpperBounds());
+
+  // ...and compare with tightening before propagating over the whole graph.
+  ScheduleBounds full(f, /*clock_period_ps=*/3, delay_estimator_);
+  XLS_ASSERT_OK(full.TightenNodeLb(tightened, 3));
+  XLS_ASSERT_OK(full.PropagateLowerBounds());
+  XLS_ASSERT_OK(full.TightenNodeUb(root, 10));
+  XLS_ASSERT_OK(full.TightenNodeUb(tightened, 4));
+  XLS_ASSERT_OK(full.PropagateUpperBounds());
+
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(incremental.bounds(node), full.bounds(node)) << node->GetName();
+  }
+  EXPECT_EQ(incremental.lb(root), 4);
+  EXPECT_EQ(incremental.ub(chain[3].node()), 4);
+}
+
 }  // namespace
 }  // namespace sched
 }  // namespace xls
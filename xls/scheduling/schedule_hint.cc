@@ -0,0 +1,82 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/schedule_hint.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/scheduling/pipeline_schedule.pb.h"
+#include "xls/scheduling/scheduling_options.h"
+
+namespace xls {
+
+absl::StatusOr<ScheduleCycleMap> MatchScheduleHint(
+    FunctionBase* f, const PipelineScheduleProto& hint) {
+  absl::flat_hash_map<std::string, Node*> nodes_by_name;
+  nodes_by_name.reserve(f->node_count());
+  for (Node* node : f->nodes()) {
+    nodes_by_name.emplace(node->GetName(), node);
+  }
+
+  ScheduleCycleMap cycle_map;
+  for (const StageProto& stage : hint.stages()) {
+    if (stage.stage() < 0) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Schedule hint for `%s` has negative stage %d", hint.function(),
+          stage.stage()));
+    }
+    for (const TimedNodeProto& timed_node : stage.timed_nodes()) {
+      auto it = nodes_by_name.find(timed_node.node());
+      if (it == nodes_by_name.end()) {
+        continue;
+      }
+      if (!cycle_map.emplace(it->second, stage.stage()).second) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Schedule hint for `%s` has node `%s` twice",
+                            hint.function(), timed_node.node()));
+      }
+    }
+  }
+  return cycle_map;
+}
+
+std::vector<SchedulingConstraint> PinHintedNodes(
+    FunctionBase* f, const ScheduleCycleMap& hinted_cycles,
+    std::optional<int64_t> pipeline_stages) {
+  auto matched = [&](Node* node) { return hinted_cycles.contains(node); };
+  std::vector<SchedulingConstraint> constraints;
+  for (Node* node : f->nodes()) {
+    auto it = hinted_cycles.find(node);
+    if (it == hinted_cycles.end() ||
+        (pipeline_stages.has_value() && it->second >= *pipeline_stages) ||
+        !absl::c_all_of(node->operands(), matched) ||
+        !absl::c_all_of(node->users(), matched)) {
+      continue;
+    }
+    constraints.push_back(NodeInCycleConstraint(node, it->second));
+  }
+  return constraints;
+}
+
+}  // namespace xls
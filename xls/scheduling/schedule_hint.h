@@ -0,0 +1,47 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SCHEDULING_SCHEDULE_HINT_H_
+#define XLS_SCHEDULING_SCHEDULE_HINT_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/function_base.h"
+#include "xls/scheduling/pipeline_schedule.pb.h"
+#include "xls/scheduling/scheduling_options.h"
+
+namespace xls {
+
+// Returns the cycles `hint`, a schedule of an earlier version of `f`, gives the
+// nodes of `f`. Nodes are matched by name; nodes of `f` missing from the hint
+// (e.g. added since) are left out of the result, as are nodes of the hint
+// missing from `f`.
+absl::StatusOr<ScheduleCycleMap> MatchScheduleHint(
+    FunctionBase* f, const PipelineScheduleProto& hint);
+
+// Returns constraints keeping the nodes of `f` away from the changes since the
+// hinted schedule `hinted_cycles` (as returned by MatchScheduleHint) in their
+// hinted cycles. A node is away from the changes if it and all of its operands
+// and users were matched; nodes hinted at later cycles than `pipeline_stages`
+// allows are not pinned.
+std::vector<SchedulingConstraint> PinHintedNodes(
+    FunctionBase* f, const ScheduleCycleMap& hinted_cycles,
+    std::optional<int64_t> pipeline_stages);
+
+}  // namespace xls
+
+#endif  // XLS_SCHEDULING_SCHEDULE_HINT_H_
@@ -0,0 +1,107 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/scheduling/schedule_hint.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/source_location.h"
+#include "xls/scheduling/pipeline_schedule.pb.h"
+#include "xls/scheduling/scheduling_options.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+class ScheduleHintTest : public IrTestBase {};
+
+void AddHintedNode(PipelineScheduleProto& hint, int64_t stage,
+                   std::string_view name) {
+  while (hint.stages_size() <= stage) {
+    int64_t next_stage = hint.stages_size();
+    hint.add_stages()->set_stage(next_stage);
+  }
+  hint.mutable_stages(stage)->add_timed_nodes()->set_node(name);
+}
+
+TEST_F(ScheduleHintTest, MatchByName) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue a = fb.Not(x, SourceInfo(), "a");
+  BValue b = fb.Negate(a, SourceInfo(), "b");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  PipelineScheduleProto hint;
+  hint.set_function(f->name());
+  AddHintedNode(hint, 0, "x");
+  AddHintedNode(hint, 1, "a");
+  AddHintedNode(hint, 1, "removed");
+  XLS_ASSERT_OK_AND_ASSIGN(ScheduleCycleMap cycles, MatchScheduleHint(f, hint));
+  EXPECT_THAT(cycles,
+              UnorderedElementsAre(Pair(x.node(), 0), Pair(a.node(), 1)));
+  EXPECT_FALSE(cycles.contains(b.node()));
+
+  AddHintedNode(hint, 2, "a");
+  EXPECT_THAT(MatchScheduleHint(f, hint),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("has node `a` twice")));
+}
+
+TEST_F(ScheduleHintTest, PinNodesAwayFromChanges) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue a = fb.Not(x, SourceInfo(), "a");
+  BValue b = fb.Not(a, SourceInfo(), "b");
+  BValue c = fb.Negate(b, SourceInfo(), "c");
+  fb.Negate(c, SourceInfo(), "added");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  ScheduleCycleMap hinted_cycles = {
+      {x.node(), 0}, {a.node(), 0}, {b.node(), 1}, {c.node(), 2}};
+  std::vector<Node*> pinned;
+  for (const SchedulingConstraint& constraint :
+       PinHintedNodes(f, hinted_cycles, /*pipeline_stages=*/std::nullopt)) {
+    const auto& node_in_cycle = std::get<NodeInCycleConstraint>(constraint);
+    EXPECT_EQ(node_in_cycle.GetCycle(),
+              hinted_cycles.at(node_in_cycle.GetNode()));
+    pinned.push_back(node_in_cycle.GetNode());
+  }
+  // `c` is used by the added node.
+  EXPECT_THAT(pinned, UnorderedElementsAre(x.node(), a.node(), b.node()));
+
+  // `b` is hinted at a stage past the end of the pipeline.
+  EXPECT_EQ(PinHintedNodes(f, hinted_cycles, /*pipeline_stages=*/1).size(), 2);
+}
+
+}  // namespace
+}  // namespace xls
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <limits>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -25,10 +26,12 @@
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
+#include "xls/common/file/filesystem.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/estimators/delay_model/delay_estimators.h"
 #include "xls/ir/package.h"
+#include "xls/scheduling/pipeline_schedule.pb.h"
 #include "xls/tools/scheduling_options_flags.pb.h"
 
 namespace xls {
@@ -56,6 +59,23 @@ absl::StatusOr<SchedulingOptions> OptionsFromFlagProto(
     scheduling_options.period_relaxation_percent(
         proto.period_relaxation_percent());
   }
+  if (proto.flop_relaxation_percent() != 0) {
+    scheduling_options.flop_relaxation_percent(proto.flop_relaxation_percent());
+  }
+  if (proto.clock_search_parallelism() > 1) {
+    scheduling_options.clock_search_parallelism(
+        proto.clock_search_parallelism());
+  }
+  if (proto.max_partition_size() != 0) {
+    scheduling_options.max_partition_size(proto.max_partition_size());
+  }
+  if (!proto.schedule_hint_path().empty()) {
+    PackagePipelineSchedulesProto schedule_hint;
+    XLS_RETURN_IF_ERROR(
+        ParseTextProtoFile(proto.schedule_hint_path(), &schedule_hint));
+    scheduling_options.schedule_hint(std::move(schedule_hint));
+  }
+  scheduling_options.pin_schedule_hint(proto.pin_schedule_hint());
   scheduling_options.minimize_clock_on_failure(
       proto.minimize_clock_on_failure());
   scheduling_options.recover_after_minimizing_clock(
@@ -65,6 +85,10 @@ absl::StatusOr<SchedulingOptions> OptionsFromFlagProto(
   }
   scheduling_options.minimize_worst_case_throughput(
       proto.minimize_worst_case_throughput());
+  if (proto.proc_replication_factor() > 1) {
+    scheduling_options.proc_replication_factor(
+        proto.proc_replication_factor());
+  }
   if (proto.additional_input_delay_ps() != 0) {
     scheduling_options.additional_input_delay_ps(
         proto.additional_input_delay_ps());
@@ -19,6 +19,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -30,6 +31,7 @@
 #include "xls/ir/node.h"
 #include "xls/ir/package.h"
 #include "xls/passes/optimization_pass.h"
+#include "xls/scheduling/pipeline_schedule.pb.h"
 #include "xls/tools/scheduling_options_flags.pb.h"
 
 namespace xls {
@@ -235,6 +237,8 @@ class SchedulingOptions {
       SchedulingStrategy strategy = SchedulingStrategy::SDC)
       : strategy_(strategy),
         opt_level_(kMaxOptLevel),
+        clock_search_parallelism_(1),
+        pin_schedule_hint_(false),
         minimize_clock_on_failure_(true),
         recover_after_minimizing_clock_(false),
         minimize_worst_case_throughput_(false),
@@ -304,6 +308,60 @@ class SchedulingOptions {
     return period_relaxation_percent_;
   }
 
+  // Sets/gets the percentage by which the SDC scheduler may lengthen the clock
+  // period it schedules for, if that lowers the pipeline flop count after
+  // codegen merges registers (see PipelineSchedule::CountFinalPipelineFlops).
+  // The clock period never goes past the one given by clock_period_ps.
+  SchedulingOptions& flop_relaxation_percent(int64_t value) {
+    flop_relaxation_percent_ = value;
+    return *this;
+  }
+  std::optional<int64_t> flop_relaxation_percent() const {
+    return flop_relaxation_percent_;
+  }
+
+  // Sets/gets the number of clock periods probed at once, each on its own
+  // thread, when searching for the minimum feasible clock period.
+  SchedulingOptions& clock_search_parallelism(int64_t value) {
+    clock_search_parallelism_ = value;
+    return *this;
+  }
+  int64_t clock_search_parallelism() const { return clock_search_parallelism_; }
+
+  // Sets/gets the size above which functions are scheduled by recursively
+  // cutting them at stage boundaries and scheduling the parts in parallel (see
+  // PartitionedMinCutScheduler) rather than with the chosen strategy. Parts are
+  // scheduled in parallel until they have at most this many nodes.
+  SchedulingOptions& max_partition_size(int64_t value) {
+    max_partition_size_ = value;
+    return *this;
+  }
+  std::optional<int64_t> max_partition_size() const {
+    return max_partition_size_;
+  }
+
+  // Sets/gets schedules of an earlier version of the package, as written by
+  // --output_schedule_path, to start from when scheduling. A function or proc
+  // keeps its hinted schedule if that is still a valid schedule of it (e.g.
+  // when it is unchanged); see also pin_schedule_hint.
+  SchedulingOptions& schedule_hint(PackagePipelineSchedulesProto value) {
+    schedule_hint_ = std::move(value);
+    return *this;
+  }
+  const std::optional<PackagePipelineSchedulesProto>& schedule_hint() const {
+    return schedule_hint_;
+  }
+
+  // Sets/gets whether the SDC scheduler keeps the nodes away from the changes
+  // since the schedule hint in their hinted cycles, so that small edits to the
+  // IR only move nearby nodes. Falls back to scheduling without pinning if
+  // that is infeasible.
+  SchedulingOptions& pin_schedule_hint(bool value) {
+    pin_schedule_hint_ = value;
+    return *this;
+  }
+  bool pin_schedule_hint() const { return pin_schedule_hint_; }
+
   // Sets/gets whether to report the fastest feasible clock if scheduling is
   // infeasible at the user's specified clock.
   SchedulingOptions& minimize_clock_on_failure(bool value) {
@@ -344,6 +402,19 @@ class SchedulingOptions {
     return worst_case_throughput_;
   }
 
+  // Sets/gets the number of copies of the top proc to build, each handling
+  // every Nth transaction in turn, so that a proc whose state feedback limits
+  // it to one transaction every N cycles accepts one every cycle at N times
+  // the area. Requires scheduling every proc in the package; see
+  // ProcReplicationPass for the requirements on the proc.
+  SchedulingOptions& proc_replication_factor(int64_t value) {
+    proc_replication_factor_ = value;
+    return *this;
+  }
+  std::optional<int64_t> proc_replication_factor() const {
+    return proc_replication_factor_;
+  }
+
   // Sets/gets the additional delay added to each input.
   //
   // TODO(tedhong): 2022-02-11, Update so that this sets/gets the
@@ -542,10 +613,16 @@ class SchedulingOptions {
   std::optional<int64_t> pipeline_stages_;
   std::optional<int64_t> clock_margin_percent_;
   std::optional<int64_t> period_relaxation_percent_;
+  std::optional<int64_t> flop_relaxation_percent_;
+  int64_t clock_search_parallelism_;
+  std::optional<int64_t> max_partition_size_;
+  std::optional<PackagePipelineSchedulesProto> schedule_hint_;
+  bool pin_schedule_hint_;
   bool minimize_clock_on_failure_;
   bool recover_after_minimizing_clock_;
   bool minimize_worst_case_throughput_;
   std::optional<int64_t> worst_case_throughput_;
+  std::optional<int64_t> proc_replication_factor_;
   std::optional<int64_t> additional_input_delay_ps_;
   std::optional<int64_t> additional_output_delay_ps_;
   std::optional<int64_t> ffi_fallback_delay_ps_;
@@ -57,6 +57,11 @@ class SchedulingUnit {
   int64_t GetNodeCount() const { return ir_->GetNodeCount(); }
 
   Package* GetPackage() const { return ir_; }
+  // Returns true if the unit operates on every function and proc in the
+  // package, including those added by scheduling passes.
+  bool IsWholePackage() const {
+    return std::holds_alternative<Package*>(schedulable_unit_);
+  }
   // Gets list of FunctionBases to be operated on by scheduling passes.
   absl::StatusOr<std::vector<FunctionBase*>> GetSchedulableFunctions() const;
   // Returns true if every function in `GetSchedulableFunctions()` has a
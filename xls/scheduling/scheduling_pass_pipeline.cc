@@ -25,6 +25,7 @@
 #include "xls/passes/optimization_pass_pipeline.h"
 #include "xls/scheduling/mutual_exclusion_pass.h"
 #include "xls/scheduling/pipeline_scheduling_pass.h"
+#include "xls/scheduling/proc_replication_pass.h"
 #include "xls/scheduling/proc_state_legalization_pass.h"
 #include "xls/scheduling/scheduling_checker.h"
 #include "xls/scheduling/scheduling_pass.h"
@@ -38,6 +39,10 @@ std::unique_ptr<SchedulingCompoundPass> CreateSchedulingPassPipeline(
       "scheduling", "Top level scheduling pass pipeline");
   top->AddInvariantChecker<SchedulingChecker>();
 
+  // Replicate the top proc, if requested, before anything else so the copies
+  // go through the rest of the pipeline.
+  top->Add<ProcReplicationPass>();
+
   // Make sure we have all of our state in the form of `next_value` nodes before
   // scheduling.
   top->Add<ProcStateLegalizationPass>();
@@ -24,6 +24,7 @@
 #include <variant>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
@@ -50,6 +51,7 @@
 #include "xls/ir/topo_sort.h"
 #include "xls/scheduling/scheduling_options.h"
 #include "ortools/math_opt/cpp/math_opt.h"
+#include "ortools/util/solve_interrupter.h"
 
 namespace xls {
 
@@ -61,10 +63,13 @@ namespace math_opt = ::operations_research::math_opt;
 // A helper function to compute each node's delay by calling the delay estimator
 absl::StatusOr<DelayMap> ComputeNodeDelays(
     FunctionBase* f, const DelayEstimator& delay_estimator) {
+  std::vector<Node*> nodes(f->nodes().begin(), f->nodes().end());
+  XLS_ASSIGN_OR_RETURN(std::vector<int64_t> delays,
+                       delay_estimator.GetOperationDelaysInPs(nodes));
   DelayMap result;
-  for (Node* node : f->nodes()) {
-    XLS_ASSIGN_OR_RETURN(result[node],
-                         delay_estimator.GetOperationDelayInPs(node));
+  result.reserve(nodes.size());
+  for (int64_t i = 0; i < nodes.size(); ++i) {
+    result[nodes[i]] = delays[i];
   }
   return result;
 }
@@ -619,6 +624,18 @@ absl::StatusOr<int64_t> SDCSchedulingModel::ExtractPipelineLength(
   return static_cast<int64_t>(std::round(last_stage)) + 1;
 }
 
+int64_t SDCSchedulingModel::ExtractRegisterBits(
+    const operations_research::math_opt::VariableMap<double>& variable_values)
+    const {
+  int64_t register_bits = 0;
+  for (Node* node : topo_sort_) {
+    double lifetime = variable_values.at(lifetime_var_.at(node));
+    register_bits += node->GetType()->GetFlatBitCount() *
+                     static_cast<int64_t>(std::round(lifetime));
+  }
+  return register_bits;
+}
+
 absl::Status SDCSchedulingModel::AddSlackVariables(
     std::optional<double> infeasible_per_state_backedge_slack_pool) {
   if (infeasible_per_state_backedge_slack_pool.has_value()) {
@@ -995,10 +1012,11 @@ absl::Status SDCScheduler::BuildError(
                    math_opt::EnumToString(result.termination.reason)));
 }
 
-absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
+absl::StatusOr<math_opt::SolveResult> SDCScheduler::Solve(
     std::optional<int64_t> pipeline_stages, int64_t clock_period_ps,
-    SchedulingFailureBehavior failure_behavior, bool check_feasibility,
-    std::optional<int64_t> worst_case_throughput) {
+    bool check_feasibility, std::optional<int64_t> worst_case_throughput,
+    const operations_research::SolveInterrupter* interrupter) {
+  const math_opt::SolveArguments solve_arguments{.interrupter = interrupter};
   model_.SetClockPeriod(clock_period_ps);
   if (worst_case_throughput.has_value()) {
     XLS_RETURN_IF_ERROR(model_.SetWorstCaseThroughput(*worst_case_throughput));
@@ -1010,11 +1028,10 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
     model_.MinimizePipelineLength();
     XLS_ASSIGN_OR_RETURN(
         const math_opt::SolveResult result_with_minimized_pipeline_length,
-        solver_->Solve());
+        solver_->Solve(solve_arguments));
     if (result_with_minimized_pipeline_length.termination.reason !=
         math_opt::TerminationReason::kOptimal) {
-      return BuildError(result_with_minimized_pipeline_length,
-                        failure_behavior);
+      return result_with_minimized_pipeline_length;
     }
     XLS_ASSIGN_OR_RETURN(
         const int64_t min_pipeline_length,
@@ -1028,8 +1045,18 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
   } else {
     model_.SetObjective();
   }
+  return solver_->Solve(solve_arguments);
+}
 
-  XLS_ASSIGN_OR_RETURN(math_opt::SolveResult result, solver_->Solve());
+absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
+    std::optional<int64_t> pipeline_stages, int64_t clock_period_ps,
+    SchedulingFailureBehavior failure_behavior, bool check_feasibility,
+    std::optional<int64_t> worst_case_throughput,
+    const operations_research::SolveInterrupter* interrupter) {
+  XLS_ASSIGN_OR_RETURN(
+      math_opt::SolveResult result,
+      Solve(pipeline_stages, clock_period_ps, check_feasibility,
+            worst_case_throughput, interrupter));
   if (result.termination.reason == math_opt::TerminationReason::kOptimal ||
       (check_feasibility &&
        result.termination.reason == math_opt::TerminationReason::kFeasible)) {
@@ -1038,4 +1065,79 @@ absl::StatusOr<ScheduleCycleMap> SDCScheduler::Schedule(
   return BuildError(result, failure_behavior);
 }
 
+absl::StatusOr<std::vector<SDCSweepPoint>> SDCScheduler::Sweep(
+    absl::Span<const int64_t> clock_periods_ps,
+    absl::Span<const std::optional<int64_t>> pipeline_stages,
+    std::optional<int64_t> worst_case_throughput) {
+  // Visit the clock periods in order so that consecutive models differ in as
+  // few timing constraints as possible.
+  std::vector<int64_t> sorted_clock_periods_ps(clock_periods_ps.begin(),
+                                               clock_periods_ps.end());
+  absl::c_sort(sorted_clock_periods_ps);
+
+  std::vector<SDCSweepPoint> points;
+  for (int64_t clock_period_ps : sorted_clock_periods_ps) {
+    for (std::optional<int64_t> stages : pipeline_stages) {
+      XLS_ASSIGN_OR_RETURN(math_opt::SolveResult result,
+                           Solve(stages, clock_period_ps,
+                                 /*check_feasibility=*/false,
+                                 worst_case_throughput));
+      if (result.termination.reason ==
+              math_opt::TerminationReason::kInfeasible ||
+          result.termination.reason ==
+              math_opt::TerminationReason::kInfeasibleOrUnbounded) {
+        VLOG(2) << absl::StrFormat(
+            "Skipping infeasible sweep point: clock period %dps, %s stages",
+            clock_period_ps,
+            stages.has_value() ? absl::StrCat(*stages) : "minimal");
+        continue;
+      }
+      if (result.termination.reason != math_opt::TerminationReason::kOptimal) {
+        return BuildError(result, SchedulingFailureBehavior{
+                                      .explain_infeasibility = false});
+      }
+      XLS_ASSIGN_OR_RETURN(ScheduleCycleMap cycle_map,
+                           model_.ExtractResult(result.variable_values()));
+      XLS_ASSIGN_OR_RETURN(
+          int64_t pipeline_length,
+          model_.ExtractPipelineLength(result.variable_values()));
+      points.push_back(SDCSweepPoint{
+          .clock_period_ps = clock_period_ps,
+          .pipeline_stages = pipeline_length,
+          .register_bits = model_.ExtractRegisterBits(result.variable_values()),
+          .cycle_map = std::move(cycle_map),
+      });
+    }
+  }
+
+  // Keep the points which no other point matches or improves on in every
+  // dimension, and only the first of any identical points.
+  auto dominates = [](const SDCSweepPoint& a, const SDCSweepPoint& b) {
+    return a.clock_period_ps <= b.clock_period_ps &&
+           a.pipeline_stages <= b.pipeline_stages &&
+           a.register_bits <= b.register_bits;
+  };
+  std::vector<SDCSweepPoint> pareto_points;
+  for (int64_t i = 0; i < points.size(); ++i) {
+    bool dominated = false;
+    for (int64_t j = 0; j < points.size() && !dominated; ++j) {
+      if (i == j || !dominates(points[j], points[i])) {
+        continue;
+      }
+      dominated = !dominates(points[i], points[j]) || j < i;
+    }
+    if (!dominated) {
+      pareto_points.push_back(std::move(points[i]));
+    }
+  }
+  absl::c_stable_sort(pareto_points,
+                      [](const SDCSweepPoint& a, const SDCSweepPoint& b) {
+                        return std::make_pair(a.clock_period_ps,
+                                              a.pipeline_stages) <
+                               std::make_pair(b.clock_period_ps,
+                                              b.pipeline_stages);
+                      });
+  return pareto_points;
+}
+
 }  // namespace xls
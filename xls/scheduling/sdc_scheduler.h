@@ -32,6 +32,7 @@
 #include "xls/ir/node.h"
 #include "xls/scheduling/scheduling_options.h"
 #include "ortools/math_opt/cpp/math_opt.h"
+#include "ortools/util/solve_interrupter.h"
 
 namespace xls {
 
@@ -77,6 +78,12 @@ class SDCSchedulingModel {
       const operations_research::math_opt::VariableMap<double>& variable_values)
       const;
 
+  // Returns the total bit count of the values held in pipeline registers,
+  // counting a value once for each stage boundary it is live across.
+  int64_t ExtractRegisterBits(
+      const operations_research::math_opt::VariableMap<double>& variable_values)
+      const;
+
   absl::Status AddSlackVariables(
       std::optional<double> infeasible_per_state_backedge_slack_pool);
 
@@ -207,6 +214,16 @@ class SDCSchedulingModel {
   absl::flat_hash_map<IOConstraint, SlackPair> io_slack_;
 };
 
+// A schedule produced by a sweep over clock periods and pipeline lengths.
+struct SDCSweepPoint {
+  int64_t clock_period_ps;
+  int64_t pipeline_stages;
+  // Total bit count of the pipeline registers, see
+  // SDCSchedulingModel::ExtractRegisterBits.
+  int64_t register_bits;
+  ScheduleCycleMap cycle_map;
+};
+
 class SDCScheduler {
   using DelayMap = absl::flat_hash_map<Node*, int64_t>;
 
@@ -233,6 +250,9 @@ class SDCScheduler {
   // and the LP solver will merely attempt to show that the generated set of
   // constraints is feasible, rather than find an register-optimal schedule.
   //
+  // If `interrupter` is given and interrupted, the solve stops early and an
+  // error is returned.
+  //
   // References:
   //   - Cong, Jason, and Zhiru Zhang. "An efficient and versatile scheduling
   //   algorithm based on SDC formulation." 2006 43rd ACM/IEEE Design Automation
@@ -244,12 +264,36 @@ class SDCScheduler {
       std::optional<int64_t> pipeline_stages, int64_t clock_period_ps,
       SchedulingFailureBehavior failure_behavior,
       bool check_feasibility = false,
+      std::optional<int64_t> worst_case_throughput = std::nullopt,
+      const operations_research::SolveInterrupter* interrupter = nullptr);
+
+  // Schedules to minimize the total pipeline registers for every combination
+  // of the given clock periods and pipeline lengths, where std::nullopt stands
+  // for the smallest feasible pipeline length as in Schedule.
+  //
+  // The schedules are solved one after another on the same model, so only the
+  // timing constraints which differ between consecutive clock periods are
+  // edited and the solver is warm-started from the previous solution.
+  // Infeasible combinations are skipped.
+  //
+  // Returns the Pareto-optimal points over (clock period, pipeline stages,
+  // register bits), ordered by clock period and then by pipeline stages.
+  absl::StatusOr<std::vector<SDCSweepPoint>> Sweep(
+      absl::Span<const int64_t> clock_periods_ps,
+      absl::Span<const std::optional<int64_t>> pipeline_stages,
       std::optional<int64_t> worst_case_throughput = std::nullopt);
 
  private:
   SDCScheduler(FunctionBase* f, DelayMap delay_map);
   absl::Status Initialize();
 
+  // Sets up the model for the given parameters and solves it, returning the
+  // result of the last solve whether or not it is optimal.
+  absl::StatusOr<operations_research::math_opt::SolveResult> Solve(
+      std::optional<int64_t> pipeline_stages, int64_t clock_period_ps,
+      bool check_feasibility, std::optional<int64_t> worst_case_throughput,
+      const operations_research::SolveInterrupter* interrupter = nullptr);
+
   absl::Status BuildError(
       const operations_research::math_opt::SolveResult& result,
       SchedulingFailureBehavior failure_behavior);
@@ -0,0 +1,86 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "xls/scheduling/sdc_scheduler.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::FieldsAre;
+
+class SDCSchedulerTest : public IrTestBase {};
+
+TEST_F(SDCSchedulerTest, SweepReturnsParetoPoints) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue acc = x;
+  for (int64_t i = 0; i < 4; ++i) {
+    acc = fb.Add(acc, acc);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SDCScheduler> scheduler,
+                           SDCScheduler::Create(f, TestDelayEstimator()));
+  std::vector<int64_t> clock_periods_ps = {4, 1, 2};
+  std::vector<std::optional<int64_t>> pipeline_stages = {std::nullopt, 4};
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<SDCSweepPoint> points,
+                           scheduler->Sweep(clock_periods_ps, pipeline_stages));
+
+  // Fixing four stages is never better than the minimal pipeline length, and
+  // at 1ps it finds the same schedule.
+  EXPECT_THAT(points,
+              ElementsAre(FieldsAre(1, 4, 3 * 32, _), FieldsAre(2, 2, 32, _),
+                          FieldsAre(4, 1, 0, _)));
+  for (const SDCSweepPoint& point : points) {
+    for (Node* node : f->nodes()) {
+      EXPECT_LT(point.cycle_map.at(node), point.pipeline_stages);
+    }
+  }
+}
+
+TEST_F(SDCSchedulerTest, SweepSkipsInfeasiblePoints) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  fb.Add(fb.Add(x, x), x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<SDCScheduler> scheduler,
+                           SDCScheduler::Create(f, TestDelayEstimator()));
+  std::vector<int64_t> clock_periods_ps = {1, 2};
+  std::vector<std::optional<int64_t>> pipeline_stages = {1};
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<SDCSweepPoint> points,
+                           scheduler->Sweep(clock_periods_ps, pipeline_stages));
+  EXPECT_THAT(points, ElementsAre(FieldsAre(2, 1, 0, _)));
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,8 +14,13 @@
 
 #include "xls/simulation/module_simulator.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <cstdint>
+#include <filesystem>  // NOLINT
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
@@ -26,26 +31,38 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/log/vlog_is_on.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/codegen/flattening.h"
 #include "xls/codegen/module_signature.h"
 #include "xls/codegen/module_signature.pb.h"
+#include "xls/common/file/named_pipe.h"
+#include "xls/common/file/temp_directory.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
 #include "xls/ir/channel.pb.h"
+#include "xls/ir/format_preference.h"
+#include "xls/ir/number_parser.h"
 #include "xls/ir/value.h"
 #include "xls/ir/xls_type.pb.h"
 #include "xls/simulation/module_testbench.h"
 #include "xls/simulation/module_testbench_thread.h"
 #include "xls/simulation/testbench_signal_capture.h"
+#include "xls/simulation/testbench_stream.h"
+#include "xls/simulation/verilog_include.h"
+#include "xls/simulation/verilog_simulator.h"
 #include "xls/tools/eval_utils.h"
 
 namespace xls {
@@ -292,6 +309,37 @@ absl::StatusOr<const BlockPortMappingProto*> BlockPortMappingForModule(
   return &*iter;
 }
 
+// Runs a batch of value inputs through `run_bits`, which simulates the module
+// with the given `signature` on inputs converted to bits. Returns the value of
+// the (single) output of the module for each input.
+absl::StatusOr<std::vector<Value>> RunBatchedOnValues(
+    const ModuleSignature& signature,
+    absl::Span<const absl::flat_hash_map<std::string, Value>> inputs,
+    absl::FunctionRef<absl::StatusOr<std::vector<ModuleSimulator::BitsMap>>(
+        absl::Span<const ModuleSimulator::BitsMap>)>
+        run_bits) {
+  std::vector<ModuleSimulator::BitsMap> bits_inputs;
+  bits_inputs.reserve(inputs.size());
+  for (const auto& input : inputs) {
+    XLS_RETURN_IF_ERROR(signature.ValidateInputs(input));
+    bits_inputs.push_back(ValueMapToBitsMap(input));
+  }
+  XLS_ASSIGN_OR_RETURN(std::vector<ModuleSimulator::BitsMap> bits_outputs,
+                       run_bits(bits_inputs));
+  XLS_RET_CHECK_EQ(signature.data_outputs().size(), 1);
+  std::vector<Value> outputs;
+  outputs.reserve(bits_outputs.size());
+  for (const ModuleSimulator::BitsMap& bits_output : bits_outputs) {
+    XLS_RET_CHECK_EQ(bits_output.size(), 1);
+    XLS_ASSIGN_OR_RETURN(
+        Value output,
+        UnflattenBitsToValue(bits_output.begin()->second,
+                             signature.data_outputs().begin()->type()));
+    outputs.push_back(std::move(output));
+  }
+  return outputs;
+}
+
 }  // namespace
 
 std::vector<DutInput> ModuleSimulator::DeassertControlSignals() const {
@@ -520,26 +568,346 @@ absl::StatusOr<Value> ModuleSimulator::RunFunction(
 
 absl::StatusOr<std::vector<Value>> ModuleSimulator::RunBatched(
     absl::Span<const absl::flat_hash_map<std::string, Value>> inputs) const {
-  std::vector<BitsMap> bits_inputs;
-  for (const auto& input : inputs) {
-    XLS_RETURN_IF_ERROR(signature_.ValidateInputs(input));
-    bits_inputs.push_back(ValueMapToBitsMap(input));
+  return RunBatchedOnValues(signature_, inputs,
+                            [this](absl::Span<const BitsMap> bits_inputs) {
+                              return RunBatched(bits_inputs);
+                            });
+}
+
+absl::StatusOr<std::vector<ModuleSimulator::BitsMap>>
+ModuleSimulator::RunBatchedSharded(absl::Span<const BitsMap> inputs,
+                                   int64_t shard_count) const {
+  XLS_RET_CHECK_GT(shard_count, 0);
+  const ModuleSignatureProto& proto = signature_.proto();
+  if (!proto.has_combinational() && !proto.has_fixed_latency() &&
+      !proto.has_pipeline()) {
+    // Other interfaces may carry state from one input to the next.
+    return RunBatched(inputs);
   }
-  XLS_ASSIGN_OR_RETURN(std::vector<BitsMap> bits_outputs,
-                       RunBatched(bits_inputs));
-  CHECK_EQ(signature_.data_outputs().size(), 1);
-  std::vector<Value> outputs;
-  for (const BitsMap& bits_output : bits_outputs) {
-    XLS_RET_CHECK_EQ(bits_output.size(), 1);
+  const int64_t input_count = inputs.size();
+  shard_count = std::min(shard_count, input_count);
+  if (shard_count <= 1) {
+    return RunBatched(inputs);
+  }
+
+  // Shard i holds the inputs [i * input_count / shard_count,
+  // (i + 1) * input_count / shard_count).
+  std::vector<absl::StatusOr<std::vector<BitsMap>>> shard_outputs(
+      shard_count, std::vector<BitsMap>());
+  std::vector<std::unique_ptr<Thread>> threads;
+  threads.reserve(shard_count);
+  for (int64_t shard = 0; shard < shard_count; ++shard) {
+    int64_t begin = shard * input_count / shard_count;
+    int64_t end = (shard + 1) * input_count / shard_count;
+    absl::Span<const BitsMap> shard_inputs = inputs.subspan(begin, end - begin);
+    threads.push_back(
+        std::make_unique<Thread>([this, &shard_outputs, shard, shard_inputs]() {
+          shard_outputs[shard] = RunBatched(shard_inputs);
+        }));
+  }
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+
+  std::vector<BitsMap> outputs;
+  outputs.reserve(input_count);
+  for (absl::StatusOr<std::vector<BitsMap>>& shard_output : shard_outputs) {
+    XLS_RETURN_IF_ERROR(shard_output.status());
+    absl::c_move(*shard_output, std::back_inserter(outputs));
+  }
+  return outputs;
+}
+
+absl::StatusOr<std::vector<Value>> ModuleSimulator::RunBatchedSharded(
+    absl::Span<const absl::flat_hash_map<std::string, Value>> inputs,
+    int64_t shard_count) const {
+  return RunBatchedOnValues(
+      signature_, inputs, [&](absl::Span<const BitsMap> bits_inputs) {
+        return RunBatchedSharded(bits_inputs, shard_count);
+      });
+}
+
+// Opens and closes the given named pipes, which unblocks any pending open of
+// the other end of them. Used when the simulator exits (or fails to start) to
+// keep the session from waiting forever to connect to it.
+static void UnblockPipeOpens(absl::Span<const NamedPipe> pipes) {
+  for (const NamedPipe& pipe : pipes) {
+    int fd = open(pipe.path().c_str(), O_RDWR | O_NONBLOCK);
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+absl::StatusOr<std::unique_ptr<ModuleSimulationSession>>
+ModuleSimulator::StartSession() const {
+  const ModuleSignatureProto& proto = signature_.proto();
+  if (!proto.has_combinational() && !proto.has_fixed_latency() &&
+      !proto.has_pipeline()) {
+    return absl::UnimplementedError(absl::StrCat(
+        "Unsupported interface for a simulation session: ",
+        proto.interface_oneof_case()));
+  }
+  for (const PortProto& port : signature_.data_inputs()) {
+    if (port.width() == 0) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Zero-width data port `%s` is not supported in a simulation session",
+          port.name()));
+    }
+  }
+  for (const PortProto& port : signature_.data_outputs()) {
+    if (port.width() == 0) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Zero-width data port `%s` is not supported in a simulation session",
+          port.name()));
+    }
+  }
+
+  // The testbench runs until its input streams are closed, so it has no cycle
+  // limit.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<ModuleTestbench> tb,
+                       ModuleTestbench::CreateFromVerilogText(
+                           verilog_text_, file_type_, signature_, simulator_,
+                           /*reset_dut=*/true, includes_,
+                           /*simulation_cycle_limit=*/std::nullopt));
+  std::vector<const TestbenchStream*> input_streams;
+  for (const PortProto& port : signature_.data_inputs()) {
     XLS_ASSIGN_OR_RETURN(
-        Value output,
-        UnflattenBitsToValue(bits_output.begin()->second,
-                             signature_.data_outputs().begin()->type()));
-    outputs.push_back(std::move(output));
+        input_streams.emplace_back(),
+        tb->CreateInputStream(absl::StrCat(port.name(), "_in"), port.width()));
   }
+  std::vector<const TestbenchStream*> output_streams;
+  for (const PortProto& port : signature_.data_outputs()) {
+    XLS_ASSIGN_OR_RETURN(output_streams.emplace_back(),
+                         tb->CreateOutputStream(absl::StrCat(port.name(),
+                                                             "_out"),
+                                                port.width(), /*flush=*/true));
+  }
+
+  std::vector<DutInput> dut_inputs = DeassertControlSignals();
+  for (const PortProto& port : signature_.data_inputs()) {
+    dut_inputs.push_back(DutInput{port.name(), IsX()});
+  }
+  XLS_ASSIGN_OR_RETURN(ModuleTestbenchThread * tbt,
+                       tb->CreateThread("stream driver", dut_inputs));
+  SequentialBlock& seq_block = tbt->MainBlock();
+  int64_t padding = 0;
+  if (proto.has_pipeline()) {
+    padding = proto.pipeline().latency();
+    if (proto.pipeline().has_pipeline_control()) {
+      const PipelineControl& pipeline_control =
+          proto.pipeline().pipeline_control();
+      if (pipeline_control.has_manual()) {
+        seq_block.Set(pipeline_control.manual().input_name(),
+                      Bits::AllOnes(padding));
+      }
+      if (pipeline_control.has_valid()) {
+        seq_block.Set(pipeline_control.valid().input_name(), 1);
+      }
+    }
+  }
+
+  // Each iteration reads one input vector and writes one output vector. For
+  // pipelines, the outputs written are those of the input vector `latency`
+  // iterations earlier.
+  SequentialBlock& loop = seq_block.RepeatForever();
+  for (int64_t i = 0; i < input_streams.size(); ++i) {
+    loop.ReadFromStreamAndSet(signature_.data_inputs()[i].name(),
+                              input_streams[i]);
+  }
+  if (proto.has_fixed_latency()) {
+    loop.AdvanceNCycles(proto.fixed_latency().latency());
+  }
+  EndOfCycleEvent& event = loop.AtEndOfCycle();
+  for (int64_t i = 0; i < output_streams.size(); ++i) {
+    event.CaptureAndWriteToStream(signature_.data_outputs()[i].name(),
+                                  output_streams[i]);
+  }
+  if (proto.has_fixed_latency()) {
+    // The input data cannot be changed in the same cycle that the output is
+    // being read so hold for one more cycle while output is read.
+    loop.NextCycle();
+  }
+
+  std::string verilog_text = tb->GenerateVerilog();
+  VLOG(2) << "Session testbench:\n" << verilog_text;
+
+  XLS_ASSIGN_OR_RETURN(TempDirectory temp_dir, TempDirectory::Create());
+  std::vector<VerilogSimulator::MacroDefinition> macro_definitions;
+  std::vector<NamedPipe> pipes;
+  for (const TestbenchStream* stream : input_streams) {
+    std::filesystem::path path = temp_dir.path() / stream->name;
+    XLS_ASSIGN_OR_RETURN(NamedPipe pipe, NamedPipe::Create(path));
+    pipes.push_back(std::move(pipe));
+    macro_definitions.push_back(VerilogSimulator::MacroDefinition{
+        stream->path_macro_name, absl::StrFormat("\"%s\"", path.string())});
+  }
+  for (const TestbenchStream* stream : output_streams) {
+    std::filesystem::path path = temp_dir.path() / stream->name;
+    XLS_ASSIGN_OR_RETURN(NamedPipe pipe, NamedPipe::Create(path));
+    pipes.push_back(std::move(pipe));
+    macro_definitions.push_back(VerilogSimulator::MacroDefinition{
+        stream->path_macro_name, absl::StrFormat("\"%s\"", path.string())});
+  }
+
+  auto session = absl::WrapUnique(
+      new ModuleSimulationSession(signature_, std::move(temp_dir)));
+  session->padding_ = padding;
+  session->pending_discards_ = padding;
+  session->pipes_ = std::move(pipes);
+  ModuleSimulationSession* s = session.get();
+  session->simulation_thread_ = std::make_unique<Thread>(
+      [s, simulator = simulator_, file_type = file_type_,
+       verilog_text = std::move(verilog_text),
+       macro_definitions = std::move(macro_definitions),
+       includes = std::vector<VerilogInclude>(includes_.begin(),
+                                              includes_.end())]() {
+        absl::StatusOr<std::pair<std::string, std::string>> result =
+            simulator->Run(verilog_text, file_type, macro_definitions,
+                           includes);
+        VLOG(1) << "Simulation session ended: " << result.status();
+        {
+          absl::MutexLock lock(&s->mutex_);
+          s->simulation_result_ = std::move(result);
+        }
+        UnblockPipeOpens(s->pipes_);
+      });
+
+  // Connect to the streams in the order the testbench opens them.
+  for (int64_t i = 0; i < input_streams.size(); ++i) {
+    XLS_ASSIGN_OR_RETURN(session->input_writers_.emplace_back(),
+                         session->pipes_[i].OpenForWriting());
+  }
+  for (int64_t i = 0; i < output_streams.size(); ++i) {
+    XLS_ASSIGN_OR_RETURN(
+        session->output_readers_.emplace_back(),
+        session->pipes_[input_streams.size() + i].OpenForReading());
+  }
+  XLS_RETURN_IF_ERROR(session->CheckSimulationRunning());
+  return session;
+}
+
+ModuleSimulationSession::~ModuleSimulationSession() {
+  // Closing the input streams makes the testbench finish once it has read all
+  // inputs; closing the output streams keeps it from blocking on writes which
+  // are never read.
+  input_writers_.clear();
+  output_readers_.clear();
+  if (simulation_thread_ != nullptr) {
+    // In case the testbench is still waiting to open a stream.
+    UnblockPipeOpens(pipes_);
+    simulation_thread_->Join();
+  }
+}
+
+absl::Status ModuleSimulationSession::CheckSimulationRunning() const {
+  absl::MutexLock lock(&mutex_);
+  if (!simulation_result_.has_value()) {
+    return absl::OkStatus();
+  }
+  if (!simulation_result_->ok()) {
+    return simulation_result_->status();
+  }
+  return absl::InternalError(
+      absl::StrFormat("Verilog simulator exited unexpectedly:\n%s\n%s",
+                      (*simulation_result_)->first,
+                      (*simulation_result_)->second));
+}
+
+absl::StatusOr<std::vector<ModuleSimulationSession::BitsMap>>
+ModuleSimulationSession::RunBatched(absl::Span<const BitsMap> inputs) {
+  if (inputs.empty()) {
+    return std::vector<BitsMap>();
+  }
+  for (const BitsMap& input : inputs) {
+    XLS_RETURN_IF_ERROR(signature_.ValidateInputs(input));
+  }
+  XLS_RETURN_IF_ERROR(CheckSimulationRunning());
+  const int64_t batch_size = inputs.size();
+
+  // Feed each input stream from its own thread so that a stream whose pipe is
+  // full never holds up the others.
+  absl::Span<const PortProto> data_inputs = signature_.data_inputs();
+  std::vector<absl::Status> write_statuses(data_inputs.size());
+  std::vector<std::unique_ptr<Thread>> writer_threads;
+  for (int64_t port = 0; port < data_inputs.size(); ++port) {
+    writer_threads.push_back(std::make_unique<Thread>([&, port]() {
+      const std::string& name = data_inputs[port].name();
+      FileLineWriter& writer = *input_writers_[port];
+      for (int64_t i = 0; i < batch_size + padding_; ++i) {
+        const Bits& value = inputs[std::min(i, batch_size - 1)].at(name);
+        absl::Status status =
+            writer.WriteLine(BitsToString(value, FormatPreference::kPlainHex));
+        if (!status.ok()) {
+          write_statuses[port] = status;
+          return;
+        }
+      }
+      write_statuses[port] = writer.Flush();
+    }));
+  }
+
+  // The testbench writes the output streams in order for each input vector, so
+  // reading them in the same order cannot block it. All outputs of the batch
+  // are read even if some are invalid, as otherwise the testbench (and so the
+  // writers) could block on a full pipe.
+  absl::Span<const PortProto> data_outputs = signature_.data_outputs();
+  std::vector<BitsMap> outputs(batch_size);
+  absl::Status stream_status = absl::OkStatus();
+  absl::Status value_status = absl::OkStatus();
+  for (int64_t i = -pending_discards_; i < batch_size && stream_status.ok();
+       ++i) {
+    for (int64_t port = 0; port < data_outputs.size(); ++port) {
+      absl::StatusOr<std::optional<std::string>> line =
+          output_readers_[port]->ReadLine();
+      if (!line.ok()) {
+        stream_status = line.status();
+        break;
+      }
+      if (!line->has_value()) {
+        stream_status = absl::InternalError(absl::StrFormat(
+            "Output stream for port `%s` closed by the Verilog simulator",
+            data_outputs[port].name()));
+        break;
+      }
+      if (i < 0 || !value_status.ok()) {
+        continue;
+      }
+      absl::StatusOr<Bits> value = ParseUnsignedNumberWithoutPrefix(
+          **line, FormatPreference::kHex, data_outputs[port].width());
+      if (!value.ok()) {
+        value_status = absl::InvalidArgumentError(absl::StrFormat(
+            "Invalid value `%s` for output port `%s`: %s", **line,
+            data_outputs[port].name(), value.status().message()));
+        continue;
+      }
+      outputs[i][data_outputs[port].name()] = *std::move(value);
+    }
+  }
+  // If the simulator exited, the writers fail rather than block.
+  for (std::unique_ptr<Thread>& thread : writer_threads) {
+    thread->Join();
+  }
+  if (!stream_status.ok()) {
+    XLS_RETURN_IF_ERROR(CheckSimulationRunning());
+    return stream_status;
+  }
+  for (const absl::Status& status : write_statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  pending_discards_ = padding_;
+  XLS_RETURN_IF_ERROR(value_status);
   return outputs;
 }
 
+absl::StatusOr<std::vector<Value>> ModuleSimulationSession::RunBatched(
+    absl::Span<const absl::flat_hash_map<std::string, Value>> inputs) {
+  return RunBatchedOnValues(signature_, inputs,
+                            [this](absl::Span<const BitsMap> bits_inputs) {
+                              return RunBatched(bits_inputs);
+                            });
+}
+
 absl::StatusOr<std::string> ModuleSimulator::GenerateProcTestbenchVerilog(
     const absl::flat_hash_map<std::string, std::vector<Bits>>& channel_inputs,
     const absl::flat_hash_map<std::string, int64_t>& output_channel_counts,
@@ -20,13 +20,20 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xls/codegen/module_signature.h"
 #include "xls/codegen/vast/vast.h"
+#include "xls/common/file/named_pipe.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/thread.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/value.h"
 #include "xls/simulation/module_testbench.h"
@@ -76,6 +83,8 @@ struct ReadyValidHoldoffs {
   absl::flat_hash_map<std::string, std::vector<int64_t>> ready_holdoffs;
 };
 
+class ModuleSimulationSession;
+
 // Abstraction for simulating a module described by a SignatureProto using a
 // testbench run under the Verilog simulator.
 class ModuleSimulator {
@@ -107,15 +116,26 @@ class ModuleSimulator {
 
   // Runs the given batch of argument values through the module with a single
   // invocation of the Verilog simulator. Generally, this is much faster than
-  // running via separate calls to Run.
+  // running via separate calls to Run. For many batches, see StartSession.
   absl::StatusOr<std::vector<BitsMap>> RunBatched(
       absl::Span<const BitsMap> inputs) const;
 
+  // As RunBatched, but splits the batch into up to `shard_count` contiguous
+  // shards which are simulated by concurrent invocations of the Verilog
+  // simulator, and concatenates their outputs in input order. Only interfaces
+  // which carry no state from one input to the next (combinational, fixed
+  // latency and pipelined) can be sharded; others are run as a single batch.
+  absl::StatusOr<std::vector<BitsMap>> RunBatchedSharded(
+      absl::Span<const BitsMap> inputs, int64_t shard_count) const;
+
   // Overloads which accept Values rather than Bits.
   absl::StatusOr<Value> RunFunction(
       const absl::flat_hash_map<std::string, Value>& inputs) const;
   absl::StatusOr<std::vector<Value>> RunBatched(
       absl::Span<const absl::flat_hash_map<std::string, Value>> inputs) const;
+  absl::StatusOr<std::vector<Value>> RunBatchedSharded(
+      absl::Span<const absl::flat_hash_map<std::string, Value>> inputs,
+      int64_t shard_count) const;
 
   // Runs the given channel inputs and expects a number of values at an output
   // channel on the a design under test (DUT) derived from a proc.
@@ -135,6 +155,13 @@ class ModuleSimulator {
   // Runs a function with arguments as a Span.
   absl::StatusOr<Value> RunFunction(absl::Span<const Value> inputs) const;
 
+  // Compiles the module with a stream-driven testbench and starts a Verilog
+  // simulator process which runs batches of inputs until the returned session
+  // is destroyed. Only function interfaces (combinational, fixed latency and
+  // pipelined) with no zero-width data ports are supported.
+  absl::StatusOr<std::unique_ptr<ModuleSimulationSession>> StartSession()
+      const;
+
   // Returns the (System)Verilog testbench for testing the module with the given
   // inputs and expected outputs counts.
   absl::StatusOr<std::string> GenerateProcTestbenchVerilog(
@@ -166,6 +193,65 @@ class ModuleSimulator {
   absl::Span<const VerilogInclude> includes_;
 };
 
+// A running Verilog simulation of a function module, created by
+// ModuleSimulator::StartSession.
+//
+// ModuleSimulator::RunBatched generates a testbench with the batch of inputs
+// baked in, and compiles and runs it from scratch on every call. A session
+// instead compiles the module once, together with a generic testbench which
+// loops forever reading input vectors from named pipes and writing the outputs
+// to named pipes, and keeps the simulator process alive between batches.
+// After the one-time start-up, the cost per input vector is that of simulating
+// it plus writing and reading a line per data port.
+//
+// Pipelined modules are kept full: each batch is followed by `latency` copies
+// of its last input vector, whose outputs are discarded at the start of the
+// next batch.
+class ModuleSimulationSession {
+ public:
+  using BitsMap = ModuleSimulator::BitsMap;
+
+  // Closes the input streams, upon which the testbench terminates the
+  // simulation, and waits for the simulator process to exit.
+  ~ModuleSimulationSession();
+
+  // As ModuleSimulator::RunBatched.
+  absl::StatusOr<std::vector<BitsMap>> RunBatched(
+      absl::Span<const BitsMap> inputs);
+  absl::StatusOr<std::vector<Value>> RunBatched(
+      absl::Span<const absl::flat_hash_map<std::string, Value>> inputs);
+
+ private:
+  friend class ModuleSimulator;
+
+  ModuleSimulationSession(const ModuleSignature& signature,
+                          TempDirectory temp_dir)
+      : signature_(signature), temp_dir_(std::move(temp_dir)) {}
+
+  // Returns an error if the simulator process has exited.
+  absl::Status CheckSimulationRunning() const;
+
+  ModuleSignature signature_;
+
+  // The number of input vectors appended to each batch to push its last
+  // outputs out of the pipeline, and the number of output vectors to discard
+  // before those of the next batch.
+  int64_t padding_ = 0;
+  int64_t pending_discards_ = 0;
+
+  TempDirectory temp_dir_;
+  std::vector<NamedPipe> pipes_;
+  // One stream per data input and output port, in signature order.
+  std::vector<std::optional<FileLineWriter>> input_writers_;
+  std::vector<std::optional<FileLineReader>> output_readers_;
+
+  // Runs the simulator process.
+  std::unique_ptr<Thread> simulation_thread_;
+  mutable absl::Mutex mutex_;
+  std::optional<absl::StatusOr<std::pair<std::string, std::string>>>
+      simulation_result_ ABSL_GUARDED_BY(mutex_);
+};
+
 }  // namespace verilog
 }  // namespace xls
 
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -201,6 +202,53 @@ TEST_P(ModuleSimulatorCodegenTest, TripleNegatePipelineBatched) {
   }
 }
 
+TEST_P(ModuleSimulatorCodegenTest, TripleNegatePipelineSession) {
+  Package package(TestName());
+  FunctionBuilder fb("negate", &package);
+  auto x = fb.Param("x", package.GetBitsType(8));
+  fb.Negate(fb.Negate(fb.Negate(x)));
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, fb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      PipelineSchedule schedule,
+      RunPipelineSchedule(func, *delay_estimator_,
+                          SchedulingOptions().clock_period_ps(1)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ModuleGeneratorResult result,
+      ToPipelineModuleText(
+          schedule, func,
+          BuildPipelineOptions().use_system_verilog(UseSystemVerilog())));
+  ASSERT_EQ(result.signature.proto().pipeline().latency(), 4);
+
+  ModuleSimulator simulator =
+      NewModuleSimulator(result.verilog_text, result.signature);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModuleSimulationSession> session,
+                           simulator.StartSession());
+
+  // Run various size batches through the same simulator process, shorter and
+  // longer than the pipeline.
+  int64_t value = 0;
+  for (int64_t batch_size = 0; batch_size < 6; ++batch_size) {
+    std::vector<absl::flat_hash_map<std::string, Bits>> input_batches(
+        batch_size);
+    for (int64_t i = 0; i < batch_size; ++i) {
+      input_batches[i]["x"] = UBits((value + i) & 0xff, 8);
+    }
+    std::vector<absl::flat_hash_map<std::string, Bits>> outputs;
+    XLS_ASSERT_OK_AND_ASSIGN(outputs, session->RunBatched(input_batches));
+
+    EXPECT_EQ(outputs.size(), batch_size);
+    for (int64_t i = 0; i < batch_size; ++i) {
+      const absl::flat_hash_map<std::string, Bits>& output = outputs[i];
+      ASSERT_TRUE(output.contains("out"));
+      EXPECT_EQ(output.at("out"), UBits((-(value + i)) & 0xff, 8))
+          << "Batch size = " << batch_size << ", set " << i;
+    }
+    value += batch_size;
+  }
+}
+
 TEST_P(ModuleSimulatorCodegenTest, AddsWithSharedResource) {
   Package package(TestName());
   FunctionBuilder fb("x_plus_y_plus_z_plus_x", &package);
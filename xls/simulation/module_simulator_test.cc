@@ -15,6 +15,7 @@
 #include "xls/simulation/module_simulator.h"
 
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -27,6 +28,7 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/codegen/module_signature.h"
 #include "xls/codegen/verilog_line_map.pb.h"
 #include "xls/common/file/filesystem.h"
@@ -50,6 +52,7 @@ using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 using ::testing::Pair;
 
 constexpr char kTestName[] = "module_simulator_test";
@@ -410,6 +413,75 @@ TEST_P(ModuleSimulatorTest, CombinationalBatched) {
   EXPECT_THAT(outputs[2], ElementsAre(Pair("out", UBits(100, 8))));
 }
 
+TEST_P(ModuleSimulatorTest, FixedLatencyBatchedSharded) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto verilog_signature, MakeFixedLatencyModule());
+  ModuleSimulator simulator =
+      NewModuleSimulator(verilog_signature.first, verilog_signature.second);
+
+  using BitsMap = ModuleSimulator::BitsMap;
+  std::vector<BitsMap> inputs;
+  for (int64_t i = 0; i < 10; ++i) {
+    inputs.push_back(BitsMap{{"x", UBits(i, 8)}});
+  }
+  // More shards than inputs are clamped to one input per shard.
+  for (int64_t shard_count : {1, 3, 4, 20}) {
+    XLS_ASSERT_OK_AND_ASSIGN(std::vector<BitsMap> outputs,
+                             simulator.RunBatchedSharded(inputs, shard_count));
+    ASSERT_EQ(outputs.size(), inputs.size());
+    for (int64_t i = 0; i < inputs.size(); ++i) {
+      EXPECT_THAT(outputs[i], ElementsAre(Pair("out", UBits(2 * i, 8))))
+          << "shard_count = " << shard_count << ", input " << i;
+    }
+  }
+  EXPECT_THAT(simulator.RunBatchedSharded(absl::Span<const BitsMap>(), 4),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST_P(ModuleSimulatorTest, FixedLatencySession) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto verilog_signature, MakeFixedLatencyModule());
+  ModuleSimulator simulator =
+      NewModuleSimulator(verilog_signature.first, verilog_signature.second);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModuleSimulationSession> session,
+                           simulator.StartSession());
+
+  using BitsMap = ModuleSimulator::BitsMap;
+  EXPECT_THAT(
+      session->RunBatched(
+          {BitsMap{{"x", UBits(44, 8)}}, BitsMap{{"x", UBits(123, 8)}}}),
+      IsOkAndHolds(ElementsAre(ElementsAre(Pair("out", UBits(88, 8))),
+                               ElementsAre(Pair("out", UBits(246, 8))))));
+  EXPECT_THAT(
+      session->RunBatched({BitsMap{{"x", UBits(7, 8)}}}),
+      IsOkAndHolds(ElementsAre(ElementsAre(Pair("out", UBits(14, 8))))));
+}
+
+TEST_P(ModuleSimulatorTest, CombinationalSession) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto verilog_signature, MakeCombinationalModule());
+  ModuleSimulator simulator =
+      NewModuleSimulator(verilog_signature.first, verilog_signature.second);
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<ModuleSimulationSession> session,
+                           simulator.StartSession());
+
+  // Enough vectors to fill the pipes between the processes several times.
+  using BitsMap = ModuleSimulator::BitsMap;
+  constexpr int64_t kBatchSize = 50000;
+  for (int64_t batch = 0; batch < 2; ++batch) {
+    std::vector<BitsMap> inputs;
+    for (int64_t i = 0; i < kBatchSize; ++i) {
+      inputs.push_back(BitsMap{{"x", UBits((i + batch) & 0xff, 8)},
+                               {"y", UBits(i / 256 & 0xff, 8)}});
+    }
+    XLS_ASSERT_OK_AND_ASSIGN(std::vector<BitsMap> outputs,
+                             session->RunBatched(inputs));
+    ASSERT_EQ(outputs.size(), kBatchSize);
+    for (int64_t i = 0; i < kBatchSize; ++i) {
+      EXPECT_THAT(outputs[i],
+                  ElementsAre(Pair("out", UBits((i + batch - i / 256) & 0xff,
+                                                8))));
+    }
+  }
+}
+
 TEST_P(ModuleSimulatorTest, ReadyValidBatched) {
   XLS_ASSERT_OK_AND_ASSIGN(auto verilog_signature, MakeReadyValidModule());
   ModuleSimulator simulator =
@@ -329,102 +329,9 @@ ExtractSignalValues(std::string_view stdout_str) {
   return parsed_values;
 }
 
-// Writes the captured sequence of values of the given signal/instance into the
-// given Bits vector. `outputs` is index by instance_id as returned by
-// `ExtractSignalValues`.
-static absl::Status RecordCapturedBitsVector(
-    std::string_view signal_name, int64_t instance_id,
-    const absl::flat_hash_map<int64_t, std::vector<BitsOrX>>& outputs,
-    std::vector<Bits>* bits_vector) {
-  bits_vector->clear();
-  if (outputs.contains(instance_id)) {
-    for (int64_t i = 0; i < outputs.at(instance_id).size(); ++i) {
-      const BitsOrX& output = outputs.at(instance_id)[i];
-      if (std::holds_alternative<IsX>(output)) {
-        return absl::NotFoundError(absl::StrFormat(
-            "Output `%s`, instance #%d, recurrence %d holds X value in "
-            "Verilog simulator output.",
-            signal_name, instance_id, i));
-      }
-      bits_vector->push_back(std::get<Bits>(output));
-    }
-  }
-  return absl::OkStatus();
-}
-
-// Writes the captured single value of the given signal/instance into the given
-// Bits. `outputs` is index by instance_id as returned by `ExtractSignalValues`.
-static absl::Status RecordCapturedBits(
-    std::string_view signal_name, int64_t instance_id,
-    const absl::flat_hash_map<int64_t, std::vector<BitsOrX>>& outputs,
-    Bits* bits) {
-  if (!outputs.contains(instance_id)) {
-    return absl::NotFoundError(absl::StrFormat(
-        "Output `%s`, instance #%d not found in Verilog simulator output.",
-        signal_name, instance_id));
-  }
-  XLS_RET_CHECK_EQ(outputs.at(instance_id).size(), 1);
-  const BitsOrX& bits_or_x = outputs.at(instance_id).front();
-  // Write out module signal values to pointers passed in via Capture
-  // calls.
-  if (std::holds_alternative<IsX>(bits_or_x)) {
-    return absl::NotFoundError(
-        absl::StrFormat("Output `%s`, instance #%d holds X value in "
-                        "Verilog simulator output.",
-                        signal_name, instance_id));
-  }
-  *bits = std::get<Bits>(bits_or_x);
-  return absl::OkStatus();
-}
-
-// Checks all of the captured values of the given signal/instance against the
-// given expectation. `outputs` is index by instance_id as returned by
-// `ExtractSignalValues`.
-static absl::Status CheckCapturedSignalAgainstExpectation(
-    std::string_view signal_name, int64_t instance_id,
-    const TestbenchExpectation& expectation,
-    const absl::flat_hash_map<int64_t, std::vector<BitsOrX>>& outputs) {
-  // The captured signal may appear zero or more times in the output. Check
-  // every instance.
-  if (outputs.contains(instance_id)) {
-    auto get_source_location = [&]() {
-      return absl::StrFormat("%s@%d", expectation.loc.file_name(),
-                             expectation.loc.line());
-    };
-    for (int64_t i = 0; i < outputs.at(instance_id).size(); ++i) {
-      const BitsOrX& bits_or_x = outputs.at(instance_id)[i];
-      std::string instance_name =
-          absl::StrFormat("output `%s`, instance #%d, recurrence %d",
-                          signal_name, instance_id, i);
-      if (std::holds_alternative<Bits>(expectation.expected)) {
-        const Bits& expected_bits = std::get<Bits>(expectation.expected);
-        if (std::holds_alternative<IsX>(bits_or_x)) {
-          return absl::FailedPreconditionError(absl::StrFormat(
-              "%s: expected %s to have value: %v, has X", get_source_location(),
-              instance_name, expected_bits));
-        }
-        const Bits& actual_bits = std::get<Bits>(bits_or_x);
-        if (actual_bits != expected_bits) {
-          return absl::FailedPreconditionError(
-              absl::StrFormat("%s: expected %s to have value: %v, actual: %v",
-                              get_source_location(), instance_name,
-                              expected_bits, actual_bits));
-        }
-      } else {
-        CHECK(std::holds_alternative<IsX>(expectation.expected));
-        if (std::holds_alternative<Bits>(bits_or_x)) {
-          return absl::FailedPreconditionError(absl::StrFormat(
-              "%s: expected %s to have X value, has non X value: %v",
-              get_source_location(), instance_name, std::get<Bits>(bits_or_x)));
-        }
-      }
-    }
-  }
-  return absl::OkStatus();
-}
-
 absl::Status ModuleTestbench::CaptureOutputsAndCheckExpectations(
-    std::string_view stdout_str) const {
+    std::string_view stdout_str, SignalCaptureRecorder& recorder,
+    const absl::Status& capture_status) const {
   // Check for timeout.
   if (simulation_cycle_limit_.has_value() &&
       absl::StrContains(stdout_str,
@@ -434,36 +341,29 @@ absl::Status ModuleTestbench::CaptureOutputsAndCheckExpectations(
                         simulation_cycle_limit_.value()));
   }
 
-  absl::flat_hash_map<int64_t, std::vector<BitsOrX>> outputs;
-  XLS_ASSIGN_OR_RETURN(outputs, ExtractSignalValues(stdout_str));
-
-  for (const SignalCapture& signal_capture :
-       capture_manager_.signal_captures()) {
-    if (std::holds_alternative<const TestbenchStream*>(signal_capture.action)) {
-      continue;
-    }
-    if (std::holds_alternative<std::vector<Bits>*>(signal_capture.action)) {
-      // Capture multiple instances of the same signal.
-      XLS_RETURN_IF_ERROR(RecordCapturedBitsVector(
-          signal_capture.signal_name, signal_capture.instance_id, outputs,
-          std::get<std::vector<Bits>*>(signal_capture.action)));
-      continue;
-    }
-
-    if (std::holds_alternative<Bits*>(signal_capture.action)) {
-      // Capture a single instance of a signal.
-      XLS_RETURN_IF_ERROR(RecordCapturedBits(
-          signal_capture.signal_name, signal_capture.instance_id, outputs,
-          std::get<Bits*>(signal_capture.action)));
-      continue;
+  if (capture_stream_ != nullptr) {
+    // The captured values were applied as they were streamed.
+    XLS_RETURN_IF_ERROR(capture_status);
+    XLS_RETURN_IF_ERROR(recorder.CheckComplete());
+  } else {
+    absl::flat_hash_map<int64_t, std::vector<BitsOrX>> outputs;
+    XLS_ASSIGN_OR_RETURN(outputs, ExtractSignalValues(stdout_str));
+    for (const SignalCapture& signal_capture :
+         capture_manager_.signal_captures()) {
+      if (std::holds_alternative<const TestbenchStream*>(
+              signal_capture.action)) {
+        continue;
+      }
+      // The captured signal may appear zero or more times in the output.
+      if (auto it = outputs.find(signal_capture.instance_id);
+          it != outputs.end()) {
+        for (const BitsOrX& value : it->second) {
+          XLS_RETURN_IF_ERROR(
+              recorder.Record(signal_capture.instance_id, value));
+        }
+      }
+      XLS_RETURN_IF_ERROR(recorder.CheckComplete(signal_capture.instance_id));
     }
-
-    // Check the signal value against any expectations.
-    XLS_RET_CHECK(
-        std::holds_alternative<TestbenchExpectation>(signal_capture.action));
-    XLS_RETURN_IF_ERROR(CheckCapturedSignalAgainstExpectation(
-        signal_capture.signal_name, signal_capture.instance_id,
-        std::get<TestbenchExpectation>(signal_capture.action), outputs));
   }
 
   // Look for the expected trace messages in the simulation output.
@@ -554,13 +454,14 @@ std::string ModuleTestbench::GenerateVerilog() const {
 
   // Create emitters for emitting Verilog code for handling file I/O. Add any
   // declarations for handling IO to/from streams. And emit code to open files.
+  std::vector<const TestbenchStream*> streams = GetAllStreams();
   absl::flat_hash_map<std::string, VastStreamEmitter> stream_emitters;
-  if (!streams_.empty()) {
+  if (!streams.empty()) {
     m->Add<BlankLine>(SourceInfo());
     m->Add<Comment>(SourceInfo(),
                     "Variable declarations for supporting streaming I/O.");
     // Declare variables required for performing IO.
-    for (const std::unique_ptr<TestbenchStream>& stream : streams_) {
+    for (const TestbenchStream* stream : streams) {
       stream_emitters.insert(
           {stream->name, VastStreamEmitter::Create(*stream, m)});
     }
@@ -568,7 +469,7 @@ std::string ModuleTestbench::GenerateVerilog() const {
     m->Add<BlankLine>(SourceInfo());
     m->Add<Comment>(SourceInfo(), "Open files for I/O.");
     Initial* initial = m->Add<Initial>(SourceInfo());
-    for (const std::unique_ptr<TestbenchStream>& stream : streams_) {
+    for (const TestbenchStream* stream : streams) {
       stream_emitters.at(stream->name).EmitOpen(initial->statements());
     }
   }
@@ -662,7 +563,7 @@ std::string ModuleTestbench::GenerateVerilog() const {
         SourceInfo(), file.PlainLiteral(1, SourceInfo()));
 
     // Close any open files.
-    for (const std::unique_ptr<TestbenchStream>& stream : streams_) {
+    for (const TestbenchStream* stream : streams) {
       stream_emitters.at(stream->name).EmitClose(initial->statements());
     }
 
@@ -690,16 +591,7 @@ absl::Status ModuleTestbench::Run() const {
     return absl::InvalidArgumentError(
         "Testbenches with streaming IO should be run with RunWithStreamingIO");
   }
-  std::string verilog_text = GenerateVerilog();
-  XLS_VLOG_LINES(3, verilog_text);
-  std::pair<std::string, std::string> stdout_stderr;
-  XLS_ASSIGN_OR_RETURN(stdout_stderr,
-                       simulator_->Run(verilog_text, file_type_,
-                                       /*macro_definitions=*/{}, includes_));
-  VLOG(2) << "Verilog simulator stdout:\n" << stdout_stderr.first;
-  VLOG(2) << "Verilog simulator stderr:\n" << stdout_stderr.second;
-  const std::string& stdout_str = stdout_stderr.first;
-  return CaptureOutputsAndCheckExpectations(stdout_str);
+  return RunInternal(/*input_producers=*/{}, /*output_consumers=*/{});
 }
 
 absl::Status ModuleTestbench::RunWithStreamingIo(
@@ -716,6 +608,12 @@ absl::Status ModuleTestbench::RunWithStreamingIo(
         return absl::InvalidArgumentError(absl::StrFormat(
             "Missing producer for input stream `%s`", stream->name));
       }
+      if (stop_at_first_mismatch_) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Input stream `%s` cannot be used when stopping at the first "
+            "mismatch",
+            stream->name));
+      }
     } else {
       if (!output_consumers.contains(stream->name)) {
         return absl::InvalidArgumentError(absl::StrFormat(
@@ -728,46 +626,89 @@ absl::Status ModuleTestbench::RunWithStreamingIo(
         "Too many producers/consumers specified (%d). Expected %d.",
         input_producers.size() + output_consumers.size(), streams_.size()));
   }
+  return RunInternal(input_producers, output_consumers);
+}
 
+absl::Status ModuleTestbench::RunInternal(
+    const absl::flat_hash_map<std::string, TestbenchStreamThread::Producer>&
+        input_producers,
+    const absl::flat_hash_map<std::string, TestbenchStreamThread::Consumer>&
+        output_consumers) const {
   std::string verilog_text = GenerateVerilog();
   XLS_VLOG_LINES(3, verilog_text);
 
-  XLS_ASSIGN_OR_RETURN(TempDirectory temp_dir, TempDirectory::Create());
+  SignalCaptureRecorder recorder(capture_manager_.signal_captures());
+  auto record_line = [&recorder](std::string_view line) {
+    return recorder.RecordLine(line);
+  };
+
+  std::vector<const TestbenchStream*> streams = GetAllStreams();
+  std::optional<TempDirectory> temp_dir;
+  if (!streams.empty()) {
+    XLS_ASSIGN_OR_RETURN(temp_dir, TempDirectory::Create());
+  }
   std::vector<VerilogSimulator::MacroDefinition> macro_definitions;
 
   std::vector<TestbenchStreamThread> stream_threads;
-  stream_threads.reserve(streams_.size());
-  for (const std::unique_ptr<TestbenchStream>& stream : streams_) {
-    std::filesystem::path stream_path = temp_dir.path() / stream->name;
+  std::optional<TestbenchStreamThread> capture_thread;
+  stream_threads.reserve(streams.size());
+  for (const TestbenchStream* stream : streams) {
+    std::filesystem::path stream_path = temp_dir->path() / stream->name;
     XLS_ASSIGN_OR_RETURN(TestbenchStreamThread thread,
                          TestbenchStreamThread::Create(*stream, stream_path));
-    stream_threads.push_back(std::move(thread));
-    if (stream->direction == TestbenchStreamDirection::kInput) {
-      stream_threads.back().RunInputStream(input_producers.at(stream->name));
+    if (stream == capture_stream_.get()) {
+      capture_thread.emplace(std::move(thread));
+      capture_thread->RunOutputLines(record_line, stop_at_first_mismatch_);
     } else {
-      stream_threads.back().RunOutputStream(output_consumers.at(stream->name));
+      stream_threads.push_back(std::move(thread));
+      if (stream->direction == TestbenchStreamDirection::kInput) {
+        stream_threads.back().RunInputStream(input_producers.at(stream->name));
+      } else {
+        stream_threads.back().RunOutputStream(
+            output_consumers.at(stream->name));
+      }
     }
     macro_definitions.push_back(VerilogSimulator::MacroDefinition{
         stream->path_macro_name,
         absl::StrFormat("\"%s\"", stream_path.string())});
   }
   VLOG(1) << "Starting simulation.";
-  std::pair<std::string, std::string> stdout_stderr;
-  XLS_ASSIGN_OR_RETURN(
-      stdout_stderr,
-      simulator_->Run(verilog_text, file_type_, macro_definitions, includes_));
+  absl::StatusOr<std::pair<std::string, std::string>> stdout_stderr =
+      simulator_->Run(verilog_text, file_type_, macro_definitions, includes_);
 
   VLOG(1) << "Simulation done.";
 
+  absl::Status capture_status = absl::OkStatus();
+  if (capture_thread.has_value()) {
+    capture_status = capture_thread->Join();
+    // Closing the pipe at a mismatch may well have made the simulation fail,
+    // so the mismatch takes precedence.
+    if (!capture_status.ok() && stop_at_first_mismatch_) {
+      return capture_status;
+    }
+  }
+  XLS_RETURN_IF_ERROR(stdout_stderr.status());
+
   for (TestbenchStreamThread& thread : stream_threads) {
     XLS_RETURN_IF_ERROR(thread.Join());
   }
 
-  VLOG(2) << "Verilog simulator stdout:\n" << stdout_stderr.first;
-  VLOG(2) << "Verilog simulator stderr:\n" << stdout_stderr.second;
+  VLOG(2) << "Verilog simulator stdout:\n" << stdout_stderr->first;
+  VLOG(2) << "Verilog simulator stderr:\n" << stdout_stderr->second;
+
+  return CaptureOutputsAndCheckExpectations(stdout_stderr->first, recorder,
+                                            capture_status);
+}
 
-  const std::string& stdout_str = stdout_stderr.first;
-  return CaptureOutputsAndCheckExpectations(stdout_str);
+std::vector<const TestbenchStream*> ModuleTestbench::GetAllStreams() const {
+  std::vector<const TestbenchStream*> streams;
+  for (const std::unique_ptr<TestbenchStream>& stream : streams_) {
+    streams.push_back(stream.get());
+  }
+  if (capture_stream_ != nullptr) {
+    streams.push_back(capture_stream_.get());
+  }
+  return streams;
 }
 
 static std::string GetPipePathMacroName(std::string_view stream_name) {
@@ -790,7 +731,7 @@ absl::StatusOr<const TestbenchStream*> ModuleTestbench::CreateInputStream(
 }
 
 absl::StatusOr<const TestbenchStream*> ModuleTestbench::CreateOutputStream(
-    std::string_view name, int64_t width) {
+    std::string_view name, int64_t width, bool flush) {
   if (stream_names_.contains(name)) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Already a I/O stream named `%s`", name));
@@ -800,9 +741,28 @@ absl::StatusOr<const TestbenchStream*> ModuleTestbench::CreateOutputStream(
       new TestbenchStream{.name = std::string{name},
                           .direction = TestbenchStreamDirection::kOutput,
                           .path_macro_name = GetPipePathMacroName(name),
-                          .width = width}));
+                          .width = width,
+                          .flush = flush}));
   return streams_.back().get();
 }
 
+absl::Status ModuleTestbench::StreamSignalCaptures(
+    bool stop_at_first_mismatch) {
+  if (capture_stream_ == nullptr) {
+    if (stream_names_.contains(kSignalCaptureStreamName)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Already a I/O stream named `%s`", kSignalCaptureStreamName));
+    }
+    stream_names_.insert(std::string{kSignalCaptureStreamName});
+    capture_stream_ = absl::WrapUnique(new TestbenchStream{
+        .name = std::string{kSignalCaptureStreamName},
+        .direction = TestbenchStreamDirection::kOutput,
+        .path_macro_name = GetPipePathMacroName(kSignalCaptureStreamName),
+        .width = 0});
+  }
+  stop_at_first_mismatch_ = stop_at_first_mismatch;
+  return absl::OkStatus();
+}
+
 }  // namespace verilog
 }  // namespace xls
@@ -146,10 +146,23 @@ class ModuleTestbench {
   // Allocate streams for reading and writing values to the testbench. The
   // returned pointer can be passed to SequentialBlock::ReadFromStreamAndSet or
   // EndOfCycleEvent::CaptureAndWriteToStream to connect into the simulation.
+  // If `flush` is true, the output stream is flushed after each value written
+  // (see TestbenchStream::flush).
   absl::StatusOr<const TestbenchStream*> CreateInputStream(
       std::string_view name, int64_t width);
   absl::StatusOr<const TestbenchStream*> CreateOutputStream(
-      std::string_view name, int64_t width);
+      std::string_view name, int64_t width, bool flush = false);
+
+  // Has the testbench write the values of captured signals (Capture, ExpectEq,
+  // etc.) to a named pipe rather than $display them. The values are then
+  // recorded and checked on a separate thread as the simulation produces
+  // them, so long simulations need not hold their whole output in memory.
+  //
+  // If `stop_at_first_mismatch` is true the pipe is closed at the first value
+  // which fails an expectation, which ends the simulation early for
+  // simulators terminated by writes to a closed pipe. This is not supported
+  // together with input streams.
+  absl::Status StreamSignalCaptures(bool stop_at_first_mismatch = false);
 
  private:
   ModuleTestbench(std::string_view verilog_text, FileType file_type,
@@ -166,9 +179,25 @@ class ModuleTestbench {
       std::string_view thread_name, absl::Span<const DutInput> dut_inputs,
       bool wait_until_done, bool wait_for_reset);
 
-  // Checks the stdout of a simulation run against expectations.
+  // Runs the simulation, with the given producers and consumers for any
+  // streams.
+  absl::Status RunInternal(
+      const absl::flat_hash_map<std::string, TestbenchStreamThread::Producer>&
+          input_producers,
+      const absl::flat_hash_map<std::string, TestbenchStreamThread::Consumer>&
+          output_consumers) const;
+
+  // Returns the streams created by the user followed by the signal capture
+  // stream, if any.
+  std::vector<const TestbenchStream*> GetAllStreams() const;
+
+  // Checks the stdout of a simulation run against expectations. Signal
+  // captures are applied with `recorder`; if they were streamed rather than
+  // displayed, `capture_status` is the result of applying them as they were
+  // read.
   absl::Status CaptureOutputsAndCheckExpectations(
-      std::string_view stdout_str) const;
+      std::string_view stdout_str, SignalCaptureRecorder& recorder,
+      const absl::Status& capture_status) const;
 
   std::vector<std::string> GatherExpectedTraces() const;
 
@@ -200,6 +229,10 @@ class ModuleTestbench {
 
   // The set of names of all streams.
   absl::flat_hash_set<std::string> stream_names_;
+
+  // The stream carrying the values of signal captures, if they are streamed.
+  std::unique_ptr<TestbenchStream> capture_stream_;
+  bool stop_at_first_mismatch_ = false;
 };
 
 }  // namespace verilog
@@ -1192,6 +1192,76 @@ TEST_P(ModuleTestbenchTest, StreamingIoMultipleInputOutput) {
   XLS_ASSERT_OK(tb->RunWithStreamingIo(producer_map, consumer_map));
 }
 
+TEST_P(ModuleTestbenchTest, StreamedSignalCaptures) {
+  VerilogFile f = NewVerilogFile();
+  Module* m = MakeTwoStageIdentityPipeline(&f);
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ModuleTestbench> tb,
+      ModuleTestbench::CreateFromVastModule(m, GetSimulator(), "clk"));
+  XLS_ASSERT_OK(tb->StreamSignalCaptures());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ModuleTestbenchThread * tbt,
+      tb->CreateThread("input driver",
+                       /*dut_inputs=*/{DutInput{.port_name = "in",
+                                                .initial_value = IsX()}}));
+  Bits captured;
+  std::vector<Bits> outputs;
+  SequentialBlock& seq = tbt->MainBlock();
+  seq.Set("in", 42);
+  seq.NextCycle().SetX("in");
+  seq.AtEndOfCycle().ExpectX("out");
+  seq.AtEndOfCycle().ExpectEq("out", 42).Capture("out", &captured);
+  seq.Set("in", 1234);
+  seq.AdvanceNCycles(3);
+  seq.AtEndOfCycle().ExpectEq("out", 1234);
+  SequentialBlock& loop = seq.Repeat(3);
+  loop.AtEndOfCycle().CaptureMultiple("out", &outputs);
+
+  XLS_ASSERT_OK(tb->Run());
+
+  EXPECT_EQ(captured, UBits(42, 16));
+  EXPECT_THAT(outputs, ElementsAre(UBits(1234, 16), UBits(1234, 16),
+                                   UBits(1234, 16)));
+}
+
+TEST_P(ModuleTestbenchTest, StreamedSignalCapturesStopAtFirstMismatch) {
+  VerilogFile f = NewVerilogFile();
+  Module* m = MakeTwoStageIdentityPipelineWithReset(&f, /*width=*/16);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ModuleTestbench> tb,
+      ModuleTestbench::CreateFromVastModule(
+          m, GetSimulator(), "clk", /*reset=*/std::nullopt,
+          /*includes=*/{}, /*simulation_cycle_limit=*/std::nullopt));
+  XLS_ASSERT_OK(tb->StreamSignalCaptures(/*stop_at_first_mismatch=*/true));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      ModuleTestbenchThread * input_thread,
+      tb->CreateThreadDrivingAllInputs("input driver",
+                                       /*default_value=*/ZeroOrX::kZero));
+  {
+    SequentialBlock& seq = input_thread->MainBlock();
+    seq.Set("reset", 0).Set("in", 42).AdvanceNCycles(5);
+    seq.Set("in", 123);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(ModuleTestbenchThread * output_thread,
+                           tb->CreateThread("output check",
+                                            /*dut_inputs=*/{}));
+  {
+    // Far more cycles than the mismatch needs; the remainder are not checked.
+    SequentialBlock& seq = output_thread->MainBlock();
+    seq.AdvanceNCycles(2);
+    SequentialBlock& loop = seq.Repeat(100'000);
+    loop.AtEndOfCycle().ExpectEq("out", UBits(42, 16));
+  }
+
+  EXPECT_THAT(
+      tb->Run(),
+      StatusIs(absl::StatusCode::kFailedPrecondition,
+               ContainsRegex("module_testbench_test.cc@[0-9]+: expected "
+                             "output `out`, instance #0, recurrence 5 to have "
+                             "value: 42, actual: 123")));
+}
+
 INSTANTIATE_TEST_SUITE_P(ModuleTestbenchTestInstantiation, ModuleTestbenchTest,
                          testing::ValuesIn(kDefaultSimulationTargets),
                          ParameterizedTestName<ModuleTestbenchTest>);
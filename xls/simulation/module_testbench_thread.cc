@@ -80,13 +80,15 @@ void WaitNCycles(LogicRef* clk, StatementBlock* statement_block,
 }
 
 // Emit $display statements and file I/O into the given block which sample the
-// value of the given signals.
+// value of the given signals. If there is an emitter for the signal capture
+// stream, the values are written to it rather than displayed.
 void EmitSignalCaptures(
     absl::Span<const SignalCapture> signal_captures,
     StatementBlock* statement_block,
     const absl::flat_hash_map<std::string, LogicRef*>& signal_refs,
     const absl::flat_hash_map<std::string, VastStreamEmitter>&
         stream_emitters) {
+  auto capture_stream = stream_emitters.find(kSignalCaptureStreamName);
   for (const SignalCapture& signal_capture : signal_captures) {
     if (std::holds_alternative<const TestbenchStream*>(signal_capture.action)) {
       const TestbenchStream* stream =
@@ -97,6 +99,16 @@ void EmitSignalCaptures(
                      signal_refs.at(signal_capture.signal_name));
       continue;
     }
+    if (capture_stream != stream_emitters.end()) {
+      // Zero-width signals are not represented in the Verilog and are written
+      // as a constant 0.
+      capture_stream->second.EmitTaggedWrite(
+          statement_block, signal_capture.instance_id,
+          signal_capture.signal_width == 0
+              ? nullptr
+              : signal_refs.at(signal_capture.signal_name));
+      continue;
+    }
     if (signal_capture.signal_width == 0) {
       // Zero-width signals are not actually represented in the Verilog though
       // they may appear in the module signature. Call $display to print a
@@ -17,11 +17,23 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <variant>
 #include <vector>
 
 #include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/types/span.h"
 #include "xls/common/source_location.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
 #include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/format_preference.h"
+#include "xls/ir/number_parser.h"
 #include "xls/simulation/testbench_stream.h"
 
 namespace xls {
@@ -95,6 +107,125 @@ SignalCapture SignalCaptureManager::ExpectX(std::string_view signal_name,
   return signal_captures_.back();
 }
 
+SignalCaptureRecorder::SignalCaptureRecorder(
+    absl::Span<const SignalCapture> captures)
+    : captures_(captures), recurrences_(captures.size(), 0) {
+  for (const SignalCapture& capture : captures_) {
+    if (std::holds_alternative<std::vector<Bits>*>(capture.action)) {
+      std::get<std::vector<Bits>*>(capture.action)->clear();
+    }
+  }
+}
+
+absl::Status SignalCaptureRecorder::Record(int64_t instance_id,
+                                           const BitsOrX& value) {
+  XLS_RET_CHECK(instance_id >= 0 && instance_id < captures_.size())
+      << "Unknown signal capture instance #" << instance_id;
+  const SignalCapture& capture = captures_[instance_id];
+  XLS_RET_CHECK_EQ(capture.instance_id, instance_id);
+  int64_t recurrence = recurrences_[instance_id]++;
+  std::string_view signal_name = capture.signal_name;
+
+  if (std::holds_alternative<std::vector<Bits>*>(capture.action)) {
+    // Capture multiple instances of the same signal.
+    if (std::holds_alternative<IsX>(value)) {
+      return absl::NotFoundError(absl::StrFormat(
+          "Output `%s`, instance #%d, recurrence %d holds X value in "
+          "Verilog simulator output.",
+          signal_name, instance_id, recurrence));
+    }
+    std::get<std::vector<Bits>*>(capture.action)
+        ->push_back(std::get<Bits>(value));
+    return absl::OkStatus();
+  }
+
+  if (std::holds_alternative<Bits*>(capture.action)) {
+    // Capture a single instance of a signal.
+    XLS_RET_CHECK_EQ(recurrence, 0) << absl::StreamFormat(
+        "Output `%s`, instance #%d captured more than once", signal_name,
+        instance_id);
+    if (std::holds_alternative<IsX>(value)) {
+      return absl::NotFoundError(
+          absl::StrFormat("Output `%s`, instance #%d holds X value in "
+                          "Verilog simulator output.",
+                          signal_name, instance_id));
+    }
+    *std::get<Bits*>(capture.action) = std::get<Bits>(value);
+    return absl::OkStatus();
+  }
+
+  // Check the signal value against the expectation.
+  XLS_RET_CHECK(std::holds_alternative<TestbenchExpectation>(capture.action));
+  const TestbenchExpectation& expectation =
+      std::get<TestbenchExpectation>(capture.action);
+  std::string source_location = absl::StrFormat(
+      "%s@%d", expectation.loc.file_name(), expectation.loc.line());
+  std::string instance_name =
+      absl::StrFormat("output `%s`, instance #%d, recurrence %d", signal_name,
+                      instance_id, recurrence);
+  if (std::holds_alternative<Bits>(expectation.expected)) {
+    const Bits& expected_bits = std::get<Bits>(expectation.expected);
+    if (std::holds_alternative<IsX>(value)) {
+      return absl::FailedPreconditionError(
+          absl::StrFormat("%s: expected %s to have value: %v, has X",
+                          source_location, instance_name, expected_bits));
+    }
+    const Bits& actual_bits = std::get<Bits>(value);
+    if (actual_bits != expected_bits) {
+      return absl::FailedPreconditionError(absl::StrFormat(
+          "%s: expected %s to have value: %v, actual: %v", source_location,
+          instance_name, expected_bits, actual_bits));
+    }
+    return absl::OkStatus();
+  }
+  XLS_RET_CHECK(std::holds_alternative<IsX>(expectation.expected));
+  if (std::holds_alternative<Bits>(value)) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "%s: expected %s to have X value, has non X value: %v",
+        source_location, instance_name, std::get<Bits>(value)));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SignalCaptureRecorder::RecordLine(std::string_view line) {
+  std::vector<std::string_view> fields =
+      absl::StrSplit(line, ' ', absl::SkipEmpty());
+  XLS_RET_CHECK_EQ(fields.size(), 2)
+      << "Malformed signal capture line: " << line;
+  int64_t instance_id;
+  XLS_RET_CHECK(absl::SimpleAtoi(fields[0], &instance_id))
+      << "Malformed signal capture line: " << line;
+  XLS_RET_CHECK(instance_id >= 0 && instance_id < captures_.size())
+      << "Unknown signal capture instance #" << instance_id;
+  if (absl::StrContains(fields[1], "x") || absl::StrContains(fields[1], "X")) {
+    return Record(instance_id, IsX());
+  }
+  int64_t width = captures_[instance_id].signal_width;
+  XLS_ASSIGN_OR_RETURN(Bits value, ParseUnsignedNumberWithoutPrefix(
+                                       fields[1], FormatPreference::kHex));
+  XLS_RET_CHECK_GE(width, value.bit_count());
+  return Record(instance_id, bits_ops::ZeroExtend(value, width));
+}
+
+absl::Status SignalCaptureRecorder::CheckComplete(int64_t instance_id) const {
+  const SignalCapture& capture = captures_.at(instance_id);
+  if (std::holds_alternative<Bits*>(capture.action) &&
+      recurrences_[instance_id] == 0) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Output `%s`, instance #%d not found in Verilog simulator output.",
+        capture.signal_name, instance_id));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SignalCaptureRecorder::CheckComplete() const {
+  for (int64_t instance_id = 0; instance_id < captures_.size();
+       ++instance_id) {
+    XLS_RETURN_IF_ERROR(CheckComplete(instance_id));
+  }
+  return absl::OkStatus();
+}
+
 EndOfCycleEvent& EndOfCycleEvent::Capture(std::string_view signal_name,
                                           Bits* value) {
   signal_captures_.push_back(capture_manager_->Capture(signal_name, value));
@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "absl/log/die_if_null.h"
+#include "absl/status/status.h"
 #include "absl/types/span.h"
 #include "xls/common/source_location.h"
 #include "xls/ir/bits.h"
@@ -67,6 +68,11 @@ struct SignalCapture {
   int64_t instance_id;
 };
 
+// The name of the stream through which the testbench writes the values of
+// signal captures, if they are streamed rather than displayed. See
+// ModuleTestbench::StreamSignalCaptures.
+inline constexpr std::string_view kSignalCaptureStreamName = "signal_captures";
+
 // Data structure which allocates capture instances so that the instance ids are
 // unique across all threads in the testbench.
 class SignalCaptureManager {
@@ -99,6 +105,34 @@ class SignalCaptureManager {
   std::vector<SignalCapture> signal_captures_;
 };
 
+// Applies the values sampled for signal captures to their actions, recording
+// them or checking them against expectations, one value at a time in the order
+// the simulation produces them. Captures which write to a TestbenchStream are
+// not handled here.
+class SignalCaptureRecorder {
+ public:
+  // Clears the vectors of any CaptureMultiple captures.
+  explicit SignalCaptureRecorder(absl::Span<const SignalCapture> captures);
+
+  // Applies the next value of the capture with the given instance id. Returns
+  // an error if the value does not meet an expectation or cannot be recorded.
+  absl::Status Record(int64_t instance_id, const BitsOrX& value);
+
+  // Applies a value written to the signal capture stream by the testbench, a
+  // line holding the instance id and the value in hex.
+  absl::Status RecordLine(std::string_view line);
+
+  // Returns an error if a single-value capture has not been recorded, for the
+  // given instance or for all instances.
+  absl::Status CheckComplete(int64_t instance_id) const;
+  absl::Status CheckComplete() const;
+
+ private:
+  absl::Span<const SignalCapture> captures_;
+  // The number of values recorded for each capture, indexed by instance id.
+  std::vector<int64_t> recurrences_;
+};
+
 // Data-structure representing the end of a cycle (one time unit before the
 // rising edge of the clock). In the ModuleTestbench infrastructure signals are
 // only sampled at the end of a cycle. The ModuleTestbenchThread API returns
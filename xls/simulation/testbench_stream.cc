@@ -20,6 +20,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -103,7 +104,7 @@ void VastStreamEmitter::EmitRead(StatementBlock* block, LogicRef* lhs) const {
   // Emit code:
   //
   //   cnt = $fscanf(fd, "%x\n", lhs);
-  //   if (cnt == 0) begin
+  //   if (cnt != 1) begin
   //     $display("FAILED: ...");
   //     $finish;
   //   end
@@ -115,8 +116,8 @@ void VastStreamEmitter::EmitRead(StatementBlock* block, LogicRef* lhs) const {
   block->Add<BlockingAssignment>(SourceInfo(), count_, call);
   Conditional* conditional = block->Add<Conditional>(
       SourceInfo(),
-      block->file()->Equals(
-          count_, block->file()->PlainLiteral(0, SourceInfo()), SourceInfo()));
+      block->file()->NotEquals(
+          count_, block->file()->PlainLiteral(1, SourceInfo()), SourceInfo()));
   conditional->consequent()->Add<Display>(
       SourceInfo(),
       std::vector<Expression*>{block->file()->Make<QuotedString>(
@@ -132,6 +133,7 @@ void VastStreamEmitter::EmitWrite(StatementBlock* block,
   //
   //   $fwriteh(fd, <value>);
   //   $fwrite(fd, "\n");
+  //   $fflush(fd);  // If the stream is flushed.
   block->Add<SystemTaskCall>(SourceInfo(), "fwriteh",
                              std::vector<Expression*>{file_descriptor_, value});
   block->Add<SystemTaskCall>(
@@ -139,6 +141,32 @@ void VastStreamEmitter::EmitWrite(StatementBlock* block,
       std::vector<Expression*>{
           file_descriptor_,
           block->file()->Make<QuotedString>(SourceInfo(), R"(\n)")});
+  if (stream_.flush) {
+    block->Add<SystemTaskCall>(SourceInfo(), "fflush",
+                               std::vector<Expression*>{file_descriptor_});
+  }
+}
+
+void VastStreamEmitter::EmitTaggedWrite(StatementBlock* block, int64_t tag,
+                                        Expression* value) const {
+  // Emit code:
+  //
+  //   $fwrite(fd, "<tag> %0x\n", <value>);
+  //   $fflush(fd);  // If the stream is flushed.
+  std::vector<Expression*> args = {file_descriptor_};
+  if (value == nullptr) {
+    args.push_back(block->file()->Make<QuotedString>(
+        SourceInfo(), absl::StrFormat(R"(%d 0\n)", tag)));
+  } else {
+    args.push_back(block->file()->Make<QuotedString>(
+        SourceInfo(), absl::StrFormat(R"(%d %%0x\n)", tag)));
+    args.push_back(value);
+  }
+  block->Add<SystemTaskCall>(SourceInfo(), "fwrite", args);
+  if (stream_.flush) {
+    block->Add<SystemTaskCall>(SourceInfo(), "fflush",
+                               std::vector<Expression*>{file_descriptor_});
+  }
 }
 
 void VastStreamEmitter::EmitClose(StatementBlock* block) const {
@@ -195,64 +223,80 @@ void TestbenchStreamThread::RunOutputStream(
     TestbenchStreamThread::Consumer consumer) {
   VLOG(1) << absl::StrFormat("RunOutputStream [%s]", stream_.name);
   thread_ = absl::WrapUnique(new Thread([this, consumer]() {
-    VLOG(1) << absl::StrFormat("Thread for stream `%s` started", stream_.name);
-    absl::StatusOr<FileLineReader> reader =
-        FileLineReader::Create(named_pipe_.path());
-    if (!reader.ok()) {
-      LOG(ERROR) << absl::StrFormat(
-          "FileLineReader creation failed for stream `%s`: %s", stream_.name,
-          reader.status().message());
-      MaybeSetError(reader.status());
-      return;
+    ReadLines(
+        [&](std::string_view line) -> absl::Status {
+          // TODO(meheff): 2023/11/8 Support capturing X values.
+          if (absl::StrContains(line, "x") || absl::StrContains(line, "X")) {
+            LOG(ERROR) << absl::StrFormat("Stream `%s` produced an X value",
+                                          stream_.name);
+            return absl::InvalidArgumentError(absl::StrFormat(
+                "Stream `%s` produced an X value: %s", stream_.name, line));
+          }
+          absl::StatusOr<Bits> value = ParseUnsignedNumberWithoutPrefix(
+              line, FormatPreference::kHex,
+              /*bit_count=*/stream_.width);
+          if (!value.ok()) {
+            LOG(ERROR) << absl::StrFormat(
+                "Unabled to convert value from stream `%s` into Bits: %s",
+                stream_.name, value.status().message());
+            return value.status();
+          }
+          return consumer(*value);
+        },
+        /*stop_at_first_error=*/false);
+  }));
+}
+
+void TestbenchStreamThread::RunOutputLines(
+    TestbenchStreamThread::LineConsumer consumer, bool stop_at_first_error) {
+  VLOG(1) << absl::StrFormat("RunOutputLines [%s]", stream_.name);
+  thread_ = absl::WrapUnique(
+      new Thread([this, consumer, stop_at_first_error]() {
+        ReadLines(consumer, stop_at_first_error);
+      }));
+}
+
+void TestbenchStreamThread::ReadLines(
+    TestbenchStreamThread::LineConsumer consumer, bool stop_at_first_error) {
+  VLOG(1) << absl::StrFormat("Thread for stream `%s` started", stream_.name);
+  absl::StatusOr<FileLineReader> reader =
+      FileLineReader::Create(named_pipe_.path());
+  if (!reader.ok()) {
+    LOG(ERROR) << absl::StrFormat(
+        "FileLineReader creation failed for stream `%s`: %s", stream_.name,
+        reader.status().message());
+    MaybeSetError(reader.status());
+    return;
+  }
+  while (true) {
+    absl::StatusOr<std::optional<std::string>> line = reader->ReadLine();
+    if (!line.ok()) {
+      LOG(ERROR) << absl::StrFormat("Error reading from stream `%s`: %s",
+                                    stream_.name, line.status().message());
+      MaybeSetError(line.status());
+      break;
     }
-    while (true) {
-      absl::StatusOr<std::optional<std::string>> line = reader->ReadLine();
-      if (!line.ok()) {
-        LOG(ERROR) << absl::StrFormat("Error reading from stream `%s`: %s",
-                                      stream_.name, line.status().message());
-        MaybeSetError(line.status());
-        break;
-      }
-      if (!line->has_value()) {
-        // The other end of the pipe has been closed.
-        VLOG(1) << absl::StrFormat(
-            "Line reader for stream `%s` returned std::nullopt. Pipe has been "
-            "closed.",
-            stream_.name);
+    if (!line->has_value()) {
+      // The other end of the pipe has been closed.
+      VLOG(1) << absl::StrFormat(
+          "Line reader for stream `%s` returned std::nullopt. Pipe has been "
+          "closed.",
+          stream_.name);
+      break;
+    }
+    VLOG(1) << absl::StrFormat("Read from stream `%s`: %s", stream_.name,
+                               line->value());
+    absl::Status result = consumer(line->value());
+    if (!result.ok()) {
+      VLOG(1) << absl::StrFormat(
+          "Consumer for stream `%s` returned an error: %s", stream_.name,
+          result.message());
+      MaybeSetError(result);
+      if (stop_at_first_error) {
         break;
       }
-      VLOG(1) << absl::StrFormat("Read from stream `%s`: %s", stream_.name,
-                                 line->value());
-      // TODO(meheff): 2023/11/8 Support capturing X values.
-      if (absl::StrContains(line->value(), "x") ||
-          absl::StrContains(line->value(), "X")) {
-        LOG(ERROR) << absl::StrFormat("Stream `%s` produced an X value",
-                                      stream_.name);
-        MaybeSetError(absl::InvalidArgumentError(
-            absl::StrFormat("Stream `%s` produced an X value: %s", stream_.name,
-                            line->value())));
-        continue;
-      }
-      absl::StatusOr<Bits> value = ParseUnsignedNumberWithoutPrefix(
-          line->value(), FormatPreference::kHex,
-          /*bit_count=*/stream_.width);
-      if (!value.ok()) {
-        LOG(ERROR) << absl::StrFormat(
-            "Unabled to convert value from stream `%s` into Bits: %s",
-            stream_.name, status_.message());
-        MaybeSetError(value.status());
-        continue;
-      }
-      absl::Status result = consumer(*value);
-      if (!result.ok()) {
-        VLOG(1) << absl::StrFormat(
-            "Consumer for stream `%s` returned an error: %s", stream_.name,
-            result.message());
-        MaybeSetError(result);
-        continue;
-      }
     }
-  }));
+  }
 }
 
 absl::Status TestbenchStreamThread::Join() {
@@ -20,6 +20,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "absl/functional/function_ref.h"
@@ -50,6 +51,11 @@ struct TestbenchStream {
 
   // The width of the data to read/write to the testbench.
   int64_t width;
+
+  // Whether the testbench flushes an output stream after each value written.
+  // Needed when the reader waits for outputs before producing further inputs,
+  // as otherwise the values may sit in the simulator's buffers indefinitely.
+  bool flush = false;
 };
 
 // Class for emitting VAST code for reading and writing values to streams.
@@ -66,9 +72,16 @@ class VastStreamEmitter {
   // Emit code which reads a value from the pipe and assigns the value to `lhs`.
   void EmitRead(StatementBlock* block, LogicRef* lhs) const;
 
-  // Emit code which writes `value` into the pipe.
+  // Emit code which writes `value` into the pipe (and flushes it, if the
+  // stream is flushed).
   void EmitWrite(StatementBlock* block, Expression* value) const;
 
+  // Emit code which writes a line holding `tag` followed by `value` in hex
+  // into the pipe, for streams carrying values of several signals. A null
+  // `value` is written as zero.
+  void EmitTaggedWrite(StatementBlock* block, int64_t tag,
+                       Expression* value) const;
+
  private:
   explicit VastStreamEmitter(const TestbenchStream& stream) : stream_(stream) {}
 
@@ -111,12 +124,27 @@ class TestbenchStreamThread {
   using Consumer = absl::FunctionRef<absl::Status(const Bits&)>;
   void RunOutputStream(Consumer consumer);
 
+  // Start running a thread which reads the lines written to an output stream
+  // by the testbench, for streams whose lines are not plain values.
+  //
+  // `consumer` is called with each line, not including the newline. If it
+  // returns an error then that error will be returned by Join. If
+  // `stop_at_first_error` is true the stream is closed at the first error
+  // rather than read to the end; this fails any further writes by the
+  // simulation process.
+  using LineConsumer = absl::FunctionRef<absl::Status(std::string_view)>;
+  void RunOutputLines(LineConsumer consumer, bool stop_at_first_error = false);
+
   absl::Status Join();
 
  private:
   TestbenchStreamThread(const TestbenchStream& stream, NamedPipe named_pipe)
       : stream_(stream), named_pipe_(std::move(named_pipe)) {}
 
+  // Reads lines from the named pipe until it is closed by the simulation
+  // process, passing each to `consumer`.
+  void ReadLines(LineConsumer consumer, bool stop_at_first_error);
+
   // Sets `status_` to the given error status if `status_` does not already hold
   // an error code.
   void MaybeSetError(const absl::Status& status);
@@ -0,0 +1,821 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/z3_aig_equivalence.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/cleanup/cleanup.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/topo_sort.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/solvers/z3_ir_translator.h"
+#include "xls/solvers/z3_utils.h"
+#include "z3/src/api/z3_api.h"
+
+namespace xls::solvers::z3 {
+namespace {
+
+// A literal is an AIG node index shifted left by one, with the low bit set if
+// the node's value is complemented. Node 0 is the constant false.
+using AigLit = uint32_t;
+constexpr AigLit kAigFalse = 0;
+constexpr AigLit kAigTrue = 1;
+
+AigLit Not(AigLit lit) { return lit ^ 1; }
+AigLit NotIf(AigLit lit, bool complement) { return lit ^ (complement ? 1 : 0); }
+int64_t NodeOf(AigLit lit) { return lit >> 1; }
+bool IsComplemented(AigLit lit) { return (lit & 1) != 0; }
+AigLit MakeLit(int64_t node) { return static_cast<AigLit>(node << 1); }
+
+// An and-inverter graph. AND nodes are structurally hashed: requesting the AND
+// of two literals which already have one returns the existing node. Nodes are
+// only ever appended, and always after their fanins, so node order is a
+// topological order.
+class Aig {
+ public:
+  Aig() : nodes_(1, AigNode{kAigFalse, kAigFalse}) {}
+
+  AigLit AddInput() {
+    nodes_.push_back(AigNode{kInputMarker, kInputMarker});
+    return MakeLit(node_count() - 1);
+  }
+
+  AigLit And(AigLit a, AigLit b) {
+    if (a > b) {
+      std::swap(a, b);
+    }
+    if (a == kAigFalse || a == Not(b)) {
+      return kAigFalse;
+    }
+    if (a == kAigTrue || a == b) {
+      return b;
+    }
+    auto [it, inserted] = strash_.try_emplace(std::make_pair(a, b), kAigFalse);
+    if (inserted) {
+      nodes_.push_back(AigNode{a, b});
+      it->second = MakeLit(node_count() - 1);
+    }
+    return it->second;
+  }
+  AigLit Or(AigLit a, AigLit b) { return Not(And(Not(a), Not(b))); }
+  AigLit Xor(AigLit a, AigLit b) {
+    return Or(And(a, Not(b)), And(Not(a), b));
+  }
+  AigLit Mux(AigLit selector, AigLit on_true, AigLit on_false) {
+    return Or(And(selector, on_true), And(Not(selector), on_false));
+  }
+
+  int64_t node_count() const { return nodes_.size(); }
+  bool IsInput(int64_t node) const {
+    return nodes_[node].fanin0 == kInputMarker;
+  }
+  bool IsAnd(int64_t node) const { return node != 0 && !IsInput(node); }
+  AigLit fanin0(int64_t node) const { return nodes_[node].fanin0; }
+  AigLit fanin1(int64_t node) const { return nodes_[node].fanin1; }
+
+  // Returns the number of AND nodes in the fanin cones of `roots`.
+  int64_t CountAnds(absl::Span<const AigLit> roots) const {
+    std::vector<bool> visited(nodes_.size(), false);
+    std::vector<int64_t> worklist;
+    for (AigLit root : roots) {
+      worklist.push_back(NodeOf(root));
+    }
+    int64_t count = 0;
+    while (!worklist.empty()) {
+      int64_t node = worklist.back();
+      worklist.pop_back();
+      if (visited[node] || !IsAnd(node)) {
+        continue;
+      }
+      visited[node] = true;
+      ++count;
+      worklist.push_back(NodeOf(fanin0(node)));
+      worklist.push_back(NodeOf(fanin1(node)));
+    }
+    return count;
+  }
+
+ private:
+  static constexpr AigLit kInputMarker = std::numeric_limits<AigLit>::max();
+
+  struct AigNode {
+    AigLit fanin0;
+    AigLit fanin1;
+  };
+
+  std::vector<AigNode> nodes_;
+  absl::flat_hash_map<std::pair<AigLit, AigLit>, AigLit> strash_;
+};
+
+// The flattened bits of an IR value, least significant bit first. Tuple
+// elements are laid out in order, element 0 at the lowest offset.
+using AigBits = std::vector<AigLit>;
+
+bool IsSupportedType(Type* type) {
+  if (type->IsBits()) {
+    return true;
+  }
+  if (type->IsTuple()) {
+    return std::all_of(type->AsTupleOrDie()->element_types().begin(),
+                       type->AsTupleOrDie()->element_types().end(),
+                       IsSupportedType);
+  }
+  return false;
+}
+
+absl::Status FlattenValue(const Value& value, AigBits& bits) {
+  if (value.IsBits()) {
+    for (int64_t i = 0; i < value.bits().bit_count(); ++i) {
+      bits.push_back(value.bits().Get(i) ? kAigTrue : kAigFalse);
+    }
+    return absl::OkStatus();
+  }
+  if (value.IsTuple()) {
+    for (const Value& element : value.elements()) {
+      XLS_RETURN_IF_ERROR(FlattenValue(element, bits));
+    }
+    return absl::OkStatus();
+  }
+  return absl::UnimplementedError(
+      absl::StrCat("Unsupported value in AIG equivalence: ", value.ToString()));
+}
+
+// Rebuilds a value of type `type` from the front of `bits`, advancing it past
+// the bits consumed.
+Value UnflattenValue(Type* type, absl::Span<const bool>& bits) {
+  if (type->IsBits()) {
+    int64_t bit_count = type->AsBitsOrDie()->bit_count();
+    Value value(Bits(bits.subspan(0, bit_count)));
+    bits.remove_prefix(bit_count);
+    return value;
+  }
+  std::vector<Value> elements;
+  for (Type* element_type : type->AsTupleOrDie()->element_types()) {
+    elements.push_back(UnflattenValue(element_type, bits));
+  }
+  return Value::TupleOwned(std::move(elements));
+}
+
+// Lowers IR functions to bit-level logic in an AIG.
+class BitBlaster {
+ public:
+  explicit BitBlaster(Aig& aig) : aig_(aig) {}
+
+  // Returns the bits of the return value of `f`, whose parameters are bound
+  // to `param_bits`.
+  absl::StatusOr<AigBits> Blast(Function* f,
+                                absl::Span<const AigBits> param_bits) {
+    absl::flat_hash_map<Node*, AigBits> values;
+    for (Node* node : TopoSort(f)) {
+      if (!IsSupportedType(node->GetType())) {
+        return absl::UnimplementedError(absl::StrFormat(
+            "Unsupported type in AIG equivalence: %s", node->ToString()));
+      }
+      if (node->Is<Param>()) {
+        XLS_ASSIGN_OR_RETURN(int64_t index,
+                             f->GetParamIndex(node->As<Param>()));
+        values[node] = param_bits[index];
+        continue;
+      }
+      std::vector<const AigBits*> operands;
+      operands.reserve(node->operand_count());
+      for (Node* operand : node->operands()) {
+        operands.push_back(&values.at(operand));
+      }
+      XLS_ASSIGN_OR_RETURN(values[node], BlastNode(node, operands));
+      XLS_RET_CHECK_EQ(values[node].size(), node->GetType()->GetFlatBitCount())
+          << node->ToString();
+    }
+    return values.at(f->return_value());
+  }
+
+ private:
+  absl::StatusOr<AigBits> BlastNode(Node* node,
+                                    absl::Span<const AigBits* const> ops) {
+    int64_t width = node->GetType()->GetFlatBitCount();
+    switch (node->op()) {
+      case Op::kLiteral: {
+        AigBits result;
+        XLS_RETURN_IF_ERROR(FlattenValue(node->As<Literal>()->value(), result));
+        return result;
+      }
+      case Op::kIdentity:
+        return *ops[0];
+      case Op::kTuple: {
+        AigBits result;
+        for (const AigBits* op : ops) {
+          result.insert(result.end(), op->begin(), op->end());
+        }
+        return result;
+      }
+      case Op::kTupleIndex: {
+        TupleType* tuple_type = node->operand(0)->GetType()->AsTupleOrDie();
+        int64_t offset = 0;
+        for (int64_t i = 0; i < node->As<TupleIndex>()->index(); ++i) {
+          offset += tuple_type->element_type(i)->GetFlatBitCount();
+        }
+        return Slice(*ops[0], offset, width);
+      }
+      case Op::kNot:
+        return Map(*ops[0], [](AigLit a) { return Not(a); });
+      case Op::kAnd:
+      case Op::kNand:
+        return NotAllIf(Fold(ops, &Aig::And), node->op() == Op::kNand);
+      case Op::kOr:
+      case Op::kNor:
+        return NotAllIf(Fold(ops, &Aig::Or), node->op() == Op::kNor);
+      case Op::kXor:
+        return Fold(ops, &Aig::Xor);
+      case Op::kAndReduce:
+        return AigBits{Reduce(*ops[0], &Aig::And, kAigTrue)};
+      case Op::kOrReduce:
+        return AigBits{Reduce(*ops[0], &Aig::Or, kAigFalse)};
+      case Op::kXorReduce:
+        return AigBits{Reduce(*ops[0], &Aig::Xor, kAigFalse)};
+      case Op::kNeg:
+        return Add(AigBits(width, kAigFalse), NotAll(*ops[0]), kAigTrue);
+      case Op::kAdd:
+        return Add(*ops[0], *ops[1], kAigFalse);
+      case Op::kSub:
+        return Add(*ops[0], NotAll(*ops[1]), kAigTrue);
+      case Op::kUMul:
+      case Op::kSMul:
+        return Multiply(Extend(*ops[0], width, node->op() == Op::kSMul),
+                        Extend(*ops[1], width, node->op() == Op::kSMul));
+      case Op::kEq:
+      case Op::kNe:
+        return AigBits{NotIf(Equal(*ops[0], *ops[1]), node->op() == Op::kNe)};
+      case Op::kULt:
+        return AigBits{LessThan(*ops[0], *ops[1], /*is_signed=*/false)};
+      case Op::kUGe:
+        return AigBits{Not(LessThan(*ops[0], *ops[1], /*is_signed=*/false))};
+      case Op::kUGt:
+        return AigBits{LessThan(*ops[1], *ops[0], /*is_signed=*/false)};
+      case Op::kULe:
+        return AigBits{Not(LessThan(*ops[1], *ops[0], /*is_signed=*/false))};
+      case Op::kSLt:
+        return AigBits{LessThan(*ops[0], *ops[1], /*is_signed=*/true)};
+      case Op::kSGe:
+        return AigBits{Not(LessThan(*ops[0], *ops[1], /*is_signed=*/true))};
+      case Op::kSGt:
+        return AigBits{LessThan(*ops[1], *ops[0], /*is_signed=*/true)};
+      case Op::kSLe:
+        return AigBits{Not(LessThan(*ops[1], *ops[0], /*is_signed=*/true))};
+      case Op::kConcat: {
+        // Operand 0 holds the most significant bits.
+        AigBits result;
+        for (auto it = ops.rbegin(); it != ops.rend(); ++it) {
+          result.insert(result.end(), (*it)->begin(), (*it)->end());
+        }
+        return result;
+      }
+      case Op::kBitSlice:
+        return Slice(*ops[0], node->As<BitSlice>()->start(), width);
+      case Op::kDynamicBitSlice:
+        return Extend(Shift(*ops[0], *ops[1], Op::kShrl), width,
+                      /*is_signed=*/false);
+      case Op::kShll:
+      case Op::kShrl:
+      case Op::kShra:
+        return Shift(*ops[0], *ops[1], node->op());
+      case Op::kZeroExt:
+      case Op::kSignExt:
+        return Extend(*ops[0], width, node->op() == Op::kSignExt);
+      case Op::kReverse:
+        return AigBits(ops[0]->rbegin(), ops[0]->rend());
+      case Op::kSel: {
+        Select* select = node->As<Select>();
+        const AigBits& selector = *ops[0];
+        absl::Span<const AigBits* const> cases =
+            ops.subspan(1, select->cases().size());
+        AigBits result =
+            select->default_value().has_value() ? *ops.back() : *cases.back();
+        for (int64_t i = 0; i < cases.size(); ++i) {
+          AigLit selected = EqualsConstant(selector, i);
+          result = Mux(selected, *cases[i], result);
+        }
+        return result;
+      }
+      case Op::kOneHotSel: {
+        const AigBits& selector = *ops[0];
+        AigBits result(width, kAigFalse);
+        for (int64_t i = 0; i + 1 < ops.size(); ++i) {
+          result = Mux(selector[i], Or(result, *ops[i + 1]), result);
+        }
+        return result;
+      }
+      case Op::kPrioritySel: {
+        const AigBits& selector = *ops[0];
+        AigBits result = *ops.back();
+        for (int64_t i = static_cast<int64_t>(ops.size()) - 3; i >= 0; --i) {
+          result = Mux(selector[i], *ops[i + 1], result);
+        }
+        return result;
+      }
+      default:
+        return absl::UnimplementedError(
+            absl::StrFormat("Unsupported op in AIG equivalence: %s",
+                            OpToString(node->op())));
+    }
+  }
+
+  template <typename F>
+  AigBits Map(const AigBits& a, F f) {
+    AigBits result;
+    result.reserve(a.size());
+    for (AigLit lit : a) {
+      result.push_back(f(lit));
+    }
+    return result;
+  }
+  AigBits NotAll(const AigBits& a) {
+    return Map(a, [](AigLit lit) { return Not(lit); });
+  }
+  AigBits NotAllIf(AigBits a, bool complement) {
+    return complement ? NotAll(a) : a;
+  }
+  AigBits Or(const AigBits& a, const AigBits& b) {
+    AigBits result;
+    for (int64_t i = 0; i < a.size(); ++i) {
+      result.push_back(aig_.Or(a[i], b[i]));
+    }
+    return result;
+  }
+  AigBits Mux(AigLit selector, const AigBits& on_true,
+              const AigBits& on_false) {
+    AigBits result;
+    for (int64_t i = 0; i < on_true.size(); ++i) {
+      result.push_back(aig_.Mux(selector, on_true[i], on_false[i]));
+    }
+    return result;
+  }
+  AigBits Fold(absl::Span<const AigBits* const> ops,
+               AigLit (Aig::*f)(AigLit, AigLit)) {
+    AigBits result = *ops[0];
+    for (const AigBits* op : ops.subspan(1)) {
+      for (int64_t i = 0; i < result.size(); ++i) {
+        result[i] = (aig_.*f)(result[i], (*op)[i]);
+      }
+    }
+    return result;
+  }
+  AigLit Reduce(const AigBits& a, AigLit (Aig::*f)(AigLit, AigLit),
+                AigLit identity) {
+    AigLit result = identity;
+    for (AigLit lit : a) {
+      result = (aig_.*f)(result, lit);
+    }
+    return result;
+  }
+  AigBits Slice(const AigBits& a, int64_t start, int64_t width) {
+    return AigBits(a.begin() + start, a.begin() + start + width);
+  }
+  AigBits Extend(const AigBits& a, int64_t width, bool is_signed) {
+    AigBits result(a.begin(), a.begin() + std::min<int64_t>(a.size(), width));
+    AigLit fill = is_signed && !a.empty() ? a.back() : kAigFalse;
+    result.resize(width, fill);
+    return result;
+  }
+
+  // Ripple-carry adder, truncated to the width of the operands.
+  AigBits Add(const AigBits& a, const AigBits& b, AigLit carry,
+              AigLit* carry_out = nullptr) {
+    AigBits sum;
+    sum.reserve(a.size());
+    for (int64_t i = 0; i < a.size(); ++i) {
+      AigLit half_sum = aig_.Xor(a[i], b[i]);
+      sum.push_back(aig_.Xor(half_sum, carry));
+      carry = aig_.Or(aig_.And(a[i], b[i]), aig_.And(carry, half_sum));
+    }
+    if (carry_out != nullptr) {
+      *carry_out = carry;
+    }
+    return sum;
+  }
+
+  // Shift-and-add multiplier of operands extended to the result width.
+  AigBits Multiply(const AigBits& a, const AigBits& b) {
+    AigBits product(a.size(), kAigFalse);
+    for (int64_t i = 0; i < b.size(); ++i) {
+      AigBits partial(a.size(), kAigFalse);
+      for (int64_t j = 0; i + j < a.size(); ++j) {
+        partial[i + j] = aig_.And(a[j], b[i]);
+      }
+      product = Add(product, partial, kAigFalse);
+    }
+    return product;
+  }
+
+  AigLit Equal(const AigBits& a, const AigBits& b) {
+    AigLit result = kAigTrue;
+    for (int64_t i = 0; i < a.size(); ++i) {
+      result = aig_.And(result, Not(aig_.Xor(a[i], b[i])));
+    }
+    return result;
+  }
+  AigLit EqualsConstant(const AigBits& a, int64_t value) {
+    AigLit result = kAigTrue;
+    for (int64_t i = 0; i < a.size(); ++i) {
+      bool bit = i < 63 && ((value >> i) & 1) != 0;
+      result = aig_.And(result, NotIf(a[i], !bit));
+    }
+    return result;
+  }
+
+  // a < b is the borrow out of a - b; signed operands compare like unsigned
+  // ones with their sign bits flipped.
+  AigLit LessThan(AigBits a, AigBits b, bool is_signed) {
+    if (a.empty()) {
+      return kAigFalse;
+    }
+    if (is_signed) {
+      a.back() = Not(a.back());
+      b.back() = Not(b.back());
+    }
+    AigLit carry_out;
+    Add(a, NotAll(b), kAigTrue, &carry_out);
+    return Not(carry_out);
+  }
+
+  // Logarithmic barrel shifter.
+  AigBits Shift(const AigBits& a, const AigBits& amount, Op op) {
+    int64_t width = a.size();
+    AigLit fill = op == Op::kShra && !a.empty() ? a.back() : kAigFalse;
+    AigBits result = a;
+    for (int64_t i = 0; i < amount.size(); ++i) {
+      int64_t distance = i < 62 ? int64_t{1} << i : width;
+      AigBits shifted(width, fill);
+      for (int64_t j = 0; j < width; ++j) {
+        int64_t source = op == Op::kShll ? j - distance : j + distance;
+        if (source >= 0 && source < width) {
+          shifted[j] = result[source];
+        }
+      }
+      result = Mux(amount[i], shifted, result);
+    }
+    return result;
+  }
+
+  Aig& aig_;
+};
+
+// Random simulation of an AIG, `words` 64-bit words of patterns per node.
+class AigSimulation {
+ public:
+  AigSimulation(const Aig& aig, int64_t words, uint64_t seed)
+      : words_(words), values_(aig.node_count() * words, 0) {
+    std::mt19937_64 rng(seed);
+    for (int64_t node = 1; node < aig.node_count(); ++node) {
+      uint64_t* value = &values_[node * words_];
+      if (aig.IsInput(node)) {
+        for (int64_t w = 0; w < words_; ++w) {
+          value[w] = rng();
+        }
+        continue;
+      }
+      for (int64_t w = 0; w < words_; ++w) {
+        value[w] = Word(aig.fanin0(node), w) & Word(aig.fanin1(node), w);
+      }
+    }
+  }
+
+  uint64_t Word(AigLit lit, int64_t w) const {
+    uint64_t word = values_[NodeOf(lit) * words_ + w];
+    return IsComplemented(lit) ? ~word : word;
+  }
+  bool Bit(AigLit lit, int64_t pattern) const {
+    return ((Word(lit, pattern / 64) >> (pattern % 64)) & 1) != 0;
+  }
+
+  // Returns the signature of `lit`, complemented if needed so that its first
+  // bit is zero, and whether it was complemented. Literals which are equal or
+  // complementary under all patterns get the same signature.
+  std::pair<std::vector<uint64_t>, bool> NormalizedSignature(
+      AigLit lit) const {
+    bool complement = (Word(lit, 0) & 1) != 0;
+    std::vector<uint64_t> signature;
+    signature.reserve(words_);
+    for (int64_t w = 0; w < words_; ++w) {
+      signature.push_back(Word(NotIf(lit, complement), w));
+    }
+    return {std::move(signature), complement};
+  }
+
+  // Returns the index of a pattern under which `a` and `b` differ, if any.
+  std::optional<int64_t> FindDifference(AigLit a, AigLit b) const {
+    for (int64_t w = 0; w < words_; ++w) {
+      uint64_t difference = Word(a, w) ^ Word(b, w);
+      if (difference != 0) {
+        int64_t bit = 0;
+        while (((difference >> bit) & 1) == 0) {
+          ++bit;
+        }
+        return w * 64 + bit;
+      }
+    }
+    return std::nullopt;
+  }
+
+ private:
+  int64_t words_;
+  std::vector<uint64_t> values_;
+};
+
+// Incremental SAT queries on an AIG, with Z3 as the solver. Each AIG node is
+// lowered to a Boolean Z3 term the first time it is needed.
+class AigSolver {
+ public:
+  explicit AigSolver(const Aig& aig) : aig_(aig) {
+    config_ = Z3_mk_config();
+    ctx_ = Z3_mk_context(config_);
+    solver_ = CreateSolver(ctx_, /*num_threads=*/1);
+  }
+  ~AigSolver() {
+    Z3_solver_dec_ref(ctx_, solver_);
+    Z3_del_context(ctx_);
+    Z3_del_config(config_);
+  }
+  AigSolver(const AigSolver&) = delete;
+  AigSolver& operator=(const AigSolver&) = delete;
+
+  // Checks whether the literals of any of `pairs` can differ. On Z3_L_TRUE,
+  // `input_values` (if given) is set to the values of the AIG's inputs, in
+  // order, under which they do.
+  Z3_lbool CanDiffer(absl::Span<const std::pair<AigLit, AigLit>> pairs,
+                     absl::Duration timeout,
+                     std::vector<bool>* input_values = nullptr) {
+    ExtendTerms();
+    std::vector<Z3_ast> differences;
+    for (const auto& [a, b] : pairs) {
+      differences.push_back(Z3_mk_xor(ctx_, Term(a), Term(b)));
+    }
+    Z3_params params = Z3_mk_params(ctx_);
+    Z3_params_inc_ref(ctx_, params);
+    Z3_params_set_uint(ctx_, params, Z3_mk_string_symbol(ctx_, "timeout"),
+                       timeout == absl::InfiniteDuration()
+                           ? std::numeric_limits<unsigned>::max()
+                           : static_cast<unsigned>(std::clamp<int64_t>(
+                                 absl::ToInt64Milliseconds(timeout), 1,
+                                 std::numeric_limits<unsigned>::max())));
+    Z3_solver_set_params(ctx_, solver_, params);
+    Z3_params_dec_ref(ctx_, params);
+
+    Z3_solver_push(ctx_, solver_);
+    absl::Cleanup pop = [&] { Z3_solver_pop(ctx_, solver_, 1); };
+    Z3_solver_assert(ctx_, solver_,
+                     Z3_mk_or(ctx_, static_cast<unsigned>(differences.size()),
+                              differences.data()));
+    Z3_lbool result = Z3_solver_check(ctx_, solver_);
+    if (result == Z3_L_TRUE && input_values != nullptr) {
+      Z3_model model = Z3_solver_get_model(ctx_, solver_);
+      Z3_model_inc_ref(ctx_, model);
+      input_values->clear();
+      for (int64_t node = 1; node < aig_.node_count(); ++node) {
+        if (!aig_.IsInput(node)) {
+          continue;
+        }
+        Z3_ast value;
+        bool evaluated =
+            Z3_model_eval(ctx_, model, Term(MakeLit(node)), true, &value);
+        input_values->push_back(evaluated &&
+                                Z3_get_bool_value(ctx_, value) == Z3_L_TRUE);
+      }
+      Z3_model_dec_ref(ctx_, model);
+    }
+    return result;
+  }
+
+ private:
+  // Lowers the AIG nodes added since the last call.
+  void ExtendTerms() {
+    Z3_sort bool_sort = Z3_mk_bool_sort(ctx_);
+    for (int64_t node = terms_.size(); node < aig_.node_count(); ++node) {
+      if (node == 0) {
+        terms_.push_back(Z3_mk_false(ctx_));
+      } else if (aig_.IsInput(node)) {
+        terms_.push_back(Z3_mk_const(
+            ctx_, Z3_mk_int_symbol(ctx_, static_cast<int>(node)), bool_sort));
+      } else {
+        Z3_ast fanins[] = {Term(aig_.fanin0(node)), Term(aig_.fanin1(node))};
+        terms_.push_back(Z3_mk_and(ctx_, 2, fanins));
+      }
+    }
+  }
+
+  Z3_ast Term(AigLit lit) {
+    Z3_ast term = terms_[NodeOf(lit)];
+    return IsComplemented(lit) ? Z3_mk_not(ctx_, term) : term;
+  }
+
+  const Aig& aig_;
+  Z3_config config_;
+  Z3_context ctx_;
+  Z3_solver solver_;
+  std::vector<Z3_ast> terms_;
+};
+
+// Returns the values of `f`'s parameters given the values of their flattened
+// bits.
+absl::flat_hash_map<const Param*, Value> MakeCounterexample(
+    Function* f, const std::vector<bool>& input_values) {
+  absl::InlinedVector<bool, 64> flat(input_values.begin(), input_values.end());
+  absl::Span<const bool> bits = flat;
+  absl::flat_hash_map<const Param*, Value> counterexample;
+  for (Param* param : f->params()) {
+    counterexample[param] = UnflattenValue(param->GetType(), bits);
+  }
+  return counterexample;
+}
+
+}  // namespace
+
+absl::StatusOr<ProverResult> TryProveEquivalenceWithAig(
+    Function* a, Function* b, absl::Duration timeout,
+    const AigEquivalenceOptions& options, AigEquivalenceStats* stats) {
+  XLS_RET_CHECK(
+      a->return_value()->GetType()->IsEqualTo(b->return_value()->GetType()))
+      << a->return_value()->GetType() << " vs " << b->return_value()->GetType();
+  XLS_RET_CHECK_EQ(a->params().size(), b->params().size());
+  for (int64_t i = 0; i < a->params().size(); ++i) {
+    XLS_RET_CHECK(
+        a->params()[i]->GetType()->IsEqualTo(b->params()[i]->GetType()));
+  }
+  XLS_RET_CHECK_GT(options.simulation_words, 0);
+  absl::Time deadline = absl::Now() + timeout;
+
+  // Bit-blast both functions into one AIG, sharing their inputs.
+  Aig aig;
+  std::vector<AigBits> param_bits;
+  for (Param* param : a->params()) {
+    if (!IsSupportedType(param->GetType())) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Unsupported type in AIG equivalence: %s", param->ToString()));
+    }
+    AigBits bits;
+    for (int64_t i = 0; i < param->GetType()->GetFlatBitCount(); ++i) {
+      bits.push_back(aig.AddInput());
+    }
+    param_bits.push_back(std::move(bits));
+  }
+  BitBlaster blaster(aig);
+  XLS_ASSIGN_OR_RETURN(AigBits a_outputs, blaster.Blast(a, param_bits));
+  XLS_ASSIGN_OR_RETURN(AigBits b_outputs, blaster.Blast(b, param_bits));
+  std::vector<AigLit> outputs = a_outputs;
+  outputs.insert(outputs.end(), b_outputs.begin(), b_outputs.end());
+  AigEquivalenceStats local_stats;
+  local_stats.and_count = aig.CountAnds(outputs);
+
+  // Random simulation alone is often enough to tell the functions apart.
+  AigSimulation simulation(aig, options.simulation_words, options.seed);
+  for (int64_t i = 0; i < a_outputs.size(); ++i) {
+    std::optional<int64_t> pattern =
+        simulation.FindDifference(a_outputs[i], b_outputs[i]);
+    if (!pattern.has_value()) {
+      continue;
+    }
+    std::vector<bool> input_values;
+    for (int64_t node = 1; node < aig.node_count(); ++node) {
+      if (aig.IsInput(node)) {
+        input_values.push_back(simulation.Bit(MakeLit(node), *pattern));
+      }
+    }
+    if (stats != nullptr) {
+      *stats = local_stats;
+    }
+    return ProvenFalse{
+        .counterexample = MakeCounterexample(a, input_values),
+        .message = absl::StrFormat(
+            "Output bit %d differs under random simulation", i),
+    };
+  }
+
+  // Sweep the AIG into a new one in topological order, merging each node into
+  // the first earlier node with the same simulation signature it is proven
+  // equal to. Class members are kept with the phase that makes the first bit
+  // of their signature zero.
+  Aig swept;
+  AigSolver solver(swept);
+  std::vector<AigLit> node_map(aig.node_count(), kAigFalse);
+  absl::flat_hash_map<std::vector<uint64_t>, std::vector<AigLit>> classes;
+  classes[simulation.NormalizedSignature(kAigFalse).first].push_back(
+      kAigFalse);
+  auto map_lit = [&](AigLit lit) {
+    return NotIf(node_map[NodeOf(lit)], IsComplemented(lit));
+  };
+  for (int64_t node = 1; node < aig.node_count(); ++node) {
+    auto [signature, complement] =
+        simulation.NormalizedSignature(MakeLit(node));
+    std::vector<AigLit>& members = classes[signature];
+    AigLit lit;
+    if (aig.IsInput(node)) {
+      lit = swept.AddInput();
+    } else {
+      lit = swept.And(map_lit(aig.fanin0(node)), map_lit(aig.fanin1(node)));
+    }
+    AigLit normalized = NotIf(lit, complement);
+    bool merged = false;
+    int64_t candidates = 0;
+    for (AigLit member : members) {
+      if (member == normalized) {
+        merged = true;
+        break;
+      }
+      absl::Duration remaining = deadline - absl::Now();
+      if (aig.IsInput(node) ||
+          candidates++ >= options.max_candidates_per_node ||
+          remaining <= absl::ZeroDuration()) {
+        break;
+      }
+      ++local_stats.candidate_checks;
+      std::pair<AigLit, AigLit> candidate = {member, normalized};
+      if (solver.CanDiffer(absl::MakeConstSpan(&candidate, 1),
+                           std::min(remaining, options.candidate_timeout)) ==
+          Z3_L_FALSE) {
+        ++local_stats.proven_equivalences;
+        normalized = member;
+        merged = true;
+        break;
+      }
+    }
+    if (!merged) {
+      members.push_back(normalized);
+    }
+    node_map[node] = NotIf(normalized, complement);
+  }
+
+  // Check whatever is left of the miter.
+  std::vector<AigLit> swept_outputs;
+  std::vector<std::pair<AigLit, AigLit>> differing;
+  for (int64_t i = 0; i < a_outputs.size(); ++i) {
+    AigLit a_output = map_lit(a_outputs[i]);
+    AigLit b_output = map_lit(b_outputs[i]);
+    swept_outputs.push_back(a_output);
+    swept_outputs.push_back(b_output);
+    if (a_output != b_output) {
+      differing.push_back({a_output, b_output});
+    }
+  }
+  local_stats.swept_and_count = swept.CountAnds(swept_outputs);
+  VLOG(1) << absl::StreamFormat(
+      "AIG sweep: %d -> %d AND nodes; %d of %d candidates proven; %d output "
+      "bits left to check",
+      local_stats.and_count, local_stats.swept_and_count,
+      local_stats.proven_equivalences, local_stats.candidate_checks,
+      differing.size());
+  if (stats != nullptr) {
+    *stats = local_stats;
+  }
+  if (differing.empty()) {
+    return ProvenTrue();
+  }
+  std::vector<bool> input_values;
+  switch (solver.CanDiffer(differing, deadline - absl::Now(), &input_values)) {
+    case Z3_L_FALSE:
+      return ProvenTrue();
+    case Z3_L_TRUE:
+      return ProvenFalse{
+          .counterexample = MakeCounterexample(a, input_values),
+          .message = "AIG miter is satisfiable",
+      };
+    case Z3_L_UNDEF:
+      return absl::DeadlineExceededError("Z3 solver timed out");
+  }
+  return absl::InternalError("Invalid Z3 result");
+}
+
+}  // namespace xls::solvers::z3
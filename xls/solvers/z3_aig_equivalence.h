@@ -0,0 +1,88 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SOLVERS_Z3_AIG_EQUIVALENCE_H_
+#define XLS_SOLVERS_Z3_AIG_EQUIVALENCE_H_
+
+#include <cstdint>
+
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "xls/ir/function.h"
+#include "xls/solvers/z3_ir_translator.h"
+
+namespace xls::solvers::z3 {
+
+struct AigEquivalenceOptions {
+  // Number of 64-bit words of random input patterns used to find candidate
+  // equivalences.
+  int64_t simulation_words = 4;
+
+  // Seed of the random input patterns.
+  uint64_t seed = 0;
+
+  // Maximum number of candidates an AIG node is checked against before it is
+  // kept as is.
+  int64_t max_candidates_per_node = 2;
+
+  // Solver time limit for each candidate equivalence; candidates which can't
+  // be decided in time are not merged.
+  absl::Duration candidate_timeout = absl::Seconds(1);
+};
+
+// Statistics of a call of TryProveEquivalenceWithAig, for logging and tests.
+struct AigEquivalenceStats {
+  // Number of AND nodes after bit-blasting (and structural hashing) and after
+  // merging the nodes proven equivalent.
+  int64_t and_count = 0;
+  int64_t swept_and_count = 0;
+
+  // Number of candidate equivalences checked with the solver, and how many of
+  // them were proven.
+  int64_t candidate_checks = 0;
+  int64_t proven_equivalences = 0;
+};
+
+// Verifies that both functions have the same behaviors, like
+// TryProveEquivalence, by bit-blasting them into a single structurally hashed
+// and-inverter graph (AIG) and sweeping it before the final check:
+//
+//  * nodes computing the same function up to structure are shared as the AIG
+//    is built;
+//  * random simulation groups the remaining nodes into classes of candidate
+//    equivalences;
+//  * in topological order, each node is checked against the earlier members
+//    of its class with small incremental solver queries, and merged into the
+//    first one it is proven equal to.
+//
+// Functions which only differ by local restructuring (as is typical of
+// optimization passes) mostly collapse into one graph during the sweep, which
+// leaves little or nothing for the final query.
+//
+// Only functions whose parameters and return value are bits or tuples of
+// them, and which use a subset of the bitwise and arithmetic operations, are
+// supported; others result in an UnimplementedError, upon which the caller can
+// fall back to TryProveEquivalence. A solver timeout in the final check
+// results in a DeadlineExceededError.
+//
+// This call does not alter either function.
+absl::StatusOr<ProverResult> TryProveEquivalenceWithAig(
+    Function* a, Function* b,
+    absl::Duration timeout = absl::InfiniteDuration(),
+    const AigEquivalenceOptions& options = AigEquivalenceOptions(),
+    AigEquivalenceStats* stats = nullptr);
+
+}  // namespace xls::solvers::z3
+
+#endif  // XLS_SOLVERS_Z3_AIG_EQUIVALENCE_H_
@@ -0,0 +1,138 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/solvers/z3_aig_equivalence.h"
+
+#include <memory>
+#include <variant>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/solvers/z3_ir_translator.h"
+#include "xls/solvers/z3_ir_translator_matchers.h"
+
+namespace xls::solvers::z3 {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::Gt;
+using ::testing::HasSubstr;
+using ::testing::Lt;
+
+class AigEquivalenceTest : public IrTestBase {};
+
+TEST_F(AigEquivalenceTest, RestructuredArithmeticIsEquivalent) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(R"(
+package p
+
+fn a(x: bits[16], y: bits[16], s: bits[4]) -> (bits[16], bits[1]) {
+  add.1: bits[16] = add(x, y)
+  shll.2: bits[16] = shll(add.1, s)
+  ult.3: bits[1] = ult(x, y)
+  ret tuple.4: (bits[16], bits[1]) = tuple(shll.2, ult.3)
+}
+
+fn b(x: bits[16], y: bits[16], s: bits[4]) -> (bits[16], bits[1]) {
+  neg.5: bits[16] = neg(y)
+  sub.6: bits[16] = sub(x, neg.5)
+  literal.7: bits[16] = literal(value=1)
+  shll.8: bits[16] = shll(literal.7, s)
+  umul.9: bits[16] = umul(sub.6, shll.8)
+  ugt.10: bits[1] = ugt(y, x)
+  ret tuple.11: (bits[16], bits[1]) = tuple(umul.9, ugt.10)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * a, p->GetFunction("a"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * b, p->GetFunction("b"));
+  AigEquivalenceStats stats;
+  EXPECT_THAT(TryProveEquivalenceWithAig(a, b, absl::InfiniteDuration(),
+                                         AigEquivalenceOptions(), &stats),
+              IsOkAndHolds(IsProvenTrue()));
+  EXPECT_THAT(stats.proven_equivalences, Gt(0));
+  EXPECT_THAT(stats.swept_and_count, Lt(stats.and_count));
+}
+
+TEST_F(AigEquivalenceTest, SimulationFindsCounterexample) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(R"(
+package p
+
+fn a(x: bits[8], y: bits[8]) -> bits[8] {
+  ret and.1: bits[8] = and(x, y)
+}
+
+fn b(x: bits[8], y: bits[8]) -> bits[8] {
+  ret or.2: bits[8] = or(x, y)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * a, p->GetFunction("a"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * b, p->GetFunction("b"));
+  XLS_ASSERT_OK_AND_ASSIGN(ProverResult result,
+                           TryProveEquivalenceWithAig(a, b));
+  ASSERT_THAT(result, IsProvenFalse(HasSubstr("random simulation")));
+  const ProvenFalse& proven_false = std::get<ProvenFalse>(result);
+  XLS_ASSERT_OK(proven_false.counterexample.status());
+  EXPECT_NE(proven_false.counterexample->at(a->param(0)),
+            proven_false.counterexample->at(a->param(1)));
+}
+
+TEST_F(AigEquivalenceTest, SolverFindsCounterexample) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(R"(
+package p
+
+fn a(x: bits[32]) -> bits[1] {
+  literal.1: bits[32] = literal(value=0x12345678)
+  ret eq.2: bits[1] = eq(x, literal.1)
+}
+
+fn b(x: bits[32]) -> bits[1] {
+  ret literal.3: bits[1] = literal(value=0)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * a, p->GetFunction("a"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * b, p->GetFunction("b"));
+  XLS_ASSERT_OK_AND_ASSIGN(ProverResult result,
+                           TryProveEquivalenceWithAig(a, b));
+  ASSERT_THAT(result, IsProvenFalse(HasSubstr("miter")));
+  const ProvenFalse& proven_false = std::get<ProvenFalse>(result);
+  XLS_ASSERT_OK(proven_false.counterexample.status());
+  EXPECT_EQ(proven_false.counterexample->at(a->param(0)),
+            Value(UBits(0x12345678, 32)));
+}
+
+TEST_F(AigEquivalenceTest, UnsupportedTypeIsUnimplemented) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(R"(
+package p
+
+fn a(x: bits[8][2]) -> bits[8] {
+  literal.1: bits[1] = literal(value=0)
+  ret array_index.2: bits[8] = array_index(x, indices=[literal.1])
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * a, p->GetFunction("a"));
+  EXPECT_THAT(TryProveEquivalenceWithAig(a, a),
+              StatusIs(absl::StatusCode::kUnimplemented,
+                       HasSubstr("Unsupported type")));
+}
+
+}  // namespace
+}  // namespace xls::solvers::z3
@@ -15,12 +15,15 @@
 #include "xls/solvers/z3_lec.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
@@ -34,7 +37,9 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/time.h"
 #include "xls/codegen/vast/vast.h"
+#include "xls/common/thread.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/bits.h"
@@ -148,6 +153,10 @@ absl::Status Lec::Init() {
         ir_outputs_.push_back(ir_bits[i]);
         netlist_outputs_.push_back(netlist_bits[i]);
         eq_nodes.push_back(Z3_mk_eq(ctx(), ir_bits[i], netlist_bits[i]));
+        // The netlist bits are ordered from the most significant down.
+        output_bit_eqs_.push_back(eq_nodes.back());
+        output_bits_.push_back(
+            {node, static_cast<int64_t>(ir_bits.size()) - 1 - i});
       }
     }
   }
@@ -275,6 +284,7 @@ absl::Status Lec::AddConstraints(Function* constraints) {
   Z3_ast eq_node = Z3_mk_eq(ctx(), constraint_translator->GetReturnNode(),
                             Z3_mk_int(ctx(), 1, Z3_mk_bv_sort(ctx(), 1)));
   Z3_solver_assert(ctx(), solver_.value(), eq_node);
+  constraints_.push_back(eq_node);
   return absl::OkStatus();
 }
 
@@ -288,6 +298,33 @@ bool Lec::Run() {
   return !satisfiable_;
 }
 
+std::string Lec::OutputBitName(int64_t index) const {
+  const auto& [node, bit] = output_bits_.at(index);
+  return absl::StrCat(node->GetName(), "[", bit, "]");
+}
+
+Z3_lbool Lec::CheckOutputBit(int64_t index,
+                             std::optional<absl::Duration> timeout) {
+  // Each bit is checked on a single thread; callers parallelize across bits.
+  Z3_solver solver = CreateSolver(ctx(), /*num_threads=*/1);
+  if (timeout.has_value()) {
+    Z3_params params = Z3_mk_params(ctx());
+    Z3_params_inc_ref(ctx(), params);
+    Z3_params_set_uint(ctx(), params, Z3_mk_string_symbol(ctx(), "timeout"),
+                       absl::ToInt64Milliseconds(*timeout));
+    Z3_solver_set_params(ctx(), solver, params);
+    Z3_params_dec_ref(ctx(), params);
+  }
+  for (Z3_ast constraint : constraints_) {
+    Z3_solver_assert(ctx(), solver, constraint);
+  }
+  Z3_solver_assert(ctx(), solver,
+                   Z3_mk_not(ctx(), output_bit_eqs_.at(index)));
+  Z3_lbool result = Z3_solver_check(ctx(), solver);
+  Z3_solver_dec_ref(ctx(), solver);
+  return result;
+}
+
 std::string Lec::ResultToString() {
   std::vector<std::string> output;
   output.push_back(SolverResultToString(ctx(), solver_.value(),
@@ -489,6 +526,63 @@ void Lec::MarkDontCareBits(const std::vector<Z3_ast>& nl_bits,
   }
 }
 
+std::string_view LecOutputBitResultToString(Z3_lbool result) {
+  switch (result) {
+    case Z3_L_FALSE:
+      return "equivalent";
+    case Z3_L_TRUE:
+      return "NOT equivalent";
+    default:
+      return "unknown (timed out)";
+  }
+}
+
+absl::StatusOr<std::vector<LecOutputBitResult>> RunLecPerOutputBit(
+    const std::function<absl::StatusOr<std::unique_ptr<Lec>>()>& create_lec,
+    const LecPerOutputBitOptions& options) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Lec> first_lec, create_lec());
+  int64_t bit_count = first_lec->output_bit_count();
+  std::vector<LecOutputBitResult> results(bit_count);
+  for (int64_t i = 0; i < bit_count; ++i) {
+    results[i].name = first_lec->OutputBitName(i);
+  }
+
+  int64_t parallelism = options.parallelism > 0
+                            ? options.parallelism
+                            : std::max<int64_t>(
+                                  1, std::thread::hardware_concurrency());
+  int64_t worker_count = std::min(parallelism, bit_count);
+  std::atomic<int64_t> next_bit = 0;
+  std::vector<absl::Status> statuses(worker_count);
+  auto check_bits = [&](Lec* lec) {
+    for (int64_t i = next_bit++; i < bit_count; i = next_bit++) {
+      results[i].result = lec->CheckOutputBit(i, options.timeout_per_bit);
+      VLOG(1) << "Output bit " << results[i].name << ": "
+              << LecOutputBitResultToString(results[i].result);
+    }
+  };
+
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t worker = 1; worker < worker_count; ++worker) {
+    threads.push_back(std::make_unique<Thread>([&, worker]() {
+      absl::StatusOr<std::unique_ptr<Lec>> lec = create_lec();
+      if (!lec.ok()) {
+        statuses[worker] = lec.status();
+        return;
+      }
+      check_bits(lec->get());
+    }));
+  }
+  check_bits(first_lec.get());
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+  for (const absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return results;
+}
+
 // Bit 1 of the 3-bit IR node foo.123 in stage 3 is present as p3_foo_123_1_.
 std::string Lec::NodeToNetlistName(const Node* node,
                                    std::optional<int> bit_index, bool is_cell) {
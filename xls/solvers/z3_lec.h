@@ -15,15 +15,19 @@
 #ifndef XLS_SOLVERS_Z3_LEC_H_
 #define XLS_SOLVERS_Z3_LEC_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "xls/ir/node.h"
 #include "xls/ir/package.h"
 #include "xls/netlist/netlist.h"
@@ -82,6 +86,19 @@ class Lec {
   // Returns true of the netlist and IR are proved to be equivalent.
   bool Run();
 
+  // The number of output bits compared, i.e., those present in the netlist.
+  int64_t output_bit_count() const { return output_bits_.size(); }
+
+  // Returns a name for output bit `index`, e.g. "add.3[7]".
+  std::string OutputBitName(int64_t index) const;
+
+  // Checks only output bit `index` (and so only its cone of influence) with a
+  // fresh solver which gives up after `timeout`, if given. Returns Z3_L_FALSE
+  // if the bit is proved equivalent, Z3_L_TRUE if a counterexample was found
+  // and Z3_L_UNDEF if the solver gave up.
+  Z3_lbool CheckOutputBit(int64_t index,
+                          std::optional<absl::Duration> timeout = std::nullopt);
+
   // Dumps all Z3 values corresponding to IR nodes in the input function.
   void DumpIrTree();
 
@@ -157,6 +174,14 @@ class Lec {
   std::vector<Z3_ast> ir_outputs_;
   std::vector<Z3_ast> netlist_outputs_;
 
+  // The equality of each compared output bit, along with the output node and
+  // bit index it belongs to.
+  std::vector<Z3_ast> output_bit_eqs_;
+  std::vector<std::pair<const Node*, int64_t>> output_bits_;
+
+  // The constraints added by AddConstraints().
+  std::vector<Z3_ast> constraints_;
+
   std::optional<PipelineSchedule> schedule_;
   int stage_;
 
@@ -170,6 +195,36 @@ class Lec {
   std::optional<Z3_model> model_;
 };
 
+// The result of checking a single output bit; see Lec::CheckOutputBit().
+struct LecOutputBitResult {
+  std::string name;
+  Z3_lbool result;
+};
+
+// Returns "equivalent", "NOT equivalent" or "unknown (timed out)".
+std::string_view LecOutputBitResultToString(Z3_lbool result);
+
+struct LecPerOutputBitOptions {
+  // The number of output bits to check at once; if zero, the number of
+  // hardware threads.
+  int64_t parallelism = 0;
+
+  // The time allowed for checking each bit.
+  std::optional<absl::Duration> timeout_per_bit;
+};
+
+// Checks each output bit separately, several at once. Bits are independent
+// problems over their own cones of influence, which are usually far easier
+// for the solver than a single problem over all outputs, and a bit which
+// times out does not keep the others from being proved.
+//
+// Z3 contexts may not be shared between threads, so each thread checks its
+// bits with its own Lec, made by `create_lec` (which may also add
+// constraints). Results are in output bit order.
+absl::StatusOr<std::vector<LecOutputBitResult>> RunLecPerOutputBit(
+    const std::function<absl::StatusOr<std::unique_ptr<Lec>>()>& create_lec,
+    const LecPerOutputBitOptions& options = {});
+
 }  // namespace z3
 }  // namespace solvers
 }  // namespace xls
@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
@@ -181,6 +182,66 @@ endmodule
   ASSERT_FALSE(match);
 }
 
+// Verifies that checking output bits separately pinpoints the bad bit.
+TEST(Z3LecTest, PerOutputBit) {
+  std::string ir_text = R"(
+package p
+
+top fn main(input: bits[4]) -> bits[4] {
+  ret not.2: bits[4] = not(input)
+}
+)";
+
+  std::string netlist_text = R"(
+module main ( clk, input_3_, input_2_, input_1_, input_0_, out_3_, out_2_, out_1_, out_0_);
+  input clk, input_3_, input_2_, input_1_, input_0_;
+  output out_3_, out_2_, out_1_, out_0_;
+  wire p0_input_3_, p0_input_2_, p0_input_1_, p0_input_0_,
+       p0_not_2_comb_3_, p0_not_2_comb_2_, p0_not_2_comb_1_, p0_not_2_comb_0_;
+
+  DFF p0_input_reg_3_ ( .D(input_3_), .CLK(clk), .Q(p0_input_3_) );
+  DFF p0_input_reg_2_ ( .D(input_2_), .CLK(clk), .Q(p0_input_2_) );
+  DFF p0_input_reg_1_ ( .D(input_1_), .CLK(clk), .Q(p0_input_1_) );
+  DFF p0_input_reg_0_ ( .D(input_0_), .CLK(clk), .Q(p0_input_0_) );
+
+  INV p0_not_2_3_ ( .A(p0_input_3_), .ZN(p0_not_2_comb_3_) );
+  INV p0_not_2_2_ ( .A(p0_input_2_), .ZN(p0_not_2_comb_2_) );
+  OR  p0_not_2_1_ ( .A(p0_input_1_), .B(p0_input_1_), .Z(p0_not_2_comb_1_) );
+  INV p0_not_2_0_ ( .A(p0_input_0_), .ZN(p0_not_2_comb_0_) );
+
+  DFF p0_not_2_reg_3_ (.D(p0_not_2_comb_3_), .CLK(clk), .Q(out_3_));
+  DFF p0_not_2_reg_2_ (.D(p0_not_2_comb_2_), .CLK(clk), .Q(out_2_));
+  DFF p0_not_2_reg_1_ (.D(p0_not_2_comb_1_), .CLK(clk), .Q(out_1_));
+  DFF p0_not_2_reg_0_ (.D(p0_not_2_comb_0_), .CLK(clk), .Q(out_0_));
+endmodule
+)";
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(ir_text));
+  XLS_ASSERT_OK_AND_ASSIGN(netlist::CellLibrary cell_library,
+                           netlist::MakeFakeCellLibrary());
+  netlist::rtl::Scanner scanner(netlist_text);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Netlist> netlist,
+      netlist::rtl::Parser::ParseNetlist(&cell_library, &scanner));
+  LecParams params;
+  params.ir_package = package.get();
+  XLS_ASSERT_OK_AND_ASSIGN(params.ir_function, package->GetTopAsFunction());
+  params.netlist = netlist.get();
+  params.netlist_module_name = "main";
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::vector<LecOutputBitResult> results,
+      RunLecPerOutputBit([&]() { return Lec::Create(params); },
+                         LecPerOutputBitOptions{.parallelism = 2}));
+  ASSERT_EQ(results.size(), 4);
+  for (const LecOutputBitResult& result : results) {
+    EXPECT_EQ(result.result,
+              result.name == "not.2[1]" ? Z3_L_TRUE : Z3_L_FALSE)
+        << result.name;
+  }
+}
+
 // This test verifies that we can do a simple multi-stage LEC.
 // There are three defined stages:
 // [inputs] -> p0_AND -> p1_OR -> p2 NOT -> [outputs]
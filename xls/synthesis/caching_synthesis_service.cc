@@ -0,0 +1,240 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/synthesis/caching_synthesis_service.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/log/log.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/types/span.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "openssl/sha.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/synthesis/synthesis.pb.h"
+#include "xls/synthesis/synthesis_service.grpc.pb.h"
+
+namespace xls {
+namespace synthesis {
+namespace {
+
+std::string Sha256Hex(std::string_view data) {
+  std::array<char, SHA256_DIGEST_LENGTH> digest;
+  SHA256(reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+         reinterpret_cast<uint8_t*>(digest.data()));
+  return absl::BytesToHexString({digest.data(), digest.size()});
+}
+
+// Appends `field` to `preimage` prefixed by its length so that the boundaries
+// between fields are unambiguous.
+void AppendField(std::string* preimage, std::string_view field) {
+  absl::StrAppend(preimage, field.size(), ":", field);
+}
+
+}  // namespace
+
+std::string NormalizeVerilog(std::string_view verilog) {
+  std::string result;
+  result.reserve(verilog.size());
+  for (std::string_view line : absl::StrSplit(verilog, '\n')) {
+    line = absl::StripTrailingAsciiWhitespace(line);
+    if (!line.empty()) {
+      absl::StrAppend(&result, line, "\n");
+    }
+  }
+  return result;
+}
+
+absl::StatusOr<std::string> FingerprintFiles(
+    absl::Span<const std::string> paths) {
+  std::string preimage;
+  for (const std::string& path : paths) {
+    XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+    AppendField(&preimage, path);
+    AppendField(&preimage, contents);
+  }
+  return Sha256Hex(preimage);
+}
+
+// A request the backend is working on. Identical requests arriving in the
+// meantime wait for `done` and then copy the result.
+struct CachingSynthesisService::Job {
+  absl::Notification done;
+  ::grpc::Status status;
+  CompileResponse response;
+};
+
+/* static */ absl::StatusOr<std::unique_ptr<CachingSynthesisService>>
+CachingSynthesisService::Create(SynthesisService::Service* backend,
+                                Options options) {
+  if (options.max_concurrent_jobs < 1) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("max_concurrent_jobs must be positive, got ",
+                     options.max_concurrent_jobs));
+  }
+  if (options.cache_dir.has_value()) {
+    XLS_RETURN_IF_ERROR(RecursivelyCreateDir(*options.cache_dir));
+  }
+  return absl::WrapUnique(
+      new CachingSynthesisService(backend, std::move(options)));
+}
+
+std::string CachingSynthesisService::ComputeKey(
+    const CompileRequest& request) const {
+  std::string preimage = absl::StrCat("v", kFormatVersion, "\n");
+  AppendField(&preimage, options_.backend_fingerprint);
+  AppendField(&preimage, request.top_module_name());
+  AppendField(&preimage,
+              request.has_target_frequency_hz()
+                  ? absl::StrCat(request.target_frequency_hz())
+                  : "");
+  // The signature has no map fields so its serialization is deterministic.
+  AppendField(&preimage, request.has_signature()
+                             ? request.signature().SerializeAsString()
+                             : "");
+  AppendField(&preimage, NormalizeVerilog(request.module_text()));
+  return Sha256Hex(preimage);
+}
+
+std::optional<CompileResponse> CachingSynthesisService::Lookup(
+    std::string_view key) const {
+  if (!options_.cache_dir.has_value()) {
+    return std::nullopt;
+  }
+  std::filesystem::path path = *options_.cache_dir / absl::StrCat(key, ".pb");
+  if (!FileExists(path).ok()) {
+    return std::nullopt;
+  }
+  CompileResponse response;
+  absl::Status status = ParseProtobinFile(path, &response);
+  if (!status.ok()) {
+    LOG(WARNING) << "Ignoring unreadable synthesis cache entry " << path
+                 << ": " << status;
+    return std::nullopt;
+  }
+  return response;
+}
+
+void CachingSynthesisService::Store(std::string_view key,
+                                    const CompileResponse& response) const {
+  if (!options_.cache_dir.has_value()) {
+    return;
+  }
+  std::filesystem::path path = *options_.cache_dir / absl::StrCat(key, ".pb");
+  absl::Status status =
+      AtomicallySetFileContents(path, response.SerializeAsString());
+  if (!status.ok()) {
+    LOG(WARNING) << "Unable to write synthesis cache entry " << path << ": "
+                 << status;
+  }
+}
+
+::grpc::Status CachingSynthesisService::RunBackend(
+    ::grpc::ServerContext* server_context, const CompileRequest& request,
+    CompileResponse* result) {
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(
+        absl::Condition(this, &CachingSynthesisService::HasFreeJobSlot));
+    ++running_jobs_;
+    ++miss_count_;
+  }
+  ::grpc::Status status = backend_->Compile(server_context, &request, result);
+  absl::MutexLock lock(&mutex_);
+  --running_jobs_;
+  return status;
+}
+
+::grpc::Status CachingSynthesisService::Compile(
+    ::grpc::ServerContext* server_context, const CompileRequest* request,
+    CompileResponse* result) {
+  std::string key = ComputeKey(*request);
+
+  std::shared_ptr<Job> job;
+  bool owner = false;
+  {
+    absl::MutexLock lock(&mutex_);
+    auto [it, inserted] = in_flight_.try_emplace(key);
+    if (inserted) {
+      it->second = std::make_shared<Job>();
+      owner = true;
+    }
+    job = it->second;
+  }
+
+  if (!owner) {
+    VLOG(1) << "Waiting for identical synthesis request " << key;
+    job->done.WaitForNotification();
+    if (job->status.ok()) {
+      absl::MutexLock lock(&mutex_);
+      ++hit_count_;
+    }
+    *result = job->response;
+    return job->status;
+  }
+
+  // Look up the cache only once this request owns the key so a result stored
+  // by a job which just finished is not missed.
+  if (std::optional<CompileResponse> cached = Lookup(key);
+      cached.has_value()) {
+    VLOG(1) << "Synthesis cache hit for " << key;
+    job->response = *std::move(cached);
+    job->status = ::grpc::Status::OK;
+    absl::MutexLock lock(&mutex_);
+    ++hit_count_;
+  } else {
+    job->status = RunBackend(server_context, *request, &job->response);
+    if (job->status.ok()) {
+      Store(key, job->response);
+    }
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    in_flight_.erase(key);
+  }
+  job->done.Notify();
+  *result = job->response;
+  return job->status;
+}
+
+int64_t CachingSynthesisService::hit_count() const {
+  absl::MutexLock lock(&mutex_);
+  return hit_count_;
+}
+
+int64_t CachingSynthesisService::miss_count() const {
+  absl::MutexLock lock(&mutex_);
+  return miss_count_;
+}
+
+}  // namespace synthesis
+}  // namespace xls
@@ -0,0 +1,125 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_SYNTHESIS_CACHING_SYNTHESIS_SERVICE_H_
+#define XLS_SYNTHESIS_CACHING_SYNTHESIS_SERVICE_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "xls/synthesis/synthesis.pb.h"
+#include "xls/synthesis/synthesis_service.grpc.pb.h"
+
+namespace xls {
+namespace synthesis {
+
+// Returns `verilog` with line endings and trailing whitespace normalized and
+// blank lines removed, so that such differences do not defeat the cache.
+std::string NormalizeVerilog(std::string_view verilog);
+
+// Returns a hash of the contents of the given files, e.g., the cell libraries
+// used by a synthesis backend, for use in a backend fingerprint.
+absl::StatusOr<std::string> FingerprintFiles(
+    absl::Span<const std::string> paths);
+
+// A synthesis service which answers requests from a cache of the results of
+// another (backend) service, and bounds the number of requests the backend
+// works on at once.
+//
+// Results are keyed by a hash of the normalized Verilog, the other fields of
+// the request and a fingerprint of the backend configuration, and stored on
+// disk so they survive restarts of the server. Requests identical to one the
+// backend is already working on wait for its result rather than synthesizing
+// the same module again. Failed requests are not cached.
+class CachingSynthesisService final : public SynthesisService::Service {
+ public:
+  struct Options {
+    // Directory in which results are stored. If not set results are not kept,
+    // but concurrent identical requests are still synthesized only once.
+    std::optional<std::filesystem::path> cache_dir;
+
+    // Maximum number of requests passed to the backend at once.
+    int64_t max_concurrent_jobs = 1;
+
+    // Identifies everything besides the request which determines the result,
+    // e.g., the tool paths, flags and cell libraries of the backend.
+    std::string backend_fingerprint;
+  };
+
+  // Bumped whenever the layout of cached entries or the key changes.
+  static constexpr int64_t kFormatVersion = 1;
+
+  // Creates a service forwarding cache misses to `backend`, which must outlive
+  // the service. Creates the cache directory if needed.
+  static absl::StatusOr<std::unique_ptr<CachingSynthesisService>> Create(
+      SynthesisService::Service* backend, Options options);
+
+  ::grpc::Status Compile(::grpc::ServerContext* server_context,
+                         const CompileRequest* request,
+                         CompileResponse* result) override;
+
+  // Returns the cache key of `request`.
+  std::string ComputeKey(const CompileRequest& request) const;
+
+  // The number of requests answered from the cache or by waiting for an
+  // identical request, and the number passed to the backend.
+  int64_t hit_count() const;
+  int64_t miss_count() const;
+
+ private:
+  struct Job;
+
+  CachingSynthesisService(SynthesisService::Service* backend, Options options)
+      : backend_(backend), options_(std::move(options)) {}
+
+  std::optional<CompileResponse> Lookup(std::string_view key) const;
+  void Store(std::string_view key, const CompileResponse& response) const;
+
+  bool HasFreeJobSlot() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return running_jobs_ < options_.max_concurrent_jobs;
+  }
+
+  // Runs `request` on the backend once a job slot is free.
+  ::grpc::Status RunBackend(::grpc::ServerContext* server_context,
+                            const CompileRequest& request,
+                            CompileResponse* result);
+
+  SynthesisService::Service* backend_;
+  Options options_;
+
+  mutable absl::Mutex mutex_;
+  // The requests the backend is working on or waiting to work on, by key.
+  absl::flat_hash_map<std::string, std::shared_ptr<Job>> in_flight_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t running_jobs_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t hit_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t miss_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace synthesis
+}  // namespace xls
+
+#endif  // XLS_SYNTHESIS_CACHING_SYNTHESIS_SERVICE_H_
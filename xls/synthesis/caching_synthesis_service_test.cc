@@ -0,0 +1,186 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/synthesis/caching_synthesis_service.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/thread.h"
+#include "xls/synthesis/synthesis.pb.h"
+#include "xls/synthesis/synthesis_service.grpc.pb.h"
+
+namespace xls {
+namespace synthesis {
+namespace {
+
+using ::absl_testing::StatusIs;
+
+// A backend which reports the length of the module text as its area and
+// counts how often it runs.
+class CountingService : public SynthesisService::Service {
+ public:
+  ::grpc::Status Compile(::grpc::ServerContext* server_context,
+                         const CompileRequest* request,
+                         CompileResponse* result) override {
+    int64_t running = ++running_;
+    max_running_ = std::max<int64_t>(max_running_, running);
+    ++calls_;
+    absl::SleepFor(delay_);
+    --running_;
+    if (request->top_module_name() == "fail") {
+      return ::grpc::Status(::grpc::StatusCode::INTERNAL, "failed");
+    }
+    result->set_area(request->module_text().size());
+    return ::grpc::Status::OK;
+  }
+
+  std::atomic<int64_t> calls_ = 0;
+  std::atomic<int64_t> running_ = 0;
+  std::atomic<int64_t> max_running_ = 0;
+  absl::Duration delay_ = absl::ZeroDuration();
+};
+
+CompileRequest MakeRequest(std::string_view text) {
+  CompileRequest request;
+  request.set_module_text(text);
+  request.set_top_module_name("top");
+  request.set_target_frequency_hz(1'000'000'000);
+  return request;
+}
+
+TEST(CachingSynthesisServiceTest, NormalizeVerilog) {
+  EXPECT_EQ(NormalizeVerilog("module top;  \r\n\n  endmodule\t\n\n"),
+            "module top;\n  endmodule\n");
+}
+
+TEST(CachingSynthesisServiceTest, RepeatedRequestsHitCache) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  CountingService backend;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CachingSynthesisService> service,
+      CachingSynthesisService::Create(
+          &backend, {.cache_dir = temp_dir.path() / "cache"}));
+
+  ::grpc::ServerContext context;
+  CompileResponse response;
+  CompileRequest request = MakeRequest("module top;\nendmodule\n");
+  ASSERT_TRUE(service->Compile(&context, &request, &response).ok());
+  EXPECT_EQ(response.area(), request.module_text().size());
+
+  // Differs only in whitespace.
+  CompileRequest same = MakeRequest("module top;   \r\n\nendmodule\n");
+  CompileResponse same_response;
+  ASSERT_TRUE(service->Compile(&context, &same, &same_response).ok());
+  EXPECT_EQ(same_response.area(), response.area());
+  EXPECT_EQ(backend.calls_, 1);
+
+  CompileRequest other_frequency = request;
+  other_frequency.set_target_frequency_hz(500'000'000);
+  ASSERT_TRUE(service->Compile(&context, &other_frequency, &response).ok());
+  EXPECT_EQ(backend.calls_, 2);
+  EXPECT_EQ(service->hit_count(), 1);
+  EXPECT_EQ(service->miss_count(), 2);
+
+  // The results persist across instances of the service, unless the backend
+  // configuration changes.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CachingSynthesisService> restarted,
+      CachingSynthesisService::Create(
+          &backend, {.cache_dir = temp_dir.path() / "cache"}));
+  ASSERT_TRUE(restarted->Compile(&context, &request, &response).ok());
+  EXPECT_EQ(backend.calls_, 2);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CachingSynthesisService> reconfigured,
+      CachingSynthesisService::Create(
+          &backend, {.cache_dir = temp_dir.path() / "cache",
+                     .backend_fingerprint = "other library"}));
+  ASSERT_TRUE(reconfigured->Compile(&context, &request, &response).ok());
+  EXPECT_EQ(backend.calls_, 3);
+}
+
+TEST(CachingSynthesisServiceTest, FailuresAreNotCached) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  CountingService backend;
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CachingSynthesisService> service,
+      CachingSynthesisService::Create(&backend,
+                                      {.cache_dir = temp_dir.path()}));
+  ::grpc::ServerContext context;
+  CompileResponse response;
+  CompileRequest request = MakeRequest("module fail;\nendmodule\n");
+  request.set_top_module_name("fail");
+  EXPECT_FALSE(service->Compile(&context, &request, &response).ok());
+  EXPECT_FALSE(service->Compile(&context, &request, &response).ok());
+  EXPECT_EQ(backend.calls_, 2);
+}
+
+TEST(CachingSynthesisServiceTest, ConcurrentRequests) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  CountingService backend;
+  backend.delay_ = absl::Milliseconds(20);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CachingSynthesisService> service,
+      CachingSynthesisService::Create(
+          &backend,
+          {.cache_dir = temp_dir.path(), .max_concurrent_jobs = 2}));
+
+  // Eight distinct modules, each requested by two threads at once.
+  std::vector<std::unique_ptr<Thread>> threads;
+  std::atomic<int64_t> failures = 0;
+  for (int64_t i = 0; i < 16; ++i) {
+    threads.push_back(std::make_unique<Thread>([&, i]() {
+      ::grpc::ServerContext context;
+      CompileRequest request =
+          MakeRequest(absl::StrCat("module m", i / 2, ";\nendmodule\n"));
+      CompileResponse response;
+      if (!service->Compile(&context, &request, &response).ok()) {
+        ++failures;
+      }
+    }));
+  }
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+  EXPECT_EQ(failures, 0);
+  EXPECT_EQ(backend.calls_, 8);
+  EXPECT_LE(backend.max_running_, 2);
+  EXPECT_EQ(service->hit_count(), 8);
+}
+
+TEST(CachingSynthesisServiceTest, RejectsNoJobs) {
+  CountingService backend;
+  EXPECT_THAT(
+      CachingSynthesisService::Create(&backend, {.max_concurrent_jobs = 0}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace synthesis
+}  // namespace xls
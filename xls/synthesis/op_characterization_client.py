@@ -19,12 +19,14 @@ interpolated) -- the results emitted on stdout are in
 xls.estimator_model.DataPoints prototext format.
 """
 
+import contextlib
 import multiprocessing as mp
 import multiprocessing.pool as mp_pool
 import os
 import sys
 import textwrap
-from typing import Any, Dict
+import threading
+from typing import Any, Dict, Iterator, List, Mapping, Sequence
 
 from absl import flags
 from absl import logging
@@ -68,6 +70,51 @@ _MAX_THREADS = flags.DEFINE_integer(
     max(os.cpu_count() // 2, 1),
     'Max number of threads for parallelizing the generation of data points.',
 )
+_ADAPTIVE_ROUNDS = flags.DEFINE_integer(
+    'adaptive_rounds',
+    0,
+    'Number of rounds of adaptive refinement. Each round adds sample points'
+    ' halfway between neighboring points of an op wherever interpolating'
+    ' across a point mispredicts its delay or area by more than'
+    ' --adaptive_tolerance.',
+)
+_ADAPTIVE_TOLERANCE = flags.DEFINE_float(
+    'adaptive_tolerance',
+    0.1,
+    'Relative interpolation error above which adaptive refinement adds sample'
+    ' points.',
+)
+
+
+class StubPool:
+  """Hands out stubs for a set of equivalent synthesis servers.
+
+  Each request goes to the server with the fewest requests in flight, so a
+  sweep keeps all servers busy even when the time taken by points varies
+  widely.
+  """
+
+  def __init__(
+      self, stubs: Sequence[synthesis_service_pb2_grpc.SynthesisServiceStub]
+  ):
+    if not stubs:
+      raise ValueError('At least one synthesis server stub is required.')
+    self._stubs = list(stubs)
+    self._in_flight = [0] * len(self._stubs)
+    self._lock = threading.Lock()
+
+  @contextlib.contextmanager
+  def acquire(
+      self,
+  ) -> Iterator[synthesis_service_pb2_grpc.SynthesisServiceStub]:
+    with self._lock:
+      index = min(range(len(self._stubs)), key=lambda i: self._in_flight[i])
+      self._in_flight[index] += 1
+    try:
+      yield self._stubs[index]
+    finally:
+      with self._lock:
+        self._in_flight[index] -= 1
 
 
 def get_op_name_mapping() -> Dict[str, str]:
@@ -97,12 +144,18 @@ def save_checkpoint(
     result: estimator_model_pb2.DataPoint, checkpoint_path: str, write_lock: Any
 ) -> None:
   if checkpoint_path:
+    # Write each record in one go so an interrupted run leaves at most one
+    # partial record at the end of the file, which load_checkpoints drops.
+    record = (
+        'data_points {\n'
+        + textwrap.indent(text_format.MessageToString(result), '  ')
+        + '}\n'
+    )
     write_lock.acquire()
     try:
       with gfile.open(checkpoint_path, 'a') as f:
-        f.write('data_points {\n')
-        f.write(textwrap.indent(text_format.MessageToString(result), '  '))
-        f.write('}\n')
+        f.write(record)
+        f.flush()
     finally:
       write_lock.release()
 
@@ -247,7 +300,7 @@ def _synthesize_ir(
 
 def _run_point(
     spec: estimator_model_utils.SampleSpec,
-    stub: synthesis_service_pb2_grpc.SynthesisServiceStub,
+    stubs: StubPool,
     checkpoint_write_lock: Any,
     op_name_mapping: Dict[str, str],
 ) -> estimator_model_pb2.DataPoint:
@@ -295,12 +348,13 @@ def _run_point(
       op_name, res_type, (opnd_types), attr, literal_operand, repeated_operand
   )
   logging.debug('ir_text:\n%s\n', ir_text)
-  result_dp = _synthesize_ir(
-      stub,
-      ir_text,
-      spec,
-      opnd_element_counts,
-  )
+  with stubs.acquire() as stub:
+    result_dp = _synthesize_ir(
+        stub,
+        ir_text,
+        spec,
+        opnd_element_counts,
+    )
 
   # Checkpoint after every run.
   save_checkpoint(result_dp, _CHECKPOINT_PATH.value, checkpoint_write_lock)
@@ -310,23 +364,124 @@ def _run_point(
 def load_checkpoints(checkpoint_path: str) -> estimator_model_pb2.DataPoints:
   """Loads data from a checkpoint, if available."""
   results = estimator_model_pb2.DataPoints()
-  if checkpoint_path:
+  if checkpoint_path and gfile.exists(checkpoint_path):
     with gfile.open(checkpoint_path, 'r') as f:
       contents = f.read()
-      results = text_format.Parse(contents, results)
-      logging.info(
-          'Loaded %d prior checkpointed results from %s of size %d bytes.',
-          len(results.data_points),
+    try:
+      text_format.Parse(contents, results)
+    except text_format.ParseError:
+      # A run interrupted while writing leaves a partial record at the end;
+      # drop it and keep everything before it.
+      last_record = contents.rfind('data_points {')
+      logging.warning(
+          'Dropping partial record at offset %d of checkpoint %s.',
+          last_record,
           checkpoint_path,
-          len(contents),
       )
+      results = text_format.Parse(
+          contents[: max(last_record, 0)], estimator_model_pb2.DataPoints()
+      )
+    logging.info(
+        'Loaded %d prior checkpointed results from %s of size %d bytes.',
+        len(results.data_points),
+        checkpoint_path,
+        len(contents),
+    )
   return results
 
 
+def _relative_error(predicted: float, actual: float) -> float:
+  return abs(predicted - actual) / max(abs(actual), 1.0)
+
+
+def _midpoint(
+    a: estimator_model_pb2.Parameterization,
+    b: estimator_model_pb2.Parameterization,
+) -> estimator_model_pb2.Parameterization:
+  point = estimator_model_pb2.Parameterization()
+  point.result_width = (a.result_width + b.result_width) // 2
+  point.operand_widths.extend(
+      (x + y) // 2 for x, y in zip(a.operand_widths, b.operand_widths)
+  )
+  return point
+
+
+def refine_sample_specs(
+    op_samples: estimator_model_pb2.OpSamples,
+    results: Mapping[str, estimator_model_pb2.DataPoint],
+    tolerance: float,
+) -> List[estimator_model_utils.SampleSpec]:
+  """Returns new sample points for `op_samples` where the model is poor.
+
+  The measured points of the op are ordered by result width. Wherever linearly
+  interpolating between the neighbors of a point mispredicts its delay or area
+  by more than `tolerance` (relative), points halfway between it and each
+  neighbor are proposed, unless they have been sampled already. Array-typed
+  points are not refined.
+
+  Args:
+    op_samples: The sample points of one op, all of which have results.
+    results: Data points by sample spec key.
+    tolerance: The relative error above which points are added.
+  """
+  measured = []
+  for point in op_samples.samples:
+    if point.result_element_counts or point.operand_element_counts:
+      continue
+    spec = estimator_model_utils.SampleSpec(op_samples, point)
+    key = estimator_model_utils.get_sample_spec_key(spec)
+    measured.append((point, results[key]))
+  measured.sort(key=lambda m: (m[0].result_width, tuple(m[0].operand_widths)))
+
+  new_specs = {}
+  for (lo, lo_dp), (mid, mid_dp), (hi, hi_dp) in zip(
+      measured, measured[1:], measured[2:]
+  ):
+    if lo.result_width == hi.result_width or (
+        len({len(p.operand_widths) for p in (lo, mid, hi)}) != 1
+    ):
+      continue
+    t = (mid.result_width - lo.result_width) / (
+        hi.result_width - lo.result_width
+    )
+    error = max(
+        _relative_error(
+            (1 - t) * getattr(lo_dp, field) + t * getattr(hi_dp, field),
+            getattr(mid_dp, field),
+        )
+        for field in ('delay', 'total_area')
+    )
+    if error <= tolerance:
+      continue
+    for neighbor in (lo, hi):
+      point = _midpoint(neighbor, mid)
+      if point.result_width in (neighbor.result_width, mid.result_width):
+        continue
+      spec = estimator_model_utils.SampleSpec(op_samples, point)
+      key = estimator_model_utils.get_sample_spec_key(spec)
+      if key not in results and key not in new_specs:
+        logging.info(
+            'Refining %s at result width %d (interpolation error %.2f).',
+            op_samples.op,
+            point.result_width,
+            error,
+        )
+        new_specs[key] = spec
+  return list(new_specs.values())
+
+
 def run_characterization(
-    stub: synthesis_service_pb2_grpc.SynthesisServiceStub,
+    stubs: Sequence[synthesis_service_pb2_grpc.SynthesisServiceStub],
 ) -> None:
-  """Run characterization with the given synthesis service."""
+  """Run characterization with the given equivalent synthesis services.
+
+  Points are dispatched concurrently across all of the services.
+
+  Args:
+    stubs: Stubs of one or more synthesis servers with identical
+      configurations.
+  """
+  stub_pool = StubPool(stubs)
   op_name_mapping = get_op_name_mapping()
   checkpointed_results = load_checkpoints(_CHECKPOINT_PATH.value)
   checkpoint_dict = estimator_model_utils.map_data_points_by_key(
@@ -339,34 +494,74 @@ def run_characterization(
     op_include_list.update(['kIdentity'] + _OP_INCLUDE_LIST.value)
   with gfile.open(samples_file, 'r') as f:
     op_samples_list = text_format.Parse(f.read(), op_samples_list)
-  sample_specs_without_prior_checkpoints = []
-  all_sample_spec_keys_in_order = []
-  for op_samples in op_samples_list.op_samples:
-    if not op_include_list or op_samples.op in op_include_list:
-      for point in op_samples.samples:
-        spec = estimator_model_utils.SampleSpec(op_samples, point)
-        spec_key = estimator_model_utils.get_sample_spec_key(spec)
-        all_sample_spec_keys_in_order.append(spec_key)
-        if spec_key not in checkpoint_dict:
-          sample_specs_without_prior_checkpoints.append(spec)
-  logging.debug('Using thread pool of size %d', _MAX_THREADS.value)
+  included_op_samples = [
+      op_samples
+      for op_samples in op_samples_list.op_samples
+      if not op_include_list or op_samples.op in op_include_list
+  ]
+  logging.debug(
+      'Using thread pool of size %d for %d servers',
+      _MAX_THREADS.value,
+      len(stubs),
+  )
   pool = mp_pool.ThreadPool(_MAX_THREADS.value)
   checkpoint_write_lock = mp.Lock()
-  results_dict = estimator_model_utils.map_data_points_by_key(
-      pool.starmap(
-          _run_point,
-          (
-              (request, stub, checkpoint_write_lock, op_name_mapping)
-              for request in sample_specs_without_prior_checkpoints
-          ),
+  results_dict = dict(checkpoint_dict)
+
+  def run_specs(specs: List[estimator_model_utils.SampleSpec]) -> None:
+    # Points collected by an earlier, interrupted run are not synthesized
+    # again. This includes points added by adaptive refinement, which
+    # proposes the same points again given the same results.
+    pending = [
+        spec
+        for spec in specs
+        if estimator_model_utils.get_sample_spec_key(spec) not in results_dict
+    ]
+    results_dict.update(
+        estimator_model_utils.map_data_points_by_key(
+            pool.starmap(
+                _run_point,
+                (
+                    (spec, stub_pool, checkpoint_write_lock, op_name_mapping)
+                    for spec in pending
+                ),
+            )
+        )
+    )
+
+  run_specs([
+      estimator_model_utils.SampleSpec(op_samples, point)
+      for op_samples in included_op_samples
+      for point in op_samples.samples
+  ])
+  for refinement_round in range(_ADAPTIVE_ROUNDS.value):
+    new_specs = []
+    for op_samples in included_op_samples:
+      refined = refine_sample_specs(
+          op_samples, results_dict, _ADAPTIVE_TOLERANCE.value
       )
-  )
+      # Record the new points with the op so they are ordered with its other
+      # points in the output and considered by later rounds.
+      for spec in refined:
+        point = op_samples.samples.add()
+        point.CopyFrom(spec.point)
+        new_specs.append(estimator_model_utils.SampleSpec(op_samples, point))
+    logging.info(
+        'Adaptive refinement round %d adds %d points.',
+        refinement_round,
+        len(new_specs),
+    )
+    if not new_specs:
+      break
+    run_specs(new_specs)
+
   data_points_proto = estimator_model_pb2.DataPoints()
-  for request_key in all_sample_spec_keys_in_order:
-    if request_key in checkpoint_dict:
-      data_points_proto.data_points.append(checkpoint_dict[request_key])
-    else:
-      data_points_proto.data_points.append(results_dict[request_key])
+  for op_samples in included_op_samples:
+    for point in op_samples.samples:
+      spec = estimator_model_utils.SampleSpec(op_samples, point)
+      data_points_proto.data_points.append(
+          results_dict[estimator_model_utils.get_sample_spec_key(spec)]
+      )
   logging.info(
       'Collected %d total data points.', len(data_points_proto.data_points)
   )
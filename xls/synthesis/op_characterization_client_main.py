@@ -19,6 +19,8 @@ interpolated) -- the results emitted on stdout are in
 xls.estimator_model.EstimatorModel prototext format.
 """
 
+import contextlib
+
 from absl import app
 from absl import flags
 import grpc
@@ -29,18 +31,30 @@ from xls.synthesis import synthesis_service_pb2_grpc
 
 FLAGS = flags.FLAGS
 flags.DEFINE_integer('port', 10000, 'Port to connect to synthesis server on.')
+flags.DEFINE_list(
+    'servers',
+    [],
+    'Addresses (host:port) of synthesis servers with identical'
+    ' configurations to dispatch points to concurrently. Overrides --port.',
+)
 
 
 def main(argv):
   if len(argv) != 1:
     raise app.UsageError('Unexpected arguments.')
 
+  servers = FLAGS.servers or [f'localhost:{FLAGS.port}']
   channel_creds = client_credentials.get_credentials()
-  with grpc.secure_channel(f'localhost:{FLAGS.port}', channel_creds) as channel:
-    grpc.channel_ready_future(channel).result()
-    stub = synthesis_service_pb2_grpc.SynthesisServiceStub(channel)
-
-    client.run_characterization(stub)
+  with contextlib.ExitStack() as stack:
+    stubs = []
+    for server in servers:
+      channel = stack.enter_context(
+          grpc.secure_channel(server, channel_creds)
+      )
+      grpc.channel_ready_future(channel).result()
+      stubs.append(synthesis_service_pb2_grpc.SynthesisServiceStub(channel))
+
+    client.run_characterization(stubs)
 
 
 if __name__ == '__main__':
@@ -65,6 +65,55 @@ class OpCharacterizationClientMainTest(absltest.TestCase):
     self.assertEqual(len(results.data_points), len(loaded_results_dict))
     self.assertEqual(saved_results_dict, loaded_results_dict)
 
+  def test_load_checkpoint_drops_partial_record(self):
+    result = estimator_model_pb2.DataPoint()
+    result.operation.op = "kAdd"
+    result.operation.bit_count = 8
+    result.delay = 5
+    tf = tempfile.NamedTemporaryFile()
+    client.save_checkpoint(result, tf.name, mp.Lock())
+    with open(tf.name, "a") as f:
+      f.write("data_points {\n  operation {\n    op: ")
+
+    loaded_results = client.load_checkpoints(tf.name)
+    self.assertLen(loaded_results.data_points, 1)
+    self.assertEqual(loaded_results.data_points[0], result)
+
+  def test_load_missing_checkpoint(self):
+    self.assertEmpty(client.load_checkpoints("").data_points)
+
+  def test_stub_pool_balances_in_flight_requests(self):
+    pool = client.StubPool(["a", "b"])
+    with pool.acquire() as first:
+      with pool.acquire() as second:
+        self.assertNotEqual(first, second)
+      with pool.acquire() as third:
+        self.assertEqual(third, second)
+    with self.assertRaises(ValueError):
+      client.StubPool([])
+
+  def test_refine_sample_specs(self):
+    op_samples = estimator_model_pb2.OpSamples(op="kAdd")
+    results = {}
+    # Delay is linear in the width up to 16 bits and then jumps.
+    for width, delay in ((2, 20), (8, 80), (16, 160), (32, 1000), (64, 1300)):
+      point = op_samples.samples.add(
+          result_width=width, operand_widths=[width, width]
+      )
+      spec = estimator_model_utils.SampleSpec(op_samples, point)
+      dp = estimator_model_pb2.DataPoint(delay=delay, total_area=width)
+      results[estimator_model_utils.get_sample_spec_key(spec)] = dp
+
+    refined = client.refine_sample_specs(op_samples, results, tolerance=0.1)
+    self.assertCountEqual(
+        [(spec.point.result_width, list(spec.point.operand_widths))
+         for spec in refined],
+        [(12, [12, 12]), (24, [24, 24]), (48, [48, 48])],
+    )
+    self.assertEmpty(
+        client.refine_sample_specs(op_samples, results, tolerance=10.0)
+    )
+
 
 if __name__ == "__main__":
   absltest.main()
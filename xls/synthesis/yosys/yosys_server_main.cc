@@ -18,17 +18,24 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
 #include "grpcpp/security/server_credentials.h"
 #include "grpcpp/server.h"
 #include "grpcpp/server_builder.h"
 #include "grpcpp/server_context.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
+#include "xls/common/thread.h"
+#include "xls/synthesis/caching_synthesis_service.h"
 #include "xls/synthesis/credentials.h"
 #include "xls/synthesis/yosys/yosys_synthesis_service.h"
 
@@ -44,6 +51,7 @@ Invocation:
      [--synthesis_libraries=LIB --sta_path=STAPATH --sta_libraries=STALIBS]
      *or*
      [--synthesis_only (--synthesis_target=DEV | --synthesis_libraries=LIB)]
+     [--cache_dir=DIR] [--max_concurrent_jobs=N]
 )";
 
 ABSL_FLAG(int32_t, port, 10000, "Port to listen on.");
@@ -66,11 +74,48 @@ ABSL_FLAG(std::string, default_driver_cell, "",
           "The default driver cell to use during synthesis.");
 ABSL_FLAG(std::string, default_load, "",
           "The default load cell to use during synthesis.");
+ABSL_FLAG(std::string, cache_dir, "",
+          "Directory in which to cache synthesis results keyed by the "
+          "normalized Verilog, the request and the synthesis configuration "
+          "(including the contents of the cell libraries). Identical requests "
+          "are then answered without running synthesis again.");
+ABSL_FLAG(int64_t, max_concurrent_jobs, 0,
+          "Maximum number of synthesis jobs to run at once. Zero means one per "
+          "available CPU.");
 
 namespace xls {
 namespace synthesis {
 namespace {
 
+// Returns a fingerprint of everything besides the request which determines
+// the result of synthesis.
+std::string BackendFingerprint() {
+  std::vector<std::string> libraries;
+  if (!absl::GetFlag(FLAGS_synthesis_libraries).empty()) {
+    libraries.push_back(absl::GetFlag(FLAGS_synthesis_libraries));
+  }
+  for (std::string_view library :
+       absl::StrSplit(absl::GetFlag(FLAGS_sta_libraries), ' ',
+                      absl::SkipWhitespace())) {
+    libraries.push_back(std::string(library));
+  }
+  absl::StatusOr<std::string> libraries_fingerprint =
+      FingerprintFiles(libraries);
+  QCHECK_OK(libraries_fingerprint.status())
+      << "Unable to read the cell libraries";
+  return absl::StrJoin(
+      {absl::GetFlag(FLAGS_yosys_path), absl::GetFlag(FLAGS_nextpnr_path),
+       absl::GetFlag(FLAGS_synthesis_target), absl::GetFlag(FLAGS_sta_path),
+       absl::GetFlag(FLAGS_synthesis_libraries),
+       absl::GetFlag(FLAGS_sta_libraries),
+       absl::GetFlag(FLAGS_default_driver_cell),
+       absl::GetFlag(FLAGS_default_load),
+       std::string(absl::GetFlag(FLAGS_return_netlist) ? "netlist" : ""),
+       std::string(absl::GetFlag(FLAGS_synthesis_only) ? "synth_only" : ""),
+       *libraries_fingerprint},
+      "\n");
+}
+
 void RealMain() {
   std::string yosys_path = absl::GetFlag(FLAGS_yosys_path);
   std::string nextpnr_path = absl::GetFlag(FLAGS_nextpnr_path);
@@ -115,10 +160,23 @@ void RealMain() {
       absl::GetFlag(FLAGS_default_load), absl::GetFlag(FLAGS_save_temps),
       absl::GetFlag(FLAGS_return_netlist), synthesis_only);
 
+  CachingSynthesisService::Options cache_options;
+  if (!absl::GetFlag(FLAGS_cache_dir).empty()) {
+    cache_options.cache_dir = absl::GetFlag(FLAGS_cache_dir);
+    cache_options.backend_fingerprint = BackendFingerprint();
+  }
+  cache_options.max_concurrent_jobs =
+      absl::GetFlag(FLAGS_max_concurrent_jobs) > 0
+          ? absl::GetFlag(FLAGS_max_concurrent_jobs)
+          : int64_t{AvailableCPUs()};
+  absl::StatusOr<std::unique_ptr<CachingSynthesisService>> caching_service =
+      CachingSynthesisService::Create(&service, std::move(cache_options));
+  QCHECK_OK(caching_service.status());
+
   ::grpc::ServerBuilder builder;
   std::shared_ptr<::grpc::ServerCredentials> creds = GetServerCredentials();
   builder.AddListeningPort(server_address, creds);
-  builder.RegisterService(&service);
+  builder.RegisterService(caching_service->get());
   std::unique_ptr<::grpc::Server> server(builder.BuildAndStart());
   LOG(INFO) << "Serving on port: " << port;
   LOG(INFO) << "synthesis_target: " << synthesis_target;
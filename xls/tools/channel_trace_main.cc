@@ -0,0 +1,108 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "llvm/include/llvm/IR/DataLayout.h"
+#include "xls/common/exit_status.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+#include "xls/jit/channel_trace.h"
+#include "xls/jit/jit_runtime.h"
+#include "xls/jit/orc_jit.h"
+#include "xls/tools/eval_utils.h"
+#include "xls/tools/proc_channel_values.pb.h"
+
+static constexpr std::string_view kUsage = R"(
+Converts between ProcChannelValuesProto protos, as used by eval_proc_main's
+--proto_inputs_for_all_channels, and channel traces (see
+xls/jit/channel_trace.h). If the input file is a channel trace it is converted
+to a proto, otherwise the input is read as a proto and converted to a channel
+trace. Example:
+
+  channel_trace_main --output=inputs.trace inputs.pb
+)";
+
+ABSL_FLAG(std::string, output, "", "File to write the converted values to.");
+ABSL_FLAG(bool, textproto, false,
+          "Whether protos are read and written as text rather than binary.");
+
+namespace xls {
+namespace {
+
+absl::Status RealMain(std::string_view input_path,
+                      std::string_view output_path, bool textproto) {
+  XLS_ASSIGN_OR_RETURN(MappedFile input, MappedFile::Open(input_path));
+  Package package("channel_trace");
+
+  if (IsChannelTrace(input.contents())) {
+    XLS_ASSIGN_OR_RETURN(ChannelTrace trace,
+                         ChannelTrace::Open(input_path, &package));
+    XLS_ASSIGN_OR_RETURN(
+        (absl::btree_map<std::string, std::vector<Value>> channel_values),
+        ChannelTraceToChannelValues(trace));
+    XLS_ASSIGN_OR_RETURN(ProcChannelValuesProto proto,
+                         ChannelValuesToProto(channel_values));
+    return textproto ? SetTextProtoFile(output_path, proto)
+                     : SetProtobinFile(output_path, proto);
+  }
+
+  ProcChannelValuesProto proto;
+  if (textproto) {
+    XLS_RETURN_IF_ERROR(ParseTextProto(input.contents(), input_path, &proto));
+  } else {
+    XLS_RETURN_IF_ERROR(ParseProtobin(input.contents(), input_path, &proto));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      (absl::btree_map<std::string, std::vector<Value>> channel_values),
+      ParseChannelValuesFromProto(proto));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<OrcJit> orc_jit, OrcJit::Create());
+  XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
+                       orc_jit->CreateDataLayout());
+  JitRuntime jit_runtime(data_layout);
+  return WriteChannelValuesToTrace(channel_values, &package, &jit_runtime,
+                                   output_path);
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+
+  if (positional_arguments.size() != 1) {
+    LOG(QFATAL) << absl::StreamFormat("Expected invocation: %s INPUT_FILE",
+                                      argv[0]);
+  }
+  if (absl::GetFlag(FLAGS_output).empty()) {
+    LOG(QFATAL) << "--output (converted file path) required.";
+  }
+
+  return xls::ExitStatus(xls::RealMain(positional_arguments[0],
+                                       absl::GetFlag(FLAGS_output),
+                                       absl::GetFlag(FLAGS_textproto)));
+}
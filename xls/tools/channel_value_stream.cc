@@ -0,0 +1,179 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/channel_value_stream.h"
+
+#include <cstdint>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/codegen/flattening.h"
+#include "xls/common/math_util.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/format_preference.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/ir/value_utils.h"
+
+namespace xls {
+namespace {
+
+int64_t BinaryValueSize(Type* type) {
+  return CeilOfRatio(type->GetFlatBitCount(), int64_t{8});
+}
+
+// Values of zero-width types take no room in binary streams, so the number of
+// values in such a stream can't be told.
+absl::Status CheckBinaryFormatSupportsType(std::string_view path, Type* type) {
+  if (BinaryValueSize(type) == 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Channel value stream '%s' has zero-width type %s which cannot be "
+        "encoded in binary format",
+        path, type->ToString()));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<ChannelStreamFormat> ChannelStreamFormatFromString(
+    std::string_view s) {
+  if (s == "text") {
+    return ChannelStreamFormat::kText;
+  }
+  if (s == "binary") {
+    return ChannelStreamFormat::kBinary;
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Unknown channel stream format '%s', expected 'text' or 'binary'", s));
+}
+
+absl::StatusOr<std::unique_ptr<ChannelValueReader>> ChannelValueReader::Create(
+    std::string_view path, Type* type, ChannelStreamFormat format) {
+  if (format == ChannelStreamFormat::kBinary) {
+    XLS_RETURN_IF_ERROR(CheckBinaryFormatSupportsType(path, type));
+  }
+  std::ifstream stream(std::string{path}, std::ios::in | std::ios::binary);
+  if (!stream.is_open()) {
+    return absl::NotFoundError(
+        absl::StrFormat("Unable to open channel value stream '%s'", path));
+  }
+  return absl::WrapUnique(new ChannelValueReader(
+      std::string{path}, type, format, std::move(stream)));
+}
+
+absl::StatusOr<std::optional<Value>> ChannelValueReader::Read() {
+  if (format_ == ChannelStreamFormat::kBinary) {
+    std::vector<uint8_t> bytes(BinaryValueSize(type_));
+    stream_.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+    int64_t byte_count = stream_.gcount();
+    if (byte_count == 0 && stream_.eof()) {
+      return std::nullopt;
+    }
+    if (byte_count != static_cast<int64_t>(bytes.size())) {
+      return absl::DataLossError(absl::StrFormat(
+          "Truncated value %d in channel value stream '%s': expected %d "
+          "bytes, got %d",
+          read_count_, path_, bytes.size(), byte_count));
+    }
+    XLS_ASSIGN_OR_RETURN(
+        Value value,
+        UnflattenBitsToValue(
+            Bits::FromBytes(bytes, type_->GetFlatBitCount()), type_));
+    ++read_count_;
+    return value;
+  }
+
+  std::string line;
+  while (std::getline(stream_, line)) {
+    std::string_view text = absl::StripAsciiWhitespace(line);
+    if (text.empty()) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(Value value, Parser::ParseTypedValue(text));
+    if (!ValueConformsToType(value, type_)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Value %d in channel value stream '%s' is %s, expected type %s",
+          read_count_, path_, value.ToString(), type_->ToString()));
+    }
+    ++read_count_;
+    return value;
+  }
+  if (stream_.bad()) {
+    return absl::DataLossError(absl::StrFormat(
+        "Error reading channel value stream '%s'", path_));
+  }
+  return std::nullopt;
+}
+
+absl::StatusOr<std::unique_ptr<ChannelValueWriter>> ChannelValueWriter::Create(
+    std::string_view path, Type* type, ChannelStreamFormat format) {
+  if (format == ChannelStreamFormat::kBinary) {
+    XLS_RETURN_IF_ERROR(CheckBinaryFormatSupportsType(path, type));
+  }
+  std::ofstream stream(std::string{path},
+                       std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!stream.is_open()) {
+    return absl::NotFoundError(
+        absl::StrFormat("Unable to open channel value stream '%s'", path));
+  }
+  return absl::WrapUnique(new ChannelValueWriter(
+      std::string{path}, type, format, std::move(stream)));
+}
+
+absl::Status ChannelValueWriter::Write(const Value& value) {
+  if (!ValueConformsToType(value, type_)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Cannot write %s to channel value stream '%s' of type %s",
+        value.ToString(), path_, type_->ToString()));
+  }
+  if (format_ == ChannelStreamFormat::kBinary) {
+    std::vector<uint8_t> bytes(BinaryValueSize(type_));
+    FlattenValueToBits(value).ToBytes(absl::MakeSpan(bytes));
+    stream_.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  } else {
+    stream_ << value.ToString(FormatPreference::kHex) << "\n";
+  }
+  if (!stream_.good()) {
+    return absl::DataLossError(absl::StrFormat(
+        "Error writing channel value stream '%s'", path_));
+  }
+  ++write_count_;
+  return absl::OkStatus();
+}
+
+absl::Status ChannelValueWriter::Flush() {
+  stream_.flush();
+  if (!stream_.good()) {
+    return absl::DataLossError(absl::StrFormat(
+        "Error flushing channel value stream '%s'", path_));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace xls
@@ -0,0 +1,105 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_TOOLS_CHANNEL_VALUE_STREAM_H_
+#define XLS_TOOLS_CHANNEL_VALUE_STREAM_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// Encoding of the values of a channel in a stream.
+enum class ChannelStreamFormat : uint8_t {
+  // One XLS Value in human-readable form per line, as in the files given to
+  // ParseValuesFile. Blank lines are skipped.
+  kText,
+  // Values back to back, each flattened to bits (see FlattenValueToBits) and
+  // stored in ceil(flat_bit_count / 8) bytes, least significant byte first.
+  // A stream of bits[8] values is thus a plain byte stream.
+  kBinary,
+};
+
+absl::StatusOr<ChannelStreamFormat> ChannelStreamFormatFromString(
+    std::string_view s);
+
+// Reads the values of a channel one at a time from a file, which may be a
+// pipe, so that arbitrarily long streams can be simulated in bounded memory.
+class ChannelValueReader {
+ public:
+  static absl::StatusOr<std::unique_ptr<ChannelValueReader>> Create(
+      std::string_view path, Type* type, ChannelStreamFormat format);
+
+  // Returns the next value of the stream, or std::nullopt once it is
+  // exhausted.
+  absl::StatusOr<std::optional<Value>> Read();
+
+  // Number of values returned by Read so far.
+  int64_t read_count() const { return read_count_; }
+
+ private:
+  ChannelValueReader(std::string path, Type* type, ChannelStreamFormat format,
+                     std::ifstream stream)
+      : path_(std::move(path)),
+        type_(type),
+        format_(format),
+        stream_(std::move(stream)) {}
+
+  std::string path_;
+  Type* type_;
+  ChannelStreamFormat format_;
+  std::ifstream stream_;
+  int64_t read_count_ = 0;
+};
+
+// Writes the values of a channel one at a time to a file, which may be a pipe.
+class ChannelValueWriter {
+ public:
+  static absl::StatusOr<std::unique_ptr<ChannelValueWriter>> Create(
+      std::string_view path, Type* type, ChannelStreamFormat format);
+
+  absl::Status Write(const Value& value);
+  absl::Status Flush();
+
+  // Number of values written so far.
+  int64_t write_count() const { return write_count_; }
+
+ private:
+  ChannelValueWriter(std::string path, Type* type, ChannelStreamFormat format,
+                     std::ofstream stream)
+      : path_(std::move(path)),
+        type_(type),
+        format_(format),
+        stream_(std::move(stream)) {}
+
+  std::string path_;
+  Type* type_;
+  ChannelStreamFormat format_;
+  std::ofstream stream_;
+  int64_t write_count_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_TOOLS_CHANNEL_VALUE_STREAM_H_
@@ -0,0 +1,165 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/channel_value_stream.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/package.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::Optional;
+using ::testing::SizeIs;
+
+TEST(ChannelValueStreamTest, ReadText) {
+  Package package("p");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TempFile file, TempFile::CreateWithContent(
+                         "bits[32]:42\n\n  bits[32]:0x10  \nbits[32]:7\n"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ChannelValueReader> reader,
+      ChannelValueReader::Create(file.path().string(), package.GetBitsType(32),
+                                 ChannelStreamFormat::kText));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(Optional(Value(UBits(42, 32)))));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(Optional(Value(UBits(16, 32)))));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(Optional(Value(UBits(7, 32)))));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(std::nullopt));
+  EXPECT_EQ(reader->read_count(), 3);
+}
+
+TEST(ChannelValueStreamTest, ReadTextWithWrongType) {
+  Package package("p");
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file,
+                           TempFile::CreateWithContent("bits[8]:42\n"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ChannelValueReader> reader,
+      ChannelValueReader::Create(file.path().string(), package.GetBitsType(32),
+                                 ChannelStreamFormat::kText));
+  EXPECT_THAT(reader->Read(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                       HasSubstr("expected type bits[32]")));
+}
+
+TEST(ChannelValueStreamTest, ReadBinary) {
+  Package package("p");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TempFile file,
+      TempFile::CreateWithContent(std::string("\x34\x12\xff\x00", 4)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ChannelValueReader> reader,
+      ChannelValueReader::Create(file.path().string(), package.GetBitsType(12),
+                                 ChannelStreamFormat::kBinary));
+  EXPECT_THAT(reader->Read(),
+              IsOkAndHolds(Optional(Value(UBits(0x234, 12)))));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(Optional(Value(UBits(0xff, 12)))));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(std::nullopt));
+}
+
+TEST(ChannelValueStreamTest, ReadTruncatedBinary) {
+  Package package("p");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TempFile file, TempFile::CreateWithContent(std::string("\x01\x02\x03")));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ChannelValueReader> reader,
+      ChannelValueReader::Create(file.path().string(), package.GetBitsType(16),
+                                 ChannelStreamFormat::kBinary));
+  EXPECT_THAT(reader->Read(),
+              IsOkAndHolds(Optional(Value(UBits(0x0201, 16)))));
+  EXPECT_THAT(reader->Read(), StatusIs(absl::StatusCode::kDataLoss,
+                                       HasSubstr("Truncated value 1")));
+}
+
+TEST(ChannelValueStreamTest, BinaryRoundTripOfTuples) {
+  Package package("p");
+  Type* type =
+      package.GetTupleType({package.GetBitsType(3),
+                            package.GetArrayType(2, package.GetBitsType(5))});
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file, TempFile::Create());
+  Value a = Value::Tuple(
+      {Value(UBits(5, 3)),
+       Value::ArrayOrDie({Value(UBits(17, 5)), Value(UBits(30, 5))})});
+  Value b = Value::Tuple(
+      {Value(UBits(2, 3)),
+       Value::ArrayOrDie({Value(UBits(1, 5)), Value(UBits(0, 5))})});
+  {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<ChannelValueWriter> writer,
+        ChannelValueWriter::Create(file.path().string(), type,
+                                   ChannelStreamFormat::kBinary));
+    XLS_ASSERT_OK(writer->Write(a));
+    XLS_ASSERT_OK(writer->Write(b));
+    XLS_ASSERT_OK(writer->Flush());
+    EXPECT_EQ(writer->write_count(), 2);
+  }
+  // 13 bits per value.
+  EXPECT_THAT(GetFileContents(file.path()), IsOkAndHolds(SizeIs(4)));
+
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ChannelValueReader> reader,
+      ChannelValueReader::Create(file.path().string(), type,
+                                 ChannelStreamFormat::kBinary));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(Optional(a)));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(Optional(b)));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(std::nullopt));
+}
+
+TEST(ChannelValueStreamTest, TextRoundTrip) {
+  Package package("p");
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file, TempFile::Create());
+  {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<ChannelValueWriter> writer,
+        ChannelValueWriter::Create(file.path().string(),
+                                   package.GetBitsType(8),
+                                   ChannelStreamFormat::kText));
+    XLS_ASSERT_OK(writer->Write(Value(UBits(200, 8))));
+    EXPECT_THAT(writer->Write(Value(UBits(1, 9))),
+                StatusIs(absl::StatusCode::kInvalidArgument));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<ChannelValueReader> reader,
+      ChannelValueReader::Create(file.path().string(), package.GetBitsType(8),
+                                 ChannelStreamFormat::kText));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(Optional(Value(UBits(200, 8)))));
+  EXPECT_THAT(reader->Read(), IsOkAndHolds(std::nullopt));
+}
+
+TEST(ChannelValueStreamTest, BinaryRejectsZeroWidthTypes) {
+  Package package("p");
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile file, TempFile::Create());
+  EXPECT_THAT(ChannelValueReader::Create(file.path().string(),
+                                         package.GetTupleType({}),
+                                         ChannelStreamFormat::kBinary),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("zero-width")));
+}
+
+}  // namespace
+}  // namespace xls
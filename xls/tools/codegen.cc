@@ -401,6 +401,13 @@ absl::StatusOr<verilog::CodegenOptions> CodegenOptionsFromProto(
   if (p.has_codegen_version()) {
     options.codegen_version(p.codegen_version());
   }
+  if (!p.module_cache_dir().empty()) {
+    options.module_cache_dir(p.module_cache_dir());
+  }
+  options.retime_registers(p.retime_registers());
+  options.share_resources(p.share_resources());
+  options.instantiated_functions(std::vector<std::string>(
+      p.instantiated_functions().begin(), p.instantiated_functions().end()));
 
   return options;
 }
@@ -166,6 +166,26 @@ ABSL_FLAG(std::string, simulation_macro_name, "SIMULATION",
 ABSL_FLAG(int64_t, codegen_version, 0,
           "Version of codegen to use.  Either 2 (refactored codegen), 1 "
           "(orignal codegen path), or 0 for default");
+ABSL_FLAG(std::string, module_cache_dir, "",
+          "Directory in which to cache the Verilog generated for each block. "
+          "Blocks whose IR and options are unchanged since a previous run "
+          "sharing the directory reuse the cached module. Empty disables "
+          "caching.");
+ABSL_FLAG(bool, retime_registers, false,
+          "Retime pipeline registers across the combinational nodes at stage "
+          "boundaries, using the delay model, where this lowers the flop "
+          "count or the delay of the slower stage without lengthening the "
+          "critical path of the pipeline.");
+ABSL_FLAG(bool, share_resources, false,
+          "Share one multiplier, divider or modulo between mutually exclusive "
+          "uses of the same width in a pipeline stage, where the delay model "
+          "shows the operand muxes do not lengthen the critical path of the "
+          "pipeline.");
+ABSL_FLAG(std::vector<std::string>, instantiated_functions, {},
+          "A comma-separated list of functions whose invocations are emitted "
+          "as instantiations of one Verilog module per function instead of "
+          "being inlined. The IR given to codegen must still contain these "
+          "invocations.");
 
 // LINT.ThenChange(
 //   //xls/build_rules/xls_providers.bzl,
@@ -258,6 +278,10 @@ static absl::StatusOr<bool> SetOptionsFromFlags(CodegenFlagsProto &proto) {
   proto.set_flop_outputs_kind(flop_outputs_kind);
 
   POPULATE_FLAG(codegen_version);
+  POPULATE_FLAG(module_cache_dir);
+  POPULATE_FLAG(retime_registers);
+  POPULATE_FLAG(share_resources);
+  POPULATE_REPEATED_FLAG(instantiated_functions);
   POPULATE_FLAG(flop_single_value_channels);
   POPULATE_FLAG(add_idle_output);
   POPULATE_FLAG(module_name);
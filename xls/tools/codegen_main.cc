@@ -25,15 +25,18 @@
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "xls/codegen/module_signature.h"
 #include "xls/common/exit_status.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
+#include "xls/common/persistent_worker.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/dev_tools/tool_timeout.h"
+#include "xls/ir/binary_ir.h"
+#include "xls/ir/block.h"
 #include "xls/ir/function_base.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/verifier.h"
 #include "xls/scheduling/pipeline_schedule.pb.h"
 #include "xls/scheduling/scheduling_options.h"
@@ -68,7 +71,7 @@ absl::Status RealMain(std::string_view ir_path) {
   }
   XLS_ASSIGN_OR_RETURN(std::string ir_contents, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> p,
-                       Parser::ParsePackage(ir_contents, ir_path));
+                       ParsePackageTextOrBinary(ir_contents, ir_path));
 
   XLS_ASSIGN_OR_RETURN(CodegenFlagsProto codegen_flags_proto,
                        GetCodegenFlags());
@@ -114,6 +117,12 @@ absl::Status RealMain(std::string_view ir_path) {
     QCHECK_GE(p->blocks().size(), 1)
         << "There should be at least one block in the package after generating "
            "module text.";
+    // Make the block of the top module the top of the package so the block IR
+    // can be simulated or compiled (e.g. with the block JIT) as a model of the
+    // generated RTL without naming the block.
+    XLS_ASSIGN_OR_RETURN(Block * top_block,
+                         p->GetBlock(result.signature.module_name()));
+    XLS_RETURN_IF_ERROR(p->SetTop(top_block));
     XLS_RETURN_IF_ERROR(SetFileContents(
         absl::GetFlag(FLAGS_output_block_ir_path), p->DumpIr()));
   }
@@ -153,6 +162,16 @@ int main(int argc, char** argv) {
   std::vector<std::string_view> positional_arguments =
       xls::InitXls(kUsage, argc, argv);
 
+  if (xls::IsPersistentWorker()) {
+    return xls::RunPersistentWorker(
+        argv[0], [](absl::Span<const std::string_view> positional_arguments) {
+          if (positional_arguments.size() != 1) {
+            return absl::InvalidArgumentError(
+                "Expected invocation: codegen_main IR_FILE");
+          }
+          return xls::RealMain(positional_arguments[0]);
+        });
+  }
   if (positional_arguments.size() != 1) {
     LOG(QFATAL) << absl::StreamFormat("Expected invocation: %s IR_FILE",
                                       argv[0]);
@@ -185,6 +185,25 @@ class CodeGenMainTest(parameterized.TestCase):
       self.assertEqual(sig_proto.module_name, 'not_add')
       self.assertTrue(sig_proto.HasField('combinational'))
 
+  def test_block_ir_top_is_generated_block(self):
+    ir_file = self.create_tempfile(content=NOT_ADD_IR)
+    block_ir_path = test_base.create_named_output_text_file('not_add.block.ir')
+
+    subprocess.check_call([
+        CODEGEN_MAIN_PATH,
+        '--generator=pipeline',
+        '--delay_model=unit',
+        '--pipeline_stages=2',
+        '--module_name=not_add_pipeline',
+        '--alsologtostderr',
+        '--top=not_add',
+        '--output_block_ir_path=' + block_ir_path,
+        ir_file.full_path,
+    ])
+
+    with open(block_ir_path, 'r') as f:
+      self.assertIn('top block not_add_pipeline(', f.read())
+
   def test_combinational_verilog_to_stdout(self):
     ir_file = self.create_tempfile(content=NOT_ADD_IR)
     verilog = subprocess.check_output([
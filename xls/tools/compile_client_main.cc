@@ -0,0 +1,231 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "grpcpp/channel.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/create_channel.h"
+#include "grpcpp/support/status.h"
+#include "xls/common/exit_status.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/init_xls.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/ir_convert/ir_converter_options_flags.pb.h"
+#include "xls/synthesis/credentials.h"
+#include "xls/tools/compile_service.grpc.pb.h"
+#include "xls/tools/compile_service.pb.h"
+
+static constexpr std::string_view kUsage = R"(
+Thin client of compile_server_main. Sends a single request to the server and
+writes the results where the corresponding tool would.
+
+The request is read in text format from --request_textproto, without its
+inputs, which are given as positional arguments:
+
+  compile_client_main --action=ir_convert --request_textproto=REQ DSLX_FILE...
+  compile_client_main --action=opt --request_textproto=REQ IR_FILE
+  compile_client_main --action=codegen --request_textproto=REQ IR_FILE
+
+where REQ holds a ConvertDslxRequest, OptimizeRequest or CodegenRequest
+respectively (see compile_service.proto).
+)";
+
+ABSL_FLAG(std::string, server, "localhost:10001",
+          "Address of the compile server.");
+ABSL_FLAG(std::string, action, "",
+          "The request to send: ir_convert, opt or codegen.");
+ABSL_FLAG(std::string, request_textproto, "",
+          "File holding the request in text format. If empty the request "
+          "holds only the inputs.");
+ABSL_FLAG(std::string, output_path, "-",
+          "Path to write the IR produced by ir_convert and opt to; '-' for "
+          "stdout. The output files named by the options of an ir_convert "
+          "request are written as ir_converter_main would.");
+// The following are the codegen_main flags of the same names.
+ABSL_FLAG(std::string, output_verilog_path, "",
+          "Path to write the Verilog to; stdout if empty.");
+ABSL_FLAG(std::string, output_signature_path, "",
+          "Path to write the module signature text proto to.");
+ABSL_FLAG(std::string, output_schedule_path, "",
+          "Path to write the schedule text proto to.");
+ABSL_FLAG(std::string, output_schedule_ir_path, "",
+          "Path to write the IR after scheduling and codegen to.");
+ABSL_FLAG(std::string, output_block_ir_path, "",
+          "Path to write the block IR to.");
+ABSL_FLAG(std::string, output_verilog_line_map_path, "",
+          "Path to write the Verilog line map text proto to.");
+
+namespace xls {
+namespace {
+
+absl::Status GrpcToAbslStatus(const ::grpc::Status& grpc_status) {
+  // The status code enums match up.
+  return absl::Status(
+      static_cast<absl::StatusCode>(static_cast<int>(grpc_status.error_code())),
+      grpc_status.error_message());
+}
+
+template <typename Request>
+absl::StatusOr<Request> ReadRequest() {
+  Request request;
+  std::string path = absl::GetFlag(FLAGS_request_textproto);
+  if (!path.empty()) {
+    XLS_RETURN_IF_ERROR(ParseTextProtoFile(path, &request));
+  }
+  return request;
+}
+
+absl::Status WriteOutput(std::string_view path, std::string_view contents) {
+  if (path == "-") {
+    std::cout << contents;
+    return absl::OkStatus();
+  }
+  return SetFileContents(path, contents);
+}
+
+absl::Status ConvertDslx(CompileService::Stub& stub,
+                         absl::Span<const std::string_view> inputs) {
+  XLS_ASSIGN_OR_RETURN(ConvertDslxRequest request,
+                       ReadRequest<ConvertDslxRequest>());
+  for (std::string_view input : inputs) {
+    request.add_paths(std::string(input));
+  }
+  ConvertDslxResponse response;
+  ::grpc::ClientContext context;
+  XLS_RETURN_IF_ERROR(
+      GrpcToAbslStatus(stub.ConvertDslx(&context, request, &response)));
+
+  const IrConverterOptionsFlagsProto& options = request.options();
+  XLS_RETURN_IF_ERROR(WriteOutput(options.has_output_file()
+                                      ? options.output_file()
+                                      : absl::GetFlag(FLAGS_output_path),
+                                  response.ir()));
+  if (options.has_interface_proto_file()) {
+    XLS_RETURN_IF_ERROR(
+        SetFileContents(options.interface_proto_file(),
+                        response.interface().SerializeAsString()));
+  }
+  if (options.has_interface_textproto_file()) {
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(options.interface_textproto_file(),
+                                         response.interface()));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Optimize(CompileService::Stub& stub, std::string_view input) {
+  XLS_ASSIGN_OR_RETURN(OptimizeRequest request,
+                       ReadRequest<OptimizeRequest>());
+  XLS_ASSIGN_OR_RETURN(*request.mutable_ir(), GetFileContents(input));
+  OptimizeResponse response;
+  ::grpc::ClientContext context;
+  XLS_RETURN_IF_ERROR(
+      GrpcToAbslStatus(stub.Optimize(&context, request, &response)));
+  return WriteOutput(absl::GetFlag(FLAGS_output_path), response.ir());
+}
+
+absl::Status Codegen(CompileService::Stub& stub, std::string_view input) {
+  XLS_ASSIGN_OR_RETURN(CodegenRequest request, ReadRequest<CodegenRequest>());
+  XLS_ASSIGN_OR_RETURN(*request.mutable_ir(), GetFileContents(input));
+  const std::string schedule_ir_path =
+      absl::GetFlag(FLAGS_output_schedule_ir_path);
+  const std::string block_ir_path = absl::GetFlag(FLAGS_output_block_ir_path);
+  request.set_return_schedule_ir(!schedule_ir_path.empty());
+  request.set_return_block_ir(!block_ir_path.empty());
+  CodegenResponse response;
+  ::grpc::ClientContext context;
+  XLS_RETURN_IF_ERROR(
+      GrpcToAbslStatus(stub.Codegen(&context, request, &response)));
+
+  if (!schedule_ir_path.empty()) {
+    XLS_RETURN_IF_ERROR(
+        SetFileContents(schedule_ir_path, response.schedule_ir()));
+  }
+  if (const std::string path = absl::GetFlag(FLAGS_output_schedule_path);
+      !path.empty()) {
+    if (response.has_schedule()) {
+      XLS_RETURN_IF_ERROR(SetTextProtoFile(path, response.schedule()));
+    } else {
+      XLS_RETURN_IF_ERROR(SetFileContents(path, ""));
+    }
+  }
+  if (!block_ir_path.empty()) {
+    XLS_RETURN_IF_ERROR(SetFileContents(block_ir_path, response.block_ir()));
+  }
+  if (const std::string path = absl::GetFlag(FLAGS_output_signature_path);
+      !path.empty()) {
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(path, response.signature()));
+  }
+  const std::string verilog_path = absl::GetFlag(FLAGS_output_verilog_path);
+  if (!verilog_path.empty()) {
+    for (int64_t i = 0; i < response.verilog_line_map().mapping_size(); ++i) {
+      response.mutable_verilog_line_map()->mutable_mapping(i)->set_verilog_file(
+          verilog_path);
+    }
+  }
+  if (const std::string path =
+          absl::GetFlag(FLAGS_output_verilog_line_map_path);
+      !path.empty()) {
+    XLS_RETURN_IF_ERROR(SetTextProtoFile(path, response.verilog_line_map()));
+  }
+  return WriteOutput(verilog_path.empty() ? "-" : verilog_path,
+                     response.verilog());
+}
+
+absl::Status RealMain(absl::Span<const std::string_view> inputs) {
+  std::shared_ptr<::grpc::Channel> channel = ::grpc::CreateChannel(
+      absl::GetFlag(FLAGS_server), synthesis::GetChannelCredentials());
+  std::unique_ptr<CompileService::Stub> stub =
+      CompileService::NewStub(channel);
+  const std::string action = absl::GetFlag(FLAGS_action);
+  if (action == "ir_convert") {
+    return ConvertDslx(*stub, inputs);
+  }
+  XLS_RET_CHECK_EQ(inputs.size(), 1) << "Expected a single IR file";
+  if (action == "opt") {
+    return Optimize(*stub, inputs.front());
+  }
+  if (action == "codegen") {
+    return Codegen(*stub, inputs.front());
+  }
+  return absl::InvalidArgumentError(
+      absl::StrFormat("Unknown --action `%s`; expected ir_convert, opt or "
+                      "codegen",
+                      action));
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  if (positional_arguments.empty()) {
+    LOG(QFATAL) << absl::StreamFormat(
+        "Expected invocation: %s --action=ACTION [flags] INPUT...", argv[0]);
+  }
+  return xls::ExitStatus(xls::RealMain(positional_arguments));
+}
@@ -0,0 +1,89 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "grpcpp/resource_quota.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "xls/common/exit_status.h"
+#include "xls/common/init_xls.h"
+#include "xls/synthesis/credentials.h"
+#include "xls/tools/compile_service.h"
+
+static constexpr std::string_view kUsage = R"(
+Launches a server which runs DSLX to IR conversion, optimization and codegen
+requests (see compile_service.proto) in a single long-lived process. Build
+systems invoking these steps many times pay for process startup and one-time
+initialization only once. Independent requests are processed concurrently.
+
+Requests are typically sent with compile_client_main. DSLX files named in
+requests are read from the filesystem of the server.
+
+Invocation:
+
+  compile_server_main --port=10001
+)";
+
+ABSL_FLAG(int32_t, port, 10001, "Port to listen on.");
+ABSL_FLAG(int64_t, max_threads, 0,
+          "Maximum number of threads used to process requests concurrently. "
+          "If zero the gRPC default is used.");
+
+namespace xls {
+namespace {
+
+absl::Status RealMain() {
+  int port = absl::GetFlag(FLAGS_port);
+  std::string server_address = absl::StrCat("0.0.0.0:", port);
+  CompileServiceImpl service;
+
+  ::grpc::ServerBuilder builder;
+  builder.AddListeningPort(server_address, synthesis::GetServerCredentials());
+  if (int64_t max_threads = absl::GetFlag(FLAGS_max_threads); max_threads > 0) {
+    ::grpc::ResourceQuota quota;
+    quota.SetMaxThreads(max_threads);
+    builder.SetResourceQuota(quota);
+  }
+  builder.RegisterService(&service);
+  std::unique_ptr<::grpc::Server> server(builder.BuildAndStart());
+  if (server == nullptr) {
+    return absl::UnavailableError(
+        absl::StrCat("Unable to serve on ", server_address));
+  }
+  LOG(INFO) << "Serving on port: " << port;
+  server->Wait();
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace xls
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> positional_arguments =
+      xls::InitXls(kUsage, argc, argv);
+  if (!positional_arguments.empty()) {
+    LOG(QFATAL) << "Expected invocation: " << argv[0] << " [--port=PORT]";
+  }
+  return xls::ExitStatus(xls::RealMain());
+}
@@ -0,0 +1,163 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/compile_service.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "xls/codegen/module_signature.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/dslx/ir_convert/conversion_cache.h"
+#include "xls/dslx/ir_convert/ir_converter_driver.h"
+#include "xls/ir/binary_ir.h"
+#include "xls/ir/block.h"
+#include "xls/ir/package.h"
+#include "xls/scheduling/scheduling_options.h"
+#include "xls/tools/codegen.h"
+#include "xls/tools/compile_service.pb.h"
+#include "xls/tools/opt.h"
+
+namespace xls {
+namespace {
+
+::grpc::Status ToGrpcStatus(const absl::Status& status) {
+  // The status code enums match up.
+  return ::grpc::Status(static_cast<::grpc::StatusCode>(status.code()),
+                        std::string(status.message()));
+}
+
+template <typename Response>
+::grpc::Status Respond(absl::StatusOr<Response> result, Response* response) {
+  if (!result.ok()) {
+    return ToGrpcStatus(result.status());
+  }
+  *response = *std::move(result);
+  return ::grpc::Status::OK;
+}
+
+}  // namespace
+
+absl::StatusOr<ConvertDslxResponse> HandleConvertDslxRequest(
+    const ConvertDslxRequest& request) {
+  XLS_RET_CHECK(!request.paths().empty()) << "No DSLX files given";
+  std::vector<std::string_view> paths(request.paths().begin(),
+                                      request.paths().end());
+  bool printed_error = false;
+  XLS_ASSIGN_OR_RETURN(dslx::CachedConversion conversion,
+                       dslx::ConvertFilesWithOptions(paths, request.options(),
+                                                     &printed_error));
+  if (printed_error) {
+    return absl::InternalError(
+        "IR conversion failed with an earlier non-fatal error.");
+  }
+  ConvertDslxResponse response;
+  response.set_ir(std::move(conversion.ir_text));
+  *response.mutable_interface() = std::move(conversion.interface);
+  return response;
+}
+
+absl::StatusOr<OptimizeResponse> HandleOptimizeRequest(
+    const OptimizeRequest& request) {
+  tools::OptOptions options{
+      .top = request.top(),
+      .skip_passes = std::vector<std::string>(request.skip_passes().begin(),
+                                              request.skip_passes().end()),
+      .inline_procs = request.inline_procs(),
+  };
+  if (request.has_opt_level()) {
+    options.opt_level = request.opt_level();
+  }
+  if (request.has_passes()) {
+    options.pass_pipeline = std::string_view(request.passes());
+  }
+  if (request.has_function_base_parallelism()) {
+    options.function_base_parallelism = request.function_base_parallelism();
+  }
+  if (request.has_node_parallelism()) {
+    options.node_parallelism = request.node_parallelism();
+  }
+  XLS_ASSIGN_OR_RETURN(std::string ir,
+                       tools::OptimizeIrForTop(request.ir(), options));
+  OptimizeResponse response;
+  response.set_ir(std::move(ir));
+  return response;
+}
+
+absl::StatusOr<CodegenResponse> HandleCodegenRequest(
+    const CodegenRequest& request) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> p,
+                       ParsePackageTextOrBinary(request.ir()));
+  if (!request.codegen_options().top().empty()) {
+    XLS_RETURN_IF_ERROR(p->SetTopByName(request.codegen_options().top()));
+  }
+  XLS_RET_CHECK(p->GetTop().has_value())
+      << "Package " << p->name() << " needs a top function/proc.";
+
+  XLS_ASSIGN_OR_RETURN(
+      bool delay_model_specified,
+      IsDelayModelSpecifiedViaFlag(request.scheduling_options()));
+  XLS_ASSIGN_OR_RETURN(
+      CodegenResult result,
+      ScheduleAndCodegen(p.get(), request.scheduling_options(),
+                         request.codegen_options(), delay_model_specified));
+  verilog::ModuleGeneratorResult& module = result.module_generator_result;
+
+  CodegenResponse response;
+  response.set_verilog(std::move(module.verilog_text));
+  *response.mutable_signature() = module.signature.proto();
+  if (result.package_pipeline_schedules_proto.has_value()) {
+    *response.mutable_schedule() =
+        *std::move(result.package_pipeline_schedules_proto);
+  }
+  *response.mutable_verilog_line_map() = std::move(module.verilog_line_map);
+  if (request.return_schedule_ir()) {
+    response.set_schedule_ir(p->DumpIr());
+  }
+  if (request.return_block_ir()) {
+    XLS_ASSIGN_OR_RETURN(Block * top_block,
+                         p->GetBlock(module.signature.module_name()));
+    XLS_RETURN_IF_ERROR(p->SetTop(top_block));
+    response.set_block_ir(p->DumpIr());
+  }
+  return response;
+}
+
+::grpc::Status CompileServiceImpl::ConvertDslx(
+    ::grpc::ServerContext* context, const ConvertDslxRequest* request,
+    ConvertDslxResponse* response) {
+  return Respond(HandleConvertDslxRequest(*request), response);
+}
+
+::grpc::Status CompileServiceImpl::Optimize(::grpc::ServerContext* context,
+                                            const OptimizeRequest* request,
+                                            OptimizeResponse* response) {
+  return Respond(HandleOptimizeRequest(*request), response);
+}
+
+::grpc::Status CompileServiceImpl::Codegen(::grpc::ServerContext* context,
+                                           const CodegenRequest* request,
+                                           CodegenResponse* response) {
+  return Respond(HandleCodegenRequest(*request), response);
+}
+
+}  // namespace xls
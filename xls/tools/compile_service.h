@@ -0,0 +1,52 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Library that backs the `compile_server_main` tool. The Handle* functions
+// perform a single request and are safe to call concurrently.
+
+#ifndef XLS_TOOLS_COMPILE_SERVICE_H_
+#define XLS_TOOLS_COMPILE_SERVICE_H_
+
+#include "absl/status/statusor.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "xls/tools/compile_service.grpc.pb.h"
+#include "xls/tools/compile_service.pb.h"
+
+namespace xls {
+
+absl::StatusOr<ConvertDslxResponse> HandleConvertDslxRequest(
+    const ConvertDslxRequest& request);
+absl::StatusOr<OptimizeResponse> HandleOptimizeRequest(
+    const OptimizeRequest& request);
+absl::StatusOr<CodegenResponse> HandleCodegenRequest(
+    const CodegenRequest& request);
+
+// Service implementation dispatching to the functions above.
+class CompileServiceImpl : public CompileService::Service {
+ public:
+  ::grpc::Status ConvertDslx(::grpc::ServerContext* context,
+                             const ConvertDslxRequest* request,
+                             ConvertDslxResponse* response) override;
+  ::grpc::Status Optimize(::grpc::ServerContext* context,
+                          const OptimizeRequest* request,
+                          OptimizeResponse* response) override;
+  ::grpc::Status Codegen(::grpc::ServerContext* context,
+                         const CodegenRequest* request,
+                         CodegenResponse* response) override;
+};
+
+}  // namespace xls
+
+#endif  // XLS_TOOLS_COMPILE_SERVICE_H_
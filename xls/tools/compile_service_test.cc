@@ -0,0 +1,101 @@
+// Copyright 2024 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/compile_service.h"
+
+#include <filesystem>  // NOLINT
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/tools/codegen_flags.pb.h"
+#include "xls/tools/compile_service.pb.h"
+
+namespace xls {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+constexpr char kIr[] = R"(package test
+
+top fn main(x: bits[32] id=1, y: bits[32] id=2) -> bits[32] {
+  literal.3: bits[32] = literal(value=0, id=3)
+  add.4: bits[32] = add(x, literal.3, id=4)
+  ret add.5: bits[32] = add(add.4, y, id=5)
+}
+)";
+
+TEST(CompileServiceTest, Optimize) {
+  OptimizeRequest request;
+  request.set_ir(kIr);
+  request.set_top("main");
+  XLS_ASSERT_OK_AND_ASSIGN(OptimizeResponse response,
+                           HandleOptimizeRequest(request));
+  EXPECT_THAT(response.ir(), HasSubstr("add(x, y"));
+  EXPECT_THAT(response.ir(), Not(HasSubstr("literal")));
+}
+
+TEST(CompileServiceTest, OptimizeInvalidIr) {
+  OptimizeRequest request;
+  request.set_ir("package test\n\nfn main(");
+  EXPECT_THAT(HandleOptimizeRequest(request),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(CompileServiceTest, CodegenCombinational) {
+  CodegenRequest request;
+  request.set_ir(kIr);
+  request.set_return_block_ir(true);
+  CodegenFlagsProto& codegen = *request.mutable_codegen_options();
+  codegen.set_generator(GENERATOR_KIND_COMBINATIONAL);
+  codegen.set_module_name("my_module");
+  codegen.set_register_merge_strategy(
+      RegisterMergeStrategyProto::STRATEGY_DONT_MERGE);
+  XLS_ASSERT_OK_AND_ASSIGN(CodegenResponse response,
+                           HandleCodegenRequest(request));
+  EXPECT_THAT(response.verilog(), HasSubstr("module my_module("));
+  EXPECT_EQ(response.signature().module_name(), "my_module");
+  EXPECT_FALSE(response.has_schedule());
+  EXPECT_THAT(response.block_ir(), HasSubstr("top block my_module("));
+  EXPECT_TRUE(response.schedule_ir().empty());
+}
+
+TEST(CompileServiceTest, ConvertDslx) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path path = temp_dir.path() / "my_module.x";
+  XLS_ASSERT_OK(
+      SetFileContents(path, "pub fn add_one(x: u32) -> u32 { x + u32:1 }"));
+  ConvertDslxRequest request;
+  request.add_paths(path.string());
+  request.mutable_options()->set_top("add_one");
+  XLS_ASSERT_OK_AND_ASSIGN(ConvertDslxResponse response,
+                           HandleConvertDslxRequest(request));
+  EXPECT_THAT(response.ir(), HasSubstr("fn __my_module__add_one("));
+  EXPECT_EQ(response.interface().functions_size(), 1);
+}
+
+TEST(CompileServiceTest, ConvertDslxMissingFile) {
+  ConvertDslxRequest request;
+  request.add_paths("/does/not/exist.x");
+  EXPECT_THAT(HandleConvertDslxRequest(request), Not(absl_testing::IsOk()));
+}
+
+}  // namespace
+}  // namespace xls
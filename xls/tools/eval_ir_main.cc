@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>  // NOLINT
 #include <iostream>
@@ -27,6 +28,7 @@
 #include "absl/algorithm/container.h"
 #include "absl/base/casts.h"
 #include "absl/flags/flag.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/random/bit_gen_ref.h"
@@ -67,6 +69,7 @@
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/create_import_data.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/import_data.h"
@@ -79,6 +82,7 @@
 #include "xls/interpreter/function_interpreter.h"
 #include "xls/interpreter/observer.h"
 #include "xls/interpreter/random_value.h"
+#include "xls/ir/binary_ir.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/events.h"
 #include "xls/ir/format_preference.h"
@@ -92,6 +96,7 @@
 #include "xls/ir/value_utils.h"
 #include "xls/jit/function_jit.h"
 #include "xls/jit/jit_buffer.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/observer.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_pipeline.h"
@@ -184,6 +189,11 @@ ABSL_FLAG(bool, test_llvm_jit, false,
 ABSL_FLAG(int64_t, llvm_opt_level, 3,
           "The optimization level of the LLVM JIT. Valid values are from 0 (no "
           "optimizations) to 3 (maximum optimizations).");
+ABSL_FLAG(std::string, jit_object_cache_dir, "",
+          "If non-empty, JIT object code is cached in this directory keyed by "
+          "the IR, optimization level and target, and reused by later runs "
+          "instead of recompiling. Ignored when observers or the LLVM "
+          "interpreter are in use.");
 ABSL_FLAG(std::string, input_validator_expr, "",
           "DSLX expression to validate randomly-generated inputs. "
           "The expression can reference entry function input arguments "
@@ -229,6 +239,14 @@ ABSL_FLAG(
     "LLVM ir and then interpret the LLVM IR. --use_llvm_jit must be true. Use "
     "--llvm_opt_level=0 if you want to execute the unoptimized llvm ir.");
 
+ABSL_FLAG(int64_t, threads, 1,
+          "Number of threads used to parse --input_file and to evaluate the "
+          "argument sets, each JIT thread with its own execution context. 0 "
+          "means one thread per available CPU. Results are printed and checked "
+          "in input order regardless. Runs with observers, the LLVM "
+          "interpreter or an injected JIT result are evaluated on one "
+          "thread.");
+
 namespace xls {
 namespace {
 
@@ -242,6 +260,39 @@ struct ArgSet {
   std::optional<Value> expected;
 };
 
+// Returns the number of threads to use for parsing and evaluating ArgSets.
+int64_t EvalThreadCount() {
+  int64_t threads = absl::GetFlag(FLAGS_threads);
+  return threads > 0 ? threads : std::max(AvailableCPUs(), 1);
+}
+
+// Splits [0, count) into up to `thread_count` contiguous chunks and calls
+// `fn(begin, end)` for each on its own thread. Returns the error of the first
+// failing chunk, if any.
+absl::Status ParallelForChunks(
+    int64_t count, int64_t thread_count,
+    absl::FunctionRef<absl::Status(int64_t, int64_t)> fn) {
+  int64_t chunk_count = std::min(count, thread_count);
+  if (chunk_count <= 1) {
+    return fn(0, count);
+  }
+  std::vector<absl::Status> statuses(chunk_count);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t i = 0; i < chunk_count; ++i) {
+      int64_t begin = count * i / chunk_count;
+      int64_t end = count * (i + 1) / chunk_count;
+      threads.push_back(std::make_unique<Thread>(
+          [&, i, begin, end]() { statuses[i] = fn(begin, end); }));
+    }
+    // Threads are joined on destruction.
+  }
+  for (const absl::Status& status : statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
 // Returns the given arguments as a semicolon-separated string.
 std::string ArgsToString(absl::Span<const Value> args) {
   return absl::StrJoin(args, "; ", ValueFormatterHex);
@@ -378,63 +429,110 @@ absl::StatusOr<std::vector<Value>> Eval(
   std::unique_ptr<FunctionJit> jit;
   if (use_jit) {
     // No support for procs yet.
-    XLS_ASSIGN_OR_RETURN(
-        jit, FunctionJit::Create(
-                 f, absl::GetFlag(FLAGS_llvm_opt_level),
-                 /*include_observer_callbacks=*/eval_observer.has_value(),
-                 &observer));
+    std::string cache_dir = absl::GetFlag(FLAGS_jit_object_cache_dir);
+    if (!cache_dir.empty() && !eval_observer.has_value() &&
+        !absl::GetFlag(FLAGS_use_llvm_jit_interpreter)) {
+      XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitObjectCache> cache,
+                           JitObjectCache::Create(cache_dir));
+      XLS_ASSIGN_OR_RETURN(
+          jit, FunctionJit::CreateWithObjectCache(
+                   f, *cache, absl::GetFlag(FLAGS_llvm_opt_level)));
+    } else {
+      XLS_ASSIGN_OR_RETURN(
+          jit, FunctionJit::Create(
+                   f, absl::GetFlag(FLAGS_llvm_opt_level),
+                   /*include_observer_callbacks=*/eval_observer.has_value(),
+                   &observer));
+    }
   }
 
-  std::vector<Value> results;
-  for (const ArgSet& arg_set : arg_sets) {
-    Value result;
-    if (use_jit) {
-      if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
-        if (absl::GetFlag(FLAGS_use_llvm_jit_interpreter)) {
-          XLS_RET_CHECK(!eval_observer)
-              << "Observer not supported with llvm interpreter.";
-          XLS_ASSIGN_OR_RETURN(result, DropInterpreterEvents(RunLlvmInterpreter(
-                                           f, observer.saved_opt_ir(),
-                                           jit.get(), arg_set.args)));
-        } else {
-          std::optional<RuntimeEvaluationObserverAdapter> adapt;
-          if (eval_observer) {
-            adapt.emplace(
-                eval_observer.value(),
-                [](int64_t v) -> Node* {
-                  return reinterpret_cast<Node*>(static_cast<intptr_t>(v));
-                },
-                jit->runtime());
-            XLS_RETURN_IF_ERROR(jit->SetRuntimeObserver(&adapt.value()));
+  // Evaluation has no side effects other than those of the observer, so
+  // without one the ArgSets are split among threads, each running the JIT
+  // through its own execution context.
+  int64_t thread_count = EvalThreadCount();
+  bool parallel = thread_count > 1 && !eval_observer.has_value() &&
+                  !absl::GetFlag(FLAGS_use_llvm_jit_interpreter) &&
+                  absl::GetFlag(FLAGS_test_only_inject_jit_result).empty();
+  std::vector<Value> results(arg_sets.size());
+  if (parallel) {
+    XLS_RETURN_IF_ERROR(ParallelForChunks(
+        arg_sets.size(), thread_count,
+        [&](int64_t begin, int64_t end) -> absl::Status {
+          std::unique_ptr<FunctionJit::ExecutionContext> context;
+          if (use_jit) {
+            context = jit->CreateExecutionContext();
           }
-          XLS_ASSIGN_OR_RETURN(result,
-                               DropInterpreterEvents(jit->Run(arg_set.args)));
-          jit->ClearRuntimeObserver();
+          for (int64_t i = begin; i < end; ++i) {
+            if (use_jit) {
+              XLS_ASSIGN_OR_RETURN(
+                  results[i],
+                  DropInterpreterEvents(context->Run(arg_sets[i].args)));
+            } else {
+              XLS_ASSIGN_OR_RETURN(results[i],
+                                   DropInterpreterEvents(InterpretFunction(
+                                       f, arg_sets[i].args)));
+            }
+          }
+          return absl::OkStatus();
+        }));
+  } else {
+    for (int64_t i = 0; i < arg_sets.size(); ++i) {
+      const ArgSet& arg_set = arg_sets[i];
+      Value& result = results[i];
+      if (use_jit) {
+        if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
+          if (absl::GetFlag(FLAGS_use_llvm_jit_interpreter)) {
+            XLS_RET_CHECK(!eval_observer)
+                << "Observer not supported with llvm interpreter.";
+            XLS_ASSIGN_OR_RETURN(
+                result, DropInterpreterEvents(RunLlvmInterpreter(
+                            f, observer.saved_opt_ir(), jit.get(),
+                            arg_set.args)));
+          } else {
+            std::optional<RuntimeEvaluationObserverAdapter> adapt;
+            if (eval_observer) {
+              adapt.emplace(
+                  eval_observer.value(),
+                  [](int64_t v) -> Node* {
+                    return reinterpret_cast<Node*>(static_cast<intptr_t>(v));
+                  },
+                  jit->runtime());
+              XLS_RETURN_IF_ERROR(jit->SetRuntimeObserver(&adapt.value()));
+            }
+            XLS_ASSIGN_OR_RETURN(result,
+                                 DropInterpreterEvents(jit->Run(arg_set.args)));
+            jit->ClearRuntimeObserver();
+          }
+        } else {
+          XLS_ASSIGN_OR_RETURN(result, Parser::ParseTypedValue(absl::GetFlag(
+                                           FLAGS_test_only_inject_jit_result)));
         }
       } else {
-        XLS_ASSIGN_OR_RETURN(result, Parser::ParseTypedValue(absl::GetFlag(
-                                         FLAGS_test_only_inject_jit_result)));
+        // TODO(https://github.com/google/xls/issues/506): 2021-10-12 Also
+        // compare resulting events once the JIT fully supports events. Note:
+        // This will require rethinking some of the control flow because event
+        // comparison only makes sense for certain modes (optimize_ir and
+        // test_llvm_jit).
+        XLS_ASSIGN_OR_RETURN(result, DropInterpreterEvents(InterpretFunction(
+                                         f, arg_set.args, eval_observer)));
       }
-    } else {
-      // TODO(https://github.com/google/xls/issues/506): 2021-10-12 Also compare
-      // resulting events once the JIT fully supports events. Note: This will
-      // require rethinking some of the control flow because event comparison
-      // only makes sense for certain modes (optimize_ir and test_llvm_jit).
-      XLS_ASSIGN_OR_RETURN(result, DropInterpreterEvents(InterpretFunction(
-                                       f, arg_set.args, eval_observer)));
     }
+  }
+
+  for (int64_t i = 0; i < arg_sets.size(); ++i) {
+    const ArgSet& arg_set = arg_sets[i];
+    const Value& result = results[i];
     std::cout << result.ToString(FormatPreference::kHex) << '\n';
 
     if (arg_set.expected.has_value()) {
       if (result != *arg_set.expected) {
         return absl::InvalidArgumentError(absl::StrFormat(
-            "Miscompare for input[%i] \"%s\"\n  %s: %s\n  %s: %s",
-            results.size(), ArgsToString(arg_set.args), actual_src,
+            "Miscompare for input[%i] \"%s\"\n  %s: %s\n  %s: %s", i,
+            ArgsToString(arg_set.args), actual_src,
             result.ToString(FormatPreference::kHex), expected_src,
             arg_set.expected->ToString(FormatPreference::kHex)));
       }
     }
-    results.push_back(result);
   }
   return results;
 }
@@ -654,7 +752,7 @@ absl::Status RealMain(std::string_view input_path,
   }
   XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(input_path));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(contents, input_path));
+                       ParsePackageTextOrBinary(contents, input_path));
   if (!absl::GetFlag(FLAGS_top).empty()) {
     XLS_RETURN_IF_ERROR(package->SetTopByName(absl::GetFlag(FLAGS_top)));
   }
@@ -691,14 +789,25 @@ absl::Status RealMain(std::string_view input_path,
     absl::StatusOr<std::string> args_input_file =
         GetFileContents(absl::GetFlag(FLAGS_input_file));
     QCHECK_OK(args_input_file.status());
-    for (const auto& arg_line : absl::StrSplit(args_input_file.value(), '\n',
-                                               absl::SkipWhitespace())) {
-      absl::StatusOr<ArgSet> arg_set_status = ArgSetFromString(arg_line);
-      QCHECK_OK(arg_set_status.status())
-          << absl::StreamFormat("Invalid line in input file %s: %s",
-                                absl::GetFlag(FLAGS_input_file), arg_line);
-      arg_sets.push_back(arg_set_status.value());
-    }
+    std::vector<std::string_view> arg_lines = absl::StrSplit(
+        args_input_file.value(), '\n', absl::SkipWhitespace());
+    arg_sets.resize(arg_lines.size());
+    QCHECK_OK(ParallelForChunks(
+        arg_lines.size(), EvalThreadCount(),
+        [&](int64_t begin, int64_t end) -> absl::Status {
+          for (int64_t i = begin; i < end; ++i) {
+            absl::StatusOr<ArgSet> arg_set_status =
+                ArgSetFromString(arg_lines[i]);
+            if (!arg_set_status.ok()) {
+              return absl::InvalidArgumentError(absl::StrFormat(
+                  "Invalid line in input file %s: %s: %s",
+                  absl::GetFlag(FLAGS_input_file), arg_lines[i],
+                  arg_set_status.status().message()));
+            }
+            arg_sets[i] = *std::move(arg_set_status);
+          }
+          return absl::OkStatus();
+        }));
   } else {
     QCHECK_NE(absl::GetFlag(FLAGS_random_inputs), 0)
         << "Must specify --input, --input_file, or --random_inputs.";
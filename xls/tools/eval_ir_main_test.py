@@ -165,6 +165,28 @@ class EvalMainTest(parameterized.TestCase):
         results.decode('utf-8').strip().split('\n'),
     )
 
+  def test_input_file_multithreaded(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    input_file = self.create_tempfile(
+        content='\n'.join(
+            'bits[32]:{}; bits[32]:{}'.format(i, 2 * i) for i in range(100)
+        )
+    )
+    for flags in ([], ['--test_llvm_jit'], ['--use_llvm_jit=false']):
+      results = subprocess.check_output(
+          [
+              EVAL_IR_MAIN_PATH,
+              '--input_file=' + input_file.full_path,
+              '--threads=4',
+              ir_file.full_path,
+          ]
+          + flags
+      )
+      self.assertSequenceEqual(
+          ['bits[32]:{:#x}'.format(3 * i) for i in range(100)],
+          results.decode('utf-8').strip().split('\n')[-100:],
+      )
+
   def test_input_file_extra_whitespace(self):
     ir_file = self.create_tempfile(content=ADD_IR)
     # Empty lines and extra whitespace in the arg file should be ignored.
@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/cleanup/cleanup.h"
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -51,6 +52,7 @@
 #include "xls/codegen/module_signature.pb.h"
 #include "xls/common/exit_status.h"
 #include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -60,7 +62,10 @@
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/evaluator_options.h"
 #include "xls/interpreter/interpreter_proc_runtime.h"
+#include "xls/interpreter/parallel_proc_runtime.h"
+#include "xls/interpreter/proc_runtime.h"
 #include "xls/interpreter/serial_proc_runtime.h"
+#include "xls/ir/binary_ir.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/block.h"
 #include "xls/ir/block_elaboration.h"
@@ -68,7 +73,6 @@
 #include "xls/ir/channel.pb.h"
 #include "xls/ir/events.h"
 #include "xls/ir/function_builder.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/proc.h"
@@ -76,9 +80,13 @@
 #include "xls/ir/register.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
+#include "xls/jit/block_channel_driver.h"
 #include "xls/jit/block_jit.h"
+#include "xls/jit/block_trace_buffer.h"
+#include "xls/jit/channel_trace.h"
 #include "xls/jit/jit_proc_runtime.h"
 #include "xls/jit/jit_runtime.h"
+#include "xls/tools/channel_value_stream.h"
 #include "xls/tools/eval_utils.h"
 #include "xls/tools/memory_models.h"
 #include "xls/tools/node_coverage_utils.h"
@@ -105,9 +113,14 @@ ABSL_FLAG(std::vector<std::string>, ticks, {},
 ABSL_FLAG(std::string, backend, "serial_jit",
           "Backend to use for evaluation. Valid options are:\n"
           " * serial_jit: JIT-backed single-stepping runtime.\n"
+          " * parallel_jit: JIT-backed runtime ticking procs on --threads "
+          "worker threads.\n"
           " * ir_interpreter: Interpreter at the IR level.\n"
           " * block_interpreter: Interpret a block generated from a proc.\n"
           " * block_jit: JIT-backed block execution generated from a proc.");
+ABSL_FLAG(int64_t, threads, 0,
+          "Number of worker threads of the parallel_jit backend; 0 uses one "
+          "per core.");
 ABSL_FLAG(std::string, block_signature_proto, "",
           "Path to textproto file containing signature from codegen");
 ABSL_FLAG(int64_t, max_cycles_no_output, 100,
@@ -128,6 +141,33 @@ ABSL_FLAG(
     "'expected_outputs_for_all_channels' are not specified the values of all "
     "the channel are displayed on stdout.");
 
+ABSL_FLAG(
+    std::vector<std::string>, streaming_inputs_for_channels, {},
+    "Comma separated list of channel=filename pairs of streaming channels. "
+    "Unlike with 'inputs_for_channels', values are read from the file as the "
+    "channel consumes them, so the file may be a pipe and memory use does not "
+    "depend on its length. See 'streaming_format' for the file format. Only "
+    "supported by the proc backends.");
+ABSL_FLAG(
+    std::vector<std::string>, streaming_expected_outputs_for_channels, {},
+    "Comma separated list of channel=filename pairs of streaming channels. "
+    "Values sent on the channel are checked against the file as they are "
+    "produced and then discarded. With --ticks=-1 the simulation stops once "
+    "all the values of the files have been matched.");
+ABSL_FLAG(
+    std::vector<std::string>, streaming_outputs_for_channels, {},
+    "Comma separated list of channel=filename pairs of streaming channels. "
+    "Values sent on the channel are written to the file as they are "
+    "produced.");
+ABSL_FLAG(std::string, streaming_format, "text",
+          "Format of the files of the streaming_* flags. Valid options are:\n"
+          " * text: one XLS Value in human-readable form per line.\n"
+          " * binary: values back to back, each flattened to bits and stored "
+          "in whole bytes, least significant byte first.");
+ABSL_FLAG(int64_t, streaming_queue_depth, 64,
+          "Maximum number of values read ahead into the queue of each "
+          "channel of 'streaming_inputs_for_channels'.");
+
 ABSL_FLAG(std::string, testvector_textproto, "",
           "A textproto file containing proc channel test vectors.");
 
@@ -165,11 +205,12 @@ ABSL_FLAG(
 ABSL_FLAG(
     std::string, proto_inputs_for_all_channels, "",
     "Path to ProcChannelValuesProto binary proto containing inputs for all "
-    "channels.");
+    "channels. May also be a channel trace as written by channel_trace_main.");
 ABSL_FLAG(
     std::string, expected_proto_outputs_for_all_channels, "",
     "Path to file containing ProcChannelValuesProto binary proto of outputs "
-    "for all channels.");
+    "for all channels. May also be a channel trace as written by "
+    "channel_trace_main.");
 
 ABSL_FLAG(int64_t, random_seed, 42, "Random seed");
 ABSL_FLAG(double, prob_input_valid_assert, 1.0,
@@ -182,6 +223,13 @@ ABSL_FLAG(int64_t, max_trace_verbosity, 0,
           "Maximum verbosity for traces. Traces with higher verbosity are "
           "stripped from codegen output. 0 by default.");
 ABSL_FLAG(int64_t, trace_per_ticks, 100, "Print a trace every N ticks.");
+ABSL_FLAG(int64_t, trace_ring_cycles, 0,
+          "If positive, the ports and registers of the last this many cycles "
+          "are kept in memory and written to --trace_ring_vcd_path as a VCD "
+          "file when an assertion fires or an output mismatches. Only "
+          "supported by the block_jit backend.");
+ABSL_FLAG(std::string, trace_ring_vcd_path, "",
+          "Path of the VCD file written for --trace_ring_cycles.");
 ABSL_FLAG(std::string, output_stats_path, "", "File to output statistics to.");
 ABSL_FLAG(bool, fail_on_assert, false,
           "When set to true, the simulation fails on the activation or cycle "
@@ -197,6 +245,10 @@ ABSL_FLAG(std::optional<std::string>, output_node_coverage_stats_textproto,
 ABSL_FLAG(bool, abstract_ram_model, false,
           "Whether or not to use an abstract RAM model, as opposed to a "
           "rewritten RAM model, for proc memory.\n");
+ABSL_FLAG(int64_t, ram_latency, 0,
+          "Number of ticks after a request that proc memory models deliver "
+          "the response. Only supported with the JIT backends, whose memory "
+          "models service requests in the JIT's native data layout.");
 ABSL_FLAG(std::string, ram_rewrites_textproto, "",
           "Path to ram rewrites textproto, which is used to create memory "
           "models. Blank is default, in which case no memory models are added "
@@ -209,13 +261,12 @@ namespace {
 static absl::Status LogInterpreterEvents(std::string_view entity_name,
                                          const InterpreterEvents& events) {
   if (absl::GetFlag(FLAGS_show_trace)) {
-    for (const auto& msg : events.trace_msgs) {
-      if (msg.verbosity <= absl::GetFlag(FLAGS_max_trace_verbosity)) {
-        std::string unescaped_msg;
-        XLS_RET_CHECK(absl::CUnescape(msg.message, &unescaped_msg));
-        std::cerr << "Proc " << entity_name << " trace: " << unescaped_msg
-                  << "\n";
-      }
+    for (const auto& msg : events.trace_msgs.GetMessages(
+             absl::GetFlag(FLAGS_max_trace_verbosity))) {
+      std::string unescaped_msg;
+      XLS_RET_CHECK(absl::CUnescape(msg.message, &unescaped_msg));
+      std::cerr << "Proc " << entity_name << " trace: " << unescaped_msg
+                << "\n";
     }
   }
   for (const auto& msg : events.assert_msgs) {
@@ -226,13 +277,225 @@ static absl::Status LogInterpreterEvents(std::string_view entity_name,
   return absl::OkStatus();
 }
 
+// Channels whose values are streamed from and to files, mapped to the names of
+// the files.
+struct ChannelStreamsOptions {
+  absl::flat_hash_map<std::string, std::string> inputs;
+  absl::flat_hash_map<std::string, std::string> expected_outputs;
+  absl::flat_hash_map<std::string, std::string> outputs;
+  ChannelStreamFormat format = ChannelStreamFormat::kText;
+  int64_t queue_depth = 64;
+};
+
+// Moves values between channel queues and files as the procs are ticked, so
+// that only a bounded number of them are held in memory at any time.
+class ChannelStreams {
+ public:
+  static absl::StatusOr<ChannelStreams> Create(
+      ChannelQueueManager& queue_manager,
+      const ChannelStreamsOptions& options) {
+    ChannelStreams streams;
+    streams.queue_depth_ = options.queue_depth;
+    for (const auto& [channel_name, filename] : options.inputs) {
+      XLS_ASSIGN_OR_RETURN(ChannelQueue * queue,
+                           GetStreamingQueue(queue_manager, channel_name));
+      XLS_ASSIGN_OR_RETURN(std::unique_ptr<ChannelValueReader> reader,
+                           ChannelValueReader::Create(
+                               filename, queue->channel()->type(),
+                               options.format));
+      streams.inputs_.push_back(
+          InputStream{.queue = queue, .reader = std::move(reader)});
+    }
+    absl::flat_hash_map<ChannelQueue*, OutputStream*> output_streams;
+    auto get_output_stream =
+        [&](std::string_view channel_name) -> absl::StatusOr<OutputStream*> {
+      XLS_ASSIGN_OR_RETURN(ChannelQueue * queue,
+                           GetStreamingQueue(queue_manager, channel_name));
+      auto [it, inserted] = output_streams.insert({queue, nullptr});
+      if (inserted) {
+        streams.outputs_.push_back(std::make_unique<OutputStream>());
+        streams.outputs_.back()->queue = queue;
+        it->second = streams.outputs_.back().get();
+      }
+      return it->second;
+    };
+    for (const auto& [channel_name, filename] : options.expected_outputs) {
+      XLS_ASSIGN_OR_RETURN(OutputStream * stream,
+                           get_output_stream(channel_name));
+      XLS_ASSIGN_OR_RETURN(stream->expected,
+                           ChannelValueReader::Create(
+                               filename, stream->queue->channel()->type(),
+                               options.format));
+      XLS_ASSIGN_OR_RETURN(stream->next_expected, stream->expected->Read());
+    }
+    for (const auto& [channel_name, filename] : options.outputs) {
+      XLS_ASSIGN_OR_RETURN(OutputStream * stream,
+                           get_output_stream(channel_name));
+      XLS_ASSIGN_OR_RETURN(stream->writer,
+                           ChannelValueWriter::Create(
+                               filename, stream->queue->channel()->type(),
+                               options.format));
+    }
+    return streams;
+  }
+
+  bool has_outputs() const { return !outputs_.empty(); }
+  bool has_expected_outputs() const {
+    return absl::c_any_of(outputs_, [](const auto& stream) {
+      return stream->expected != nullptr;
+    });
+  }
+  int64_t matched_count() const { return matched_count_; }
+
+  // Tops up the queues of the input channels from their files.
+  absl::Status FillInputQueues() {
+    for (InputStream& input : inputs_) {
+      while (!input.exhausted && input.queue->GetSize() < queue_depth_) {
+        XLS_ASSIGN_OR_RETURN(std::optional<Value> value, input.reader->Read());
+        if (!value.has_value()) {
+          input.exhausted = true;
+          break;
+        }
+        XLS_RETURN_IF_ERROR(input.queue->Write(*value));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Empties the queues of the output channels, writing the values to their
+  // files and checking them against the expected ones. Values sent beyond the
+  // expected ones are ignored, as for in-memory expectations.
+  absl::Status DrainOutputQueues() {
+    for (std::unique_ptr<OutputStream>& output : outputs_) {
+      while (std::optional<Value> value = output->queue->Read()) {
+        if (output->writer != nullptr) {
+          XLS_RETURN_IF_ERROR(output->writer->Write(*value));
+        }
+        if (!output->next_expected.has_value()) {
+          continue;
+        }
+        if (*output->next_expected != *value) {
+          return absl::UnknownError(absl::StrFormat(
+              "Outputs did not match expectations:\n\nMismatched "
+              "(channel=%s) after %d outputs (%s != %s)",
+              output->queue->channel()->name(), output->matched_count,
+              output->next_expected->ToString(), value->ToString()));
+        }
+        if (absl::GetFlag(FLAGS_show_trace)) {
+          LOG(INFO) << absl::StreamFormat(
+              "Matched (channel=%s) after %d outputs",
+              output->queue->channel()->name(), output->matched_count);
+        }
+        ++output->matched_count;
+        ++matched_count_;
+        XLS_ASSIGN_OR_RETURN(output->next_expected, output->expected->Read());
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Returns whether the streams have run their course: all expected outputs
+  // have been matched if there are any, otherwise all inputs have been
+  // consumed.
+  bool Done() const {
+    if (has_expected_outputs()) {
+      return absl::c_none_of(outputs_, [](const auto& stream) {
+        return stream->next_expected.has_value();
+      });
+    }
+    return absl::c_all_of(inputs_, [](const InputStream& input) {
+      return input.exhausted && input.queue->IsEmpty();
+    });
+  }
+
+  // Flushes the output files and adds an error to `errors` for each channel
+  // which did not produce all its expected values.
+  absl::Status Finish(std::vector<std::string>& errors) {
+    for (std::unique_ptr<OutputStream>& output : outputs_) {
+      if (output->writer != nullptr) {
+        XLS_RETURN_IF_ERROR(output->writer->Flush());
+      }
+      if (!output->next_expected.has_value()) {
+        continue;
+      }
+      int64_t missing_count = 0;
+      while (output->next_expected.has_value()) {
+        ++missing_count;
+        XLS_ASSIGN_OR_RETURN(output->next_expected, output->expected->Read());
+      }
+      errors.push_back(absl::StrFormat(
+          "Channel %s didn't consume %d expected values (processed %d)",
+          output->queue->channel()->name(), missing_count,
+          output->matched_count));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  struct InputStream {
+    ChannelQueue* queue;
+    std::unique_ptr<ChannelValueReader> reader;
+    bool exhausted = false;
+  };
+  struct OutputStream {
+    ChannelQueue* queue = nullptr;
+    std::unique_ptr<ChannelValueReader> expected;
+    std::optional<Value> next_expected;
+    std::unique_ptr<ChannelValueWriter> writer;
+    int64_t matched_count = 0;
+  };
+
+  static absl::StatusOr<ChannelQueue*> GetStreamingQueue(
+      ChannelQueueManager& queue_manager, std::string_view channel_name) {
+    XLS_ASSIGN_OR_RETURN(ChannelQueue * queue,
+                         queue_manager.GetQueueByName(channel_name));
+    if (queue->channel()->kind() != ChannelKind::kStreaming) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Channel %s is not a streaming channel and can't be streamed from "
+          "or to a file",
+          channel_name));
+    }
+    return queue;
+  }
+
+  int64_t queue_depth_ = 0;
+  int64_t matched_count_ = 0;
+  std::vector<InputStream> inputs_;
+  std::vector<std::unique_ptr<OutputStream>> outputs_;
+};
+
 struct EvaluateProcsOptions {
   bool use_jit = false;
+  // Ticks the procs on worker threads, see ParallelProcRuntime. Requires
+  // `use_jit`.
+  bool use_parallel_runtime = false;
+  int64_t thread_count = 0;
   bool fail_on_assert = false;
   std::vector<int64_t> ticks = {-1};
   std::optional<std::string> top = std::nullopt;
+  ChannelStreamsOptions streams;
 };
 
+// Returns the rewrites of the banks of `ram_rewrite` if it splits the RAM into
+// banks, each modeled separately, and otherwise `ram_rewrite` itself. The banks
+// are named as by RamBankNamePrefix() in the RAM rewrite pass.
+static std::vector<RamRewriteProto> ExpandRamBanks(
+    const RamRewriteProto& ram_rewrite) {
+  if (!ram_rewrite.has_banking()) {
+    return {ram_rewrite};
+  }
+  std::vector<RamRewriteProto> bank_rewrites;
+  for (int64_t bank = 0; bank < ram_rewrite.banking().bank_count(); ++bank) {
+    RamRewriteProto& bank_rewrite = bank_rewrites.emplace_back(ram_rewrite);
+    bank_rewrite.clear_banking();
+    bank_rewrite.mutable_from_config()->set_depth(
+        ram_rewrite.to_config().depth());
+    bank_rewrite.set_to_name_prefix(
+        absl::StrCat(ram_rewrite.to_name_prefix(), "_bank", bank));
+  }
+  return bank_rewrites;
+}
+
 static absl::Status EvaluateProcs(
     Package* package,
     const absl::btree_map<std::string, std::vector<Value>>& inputs_for_channels,
@@ -240,10 +503,14 @@ static absl::Status EvaluateProcs(
         expected_outputs_for_channels,
     const RamRewritesProto& ram_rewrites,
     const EvaluateProcsOptions& options = {}) {
-  std::unique_ptr<SerialProcRuntime> runtime;
+  std::unique_ptr<ProcRuntime> runtime;
   std::optional<JitRuntime*> jit;
   EvaluatorOptions evaluator_options;
   evaluator_options.set_trace_channels(absl::GetFlag(FLAGS_trace_channels));
+  if (absl::GetFlag(FLAGS_show_trace)) {
+    evaluator_options.set_max_trace_verbosity(
+        absl::GetFlag(FLAGS_max_trace_verbosity));
+  }
   bool uses_observers =
       absl::GetFlag(FLAGS_output_node_coverage_stats_proto).has_value() ||
       absl::GetFlag(FLAGS_output_node_coverage_stats_textproto).has_value();
@@ -254,8 +521,17 @@ static absl::Status EvaluateProcs(
           "Simulating subsets of the proc network is not implemented yet.");
     }
   }
-  evaluator_options.set_support_observers(uses_observers);
-  if (options.use_jit) {
+  // The JIT accumulates coverage in place rather than calling the observer for
+  // every node evaluation.
+  evaluator_options.set_support_observers(uses_observers && !options.use_jit);
+  evaluator_options.set_jit_node_coverage(uses_observers && options.use_jit);
+  if (options.use_jit && options.use_parallel_runtime) {
+    XLS_ASSIGN_OR_RETURN(runtime,
+                         CreateJitParallelProcRuntime(
+                             package, evaluator_options, options.thread_count));
+    XLS_ASSIGN_OR_RETURN(auto jit_queue, runtime->GetJitChannelQueueManager());
+    jit = &jit_queue->runtime();
+  } else if (options.use_jit) {
     XLS_ASSIGN_OR_RETURN(
         runtime, CreateJitSerialProcRuntime(package, evaluator_options));
     XLS_ASSIGN_OR_RETURN(auto jit_queue, runtime->GetJitChannelQueueManager());
@@ -271,14 +547,28 @@ static absl::Status EvaluateProcs(
     XLS_RETURN_IF_ERROR(runtime->SetObserver(*cov.observer()));
     LOG(ERROR) << "Set observer!";
   }
+  // Clearing the observer hands the coverage accumulated by the JIT to it, so
+  // it must happen before `cov` writes out the stats.
+  absl::Cleanup clear_observer = [&runtime] { runtime->ClearObserver(); };
 
   ChannelQueueManager& queue_manager = runtime->queue_manager();
 
   std::vector<std::unique_ptr<memory_model::ProcMemoryModel>> memory_models;
 
   const bool abstract_ram_model = absl::GetFlag(FLAGS_abstract_ram_model);
+  const int64_t ram_latency = absl::GetFlag(FLAGS_ram_latency);
 
+  std::vector<RamRewriteProto> modeled_rewrites;
   for (const RamRewriteProto& ram_rewrite : ram_rewrites.rewrites()) {
+    if (abstract_ram_model) {
+      // The procs still use the abstract RAM, banked or not.
+      modeled_rewrites.push_back(ram_rewrite);
+    } else {
+      absl::c_move(ExpandRamBanks(ram_rewrite),
+                   std::back_inserter(modeled_rewrites));
+    }
+  }
+  for (const RamRewriteProto& ram_rewrite : modeled_rewrites) {
     XLS_RET_CHECK(ram_rewrite.has_to_config());
 
     XLS_RET_CHECK_EQ(ram_rewrite.from_config().depth(),
@@ -286,7 +576,15 @@ static absl::Status EvaluateProcs(
 
     std::unique_ptr<memory_model::ProcMemoryModel> memory_model;
 
-    if (abstract_ram_model) {
+    if (options.use_jit) {
+      XLS_ASSIGN_OR_RETURN(memory_model,
+                           memory_model::CreateJitProcMemoryModel(
+                               ram_rewrite, queue_manager, abstract_ram_model,
+                               ram_latency));
+    } else if (ram_latency != 0) {
+      return absl::UnimplementedError(
+          "--ram_latency is only supported with the JIT backends");
+    } else if (abstract_ram_model) {
       XLS_ASSIGN_OR_RETURN(memory_model,
                            memory_model::CreateAbstractProcMemoryModel(
                                ram_rewrite, queue_manager));
@@ -304,6 +602,23 @@ static absl::Status EvaluateProcs(
     memory_models.push_back(std::move(memory_model));
   }
 
+  for (const auto& [channel_name, _] : options.streams.inputs) {
+    if (inputs_for_channels.contains(channel_name)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Inputs of channel %s are both streamed and given upfront",
+          channel_name));
+    }
+  }
+  for (const auto& [channel_name, _] : options.streams.expected_outputs) {
+    if (expected_outputs_for_channels.contains(channel_name)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Expected outputs of channel %s are both streamed and given upfront",
+          channel_name));
+    }
+  }
+  XLS_ASSIGN_OR_RETURN(ChannelStreams streams,
+                       ChannelStreams::Create(queue_manager, options.streams));
+
   for (const auto& [channel_name, values] : inputs_for_channels) {
     XLS_ASSIGN_OR_RETURN(ChannelQueue * in_queue,
                          queue_manager.GetQueueByName(channel_name));
@@ -349,6 +664,7 @@ static absl::Status EvaluateProcs(
         }
         LOG(INFO) << "Tick " << i << ": " << ostr.str();
       }
+      XLS_RETURN_IF_ERROR(streams.FillInputQueues());
       // Don't double print events (traces, assertions, etc)
       runtime->ClearInterpreterEvents();
       absl::Status tick_ret = runtime->Tick();
@@ -378,6 +694,7 @@ static absl::Status EvaluateProcs(
            memory_models) {
         XLS_RETURN_IF_ERROR(memory->Tick());
       }
+      XLS_RETURN_IF_ERROR(streams.DrainOutputQueues());
 
       // Sort the keys for stable print order.
       absl::flat_hash_map<Proc*, std::vector<Value>> states;
@@ -420,7 +737,7 @@ static absl::Status EvaluateProcs(
 
       // --ticks 0 stops when all outputs are verified
       if (this_ticks < 0) {
-        bool all_outputs_produced = true;
+        bool all_outputs_produced = streams.Done();
         for (const auto& [channel_name, values] :
              expected_outputs_for_channels) {
           XLS_ASSIGN_OR_RETURN(ChannelQueue * out_queue,
@@ -483,16 +800,19 @@ static absl::Status EvaluateProcs(
       ++processed_count;
     }
   }
+  XLS_RETURN_IF_ERROR(streams.Finish(errors));
+  checked_any_output |= streams.matched_count() > 0;
   if (!errors.empty()) {
     return absl::UnknownError(
         absl::StrFormat("Outputs did not match expectations:\n\n%s",
                         absl::StrJoin(errors, "\n")));
   }
-  if (!checked_any_output && !expected_outputs_for_channels.empty()) {
+  if (!checked_any_output && (!expected_outputs_for_channels.empty() ||
+                              streams.has_expected_outputs())) {
     return absl::UnknownError("No output verified (empty expected values?)");
   }
 
-  if (expected_outputs_for_channels.empty()) {
+  if (expected_outputs_for_channels.empty() && !streams.has_outputs()) {
     for (const Channel* channel : package->channels()) {
       if (!channel->CanSend()) {
         continue;
@@ -659,6 +979,8 @@ struct RunBlockOptions {
   double prob_input_valid_assert;
   bool show_trace;
   bool fail_on_assert;
+  int64_t trace_ring_cycles = 0;
+  std::string trace_ring_vcd_path;
 };
 
 // Helper to hold various commonly needed port names for a particular ram.
@@ -707,6 +1029,157 @@ absl::StatusOr<absl::flat_hash_map<std::string, StandardRamInfo>> GetRamInfoMap(
   return all_infos;
 }
 
+// Runs a jitted block with its channels driven by a BlockChannelDriver, which
+// moves channel values in the native layout of the JIT rather than through
+// Value port maps every cycle. Behaves like the cycle loop of RunBlock with
+// inputs always valid when available and outputs always ready.
+static absl::Status RunBlockWithChannelDriver(
+    Block* block, BlockJitContinuation* continuation,
+    const verilog::ModuleSignatureProto& signature,
+    const absl::flat_hash_map<std::string, ChannelInfo>& channel_info,
+    const absl::btree_map<std::string, std::vector<Value>>& inputs_for_channels,
+    const absl::btree_map<std::string, std::vector<Value>>&
+        expected_outputs_for_channels,
+    std::string_view output_stats_path, const RunBlockOptions& options) {
+  std::vector<BlockChannelDriver::ChannelPorts> input_channels;
+  std::vector<BlockChannelDriver::ChannelPorts> output_channels;
+  for (const auto& [name, _] : inputs_for_channels) {
+    const ChannelInfo& info = channel_info.at(name);
+    if (info.ready_valid) {
+      input_channels.push_back(
+          {.name = name,
+           .data = info.width != 0 ? info.channel_data : "",
+           .valid = info.channel_valid,
+           .ready = info.channel_ready});
+    }
+  }
+  for (const auto& [name, _] : expected_outputs_for_channels) {
+    const ChannelInfo& info = channel_info.at(name);
+    // TODO(allight): Support simulating fns which aren't ready-valid.
+    XLS_RET_CHECK(info.ready_valid);
+    output_channels.push_back(
+        {.name = name,
+         .data = info.width != 0 ? info.channel_data : "",
+         .valid = info.channel_valid,
+         .ready = info.channel_ready});
+  }
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<BlockChannelDriver> driver,
+                       BlockChannelDriver::Create(continuation, input_channels,
+                                                  output_channels));
+  for (const auto& [name, values] : inputs_for_channels) {
+    if (channel_info.at(name).ready_valid) {
+      for (const Value& value : values) {
+        XLS_RETURN_IF_ERROR(driver->Send(name, value));
+      }
+    } else {
+      // Just take the first value for the single value channels
+      XLS_RET_CHECK(!values.empty());
+      XLS_RETURN_IF_ERROR(driver->SetInputPort(name, values.front()));
+    }
+  }
+  for (const auto& [name, values] : expected_outputs_for_channels) {
+    XLS_RETURN_IF_ERROR(driver->SetReceiveTarget(name, values.size()));
+  }
+
+  absl::Time start_time = absl::Now();
+  // Idealized reset behavior: the first cycle resets the block and transfers
+  // nothing.
+  const bool has_reset = !signature.reset().name().empty();
+  if (!has_reset) {
+    LOG(WARNING) << "No reset found in signature!";
+  }
+  auto set_reset = [&](bool resetting) -> absl::Status {
+    if (!has_reset) {
+      return absl::OkStatus();
+    }
+    return driver->SetInputPort(
+        signature.reset().name(),
+        Value(UBits((resetting ^ signature.reset().active_low()) ? 1 : 0, 1)));
+  };
+  XLS_RETURN_IF_ERROR(set_reset(true));
+  XLS_RETURN_IF_ERROR(driver->RunIdleCycle());
+  XLS_RETURN_IF_ERROR(set_reset(false));
+  XLS_ASSIGN_OR_RETURN(
+      BlockChannelDriver::RunResult result,
+      driver->Run({.max_idle_cycles = options.max_cycles_no_output + 1,
+                   .stop_on_assert = options.fail_on_assert}));
+  absl::Duration elapsed_time = absl::Now() - start_time;
+  LOG(INFO) << "Elapsed time: " << elapsed_time << " for "
+            << result.cycle_count + 1 << " cycles";
+
+  const InterpreterEvents& events = continuation->GetEvents();
+  XLS_RETURN_IF_ERROR(LogInterpreterEvents(block->name(), events));
+  if (!events.assert_msgs.empty() && options.fail_on_assert) {
+    return absl::UnknownError(absl::StrFormat(
+        "Assert(s) fired:\n\n%s", absl::StrJoin(events.assert_msgs, "\n")));
+  }
+
+  // Cycles are numbered from the reset cycle.
+  const int64_t last_output_cycle = result.last_receive_cycle + 1;
+  std::vector<std::string> errors;
+  bool checked_any_output = false;
+  for (const auto& [name, expected] : expected_outputs_for_channels) {
+    const ChannelInfo& info = channel_info.at(name);
+    XLS_ASSIGN_OR_RETURN(std::vector<Value> received,
+                         driver->GetReceived(name));
+    for (int64_t i = 0; i < received.size(); ++i) {
+      if (i >= expected.size()) {
+        errors.push_back(
+            absl::StrFormat("Block wrote past the end of the expected values "
+                            "list for channel %s: %s",
+                            name, received[i].ToString()));
+        break;
+      }
+      checked_any_output = true;
+      if (info.width != 0 && received[i] != expected[i]) {
+        errors.push_back(absl::StrFormat(
+            "Output mismatched for channel %s: expected %s, block outputted %s",
+            name, expected[i].ToString(), received[i].ToString()));
+        break;
+      }
+      if (info.width == 0 && expected[i].GetFlatBitCount() != 0) {
+        errors.push_back(absl::StrFormat(
+            "Output mismatched for channel %s: expected %s, block outputted "
+            "zero-len data",
+            name, expected[i].ToString()));
+        break;
+      }
+    }
+  }
+  if (!errors.empty()) {
+    return absl::UnknownError(absl::StrFormat(
+        "Outputs did not match expectations by cycle %d:\n\n%s",
+        result.cycle_count, absl::StrJoin(errors, "\n")));
+  }
+  if (!result.targets_reached) {
+    return absl::OutOfRangeError(
+        absl::StrFormat("Block didn't produce output for %i cycles",
+                        options.max_cycles_no_output));
+  }
+
+  absl::btree_map<std::string, std::vector<Value>> unconsumed_inputs;
+  for (const BlockChannelDriver::ChannelPorts& channel : input_channels) {
+    XLS_ASSIGN_OR_RETURN(std::vector<Value> pending,
+                         driver->GetPendingInputs(channel.name));
+    if (!pending.empty()) {
+      unconsumed_inputs[channel.name] = std::move(pending);
+    }
+  }
+  if (!unconsumed_inputs.empty()) {
+    LOG(WARNING) << "Warning: Not all inputs were consumed by the time all "
+                    "expected outputs were produced. Remaining inputs:\n"
+                 << ChannelValuesToString(unconsumed_inputs);
+  }
+  if (!checked_any_output) {
+    return absl::UnknownError("No output verified (empty expected values?)");
+  }
+  if (!output_stats_path.empty()) {
+    XLS_RETURN_IF_ERROR(xls::SetFileContents(
+        output_stats_path, absl::StrFormat("%i", last_output_cycle)));
+  }
+  return absl::OkStatus();
+}
+
 static absl::Status RunBlock(
     Package* package, const verilog::ModuleSignatureProto& signature,
     const absl::btree_map<std::string, std::vector<Value>>& inputs_for_channels,
@@ -766,7 +1239,12 @@ static absl::Status RunBlock(
                       std::unique_ptr<memory_model::BlockMemoryModel>>
       model_memories;
 
+  std::vector<RamRewriteProto> modeled_rewrites;
   for (const RamRewriteProto& rewrite : ram_rewrites.rewrites()) {
+    absl::c_move(ExpandRamBanks(rewrite),
+                 std::back_inserter(modeled_rewrites));
+  }
+  for (const RamRewriteProto& rewrite : modeled_rewrites) {
     const std::string& name = rewrite.to_name_prefix();
     const std::string_view& wr_data = ram_info.at(name).wr_data;
     XLS_ASSIGN_OR_RETURN(const OutputPort* port, block->GetOutputPort(wr_data));
@@ -823,6 +1301,49 @@ static absl::Status RunBlock(
     XLS_RETURN_IF_ERROR(continuation->SetObserver(*cov.observer()));
   }
 
+  // Without per-cycle instrumentation, memory models or randomized valids the
+  // channels of a jitted block can be streamed natively.
+  if (options.use_jit && !needs_observer && model_memories.empty() &&
+      options.trace_ring_cycles == 0 && !options.show_trace &&
+      options.prob_input_valid_assert >= 1.0) {
+    XLS_ASSIGN_OR_RETURN(
+        BlockJitContinuation * streaming_continuation,
+        kJitBlockEvaluator.GetJitContinuation(continuation.get()));
+    return RunBlockWithChannelDriver(
+        block, streaming_continuation, signature, channel_info,
+        inputs_for_channels, expected_outputs_for_channels, output_stats_path,
+        options);
+  }
+
+  BlockJitContinuation* jit_continuation = nullptr;
+  std::unique_ptr<BlockTraceBuffer> trace_ring;
+  if (options.trace_ring_cycles > 0) {
+    if (!options.use_jit) {
+      return absl::InvalidArgumentError(
+          "--trace_ring_cycles is only supported by the block_jit backend");
+    }
+    if (options.trace_ring_vcd_path.empty()) {
+      return absl::InvalidArgumentError(
+          "--trace_ring_cycles requires --trace_ring_vcd_path");
+    }
+    XLS_ASSIGN_OR_RETURN(
+        jit_continuation,
+        kJitBlockEvaluator.GetJitContinuation(continuation.get()));
+    XLS_ASSIGN_OR_RETURN(trace_ring,
+                         BlockTraceBuffer::Create(jit_continuation->jit(),
+                                                  options.trace_ring_cycles));
+  }
+  bool trace_ring_dumped = false;
+  auto dump_trace_ring = [&]() -> absl::Status {
+    if (trace_ring == nullptr || trace_ring_dumped) {
+      return absl::OkStatus();
+    }
+    trace_ring_dumped = true;
+    LOG(INFO) << "Writing the last " << trace_ring->size() << " cycles to "
+              << options.trace_ring_vcd_path;
+    return SetFileContents(options.trace_ring_vcd_path, trace_ring->ToVcd());
+  };
+
   int64_t last_output_cycle = 0;
   int64_t matched_outputs = 0;
   bool checked_any_output = false;
@@ -891,7 +1412,13 @@ static absl::Status RunBlock(
       XLS_RET_CHECK(info.ready_valid);
       input_set[info.channel_ready] = Value(xls::UBits(1, 1));
     }
+    if (trace_ring != nullptr) {
+      trace_ring->BeginCycle(*jit_continuation);
+    }
     XLS_RETURN_IF_ERROR(continuation->RunOneCycle(input_set));
+    if (trace_ring != nullptr) {
+      trace_ring->EndCycle(*jit_continuation);
+    }
     const absl::flat_hash_map<std::string, Value>& outputs =
         continuation->output_ports();
 
@@ -899,6 +1426,9 @@ static absl::Status RunBlock(
     const xls::InterpreterEvents& events = continuation->events();
     XLS_RETURN_IF_ERROR(LogInterpreterEvents(block->name(), events));
 
+    if (!events.assert_msgs.empty()) {
+      XLS_RETURN_IF_ERROR(dump_trace_ring());
+    }
     if (!events.assert_msgs.empty() && options.fail_on_assert) {
       return absl::UnknownError(absl::StrFormat(
           "Assert(s) fired:\n\n%s", absl::StrJoin(events.assert_msgs, "\n")));
@@ -978,6 +1508,7 @@ static absl::Status RunBlock(
       }
     }
     if (!errors.empty()) {
+      XLS_RETURN_IF_ERROR(dump_trace_ring());
       return absl::UnknownError(absl::StrFormat(
           "Outputs did not match expectations after cycle %d:\n\n%s", cycle,
           absl::StrJoin(errors, "\n")));
@@ -1106,6 +1637,29 @@ GetValuesForEachChannels(
   return values_for_channels;
 }
 
+// Reads channel values from a ProcChannelValuesProto or, if the file is one, a
+// channel trace (see xls/jit/channel_trace.h).
+static absl::StatusOr<absl::btree_map<std::string, std::vector<Value>>>
+ParseChannelValuesFromProtoOrTraceFile(std::string_view filename,
+                                       const int64_t total_ticks) {
+  XLS_ASSIGN_OR_RETURN(MappedFile file, MappedFile::Open(filename));
+  if (!IsChannelTrace(file.contents())) {
+    return ParseChannelValuesFromProtoFile(filename, total_ticks);
+  }
+  Package package("channel_trace");
+  XLS_ASSIGN_OR_RETURN(ChannelTrace trace,
+                       ChannelTrace::Open(filename, &package));
+  XLS_ASSIGN_OR_RETURN(
+      (absl::btree_map<std::string, std::vector<Value>> values_for_channels),
+      ChannelTraceToChannelValues(trace));
+  for (auto& [_, values] : values_for_channels) {
+    if (static_cast<int64_t>(values.size()) > total_ticks) {
+      values.resize(total_ticks);
+    }
+  }
+  return values_for_channels;
+}
+
 static absl::Status RealMain(
     std::string_view ir_file, std::string_view backend,
     std::string_view block_signature_proto, std::vector<int64_t> ticks,
@@ -1137,7 +1691,7 @@ static absl::Status RealMain(
         ParseChannelValuesFromFile(inputs_for_all_channels_text, total_ticks));
   } else if (!proto_inputs_for_all_channels.empty()) {
     XLS_ASSIGN_OR_RETURN(inputs_for_channels,
-                         ParseChannelValuesFromProtoFile(
+                         ParseChannelValuesFromProtoOrTraceFile(
                              proto_inputs_for_all_channels, total_ticks));
   } else if (!testvector_proto.empty()) {
     XLS_ASSIGN_OR_RETURN(
@@ -1159,8 +1713,8 @@ static absl::Status RealMain(
   } else if (!expected_proto_outputs_for_all_channels.empty()) {
     XLS_ASSIGN_OR_RETURN(
         expected_outputs_for_channels,
-        ParseChannelValuesFromProtoFile(expected_proto_outputs_for_all_channels,
-                                        total_ticks));
+        ParseChannelValuesFromProtoOrTraceFile(
+            expected_proto_outputs_for_all_channels, total_ticks));
   }
 
   RamRewritesProto ram_rewrites;
@@ -1171,7 +1725,7 @@ static absl::Status RealMain(
   }
 
   XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_file));
-  XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(auto package, ParsePackageTextOrBinary(ir_text));
 
   if (backend.starts_with("block")) {
     RunBlockOptions block_options = {
@@ -1181,7 +1735,9 @@ static absl::Status RealMain(
         .random_seed = random_seed,
         .prob_input_valid_assert = prob_input_valid_assert,
         .show_trace = show_trace,
-        .fail_on_assert = fail_on_assert};
+        .fail_on_assert = fail_on_assert,
+        .trace_ring_cycles = absl::GetFlag(FLAGS_trace_ring_cycles),
+        .trace_ring_vcd_path = absl::GetFlag(FLAGS_trace_ring_vcd_path)};
     if (backend == "block_jit") {
       block_options.use_jit = true;
     } else if (backend == "block_interpreter") {
@@ -1197,14 +1753,37 @@ static absl::Status RealMain(
   }
 
   // Not block sim
+  ChannelStreamsOptions streams_options;
+  XLS_ASSIGN_OR_RETURN(
+      streams_options.inputs,
+      ParseChannelFilenames(
+          absl::GetFlag(FLAGS_streaming_inputs_for_channels)));
+  XLS_ASSIGN_OR_RETURN(
+      streams_options.expected_outputs,
+      ParseChannelFilenames(
+          absl::GetFlag(FLAGS_streaming_expected_outputs_for_channels)));
+  XLS_ASSIGN_OR_RETURN(
+      streams_options.outputs,
+      ParseChannelFilenames(
+          absl::GetFlag(FLAGS_streaming_outputs_for_channels)));
+  XLS_ASSIGN_OR_RETURN(
+      streams_options.format,
+      ChannelStreamFormatFromString(absl::GetFlag(FLAGS_streaming_format)));
+  streams_options.queue_depth = absl::GetFlag(FLAGS_streaming_queue_depth);
+
   EvaluateProcsOptions evaluate_procs_options = {
       .fail_on_assert = fail_on_assert,
       .ticks = ticks,
       .top = absl::GetFlag(FLAGS_top),
+      .streams = std::move(streams_options),
   };
 
   if (backend == "serial_jit") {
     evaluate_procs_options.use_jit = true;
+  } else if (backend == "parallel_jit") {
+    evaluate_procs_options.use_jit = true;
+    evaluate_procs_options.use_parallel_runtime = true;
+    evaluate_procs_options.thread_count = absl::GetFlag(FLAGS_threads);
   } else if (backend == "ir_interpreter") {
     evaluate_procs_options.use_jit = false;
   } else {
@@ -1226,8 +1805,9 @@ int main(int argc, char* argv[]) {
   }
 
   std::string backend = absl::GetFlag(FLAGS_backend);
-  if (backend != "serial_jit" && backend != "ir_interpreter" &&
-      backend != "block_interpreter" && backend != "block_jit") {
+  if (backend != "serial_jit" && backend != "parallel_jit" &&
+      backend != "ir_interpreter" && backend != "block_interpreter" &&
+      backend != "block_jit") {
     LOG(QFATAL) << "Unrecognized backend choice.";
   }
 
@@ -1236,6 +1816,19 @@ int main(int argc, char* argv[]) {
     LOG(QFATAL) << "Block evaluation requires --block_signature_proto.";
   }
 
+  if ((backend == "block_interpreter" || backend == "block_jit") &&
+      (!absl::GetFlag(FLAGS_streaming_inputs_for_channels).empty() ||
+       !absl::GetFlag(FLAGS_streaming_expected_outputs_for_channels).empty() ||
+       !absl::GetFlag(FLAGS_streaming_outputs_for_channels).empty())) {
+    LOG(QFATAL) << "Streaming channels are not supported by block evaluation.";
+  }
+  if (absl::GetFlag(FLAGS_threads) < 0) {
+    LOG(QFATAL) << "--threads must not be negative.";
+  }
+  if (absl::GetFlag(FLAGS_streaming_queue_depth) < 1) {
+    LOG(QFATAL) << "--streaming_queue_depth must be positive.";
+  }
+
   std::vector<int64_t> ticks;
   for (const std::string& run_str : absl::GetFlag(FLAGS_ticks)) {
     int ticks_int;
@@ -477,6 +477,69 @@ class EvalProcTest(parameterized.TestCase):
     output = run_command(shared_args + ["--backend", "serial_jit"])
     self.assertIn("Proc __eval_proc_main_test__test_proc_0_next", output.stderr)
 
+  @parameterized.parameters("serial_jit", "parallel_jit")
+  def test_streaming_binary_channels(self, backend):
+    def pack(values):
+      return b"".join(struct.pack("<Q", v) for v in values)
+
+    input_file = self.create_tempfile(content=pack([42, 101]))
+    input_file_2 = self.create_tempfile(content=pack([10, 6]))
+    expected_file = self.create_tempfile(content=pack([62, 127]))
+    output_file = self.create_tempfile()
+
+    run_command([
+        EVAL_PROC_MAIN_PATH,
+        PROC_PATH,
+        "--ticks",
+        "-1",
+        "--backend",
+        backend,
+        "--streaming_format",
+        "binary",
+        "--streaming_queue_depth",
+        "1",
+        "--streaming_inputs_for_channels",
+        "eval_proc_main_test__in_ch={infile1},eval_proc_main_test__in_ch_2={infile2}"
+        .format(infile1=input_file.full_path, infile2=input_file_2.full_path),
+        "--streaming_expected_outputs_for_channels",
+        "eval_proc_main_test__out_ch={}".format(expected_file.full_path),
+        "--streaming_outputs_for_channels",
+        "eval_proc_main_test__out_ch_2={}".format(output_file.full_path),
+    ])
+    self.assertEqual(output_file.read_bytes(), pack([55, 55]))
+
+  def test_streaming_mismatch(self):
+    input_file = self.create_tempfile(content="bits[64]:42\nbits[64]:101\n")
+    input_file_2 = self.create_tempfile(content="bits[64]:10\nbits[64]:6\n")
+    expected_file = self.create_tempfile(
+        content="bits[64]:62\nbits[64]:128\n"
+    )
+
+    comp = subprocess.run(
+        [
+            EVAL_PROC_MAIN_PATH,
+            PROC_PATH,
+            "--ticks",
+            "-1",
+            "--streaming_inputs_for_channels",
+            "eval_proc_main_test__in_ch={infile1},eval_proc_main_test__in_ch_2={infile2}"
+            .format(
+                infile1=input_file.full_path, infile2=input_file_2.full_path
+            ),
+            "--streaming_expected_outputs_for_channels",
+            "eval_proc_main_test__out_ch={}".format(expected_file.full_path),
+        ],
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        encoding="utf-8",
+        check=False,
+    )
+    self.assertNotEqual(comp.returncode, 0)
+    self.assertIn(
+        "Mismatched (channel=eval_proc_main_test__out_ch) after 1 outputs",
+        comp.stderr,
+    )
+
   def test_reset_static(self):
     input_file = self.create_tempfile(content=textwrap.dedent("""
           bits[64]:42
@@ -1054,6 +1117,55 @@ rewrites {
     output = run_command(shared_args)
     self.assertIn("Proc Test_proc", output.stderr)
 
+  def test_proc_rewritten_memory_with_latency(self):
+    ir_file = PROC_REWRITTEN_MEMORY_IR_PATH
+    ram_rewrites_file = BLOCK_MEMORY_REWRITES_PATH
+    input_file = self.create_tempfile(content=textwrap.dedent("""
+          in : {
+            bits[32]:42
+            bits[32]:101
+            bits[32]:50
+            bits[32]:11
+          }
+        """))
+    output_file = self.create_tempfile(content=textwrap.dedent("""
+          out : {
+            bits[32]:126
+            bits[32]:303
+            bits[32]:150
+            bits[32]:33
+          }
+        """))
+
+    shared_args = [
+        EVAL_PROC_MAIN_PATH,
+        ir_file,
+        "--ticks",
+        "64",
+        "--logtostderr",
+        "--inputs_for_all_channels",
+        input_file.full_path,
+        "--expected_outputs_for_all_channels",
+        output_file.full_path,
+        "--ram_rewrites_textproto",
+        ram_rewrites_file,
+        "--ram_latency",
+        "3",
+        "--backend",
+        "serial_jit",
+    ]
+
+    run_command(shared_args)
+
+    # Latency needs the native memory model of the JIT.
+    output = subprocess.run(
+        shared_args[:-2] + ["--backend", "ir_interpreter"],
+        capture_output=True,
+        check=False,
+    )
+    self.assertNotEqual(output.returncode, 0)
+    self.assertIn(b"only supported with the JIT", output.stderr)
+
   @parameterized_block_backends
   def test_observe_block(self, backend):
     ir_file = self.create_tempfile(content=OBSERVER_IR)
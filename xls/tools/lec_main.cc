@@ -22,6 +22,7 @@
 #include <filesystem>  // NOLINT
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -31,9 +32,11 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "xls/common/exit_status.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/common/file/get_runfile_path.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -100,6 +103,12 @@ ABSL_FLAG(int32_t, stage, -1,
           "Pipeline stage to evaluate. Requires --schedule.\n"
           "If \"schedule\" is set, but this is not, then the entire module "
           "will be evaluated.");
+ABSL_FLAG(bool, per_output_bit, false,
+          "If true, prove each output bit separately, several at once, and "
+          "report a result per bit. --timeout_sec then applies to each bit.");
+ABSL_FLAG(int64_t, parallelism, 0,
+          "With --per_output_bit, the number of bits to prove at once. If "
+          "zero, the number of hardware threads.");
 
 namespace xls {
 namespace {
@@ -129,8 +138,8 @@ absl::StatusOr<netlist::CellLibrary> GetCellLibrary(
 // Loads and parses a netlist from a file.
 absl::StatusOr<std::unique_ptr<netlist::rtl::Netlist>> GetNetlist(
     std::string_view netlist_path, netlist::CellLibrary* cell_library) {
-  XLS_ASSIGN_OR_RETURN(std::string netlist_text, GetFileContents(netlist_path));
-  netlist::rtl::Scanner scanner(netlist_text);
+  XLS_ASSIGN_OR_RETURN(MappedFile netlist_file, MappedFile::Open(netlist_path));
+  netlist::rtl::Scanner scanner(netlist_file.contents());
   return netlist::rtl::Parser::ParseNetlist(cell_library, &scanner);
 }
 
@@ -238,7 +247,8 @@ static absl::Status RealMain(
     std::string_view netlist_module_name, std::string_view cell_lib_path,
     std::string_view cell_proto_path, std::string_view netlist_path,
     std::string_view constraints_file, std::string_view schedule_path,
-    int stage, bool auto_stage, int timeout_sec) {
+    int stage, bool auto_stage, int timeout_sec, bool per_output_bit,
+    int64_t parallelism) {
   solvers::z3::LecParams lec_params;
   XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
@@ -257,24 +267,20 @@ static absl::Status RealMain(
   lec_params.netlist = netlist.get();
   lec_params.netlist_module_name = netlist_module_name;
 
-  std::unique_ptr<solvers::z3::Lec> lec;
+  std::optional<PipelineSchedule> schedule;
   if (!schedule_path.empty()) {
     XLS_ASSIGN_OR_RETURN(
         PackagePipelineSchedulesProto proto,
         ParseTextProtoFile<PackagePipelineSchedulesProto>(schedule_path));
     XLS_ASSIGN_OR_RETURN(
-        PipelineSchedule schedule,
-        PipelineSchedule::FromProto(lec_params.ir_function, proto));
+        schedule, PipelineSchedule::FromProto(lec_params.ir_function, proto));
     if (auto_stage) {
-      return AutoStage(lec_params, schedule, timeout_sec);
+      return AutoStage(lec_params, *schedule, timeout_sec);
     }
-    XLS_ASSIGN_OR_RETURN(
-        lec, solvers::z3::Lec::CreateForStage(lec_params, schedule, stage));
-  } else {
-    XLS_ASSIGN_OR_RETURN(lec, solvers::z3::Lec::Create(lec_params));
   }
 
   std::unique_ptr<Package> constraints_pkg;
+  Function* constraints = nullptr;
   if (!constraints_file.empty()) {
     XLS_ASSIGN_OR_RETURN(std::filesystem::path ir_converter_path,
                          GetXlsRunfilePath(kIrConverterPath));
@@ -287,11 +293,46 @@ static absl::Status RealMain(
 
     XLS_ASSIGN_OR_RETURN(constraints_pkg,
                          Parser::ParsePackage(stdout_and_stderr.first));
-    XLS_ASSIGN_OR_RETURN(Function * function,
-                         constraints_pkg->GetTopAsFunction());
-    XLS_RETURN_IF_ERROR(lec->AddConstraints(function));
+    XLS_ASSIGN_OR_RETURN(constraints, constraints_pkg->GetTopAsFunction());
   }
 
+  auto create_lec =
+      [&]() -> absl::StatusOr<std::unique_ptr<solvers::z3::Lec>> {
+    std::unique_ptr<solvers::z3::Lec> lec;
+    if (schedule.has_value()) {
+      XLS_ASSIGN_OR_RETURN(lec, solvers::z3::Lec::CreateForStage(
+                                    lec_params, *schedule, stage));
+    } else {
+      XLS_ASSIGN_OR_RETURN(lec, solvers::z3::Lec::Create(lec_params));
+    }
+    if (constraints != nullptr) {
+      XLS_RETURN_IF_ERROR(lec->AddConstraints(constraints));
+    }
+    return lec;
+  };
+
+  if (per_output_bit) {
+    solvers::z3::LecPerOutputBitOptions options{.parallelism = parallelism};
+    if (timeout_sec != -1) {
+      options.timeout_per_bit = absl::Seconds(timeout_sec);
+    }
+    XLS_ASSIGN_OR_RETURN(
+        std::vector<solvers::z3::LecOutputBitResult> results,
+        solvers::z3::RunLecPerOutputBit(create_lec, options));
+    int64_t equivalent_count = 0;
+    for (const solvers::z3::LecOutputBitResult& result : results) {
+      std::cout << result.name << ": "
+                << solvers::z3::LecOutputBitResultToString(result.result)
+                << '\n';
+      equivalent_count += result.result == Z3_L_FALSE ? 1 : 0;
+    }
+    std::cout << equivalent_count << " of " << results.size()
+              << " output bits proved equivalent.\n";
+    return absl::OkStatus();
+  }
+
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<solvers::z3::Lec> lec, create_lec());
+
   struct sigaction old_action;
   if (timeout_sec != -1) {
     old_action = SetAlarm(timeout_sec);
@@ -347,5 +388,6 @@ int main(int argc, char* argv[]) {
       ir_path, absl::GetFlag(FLAGS_entry_function_name),
       absl::GetFlag(FLAGS_netlist_module_name), cell_lib_path, cell_proto_path,
       netlist_path, absl::GetFlag(FLAGS_constraints_file), schedule_path, stage,
-      auto_stage, absl::GetFlag(FLAGS_timeout_sec)));
+      auto_stage, absl::GetFlag(FLAGS_timeout_sec),
+      absl::GetFlag(FLAGS_per_output_bit), absl::GetFlag(FLAGS_parallelism)));
 }
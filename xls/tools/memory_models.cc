@@ -14,11 +14,15 @@
 
 #include "xls/tools/memory_models.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -34,6 +38,9 @@
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_utils.h"
+#include "xls/jit/jit_channel_queue.h"
+#include "xls/jit/jit_runtime.h"
+#include "xls/jit/type_layout.h"
 
 namespace xls {
 
@@ -207,7 +214,16 @@ class RewrittenProcMemoryModel : public ProcMemoryModel {
   ChannelQueue* write_completion_channel_;
 };
 
-absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateAbstractProcMemoryModel(
+namespace {
+
+struct AbstractRamQueues {
+  ChannelQueue* read_request;
+  ChannelQueue* read_response;
+  ChannelQueue* write_request;
+  ChannelQueue* write_response;
+};
+
+absl::StatusOr<AbstractRamQueues> GetAbstractRamQueues(
     const RamRewriteProto& ram_rewrite, ChannelQueueManager& queue_manager) {
   ChannelQueue* read_request_queue = nullptr;
   ChannelQueue* read_response_queue = nullptr;
@@ -255,11 +271,23 @@ absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateAbstractProcMemoryModel(
         absl::StrFormat("No write response channel found for RAM rewrite %s",
                         ram_rewrite.to_name_prefix()));
   }
+  return AbstractRamQueues{.read_request = read_request_queue,
+                           .read_response = read_response_queue,
+                           .write_request = write_request_queue,
+                           .write_response = write_response_queue};
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateAbstractProcMemoryModel(
+    const RamRewriteProto& ram_rewrite, ChannelQueueManager& queue_manager) {
+  XLS_ASSIGN_OR_RETURN(AbstractRamQueues queues,
+                       GetAbstractRamQueues(ram_rewrite, queue_manager));
 
   auto memory_model = std::make_unique<AbstractProcMemoryModel>(
       ram_rewrite.to_name_prefix(),
-      /*size=*/ram_rewrite.from_config().depth(), read_request_queue,
-      read_response_queue, write_request_queue, write_response_queue);
+      /*size=*/ram_rewrite.from_config().depth(), queues.read_request,
+      queues.read_response, queues.write_request, queues.write_response);
 
   return std::move(memory_model);
 }
@@ -300,6 +328,321 @@ absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateRewrittenProcMemoryModel(
   return std::move(memory_model);
 }
 
+namespace {
+
+// Location of an element of a tuple in the JIT's native layout of the tuple.
+struct NativeField {
+  int64_t offset = 0;
+  int64_t size = 0;
+};
+
+// A port of a RAM: the request channel and the response channels it is
+// answered on. Ports without a read response channel never read, and ports
+// without a write completion channel never write. Ports with both are told
+// which to do by the enables in each request.
+struct JitRamPort {
+  JitChannelQueue* request;
+  NativeField address;
+  std::optional<NativeField> write_data;
+  std::optional<NativeField> write_enable;
+  std::optional<NativeField> read_enable;
+
+  JitChannelQueue* read_response = nullptr;
+  int64_t read_response_size = 0;
+  NativeField read_response_data;
+
+  JitChannelQueue* write_completion = nullptr;
+  int64_t write_completion_size = 0;
+};
+
+// Keeps the contents of the memory as a flat array of words in the JIT's
+// native layout and services requests by copying bytes between it and the
+// slots of the JIT channel queues of the RAM, never converting to Values.
+// Like the other models, reads see the contents of the memory before the
+// writes of the same tick.
+class JitProcMemoryModel : public ProcMemoryModel {
+ public:
+  JitProcMemoryModel(std::string name, int64_t depth,
+                     std::vector<uint8_t> initial_word,
+                     std::vector<JitRamPort> ports, int64_t latency)
+      : name_(std::move(name)),
+        depth_(depth),
+        word_size_(initial_word.size()),
+        ports_(std::move(ports)),
+        latency_(latency) {
+    words_.resize(depth_ * word_size_);
+    for (int64_t i = 0; i < depth_; ++i) {
+      std::copy(initial_word.begin(), initial_word.end(),
+                words_.begin() + i * word_size_);
+    }
+  }
+
+  absl::Status Tick() override {
+    ++tick_;
+    write_addresses_.clear();
+    write_data_.clear();
+    for (const JitRamPort& port : ports_) {
+      while (const uint8_t* request = port.request->PeekReadSlot()) {
+        absl::Status status = ServiceRequest(port, request);
+        port.request->ReleaseReadSlot();
+        XLS_RETURN_IF_ERROR(status);
+      }
+    }
+    for (int64_t i = 0; i < write_addresses_.size(); ++i) {
+      const auto& [address, port] = write_addresses_[i];
+      std::copy_n(write_data_.begin() + i * word_size_, word_size_,
+                  words_.begin() + address * word_size_);
+      Respond(port->write_completion, port->write_completion_size,
+              /*offset=*/0, /*word=*/nullptr);
+    }
+    while (!delayed_responses_.empty() &&
+           delayed_responses_.front().due_tick <= tick_) {
+      const DelayedResponse& response = delayed_responses_.front();
+      WriteResponse(response.queue, response.size, response.offset,
+                    response.word.empty() ? nullptr : response.word.data());
+      delayed_responses_.pop_front();
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  struct DelayedResponse {
+    int64_t due_tick;
+    JitChannelQueue* queue;
+    int64_t size;
+    int64_t offset;
+    std::vector<uint8_t> word;
+  };
+
+  absl::Status ServiceRequest(const JitRamPort& port, const uint8_t* request) {
+    bool read = port.read_response != nullptr &&
+                (!port.read_enable.has_value() ||
+                 IsEnabled(request, *port.read_enable));
+    bool write = port.write_completion != nullptr &&
+                 (!port.write_enable.has_value() ||
+                  IsEnabled(request, *port.write_enable));
+    if (!read && !write) {
+      return absl::OkStatus();
+    }
+    XLS_RET_CHECK(!(read && write));
+    XLS_ASSIGN_OR_RETURN(int64_t address, GetAddress(request, port.address));
+    if (read) {
+      Respond(port.read_response, port.read_response_size,
+              port.read_response_data.offset,
+              words_.data() + address * word_size_);
+    } else {
+      write_addresses_.push_back({address, &port});
+      const uint8_t* data = request + port.write_data->offset;
+      write_data_.insert(write_data_.end(), data, data + word_size_);
+    }
+    return absl::OkStatus();
+  }
+
+  static bool IsEnabled(const uint8_t* request, NativeField enable) {
+    return enable.size > 0 && (request[enable.offset] & 1) != 0;
+  }
+
+  absl::StatusOr<int64_t> GetAddress(const uint8_t* request,
+                                     NativeField field) const {
+    uint64_t address = 0;
+    std::memcpy(&address, request + field.offset,
+                std::min<int64_t>(field.size, sizeof(address)));
+    bool in_range = address < depth_;
+    for (int64_t i = sizeof(address); i < field.size; ++i) {
+      in_range = in_range && request[field.offset + i] == 0;
+    }
+    if (!in_range) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Request address %d to memory %s out of range [0, %d)", address,
+          name_, depth_));
+    }
+    return address;
+  }
+
+  // Sends a response of `size` bytes holding `word` (if not null) at `offset`,
+  // after the latency of the memory.
+  void Respond(JitChannelQueue* queue, int64_t size, int64_t offset,
+               const uint8_t* word) {
+    if (latency_ == 0) {
+      WriteResponse(queue, size, offset, word);
+      return;
+    }
+    delayed_responses_.push_back(DelayedResponse{
+        .due_tick = tick_ + latency_,
+        .queue = queue,
+        .size = size,
+        .offset = offset,
+        .word = word == nullptr ? std::vector<uint8_t>()
+                                : std::vector<uint8_t>(word, word + word_size_),
+    });
+  }
+
+  void WriteResponse(JitChannelQueue* queue, int64_t size, int64_t offset,
+                     const uint8_t* word) {
+    uint8_t* slot = queue->AcquireWriteSlot();
+    std::memset(slot, 0, size);
+    if (word != nullptr) {
+      std::memcpy(slot + offset, word, word_size_);
+    }
+    queue->CommitWriteSlot();
+  }
+
+  std::string name_;
+  int64_t depth_;
+  int64_t word_size_;
+  std::vector<uint8_t> words_;
+  std::vector<JitRamPort> ports_;
+  int64_t latency_;
+  int64_t tick_ = 0;
+
+  // Writes of the current tick, applied once all of its reads are done.
+  std::vector<std::pair<int64_t, const JitRamPort*>> write_addresses_;
+  std::vector<uint8_t> write_data_;
+
+  std::deque<DelayedResponse> delayed_responses_;
+};
+
+absl::StatusOr<JitChannelQueue*> AsJitChannelQueue(ChannelQueue* queue) {
+  auto* jit_queue = dynamic_cast<JitChannelQueue*>(queue);
+  if (jit_queue == nullptr) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "Queue of channel %s is not a JIT channel queue",
+        queue->channel()->name()));
+  }
+  return jit_queue;
+}
+
+absl::StatusOr<JitChannelQueue*> GetJitChannelQueue(
+    ChannelQueueManager& queue_manager, std::string_view name) {
+  XLS_ASSIGN_OR_RETURN(ChannelQueue * queue,
+                       queue_manager.GetQueueByName(name));
+  return AsJitChannelQueue(queue);
+}
+
+// Returns the location of element `index` of the tuples carried by `queue`.
+absl::StatusOr<NativeField> GetTupleElementField(JitChannelQueue* queue,
+                                                 int64_t index) {
+  Type* type = queue->channel()->type();
+  XLS_RET_CHECK(type->IsTuple()) << type->ToString();
+  TupleType* tuple_type = type->AsTupleOrDie();
+  XLS_RET_CHECK_LT(index, tuple_type->size()) << type->ToString();
+  Type* element_type = tuple_type->element_type(index);
+  if (element_type->leaf_count() == 0) {
+    return NativeField{};
+  }
+  // The first leaf of an aggregate sits at the start of the aggregate.
+  int64_t leaf = 0;
+  for (int64_t i = 0; i < index; ++i) {
+    leaf += tuple_type->element_type(i)->leaf_count();
+  }
+  TypeLayout layout = queue->jit_runtime()->CreateTypeLayout(type);
+  return NativeField{
+      .offset = layout.elements()[leaf].offset,
+      .size = queue->jit_runtime()->GetTypeByteSize(element_type)};
+}
+
+absl::StatusOr<JitRamPort> MakeReadPort(JitChannelQueue* request,
+                                        JitChannelQueue* response) {
+  JitRamPort port{.request = request};
+  XLS_ASSIGN_OR_RETURN(port.address, GetTupleElementField(request, 0));
+  port.read_response = response;
+  port.read_response_size =
+      response->jit_runtime()->GetTypeByteSize(response->channel()->type());
+  XLS_ASSIGN_OR_RETURN(port.read_response_data,
+                       GetTupleElementField(response, 0));
+  return port;
+}
+
+absl::StatusOr<JitRamPort> MakeWritePort(JitChannelQueue* request,
+                                         JitChannelQueue* completion) {
+  JitRamPort port{.request = request};
+  XLS_ASSIGN_OR_RETURN(port.address, GetTupleElementField(request, 0));
+  XLS_ASSIGN_OR_RETURN(port.write_data, GetTupleElementField(request, 1));
+  port.write_completion = completion;
+  port.write_completion_size =
+      completion->jit_runtime()->GetTypeByteSize(completion->channel()->type());
+  return port;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateJitProcMemoryModel(
+    const RamRewriteProto& ram_rewrite, ChannelQueueManager& queue_manager,
+    bool abstract, int64_t latency) {
+  XLS_RET_CHECK_GE(latency, 0);
+  const std::string& prefix = ram_rewrite.to_name_prefix();
+  std::vector<JitRamPort> ports;
+  JitChannelQueue* read_response = nullptr;
+  if (abstract || ram_rewrite.to_config().kind() == RamKindProto::RAM_1R1W) {
+    AbstractRamQueues queues;
+    if (abstract) {
+      XLS_ASSIGN_OR_RETURN(queues,
+                           GetAbstractRamQueues(ram_rewrite, queue_manager));
+    } else {
+      XLS_ASSIGN_OR_RETURN(queues.read_request, queue_manager.GetQueueByName(
+                                                    prefix + "_read_req"));
+      XLS_ASSIGN_OR_RETURN(queues.read_response, queue_manager.GetQueueByName(
+                                                     prefix + "_read_resp"));
+      XLS_ASSIGN_OR_RETURN(queues.write_request, queue_manager.GetQueueByName(
+                                                     prefix + "_write_req"));
+      XLS_ASSIGN_OR_RETURN(
+          queues.write_response,
+          queue_manager.GetQueueByName(prefix + "_write_completion"));
+    }
+    XLS_ASSIGN_OR_RETURN(JitChannelQueue * read_request,
+                         AsJitChannelQueue(queues.read_request));
+    XLS_ASSIGN_OR_RETURN(read_response,
+                         AsJitChannelQueue(queues.read_response));
+    XLS_ASSIGN_OR_RETURN(JitChannelQueue * write_request,
+                         AsJitChannelQueue(queues.write_request));
+    XLS_ASSIGN_OR_RETURN(JitChannelQueue * write_completion,
+                         AsJitChannelQueue(queues.write_response));
+    XLS_ASSIGN_OR_RETURN(JitRamPort read_port,
+                         MakeReadPort(read_request, read_response));
+    XLS_ASSIGN_OR_RETURN(JitRamPort write_port,
+                         MakeWritePort(write_request, write_completion));
+    ports.push_back(read_port);
+    ports.push_back(write_port);
+  } else if (ram_rewrite.to_config().kind() == RamKindProto::RAM_1RW) {
+    // Requests are (addr, data, write_mask, read_mask, we, re).
+    XLS_ASSIGN_OR_RETURN(JitChannelQueue * request,
+                         GetJitChannelQueue(queue_manager, prefix + "_req"));
+    XLS_ASSIGN_OR_RETURN(read_response,
+                         GetJitChannelQueue(queue_manager, prefix + "_resp"));
+    XLS_ASSIGN_OR_RETURN(
+        JitChannelQueue * write_completion,
+        GetJitChannelQueue(queue_manager, prefix + "_write_completion"));
+    XLS_ASSIGN_OR_RETURN(JitRamPort port,
+                         MakeReadPort(request, read_response));
+    XLS_ASSIGN_OR_RETURN(JitRamPort write_port,
+                         MakeWritePort(request, write_completion));
+    port.write_data = write_port.write_data;
+    port.write_completion = write_port.write_completion;
+    port.write_completion_size = write_port.write_completion_size;
+    XLS_ASSIGN_OR_RETURN(port.write_enable, GetTupleElementField(request, 4));
+    XLS_ASSIGN_OR_RETURN(port.read_enable, GetTupleElementField(request, 5));
+    ports.push_back(port);
+  } else {
+    return absl::UnimplementedError(absl::StrFormat(
+        "No JIT memory model for RamKind %s of RAM rewrite %s",
+        RamKindProto_Name(ram_rewrite.to_config().kind()), prefix));
+  }
+
+  // Memories start out filled with Xs, as in the other models.
+  Type* read_response_type = read_response->channel()->type();
+  XLS_RET_CHECK(read_response_type->IsTuple());
+  XLS_RET_CHECK_EQ(read_response_type->AsTupleOrDie()->size(), 1);
+  Type* word_type = read_response_type->AsTupleOrDie()->element_type(0);
+  JitRuntime* jit_runtime = read_response->jit_runtime();
+  std::vector<uint8_t> initial_word(jit_runtime->GetTypeByteSize(word_type));
+  jit_runtime->CreateTypeLayout(word_type).ValueToNativeLayout(
+      XsOfType(word_type), initial_word.data());
+
+  return std::make_unique<JitProcMemoryModel>(
+      prefix, ram_rewrite.from_config().depth(), std::move(initial_word),
+      std::move(ports), latency);
+}
+
 // TODO: Implement in XLS using XLS IR (DSLX/C++ source) google/xls#1638
 // Possibly replace with ram.x, which also implements different
 // simultaneous read/write behaviors.
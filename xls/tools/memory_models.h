@@ -50,6 +50,17 @@ absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateAbstractProcMemoryModel(
 absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateRewrittenProcMemoryModel(
     const RamRewriteProto& ram_rewrite, ChannelQueueManager& queue_manager);
 
+// Creates a model of the memory of `ram_rewrite` for procs run by the JIT,
+// whose channel queues must all be JitChannelQueues. The contents of the
+// memory are kept as a flat array in the JIT's native layout and requests are
+// serviced by copying bytes between it and the slots of the queues, so no
+// Values are built per access. Models the abstract RAM channels if `abstract`
+// and otherwise the rewritten 1RW or 1R1W channels. Responses are delivered
+// `latency` ticks after their requests are serviced.
+absl::StatusOr<std::unique_ptr<ProcMemoryModel>> CreateJitProcMemoryModel(
+    const RamRewriteProto& ram_rewrite, ChannelQueueManager& queue_manager,
+    bool abstract, int64_t latency);
+
 class BlockMemoryModel {
  public:
   BlockMemoryModel(const std::string& name, size_t size,
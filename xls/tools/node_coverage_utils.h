@@ -48,6 +48,10 @@ class CoverageEvalObserver final : public EvaluationObserver,
     return std::nullopt;
   }
   void RecordNodeValue(int64_t node_ptr, const uint8_t* data) override;
+  // Accumulated coverage is merged exactly like a single value.
+  void RecordNodeCoverage(int64_t node_ptr, const uint8_t* data) override {
+    RecordNodeValue(node_ptr, data);
+  }
 
   // Prepare for proto conversion.
   absl::Status Finalize();
@@ -30,10 +30,11 @@
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/visitor.h"
+#include "xls/ir/binary_ir.h"
 #include "xls/ir/function_base.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/package.h"
 #include "xls/ir/verifier.h"
+#include "xls/passes/analysis_manager.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_pipeline.h"
 #include "xls/passes/pass_base.h"
@@ -105,17 +106,37 @@ absl::Status OptimizeIrForTop(Package* package, const OptOptions& options) {
   pass_options.ram_rewrites = options.ram_rewrites;
   pass_options.use_context_narrowing_analysis =
       options.use_context_narrowing_analysis;
+  pass_options.unroll_step_node_count = options.unroll_step_node_count;
+  pass_options.max_unrolled_iteration_growth =
+      options.max_unrolled_iteration_growth;
+  pass_options.max_inlined_callee_node_count =
+      options.max_inlined_callee_node_count;
   pass_options.bisect_limit = options.bisect_limit;
+  pass_options.function_base_parallelism = options.function_base_parallelism;
+  pass_options.node_parallelism = options.node_parallelism;
+  pass_options.incremental_verification = options.incremental_verification;
+  pass_options.pass_time_budget = options.pass_time_budget;
+  pass_options.pass_node_budget = options.pass_node_budget;
+  AnalysisManager analysis_manager;
+  pass_options.analysis_manager = &analysis_manager;
   PassResults results;
+  results.profile = options.profile;
   XLS_RETURN_IF_ERROR(pipeline->Run(package, pass_options, &results).status());
+  if (options.incremental_verification) {
+    XLS_RETURN_IF_ERROR(VerifyPackage(package));
+  }
   return absl::OkStatus();
 }
 
 absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
                                              const OptOptions& options) {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(ir, options.ir_path));
+                       ParsePackageTextOrBinary(ir, options.ir_path,
+                                                options.parse_parallelism));
   XLS_RETURN_IF_ERROR(OptimizeIrForTop(package.get(), options));
+  if (options.output_binary_ir) {
+    return SerializePackageToBinary(package.get());
+  }
   return package->DumpIr();
 }
 
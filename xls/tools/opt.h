@@ -26,9 +26,11 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "xls/ir/package.h"
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/pass_pipeline.pb.h"
+#include "xls/passes/pass_profile.h"
 
 namespace xls::tools {
 
@@ -45,9 +47,27 @@ struct OptOptions {
   bool inline_procs = false;
   std::vector<RamRewrite> ram_rewrites = {};
   bool use_context_narrowing_analysis = false;
+  std::optional<int64_t> unroll_step_node_count = std::nullopt;
+  std::optional<int64_t> max_unrolled_iteration_growth = std::nullopt;
+  std::optional<int64_t> max_inlined_callee_node_count = std::nullopt;
   std::variant<std::nullopt_t, std::string_view, PassPipelineProto>
       pass_pipeline = std::nullopt;
   std::optional<int64_t> bisect_limit;
+  int64_t function_base_parallelism = 1;
+  int64_t node_parallelism = 1;
+  // Maximum number of threads used to parse and verify text IR.
+  int64_t parse_parallelism = 1;
+  // If true, the verifier run between passes only verifies the functions
+  // changed since its previous run, and the package is verified in full once
+  // the pipeline is done.
+  bool incremental_verification = false;
+  std::optional<absl::Duration> pass_time_budget;
+  std::optional<int64_t> pass_node_budget;
+  // If set, the run time and transformations of each pass are recorded here.
+  PassProfile* profile = nullptr;
+  // If true the optimized IR is returned in the binary IR format (see
+  // xls/ir/binary_ir.h) rather than as text.
+  bool output_binary_ir = false;
 };
 
 // Helper used in the opt_main tool, optimizes the given IR for a particular
@@ -57,7 +77,7 @@ absl::Status OptimizeIrForTop(Package* package, const OptOptions& options);
 
 // Helper used in the opt_main tool, optimizes the given IR for a particular
 // top-level entity (e.g., function, proc, etc) at the given opt level and
-// returns the resulting optimized IR.
+// returns the resulting optimized IR. `ir` may be either textual or binary IR.
 absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
                                              const OptOptions& options);
 }  // namespace xls::tools
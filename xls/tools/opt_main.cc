@@ -38,11 +38,14 @@
 #include "absl/log/log_sink_registry.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "google/protobuf/text_format.h"
 #include "xls/common/exit_status.h"
 #include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/init_xls.h"
+#include "xls/common/persistent_worker.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/dev_tools/tool_timeout.h"
@@ -50,6 +53,7 @@
 #include "xls/passes/optimization_pass.h"
 #include "xls/passes/optimization_pass_pipeline.h"
 #include "xls/passes/pass_pipeline.pb.h"
+#include "xls/passes/pass_profile.h"
 #include "xls/tools/opt.h"
 
 static constexpr std::string_view kUsage = R"(
@@ -125,6 +129,54 @@ ABSL_FLAG(std::optional<std::string>, passes_textproto, std::nullopt,
 ABSL_FLAG(std::optional<int64_t>, passes_bisect_limit, std::nullopt,
           "Number of passes to allow to execute. This can be used as compiler "
           "fuel to ensure the compiler finishes at a particular point.");
+ABSL_FLAG(std::optional<int64_t>, unroll_step_node_count, std::nullopt,
+          "If set, loops are unrolled this many nodes at a time and the "
+          "function is simplified between steps, which keeps the IR smaller "
+          "than unrolling whole loops at once.");
+ABSL_FLAG(std::optional<int64_t>, max_unrolled_iteration_growth, std::nullopt,
+          "If set along with --unroll_step_node_count, stop unrolling a loop "
+          "once an unrolled iteration adds more than this many nodes after "
+          "simplification, leaving its remaining iterations rolled. The "
+          "output may then not be suitable for codegen.");
+ABSL_FLAG(std::optional<int64_t>, max_inlined_callee_node_count, std::nullopt,
+          "If set, invokes of functions with more than this many nodes which "
+          "are called from more than one site are not inlined, and calls of "
+          "identical functions are merged first. The output may then not be "
+          "suitable for codegen.");
+ABSL_FLAG(int64_t, function_base_parallelism, 1,
+          "Maximum number of functions and procs to run each pass on "
+          "concurrently. Functions which call or are called by others are "
+          "always optimized one at a time. If greater than one, the ids of "
+          "nodes in the output may differ from run to run.");
+ABSL_FLAG(int64_t, node_parallelism, 1,
+          "Maximum number of threads which passes supporting it (e.g., cse) "
+          "use on the nodes of a single function or proc. Does not change "
+          "the output.");
+ABSL_FLAG(int64_t, parse_parallelism, 1,
+          "Maximum number of threads used to parse and verify the input IR. "
+          "The bodies of functions and procs are built concurrently.");
+ABSL_FLAG(bool, incremental_verification, false,
+          "If true, the IR verifier run after each pass only verifies the "
+          "functions changed since its previous run. The whole package is "
+          "still verified once optimization is done.");
+ABSL_FLAG(std::optional<absl::Duration>, pass_time_budget, std::nullopt,
+          "If set, a pass which runs for longer than this on a function or "
+          "proc has its changes to functions discarded and is not run on that "
+          "function or proc again, e.g. '30s'.");
+ABSL_FLAG(std::optional<int64_t>, pass_node_budget, std::nullopt,
+          "If set, a pass which adds more than this many nodes to a function "
+          "or proc has its changes to functions discarded and is not run on "
+          "that function or proc again.");
+ABSL_FLAG(std::optional<std::string>, pass_profile_path, std::nullopt,
+          "If set, a PassProfileProto recording the run time and the nodes "
+          "added and removed by each pass, both on the whole package and on "
+          "each function and proc, is written to this file as a textproto.");
+ABSL_FLAG(std::optional<std::string>, pass_profile_trace_path, std::nullopt,
+          "If set, the pass profile is written to this file as a Chrome trace "
+          "event JSON timeline, viewable in chrome://tracing or Perfetto.");
+ABSL_FLAG(bool, output_binary_ir, false,
+          "If true, the optimized IR is written in the binary IR format which "
+          "the XLS tools load without parsing.");
 ABSL_FLAG(bool, list_passes, false,
           "If passed list the names of all passes and exit.");
 
@@ -209,7 +261,23 @@ absl::Status RealMain(std::string_view input_path) {
   std::optional<std::string> pass_list = absl::GetFlag(FLAGS_passes);
   std::optional<int64_t> bisect_limit =
       absl::GetFlag(FLAGS_passes_bisect_limit);
-  XLS_ASSIGN_OR_RETURN(std::string ir, GetFileContents(input_path));
+  int64_t function_base_parallelism =
+      absl::GetFlag(FLAGS_function_base_parallelism);
+  std::optional<absl::Duration> pass_time_budget =
+      absl::GetFlag(FLAGS_pass_time_budget);
+  std::optional<int64_t> pass_node_budget =
+      absl::GetFlag(FLAGS_pass_node_budget);
+  std::optional<std::string> pass_profile_path =
+      absl::GetFlag(FLAGS_pass_profile_path);
+  std::optional<std::string> pass_profile_trace_path =
+      absl::GetFlag(FLAGS_pass_profile_trace_path);
+  std::optional<PassProfile> profile;
+  if (pass_profile_path.has_value() || pass_profile_trace_path.has_value()) {
+    profile.emplace();
+  }
+  // The IR is mapped rather than read so that very large packages are paged in
+  // as they are parsed.
+  XLS_ASSIGN_OR_RETURN(MappedFile ir, MappedFile::Open(input_path));
   std::optional<std::string> pipeline_textproto =
       absl::GetFlag(FLAGS_passes_textproto);
   std::optional<std::string> pipeline_binproto =
@@ -244,7 +312,7 @@ absl::Status RealMain(std::string_view input_path) {
   XLS_ASSIGN_OR_RETURN(
       std::string opt_ir,
       tools::OptimizeIrForTop(
-          ir,
+          ir.contents(),
           OptOptions{
               .opt_level = opt_level,
               .top = top,
@@ -255,10 +323,34 @@ absl::Status RealMain(std::string_view input_path) {
               .inline_procs = inline_procs,
               .ram_rewrites = std::move(ram_rewrites_vec),
               .use_context_narrowing_analysis = use_context_narrowing_analysis,
+              .unroll_step_node_count =
+                  absl::GetFlag(FLAGS_unroll_step_node_count),
+              .max_unrolled_iteration_growth =
+                  absl::GetFlag(FLAGS_max_unrolled_iteration_growth),
+              .max_inlined_callee_node_count =
+                  absl::GetFlag(FLAGS_max_inlined_callee_node_count),
               .pass_pipeline = pass_pipeline,
               .bisect_limit = bisect_limit,
+              .function_base_parallelism = function_base_parallelism,
+              .node_parallelism = absl::GetFlag(FLAGS_node_parallelism),
+              .parse_parallelism = absl::GetFlag(FLAGS_parse_parallelism),
+              .incremental_verification =
+                  absl::GetFlag(FLAGS_incremental_verification),
+              .pass_time_budget = pass_time_budget,
+              .pass_node_budget = pass_node_budget,
+              .profile = profile.has_value() ? &*profile : nullptr,
+              .output_binary_ir = absl::GetFlag(FLAGS_output_binary_ir),
           }));
 
+  if (pass_profile_path.has_value()) {
+    XLS_RETURN_IF_ERROR(
+        SetTextProtoFile(*pass_profile_path, profile->ToProto()));
+  }
+  if (pass_profile_trace_path.has_value()) {
+    XLS_RETURN_IF_ERROR(SetFileContents(*pass_profile_trace_path,
+                                        profile->ToChromeTraceJson()));
+  }
+
   if (output_path == "-") {
     std::cout << opt_ir;
     return absl::OkStatus();
@@ -273,6 +365,16 @@ int main(int argc, char** argv) {
   std::vector<std::string_view> positional_arguments =
       xls::InitXls(kUsage, argc, argv);
 
+  if (xls::IsPersistentWorker()) {
+    return xls::RunPersistentWorker(
+        argv[0], [](absl::Span<const std::string_view> positional_arguments) {
+          if (positional_arguments.size() != 1) {
+            return absl::InvalidArgumentError(
+                "Expected invocation: opt_main <path>");
+          }
+          return xls::tools::RealMain(positional_arguments[0]);
+        });
+  }
   if (absl::GetFlag(FLAGS_list_passes)) {
     std::cout
         << xls::GetOptimizationPipelineGenerator().GetAvailablePassesStr();
@@ -54,6 +54,29 @@ ABSL_FLAG(int64_t, period_relaxation_percent, 0,
           "constraints will be used. Increasing this will trade-off an "
           "increase in critical path delay in favor of decreased register "
           "count. See https://google.github.io/xls/scheduling for details.");
+ABSL_FLAG(int64_t, flop_relaxation_percent, 0,
+          "The percentage by which the SDC scheduler may lengthen the clock "
+          "period it schedules for, if that lowers the number of pipeline "
+          "flops left after codegen merges registers. The clock period never "
+          "goes past --clock_period_ps. When set to 0, the clock period is "
+          "not lengthened.");
+ABSL_FLAG(int64_t, clock_search_parallelism, 1,
+          "The number of clock periods to try at once, each on its own "
+          "thread, when searching for the minimum feasible clock period.");
+ABSL_FLAG(int64_t, max_partition_size, 0,
+          "If positive, functions with more nodes than this are scheduled by "
+          "recursively cutting them at stage boundaries and scheduling the "
+          "parts in parallel, rather than with the chosen strategy. Parts are "
+          "scheduled in parallel until they have at most this many nodes.");
+ABSL_FLAG(std::string, schedule_hint_path, "",
+          "Path to the schedule of an earlier version of the IR, as written by "
+          "--output_schedule_path. Functions and procs whose hinted schedule "
+          "is still valid keep it rather than being scheduled again.");
+ABSL_FLAG(bool, pin_schedule_hint, false,
+          "If true, nodes away from the changes since the schedule in "
+          "--schedule_hint_path stay in the stages it put them in, if that "
+          "is feasible, so that small edits to the IR only move nearby "
+          "nodes.");
 ABSL_FLAG(
     bool, minimize_clock_on_failure, true,
     "If true, when `--clock_period_ps` is given but is infeasible for "
@@ -83,6 +106,13 @@ ABSL_FLAG(std::optional<int64_t>, worst_case_throughput, std::nullopt,
           "If zero, no throughput bound will be enforced.\n"
           "If negative, XLS will find the fastest throughput achievable given "
           "all other constraints specified.");
+ABSL_FLAG(int64_t, proc_replication_factor, 1,
+          "If greater than 1, the top proc is replaced by this many copies of "
+          "itself, each handling every Nth transaction, behind procs which "
+          "dispatch transactions to the copies and collect their results in "
+          "order. Requires --multi_proc. Combine with --worst_case_throughput "
+          "set to the same value to give each copy that many cycles per "
+          "transaction while the design as a whole accepts one per cycle.");
 ABSL_FLAG(int64_t, additional_input_delay_ps, 0,
           "The additional delay added to each input.");
 ABSL_FLAG(int64_t, additional_output_delay_ps, 0,
@@ -196,6 +226,11 @@ static absl::StatusOr<bool> SetOptionsFromFlags(
   POPULATE_FLAG(delay_model);
   POPULATE_FLAG(clock_margin_percent);
   POPULATE_FLAG(period_relaxation_percent);
+  POPULATE_FLAG(flop_relaxation_percent);
+  POPULATE_FLAG(clock_search_parallelism);
+  POPULATE_FLAG(max_partition_size);
+  POPULATE_FLAG(schedule_hint_path);
+  POPULATE_FLAG(pin_schedule_hint);
   POPULATE_FLAG(minimize_clock_on_failure);
   POPULATE_FLAG(recover_after_minimizing_clock);
   POPULATE_FLAG(minimize_worst_case_throughput);
@@ -205,6 +240,7 @@ static absl::StatusOr<bool> SetOptionsFromFlags(
         absl::GetFlag(FLAGS_worst_case_throughput)
             .value_or(proto.minimize_worst_case_throughput() ? 0 : 1));
   }
+  POPULATE_FLAG(proc_replication_factor);
   POPULATE_FLAG(additional_input_delay_ps);
   POPULATE_FLAG(additional_output_delay_ps);
   POPULATE_FLAG(ffi_fallback_delay_ps);
@@ -107,6 +107,11 @@ ABSL_FLAG(std::vector<std::string>, output_channel_counts, {},
 ABSL_FLAG(std::string, verilog_simulator, "iverilog",
           "The Verilog simulator to use. If not specified, the default "
           "simulator is used.");
+ABSL_FLAG(int64_t, simulation_shards, 1,
+          "Number of concurrent simulator invocations a batch of function "
+          "arguments is split across. Only modules whose interface carries no "
+          "state between argument sets (combinational, fixed latency and "
+          "pipelined) are sharded.");
 ABSL_FLAG(std::string, file_type, "",
           "The type of input file, may be either 'verilog' or "
           "'system_verilog'. If not specified the file type is determined by "
@@ -204,7 +209,8 @@ absl::Status RunFunction(const verilog::ModuleSimulator& simulator,
   }
 
   XLS_ASSIGN_OR_RETURN(std::vector<Value> outputs,
-                       simulator.RunBatched(args_sets));
+                       simulator.RunBatchedSharded(
+                           args_sets, absl::GetFlag(FLAGS_simulation_shards)));
 
   for (const Value& output : outputs) {
     std::cout << output.ToString(FormatPreference::kHex) << '\n';
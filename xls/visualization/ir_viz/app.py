@@ -255,10 +255,8 @@ def example_handler(filename: str):
     flask.abort(404)
 
 
-@webapp.route('/graph', methods=['POST'])
-def graph_handler():
-  """Parses the posted text and returns a parse status."""
-  text = flask.request.form['text']
+def ir_to_json(text: str, extra_args: List[str]) -> flask.Response:
+  """Runs ir_to_json_main on the given IR text and returns the JSON response."""
   with tempfile.NamedTemporaryFile(
       mode='w', encoding='utf-8', prefix='ir_viz.', suffix='.ir'
   ) as tmp_ir:
@@ -268,7 +266,7 @@ def graph_handler():
         IR_TO_JSON_MAIN_PATH,
         '--delay_model={}'.format(FLAGS.delay_model),
         tmp_ir.name,
-    ]
+    ] + extra_args
     if FLAGS.pipeline_stages is not None:
       argv.append('--pipeline_stages={}'.format(FLAGS.pipeline_stages))
     if FLAGS.top is not None:
@@ -289,6 +287,26 @@ def graph_handler():
   return jsonified
 
 
+@webapp.route('/graph', methods=['POST'])
+def graph_handler():
+  """Parses the posted text and returns a parse status.
+
+  The returned package only lists its functions, procs and blocks. Their graphs
+  are fetched one at a time from /function as they are viewed, so large
+  packages are not analyzed up front.
+  """
+  return ir_to_json(flask.request.form['text'], ['--skeleton'])
+
+
+@webapp.route('/function', methods=['POST'])
+def function_handler():
+  """Returns the graph of one function, proc or block of the posted text."""
+  return ir_to_json(
+      flask.request.form['text'],
+      ['--function_id={}'.format(flask.request.form['function_id'])],
+  )
+
+
 def main(argv):
   if len(argv) > 1:
     raise app.UsageError('Too many command-line arguments.')
@@ -20,6 +20,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "google/protobuf/message.h"
 #include "google/protobuf/util/json_util.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
@@ -29,14 +30,10 @@
 #include "xls/visualization/ir_viz/visualization.pb.h"
 
 namespace xls {
+namespace {
 
-absl::StatusOr<std::string> IrToJson(
-    Package* package, const DelayEstimator& delay_estimator,
-    const PipelineSchedule* schedule,
-    std::optional<std::string_view> entry_name) {
-  XLS_ASSIGN_OR_RETURN(viz::Package proto, IrToProto(package, delay_estimator,
-                                                     schedule, entry_name));
-
+absl::StatusOr<std::string> ProtoToJson(
+    const google::protobuf::Message& proto) {
   std::string serialized_json;
   google::protobuf::util::JsonPrintOptions print_options;
   print_options.add_whitespace = true;
@@ -50,4 +47,31 @@ absl::StatusOr<std::string> IrToJson(
   return serialized_json;
 }
 
+}  // namespace
+
+absl::StatusOr<std::string> IrToJson(
+    Package* package, const DelayEstimator& delay_estimator,
+    const PipelineSchedule* schedule,
+    std::optional<std::string_view> entry_name) {
+  XLS_ASSIGN_OR_RETURN(viz::Package proto, IrToProto(package, delay_estimator,
+                                                     schedule, entry_name));
+  return ProtoToJson(proto);
+}
+
+absl::StatusOr<std::string> IrToSkeletonJson(
+    Package* package, std::optional<std::string_view> entry_name) {
+  XLS_ASSIGN_OR_RETURN(viz::Package proto,
+                       IrToSkeletonProto(package, entry_name));
+  return ProtoToJson(proto);
+}
+
+absl::StatusOr<std::string> FunctionBaseToJson(
+    Package* package, std::string_view function_id,
+    const DelayEstimator& delay_estimator, const PipelineSchedule* schedule) {
+  XLS_ASSIGN_OR_RETURN(
+      viz::FunctionBase proto,
+      FunctionBaseToProto(package, function_id, delay_estimator, schedule));
+  return ProtoToJson(proto);
+}
+
 }  // namespace xls
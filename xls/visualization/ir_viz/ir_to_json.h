@@ -34,6 +34,21 @@ absl::StatusOr<std::string> IrToJson(
     const PipelineSchedule* schedule = nullptr,
     std::optional<std::string_view> entry_name = std::nullopt);
 
+// Returns a JSON representation of the package without the graphs of its
+// functions, procs and blocks (see IrToSkeletonProto). The visualizer fetches
+// the graph of a function base with FunctionBaseToJson when it is viewed, so
+// large packages are not analyzed and sent as a whole.
+absl::StatusOr<std::string> IrToSkeletonJson(
+    Package* package,
+    std::optional<std::string_view> entry_name = std::nullopt);
+
+// Returns a JSON representation of the graph of the function base with the
+// given id. The JSON is based on the xls::viz::FunctionBase proto.
+absl::StatusOr<std::string> FunctionBaseToJson(
+    Package* package, std::string_view function_id,
+    const DelayEstimator& delay_estimator,
+    const PipelineSchedule* schedule = nullptr);
+
 }  // namespace xls
 
 #endif  // XLS_VISUALIZATION_IR_VIZ_IR_TO_JSON_H_
@@ -45,9 +45,15 @@ ABSL_FLAG(std::string, delay_model, "", "Delay model to use.");
 ABSL_FLAG(std::optional<int64_t>, pipeline_stages, std::nullopt,
           "Pipeline stages to use when scheduling the function");
 ABSL_FLAG(std::optional<std::string>, entry_name, std::nullopt, "Entry name");
+ABSL_FLAG(bool, skeleton, false,
+          "Only emit the names, ids and kinds of the functions, procs and "
+          "blocks, and the marked up IR, without their graphs.");
+ABSL_FLAG(std::optional<std::string>, function_id, std::nullopt,
+          "Only emit the graph of the function, proc or block with this id, "
+          "as found in the output of --skeleton.");
 
 constexpr std::string_view kUsage =
-    R"(Expected: ir_to_json_main --delay_model=MODEL [--pipeline_stages=N] [--entry_name=ENTRY] /path/to/file.ir)";
+    R"(Expected: ir_to_json_main --delay_model=MODEL [--pipeline_stages=N] [--entry_name=ENTRY] [--skeleton | --function_id=ID] /path/to/file.ir)";
 
 namespace xls {
 namespace {
@@ -70,7 +76,8 @@ absl::StatusOr<FunctionBase*> GetFunctionBaseToView(Package* package) {
 absl::Status RealMain(const std::filesystem::path& ir_path,
                       std::string_view delay_model_name,
                       std::optional<int64_t> pipeline_stages,
-                      std::optional<std::string_view> entry_name) {
+                      std::optional<std::string_view> entry_name, bool skeleton,
+                      std::optional<std::string_view> function_id) {
   XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_path));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
                        Parser::ParsePackage(ir_text));
@@ -80,24 +87,36 @@ absl::Status RealMain(const std::filesystem::path& ir_path,
   } else {
     XLS_ASSIGN_OR_RETURN(func_base, GetFunctionBaseToView(package.get()));
   }
+  if (skeleton) {
+    XLS_ASSIGN_OR_RETURN(std::string json,
+                         IrToSkeletonJson(package.get(), func_base->name()));
+    std::cout << json << "\n";
+    return absl::OkStatus();
+  }
   XLS_ASSIGN_OR_RETURN(DelayEstimator * delay_estimator,
                        GetDelayEstimator(delay_model_name));
 
-  std::string json;
+  std::optional<PipelineSchedule> schedule;
   if (pipeline_stages.has_value()) {
     // TODO(meheff): Support scheduled procs.
     XLS_RET_CHECK(func_base->IsFunction());
     XLS_ASSIGN_OR_RETURN(
-        PipelineSchedule schedule,
+        schedule,
         RunPipelineSchedule(
             func_base->AsFunctionOrDie(), *delay_estimator,
             SchedulingOptions().pipeline_stages(pipeline_stages.value())));
-    XLS_ASSIGN_OR_RETURN(json, IrToJson(package.get(), *delay_estimator,
-                                        &schedule, func_base->name()));
-  } else {
+  }
+  const PipelineSchedule* schedule_ptr =
+      schedule.has_value() ? &schedule.value() : nullptr;
+
+  std::string json;
+  if (function_id.has_value()) {
     XLS_ASSIGN_OR_RETURN(json,
-                         IrToJson(package.get(), *delay_estimator,
-                                  /*schedule=*/nullptr, func_base->name()));
+                         FunctionBaseToJson(package.get(), function_id.value(),
+                                            *delay_estimator, schedule_ptr));
+  } else {
+    XLS_ASSIGN_OR_RETURN(json, IrToJson(package.get(), *delay_estimator,
+                                        schedule_ptr, func_base->name()));
   }
   std::cout << json << "\n";
   return absl::OkStatus();
@@ -120,5 +139,6 @@ int main(int argc, char** argv) {
 
   return xls::ExitStatus(xls::RealMain(
       positional_arguments[0], absl::GetFlag(FLAGS_delay_model),
-      absl::GetFlag(FLAGS_pipeline_stages), absl::GetFlag(FLAGS_entry_name)));
+      absl::GetFlag(FLAGS_pipeline_stages), absl::GetFlag(FLAGS_entry_name),
+      absl::GetFlag(FLAGS_skeleton), absl::GetFlag(FLAGS_function_id)));
 }
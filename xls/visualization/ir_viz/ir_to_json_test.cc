@@ -22,6 +22,8 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
 #include "xls/common/status/matchers.h"
 #include "xls/estimators/delay_model/delay_estimator.h"
 #include "xls/estimators/delay_model/delay_estimators.h"
@@ -35,7 +37,9 @@
 namespace xls {
 namespace {
 
+using ::absl_testing::StatusIs;
 using ::testing::HasSubstr;
+using ::testing::Not;
 
 using IrToJsonTest = IrTestBase;
 
@@ -117,6 +121,39 @@ fn main(x: bits[32], xx: bits[32]) -> bits[32] {
   VLOG(1) << json;
 }
 
+TEST_F(IrToJsonTest, SkeletonAndFunctionBase) {
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(R"(
+package test
+
+fn other(z: bits[32]) -> bits[32] {
+  ret neg.1: bits[32] = neg(z, id=1)
+}
+
+fn main(x: bits[32]) -> bits[32] {
+  ret my_add: bits[32] = add(x, x)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(DelayEstimator * delay_estimator,
+                           GetDelayEstimator("unit"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string skeleton,
+                           IrToSkeletonJson(p.get(), /*entry_name=*/"main"));
+  VLOG(1) << skeleton;
+  EXPECT_THAT(skeleton, HasSubstr(R"("name": "main")"));
+  EXPECT_THAT(skeleton, HasSubstr(R"("entry_id": "f1")"));
+  EXPECT_THAT(skeleton, HasSubstr(R"("ir_html")"));
+  EXPECT_THAT(skeleton, Not(HasSubstr(R"("nodes")")));
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::string json,
+                           FunctionBaseToJson(p.get(), "f1", *delay_estimator));
+  VLOG(1) << json;
+  EXPECT_THAT(json, HasSubstr(R"("name": "main")"));
+  EXPECT_THAT(json, HasSubstr(R"("name": "my_add")"));
+  EXPECT_THAT(json, Not(HasSubstr(R"("name": "other")")));
+
+  EXPECT_THAT(FunctionBaseToJson(p.get(), "f2", *delay_estimator),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
 TEST_F(IrToJsonTest, SimpleProc) {
   XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackage(R"(
 package test
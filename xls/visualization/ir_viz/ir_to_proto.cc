@@ -160,9 +160,9 @@ absl::StatusOr<viz::NodeAttributes> NodeAttributes(
   return attributes;
 }
 
-absl::StatusOr<viz::FunctionBase> FunctionBaseToVisualizationProto(
-    FunctionBase* function, const DelayEstimator& delay_estimator,
-    const AreaEstimator& area_estimator, const PipelineSchedule* schedule,
+// Returns the proto of the function without its graph.
+absl::StatusOr<viz::FunctionBase> FunctionBaseToSkeletonProto(
+    FunctionBase* function,
     const absl::flat_hash_map<FunctionBase*, std::string>& function_ids) {
   viz::FunctionBase proto;
   proto.set_name(function->name());
@@ -175,6 +175,15 @@ absl::StatusOr<viz::FunctionBase> FunctionBaseToVisualizationProto(
     proto.set_kind("block");
   }
   proto.set_id(function_ids.at(function));
+  return proto;
+}
+
+absl::StatusOr<viz::FunctionBase> FunctionBaseToVisualizationProto(
+    FunctionBase* function, const DelayEstimator& delay_estimator,
+    const AreaEstimator& area_estimator, const PipelineSchedule* schedule,
+    const absl::flat_hash_map<FunctionBase*, std::string>& function_ids) {
+  XLS_ASSIGN_OR_RETURN(viz::FunctionBase proto,
+                       FunctionBaseToSkeletonProto(function, function_ids));
   absl::StatusOr<std::vector<CriticalPathEntry>> critical_path =
       AnalyzeCriticalPath(function, /*clock_period_ps=*/std::nullopt,
                           delay_estimator);
@@ -504,20 +513,37 @@ absl::StatusOr<viz::Package> IrToProto(
     Package* package, const DelayEstimator& delay_estimator,
     const AreaEstimator& area_estimator, const PipelineSchedule* schedule,
     std::optional<std::string_view> entry_name) {
-  viz::Package proto;
+  XLS_ASSIGN_OR_RETURN(viz::Package proto,
+                       IrToSkeletonProto(package, entry_name));
 
   absl::flat_hash_map<FunctionBase*, std::string> function_ids =
       GetFunctionIds(package);
 
-  std::optional<FunctionBase*> entry_function_base;
-  for (FunctionBase* fb : package->GetFunctionBases()) {
+  std::vector<FunctionBase*> function_bases = package->GetFunctionBases();
+  for (int64_t i = 0; i < function_bases.size(); ++i) {
+    FunctionBase* fb = function_bases[i];
     XLS_ASSIGN_OR_RETURN(
-        *proto.add_function_bases(),
+        *proto.mutable_function_bases(i),
         FunctionBaseToVisualizationProto(
             fb, delay_estimator, area_estimator,
             schedule != nullptr && schedule->function_base() == fb ? schedule
                                                                    : nullptr,
             function_ids));
+  }
+  return proto;
+}
+
+absl::StatusOr<viz::Package> IrToSkeletonProto(
+    Package* package, std::optional<std::string_view> entry_name) {
+  viz::Package proto;
+
+  absl::flat_hash_map<FunctionBase*, std::string> function_ids =
+      GetFunctionIds(package);
+
+  std::optional<FunctionBase*> entry_function_base;
+  for (FunctionBase* fb : package->GetFunctionBases()) {
+    XLS_ASSIGN_OR_RETURN(*proto.add_function_bases(),
+                         FunctionBaseToSkeletonProto(fb, function_ids));
     if (entry_name.has_value() && fb->name() == entry_name.value()) {
       entry_function_base = fb;
     }
@@ -537,4 +563,33 @@ absl::StatusOr<viz::Package> IrToProto(
   return proto;
 }
 
+absl::StatusOr<viz::FunctionBase> FunctionBaseToProto(
+    Package* package, std::string_view function_id,
+    const DelayEstimator& delay_estimator, const PipelineSchedule* schedule) {
+  NoAreaEstimator no_area;
+  return FunctionBaseToProto(package, function_id, delay_estimator, no_area,
+                             schedule);
+}
+
+absl::StatusOr<viz::FunctionBase> FunctionBaseToProto(
+    Package* package, std::string_view function_id,
+    const DelayEstimator& delay_estimator, const AreaEstimator& area_estimator,
+    const PipelineSchedule* schedule) {
+  absl::flat_hash_map<FunctionBase*, std::string> function_ids =
+      GetFunctionIds(package);
+  for (FunctionBase* fb : package->GetFunctionBases()) {
+    if (function_ids.at(fb) != function_id) {
+      continue;
+    }
+    return FunctionBaseToVisualizationProto(
+        fb, delay_estimator, area_estimator,
+        schedule != nullptr && schedule->function_base() == fb ? schedule
+                                                               : nullptr,
+        function_ids);
+  }
+  return absl::NotFoundError(absl::StrFormat(
+      "No function, proc or block with id %s in package %s", function_id,
+      package->name()));
+}
+
 }  // namespace xls
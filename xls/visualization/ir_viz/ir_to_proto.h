@@ -40,6 +40,27 @@ absl::StatusOr<xls::viz::Package> IrToProto(
     Package* package, const DelayEstimator& delay_estimator,
     const PipelineSchedule* schedule = nullptr,
     std::optional<std::string_view> entry_name = std::nullopt);
+
+// Returns a proto in which the function bases only have their name, id and
+// kind, without their graphs. This is cheap to compute and small even for
+// large packages; the graphs can then be obtained one at a time with
+// FunctionBaseToProto.
+absl::StatusOr<xls::viz::Package> IrToSkeletonProto(
+    Package* package,
+    std::optional<std::string_view> entry_name = std::nullopt);
+
+// Returns the proto, including the graph, of the function base with the given
+// id (see xls::viz::FunctionBase::id).
+absl::StatusOr<xls::viz::FunctionBase> FunctionBaseToProto(
+    Package* package, std::string_view function_id,
+    const DelayEstimator& delay_estimator, const AreaEstimator& area_estimator,
+    const PipelineSchedule* schedule = nullptr);
+
+// Returns a proto without any area information.
+absl::StatusOr<xls::viz::FunctionBase> FunctionBaseToProto(
+    Package* package, std::string_view function_id,
+    const DelayEstimator& delay_estimator,
+    const PipelineSchedule* schedule = nullptr);
 }  // namespace xls
 
 #endif  // XLS_VISUALIZATION_IR_VIZ_IR_TO_PROTO_H_
@@ -189,12 +189,26 @@ class IrVisualizer {
      */
     this.package_ = null;
 
+    /**
+     *  The IR text from which the package was parsed. Graphs of the functions
+     *  are fetched from the server with this text as they are selected.
+     *  @private {string}
+     */
+    this.packageText_ = '';
+
     /**
      *  The unique identifier of the selected function to view.
      *  @private {?string}
      */
     this.selectedFunctionId_ = null;
 
+    /**
+     *  The unique identifier of the function most recently requested to be
+     *  viewed, which may still be waiting for its graph.
+     *  @private {?string}
+     */
+    this.requestedFunctionId_ = null;
+
     let self = this;
     this.functionSelector_.addEventListener('change', e => {
       if (e.target.value) {
@@ -414,6 +428,20 @@ class IrVisualizer {
     if (graph == null) {
       return;
     }
+    this.requestedFunctionId_ = functionId;
+    if (!graph['fetched']) {
+      this.fetchFunctionGraph_(graph, () => {
+        if (this.requestedFunctionId_ == functionId) {
+          this.selectFunction(functionId);
+          // Drawing the graph may have been requested before it arrived.
+          if (!this.graphView_) {
+            this.draw(
+                document.getElementById('only-selected-checkbox').checked);
+          }
+        }
+      });
+      return;
+    }
     this.irGraph_ = new irGraph.IrGraph(graph);
     this.graph_ = new selectableGraph.SelectableGraph(this.irGraph_);
     this.highlightIr_(graph);
@@ -440,6 +468,45 @@ class IrVisualizer {
         .classList.add('ir-function-selected');
   }
 
+  /**
+   * Fetches the nodes and edges of the given function of the package from the
+   * server and adds them to it. The server only sends the names of the
+   * functions with the package so that large packages load quickly.
+   * @param {!Object} func
+   * @param {function()} cb Called once the graph has been added to `func`.
+   * @private
+   */
+  fetchFunctionGraph_(func, cb) {
+    let pkg = this.package_;
+    let xmr = new XMLHttpRequest();
+    xmr.open('POST', '/function');
+    let self = this;
+    xmr.addEventListener('load', function() {
+      if (xmr.status < 200 || xmr.status >= 400) {
+        return;
+      }
+      let response = /** @type {!Object} */ (JSON.parse(xmr.responseText));
+      if (self.package_ !== pkg) {
+        // The IR was reparsed while the graph was in flight.
+        return;
+      }
+      if (response['error_code'] != 'ok') {
+        if (!!self.sourceErrorCallback_) {
+          self.sourceErrorCallback_(response['message']);
+        }
+        return;
+      }
+      func['nodes'] = response['graph']['nodes'] || [];
+      func['edges'] = response['graph']['edges'] || [];
+      func['fetched'] = true;
+      cb();
+    });
+    let data = new FormData();
+    data.append('text', this.packageText_);
+    data.append('function_id', func['id']);
+    xmr.send(data);
+  }
+
   /**
    * Sets various listeners for hovering over and selecting identifiers in the
    * IR text.
@@ -534,6 +601,7 @@ class IrVisualizer {
           self.sourceOkCallback_();
         }
         self.package_ = response['graph'];
+        self.packageText_ = text;
 
         // Fill in the names and ids of function in the select element.
         let functions = [];